@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+// Searches for any of a set of patterns in a single pass over the text.
+class AhoCorasick {
+public:
+    struct Match {
+        size_t offset;
+        size_t length;
+        size_t pattern_index;
+    };
+
+    explicit AhoCorasick(const Vector<StringView>& patterns)
+    {
+        for (auto& transition : m_root_transitions)
+            transition = 0;
+        m_nodes.append(Node());
+
+        for (size_t pattern_index = 0; pattern_index < patterns.size(); ++pattern_index) {
+            auto& pattern = patterns[pattern_index];
+            if (pattern.is_empty()) {
+                if (!m_empty_pattern_index.has_value())
+                    m_empty_pattern_index = pattern_index;
+                continue;
+            }
+            u32 state = 0;
+            for (size_t i = 0; i < pattern.length(); ++i) {
+                u8 byte = pattern[i];
+                u32 next = child(state, byte);
+                if (!next) {
+                    next = m_nodes.size();
+                    m_nodes.append(Node());
+                    m_nodes[next].depth = i + 1;
+                    if (state == 0)
+                        m_root_transitions[byte] = next;
+                    else
+                        m_nodes[state].children.append({ byte, next });
+                }
+                state = next;
+            }
+            if (m_nodes[state].pattern_index < 0)
+                m_nodes[state].pattern_index = pattern_index;
+        }
+
+        // Breadth first, so that the failure link of every node is done before those of its children.
+        Vector<u32> queue;
+        for (u32 node : m_root_transitions) {
+            if (node)
+                queue.append(node);
+        }
+        for (size_t i = 0; i < queue.size(); ++i) {
+            u32 state = queue[i];
+            auto& node = m_nodes[state];
+            node.output = node.pattern_index >= 0 ? state : m_nodes[node.failure].output;
+            for (auto& transition : node.children) {
+                m_nodes[transition.node].failure = step(node.failure, transition.byte);
+                queue.append(transition.node);
+            }
+        }
+    }
+
+    // Returns the match that ends first, and the longest pattern ending there.
+    Optional<Match> find(ReadonlyBytes text) const
+    {
+        if (m_empty_pattern_index.has_value())
+            return Match { 0, 0, m_empty_pattern_index.value() };
+
+        u32 state = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            state = step(state, text[i]);
+            if (u32 output = m_nodes[state].output) {
+                auto& node = m_nodes[output];
+                return Match { i + 1 - node.depth, node.depth, (size_t)node.pattern_index };
+            }
+        }
+        return {};
+    }
+
+    Optional<Match> find(const StringView& text) const { return find(text.bytes()); }
+
+private:
+    struct Transition {
+        u8 byte;
+        u32 node;
+    };
+
+    struct Node {
+        Vector<Transition> children;
+        u32 failure { 0 };
+        // The nearest node on the failure chain (including this one) that ends a pattern, 0 if none does.
+        u32 output { 0 };
+        u32 depth { 0 };
+        ssize_t pattern_index { -1 };
+    };
+
+    u32 child(u32 state, u8 byte) const
+    {
+        if (state == 0)
+            return m_root_transitions[byte];
+        for (auto& transition : m_nodes[state].children) {
+            if (transition.byte == byte)
+                return transition.node;
+        }
+        return 0;
+    }
+
+    u32 step(u32 state, u8 byte) const
+    {
+        for (;;) {
+            if (u32 next = child(state, byte))
+                return next;
+            if (state == 0)
+                return 0;
+            state = m_nodes[state].failure;
+        }
+    }
+
+    Vector<Node> m_nodes;
+    // The root has a transition for most bytes in a typical search, so it gets a table of its own.
+    u32 m_root_transitions[256];
+    Optional<size_t> m_empty_pattern_index;
+};
+
+}
+
+using AK::AhoCorasick;
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/FlyString.h>
 #include <AK/HashTable.h>
 #include <AK/Optional.h>
@@ -47,17 +48,64 @@ struct FlyStringImplTraits : public AK::Traits<StringImpl*> {
     }
 };
 
-static HashTable<StringImpl*, FlyStringImplTraits>& fly_impls()
+// The interning table is split into shards, each behind its own spin lock, so that
+// threads interning unrelated strings don't serialize on a single table.
+static constexpr size_t fly_impl_shard_count = 16;
+
+struct FlyImplShard {
+    Atomic<bool> locked { false };
+    HashTable<StringImpl*, FlyStringImplTraits> impls;
+
+    void lock()
+    {
+        while (locked.exchange(true, AK::MemoryOrder::memory_order_acquire)) {
+            while (locked.load(AK::MemoryOrder::memory_order_relaxed)) {
+#if ARCH(I386) || ARCH(X86_64)
+                __builtin_ia32_pause();
+#endif
+            }
+        }
+    }
+
+    void unlock() { locked.store(false, AK::MemoryOrder::memory_order_release); }
+};
+
+class FlyImplShardLocker {
+public:
+    explicit FlyImplShardLocker(FlyImplShard& shard)
+        : m_shard(shard)
+    {
+        m_shard.lock();
+    }
+    ~FlyImplShardLocker() { m_shard.unlock(); }
+
+private:
+    FlyImplShard& m_shard;
+};
+
+static FlyImplShard& fly_impl_shard(unsigned hash)
 {
-    static HashTable<StringImpl*, FlyStringImplTraits>* table;
-    if (!table)
-        table = new HashTable<StringImpl*, FlyStringImplTraits>;
-    return *table;
+    static FlyImplShard* shards;
+    auto* current = atomic_load(&shards, AK::MemoryOrder::memory_order_acquire);
+    if (!current) {
+        auto* fresh = new FlyImplShard[fly_impl_shard_count];
+        if (atomic_compare_exchange_strong(&shards, current, fresh, AK::MemoryOrder::memory_order_acq_rel))
+            current = fresh;
+        else
+            delete[] fresh;
+    }
+    return current[hash % fly_impl_shard_count];
 }
 
 void FlyString::did_destroy_impl(Badge<StringImpl>, StringImpl& impl)
 {
-    fly_impls().remove(&impl);
+    auto& shard = fly_impl_shard(impl.hash());
+    FlyImplShardLocker locker(shard);
+    // Another thread may have interned a replacement while this impl was dying,
+    // so only drop the entry if it's still ours.
+    auto it = shard.impls.find(&impl);
+    if (it != shard.impls.end() && *it == &impl)
+        shard.impls.remove(it);
 }
 
 FlyString::FlyString(const String& string)
@@ -68,15 +116,18 @@ FlyString::FlyString(const String& string)
         m_impl = string.impl();
         return;
     }
-    auto it = fly_impls().find(const_cast<StringImpl*>(string.impl()));
-    if (it == fly_impls().end()) {
-        fly_impls().set(const_cast<StringImpl*>(string.impl()));
-        string.impl()->set_fly({}, true);
-        m_impl = string.impl();
-    } else {
+    auto* impl = const_cast<StringImpl*>(string.impl());
+    auto& shard = fly_impl_shard(impl->hash());
+    FlyImplShardLocker locker(shard);
+    auto it = shard.impls.find(impl);
+    if (it != shard.impls.end() && (*it)->try_ref()) {
         ASSERT((*it)->is_fly());
-        m_impl = *it;
+        m_impl = adopt(**it);
+        return;
     }
+    shard.impls.set(impl);
+    impl->set_fly({}, true);
+    m_impl = impl;
 }
 
 FlyString::FlyString(const StringView& string)
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Types.h>
+
+#ifdef KERNEL
+#    error "AK/Futex.h is for userspace; the kernel has its own wait queues"
+#endif
+
+#ifdef __serenity__
+#    include <serenity.h>
+#elif defined(__linux__)
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#else
+#    include <sched.h>
+#endif
+
+namespace AK {
+
+// Sleeps as long as word still holds expected. May also return spuriously,
+// so callers re-check their condition in a loop.
+inline void futex_wait(Atomic<u32>& word, u32 expected)
+{
+    auto* address = reinterpret_cast<int32_t*>(const_cast<u32*>(word.ptr()));
+#ifdef __serenity__
+    futex(address, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, (int32_t)expected, nullptr, nullptr, 0);
+#elif defined(__linux__)
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, (int32_t)expected, nullptr, nullptr, 0);
+#else
+    (void)address;
+    if (word.load() == expected)
+        sched_yield();
+#endif
+}
+
+// Wakes up to count threads sleeping in futex_wait() on word.
+inline void futex_wake(Atomic<u32>& word, int count = 1)
+{
+    auto* address = reinterpret_cast<int32_t*>(const_cast<u32*>(word.ptr()));
+#ifdef __serenity__
+    futex(address, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count, nullptr, nullptr, 0);
+#elif defined(__linux__)
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+    (void)address;
+    (void)count;
+#endif
+}
+
+}
+
+using AK::futex_wait;
+using AK::futex_wake;
@@ -27,10 +27,11 @@
 #pragma once
 
 #include <AK/Assertions.h>
-#include <AK/SinglyLinkedList.h>
 #include <AK/StdLibExtras.h>
 #include <AK/TemporaryChange.h>
 #include <AK/Traits.h>
+#include <AK/Types.h>
+#include <AK/kmalloc.h>
 
 namespace AK {
 
@@ -42,21 +43,13 @@ enum class HashSetResult {
 template<typename T, typename>
 class HashTable;
 
-template<typename HashTableType, typename ElementType, typename BucketIteratorType>
+template<typename HashTableType, typename ElementType, typename BucketType>
 class HashTableIterator {
 public:
-    bool operator!=(const HashTableIterator& other) const
-    {
-        if (m_is_end && other.m_is_end)
-            return false;
-        return &m_table != &other.m_table
-            || m_is_end != other.m_is_end
-            || m_bucket_index != other.m_bucket_index
-            || m_bucket_iterator != other.m_bucket_iterator;
-    }
-    bool operator==(const HashTableIterator& other) const { return !(*this != other); }
-    ElementType& operator*() { return *m_bucket_iterator; }
-    ElementType* operator->() { return m_bucket_iterator.operator->(); }
+    bool operator!=(const HashTableIterator& other) const { return m_bucket != other.m_bucket; }
+    bool operator==(const HashTableIterator& other) const { return m_bucket == other.m_bucket; }
+    ElementType& operator*() { return *m_bucket->slot(); }
+    ElementType* operator->() { return m_bucket->slot(); }
     HashTableIterator& operator++()
     {
         skip_to_next();
@@ -65,58 +58,54 @@ public:
 
     void skip_to_next()
     {
-        while (!m_is_end) {
-            if (m_bucket_iterator.is_end()) {
-                ++m_bucket_index;
-                if (m_bucket_index >= m_table.capacity()) {
-                    m_is_end = true;
-                    return;
-                }
-                m_bucket_iterator = m_table.bucket(m_bucket_index).begin();
-            } else {
-                ++m_bucket_iterator;
-            }
-            if (!m_bucket_iterator.is_end())
-                return;
-        }
+        if (!m_bucket)
+            return;
+        auto* end = m_table.m_buckets + m_table.m_capacity;
+        do {
+            ++m_bucket;
+        } while (m_bucket != end && !m_bucket->is_used());
+        if (m_bucket == end)
+            m_bucket = nullptr;
     }
 
 private:
     friend HashTableType;
 
-    explicit HashTableIterator(HashTableType& table, bool is_end, BucketIteratorType bucket_iterator = {}, size_t bucket_index = 0)
+    HashTableIterator(HashTableType& table, BucketType* bucket)
         : m_table(table)
-        , m_bucket_index(bucket_index)
-        , m_is_end(is_end)
-        , m_bucket_iterator(bucket_iterator)
+        , m_bucket(bucket)
     {
         ASSERT(!table.m_clearing);
         ASSERT(!table.m_rehashing);
-        if (!is_end && !m_table.is_empty() && m_bucket_iterator.is_end()) {
-            m_bucket_iterator = m_table.bucket(0).begin();
-            if (m_bucket_iterator.is_end())
-                skip_to_next();
-        }
     }
 
     HashTableType& m_table;
-    size_t m_bucket_index { 0 };
-    bool m_is_end { false };
-    BucketIteratorType m_bucket_iterator;
+    BucketType* m_bucket { nullptr };
 };
 
+// An open-addressing hash table with linear probing. Every bucket has a control byte that is
+// either free, deleted, or holds 7 bits of the element's hash, so most mismatches during a lookup
+// are rejected without calling into the traits. Elements stay put until the table is rehashed.
 template<typename T, typename TraitsForT>
 class HashTable {
 private:
-    using Bucket = SinglyLinkedList<T>;
+    static constexpr u8 free_bucket = 0x80;
+    static constexpr u8 deleted_bucket = 0x81;
+    static constexpr size_t min_capacity = 8;
+    static constexpr size_t load_factor_in_percent = 75;
+
+    struct Bucket {
+        u8 control { free_bucket };
+        alignas(T) u8 storage[sizeof(T)];
+
+        bool is_used() const { return !(control & 0x80); }
+        T* slot() { return reinterpret_cast<T*>(storage); }
+        const T* slot() const { return reinterpret_cast<const T*>(storage); }
+    };
 
 public:
     HashTable() { }
-    HashTable(size_t capacity)
-        : m_buckets(new Bucket[capacity])
-        , m_capacity(capacity)
-    {
-    }
+    HashTable(size_t capacity) { rehash(capacity); }
     HashTable(const HashTable& other)
     {
         ensure_capacity(other.size());
@@ -136,9 +125,11 @@ public:
     HashTable(HashTable&& other)
         : m_buckets(other.m_buckets)
         , m_size(other.m_size)
+        , m_deleted_count(other.m_deleted_count)
         , m_capacity(other.m_capacity)
     {
         other.m_size = 0;
+        other.m_deleted_count = 0;
         other.m_capacity = 0;
         other.m_buckets = nullptr;
     }
@@ -148,8 +139,10 @@ public:
             clear();
             m_buckets = other.m_buckets;
             m_size = other.m_size;
+            m_deleted_count = other.m_deleted_count;
             m_capacity = other.m_capacity;
             other.m_size = 0;
+            other.m_deleted_count = 0;
             other.m_capacity = 0;
             other.m_buckets = nullptr;
         }
@@ -164,7 +157,8 @@ public:
     void ensure_capacity(size_t capacity)
     {
         ASSERT(capacity >= size());
-        rehash(capacity);
+        if (capacity_for_size(capacity) > m_capacity)
+            rehash(capacity);
     }
 
     HashSetResult set(const T&);
@@ -181,40 +175,26 @@ public:
     bool contains(const T&) const;
     void clear();
 
-    using Iterator = HashTableIterator<HashTable, T, typename Bucket::Iterator>;
+    using Iterator = HashTableIterator<HashTable, T, Bucket>;
     friend Iterator;
-    Iterator begin() { return Iterator(*this, is_empty()); }
-    Iterator end() { return Iterator(*this, true); }
+    Iterator begin() { return Iterator(*this, first_used_bucket()); }
+    Iterator end() { return Iterator(*this, nullptr); }
 
-    using ConstIterator = HashTableIterator<const HashTable, const T, typename Bucket::ConstIterator>;
+    using ConstIterator = HashTableIterator<const HashTable, const T, const Bucket>;
     friend ConstIterator;
-    ConstIterator begin() const { return ConstIterator(*this, is_empty()); }
-    ConstIterator end() const { return ConstIterator(*this, true); }
+    ConstIterator begin() const { return ConstIterator(*this, first_used_bucket()); }
+    ConstIterator end() const { return ConstIterator(*this, nullptr); }
 
     template<typename Finder>
     Iterator find(unsigned hash, Finder finder)
     {
-        if (is_empty())
-            return end();
-        size_t bucket_index;
-        auto& bucket = lookup_with_hash(hash, &bucket_index);
-        auto bucket_iterator = bucket.find(finder);
-        if (bucket_iterator != bucket.end())
-            return Iterator(*this, false, bucket_iterator, bucket_index);
-        return end();
+        return Iterator(*this, lookup_with_hash(hash, finder));
     }
 
     template<typename Finder>
     ConstIterator find(unsigned hash, Finder finder) const
     {
-        if (is_empty())
-            return end();
-        size_t bucket_index;
-        auto& bucket = lookup_with_hash(hash, &bucket_index);
-        auto bucket_iterator = bucket.find(finder);
-        if (bucket_iterator != bucket.end())
-            return ConstIterator(*this, false, bucket_iterator, bucket_index);
-        return end();
+        return ConstIterator(*this, lookup_with_hash(hash, finder));
     }
 
     Iterator find(const T& value)
@@ -240,33 +220,77 @@ public:
     void remove(Iterator);
 
 private:
-    Bucket& lookup(const T&, size_t* bucket_index = nullptr);
-    const Bucket& lookup(const T&, size_t* bucket_index = nullptr) const;
+    static u8 control_for_hash(unsigned hash) { return hash & 0x7f; }
 
-    Bucket& lookup_with_hash(unsigned hash, size_t* bucket_index)
+    static size_t capacity_for_size(size_t size)
     {
-        if (bucket_index)
-            *bucket_index = hash % m_capacity;
-        return m_buckets[hash % m_capacity];
+        size_t needed = size * 100 / load_factor_in_percent + 1;
+        size_t capacity = min_capacity;
+        while (capacity < needed)
+            capacity *= 2;
+        return capacity;
     }
 
-    const Bucket& lookup_with_hash(unsigned hash, size_t* bucket_index) const
+    size_t bucket_index_for_hash(unsigned hash) const
     {
-        if (bucket_index)
-            *bucket_index = hash % m_capacity;
-        return m_buckets[hash % m_capacity];
+        // Fibonacci hashing spreads all bits of the hash over the (power of two) table,
+        // so even traits with weak hash functions don't end up in a long run of buckets.
+        unsigned shift = 32 - __builtin_ctz(m_capacity);
+        return (u32)(hash * 2654435769u) >> shift;
     }
 
-    void rehash(size_t capacity);
-    void insert(const T&);
-    void insert(T&&);
+    template<typename Finder>
+    Bucket* lookup_with_hash(unsigned hash, Finder finder) const
+    {
+        if (is_empty())
+            return nullptr;
+        u8 control = control_for_hash(hash);
+        size_t index = bucket_index_for_hash(hash);
+        // There's always at least one free bucket, so this terminates.
+        for (;;) {
+            auto& bucket = m_buckets[index];
+            if (bucket.control == free_bucket)
+                return nullptr;
+            if (bucket.control == control && finder(*bucket.slot()))
+                return &bucket;
+            index = (index + 1) & (m_capacity - 1);
+        }
+    }
 
-    Bucket& bucket(size_t index) { return m_buckets[index]; }
-    const Bucket& bucket(size_t index) const { return m_buckets[index]; }
+    Bucket& bucket_for_insertion(unsigned hash)
+    {
+        size_t index = bucket_index_for_hash(hash);
+        while (m_buckets[index].is_used())
+            index = (index + 1) & (m_capacity - 1);
+        auto& bucket = m_buckets[index];
+        if (bucket.control == deleted_bucket)
+            --m_deleted_count;
+        bucket.control = control_for_hash(hash);
+        ++m_size;
+        return bucket;
+    }
+
+    void ensure_room_for_one_more()
+    {
+        if ((m_size + m_deleted_count + 1) * 100 > m_capacity * load_factor_in_percent)
+            rehash(m_size + 1);
+    }
+
+    Bucket* first_used_bucket() const
+    {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (m_buckets[i].is_used())
+                return &m_buckets[i];
+        }
+        return nullptr;
+    }
+
+    void rehash(size_t capacity);
 
     Bucket* m_buckets { nullptr };
 
     size_t m_size { 0 };
+    size_t m_deleted_count { 0 };
     size_t m_capacity { 0 };
     bool m_clearing { false };
     bool m_rehashing { false };
@@ -275,62 +299,47 @@ private:
 template<typename T, typename TraitsForT>
 HashSetResult HashTable<T, TraitsForT>::set(T&& value)
 {
-    if (!m_capacity)
-        rehash(1);
-    auto& bucket = lookup(value);
-    for (auto& e : bucket) {
-        if (TraitsForT::equals(e, value)) {
-            e = move(value);
-            return HashSetResult::ReplacedExistingEntry;
-        }
-    }
-    if (size() >= capacity()) {
-        rehash(size() + 1);
-        insert(move(value));
-    } else {
-        bucket.append(move(value));
+    unsigned hash = TraitsForT::hash(value);
+    if (auto* bucket = lookup_with_hash(hash, [&](auto& other) { return TraitsForT::equals(value, other); })) {
+        *bucket->slot() = move(value);
+        return HashSetResult::ReplacedExistingEntry;
     }
-    m_size++;
+    ensure_room_for_one_more();
+    new (bucket_for_insertion(hash).slot()) T(move(value));
     return HashSetResult::InsertedNewEntry;
 }
 
 template<typename T, typename TraitsForT>
 HashSetResult HashTable<T, TraitsForT>::set(const T& value)
 {
-    if (!m_capacity)
-        rehash(1);
-    auto& bucket = lookup(value);
-    for (auto& e : bucket) {
-        if (TraitsForT::equals(e, value)) {
-            e = value;
-            return HashSetResult::ReplacedExistingEntry;
-        }
-    }
-    if (size() >= capacity()) {
-        rehash(size() + 1);
-        insert(value);
-    } else {
-        bucket.append(value);
+    unsigned hash = TraitsForT::hash(value);
+    if (auto* bucket = lookup_with_hash(hash, [&](auto& other) { return TraitsForT::equals(value, other); })) {
+        *bucket->slot() = value;
+        return HashSetResult::ReplacedExistingEntry;
     }
-    m_size++;
+    ensure_room_for_one_more();
+    new (bucket_for_insertion(hash).slot()) T(value);
     return HashSetResult::InsertedNewEntry;
 }
 
 template<typename T, typename TraitsForT>
-void HashTable<T, TraitsForT>::rehash(size_t new_capacity)
+void HashTable<T, TraitsForT>::rehash(size_t size)
 {
     TemporaryChange<bool> change(m_rehashing, true);
-    new_capacity *= 2;
-    auto* new_buckets = new Bucket[new_capacity];
+    size_t new_capacity = capacity_for_size(size);
     auto* old_buckets = m_buckets;
     size_t old_capacity = m_capacity;
-    m_buckets = new_buckets;
+    m_buckets = new Bucket[new_capacity];
     m_capacity = new_capacity;
+    m_size = 0;
+    m_deleted_count = 0;
 
     for (size_t i = 0; i < old_capacity; ++i) {
-        for (auto& value : old_buckets[i]) {
-            insert(move(value));
-        }
+        auto& old_bucket = old_buckets[i];
+        if (!old_bucket.is_used())
+            continue;
+        new (bucket_for_insertion(TraitsForT::hash(*old_bucket.slot())).slot()) T(move(*old_bucket.slot()));
+        old_bucket.slot()->~T();
     }
 
     delete[] old_buckets;
@@ -341,64 +350,41 @@ void HashTable<T, TraitsForT>::clear()
 {
     TemporaryChange<bool> change(m_clearing, true);
     if (m_buckets) {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (m_buckets[i].is_used())
+                m_buckets[i].slot()->~T();
+        }
         delete[] m_buckets;
         m_buckets = nullptr;
     }
     m_capacity = 0;
     m_size = 0;
-}
-
-template<typename T, typename TraitsForT>
-void HashTable<T, TraitsForT>::insert(T&& value)
-{
-    auto& bucket = lookup(value);
-    bucket.append(move(value));
-}
-
-template<typename T, typename TraitsForT>
-void HashTable<T, TraitsForT>::insert(const T& value)
-{
-    auto& bucket = lookup(value);
-    bucket.append(value);
+    m_deleted_count = 0;
 }
 
 template<typename T, typename TraitsForT>
 bool HashTable<T, TraitsForT>::contains(const T& value) const
 {
-    if (is_empty())
-        return false;
-    auto& bucket = lookup(value);
-    for (auto& e : bucket) {
-        if (TraitsForT::equals(e, value))
-            return true;
-    }
-    return false;
+    return find(value) != end();
 }
 
 template<typename T, typename TraitsForT>
 void HashTable<T, TraitsForT>::remove(Iterator it)
 {
     ASSERT(!is_empty());
-    m_buckets[it.m_bucket_index].remove(it.m_bucket_iterator);
+    auto& bucket = *it.m_bucket;
+    ASSERT(bucket.is_used());
+    bucket.slot()->~T();
     --m_size;
-}
-
-template<typename T, typename TraitsForT>
-auto HashTable<T, TraitsForT>::lookup(const T& value, size_t* bucket_index) -> Bucket&
-{
-    unsigned hash = TraitsForT::hash(value);
-    if (bucket_index)
-        *bucket_index = hash % m_capacity;
-    return m_buckets[hash % m_capacity];
-}
-
-template<typename T, typename TraitsForT>
-auto HashTable<T, TraitsForT>::lookup(const T& value, size_t* bucket_index) const -> const Bucket&
-{
-    unsigned hash = TraitsForT::hash(value);
-    if (bucket_index)
-        *bucket_index = hash % m_capacity;
-    return m_buckets[hash % m_capacity];
+    // If the next bucket is free, no probe sequence can run through this one,
+    // so it doesn't have to be kept around as a tombstone.
+    size_t next_index = (&bucket - m_buckets + 1) & (m_capacity - 1);
+    if (m_buckets[next_index].control == free_bucket) {
+        bucket.control = free_bucket;
+    } else {
+        bucket.control = deleted_bucket;
+        ++m_deleted_count;
+    }
 }
 
 }
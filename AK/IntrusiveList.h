@@ -50,6 +50,7 @@ public:
     bool is_empty() const;
     void append(T& n);
     void prepend(T& n);
+    void insert_before(T& before, T& n);
     void remove(T& n);
     bool contains(const T&) const;
     T* first() const;
@@ -202,6 +203,26 @@ inline void IntrusiveList<T, member>::prepend(T& n)
         m_storage.m_last = &nnode;
 }
 
+template<class T, IntrusiveListNode T::*member>
+inline void IntrusiveList<T, member>::insert_before(T& before, T& n)
+{
+    auto& bnode = before.*member;
+    auto& nnode = n.*member;
+    ASSERT(bnode.m_storage == &m_storage);
+    if (nnode.m_storage)
+        nnode.remove();
+
+    nnode.m_storage = &m_storage;
+    nnode.m_prev = bnode.m_prev;
+    nnode.m_next = &bnode;
+
+    if (bnode.m_prev)
+        bnode.m_prev->m_next = &nnode;
+    else
+        m_storage.m_first = &nnode;
+    bnode.m_prev = &nnode;
+}
+
 template<class T, IntrusiveListNode T::*member>
 inline void IntrusiveList<T, member>::remove(T& n)
 {
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/JsonParser.h>
+#include <AK/JsonStreamReader.h>
+#include <AK/StringUtils.h>
+
+namespace AK {
+
+int JsonStreamReader::peek()
+{
+    if (m_buffer_offset == m_buffer_size) {
+        if (m_eof)
+            return -1;
+        m_buffer_offset = 0;
+        m_buffer_size = m_stream.read({ m_buffer, sizeof(m_buffer) });
+        if (m_buffer_size == 0) {
+            m_eof = true;
+            return -1;
+        }
+    }
+    return m_buffer[m_buffer_offset];
+}
+
+int JsonStreamReader::consume()
+{
+    int ch = peek();
+    if (ch != -1)
+        ++m_buffer_offset;
+    return ch;
+}
+
+bool JsonStreamReader::consume_specific(char expected)
+{
+    if (peek() != (u8)expected)
+        return false;
+    ++m_buffer_offset;
+    return true;
+}
+
+bool JsonStreamReader::consume_literal(const char* literal)
+{
+    for (; *literal; ++literal) {
+        if (!consume_specific(*literal))
+            return false;
+    }
+    return true;
+}
+
+void JsonStreamReader::skip_whitespace()
+{
+    for (;;) {
+        int ch = peek();
+        if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
+            return;
+        ++m_buffer_offset;
+    }
+}
+
+void JsonStreamReader::did_finish_value()
+{
+    m_state = m_containers.is_empty() ? State::Done : State::CommaOrEnd;
+}
+
+bool JsonStreamReader::read_string()
+{
+    if (!consume_specific('"'))
+        return false;
+
+    m_text_builder.clear();
+    for (;;) {
+        int ch = consume();
+        if (ch == -1)
+            return false;
+        if (ch == '"')
+            break;
+        if (ch != '\\') {
+            m_text_builder.append((char)ch);
+            continue;
+        }
+        int escaped_ch = consume();
+        switch (escaped_ch) {
+        case -1:
+            return false;
+        case 'n':
+            m_text_builder.append('\n');
+            break;
+        case 'r':
+            m_text_builder.append('\r');
+            break;
+        case 't':
+            m_text_builder.append('\t');
+            break;
+        case 'b':
+            m_text_builder.append('\b');
+            break;
+        case 'f':
+            m_text_builder.append('\f');
+            break;
+        case 'u': {
+            char hex[4];
+            for (size_t i = 0; i < 4; ++i) {
+                int hex_ch = consume();
+                if (hex_ch == -1)
+                    return false;
+                hex[i] = (char)hex_ch;
+            }
+            auto code_point = AK::StringUtils::convert_to_uint_from_hex(StringView(hex, 4));
+            if (code_point.has_value())
+                m_text_builder.append_code_point(code_point.value());
+            else
+                m_text_builder.append('?');
+        } break;
+        default:
+            m_text_builder.append((char)escaped_ch);
+            break;
+        }
+    }
+    m_text = m_text_builder.to_string();
+    return true;
+}
+
+Optional<JsonStreamReader::Token> JsonStreamReader::read_value()
+{
+    switch (peek()) {
+    case '{':
+        consume();
+        m_containers.append(Container::Object);
+        m_state = State::KeyOrEndObject;
+        return Token::StartObject;
+    case '[':
+        consume();
+        m_containers.append(Container::Array);
+        m_state = State::ValueOrEndArray;
+        return Token::StartArray;
+    case '"':
+        if (!read_string())
+            return fail();
+        did_finish_value();
+        return Token::String;
+    case 't':
+        if (!consume_literal("true"))
+            return fail();
+        did_finish_value();
+        return Token::True;
+    case 'f':
+        if (!consume_literal("false"))
+            return fail();
+        did_finish_value();
+        return Token::False;
+    case 'n':
+        if (!consume_literal("null"))
+            return fail();
+        did_finish_value();
+        return Token::Null;
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9': {
+        char number[64];
+        size_t length = 0;
+        for (;;) {
+            int ch = peek();
+            if (!((ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E'))
+                break;
+            if (length == sizeof(number))
+                return fail();
+            number[length++] = (char)consume();
+        }
+        m_text = String(number, length);
+        did_finish_value();
+        return Token::Number;
+    }
+    default:
+        return fail();
+    }
+}
+
+bool JsonStreamReader::next()
+{
+    auto token = [this]() -> Optional<Token> {
+        for (;;) {
+            skip_whitespace();
+            switch (m_state) {
+            case State::Done:
+                if (!m_error && peek() != -1)
+                    return fail();
+                return {};
+            case State::ValueOrEndArray:
+                if (consume_specific(']')) {
+                    m_containers.take_last();
+                    did_finish_value();
+                    return Token::EndArray;
+                }
+                [[fallthrough]];
+            case State::Value:
+                return read_value();
+            case State::KeyOrEndObject:
+                if (consume_specific('}')) {
+                    m_containers.take_last();
+                    did_finish_value();
+                    return Token::EndObject;
+                }
+                [[fallthrough]];
+            case State::Key:
+                if (!read_string())
+                    return fail();
+                skip_whitespace();
+                if (!consume_specific(':'))
+                    return fail();
+                m_state = State::Value;
+                return Token::Key;
+            case State::CommaOrEnd: {
+                bool in_object = m_containers.last() == Container::Object;
+                if (consume_specific(in_object ? '}' : ']')) {
+                    m_containers.take_last();
+                    did_finish_value();
+                    return in_object ? Token::EndObject : Token::EndArray;
+                }
+                if (!consume_specific(','))
+                    return fail();
+                m_state = in_object ? State::Key : State::Value;
+                continue;
+            }
+            }
+            ASSERT_NOT_REACHED();
+        }
+    }();
+    if (!token.has_value())
+        return false;
+    m_token = token.value();
+    return true;
+}
+
+JsonValue JsonStreamReader::value() const
+{
+    switch (m_token) {
+    case Token::Key:
+    case Token::String:
+        return JsonValue(m_text);
+    case Token::True:
+        return JsonValue(true);
+    case Token::False:
+        return JsonValue(false);
+    case Token::Number: {
+        auto number = JsonParser(m_text).parse();
+        if (number.has_value())
+            return number.release_value();
+        return JsonValue(m_text);
+    }
+    default:
+        return JsonValue(JsonValue::Type::Null);
+    }
+}
+
+}
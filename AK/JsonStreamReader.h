@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/JsonValue.h>
+#include <AK/Optional.h>
+#include <AK/Stream.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+// JsonStreamReader: Incremental, pull-based JSON reader.
+//
+// Unlike JsonParser, this never builds a tree. Each call to next() reads just enough of
+// the underlying InputStream to produce one token, so a document of any size can be
+// walked in memory proportional to its nesting depth (plus the longest single string).
+//
+//     JsonStreamReader reader(stream);
+//     while (reader.next()) {
+//         if (reader.token() == JsonStreamReader::Token::Key)
+//             dbg() << "key: " << reader.text();
+//     }
+//     if (reader.has_error())
+//         ...
+
+class JsonStreamReader {
+public:
+    enum class Token {
+        StartObject,
+        EndObject,
+        StartArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+    };
+
+    explicit JsonStreamReader(InputStream& stream)
+        : m_stream(stream)
+    {
+    }
+
+    // Advances to the next token. Returns false once the document is complete.
+    // If the input is malformed, has_error() becomes true and no more tokens are produced.
+    bool next();
+
+    Token token() const { return m_token; }
+
+    bool has_error() const { return m_error; }
+
+    // The unescaped text of the last Key or String token, or the literal text of the last Number.
+    const String& text() const { return m_text; }
+
+    // The last scalar token as a JsonValue. Not valid for the structural tokens.
+    JsonValue value() const;
+
+    // The number of objects and arrays currently open.
+    size_t depth() const { return m_containers.size(); }
+
+private:
+    enum class State : u8 {
+        Value,
+        ValueOrEndArray,
+        KeyOrEndObject,
+        Key,
+        CommaOrEnd,
+        Done,
+    };
+
+    enum class Container : u8 {
+        Object,
+        Array,
+    };
+
+    int peek();
+    int consume();
+    bool consume_specific(char);
+    bool consume_literal(const char*);
+    void skip_whitespace();
+
+    Optional<Token> read_value();
+    bool read_string();
+    void did_finish_value();
+    Optional<Token> fail()
+    {
+        m_error = true;
+        m_state = State::Done;
+        return {};
+    }
+
+    InputStream& m_stream;
+    u8 m_buffer[4096];
+    size_t m_buffer_size { 0 };
+    size_t m_buffer_offset { 0 };
+    bool m_eof { false };
+    bool m_error { false };
+
+    State m_state { State::Value };
+    Vector<Container, 32> m_containers;
+
+    Token m_token { Token::Null };
+    String m_text;
+    StringBuilder m_text_builder;
+};
+
+}
+
+using AK::JsonStreamReader;
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Stream.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+// JsonStreamWriter: Writes JSON straight into an OutputStream as it's produced.
+//
+// This is the streaming counterpart to JsonStreamReader. Structure is tracked with a small
+// fixed-capacity stack and numbers are formatted on the stack, so nothing is heap-allocated
+// unless documents nest deeper than the inline capacity. Strings are escaped on the way out.
+
+class JsonStreamWriter {
+public:
+    explicit JsonStreamWriter(OutputStream& stream)
+        : m_stream(stream)
+    {
+    }
+
+    void begin_object()
+    {
+        begin_value();
+        write('{');
+        m_has_items.append(false);
+    }
+
+    void end_object()
+    {
+        m_has_items.take_last();
+        write('}');
+    }
+
+    void begin_array()
+    {
+        begin_value();
+        write('[');
+        m_has_items.append(false);
+    }
+
+    void end_array()
+    {
+        m_has_items.take_last();
+        write(']');
+    }
+
+    void key(const StringView& name)
+    {
+        begin_value();
+        write_escaped_string(name);
+        write(':');
+        m_after_key = true;
+    }
+
+    void value(const StringView& string)
+    {
+        begin_value();
+        write_escaped_string(string);
+    }
+
+    void value(const char* string) { value(StringView(string)); }
+
+    void value(bool boolean)
+    {
+        begin_value();
+        write(boolean ? "true" : "false");
+    }
+
+    void value(i64 number)
+    {
+        begin_value();
+        if (number < 0) {
+            write('-');
+            write_unsigned((u64)0 - (u64)number);
+        } else {
+            write_unsigned((u64)number);
+        }
+    }
+
+    void value(u64 number)
+    {
+        begin_value();
+        write_unsigned(number);
+    }
+
+    void value(int number) { value((i64)number); }
+    void value(unsigned number) { value((u64)number); }
+
+#ifndef KERNEL
+    void value(double number)
+    {
+        begin_value();
+        if (number < 0) {
+            write('-');
+            number = -number;
+        }
+        u64 whole = (u64)number;
+        write_unsigned(whole);
+        write('.');
+        u64 fraction = (u64)((number - (double)whole) * 1000000);
+        char digits[6];
+        for (int i = 5; i >= 0; --i) {
+            digits[i] = '0' + (fraction % 10);
+            fraction /= 10;
+        }
+        write(StringView(digits, sizeof(digits)));
+    }
+#endif
+
+    void null_value()
+    {
+        begin_value();
+        write("null");
+    }
+
+    // Writes already-formatted JSON (e.g. a number token from JsonStreamReader) as a value.
+    void raw_value(const StringView& json)
+    {
+        begin_value();
+        write(json);
+    }
+
+    size_t depth() const { return m_has_items.size(); }
+
+private:
+    void begin_value()
+    {
+        if (m_after_key) {
+            m_after_key = false;
+            return;
+        }
+        if (m_has_items.is_empty())
+            return;
+        if (m_has_items.last())
+            write(',');
+        m_has_items.last() = true;
+    }
+
+    void write(char ch) { m_stream.write_or_error({ &ch, 1 }); }
+    void write(const StringView& string) { m_stream.write_or_error(string.bytes()); }
+
+    void write_unsigned(u64 number)
+    {
+        char digits[20];
+        size_t length = 0;
+        do {
+            digits[sizeof(digits) - ++length] = '0' + (number % 10);
+            number /= 10;
+        } while (number);
+        write(StringView(digits + sizeof(digits) - length, length));
+    }
+
+    void write_escaped_string(const StringView& string)
+    {
+        static constexpr char hex_digits[] = "0123456789abcdef";
+        write('"');
+        size_t run_start = 0;
+        for (size_t i = 0; i < string.length(); ++i) {
+            u8 ch = string[i];
+            if (ch >= 0x20 && ch != '"' && ch != '\\')
+                continue;
+            write(string.substring_view(run_start, i - run_start));
+            run_start = i + 1;
+            switch (ch) {
+            case '"':
+                write("\\\"");
+                break;
+            case '\\':
+                write("\\\\");
+                break;
+            case '\n':
+                write("\\n");
+                break;
+            case '\r':
+                write("\\r");
+                break;
+            case '\t':
+                write("\\t");
+                break;
+            case '\b':
+                write("\\b");
+                break;
+            case '\f':
+                write("\\f");
+                break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', hex_digits[ch >> 4], hex_digits[ch & 0xf] };
+                write(StringView(escape, sizeof(escape)));
+            }
+            }
+        }
+        write(string.substring_view(run_start, string.length() - run_start));
+        write('"');
+    }
+
+    OutputStream& m_stream;
+    Vector<bool, 32> m_has_items;
+    bool m_after_key { false };
+};
+
+}
+
+using AK::JsonStreamWriter;
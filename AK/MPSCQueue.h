@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Futex.h>
+#include <AK/Optional.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+
+namespace AK {
+
+// A bounded, lock-free ring buffer that any number of producer threads can hand values to,
+// and that exactly one consumer thread takes them out of. Producers claim slots with a
+// compare-and-swap, and every slot carries a sequence number that tells whether it is free,
+// being filled, or ready. The consumer can block in dequeue() until something arrives.
+template<typename T, size_t Capacity>
+class MPSCQueue {
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "MPSCQueue capacity must be a power of two");
+
+public:
+    MPSCQueue()
+    {
+        for (u32 i = 0; i < Capacity; ++i)
+            m_cells[i].sequence.store(i, AK::memory_order_relaxed);
+    }
+
+    ~MPSCQueue()
+    {
+        while (try_dequeue().has_value())
+            ;
+    }
+
+    size_t capacity() const { return Capacity; }
+
+    // Any thread. Returns false (and leaves value alone) if the queue is full.
+    bool try_enqueue(T&& value)
+    {
+        Cell* cell;
+        u32 position = m_enqueue_position.load(AK::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[position & (Capacity - 1)];
+            i32 difference = (i32)(cell->sequence.load(AK::memory_order_acquire) - position);
+            if (difference == 0) {
+                if (m_enqueue_position.compare_exchange_strong(position, position + 1, AK::memory_order_relaxed))
+                    break;
+                // compare_exchange_strong() reloaded position for us.
+            } else if (difference < 0) {
+                // The consumer hasn't taken the value from a lap ago out of this cell yet.
+                return false;
+            } else {
+                position = m_enqueue_position.load(AK::memory_order_relaxed);
+            }
+        }
+
+        new (cell->storage) T(move(value));
+        cell->sequence.store(position + 1, AK::memory_order_release);
+
+        // See dequeue() for why this can't be a weaker ordering.
+        m_publish_count.fetch_add(1);
+        if (m_consumer_is_waiting.load())
+            futex_wake(m_publish_count);
+        return true;
+    }
+
+    bool try_enqueue(const T& value)
+    {
+        T copy(value);
+        return try_enqueue(move(copy));
+    }
+
+    // Consumer only.
+    Optional<T> try_dequeue()
+    {
+        Cell& cell = m_cells[m_dequeue_position & (Capacity - 1)];
+        if (cell.sequence.load(AK::memory_order_acquire) != m_dequeue_position + 1)
+            return {};
+        T& stored = *reinterpret_cast<T*>(cell.storage);
+        T value = move(stored);
+        stored.~T();
+        cell.sequence.store(m_dequeue_position + Capacity, AK::memory_order_release);
+        ++m_dequeue_position;
+        return value;
+    }
+
+    // Consumer only. Sleeps until there's a value to return.
+    T dequeue()
+    {
+        for (;;) {
+            u32 publish_count = m_publish_count.load();
+            if (auto value = try_dequeue(); value.has_value())
+                return value.release_value();
+            // Producers bump the count before checking the flag, so either one of them
+            // sees the flag and wakes us, or the futex sees the count change and returns.
+            m_consumer_is_waiting.store(true);
+            futex_wait(m_publish_count, publish_count);
+            m_consumer_is_waiting.store(false);
+        }
+    }
+
+private:
+    struct Cell {
+        Atomic<u32> sequence;
+        alignas(T) u8 storage[sizeof(T)];
+    };
+
+    alignas(64) Atomic<u32> m_enqueue_position { 0 };
+    Atomic<u32> m_publish_count { 0 };
+    alignas(64) u32 m_dequeue_position { 0 };
+    Atomic<bool> m_consumer_is_waiting { false };
+    Cell m_cells[Capacity];
+};
+
+}
+
+using AK::MPSCQueue;
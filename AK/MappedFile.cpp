@@ -27,6 +27,7 @@
 #include <AK/MappedFile.h>
 #include <AK/String.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -96,4 +97,94 @@ MappedFile& MappedFile::operator=(MappedFile&& other)
     return *this;
 }
 
+MappedFileWindow::MappedFileWindow(const StringView& file_name, size_t window_size, AccessPattern access_pattern)
+    : m_access_pattern(access_pattern)
+{
+    m_window_size = max(window_size + PAGE_SIZE - 1, (size_t)PAGE_SIZE) & ~(PAGE_SIZE - 1);
+
+    m_fd = open_with_path_length(file_name.characters_without_null_termination(), file_name.length(), O_RDONLY | O_CLOEXEC, 0);
+    if (m_fd == -1) {
+        m_errno = errno;
+        perror("open");
+        return;
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) < 0) {
+        m_errno = errno;
+        perror("fstat");
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_file_size = st.st_size;
+}
+
+MappedFileWindow::~MappedFileWindow()
+{
+    unmap_window();
+    if (m_fd != -1)
+        close(m_fd);
+}
+
+void MappedFileWindow::unmap_window()
+{
+    if (m_map == (void*)-1)
+        return;
+#ifdef MADV_DONTNEED
+    // The pages behind a sequential scan won't be touched again, so don't let them linger.
+    if (m_access_pattern == AccessPattern::Sequential)
+        madvise(m_map, m_map_size, MADV_DONTNEED);
+#endif
+    int rc = munmap(m_map, m_map_size);
+    ASSERT(rc == 0);
+    m_map = (void*)-1;
+    m_map_offset = 0;
+    m_map_size = 0;
+}
+
+ReadonlyBytes MappedFileWindow::window_at(u64 offset, size_t min_size)
+{
+    if (!is_valid() || offset >= m_file_size)
+        return {};
+
+    min_size = min((u64)min_size, m_file_size - offset);
+
+    if (m_map != (void*)-1 && offset >= m_map_offset && offset < m_map_offset + m_map_size && offset + min_size <= m_map_offset + m_map_size) {
+        size_t offset_in_map = offset - m_map_offset;
+        return { (const u8*)m_map + offset_in_map, m_map_size - offset_in_map };
+    }
+
+    unmap_window();
+
+    u64 map_offset = offset & ~(u64)(PAGE_SIZE - 1);
+    size_t offset_in_map = offset - map_offset;
+    size_t map_size = min((u64)max(m_window_size, offset_in_map + min_size), m_file_size - map_offset);
+
+    void* map = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, m_fd, map_offset);
+    if (map == MAP_FAILED) {
+        m_errno = errno;
+        perror("mmap");
+        return {};
+    }
+
+#if defined(MADV_SEQUENTIAL) && defined(MADV_WILLNEED)
+    if (m_access_pattern == AccessPattern::Sequential) {
+        madvise(map, map_size, MADV_SEQUENTIAL);
+        madvise(map, map_size, MADV_WILLNEED);
+    } else {
+        madvise(map, map_size, MADV_RANDOM);
+    }
+#endif
+
+#ifdef DEBUG_MAPPED_FILE
+    dbgprintf("MappedFileWindow{fd=%d} window at %llu, size=%zu, map=%p\n", m_fd, map_offset, map_size, map);
+#endif
+
+    m_map = map;
+    m_map_offset = map_offset;
+    m_map_size = map_size;
+    return { (const u8*)m_map + offset_in_map, m_map_size - offset_in_map };
+}
+
 }
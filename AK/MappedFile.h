@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Noncopyable.h>
+#include <AK/Span.h>
 #include <AK/StringView.h>
 
 namespace AK {
@@ -60,6 +61,53 @@ private:
     int m_errno { 0 };
 };
 
+// MappedFileWindow maps only a sliding range of a file at a time, so files larger than the
+// free address space can still be walked through. Moving the window in sequential mode drops
+// the pages behind it and asks the kernel to read ahead of it.
+class MappedFileWindow {
+    AK_MAKE_NONCOPYABLE(MappedFileWindow);
+    AK_MAKE_NONMOVABLE(MappedFileWindow);
+
+public:
+    enum class AccessPattern {
+        Sequential,
+        Random,
+    };
+
+    static constexpr size_t default_window_size = 16 * MiB;
+
+    explicit MappedFileWindow(const StringView& file_name, size_t window_size = default_window_size, AccessPattern = AccessPattern::Sequential);
+    ~MappedFileWindow();
+
+    bool is_valid() const { return m_fd != -1; }
+    int errno_if_invalid() const
+    {
+        ASSERT(!is_valid());
+        return m_errno;
+    }
+
+    u64 file_size() const { return m_file_size; }
+    size_t window_size() const { return m_window_size; }
+
+    // Returns the bytes from offset to the end of the mapped window, which holds at least
+    // min_size bytes unless the file ends first. The span is valid until the next call.
+    ReadonlyBytes window_at(u64 offset, size_t min_size = 0);
+
+private:
+    void unmap_window();
+
+    int m_fd { -1 };
+    int m_errno { 0 };
+    u64 m_file_size { 0 };
+    size_t m_window_size { 0 };
+    AccessPattern m_access_pattern { AccessPattern::Sequential };
+
+    void* m_map { (void*)-1 };
+    u64 m_map_offset { 0 };
+    size_t m_map_size { 0 };
+};
+
 }
 
 using AK::MappedFile;
+using AK::MappedFileWindow;
@@ -26,40 +26,191 @@
 
 #pragma once
 
-#include <AK/Assertions.h>
 #include <AK/Types.h>
 
+#if defined(__SSE2__) && !defined(KERNEL)
+#    define AK_MEMMEM_HAVE_SSE2
+#endif
+
 namespace AK {
 
-namespace {
-const static void* bitap_bitwise(const void* haystack, size_t haystack_length, const void* needle, size_t needle_length)
+namespace Detail {
+
+// Needles at least this long are searched with the two-way algorithm, shorter ones with a plain filter.
+constexpr size_t two_way_threshold = 32;
+
+// Computes the maximal suffix of the needle under the normal or reversed element ordering,
+// returning where it starts and its period.
+template<typename T>
+inline void maximal_suffix(const T* needle, size_t needle_length, bool reversed, size_t& start, size_t& period)
 {
-    ASSERT(needle_length < 32);
+    // This is the position just before the suffix, which starts out as -1.
+    size_t before = (size_t)-1;
+    size_t candidate = 0;
+    size_t offset = 1;
+    period = 1;
+    while (candidate + offset < needle_length) {
+        auto a = needle[before + offset];
+        auto b = needle[candidate + offset];
+        if (a == b) {
+            if (offset == period) {
+                candidate += period;
+                offset = 1;
+            } else {
+                ++offset;
+            }
+        } else if (reversed ? a < b : a > b) {
+            candidate += offset;
+            offset = 1;
+            period = candidate - before;
+        } else {
+            before = candidate++;
+            offset = period = 1;
+        }
+    }
+    start = before + 1;
+}
 
-    u64 lookup = 0xfffffffe;
+// The two-way algorithm by Crochemore and Perrin, which runs in linear time and constant space.
+// Like musl's memmem, it first looks at the element under the end of the needle and skips ahead Horspool style
+// when that doesn't fit. The skip table is indexed by the low byte of each element, which only makes skips shorter
+// for elements wider than a byte.
+template<typename T>
+inline const T* two_way_search(const T* haystack, size_t haystack_length, const T* needle, size_t needle_length)
+{
+    // One past the last position in the needle of an element with the given low byte, or 0 if there is none.
+    size_t last_position[256];
+    for (size_t i = 0; i < 256; ++i)
+        last_position[i] = 0;
+    for (size_t i = 0; i < needle_length; ++i)
+        last_position[(u8)needle[i]] = i + 1;
 
-    constexpr size_t mask_length = (size_t)((u8)-1) + 1;
-    u64 needle_mask[mask_length];
+    // The longer of the two maximal suffixes gives a critical factorization of the needle.
+    size_t split;
+    size_t period;
+    maximal_suffix(needle, needle_length, false, split, period);
+    size_t reversed_split;
+    size_t reversed_period;
+    maximal_suffix(needle, needle_length, true, reversed_split, reversed_period);
+    if (reversed_split > split) {
+        split = reversed_split;
+        period = reversed_period;
+    }
 
-    for (size_t i = 0; i < mask_length; ++i)
-        needle_mask[i] = 0xffffffff;
+    bool is_periodic = true;
+    for (size_t i = 0; i < split; ++i) {
+        if (needle[i] != needle[i + period]) {
+            is_periodic = false;
+            break;
+        }
+    }
 
-    for (size_t i = 0; i < needle_length; ++i)
-        needle_mask[((const u8*)needle)[i]] &= ~(0x00000001 << i);
+    // For periodic needles, this much of the needle is known to match after shifting by a period.
+    size_t memory_after_shift = 0;
+    if (is_periodic) {
+        memory_after_shift = needle_length - period;
+    } else {
+        period = (split > needle_length - split ? split - 1 : needle_length - split) + 1;
+    }
+
+    size_t memory = 0;
+    const T* position = haystack;
+    const T* end = haystack + haystack_length;
+    while ((size_t)(end - position) >= needle_length) {
+        size_t last = last_position[(u8)position[needle_length - 1]];
+        if (!last) {
+            position += needle_length;
+            memory = 0;
+            continue;
+        }
+        if (size_t skip = needle_length - last) {
+            position += skip < memory ? memory : skip;
+            memory = 0;
+            continue;
+        }
 
-    for (size_t i = 0; i < haystack_length; ++i) {
-        lookup |= needle_mask[((const u8*)haystack)[i]];
-        lookup <<= 1;
+        // Compare the right half, then the left half.
+        size_t i = split > memory ? split : memory;
+        while (i < needle_length && needle[i] == position[i])
+            ++i;
+        if (i < needle_length) {
+            position += i - split + 1;
+            memory = 0;
+            continue;
+        }
+        i = split;
+        while (i > memory && needle[i - 1] == position[i - 1])
+            --i;
+        if (i <= memory)
+            return position;
+        position += period;
+        memory = memory_after_shift;
+    }
+    return nullptr;
+}
 
-        if (!(lookup & (0x00000001 << needle_length)))
-            return ((const u8*)haystack) + i - needle_length + 1;
+// For short needles, finds the positions where both the first and the last byte of the needle show up
+// the right distance apart, a whole register at a time, and only compares the needle there.
+inline const u8* first_and_last_byte_search(const u8* haystack, size_t haystack_length, const u8* needle, size_t needle_length)
+{
+    size_t last_start = haystack_length - needle_length;
+    size_t i = 0;
+
+    auto matches_at = [&](size_t start) {
+        return __builtin_memcmp(haystack + start, needle, needle_length) == 0;
+    };
+
+#ifdef AK_MEMMEM_HAVE_SSE2
+    typedef char v16qi __attribute__((vector_size(16), may_alias));
+    typedef char v16qi_unaligned __attribute__((vector_size(16), may_alias, aligned(1)));
+    v16qi first = (v16qi) {} + (char)needle[0];
+    v16qi last = (v16qi) {} + (char)needle[needle_length - 1];
+    for (; i + 16 <= last_start + 1; i += 16) {
+        v16qi a = *(const v16qi_unaligned*)(haystack + i);
+        v16qi b = *(const v16qi_unaligned*)(haystack + i + needle_length - 1);
+        unsigned candidates = __builtin_ia32_pmovmskb128((v16qi)((a == first) & (b == last)));
+        while (candidates) {
+            size_t start = i + __builtin_ctz(candidates);
+            if (matches_at(start))
+                return haystack + start;
+            candidates &= candidates - 1;
+        }
+    }
+#else
+    // A zero byte in either word always sets the top bit of that byte in has_zero(), and the rare false
+    // positives (from borrows out of a zero byte) are weeded out by the comparison.
+    constexpr FlatPtr ones = (FlatPtr)-1 / 0xff;
+    constexpr FlatPtr highs = ones << 7;
+    auto has_zero = [&](FlatPtr word) { return (word - ones) & ~word & highs; };
+    FlatPtr first = ones * needle[0];
+    FlatPtr last = ones * needle[needle_length - 1];
+    for (; i + sizeof(FlatPtr) <= last_start + 1; i += sizeof(FlatPtr)) {
+        FlatPtr a;
+        FlatPtr b;
+        __builtin_memcpy(&a, haystack + i, sizeof(FlatPtr));
+        __builtin_memcpy(&b, haystack + i + needle_length - 1, sizeof(FlatPtr));
+        FlatPtr candidates = has_zero(a ^ first) & has_zero(b ^ last);
+        while (candidates) {
+            size_t start = i + __builtin_ctzll(candidates) / 8;
+            if (matches_at(start))
+                return haystack + start;
+            candidates &= candidates - 1;
+        }
     }
+#endif
 
+    for (; i <= last_start; ++i) {
+        if (haystack[i] == needle[0] && matches_at(i))
+            return haystack + i;
+    }
     return nullptr;
 }
+
 }
 
-static inline const void* memmem(const void* haystack, size_t haystack_length, const void* needle, size_t needle_length)
+// Finds the first occurrence of a sequence of elements (e.g. code points) in another one.
+template<typename T>
+inline const T* find_sequence(const T* haystack, size_t haystack_length, const T* needle, size_t needle_length)
 {
     if (needle_length == 0)
         return haystack;
@@ -67,21 +218,50 @@ static inline const void* memmem(const void* haystack, size_t haystack_length, c
     if (haystack_length < needle_length)
         return nullptr;
 
-    if (haystack_length == needle_length)
-        return __builtin_memcmp(haystack, needle, haystack_length) == 0 ? haystack : nullptr;
+    if (needle_length >= Detail::two_way_threshold)
+        return Detail::two_way_search(haystack, haystack_length, needle, needle_length);
 
-    if (needle_length < 32)
-        return bitap_bitwise(haystack, haystack_length, needle, needle_length);
+    for (size_t i = 0; i <= haystack_length - needle_length; ++i) {
+        if (haystack[i] != needle[0])
+            continue;
+        size_t j = 1;
+        while (j < needle_length && haystack[i + j] == needle[j])
+            ++j;
+        if (j == needle_length)
+            return haystack + i;
+    }
+    return nullptr;
+}
 
-    // Fallback to a slower search.
-    auto length_diff = haystack_length - needle_length;
-    for (size_t i = 0; i < length_diff; ++i) {
-        const auto* start = ((const u8*)haystack) + i;
-        if (__builtin_memcmp(start, needle, needle_length) == 0)
-            return start;
+static inline const void* memmem(const void* haystack, size_t haystack_length, const void* needle, size_t needle_length)
+{
+    if (needle_length == 0)
+        return haystack;
+
+    if (haystack_length < needle_length)
+        return nullptr;
+
+    auto* bytes = (const u8*)haystack;
+    auto* needle_bytes = (const u8*)needle;
+
+    if (needle_length == 1) {
+#ifndef KERNEL
+        return __builtin_memchr(haystack, needle_bytes[0], haystack_length);
+#else
+        for (size_t i = 0; i < haystack_length; ++i) {
+            if (bytes[i] == needle_bytes[0])
+                return bytes + i;
+        }
+        return nullptr;
+#endif
     }
 
-    return nullptr;
+    if (needle_length < Detail::two_way_threshold)
+        return Detail::first_and_last_byte_search(bytes, haystack_length, needle_bytes, needle_length);
+
+    return Detail::two_way_search(bytes, haystack_length, needle_bytes, needle_length);
 }
 
 }
+
+using AK::find_sequence;
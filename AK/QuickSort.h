@@ -30,59 +30,134 @@
 
 namespace AK {
 
-/* This is a dual pivot quick sort. It is quite a bit faster than the single
- * pivot quick_sort below. The other quick_sort below should only be used when
- * you are stuck with simple iterators to a container and you don't have access
- * to the container itself.
- */
+namespace Detail {
+
+// Partitions smaller than this are finished off with an insertion sort.
+static constexpr int introsort_insertion_sort_threshold = 16;
+
+// Everything below only ever swaps elements and compares them in place, so it also works
+// for proxy collections whose operator[] returns a handle to the element (e.g. qsort()).
+
 template<typename Collection, typename LessThan>
-void dual_pivot_quick_sort(Collection& col, int start, int end, LessThan less_than)
+void insertion_sort(Collection& col, int start, int end, LessThan& less_than)
 {
-    if (start >= end) {
-        return;
+    for (int i = start + 1; i <= end; ++i) {
+        for (int j = i; j > start && less_than(col[j], col[j - 1]); --j)
+            swap(col[j], col[j - 1]);
     }
+}
 
-    int left_pointer, right_pointer;
-    if (!less_than(col[start], col[end])) {
-        swap(col[start], col[end]);
+template<typename Collection, typename LessThan>
+void heap_sift_down(Collection& col, int start, int root, int count, LessThan& less_than)
+{
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= count)
+            return;
+        if (child + 1 < count && less_than(col[start + child], col[start + child + 1]))
+            ++child;
+        if (!less_than(col[start + root], col[start + child]))
+            return;
+        swap(col[start + root], col[start + child]);
+        root = child;
     }
+}
 
-    int j = start + 1;
-    int k = start + 1;
-    int g = end - 1;
-
-    auto left_pivot = col[start];
-    auto right_pivot = col[end];
-
-    while (k <= g) {
-        if (less_than(col[k], left_pivot)) {
-            swap(col[k], col[j]);
-            j++;
-        } else if (!less_than(col[k], right_pivot)) {
-            while (!less_than(col[g], right_pivot) && k < g) {
-                g--;
-            }
-            swap(col[k], col[g]);
-            g--;
-            if (less_than(col[k], left_pivot)) {
-                swap(col[k], col[j]);
-                j++;
-            }
+template<typename Collection, typename LessThan>
+void heap_sort(Collection& col, int start, int end, LessThan& less_than)
+{
+    int count = end - start + 1;
+    for (int root = count / 2 - 1; root >= 0; --root)
+        heap_sift_down(col, start, root, count, less_than);
+    for (int last = count - 1; last > 0; --last) {
+        swap(col[start], col[start + last]);
+        heap_sift_down(col, start, 0, last, less_than);
+    }
+}
+
+template<typename Collection, typename LessThan>
+void intro_sort(Collection& col, int start, int end, int depth_limit, LessThan& less_than)
+{
+    while (end - start + 1 > introsort_insertion_sort_threshold) {
+        if (depth_limit-- == 0) {
+            heap_sort(col, start, end, less_than);
+            return;
+        }
+
+        // Order the first, middle and last elements, then use the median as the pivot.
+        // The largest of the three stays at the end, where it stops the upward scan below.
+        int middle = start + (end - start) / 2;
+        if (less_than(col[middle], col[start]))
+            swap(col[middle], col[start]);
+        if (less_than(col[end], col[middle])) {
+            swap(col[end], col[middle]);
+            if (less_than(col[middle], col[start]))
+                swap(col[middle], col[start]);
+        }
+        swap(col[start], col[middle]);
+
+        // Hoare partition around col[start]. Both scans stop on elements equal to the pivot,
+        // which keeps runs of duplicate keys from degrading into quadratic behavior.
+        int i = start;
+        int j = end + 1;
+        for (;;) {
+            do {
+                ++i;
+            } while (less_than(col[i], col[start]));
+            do {
+                --j;
+            } while (less_than(col[start], col[j]));
+            if (i >= j)
+                break;
+            swap(col[i], col[j]);
         }
-        k++;
+        swap(col[start], col[j]);
+
+        // Recurse into the smaller side and loop on the larger one to bound the stack depth.
+        if (j - start < end - j) {
+            intro_sort(col, start, j - 1, depth_limit, less_than);
+            start = j + 1;
+        } else {
+            intro_sort(col, j + 1, end, depth_limit, less_than);
+            end = j - 1;
+        }
+    }
+    insertion_sort(col, start, end, less_than);
+}
+
+template<typename Iterator>
+class IteratorRange {
+public:
+    explicit IteratorRange(Iterator start)
+        : m_start(start)
+    {
     }
-    j--;
-    g++;
 
-    swap(col[start], col[j]);
-    swap(col[end], col[g]);
+    decltype(auto) operator[](int index) { return *(m_start + index); }
+
+private:
+    Iterator m_start;
+};
+
+}
+
+/* This is an introsort: a quick sort with median-of-three pivots that finishes small
+ * partitions with an insertion sort, and falls back to a heap sort when the recursion
+ * gets too deep. That keeps it O(n log n) even on inputs crafted against the pivot choice.
+ * It sorts the inclusive range [start, end] of anything that can be indexed with [].
+ * Like any quick sort, it is not stable.
+ */
+template<typename Collection, typename LessThan>
+void intro_sort(Collection& col, int start, int end, LessThan less_than)
+{
+    if (start >= end)
+        return;
 
-    left_pointer = j;
-    right_pointer = g;
+    int depth_limit = 0;
+    for (int size = end - start + 1; size > 1; size >>= 1)
+        depth_limit += 2;
 
-    dual_pivot_quick_sort(col, start, left_pointer - 1, less_than);
-    dual_pivot_quick_sort(col, left_pointer + 1, right_pointer - 1, less_than);
-    dual_pivot_quick_sort(col, right_pointer + 1, end, less_than);
+    Detail::intro_sort(col, start, end, depth_limit, less_than);
 }
 
 template<typename Iterator, typename LessThan>
@@ -92,23 +167,8 @@ void quick_sort(Iterator start, Iterator end, LessThan less_than)
     if (size <= 1)
         return;
 
-    int pivot_point = size / 2;
-    auto pivot = *(start + pivot_point);
-
-    if (pivot_point)
-        swap(*(start + pivot_point), *start);
-
-    int i = 1;
-    for (int j = 1; j < size; ++j) {
-        if (less_than(*(start + j), pivot)) {
-            swap(*(start + j), *(start + i));
-            ++i;
-        }
-    }
-
-    swap(*start, *(start + i - 1));
-    quick_sort(start, start + i - 1, less_than);
-    quick_sort(start + i, end, less_than);
+    Detail::IteratorRange<Iterator> range(start);
+    intro_sort(range, 0, size - 1, move(less_than));
 }
 
 template<typename Iterator>
@@ -120,16 +180,17 @@ void quick_sort(Iterator start, Iterator end)
 template<typename Collection, typename LessThan>
 void quick_sort(Collection& collection, LessThan less_than)
 {
-    dual_pivot_quick_sort(collection, 0, collection.size() - 1, move(less_than));
+    intro_sort(collection, 0, (int)collection.size() - 1, move(less_than));
 }
 
 template<typename Collection>
 void quick_sort(Collection& collection)
 {
-    dual_pivot_quick_sort(collection, 0, collection.size() - 1,
+    intro_sort(collection, 0, (int)collection.size() - 1,
         [](auto& a, auto& b) { return a < b; });
 }
 
 }
 
+using AK::intro_sort;
 using AK::quick_sort;
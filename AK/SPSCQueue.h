@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Futex.h>
+#include <AK/Optional.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+
+namespace AK {
+
+// A bounded, lock-free ring buffer for handing values from exactly one producer thread
+// to exactly one consumer thread. Neither side ever takes a lock; the consumer can block
+// in dequeue() until something arrives, which costs the producer a futex wake only
+// while the consumer is actually asleep.
+template<typename T, size_t Capacity>
+class SPSCQueue {
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+public:
+    SPSCQueue() { }
+    ~SPSCQueue()
+    {
+        while (try_dequeue().has_value())
+            ;
+    }
+
+    size_t capacity() const { return Capacity; }
+
+    // Only exact when called from the producer or the consumer while the other side is idle.
+    size_t size() const { return m_tail.load(AK::memory_order_acquire) - m_head.load(AK::memory_order_acquire); }
+    bool is_empty() const { return size() == 0; }
+
+    // Producer only. Returns false (and leaves value alone) if the queue is full.
+    bool try_enqueue(T&& value)
+    {
+        u32 tail = m_tail.load(AK::memory_order_relaxed);
+        if (tail - m_head.load(AK::memory_order_acquire) == Capacity)
+            return false;
+        new (&slot(tail)) T(move(value));
+        // This has to be ordered before the load of the flag, hence not just a release store.
+        m_tail.store(tail + 1);
+        if (m_consumer_is_waiting.load())
+            futex_wake(m_tail);
+        return true;
+    }
+
+    bool try_enqueue(const T& value)
+    {
+        T copy(value);
+        return try_enqueue(move(copy));
+    }
+
+    // Consumer only.
+    Optional<T> try_dequeue()
+    {
+        u32 head = m_head.load(AK::memory_order_relaxed);
+        if (head == m_tail.load(AK::memory_order_acquire))
+            return {};
+        T& stored = slot(head);
+        T value = move(stored);
+        stored.~T();
+        m_head.store(head + 1, AK::memory_order_release);
+        return value;
+    }
+
+    // Consumer only. Sleeps until there's a value to return.
+    T dequeue()
+    {
+        for (;;) {
+            if (auto value = try_dequeue(); value.has_value())
+                return value.release_value();
+            // The producer publishes before checking the flag, so either it sees the flag and wakes us,
+            // or the futex sees that m_tail has moved on and doesn't put us to sleep.
+            u32 tail = m_tail.load();
+            m_consumer_is_waiting.store(true);
+            if (tail == m_head.load(AK::memory_order_relaxed))
+                futex_wait(m_tail, tail);
+            m_consumer_is_waiting.store(false);
+        }
+    }
+
+private:
+    T& slot(u32 index) { return reinterpret_cast<T*>(m_storage)[index & (Capacity - 1)]; }
+
+    // The counters only ever increase and wrap around; u32 so that futexes can wait on them.
+    // They live on separate cache lines so the two sides don't keep stealing each other's.
+    alignas(64) Atomic<u32> m_head { 0 };
+    alignas(64) Atomic<u32> m_tail { 0 };
+    Atomic<bool> m_consumer_is_waiting { false };
+    alignas(T) u8 m_storage[sizeof(T) * Capacity];
+};
+
+}
+
+using AK::SPSCQueue;
@@ -25,6 +25,7 @@
  */
 
 #include <AK/FlyString.h>
+#include <AK/MemMem.h>
 #include <AK/Memory.h>
 #include <AK/StdLibExtras.h>
 #include <AK/String.h>
@@ -53,6 +54,9 @@ bool String::operator==(const FlyString& fly_string) const
 
 bool String::operator==(const String& other) const
 {
+    if (m_impl == other.m_impl)
+        return true;
+
     if (!m_impl)
         return !other.m_impl;
 
@@ -298,7 +302,7 @@ bool String::contains(const String& needle) const
 {
     if (is_null() || needle.is_null())
         return false;
-    return strstr(characters(), needle.characters());
+    return memmem(characters(), length(), needle.characters(), needle.length()) != nullptr;
 }
 
 Optional<size_t> String::index_of(const String& needle, size_t start) const
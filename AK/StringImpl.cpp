@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/FlyString.h>
 #include <AK/HashTable.h>
 #include <AK/Memory.h>
@@ -31,6 +32,10 @@
 #include <AK/StringImpl.h>
 #include <AK/kmalloc.h>
 
+#ifdef KERNEL
+#    include <Kernel/Heap/SlabAllocator.h>
+#endif
+
 //#define DEBUG_STRINGIMPL
 
 #ifdef DEBUG_STRINGIMPL
@@ -60,6 +65,133 @@ StringImpl& StringImpl::the_empty_stringimpl()
     return *s_the_empty_stringimpl;
 }
 
+static StringImpl* s_single_character_stringimpls[256];
+
+StringImpl& StringImpl::the_single_character_stringimpl(char ch)
+{
+    auto*& impl = s_single_character_stringimpls[(u8)ch];
+    if (!impl) {
+        void* slot = kmalloc(sizeof(StringImpl) + 2 * sizeof(char));
+        impl = new (slot) StringImpl(ConstructWithInlineBuffer, 1);
+        impl->m_inline_buffer[0] = ch;
+        impl->m_inline_buffer[1] = '\0';
+    }
+    return *impl;
+}
+
+static inline size_t allocation_size_for_stringimpl(size_t length)
+{
+    return sizeof(StringImpl) + (sizeof(char) * length) + sizeof(char);
+}
+
+// Tokenizers and parsers churn through huge numbers of identifiers, keywords and
+// short literals. Rather than a trip through the general-purpose allocator for each,
+// those come out of fixed-size slots carved from larger chunks. Slots are recycled
+// through a free list and never handed back, much like the kernel's slab allocator.
+static constexpr size_t small_stringimpl_slot_size = 32;
+static constexpr size_t medium_stringimpl_slot_size = 64;
+
+#ifndef KERNEL
+template<size_t slot_size>
+class StringImplSlab {
+public:
+    void* allocate()
+    {
+        lock();
+        if (!m_free_slots)
+            grow();
+        auto* slot = m_free_slots;
+        if (slot)
+            m_free_slots = slot->next;
+        unlock();
+        return slot;
+    }
+
+    void deallocate(void* ptr)
+    {
+        auto* slot = static_cast<FreeSlot*>(ptr);
+        lock();
+        slot->next = m_free_slots;
+        m_free_slots = slot;
+        unlock();
+    }
+
+private:
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+    static_assert(slot_size >= sizeof(FreeSlot));
+
+    static constexpr size_t chunk_size = 64 * KiB;
+
+    void grow()
+    {
+        auto* chunk = static_cast<u8*>(kmalloc(chunk_size));
+        if (!chunk)
+            return;
+        for (size_t offset = 0; offset + slot_size <= chunk_size; offset += slot_size) {
+            auto* slot = reinterpret_cast<FreeSlot*>(chunk + offset);
+            slot->next = m_free_slots;
+            m_free_slots = slot;
+        }
+    }
+
+    void lock()
+    {
+        while (atomic_exchange(&m_locked, true, AK::MemoryOrder::memory_order_acquire)) {
+            while (atomic_load(&m_locked, AK::MemoryOrder::memory_order_relaxed)) {
+#    if ARCH(I386) || ARCH(X86_64)
+                __builtin_ia32_pause();
+#    endif
+            }
+        }
+    }
+
+    void unlock() { atomic_store(&m_locked, false, AK::MemoryOrder::memory_order_release); }
+
+    // Plain members, so the slabs are ready before any static constructor makes a string.
+    bool m_locked { false };
+    FreeSlot* m_free_slots { nullptr };
+};
+
+static StringImplSlab<small_stringimpl_slot_size> s_small_stringimpl_slab;
+static StringImplSlab<medium_stringimpl_slot_size> s_medium_stringimpl_slab;
+#endif
+
+static void* allocate_stringimpl(size_t allocation_size)
+{
+#ifdef KERNEL
+    if (allocation_size <= medium_stringimpl_slot_size)
+        return Kernel::slab_alloc(allocation_size);
+#else
+    if (allocation_size <= small_stringimpl_slot_size)
+        return s_small_stringimpl_slab.allocate();
+    if (allocation_size <= medium_stringimpl_slot_size)
+        return s_medium_stringimpl_slab.allocate();
+#endif
+    return kmalloc(allocation_size);
+}
+
+static void deallocate_stringimpl(void* ptr, size_t allocation_size)
+{
+#ifdef KERNEL
+    if (allocation_size <= medium_stringimpl_slot_size) {
+        Kernel::slab_dealloc(ptr, allocation_size);
+        return;
+    }
+#else
+    if (allocation_size <= small_stringimpl_slot_size) {
+        s_small_stringimpl_slab.deallocate(ptr);
+        return;
+    }
+    if (allocation_size <= medium_stringimpl_slot_size) {
+        s_medium_stringimpl_slab.deallocate(ptr);
+        return;
+    }
+#endif
+    kfree(ptr);
+}
+
 StringImpl::StringImpl(ConstructWithInlineBufferTag, size_t length)
     : m_length(length)
 {
@@ -81,15 +213,18 @@ StringImpl::~StringImpl()
 #endif
 }
 
-static inline size_t allocation_size_for_stringimpl(size_t length)
+void StringImpl::destroy() const
 {
-    return sizeof(StringImpl) + (sizeof(char) * length) + sizeof(char);
+    size_t allocation_size = allocation_size_for_stringimpl(m_length);
+    void* slot = const_cast<StringImpl*>(this);
+    this->~StringImpl();
+    deallocate_stringimpl(slot, allocation_size);
 }
 
 NonnullRefPtr<StringImpl> StringImpl::create_uninitialized(size_t length, char*& buffer)
 {
     ASSERT(length);
-    void* slot = kmalloc(allocation_size_for_stringimpl(length));
+    void* slot = allocate_stringimpl(allocation_size_for_stringimpl(length));
     ASSERT(slot);
     auto new_stringimpl = adopt(*new (slot) StringImpl(ConstructWithInlineBuffer, length));
     buffer = const_cast<char*>(new_stringimpl->characters());
@@ -118,6 +253,9 @@ RefPtr<StringImpl> StringImpl::create(const char* cstring, size_t length, Should
     if (!length)
         return the_empty_stringimpl();
 
+    if (length == 1)
+        return the_single_character_stringimpl(cstring[0]);
+
     char* buffer;
     auto new_stringimpl = create_uninitialized(length, buffer);
     memcpy(buffer, cstring, length * sizeof(char));
@@ -171,6 +309,9 @@ NonnullRefPtr<StringImpl> StringImpl::to_lowercase() const
     return const_cast<StringImpl&>(*this);
 
 slow_path:
+    if (m_length == 1)
+        return the_single_character_stringimpl(to_ascii_lowercase(characters()[0]));
+
     char* buffer;
     auto lowercased = create_uninitialized(m_length, buffer);
     for (size_t i = 0; i < m_length; ++i)
@@ -187,6 +328,9 @@ NonnullRefPtr<StringImpl> StringImpl::to_uppercase() const
     return const_cast<StringImpl&>(*this);
 
 slow_path:
+    if (m_length == 1)
+        return the_single_character_stringimpl(to_ascii_uppercase(characters()[0]));
+
     char* buffer;
     auto uppercased = create_uninitialized(m_length, buffer);
     for (size_t i = 0; i < m_length; ++i)
@@ -49,13 +49,20 @@ public:
     NonnullRefPtr<StringImpl> to_lowercase() const;
     NonnullRefPtr<StringImpl> to_uppercase() const;
 
-    void operator delete(void* ptr)
+    // Short strings live in slab slots rather than their own allocation, so they
+    // can't go through operator delete; this hides RefCounted::unref() to free them.
+    void unref() const
     {
-        kfree(ptr);
+        if (deref_base() == 0)
+            destroy();
     }
 
     static StringImpl& the_empty_stringimpl();
 
+    // One-character strings are shared and never freed, so tokenizers splitting
+    // out punctuation don't hit the allocator for every single token.
+    static StringImpl& the_single_character_stringimpl(char);
+
     ~StringImpl();
 
     size_t length() const { return m_length; }
@@ -100,6 +107,7 @@ private:
     };
     StringImpl(ConstructWithInlineBufferTag, size_t length);
 
+    void destroy() const;
     void compute_hash() const;
 
     size_t m_length { 0 };
@@ -55,12 +55,16 @@
 #include <stdio.h>
 
 #include <AK/Function.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
 #include <AK/LogStream.h>
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/QuickSort.h>
 #include <AK/String.h>
 
 #include <LibCore/ArgsParser.h>
 
+#include <math.h>
 #include <sys/time.h>
 
 namespace AK {
@@ -82,12 +86,43 @@ public:
         return delta.tv_sec * 1000 + delta.tv_usec / 1000;
     }
 
+    u64 elapsed_microseconds()
+    {
+        struct timeval now;
+        gettimeofday(&now, nullptr);
+
+        struct timeval delta;
+        timersub(&now, &m_started, &delta);
+
+        return (u64)delta.tv_sec * 1000000 + delta.tv_usec;
+    }
+
 private:
     struct timeval m_started;
 };
 
 using TestFunction = AK::Function<void()>;
 
+// Keeps the compiler from optimizing away a value a benchmark computes but never uses.
+template<typename T>
+inline void taint_for_optimizer(T& value)
+{
+    asm volatile(""
+                 : "+m"(value)
+                 :
+                 : "memory");
+}
+
+struct BenchmarkResult {
+    String name;
+    size_t iterations { 0 };
+    u64 min_us { 0 };
+    u64 max_us { 0 };
+    u64 median_us { 0 };
+    double mean_us { 0 };
+    double stddev_us { 0 };
+};
+
 class TestCase : public RefCounted<TestCase> {
 public:
     TestCase(const String& name, TestFunction&& fn, bool is_benchmark)
@@ -124,6 +159,8 @@ public:
     }
 
     void run(const NonnullRefPtrVector<TestCase>&);
+    BenchmarkResult run_benchmark(const TestCase&);
+    void write_benchmark_results(const char* path) const;
     void main(const String& suite_name, int argc, char** argv);
     NonnullRefPtrVector<TestCase> find_cases(const String& search, bool find_tests, bool find_benchmarks);
     void add_case(const NonnullRefPtr<TestCase>& test_case)
@@ -137,6 +174,9 @@ private:
     u64 m_testtime = 0;
     u64 m_benchtime = 0;
     String m_suite_name;
+    int m_benchmark_warmup = 0;
+    int m_benchmark_iterations = 1;
+    Vector<BenchmarkResult> m_benchmark_results;
 };
 
 void TestSuite::main(const String& suite_name, int argc, char** argv)
@@ -149,13 +189,22 @@ void TestSuite::main(const String& suite_name, int argc, char** argv)
     bool do_benchmarks_only = false;
     bool do_list_cases = false;
     const char* search_string = "*";
+    const char* json_path = nullptr;
 
     args_parser.add_option(do_tests_only, "Only run tests.", "tests", 0);
     args_parser.add_option(do_benchmarks_only, "Only run benchmarks.", "bench", 0);
     args_parser.add_option(do_list_cases, "List avaliable test cases.", "list", 0);
+    args_parser.add_option(m_benchmark_warmup, "Untimed runs of each benchmark before measuring.", "warmup", 0, "count");
+    args_parser.add_option(m_benchmark_iterations, "Timed runs of each benchmark.", "iterations", 0, "count");
+    args_parser.add_option(json_path, "Write benchmark results to a JSON file.", "json", 0, "path");
     args_parser.add_positional_argument(search_string, "Only run matching cases.", "pattern", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
+    if (m_benchmark_warmup < 0)
+        m_benchmark_warmup = 0;
+    if (m_benchmark_iterations < 1)
+        m_benchmark_iterations = 1;
+
     const auto& matching_tests = find_cases(search_string, !do_benchmarks_only, !do_tests_only);
 
     if (do_list_cases) {
@@ -167,6 +216,9 @@ void TestSuite::main(const String& suite_name, int argc, char** argv)
         out() << "Running " << matching_tests.size() << " cases out of " << m_cases.size();
 
         run(matching_tests);
+
+        if (json_path)
+            write_benchmark_results(json_path);
     }
 }
 
@@ -201,25 +253,100 @@ void TestSuite::run(const NonnullRefPtrVector<TestCase>& tests)
 
         dbg() << "START Running " << test_type << " " << t.name();
 
+        if (t.is_benchmark()) {
+            TestElapsedTimer timer;
+            auto result = run_benchmark(t);
+            m_benchtime += timer.elapsed_milliseconds();
+            benchmark_count++;
+
+            if (result.iterations == 1) {
+                warn() << "\033[32;1mPASS\033[0m: " << result.min_us / 1000 << " ms running " << test_type << " " << t.name();
+            } else {
+                warn() << "\033[32;1mPASS\033[0m: " << t.name() << ": " << result.iterations << " iterations, min " << result.min_us << " us, median " << result.median_us
+                       << " us, mean " << (u64)result.mean_us << " us, max " << result.max_us << " us, stddev " << (u64)result.stddev_us << " us";
+            }
+            m_benchmark_results.append(move(result));
+            continue;
+        }
+
         TestElapsedTimer timer;
         t.func()();
         const auto time = timer.elapsed_milliseconds();
 
         warn() << "\033[32;1mPASS\033[0m: " << time << " ms running " << test_type << " " << t.name();
 
-        if (t.is_benchmark()) {
-            m_benchtime += time;
-            benchmark_count++;
-        } else {
-            m_testtime += time;
-            test_count++;
-        }
+        m_testtime += time;
+        test_count++;
     }
 
     dbg() << "Finished " << test_count << " tests and " << benchmark_count << " benchmarks in " << global_timer.elapsed_milliseconds() << " ms ("
           << m_testtime << " tests, " << m_benchtime << " benchmarks, " << (global_timer.elapsed_milliseconds() - (m_testtime + m_benchtime)) << " other)";
 }
 
+BenchmarkResult TestSuite::run_benchmark(const TestCase& benchmark)
+{
+    for (int i = 0; i < m_benchmark_warmup; ++i)
+        benchmark.func()();
+
+    Vector<u64> samples;
+    samples.ensure_capacity(m_benchmark_iterations);
+    for (int i = 0; i < m_benchmark_iterations; ++i) {
+        TestElapsedTimer timer;
+        benchmark.func()();
+        samples.append(timer.elapsed_microseconds());
+    }
+    quick_sort(samples);
+
+    BenchmarkResult result;
+    result.name = benchmark.name();
+    result.iterations = samples.size();
+    result.min_us = samples.first();
+    result.max_us = samples.last();
+    result.median_us = samples.size() % 2 ? samples[samples.size() / 2] : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+
+    double sum = 0;
+    for (auto sample : samples)
+        sum += sample;
+    result.mean_us = sum / samples.size();
+
+    double squared_deviations = 0;
+    for (auto sample : samples)
+        squared_deviations += (sample - result.mean_us) * (sample - result.mean_us);
+    result.stddev_us = samples.size() > 1 ? sqrt(squared_deviations / (samples.size() - 1)) : 0;
+    return result;
+}
+
+void TestSuite::write_benchmark_results(const char* path) const
+{
+    JsonArray benchmarks;
+    for (auto& result : m_benchmark_results) {
+        JsonObject object;
+        object.set("name", result.name);
+        object.set("iterations", result.iterations);
+        object.set("min_us", result.min_us);
+        object.set("max_us", result.max_us);
+        object.set("median_us", result.median_us);
+        object.set("mean_us", result.mean_us);
+        object.set("stddev_us", result.stddev_us);
+        benchmarks.append(move(object));
+    }
+
+    JsonObject root;
+    root.set("suite", m_suite_name);
+    root.set("warmup", m_benchmark_warmup);
+    root.set("benchmarks", move(benchmarks));
+
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        perror("fopen");
+        return;
+    }
+    auto json = root.to_string();
+    fwrite(json.characters(), 1, json.length(), fp);
+    fputc('\n', fp);
+    fclose(fp);
+}
+
 // Use SFINAE to print if we can.
 // This trick is good enough for TestSuite.h, but not flexible enough to be put into LogStream.h.
 template<typename Stream, typename LHS, typename RHS, typename = void>
@@ -251,6 +378,8 @@ static const Stream& force_print_rhs_lhs(const Stream& stream, const LHS& lhs, c
 
 }
 
+using AK::BenchmarkResult;
+using AK::taint_for_optimizer;
 using AK::TestCase;
 using AK::TestSuite;
 
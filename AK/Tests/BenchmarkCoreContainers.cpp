@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/HashMap.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+#include <AK/URL.h>
+#include <AK/Vector.h>
+
+// Baseline benchmarks for the core AK types. Run them with:
+//
+//     BenchmarkCoreContainers --bench --warmup 2 --iterations 20 --json results.json
+//
+// Each case is kept short enough to also run once as part of the regular test suite.
+
+BENCHMARK_CASE(vector_append_ints)
+{
+    Vector<int> ints;
+    for (int i = 0; i < 1000000; ++i)
+        ints.append(i);
+    taint_for_optimizer(ints);
+    EXPECT_EQ(ints.size(), 1000000u);
+}
+
+BENCHMARK_CASE(vector_append_strings)
+{
+    Vector<String> strings;
+    for (int i = 0; i < 100000; ++i)
+        strings.append(String::number(i));
+    taint_for_optimizer(strings);
+    EXPECT_EQ(strings.size(), 100000u);
+}
+
+BENCHMARK_CASE(vector_insert_front)
+{
+    Vector<int> ints;
+    for (int i = 0; i < 10000; ++i)
+        ints.prepend(i);
+    taint_for_optimizer(ints);
+    EXPECT_EQ(ints.first(), 9999);
+}
+
+BENCHMARK_CASE(hashmap_set_and_find_ints)
+{
+    HashMap<int, int> map;
+    for (int i = 0; i < 200000; ++i)
+        map.set(i, i * 2);
+    size_t found = 0;
+    for (int i = 0; i < 400000; ++i)
+        found += map.contains(i);
+    taint_for_optimizer(found);
+    EXPECT_EQ(found, 200000u);
+}
+
+BENCHMARK_CASE(hashmap_set_and_remove_strings)
+{
+    Vector<String> keys;
+    for (int i = 0; i < 50000; ++i)
+        keys.append(String::format("key-%d", i));
+    HashMap<String, int> map;
+    for (size_t i = 0; i < keys.size(); ++i)
+        map.set(keys[i], (int)i);
+    for (auto& key : keys)
+        map.remove(key);
+    EXPECT(map.is_empty());
+}
+
+BENCHMARK_CASE(string_number_and_compare)
+{
+    size_t equal = 0;
+    for (int i = 0; i < 100000; ++i) {
+        auto a = String::number(i);
+        auto b = String::number(i);
+        equal += a == b;
+    }
+    taint_for_optimizer(equal);
+    EXPECT_EQ(equal, 100000u);
+}
+
+BENCHMARK_CASE(string_builder_append)
+{
+    StringBuilder builder;
+    for (int i = 0; i < 200000; ++i) {
+        builder.append("line ");
+        builder.append(String::number(i));
+        builder.append('\n');
+    }
+    auto string = builder.to_string();
+    taint_for_optimizer(string);
+    EXPECT(string.length() > 200000u);
+}
+
+static String make_json_document()
+{
+    JsonArray array;
+    for (int i = 0; i < 5000; ++i) {
+        JsonObject object;
+        object.set("id", i);
+        object.set("name", String::format("item %d", i));
+        object.set("enabled", i % 2 == 0);
+        object.set("score", i * 0.5);
+        array.append(move(object));
+    }
+    return array.to_string();
+}
+
+BENCHMARK_CASE(json_parse)
+{
+    static String document = make_json_document();
+    auto value = JsonValue::from_string(document);
+    EXPECT(value.has_value());
+    EXPECT_EQ(value.value().as_array().size(), 5000);
+}
+
+BENCHMARK_CASE(json_serialize)
+{
+    auto document = make_json_document();
+    taint_for_optimizer(document);
+    EXPECT(!document.is_empty());
+}
+
+BENCHMARK_CASE(url_parse)
+{
+    size_t valid = 0;
+    for (int i = 0; i < 20000; ++i) {
+        URL url(String::format("http://www.example.com:8080/path/to/page%d.html?query=%d#fragment", i, i));
+        valid += url.is_valid();
+    }
+    taint_for_optimizer(valid);
+    EXPECT_EQ(valid, 20000u);
+}
+
+TEST_MAIN(BenchmarkCoreContainers)
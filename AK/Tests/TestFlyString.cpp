@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/FlyString.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+
+TEST_CASE(interning)
+{
+    FlyString a = "interned";
+    FlyString b = String::format("%s", "interned");
+    EXPECT_EQ(a.impl(), b.impl());
+    EXPECT(a.impl()->is_fly());
+
+    FlyString c = "different";
+    EXPECT(a.impl() != c.impl());
+}
+
+TEST_CASE(reintern_after_destroy)
+{
+    auto make = [] {
+        StringBuilder builder;
+        builder.append("transient-");
+        builder.append("name");
+        return builder.to_string();
+    };
+    {
+        FlyString first = make();
+        EXPECT_EQ(first, "transient-name");
+    }
+    FlyString second = make();
+    FlyString third = make();
+    EXPECT_EQ(second.impl(), third.impl());
+    EXPECT_EQ(second, "transient-name");
+}
+
+TEST_CASE(many_strings)
+{
+    Vector<FlyString> names;
+    for (int i = 0; i < 1000; ++i)
+        names.append(String::number(i));
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(FlyString(String::number(i)).impl(), names[i].impl());
+    names.clear();
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(FlyString(String::number(i)), String::number(i));
+}
+
+TEST_MAIN(FlyString)
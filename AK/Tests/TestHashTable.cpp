@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/HashTable.h>
+#include <AK/String.h>
+
+TEST_CASE(construct)
+{
+    typedef HashTable<int> IntTable;
+    EXPECT(IntTable().is_empty());
+    EXPECT_EQ(IntTable().size(), 0u);
+}
+
+TEST_CASE(populate)
+{
+    HashTable<String> strings;
+    strings.set("One");
+    strings.set("Two");
+    strings.set("Three");
+
+    EXPECT_EQ(strings.is_empty(), false);
+    EXPECT_EQ(strings.size(), 3u);
+}
+
+TEST_CASE(range_loop)
+{
+    HashTable<String> strings;
+    EXPECT_EQ(strings.set("One"), AK::HashSetResult::InsertedNewEntry);
+    EXPECT_EQ(strings.set("Two"), AK::HashSetResult::InsertedNewEntry);
+    EXPECT_EQ(strings.set("Three"), AK::HashSetResult::InsertedNewEntry);
+
+    int loop_counter = 0;
+    for (auto& it : strings) {
+        EXPECT_EQ(it.is_null(), false);
+        ++loop_counter;
+    }
+    EXPECT_EQ(loop_counter, 3);
+}
+
+TEST_CASE(table_remove)
+{
+    HashTable<String> strings;
+    EXPECT_EQ(strings.set("One"), AK::HashSetResult::InsertedNewEntry);
+    EXPECT_EQ(strings.set("Two"), AK::HashSetResult::InsertedNewEntry);
+    EXPECT_EQ(strings.set("Three"), AK::HashSetResult::InsertedNewEntry);
+
+    EXPECT(strings.remove("One"));
+    EXPECT_EQ(strings.size(), 2u);
+    EXPECT(strings.find("One") == strings.end());
+
+    EXPECT(strings.remove("Three"));
+    EXPECT_EQ(strings.size(), 1u);
+    EXPECT(strings.find("Three") == strings.end());
+    EXPECT(strings.find("Two") != strings.end());
+}
+
+TEST_CASE(set_existing)
+{
+    HashTable<String> strings;
+    EXPECT_EQ(strings.set("One"), AK::HashSetResult::InsertedNewEntry);
+    EXPECT_EQ(strings.set("One"), AK::HashSetResult::ReplacedExistingEntry);
+    EXPECT_EQ(strings.size(), 1u);
+}
+
+TEST_CASE(many_items)
+{
+    HashTable<int> numbers;
+    for (int i = 0; i < 10000; ++i)
+        numbers.set(i);
+    EXPECT_EQ(numbers.size(), 10000u);
+
+    for (int i = 0; i < 10000; i += 2)
+        EXPECT(numbers.remove(i));
+    EXPECT_EQ(numbers.size(), 5000u);
+
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_EQ(numbers.contains(i), i % 2 == 1);
+
+    size_t loop_counter = 0;
+    for (int number : numbers) {
+        EXPECT_EQ(number % 2, 1);
+        ++loop_counter;
+    }
+    EXPECT_EQ(loop_counter, 5000u);
+}
+
+TEST_CASE(reinsert_after_remove)
+{
+    // Removing and inserting over and over shouldn't leave behind deleted buckets that
+    // fill up the table, or make lookups miss elements behind them.
+    HashTable<int> numbers;
+    for (int i = 0; i < 100; ++i)
+        numbers.set(i);
+    for (int round = 0; round < 1000; ++round) {
+        EXPECT(numbers.remove(round));
+        numbers.set(round + 100);
+    }
+    EXPECT_EQ(numbers.size(), 100u);
+    for (int i = 1000; i < 1100; ++i)
+        EXPECT(numbers.contains(i));
+    EXPECT(numbers.capacity() <= 256u);
+}
+
+struct CollidingTraits : public GenericTraits<int> {
+    static unsigned hash(int) { return 42; }
+};
+
+TEST_CASE(colliding_hashes)
+{
+    HashTable<int, CollidingTraits> numbers;
+    for (int i = 0; i < 100; ++i)
+        numbers.set(i);
+    EXPECT_EQ(numbers.size(), 100u);
+
+    for (int i = 0; i < 100; i += 3)
+        EXPECT(numbers.remove(i));
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(numbers.contains(i), i % 3 != 0);
+}
+
+TEST_CASE(copy_and_move)
+{
+    HashTable<String> strings;
+    strings.set("One");
+    strings.set("Two");
+
+    auto copy = strings;
+    EXPECT_EQ(copy.size(), 2u);
+    EXPECT(copy.contains("One"));
+    EXPECT(copy.contains("Two"));
+
+    auto moved = move(strings);
+    EXPECT_EQ(moved.size(), 2u);
+    EXPECT(moved.contains("One"));
+    EXPECT(strings.is_empty());
+    EXPECT(!strings.contains("One"));
+}
+
+BENCHMARK_CASE(insert_and_find_integers)
+{
+    HashTable<int> numbers;
+    for (int i = 0; i < 1000000; ++i)
+        numbers.set(i);
+    size_t found = 0;
+    for (int i = 0; i < 2000000; ++i)
+        found += numbers.contains(i);
+    EXPECT_EQ(found, 1000000u);
+}
+
+BENCHMARK_CASE(insert_and_remove_strings)
+{
+    Vector<String> strings;
+    for (int i = 0; i < 100000; ++i)
+        strings.append(String::number(i));
+    HashTable<String> table;
+    for (auto& string : strings)
+        table.set(string);
+    for (auto& string : strings)
+        EXPECT(table.remove(string));
+    EXPECT(table.is_empty());
+}
+
+TEST_MAIN(HashTable)
@@ -29,8 +29,11 @@
 #include <AK/HashMap.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
+#include <AK/JsonStreamReader.h>
+#include <AK/JsonStreamWriter.h>
 #include <AK/JsonValue.h>
 #include <AK/String.h>
+#include <AK/Stream.h>
 #include <AK/StringBuilder.h>
 
 TEST_CASE(load_form)
@@ -145,4 +148,116 @@ TEST_CASE(json_duplicate_keys)
     EXPECT_EQ(json.to_string(), "{\"test\":\"baz\"}");
 }
 
+static Vector<JsonStreamReader::Token> tokenize(const StringView& input, bool& had_error)
+{
+    InputMemoryStream stream(input.bytes());
+    JsonStreamReader reader(stream);
+    Vector<JsonStreamReader::Token> tokens;
+    while (reader.next())
+        tokens.append(reader.token());
+    had_error = reader.has_error();
+    return tokens;
+}
+
+TEST_CASE(json_stream_reader)
+{
+    using Token = JsonStreamReader::Token;
+    StringView input = " {\"name\": \"a\\\"b\\u0041\", \"list\": [1, -2.5, true, false, null, {}], \"empty\": []} ";
+    InputMemoryStream stream(input.bytes());
+    JsonStreamReader reader(stream);
+
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::StartObject);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::Key);
+    EXPECT_EQ(reader.text(), "name");
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::String);
+    EXPECT_EQ(reader.text(), "a\"bA");
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::Key);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::StartArray);
+    EXPECT_EQ(reader.depth(), 2u);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::Number);
+    EXPECT_EQ(reader.value().to_u32(), 1u);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::Number);
+    EXPECT_EQ(reader.text(), "-2.5");
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::True);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::False);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::Null);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::StartObject);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::EndObject);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::EndArray);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::Key);
+    EXPECT_EQ(reader.text(), "empty");
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::StartArray);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::EndArray);
+    EXPECT(reader.next());
+    EXPECT(reader.token() == Token::EndObject);
+    EXPECT(!reader.next());
+    EXPECT(!reader.has_error());
+}
+
+TEST_CASE(json_stream_reader_malformed)
+{
+    bool had_error = false;
+    tokenize("[1, 2,]", had_error);
+    EXPECT(had_error);
+    tokenize("{\"a\" 1}", had_error);
+    EXPECT(had_error);
+    tokenize("{\"a\": 1", had_error);
+    EXPECT(had_error);
+    tokenize("[1] 2", had_error);
+    EXPECT(had_error);
+    tokenize("[\"unterminated]", had_error);
+    EXPECT(had_error);
+    auto tokens = tokenize("[[[]]]", had_error);
+    EXPECT(!had_error);
+    EXPECT_EQ(tokens.size(), 6u);
+}
+
+TEST_CASE(json_stream_writer)
+{
+    DuplexMemoryStream stream;
+    JsonStreamWriter writer(stream);
+    writer.begin_object();
+    writer.key("name");
+    writer.value("quote\" and \\ and \n");
+    writer.key("numbers");
+    writer.begin_array();
+    writer.value(0);
+    writer.value((i64)-42);
+    writer.value((u64)0x12345678aabbccddull);
+    writer.raw_value("1.5");
+    writer.end_array();
+    writer.key("flags");
+    writer.begin_array();
+    writer.value(true);
+    writer.null_value();
+    writer.end_array();
+    writer.end_object();
+    EXPECT_EQ(writer.depth(), 0u);
+
+    char buffer[256];
+    auto size = stream.read({ buffer, sizeof(buffer) });
+    StringView output(buffer, size);
+    EXPECT_EQ(output, "{\"name\":\"quote\\\" and \\\\ and \\n\",\"numbers\":[0,-42,1311768467732155613,1.5],\"flags\":[true,null]}");
+
+    auto parsed = JsonValue::from_string(output);
+    EXPECT(parsed.has_value());
+    EXPECT_EQ(parsed.value().as_object().get("name").as_string(), "quote\" and \\ and \n");
+}
+
 TEST_MAIN(JSON)
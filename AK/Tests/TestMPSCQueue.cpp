@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/MPSCQueue.h>
+#include <AK/String.h>
+#include <pthread.h>
+
+TEST_CASE(fill_and_drain)
+{
+    MPSCQueue<String, 4> queue;
+    EXPECT(!queue.try_dequeue().has_value());
+    for (int lap = 0; lap < 3; ++lap) {
+        EXPECT(queue.try_enqueue("one"));
+        EXPECT(queue.try_enqueue("two"));
+        EXPECT(queue.try_enqueue("three"));
+        EXPECT(queue.try_enqueue("four"));
+        EXPECT(!queue.try_enqueue("five"));
+
+        EXPECT_EQ(queue.try_dequeue().value(), "one");
+        EXPECT_EQ(queue.dequeue(), "two");
+        EXPECT(queue.try_enqueue("five"));
+        EXPECT_EQ(queue.dequeue(), "three");
+        EXPECT_EQ(queue.dequeue(), "four");
+        EXPECT_EQ(queue.dequeue(), "five");
+        EXPECT(!queue.try_dequeue().has_value());
+    }
+}
+
+static constexpr int producer_count = 4;
+static constexpr int values_per_producer = 20000;
+
+struct Producer {
+    MPSCQueue<int, 64>* queue;
+    int id;
+};
+
+static void* produce(void* argument)
+{
+    auto& producer = *static_cast<Producer*>(argument);
+    for (int i = 0; i < values_per_producer;) {
+        if (producer.queue->try_enqueue(producer.id * values_per_producer + i))
+            ++i;
+    }
+    return nullptr;
+}
+
+TEST_CASE(many_producers)
+{
+    MPSCQueue<int, 64> queue;
+    pthread_t threads[producer_count];
+    Producer producers[producer_count];
+    for (int i = 0; i < producer_count; ++i) {
+        producers[i] = { &queue, i };
+        pthread_create(&threads[i], nullptr, produce, &producers[i]);
+    }
+
+    // Values from one producer must come out in the order it put them in.
+    int next_expected[producer_count] = {};
+    bool in_order = true;
+    for (int i = 0; i < producer_count * values_per_producer; ++i) {
+        int value = queue.dequeue();
+        int id = value / values_per_producer;
+        if (value % values_per_producer != next_expected[id]++)
+            in_order = false;
+    }
+    for (auto& thread : threads)
+        pthread_join(thread, nullptr);
+
+    EXPECT(in_order);
+    for (int i = 0; i < producer_count; ++i)
+        EXPECT_EQ(next_expected[i], values_per_producer);
+    EXPECT(!queue.try_dequeue().has_value());
+}
+
+TEST_MAIN(MPSCQueue)
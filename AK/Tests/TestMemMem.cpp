@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/AhoCorasick.h>
+#include <AK/MemMem.h>
+#include <AK/Vector.h>
+
+template<typename T>
+static const T* naive_find(const T* haystack, size_t haystack_length, const T* needle, size_t needle_length)
+{
+    if (haystack_length < needle_length)
+        return nullptr;
+    for (size_t i = 0; i <= haystack_length - needle_length; ++i) {
+        size_t j = 0;
+        while (j < needle_length && haystack[i + j] == needle[j])
+            ++j;
+        if (j == needle_length)
+            return haystack + i;
+    }
+    return nullptr;
+}
+
+// A small alphabet, so that there are lots of partial matches.
+static Vector<u8> make_bytes(size_t length, u32 seed, u8 alphabet_size)
+{
+    Vector<u8> bytes;
+    for (size_t i = 0; i < length; ++i) {
+        seed = seed * 1103515245 + 12345;
+        bytes.append('a' + (seed >> 16) % alphabet_size);
+    }
+    return bytes;
+}
+
+TEST_CASE(memmem_empty_and_short_haystacks)
+{
+    const char* haystack = "hello";
+    EXPECT_EQ(AK::memmem(haystack, 5, "", 0), haystack);
+    EXPECT_EQ(AK::memmem(haystack, 0, "", 0), haystack);
+    EXPECT_EQ(AK::memmem(haystack, 4, "hello", 5), nullptr);
+    EXPECT_EQ(AK::memmem(haystack, 5, "hello", 5), haystack);
+    EXPECT_EQ(AK::memmem(haystack, 5, "o", 1), haystack + 4);
+    EXPECT_EQ(AK::memmem(haystack, 5, "lo", 2), haystack + 3);
+    EXPECT_EQ(AK::memmem(haystack, 5, "ol", 2), nullptr);
+}
+
+TEST_CASE(memmem_match_at_the_end)
+{
+    Vector<u8> haystack;
+    for (size_t i = 0; i < 100; ++i)
+        haystack.append('a');
+    for (size_t needle_length = 1; needle_length < 80; ++needle_length) {
+        haystack[haystack.size() - 1] = 'b';
+        Vector<u8> needle;
+        for (size_t i = 0; i < needle_length - 1; ++i)
+            needle.append('a');
+        needle.append('b');
+        EXPECT_EQ(AK::memmem(haystack.data(), haystack.size(), needle.data(), needle.size()), haystack.data() + haystack.size() - needle_length);
+        haystack[haystack.size() - 1] = 'a';
+        EXPECT_EQ(AK::memmem(haystack.data(), haystack.size(), needle.data(), needle.size()), nullptr);
+    }
+}
+
+TEST_CASE(memmem_against_naive_search)
+{
+    for (u8 alphabet_size : { 2, 4, 26 }) {
+        for (size_t needle_length : { 1, 2, 3, 7, 15, 16, 17, 31, 32, 33, 64, 100 }) {
+            for (u32 seed = 0; seed < 20; ++seed) {
+                auto haystack = make_bytes(1000 + seed * 37, seed, alphabet_size);
+                // Take the needle from the haystack half of the time, so that there is a match.
+                auto needle = make_bytes(needle_length, seed + 1000, alphabet_size);
+                if (seed % 2) {
+                    size_t offset = (seed * 101) % (haystack.size() - needle_length);
+                    for (size_t i = 0; i < needle_length; ++i)
+                        needle[i] = haystack[offset + i];
+                }
+                auto* expected = naive_find(haystack.data(), haystack.size(), needle.data(), needle.size());
+                EXPECT_EQ(AK::memmem(haystack.data(), haystack.size(), needle.data(), needle.size()), expected);
+            }
+        }
+    }
+}
+
+TEST_CASE(memmem_periodic_needles)
+{
+    // These are the inputs that send naive searches into quadratic time and test the two-way "memory".
+    for (size_t period : { 1, 2, 3, 5 }) {
+        Vector<u8> haystack;
+        for (size_t i = 0; i < 2000; ++i)
+            haystack.append('a' + i % period);
+        for (size_t needle_length : { 32, 40, 99, 500 }) {
+            Vector<u8> needle;
+            for (size_t i = 0; i < needle_length; ++i)
+                needle.append('a' + i % period);
+            EXPECT_EQ(AK::memmem(haystack.data(), haystack.size(), needle.data(), needle.size()), naive_find(haystack.data(), haystack.size(), needle.data(), needle.size()));
+            needle.last() = 'z';
+            EXPECT_EQ(AK::memmem(haystack.data(), haystack.size(), needle.data(), needle.size()), nullptr);
+        }
+    }
+}
+
+TEST_CASE(find_sequence_of_code_points)
+{
+    for (size_t needle_length : { 1, 5, 31, 32, 50 }) {
+        for (u32 seed = 0; seed < 10; ++seed) {
+            auto bytes = make_bytes(500, seed, 3);
+            Vector<u32> haystack;
+            for (auto byte : bytes)
+                haystack.append(byte % 2 ? byte : 0x1f600 + byte);
+            Vector<u32> needle;
+            size_t offset = (seed * 41) % (haystack.size() - needle_length);
+            for (size_t i = 0; i < needle_length; ++i)
+                needle.append(haystack[offset + i]);
+            if (seed % 3 == 0)
+                needle.last() = 0x1f600;
+            EXPECT_EQ(find_sequence(haystack.data(), haystack.size(), needle.data(), needle.size()), naive_find(haystack.data(), haystack.size(), needle.data(), needle.size()));
+        }
+    }
+}
+
+TEST_CASE(aho_corasick)
+{
+    Vector<StringView> patterns { "he", "she", "his", "hers" };
+    AhoCorasick matcher(patterns);
+
+    auto match = matcher.find("ushers");
+    EXPECT(match.has_value());
+    EXPECT_EQ(match.value().offset, 1u);
+    EXPECT_EQ(match.value().length, 3u);
+    EXPECT_EQ(match.value().pattern_index, 1u);
+
+    match = matcher.find("ahishe");
+    EXPECT(match.has_value());
+    EXPECT_EQ(match.value().offset, 1u);
+    EXPECT_EQ(match.value().pattern_index, 2u);
+
+    EXPECT(!matcher.find("hi sh e").has_value());
+    EXPECT(!matcher.find("").has_value());
+
+    Vector<StringView> with_empty { "abc", "" };
+    EXPECT(AhoCorasick(with_empty).find("xyz").has_value());
+}
+
+TEST_CASE(aho_corasick_against_memmem)
+{
+    auto text = make_bytes(5000, 7, 3);
+    for (u32 seed = 0; seed < 30; ++seed) {
+        Vector<Vector<u8>> pattern_bytes;
+        Vector<StringView> patterns;
+        for (size_t i = 0; i < 1 + seed % 5; ++i)
+            pattern_bytes.append(make_bytes(4 + (seed + i) % 9, seed * 13 + i, 3));
+        for (auto& bytes : pattern_bytes)
+            patterns.append(StringView((const char*)bytes.data(), bytes.size()));
+        AhoCorasick matcher(patterns);
+
+        // The earliest ending match of any pattern.
+        size_t best_end = text.size() + 1;
+        for (auto& pattern : patterns) {
+            auto* position = (const u8*)AK::memmem(text.data(), text.size(), pattern.characters_without_null_termination(), pattern.length());
+            if (position)
+                best_end = min(best_end, (size_t)(position - text.data()) + pattern.length());
+        }
+        auto match = matcher.find(text.span());
+        if (best_end > text.size()) {
+            EXPECT(!match.has_value());
+            continue;
+        }
+        EXPECT(match.has_value());
+        EXPECT_EQ(match.value().offset + match.value().length, best_end);
+    }
+}
+
+TEST_MAIN(MemMem)
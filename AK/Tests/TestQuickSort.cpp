@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/QuickSort.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+template<typename Collection>
+static bool is_sorted(const Collection& collection)
+{
+    for (size_t i = 1; i < collection.size(); ++i) {
+        if (collection[i] < collection[i - 1])
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(sorts_common_patterns)
+{
+    const int size = 1000;
+    for (int pattern = 0; pattern < 5; ++pattern) {
+        Vector<int> ints;
+        for (int i = 0; i < size; ++i) {
+            switch (pattern) {
+            case 0:
+                ints.append(i);
+                break;
+            case 1:
+                ints.append(size - i);
+                break;
+            case 2:
+                ints.append(7);
+                break;
+            case 3:
+                ints.append(i < size / 2 ? i : size - i);
+                break;
+            case 4:
+                ints.append((i * 7919) % 61);
+                break;
+            }
+        }
+        quick_sort(ints);
+        EXPECT_EQ(ints.size(), (size_t)size);
+        EXPECT(is_sorted(ints));
+    }
+}
+
+TEST_CASE(sorts_small_collections)
+{
+    for (int size = 0; size < 40; ++size) {
+        Vector<int> ints;
+        for (int i = 0; i < size; ++i)
+            ints.append((i * 37) % 11);
+        quick_sort(ints);
+        EXPECT(is_sorted(ints));
+    }
+}
+
+TEST_CASE(sorts_with_custom_comparator)
+{
+    Vector<String> strings;
+    for (int i = 0; i < 200; ++i)
+        strings.append(String::number((i * 31) % 200));
+    quick_sort(strings, [](auto& a, auto& b) { return a.length() < b.length() || (a.length() == b.length() && a < b); });
+    for (size_t i = 1; i < strings.size(); ++i)
+        EXPECT(strings[i - 1].length() < strings[i].length() || (strings[i - 1].length() == strings[i].length() && strings[i - 1] < strings[i]));
+    EXPECT_EQ(strings.first(), "0");
+    EXPECT_EQ(strings.last(), "199");
+}
+
+TEST_CASE(sorts_iterator_range)
+{
+    int ints[] = { 9, 3, 7, 1, 8, 2, 6, 4, 5, 0 };
+    quick_sort(ints + 2, ints + 8);
+    EXPECT_EQ(ints[0], 9);
+    EXPECT_EQ(ints[1], 3);
+    for (int i = 3; i < 8; ++i)
+        EXPECT(ints[i - 1] <= ints[i]);
+    EXPECT_EQ(ints[8], 5);
+    EXPECT_EQ(ints[9], 0);
+}
+
+// McIlroy's "killer adversary": it decides the relative order of the elements lazily,
+// always in the way that makes the current pivot candidate as bad as possible.
+// A plain quick sort needs a quadratic number of comparisons against it.
+TEST_CASE(stays_n_log_n_against_adversarial_comparisons)
+{
+    const int size = 4096;
+    const int gas = size;
+    Vector<int> values;
+    Vector<int> items;
+    for (int i = 0; i < size; ++i) {
+        values.append(gas);
+        items.append(i);
+    }
+
+    int solid = 0;
+    int candidate = 0;
+    size_t comparisons = 0;
+    quick_sort(items, [&](int x, int y) {
+        ++comparisons;
+        if (values[x] == gas && values[y] == gas) {
+            if (x == candidate)
+                values[x] = solid++;
+            else
+                values[y] = solid++;
+        }
+        if (values[x] == gas)
+            candidate = x;
+        else if (values[y] == gas)
+            candidate = y;
+        return values[x] < values[y];
+    });
+
+    for (int i = 1; i < size; ++i)
+        EXPECT(values[items[i - 1]] <= values[items[i]]);
+
+    // 4096 * log2(4096) = 49152; a quadratic sort needs millions here.
+    EXPECT(comparisons < 20 * 49152u);
+}
+
+TEST_MAIN(QuickSort)
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/SPSCQueue.h>
+#include <AK/String.h>
+#include <pthread.h>
+
+TEST_CASE(construct)
+{
+    SPSCQueue<int, 4> queue;
+    EXPECT(queue.is_empty());
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_EQ(queue.capacity(), 4u);
+    EXPECT(!queue.try_dequeue().has_value());
+}
+
+TEST_CASE(fill_and_drain)
+{
+    SPSCQueue<String, 4> queue;
+    for (int lap = 0; lap < 3; ++lap) {
+        EXPECT(queue.try_enqueue("one"));
+        EXPECT(queue.try_enqueue("two"));
+        EXPECT(queue.try_enqueue("three"));
+        EXPECT(queue.try_enqueue("four"));
+        EXPECT(!queue.try_enqueue("five"));
+        EXPECT_EQ(queue.size(), 4u);
+
+        EXPECT_EQ(queue.try_dequeue().value(), "one");
+        EXPECT_EQ(queue.try_dequeue().value(), "two");
+        EXPECT_EQ(queue.dequeue(), "three");
+        EXPECT_EQ(queue.dequeue(), "four");
+        EXPECT(!queue.try_dequeue().has_value());
+    }
+}
+
+TEST_CASE(destroys_remaining_values)
+{
+    String string = "hello";
+    {
+        SPSCQueue<String, 8> queue;
+        queue.try_enqueue(string);
+        queue.try_enqueue(string);
+        EXPECT_EQ(string.impl()->ref_count(), 3u);
+    }
+    EXPECT_EQ(string.impl()->ref_count(), 1u);
+}
+
+static constexpr int values_to_send = 50000;
+
+static void* produce(void* argument)
+{
+    auto& queue = *static_cast<SPSCQueue<int, 16>*>(argument);
+    for (int i = 0; i < values_to_send;) {
+        if (queue.try_enqueue(i))
+            ++i;
+    }
+    return nullptr;
+}
+
+TEST_CASE(hand_off_between_threads)
+{
+    SPSCQueue<int, 16> queue;
+    pthread_t producer;
+    pthread_create(&producer, nullptr, produce, &queue);
+
+    bool in_order = true;
+    for (int i = 0; i < values_to_send; ++i) {
+        if (queue.dequeue() != i)
+            in_order = false;
+    }
+    pthread_join(producer, nullptr);
+
+    EXPECT(in_order);
+    EXPECT(queue.is_empty());
+}
+
+TEST_MAIN(SPSCQueue)
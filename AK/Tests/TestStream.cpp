@@ -181,4 +181,22 @@ TEST_CASE(duplex_wild_seeking)
     EXPECT(stream.eof());
 }
 
+TEST_CASE(duplex_large_buffer)
+{
+    DuplexMemoryStream stream;
+
+    FixedArray<u8> input { 10000 };
+    for (size_t idx = 0; idx < input.size(); ++idx)
+        input[idx] = idx % 251;
+
+    // Both of these span multiple chunks at once.
+    stream.write(input.bytes());
+    EXPECT_EQ(stream.remaining(), input.size());
+
+    FixedArray<u8> output { 10000 };
+    EXPECT_EQ(stream.read(output.bytes()), output.size());
+    EXPECT(stream.eof());
+    EXPECT(compare(input.bytes(), output.bytes()));
+}
+
 TEST_MAIN(Stream)
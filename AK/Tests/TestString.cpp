@@ -242,4 +242,36 @@ TEST_CASE(builder_zero_initial_capacity)
     EXPECT_EQ(built.length(), 0u);
 }
 
+TEST_CASE(single_character_strings_are_shared)
+{
+    String a = "x";
+    String b = String("xyz").substring(0, 1);
+    EXPECT_EQ(a.impl(), b.impl());
+    EXPECT_EQ(String("X").to_lowercase().impl(), a.impl());
+    EXPECT_EQ(String("xy").impl() == String("xy").impl(), false);
+    EXPECT(a == b);
+    EXPECT_EQ(a.hash(), b.hash());
+}
+
+TEST_CASE(short_strings_reuse_slots)
+{
+    // Lengths on both sides of the slab size classes, freed in between to exercise reuse.
+    for (size_t round = 0; round < 3; ++round) {
+        Vector<String> strings;
+        for (size_t length = 2; length < 100; ++length) {
+            for (size_t i = 0; i < 100; ++i)
+                strings.append(String::repeated((char)('a' + (i + length) % 26), length));
+        }
+        size_t index = 0;
+        for (size_t length = 2; length < 100; ++length) {
+            for (size_t i = 0; i < 100; ++i) {
+                auto& string = strings[index++];
+                EXPECT_EQ(string.length(), length);
+                EXPECT_EQ(string[length - 1], (char)('a' + (i + length) % 26));
+                EXPECT_EQ(string.characters()[length], '\0');
+            }
+        }
+    }
+}
+
 TEST_MAIN(String)
@@ -27,6 +27,7 @@
 #include "BrowserConsoleClient.h"
 #include "ConsoleWidget.h"
 #include <AK/StringBuilder.h>
+#include <LibCore/File.h>
 #include <LibGUI/BoxLayout.h>
 #include <LibGUI/JSSyntaxHighlighter.h>
 #include <LibGUI/TextBox.h>
@@ -128,4 +129,30 @@ JS::Value BrowserConsoleClient::count_reset()
     return JS::js_undefined();
 }
 
+JS::Value BrowserConsoleClient::profile()
+{
+    auto label = interpreter().argument_count() ? interpreter().argument(0).to_string_without_side_effects() : "default";
+    if (!m_console.profile_start(label))
+        m_console_widget.print_html("A profile is already being recorded");
+    return JS::js_undefined();
+}
+
+JS::Value BrowserConsoleClient::profile_end()
+{
+    auto label = interpreter().argument_count() ? interpreter().argument(0).to_string_without_side_effects() : "default";
+    auto profiler = m_console.profile_stop(label);
+    if (!profiler) {
+        m_console_widget.print_html(String::format("No profile named \"%s\" is being recorded", label.characters()));
+        return JS::js_undefined();
+    }
+    auto path = String::format("/tmp/%s.jsprofile", label.characters());
+    auto file = Core::File::construct(path);
+    if (!file->open(Core::IODevice::WriteOnly) || !file->write(profiler->to_json(label))) {
+        m_console_widget.print_html(String::format("Failed to write profile to %s", path.characters()));
+        return JS::js_undefined();
+    }
+    m_console_widget.print_html(String::format("Profile \"%s\" with %zu samples written to %s", label.characters(), profiler->sample_count(), path.characters()));
+    return JS::js_undefined();
+}
+
 }
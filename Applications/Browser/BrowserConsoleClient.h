@@ -53,6 +53,8 @@ private:
     virtual JS::Value trace() override;
     virtual JS::Value count() override;
     virtual JS::Value count_reset() override;
+    virtual JS::Value profile() override;
+    virtual JS::Value profile_end() override;
 
     ConsoleWidget& m_console_widget;
 };
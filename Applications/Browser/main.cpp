@@ -40,9 +40,13 @@
 #include <LibGUI/TabWidget.h>
 #include <LibGUI/Window.h>
 #include <LibGfx/Bitmap.h>
+#include <LibWeb/Loader/HttpCache.h>
 #include <LibWeb/Loader/ResourceLoader.h>
+#include <LibWeb/OutOfProcessWebView.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
 namespace Browser {
 
@@ -120,8 +124,22 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    // For the HTTP cache, which is shared with the WebContent processes.
+    if (mkdir(Web::HttpCache::directory, 0700) < 0 && errno != EEXIST) {
+        perror("mkdir");
+        return 1;
+    }
+    if (unveil(Web::HttpCache::directory, "rwc") < 0) {
+        perror("unveil");
+        return 1;
+    }
+
     unveil(nullptr, nullptr);
 
+    // Keep a WebContent process ready so that opening a tab doesn't have to wait for one to start.
+    if (Browser::g_multi_process)
+        OutOfProcessWebView::set_prelaunched_process_count(1);
+
     auto m_config = Core::ConfigFile::get_for_app("Browser");
     Browser::g_home_url = m_config->read_entry("Preferences", "Home", "about:blank");
 
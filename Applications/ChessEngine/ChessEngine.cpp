@@ -26,7 +26,11 @@
 
 #include "ChessEngine.h"
 #include "MCTSTree.h"
+#include <AK/Atomic.h>
 #include <LibCore/ElapsedTimer.h>
+#include <LibThread/ThreadPool.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 using namespace Chess::UCI;
 
@@ -53,22 +57,46 @@ void ChessEngine::handle_go(const GoCommand& command)
     // FIXME: Add different ways to terminate search.
     ASSERT(command.movetime.has_value());
 
-    srand(arc4random());
-
     Core::ElapsedTimer elapsed_time;
     elapsed_time.start();
 
-    MCTSTree mcts(m_board);
+    // Root parallelization: every CPU grows a tree of its own from the current position,
+    // and the trees' statistics for the first move are pooled at the end.
+    size_t tree_count = max(1l, sysconf(_SC_NPROCESSORS_ONLN));
+    NonnullOwnPtrVector<MCTSTree> trees;
+    for (size_t i = 0; i < tree_count; ++i) {
+        auto tree = make<MCTSTree>(m_board);
+        // FIXME: optimize simulations enough for use.
+        tree->set_eval_method(MCTSTree::EvalMethod::Heuristic);
+        tree->set_random_seed(((u64)arc4random() << 32) | arc4random());
+        trees.append(move(tree));
+    }
 
-    // FIXME: optimize simulations enough for use.
-    mcts.set_eval_method(MCTSTree::EvalMethod::Heuristic);
+    int movetime = command.movetime.value();
+    Atomic<int> rounds { 0 };
+    auto grow = [&](MCTSTree& tree) {
+        int tree_rounds = 0;
+        while (elapsed_time.elapsed() <= movetime) {
+            tree.do_round();
+            ++tree_rounds;
+        }
+        rounds += tree_rounds;
+    };
 
-    int rounds = 0;
-    while (elapsed_time.elapsed() <= command.movetime.value()) {
-        mcts.do_round();
-        ++rounds;
+    if (tree_count == 1) {
+        grow(trees[0]);
+    } else {
+        Vector<Function<void()>> jobs;
+        for (auto& tree : trees)
+            jobs.append([&grow, &tree] { grow(tree); });
+        LibThread::ThreadPool::the().run(move(jobs));
     }
-    dbg() << "MCTS finished " << rounds << " rounds.";
+
+    auto& mcts = trees[0];
+    for (size_t i = 1; i < trees.size(); ++i)
+        mcts.merge(trees[i]);
+
+    dbg() << "MCTS finished " << rounds.load() << " rounds in " << tree_count << " trees.";
     dbg() << "MCTS evaluation " << mcts.expected_value();
     auto best_move = mcts.best_move();
     dbg() << "MCTS best move " << best_move.to_long_algebraic();
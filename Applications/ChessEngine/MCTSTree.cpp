@@ -26,7 +26,6 @@
 
 #include "MCTSTree.h"
 #include <AK/String.h>
-#include <stdlib.h>
 
 MCTSTree::MCTSTree(const Chess::Board& board, double exploration_parameter, MCTSTree* parent)
     : m_parent(parent)
@@ -91,14 +90,17 @@ int MCTSTree::simulate_game() const
     return clone.game_score();
 }
 
-int MCTSTree::heuristic() const
+int MCTSTree::heuristic(u64& random_state) const
 {
     if (m_board.game_finished())
         return m_board.game_score();
 
     double winchance = max(min(double(m_board.material_imbalance()) / 6, 1.0), -1.0);
 
-    double random = double(rand()) / RAND_MAX;
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    double random = double(random_state >> 11) / double(1ull << 53);
     if (winchance >= random)
         return 1;
     if (winchance <= -random)
@@ -124,11 +126,25 @@ void MCTSTree::do_round()
     if (m_eval_method == EvalMethod::Simulation) {
         result = node.simulate_game();
     } else {
-        result = node.heuristic();
+        result = node.heuristic(m_random_state);
     }
     node.apply_result(result);
 }
 
+void MCTSTree::merge(const MCTSTree& other)
+{
+    m_simulations += other.m_simulations;
+    m_white_points += other.m_white_points;
+
+    // Both trees generated the same moves in the same order, unless one of them never got that far.
+    if (m_children.size() != other.m_children.size())
+        return;
+    for (size_t i = 0; i < m_children.size(); ++i) {
+        m_children[i].m_simulations += other.m_children[i].m_simulations;
+        m_children[i].m_white_points += other.m_children[i].m_white_points;
+    }
+}
+
 Chess::Move MCTSTree::best_move() const
 {
     int score_multiplier = (m_board.turn() == Chess::Colour::White) ? 1 : -1;
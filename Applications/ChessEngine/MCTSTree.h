@@ -43,10 +43,13 @@ public:
     MCTSTree& select_leaf();
     MCTSTree& expand();
     int simulate_game() const;
-    int heuristic() const;
+    int heuristic(u64& random_state) const;
     void apply_result(int game_score);
     void do_round();
 
+    // Adds the results of another tree, grown from the same position, to this one's root and first moves.
+    void merge(const MCTSTree& other);
+
     Chess::Move best_move() const;
     double expected_value() const;
     double uct(Chess::Colour colour) const;
@@ -55,6 +58,9 @@ public:
     EvalMethod eval_method() const { return m_eval_method; }
     void set_eval_method(EvalMethod method) { m_eval_method = method; }
 
+    // Each tree draws from its own generator, so trees can be grown on separate threads.
+    void set_random_seed(u64 seed) { m_random_state = seed ? seed : 1; }
+
 private:
     NonnullOwnPtrVector<MCTSTree> m_children;
     MCTSTree* m_parent { nullptr };
@@ -63,5 +69,6 @@ private:
     bool m_moves_generated { false };
     double m_exploration_parameter;
     EvalMethod m_eval_method { EvalMethod::Simulation };
+    u64 m_random_state { 1 };
     Chess::Board m_board;
 };
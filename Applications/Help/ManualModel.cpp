@@ -29,8 +29,13 @@
 #include "ManualPageNode.h"
 #include "ManualSectionNode.h"
 #include <AK/ByteBuffer.h>
+#include <AK/StringBuilder.h>
 #include <LibCore/File.h>
 #include <LibGUI/FilteringProxyModel.h>
+#include <LibMarkdown/Document.h>
+#include <LibMarkdown/Parser.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 static ManualSectionNode s_sections[] = {
     { "1", "Command-line programs" },
@@ -79,23 +84,61 @@ String ManualModel::page_path(const GUI::ModelIndex& index) const
     return page->path();
 }
 
-Result<StringView, int> ManualModel::page_view(const String& path) const
+Result<ManualModel::CachedPage*, int> ManualModel::cached_page(const String& path) const
 {
-    if (path.is_empty())
-        return StringView {};
+    struct stat st;
+    if (stat(path.characters(), &st) < 0)
+        return errno;
 
-    auto mapped_file = m_mapped_files.get(path);
-    if (mapped_file.has_value())
-        return StringView { (const char*)mapped_file.value()->data(), mapped_file.value()->size() };
+    auto it = m_pages.find(path);
+    if (it != m_pages.end() && (*it).value.mtime == st.st_mtime)
+        return &(*it).value;
 
     auto map = make<MappedFile>(path);
     if (!map->is_valid())
         return map->errno_if_invalid();
 
-    StringView view { (const char*)map->data(), map->size() };
-    m_mapped_files.set(path, move(map));
+    CachedPage page;
+    page.mtime = st.st_mtime;
+    page.mapped_file = move(map);
+    m_pages.set(path, move(page));
+    return &(*m_pages.find(path)).value;
+}
+
+Result<StringView, int> ManualModel::page_view(const String& path) const
+{
+    if (path.is_empty())
+        return StringView {};
+
+    auto page_or_error = cached_page(path);
+    if (page_or_error.is_error())
+        return page_or_error.error();
+    auto& mapped_file = *page_or_error.value()->mapped_file;
+    return StringView { (const char*)mapped_file.data(), mapped_file.size() };
+}
 
-    return view;
+Result<String, int> ManualModel::page_html(const String& path) const
+{
+    auto page_or_error = cached_page(path);
+    if (page_or_error.is_error())
+        return page_or_error.error();
+    auto& page = *page_or_error.value();
+    if (!page.html.is_null())
+        return page.html;
+
+    // Render each block as soon as it's parsed, rather than building up the whole document first.
+    StringBuilder builder;
+    builder.append(Markdown::Document::html_prologue());
+    Markdown::Parser parser;
+    parser.on_block = [&](auto block) {
+        builder.append(block->render_to_html());
+    };
+    auto& mapped_file = *page.mapped_file;
+    if (!parser.write({ (const char*)mapped_file.data(), mapped_file.size() }) || !parser.finish())
+        return EINVAL;
+    builder.append(Markdown::Document::html_epilogue());
+    page.html = builder.build();
+    return page.html;
 }
 
 String ManualModel::page_and_section(const GUI::ModelIndex& index) const
@@ -46,6 +46,8 @@ public:
     String page_path(const GUI::ModelIndex&) const;
     String page_and_section(const GUI::ModelIndex&) const;
     Result<StringView, int> page_view(const String& path) const;
+    // The page rendered to HTML. This is cached until the file is modified, so going back and forth between pages is cheap.
+    Result<String, int> page_html(const String& path) const;
 
     void update_section_node_on_toggle(const GUI::ModelIndex&, const bool);
     virtual int row_count(const GUI::ModelIndex& = GUI::ModelIndex()) const override;
@@ -62,5 +64,13 @@ private:
     GUI::Icon m_section_open_icon;
     GUI::Icon m_section_icon;
     GUI::Icon m_page_icon;
-    mutable HashMap<String, OwnPtr<MappedFile>> m_mapped_files;
+    struct CachedPage {
+        time_t mtime { 0 };
+        OwnPtr<MappedFile> mapped_file;
+        String html;
+    };
+    // Maps the page, or maps it again if it has changed since we last did.
+    Result<CachedPage*, int> cached_page(const String& path) const;
+
+    mutable HashMap<String, CachedPage> m_pages;
 };
@@ -46,7 +46,6 @@
 #include <LibGUI/ToolBarContainer.h>
 #include <LibGUI/TreeView.h>
 #include <LibGUI/Window.h>
-#include <LibMarkdown/Document.h>
 #include <LibWeb/Layout/LayoutNode.h>
 #include <LibWeb/InProcessWebView.h>
 #include <libgen.h>
@@ -168,21 +167,13 @@ int main(int argc, char* argv[])
             return;
         }
 
-        auto source_result = model->page_view(path);
-        if (source_result.is_error()) {
-            GUI::MessageBox::show(window, strerror(source_result.error()), "Failed to open man page", GUI::MessageBox::Type::Error);
+        auto html_result = model->page_html(path);
+        if (html_result.is_error()) {
+            GUI::MessageBox::show(window, strerror(html_result.error()), "Failed to open man page", GUI::MessageBox::Type::Error);
             return;
         }
 
-        auto source = source_result.value();
-        String html;
-        {
-            auto md_document = Markdown::Document::parse(source);
-            ASSERT(md_document);
-            html = md_document->render_to_html();
-        }
-
-        page_view.load_html(html, URL::create_with_file_protocol(path));
+        page_view.load_html(html_result.value(), URL::create_with_file_protocol(path));
 
         String page_and_section = model->page_and_section(tree_view.selection().first());
         window->set_title(String::format("%s - Help", page_and_section.characters()));
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HexDocument.h"
+#include <AK/LogStream.h>
+#include <AK/MemMem.h>
+#include <AK/Vector.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Reading in windows lets the kernel fault in only what's on screen. Jumping around a big
+// file is the common case, so don't read ahead.
+static constexpr size_t file_window_size = 1 * MiB;
+static constexpr size_t stream_chunk_size = 64 * KiB;
+
+HexDocument::HexDocument(size_t size)
+    : m_size(size)
+{
+}
+
+HexDocument::~HexDocument()
+{
+}
+
+OwnPtr<HexDocument> HexDocument::create_from_file(const String& path)
+{
+    auto document = adopt_own(*new HexDocument(0));
+    if (!document->open_file(path))
+        return nullptr;
+    return document;
+}
+
+NonnullOwnPtr<HexDocument> HexDocument::create_zeroed(size_t size)
+{
+    return adopt_own(*new HexDocument(size));
+}
+
+bool HexDocument::open_file(const String& path)
+{
+    auto file = make<MappedFileWindow>(path, file_window_size, MappedFileWindow::AccessPattern::Random);
+    if (!file->is_valid()) {
+        errno = file->errno_if_invalid();
+        return false;
+    }
+    m_size = file->file_size();
+    m_path = path;
+    m_file = move(file);
+    m_edited_pages.clear();
+    return true;
+}
+
+size_t HexDocument::read_original(size_t position, Bytes bytes)
+{
+    size_t length = min(bytes.size(), m_size - position);
+    if (!m_file) {
+        memset(bytes.data(), 0, length);
+        return length;
+    }
+
+    size_t copied = 0;
+    while (copied < length) {
+        auto window = m_file->window_at(position + copied, min(length - copied, file_window_size));
+        if (window.is_empty()) {
+            // The file shrank (or can't be mapped anymore) under us; show the rest as zeroes.
+            memset(bytes.offset(copied), 0, length - copied);
+            break;
+        }
+        size_t chunk = min(window.size(), length - copied);
+        memcpy(bytes.offset(copied), window.data(), chunk);
+        copied += chunk;
+    }
+    return length;
+}
+
+u8 HexDocument::get(size_t position)
+{
+    ASSERT(position < m_size);
+    auto it = m_edited_pages.find(position / page_size);
+    if (it != m_edited_pages.end())
+        return it->value->data[position % page_size];
+
+    u8 value;
+    read_original(position, { &value, 1 });
+    return value;
+}
+
+HexDocument::Page& HexDocument::ensure_page(size_t index)
+{
+    auto it = m_edited_pages.find(index);
+    if (it != m_edited_pages.end())
+        return *it->value;
+
+    auto page = make<Page>();
+    read_original(index * page_size, { page->data, page_size });
+    auto& page_ref = *page;
+    m_edited_pages.set(index, move(page));
+    return page_ref;
+}
+
+void HexDocument::set(size_t position, u8 value)
+{
+    ASSERT(position < m_size);
+    auto& page = ensure_page(position / page_size);
+    size_t offset_in_page = position % page_size;
+    page.data[offset_in_page] = value;
+    page.changed[offset_in_page / 8] |= 1 << (offset_in_page % 8);
+}
+
+bool HexDocument::is_changed(size_t position) const
+{
+    auto it = m_edited_pages.find(position / page_size);
+    if (it == m_edited_pages.end())
+        return false;
+    size_t offset_in_page = position % page_size;
+    return it->value->changed[offset_in_page / 8] & (1 << (offset_in_page % 8));
+}
+
+size_t HexDocument::read(size_t position, Bytes bytes)
+{
+    if (position >= m_size)
+        return 0;
+
+    size_t length = read_original(position, bytes);
+
+    // Patch in the edited pages that overlap the range.
+    size_t first_page = position / page_size;
+    size_t last_page = (position + length - 1) / page_size;
+    if (m_edited_pages.size() < last_page - first_page + 1) {
+        for (auto& it : m_edited_pages) {
+            if (it.key < first_page || it.key > last_page)
+                continue;
+            size_t page_start = it.key * page_size;
+            size_t start = max(page_start, position);
+            size_t end = min(page_start + page_size, position + length);
+            memcpy(bytes.offset(start - position), it.value->data + (start - page_start), end - start);
+        }
+    } else {
+        for (size_t index = first_page; index <= last_page; ++index) {
+            auto it = m_edited_pages.find(index);
+            if (it == m_edited_pages.end())
+                continue;
+            size_t page_start = index * page_size;
+            size_t start = max(page_start, position);
+            size_t end = min(page_start + page_size, position + length);
+            memcpy(bytes.offset(start - position), it->value->data + (start - page_start), end - start);
+        }
+    }
+    return length;
+}
+
+Optional<size_t> HexDocument::find(ReadonlyBytes needle, size_t start)
+{
+    if (needle.is_empty() || needle.size() > stream_chunk_size || start >= m_size)
+        return {};
+
+    // Consecutive chunks overlap by one byte less than the needle, so a match can't fall between them.
+    auto chunk = ByteBuffer::create_uninitialized(stream_chunk_size);
+    for (size_t position = start; position + needle.size() <= m_size;) {
+        size_t length = read(position, chunk.bytes());
+        auto* match = (const u8*)AK::memmem(chunk.data(), length, needle.data(), needle.size());
+        if (match)
+            return position + (match - chunk.data());
+        if (position + length >= m_size)
+            break;
+        position += length - needle.size() + 1;
+    }
+    return {};
+}
+
+bool HexDocument::write_to_file(const String& path)
+{
+    if (m_file && path == m_path) {
+        int fd = open_with_path_length(path.characters(), path.length(), O_WRONLY, 0);
+        if (fd < 0) {
+            perror("open");
+            return false;
+        }
+        for (auto& it : m_edited_pages) {
+            size_t page_start = it.key * page_size;
+            size_t length = min(page_size, m_size - page_start);
+            ssize_t nwritten = pwrite(fd, it.value->data, length, page_start);
+            if (nwritten < 0 || static_cast<size_t>(nwritten) != length) {
+                perror("pwrite");
+                close(fd);
+                return false;
+            }
+        }
+        close(fd);
+        // The written pages now match the file, so there's nothing left to keep around.
+        return open_file(path);
+    }
+
+    int fd = open_with_path_length(path.characters(), path.length(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        perror("open");
+        return false;
+    }
+
+    auto chunk = ByteBuffer::create_uninitialized(stream_chunk_size);
+    for (size_t position = 0; position < m_size;) {
+        size_t length = read(position, chunk.bytes());
+        ssize_t nwritten = write(fd, chunk.data(), length);
+        if (nwritten < 0 || static_cast<size_t>(nwritten) != length) {
+            perror("write");
+            close(fd);
+            return false;
+        }
+        position += length;
+    }
+    close(fd);
+    return open_file(path);
+}
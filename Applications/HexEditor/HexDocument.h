@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/MappedFile.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Span.h>
+#include <AK/String.h>
+
+// The bytes being edited. A file-backed document reads the file through a mapped window as it's
+// looked at, and keeps edits in copies of the pages they touch, so only those pages have to be
+// in memory (and written back). A new document reads as zeroes until it's saved.
+class HexDocument {
+    AK_MAKE_NONCOPYABLE(HexDocument);
+    AK_MAKE_NONMOVABLE(HexDocument);
+
+public:
+    static constexpr size_t page_size = 4096;
+
+    // Returns null (with errno set) if the file can't be opened.
+    static OwnPtr<HexDocument> create_from_file(const String& path);
+    static NonnullOwnPtr<HexDocument> create_zeroed(size_t size);
+
+    ~HexDocument();
+
+    size_t size() const { return m_size; }
+    bool is_empty() const { return !m_size; }
+
+    u8 get(size_t position);
+    void set(size_t position, u8 value);
+    bool is_changed(size_t position) const;
+
+    // Copies up to bytes.size() bytes starting at position, edits included. Returns how many were copied.
+    size_t read(size_t position, Bytes bytes);
+
+    // Looks for the needle from start on, a chunk at a time.
+    Optional<size_t> find(ReadonlyBytes needle, size_t start);
+
+    // Saving over the file the document came from only writes the edited pages; anywhere else
+    // gets a full copy. Either way, the document is backed by the written file afterwards.
+    bool write_to_file(const String& path);
+
+private:
+    explicit HexDocument(size_t size);
+
+    struct Page {
+        u8 data[page_size];
+        u8 changed[page_size / 8] {};
+    };
+
+    bool open_file(const String& path);
+    size_t read_original(size_t position, Bytes bytes);
+    Page& ensure_page(size_t index);
+
+    size_t m_size { 0 };
+    String m_path;
+    OwnPtr<MappedFileWindow> m_file;
+    HashMap<size_t, NonnullOwnPtr<Page>> m_edited_pages;
+};
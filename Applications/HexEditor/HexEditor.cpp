@@ -60,11 +60,12 @@ void HexEditor::set_readonly(bool readonly)
     m_readonly = readonly;
 }
 
-void HexEditor::set_buffer(const ByteBuffer& buffer)
+void HexEditor::set_document(NonnullOwnPtr<HexDocument> document)
 {
-    m_buffer = buffer;
-    set_content_length(buffer.size());
-    m_tracked_changes.clear();
+    m_document = move(document);
+    set_content_length(m_document->size());
+    m_selection_start = -1;
+    m_selection_end = -1;
     m_position = 0;
     m_byte_position = 0;
     update();
@@ -76,10 +77,8 @@ void HexEditor::fill_selection(u8 fill_byte)
     if (!has_selection())
         return;
 
-    for (int i = m_selection_start; i <= m_selection_end; i++) {
-        m_tracked_changes.set(i, m_buffer.data()[i]);
-        m_buffer.data()[i] = fill_byte;
-    }
+    for (int i = m_selection_start; i <= m_selection_end; i++)
+        m_document->set(i, fill_byte);
 
     update();
     did_change();
@@ -87,7 +86,7 @@ void HexEditor::fill_selection(u8 fill_byte)
 
 void HexEditor::set_position(int position)
 {
-    if (position > static_cast<int>(m_buffer.size()))
+    if (position > document_size())
         return;
 
     m_position = position;
@@ -96,36 +95,33 @@ void HexEditor::set_position(int position)
     update_status();
 }
 
-bool HexEditor::write_to_file(const StringView& path)
+bool HexEditor::write_to_file(const String& path)
 {
-    if (m_buffer.is_empty())
+    if (!m_document || m_document->is_empty())
         return true;
 
-    int fd = open_with_path_length(path.characters_without_null_termination(), path.length(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
-    if (fd < 0) {
-        perror("open");
+    if (!m_document->write_to_file(path))
         return false;
-    }
 
-    int rc = ftruncate(fd, m_buffer.size());
-    if (rc < 0) {
-        perror("ftruncate");
-        return false;
-    }
+    update();
+    return true;
+}
 
-    ssize_t nwritten = write(fd, m_buffer.data(), m_buffer.size());
-    if (nwritten < 0) {
-        perror("write");
-        close(fd);
+bool HexEditor::find_and_select(ReadonlyBytes needle)
+{
+    if (!m_document || needle.is_empty())
         return false;
-    }
 
-    if (static_cast<size_t>(nwritten) == m_buffer.size()) {
-        m_tracked_changes.clear();
-        update();
-    }
+    auto match = m_document->find(needle, m_position + 1);
+    if (!match.has_value())
+        match = m_document->find(needle, 0);
+    if (!match.has_value())
+        return false;
 
-    close(fd);
+    m_selection_start = match.value();
+    m_selection_end = match.value() + needle.size() - 1;
+    set_position(match.value());
+    update();
     return true;
 }
 
@@ -136,7 +132,7 @@ bool HexEditor::copy_selected_hex_to_clipboard()
 
     StringBuilder output_string_builder;
     for (int i = m_selection_start; i <= m_selection_end; i++) {
-        output_string_builder.appendf("%02X ", m_buffer.data()[i]);
+        output_string_builder.appendf("%02X ", m_document->get(i));
     }
 
     GUI::Clipboard::the().set_data(output_string_builder.to_string());
@@ -150,7 +146,8 @@ bool HexEditor::copy_selected_text_to_clipboard()
 
     StringBuilder output_string_builder;
     for (int i = m_selection_start; i <= m_selection_end; i++) {
-        output_string_builder.appendf("%c", isprint(m_buffer.data()[i]) ? m_buffer[i] : '.');
+        u8 byte = m_document->get(i);
+        output_string_builder.appendf("%c", isprint(byte) ? byte : '.');
     }
 
     GUI::Clipboard::the().set_data(output_string_builder.to_string());
@@ -166,7 +163,7 @@ bool HexEditor::copy_selected_hex_to_clipboard_as_c_code()
     output_string_builder.appendf("unsigned char raw_data[%d] = {\n", (m_selection_end - m_selection_start) + 1);
     output_string_builder.append("    ");
     for (int i = m_selection_start, j = 1; i <= m_selection_end; i++, j++) {
-        output_string_builder.appendf("0x%02X", m_buffer.data()[i]);
+        output_string_builder.appendf("0x%02X", m_document->get(i));
         if (i != m_selection_end)
             output_string_builder.append(", ");
         if ((j % 12) == 0) {
@@ -219,7 +216,7 @@ void HexEditor::mousedown_event(GUI::MouseEvent& event)
         auto byte_y = (absolute_y - hex_start_y) / line_height();
         auto offset = (byte_y * m_bytes_per_row) + byte_x;
 
-        if (offset < 0 || offset > static_cast<int>(m_buffer.size()))
+        if (offset < 0 || offset > document_size())
             return;
 
 #ifdef HEX_DEBUG
@@ -241,7 +238,7 @@ void HexEditor::mousedown_event(GUI::MouseEvent& event)
         auto byte_y = (absolute_y - text_start_y) / line_height();
         auto offset = (byte_y * m_bytes_per_row) + byte_x;
 
-        if (offset < 0 || offset > static_cast<int>(m_buffer.size()))
+        if (offset < 0 || offset > document_size())
             return;
 
 #ifdef HEX_DEBUG
@@ -288,7 +285,7 @@ void HexEditor::mousemove_event(GUI::MouseEvent& event)
             auto byte_y = (absolute_y - hex_start_y) / line_height();
             auto offset = (byte_y * m_bytes_per_row) + byte_x;
 
-            if (offset < 0 || offset > static_cast<int>(m_buffer.size()))
+            if (offset < 0 || offset > document_size())
                 return;
 
             m_selection_end = offset;
@@ -299,7 +296,7 @@ void HexEditor::mousemove_event(GUI::MouseEvent& event)
             auto byte_x = (absolute_x - text_start_x) / character_width();
             auto byte_y = (absolute_y - text_start_y) / line_height();
             auto offset = (byte_y * m_bytes_per_row) + byte_x;
-            if (offset < 0 || offset > static_cast<int>(m_buffer.size()))
+            if (offset < 0 || offset > document_size())
                 return;
 
             m_selection_end = offset;
@@ -362,7 +359,7 @@ void HexEditor::keydown_event(GUI::KeyEvent& event)
     }
 
     if (event.key() == KeyCode::Key_Down) {
-        if (m_position + bytes_per_row() < static_cast<int>(m_buffer.size())) {
+        if (m_position + bytes_per_row() < document_size()) {
             m_position += bytes_per_row();
             m_byte_position = 0;
             scroll_position_into_view(m_position);
@@ -384,7 +381,7 @@ void HexEditor::keydown_event(GUI::KeyEvent& event)
     }
 
     if (event.key() == KeyCode::Key_Right) {
-        if (m_position + 1 < static_cast<int>(m_buffer.size())) {
+        if (m_position + 1 < document_size()) {
             m_position++;
             m_byte_position = 0;
             scroll_position_into_view(m_position);
@@ -417,23 +414,23 @@ void HexEditor::keydown_event(GUI::KeyEvent& event)
 void HexEditor::hex_mode_keydown_event(GUI::KeyEvent& event)
 {
     if ((event.key() >= KeyCode::Key_0 && event.key() <= KeyCode::Key_9) || (event.key() >= KeyCode::Key_A && event.key() <= KeyCode::Key_F)) {
-        if (m_buffer.is_empty())
+        if (document_size() == 0)
             return;
         ASSERT(m_position >= 0);
-        ASSERT(m_position < static_cast<int>(m_buffer.size()));
+        ASSERT(m_position < document_size());
 
         // yes, this is terrible... but it works.
         auto value = (event.key() >= KeyCode::Key_0 && event.key() <= KeyCode::Key_9)
             ? event.key() - KeyCode::Key_0
             : (event.key() - KeyCode::Key_A) + 0xA;
 
+        u8 byte = m_document->get(m_position);
         if (m_byte_position == 0) {
-            m_tracked_changes.set(m_position, m_buffer.data()[m_position]);
-            m_buffer.data()[m_position] = value << 4 | (m_buffer.data()[m_position] & 0xF); // shift new value left 4 bits, OR with existing last 4 bits
+            m_document->set(m_position, value << 4 | (byte & 0xF)); // shift new value left 4 bits, OR with existing last 4 bits
             m_byte_position++;
         } else {
-            m_buffer.data()[m_position] = (m_buffer.data()[m_position] & 0xF0) | value; // save the first 4 bits, OR the new value in the last 4
-            if (m_position + 1 < static_cast<int>(m_buffer.size()))
+            m_document->set(m_position, (byte & 0xF0) | value); // save the first 4 bits, OR the new value in the last 4
+            if (m_position + 1 < document_size())
                 m_position++;
             m_byte_position = 0;
         }
@@ -446,14 +443,13 @@ void HexEditor::hex_mode_keydown_event(GUI::KeyEvent& event)
 
 void HexEditor::text_mode_keydown_event(GUI::KeyEvent& event)
 {
-    if (m_buffer.is_empty())
+    if (document_size() == 0)
         return;
     ASSERT(m_position >= 0);
-    ASSERT(m_position < static_cast<int>(m_buffer.size()));
+    ASSERT(m_position < document_size());
 
-    m_tracked_changes.set(m_position, m_buffer.data()[m_position]);
-    m_buffer.data()[m_position] = (u8)event.text().characters()[0]; // save the first 4 bits, OR the new value in the last 4
-    if (m_position + 1 < static_cast<int>(m_buffer.size()))
+    m_document->set(m_position, (u8)event.text().characters()[0]);
+    if (m_position + 1 < document_size())
         m_position++;
     m_byte_position = 0;
 
@@ -483,7 +479,7 @@ void HexEditor::paint_event(GUI::PaintEvent& event)
     painter.add_clip_rect(event.rect());
     painter.fill_rect(event.rect(), palette().color(background_role()));
 
-    if (m_buffer.is_empty())
+    if (document_size() == 0)
         return;
 
     painter.translate(frame_thickness(), frame_thickness());
@@ -526,14 +522,20 @@ void HexEditor::paint_event(GUI::PaintEvent& event)
             is_current_line ? palette().ruler_active_text() : palette().ruler_inactive_text());
     }
 
+    // Fetch the visible rows in one go, rather than a byte at a time.
+    auto visible_bytes = ByteBuffer::create_uninitialized((max_row - min_row) * bytes_per_row());
+    size_t visible_length = m_document->read(min_row * bytes_per_row(), visible_bytes.bytes());
+
     for (int i = min_row; i < max_row; i++) {
         for (int j = 0; j < bytes_per_row(); j++) {
             auto byte_position = (i * bytes_per_row()) + j;
-            if (byte_position >= static_cast<int>(m_buffer.size()))
+            size_t visible_index = byte_position - min_row * bytes_per_row();
+            if (byte_position >= document_size() || visible_index >= visible_length)
                 return;
+            u8 byte = visible_bytes[visible_index];
 
             Color text_color = palette().color(foreground_role());
-            if (m_tracked_changes.contains(byte_position)) {
+            if (m_document->is_changed(byte_position)) {
                 text_color = Color::Red;
             }
 
@@ -561,7 +563,7 @@ void HexEditor::paint_event(GUI::PaintEvent& event)
                 text_color = palette().inactive_selection_text();
             }
 
-            auto line = String::format("%02X", m_buffer[byte_position]);
+            auto line = String::format("%02X", byte);
             painter.draw_text(hex_display_rect, line, Gfx::TextAlignment::TopLeft, text_color);
 
             Gfx::IntRect text_display_rect {
@@ -577,7 +579,7 @@ void HexEditor::paint_event(GUI::PaintEvent& event)
                 painter.fill_rect(text_display_rect, palette().inactive_selection());
             }
 
-            painter.draw_text(text_display_rect, String::format("%c", isprint(m_buffer[byte_position]) ? m_buffer[byte_position] : '.'), Gfx::TextAlignment::TopLeft, text_color);
+            painter.draw_text(text_display_rect, String::format("%c", isprint(byte) ? byte : '.'), Gfx::TextAlignment::TopLeft, text_color);
         }
     }
 }
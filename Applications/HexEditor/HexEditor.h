@@ -26,7 +26,7 @@
 
 #pragma once
 
-#include <AK/ByteBuffer.h>
+#include "HexDocument.h"
 #include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/NonnullOwnPtrVector.h>
@@ -49,11 +49,14 @@ public:
     bool is_readonly() const { return m_readonly; }
     void set_readonly(bool);
 
-    void set_buffer(const ByteBuffer&);
+    void set_document(NonnullOwnPtr<HexDocument>);
     void fill_selection(u8 fill_byte);
-    bool write_to_file(const StringView& path);
+    bool write_to_file(const String& path);
 
-    bool has_selection() const { return !(m_selection_start == -1 || m_selection_end == -1 || (m_selection_end - m_selection_start) < 0 || m_buffer.is_empty()); }
+    // Selects the next match after the current position, wrapping around to the start.
+    bool find_and_select(ReadonlyBytes needle);
+
+    bool has_selection() const { return !(m_selection_start == -1 || m_selection_end == -1 || (m_selection_end - m_selection_start) < 0 || document_size() == 0); }
     bool copy_selected_text_to_clipboard();
     bool copy_selected_hex_to_clipboard();
     bool copy_selected_hex_to_clipboard_as_c_code();
@@ -82,17 +85,18 @@ private:
     int m_line_spacing { 4 };
     int m_content_length { 0 };
     int m_bytes_per_row { 16 };
-    ByteBuffer m_buffer;
+    OwnPtr<HexDocument> m_document;
     bool m_in_drag_select { false };
     int m_selection_start { -1 };
     int m_selection_end { -1 };
-    HashMap<int, u8> m_tracked_changes;
     int m_position { 0 };
     int m_byte_position { 0 }; // 0 or 1
     EditMode m_edit_mode { Hex };
 
     void scroll_position_into_view(int position);
 
+    int document_size() const { return m_document ? m_document->size() : 0; }
+
     int total_rows() const { return ceil_div(m_content_length, m_bytes_per_row); }
     int line_height() const { return font().glyph_height() + m_line_spacing; }
     int character_width() const { return font().glyph_width('W'); }
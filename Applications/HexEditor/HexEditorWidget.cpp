@@ -27,7 +27,6 @@
 #include "HexEditorWidget.h"
 #include <AK/Optional.h>
 #include <AK/StringBuilder.h>
-#include <LibCore/File.h>
 #include <LibGUI/AboutDialog.h>
 #include <LibGUI/Action.h>
 #include <LibGUI/BoxLayout.h>
@@ -82,7 +81,7 @@ HexEditorWidget::HexEditorWidget()
             auto file_size = value.to_int();
             if (file_size.has_value() && file_size.value() > 0) {
                 m_document_dirty = false;
-                m_editor->set_buffer(ByteBuffer::create_zeroed(file_size.value()));
+                m_editor->set_document(HexDocument::create_zeroed(file_size.value()));
                 set_path(LexicalPath());
                 update_title();
             } else {
@@ -167,6 +166,13 @@ HexEditorWidget::HexEditorWidget()
             m_editor->fill_selection(fill_byte);
         }
     }));
+    edit_menu.add_action(GUI::Action::create("Find...", { Mod_Ctrl, Key_F }, Gfx::Bitmap::load_from_file("/res/icons/16x16/find.png"), [&](const GUI::Action&) {
+        String value;
+        if (GUI::InputBox::show(value, window(), "Find text:", "Find") == GUI::InputBox::ExecOK && !value.is_empty()) {
+            if (!m_editor->find_and_select(value.bytes()))
+                GUI::MessageBox::show(window(), String::format("\"%s\" wasn't found.", value.characters()), "Not found", GUI::MessageBox::Type::Information);
+        }
+    }));
     edit_menu.add_separator();
     edit_menu.add_action(*m_goto_decimal_offset_action);
     edit_menu.add_action(*m_goto_hex_offset_action);
@@ -225,14 +231,14 @@ void HexEditorWidget::update_title()
 
 void HexEditorWidget::open_file(const String& path)
 {
-    auto file = Core::File::construct(path);
-    if (!file->open(Core::IODevice::ReadOnly)) {
+    auto document = HexDocument::create_from_file(path);
+    if (!document) {
         GUI::MessageBox::show(window(), String::format("Opening \"%s\" failed: %s", path.characters(), strerror(errno)), "Error", GUI::MessageBox::Type::Error);
         return;
     }
 
     m_document_dirty = false;
-    m_editor->set_buffer(file->read_all()); // FIXME: On really huge files, this is never going to work. Should really create a framework to fetch data from the file on-demand.
+    m_editor->set_document(document.release_nonnull());
     set_path(LexicalPath(path));
 }
 
@@ -72,9 +72,10 @@ void EllipseTool::on_mouseup(Layer& layer, GUI::MouseEvent& event, GUI::MouseEve
 {
     if (event.button() == m_drawing_button) {
         GUI::Painter painter(layer.bitmap());
-        draw_using(painter, Gfx::IntRect::from_two_points(m_ellipse_start_position, m_ellipse_end_position));
+        auto ellipse_intersecting_rect = Gfx::IntRect::from_two_points(m_ellipse_start_position, m_ellipse_end_position);
+        draw_using(painter, ellipse_intersecting_rect);
         m_drawing_button = GUI::MouseButton::None;
-        m_editor->update();
+        layer.did_modify_bitmap(*m_editor->image(), ellipse_intersecting_rect.inflated(m_thickness * 2, m_thickness * 2));
     }
 }
 
@@ -27,6 +27,7 @@
 #include "Image.h"
 #include "Layer.h"
 #include <LibGUI/Painter.h>
+#include <LibGfx/Bitmap.h>
 
 //#define PAINT_DEBUG
 
@@ -46,20 +47,60 @@ RefPtr<Image> Image::create_with_size(const Gfx::IntSize& size)
 Image::Image(const Gfx::IntSize& size)
     : m_size(size)
 {
+    m_tile_columns = (size.width() + tile_size - 1) / tile_size;
+    int tile_rows = (size.height() + tile_size - 1) / tile_size;
+    m_dirty_tiles.resize(m_tile_columns * tile_rows);
+    for (auto& is_dirty : m_dirty_tiles)
+        is_dirty = true;
 }
 
 void Image::paint_into(GUI::Painter& painter, const Gfx::IntRect& dest_rect)
 {
-    float scale = (float)dest_rect.width() / (float)rect().width();
-    Gfx::PainterStateSaver saver(painter);
-    painter.add_clip_rect(dest_rect);
-    for (auto& layer : m_layers) {
-        if (!layer.is_visible())
+    composite_dirty_tiles();
+    if (m_composited_bitmap)
+        painter.draw_scaled_bitmap(dest_rect, *m_composited_bitmap, rect());
+}
+
+void Image::invalidate(const Gfx::IntRect& image_rect)
+{
+    auto dirty_rect = image_rect.intersected(rect());
+    if (dirty_rect.is_empty())
+        return;
+    for (int row = dirty_rect.top() / tile_size; row <= dirty_rect.bottom() / tile_size; ++row) {
+        for (int column = dirty_rect.left() / tile_size; column <= dirty_rect.right() / tile_size; ++column)
+            m_dirty_tiles[row * m_tile_columns + column] = true;
+    }
+    m_has_dirty_tiles = true;
+}
+
+void Image::composite_dirty_tiles()
+{
+    if (!m_has_dirty_tiles)
+        return;
+    if (!m_composited_bitmap) {
+        m_composited_bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, m_size);
+        if (!m_composited_bitmap)
+            return;
+    }
+
+    Gfx::Painter painter(*m_composited_bitmap);
+    for (size_t i = 0; i < m_dirty_tiles.size(); ++i) {
+        if (!m_dirty_tiles[i])
             continue;
-        auto target = dest_rect.translated(layer.location().x() * scale, layer.location().y() * scale);
-        target.set_size(layer.size().width() * scale, layer.size().height() * scale);
-        painter.draw_scaled_bitmap(target, layer.bitmap(), layer.rect(), (float)layer.opacity_percent() / 100.0f);
+        Gfx::IntRect tile_rect { (int)(i % m_tile_columns) * tile_size, (int)(i / m_tile_columns) * tile_size, tile_size, tile_size };
+        tile_rect.intersect(rect());
+        painter.clear_rect(tile_rect, Color::Transparent);
+        for (auto& layer : m_layers) {
+            if (!layer.is_visible())
+                continue;
+            auto area = tile_rect.intersected(layer.relative_rect());
+            if (area.is_empty())
+                continue;
+            painter.blit(area.location(), layer.bitmap(), area.translated(-layer.location().x(), -layer.location().y()), (float)layer.opacity_percent() / 100.0f);
+        }
+        m_dirty_tiles[i] = false;
     }
+    m_has_dirty_tiles = false;
 }
 
 void Image::add_layer(NonnullRefPtr<Layer> layer)
@@ -67,6 +108,7 @@ void Image::add_layer(NonnullRefPtr<Layer> layer)
     for (auto& existing_layer : m_layers) {
         ASSERT(&existing_layer != layer.ptr());
     }
+    invalidate(layer->relative_rect());
     m_layers.append(move(layer));
 
     for (auto* client : m_clients)
@@ -140,7 +182,8 @@ void Image::did_modify_layer_stack()
     for (auto* client : m_clients)
         client->image_did_modify_layer_stack();
 
-    did_change();
+    invalidate(rect());
+    did_change(rect());
 }
 
 void Image::remove_layer(Layer& layer)
@@ -167,13 +210,15 @@ void Image::remove_client(ImageClient& client)
     m_clients.remove(&client);
 }
 
-void Image::layer_did_modify_bitmap(Badge<Layer>, const Layer& layer)
+void Image::layer_did_modify_bitmap(Badge<Layer>, const Layer& layer, const Gfx::IntRect& layer_rect)
 {
     auto layer_index = index_of(layer);
     for (auto* client : m_clients)
         client->image_did_modify_layer(layer_index);
 
-    did_change();
+    auto image_rect = layer_rect.intersected(layer.rect()).translated(layer.location());
+    invalidate(image_rect);
+    did_change(image_rect);
 }
 
 void Image::layer_did_modify_properties(Badge<Layer>, const Layer& layer)
@@ -182,13 +227,30 @@ void Image::layer_did_modify_properties(Badge<Layer>, const Layer& layer)
     for (auto* client : m_clients)
         client->image_did_modify_layer(layer_index);
 
-    did_change();
+    invalidate(layer.relative_rect());
+    did_change(layer.relative_rect());
+}
+
+void Image::layer_did_move(Badge<Layer>, const Layer& layer, const Gfx::IntRect& old_relative_rect)
+{
+    // Layers may be moved around before they're added to the image.
+    bool is_in_image = false;
+    for (auto& existing_layer : m_layers) {
+        if (&existing_layer == &layer)
+            is_in_image = true;
+    }
+    if (!is_in_image)
+        return;
+
+    invalidate(old_relative_rect);
+    invalidate(layer.relative_rect());
+    did_change(old_relative_rect.united(layer.relative_rect()));
 }
 
-void Image::did_change()
+void Image::did_change(const Gfx::IntRect& image_rect)
 {
     for (auto* client : m_clients)
-        client->image_did_change();
+        client->image_did_change(image_rect);
 }
 
 }
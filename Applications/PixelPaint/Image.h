@@ -46,7 +46,8 @@ public:
     virtual void image_did_remove_layer(size_t) { }
     virtual void image_did_modify_layer(size_t) { }
     virtual void image_did_modify_layer_stack() {}
-    virtual void image_did_change() { }
+    // The rect is the part of the image that may look different now.
+    virtual void image_did_change(const Gfx::IntRect&) { }
 };
 
 class Image : public RefCounted<Image> {
@@ -62,6 +63,7 @@ public:
 
     void add_layer(NonnullRefPtr<Layer>);
 
+    // Only the parts of dest_rect inside the painter's clip rect are painted.
     void paint_into(GUI::Painter&, const Gfx::IntRect& dest_rect);
 
     void move_layer_to_front(Layer&);
@@ -74,20 +76,32 @@ public:
     void add_client(ImageClient&);
     void remove_client(ImageClient&);
 
-    void layer_did_modify_bitmap(Badge<Layer>, const Layer&);
+    void layer_did_modify_bitmap(Badge<Layer>, const Layer&, const Gfx::IntRect& layer_rect);
     void layer_did_modify_properties(Badge<Layer>, const Layer&);
+    void layer_did_move(Badge<Layer>, const Layer&, const Gfx::IntRect& old_relative_rect);
 
     size_t index_of(const Layer&) const;
 
 private:
     explicit Image(const Gfx::IntSize&);
 
-    void did_change();
+    void did_change(const Gfx::IntRect&);
     void did_modify_layer_stack();
 
+    void invalidate(const Gfx::IntRect&);
+    void composite_dirty_tiles();
+
     Gfx::IntSize m_size;
     NonnullRefPtrVector<Layer> m_layers;
 
+    // All the visible layers blended together, so painting doesn't have to go through every layer.
+    // It's kept up to date in tiles, only recompositing those that have changed since the last paint.
+    static constexpr int tile_size = 64;
+    RefPtr<Gfx::Bitmap> m_composited_bitmap;
+    int m_tile_columns { 0 };
+    Vector<bool> m_dirty_tiles;
+    bool m_has_dirty_tiles { true };
+
     HashTable<ImageClient*> m_clients;
 };
 
@@ -365,9 +365,9 @@ void ImageEditor::relayout()
     update();
 }
 
-void ImageEditor::image_did_change()
+void ImageEditor::image_did_change(const Gfx::IntRect& image_rect)
 {
-    update();
+    update(enclosing_int_rect(image_rect_to_editor_rect(image_rect)).inflated(2, 2));
 }
 
 }
@@ -48,9 +48,18 @@ Layer::Layer(Image& image, const Gfx::IntSize& size, const String& name)
     m_bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, size);
 }
 
-void Layer::did_modify_bitmap(Image& image)
+void Layer::did_modify_bitmap(Image& image, const Gfx::IntRect& rect)
 {
-    image.layer_did_modify_bitmap({}, *this);
+    image.layer_did_modify_bitmap({}, *this, rect.is_empty() ? this->rect() : rect);
+}
+
+void Layer::set_location(const Gfx::IntPoint& location)
+{
+    if (m_location == location)
+        return;
+    auto old_relative_rect = relative_rect();
+    m_location = location;
+    m_image.layer_did_move({}, *this, old_relative_rect);
 }
 
 void Layer::set_visible(bool visible)
@@ -49,7 +49,7 @@ public:
     ~Layer() { }
 
     const Gfx::IntPoint& location() const { return m_location; }
-    void set_location(const Gfx::IntPoint& location) { m_location = location; }
+    void set_location(const Gfx::IntPoint&);
 
     const Gfx::Bitmap& bitmap() const { return *m_bitmap; }
     Gfx::Bitmap& bitmap() { return *m_bitmap; }
@@ -63,7 +63,8 @@ public:
 
     void set_bitmap(Gfx::Bitmap& bitmap) { m_bitmap = bitmap; }
 
-    void did_modify_bitmap(Image&);
+    // The rect is the part of the layer that was painted on, in layer coordinates. By default, that's all of it.
+    void did_modify_bitmap(Image&, const Gfx::IntRect& = {});
 
     void set_selected(bool selected) { m_selected = selected; }
     bool is_selected() const { return m_selected; }
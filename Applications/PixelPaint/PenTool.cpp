@@ -48,7 +48,7 @@ void PenTool::on_mousedown(Layer& layer, GUI::MouseEvent& event, GUI::MouseEvent
 
     GUI::Painter painter(layer.bitmap());
     painter.draw_line(event.position(), event.position(), m_editor->color_for(event), m_thickness);
-    layer.did_modify_bitmap(*m_editor->image());
+    layer.did_modify_bitmap(*m_editor->image(), Gfx::IntRect(event.position(), {}).inflated(m_thickness * 2, m_thickness * 2));
     m_last_drawing_event_position = event.position();
 }
 
@@ -64,11 +64,9 @@ void PenTool::on_mousemove(Layer& layer, GUI::MouseEvent& event, GUI::MouseEvent
         return;
     GUI::Painter painter(layer.bitmap());
 
-    if (m_last_drawing_event_position != Gfx::IntPoint(-1, -1))
-        painter.draw_line(m_last_drawing_event_position, event.position(), m_editor->color_for(event), m_thickness);
-    else
-        painter.draw_line(event.position(), event.position(), m_editor->color_for(event), m_thickness);
-    layer.did_modify_bitmap(*m_editor->image());
+    auto start_position = m_last_drawing_event_position != Gfx::IntPoint(-1, -1) ? m_last_drawing_event_position : event.position();
+    painter.draw_line(start_position, event.position(), m_editor->color_for(event), m_thickness);
+    layer.did_modify_bitmap(*m_editor->image(), Gfx::IntRect::from_two_points(start_position, event.position()).inflated(m_thickness * 2, m_thickness * 2));
 
     m_last_drawing_event_position = event.position();
 }
@@ -65,7 +65,6 @@ void SprayTool::paint_it()
     auto& bitmap = layer->bitmap();
     GUI::Painter painter(bitmap);
     ASSERT(bitmap.bpp() == 32);
-    m_editor->update();
     const double minimal_radius = 10;
     const double base_radius = minimal_radius * m_thickness;
     for (int i = 0; i < 100 + (nrand() * 800); i++) {
@@ -80,7 +79,8 @@ void SprayTool::paint_it()
         bitmap.set_pixel<Gfx::BitmapFormat::RGB32>(xpos, ypos, m_color);
     }
 
-    layer->did_modify_bitmap(*m_editor->image());
+    int radius = ceil(base_radius);
+    layer->did_modify_bitmap(*m_editor->image(), Gfx::IntRect(m_last_pos, {}).inflated(radius * 2 + 2, radius * 2 + 2));
 }
 
 void SprayTool::on_mousedown(Layer&, GUI::MouseEvent& event, GUI::MouseEvent&)
@@ -73,6 +73,8 @@ int main(int argc, char** argv)
     window->set_title("PixelPaint");
     window->resize(950, 570);
     window->set_icon(app_icon.bitmap_for_size(16));
+    // Brush strokes need every point the cursor went through, not just where it ended up.
+    window->set_wants_mouse_move_history(true);
 
     auto& horizontal_container = window->set_main_widget<GUI::Widget>();
     horizontal_container.set_layout<GUI::HorizontalBoxLayout>();
@@ -207,51 +209,65 @@ int main(int argc, char** argv)
     edge_detect_submenu.add_action(GUI::Action::create("Laplacian (cardinal)", [&](auto&) {
         if (auto* layer = image_editor.active_layer()) {
             PixelPaint::LaplacianFilter filter;
-            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect(), false))
+            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect(), false)) {
                 filter.apply(*parameters);
+                layer->did_modify_bitmap(*image_editor.image());
+            }
         }
     }));
     edge_detect_submenu.add_action(GUI::Action::create("Laplacian (diagonal)", [&](auto&) {
         if (auto* layer = image_editor.active_layer()) {
             PixelPaint::LaplacianFilter filter;
-            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect(), true))
+            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect(), true)) {
                 filter.apply(*parameters);
+                layer->did_modify_bitmap(*image_editor.image());
+            }
         }
     }));
     auto& blur_submenu = spatial_filters_menu.add_submenu("Blur and Sharpen");
     blur_submenu.add_action(GUI::Action::create("Gaussian Blur (3x3)", [&](auto&) {
         if (auto* layer = image_editor.active_layer()) {
             PixelPaint::SpatialGaussianBlurFilter<3> filter;
-            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect()))
+            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect())) {
                 filter.apply(*parameters);
+                layer->did_modify_bitmap(*image_editor.image());
+            }
         }
     }));
     blur_submenu.add_action(GUI::Action::create("Gaussian Blur (5x5)", [&](auto&) {
         if (auto* layer = image_editor.active_layer()) {
             PixelPaint::SpatialGaussianBlurFilter<5> filter;
-            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect()))
+            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect())) {
                 filter.apply(*parameters);
+                layer->did_modify_bitmap(*image_editor.image());
+            }
         }
     }));
     blur_submenu.add_action(GUI::Action::create("Box Blur (3x3)", [&](auto&) {
         if (auto* layer = image_editor.active_layer()) {
             PixelPaint::BoxBlurFilter<3> filter;
-            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect()))
+            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect())) {
                 filter.apply(*parameters);
+                layer->did_modify_bitmap(*image_editor.image());
+            }
         }
     }));
     blur_submenu.add_action(GUI::Action::create("Box Blur (5x5)", [&](auto&) {
         if (auto* layer = image_editor.active_layer()) {
             PixelPaint::BoxBlurFilter<5> filter;
-            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect()))
+            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect())) {
                 filter.apply(*parameters);
+                layer->did_modify_bitmap(*image_editor.image());
+            }
         }
     }));
     blur_submenu.add_action(GUI::Action::create("Sharpen", [&](auto&) {
         if (auto* layer = image_editor.active_layer()) {
             PixelPaint::SharpenFilter filter;
-            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect()))
+            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect())) {
                 filter.apply(*parameters);
+                layer->did_modify_bitmap(*image_editor.image());
+            }
         }
     }));
 
@@ -259,8 +275,10 @@ int main(int argc, char** argv)
     spatial_filters_menu.add_action(GUI::Action::create("Generic 5x5 Convolution", [&](auto&) {
         if (auto* layer = image_editor.active_layer()) {
             PixelPaint::GenericConvolutionFilter<5> filter;
-            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect(), window))
+            if (auto parameters = filter.get_parameters(layer->bitmap(), layer->rect(), window)) {
                 filter.apply(*parameters);
+                layer->did_modify_bitmap(*image_editor.image());
+            }
         }
     }));
 
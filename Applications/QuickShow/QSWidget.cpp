@@ -46,6 +46,7 @@ QSWidget::~QSWidget()
 void QSWidget::clear()
 {
     m_bitmap = nullptr;
+    m_scaled_bitmap = nullptr;
     m_path = {};
 
     set_scale(100);
@@ -55,6 +56,7 @@ void QSWidget::clear()
 void QSWidget::flip(Gfx::Orientation orientation)
 {
     m_bitmap = m_bitmap->flipped(orientation);
+    m_scaled_bitmap = nullptr;
     set_scale(m_scale);
 
     resize_window();
@@ -63,6 +65,7 @@ void QSWidget::flip(Gfx::Orientation orientation)
 void QSWidget::rotate(Gfx::RotationDirection rotation_direction)
 {
     m_bitmap = m_bitmap->rotated(rotation_direction);
+    m_scaled_bitmap = nullptr;
     set_scale(m_scale);
 
     resize_window();
@@ -188,8 +191,20 @@ void QSWidget::paint_event(GUI::PaintEvent& event)
 
     painter.fill_rect_with_checkerboard(frame_inner_rect(), { 8, 8 }, palette().base().darkened(0.9), palette().base());
 
-    if (!m_bitmap.is_null())
-        painter.draw_scaled_bitmap(m_bitmap_rect, *m_bitmap, m_bitmap->rect());
+    if (m_bitmap.is_null())
+        return;
+
+    // Shrinking looks at every pixel of the image, so keep the result around until the scale changes.
+    if (m_bitmap_rect.width() < m_bitmap->width() && m_bitmap_rect.height() < m_bitmap->height()) {
+        if (!m_scaled_bitmap || m_scaled_bitmap->size() != m_bitmap_rect.size())
+            m_scaled_bitmap = m_bitmap->scaled(m_bitmap_rect.size(), Gfx::ScalingMode::BilinearBlend);
+        if (m_scaled_bitmap) {
+            painter.blit(m_bitmap_rect.location(), *m_scaled_bitmap, m_scaled_bitmap->rect());
+            return;
+        }
+    }
+
+    painter.draw_scaled_bitmap(m_bitmap_rect, *m_bitmap, m_bitmap->rect(), 1.0f, Gfx::ScalingMode::BilinearBlend);
 }
 
 void QSWidget::mousedown_event(GUI::MouseEvent& event)
@@ -255,6 +270,7 @@ void QSWidget::load_from_file(const String& path)
 
     m_path = path;
     m_bitmap = bitmap;
+    m_scaled_bitmap = nullptr;
     m_scale = -1;
     set_scale(100);
 }
@@ -77,6 +77,7 @@ private:
 
     String m_path;
     RefPtr<Gfx::Bitmap> m_bitmap;
+    RefPtr<Gfx::Bitmap> m_scaled_bitmap;
     int m_toolbar_height { 28 };
 
     Gfx::IntRect m_bitmap_rect;
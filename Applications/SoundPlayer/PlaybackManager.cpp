@@ -106,6 +106,9 @@ void PlaybackManager::remove_dead_buffers()
         current_id = m_current_buffer->shbuf_id();
 
     if (id >= 0 && id != current_id) {
+        // Everything before the buffer that's playing now has been played, so the loader can fill it again.
+        if (m_current_buffer)
+            m_loader->recycle_buffer(m_current_buffer.release_nonnull());
         while (!m_buffers.is_empty()) {
             --m_next_ptr;
             auto buffer = m_buffers.take_first();
@@ -114,18 +117,19 @@ void PlaybackManager::remove_dead_buffers()
                 m_current_buffer = buffer;
                 break;
             }
+            m_loader->recycle_buffer(buffer.release_nonnull());
         }
     }
 }
 
 void PlaybackManager::load_next_buffer()
 {
-    if (m_buffers.size() < 10) {
-        for (int i = 0; i < 20 && m_loader->loaded_samples() < m_loader->total_samples(); i++) {
-            auto buffer = m_loader->get_more_samples(PLAYBACK_MANAGER_BUFFER_SIZE);
-            if (buffer)
-                m_buffers.append(buffer);
-        }
+    // Only stay a few blocks ahead, so memory use doesn't depend on the length of the file.
+    while (m_buffers.size() < PLAYBACK_MANAGER_BUFFER_COUNT && m_loader->loaded_samples() < m_loader->total_samples()) {
+        auto buffer = m_loader->get_more_samples(PLAYBACK_MANAGER_BUFFER_SIZE);
+        if (!buffer)
+            break;
+        m_buffers.append(buffer);
     }
 
     if (m_next_ptr < m_buffers.size()) {
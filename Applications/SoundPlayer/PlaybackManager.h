@@ -32,6 +32,7 @@
 #include <LibCore/Timer.h>
 
 #define PLAYBACK_MANAGER_BUFFER_SIZE 64 * KiB
+#define PLAYBACK_MANAGER_BUFFER_COUNT 8
 #define PLAYBACK_MANAGER_RATE 44100
 
 class PlaybackManager final {
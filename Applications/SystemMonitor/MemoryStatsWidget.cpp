@@ -26,7 +26,7 @@
 
 #include "MemoryStatsWidget.h"
 #include "GraphWidget.h"
-#include <AK/JsonObject.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <LibCore/File.h>
 #include <LibGUI/BoxLayout.h>
 #include <LibGUI/Label.h>
@@ -95,25 +95,30 @@ static inline size_t bytes_to_kb(size_t bytes)
 
 void MemoryStatsWidget::refresh()
 {
-    auto proc_memstat = Core::File::construct("/proc/memstat");
-    if (!proc_memstat->open(Core::IODevice::OpenMode::ReadOnly))
-        ASSERT_NOT_REACHED();
-
-    auto file_contents = proc_memstat->read_all();
-    auto json_result = JsonValue::from_string(file_contents);
-    ASSERT(json_result.has_value());
-    auto json = json_result.value().as_object();
-
-    unsigned kmalloc_eternal_allocated = json.get("kmalloc_eternal_allocated").to_u32();
-    (void)kmalloc_eternal_allocated;
-    unsigned kmalloc_allocated = json.get("kmalloc_allocated").to_u32();
-    unsigned kmalloc_available = json.get("kmalloc_available").to_u32();
-    unsigned user_physical_allocated = json.get("user_physical_allocated").to_u32();
-    unsigned user_physical_available = json.get("user_physical_available").to_u32();
-    unsigned super_physical_alloc = json.get("super_physical_allocated").to_u32();
-    unsigned super_physical_free = json.get("super_physical_available").to_u32();
-    unsigned kmalloc_call_count = json.get("kmalloc_call_count").to_u32();
-    unsigned kfree_call_count = json.get("kfree_call_count").to_u32();
+    if (!m_proc_memstat) {
+        m_proc_memstat = Core::File::construct("/proc/memstat.bin");
+        if (!m_proc_memstat->open(Core::IODevice::OpenMode::ReadOnly))
+            ASSERT_NOT_REACHED();
+    } else {
+        m_proc_memstat->seek(0);
+    }
+
+    auto file_contents = m_proc_memstat->read_all();
+    ASSERT(file_contents.size() >= sizeof(MemoryStatsFileHeader));
+    auto& file_header = *reinterpret_cast<const MemoryStatsFileHeader*>(file_contents.data());
+    ASSERT(file_header.header.magic == PROC_STATS_MAGIC && file_header.header.version == PROC_STATS_VERSION);
+    ASSERT(file_header.memory_record_size >= sizeof(MemoryStatsRecord));
+    ASSERT(file_contents.size() >= file_header.header.header_size + sizeof(MemoryStatsRecord));
+    auto& stats = *reinterpret_cast<const MemoryStatsRecord*>(file_contents.data() + file_header.header.header_size);
+
+    unsigned kmalloc_allocated = stats.kmalloc_allocated;
+    unsigned kmalloc_available = stats.kmalloc_available;
+    unsigned user_physical_allocated = stats.user_physical_allocated;
+    unsigned user_physical_available = stats.user_physical_available;
+    unsigned super_physical_alloc = stats.super_physical_allocated;
+    unsigned super_physical_free = stats.super_physical_available;
+    unsigned kmalloc_call_count = stats.kmalloc_call_count;
+    unsigned kfree_call_count = stats.kfree_call_count;
 
     size_t kmalloc_sum_available = kmalloc_allocated + kmalloc_available;
     size_t user_pages_available = user_physical_allocated + user_physical_available;
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <LibCore/Forward.h>
 #include <LibGUI/Widget.h>
 
 class GraphWidget;
@@ -43,6 +44,7 @@ private:
     MemoryStatsWidget(GraphWidget& graph);
 
     GraphWidget& m_graph;
+    RefPtr<Core::File> m_proc_memstat;
     RefPtr<GUI::Label> m_user_physical_pages_label;
     RefPtr<GUI::Label> m_supervisor_physical_pages_label;
     RefPtr<GUI::Label> m_kmalloc_space_label;
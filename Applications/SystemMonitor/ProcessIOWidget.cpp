@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ProcessIOWidget.h"
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <LibCore/File.h>
+#include <LibCore/Timer.h>
+#include <LibGUI/BoxLayout.h>
+#include <LibGUI/Label.h>
+#include <LibGUI/Model.h>
+#include <LibGUI/TableView.h>
+
+// One row per latency bucket of /proc/PID/io, with how many reads, writes and page faults fell into it.
+class IOLatencyModel final : public GUI::Model {
+public:
+    enum Column {
+        Latency = 0,
+        Reads,
+        Writes,
+        PageFaults,
+        __Count
+    };
+
+    static NonnullRefPtr<IOLatencyModel> create() { return adopt(*new IOLatencyModel); }
+    virtual ~IOLatencyModel() override { }
+
+    virtual int row_count(const GUI::ModelIndex&) const override { return m_rows.size(); }
+    virtual int column_count(const GUI::ModelIndex&) const override { return Column::__Count; }
+
+    virtual String column_name(int column) const override
+    {
+        switch (column) {
+        case Column::Latency:
+            return "Latency";
+        case Column::Reads:
+            return "Reads";
+        case Column::Writes:
+            return "Writes";
+        case Column::PageFaults:
+            return "Page faults";
+        default:
+            ASSERT_NOT_REACHED();
+        }
+    }
+
+    virtual GUI::Variant data(const GUI::ModelIndex& index, GUI::ModelRole role) const override
+    {
+        auto& row = m_rows[index.row()];
+        if (role == GUI::ModelRole::TextAlignment)
+            return index.column() == Column::Latency ? Gfx::TextAlignment::CenterLeft : Gfx::TextAlignment::CenterRight;
+        if (role != GUI::ModelRole::Display && role != GUI::ModelRole::Sort)
+            return {};
+        switch (index.column()) {
+        case Column::Latency:
+            return role == GUI::ModelRole::Sort ? GUI::Variant((int)index.row()) : GUI::Variant(row.label);
+        case Column::Reads:
+            return row.reads;
+        case Column::Writes:
+            return row.writes;
+        case Column::PageFaults:
+            return row.page_faults;
+        default:
+            ASSERT_NOT_REACHED();
+        }
+    }
+
+    virtual void update() override { did_update(); }
+
+    void set_statistics(const JsonObject& statistics)
+    {
+        auto bounds = statistics.get("latency_bucket_bounds_us");
+        auto reads = statistics.get("read_latency");
+        auto writes = statistics.get("write_latency");
+        auto page_faults = statistics.get("page_fault_latency");
+        m_rows.clear();
+        if (bounds.is_array() && reads.is_array() && writes.is_array() && page_faults.is_array()) {
+            auto& bound_values = bounds.as_array().values();
+            auto& read_values = reads.as_array().values();
+            auto& write_values = writes.as_array().values();
+            auto& page_fault_values = page_faults.as_array().values();
+            for (size_t i = 0; i < read_values.size(); ++i) {
+                Row row;
+                if (i < bound_values.size())
+                    row.label = String::format("< %s", format_microseconds(bound_values[i].to_number<u64>()).characters());
+                else if (!bound_values.is_empty())
+                    row.label = String::format(">= %s", format_microseconds(bound_values.last().to_number<u64>()).characters());
+                row.reads = read_values[i].to_u32();
+                row.writes = i < write_values.size() ? write_values[i].to_u32() : 0;
+                row.page_faults = i < page_fault_values.size() ? page_fault_values[i].to_u32() : 0;
+                m_rows.append(move(row));
+            }
+        }
+        did_update();
+    }
+
+private:
+    IOLatencyModel() { }
+
+    static String format_microseconds(u64 microseconds)
+    {
+        if (microseconds >= 1000000)
+            return String::format("%llu s", microseconds / 1000000);
+        if (microseconds >= 1000)
+            return String::format("%llu ms", microseconds / 1000);
+        return String::format("%llu us", microseconds);
+    }
+
+    struct Row {
+        String label;
+        unsigned reads { 0 };
+        unsigned writes { 0 };
+        unsigned page_faults { 0 };
+    };
+    Vector<Row> m_rows;
+};
+
+ProcessIOWidget::ProcessIOWidget()
+{
+    set_layout<GUI::VerticalBoxLayout>();
+    layout()->set_margins({ 4, 4, 4, 4 });
+
+    m_totals_label = add<GUI::Label>();
+    m_totals_label->set_text_alignment(Gfx::TextAlignment::CenterLeft);
+    m_totals_label->set_size_policy(GUI::SizePolicy::Fill, GUI::SizePolicy::Fixed);
+    m_totals_label->set_preferred_size(0, 20);
+
+    m_table_view = add<GUI::TableView>();
+    m_latency_model = IOLatencyModel::create();
+    m_table_view->set_model(m_latency_model);
+
+    m_timer = add<Core::Timer>(1000, [this] { refresh(); });
+}
+
+ProcessIOWidget::~ProcessIOWidget()
+{
+}
+
+void ProcessIOWidget::set_pid(pid_t pid)
+{
+    if (m_pid == pid)
+        return;
+    m_pid = pid;
+    refresh();
+}
+
+static String pretty_byte_size(u64 size)
+{
+    return String::format("%lluK", size / 1024);
+}
+
+void ProcessIOWidget::refresh()
+{
+    if (m_pid == -1)
+        return;
+
+    auto file = Core::File::construct(String::format("/proc/%d/io", m_pid));
+    if (!file->open(Core::IODevice::ReadOnly))
+        return;
+    auto json = JsonValue::from_string(file->read_all());
+    if (!json.has_value() || !json.value().is_object())
+        return;
+    auto& statistics = json.value().as_object();
+
+    auto bytes = [&](const char* name) { return pretty_byte_size(statistics.get(name).to_number<u64>()); };
+    m_totals_label->set_text(String::format("Syscalls: %llu    File: %s in, %s out    Unix: %s in, %s out    IPv4: %s in, %s out    Block I/O requests: %llu",
+        statistics.get("syscall_count").to_number<u64>(),
+        bytes("file_read_bytes").characters(),
+        bytes("file_write_bytes").characters(),
+        bytes("unix_socket_read_bytes").characters(),
+        bytes("unix_socket_write_bytes").characters(),
+        bytes("ipv4_socket_read_bytes").characters(),
+        bytes("ipv4_socket_write_bytes").characters(),
+        statistics.get("block_io_requests").to_number<u64>()));
+    m_latency_model->set_statistics(statistics);
+}
@@ -142,6 +142,8 @@ String ProcessModel::column_name(int column) const
         return "File In";
     case Column::FileWriteBytes:
         return "File Out";
+    case Column::BlockIORequests:
+        return "Block I/O";
     case Column::Pledge:
         return "Pledge";
     case Column::Veil:
@@ -194,6 +196,7 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole rol
         case Column::UnixSocketWriteBytes:
         case Column::IPv4SocketReadBytes:
         case Column::IPv4SocketWriteBytes:
+        case Column::BlockIORequests:
             return Gfx::TextAlignment::CenterRight;
         default:
             ASSERT_NOT_REACHED();
@@ -263,6 +266,8 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole rol
             return thread.current_state.file_read_bytes;
         case Column::FileWriteBytes:
             return thread.current_state.file_write_bytes;
+        case Column::BlockIORequests:
+            return thread.current_state.block_io_requests;
         case Column::Pledge:
             return thread.current_state.pledge;
         case Column::Veil:
@@ -340,6 +345,8 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole rol
             return thread.current_state.file_read_bytes;
         case Column::FileWriteBytes:
             return thread.current_state.file_write_bytes;
+        case Column::BlockIORequests:
+            return thread.current_state.block_io_requests;
         case Column::Pledge:
             return thread.current_state.pledge;
         case Column::Veil:
@@ -353,21 +360,28 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, GUI::ModelRole rol
 void ProcessModel::update()
 {
     auto previous_pid_count = m_pids.size();
-    auto all_processes = Core::ProcessStatisticsReader::get_all();
+    auto& changes = m_process_statistics_reader.update();
 
     unsigned last_sum_times_scheduled = 0;
-    for (auto& it : m_threads)
+    for (auto& it : m_threads) {
         last_sum_times_scheduled += it.value->current_state.times_scheduled;
+        // Threads of processes that didn't change keep this state, so they show no CPU usage.
+        it.value->previous_state = it.value->current_state;
+    }
 
+    HashTable<pid_t> updated_pids;
     HashTable<PidAndTid> live_pids;
-    unsigned sum_times_scheduled = 0;
-    for (auto& it : all_processes) {
-        for (auto& thread : it.value.threads) {
+    auto update_process = [&](pid_t pid) {
+        auto process_it = m_process_statistics_reader.processes().find(pid);
+        ASSERT(process_it != m_process_statistics_reader.processes().end());
+        auto& process = (*process_it).value;
+        updated_pids.set(pid);
+        for (auto& thread : process.threads) {
             ThreadState state;
-            state.pid = it.value.pid;
-            state.user = it.value.username;
-            state.pledge = it.value.pledge;
-            state.veil = it.value.veil;
+            state.pid = process.pid;
+            state.user = process.username;
+            state.pledge = process.pledge;
+            state.veil = process.veil;
             state.syscall_count = thread.syscall_count;
             state.inode_faults = thread.inode_faults;
             state.zero_faults = thread.zero_faults;
@@ -378,50 +392,60 @@ void ProcessModel::update()
             state.ipv4_socket_write_bytes = thread.ipv4_socket_write_bytes;
             state.file_read_bytes = thread.file_read_bytes;
             state.file_write_bytes = thread.file_write_bytes;
-            state.amount_virtual = it.value.amount_virtual;
-            state.amount_resident = it.value.amount_resident;
-            state.amount_dirty_private = it.value.amount_dirty_private;
-            state.amount_clean_inode = it.value.amount_clean_inode;
-            state.amount_purgeable_volatile = it.value.amount_purgeable_volatile;
-            state.amount_purgeable_nonvolatile = it.value.amount_purgeable_nonvolatile;
-            state.icon_id = it.value.icon_id;
+            state.block_io_requests = thread.block_io_requests;
+            state.amount_virtual = process.amount_virtual;
+            state.amount_resident = process.amount_resident;
+            state.amount_dirty_private = process.amount_dirty_private;
+            state.amount_clean_inode = process.amount_clean_inode;
+            state.amount_purgeable_volatile = process.amount_purgeable_volatile;
+            state.amount_purgeable_nonvolatile = process.amount_purgeable_nonvolatile;
+            state.icon_id = process.icon_id;
 
             state.name = thread.name;
 
-            state.ppid = it.value.ppid;
+            state.ppid = process.ppid;
             state.tid = thread.tid;
-            state.pgid = it.value.pgid;
-            state.sid = it.value.sid;
+            state.pgid = process.pgid;
+            state.sid = process.sid;
             state.times_scheduled = thread.times_scheduled;
             state.cpu = thread.cpu;
             state.cpu_percent = 0;
             state.priority = thread.priority;
             state.effective_priority = thread.effective_priority;
             state.state = thread.state;
-            sum_times_scheduled += thread.times_scheduled;
-            {
-                auto pit = m_threads.find({ it.value.pid, thread.tid });
-                if (pit == m_threads.end())
-                    m_threads.set({ it.value.pid, thread.tid }, make<Thread>());
-            }
-            auto pit = m_threads.find({ it.value.pid, thread.tid });
+
+            if (!m_threads.contains({ process.pid, thread.tid }))
+                m_threads.set({ process.pid, thread.tid }, make<Thread>());
+            auto pit = m_threads.find({ process.pid, thread.tid });
             ASSERT(pit != m_threads.end());
-            (*pit).value->previous_state = (*pit).value->current_state;
             (*pit).value->current_state = state;
 
-            live_pids.set({ it.value.pid, thread.tid });
+            live_pids.set({ process.pid, thread.tid });
         }
+    };
+    for (auto pid : changes.added)
+        update_process(pid);
+    for (auto pid : changes.changed)
+        update_process(pid);
+    for (auto pid : changes.exited)
+        updated_pids.set(pid);
+
+    Vector<PidAndTid, 16> pids_to_remove;
+    for (auto& it : m_threads) {
+        if (updated_pids.contains(it.key.pid) && !live_pids.contains(it.key))
+            pids_to_remove.append(it.key);
     }
+    for (auto pid : pids_to_remove)
+        m_threads.remove(pid);
+
+    unsigned sum_times_scheduled = 0;
+    for (auto& it : m_threads)
+        sum_times_scheduled += it.value->current_state.times_scheduled;
 
     m_pids.clear();
     for (auto& c : m_cpus)
         c.total_cpu_percent = 0.0;
-    Vector<PidAndTid, 16> pids_to_remove;
     for (auto& it : m_threads) {
-        if (!live_pids.contains(it.key)) {
-            pids_to_remove.append(it.key);
-            continue;
-        }
         auto& process = *it.value;
         u32 times_scheduled_diff = process.current_state.times_scheduled - process.previous_state.times_scheduled;
         process.current_state.cpu_percent = ((float)times_scheduled_diff * 100) / (float)(sum_times_scheduled - last_sum_times_scheduled);
@@ -430,8 +454,6 @@ void ProcessModel::update()
             m_pids.append(it.key);
         }
     }
-    for (auto pid : pids_to_remove)
-        m_threads.remove(pid);
 
     if (on_cpu_info_change)
         on_cpu_info_change(m_cpus);
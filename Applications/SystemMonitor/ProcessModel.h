@@ -30,6 +30,7 @@
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
+#include <LibCore/ProcessStatisticsReader.h>
 #include <LibGUI/Model.h>
 #include <unistd.h>
 
@@ -78,6 +79,7 @@ public:
         UnixSocketWriteBytes,
         IPv4SocketReadBytes,
         IPv4SocketWriteBytes,
+        BlockIORequests,
         __Count
     };
 
@@ -140,6 +142,7 @@ private:
         unsigned ipv4_socket_write_bytes;
         unsigned file_read_bytes;
         unsigned file_write_bytes;
+        unsigned block_io_requests;
         float cpu_percent;
         int icon_id;
     };
@@ -149,6 +152,7 @@ private:
         ThreadState previous_state;
     };
 
+    Core::ProcessStatisticsReader m_process_statistics_reader;
     HashMap<uid_t, String> m_usernames;
     HashMap<PidAndTid, NonnullOwnPtr<Thread>> m_threads;
     NonnullOwnPtrVector<CpuInfo> m_cpus;
@@ -29,6 +29,7 @@
 #include "MemoryStatsWidget.h"
 #include "NetworkStatisticsWidget.h"
 #include "ProcessFileDescriptorMapWidget.h"
+#include "ProcessIOWidget.h"
 #include "ProcessMemoryMapWidget.h"
 #include "ProcessModel.h"
 #include "ProcessUnveiledPathsWidget.h"
@@ -310,6 +311,7 @@ int main(int argc, char** argv)
     auto& memory_map_widget = process_tab_widget.add_tab<ProcessMemoryMapWidget>("Memory map");
     auto& open_files_widget = process_tab_widget.add_tab<ProcessFileDescriptorMapWidget>("Open files");
     auto& unveiled_paths_widget = process_tab_widget.add_tab<ProcessUnveiledPathsWidget>("Unveiled paths");
+    auto& io_widget = process_tab_widget.add_tab<ProcessIOWidget>("I/O");
     auto& stack_widget = process_tab_widget.add_tab<ThreadStackWidget>("Stack");
 
     process_table_view.on_selection = [&](auto&) {
@@ -328,6 +330,7 @@ int main(int argc, char** argv)
         stack_widget.set_ids(pid, tid);
         memory_map_widget.set_pid(pid);
         unveiled_paths_widget.set_pid(pid);
+        io_widget.set_pid(pid);
     };
 
     window->show();
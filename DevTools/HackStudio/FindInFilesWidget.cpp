@@ -105,7 +105,12 @@ private:
 static RefPtr<SearchResultsModel> find_in_files(const StringView& text)
 {
     Vector<Match> matches;
+    auto& index = g_project->index();
+    index.revalidate();
     g_project->for_each_text_file([&](auto& file) {
+        // The index only knows what's on disk, so edited documents always have to be searched.
+        if (!file.may_have_unsaved_changes() && !index.may_contain(file.name(), text))
+            return;
         auto matches_in_file = file.document().find_all(text);
         for (auto& range : matches_in_file) {
             auto whole_line_range = file.document().range_for_entire_line(range.start().line());
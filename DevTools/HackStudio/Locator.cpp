@@ -38,9 +38,18 @@ static RefPtr<Gfx::Bitmap> s_file_icon;
 static RefPtr<Gfx::Bitmap> s_cplusplus_icon;
 static RefPtr<Gfx::Bitmap> s_header_icon;
 
+// Typing into the Locator shouldn't have to wait for the popup to fill up with every file of a large project.
+static constexpr size_t max_suggestions = 100;
+
+struct LocatorSuggestion {
+    String filename;
+    String text;
+    Optional<size_t> line;
+};
+
 class LocatorSuggestionModel final : public GUI::Model {
 public:
-    explicit LocatorSuggestionModel(Vector<String>&& suggestions)
+    explicit LocatorSuggestionModel(Vector<LocatorSuggestion>&& suggestions)
         : m_suggestions(move(suggestions))
     {
     }
@@ -57,11 +66,11 @@ public:
         auto& suggestion = m_suggestions.at(index.row());
         if (role == GUI::ModelRole::Display) {
             if (index.column() == Column::Name)
-                return suggestion;
+                return suggestion.text;
             if (index.column() == Column::Icon) {
-                if (suggestion.ends_with(".cpp"))
+                if (suggestion.filename.ends_with(".cpp"))
                     return *s_cplusplus_icon;
-                if (suggestion.ends_with(".h"))
+                if (suggestion.filename.ends_with(".h"))
                     return *s_header_icon;
                 return *s_file_icon;
             }
@@ -70,8 +79,10 @@ public:
     }
     virtual void update() override {};
 
+    const LocatorSuggestion& suggestion_at(int row) const { return m_suggestions.at(row); }
+
 private:
-    Vector<String> m_suggestions;
+    Vector<LocatorSuggestion> m_suggestions;
 };
 
 Locator::Locator()
@@ -143,9 +154,10 @@ Locator::~Locator()
 
 void Locator::open_suggestion(const GUI::ModelIndex& index)
 {
-    auto filename_index = m_suggestion_view->model()->index(index.row(), LocatorSuggestionModel::Column::Name);
-    auto filename = filename_index.data().to_string();
-    open_file(filename);
+    auto& suggestion = static_cast<const LocatorSuggestionModel&>(*m_suggestion_view->model()).suggestion_at(index.row());
+    open_file(suggestion.filename);
+    if (suggestion.line.has_value())
+        current_editor().set_cursor(suggestion.line.value(), 0);
     close();
 }
 
@@ -166,14 +178,14 @@ void Locator::close()
 void Locator::update_suggestions()
 {
     auto typed_text = m_textbox->text();
-    Vector<String> suggestions;
+    Vector<LocatorSuggestion> suggestions;
     g_project->for_each_text_file([&](auto& file) {
-        if (file.name().contains(typed_text))
-            suggestions.append(file.name());
+        if (suggestions.size() < max_suggestions && file.name().contains(typed_text))
+            suggestions.append({ file.name(), file.name(), {} });
     });
-    dbg() << "I have " << suggestions.size() << " suggestion(s):";
-    for (auto& s : suggestions) {
-        dbg() << "    " << s;
+    if (!typed_text.is_empty()) {
+        for (auto& match : g_project->index().find_symbols(typed_text, max_suggestions - suggestions.size()))
+            suggestions.append({ match.filename, String::format("%s (%s:%zu)", match.symbol.name.characters(), match.filename.characters(), match.symbol.line + 1), match.symbol.line });
     }
 
     bool has_suggestions = !suggestions.is_empty();
@@ -186,7 +198,6 @@ void Locator::update_suggestions()
         m_suggestion_view->selection().set(m_suggestion_view->model()->index(0));
 
     m_popup_window->move_to(screen_relative_rect().top_left().translated(0, -m_popup_window->height()));
-    dbg() << "Popup rect: " << m_popup_window->rect();
     m_popup_window->show();
 }
 
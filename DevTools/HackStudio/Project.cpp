@@ -186,6 +186,11 @@ Project::Project(const String& path, Vector<String>&& filenames)
     m_model = adopt(*new ProjectModel(*this));
 
     rebuild_tree();
+
+    // The index lives next to the project file, e.g. ".little.files.index" for "little.files".
+    LexicalPath lexical_path(m_path);
+    auto directory = lexical_path.dirname().is_empty() ? String(".") : lexical_path.dirname();
+    m_index = make<ProjectIndex>(String::format("%s/.%s.index", directory.characters(), lexical_path.basename().characters()), filenames);
 }
 
 Project::~Project()
@@ -252,6 +257,7 @@ bool Project::add_file(const String& filename)
     m_files.append(ProjectFile::construct_with_name(filename));
     rebuild_tree();
     m_model->update();
+    m_index->set_files(filenames());
     return save();
 }
 
@@ -262,6 +268,7 @@ bool Project::remove_file(const String& filename)
     m_files.remove_first_matching([filename](auto& file) { return file->name() == filename; });
     rebuild_tree();
     m_model->update();
+    m_index->set_files(filenames());
     return save();
 }
 
@@ -291,6 +298,15 @@ ProjectFile* Project::get_file(const String& filename)
     return nullptr;
 }
 
+Vector<String> Project::filenames() const
+{
+    Vector<String> filenames;
+    filenames.ensure_capacity(m_files.size());
+    for (auto& file : m_files)
+        filenames.append(file.name());
+    return filenames;
+}
+
 String Project::default_file() const
 {
     if (m_type == ProjectType::Cpp)
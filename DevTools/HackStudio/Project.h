@@ -27,6 +27,7 @@
 #pragma once
 
 #include "ProjectFile.h"
+#include "ProjectIndex.h"
 #include <AK/Noncopyable.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
@@ -57,6 +58,7 @@ public:
 
     ProjectType type() const { return m_type; }
     GUI::Model& model() { return *m_model; }
+    ProjectIndex& index() { return *m_index; }
     String default_file() const;
     String name() const { return m_name; }
     String path() const { return m_path; }
@@ -76,6 +78,7 @@ private:
 
     const ProjectTreeNode& root_node() const { return *m_root_node; }
     void rebuild_tree();
+    Vector<String> filenames() const;
 
     ProjectType m_type { ProjectType::Unknown };
     String m_name;
@@ -83,6 +86,7 @@ private:
     RefPtr<GUI::Model> m_model;
     NonnullRefPtrVector<ProjectFile> m_files;
     RefPtr<ProjectTreeNode> m_root_node;
+    OwnPtr<ProjectIndex> m_index;
 
     GUI::Icon m_directory_icon;
     GUI::Icon m_file_icon;
@@ -44,6 +44,8 @@ public:
     const String& name() const { return m_name; }
 
     const GUI::TextDocument& document() const;
+    // Documents that haven't been edited since they were loaded are the same as the file on disk.
+    bool may_have_unsaved_changes() const { return m_document && m_document->can_undo(); }
 
 private:
     explicit ProjectFile(const String& name);
@@ -0,0 +1,572 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ProjectIndex.h"
+#include <AK/BinarySearch.h>
+#include <AK/ByteBuffer.h>
+#include <AK/HashTable.h>
+#include <AK/LexicalPath.h>
+#include <AK/QuickSort.h>
+#include <AK/Stream.h>
+#include <LibCore/File.h>
+#include <LibGUI/CppLexer.h>
+#include <LibThread/BackgroundAction.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace HackStudio {
+
+static constexpr u32 index_magic = 0x58495348; // "HSIX"
+static constexpr u32 index_version = 1;
+
+// How many files are read in one go before their results are merged into the index.
+static constexpr size_t files_per_batch = 16;
+
+// Every watched directory costs us a file descriptor, and we don't have many of those.
+static constexpr size_t max_watched_directories = 8;
+
+static u32 trigram_at(const StringView& text, size_t offset)
+{
+    return ((u8)text[offset] << 16) | ((u8)text[offset + 1] << 8) | (u8)text[offset + 2];
+}
+
+static bool has_symbols(const String& filename)
+{
+    return filename.ends_with(".cpp") || filename.ends_with(".h") || filename.ends_with(".c");
+}
+
+ProjectIndex::ProjectIndex(const String& path, const Vector<String>& filenames)
+    : m_path(path)
+{
+    for (auto& filename : filenames)
+        m_files.set(filename, {});
+    watch_directories();
+
+    auto weak_this = make_weak_ptr();
+    LibThread::BackgroundAction<Vector<IndexedFile>>::create(
+        [path, filenames] {
+            return load_from_file(path, filenames);
+        },
+        [this, weak_this](auto files) {
+            if (!weak_this.is_null())
+                did_load(move(files));
+        });
+}
+
+ProjectIndex::~ProjectIndex()
+{
+    m_notifiers.clear();
+    for (int fd : m_watch_fds)
+        close(fd);
+}
+
+void ProjectIndex::set_files(const Vector<String>& filenames)
+{
+    HashTable<String> wanted;
+    for (auto& filename : filenames) {
+        wanted.set(filename);
+        if (!m_files.contains(filename)) {
+            m_files.set(filename, {});
+            mark_stale(filename);
+        }
+    }
+
+    Vector<String> removed;
+    for (auto& it : m_files) {
+        if (!wanted.contains(it.key))
+            removed.append(it.key);
+    }
+    for (auto& filename : removed)
+        m_files.remove(filename);
+    if (!removed.is_empty())
+        m_needs_save = true;
+
+    watch_directories();
+    index_next_batch();
+}
+
+void ProjectIndex::file_did_change(const String& filename)
+{
+    mark_stale(filename);
+    index_next_batch();
+}
+
+void ProjectIndex::revalidate()
+{
+    Vector<String> changed;
+    for (auto& it : m_files) {
+        if (!it.value.is_indexed)
+            continue;
+        struct stat st;
+        if (stat(it.key.characters(), &st) < 0 || st.st_mtime != it.value.mtime || st.st_size != it.value.size)
+            changed.append(it.key);
+    }
+    for (auto& filename : changed)
+        mark_stale(filename);
+    index_next_batch();
+}
+
+bool ProjectIndex::may_contain(const String& filename, const StringView& text) const
+{
+    if (text.length() < 3)
+        return true;
+    auto it = m_files.find(filename);
+    if (it == m_files.end() || !it->value.is_indexed)
+        return true;
+
+    auto trigrams = it->value.trigrams.span();
+    for (size_t i = 0; i + 2 < text.length(); ++i) {
+        auto* match = binary_search<const u32>(trigrams, trigram_at(text, i), [](auto& a, auto& b) {
+            return (int)a - (int)b;
+        });
+        if (!match)
+            return false;
+    }
+    return true;
+}
+
+Vector<ProjectIndex::SymbolMatch> ProjectIndex::find_symbols(const StringView& query, size_t max_results) const
+{
+    // Symbols whose (unqualified) name starts with the query come first, since that's usually what's being looked for.
+    Vector<SymbolMatch> prefix_matches;
+    Vector<SymbolMatch> other_matches;
+    for (auto& it : m_files) {
+        if (prefix_matches.size() >= max_results)
+            break;
+        for (auto& symbol : it.value.symbols) {
+            StringView name = symbol.name;
+            auto last_colon = name.find_last_of(':');
+            auto unqualified_name = last_colon.has_value() ? name.substring_view(last_colon.value() + 1, name.length() - last_colon.value() - 1) : name;
+            if (name.starts_with(query) || unqualified_name.starts_with(query)) {
+                prefix_matches.append({ it.key, symbol });
+                if (prefix_matches.size() >= max_results)
+                    break;
+            } else if (other_matches.size() < max_results && name.contains(query)) {
+                other_matches.append({ it.key, symbol });
+            }
+        }
+    }
+
+    auto compare = [](auto& a, auto& b) {
+        if (a.symbol.name == b.symbol.name)
+            return a.filename < b.filename;
+        return a.symbol.name < b.symbol.name;
+    };
+    quick_sort(prefix_matches, compare);
+    quick_sort(other_matches, compare);
+    for (auto& match : other_matches) {
+        if (prefix_matches.size() >= max_results)
+            break;
+        prefix_matches.append(move(match));
+    }
+    return prefix_matches;
+}
+
+bool ProjectIndex::save() const
+{
+    DuplexMemoryStream stream;
+    auto write_string = [&](const String& string) {
+        stream << (u32)string.length() << string.bytes();
+    };
+
+    u32 file_count = 0;
+    for (auto& it : m_files) {
+        if (it.value.is_indexed)
+            ++file_count;
+    }
+    stream << index_magic << index_version << file_count;
+
+    for (auto& it : m_files) {
+        auto& entry = it.value;
+        if (!entry.is_indexed)
+            continue;
+        write_string(it.key);
+        stream << (i64)entry.mtime << (i64)entry.size;
+        stream << (u32)entry.trigrams.size() << ReadonlyBytes { reinterpret_cast<const u8*>(entry.trigrams.data()), entry.trigrams.size() * sizeof(u32) };
+        stream << (u32)entry.symbols.size();
+        for (auto& symbol : entry.symbols) {
+            stream << (u8)symbol.kind << (u32)symbol.line;
+            write_string(symbol.name);
+        }
+    }
+
+    auto buffer = ByteBuffer::create_uninitialized(stream.remaining());
+    stream.read(buffer);
+
+    auto file = Core::File::construct(m_path);
+    if (!file->open((Core::IODevice::OpenMode)(Core::IODevice::WriteOnly | Core::IODevice::Truncate)))
+        return false;
+    if (!file->write(buffer.data(), buffer.size()))
+        return false;
+    return file->close();
+}
+
+Vector<ProjectIndex::IndexedFile> ProjectIndex::load_from_file(const String& path, const Vector<String>& filenames)
+{
+    auto file = Core::File::construct(path);
+    if (!file->open(Core::IODevice::ReadOnly))
+        return {};
+    auto buffer = file->read_all();
+
+    InputMemoryStream stream { buffer };
+    u32 magic = 0;
+    u32 version = 0;
+    u32 file_count = 0;
+    stream >> magic >> version >> file_count;
+    if (stream.handle_error() || magic != index_magic || version != index_version)
+        return {};
+
+    auto read_string = [&](String& string) {
+        u32 length = 0;
+        stream >> length;
+        if (stream.has_error() || length > stream.remaining())
+            return false;
+        string = String { stream.bytes().slice(stream.offset(), length) };
+        stream.discard_or_error(length);
+        return true;
+    };
+
+    HashTable<String> wanted;
+    for (auto& filename : filenames)
+        wanted.set(filename);
+
+    Vector<IndexedFile> files;
+    for (u32 i = 0; i < file_count; ++i) {
+        IndexedFile file;
+        if (!read_string(file.filename))
+            break;
+
+        i64 mtime = 0;
+        i64 size = 0;
+        u32 trigram_count = 0;
+        stream >> mtime >> size >> trigram_count;
+        if (stream.has_error() || trigram_count > stream.remaining() / sizeof(u32))
+            break;
+        file.entry.trigrams.resize(trigram_count);
+        stream >> Bytes { reinterpret_cast<u8*>(file.entry.trigrams.data()), trigram_count * sizeof(u32) };
+
+        u32 symbol_count = 0;
+        stream >> symbol_count;
+        bool ok = !stream.has_error();
+        for (u32 j = 0; ok && j < symbol_count; ++j) {
+            u8 kind = 0;
+            u32 line = 0;
+            Symbol symbol;
+            stream >> kind >> line;
+            ok = read_string(symbol.name) && kind <= (u8)SymbolKind::Function;
+            symbol.kind = (SymbolKind)kind;
+            symbol.line = line;
+            file.entry.symbols.append(move(symbol));
+        }
+        if (!ok)
+            break;
+
+        // Only what's still part of the project and hasn't changed since it was saved is worth keeping.
+        struct stat st;
+        if (!wanted.contains(file.filename) || stat(file.filename.characters(), &st) < 0 || st.st_mtime != mtime || st.st_size != size)
+            continue;
+        file.entry.mtime = mtime;
+        file.entry.size = size;
+        file.entry.is_indexed = true;
+        files.append(move(file));
+    }
+
+    if (stream.handle_error())
+        dbg() << "ProjectIndex: " << path << " is truncated, only " << files.size() << " file(s) could be loaded";
+    return files;
+}
+
+bool ProjectIndex::index_file(const String& filename, FileEntry& entry)
+{
+    // Stat before reading, so that changes made in between make the entry look outdated rather than current.
+    struct stat st;
+    if (stat(filename.characters(), &st) < 0)
+        return false;
+    auto file = Core::File::construct(filename);
+    if (!file->open(Core::IODevice::ReadOnly))
+        return false;
+    auto contents = file->read_all();
+
+    entry.mtime = st.st_mtime;
+    entry.size = st.st_size;
+    entry.trigrams = collect_trigrams(contents);
+    if (has_symbols(filename))
+        entry.symbols = collect_symbols(contents);
+    return true;
+}
+
+Vector<u32> ProjectIndex::collect_trigrams(const StringView& text)
+{
+    HashTable<u32> seen;
+    for (size_t i = 0; i + 2 < text.length(); ++i)
+        seen.set(trigram_at(text, i));
+
+    Vector<u32> trigrams;
+    trigrams.ensure_capacity(seen.size());
+    for (auto trigram : seen)
+        trigrams.append(trigram);
+    quick_sort(trigrams);
+    return trigrams;
+}
+
+Vector<ProjectIndex::Symbol> ProjectIndex::collect_symbols(const StringView& text)
+{
+    using Type = GUI::CppToken::Type;
+
+    Vector<size_t> line_offsets;
+    line_offsets.append(0);
+    for (size_t i = 0; i < text.length(); ++i) {
+        if (text[i] == '\n')
+            line_offsets.append(i + 1);
+    }
+
+    Vector<GUI::CppToken> tokens;
+    for (auto& token : GUI::CppLexer(text).lex()) {
+        if (token.m_type != Type::Whitespace && token.m_type != Type::Comment)
+            tokens.append(token);
+    }
+
+    auto offset_of = [&](const GUI::CppPosition& position) {
+        return line_offsets[position.line] + position.column;
+    };
+    auto text_of = [&](size_t first, size_t last) {
+        auto start = offset_of(tokens[first].m_start);
+        return text.substring_view(start, offset_of(tokens[last].m_end) + 1 - start);
+    };
+    auto is = [&](size_t index, Type type) {
+        return index < tokens.size() && tokens[index].m_type == type;
+    };
+
+    Vector<Symbol> symbols;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (is(i, Type::Keyword)) {
+            auto keyword = text_of(i, i);
+            SymbolKind kind;
+            if (keyword == "namespace")
+                kind = SymbolKind::Namespace;
+            else if (keyword == "class" || keyword == "struct" || keyword == "union" || keyword == "enum")
+                kind = SymbolKind::Type;
+            else
+                continue;
+
+            size_t name_index = i + 1;
+            if (keyword == "enum" && is(name_index, Type::Keyword))
+                ++name_index;
+            if (!is(name_index, Type::Identifier))
+                continue;
+
+            // Only definitions count, not forward declarations or things like `struct stat st;`.
+            size_t j = name_index + 1;
+            while (j < tokens.size() && !is(j, Type::LeftCurly) && !is(j, Type::Semicolon) && !is(j, Type::LeftParen) && !is(j, Type::RightParen) && !is(j, Type::Comma) && !is(j, Type::Equals))
+                ++j;
+            if (is(j, Type::LeftCurly))
+                symbols.append({ text_of(name_index, name_index), kind, tokens[name_index].m_start.line });
+            i = name_index;
+            continue;
+        }
+
+        if (!is(i, Type::Identifier))
+            continue;
+
+        // Function definitions look like `Foo::bar(...) const {`, or `Foo::Foo(...) : m_baz(...)` for constructors.
+        size_t last = i;
+        while (is(last + 1, Type::ColonColon)) {
+            if (is(last + 2, Type::Identifier))
+                last += 2;
+            else if (is(last + 2, Type::Tilde) && is(last + 3, Type::Identifier))
+                last += 3;
+            else
+                break;
+        }
+        size_t first = i;
+        i = last;
+        if (!is(last + 1, Type::LeftParen))
+            continue;
+        if (first > 0) {
+            auto previous = tokens[first - 1].m_type;
+            if (previous == Type::Colon || previous == Type::Comma || previous == Type::Dot || previous == Type::Arrow || previous == Type::Equals || previous == Type::LeftParen || previous == Type::QuestionMark || previous == Type::ColonColon)
+                continue;
+            if (previous == Type::Keyword && text_of(first - 1, first - 1) == "case")
+                continue;
+        }
+
+        size_t j = last + 1;
+        int depth = 0;
+        for (; j < tokens.size(); ++j) {
+            if (is(j, Type::LeftParen))
+                ++depth;
+            else if (is(j, Type::RightParen) && --depth == 0)
+                break;
+        }
+        ++j;
+        while (is(j, Type::Keyword))
+            ++j;
+        if (is(j, Type::LeftCurly) || is(j, Type::Colon))
+            symbols.append({ text_of(first, last), SymbolKind::Function, tokens[first].m_start.line });
+    }
+    return symbols;
+}
+
+void ProjectIndex::did_load(Vector<IndexedFile> files)
+{
+    for (auto& file : files) {
+        auto it = m_files.find(file.filename);
+        // Anything that changed while we were loading has to be indexed again anyway.
+        if (it == m_files.end() || it->value.generation != file.generation)
+            continue;
+        it->value = move(file.entry);
+    }
+
+    Vector<String> unindexed;
+    for (auto& it : m_files) {
+        if (!it.value.is_indexed && !it.value.is_queued)
+            unindexed.append(it.key);
+    }
+    for (auto& filename : unindexed)
+        mark_stale(filename);
+
+    m_is_loading = false;
+    if (on_update)
+        on_update();
+    index_next_batch();
+}
+
+void ProjectIndex::mark_stale(const String& filename)
+{
+    auto it = m_files.find(filename);
+    if (it == m_files.end())
+        return;
+    auto& entry = it->value;
+    entry.is_indexed = false;
+    ++entry.generation;
+    if (!entry.is_queued) {
+        entry.is_queued = true;
+        m_stale_files.append(filename);
+    }
+}
+
+void ProjectIndex::index_next_batch()
+{
+    if (m_is_loading || m_is_indexing)
+        return;
+
+    Vector<IndexedFile> batch;
+    while (!m_stale_files.is_empty() && batch.size() < files_per_batch) {
+        auto filename = m_stale_files.take_last();
+        auto it = m_files.find(filename);
+        if (it == m_files.end())
+            continue;
+        it->value.is_queued = false;
+        batch.append({ filename, it->value.generation, {} });
+    }
+
+    if (batch.is_empty()) {
+        if (m_needs_save) {
+            m_needs_save = false;
+            if (!save())
+                dbg() << "ProjectIndex: Failed to save " << m_path;
+        }
+        return;
+    }
+
+    m_is_indexing = true;
+    auto weak_this = make_weak_ptr();
+    LibThread::BackgroundAction<Vector<IndexedFile>>::create(
+        [batch = move(batch)] {
+            Vector<IndexedFile> files;
+            for (auto& file : batch) {
+                IndexedFile indexed_file { file.filename, file.generation, {} };
+                if (index_file(indexed_file.filename, indexed_file.entry))
+                    files.append(move(indexed_file));
+            }
+            return files;
+        },
+        [this, weak_this](auto files) {
+            if (!weak_this.is_null())
+                did_index_batch(move(files));
+        });
+}
+
+void ProjectIndex::did_index_batch(Vector<IndexedFile> files)
+{
+    for (auto& file : files) {
+        auto it = m_files.find(file.filename);
+        if (it == m_files.end() || it->value.generation != file.generation)
+            continue;
+        bool is_queued = it->value.is_queued;
+        it->value = move(file.entry);
+        it->value.generation = file.generation;
+        it->value.is_queued = is_queued;
+        it->value.is_indexed = true;
+        m_needs_save = true;
+    }
+
+    m_is_indexing = false;
+    if (on_update)
+        on_update();
+    index_next_batch();
+}
+
+void ProjectIndex::watch_directories()
+{
+    m_notifiers.clear();
+    for (int fd : m_watch_fds)
+        close(fd);
+    m_watch_fds.clear();
+
+    // The kernel only tells us that something in a directory changed (not what), which is all
+    // we need to know to look at the files in it again. Changes to the contents of a file that
+    // leave its directory alone are caught by revalidate() before each search instead.
+    HashTable<String> directories;
+    for (auto& it : m_files) {
+        auto dirname = LexicalPath(it.key).dirname();
+        directories.set(dirname.is_empty() ? "." : dirname);
+    }
+
+    for (auto& directory : directories) {
+        if (m_watch_fds.size() >= max_watched_directories)
+            break;
+        int fd = watch_file(directory.characters(), directory.length());
+        if (fd < 0) {
+            perror("watch_file");
+            continue;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        auto notifier = Core::Notifier::construct(fd, Core::Notifier::Event::Read);
+        notifier->on_ready_to_read = [this, fd] {
+            char buffer[32];
+            int rc = read(fd, buffer, sizeof(buffer));
+            ASSERT(rc >= 0);
+            revalidate();
+        };
+        m_watch_fds.append(fd);
+        m_notifiers.append(move(notifier));
+    }
+}
+
+}
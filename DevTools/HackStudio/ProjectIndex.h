@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <AK/Weakable.h>
+#include <LibCore/Notifier.h>
+#include <sys/types.h>
+
+namespace HackStudio {
+
+// Remembers the trigrams and symbols of every file in a project, so that Find in Files and the Locator
+// don't have to read the whole project for every query. Files are indexed on a background thread,
+// and the index is saved next to the project file so that it only has to catch up on what changed.
+class ProjectIndex : public Weakable<ProjectIndex> {
+    AK_MAKE_NONCOPYABLE(ProjectIndex);
+    AK_MAKE_NONMOVABLE(ProjectIndex);
+
+public:
+    enum class SymbolKind : u8 {
+        Namespace,
+        Type,
+        Function,
+    };
+
+    struct Symbol {
+        String name;
+        SymbolKind kind;
+        size_t line;
+    };
+
+    struct SymbolMatch {
+        String filename;
+        Symbol symbol;
+    };
+
+    ProjectIndex(const String& path, const Vector<String>& filenames);
+    ~ProjectIndex();
+
+    void set_files(const Vector<String>& filenames);
+    void file_did_change(const String& filename);
+
+    // Looks for files that changed on disk and indexes them again. Until that's done, they can contain anything.
+    void revalidate();
+
+    // Only returns false if the file is indexed and can't possibly contain the text.
+    bool may_contain(const String& filename, const StringView& text) const;
+    Vector<SymbolMatch> find_symbols(const StringView& query, size_t max_results) const;
+
+    Function<void()> on_update;
+
+private:
+    struct FileEntry {
+        time_t mtime { 0 };
+        off_t size { -1 };
+        bool is_indexed { false };
+        bool is_queued { false };
+        u32 generation { 0 };
+        Vector<u32> trigrams;
+        Vector<Symbol> symbols;
+    };
+
+    struct IndexedFile {
+        String filename;
+        u32 generation { 0 };
+        FileEntry entry;
+    };
+
+    static Vector<IndexedFile> load_from_file(const String& path, const Vector<String>& filenames);
+    static bool index_file(const String& filename, FileEntry&);
+    static Vector<u32> collect_trigrams(const StringView&);
+    static Vector<Symbol> collect_symbols(const StringView&);
+
+    bool save() const;
+    void did_load(Vector<IndexedFile>);
+    void mark_stale(const String& filename);
+    void index_next_batch();
+    void did_index_batch(Vector<IndexedFile>);
+    void watch_directories();
+
+    String m_path;
+    HashMap<String, FileEntry> m_files;
+    Vector<String> m_stale_files;
+    bool m_is_loading { true };
+    bool m_is_indexing { false };
+    bool m_needs_save { false };
+
+    Vector<int> m_watch_fds;
+    NonnullRefPtrVector<Core::Notifier> m_notifiers;
+};
+
+}
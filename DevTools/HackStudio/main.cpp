@@ -465,6 +465,7 @@ int main_impl(int argc, char** argv)
         if (g_currently_open_file.is_empty())
             return;
         current_editor().write_to_file(g_currently_open_file);
+        g_project->index().file_did_change(g_currently_open_file);
     });
 
     toolbar.add_action(new_action);
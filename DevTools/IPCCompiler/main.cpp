@@ -41,6 +41,7 @@ struct Parameter {
 };
 
 struct Message {
+    Vector<String> attributes;
     String name;
     bool is_synchronous { false };
     Vector<Parameter> inputs;
@@ -92,26 +93,30 @@ int main(int argc, char** argv)
             lexer.ignore_until([](char ch) { return ch == '\n'; });
     };
 
+    auto parse_attributes = [&](Vector<String>& storage) {
+        if (!lexer.consume_specific('['))
+            return;
+        for (;;) {
+            if (lexer.consume_specific(']')) {
+                consume_whitespace();
+                break;
+            }
+            if (lexer.consume_specific(',')) {
+                consume_whitespace();
+            }
+            auto attribute = lexer.consume_until([](char ch) { return ch == ']' || ch == ','; });
+            storage.append(attribute);
+            consume_whitespace();
+        }
+    };
+
     auto parse_parameter = [&](Vector<Parameter>& storage) {
         for (;;) {
             Parameter parameter;
             consume_whitespace();
             if (lexer.peek() == ')')
                 break;
-            if (lexer.consume_specific('[')) {
-                for (;;) {
-                    if (lexer.consume_specific(']')) {
-                        consume_whitespace();
-                        break;
-                    }
-                    if (lexer.consume_specific(',')) {
-                        consume_whitespace();
-                    }
-                    auto attribute = lexer.consume_until([](char ch) { return ch == ']' || ch == ','; });
-                    parameter.attributes.append(attribute);
-                    consume_whitespace();
-                }
-            }
+            parse_attributes(parameter.attributes);
             parameter.type = lexer.consume_until([](char ch) { return isspace(ch); });
             consume_whitespace();
             parameter.name = lexer.consume_until([](char ch) { return isspace(ch) || ch == ',' || ch == ')'; });
@@ -139,6 +144,7 @@ int main(int argc, char** argv)
     auto parse_message = [&] {
         Message message;
         consume_whitespace();
+        parse_attributes(message.attributes);
         message.name = lexer.consume_until([](char ch) { return isspace(ch) || ch == '('; });
         consume_whitespace();
         assert_specific('(');
@@ -211,6 +217,7 @@ int main(int argc, char** argv)
     out() << "#include <LibIPC/Dictionary.h>";
     out() << "#include <LibIPC/Encoder.h>";
     out() << "#include <LibIPC/Endpoint.h>";
+    out() << "#include <LibIPC/LargeBuffer.h>";
     out() << "#include <LibIPC/Message.h>";
     out();
 
@@ -267,7 +274,7 @@ int main(int argc, char** argv)
             return builder.to_string();
         };
 
-        auto do_message = [&](const String& name, const Vector<Parameter>& parameters, const String& response_type = {}) {
+        auto do_message = [&](const String& name, const Vector<Parameter>& parameters, const String& response_type = {}, bool is_coalescable = false) {
             out() << "class " << name << " final : public IPC::Message {";
             out() << "public:";
             if (!response_type.is_null())
@@ -317,6 +324,33 @@ int main(int argc, char** argv)
             }
             out() << "        return buffer;";
             out() << "    }";
+            if (is_coalescable) {
+                // Two of these merge when all their other parameters are equal. The newer message's vectors are appended to ours,
+                // its [Latest] parameters replace ours, and its [Sum] parameters are added to ours.
+                out() << "    virtual bool is_coalescable() const override { return true; }";
+                out() << "    virtual OwnPtr<IPC::Message> clone() const override { return make<" << name << ">(*this); }";
+                out() << "    virtual bool coalesce(const IPC::Message& newer) override";
+                out() << "    {";
+                out() << "        if (newer.endpoint_magic() != endpoint_magic() || newer.message_id() != message_id())";
+                out() << "            return false;";
+                out() << "        auto& other = static_cast<const " << name << "&>(newer);";
+                for (auto& parameter : parameters) {
+                    if (parameter.type.starts_with("Vector<") || parameter.attributes.contains_slow("Latest") || parameter.attributes.contains_slow("Sum"))
+                        continue;
+                    out() << "        if (m_" << parameter.name << " != other.m_" << parameter.name << ")";
+                    out() << "            return false;";
+                }
+                for (auto& parameter : parameters) {
+                    if (parameter.type.starts_with("Vector<"))
+                        out() << "        m_" << parameter.name << ".append(other.m_" << parameter.name << ");";
+                    else if (parameter.attributes.contains_slow("Latest"))
+                        out() << "        m_" << parameter.name << " = other.m_" << parameter.name << ";";
+                    else if (parameter.attributes.contains_slow("Sum"))
+                        out() << "        m_" << parameter.name << " += other.m_" << parameter.name << ";";
+                }
+                out() << "        return true;";
+                out() << "    }";
+            }
             for (auto& parameter : parameters) {
                 out() << "    const " << parameter.type << "& " << parameter.name << "() const { return m_" << parameter.name << "; }";
             }
@@ -333,7 +367,10 @@ int main(int argc, char** argv)
                 response_name = message.response_name();
                 do_message(response_name, message.outputs);
             }
-            do_message(message.name, message.inputs, response_name);
+            bool is_coalescable = message.attributes.contains_slow("Coalesce");
+            // A synchronous request must get exactly one response, so it can't be merged into another one.
+            ASSERT(!is_coalescable || !message.is_synchronous);
+            do_message(message.name, message.inputs, response_name, is_coalescable);
         }
         out() << "} // namespace " << endpoint.name;
         out() << "} // namespace Messages";
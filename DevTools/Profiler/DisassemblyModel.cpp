@@ -55,6 +55,9 @@ DisassemblyModel::DisassemblyModel(Profile& profile, ProfileNode& node)
     : m_profile(profile)
     , m_node(node)
 {
+    if (m_profile.is_javascript())
+        return;
+
     String path;
     if (m_node.address() >= 0xc0000000)
         path = "/boot/Kernel";
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FlameGraphWidget.h"
+#include "Profile.h"
+#include <AK/StringBuilder.h>
+#include <LibGUI/Painter.h>
+#include <LibGfx/Font.h>
+
+FlameGraphWidget::FlameGraphWidget(Profile& profile)
+    : m_profile(profile)
+{
+    set_background_color(Color::White);
+    set_fill_with_background_color(true);
+}
+
+FlameGraphWidget::~FlameGraphWidget()
+{
+}
+
+void FlameGraphWidget::did_rebuild_tree()
+{
+    // The old nodes are gone, only the focus path survives.
+    m_bars.clear();
+    set_hovered_node(nullptr);
+    update();
+}
+
+int FlameGraphWidget::bar_height() const
+{
+    return font().glyph_height() + 6;
+}
+
+const ProfileNode* FlameGraphWidget::focused_node() const
+{
+    const ProfileNode* node = nullptr;
+    for (auto& symbol : m_focus_path) {
+        auto& candidates = node ? node->children() : m_profile.roots();
+        const ProfileNode* next = nullptr;
+        for (auto& candidate : candidates) {
+            if (candidate->symbol() == symbol) {
+                next = candidate.ptr();
+                break;
+            }
+        }
+        if (!next)
+            return node;
+        node = next;
+    }
+    return node;
+}
+
+void FlameGraphWidget::lay_out_bars()
+{
+    m_bars.clear();
+
+    auto inner_rect = frame_inner_rect();
+    if (auto* focus = focused_node()) {
+        lay_out_bar(*focus, inner_rect.x(), inner_rect.width(), 0);
+        return;
+    }
+
+    if (!m_profile.filtered_event_count())
+        return;
+    float x = inner_rect.x();
+    for (auto& root : m_profile.roots()) {
+        float width = (float)inner_rect.width() * root->event_count() / m_profile.filtered_event_count();
+        lay_out_bar(root, x, width, 0);
+        x += width;
+    }
+}
+
+void FlameGraphWidget::lay_out_bar(const ProfileNode& node, float x, float width, int depth)
+{
+    // Frames too narrow to see or below the bottom edge aren't worth drawing, and neither is anything they called.
+    if (width < 1.0f)
+        return;
+    int y = frame_inner_rect().y() + depth * bar_height();
+    if (y >= frame_inner_rect().bottom())
+        return;
+
+    m_bars.append({ { (int)x, y, max(1, (int)(x + width) - (int)x), bar_height() - 1 }, &node });
+
+    if (!node.event_count())
+        return;
+    float child_x = x;
+    for (auto& child : node.children()) {
+        float child_width = width * child->event_count() / node.event_count();
+        lay_out_bar(child, child_x, child_width, depth + 1);
+        child_x += child_width;
+    }
+}
+
+static Color color_for_node(const ProfileNode& node)
+{
+    // Give each function a stable color of its own, in the timeline's blue for userspace and red for the kernel.
+    unsigned hash = string_hash(node.symbol().characters(), node.symbol().length());
+    double hue = node.address() >= 0xc0000000 ? 350 + hash % 30 : 210 + hash % 30;
+    if (hue >= 360)
+        hue -= 360;
+    double saturation = 0.35 + (hash >> 8) % 20 / 100.0;
+    double value = 0.85 + (hash >> 16) % 12 / 100.0;
+    return Color::from_hsv(hue, saturation, value);
+}
+
+void FlameGraphWidget::paint_event(GUI::PaintEvent& event)
+{
+    GUI::Frame::paint_event(event);
+
+    GUI::Painter painter(*this);
+    painter.add_clip_rect(event.rect());
+    painter.add_clip_rect(frame_inner_rect());
+
+    lay_out_bars();
+
+    for (auto& bar : m_bars) {
+        if (!bar.rect.intersects(event.rect()))
+            continue;
+        auto color = color_for_node(*bar.node);
+        if (bar.node == m_hovered_node)
+            color = color.darkened(0.8f);
+        painter.fill_rect(bar.rect, color);
+
+        auto text_rect = bar.rect.shrunken(6, 0);
+        if (text_rect.width() > font().glyph_width('x') * 3)
+            painter.draw_text(text_rect, bar.node->symbol(), Gfx::TextAlignment::CenterLeft, Color::Black, Gfx::TextElision::Right);
+    }
+}
+
+const FlameGraphWidget::Bar* FlameGraphWidget::bar_at(const Gfx::IntPoint& position) const
+{
+    for (auto& bar : m_bars) {
+        if (bar.rect.contains(position))
+            return &bar;
+    }
+    return nullptr;
+}
+
+void FlameGraphWidget::set_hovered_node(const ProfileNode* node)
+{
+    if (m_hovered_node == node)
+        return;
+    m_hovered_node = node;
+
+    if (!node) {
+        set_tooltip({});
+        update();
+        return;
+    }
+
+    float total = m_profile.filtered_event_count() ? m_profile.filtered_event_count() : 1;
+    set_tooltip(String::format("%s: %u samples (%.1f%%), %u self",
+        node->symbol().characters(),
+        node->event_count(),
+        node->event_count() * 100.0f / total,
+        node->self_count()));
+    update();
+}
+
+void FlameGraphWidget::mousemove_event(GUI::MouseEvent& event)
+{
+    auto* bar = bar_at(event.position());
+    set_hovered_node(bar ? bar->node : nullptr);
+}
+
+void FlameGraphWidget::leave_event(Core::Event&)
+{
+    set_hovered_node(nullptr);
+}
+
+void FlameGraphWidget::mousedown_event(GUI::MouseEvent& event)
+{
+    // Left click zooms into a frame, right click zooms back out one level.
+    if (event.button() == GUI::MouseButton::Right) {
+        if (!m_focus_path.is_empty())
+            m_focus_path.take_last();
+    } else if (event.button() == GUI::MouseButton::Left) {
+        auto* bar = bar_at(event.position());
+        if (!bar)
+            return;
+        Vector<String> path;
+        for (auto* node = bar->node; node; node = node->parent())
+            path.prepend(node->symbol());
+        m_focus_path = move(path);
+    } else {
+        return;
+    }
+
+    set_hovered_node(nullptr);
+    update();
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibGUI/Frame.h>
+
+class Profile;
+class ProfileNode;
+
+// Shows the call tree as an icicle graph: callers on top, callees below them,
+// with each frame as wide as the share of samples it was on the stack for.
+class FlameGraphWidget final : public GUI::Frame {
+    C_OBJECT(FlameGraphWidget)
+public:
+    virtual ~FlameGraphWidget() override;
+
+    void did_rebuild_tree();
+
+private:
+    explicit FlameGraphWidget(Profile&);
+
+    virtual void paint_event(GUI::PaintEvent&) override;
+    virtual void mousemove_event(GUI::MouseEvent&) override;
+    virtual void mousedown_event(GUI::MouseEvent&) override;
+    virtual void leave_event(Core::Event&) override;
+
+    struct Bar {
+        Gfx::IntRect rect;
+        const ProfileNode* node { nullptr };
+    };
+
+    int bar_height() const;
+    const ProfileNode* focused_node() const;
+    void lay_out_bars();
+    void lay_out_bar(const ProfileNode&, float x, float width, int depth);
+    const Bar* bar_at(const Gfx::IntPoint&) const;
+    void set_hovered_node(const ProfileNode*);
+
+    Profile& m_profile;
+
+    // The symbols leading to the node that was zoomed into, so that it can be found again after the tree was rebuilt.
+    Vector<String> m_focus_path;
+
+    Vector<Bar> m_bars;
+    const ProfileNode* m_hovered_node { nullptr };
+};
@@ -31,18 +31,83 @@
 #include <AK/MappedFile.h>
 #include <AK/QuickSort.h>
 #include <AK/RefPtr.h>
+#include <Kernel/API/Perfcore.h>
 #include <LibCore/File.h>
 #include <LibELF/Loader.h>
+#include <serenity.h>
 #include <stdio.h>
+#include <string.h>
 
-static void sort_profile_nodes(Vector<NonnullRefPtr<ProfileNode>>& nodes)
+static u32 event_weight(const Profile::Event& event)
 {
+    if (event.type == "off_cpu")
+        return max(event.off_cpu_duration_ns / 1000, (u64)1);
+    return 1;
+}
+
+// Returns the frame that an event has at the given depth of the tree, or null if its stack ends before that.
+static const Profile::Frame* frame_at_depth(const Profile::Event& event, size_t depth, bool inverted, bool& is_innermost_frame)
+{
+    if (depth >= event.frames.size())
+        return nullptr;
+    size_t index = inverted ? event.frames.size() - 1 - depth : depth;
+    auto& frame = event.frames.at(index);
+    if (frame.symbol.is_empty())
+        return nullptr;
+    is_innermost_frame = index == event.frames.size() - 1;
+    return &frame;
+}
+
+// Makes one node for every distinct symbol that the given events have at the given depth.
+static Vector<NonnullRefPtr<ProfileNode>> create_nodes_at_depth(const Profile& profile, const Vector<u32>& event_indices, size_t depth, bool inverted, ProfileNode* parent)
+{
+    Vector<NonnullRefPtr<ProfileNode>> nodes;
+    HashMap<String, size_t> node_index_by_symbol;
+
+    for (auto event_index : event_indices) {
+        auto& event = profile.events()[event_index];
+        bool is_innermost_frame = false;
+        auto* frame = frame_at_depth(event, depth, inverted, is_innermost_frame);
+        if (!frame)
+            continue;
+
+        size_t node_index;
+        auto it = node_index_by_symbol.find(frame->symbol);
+        if (it == node_index_by_symbol.end()) {
+            node_index = nodes.size();
+            node_index_by_symbol.set(frame->symbol, node_index);
+            nodes.append(ProfileNode::create(profile, parent, depth, inverted, frame->symbol, frame->address, frame->offset, event.timestamp));
+        } else {
+            node_index = it->value;
+        }
+        nodes[node_index]->add_event(event_index, event_weight(event), is_innermost_frame, frame->address);
+    }
+
     quick_sort(nodes.begin(), nodes.end(), [](auto& a, auto& b) {
         return a->event_count() >= b->event_count();
     });
+    return nodes;
+}
 
-    for (auto& child : nodes)
-        child->sort_children();
+void ProfileNode::add_event(u32 event_index, u32 weight, bool is_innermost_frame, FlatPtr address)
+{
+    m_event_indices.append(event_index);
+    m_event_count += weight;
+    if (!is_innermost_frame)
+        return;
+    m_self_count += weight;
+    auto it = m_events_per_address.find(address);
+    if (it == m_events_per_address.end())
+        m_events_per_address.set(address, weight);
+    else
+        it->value += weight;
+}
+
+void ProfileNode::build_children() const
+{
+    m_children = create_nodes_at_depth(m_profile, m_event_indices, m_depth + 1, m_inverted, const_cast<ProfileNode*>(this));
+    m_event_indices.clear();
+    m_has_built_children = true;
 }
 
 Profile::Profile(String executable_path, Vector<Event> events)
@@ -73,19 +138,7 @@ GUI::Model& Profile::model()
 void Profile::rebuild_tree()
 {
     u32 filtered_event_count = 0;
-    Vector<NonnullRefPtr<ProfileNode>> roots;
-
-    auto find_or_create_root = [&roots](const String& symbol, u32 address, u32 offset, u64 timestamp) -> ProfileNode& {
-        for (size_t i = 0; i < roots.size(); ++i) {
-            auto& root = roots[i];
-            if (root->symbol() == symbol) {
-                return root;
-            }
-        }
-        auto new_root = ProfileNode::create(symbol, address, offset, timestamp);
-        roots.append(new_root);
-        return new_root;
-    };
+    Vector<u32> event_indices;
 
     HashTable<FlatPtr> live_allocations;
 
@@ -102,7 +155,8 @@ void Profile::rebuild_tree()
             live_allocations.remove(event.ptr);
     }
 
-    for (auto& event : m_events) {
+    for (size_t i = 0; i < m_events.size(); ++i) {
+        auto& event = m_events[i];
         if (has_timestamp_filter_range()) {
             auto timestamp = event.timestamp;
             if (timestamp < m_timestamp_filter_range_start || timestamp > m_timestamp_filter_range_end)
@@ -115,63 +169,236 @@ void Profile::rebuild_tree()
         if (event.type == "free")
             continue;
 
-        ProfileNode* node = nullptr;
-
-        auto for_each_frame = [&]<typename Callback>(Callback callback)
-        {
-            if (!m_inverted) {
-                for (size_t i = 0; i < event.frames.size(); ++i) {
-                    if (callback(event.frames.at(i), i == event.frames.size() - 1) == IterationDecision::Break)
-                        break;
-                }
-            } else {
-                for (ssize_t i = event.frames.size() - 1; i >= 0; --i) {
-                    if (callback(event.frames.at(i), static_cast<size_t>(i) == event.frames.size() - 1) == IterationDecision::Break)
-                        break;
-                }
-            }
-        };
-
-        for_each_frame([&](const Frame& frame, bool is_innermost_frame) {
-            auto& symbol = frame.symbol;
-            auto& address = frame.address;
-            auto& offset = frame.offset;
-
-            if (symbol.is_empty())
-                return IterationDecision::Break;
-
-            if (!node)
-                node = &find_or_create_root(symbol, address, offset, event.timestamp);
+        bool is_off_cpu = event.type == "off_cpu";
+        if (is_off_cpu != m_showing_off_cpu)
+            continue;
+
+        event_indices.append(i);
+        filtered_event_count += event_weight(event);
+    }
+
+    m_filtered_event_count = filtered_event_count;
+    m_roots = create_nodes_at_depth(*this, event_indices, 0, m_inverted, nullptr);
+    m_model->update();
+
+    if (on_tree_rebuilt)
+        on_tree_rebuilt();
+}
+
+// Symbolicating is what most of the loading time goes to, and the same few addresses come up in
+// nearly every event. Programs are linked statically, so an address on its own already tells us
+// both the binary (the program or the kernel) and the offset into it.
+class SymbolCache {
+public:
+    SymbolCache(const ELF::Loader& elf_loader, const ELF::Loader* kernel_elf_loader)
+        : m_elf_loader(elf_loader)
+        , m_kernel_elf_loader(kernel_elf_loader)
+    {
+    }
+
+    Profile::Frame frame_for(u32 address)
+    {
+        auto it = m_frames.find(address);
+        if (it != m_frames.end())
+            return it->value;
+
+        u32 offset = 0;
+        String symbol;
+        if (address >= 0xc0000000) {
+            if (m_kernel_elf_loader)
+                symbol = m_kernel_elf_loader->symbolicate(address, &offset);
             else
-                node = &node->find_or_create_child(symbol, address, offset, event.timestamp);
+                symbol = "??";
+        } else {
+            symbol = m_elf_loader.symbolicate(address, &offset);
+        }
+
+        Profile::Frame frame { symbol, address, offset };
+        m_frames.set(address, frame);
+        return frame;
+    }
 
-            node->increment_event_count();
-            if (is_innermost_frame) {
-                node->add_event_address(address);
-                node->increment_self_count();
-            }
-            return IterationDecision::Continue;
-        });
+private:
+    const ELF::Loader& m_elf_loader;
+    const ELF::Loader* m_kernel_elf_loader { nullptr };
+    HashMap<u32, Profile::Frame> m_frames;
+};
+
+// Keeps the executable and the kernel mapped for as long as we're symbolicating against them.
+struct SymbolicationContext {
+    MappedFile elf_file;
+    MappedFile kernel_elf_file;
+    RefPtr<ELF::Loader> elf_loader;
+    RefPtr<ELF::Loader> kernel_elf_loader;
+    OwnPtr<SymbolCache> cache;
+};
 
-        ++filtered_event_count;
+static OwnPtr<SymbolicationContext> create_symbolication_context(const String& executable_path)
+{
+    auto context = make<SymbolicationContext>();
+    context->elf_file = MappedFile(executable_path);
+    if (!context->elf_file.is_valid()) {
+        fprintf(stderr, "Unable to open executable '%s' for symbolication.\n", executable_path.characters());
+        return nullptr;
     }
+    context->elf_loader = ELF::Loader::create(static_cast<const u8*>(context->elf_file.data()), context->elf_file.size());
 
-    sort_profile_nodes(roots);
+    context->kernel_elf_file = MappedFile("/boot/Kernel");
+    if (context->kernel_elf_file.is_valid())
+        context->kernel_elf_loader = ELF::Loader::create(static_cast<const u8*>(context->kernel_elf_file.data()), context->kernel_elf_file.size());
 
-    m_filtered_event_count = filtered_event_count;
-    m_roots = move(roots);
-    m_model->update();
+    context->cache = make<SymbolCache>(*context->elf_loader, context->kernel_elf_loader.ptr());
+    return context;
 }
 
-OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
+// The last steps for an event of either perfcore format, once its stack has been symbolicated.
+static void finish_event(Vector<Profile::Event>& events, Profile::Event&& event, const String& off_cpu_reason)
 {
-    auto file = Core::File::construct(path);
-    if (!file->open(Core::IODevice::ReadOnly)) {
-        fprintf(stderr, "Unable to open %s, error: %s\n", path.to_string().characters(), file->error_string());
+    if (event.frames.size() < 2)
+        return;
+
+    // Make the reason show up as the innermost frame, so waits on different locks and devices can be told apart.
+    if (event.type == "off_cpu")
+        event.frames.append({ String::format("[%s]", off_cpu_reason.characters()), 0, 0 });
+
+    FlatPtr innermost_frame_address = event.frames.at(1).address;
+    event.in_kernel = innermost_frame_address >= 0xc0000000;
+
+    events.append(move(event));
+}
+
+// Event types are shared between all events instead of being allocated for each of them.
+static const String& event_type_name(u8 type)
+{
+    static const String malloc_name = "malloc";
+    static const String free_name = "free";
+    static const String sample_name = "sample";
+    static const String off_cpu_name = "off_cpu";
+    static const String unknown_name = "unknown";
+    switch (type) {
+    case PERF_EVENT_MALLOC:
+        return malloc_name;
+    case PERF_EVENT_FREE:
+        return free_name;
+    case PERF_EVENT_SAMPLE:
+        return sample_name;
+    case PERF_EVENT_OFF_CPU:
+        return off_cpu_name;
+    default:
+        return unknown_name;
+    }
+}
+
+// JavaScript profiles are written by LibJS, and come with the frames already symbolicated.
+OwnPtr<Profile> Profile::load_javascript_profile(const String& script_path, const JsonObject& object)
+{
+    auto events_value = object.get("events");
+    if (!events_value.is_array() || events_value.as_array().is_empty())
         return nullptr;
+
+    Vector<Event> events;
+    for (auto& perf_event_value : events_value.as_array().values()) {
+        auto& perf_event = perf_event_value.as_object();
+
+        Event event;
+        event.timestamp = perf_event.get("timestamp").to_number<u64>();
+        event.type = perf_event.get("type").to_string();
+
+        auto stack_array = perf_event.get("stack").as_array();
+        for (ssize_t i = stack_array.values().size() - 1; i >= 0; --i)
+            event.frames.append({ stack_array.at(i).to_string(), 0, 0 });
+
+        if (event.frames.is_empty())
+            continue;
+        events.append(move(event));
+    }
+
+    auto profile = NonnullOwnPtr<Profile>(NonnullOwnPtr<Profile>::Adopt, *new Profile(script_path, move(events)));
+    profile->m_is_javascript = true;
+    return profile;
+}
+
+// The binary perfcore files written by the kernel are decoded front to back while only a window of
+// the file is mapped, so even huge profiles never have to be in memory as a whole.
+OwnPtr<Profile> Profile::load_binary_profile(MappedFileWindow& file)
+{
+    auto header_bytes = file.window_at(0, sizeof(PerfcoreHeader));
+    if (header_bytes.size() < sizeof(PerfcoreHeader)) {
+        fprintf(stderr, "Invalid perfcore format (truncated header)\n");
+        return nullptr;
+    }
+    PerfcoreHeader header;
+    memcpy(&header, header_bytes.data(), sizeof(header));
+    if (header.version != PERFCORE_VERSION || header.header_size < sizeof(PerfcoreHeader) || header.event_record_size < sizeof(PerfcoreEventRecord)) {
+        fprintf(stderr, "Unsupported perfcore format (version %u)\n", header.version);
+        return nullptr;
+    }
+
+    u64 offset = header.header_size;
+    auto path_bytes = file.window_at(offset, header.executable_path_length);
+    if (path_bytes.size() < header.executable_path_length) {
+        fprintf(stderr, "Invalid perfcore format (truncated header)\n");
+        return nullptr;
+    }
+    String executable_path(reinterpret_cast<const char*>(path_bytes.data()), header.executable_path_length);
+    offset += header.executable_path_length;
+
+    auto context = create_symbolication_context(executable_path);
+    if (!context)
+        return nullptr;
+
+    Vector<Event> events;
+    size_t max_stack_size = 255 * sizeof(u32);
+    while (offset < file.file_size()) {
+        auto bytes = file.window_at(offset, header.event_record_size + max_stack_size);
+        if (bytes.size() < header.event_record_size)
+            break;
+        PerfcoreEventRecord record;
+        memcpy(&record, bytes.data(), sizeof(record));
+        size_t stack_bytes = record.stack_size * sizeof(u32);
+        if (bytes.size() < header.event_record_size + stack_bytes)
+            break;
+        auto* stack = bytes.offset(header.event_record_size);
+        offset += header.event_record_size + stack_bytes;
+
+        Event event;
+        event.timestamp = record.timestamp;
+        event.type = event_type_name(record.type);
+        String off_cpu_reason;
+
+        switch (record.type) {
+        case PERF_EVENT_MALLOC:
+            event.ptr = record.ptr;
+            event.size = record.size;
+            break;
+        case PERF_EVENT_FREE:
+            event.ptr = record.ptr;
+            break;
+        case PERF_EVENT_OFF_CPU:
+            event.off_cpu_duration_ns = record.duration_ns;
+            off_cpu_reason = String(record.reason, strnlen(record.reason, sizeof(record.reason)));
+            break;
+        }
+
+        event.frames.ensure_capacity(record.stack_size + 1);
+        for (ssize_t i = record.stack_size - 1; i >= 0; --i) {
+            u32 address;
+            memcpy(&address, stack + i * sizeof(u32), sizeof(address));
+            event.frames.append(context->cache->frame_for(address));
+        }
+
+        finish_event(events, move(event), off_cpu_reason);
     }
 
-    auto json = JsonValue::from_string(file->read_all());
+    if (events.is_empty())
+        return nullptr;
+
+    return NonnullOwnPtr<Profile>(NonnullOwnPtr<Profile>::Adopt, *new Profile(executable_path, move(events)));
+}
+
+OwnPtr<Profile> Profile::load_json_profile(const ByteBuffer& data)
+{
+    auto json = JsonValue::from_string(data);
     ASSERT(json.has_value());
     if (!json.value().is_object()) {
         fprintf(stderr, "Invalid perfcore format (not a JSON object)\n");
@@ -181,18 +408,12 @@ OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
     auto& object = json.value().as_object();
     auto executable_path = object.get("executable").to_string();
 
-    MappedFile elf_file(executable_path);
-    if (!elf_file.is_valid()) {
-        fprintf(stderr, "Unable to open executable '%s' for symbolication.\n", executable_path.characters());
-        return nullptr;
-    }
-
-    auto elf_loader = ELF::Loader::create(static_cast<const u8*>(elf_file.data()), elf_file.size());
+    if (object.get("kind").to_string() == "javascript")
+        return load_javascript_profile(executable_path, object);
 
-    MappedFile kernel_elf_file("/boot/Kernel");
-    RefPtr<ELF::Loader> kernel_elf_loader;
-    if (kernel_elf_file.is_valid())
-        kernel_elf_loader = ELF::Loader::create(static_cast<const u8*>(kernel_elf_file.data()), kernel_elf_file.size());
+    auto context = create_symbolication_context(executable_path);
+    if (!context)
+        return nullptr;
 
     auto events_value = object.get("events");
     if (!events_value.is_array())
@@ -211,49 +432,47 @@ OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
 
         event.timestamp = perf_event.get("timestamp").to_number<u64>();
         event.type = perf_event.get("type").to_string();
+        String off_cpu_reason;
 
         if (event.type == "malloc") {
             event.ptr = perf_event.get("ptr").to_number<FlatPtr>();
             event.size = perf_event.get("size").to_number<size_t>();
         } else if (event.type == "free") {
             event.ptr = perf_event.get("ptr").to_number<FlatPtr>();
+        } else if (event.type == "off_cpu") {
+            event.off_cpu_duration_ns = perf_event.get("duration_ns").to_number<u64>();
+            off_cpu_reason = perf_event.get("reason").to_string();
         }
 
         auto stack_array = perf_event.get("stack").as_array();
-        for (ssize_t i = stack_array.values().size() - 1; i >= 0; --i) {
-            auto& frame = stack_array.at(i);
-            auto ptr = frame.to_number<u32>();
-            u32 offset = 0;
-            String symbol;
-
-            if (ptr >= 0xc0000000) {
-                if (kernel_elf_loader) {
-                    symbol = kernel_elf_loader->symbolicate(ptr, &offset);
-                } else {
-                    symbol = "??";
-                }
-            } else {
-                symbol = elf_loader->symbolicate(ptr, &offset);
-            }
-
-            event.frames.append({ symbol, ptr, offset });
-        }
-
-        if (event.frames.size() < 2)
-            continue;
+        for (ssize_t i = stack_array.values().size() - 1; i >= 0; --i)
+            event.frames.append(context->cache->frame_for(stack_array.at(i).to_number<u32>()));
 
-        FlatPtr innermost_frame_address = event.frames.at(1).address;
-        event.in_kernel = innermost_frame_address >= 0xc0000000;
-
-        events.append(move(event));
+        finish_event(events, move(event), off_cpu_reason);
     }
 
     return NonnullOwnPtr<Profile>(NonnullOwnPtr<Profile>::Adopt, *new Profile(executable_path, move(events)));
 }
 
-void ProfileNode::sort_children()
+OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
 {
-    sort_profile_nodes(m_children);
+    MappedFileWindow window(path);
+    if (window.is_valid()) {
+        auto magic_bytes = window.window_at(0, sizeof(u32));
+        u32 magic = 0;
+        if (magic_bytes.size() >= sizeof(magic))
+            memcpy(&magic, magic_bytes.data(), sizeof(magic));
+        if (magic == PERFCORE_MAGIC)
+            return load_binary_profile(window);
+    }
+
+    // Profiles read from /proc/profile, and the ones written by LibJS, are JSON.
+    auto file = Core::File::construct(path);
+    if (!file->open(Core::IODevice::ReadOnly)) {
+        fprintf(stderr, "Unable to open %s, error: %s\n", path.to_string().characters(), file->error_string());
+        return nullptr;
+    }
+    return load_json_profile(file->read_all());
 }
 
 void Profile::set_timestamp_filter_range(u64 start, u64 end)
@@ -284,6 +503,14 @@ void Profile::set_inverted(bool inverted)
     rebuild_tree();
 }
 
+void Profile::set_showing_off_cpu(bool showing_off_cpu)
+{
+    if (m_showing_off_cpu == showing_off_cpu)
+        return;
+    m_showing_off_cpu = showing_off_cpu;
+    rebuild_tree();
+}
+
 void Profile::set_show_percentages(bool show_percentages)
 {
     if (m_show_percentages == show_percentages)
@@ -26,9 +26,11 @@
 
 #pragma once
 
+#include <AK/Function.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
+#include <AK/MappedFile.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <LibGUI/Forward.h>
@@ -37,11 +39,15 @@
 class ProfileModel;
 class DisassemblyModel;
 
+class Profile;
+
+// Nodes only know which events pass through them. Their children are worked out the first time
+// somebody asks for them, so the parts of a big tree that are never expanded are never built.
 class ProfileNode : public RefCounted<ProfileNode> {
 public:
-    static NonnullRefPtr<ProfileNode> create(const String& symbol, u32 address, u32 offset, u64 timestamp)
+    static NonnullRefPtr<ProfileNode> create(const Profile& profile, ProfileNode* parent, size_t depth, bool inverted, const String& symbol, u32 address, u32 offset, u64 timestamp)
     {
-        return adopt(*new ProfileNode(symbol, address, offset, timestamp));
+        return adopt(*new ProfileNode(profile, parent, depth, inverted, symbol, address, offset, timestamp));
     }
 
     const String& symbol() const { return m_symbol; }
@@ -52,67 +58,53 @@ public:
     u32 event_count() const { return m_event_count; }
     u32 self_count() const { return m_self_count; }
 
-    int child_count() const { return m_children.size(); }
-    const Vector<NonnullRefPtr<ProfileNode>>& children() const { return m_children; }
-
-    void add_child(ProfileNode& child)
+    int child_count() const { return children().size(); }
+    const Vector<NonnullRefPtr<ProfileNode>>& children() const
     {
-        if (child.m_parent == this)
-            return;
-        ASSERT(!child.m_parent);
-        child.m_parent = this;
-        m_children.append(child);
+        if (!m_has_built_children)
+            build_children();
+        return m_children;
     }
 
-    ProfileNode& find_or_create_child(const String& symbol, u32 address, u32 offset, u64 timestamp)
-    {
-        for (size_t i = 0; i < m_children.size(); ++i) {
-            auto& child = m_children[i];
-            if (child->symbol() == symbol) {
-                return child;
-            }
-        }
-        auto new_child = ProfileNode::create(symbol, address, offset, timestamp);
-        add_child(new_child);
-        return new_child;
-    };
-
     ProfileNode* parent() { return m_parent; }
     const ProfileNode* parent() const { return m_parent; }
 
-    void increment_event_count() { ++m_event_count; }
-    void increment_self_count() { ++m_self_count; }
-
-    void sort_children();
+    // Counts an event (an index into Profile::events()) whose stack passes through this node.
+    void add_event(u32 event_index, u32 weight, bool is_innermost_frame, FlatPtr address);
 
     const HashMap<FlatPtr, size_t>& events_per_address() const { return m_events_per_address; }
-    void add_event_address(FlatPtr address)
-    {
-        auto it = m_events_per_address.find(address);
-        if (it == m_events_per_address.end())
-            m_events_per_address.set(address, 1);
-        else
-            m_events_per_address.set(address, it->value + 1);
-    }
 
 private:
-    explicit ProfileNode(const String& symbol, u32 address, u32 offset, u64 timestamp)
-        : m_symbol(symbol)
+    explicit ProfileNode(const Profile& profile, ProfileNode* parent, size_t depth, bool inverted, const String& symbol, u32 address, u32 offset, u64 timestamp)
+        : m_profile(profile)
+        , m_parent(parent)
+        , m_depth(depth)
+        , m_inverted(inverted)
+        , m_symbol(symbol)
         , m_address(address)
         , m_offset(offset)
         , m_timestamp(timestamp)
     {
     }
 
+    void build_children() const;
+
+    const Profile& m_profile;
     ProfileNode* m_parent { nullptr };
+    size_t m_depth { 0 };
+    bool m_inverted { false };
     String m_symbol;
     u32 m_address { 0 };
     u32 m_offset { 0 };
     u32 m_event_count { 0 };
     u32 m_self_count { 0 };
     u64 m_timestamp { 0 };
-    Vector<NonnullRefPtr<ProfileNode>> m_children;
     HashMap<FlatPtr, size_t> m_events_per_address;
+
+    // Handed down to the children once they are built.
+    mutable Vector<u32> m_event_indices;
+    mutable bool m_has_built_children { false };
+    mutable Vector<NonnullRefPtr<ProfileNode>> m_children;
 };
 
 class Profile {
@@ -138,6 +130,7 @@ public:
         String type;
         FlatPtr ptr { 0 };
         size_t size { 0 };
+        u64 off_cpu_duration_ns { 0 };
         bool in_kernel { false };
         Vector<Frame> frames;
     };
@@ -161,14 +154,28 @@ public:
     bool show_percentages() const { return m_show_percentages; }
     void set_show_percentages(bool);
 
+    // Shows where threads were blocked instead of where they ran, weighted by microseconds spent off-CPU.
+    bool is_showing_off_cpu() const { return m_showing_off_cpu; }
+    void set_showing_off_cpu(bool);
+
     const String& executable_path() const { return m_executable_path; }
 
+    Function<void()> on_tree_rebuilt;
+
+    // JavaScript profiles have no machine code to disassemble.
+    bool is_javascript() const { return m_is_javascript; }
+
 private:
     Profile(String executable_path, Vector<Event>);
 
+    static OwnPtr<Profile> load_javascript_profile(const String& script_path, const JsonObject&);
+    static OwnPtr<Profile> load_json_profile(const ByteBuffer&);
+    static OwnPtr<Profile> load_binary_profile(MappedFileWindow&);
+
     void rebuild_tree();
 
     String m_executable_path;
+    bool m_is_javascript { false };
 
     RefPtr<ProfileModel> m_model;
     RefPtr<DisassemblyModel> m_disassembly_model;
@@ -189,4 +196,5 @@ private:
     u32 m_deepest_stack_depth { 0 };
     bool m_inverted { false };
     bool m_show_percentages { false };
+    bool m_showing_off_cpu { false };
 };
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ProfileDiffModel.h"
+#include "Profile.h"
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+
+struct FunctionSamples {
+    u32 self { 0 };
+    u32 total { 0 };
+};
+
+static HashMap<String, FunctionSamples> samples_per_function(const Profile& profile, u32& sample_count)
+{
+    HashMap<String, FunctionSamples> functions;
+    sample_count = 0;
+
+    for (auto& event : profile.events()) {
+        if (event.type != "sample")
+            continue;
+        ++sample_count;
+
+        // Recursive functions only count once per sample towards their total.
+        HashTable<String> seen_symbols;
+        for (size_t i = 0; i < event.frames.size(); ++i) {
+            auto& symbol = event.frames[i].symbol;
+            if (symbol.is_empty())
+                break;
+            auto& samples = functions.ensure(symbol);
+            if (!seen_symbols.contains(symbol)) {
+                seen_symbols.set(symbol);
+                ++samples.total;
+            }
+            if (i == event.frames.size() - 1)
+                ++samples.self;
+        }
+    }
+    return functions;
+}
+
+ProfileDiffModel::ProfileDiffModel(const Profile& baseline, const Profile& profile)
+{
+    u32 baseline_sample_count = 0;
+    u32 sample_count = 0;
+    auto baseline_functions = samples_per_function(baseline, baseline_sample_count);
+    auto functions = samples_per_function(profile, sample_count);
+
+    // The two runs usually aren't the same length, so compare shares of each run rather than raw sample counts.
+    auto percentage = [](u32 samples, u32 total) {
+        return total ? samples * 100.0f / total : 0.0f;
+    };
+
+    HashMap<String, size_t> row_for_symbol;
+    auto row = [&](const String& symbol) -> FunctionDelta& {
+        if (auto it = row_for_symbol.find(symbol); it != row_for_symbol.end())
+            return m_functions[it->value];
+        row_for_symbol.set(symbol, m_functions.size());
+        m_functions.append({ symbol });
+        return m_functions.last();
+    };
+
+    for (auto& it : baseline_functions) {
+        auto& function = row(it.key);
+        function.baseline_self = percentage(it.value.self, baseline_sample_count);
+        function.baseline_total = percentage(it.value.total, baseline_sample_count);
+    }
+    for (auto& it : functions) {
+        auto& function = row(it.key);
+        function.self = percentage(it.value.self, sample_count);
+        function.total = percentage(it.value.total, sample_count);
+    }
+}
+
+ProfileDiffModel::~ProfileDiffModel()
+{
+}
+
+int ProfileDiffModel::row_count(const GUI::ModelIndex&) const
+{
+    return m_functions.size();
+}
+
+String ProfileDiffModel::column_name(int column) const
+{
+    switch (column) {
+    case Column::Function:
+        return "Function";
+    case Column::BaselineSelf:
+        return "% Self before";
+    case Column::Self:
+        return "% Self after";
+    case Column::SelfDelta:
+        return "Self delta";
+    case Column::BaselineTotal:
+        return "% Total before";
+    case Column::Total:
+        return "% Total after";
+    case Column::TotalDelta:
+        return "Total delta";
+    default:
+        ASSERT_NOT_REACHED();
+        return {};
+    }
+}
+
+GUI::Variant ProfileDiffModel::data(const GUI::ModelIndex& index, GUI::ModelRole role) const
+{
+    auto& function = m_functions[index.row()];
+
+    if (role == GUI::ModelRole::TextAlignment) {
+        if (index.column() != Column::Function)
+            return Gfx::TextAlignment::CenterRight;
+        return {};
+    }
+
+    if (role == GUI::ModelRole::ForegroundColor) {
+        // Less time spent is an improvement.
+        float delta = 0;
+        if (index.column() == Column::SelfDelta)
+            delta = function.self - function.baseline_self;
+        else if (index.column() == Column::TotalDelta)
+            delta = function.total - function.baseline_total;
+        if (delta < 0)
+            return Color(Color::DarkGreen);
+        if (delta > 0)
+            return Color(Color::DarkRed);
+        return {};
+    }
+
+    if (role == GUI::ModelRole::Display || role == GUI::ModelRole::Sort) {
+        switch (index.column()) {
+        case Column::Function:
+            return function.symbol;
+        case Column::BaselineSelf:
+            return function.baseline_self;
+        case Column::Self:
+            return function.self;
+        case Column::SelfDelta:
+            return function.self - function.baseline_self;
+        case Column::BaselineTotal:
+            return function.baseline_total;
+        case Column::Total:
+            return function.total;
+        case Column::TotalDelta:
+            return function.total - function.baseline_total;
+        }
+    }
+    return {};
+}
+
+void ProfileDiffModel::update()
+{
+    did_update();
+}
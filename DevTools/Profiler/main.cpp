@@ -24,8 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "FlameGraphWidget.h"
 #include "Profile.h"
+#include "ProfileDiffModel.h"
 #include "ProfileTimelineWidget.h"
+#include <AK/LexicalPath.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/ElapsedTimer.h>
 #include <LibCore/EventLoop.h>
@@ -42,7 +45,9 @@
 #include <LibGUI/MessageBox.h>
 #include <LibGUI/Model.h>
 #include <LibGUI/ProcessChooser.h>
+#include <LibGUI/SortingProxyModel.h>
 #include <LibGUI/Splitter.h>
+#include <LibGUI/TabWidget.h>
 #include <LibGUI/TableView.h>
 #include <LibGUI/TreeView.h>
 #include <LibGUI/Window.h>
@@ -56,19 +61,20 @@ int main(int argc, char** argv)
 {
     Core::ArgsParser args_parser;
     int pid = 0;
+    const char* path = nullptr;
+    const char* baseline_path = nullptr;
     args_parser.add_option(pid, "PID to profile", "pid", 'p', "PID");
+    args_parser.add_option(baseline_path, "Compare against an earlier profile", "diff", 'd', "path");
+    args_parser.add_positional_argument(path, "Profile to load", "path", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv, false);
 
     auto app = GUI::Application::construct(argc, argv);
     auto app_icon = GUI::Icon::default_icon("app-profiler");
 
-    const char* path = nullptr;
-    if (argc != 2) {
+    if (!path) {
         if (!generate_profile(pid))
             return 0;
         path = "/proc/profile";
-    } else {
-        path = argv[1];
     }
 
     auto profile = Profile::load_from_perfcore_file(path);
@@ -78,6 +84,15 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    OwnPtr<Profile> baseline_profile;
+    if (baseline_path) {
+        baseline_profile = Profile::load_from_perfcore_file(baseline_path);
+        if (!baseline_profile) {
+            fprintf(stderr, "Unable to load profile '%s'\n", baseline_path);
+            return 1;
+        }
+    }
+
     auto window = GUI::Window::construct();
     window->set_title("Profiler");
     window->set_icon(app_icon.bitmap_for_size(16));
@@ -91,10 +106,23 @@ int main(int argc, char** argv)
 
     auto& bottom_splitter = main_widget.add<GUI::VerticalSplitter>();
 
-    auto& tree_view = bottom_splitter.add<GUI::TreeView>();
+    auto& tab_widget = bottom_splitter.add<GUI::TabWidget>();
+
+    auto& tree_view = tab_widget.add_tab<GUI::TreeView>("Call tree");
     tree_view.set_headers_visible(true);
     tree_view.set_model(profile->model());
 
+    auto& flame_graph = tab_widget.add_tab<FlameGraphWidget>("Flame graph", *profile);
+    profile->on_tree_rebuilt = [&] {
+        flame_graph.did_rebuild_tree();
+    };
+
+    if (baseline_profile) {
+        auto& diff_view = tab_widget.add_tab<GUI::TableView>(String::format("Compared to %s", LexicalPath(baseline_path).basename().characters()));
+        diff_view.set_model(GUI::SortingProxyModel::create(ProfileDiffModel::create(*baseline_profile, *profile)));
+        diff_view.set_key_column_and_sort_order(ProfileDiffModel::Column::SelfDelta, GUI::SortOrder::Ascending);
+    }
+
     auto& disassembly_view = bottom_splitter.add<GUI::TableView>();
 
     tree_view.on_selection = [&](auto& index) {
@@ -121,6 +149,12 @@ int main(int argc, char** argv)
     percent_action->set_checked(false);
     view_menu.add_action(percent_action);
 
+    auto off_cpu_action = GUI::Action::create_checkable("Show off-CPU time", { Mod_Ctrl, Key_O }, [&](auto& action) {
+        profile->set_showing_off_cpu(action.is_checked());
+    });
+    off_cpu_action->set_checked(false);
+    view_menu.add_action(off_cpu_action);
+
     auto& help_menu = menubar->add_menu("Help");
     help_menu.add_action(GUI::Action::create("About", [&](auto&) {
         GUI::AboutDialog::show("Profiler", app_icon.bitmap_for_size(32), window);
@@ -158,6 +158,69 @@ bool Emulator::load_elf()
     return true;
 }
 
+static constexpr size_t max_decoded_block_size = 64;
+
+// Anything that may not continue with the next instruction ends a decoded block.
+static bool ends_decoded_block(const X86::Instruction& insn)
+{
+    if (!insn.is_valid())
+        return true;
+
+    if (insn.has_sub_op())
+        return (insn.sub_op() & 0xf0) == 0x80; // Jcc imm16/32
+
+    switch (insn.op()) {
+    case 0x70 ... 0x7f: // Jcc imm8
+    case 0x9a:          // CALL far
+    case 0xc2:          // RET imm16
+    case 0xc3:          // RET
+    case 0xca:          // RETF imm16
+    case 0xcb:          // RETF
+    case 0xcc ... 0xcf: // INT3, INT, INTO, IRET
+    case 0xe0 ... 0xe3: // LOOPNZ, LOOPZ, LOOP, JCXZ
+    case 0xe8 ... 0xeb: // CALL, JMP near/far/short
+    case 0xf4:          // HLT
+        return true;
+    case 0xff:
+        // CALL and JMP through a register or memory.
+        return insn.slash() >= 2 && insn.slash() <= 5;
+    default:
+        return false;
+    }
+}
+
+const Emulator::DecodedBlock& Emulator::decoded_block_at(u32 eip)
+{
+    if (m_decoded_blocks_generation != m_mmu.code_generation()) {
+        m_decoded_blocks.clear();
+        m_decoded_blocks_generation = m_mmu.code_generation();
+    }
+
+    if (auto it = m_decoded_blocks.find(eip); it != m_decoded_blocks.end())
+        return *it->value;
+
+    auto* region = m_mmu.find_region({ m_cpu.cs(), eip });
+    ASSERT(region);
+    region->set_has_decoded_code(true);
+
+    auto block = make<DecodedBlock>();
+    for (;;) {
+        auto insn = X86::Instruction::from_stream(m_cpu, true, true);
+        auto handler = insn.is_valid() ? insn.handler() : nullptr;
+        block->instructions.append({ insn, handler, m_cpu.eip() });
+        if (ends_decoded_block(insn) || block->instructions.size() == max_decoded_block_size)
+            break;
+        // The next instruction may be up to 15 bytes long, don't decode past the end of the region.
+        if (region->end() - m_cpu.eip() < 15)
+            break;
+    }
+    m_cpu.set_eip(eip);
+
+    auto& decoded_block = *block;
+    m_decoded_blocks.set(eip, move(block));
+    return decoded_block;
+}
+
 int Emulator::exec()
 {
     X86::ELFSymbolProvider symbol_provider(*m_elf);
@@ -165,20 +228,32 @@ int Emulator::exec()
     bool trace = false;
 
     while (!m_shutdown) {
-        m_cpu.save_base_eip();
+        auto& block = decoded_block_at(m_cpu.eip());
 
-        auto insn = X86::Instruction::from_stream(m_cpu, true, true);
+        for (auto& decoded : block.instructions) {
+            m_cpu.save_base_eip();
+            m_cpu.set_eip(decoded.next_eip);
 
-        if (trace)
-            out() << (const void*)m_cpu.base_eip() << "  \033[33;1m" << insn.to_string(m_cpu.base_eip(), &symbol_provider) << "\033[0m";
+            if (trace)
+                out() << (const void*)m_cpu.base_eip() << "  \033[33;1m" << decoded.instruction.to_string(m_cpu.base_eip(), &symbol_provider) << "\033[0m";
 
-        (m_cpu.*insn.handler())(insn);
+            if (!decoded.handler) {
+                report("\n==%d==  \033[31;1mInvalid instruction\033[0m at %#08x\n", getpid(), m_cpu.base_eip());
+                dump_backtrace();
+                TODO();
+            }
+            (m_cpu.*decoded.handler)(decoded.instruction);
 
-        if (trace)
-            m_cpu.dump();
+            if (trace)
+                m_cpu.dump();
 
-        if (m_pending_signals)
-            dispatch_one_pending_signal();
+            if (m_pending_signals)
+                dispatch_one_pending_signal();
+
+            // Jumps, signals and writes to code all mean the rest of the block may not be what runs next.
+            if (m_shutdown || m_cpu.eip() != decoded.next_eip || m_decoded_blocks_generation != m_mmu.code_generation())
+                break;
+        }
     }
 
     if (auto* tracer = malloc_tracer())
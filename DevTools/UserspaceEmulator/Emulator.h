@@ -29,6 +29,8 @@
 #include "MallocTracer.h"
 #include "SoftCPU.h"
 #include "SoftMMU.h"
+#include <AK/HashMap.h>
+#include <AK/OwnPtr.h>
 #include <AK/Types.h>
 #include <LibDebug/DebugInfo.h>
 #include <LibELF/Loader.h>
@@ -150,6 +152,20 @@ private:
 
     void dispatch_one_pending_signal();
 
+    // A run of instructions ending in a control transfer, decoded once and then replayed.
+    struct DecodedInstruction {
+        X86::Instruction instruction;
+        X86::InstructionHandler handler { nullptr };
+        u32 next_eip { 0 };
+    };
+    struct DecodedBlock {
+        Vector<DecodedInstruction> instructions;
+    };
+    const DecodedBlock& decoded_block_at(u32 eip);
+
+    HashMap<u32, OwnPtr<DecodedBlock>> m_decoded_blocks;
+    u32 m_decoded_blocks_generation { 0 };
+
     bool m_shutdown { false };
     int m_exit_status { 0 };
 
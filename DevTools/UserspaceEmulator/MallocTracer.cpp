@@ -27,7 +27,9 @@
 #include "MallocTracer.h"
 #include "Emulator.h"
 #include "MmapRegion.h"
+#include <AK/HashTable.h>
 #include <AK/LogStream.h>
+#include <AK/QuickSort.h>
 #include <string.h>
 
 //#define REACHABLE_DEBUG
@@ -38,6 +40,61 @@ MallocTracer::MallocTracer()
 {
 }
 
+static constexpr FlatPtr index_page_size = 4096;
+
+static FlatPtr first_page_of(FlatPtr address)
+{
+    return address & ~(index_page_size - 1);
+}
+
+static FlatPtr last_page_of(FlatPtr address, size_t size)
+{
+    // Empty mallocations still get an entry in the page they start in.
+    return first_page_of(address + max(size, (size_t)1) - 1);
+}
+
+void MallocTracer::add_to_index(const Mallocation& mallocation)
+{
+    for (FlatPtr page = first_page_of(mallocation.address); page <= last_page_of(mallocation.address, mallocation.size); page += index_page_size) {
+        auto& addresses = m_mallocations_by_page.ensure(page);
+        // New mallocations tend to come after the existing ones, so look from the back.
+        size_t i = addresses.size();
+        while (i > 0 && addresses[i - 1] > mallocation.address)
+            --i;
+        addresses.insert(i, mallocation.address);
+    }
+}
+
+void MallocTracer::remove_from_index(const Mallocation& mallocation)
+{
+    for (FlatPtr page = first_page_of(mallocation.address); page <= last_page_of(mallocation.address, mallocation.size); page += index_page_size) {
+        auto it = m_mallocations_by_page.find(page);
+        ASSERT(it != m_mallocations_by_page.end());
+        it->value.remove_first_matching([&](auto address) { return address == mallocation.address; });
+        if (it->value.is_empty())
+            m_mallocations_by_page.remove(it);
+    }
+}
+
+void MallocTracer::forget_freed_mallocations_overlapping(FlatPtr address, size_t size)
+{
+    Vector<FlatPtr> overlapping;
+    for (FlatPtr page = first_page_of(address); page <= last_page_of(address, size); page += index_page_size) {
+        auto it = m_mallocations_by_page.find(page);
+        if (it == m_mallocations_by_page.end())
+            continue;
+        for (auto other_address : it->value) {
+            auto& other = m_mallocations.find(other_address)->value;
+            if (other.freed && other.address < address + size && address < other.address + other.size && !overlapping.contains_slow(other_address))
+                overlapping.append(other_address);
+        }
+    }
+    for (auto other_address : overlapping) {
+        remove_from_index(m_mallocations.find(other_address)->value);
+        m_mallocations.remove(other_address);
+    }
+}
+
 void MallocTracer::target_did_malloc(Badge<SoftCPU>, FlatPtr address, size_t size)
 {
     auto* region = Emulator::the().mmu().find_region({ 0x20, address });
@@ -48,18 +105,21 @@ void MallocTracer::target_did_malloc(Badge<SoftCPU>, FlatPtr address, size_t siz
     // Mark the containing mmap region as a malloc block!
     mmap_region.set_malloc(true);
 
-    auto* shadow_bits = mmap_region.shadow_data() + address - mmap_region.base();
-    memset(shadow_bits, 0, size);
+    mmap_region.set_uninitialized(address - mmap_region.base(), size);
 
-    if (auto* existing_mallocation = find_mallocation(address)) {
-        ASSERT(existing_mallocation->freed);
-        existing_mallocation->size = size;
-        existing_mallocation->freed = false;
-        existing_mallocation->malloc_backtrace = Emulator::the().raw_backtrace();
-        existing_mallocation->free_backtrace.clear();
-        return;
+    if (auto it = m_mallocations.find(address); it != m_mallocations.end()) {
+        auto& existing_mallocation = it->value;
+        ASSERT(existing_mallocation.freed);
+        remove_from_index(existing_mallocation);
+        m_mallocations.remove(it);
     }
-    m_mallocations.append({ address, size, false, Emulator::the().raw_backtrace(), Vector<FlatPtr>() });
+
+    // Whatever used to live in this memory is gone now, so don't let it shadow the new mallocation.
+    forget_freed_mallocations_overlapping(address, size);
+
+    Mallocation mallocation { address, size, false, Emulator::the().raw_backtrace(), Vector<FlatPtr>() };
+    add_to_index(mallocation);
+    m_mallocations.set(address, move(mallocation));
 }
 
 void MallocTracer::target_did_free(Badge<SoftCPU>, FlatPtr address)
@@ -67,19 +127,18 @@ void MallocTracer::target_did_free(Badge<SoftCPU>, FlatPtr address)
     if (!address)
         return;
 
-    for (auto& mallocation : m_mallocations) {
-        if (mallocation.address == address) {
-            if (mallocation.freed) {
-                report("\n");
-                report("==%d==  \033[31;1mDouble free()\033[0m, %p\n", getpid(), address);
-                report("==%d==  Address %p has already been passed to free()\n", getpid(), address);
-                Emulator::the().dump_backtrace();
-            } else {
-                mallocation.freed = true;
-                mallocation.free_backtrace = Emulator::the().raw_backtrace();
-            }
-            return;
+    if (auto it = m_mallocations.find(address); it != m_mallocations.end()) {
+        auto& mallocation = it->value;
+        if (mallocation.freed) {
+            report("\n");
+            report("==%d==  \033[31;1mDouble free()\033[0m, %p\n", getpid(), address);
+            report("==%d==  Address %p has already been passed to free()\n", getpid(), address);
+            Emulator::the().dump_backtrace();
+        } else {
+            mallocation.freed = true;
+            mallocation.free_backtrace = Emulator::the().raw_backtrace();
         }
+        return;
     }
     report("\n");
     report("==%d==  \033[31;1mInvalid free()\033[0m, %p\n", getpid(), address);
@@ -89,17 +148,35 @@ void MallocTracer::target_did_free(Badge<SoftCPU>, FlatPtr address)
 
 MallocTracer::Mallocation* MallocTracer::find_mallocation(FlatPtr address)
 {
-    for (auto& mallocation : m_mallocations) {
-        if (mallocation.contains(address))
-            return &mallocation;
+    auto it = m_mallocations_by_page.find(first_page_of(address));
+    if (it == m_mallocations_by_page.end())
+        return nullptr;
+
+    // Mallocations don't overlap, so only the last one starting at or before the address can contain it.
+    auto& addresses = it->value;
+    size_t low = 0;
+    size_t high = addresses.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (addresses[middle] <= address)
+            low = middle + 1;
+        else
+            high = middle;
     }
-    return nullptr;
+    if (!low)
+        return nullptr;
+
+    auto& mallocation = m_mallocations.find(addresses[low - 1])->value;
+    if (!mallocation.contains(address))
+        return nullptr;
+    return &mallocation;
 }
 
 MallocTracer::Mallocation* MallocTracer::find_mallocation_before(FlatPtr address)
 {
     Mallocation* found_mallocation = nullptr;
-    for (auto& mallocation : m_mallocations) {
+    for (auto& it : m_mallocations) {
+        auto& mallocation = it.value;
         if (mallocation.address >= address)
             continue;
         if (!found_mallocation || (mallocation.address > found_mallocation->address))
@@ -179,32 +256,45 @@ void MallocTracer::audit_write(FlatPtr address, size_t size)
     }
 }
 
-bool MallocTracer::is_reachable(const Mallocation& mallocation) const
+void MallocTracer::dump_leak_report()
 {
-    ASSERT(!mallocation.freed);
+    TemporaryChange change(m_auditing_enabled, false);
 
-    // 1. Search in active (non-freed) mallocations for pointers to this mallocation
-    for (auto& other_mallocation : m_mallocations) {
-        if (&mallocation == &other_mallocation)
-            continue;
-        if (other_mallocation.freed)
-            continue;
-        size_t pointers_in_mallocation = other_mallocation.size / sizeof(u32);
-        for (size_t i = 0; i < pointers_in_mallocation; ++i) {
-            auto value = Emulator::the().mmu().read32({ 0x20, other_mallocation.address + i * sizeof(u32) });
-            if (value.value() == mallocation.address && !value.is_uninitialized()) {
+    // Collect everything that's pointed to in a single pass over memory.
+    HashTable<FlatPtr> reachable_addresses;
+    auto note_pointer = [&](ValueWithShadow<u32> value, FlatPtr source_address) {
+        if (value.is_uninitialized())
+            return;
+        auto it = m_mallocations.find(value.value());
+        if (it == m_mallocations.end() || it->value.freed || it->value.address == source_address)
+            return;
 #ifdef REACHABLE_DEBUG
-                report("mallocation %p is reachable from other mallocation %p\n", mallocation.address, other_mallocation.address);
+        if (!reachable_addresses.contains(value.value()))
+            report("mallocation %p is reachable from %p\n", value.value(), source_address);
 #endif
-                return true;
-            }
+        reachable_addresses.set(value.value());
+    };
+
+    auto& mmu = Emulator::the().mmu();
+
+    // 1. Search in active (non-freed) mallocations for pointers to other mallocations
+    for (auto& it : m_mallocations) {
+        auto& mallocation = it.value;
+        if (mallocation.freed)
+            continue;
+        size_t pointers_in_mallocation = mallocation.size / sizeof(u32);
+        auto* region = mmu.find_region({ 0x20, mallocation.address });
+        if (region && region->contains(mallocation.address + mallocation.size - 1)) {
+            for (size_t i = 0; i < pointers_in_mallocation; ++i)
+                note_pointer(region->read32(mallocation.address - region->base() + i * sizeof(u32)), mallocation.address);
+        } else {
+            for (size_t i = 0; i < pointers_in_mallocation; ++i)
+                note_pointer(mmu.read32({ 0x20, mallocation.address + i * sizeof(u32) }), mallocation.address);
         }
     }
 
-    bool reachable = false;
-
-    // 2. Search in other memory regions for pointers to this mallocation
-    Emulator::the().mmu().for_each_region([&](auto& region) {
+    // 2. Search in other memory regions for pointers to mallocations
+    mmu.for_each_region([&](auto& region) {
         // Skip the stack
         if (region.is_stack())
             return IterationDecision::Continue;
@@ -215,37 +305,27 @@ bool MallocTracer::is_reachable(const Mallocation& mallocation) const
             return IterationDecision::Continue;
 
         size_t pointers_in_region = region.size() / sizeof(u32);
-        for (size_t i = 0; i < pointers_in_region; ++i) {
-            auto value = region.read32(i * sizeof(u32));
-            if (value.value() == mallocation.address && !value.is_uninitialized()) {
-#ifdef REACHABLE_DEBUG
-                report("mallocation %p is reachable from region %p-%p\n", mallocation.address, region.base(), region.end() - 1);
-#endif
-                reachable = true;
-                return IterationDecision::Break;
-            }
-        }
+        for (size_t i = 0; i < pointers_in_region; ++i)
+            note_pointer(region.read32(i * sizeof(u32)), region.base() + i * sizeof(u32));
         return IterationDecision::Continue;
     });
-    return reachable;
-}
 
-void MallocTracer::dump_leak_report()
-{
-    TemporaryChange change(m_auditing_enabled, false);
+    Vector<const Mallocation*> leaks;
+    for (auto& it : m_mallocations) {
+        if (!it.value.freed && !reachable_addresses.contains(it.value.address))
+            leaks.append(&it.value);
+    }
+    // Report leaks in a predictable order.
+    quick_sort(leaks, [](auto* a, auto* b) { return a->address < b->address; });
 
     size_t bytes_leaked = 0;
     size_t leaks_found = 0;
-    for (auto& mallocation : m_mallocations) {
-        if (mallocation.freed)
-            continue;
-        if (is_reachable(mallocation))
-            continue;
+    for (auto* mallocation : leaks) {
         ++leaks_found;
-        bytes_leaked += mallocation.size;
+        bytes_leaked += mallocation->size;
         report("\n");
-        report("==%d==  \033[31;1mLeak\033[0m, %zu-byte allocation at address %#08x\n", getpid(), mallocation.size, mallocation.address);
-        Emulator::the().dump_backtrace(mallocation.malloc_backtrace);
+        report("==%d==  \033[31;1mLeak\033[0m, %zu-byte allocation at address %#08x\n", getpid(), mallocation->size, mallocation->address);
+        Emulator::the().dump_backtrace(mallocation->malloc_backtrace);
     }
 
     report("\n");
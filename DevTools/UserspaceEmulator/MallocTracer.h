@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Badge.h>
+#include <AK/HashMap.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 
@@ -63,9 +64,15 @@ private:
 
     Mallocation* find_mallocation(FlatPtr);
     Mallocation* find_mallocation_before(FlatPtr);
-    bool is_reachable(const Mallocation&) const;
 
-    Vector<Mallocation> m_mallocations;
+    void add_to_index(const Mallocation&);
+    void remove_from_index(const Mallocation&);
+    void forget_freed_mallocations_overlapping(FlatPtr address, size_t);
+
+    // Mallocations by their address.
+    HashMap<FlatPtr, Mallocation> m_mallocations;
+    // For each page, the addresses of the mallocations that overlap it, in ascending order.
+    HashMap<FlatPtr, Vector<FlatPtr>> m_mallocations_by_page;
 
     bool m_auditing_enabled { true };
 };
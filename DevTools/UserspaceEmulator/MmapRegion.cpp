@@ -52,19 +52,80 @@ MmapRegion::MmapRegion(u32 base, u32 size, int prot)
     : Region(base, size)
     , m_prot(prot)
 {
-    m_shadow_data = (u8*)malloc(size);
-    memset(m_shadow_data, 1, size);
+    m_shadow_pages.resize((size + shadow_page_size - 1) / shadow_page_size);
 }
 
 MmapRegion::~MmapRegion()
 {
-    free(m_shadow_data);
     if (m_file_backed)
         munmap(m_data, size());
     else
         free(m_data);
 }
 
+MmapRegion::ShadowPage& MmapRegion::ensure_shadow_page(u32 offset)
+{
+    auto& page = m_shadow_pages[offset / shadow_page_size];
+    if (!page) {
+        page = make<ShadowPage>();
+        memset(page->bits, 0xff, sizeof(page->bits));
+    }
+    return *page;
+}
+
+void MmapRegion::set_initialized(u32 offset, bool initialized)
+{
+    if (initialized && !m_shadow_pages[offset / shadow_page_size])
+        return;
+    auto& page = ensure_shadow_page(offset);
+    u32 bit = offset % shadow_page_size;
+    if (initialized)
+        page.bits[bit / 8] |= 1 << (bit % 8);
+    else
+        page.bits[bit / 8] &= ~(1 << (bit % 8));
+}
+
+void MmapRegion::set_uninitialized(u32 offset, size_t size)
+{
+    ASSERT(offset + size <= this->size());
+    while (size) {
+        auto& page = ensure_shadow_page(offset);
+        u32 offset_in_page = offset % shadow_page_size;
+        size_t size_in_page = min(size, shadow_page_size - offset_in_page);
+
+        // Clear single bits up to the next whole byte of them, then clear whole bytes.
+        size_t i = 0;
+        for (; i < size_in_page && (offset_in_page + i) % 8; ++i)
+            page.bits[(offset_in_page + i) / 8] &= ~(1 << ((offset_in_page + i) % 8));
+        size_t whole_bytes = (size_in_page - i) / 8;
+        memset(page.bits + (offset_in_page + i) / 8, 0, whole_bytes);
+        for (i += whole_bytes * 8; i < size_in_page; ++i)
+            page.bits[(offset_in_page + i) / 8] &= ~(1 << ((offset_in_page + i) % 8));
+
+        offset += size_in_page;
+        size -= size_in_page;
+    }
+}
+
+template<typename T>
+ALWAYS_INLINE T MmapRegion::read_shadow(u32 offset) const
+{
+    // Spread the bits back out into one byte per byte, like ValueWithShadow wants them.
+    T shadow = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        if (is_initialized(offset + i))
+            shadow |= (T)0x01 << (i * 8);
+    }
+    return shadow;
+}
+
+template<typename T>
+ALWAYS_INLINE void MmapRegion::write_shadow(u32 offset, T shadow)
+{
+    for (size_t i = 0; i < sizeof(T); ++i)
+        set_initialized(offset + i, (shadow >> (i * 8)) & 0x01);
+}
+
 ValueWithShadow<u8> MmapRegion::read8(FlatPtr offset)
 {
     if (!is_readable()) {
@@ -79,7 +140,7 @@ ValueWithShadow<u8> MmapRegion::read8(FlatPtr offset)
     }
 
     ASSERT(offset < size());
-    return { *reinterpret_cast<const u8*>(m_data + offset), *reinterpret_cast<const u8*>(m_shadow_data + offset) };
+    return { *reinterpret_cast<const u8*>(m_data + offset), read_shadow<u8>(offset) };
 }
 
 ValueWithShadow<u16> MmapRegion::read16(u32 offset)
@@ -96,7 +157,7 @@ ValueWithShadow<u16> MmapRegion::read16(u32 offset)
     }
 
     ASSERT(offset + 1 < size());
-    return { *reinterpret_cast<const u16*>(m_data + offset), *reinterpret_cast<const u16*>(m_shadow_data + offset) };
+    return { *reinterpret_cast<const u16*>(m_data + offset), read_shadow<u16>(offset) };
 }
 
 ValueWithShadow<u32> MmapRegion::read32(u32 offset)
@@ -113,7 +174,7 @@ ValueWithShadow<u32> MmapRegion::read32(u32 offset)
     }
 
     ASSERT(offset + 3 < size());
-    return { *reinterpret_cast<const u32*>(m_data + offset), *reinterpret_cast<const u32*>(m_shadow_data + offset) };
+    return { *reinterpret_cast<const u32*>(m_data + offset), read_shadow<u32>(offset) };
 }
 
 void MmapRegion::write8(u32 offset, ValueWithShadow<u8> value)
@@ -131,7 +192,7 @@ void MmapRegion::write8(u32 offset, ValueWithShadow<u8> value)
 
     ASSERT(offset < size());
     *reinterpret_cast<u8*>(m_data + offset) = value.value();
-    *reinterpret_cast<u8*>(m_shadow_data + offset) = value.shadow();
+    write_shadow(offset, value.shadow());
 }
 
 void MmapRegion::write16(u32 offset, ValueWithShadow<u16> value)
@@ -149,7 +210,7 @@ void MmapRegion::write16(u32 offset, ValueWithShadow<u16> value)
 
     ASSERT(offset + 1 < size());
     *reinterpret_cast<u16*>(m_data + offset) = value.value();
-    *reinterpret_cast<u16*>(m_shadow_data + offset) = value.shadow();
+    write_shadow(offset, value.shadow());
 }
 
 void MmapRegion::write32(u32 offset, ValueWithShadow<u32> value)
@@ -166,9 +227,8 @@ void MmapRegion::write32(u32 offset, ValueWithShadow<u32> value)
     }
 
     ASSERT(offset + 3 < size());
-    ASSERT(m_data != m_shadow_data);
     *reinterpret_cast<u32*>(m_data + offset) = value.value();
-    *reinterpret_cast<u32*>(m_shadow_data + offset) = value.shadow();
+    write_shadow(offset, value.shadow());
 }
 
 }
@@ -27,6 +27,8 @@
 #pragma once
 
 #include "SoftMMU.h"
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
 #include <sys/mman.h>
 
 namespace UserspaceEmulator {
@@ -46,7 +48,8 @@ public:
     virtual void write32(u32 offset, ValueWithShadow<u32>) override;
 
     u8* data() { return m_data; }
-    u8* shadow_data() { return m_shadow_data; }
+
+    void set_uninitialized(u32 offset, size_t size);
 
     bool is_readable() const { return m_prot & PROT_READ; }
     bool is_writable() const { return m_prot & PROT_WRITE; }
@@ -59,8 +62,31 @@ private:
     MmapRegion(u32 base, u32 size, int prot);
     virtual bool is_mmap() const override { return true; }
 
+    // Shadow memory is kept as one bit per byte, which is set while the byte is initialized.
+    // Most pages never see an uninitialized byte, so their shadow page is only allocated once one does.
+    static constexpr size_t shadow_page_size = 4096;
+    struct ShadowPage {
+        u8 bits[shadow_page_size / 8];
+    };
+
+    bool is_initialized(u32 offset) const
+    {
+        auto* page = m_shadow_pages[offset / shadow_page_size].ptr();
+        if (!page)
+            return true;
+        u32 bit = offset % shadow_page_size;
+        return page->bits[bit / 8] & (1 << (bit % 8));
+    }
+    void set_initialized(u32 offset, bool);
+    ShadowPage& ensure_shadow_page(u32 offset);
+
+    template<typename T>
+    T read_shadow(u32 offset) const;
+    template<typename T>
+    void write_shadow(u32 offset, T shadow);
+
     u8* m_data { nullptr };
-    u8* m_shadow_data { nullptr };
+    Vector<OwnPtr<ShadowPage>> m_shadow_pages;
     int m_prot { 0 };
     bool m_file_backed { false };
     bool m_malloc { false };
@@ -55,6 +55,8 @@ void SoftMMU::remove_region(Region& region)
 {
     if (region.is_shared_buffer())
         m_shbuf_regions.remove(static_cast<SharedBufferRegion&>(region).shbuf_id());
+    if (region.has_decoded_code())
+        ++m_code_generation;
     m_regions.remove_first_matching([&](auto& entry) { return entry.ptr() == &region; });
 }
 
@@ -105,6 +107,8 @@ void SoftMMU::write8(X86::LogicalAddress address, ValueWithShadow<u8> value)
         TODO();
     }
 
+    if (region->has_decoded_code())
+        ++m_code_generation;
     region->write8(address.offset() - region->base(), value);
 }
 
@@ -116,6 +120,8 @@ void SoftMMU::write16(X86::LogicalAddress address, ValueWithShadow<u16> value)
         TODO();
     }
 
+    if (region->has_decoded_code())
+        ++m_code_generation;
     region->write16(address.offset() - region->base(), value);
 }
 
@@ -127,6 +133,8 @@ void SoftMMU::write32(X86::LogicalAddress address, ValueWithShadow<u32> value)
         TODO();
     }
 
+    if (region->has_decoded_code())
+        ++m_code_generation;
     region->write32(address.offset() - region->base(), value);
 }
 
@@ -67,6 +67,9 @@ public:
         bool is_text() const { return m_text; }
         void set_text(bool b) { m_text = b; }
 
+        bool has_decoded_code() const { return m_has_decoded_code; }
+        void set_has_decoded_code(bool b) { m_has_decoded_code = b; }
+
     protected:
         Region(u32 base, u32 size)
             : m_base(base)
@@ -80,6 +83,7 @@ public:
 
         bool m_stack { false };
         bool m_text { false };
+        bool m_has_decoded_code { false };
     };
 
     ValueWithShadow<u8> read8(X86::LogicalAddress);
@@ -103,6 +107,9 @@ public:
 
     SharedBufferRegion* shbuf_region(int shbuf_id);
 
+    // Bumped whenever memory that instructions were decoded from gets written to or unmapped.
+    u32 code_generation() const { return m_code_generation; }
+
     template<typename Callback>
     void for_each_region(Callback callback)
     {
@@ -120,6 +127,8 @@ private:
     OwnPtr<Region> m_tls_region;
     NonnullOwnPtrVector<Region> m_regions;
     HashMap<int, Region*> m_shbuf_regions;
+
+    u32 m_code_generation { 0 };
 };
 
 }
@@ -33,6 +33,9 @@
 
 __BEGIN_DECLS
 
+// NOTE: Reading from a framebuffer device blocks until the next vertical blank,
+//       and yields the number of vblanks since boot as a u64.
+
 ALWAYS_INLINE int fb_get_size_in_bytes(int fd, size_t* out)
 {
     return ioctl(fd, FB_IOCTL_GET_SIZE_IN_BYTES, out);
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// Binary layout of the perfcore files written when a profiled process exits. It holds the same
+// events as the JSON from /proc/profile, but can be read front to back without parsing.
+//
+// The header records the size of itself and of an event record, so readers step over records
+// using those sizes and new fields can be appended without breaking them. Incompatible changes
+// bump the version.
+
+#define PERFCORE_MAGIC 0x46524550 // "PERF"
+#define PERFCORE_VERSION 1
+
+// The header is followed by executable_path_length bytes of the executable's path (not null-terminated).
+struct [[gnu::packed]] PerfcoreHeader
+{
+    u32 magic;
+    u16 version;
+    u16 header_size;
+    u32 event_record_size;
+    i32 pid;
+    u32 lost_events;
+    u32 executable_path_length;
+};
+
+// Every event record is directly followed by stack_size u32 return addresses, innermost frame first.
+struct [[gnu::packed]] PerfcoreEventRecord
+{
+    u8 type;
+    u8 stack_size;
+    u64 timestamp;
+    // PERF_EVENT_MALLOC and PERF_EVENT_FREE
+    u32 ptr;
+    u32 size;
+    // PERF_EVENT_SAMPLE
+    u32 counter;
+    u32 period;
+    // PERF_EVENT_OFF_CPU
+    u64 duration_ns;
+    char reason[24];
+};
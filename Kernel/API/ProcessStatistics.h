@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// Binary layouts of /proc/all.bin and /proc/memstat.bin, which carry the same numbers as their
+// JSON counterparts but can be consumed without any parsing.
+//
+// Every file starts with a header that records the size of each record type. New fields are
+// only ever appended to a record, so readers step over records using the sizes from the header
+// and can tell whether a field they know about is present. Incompatible changes bump the version.
+
+#define PROC_STATS_MAGIC 0x54415453 // "STAT"
+#define PROC_STATS_VERSION 1
+
+struct [[gnu::packed]] ProcStatsHeader
+{
+    u32 magic;
+    u16 version;
+    u16 header_size;
+};
+
+// /proc/all.bin: the header, then every process record directly followed by its thread records.
+struct [[gnu::packed]] ProcessStatsFileHeader
+{
+    ProcStatsHeader header;
+    u32 process_record_size;
+    u32 thread_record_size;
+    u32 process_count;
+};
+
+struct [[gnu::packed]] ProcessStatsRecord
+{
+    i32 pid;
+    i32 pgid;
+    i32 pgp;
+    i32 sid;
+    u32 uid;
+    u32 gid;
+    i32 ppid;
+    u32 nfds;
+    u32 amount_virtual;
+    u32 amount_resident;
+    u32 amount_shared;
+    u32 amount_dirty_private;
+    u32 amount_clean_inode;
+    u32 amount_purgeable_volatile;
+    u32 amount_purgeable_nonvolatile;
+    i32 icon_id;
+    u32 thread_count;
+    char name[64];
+    char tty[32];
+    char pledge[192];
+    char veil[16];
+};
+
+struct [[gnu::packed]] ThreadStatsRecord
+{
+    i32 tid;
+    u32 times_scheduled;
+    u32 ticks;
+    u32 syscall_count;
+    u32 inode_faults;
+    u32 zero_faults;
+    u32 cow_faults;
+    u32 unix_socket_read_bytes;
+    u32 unix_socket_write_bytes;
+    u32 ipv4_socket_read_bytes;
+    u32 ipv4_socket_write_bytes;
+    u32 file_read_bytes;
+    u32 file_write_bytes;
+    u32 cpu;
+    u32 priority;
+    u32 effective_priority;
+    char state[32];
+    char name[64];
+    u32 fpu_saves;
+    u32 fpu_restores;
+    u32 block_io_requests;
+};
+
+// /proc/memstat.bin: the header, the memory record, then one record per slab allocator.
+struct [[gnu::packed]] MemoryStatsFileHeader
+{
+    ProcStatsHeader header;
+    u32 memory_record_size;
+    u32 slab_record_size;
+    u32 slab_count;
+};
+
+struct [[gnu::packed]] MemoryStatsRecord
+{
+    u32 kmalloc_allocated;
+    u32 kmalloc_available;
+    u32 kmalloc_eternal_allocated;
+    u32 kmalloc_subheap_count;
+    u32 kmalloc_free_run_count;
+    u32 kmalloc_largest_free_run;
+    u32 user_physical_allocated;
+    u32 user_physical_available;
+    u32 user_physical_compressed;
+    u32 user_physical_compressed_bytes;
+    u32 super_physical_allocated;
+    u32 super_physical_available;
+    u32 kmalloc_call_count;
+    u32 kfree_call_count;
+};
+
+struct [[gnu::packed]] SlabStatsRecord
+{
+    u32 slab_size;
+    u32 num_allocated;
+    u32 num_free;
+};
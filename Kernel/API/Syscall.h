@@ -37,6 +37,8 @@ constexpr int syscall_vector = 0x82;
 
 extern "C" {
 struct pollfd;
+struct iovec;
+struct epoll_event;
 struct timeval;
 struct timespec;
 struct sockaddr;
@@ -47,161 +49,186 @@ typedef u32 socklen_t;
 
 namespace Kernel {
 
-#define ENUMERATE_SYSCALLS(S) \
-    S(sleep)                  \
-    S(yield)                  \
-    S(open)                   \
-    S(close)                  \
-    S(read)                   \
-    S(lseek)                  \
-    S(kill)                   \
-    S(getuid)                 \
-    S(exit)                   \
-    S(geteuid)                \
-    S(getegid)                \
-    S(getgid)                 \
-    S(getpid)                 \
-    S(getppid)                \
-    S(getresuid)              \
-    S(getresgid)              \
-    S(waitid)                 \
-    S(mmap)                   \
-    S(munmap)                 \
-    S(get_dir_entries)        \
-    S(getcwd)                 \
-    S(gettimeofday)           \
-    S(gethostname)            \
-    S(sethostname)            \
-    S(chdir)                  \
-    S(uname)                  \
-    S(set_mmap_name)          \
-    S(readlink)               \
-    S(write)                  \
-    S(ttyname)                \
-    S(stat)                   \
-    S(getsid)                 \
-    S(setsid)                 \
-    S(getpgid)                \
-    S(setpgid)                \
-    S(getpgrp)                \
-    S(fork)                   \
-    S(execve)                 \
-    S(dup2)                   \
-    S(sigaction)              \
-    S(umask)                  \
-    S(getgroups)              \
-    S(setgroups)              \
-    S(sigreturn)              \
-    S(sigprocmask)            \
-    S(sigpending)             \
-    S(pipe)                   \
-    S(killpg)                 \
-    S(seteuid)                \
-    S(setegid)                \
-    S(setuid)                 \
-    S(setgid)                 \
-    S(setresuid)              \
-    S(setresgid)              \
-    S(alarm)                  \
-    S(fstat)                  \
-    S(access)                 \
-    S(fcntl)                  \
-    S(ioctl)                  \
-    S(mkdir)                  \
-    S(times)                  \
-    S(utime)                  \
-    S(sync)                   \
-    S(ptsname)                \
-    S(select)                 \
-    S(unlink)                 \
-    S(poll)                   \
-    S(rmdir)                  \
-    S(chmod)                  \
-    S(usleep)                 \
-    S(socket)                 \
-    S(bind)                   \
-    S(accept)                 \
-    S(listen)                 \
-    S(connect)                \
-    S(shbuf_create)           \
-    S(shbuf_allow_pid)        \
-    S(shbuf_get)              \
-    S(shbuf_release)          \
-    S(link)                   \
-    S(chown)                  \
-    S(fchmod)                 \
-    S(symlink)                \
-    S(shbuf_seal)             \
-    S(sendto)                 \
-    S(recvfrom)               \
-    S(getsockopt)             \
-    S(setsockopt)             \
-    S(create_thread)          \
-    S(gettid)                 \
-    S(donate)                 \
-    S(rename)                 \
-    S(ftruncate)              \
-    S(exit_thread)            \
-    S(mknod)                  \
-    S(writev)                 \
-    S(beep)                   \
-    S(getsockname)            \
-    S(getpeername)            \
-    S(sched_setparam)         \
-    S(sched_getparam)         \
-    S(fchown)                 \
-    S(halt)                   \
-    S(reboot)                 \
-    S(mount)                  \
-    S(umount)                 \
-    S(dump_backtrace)         \
-    S(dbgputch)               \
-    S(dbgputstr)              \
-    S(watch_file)             \
-    S(shbuf_allow_all)        \
-    S(set_process_icon)       \
-    S(mprotect)               \
-    S(realpath)               \
-    S(get_process_name)       \
-    S(fchdir)                 \
-    S(getrandom)              \
-    S(setkeymap)              \
-    S(clock_gettime)          \
-    S(clock_settime)          \
-    S(clock_nanosleep)        \
-    S(join_thread)            \
-    S(module_load)            \
-    S(module_unload)          \
-    S(detach_thread)          \
-    S(set_thread_name)        \
-    S(get_thread_name)        \
-    S(madvise)                \
-    S(purge)                  \
-    S(shbuf_set_volatile)     \
-    S(profiling_enable)       \
-    S(profiling_disable)      \
-    S(futex)                  \
-    S(set_thread_boost)       \
-    S(set_process_boost)      \
-    S(chroot)                 \
-    S(pledge)                 \
-    S(unveil)                 \
-    S(perf_event)             \
-    S(shutdown)               \
-    S(get_stack_bounds)       \
-    S(ptrace)                 \
-    S(minherit)               \
-    S(sendfd)                 \
-    S(recvfd)                 \
-    S(sysconf)                \
-    S(set_process_name)       \
-    S(disown)
+// Syscalls marked NeedsBigProcessLock::No run without Process::big_lock() and rely on the
+// finer-grained per-process locks instead (see Process.h). Everything else is still
+// serialized against the rest of the process by the big lock.
+enum class NeedsBigProcessLock {
+    No,
+    Yes,
+};
+
+#define ENUMERATE_SYSCALLS(S)                       \
+    S(sleep, NeedsBigProcessLock::No)               \
+    S(yield, NeedsBigProcessLock::No)               \
+    S(open, NeedsBigProcessLock::No)                \
+    S(close, NeedsBigProcessLock::No)               \
+    S(read, NeedsBigProcessLock::No)                \
+    S(lseek, NeedsBigProcessLock::No)               \
+    S(kill, NeedsBigProcessLock::Yes)               \
+    S(getuid, NeedsBigProcessLock::No)              \
+    S(exit, NeedsBigProcessLock::Yes)               \
+    S(geteuid, NeedsBigProcessLock::No)             \
+    S(getegid, NeedsBigProcessLock::No)             \
+    S(getgid, NeedsBigProcessLock::No)              \
+    S(getpid, NeedsBigProcessLock::No)              \
+    S(getppid, NeedsBigProcessLock::No)             \
+    S(getresuid, NeedsBigProcessLock::No)           \
+    S(getresgid, NeedsBigProcessLock::No)           \
+    S(waitid, NeedsBigProcessLock::Yes)             \
+    S(mmap, NeedsBigProcessLock::No)                \
+    S(munmap, NeedsBigProcessLock::No)              \
+    S(get_dir_entries, NeedsBigProcessLock::No)     \
+    S(getcwd, NeedsBigProcessLock::No)              \
+    S(gettimeofday, NeedsBigProcessLock::No)        \
+    S(gethostname, NeedsBigProcessLock::Yes)        \
+    S(sethostname, NeedsBigProcessLock::Yes)        \
+    S(chdir, NeedsBigProcessLock::No)               \
+    S(uname, NeedsBigProcessLock::No)               \
+    S(set_mmap_name, NeedsBigProcessLock::No)       \
+    S(readlink, NeedsBigProcessLock::No)            \
+    S(write, NeedsBigProcessLock::No)               \
+    S(ttyname, NeedsBigProcessLock::Yes)            \
+    S(stat, NeedsBigProcessLock::No)                \
+    S(getsid, NeedsBigProcessLock::Yes)             \
+    S(setsid, NeedsBigProcessLock::Yes)             \
+    S(getpgid, NeedsBigProcessLock::Yes)            \
+    S(setpgid, NeedsBigProcessLock::Yes)            \
+    S(getpgrp, NeedsBigProcessLock::Yes)            \
+    S(fork, NeedsBigProcessLock::Yes)               \
+    S(execve, NeedsBigProcessLock::Yes)             \
+    S(dup2, NeedsBigProcessLock::No)                \
+    S(sigaction, NeedsBigProcessLock::Yes)          \
+    S(umask, NeedsBigProcessLock::Yes)              \
+    S(getgroups, NeedsBigProcessLock::No)           \
+    S(setgroups, NeedsBigProcessLock::Yes)          \
+    S(sigreturn, NeedsBigProcessLock::Yes)          \
+    S(sigprocmask, NeedsBigProcessLock::Yes)        \
+    S(sigpending, NeedsBigProcessLock::Yes)         \
+    S(pipe, NeedsBigProcessLock::No)                \
+    S(killpg, NeedsBigProcessLock::Yes)             \
+    S(seteuid, NeedsBigProcessLock::Yes)            \
+    S(setegid, NeedsBigProcessLock::Yes)            \
+    S(setuid, NeedsBigProcessLock::Yes)             \
+    S(setgid, NeedsBigProcessLock::Yes)             \
+    S(setresuid, NeedsBigProcessLock::Yes)          \
+    S(setresgid, NeedsBigProcessLock::Yes)          \
+    S(alarm, NeedsBigProcessLock::Yes)              \
+    S(fstat, NeedsBigProcessLock::No)               \
+    S(access, NeedsBigProcessLock::No)              \
+    S(fcntl, NeedsBigProcessLock::No)               \
+    S(ioctl, NeedsBigProcessLock::Yes)              \
+    S(mkdir, NeedsBigProcessLock::Yes)              \
+    S(times, NeedsBigProcessLock::Yes)              \
+    S(utime, NeedsBigProcessLock::Yes)              \
+    S(sync, NeedsBigProcessLock::Yes)               \
+    S(ptsname, NeedsBigProcessLock::Yes)            \
+    S(select, NeedsBigProcessLock::Yes)             \
+    S(unlink, NeedsBigProcessLock::Yes)             \
+    S(poll, NeedsBigProcessLock::Yes)               \
+    S(rmdir, NeedsBigProcessLock::Yes)              \
+    S(chmod, NeedsBigProcessLock::Yes)              \
+    S(usleep, NeedsBigProcessLock::No)              \
+    S(socket, NeedsBigProcessLock::Yes)             \
+    S(bind, NeedsBigProcessLock::Yes)               \
+    S(accept, NeedsBigProcessLock::Yes)             \
+    S(listen, NeedsBigProcessLock::Yes)             \
+    S(connect, NeedsBigProcessLock::Yes)            \
+    S(shbuf_create, NeedsBigProcessLock::Yes)       \
+    S(shbuf_allow_pid, NeedsBigProcessLock::Yes)    \
+    S(shbuf_get, NeedsBigProcessLock::Yes)          \
+    S(shbuf_release, NeedsBigProcessLock::Yes)      \
+    S(link, NeedsBigProcessLock::Yes)               \
+    S(chown, NeedsBigProcessLock::Yes)              \
+    S(fchmod, NeedsBigProcessLock::Yes)             \
+    S(symlink, NeedsBigProcessLock::Yes)            \
+    S(shbuf_seal, NeedsBigProcessLock::Yes)         \
+    S(sendto, NeedsBigProcessLock::Yes)             \
+    S(recvfrom, NeedsBigProcessLock::Yes)           \
+    S(getsockopt, NeedsBigProcessLock::Yes)         \
+    S(setsockopt, NeedsBigProcessLock::Yes)         \
+    S(create_thread, NeedsBigProcessLock::Yes)      \
+    S(gettid, NeedsBigProcessLock::No)              \
+    S(donate, NeedsBigProcessLock::Yes)             \
+    S(rename, NeedsBigProcessLock::Yes)             \
+    S(ftruncate, NeedsBigProcessLock::Yes)          \
+    S(exit_thread, NeedsBigProcessLock::Yes)        \
+    S(mknod, NeedsBigProcessLock::Yes)              \
+    S(writev, NeedsBigProcessLock::No)              \
+    S(beep, NeedsBigProcessLock::Yes)               \
+    S(getsockname, NeedsBigProcessLock::Yes)        \
+    S(getpeername, NeedsBigProcessLock::Yes)        \
+    S(sched_setparam, NeedsBigProcessLock::Yes)     \
+    S(sched_getparam, NeedsBigProcessLock::Yes)     \
+    S(fchown, NeedsBigProcessLock::Yes)             \
+    S(halt, NeedsBigProcessLock::Yes)               \
+    S(reboot, NeedsBigProcessLock::Yes)             \
+    S(mount, NeedsBigProcessLock::Yes)              \
+    S(umount, NeedsBigProcessLock::Yes)             \
+    S(dump_backtrace, NeedsBigProcessLock::Yes)     \
+    S(dbgputch, NeedsBigProcessLock::No)            \
+    S(dbgputstr, NeedsBigProcessLock::No)           \
+    S(watch_file, NeedsBigProcessLock::Yes)         \
+    S(shbuf_allow_all, NeedsBigProcessLock::Yes)    \
+    S(set_process_icon, NeedsBigProcessLock::Yes)   \
+    S(mprotect, NeedsBigProcessLock::No)            \
+    S(realpath, NeedsBigProcessLock::No)            \
+    S(get_process_name, NeedsBigProcessLock::Yes)   \
+    S(fchdir, NeedsBigProcessLock::No)              \
+    S(getrandom, NeedsBigProcessLock::No)           \
+    S(setkeymap, NeedsBigProcessLock::Yes)          \
+    S(clock_gettime, NeedsBigProcessLock::No)       \
+    S(clock_settime, NeedsBigProcessLock::Yes)      \
+    S(clock_nanosleep, NeedsBigProcessLock::No)     \
+    S(join_thread, NeedsBigProcessLock::Yes)        \
+    S(module_load, NeedsBigProcessLock::Yes)        \
+    S(module_unload, NeedsBigProcessLock::Yes)      \
+    S(detach_thread, NeedsBigProcessLock::Yes)      \
+    S(set_thread_name, NeedsBigProcessLock::Yes)    \
+    S(get_thread_name, NeedsBigProcessLock::Yes)    \
+    S(madvise, NeedsBigProcessLock::No)             \
+    S(purge, NeedsBigProcessLock::Yes)              \
+    S(shbuf_set_volatile, NeedsBigProcessLock::Yes) \
+    S(profiling_enable, NeedsBigProcessLock::Yes)   \
+    S(profiling_disable, NeedsBigProcessLock::Yes)  \
+    S(futex, NeedsBigProcessLock::Yes)              \
+    S(set_thread_boost, NeedsBigProcessLock::Yes)   \
+    S(set_process_boost, NeedsBigProcessLock::Yes)  \
+    S(chroot, NeedsBigProcessLock::Yes)             \
+    S(pledge, NeedsBigProcessLock::Yes)             \
+    S(unveil, NeedsBigProcessLock::Yes)             \
+    S(perf_event, NeedsBigProcessLock::Yes)         \
+    S(shutdown, NeedsBigProcessLock::Yes)           \
+    S(get_stack_bounds, NeedsBigProcessLock::No)    \
+    S(ptrace, NeedsBigProcessLock::Yes)             \
+    S(minherit, NeedsBigProcessLock::No)            \
+    S(sendfd, NeedsBigProcessLock::Yes)             \
+    S(recvfd, NeedsBigProcessLock::Yes)             \
+    S(sysconf, NeedsBigProcessLock::Yes)            \
+    S(set_process_name, NeedsBigProcessLock::Yes)   \
+    S(disown, NeedsBigProcessLock::Yes)             \
+    S(msync, NeedsBigProcessLock::No)               \
+    S(posix_spawn, NeedsBigProcessLock::Yes)        \
+    S(epoll_create, NeedsBigProcessLock::No)        \
+    S(epoll_ctl, NeedsBigProcessLock::No)           \
+    S(epoll_wait, NeedsBigProcessLock::Yes)         \
+    S(readv, NeedsBigProcessLock::No)               \
+    S(pread, NeedsBigProcessLock::No)               \
+    S(pwrite, NeedsBigProcessLock::No)              \
+    S(preadv, NeedsBigProcessLock::No)              \
+    S(pwritev, NeedsBigProcessLock::No)             \
+    S(sendfile, NeedsBigProcessLock::No)            \
+    S(io_ring_setup, NeedsBigProcessLock::No)       \
+    S(io_ring_enter, NeedsBigProcessLock::Yes)      \
+    S(perf_event_stream, NeedsBigProcessLock::No)   \
+    S(perf_counter_sampling, NeedsBigProcessLock::No) \
+    S(perf_off_cpu_tracing, NeedsBigProcessLock::No) \
+    S(perf_syscall_tracing, NeedsBigProcessLock::No)
 
 namespace Syscall {
 
 enum Function {
 #undef __ENUMERATE_SYSCALL
-#define __ENUMERATE_SYSCALL(x) SC_##x,
+#define __ENUMERATE_SYSCALL(x, needs_lock) SC_##x,
     ENUMERATE_SYSCALLS(__ENUMERATE_SYSCALL)
 #undef __ENUMERATE_SYSCALL
         __Count
@@ -211,8 +238,8 @@ inline constexpr const char* to_string(Function function)
 {
     switch (function) {
 #undef __ENUMERATE_SYSCALL
-#define __ENUMERATE_SYSCALL(x) \
-    case SC_##x:               \
+#define __ENUMERATE_SYSCALL(x, needs_lock) \
+    case SC_##x:                           \
         return #x;
         ENUMERATE_SYSCALLS(__ENUMERATE_SYSCALL)
 #undef __ENUMERATE_SYSCALL
@@ -279,6 +306,49 @@ struct SC_poll_params {
     Userspace<const u32*> sigmask;
 };
 
+struct SC_pread_params {
+    int fd;
+    Userspace<u8*> buffer;
+    ssize_t size;
+    ssize_t offset;
+};
+
+struct SC_pwrite_params {
+    int fd;
+    Userspace<const u8*> data;
+    ssize_t size;
+    ssize_t offset;
+};
+
+struct SC_preadv_params {
+    int fd;
+    Userspace<const struct iovec*> iov;
+    int iov_count;
+    ssize_t offset;
+};
+
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    Userspace<ssize_t*> offset;
+    ssize_t count;
+};
+
+struct SC_epoll_ctl_params {
+    int epoll_fd;
+    int op;
+    int fd;
+    Userspace<const struct epoll_event*> event;
+};
+
+struct SC_epoll_wait_params {
+    int epoll_fd;
+    Userspace<struct epoll_event*> events;
+    int max_events;
+    Userspace<const struct timespec*> timeout;
+    Userspace<const u32*> sigmask;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -335,6 +405,9 @@ struct SC_futex_params {
     int futex_op;
     i32 val;
     Userspace<const timespec*> timeout;
+    u32 val2;
+    Userspace<const i32*> userspace_address2;
+    i32 val3;
 };
 
 struct SC_setkeymap_params {
@@ -376,6 +449,31 @@ struct SC_execve_params {
     StringListArgument environment;
 };
 
+enum class SpawnFileActionType {
+    Close,
+    Dup2,
+    Open,
+    Chdir,
+    Fchdir,
+};
+
+struct SC_posix_spawn_file_action {
+    SpawnFileActionType type;
+    int fd;
+    int new_fd;
+    int options;
+    u16 mode;
+    StringArgument path;
+};
+
+struct SC_posix_spawn_params {
+    StringArgument path;
+    StringListArgument arguments;
+    StringListArgument environment;
+    Userspace<const SC_posix_spawn_file_action*> file_actions;
+    size_t file_action_count { 0 };
+};
+
 struct SC_readlink_params {
     StringArgument path;
     MutableBufferArgument<char, size_t> buffer;
@@ -500,7 +598,7 @@ inline u32 invoke(Function function, T1 arg1, T2 arg2, T3 arg3)
 }
 
 #undef __ENUMERATE_SYSCALL
-#define __ENUMERATE_SYSCALL(x) using Syscall::SC_##x;
+#define __ENUMERATE_SYSCALL(x, needs_lock) using Syscall::SC_##x;
 ENUMERATE_SYSCALLS(__ENUMERATE_SYSCALL)
 #undef __ENUMERATE_SYSCALL
 #define syscall Syscall::invoke
@@ -206,9 +206,8 @@ void general_protection_fault_handler(TrapFrame* trap)
 EH_ENTRY_NO_CODE(7, fpu_exception);
 void fpu_exception_handler(TrapFrame*)
 {
-    // Just clear the TS flag. We've already restored the FPU state eagerly.
-    // FIXME: It would be nice if we didn't have to do this at all.
-    asm volatile("clts");
+    // The current thread touched the FPU for the first time since it was scheduled in, see enter_thread_context().
+    Processor::current().restore_fpu_state_of_current_thread();
 }
 
 // 14: Page Fault
@@ -711,6 +710,12 @@ u32 read_cr0()
     return cr0;
 }
 
+void write_cr0(u32 cr0)
+{
+    asm volatile("movl %%eax, %%cr0" ::"a"(cr0)
+                 : "memory");
+}
+
 u32 read_cr3()
 {
     u32 cr3;
@@ -721,6 +726,9 @@ u32 read_cr3()
 
 void write_cr3(u32 cr3)
 {
+    // Publish the new address space before switching to it, see Processor::smp_broadcast_flush_tlb().
+    if (Processor::is_initialized())
+        Processor::current().set_active_cr3(cr3);
     asm volatile("movl %%eax, %%cr3" ::"a"(cr3)
                  : "memory");
 }
@@ -948,8 +956,10 @@ void Processor::early_initialize(u32 cpu)
     m_scheduler_initialized = false;
 
     m_message_queue = nullptr;
+    m_active_cr3 = 0;
     m_idle_thread = nullptr;
     m_current_thread = nullptr;
+    m_fpu_owner = nullptr;
     m_scheduler_data = nullptr;
     m_mm_data = nullptr;
     m_info = nullptr;
@@ -1095,8 +1105,7 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
 
     auto& from_tss = from_thread->tss();
     auto& to_tss = to_thread->tss();
-    asm volatile("fxsave %0"
-        : "=m"(from_thread->fpu_state()));
+    processor.switch_fpu_state(*from_thread, *to_thread);
 
     from_tss.fs = get_fs();
     from_tss.gs = get_gs();
@@ -1112,13 +1121,63 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
 
     to_thread->set_cpu(processor.id());
 
-    asm volatile("fxrstor %0"
-        ::"m"(to_thread->fpu_state()));
-
     // TODO: debug registers
     // TODO: ioperm?
 }
 
+void Processor::switch_fpu_state(Thread& from_thread, Thread& to_thread)
+{
+    // The FPU state is switched lazily, since most threads rarely (if ever) touch it. CR0.TS is set
+    // whenever a thread is scheduled in, so its first FPU instruction traps into fpu_exception_handler(),
+    // which loads the thread's state. If CR0.TS is still set when the thread is scheduled out, it
+    // never used the FPU and there's nothing to save either.
+    u32 cr0 = read_cr0();
+    if (!(cr0 & CR0_TS)) {
+        asm volatile("fxsave %0"
+            : "=m"(from_thread.fpu_state()));
+        m_fpu_owner = &from_thread;
+        from_thread.did_save_fpu_state(m_cpu);
+    }
+
+    // If nobody else used the FPU on this processor since the thread last did, its state is still there.
+    if (has_fpu_state_of(to_thread))
+        cr0 &= ~CR0_TS;
+    else
+        cr0 |= CR0_TS;
+    write_cr0(cr0);
+}
+
+bool Processor::has_fpu_state_of(const Thread& thread) const
+{
+    // The thread could have been running on another processor since we saved its state, or
+    // m_fpu_owner could be a thread that died and whose memory is now used by a different thread.
+    // Either way, the thread's FPU state was last loaded (or saved) somewhere else.
+    return m_fpu_owner == &thread && thread.fpu_cpu() == m_cpu;
+}
+
+void Processor::restore_fpu_state_of_current_thread()
+{
+    auto* thread = current_thread();
+    ASSERT(thread);
+    asm volatile("clts");
+    asm volatile("fxrstor %0" ::"m"(thread->fpu_state()));
+    m_fpu_owner = thread;
+    thread->did_restore_fpu_state(m_cpu);
+}
+
+void Processor::save_fpu_state_of_current_thread()
+{
+    ScopedCritical critical;
+    if (read_cr0() & CR0_TS)
+        return;
+    auto* thread = current_thread();
+    ASSERT(thread);
+    asm volatile("fxsave %0"
+        : "=m"(thread->fpu_state()));
+    m_fpu_owner = thread;
+    thread->did_save_fpu_state(m_cpu);
+}
+
 #define ENTER_THREAD_CONTEXT_ARGS_SIZE (2 * 4) //  to_thread, from_thread
 
 void Processor::switch_context(Thread*& from_thread, Thread*& to_thread)
@@ -1437,8 +1496,16 @@ void Processor::check_invoke_scheduler()
     }
 }
 
+// Past this many pages it's cheaper to drop the whole TLB than to invalidate page by page.
+static constexpr size_t max_pages_to_flush_individually = 64;
+
 void Processor::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 {
+    // Reloading cr3 doesn't flush global (kernel) entries, so only do that for userspace ranges.
+    if (page_count > max_pages_to_flush_individually && vaddr.offset(page_count * PAGE_SIZE).get() <= 0xc0000000) {
+        flush_entire_tlb_local();
+        return;
+    }
     auto ptr = vaddr.as_ptr();
     while (page_count > 0) {
         asm volatile("invlpg %0"
@@ -1450,11 +1517,11 @@ void Processor::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
     }
 }
 
-void Processor::flush_tlb(VirtualAddress vaddr, size_t page_count)
+void Processor::flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
     flush_tlb_local(vaddr, page_count);
     if (s_smp_enabled)
-        smp_broadcast_flush_tlb(vaddr, page_count);
+        smp_broadcast_flush_tlb(page_directory, vaddr, page_count);
 }
 
 static volatile ProcessorMessage* s_message_pool;
@@ -1571,7 +1638,9 @@ bool Processor::smp_process_pending_messages()
                     msg->callback_with_data.handler(msg->callback_with_data.data);
                     break;
                 case ProcessorMessage::FlushTlb:
-                    flush_tlb_local(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count);
+                    // We may have switched address spaces since the message was sent, in which case the TLB is clean already.
+                    if (!msg->flush_tlb.cr3 || msg->flush_tlb.cr3 == read_cr3())
+                        flush_tlb_local(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count);
                     break;
             }
 
@@ -1636,16 +1705,52 @@ void Processor::smp_broadcast_message(ProcessorMessage& msg, bool async)
     // Now trigger an IPI on all other APs
     APIC::the().broadcast_ipi();
 
-    if (!async) {
-        // If synchronous then we must cleanup and return the message back
-        // to the pool. Otherwise, the last processor to complete it will return it
-        while (atomic_load(&msg.refs, AK::MemoryOrder::memory_order_consume) != 0) {
-            // TODO: pause for a bit?
+    if (!async)
+        smp_wait_for_message(msg);
+}
+
+void Processor::smp_multicast_message(ProcessorMessage& msg, u32 target_mask, bool async)
+{
+    auto& cur_proc = Processor::current();
+    ASSERT(!(target_mask & (1u << cur_proc.id())));
+    msg.async = async;
+#ifdef SMP_DEBUG
+    dbg() << "SMP[" << cur_proc.id() << "]: Multicast message " << VirtualAddress(&msg) << " to cpu mask " << String::format("%x", target_mask);
+#endif
+    atomic_store(&msg.refs, (u32)__builtin_popcount(target_mask), AK::MemoryOrder::memory_order_release);
+    ASSERT(msg.refs > 0);
+    bool all_others = msg.refs == count() - 1;
+    for_each(
+        [&](Processor& proc) -> IterationDecision
+        {
+            if (target_mask & (1u << proc.id()))
+                proc.smp_queue_message(msg);
+            return IterationDecision::Continue;
+        });
+
+    if (all_others) {
+        APIC::the().broadcast_ipi();
+    } else {
+        for (u32 cpu = 0; cpu < 32; ++cpu) {
+            if (target_mask & (1u << cpu))
+                APIC::the().send_ipi(cpu);
         }
+    }
+
+    if (!async)
+        smp_wait_for_message(msg);
+}
 
-        smp_cleanup_message(msg);
-        smp_return_to_pool(msg);
+void Processor::smp_wait_for_message(ProcessorMessage& msg)
+{
+    // If synchronous then we must cleanup and return the message back
+    // to the pool. Otherwise, the last processor to complete it will return it
+    while (atomic_load(&msg.refs, AK::MemoryOrder::memory_order_consume) != 0) {
+        // TODO: pause for a bit?
     }
+
+    smp_cleanup_message(msg);
+    smp_return_to_pool(msg);
 }
 
 void Processor::smp_broadcast(void (*callback)(void*), void* data, void (*free_data)(void*), bool async)
@@ -1666,13 +1771,39 @@ void Processor::smp_broadcast(void (*callback)(), bool async)
     smp_broadcast_message(msg, async);
 }
 
-void Processor::smp_broadcast_flush_tlb(VirtualAddress vaddr, size_t page_count)
+void Processor::smp_broadcast_flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
+    // Kernel mappings are shared by every address space, but userspace mappings only
+    // need flushing on the processors that currently have that page directory loaded.
+    u32 cr3 = 0;
+    if (page_directory && vaddr.get() < 0xc0000000)
+        cr3 = page_directory->cr3();
+
+    // Make sure our page table updates are visible before we look at which address
+    // spaces the others are in. Anyone switching to this one after that finds them.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    auto& cur_proc = Processor::current();
+    u32 target_mask = 0;
+    for_each(
+        [&](Processor& proc) -> IterationDecision
+        {
+            if (&proc == &cur_proc)
+                return IterationDecision::Continue;
+            u32 active_cr3 = atomic_load(&proc.m_active_cr3, AK::MemoryOrder::memory_order_acquire);
+            if (!cr3 || !active_cr3 || active_cr3 == cr3)
+                target_mask |= 1u << proc.id();
+            return IterationDecision::Continue;
+        });
+    if (!target_mask)
+        return;
+
     auto& msg = smp_get_from_pool();
     msg.type = ProcessorMessage::FlushTlb;
     msg.flush_tlb.ptr = vaddr.as_ptr();
     msg.flush_tlb.page_count = page_count;
-    smp_broadcast_message(msg, false);
+    msg.flush_tlb.cr3 = cr3;
+    smp_multicast_message(msg, target_mask, false);
 }
 
 void Processor::smp_broadcast_halt()
@@ -209,6 +209,7 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Accessed = 1 << 5,
         Global = 1 << 8,
         NoExecute = 0x8000000000000000ULL,
     };
@@ -216,6 +217,10 @@ public:
     bool is_present() const { return raw() & Present; }
     void set_present(bool b) { set_bit(Present, b); }
 
+    // Set by the CPU whenever the page is used for a translation.
+    bool is_accessed() const { return raw() & Accessed; }
+    void set_accessed(bool b) { set_bit(Accessed, b); }
+
     bool is_user_allowed() const { return raw() & UserSupervisor; }
     void set_user_allowed(bool b) { set_bit(UserSupervisor, b); }
 
@@ -513,7 +518,10 @@ inline FlatPtr offset_in_page(const void* address)
     return offset_in_page((FlatPtr)address);
 }
 
+#define CR0_TS (1 << 3)
+
 u32 read_cr0();
+void write_cr0(u32);
 u32 read_cr3();
 void write_cr3(u32);
 u32 read_cr4();
@@ -648,6 +656,7 @@ struct ProcessorMessage {
         struct {
             u8* ptr;
             size_t page_count;
+            u32 cr3; // 0 if the range is mapped in every address space
         } flush_tlb;
     };
 
@@ -687,8 +696,10 @@ class Processor {
     SchedulerPerProcessorData* m_scheduler_data;
     Thread* m_current_thread;
     Thread* m_idle_thread;
+    Thread* m_fpu_owner; // Whose FPU state was last loaded into (or saved from) our registers, never dereferenced
 
     volatile ProcessorMessageEntry* m_message_queue; // atomic, LIFO
+    volatile u32 m_active_cr3; // atomic, 0 if unknown
 
     bool m_invoke_scheduler_async;
     bool m_scheduler_initialized;
@@ -704,6 +715,8 @@ class Processor {
     static void smp_cleanup_message(ProcessorMessage& msg);
     bool smp_queue_message(ProcessorMessage& msg);
     static void smp_broadcast_message(ProcessorMessage& msg, bool async);
+    static void smp_multicast_message(ProcessorMessage& msg, u32 target_mask, bool async);
+    static void smp_wait_for_message(ProcessorMessage& msg);
     static void smp_broadcast_halt();
 
     void cpu_detect();
@@ -727,7 +740,7 @@ public:
     ALWAYS_INLINE static void wait_check()
     {
         Processor::current().smp_process_pending_messages();
-        // TODO: pause
+        asm volatile("pause");
     }
 
     [[noreturn]] static void halt();
@@ -738,7 +751,14 @@ public:
     }
 
     static void flush_tlb_local(VirtualAddress vaddr, size_t page_count);
-    static void flush_tlb(VirtualAddress vaddr, size_t page_count);
+    static void flush_tlb(const PageDirectory*, VirtualAddress vaddr, size_t page_count);
+
+    // Called whenever this processor loads a new page directory, so TLB shootdowns
+    // for other address spaces can skip it.
+    ALWAYS_INLINE void set_active_cr3(u32 cr3)
+    {
+        atomic_store(&m_active_cr3, cr3, AK::MemoryOrder::memory_order_release);
+    }
 
     Descriptor& get_gdt_entry(u16 selector);
     void flush_gdt();
@@ -884,6 +904,11 @@ public:
         return s_clean_fpu_state;
     }
 
+    void switch_fpu_state(Thread& from_thread, Thread& to_thread);
+    bool has_fpu_state_of(const Thread&) const;
+    void restore_fpu_state_of_current_thread();
+    void save_fpu_state_of_current_thread();
+
     static void smp_enable();
     bool smp_process_pending_messages();
 
@@ -903,7 +928,7 @@ public:
     }
     static void smp_broadcast(void (*callback)(), bool async);
     static void smp_broadcast(void (*callback)(void*), void* data, void (*free_data)(void*), bool async);
-    static void smp_broadcast_flush_tlb(VirtualAddress vaddr, size_t page_count);
+    static void smp_broadcast_flush_tlb(const PageDirectory*, VirtualAddress vaddr, size_t page_count);
 
     ALWAYS_INLINE bool has_feature(CPUFeature f) const
     {
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//#define AHCI_DEBUG
+
+#include <AK/StringView.h>
+#include <Kernel/Devices/AHCIController.h>
+#include <Kernel/Devices/AHCIDiskDevice.h>
+#include <Kernel/IO.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+#define PCI_Mass_Storage_Class 0x1
+#define PCI_SATA_Controller_Subclass 0x6
+#define PCI_AHCI_Programming_Interface 0x1
+
+#define AHCI_CAP_NCS(cap) ((((cap) >> 8) & 0x1f) + 1)
+#define AHCI_CAP_SNCQ (1u << 30)
+#define AHCI_CAP_S64A (1u << 31)
+
+#define AHCI_GHC_HR (1u << 0)
+#define AHCI_GHC_IE (1u << 1)
+#define AHCI_GHC_AE (1u << 31)
+
+#define AHCI_SSTS_DET_PRESENT 0x3
+#define AHCI_SSTS_IPM_ACTIVE 0x1
+#define AHCI_SIG_ATA 0x00000101
+
+OwnPtr<AHCIController> AHCIController::detect()
+{
+    PCI::Address pci_address;
+    PCI::enumerate([&](const PCI::Address& address, PCI::ID id) {
+        if (!pci_address.is_null())
+            return;
+        if (PCI::get_class(address) == PCI_Mass_Storage_Class
+            && PCI::get_subclass(address) == PCI_SATA_Controller_Subclass
+            && PCI::get_programming_interface(address) == PCI_AHCI_Programming_Interface) {
+            pci_address = address;
+            klog() << "AHCIController: AHCI Controller found, ID " << id;
+        }
+    });
+    if (pci_address.is_null())
+        return nullptr;
+    return make<AHCIController>(pci_address);
+}
+
+AHCIController::AHCIController(PCI::Address address)
+    : PCI::Device(address, PCI::get_interrupt_line(address))
+{
+    disable_irq();
+
+    PCI::enable_bus_mastering(pci_address());
+    PCI::enable_interrupt_line(pci_address());
+
+    size_t hba_size = PCI::get_BAR_space_size(pci_address(), 5);
+    if (hba_size < sizeof(AHCI::HBARegisters))
+        hba_size = sizeof(AHCI::HBARegisters);
+    PhysicalAddress hba_base(PCI::get_BAR5(pci_address()) & 0xfffffff0);
+    m_hba_region = MM.allocate_kernel_region(hba_base.page_base(), PAGE_ROUND_UP(hba_base.offset_in_page() + hba_size), "AHCI ABAR", Region::Access::Read | Region::Access::Write, false, false);
+    ASSERT(m_hba_region);
+    m_hba_base = m_hba_region->vaddr().offset(hba_base.offset_in_page());
+
+    reset();
+
+    u32 cap = hba().cap;
+    m_command_slots = AHCI_CAP_NCS(cap);
+    m_supports_ncq = cap & AHCI_CAP_SNCQ;
+    klog() << "AHCIController: ABAR " << hba_base << ", version " << String::format("%x", hba().vs) << ", " << m_command_slots << " command slots, NCQ " << (m_supports_ncq ? "supported" : "not supported");
+    if (!(cap & AHCI_CAP_S64A))
+        klog() << "AHCIController: HBA can't do 64-bit DMA, relying on physical memory below 4 GiB";
+
+    detect_disks();
+
+    hba().is = 0xffffffff;
+    hba().ghc = hba().ghc | AHCI_GHC_IE;
+    enable_irq();
+}
+
+AHCIController::~AHCIController()
+{
+}
+
+void AHCIController::reset()
+{
+    hba().ghc = hba().ghc | AHCI_GHC_AE;
+    hba().ghc = hba().ghc | AHCI_GHC_HR;
+    // The HBA clears HR once the reset is done, which the spec bounds at one second.
+    for (size_t i = 0; i < 1000 && (hba().ghc & AHCI_GHC_HR); ++i)
+        IO::delay(1000);
+    if (hba().ghc & AHCI_GHC_HR)
+        klog() << "AHCIController: HBA did not come out of reset";
+    // AE may have been cleared by the reset.
+    hba().ghc = AHCI_GHC_AE;
+}
+
+void AHCIController::detect_disks()
+{
+    u32 ports_implemented = hba().pi;
+    for (u8 i = 0; i < 32; ++i) {
+        if (!(ports_implemented & (1u << i)))
+            continue;
+        auto& port = hba().ports[i];
+        u32 ssts = port.ssts;
+        if ((ssts & 0xf) != AHCI_SSTS_DET_PRESENT || ((ssts >> 8) & 0xf) != AHCI_SSTS_IPM_ACTIVE) {
+#ifdef AHCI_DEBUG
+            klog() << "AHCIController: No device on port " << i;
+#endif
+            continue;
+        }
+        if (port.sig != AHCI_SIG_ATA) {
+            klog() << "AHCIController: Ignoring non-ATA device on port " << i << " (signature " << String::format("%x", port.sig) << ")";
+            continue;
+        }
+        auto disk = AHCIDiskDevice::create(*this, i, 8, m_disks.size());
+        if (!disk)
+            continue;
+        m_ports[i] = disk.ptr();
+        m_disks.append(disk.release_nonnull());
+    }
+}
+
+void AHCIController::handle_irq(const RegisterState&)
+{
+    u32 pending = hba().is;
+    if (!pending) {
+#ifdef AHCI_DEBUG
+        klog() << "AHCIController: ignore interrupt";
+#endif
+        return;
+    }
+    for (u32 ports = pending; ports; ports &= ports - 1) {
+        auto port_index = __builtin_ctz(ports);
+        if (m_ports[port_index])
+            m_ports[port_index]->handle_interrupt();
+        else
+            hba().ports[port_index].is = 0xffffffff;
+    }
+    // Port interrupt status has to be cleared before the global one, or the HBA will immediately raise it again.
+    hba().is = pending;
+}
+
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// Advanced Host Controller Interface (AHCI) driver
+//
+// An AHCI controller exposes up to 32 SATA ports through a single memory
+// mapped register block (ABAR). Every port has its own command list with up to
+// 32 command slots, so a disk can have many commands in flight at once. With
+// Native Command Queuing (NCQ) the drive is free to reorder them.
+//
+// More information about the AHCI spec can be found here:
+//      https://www.intel.com/content/dam/www/public/us/en/documents/technical-specifications/serial-ata-ahci-spec-rev1-3-1.pdf
+//
+
+#pragma once
+
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <Kernel/PCI/Access.h>
+#include <Kernel/PCI/Device.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+namespace AHCI {
+
+struct PortRegisters {
+    u32 clb;
+    u32 clbu;
+    u32 fb;
+    u32 fbu;
+    u32 is;
+    u32 ie;
+    u32 cmd;
+    u32 reserved0;
+    u32 tfd;
+    u32 sig;
+    u32 ssts;
+    u32 sctl;
+    u32 serr;
+    u32 sact;
+    u32 ci;
+    u32 sntf;
+    u32 fbs;
+    u32 reserved1[11];
+    u32 vendor[4];
+};
+static_assert(sizeof(PortRegisters) == 0x80);
+
+struct HBARegisters {
+    u32 cap;
+    u32 ghc;
+    u32 is;
+    u32 pi;
+    u32 vs;
+    u32 ccc_ctl;
+    u32 ccc_ports;
+    u32 em_loc;
+    u32 em_ctl;
+    u32 cap2;
+    u32 bohc;
+    u8 reserved[0xa0 - 0x2c];
+    u8 vendor[0x100 - 0xa0];
+    PortRegisters ports[32];
+};
+static_assert(sizeof(HBARegisters) == 0x1100);
+
+struct CommandHeader {
+    u16 attributes;
+    u16 prdt_length;
+    u32 prd_byte_count;
+    u32 command_table_base;
+    u32 command_table_base_upper;
+    u32 reserved[4];
+};
+static_assert(sizeof(CommandHeader) == 32);
+
+struct PhysicalRegionDescriptor {
+    u32 base;
+    u32 base_upper;
+    u32 reserved;
+    u32 byte_count_and_flags;
+};
+
+// Each command can scatter its data over this many pages.
+static constexpr size_t prdt_entries_per_command = 8;
+static constexpr size_t max_bytes_per_command = prdt_entries_per_command * PAGE_SIZE;
+
+struct CommandTable {
+    u8 command_fis[64];
+    u8 atapi_command[16];
+    u8 reserved[48];
+    PhysicalRegionDescriptor descriptors[prdt_entries_per_command];
+};
+static_assert(sizeof(CommandTable) % 128 == 0);
+
+struct RegisterHostToDeviceFIS {
+    u8 fis_type;
+    u8 flags;
+    u8 command;
+    u8 feature_low;
+    u8 lba0;
+    u8 lba1;
+    u8 lba2;
+    u8 device;
+    u8 lba3;
+    u8 lba4;
+    u8 lba5;
+    u8 feature_high;
+    u8 count_low;
+    u8 count_high;
+    u8 icc;
+    u8 control;
+    u32 reserved;
+};
+static_assert(sizeof(RegisterHostToDeviceFIS) == 20);
+
+}
+
+class AHCIDiskDevice;
+class AHCIController final : public PCI::Device {
+    friend class AHCIDiskDevice;
+    AK_MAKE_ETERNAL
+public:
+    static OwnPtr<AHCIController> detect();
+    explicit AHCIController(PCI::Address);
+    virtual ~AHCIController() override;
+
+    const NonnullRefPtrVector<AHCIDiskDevice>& disks() const { return m_disks; }
+
+    virtual const char* purpose() const override { return "AHCI Controller"; }
+
+private:
+    //^ IRQHandler
+    virtual void handle_irq(const RegisterState&) override;
+
+    void reset();
+    void detect_disks();
+
+    volatile AHCI::HBARegisters& hba() { return *reinterpret_cast<volatile AHCI::HBARegisters*>(m_hba_base.as_ptr()); }
+
+    OwnPtr<Region> m_hba_region;
+    VirtualAddress m_hba_base;
+    u32 m_command_slots { 1 };
+    bool m_supports_ncq { false };
+
+    AHCIDiskDevice* m_ports[32] {};
+    NonnullRefPtrVector<AHCIDiskDevice> m_disks;
+};
+
+}
@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//#define AHCI_DEVICE_DEBUG
+
+#include <AK/Memory.h>
+#include <AK/StringView.h>
+#include <Kernel/Devices/AHCIDiskDevice.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/IO.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+#define ATA_CMD_READ_DMA 0xC8
+#define ATA_CMD_READ_DMA_EXT 0x25
+#define ATA_CMD_WRITE_DMA 0xCA
+#define ATA_CMD_WRITE_DMA_EXT 0x35
+#define ATA_CMD_READ_FPDMA_QUEUED 0x60
+#define ATA_CMD_WRITE_FPDMA_QUEUED 0x61
+#define ATA_CMD_IDENTIFY 0xEC
+
+#define ATA_SR_BSY 0x80
+#define ATA_SR_DRQ 0x08
+#define ATA_SR_ERR 0x01
+
+#define FIS_TYPE_REG_H2D 0x27
+#define FIS_H2D_COMMAND (1 << 7)
+
+#define AHCI_PORT_CMD_ST (1u << 0)
+#define AHCI_PORT_CMD_FRE (1u << 4)
+#define AHCI_PORT_CMD_FR (1u << 14)
+#define AHCI_PORT_CMD_CR (1u << 15)
+
+#define AHCI_PORT_IS_DHRS (1u << 0)
+#define AHCI_PORT_IS_PSS (1u << 1)
+#define AHCI_PORT_IS_SDBS (1u << 3)
+#define AHCI_PORT_IS_DPS (1u << 5)
+#define AHCI_PORT_IS_IFS (1u << 27)
+#define AHCI_PORT_IS_HBDS (1u << 28)
+#define AHCI_PORT_IS_HBFS (1u << 29)
+#define AHCI_PORT_IS_TFES (1u << 30)
+#define AHCI_PORT_IS_ERROR (AHCI_PORT_IS_IFS | AHCI_PORT_IS_HBDS | AHCI_PORT_IS_HBFS | AHCI_PORT_IS_TFES)
+
+#define AHCI_COMMAND_HEADER_WRITE (1 << 6)
+
+static constexpr size_t sectors_per_command = AHCI::max_bytes_per_command / 512;
+
+static bool wait_until_clear(volatile u32& reg, u32 mask, size_t milliseconds)
+{
+    for (size_t i = 0; i < milliseconds && (reg & mask); ++i)
+        IO::delay(1000);
+    return !(reg & mask);
+}
+
+static u32 slot_mask(u32 slots)
+{
+    return slots >= 32 ? 0xffffffff : (1u << slots) - 1;
+}
+
+RefPtr<AHCIDiskDevice> AHCIDiskDevice::create(AHCIController& controller, u8 port_index, int major, int minor)
+{
+    auto device = adopt(*new AHCIDiskDevice(controller, port_index, major, minor));
+    if (!device->initialize())
+        return nullptr;
+    return device;
+}
+
+AHCIDiskDevice::AHCIDiskDevice(AHCIController& controller, u8 port_index, int major, int minor)
+    : BlockDevice(major, minor, 512)
+    , m_controller(controller)
+    , m_port_index(port_index)
+    , m_command_slots(controller.m_command_slots)
+{
+}
+
+AHCIDiskDevice::~AHCIDiskDevice()
+{
+}
+
+const char* AHCIDiskDevice::class_name() const
+{
+    return "AHCIDiskDevice";
+}
+
+bool AHCIDiskDevice::initialize()
+{
+    m_command_list_region = MM.allocate_contiguous_kernel_region(PAGE_SIZE, "AHCI Command List", Region::Access::Read | Region::Access::Write);
+    m_command_tables_region = MM.allocate_contiguous_kernel_region(PAGE_ROUND_UP(sizeof(AHCI::CommandTable) * m_command_slots), "AHCI Command Tables", Region::Access::Read | Region::Access::Write);
+    m_dma_buffers_region = MM.allocate_kernel_region(AHCI::max_bytes_per_command * m_command_slots, "AHCI DMA Buffers", Region::Access::Read | Region::Access::Write, false, true);
+    if (!m_command_list_region || !m_command_tables_region || !m_dma_buffers_region) {
+        klog() << "AHCIDiskDevice: Port " << m_port_index << ": couldn't allocate DMA memory";
+        return false;
+    }
+
+    stop();
+
+    memset(m_command_list_region->vaddr().as_ptr(), 0, PAGE_SIZE);
+    memset(m_command_tables_region->vaddr().as_ptr(), 0, m_command_tables_region->size());
+
+    auto command_list = m_command_list_region->physical_page(0)->paddr();
+    auto command_tables = m_command_tables_region->physical_page(0)->paddr();
+    size_t pages_per_command = AHCI::max_bytes_per_command / PAGE_SIZE;
+    for (u32 slot = 0; slot < m_command_slots; ++slot) {
+        command_header(slot).command_table_base = command_tables.offset(slot * sizeof(AHCI::CommandTable)).get();
+        command_header(slot).command_table_base_upper = 0;
+        for (size_t i = 0; i < AHCI::prdt_entries_per_command; ++i) {
+            auto& descriptor = command_table(slot).descriptors[i];
+            descriptor.base = m_dma_buffers_region->physical_page(slot * pages_per_command + i)->paddr().get();
+            descriptor.base_upper = 0;
+        }
+    }
+
+    port().clb = command_list.get();
+    port().clbu = 0;
+    port().fb = command_list.offset(1024).get();
+    port().fbu = 0;
+    port().serr = 0xffffffff;
+    port().is = 0xffffffff;
+    port().ie = AHCI_PORT_IS_DHRS | AHCI_PORT_IS_PSS | AHCI_PORT_IS_SDBS | AHCI_PORT_IS_DPS | AHCI_PORT_IS_ERROR;
+
+    if (!start()) {
+        klog() << "AHCIDiskDevice: Port " << m_port_index << ": device stays busy, giving up";
+        return false;
+    }
+
+    m_free_slots = slot_mask(m_command_slots);
+    return identify();
+}
+
+bool AHCIDiskDevice::start()
+{
+    if (!wait_until_clear(port().tfd, ATA_SR_BSY | ATA_SR_DRQ, 1000))
+        return false;
+    port().cmd = port().cmd | AHCI_PORT_CMD_FRE;
+    port().cmd = port().cmd | AHCI_PORT_CMD_ST;
+    return true;
+}
+
+void AHCIDiskDevice::stop()
+{
+    port().cmd = port().cmd & ~AHCI_PORT_CMD_ST;
+    if (!wait_until_clear(port().cmd, AHCI_PORT_CMD_CR, 500))
+        klog() << "AHCIDiskDevice: Port " << m_port_index << ": command list engine didn't stop";
+    port().cmd = port().cmd & ~AHCI_PORT_CMD_FRE;
+    if (!wait_until_clear(port().cmd, AHCI_PORT_CMD_FR, 500))
+        klog() << "AHCIDiskDevice: Port " << m_port_index << ": FIS receive engine didn't stop";
+}
+
+bool AHCIDiskDevice::identify()
+{
+    AHCI::RegisterHostToDeviceFIS fis {};
+    fis.fis_type = FIS_TYPE_REG_H2D;
+    fis.flags = FIS_H2D_COMMAND;
+    fis.command = ATA_CMD_IDENTIFY;
+
+    // Interrupts aren't enabled on the controller yet, so poll for this one.
+    prepare_command(0, fis, 512, false);
+    if (!issue_and_poll(0)) {
+        klog() << "AHCIDiskDevice: Port " << m_port_index << ": IDENTIFY failed";
+        return false;
+    }
+
+    const u16* identify = reinterpret_cast<const u16*>(dma_buffer(0));
+
+    char model[41];
+    for (size_t i = 0; i < 20; ++i) {
+        model[i * 2] = MSB(identify[27 + i]);
+        model[i * 2 + 1] = LSB(identify[27 + i]);
+    }
+    model[40] = '\0';
+    // "Unpad" the device name string.
+    for (int i = 39; i >= 0 && model[i] == ' '; --i)
+        model[i] = '\0';
+
+    m_lba48 = identify[83] & (1 << 10);
+    if (m_lba48)
+        m_block_count = (u64)identify[100] | ((u64)identify[101] << 16) | ((u64)identify[102] << 32) | ((u64)identify[103] << 48);
+    else
+        m_block_count = (u32)identify[60] | ((u32)identify[61] << 16);
+
+    if (m_controller.m_supports_ncq && (identify[76] & (1 << 8))) {
+        m_ncq = true;
+        u32 queue_depth = (identify[75] & 0x1f) + 1;
+        if (queue_depth < m_command_slots) {
+            m_command_slots = queue_depth;
+            m_free_slots = slot_mask(m_command_slots);
+        }
+    }
+
+    klog() << "AHCIDiskDevice: Port " << m_port_index << ": Name=" << model << ", " << m_block_count << " sectors, " << (m_ncq ? "NCQ" : "no NCQ") << ", " << m_command_slots << " command slots";
+    return true;
+}
+
+void AHCIDiskDevice::prepare_command(u32 slot, const AHCI::RegisterHostToDeviceFIS& fis, size_t byte_count, bool write)
+{
+    ASSERT(byte_count <= AHCI::max_bytes_per_command);
+    size_t entries = (byte_count + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    auto& table = command_table(slot);
+    memcpy(const_cast<u8*>(table.command_fis), &fis, sizeof(fis));
+    for (size_t i = 0; i < entries; ++i) {
+        size_t entry_size = min<size_t>(byte_count - i * PAGE_SIZE, PAGE_SIZE);
+        table.descriptors[i].byte_count_and_flags = entry_size - 1;
+    }
+
+    auto& header = command_header(slot);
+    header.attributes = (sizeof(fis) / sizeof(u32)) | (write ? AHCI_COMMAND_HEADER_WRITE : 0);
+    header.prdt_length = entries;
+    header.prd_byte_count = 0;
+}
+
+bool AHCIDiskDevice::issue_and_poll(u32 slot)
+{
+    u32 bit = 1u << slot;
+    port().ci = bit;
+    for (size_t i = 0; i < 5000 && (port().ci & bit); ++i) {
+        if (port().is & AHCI_PORT_IS_ERROR)
+            break;
+        IO::delay(1000);
+    }
+    bool success = !(port().ci & bit) && !(port().is & AHCI_PORT_IS_ERROR) && !(port().tfd & ATA_SR_ERR);
+    if (!success) {
+        stop();
+        port().serr = 0xffffffff;
+        start();
+    }
+    port().is = 0xffffffff;
+    return success;
+}
+
+void AHCIDiskDevice::issue(u32 slot)
+{
+    u32 bit = 1u << slot;
+    ScopedSpinLock lock(m_slot_lock);
+    m_pending_slots |= bit;
+    m_failed_slots &= ~bit;
+    // Queued commands must be marked active before they're issued.
+    if (m_ncq)
+        port().sact = bit;
+    port().ci = bit;
+}
+
+bool AHCIDiskDevice::issue_and_wait(u32 slot)
+{
+    u32 bit = 1u << slot;
+    issue(slot);
+    for (;;) {
+        {
+            ScopedSpinLock lock(m_slot_lock);
+            if (!(m_pending_slots & bit))
+                return !(m_failed_slots & bit);
+        }
+        Thread::current()->wait_on(m_completion_queues[slot], "AHCIDiskDevice");
+    }
+}
+
+void AHCIDiskDevice::handle_interrupt()
+{
+    u32 status = port().is;
+    port().is = status;
+
+    u32 completed;
+    u32 failed;
+    {
+        ScopedSpinLock lock(m_slot_lock);
+        if (status & AHCI_PORT_IS_ERROR) {
+            klog() << "AHCIDiskDevice: Port " << m_port_index << ": Error, IS=" << String::format("%x", status) << " TFD=" << String::format("%x", port().tfd) << " SERR=" << String::format("%x", port().serr);
+            // An error halts the whole command list, so fail everything that was in flight.
+            // FIXME: With NCQ, read the NCQ error log to find the failing tag and retry the others.
+            completed = m_pending_slots;
+            m_failed_slots |= completed;
+            stop();
+            port().serr = 0xffffffff;
+            port().is = 0xffffffff;
+            start();
+        } else {
+            u32 busy = port().ci;
+            if (m_ncq)
+                busy |= port().sact;
+            completed = m_pending_slots & ~busy;
+        }
+        m_pending_slots &= ~completed;
+        failed = m_failed_slots & completed;
+    }
+
+#ifdef AHCI_DEVICE_DEBUG
+    klog() << "AHCIDiskDevice: Port " << m_port_index << ": interrupt, IS=" << String::format("%x", status) << " completed=" << String::format("%x", completed);
+#endif
+
+    for (; completed; completed &= completed - 1) {
+        u32 slot = __builtin_ctz(completed);
+        if (!m_slot_batches[slot]) {
+            m_completion_queues[slot].wake_all();
+            continue;
+        }
+        auto batch = m_slot_batches[slot].release_nonnull();
+        bool success = !(failed & (1u << slot));
+        if (success && batch->type() == BlockDeviceRequest::Type::Read)
+            batch->scatter(dma_buffer(slot), block_size());
+        release_slot(slot);
+        complete_batch(move(batch), success);
+    }
+}
+
+u32 AHCIDiskDevice::allocate_slot()
+{
+    for (;;) {
+        {
+            ScopedSpinLock lock(m_slot_lock);
+            if (m_free_slots) {
+                u32 slot = __builtin_ctz(m_free_slots);
+                m_free_slots &= ~(1u << slot);
+                return slot;
+            }
+        }
+        Thread::current()->wait_on(m_slot_queue, "AHCIDiskDevice");
+    }
+}
+
+void AHCIDiskDevice::release_slot(u32 slot)
+{
+    {
+        ScopedSpinLock lock(m_slot_lock);
+        m_free_slots |= 1u << slot;
+    }
+    m_slot_queue.wake_one();
+}
+
+void AHCIDiskDevice::prepare_transfer(u32 slot, u64 lba, u16 count, bool write)
+{
+    ASSERT(count <= sectors_per_command);
+
+    AHCI::RegisterHostToDeviceFIS fis {};
+    fis.fis_type = FIS_TYPE_REG_H2D;
+    fis.flags = FIS_H2D_COMMAND;
+    fis.device = 0x40;
+    fis.lba0 = lba & 0xff;
+    fis.lba1 = (lba >> 8) & 0xff;
+    fis.lba2 = (lba >> 16) & 0xff;
+    if (m_ncq) {
+        fis.command = write ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+        fis.feature_low = count & 0xff;
+        fis.feature_high = count >> 8;
+    } else if (m_lba48) {
+        fis.command = write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT;
+        fis.count_low = count & 0xff;
+        fis.count_high = count >> 8;
+    } else {
+        fis.command = write ? ATA_CMD_WRITE_DMA : ATA_CMD_READ_DMA;
+        fis.device |= (lba >> 24) & 0xf;
+        fis.count_low = count & 0xff;
+    }
+    if (m_ncq || m_lba48) {
+        fis.lba3 = (lba >> 24) & 0xff;
+        fis.lba4 = (lba >> 32) & 0xff;
+        fis.lba5 = (lba >> 40) & 0xff;
+    }
+
+    // The tag of a queued command lives in the count field.
+    if (m_ncq)
+        fis.count_low = slot << 3;
+
+    prepare_command(slot, fis, count * block_size(), write);
+}
+
+bool AHCIDiskDevice::transfer(u64 lba, u16 count, u8* buffer, bool write)
+{
+    size_t byte_count = count * block_size();
+    auto slot = allocate_slot();
+    if (write)
+        memcpy(dma_buffer(slot), buffer, byte_count);
+    prepare_transfer(slot, lba, count, write);
+
+    bool success = issue_and_wait(slot);
+    if (success && !write)
+        memcpy(buffer, dma_buffer(slot), byte_count);
+    release_slot(slot);
+    return success;
+}
+
+u16 AHCIDiskDevice::max_blocks_per_batch() const
+{
+    return sectors_per_command;
+}
+
+void AHCIDiskDevice::start_batch(NonnullOwnPtr<BlockDeviceRequestBatch> batch)
+{
+    bool write = batch->type() == BlockDeviceRequest::Type::Write;
+    auto slot = allocate_slot();
+    if (write)
+        batch->gather(dma_buffer(slot), block_size());
+    prepare_transfer(slot, batch->block_index(), batch->block_count(), write);
+
+    // handle_interrupt() completes the batch once the drive is done with it.
+    ASSERT(!m_slot_batches[slot]);
+    m_slot_batches[slot] = move(batch);
+    issue(slot);
+}
+
+bool AHCIDiskDevice::read_blocks(unsigned index, u16 count, u8* out)
+{
+#ifdef AHCI_DEVICE_DEBUG
+    klog() << "AHCIDiskDevice::read_blocks() index=" << index << " count=" << count;
+#endif
+    while (count) {
+        u16 chunk = min<u16>(count, sectors_per_command);
+        if (!transfer(index, chunk, out, false))
+            return false;
+        index += chunk;
+        count -= chunk;
+        out += chunk * block_size();
+    }
+    return true;
+}
+
+bool AHCIDiskDevice::write_blocks(unsigned index, u16 count, const u8* data)
+{
+#ifdef AHCI_DEVICE_DEBUG
+    klog() << "AHCIDiskDevice::write_blocks() index=" << index << " count=" << count;
+#endif
+    while (count) {
+        u16 chunk = min<u16>(count, sectors_per_command);
+        if (!transfer(index, chunk, const_cast<u8*>(data), true))
+            return false;
+        index += chunk;
+        count -= chunk;
+        data += chunk * block_size();
+    }
+    return true;
+}
+
+KResultOr<size_t> AHCIDiskDevice::read(FileDescription&, size_t offset, u8* outbuf, size_t len)
+{
+    account_block_io_request();
+    unsigned index = offset / block_size();
+    size_t whole_blocks = min<size_t>(len / block_size(), 0xffff);
+    ssize_t remaining = whole_blocks == 0xffff ? 0 : len % block_size();
+
+    if (whole_blocks > 0) {
+        if (!read_blocks(index, whole_blocks, outbuf))
+            return -1;
+    }
+
+    off_t pos = whole_blocks * block_size();
+
+    if (remaining > 0) {
+        auto buf = ByteBuffer::create_uninitialized(block_size());
+        if (!read_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+        memcpy(&outbuf[pos], buf.data(), remaining);
+    }
+
+    return pos + remaining;
+}
+
+bool AHCIDiskDevice::can_read(const FileDescription&, size_t offset) const
+{
+    return offset < m_block_count * block_size();
+}
+
+KResultOr<size_t> AHCIDiskDevice::write(FileDescription&, size_t offset, const u8* inbuf, size_t len)
+{
+    account_block_io_request();
+    unsigned index = offset / block_size();
+    size_t whole_blocks = min<size_t>(len / block_size(), 0xffff);
+    ssize_t remaining = whole_blocks == 0xffff ? 0 : len % block_size();
+
+    if (whole_blocks > 0) {
+        if (!write_blocks(index, whole_blocks, inbuf))
+            return -1;
+    }
+
+    off_t pos = whole_blocks * block_size();
+
+    // Partial block writes have to read-modify-write the whole block.
+    if (remaining > 0) {
+        auto buf = ByteBuffer::create_zeroed(block_size());
+        if (!read_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+        memcpy(buf.data(), &inbuf[pos], remaining);
+        if (!write_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+    }
+
+    return pos + remaining;
+}
+
+bool AHCIDiskDevice::can_write(const FileDescription&, size_t offset) const
+{
+    return offset < m_block_count * block_size();
+}
+
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// A SATA disk attached to one port of an AHCIController.
+//
+
+#pragma once
+
+#include <Kernel/Devices/AHCIController.h>
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+class AHCIDiskDevice final : public BlockDevice {
+    friend class AHCIController;
+    AK_MAKE_ETERNAL
+public:
+    static RefPtr<AHCIDiskDevice> create(AHCIController&, u8 port_index, int major, int minor);
+    virtual ~AHCIDiskDevice() override;
+
+    // ^DiskDevice
+    virtual bool read_blocks(unsigned index, u16 count, u8*) override;
+    virtual bool write_blocks(unsigned index, u16 count, const u8*) override;
+
+    // ^BlockDevice
+    virtual KResultOr<size_t> read(FileDescription&, size_t, u8*, size_t) override;
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual KResultOr<size_t> write(FileDescription&, size_t, const u8*, size_t) override;
+    virtual bool can_write(const FileDescription&, size_t) const override;
+    virtual u16 max_blocks_per_batch() const override;
+
+    u64 block_count() const { return m_block_count; }
+    bool uses_ncq() const { return m_ncq; }
+
+private:
+    AHCIDiskDevice(AHCIController&, u8 port_index, int major, int minor);
+
+    // ^DiskDevice
+    virtual const char* class_name() const override;
+
+    // ^BlockDevice
+    virtual size_t max_batches_in_flight() const override { return m_command_slots; }
+    virtual void start_batch(NonnullOwnPtr<BlockDeviceRequestBatch>) override;
+
+    bool initialize();
+    bool start();
+    void stop();
+    bool identify();
+    void handle_interrupt();
+
+    u32 allocate_slot();
+    void release_slot(u32 slot);
+    void prepare_command(u32 slot, const AHCI::RegisterHostToDeviceFIS&, size_t byte_count, bool write);
+    void prepare_transfer(u32 slot, u64 lba, u16 count, bool write);
+    void issue(u32 slot);
+    bool issue_and_wait(u32 slot);
+    bool issue_and_poll(u32 slot);
+    bool transfer(u64 lba, u16 count, u8* buffer, bool write);
+
+    volatile AHCI::PortRegisters& port() { return m_controller.hba().ports[m_port_index]; }
+    volatile AHCI::CommandHeader& command_header(u32 slot) { return reinterpret_cast<volatile AHCI::CommandHeader*>(m_command_list_region->vaddr().as_ptr())[slot]; }
+    volatile AHCI::CommandTable& command_table(u32 slot) { return reinterpret_cast<volatile AHCI::CommandTable*>(m_command_tables_region->vaddr().as_ptr())[slot]; }
+    u8* dma_buffer(u32 slot) { return m_dma_buffers_region->vaddr().offset(slot * AHCI::max_bytes_per_command).as_ptr(); }
+
+    AHCIController& m_controller;
+    u8 m_port_index { 0 };
+
+    // One page holding the 1 KiB command list followed by the received FIS area.
+    OwnPtr<Region> m_command_list_region;
+    OwnPtr<Region> m_command_tables_region;
+    // Every slot owns prdt_entries_per_command pages here; they need not be physically contiguous.
+    OwnPtr<Region> m_dma_buffers_region;
+
+    u32 m_command_slots { 1 };
+    bool m_ncq { false };
+    bool m_lba48 { false };
+    u64 m_block_count { 0 };
+
+    SpinLock<u8> m_slot_lock;
+    u32 m_free_slots { 0 };
+    u32 m_pending_slots { 0 };
+    u32 m_failed_slots { 0 };
+    WaitQueue m_slot_queue;
+    WaitQueue m_completion_queues[32];
+    // Batches from the request queue that are in flight, by command slot.
+    OwnPtr<BlockDeviceRequestBatch> m_slot_batches[32];
+};
+
+}
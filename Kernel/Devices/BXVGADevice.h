@@ -29,6 +29,7 @@
 #include <AK/String.h>
 #include <AK/Types.h>
 #include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Devices/VBlankClock.h>
 #include <Kernel/PhysicalAddress.h>
 
 namespace Kernel {
@@ -45,9 +46,9 @@ public:
 
 private:
     virtual const char* class_name() const override { return "BXVGA"; }
-    virtual bool can_read(const FileDescription&, size_t) const override { return true; }
+    virtual bool can_read(const FileDescription&, size_t) const override { return m_vblank_clock.can_read(); }
     virtual bool can_write(const FileDescription&, size_t) const override { return true; }
-    virtual KResultOr<size_t> read(FileDescription&, size_t, u8*, size_t) override { return -EINVAL; }
+    virtual KResultOr<size_t> read(FileDescription&, size_t, u8* buffer, size_t size) override { return m_vblank_clock.read(buffer, size); }
     virtual KResultOr<size_t> write(FileDescription&, size_t, const u8*, size_t) override { return -EINVAL; }
     virtual bool read_blocks(unsigned, u16, u8*) override { return false; }
     virtual bool write_blocks(unsigned, u16, const u8*) override { return false; }
@@ -70,6 +71,7 @@ private:
     size_t m_framebuffer_width { 0 };
     size_t m_framebuffer_height { 0 };
     size_t m_y_offset { 0 };
+    VBlankClock m_vblank_clock;
 };
 
 }
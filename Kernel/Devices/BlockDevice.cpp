@@ -24,10 +24,59 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Memory.h>
 #include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Tasks/BlockIOTask.h>
+
+//#define BLOCK_REQUEST_DEBUG
 
 namespace Kernel {
 
+BlockDeviceRequest::Result BlockDeviceRequest::wait()
+{
+    while (!is_completed())
+        Thread::current()->wait_on(m_wait_queue, "BlockDeviceRequest");
+    return m_result;
+}
+
+void BlockDeviceRequest::complete(Result result)
+{
+    ASSERT(result != Result::Pending);
+    ASSERT(!is_completed());
+    m_result = result;
+    m_wait_queue.wake_all();
+}
+
+void BlockDeviceRequestBatch::append(NonnullRefPtr<BlockDeviceRequest> request)
+{
+    ASSERT(m_requests.is_empty() || (request->type() == type() && request->block_index() == block_index() + block_count()));
+    m_block_count += request->block_count();
+    m_requests.append(move(request));
+}
+
+void BlockDeviceRequestBatch::gather(u8* buffer, size_t block_size) const
+{
+    for (auto& request : m_requests) {
+        memcpy(buffer, request.buffer(), request.block_count() * block_size);
+        buffer += request.block_count() * block_size;
+    }
+}
+
+void BlockDeviceRequestBatch::scatter(const u8* buffer, size_t block_size)
+{
+    for (auto& request : m_requests) {
+        memcpy(request.buffer(), buffer, request.block_count() * block_size);
+        buffer += request.block_count() * block_size;
+    }
+}
+
+BlockDevice::BlockDevice(unsigned major, unsigned minor, size_t block_size)
+    : Device(major, minor)
+    , m_block_size(block_size)
+{
+}
+
 BlockDevice::~BlockDevice()
 {
 }
@@ -62,4 +111,170 @@ bool BlockDevice::write_raw(u32 offset, unsigned length, const u8* in)
     return write_blocks(first_block, end_block - first_block, in);
 }
 
+void BlockDevice::account_block_io_request()
+{
+    if (auto* thread = Thread::current())
+        thread->did_block_io_request();
+}
+
+u16 BlockDevice::max_blocks_per_batch() const
+{
+    return max<size_t>(64 * KiB / block_size(), 1);
+}
+
+static bool requests_conflict(const BlockDeviceRequest& a, const BlockDeviceRequest& b)
+{
+    if (a.type() == BlockDeviceRequest::Type::Read && b.type() == BlockDeviceRequest::Type::Read)
+        return false;
+    return a.block_index() < b.end_block_index() && b.block_index() < a.end_block_index();
+}
+
+bool BlockDevice::has_conflicting_request_before(const BlockDeviceRequest& request)
+{
+    ASSERT(m_request_lock.is_locked());
+    for (auto& other : m_pending_requests) {
+        if (&other == &request)
+            return false;
+        if (requests_conflict(other, request))
+            return true;
+    }
+    ASSERT_NOT_REACHED();
+}
+
+void BlockDevice::queue_request(BlockDeviceRequest& request)
+{
+    ASSERT(m_request_lock.is_locked());
+    // Keep the queue sorted by block index, except that a request never
+    // moves ahead of an earlier one touching the same blocks, unless both
+    // are reads.
+    BlockDeviceRequest* insert_before = nullptr;
+    for (auto& other : m_pending_requests) {
+        if (requests_conflict(other, request)) {
+            insert_before = nullptr;
+            continue;
+        }
+        if (!insert_before && other.block_index() > request.block_index())
+            insert_before = &other;
+    }
+    if (insert_before)
+        m_pending_requests.insert_before(*insert_before, request);
+    else
+        m_pending_requests.append(request);
+}
+
+void BlockDevice::take_next_batch(BlockDeviceRequestBatch& batch)
+{
+    ASSERT(m_request_lock.is_locked());
+    ASSERT(!m_pending_requests.is_empty());
+
+    // C-LOOK: keep sweeping towards higher block indices and jump back to
+    // the lowest pending request once we run out. The head of the queue
+    // never has to wait for anything, so we can always fall back to it.
+    BlockDeviceRequest* next = nullptr;
+    for (auto& request : m_pending_requests) {
+        if (request.block_index() >= m_elevator_position && !has_conflicting_request_before(request)) {
+            next = &request;
+            break;
+        }
+    }
+    if (!next)
+        next = m_pending_requests.first();
+
+    m_pending_requests.remove(*next);
+    batch.append(*next);
+
+    // Absorb the requests that continue where the batch ends.
+    u16 max_blocks = max_blocks_per_batch();
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (auto& request : m_pending_requests) {
+            if (request.type() != batch.type() || request.block_index() != batch.block_index() + batch.block_count())
+                continue;
+            if (request.block_count() > max_blocks - batch.block_count())
+                break;
+            if (has_conflicting_request_before(request))
+                break;
+            m_pending_requests.remove(request);
+            batch.append(request);
+            merged = true;
+            break;
+        }
+    }
+
+    m_elevator_position = batch.block_index() + batch.block_count();
+#ifdef BLOCK_REQUEST_DEBUG
+    dbg() << class_name() << ": Dispatching " << (batch.type() == BlockDeviceRequest::Type::Read ? "read" : "write") << " of " << batch.block_count() << " blocks at " << batch.block_index() << " (" << batch.requests().size() << " requests)";
+#endif
+}
+
+void BlockDevice::submit_request(BlockDeviceRequest& request)
+{
+    ASSERT(!request.is_completed());
+    ASSERT(request.block_count() <= max_blocks_per_batch());
+    account_block_io_request();
+    {
+        ScopedSpinLock lock(m_request_lock);
+        // The queue holds a reference until the request is completed.
+        request.ref();
+        queue_request(request);
+    }
+    BlockIOTask::schedule(*this);
+}
+
+void BlockDevice::dispatch_pending_requests()
+{
+    for (;;) {
+        auto batch = make<BlockDeviceRequestBatch>();
+        {
+            ScopedSpinLock lock(m_request_lock);
+            if (m_pending_requests.is_empty() || m_batches_in_flight >= max_batches_in_flight())
+                return;
+            take_next_batch(*batch);
+            ++m_batches_in_flight;
+        }
+        // The queue's references now belong to the batch.
+        for (auto& request : batch->requests())
+            request.unref();
+        start_batch(move(batch));
+    }
+}
+
+void BlockDevice::start_batch(NonnullOwnPtr<BlockDeviceRequestBatch> batch)
+{
+    u8* buffer = batch->contiguous_buffer();
+    if (!buffer) {
+        if (!m_batch_buffer)
+            m_batch_buffer = make<KBuffer>(KBuffer::create_with_size(max_blocks_per_batch() * block_size(), Region::Access::Read | Region::Access::Write, "BlockDevice batch"));
+        buffer = m_batch_buffer->data();
+    }
+
+    bool success;
+    if (batch->type() == BlockDeviceRequest::Type::Read) {
+        success = read_blocks(batch->block_index(), batch->block_count(), buffer);
+        if (success && buffer != batch->contiguous_buffer())
+            batch->scatter(buffer, block_size());
+    } else {
+        if (buffer != batch->contiguous_buffer())
+            batch->gather(buffer, block_size());
+        success = write_blocks(batch->block_index(), batch->block_count(), buffer);
+    }
+    complete_batch(move(batch), success);
+}
+
+void BlockDevice::complete_batch(NonnullOwnPtr<BlockDeviceRequestBatch> batch, bool success)
+{
+    for (auto& request : batch->requests())
+        request.complete(success ? BlockDeviceRequest::Result::Success : BlockDeviceRequest::Result::Failure);
+
+    bool has_more_work;
+    {
+        ScopedSpinLock lock(m_request_lock);
+        ASSERT(m_batches_in_flight);
+        --m_batches_in_flight;
+        has_more_work = !m_pending_requests.is_empty();
+    }
+    if (has_more_work)
+        BlockIOTask::schedule(*this);
+}
+
 }
@@ -26,11 +26,97 @@
 
 #pragma once
 
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <Kernel/Devices/Device.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
+class BlockDevice;
+class KBuffer;
+
+class BlockDeviceRequest : public RefCounted<BlockDeviceRequest> {
+    friend class BlockDevice;
+
+public:
+    enum class Type : u8 {
+        Read,
+        Write
+    };
+
+    enum class Result : u8 {
+        Pending,
+        Success,
+        Failure
+    };
+
+    static NonnullRefPtr<BlockDeviceRequest> create(Type type, unsigned block_index, u16 block_count, u8* buffer)
+    {
+        return adopt(*new BlockDeviceRequest(type, block_index, block_count, buffer));
+    }
+
+    Type type() const { return m_type; }
+    unsigned block_index() const { return m_block_index; }
+    u16 block_count() const { return m_block_count; }
+    unsigned end_block_index() const { return m_block_index + m_block_count; }
+    u8* buffer() { return m_buffer; }
+    const u8* buffer() const { return m_buffer; }
+
+    Result result() const { return m_result; }
+    bool is_completed() const { return m_result != Result::Pending; }
+
+    // Blocks the calling thread until the device has completed the request.
+    Result wait();
+
+private:
+    BlockDeviceRequest(Type type, unsigned block_index, u16 block_count, u8* buffer)
+        : m_type(type)
+        , m_block_index(block_index)
+        , m_block_count(block_count)
+        , m_buffer(buffer)
+    {
+    }
+
+    void complete(Result);
+
+    IntrusiveListNode m_queue_node;
+    WaitQueue m_wait_queue;
+    Type m_type;
+    unsigned m_block_index { 0 };
+    u16 m_block_count { 0 };
+    u8* m_buffer { nullptr };
+    volatile Result m_result { Result::Pending };
+};
+
+// A run of adjacent requests of the same type that the elevator merged
+// into a single transfer.
+class BlockDeviceRequestBatch {
+public:
+    BlockDeviceRequest::Type type() const { return m_requests.first().type(); }
+    unsigned block_index() const { return m_requests.first().block_index(); }
+    u16 block_count() const { return m_block_count; }
+
+    // A single request can be transferred straight from/to its own buffer.
+    u8* contiguous_buffer() { return m_requests.size() == 1 ? m_requests.first().buffer() : nullptr; }
+
+    // Copy the data of a write batch into one buffer, or a read batch's data back out to its requests.
+    void gather(u8* buffer, size_t block_size) const;
+    void scatter(const u8* buffer, size_t block_size);
+
+    void append(NonnullRefPtr<BlockDeviceRequest>);
+    NonnullRefPtrVector<BlockDeviceRequest, 8>& requests() { return m_requests; }
+
+private:
+    NonnullRefPtrVector<BlockDeviceRequest, 8> m_requests;
+    u16 m_block_count { 0 };
+};
+
 class BlockDevice : public Device {
+    friend class BlockIOTask;
+
 public:
     virtual ~BlockDevice() override;
 
@@ -45,17 +131,53 @@ public:
     virtual bool read_blocks(unsigned index, u16 count, u8*) = 0;
     virtual bool write_blocks(unsigned index, u16 count, const u8*) = 0;
 
+    // Queue a request without waiting for it. Pending requests are sorted
+    // by an elevator, adjacent ones are merged, and the BlockIOTask hands
+    // them to the driver. Use BlockDeviceRequest::wait() to wait for it.
+    virtual void submit_request(BlockDeviceRequest&);
+
+    // How many blocks a single request or merged transfer may cover.
+    virtual u16 max_blocks_per_batch() const;
+
 protected:
-    BlockDevice(unsigned major, unsigned minor, size_t block_size = PAGE_SIZE)
-        : Device(major, minor)
-        , m_block_size(block_size)
-    {
-    }
+    BlockDevice(unsigned major, unsigned minor, size_t block_size = PAGE_SIZE);
+
+    // How many transfers the driver can have in flight at once.
+    virtual size_t max_batches_in_flight() const { return 1; }
+
+    // Drivers that can run transfers asynchronously override this and call
+    // complete_batch() when the device is done, which is safe to do from an
+    // IRQ handler. The default implementation runs the batch synchronously
+    // through read_blocks()/write_blocks().
+    virtual void start_batch(NonnullOwnPtr<BlockDeviceRequestBatch>);
+    void complete_batch(NonnullOwnPtr<BlockDeviceRequestBatch>, bool success);
+
+    static void rebase_request(BlockDeviceRequest& request, unsigned block_offset) { request.m_block_index += block_offset; }
+
+    // Charges a request that has to go to the device to the calling thread. Drivers call this for reads and
+    // writes through their file interface; queued requests are charged by submit_request().
+    static void account_block_io_request();
 
 private:
     virtual bool is_block_device() const final { return true; }
 
+    void dispatch_pending_requests();
+    void queue_request(BlockDeviceRequest&);
+    bool has_conflicting_request_before(const BlockDeviceRequest&);
+    void take_next_batch(BlockDeviceRequestBatch&);
+
     size_t m_block_size { 0 };
+
+    typedef IntrusiveList<BlockDeviceRequest, &BlockDeviceRequest::m_queue_node> RequestList;
+    SpinLock<u8> m_request_lock;
+    RequestList m_pending_requests;
+    unsigned m_elevator_position { 0 };
+    size_t m_batches_in_flight { 0 };
+    IntrusiveListNode m_block_io_node;
+    OwnPtr<KBuffer> m_batch_buffer;
+
+public:
+    typedef IntrusiveList<BlockDevice, &BlockDevice::m_block_io_node> BlockIOList;
 };
 
 }
@@ -110,6 +110,16 @@ bool DiskPartition::write_blocks(unsigned index, u16 count, const u8* data)
     return m_device->write_blocks(m_block_offset + index, count, data);
 }
 
+void DiskPartition::submit_request(BlockDeviceRequest& request)
+{
+#ifdef OFFD_DEBUG
+    klog() << "DiskPartition::submit_request " << request.block_index() << " (really: " << (m_block_offset + request.block_index()) << ") count=" << request.block_count();
+#endif
+
+    rebase_request(request, m_block_offset);
+    m_device->submit_request(request);
+}
+
 const char* DiskPartition::class_name() const
 {
     return "DiskPartition";
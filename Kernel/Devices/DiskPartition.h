@@ -40,6 +40,8 @@ public:
     virtual bool write_blocks(unsigned index, u16 count, const u8*) override;
 
     // ^BlockDevice
+    virtual void submit_request(BlockDeviceRequest&) override;
+    virtual u16 max_blocks_per_batch() const override { return m_device->max_blocks_per_batch(); }
     virtual KResultOr<size_t> read(FileDescription&, size_t, u8*, size_t) override;
     virtual bool can_read(const FileDescription&, size_t) const override;
     virtual KResultOr<size_t> write(FileDescription&, size_t, const u8*, size_t) override;
@@ -165,7 +165,7 @@ void PATAChannel::initialize(bool force_pio)
     // Let's try to set up DMA transfers.
     PCI::enable_bus_mastering(pci_address());
     m_prdt_page = MM.allocate_supervisor_physical_page();
-    prdt().end_of_table = 0x8000;
+    prdt()[0].end_of_table = 0x8000;
     m_dma_buffer_page = MM.allocate_supervisor_physical_page();
     klog() << "PATAChannel: Bus master IDE: " << m_bus_master_base;
 }
@@ -274,29 +274,72 @@ void PATAChannel::detect_disks()
     }
 }
 
-bool PATAChannel::ata_read_sectors_with_dma(u32 lba, u16 count, u8* outbuf, bool slave_request)
+size_t PATAChannel::build_prdt(const u8* buffer, size_t length)
 {
-    LOCKER(s_lock());
-#ifdef PATA_DEBUG
-    dbg() << "PATAChannel::ata_read_sectors_with_dma (" << lba << " x" << count << ") -> " << outbuf;
-#endif
+    // The bus master can only transfer whole words.
+    if ((FlatPtr)buffer & 1 || length & 1)
+        return 0;
+
+    auto* descriptors = prdt();
+    size_t entry_count = 0;
+    for (size_t offset = 0; offset < length;) {
+        VirtualAddress vaddr((FlatPtr)buffer + offset);
+        size_t chunk_size = min<size_t>(PAGE_SIZE - (vaddr.get() & (PAGE_SIZE - 1)), length - offset);
+        auto paddr = MM.physical_address_for_dma(vaddr);
+        if (!paddr.has_value())
+            return 0;
+
+        // Extend the previous entry if this page follows it physically. Entries
+        // must not cross a 64 KiB boundary, and a size of 0 means 64 KiB.
+        if (entry_count) {
+            auto& last = descriptors[entry_count - 1];
+            u32 last_size = last.size ? last.size : 0x10000;
+            if (last.offset.get() + last_size == paddr.value().get() && (last.offset.get() >> 16) == ((paddr.value().get() + chunk_size - 1) >> 16)) {
+                last.size = last_size + chunk_size;
+                offset += chunk_size;
+                continue;
+            }
+        }
 
-    prdt().offset = m_dma_buffer_page->paddr();
-    prdt().size = 512 * count;
+        if (entry_count == max_prdt_entries)
+            return 0;
+        auto& descriptor = descriptors[entry_count++];
+        descriptor.offset = paddr.value();
+        descriptor.size = chunk_size;
+        descriptor.end_of_table = 0;
+        offset += chunk_size;
+    }
 
-    ASSERT(prdt().size <= PAGE_SIZE);
+    if (!entry_count)
+        return 0;
+    descriptors[entry_count - 1].end_of_table = 0x8000;
+    return entry_count;
+}
+
+void PATAChannel::use_dma_buffer_page(u16 count)
+{
+    ASSERT(512 * count <= PAGE_SIZE);
+    prdt()[0].offset = m_dma_buffer_page->paddr();
+    prdt()[0].size = 512 * count;
+    prdt()[0].end_of_table = 0x8000;
+}
+
+bool PATAChannel::ata_dma_transfer(u32 lba, u16 count, bool write, bool slave_request)
+{
+    ASSERT(count <= max_sectors_per_dma_transfer);
 
     // Stop bus master
     m_bus_master_base.out<u8>(0);
 
     // Write the PRDT location
-    m_bus_master_base.offset(4).out(m_prdt_page->paddr().get());
+    m_bus_master_base.offset(4).out<u32>(m_prdt_page->paddr().get());
 
     // Turn on "Interrupt" and "Error" flag. The error flag should be cleared by hardware.
     m_bus_master_base.offset(2).out<u8>(m_bus_master_base.offset(2).in<u8>() | 0x6);
 
     // Set transfer direction
-    m_bus_master_base.out<u8>(0x8);
+    if (!write)
+        m_bus_master_base.out<u8>(0x8);
 
     while (m_io_base.offset(ATA_REG_STATUS).in<u8>() & ATA_SR_BSY)
         ;
@@ -307,12 +350,13 @@ bool PATAChannel::ata_read_sectors_with_dma(u32 lba, u16 count, u8* outbuf, bool
 
     m_io_base.offset(ATA_REG_FEATURES).out<u16>(0);
 
-    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(0);
-    m_io_base.offset(ATA_REG_LBA0).out<u8>(0);
+    // The high order bytes of the 48-bit sector count and LBA go first.
+    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(count >> 8);
+    m_io_base.offset(ATA_REG_LBA0).out<u8>((lba & 0xff000000) >> 24);
     m_io_base.offset(ATA_REG_LBA1).out<u8>(0);
     m_io_base.offset(ATA_REG_LBA2).out<u8>(0);
 
-    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(count);
+    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(count & 0xff);
     m_io_base.offset(ATA_REG_LBA0).out<u8>((lba & 0x000000ff) >> 0);
     m_io_base.offset(ATA_REG_LBA1).out<u8>((lba & 0x0000ff00) >> 8);
     m_io_base.offset(ATA_REG_LBA2).out<u8>((lba & 0x00ff0000) >> 16);
@@ -323,86 +367,66 @@ bool PATAChannel::ata_read_sectors_with_dma(u32 lba, u16 count, u8* outbuf, bool
             break;
     }
 
-    m_io_base.offset(ATA_REG_COMMAND).out<u8>(ATA_CMD_READ_DMA_EXT);
+    m_io_base.offset(ATA_REG_COMMAND).out<u8>(write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT);
     io_delay();
 
     prepare_for_irq();
     // Start bus master
-    m_bus_master_base.out<u8>(0x9);
+    m_bus_master_base.out<u8>(write ? 0x1 : 0x9);
 
     wait_for_irq();
 
     if (m_device_error)
         return false;
 
-    memcpy(outbuf, m_dma_buffer_page->paddr().offset(0xc0000000).as_ptr(), 512 * count);
-
     // I read somewhere that this may trigger a cache flush so let's do it.
     m_bus_master_base.offset(2).out<u8>(m_bus_master_base.offset(2).in<u8>() | 0x6);
     return true;
 }
 
-bool PATAChannel::ata_write_sectors_with_dma(u32 lba, u16 count, const u8* inbuf, bool slave_request)
+bool PATAChannel::ata_read_sectors_with_dma(u32 lba, u16 count, u8* outbuf, bool slave_request)
 {
     LOCKER(s_lock());
 #ifdef PATA_DEBUG
-    dbg() << "PATAChannel::ata_write_sectors_with_dma (" << lba << " x" << count << ") <- " << inbuf;
+    dbg() << "PATAChannel::ata_read_sectors_with_dma (" << lba << " x" << count << ") -> " << outbuf;
 #endif
 
-    prdt().offset = m_dma_buffer_page->paddr();
-    prdt().size = 512 * count;
-
-    memcpy(m_dma_buffer_page->paddr().offset(0xc0000000).as_ptr(), inbuf, 512 * count);
-
-    ASSERT(prdt().size <= PAGE_SIZE);
-
-    // Stop bus master
-    m_bus_master_base.out<u8>(0);
-
-    // Write the PRDT location
-    m_bus_master_base.offset(4).out<u32>(m_prdt_page->paddr().get());
-
-    // Turn on "Interrupt" and "Error" flag. The error flag should be cleared by hardware.
-    m_bus_master_base.offset(2).out<u8>(m_bus_master_base.offset(2).in<u8>() | 0x6);
-
-    while (m_io_base.offset(ATA_REG_STATUS).in<u8>() & ATA_SR_BSY)
-        ;
-
-    m_control_base.offset(ATA_CTL_CONTROL).out<u8>(0);
-    m_io_base.offset(ATA_REG_HDDEVSEL).out<u8>(0x40 | (static_cast<u8>(slave_request) << 4));
-    io_delay();
-
-    m_io_base.offset(ATA_REG_FEATURES).out<u16>(0);
-
-    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(0);
-    m_io_base.offset(ATA_REG_LBA0).out<u8>(0);
-    m_io_base.offset(ATA_REG_LBA1).out<u8>(0);
-    m_io_base.offset(ATA_REG_LBA2).out<u8>(0);
+    if (build_prdt(outbuf, 512 * count))
+        return ata_dma_transfer(lba, count, false, slave_request);
 
-    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(count);
-    m_io_base.offset(ATA_REG_LBA0).out<u8>((lba & 0x000000ff) >> 0);
-    m_io_base.offset(ATA_REG_LBA1).out<u8>((lba & 0x0000ff00) >> 8);
-    m_io_base.offset(ATA_REG_LBA2).out<u8>((lba & 0x00ff0000) >> 16);
-
-    for (;;) {
-        auto status = m_io_base.offset(ATA_REG_STATUS).in<u8>();
-        if (!(status & ATA_SR_BSY) && (status & ATA_SR_DRDY))
-            break;
+    // We can't point the controller at the caller's buffer, so bounce it through our own page.
+    u16 sectors_per_page = PAGE_SIZE / 512;
+    for (u16 done = 0; done < count;) {
+        u16 chunk = min<u16>(count - done, sectors_per_page);
+        use_dma_buffer_page(chunk);
+        if (!ata_dma_transfer(lba + done, chunk, false, slave_request))
+            return false;
+        memcpy(outbuf + done * 512, m_dma_buffer_page->paddr().offset(0xc0000000).as_ptr(), 512 * chunk);
+        done += chunk;
     }
+    return true;
+}
 
-    m_io_base.offset(ATA_REG_COMMAND).out<u8>(ATA_CMD_WRITE_DMA_EXT);
-    io_delay();
-
-    prepare_for_irq();
-    // Start bus master
-    m_bus_master_base.out<u8>(0x1);
-    wait_for_irq();
+bool PATAChannel::ata_write_sectors_with_dma(u32 lba, u16 count, const u8* inbuf, bool slave_request)
+{
+    LOCKER(s_lock());
+#ifdef PATA_DEBUG
+    dbg() << "PATAChannel::ata_write_sectors_with_dma (" << lba << " x" << count << ") <- " << inbuf;
+#endif
 
-    if (m_device_error)
-        return false;
+    if (build_prdt(inbuf, 512 * count))
+        return ata_dma_transfer(lba, count, true, slave_request);
 
-    // I read somewhere that this may trigger a cache flush so let's do it.
-    m_bus_master_base.offset(2).out<u8>(m_bus_master_base.offset(2).in<u8>() | 0x6);
+    // We can't point the controller at the caller's buffer, so bounce it through our own page.
+    u16 sectors_per_page = PAGE_SIZE / 512;
+    for (u16 done = 0; done < count;) {
+        u16 chunk = min<u16>(count - done, sectors_per_page);
+        memcpy(m_dma_buffer_page->paddr().offset(0xc0000000).as_ptr(), inbuf + done * 512, 512 * chunk);
+        use_dma_buffer_page(chunk);
+        if (!ata_dma_transfer(lba + done, chunk, true, slave_request))
+            return false;
+        done += chunk;
+    }
     return true;
 }
 
@@ -71,6 +71,9 @@ public:
     PATAChannel(PCI::Address address, ChannelType type, bool force_pio);
     virtual ~PATAChannel() override;
 
+    // The most sectors a single DMA command will move; see PATADiskDevice::max_blocks_per_batch().
+    static constexpr u16 max_sectors_per_dma_transfer = 256;
+
     RefPtr<PATADiskDevice> master_device() { return m_master; };
     RefPtr<PATADiskDevice> slave_device() { return m_slave; };
 
@@ -84,6 +87,9 @@ private:
     void detect_disks();
 
     void wait_for_irq();
+    size_t build_prdt(const u8*, size_t);
+    void use_dma_buffer_page(u16 count);
+    bool ata_dma_transfer(u32 lba, u16 count, bool write, bool slave_request);
     bool ata_read_sectors_with_dma(u32, u16, u8*, bool);
     bool ata_write_sectors_with_dma(u32, u16, const u8*, bool);
     bool ata_read_sectors(u32, u16, u8*, bool);
@@ -99,7 +105,8 @@ private:
 
     WaitQueue m_irq_queue;
 
-    PhysicalRegionDescriptor& prdt() { return *reinterpret_cast<PhysicalRegionDescriptor*>(m_prdt_page->paddr().offset(0xc0000000).as_ptr()); }
+    static constexpr size_t max_prdt_entries = PAGE_SIZE / sizeof(PhysicalRegionDescriptor);
+    PhysicalRegionDescriptor* prdt() { return reinterpret_cast<PhysicalRegionDescriptor*>(m_prdt_page->paddr().offset(0xc0000000).as_ptr()); }
     RefPtr<PhysicalPage> m_prdt_page;
     RefPtr<PhysicalPage> m_dma_buffer_page;
     IOAddress m_bus_master_base;
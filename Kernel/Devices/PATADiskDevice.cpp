@@ -57,15 +57,28 @@ const char* PATADiskDevice::class_name() const
 
 bool PATADiskDevice::read_blocks(unsigned index, u16 count, u8* out)
 {
-    if (!m_channel.m_bus_master_base.is_null() && m_channel.m_dma_enabled.resource())
-        return read_sectors_with_dma(index, count, out);
-    return read_sectors(index, count, out);
+    bool use_dma = !m_channel.m_bus_master_base.is_null() && m_channel.m_dma_enabled.resource();
+    for (u16 done = 0; done < count;) {
+        u16 chunk = min<u16>(count - done, PATAChannel::max_sectors_per_dma_transfer);
+        bool success = use_dma ? read_sectors_with_dma(index + done, chunk, out + done * block_size()) : read_sectors(index + done, chunk, out + done * block_size());
+        if (!success)
+            return false;
+        done += chunk;
+    }
+    return true;
 }
 
 bool PATADiskDevice::write_blocks(unsigned index, u16 count, const u8* data)
 {
-    if (!m_channel.m_bus_master_base.is_null() && m_channel.m_dma_enabled.resource())
-        return write_sectors_with_dma(index, count, data);
+    if (!m_channel.m_bus_master_base.is_null() && m_channel.m_dma_enabled.resource()) {
+        for (u16 done = 0; done < count;) {
+            u16 chunk = min<u16>(count - done, PATAChannel::max_sectors_per_dma_transfer);
+            if (!write_sectors_with_dma(index + done, chunk, data + done * block_size()))
+                return false;
+            done += chunk;
+        }
+        return true;
+    }
     for (unsigned i = 0; i < count; ++i) {
         if (!write_sectors(index + i, 1, data + i * 512))
             return false;
@@ -73,6 +86,12 @@ bool PATADiskDevice::write_blocks(unsigned index, u16 count, const u8* data)
     return true;
 }
 
+u16 PATADiskDevice::max_blocks_per_batch() const
+{
+    // A single DMA command can move up to 256 sectors straight into the caller's pages.
+    return PATAChannel::max_sectors_per_dma_transfer;
+}
+
 void PATADiskDevice::set_drive_geometry(u16 cyls, u16 heads, u16 spt)
 {
     m_cylinders = cyls;
@@ -82,16 +101,15 @@ void PATADiskDevice::set_drive_geometry(u16 cyls, u16 heads, u16 spt)
 
 KResultOr<size_t> PATADiskDevice::read(FileDescription&, size_t offset, u8* outbuf, size_t len)
 {
+    account_block_io_request();
     unsigned index = offset / block_size();
     u16 whole_blocks = len / block_size();
     ssize_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
-
-    // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
+    // read_blocks()/write_blocks() take a u16 block count; hand back a short
+    // transfer rather than silently truncating it.
+    if (len / block_size() > 0xffff) {
+        whole_blocks = 0xffff;
         remaining = 0;
     }
 
@@ -123,16 +141,15 @@ bool PATADiskDevice::can_read(const FileDescription&, size_t offset) const
 
 KResultOr<size_t> PATADiskDevice::write(FileDescription&, size_t offset, const u8* inbuf, size_t len)
 {
+    account_block_io_request();
     unsigned index = offset / block_size();
     u16 whole_blocks = len / block_size();
     ssize_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
-
-    // PATAChannel will chuck a wobbly if we try to write more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
+    // read_blocks()/write_blocks() take a u16 block count; hand back a short
+    // transfer rather than silently truncating it.
+    if (len / block_size() > 0xffff) {
+        whole_blocks = 0xffff;
         remaining = 0;
     }
 
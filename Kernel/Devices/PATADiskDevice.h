@@ -65,6 +65,7 @@ public:
     virtual bool can_read(const FileDescription&, size_t) const override;
     virtual KResultOr<size_t> write(FileDescription&, size_t, const u8*, size_t) override;
     virtual bool can_write(const FileDescription&, size_t) const override;
+    virtual u16 max_blocks_per_batch() const override;
 
 protected:
     explicit PATADiskDevice(PATAChannel&, DriveType, int, int);
@@ -181,7 +181,7 @@ void SB16::dma_start(uint32_t length)
 {
     const auto addr = m_dma_region->physical_page(0)->paddr().get();
     const u8 channel = 5; // 16-bit samples use DMA channel 5 (on the master DMA controller)
-    const u8 mode = 0x48;
+    const u8 mode = 0x58; // Single transfer, auto-initialized, reading from memory
 
     // Disable the DMA channel
     IO::out8(0xd4, 4 + (channel % 4));
@@ -197,9 +197,10 @@ void SB16::dma_start(uint32_t length)
     IO::out8(0xc4, (u8)offset);
     IO::out8(0xc4, (u8)(offset >> 8));
 
-    // Write the transfer length
-    IO::out8(0xc6, (u8)(length - 1));
-    IO::out8(0xc6, (u8)((length - 1) >> 8));
+    // Write the transfer length, which 16-bit channels count in words
+    u16 words = length / 2 - 1;
+    IO::out8(0xc6, (u8)words);
+    IO::out8(0xc6, (u8)(words >> 8));
 
     // Write the buffer
     IO::out8(0x8b, addr >> 16);
@@ -210,65 +211,105 @@ void SB16::dma_start(uint32_t length)
 
 void SB16::handle_irq(const RegisterState&)
 {
-    // Stop sound output ready for the next block.
-    dsp_write(0xd5);
-
     IO::in8(DSP_STATUS); // 8 bit interrupt
     if (m_major_version >= 4)
         IO::in8(DSP_R_ACK); // 16 bit interrupt
 
-    m_irq_queue.wake_all();
-}
-
-void SB16::wait_for_irq()
-{
-    Thread::current()->wait_on(m_irq_queue, "SB16");
-    disable_irq();
-}
-
-KResultOr<size_t> SB16::write(FileDescription&, size_t, const u8* data, size_t length)
-{
-    if (!m_dma_region) {
-        auto page = MM.allocate_supervisor_physical_page();
-        auto vmobject = AnonymousVMObject::create_with_physical_page(*page);
-        m_dma_region = MM.allocate_kernel_region_with_vmobject(*vmobject, PAGE_SIZE, "SB16 DMA buffer", Region::Access::Write);
-    }
+    if (m_state == State::Stopped)
+        return;
 
-#ifdef SB16_DEBUG
-    klog() << "SB16: Writing buffer of " << length << " bytes";
-#endif
-    ASSERT(length <= PAGE_SIZE);
-    const int BLOCK_SIZE = 32 * 1024;
-    if (length > BLOCK_SIZE) {
-        return -ENOSPC;
+    // The period that was just played gets silenced, so that it doesn't repeat if nothing new is written in time.
+    memset(m_dma_region->vaddr().offset(m_play_position % ring_size).as_ptr(), 0, period_size);
+    m_play_position += period_size;
+
+    if (m_state == State::Stopping) {
+        m_state = State::Stopped;
+        m_write_position = 0;
+        m_play_position = 0;
+        disable_irq();
+    } else if (m_write_position <= m_play_position) {
+        // Nothing left to play, so leave auto-initialized mode once the (silent) current period is done.
+        dsp_write(0xd9);
+        m_state = State::Stopping;
     }
 
-    u8 mode = (u8)SampleFormat::Signed | (u8)SampleFormat::Stereo;
+    m_irq_queue.wake_all();
+}
 
+void SB16::start_playback()
+{
     const int sample_rate = 44100;
     set_sample_rate(sample_rate);
-    memcpy(m_dma_region->vaddr().as_ptr(), data, length);
-    dma_start(length);
+    dma_start(ring_size);
 
-    // 16-bit single-cycle output.
-    // FIXME: Implement auto-initialized output.
-    u8 command = 0xb0;
+    // 16-bit auto-initialized output.
+    u8 command = 0xb6;
+    u8 mode = (u8)SampleFormat::Signed | (u8)SampleFormat::Stereo;
 
-    u16 sample_count = length / sizeof(i16);
+    // The card interrupts every time it has played this many samples.
+    u16 sample_count = period_size / sizeof(i16);
     if (mode & (u8)SampleFormat::Stereo)
         sample_count /= 2;
 
     sample_count -= 1;
 
-    cli();
+    m_state = State::Running;
     enable_irq();
 
     dsp_write(command);
     dsp_write(mode);
     dsp_write((u8)sample_count);
     dsp_write((u8)(sample_count >> 8));
+}
+
+size_t SB16::free_space() const
+{
+    // Running out of samples stops playback, so the writer is never behind the card.
+    if (m_state == State::Stopping)
+        return 0;
+    return ring_size - (m_write_position - m_play_position);
+}
+
+bool SB16::can_write(const FileDescription&, size_t) const
+{
+    return free_space() > 0;
+}
+
+KResultOr<size_t> SB16::write(FileDescription&, size_t, const u8* data, size_t length)
+{
+    if (!m_dma_region) {
+        auto page = MM.allocate_supervisor_physical_page();
+        auto vmobject = AnonymousVMObject::create_with_physical_page(*page);
+        m_dma_region = MM.allocate_kernel_region_with_vmobject(*vmobject, PAGE_SIZE, "SB16 DMA buffer", Region::Access::Write);
+        memset(m_dma_region->vaddr().as_ptr(), 0, ring_size);
+    }
 
-    wait_for_irq();
+#ifdef SB16_DEBUG
+    klog() << "SB16: Writing buffer of " << length << " bytes";
+#endif
+
+    size_t nwritten = 0;
+    while (nwritten < length) {
+        cli();
+        size_t space = free_space();
+        if (!space) {
+            Thread::current()->wait_on(m_irq_queue, "SB16");
+            continue;
+        }
+        size_t offset = m_write_position % ring_size;
+        sti();
+
+        // The card never touches the free part of the ring, so it's safe to fill with interrupts on.
+        size_t chunk = min(min(space, length - nwritten), ring_size - offset);
+        memcpy(m_dma_region->vaddr().offset(offset).as_ptr(), data + nwritten, chunk);
+        nwritten += chunk;
+
+        cli();
+        m_write_position += chunk;
+        if (m_state == State::Stopped)
+            start_playback();
+        sti();
+    }
     return length;
 }
 
@@ -48,7 +48,7 @@ public:
     virtual bool can_read(const FileDescription&, size_t) const override;
     virtual KResultOr<size_t> read(FileDescription&, size_t, u8*, size_t) override;
     virtual KResultOr<size_t> write(FileDescription&, size_t, const u8*, size_t) override;
-    virtual bool can_write(const FileDescription&, size_t) const override { return true; }
+    virtual bool can_write(const FileDescription&, size_t) const override;
 
     virtual const char* purpose() const override { return class_name(); }
 
@@ -60,8 +60,9 @@ private:
     virtual const char* class_name() const override { return "SB16"; }
 
     void initialize();
-    void wait_for_irq();
     void dma_start(uint32_t length);
+    void start_playback();
+    size_t free_space() const;
     void set_sample_rate(uint16_t hz);
     void dsp_write(u8 value);
     u8 dsp_read();
@@ -69,9 +70,29 @@ private:
     void set_irq_register(u8 irq_number);
     void set_irq_line(u8 irq_number);
 
+    // Playback loops over a ring of periods with auto-initialized DMA. The card interrupts
+    // after every period, which is when that period's part of the ring can be written again.
+    static constexpr size_t period_size = 1024;
+    static constexpr size_t period_count = 4;
+    static constexpr size_t ring_size = period_size * period_count;
+    static_assert(ring_size <= PAGE_SIZE);
+
+    enum class State {
+        Stopped,
+        Running,
+        // Ran out of samples, and the card was told to stop after the current period.
+        Stopping,
+    };
+
     OwnPtr<Region> m_dma_region;
     int m_major_version { 0 };
 
+    // Both of these count bytes since playback started, and only ever go up.
+    // The card is playing the period starting at m_play_position.
+    size_t m_write_position { 0 };
+    size_t m_play_position { 0 };
+    State m_state { State::Stopped };
+
     WaitQueue m_irq_queue;
 };
 }
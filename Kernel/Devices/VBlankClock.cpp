@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Devices/VBlankClock.h>
+#include <Kernel/StdLib.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <LibC/errno_numbers.h>
+
+namespace Kernel {
+
+u64 VBlankClock::current_vblank()
+{
+    return TimeManagement::the().monotonic_nanoseconds() / refresh_interval_in_nanoseconds;
+}
+
+bool VBlankClock::can_read() const
+{
+    if (current_vblank() != m_last_read_vblank)
+        return true;
+    TimeManagement::the().request_wakeup_at((m_last_read_vblank + 1) * refresh_interval_in_nanoseconds);
+    return false;
+}
+
+KResultOr<size_t> VBlankClock::read(u8* buffer, size_t size)
+{
+    if (size < sizeof(u64))
+        return KResult(-EINVAL);
+    u64 vblank = current_vblank();
+    memcpy(buffer, &vblank, sizeof(vblank));
+    m_last_read_vblank = vblank;
+    return sizeof(vblank);
+}
+
+}
@@ -24,57 +24,95 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/Process.h>
+#include <Kernel/Tasks/SyncTask.h>
+#include <Kernel/Time/TimeManagement.h>
 
 //#define BBFS_DEBUG
 
 namespace Kernel {
 
 struct CacheEntry {
-    time_t timestamp { 0 };
+    IntrusiveListNode list_node;
     u32 block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
-    bool is_dirty { false };
 };
 
 class DiskCache {
 public:
-    explicit DiskCache(BlockBasedFS& fs)
-        : m_fs(fs)
-        , m_cached_block_data(KBuffer::create_with_size(m_entry_count * m_fs.block_size()))
-        , m_entries(KBuffer::create_with_size(m_entry_count * sizeof(CacheEntry)))
+    explicit DiskCache(BlockBasedFS& fs);
+    ~DiskCache();
+
+    // Entries handed out by get() must not go away while they're in use, so everyone using
+    // them keeps the cache pinned. Memory reclaim leaves pinned caches alone.
+    void pin()
     {
-        for (size_t i = 0; i < m_entry_count; ++i) {
-            entries()[i].data = m_cached_block_data.data() + i * m_fs.block_size();
-        }
+        ScopedSpinLock lock(m_pin_lock);
+        ++m_pin_count;
+    }
+
+    void unpin()
+    {
+        ScopedSpinLock lock(m_pin_lock);
+        ASSERT(m_pin_count);
+        --m_pin_count;
     }
 
-    ~DiskCache() { }
+    // Releases chunks that hold nothing but clean entries, coldest first, but always keeps one.
+    // Called from memory reclaim, which can't sleep or wait for the cache to be unpinned.
+    size_t try_release_clean_chunks(size_t max_page_count);
+
+    bool is_dirty() const { return !m_dirty_list.is_empty(); }
+    bool is_dirty(const CacheEntry& entry) const { return m_dirty_list.contains(entry); }
+    size_t dirty_count() const { return m_dirty_count; }
 
-    bool is_dirty() const { return m_dirty; }
-    void set_dirty(bool b) { m_dirty = b; }
+    // Both lists are kept in LRU order, most recently used entry first.
+    void mark_dirty(CacheEntry& entry)
+    {
+        if (!is_dirty(entry))
+            ++m_dirty_count;
+        m_dirty_list.prepend(entry);
+    }
+
+    void mark_clean(CacheEntry& entry)
+    {
+        if (is_dirty(entry))
+            --m_dirty_count;
+        m_clean_list.prepend(entry);
+    }
+
+    CacheEntry* find(u32 block_index) const
+    {
+        auto it = m_hash.find(block_index);
+        if (it == m_hash.end())
+            return nullptr;
+        ASSERT(it->value->block_index == block_index);
+        return it->value;
+    }
 
     CacheEntry& get(u32 block_index) const
     {
-        auto now = kgettimeofday().tv_sec;
-
-        CacheEntry* oldest_clean_entry = nullptr;
-        for (size_t i = 0; i < m_entry_count; ++i) {
-            auto& entry = const_cast<CacheEntry&>(entries()[i]);
-            if (entry.block_index == block_index) {
-                entry.timestamp = now;
-                return entry;
-            }
-            if (!entry.is_dirty) {
-                if (!oldest_clean_entry)
-                    oldest_clean_entry = &entry;
-                else if (entry.timestamp < oldest_clean_entry->timestamp)
-                    oldest_clean_entry = &entry;
-            }
+        ASSERT(m_pin_count);
+        if (auto* entry = find(block_index)) {
+            if (is_dirty(*entry))
+                m_dirty_list.prepend(*entry);
+            else
+                m_clean_list.prepend(*entry);
+            return *entry;
         }
-        if (!oldest_clean_entry) {
+
+        // Grow instead of evicting live data while there's memory to spare.
+        auto* victim = m_clean_list.last();
+        if ((!victim || is_mapped(*victim)) && should_grow())
+            const_cast<DiskCache&>(*this).grow();
+
+        if (m_clean_list.is_empty()) {
             // Not a single clean entry! Flush writes and try again.
             // NOTE: We want to make sure we only call FileBackedFS flush here,
             //       not some FileBackedFS subclass flush!
@@ -82,33 +120,183 @@ public:
             return get(block_index);
         }
 
-        // Replace the oldest clean entry.
-        auto& new_entry = *oldest_clean_entry;
-        new_entry.timestamp = now;
+        // Replace the least recently used clean entry.
+        auto& new_entry = *m_clean_list.last();
+        m_clean_list.prepend(new_entry);
+        if (is_mapped(new_entry))
+            m_hash.remove(new_entry.block_index);
+        m_hash.set(block_index, &new_entry);
         new_entry.block_index = block_index;
         new_entry.has_data = false;
-        new_entry.is_dirty = false;
         return new_entry;
     }
 
-    const CacheEntry* entries() const { return (const CacheEntry*)m_entries.data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries.data(); }
-
     template<typename Callback>
-    void for_each_entry(Callback callback)
+    void for_each_dirty_entry(Callback callback)
     {
-        for (size_t i = 0; i < m_entry_count; ++i)
-            callback(entries()[i]);
+        for (auto it = m_dirty_list.begin(); it != m_dirty_list.end();) {
+            auto& entry = *it;
+            ++it;
+            callback(entry);
+        }
     }
 
+    IntrusiveListNode m_all_disk_caches_node;
+
 private:
+    bool is_mapped(const CacheEntry& entry) const { return find(entry.block_index) == &entry; }
+
+    bool should_grow() const
+    {
+        // Let the cache use up to a quarter of the free physical memory.
+        size_t free_pages = MM.user_physical_pages() - MM.user_physical_pages_used();
+        size_t cache_bytes = m_entry_count * m_fs.block_size();
+        return cache_bytes + m_entries_per_chunk * m_fs.block_size() <= free_pages * PAGE_SIZE / 4;
+    }
+
+    void grow()
+    {
+        auto data = KBuffer::create_with_size(m_entries_per_chunk * m_fs.block_size(), Region::Access::Read | Region::Access::Write, "DiskCache");
+        auto entries = KBuffer::create_with_size(m_entries_per_chunk * sizeof(CacheEntry), Region::Access::Read | Region::Access::Write, "DiskCache entries");
+        auto* entry_array = (CacheEntry*)entries.data();
+        for (size_t i = 0; i < m_entries_per_chunk; ++i) {
+            auto& entry = *new (&entry_array[i]) CacheEntry;
+            entry.data = data.data() + i * m_fs.block_size();
+            // Unused entries go to the back of the LRU so they're picked first.
+            m_clean_list.append(entry);
+        }
+        m_cached_block_data.append(move(data));
+        m_entries.append(move(entries));
+        m_entry_count += m_entries_per_chunk;
+    }
+
+    size_t chunk_index_of(const CacheEntry& entry) const
+    {
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            auto* entry_array = (const CacheEntry*)m_entries[i].data();
+            if (&entry >= entry_array && &entry < entry_array + m_entries_per_chunk)
+                return i;
+        }
+        ASSERT_NOT_REACHED();
+    }
+
+    bool chunk_has_dirty_entries(size_t chunk_index) const
+    {
+        auto* entry_array = (const CacheEntry*)m_entries[chunk_index].data();
+        for (size_t i = 0; i < m_entries_per_chunk; ++i) {
+            if (is_dirty(entry_array[i]))
+                return true;
+        }
+        return false;
+    }
+
+    void release_chunk(size_t chunk_index)
+    {
+        auto* entry_array = (CacheEntry*)m_entries[chunk_index].data();
+        for (size_t i = 0; i < m_entries_per_chunk; ++i) {
+            auto& entry = entry_array[i];
+            if (is_mapped(entry))
+                m_hash.remove(entry.block_index);
+            m_clean_list.remove(entry);
+        }
+        m_cached_block_data.remove(chunk_index);
+        m_entries.remove(chunk_index);
+        m_entry_count -= m_entries_per_chunk;
+    }
+
     BlockBasedFS& m_fs;
-    size_t m_entry_count { 10000 };
-    KBuffer m_cached_block_data;
-    KBuffer m_entries;
-    bool m_dirty { false };
+    size_t m_entries_per_chunk { 2048 };
+    size_t m_entry_count { 0 };
+    size_t m_dirty_count { 0 };
+    Vector<KBuffer> m_cached_block_data;
+    Vector<KBuffer> m_entries;
+    mutable IntrusiveList<CacheEntry, &CacheEntry::list_node> m_dirty_list;
+    mutable IntrusiveList<CacheEntry, &CacheEntry::list_node> m_clean_list;
+    mutable HashMap<u32, CacheEntry*> m_hash;
+    SpinLock<u8> m_pin_lock;
+    size_t m_pin_count { 0 };
+};
+
+// Every DiskCache, so memory reclaim can get at them.
+static SpinLock s_all_disk_caches_lock;
+
+static IntrusiveList<DiskCache, &DiskCache::m_all_disk_caches_node>& all_disk_caches_with_lock()
+{
+    ASSERT(s_all_disk_caches_lock.is_locked());
+
+    static IntrusiveList<DiskCache, &DiskCache::m_all_disk_caches_node>* list;
+    if (!list)
+        list = new IntrusiveList<DiskCache, &DiskCache::m_all_disk_caches_node>;
+    return *list;
+}
+
+DiskCache::DiskCache(BlockBasedFS& fs)
+    : m_fs(fs)
+{
+    grow();
+    ScopedSpinLock lock(s_all_disk_caches_lock);
+    all_disk_caches_with_lock().append(*this);
+}
+
+DiskCache::~DiskCache()
+{
+    ScopedSpinLock lock(s_all_disk_caches_lock);
+    all_disk_caches_with_lock().remove(*this);
+}
+
+size_t DiskCache::try_release_clean_chunks(size_t max_page_count)
+{
+    u32 pin_flags;
+    if (!m_pin_lock.try_lock(pin_flags))
+        return 0;
+    size_t released_page_count = 0;
+    size_t pages_per_chunk = m_entries_per_chunk * m_fs.block_size() / PAGE_SIZE;
+    while (!m_pin_count && released_page_count < max_page_count && m_entries.size() > 1) {
+        // The least recently used clean entry points at the chunk that has gone coldest.
+        auto* coldest = m_clean_list.last();
+        if (!coldest)
+            break;
+        size_t chunk_index = chunk_index_of(*coldest);
+        if (chunk_has_dirty_entries(chunk_index))
+            break;
+        release_chunk(chunk_index);
+        released_page_count += pages_per_chunk;
+    }
+    m_pin_lock.unlock(pin_flags);
+    return released_page_count;
+}
+
+class ScopedDiskCachePin {
+public:
+    explicit ScopedDiskCachePin(DiskCache& cache)
+        : m_cache(cache)
+    {
+        m_cache.pin();
+    }
+    ~ScopedDiskCachePin() { m_cache.unpin(); }
+
+private:
+    DiskCache& m_cache;
 };
 
+size_t BlockBasedFS::reclaim_clean_cache_pages(size_t max_page_count)
+{
+    // We may be called with the MM lock held from anywhere, including from under this very lock.
+    u32 all_disk_caches_flags;
+    if (!s_all_disk_caches_lock.try_lock(all_disk_caches_flags))
+        return 0;
+
+    size_t released_page_count = 0;
+    for (auto& cache : all_disk_caches_with_lock()) {
+        if (released_page_count >= max_page_count)
+            break;
+        released_page_count += cache.try_release_clean_chunks(max_page_count - released_page_count);
+    }
+
+    s_all_disk_caches_lock.unlock(all_disk_caches_flags);
+    return released_page_count;
+}
+
 BlockBasedFS::BlockBasedFS(FileDescription& file_description)
     : FileBackedFS(file_description)
 {
@@ -138,16 +326,18 @@ bool BlockBasedFS::write_block(unsigned index, const u8* data, size_t count, siz
         return true;
     }
 
+    ScopedDiskCachePin pin(cache());
     auto& entry = cache().get(index);
     if (count < block_size()) {
         // Fill the cache first.
         read_block(index, nullptr, block_size());
     }
     memcpy(entry.data + offset, data, count);
-    entry.is_dirty = true;
     entry.has_data = true;
 
-    cache().set_dirty(true);
+    cache().mark_dirty(entry);
+    if (dirty_bytes() >= dirty_background_threshold())
+        SyncTask::wake();
     return true;
 }
 
@@ -219,6 +409,7 @@ bool BlockBasedFS::read_block(unsigned index, u8* buffer, size_t count, size_t o
         return true;
     }
 
+    ScopedDiskCachePin pin(cache());
     auto& entry = cache().get(index);
     if (!entry.has_data) {
         u32 base_offset = static_cast<u32>(index) * static_cast<u32>(block_size());
@@ -252,39 +443,132 @@ bool BlockBasedFS::read_blocks(unsigned index, unsigned count, u8* buffer, bool
     return true;
 }
 
+void BlockBasedFS::read_ahead_blocks(unsigned index, unsigned count) const
+{
+    ASSERT(m_logical_block_size);
+#ifdef BBFS_DEBUG
+    klog() << "BlockBasedFileSystem::read_ahead_blocks " << index << " x" << count;
+#endif
+    ScopedDiskCachePin pin(cache());
+    auto is_cached = [&](unsigned block_index) {
+        auto* entry = cache().find(block_index);
+        return entry && entry->has_data;
+    };
+
+    if (auto* device = block_device()) {
+        // Queue every missing block at once and let the elevator merge them into large transfers.
+        u16 device_blocks_per_block = block_size() / device->block_size();
+        auto buffer = KBuffer::create_with_size(count * block_size(), Region::Access::Read | Region::Access::Write, "BlockBasedFS read-ahead");
+        NonnullRefPtrVector<BlockDeviceRequest> requests;
+        Vector<unsigned> request_block_indices;
+        for (unsigned i = 0; i < count; ++i) {
+            if (is_cached(index + i))
+                continue;
+            auto request = BlockDeviceRequest::create(BlockDeviceRequest::Type::Read, (index + i) * device_blocks_per_block, device_blocks_per_block, buffer.data() + i * block_size());
+            device->submit_request(request);
+            requests.append(move(request));
+            request_block_indices.append(i);
+        }
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (requests[i].wait() != BlockDeviceRequest::Result::Success)
+                continue;
+            auto& entry = cache().get(index + request_block_indices[i]);
+            if (entry.has_data)
+                continue;
+            memcpy(entry.data, buffer.data() + request_block_indices[i] * block_size(), block_size());
+            entry.has_data = true;
+        }
+        return;
+    }
+
+    unsigned i = 0;
+    while (i < count) {
+        if (is_cached(index + i)) {
+            ++i;
+            continue;
+        }
+
+        // Read the whole run of uncached blocks in one go, then populate the cache from it.
+        unsigned run_start = i;
+        while (i < count && !is_cached(index + i))
+            ++i;
+        size_t run_size = (i - run_start) * block_size();
+        auto buffer = KBuffer::create_with_size(run_size, Region::Access::Read | Region::Access::Write, "BlockBasedFS read-ahead");
+
+        u32 base_offset = static_cast<u32>(index + run_start) * static_cast<u32>(block_size());
+        file_description().seek(base_offset, SEEK_SET);
+        size_t nread = 0;
+        while (nread < run_size) {
+            auto result = file_description().read(buffer.data() + nread, run_size - nread);
+            if (result.is_error() || result.value() == 0)
+                break;
+            nread += result.value();
+        }
+
+        for (unsigned j = 0; j < nread / block_size(); ++j) {
+            auto& entry = cache().get(index + run_start + j);
+            if (entry.has_data)
+                continue;
+            memcpy(entry.data, buffer.data() + j * block_size(), block_size());
+            entry.has_data = true;
+        }
+
+        if (nread < run_size)
+            return;
+    }
+}
+
 void BlockBasedFS::flush_specific_block_if_needed(unsigned index)
 {
     LOCKER(m_lock);
+    ScopedDiskCachePin pin(cache());
     if (!cache().is_dirty())
         return;
-    cache().for_each_entry([&](CacheEntry& entry) {
-        if (entry.is_dirty && entry.block_index == index) {
-            u32 base_offset = static_cast<u32>(entry.block_index) * static_cast<u32>(block_size());
-            file_description().seek(base_offset, SEEK_SET);
-            // FIXME: Should this error path be surfaced somehow?
-            (void)file_description().write(entry.data, block_size());
-            entry.is_dirty = false;
-        }
-    });
+    auto* entry = cache().find(index);
+    if (!entry || !cache().is_dirty(*entry))
+        return;
+    u32 base_offset = static_cast<u32>(entry->block_index) * static_cast<u32>(block_size());
+    file_description().seek(base_offset, SEEK_SET);
+    // FIXME: Should this error path be surfaced somehow?
+    (void)file_description().write(entry->data, block_size());
+    cache().mark_clean(*entry);
 }
 
 void BlockBasedFS::flush_writes_impl()
 {
     LOCKER(m_lock);
+    ScopedDiskCachePin pin(cache());
     if (!cache().is_dirty())
         return;
     u32 count = 0;
-    cache().for_each_entry([&](CacheEntry& entry) {
-        if (!entry.is_dirty)
-            return;
+    if (auto* device = block_device()) {
+        // Queue every dirty block at once so adjacent ones get merged into larger transfers.
+        u16 device_blocks_per_block = block_size() / device->block_size();
+        NonnullRefPtrVector<BlockDeviceRequest> requests;
+        Vector<CacheEntry*> entries;
+        cache().for_each_dirty_entry([&](CacheEntry& entry) {
+            auto request = BlockDeviceRequest::create(BlockDeviceRequest::Type::Write, entry.block_index * device_blocks_per_block, device_blocks_per_block, entry.data);
+            device->submit_request(request);
+            requests.append(move(request));
+            entries.append(&entry);
+        });
+        for (size_t i = 0; i < requests.size(); ++i) {
+            // FIXME: Should this error path be surfaced somehow?
+            (void)requests[i].wait();
+            cache().mark_clean(*entries[i]);
+            ++count;
+        }
+        dbg() << class_name() << ": Flushed " << count << " blocks to disk";
+        return;
+    }
+    cache().for_each_dirty_entry([&](CacheEntry& entry) {
         u32 base_offset = static_cast<u32>(entry.block_index) * static_cast<u32>(block_size());
         file_description().seek(base_offset, SEEK_SET);
         // FIXME: Should this error path be surfaced somehow?
         (void)file_description().write(entry.data, block_size());
         ++count;
-        entry.is_dirty = false;
+        cache().mark_clean(entry);
     });
-    cache().set_dirty(false);
     dbg() << class_name() << ": Flushed " << count << " blocks to disk";
 }
 
@@ -293,6 +577,56 @@ void BlockBasedFS::flush_writes()
     flush_writes_impl();
 }
 
+size_t BlockBasedFS::dirty_bytes() const
+{
+    return m_cache ? m_cache->dirty_count() * block_size() : 0;
+}
+
+size_t BlockBasedFS::dirty_background_threshold() const
+{
+    return (size_t)MM.user_physical_pages() * PAGE_SIZE / 100 * dirty_background_ratio;
+}
+
+size_t BlockBasedFS::dirty_threshold() const
+{
+    return (size_t)MM.user_physical_pages() * PAGE_SIZE / 100 * dirty_ratio;
+}
+
+void BlockBasedFS::throttle_writer()
+{
+    size_t dirty = dirty_bytes();
+    size_t background_threshold = dirty_background_threshold();
+    if (dirty < background_threshold)
+        return;
+    SyncTask::wake();
+
+    size_t threshold = dirty_threshold();
+    if (dirty >= threshold) {
+#ifdef BBFS_DEBUG
+        dbg() << class_name() << ": " << dirty << " bytes dirty, writer has to flush";
+#endif
+        flush_writes_impl();
+        return;
+    }
+
+    // Sleep for up to 100ms, depending on how close we are to the hard limit.
+    u64 max_ticks = TimeManagement::the().ticks_per_second() / 10;
+    u64 ticks = max_ticks * (dirty - background_threshold) / (threshold - background_threshold);
+    if (ticks)
+        Thread::current()->sleep(ticks);
+}
+
+BlockDevice* BlockBasedFS::block_device() const
+{
+    auto& file = file_description().file();
+    if (!file.is_block_device())
+        return nullptr;
+    auto& device = static_cast<BlockDevice&>(file);
+    if (block_size() % device.block_size() || block_size() / device.block_size() > device.max_blocks_per_batch())
+        return nullptr;
+    return &device;
+}
+
 DiskCache& BlockBasedFS::cache() const
 {
     if (!m_cache)
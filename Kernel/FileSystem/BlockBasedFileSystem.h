@@ -30,6 +30,8 @@
 
 namespace Kernel {
 
+class BlockDevice;
+
 class BlockBasedFS : public FileBackedFS {
 public:
     virtual ~BlockBasedFS() override;
@@ -39,11 +41,25 @@ public:
     virtual void flush_writes() override;
     void flush_writes_impl();
 
+    // Once dirty data crosses the background threshold (as a percentage of physical memory),
+    // SyncTask is woken up to write it back. Writers are slowed down in proportion to how far
+    // above that we are, and past the hard threshold they have to write back the cache themselves.
+    static constexpr size_t dirty_background_ratio = 10;
+    static constexpr size_t dirty_ratio = 20;
+
+    size_t dirty_bytes() const;
+    virtual void throttle_writer() override;
+
+    // Gives memory back from the block caches of all file systems, a whole cache chunk at a time.
+    // Only chunks without dirty blocks go, and caches that are busy right now are skipped.
+    static size_t reclaim_clean_cache_pages(size_t max_page_count);
+
 protected:
     explicit BlockBasedFS(FileDescription&);
 
     bool read_block(unsigned index, u8* buffer, size_t count, size_t offset = 0, bool allow_cache = true) const;
     bool read_blocks(unsigned index, unsigned count, u8* buffer, bool allow_cache = true) const;
+    void read_ahead_blocks(unsigned index, unsigned count) const;
 
     bool raw_read(unsigned index, u8* buffer);
     bool raw_write(unsigned index, const u8* buffer);
@@ -60,6 +76,12 @@ private:
     DiskCache& cache() const;
     void flush_specific_block_if_needed(unsigned index);
 
+    size_t dirty_background_threshold() const;
+    size_t dirty_threshold() const;
+
+    // The device behind our file description, if we can queue requests on it directly.
+    BlockDevice* block_device() const;
+
     mutable OwnPtr<DiskCache> m_cache;
 };
 
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/HashFunctions.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/Inode.h>
+
+namespace Kernel {
+
+static constexpr size_t max_entry_count = 1024;
+
+DirectoryEntryCache::DirectoryEntryCache()
+{
+}
+
+DirectoryEntryCache::~DirectoryEntryCache()
+{
+    InlineLinkedList<Entry> evicted;
+    {
+        LOCKER(m_lock);
+        m_entries.clear();
+        evicted.append(m_lru);
+    }
+    destroy(evicted);
+}
+
+unsigned DirectoryEntryCache::hash_for(InodeIdentifier directory, const StringView& name)
+{
+    return pair_int_hash(pair_int_hash(directory.fsid(), directory.index()), string_hash(name.characters_without_null_termination(), name.length()));
+}
+
+DirectoryEntryCache::Entry* DirectoryEntryCache::find(InodeIdentifier directory, const StringView& name, unsigned hash)
+{
+    auto it = m_entries.find(hash, [&](auto* entry) { return entry->directory == directory && entry->name == name; });
+    if (it == m_entries.end())
+        return nullptr;
+    return *it;
+}
+
+void DirectoryEntryCache::evict(Entry& entry, InlineLinkedList<Entry>& evicted)
+{
+    m_entries.remove(&entry);
+    m_lru.remove(&entry);
+    evicted.append(&entry);
+}
+
+void DirectoryEntryCache::destroy(InlineLinkedList<Entry>& entries)
+{
+    // This is done without holding m_lock, since dropping the last reference to an inode
+    // may well call back into the file system, which may call back into us.
+    while (auto* entry = entries.remove_head())
+        delete entry;
+}
+
+RefPtr<Inode> DirectoryEntryCache::lookup(Inode& directory, const StringView& name)
+{
+    if (!directory.fs().supports_lookup_cache())
+        return directory.lookup(name);
+
+    auto directory_id = directory.identifier();
+    unsigned hash = hash_for(directory_id, name);
+    u64 generation;
+    {
+        LOCKER(m_lock);
+        if (auto* entry = find(directory_id, name, hash)) {
+            m_lru.remove(entry);
+            m_lru.prepend(entry);
+            return entry->inode;
+        }
+        generation = m_generation;
+    }
+
+    auto inode = directory.lookup(name);
+
+    InlineLinkedList<Entry> evicted;
+    {
+        LOCKER(m_lock);
+        if (generation != m_generation || find(directory_id, name, hash))
+            return inode;
+        auto* entry = new Entry(directory_id, name, hash, RefPtr<Inode>(inode));
+        m_entries.set(entry);
+        m_lru.prepend(entry);
+        if (m_entries.size() > max_entry_count)
+            evict(*m_lru.tail(), evicted);
+    }
+    destroy(evicted);
+    return inode;
+}
+
+void DirectoryEntryCache::invalidate(InodeIdentifier directory, const StringView& name)
+{
+    InlineLinkedList<Entry> evicted;
+    {
+        LOCKER(m_lock);
+        ++m_generation;
+        if (auto* entry = find(directory, name, hash_for(directory, name)))
+            evict(*entry, evicted);
+    }
+    destroy(evicted);
+}
+
+void DirectoryEntryCache::invalidate_directory(InodeIdentifier directory)
+{
+    InlineLinkedList<Entry> evicted;
+    {
+        LOCKER(m_lock);
+        ++m_generation;
+        for (auto* entry = m_lru.head(); entry;) {
+            auto* next = entry->next();
+            if (entry->directory == directory)
+                evict(*entry, evicted);
+            entry = next;
+        }
+    }
+    destroy(evicted);
+}
+
+void DirectoryEntryCache::invalidate_fs(u32 fsid)
+{
+    InlineLinkedList<Entry> evicted;
+    {
+        LOCKER(m_lock);
+        ++m_generation;
+        for (auto* entry = m_lru.head(); entry;) {
+            auto* next = entry->next();
+            if (entry->directory.fsid() == fsid)
+                evict(*entry, evicted);
+            entry = next;
+        }
+    }
+    destroy(evicted);
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashTable.h>
+#include <AK/InlineLinkedList.h>
+#include <AK/RefPtr.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/InodeIdentifier.h>
+#include <Kernel/Lock.h>
+
+namespace Kernel {
+
+// Remembers what each (directory, name) pair resolved to, including names that turned out
+// not to exist, so that path resolution doesn't have to ask the file system every time.
+// Only file systems that report every change to their directories through
+// Inode::did_add_child() and Inode::did_remove_child() take part; see FS::supports_lookup_cache().
+class DirectoryEntryCache {
+    AK_MAKE_NONCOPYABLE(DirectoryEntryCache);
+
+public:
+    DirectoryEntryCache();
+    ~DirectoryEntryCache();
+
+    RefPtr<Inode> lookup(Inode& directory, const StringView& name);
+
+    void invalidate(InodeIdentifier directory, const StringView& name);
+    void invalidate_directory(InodeIdentifier directory);
+    void invalidate_fs(u32 fsid);
+
+private:
+    struct Entry : public InlineLinkedListNode<Entry> {
+        Entry(InodeIdentifier a_directory, const StringView& a_name, unsigned a_hash, RefPtr<Inode>&& a_inode)
+            : directory(a_directory)
+            , name(a_name)
+            , hash(a_hash)
+            , inode(move(a_inode))
+        {
+        }
+
+        InodeIdentifier directory;
+        String name;
+        unsigned hash { 0 };
+        RefPtr<Inode> inode; // Null for names that don't exist.
+
+        // For InlineLinkedListNode.
+        Entry* m_next { nullptr };
+        Entry* m_prev { nullptr };
+    };
+
+    struct EntryTraits : public GenericTraits<Entry*> {
+        static unsigned hash(const Entry* entry) { return entry->hash; }
+        static bool equals(const Entry* a, const Entry* b) { return a->directory == b->directory && a->name == b->name; }
+    };
+
+    static unsigned hash_for(InodeIdentifier directory, const StringView& name);
+    Entry* find(InodeIdentifier directory, const StringView& name, unsigned hash);
+    void evict(Entry&, InlineLinkedList<Entry>& evicted);
+    static void destroy(InlineLinkedList<Entry>&);
+
+    Lock m_lock { "DirectoryEntryCache" };
+    HashTable<Entry*, EntryTraits> m_entries;
+    // Most recently used first.
+    InlineLinkedList<Entry> m_lru;
+    // Bumped whenever anything is invalidated, so that a lookup that raced with a change
+    // to the directory knows not to cache its possibly stale result.
+    u64 m_generation { 0 };
+};
+
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+NonnullRefPtr<EventPoll> EventPoll::create()
+{
+    return adopt(*new EventPoll);
+}
+
+EventPoll::EventPoll()
+{
+}
+
+EventPoll::~EventPoll()
+{
+}
+
+KResult EventPoll::add(int fd, FileDescription& description, u32 events, u64 data)
+{
+    // Watching other event polls would let them keep each other alive.
+    if (description.file().is_event_poll())
+        return KResult(-EINVAL);
+
+    ScopedSpinLock lock(m_lock);
+    auto it = m_interests.find(fd);
+    // If the fd was closed and reused without being removed first, the old entry is stale.
+    if (it != m_interests.end() && it->value.description == &description)
+        return KResult(-EEXIST);
+    m_interests.set(fd, { description, events, data });
+    return KSuccess;
+}
+
+KResult EventPoll::modify(int fd, FileDescription& description, u32 events, u64 data)
+{
+    ScopedSpinLock lock(m_lock);
+    auto it = m_interests.find(fd);
+    if (it == m_interests.end() || it->value.description != &description)
+        return KResult(-ENOENT);
+    it->value.events = events;
+    it->value.data = data;
+    return KSuccess;
+}
+
+KResult EventPoll::remove(int fd)
+{
+    RefPtr<FileDescription> description;
+    {
+        ScopedSpinLock lock(m_lock);
+        auto it = m_interests.find(fd);
+        if (it == m_interests.end())
+            return KResult(-ENOENT);
+        // Don't drop what might be the last reference while holding the lock.
+        description = move(it->value.description);
+        m_interests.remove(it);
+    }
+    return KSuccess;
+}
+
+u32 EventPoll::ready_events(const Interest& interest)
+{
+    u32 events = 0;
+    if ((interest.events & EPOLLIN) && interest.description->can_read())
+        events |= EPOLLIN;
+    if ((interest.events & EPOLLOUT) && interest.description->can_write())
+        events |= EPOLLOUT;
+    return events;
+}
+
+bool EventPoll::has_ready_events() const
+{
+    ScopedSpinLock lock(m_lock);
+    for (auto& it : m_interests) {
+        if (ready_events(it.value))
+            return true;
+    }
+    return false;
+}
+
+size_t EventPoll::collect_ready_events(const Process& process, epoll_event* events, size_t max_events) const
+{
+    ScopedSpinLock lock(m_lock);
+    size_t count = 0;
+    for (auto& it : m_interests) {
+        if (count == max_events)
+            break;
+        u32 ready = ready_events(it.value);
+        if (!ready)
+            continue;
+        // Descriptions that are no longer open under this fd are left for remove() to clean up.
+        if (process.file_description(it.key) != it.value.description)
+            continue;
+        events[count].events = ready;
+        events[count].data.u64 = it.value.data;
+        ++count;
+    }
+    return count;
+}
+
+}
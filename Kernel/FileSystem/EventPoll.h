@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+// A persistent set of file descriptions to watch for readiness, so that waiting doesn't
+// have to rebuild (and re-validate) the whole interest set every time like select() and poll().
+class EventPoll final : public File {
+public:
+    static NonnullRefPtr<EventPoll> create();
+    virtual ~EventPoll() override;
+
+    KResult add(int fd, FileDescription&, u32 events, u64 data);
+    KResult modify(int fd, FileDescription&, u32 events, u64 data);
+    KResult remove(int fd);
+
+    // Whether any of the watched descriptions is ready for what it's watched for.
+    bool has_ready_events() const;
+
+    // Fills in the events that are ready for descriptions that are still open in the given
+    // process under the fd they were added with.
+    size_t collect_ready_events(const Process&, epoll_event* events, size_t max_events) const;
+
+    virtual bool can_read(const FileDescription&, size_t) const override { return has_ready_events(); }
+    virtual bool can_write(const FileDescription&, size_t) const override { return false; }
+    virtual KResultOr<size_t> read(FileDescription&, size_t, u8*, size_t) override { return KResult(-EINVAL); }
+    virtual KResultOr<size_t> write(FileDescription&, size_t, const u8*, size_t) override { return KResult(-EINVAL); }
+    virtual String absolute_path(const FileDescription&) const override { return "EventPoll"; }
+    virtual const char* class_name() const override { return "EventPoll"; }
+    virtual bool is_event_poll() const override { return true; }
+
+private:
+    EventPoll();
+
+    struct Interest {
+        RefPtr<FileDescription> description;
+        u32 events { 0 };
+        u64 data { 0 };
+    };
+
+    static u32 ready_events(const Interest&);
+
+    mutable SpinLock<u8> m_lock;
+    HashMap<int, Interest> m_interests;
+};
+
+}
@@ -27,11 +27,13 @@
 #include <AK/Bitmap.h>
 #include <AK/BufferStream.h>
 #include <AK/HashMap.h>
+#include <AK/QuickSort.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringView.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/Ext2FileSystem.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/FileSystem/ext2_fs.h>
 #include <Kernel/Process.h>
 #include <Kernel/UnixTypes.h>
@@ -44,6 +46,13 @@ namespace Kernel {
 static const size_t max_link_count = 65535;
 static const size_t max_block_size = 4096;
 static const ssize_t max_inline_symlink_length = 60;
+static const size_t initial_read_ahead_blocks = 4;
+static const size_t max_read_ahead_blocks = 64;
+static const size_t initial_block_reservation_size = 8;
+static const size_t max_block_reservation_size = 256;
+static const size_t max_block_reservation_count = 64;
+static const size_t max_delayed_bytes_per_inode = 256 * KiB;
+static const size_t max_delayed_bytes = 4 * MiB;
 
 struct Ext2FSDirectoryEntry {
     String name;
@@ -70,6 +79,164 @@ static u8 to_ext2_file_type(mode_t mode)
     return EXT2_FT_UNKNOWN;
 }
 
+// The directory index hashes, as defined by the Linux ext2/3/4 implementation.
+// The "unsigned" variants only differ in how they treat bytes above 0x7f.
+static const u8 hash_version_unsigned_offset = EXT2_HASH_LEGACY_UNSIGNED - EXT2_HASH_LEGACY;
+static const u32 htree_eof = 0x7fffffff;
+
+static u32 dx_hack_hash(const StringView& name, bool is_unsigned)
+{
+    u32 hash = 0;
+    u32 hash0 = 0x12a3fe2d;
+    u32 hash1 = 0x37abe8f9;
+    for (size_t i = 0; i < name.length(); ++i) {
+        int c = is_unsigned ? (int)(u8)name[i] : (int)(i8)name[i];
+        hash = hash1 + (hash0 ^ (c * 7152373));
+        if (hash & 0x80000000)
+            hash -= 0x7fffffff;
+        hash1 = hash0;
+        hash0 = hash;
+    }
+    return hash0 << 1;
+}
+
+static void str2hashbuf(const char* message, size_t length, u32* buffer, int count, bool is_unsigned)
+{
+    u32 pad = (u32)length | ((u32)length << 8);
+    pad |= pad << 16;
+
+    u32 value = pad;
+    if (length > (size_t)count * 4)
+        length = count * 4;
+    for (size_t i = 0; i < length; ++i) {
+        int c = is_unsigned ? (int)(u8)message[i] : (int)(i8)message[i];
+        value = c + (value << 8);
+        if ((i % 4) == 3) {
+            *buffer++ = value;
+            value = pad;
+            --count;
+        }
+    }
+    if (--count >= 0)
+        *buffer++ = value;
+    while (--count >= 0)
+        *buffer++ = pad;
+}
+
+static void tea_transform(u32* buffer, const u32* in)
+{
+    u32 sum = 0;
+    u32 b0 = buffer[0];
+    u32 b1 = buffer[1];
+    for (int n = 0; n < 16; ++n) {
+        sum += 0x9e3779b9;
+        b0 += ((b1 << 4) + in[0]) ^ (b1 + sum) ^ ((b1 >> 5) + in[1]);
+        b1 += ((b0 << 4) + in[2]) ^ (b0 + sum) ^ ((b0 >> 5) + in[3]);
+    }
+    buffer[0] += b0;
+    buffer[1] += b1;
+}
+
+static inline u32 rotate_left(u32 value, int shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+static void half_md4_transform(u32* buffer, const u32* in)
+{
+    auto f = [](u32 x, u32 y, u32 z) { return z ^ (x & (y ^ z)); };
+    auto g = [](u32 x, u32 y, u32 z) { return (x & y) + ((x ^ y) & z); };
+    auto h = [](u32 x, u32 y, u32 z) { return x ^ y ^ z; };
+    const u32 k2 = 013240474631u;
+    const u32 k3 = 015666365641u;
+
+    u32 a = buffer[0];
+    u32 b = buffer[1];
+    u32 c = buffer[2];
+    u32 d = buffer[3];
+
+#define ROUND(fn, a, b, c, d, x, s) (a += fn(b, c, d) + (x), a = rotate_left(a, s))
+    ROUND(f, a, b, c, d, in[0], 3);
+    ROUND(f, d, a, b, c, in[1], 7);
+    ROUND(f, c, d, a, b, in[2], 11);
+    ROUND(f, b, c, d, a, in[3], 19);
+    ROUND(f, a, b, c, d, in[4], 3);
+    ROUND(f, d, a, b, c, in[5], 7);
+    ROUND(f, c, d, a, b, in[6], 11);
+    ROUND(f, b, c, d, a, in[7], 19);
+
+    ROUND(g, a, b, c, d, in[1] + k2, 3);
+    ROUND(g, d, a, b, c, in[3] + k2, 5);
+    ROUND(g, c, d, a, b, in[5] + k2, 9);
+    ROUND(g, b, c, d, a, in[7] + k2, 13);
+    ROUND(g, a, b, c, d, in[0] + k2, 3);
+    ROUND(g, d, a, b, c, in[2] + k2, 5);
+    ROUND(g, c, d, a, b, in[4] + k2, 9);
+    ROUND(g, b, c, d, a, in[6] + k2, 13);
+
+    ROUND(h, a, b, c, d, in[3] + k3, 3);
+    ROUND(h, d, a, b, c, in[7] + k3, 9);
+    ROUND(h, c, d, a, b, in[2] + k3, 11);
+    ROUND(h, b, c, d, a, in[6] + k3, 15);
+    ROUND(h, a, b, c, d, in[1] + k3, 3);
+    ROUND(h, d, a, b, c, in[5] + k3, 9);
+    ROUND(h, c, d, a, b, in[0] + k3, 11);
+    ROUND(h, b, c, d, a, in[4] + k3, 15);
+#undef ROUND
+
+    buffer[0] += a;
+    buffer[1] += b;
+    buffer[2] += c;
+    buffer[3] += d;
+}
+
+static u32 ext2_directory_hash(const StringView& name, u8 hash_version, const u32* seed)
+{
+    u32 buffer[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    if (seed[0] || seed[1] || seed[2] || seed[3])
+        memcpy(buffer, seed, sizeof(buffer));
+
+    bool is_unsigned = hash_version >= EXT2_HASH_LEGACY_UNSIGNED;
+    u32 hash = 0;
+    u32 in[8];
+    switch (hash_version) {
+    case EXT2_HASH_LEGACY:
+    case EXT2_HASH_LEGACY_UNSIGNED:
+        hash = dx_hack_hash(name, is_unsigned);
+        break;
+    case EXT2_HASH_HALF_MD4:
+    case EXT2_HASH_HALF_MD4_UNSIGNED:
+        for (size_t offset = 0; offset < name.length(); offset += 32) {
+            str2hashbuf(name.characters_without_null_termination() + offset, name.length() - offset, in, 8, is_unsigned);
+            half_md4_transform(buffer, in);
+        }
+        hash = buffer[1];
+        break;
+    case EXT2_HASH_TEA:
+    case EXT2_HASH_TEA_UNSIGNED:
+        for (size_t offset = 0; offset < name.length(); offset += 16) {
+            str2hashbuf(name.characters_without_null_termination() + offset, name.length() - offset, in, 4, is_unsigned);
+            tea_transform(buffer, in);
+        }
+        hash = buffer[0];
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+
+    hash &= ~1u;
+    if (hash == (htree_eof << 1))
+        hash = (htree_eof - 1) << 1;
+    return hash;
+}
+
+// The root of the index hides behind the "." and ".." entries of the directory's first block,
+// and the other index blocks behind a single empty entry, so that they all still look like
+// ordinary directory blocks to anything that doesn't know about the index.
+static const size_t dx_root_info_offset = EXT2_DIR_REC_LEN(1) + EXT2_DIR_REC_LEN(2);
+static const size_t dx_node_entries_offset = EXT2_DIR_REC_LEN(0);
+static const u32 dx_block_mask = 0x0fffffff;
+
 NonnullRefPtr<Ext2FS> Ext2FS::create(FileDescription& file_description)
 {
     return adopt(*new Ext2FS(file_description));
@@ -507,6 +674,8 @@ void Ext2FS::free_inode(Ext2FSInode& inode)
     inode.m_raw_inode.i_dtime = now.tv_sec;
     write_ext2_inode(inode.index(), inode.m_raw_inode);
 
+    m_block_reservations.remove(inode.index());
+    inode.discard_delayed_blocks();
     auto block_list = block_list_for_inode(inode.m_raw_inode, true);
 
     for (auto block_index : block_list) {
@@ -518,6 +687,10 @@ void Ext2FS::free_inode(Ext2FSInode& inode)
     set_inode_allocation_state(inode.index(), false);
 
     if (inode.is_directory()) {
+        // Its index may soon be handed out to a new directory, which mustn't inherit what
+        // we remembered about this one's (non-existent) contents.
+        VFS::the().directory_entry_cache().invalidate_directory(inode.identifier());
+
         auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index_from_inode(inode.index())));
         --bgd.bg_used_dirs_count;
         dbg() << "Ext2FS: Decremented bg_used_dirs_count to " << bgd.bg_used_dirs_count;
@@ -590,7 +763,7 @@ InodeMetadata Ext2FSInode::metadata() const
     LOCKER(m_lock);
     InodeMetadata metadata;
     metadata.inode = identifier();
-    metadata.size = m_raw_inode.i_size;
+    metadata.size = logical_size();
     metadata.mode = m_raw_inode.i_mode;
     metadata.uid = m_raw_inode.i_uid;
     metadata.gid = m_raw_inode.i_gid;
@@ -618,6 +791,9 @@ void Ext2FSInode::flush_metadata()
 #ifdef EXT2_DEBUG
     dbg() << "Ext2FS: flush_metadata for inode " << identifier();
 #endif
+    auto result = flush_delayed_blocks();
+    if (result.is_error())
+        dbg() << "Ext2FS: Failed to flush delayed writes for inode " << identifier() << ": " << result.error();
     fs().write_ext2_inode(index(), m_raw_inode);
     if (is_directory()) {
         // Unless we're about to go away permanently, invalidate the lookup cache.
@@ -657,6 +833,31 @@ RefPtr<Inode> Ext2FS::get_inode(InodeIdentifier inode) const
 }
 
 ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, u8* buffer, FileDescription* description) const
+{
+    Locker inode_locker(m_lock);
+    ASSERT(offset >= 0);
+    if (!m_delayed_size)
+        return read_bytes_from_blocks(offset, count, buffer, description);
+
+    // The tail of the file hasn't been written to disk yet, so that part comes straight from memory.
+    u64 disk_size = size();
+    ssize_t nread = 0;
+    if (static_cast<u64>(offset) < disk_size) {
+        ssize_t count_on_disk = min(static_cast<u64>(count), disk_size - offset);
+        nread = read_bytes_from_blocks(offset, count_on_disk, buffer, description);
+        if (nread < count_on_disk)
+            return nread;
+    }
+
+    u64 delayed_offset = offset + nread - disk_size;
+    if (delayed_offset >= m_delayed_size)
+        return nread;
+    size_t delayed_count = min(static_cast<size_t>(count - nread), m_delayed_size - static_cast<size_t>(delayed_offset));
+    memcpy(buffer + nread, m_delayed_data.value().data() + delayed_offset, delayed_count);
+    return nread + delayed_count;
+}
+
+ssize_t Ext2FSInode::read_bytes_from_blocks(off_t offset, ssize_t count, u8* buffer, FileDescription* description) const
 {
     Locker inode_locker(m_lock);
     ASSERT(offset >= 0);
@@ -701,6 +902,9 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, u8* buffer, FileDes
     dbg() << "Ext2FS: Reading up to " << count << " bytes " << offset << " bytes into inode " << identifier() << " to " << (const void*)buffer;
 #endif
 
+    if (allow_cache && description)
+        read_ahead(*description, offset, first_block_logical_index, last_block_logical_index);
+
     for (size_t bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; ++bi) {
         auto block_index = m_block_list[bi];
         ASSERT(block_index);
@@ -716,9 +920,69 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, u8* buffer, FileDes
         out += num_bytes_to_copy;
     }
 
+    if (allow_cache && description)
+        description->read_ahead_state().next_offset = offset + nread;
+
     return nread;
 }
 
+void Ext2FSInode::read_ahead(FileDescription& description, off_t offset, size_t first_block_logical_index, size_t last_block_logical_index) const
+{
+    auto& state = description.read_ahead_state();
+    if (offset != state.next_offset) {
+        // Not a sequential read, start over with no read-ahead.
+        state.window = 0;
+        state.prefetched_until = 0;
+        return;
+    }
+
+    state.window = state.window ? min(state.window * 2, max_read_ahead_blocks) : initial_read_ahead_blocks;
+
+    // Keep at least half a window ahead of the reader before fetching more.
+    if (last_block_logical_index + 1 + state.window / 2 <= state.prefetched_until)
+        return;
+
+    size_t start = max(first_block_logical_index, state.prefetched_until);
+    size_t end = min(last_block_logical_index + 1 + state.window, m_block_list.size());
+    if (start >= end)
+        return;
+
+#ifdef EXT2_DEBUG
+    dbg() << "Ext2FS: Read-ahead of logical blocks " << start << "-" << end - 1 << " for inode " << identifier();
+#endif
+
+    read_ahead_block_range(start, end);
+    state.prefetched_until = end;
+}
+
+void Ext2FSInode::read_ahead_block_range(size_t start, size_t end) const
+{
+    // Fetch each physically contiguous run of blocks with a single request.
+    size_t run_start = start;
+    for (size_t bi = start + 1; bi <= end; ++bi) {
+        if (bi < end && m_block_list[bi] == m_block_list[bi - 1] + 1)
+            continue;
+        fs().read_ahead_blocks(m_block_list[run_start], bi - run_start);
+        run_start = bi;
+    }
+}
+
+void Ext2FSInode::read_ahead_pages(size_t first_page_index, size_t page_count)
+{
+    Locker inode_locker(m_lock);
+    Locker fs_locker(fs().m_lock);
+
+    if (m_block_list.is_empty())
+        m_block_list = fs().block_list_for_inode(m_raw_inode);
+
+    size_t block_size = fs().block_size();
+    size_t start = first_page_index * PAGE_SIZE / block_size;
+    size_t end = min(ceil_div((first_page_index + page_count) * PAGE_SIZE, block_size), m_block_list.size());
+    if (start >= end)
+        return;
+    read_ahead_block_range(start, end);
+}
+
 KResult Ext2FSInode::resize(u64 new_size)
 {
     u64 old_size = size();
@@ -736,15 +1000,21 @@ KResult Ext2FSInode::resize(u64 new_size)
 
     if (blocks_needed_after > blocks_needed_before) {
         u32 additional_blocks_needed = blocks_needed_after - blocks_needed_before;
-        if (additional_blocks_needed > fs().super_block().s_free_blocks_count)
+        // Blocks already promised to delayed writes aren't ours to take.
+        u32 free_blocks = fs().super_block().s_free_blocks_count;
+        free_blocks -= min(free_blocks, static_cast<u32>(fs().m_delayed_block_count));
+        if (additional_blocks_needed > free_blocks)
             return KResult(-ENOSPC);
     }
 
     auto block_list = fs().block_list_for_inode(m_raw_inode);
     if (blocks_needed_after > blocks_needed_before) {
-        auto new_blocks = fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before);
+        // Aim for the block right after our last one, so that the file stays contiguous.
+        Ext2FS::BlockIndex goal = block_list.is_empty() ? 0 : block_list.last() + 1;
+        auto new_blocks = fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before, index(), goal);
         block_list.append(move(new_blocks));
     } else if (blocks_needed_after < blocks_needed_before) {
+        fs().discard_block_reservation(index());
 #ifdef EXT2_DEBUG
         dbg() << "Ext2FS: Shrinking inode " << identifier() << ". Old block list is " << block_list.size() << " entries:";
         for (auto block_index : block_list) {
@@ -797,6 +1067,141 @@ ssize_t Ext2FSInode::write_bytes(off_t offset, ssize_t count, const u8* data, Fi
 
     bool allow_cache = !description || !description->is_direct();
 
+    if (!allow_cache || !Kernel::is_regular_file(m_raw_inode.i_mode)) {
+        auto flush_result = flush_delayed_blocks();
+        if (flush_result.is_error())
+            return flush_result;
+        return write_bytes_to_blocks(offset, count, data, allow_cache);
+    }
+
+    // Anything written past the last block we have is held back until the inode gets flushed,
+    // so that a file written in small pieces gets its blocks in a few large contiguous runs.
+    const size_t block_size = fs().block_size();
+    u64 end = static_cast<u64>(offset) + count;
+    u64 delayed_start = ceil_div(static_cast<u64>(size()), static_cast<u64>(block_size)) * block_size;
+    if (end <= delayed_start)
+        return write_bytes_to_blocks(offset, count, data, true);
+
+    if (static_cast<u64>(offset) > logical_size()) {
+        // Leaving a hole, let the regular path take care of that.
+        auto flush_result = flush_delayed_blocks();
+        if (flush_result.is_error())
+            return flush_result;
+        return write_bytes_to_blocks(offset, count, data, true);
+    }
+
+    ssize_t nwritten = 0;
+    if (static_cast<u64>(offset) < delayed_start) {
+        nwritten = write_bytes_to_blocks(offset, delayed_start - offset, data, true);
+        if (nwritten < 0)
+            return nwritten;
+    }
+
+    auto ndelayed = write_delayed_bytes(offset + nwritten, count - nwritten, data + nwritten);
+    if (ndelayed < 0)
+        return nwritten ? nwritten : ndelayed;
+    return nwritten + ndelayed;
+}
+
+ssize_t Ext2FSInode::write_delayed_bytes(off_t offset, size_t count, const u8* data)
+{
+    const size_t block_size = fs().block_size();
+    u64 disk_size = size();
+    ASSERT(disk_size % block_size == 0);
+    ASSERT(static_cast<u64>(offset) >= disk_size && static_cast<u64>(offset) <= logical_size());
+
+    size_t delayed_offset = offset - disk_size;
+    size_t delayed_end = delayed_offset + count;
+    size_t additional_blocks = 0;
+    if (delayed_end > m_delayed_size)
+        additional_blocks = ceil_div(delayed_end, block_size) - ceil_div(m_delayed_size, block_size);
+
+    size_t delayed_block_count = fs().m_delayed_block_count + additional_blocks;
+    if (delayed_end > max_delayed_bytes_per_inode
+        || delayed_block_count * block_size > max_delayed_bytes
+        || delayed_block_count > fs().super_block().s_free_blocks_count) {
+        // That's more than we're willing to hold on to, so write out what we have and do this one right away.
+        auto flush_result = flush_delayed_blocks();
+        if (flush_result.is_error())
+            return flush_result;
+        return write_bytes_to_blocks(offset, count, data, true);
+    }
+
+#ifdef EXT2_DEBUG
+    dbg() << "Ext2FS: Delaying write of " << count << " bytes at offset " << offset << " into inode " << identifier();
+#endif
+
+    if (!m_delayed_data.has_value())
+        m_delayed_data = KBuffer::create_with_size(max_delayed_bytes_per_inode, Region::Access::Read | Region::Access::Write, "Ext2FS: Delayed writes");
+    memcpy(m_delayed_data.value().data() + delayed_offset, data, count);
+
+    u64 old_size = logical_size();
+    if (delayed_end > m_delayed_size) {
+        fs().m_delayed_block_count += additional_blocks;
+        m_delayed_size = delayed_end;
+    }
+    set_metadata_dirty(true);
+
+    if (old_size != logical_size())
+        inode_size_changed(old_size, logical_size());
+    inode_contents_changed(offset, count, data);
+    return count;
+}
+
+KResult Ext2FSInode::flush_delayed_blocks()
+{
+    LOCKER(m_lock);
+    if (!m_delayed_size)
+        return KSuccess;
+
+    Locker fs_locker(fs().m_lock);
+    const size_t block_size = fs().block_size();
+    size_t first_block_logical_index = size() / block_size;
+    size_t block_count = ceil_div(m_delayed_size, block_size);
+
+#ifdef EXT2_DEBUG
+    dbg() << "Ext2FS: Flushing " << m_delayed_size << " delayed bytes (" << block_count << " blocks) of inode " << identifier();
+#endif
+
+    // resize() is about to allocate the blocks we've been holding on to, all in one go.
+    fs().m_delayed_block_count -= block_count;
+    auto result = resize(logical_size());
+    if (result.is_error()) {
+        fs().m_delayed_block_count += block_count;
+        return result;
+    }
+
+    if (m_block_list.is_empty())
+        m_block_list = fs().block_list_for_inode(m_raw_inode);
+
+    size_t delayed_size = m_delayed_size;
+    auto delayed_data = m_delayed_data.release_value();
+    m_delayed_size = 0;
+
+    for (size_t i = 0; i < block_count; ++i) {
+        size_t offset = i * block_size;
+        auto block_index = m_block_list[first_block_logical_index + i];
+        bool success = fs().write_block(block_index, delayed_data.data() + offset, min(block_size, delayed_size - offset), 0, true);
+        if (!success) {
+            dbg() << "Ext2FS: write_block(" << block_index << ") failed while flushing delayed writes";
+            return KResult(-EIO);
+        }
+    }
+    return KSuccess;
+}
+
+void Ext2FSInode::discard_delayed_blocks()
+{
+    fs().m_delayed_block_count -= ceil_div(m_delayed_size, static_cast<size_t>(fs().block_size()));
+    m_delayed_size = 0;
+    m_delayed_data.clear();
+}
+
+ssize_t Ext2FSInode::write_bytes_to_blocks(off_t offset, ssize_t count, const u8* data, bool allow_cache)
+{
+    Locker inode_locker(m_lock);
+    Locker fs_locker(fs().m_lock);
+
     const size_t block_size = fs().block_size();
     u64 old_size = size();
     u64 new_size = max(static_cast<u64>(offset) + count, (u64)size());
@@ -937,6 +1342,8 @@ bool Ext2FSInode::write_directory(const Vector<Ext2FSDirectoryEntry>& entries)
     ssize_t nwritten = write_bytes(0, directory_data.size(), directory_data.data(), nullptr);
     if (nwritten < 0)
         return false;
+    // Whatever index there was is gone now.
+    m_raw_inode.i_flags &= ~EXT2_INDEX_FL;
     set_metadata_dirty(true);
     return static_cast<size_t>(nwritten) == directory_data.size();
 }
@@ -948,6 +1355,419 @@ KResultOr<NonnullRefPtr<Inode>> Ext2FSInode::create_child(const String& name, mo
     return fs().create_inode(identifier(), name, mode, 0, dev, uid, gid);
 }
 
+static ext2_dir_entry_2* directory_entry_at(u8* block, size_t offset)
+{
+    return reinterpret_cast<ext2_dir_entry_2*>(block + offset);
+}
+
+static bool find_entry_in_directory_block(u8* block, size_t block_size, const StringView& name, size_t& offset, Optional<size_t>& previous_offset)
+{
+    previous_offset = {};
+    for (offset = 0; offset + 8 <= block_size;) {
+        auto* entry = directory_entry_at(block, offset);
+        if (entry->rec_len < 8 || offset + entry->rec_len > block_size)
+            return false;
+        if (entry->inode && name == StringView(entry->name, entry->name_len))
+            return true;
+        previous_offset = offset;
+        offset += entry->rec_len;
+    }
+    return false;
+}
+
+static void fill_directory_entry(ext2_dir_entry_2& entry, const StringView& name, unsigned inode, u8 file_type)
+{
+    entry.inode = inode;
+    entry.name_len = name.length();
+    entry.file_type = file_type;
+    memcpy(entry.name, name.characters_without_null_termination(), name.length());
+}
+
+// Puts the new entry into the first gap in the block that's big enough for it.
+static bool insert_entry_into_directory_block(u8* block, size_t block_size, const StringView& name, unsigned inode, u8 file_type)
+{
+    size_t needed = EXT2_DIR_REC_LEN(name.length());
+    for (size_t offset = 0; offset + 8 <= block_size;) {
+        auto* entry = directory_entry_at(block, offset);
+        if (entry->rec_len < 8 || offset + entry->rec_len > block_size)
+            return false;
+        size_t used = entry->inode ? EXT2_DIR_REC_LEN(entry->name_len) : 0;
+        if (entry->rec_len - used >= needed) {
+            if (used) {
+                auto* new_entry = directory_entry_at(block, offset + used);
+                new_entry->rec_len = entry->rec_len - used;
+                entry->rec_len = used;
+                entry = new_entry;
+            }
+            fill_directory_entry(*entry, name, inode, file_type);
+            return true;
+        }
+        offset += entry->rec_len;
+    }
+    return false;
+}
+
+// Lays out the given entries one after the other, with the last one taking up the rest of the block.
+static void pack_directory_block(u8* block, size_t block_size, const Vector<ext2_dir_entry_2*>& entries)
+{
+    memset(block, 0, block_size);
+    if (entries.is_empty()) {
+        directory_entry_at(block, 0)->rec_len = block_size;
+        return;
+    }
+    size_t offset = 0;
+    ext2_dir_entry_2* last_entry = nullptr;
+    for (auto* entry : entries) {
+        last_entry = directory_entry_at(block, offset);
+        last_entry->rec_len = EXT2_DIR_REC_LEN(entry->name_len);
+        fill_directory_entry(*last_entry, { entry->name, entry->name_len }, entry->inode, entry->file_type);
+        offset += last_entry->rec_len;
+    }
+    last_entry->rec_len += block_size - offset;
+}
+
+bool Ext2FSInode::is_indexed_directory() const
+{
+    return (m_raw_inode.i_flags & EXT2_INDEX_FL) && fs().supports_directory_index();
+}
+
+size_t Ext2FSInode::directory_block_count() const
+{
+    return size() / fs().block_size();
+}
+
+bool Ext2FSInode::read_directory_block(size_t index, u8* buffer) const
+{
+    if (m_block_list.is_empty())
+        m_block_list = fs().block_list_for_inode(m_raw_inode);
+    if (index >= m_block_list.size())
+        return false;
+    return fs().read_block(m_block_list[index], buffer, fs().block_size());
+}
+
+bool Ext2FSInode::write_directory_block(size_t index, const u8* buffer)
+{
+    if (m_block_list.is_empty())
+        m_block_list = fs().block_list_for_inode(m_raw_inode);
+    if (index >= m_block_list.size())
+        return false;
+    return fs().write_block(m_block_list[index], buffer, fs().block_size());
+}
+
+KResult Ext2FSInode::append_directory_block(const u8* buffer)
+{
+    size_t block_size = fs().block_size();
+    ssize_t nwritten = write_bytes(directory_block_count() * block_size, block_size, buffer, nullptr);
+    if (nwritten < 0)
+        return KResult(nwritten);
+    if ((size_t)nwritten != block_size)
+        return KResult(-EIO);
+    return KSuccess;
+}
+
+bool Ext2FSInode::DirectoryIndexFrame::is_valid(size_t block_size)
+{
+    if (entries_offset + sizeof(ext2_dx_countlimit) > block_size)
+        return false;
+    auto& countlimit = this->countlimit();
+    return countlimit.count && countlimit.count <= countlimit.limit && entries_offset + countlimit.limit * sizeof(ext2_dx_entry) <= block_size;
+}
+
+// Walks down the index to the leaf block that would contain the given name.
+// Returns false if the index doesn't make sense, in which case it's best ignored.
+bool Ext2FSInode::probe_directory_index(const StringView& name, u32& hash, u8& hash_version, DirectoryIndexPath& path, size_t& leaf_block) const
+{
+    size_t block_size = fs().block_size();
+    size_t block_count = directory_block_count();
+
+    DirectoryIndexFrame root;
+    root.block = ByteBuffer::create_uninitialized(block_size);
+    if (!read_directory_block(0, root.block.data()))
+        return false;
+    auto& info = *reinterpret_cast<const ext2_dx_root_info*>(root.block.data() + dx_root_info_offset);
+    if (info.reserved_zero || info.hash_version > EXT2_HASH_TEA || info.info_length < sizeof(ext2_dx_root_info) || info.indirect_levels > 1)
+        return false;
+    size_t indirect_levels = info.indirect_levels;
+    root.entries_offset = dx_root_info_offset + info.info_length;
+    if (!root.is_valid(block_size))
+        return false;
+
+    hash_version = fs().directory_hash_version(info.hash_version);
+    hash = fs().directory_hash(name, hash_version);
+
+    path.clear();
+    path.append(move(root));
+    for (size_t level = 0;; ++level) {
+        auto& frame = path.last();
+        auto* entries = frame.entries();
+
+        // Find the last entry whose hash is not above ours. The first entry's hash is
+        // implicitly zero (it's where the count and limit live), so it always qualifies.
+        size_t low = 1;
+        size_t high = frame.countlimit().count;
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            if (entries[middle].hash > hash)
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        frame.position = low - 1;
+
+        size_t block = entries[frame.position].block & dx_block_mask;
+        if (!block || block >= block_count)
+            return false;
+        if (level == indirect_levels) {
+            leaf_block = block;
+            return true;
+        }
+
+        DirectoryIndexFrame node;
+        node.block_index = block;
+        node.block = ByteBuffer::create_uninitialized(block_size);
+        node.entries_offset = dx_node_entries_offset;
+        if (!read_directory_block(block, node.block.data()) || !node.is_valid(block_size))
+            return false;
+        path.append(move(node));
+    }
+}
+
+// Moves on to the next leaf, as long as it continues a run of names that share our hash.
+bool Ext2FSInode::advance_directory_index(u32 hash, DirectoryIndexPath& path, size_t& leaf_block) const
+{
+    ssize_t level = path.size() - 1;
+    while (level >= 0 && path[level].position + 1 >= path[level].countlimit().count)
+        --level;
+    if (level < 0)
+        return false;
+
+    auto& frame = path[level];
+    ++frame.position;
+    if ((frame.entries()[frame.position].hash & ~1u) != hash)
+        return false;
+
+    size_t block_size = fs().block_size();
+    for (size_t i = level + 1; i < path.size(); ++i) {
+        auto& parent = path[i - 1];
+        auto& node = path[i];
+        node.block_index = parent.entries()[parent.position].block & dx_block_mask;
+        node.position = 0;
+        if (!read_directory_block(node.block_index, node.block.data()) || !node.is_valid(block_size))
+            return false;
+    }
+
+    auto& leaf_frame = path.last();
+    leaf_block = leaf_frame.entries()[leaf_frame.position].block & dx_block_mask;
+    return leaf_block && leaf_block < directory_block_count();
+}
+
+bool Ext2FSInode::find_directory_entry(const StringView& name, DirectoryEntryLocation& location) const
+{
+    size_t block_size = fs().block_size();
+    auto block = ByteBuffer::create_uninitialized(block_size);
+
+    auto find_in_block = [&](size_t block_index) {
+        if (!read_directory_block(block_index, block.data()))
+            return false;
+        if (!find_entry_in_directory_block(block.data(), block_size, name, location.offset, location.previous_offset))
+            return false;
+        location.block_index = block_index;
+        location.inode = directory_entry_at(block.data(), location.offset)->inode;
+        return true;
+    };
+
+    // "." and ".." live in the first block, in front of the index, and nowhere else.
+    if (is_indexed_directory() && name != "." && name != "..") {
+        DirectoryIndexPath path;
+        u32 hash;
+        u8 hash_version;
+        size_t leaf_block;
+        if (probe_directory_index(name, hash, hash_version, path, leaf_block)) {
+            do {
+                if (find_in_block(leaf_block))
+                    return true;
+            } while (advance_directory_index(hash, path, leaf_block));
+            return false;
+        }
+        dbg() << "Ext2FS: Directory index of inode " << identifier() << " is broken, searching it linearly";
+    }
+
+    size_t block_count = directory_block_count();
+    for (size_t i = 0; i < block_count; ++i) {
+        if (find_in_block(i))
+            return true;
+    }
+    return false;
+}
+
+// Returns ENOSPC if the index has no room for another leaf block.
+KResult Ext2FSInode::add_indexed_directory_entry(const StringView& name, unsigned inode, u8 file_type)
+{
+    DirectoryIndexPath path;
+    u32 hash;
+    u8 hash_version;
+    size_t leaf_block;
+    if (!probe_directory_index(name, hash, hash_version, path, leaf_block))
+        return KResult(-ENOSPC);
+
+    size_t block_size = fs().block_size();
+    auto leaf = ByteBuffer::create_uninitialized(block_size);
+    if (!read_directory_block(leaf_block, leaf.data()))
+        return KResult(-EIO);
+    if (insert_entry_into_directory_block(leaf.data(), block_size, name, inode, file_type))
+        return write_directory_block(leaf_block, leaf.data()) ? KSuccess : KResult(-EIO);
+
+    auto& frame = path.last();
+    if (frame.countlimit().count >= frame.countlimit().limit)
+        return KResult(-ENOSPC);
+
+    // The leaf is full, so split it in two down the middle of its hash range,
+    // and give the upper half a new block with an index entry of its own.
+    struct HashedEntry {
+        u32 hash;
+        ext2_dir_entry_2* entry;
+    };
+    Vector<HashedEntry> entries;
+    for (size_t offset = 0; offset + 8 <= block_size;) {
+        auto* entry = directory_entry_at(leaf.data(), offset);
+        if (entry->rec_len < 8 || offset + entry->rec_len > block_size)
+            return KResult(-EIO);
+        if (entry->inode)
+            entries.append({ fs().directory_hash({ entry->name, entry->name_len }, hash_version), entry });
+        offset += entry->rec_len;
+    }
+    if (entries.size() < 2)
+        return KResult(-ENOSPC);
+    quick_sort(entries, [](auto& a, auto& b) { return a.hash < b.hash; });
+
+    size_t split = entries.size() / 2;
+    u32 split_hash = entries[split].hash;
+    // If the split lands in the middle of names with the same hash, mark the new leaf
+    // as continuing the previous one, so that lookups know to keep going.
+    bool continued = entries[split - 1].hash == split_hash;
+
+    Vector<ext2_dir_entry_2*> lower_entries;
+    Vector<ext2_dir_entry_2*> upper_entries;
+    for (size_t i = 0; i < entries.size(); ++i)
+        (i < split ? lower_entries : upper_entries).append(entries[i].entry);
+
+    auto lower = ByteBuffer::create_uninitialized(block_size);
+    auto upper = ByteBuffer::create_uninitialized(block_size);
+    pack_directory_block(lower.data(), block_size, lower_entries);
+    pack_directory_block(upper.data(), block_size, upper_entries);
+
+    auto& target = hash >= split_hash ? upper : lower;
+    if (!insert_entry_into_directory_block(target.data(), block_size, name, inode, file_type))
+        return KResult(-ENOSPC);
+
+    size_t new_block = directory_block_count();
+    auto result = append_directory_block(upper.data());
+    if (result.is_error())
+        return result;
+    if (!write_directory_block(leaf_block, lower.data()))
+        return KResult(-EIO);
+
+    auto* index_entries = frame.entries();
+    u16 count = frame.countlimit().count;
+    size_t position = frame.position + 1;
+    memmove(&index_entries[position + 1], &index_entries[position], (count - position) * sizeof(ext2_dx_entry));
+    index_entries[position].hash = split_hash | (continued ? 1 : 0);
+    index_entries[position].block = new_block;
+    frame.countlimit().count = count + 1;
+    if (!write_directory_block(frame.block_index, frame.block.data()))
+        return KResult(-EIO);
+    return KSuccess;
+}
+
+// Turns a directory that has outgrown its first block into an indexed one,
+// with all of its entries (apart from "." and "..") moved into a single leaf.
+bool Ext2FSInode::make_indexed_directory()
+{
+    u8 hash_version = fs().super_block().s_def_hash_version;
+    if (hash_version > EXT2_HASH_TEA || directory_block_count() != 1)
+        return false;
+
+    size_t block_size = fs().block_size();
+    auto root = ByteBuffer::create_uninitialized(block_size);
+    if (!read_directory_block(0, root.data()))
+        return false;
+
+    auto* dot = directory_entry_at(root.data(), 0);
+    if (dot->rec_len != EXT2_DIR_REC_LEN(1) || StringView(dot->name, dot->name_len) != ".")
+        return false;
+    auto* dot_dot = directory_entry_at(root.data(), dot->rec_len);
+    if (dot_dot->rec_len < EXT2_DIR_REC_LEN(2) || dot->rec_len + dot_dot->rec_len > block_size || StringView(dot_dot->name, dot_dot->name_len) != "..")
+        return false;
+
+    Vector<ext2_dir_entry_2*> entries;
+    for (size_t offset = dot->rec_len + dot_dot->rec_len; offset + 8 <= block_size;) {
+        auto* entry = directory_entry_at(root.data(), offset);
+        if (entry->rec_len < 8 || offset + entry->rec_len > block_size)
+            return false;
+        if (entry->inode)
+            entries.append(entry);
+        offset += entry->rec_len;
+    }
+
+    auto leaf = ByteBuffer::create_uninitialized(block_size);
+    pack_directory_block(leaf.data(), block_size, entries);
+    if (append_directory_block(leaf.data()).is_error())
+        return false;
+
+    dot_dot->rec_len = block_size - dot->rec_len;
+    memset(root.data() + dx_root_info_offset, 0, block_size - dx_root_info_offset);
+    auto& info = *reinterpret_cast<ext2_dx_root_info*>(root.data() + dx_root_info_offset);
+    info.hash_version = hash_version;
+    info.info_length = sizeof(ext2_dx_root_info);
+    DirectoryIndexFrame frame;
+    frame.block = root;
+    frame.entries_offset = dx_root_info_offset + sizeof(ext2_dx_root_info);
+    frame.countlimit().limit = (block_size - frame.entries_offset) / sizeof(ext2_dx_entry);
+    frame.countlimit().count = 1;
+    frame.entries()[0].block = 1;
+    if (!write_directory_block(0, root.data()))
+        return false;
+
+    m_raw_inode.i_flags |= EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+    return true;
+}
+
+KResult Ext2FSInode::add_directory_entry(const StringView& name, unsigned inode, u8 file_type)
+{
+    if (is_indexed_directory()) {
+        auto result = add_indexed_directory_entry(name, inode, file_type);
+        if (result != -ENOSPC)
+            return result;
+        // Carry on without the index, as kernels that don't know about indexing
+        // would; e2fsck -D can build a new one.
+        dbg() << "Ext2FS: Directory index of inode " << identifier() << " is full, dropping it";
+        m_raw_inode.i_flags &= ~EXT2_INDEX_FL;
+        set_metadata_dirty(true);
+    }
+
+    size_t block_size = fs().block_size();
+    size_t block_count = directory_block_count();
+    auto block = ByteBuffer::create_uninitialized(block_size);
+    for (size_t i = 0; i < block_count; ++i) {
+        if (!read_directory_block(i, block.data()))
+            return KResult(-EIO);
+        if (insert_entry_into_directory_block(block.data(), block_size, name, inode, file_type))
+            return write_directory_block(i, block.data()) ? KSuccess : KResult(-EIO);
+    }
+
+    if (block_count == 1 && fs().supports_directory_index() && make_indexed_directory()) {
+        auto result = add_indexed_directory_entry(name, inode, file_type);
+        if (result != -ENOSPC)
+            return result;
+    }
+
+    memset(block.data(), 0, block_size);
+    directory_entry_at(block.data(), 0)->rec_len = block_size;
+    insert_entry_into_directory_block(block.data(), block_size, name, inode, file_type);
+    return append_directory_block(block.data());
+}
+
 KResult Ext2FSInode::add_child(Inode& child, const StringView& name, mode_t mode)
 {
     LOCKER(m_lock);
@@ -960,32 +1780,26 @@ KResult Ext2FSInode::add_child(Inode& child, const StringView& name, mode_t mode
     dbg() << "Ext2FSInode::add_child(): Adding inode " << child.index() << " with name '" << name << "' and mode " << mode << " to directory " << index();
 #endif
 
-    Vector<Ext2FSDirectoryEntry> entries;
-    bool name_already_exists = false;
-    KResult result = traverse_as_directory([&](auto& entry) {
-        if (name == entry.name) {
-            name_already_exists = true;
-            return false;
-        }
-        entries.append({ entry.name, entry.inode, entry.file_type });
-        return true;
-    });
-
-    if (result.is_error())
-        return result;
-
-    if (name_already_exists) {
+    DirectoryEntryLocation existing_entry;
+    if (find_directory_entry(name, existing_entry)) {
         dbg() << "Ext2FSInode::add_child(): Name '" << name << "' already exists in inode " << index();
         return KResult(-EEXIST);
     }
 
-    result = child.increment_link_count();
+    auto result = child.increment_link_count();
     if (result.is_error())
         return result;
 
-    entries.empend(name, child.identifier(), to_ext2_file_type(mode));
-    bool success = write_directory(entries);
-    if (success)
+    result = add_directory_entry(name, child.index(), to_ext2_file_type(mode));
+    if (result.is_error()) {
+        // The entry was never written, so the error that matters to the caller is the original one.
+        auto undo_result = child.decrement_link_count();
+        if (undo_result.is_error())
+            dbg() << "Ext2FSInode::add_child(): Failed to restore link count of inode " << child.index() << ": " << undo_result.error();
+        return result;
+    }
+
+    if (!m_lookup_cache.is_empty())
         m_lookup_cache.set(name, child.index());
 
     did_add_child(name);
@@ -1000,36 +1814,33 @@ KResult Ext2FSInode::remove_child(const StringView& name)
 #endif
     ASSERT(is_directory());
 
-    auto it = m_lookup_cache.find(name);
-    if (it == m_lookup_cache.end())
+    DirectoryEntryLocation location;
+    if (!find_directory_entry(name, location))
         return KResult(-ENOENT);
-    auto child_inode_index = (*it).value;
 
-    InodeIdentifier child_id { fsid(), child_inode_index };
+    InodeIdentifier child_id { fsid(), location.inode };
 
 #ifdef EXT2_DEBUG
     dbg() << "Ext2FSInode::remove_child(): Removing '" << name << "' in directory " << index();
 #endif
 
-    Vector<Ext2FSDirectoryEntry> entries;
-    KResult result = traverse_as_directory([&](auto& entry) {
-        if (name != entry.name)
-            entries.append({ entry.name, entry.inode, entry.file_type });
-        return true;
-    });
-    if (result.is_error())
-        return result;
-
-    bool success = write_directory(entries);
-    if (!success) {
-        // FIXME: Plumb error from write_directory().
+    // Only the block that had the entry in it needs rewriting: the entry before it
+    // (if any) absorbs its space, otherwise it's simply marked unused.
+    auto block = ByteBuffer::create_uninitialized(fs().block_size());
+    if (!read_directory_block(location.block_index, block.data()))
+        return KResult(-EIO);
+    auto* entry = directory_entry_at(block.data(), location.offset);
+    if (location.previous_offset.has_value())
+        directory_entry_at(block.data(), location.previous_offset.value())->rec_len += entry->rec_len;
+    else
+        entry->inode = 0;
+    if (!write_directory_block(location.block_index, block.data()))
         return KResult(-EIO);
-    }
 
     m_lookup_cache.remove(name);
 
     auto child_inode = fs().get_inode(child_id);
-    result = child_inode->decrement_link_count();
+    auto result = child_inode->decrement_link_count();
     if (result.is_error())
         return result;
 
@@ -1051,6 +1862,23 @@ unsigned Ext2FS::inode_size() const
 {
     return EXT2_INODE_SIZE(&super_block());
 }
+
+bool Ext2FS::supports_directory_index() const
+{
+    return super_block().s_feature_compat & EXT2_FEATURE_COMPAT_DIR_INDEX;
+}
+
+u8 Ext2FS::directory_hash_version(u8 hash_version) const
+{
+    if (hash_version <= EXT2_HASH_TEA && (super_block().s_flags & EXT2_FLAGS_UNSIGNED_HASH))
+        return hash_version + hash_version_unsigned_offset;
+    return hash_version;
+}
+
+u32 Ext2FS::directory_hash(const StringView& name, u8 hash_version) const
+{
+    return ext2_directory_hash(name, hash_version, super_block().s_hash_seed);
+}
 unsigned Ext2FS::blocks_per_group() const
 {
     return EXT2_BLOCKS_PER_GROUP(&super_block());
@@ -1066,29 +1894,132 @@ bool Ext2FS::write_ext2_inode(unsigned inode, const ext2_inode& e2inode)
     return write_block(block_index, reinterpret_cast<const u8*>(&e2inode), inode_size(), offset);
 }
 
-Vector<Ext2FS::BlockIndex> Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count)
+bool Ext2FS::is_reserved_for_another_inode(BlockIndex first_block, size_t length, BlockIndex& reservation_end) const
+{
+    for (auto& it : m_block_reservations) {
+        auto& reservation = it.value;
+        if (first_block < reservation.first_block + reservation.size && reservation.first_block < first_block + length) {
+            reservation_end = reservation.first_block + reservation.size;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Ext2FS::discard_block_reservation(InodeIndex inode)
 {
     LOCKER(m_lock);
+    m_block_reservations.remove(inode);
+}
+
+void Ext2FS::allocate_block_run(GroupIndex group_index, size_t first_bit, size_t length, Vector<BlockIndex>& blocks)
+{
+    auto& bgd = group_descriptor(group_index);
+    auto& cached_bitmap = get_bitmap_block(bgd.bg_block_bitmap);
+    auto bitmap = cached_bitmap.bitmap(blocks_per_group());
+    BlockIndex first_block_in_group = (group_index - 1) * blocks_per_group() + first_block_index();
+
 #ifdef EXT2_DEBUG
-    dbg() << "Ext2FS: allocate_blocks(preferred group: " << preferred_group_index << ", count: " << count << ")";
+    dbg() << "Ext2FS: allocating " << length << " blocks from " << (first_block_in_group + first_bit) << " [" << group_index << "]";
+#endif
+    for (size_t i = 0; i < length; ++i) {
+        ASSERT(!bitmap.get(first_bit + i));
+        blocks.unchecked_append(first_block_in_group + first_bit + i);
+    }
+    bitmap.set_range(first_bit, length, true);
+    cached_bitmap.dirty = true;
+
+    m_super_block.s_free_blocks_count -= length;
+    m_super_block_dirty = true;
+    const_cast<ext2_group_desc&>(bgd).bg_free_blocks_count -= length;
+    m_block_group_descriptors_dirty = true;
+}
+
+// Looks for the first stretch of free blocks at or after start_bit that fits everything
+// and doesn't get in the way of anyone's reservation. Failing that, settles for the longest
+// stretch in the group.
+size_t Ext2FS::find_free_block_run(GroupIndex group_index, size_t start_bit, size_t wanted, size_t& found_length) const
+{
+    auto& bgd = group_descriptor(group_index);
+    auto& cached_bitmap = const_cast<Ext2FS&>(*this).get_bitmap_block(bgd.bg_block_bitmap);
+    auto bitmap = cached_bitmap.bitmap(blocks_per_group());
+    BlockIndex first_block_in_group = (group_index - 1) * blocks_per_group() + first_block_index();
+
+    for (size_t from = start_bit;;) {
+        if (from >= blocks_per_group()) {
+            if (!start_bit)
+                break;
+            // Wrap around to the start of the group once.
+            from = 0;
+            start_bit = 0;
+            continue;
+        }
+        auto length = bitmap.find_next_range_of_unset_bits(from, wanted, wanted);
+        if (!length.has_value()) {
+            from = blocks_per_group();
+            continue;
+        }
+        BlockIndex reservation_end;
+        if (!is_reserved_for_another_inode(first_block_in_group + from, length.value(), reservation_end)) {
+            found_length = length.value();
+            return from;
+        }
+        from = max(from + 1, reservation_end - first_block_in_group);
+    }
+
+    auto first_unset_bit_index = bitmap.find_longest_range_of_unset_bits(wanted, found_length);
+    ASSERT(first_unset_bit_index.has_value());
+    return first_unset_bit_index.value();
+}
+
+Vector<Ext2FS::BlockIndex> Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count, InodeIndex owner, BlockIndex goal)
+{
+    LOCKER(m_lock);
+#ifdef EXT2_DEBUG
+    dbg() << "Ext2FS: allocate_blocks(preferred group: " << preferred_group_index << ", count: " << count << ", owner: " << owner << ", goal: " << goal << ")";
 #endif
     if (count == 0)
         return {};
 
     Vector<BlockIndex> blocks;
-#ifdef EXT2_DEBUG
-    dbg() << "Ext2FS: allocate_blocks:";
-#endif
     blocks.ensure_capacity(count);
 
+    // The owner's own reservation is where it's going to continue from,
+    // and the only one it doesn't need to steer clear of.
+    size_t reservation_size = 0;
+    if (owner) {
+        auto it = m_block_reservations.find(owner);
+        if (it != m_block_reservations.end()) {
+            goal = (*it).value.first_block;
+            reservation_size = (*it).value.size;
+            m_block_reservations.remove(it);
+        }
+    }
+
     GroupIndex group_index = preferred_group_index;
+    size_t start_bit = 0;
+    if (goal >= first_block_index() && goal < super_block().s_blocks_count) {
+        group_index = group_index_from_block_index(goal);
+        start_bit = goal - first_block_index() - (group_index - 1) * blocks_per_group();
 
-    if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
+        // Carry on right where the file left off for as long as we can.
+        auto& bgd = group_descriptor(group_index);
+        auto bitmap = get_bitmap_block(bgd.bg_block_bitmap).bitmap(blocks_per_group());
+        size_t run = 0;
+        BlockIndex reservation_end;
+        while (run < count && start_bit + run < blocks_per_group() && !bitmap.get(start_bit + run) && !is_reserved_for_another_inode(goal + run, 1, reservation_end))
+            ++run;
+        if (run)
+            allocate_block_run(group_index, start_bit, run, blocks);
+        start_bit += run;
+    }
+
+    if (!group_descriptor(group_index).bg_free_blocks_count) {
         group_index = 1;
+        start_bit = 0;
     }
 
     while (blocks.size() < count) {
-
         bool found_a_group = false;
         if (group_descriptor(group_index).bg_free_blocks_count) {
             found_a_group = true;
@@ -1101,33 +2032,25 @@ Vector<Ext2FS::BlockIndex> Ext2FS::allocate_blocks(GroupIndex preferred_group_in
                     break;
                 }
             }
+            start_bit = 0;
         }
 
         ASSERT(found_a_group);
-        auto& bgd = group_descriptor(group_index);
-        auto& cached_bitmap = get_bitmap_block(bgd.bg_block_bitmap);
-
-        int blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
-        auto block_bitmap = Bitmap::wrap(cached_bitmap.buffer.data(), blocks_in_group);
-
-        BlockIndex first_block_in_group = (group_index - 1) * blocks_per_group() + first_block_index();
-        size_t free_region_size = 0;
-        auto first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(count - blocks.size(), free_region_size);
-        ASSERT(first_unset_bit_index.has_value());
-#ifdef EXT2_DEBUG
-        dbg() << "Ext2FS: allocating free region of size: " << free_region_size << "[" << group_index << "]";
-#endif
-        for (size_t i = 0; i < free_region_size; ++i) {
-            BlockIndex block_index = (first_unset_bit_index.value() + i) + first_block_in_group;
-            set_block_allocation_state(block_index, true);
-            blocks.unchecked_append(block_index);
-#ifdef EXT2_DEBUG
-            dbg() << "  allocated > " << block_index;
-#endif
-        }
+        size_t found_length = 0;
+        size_t first_bit = find_free_block_run(group_index, start_bit, count - blocks.size(), found_length);
+        allocate_block_run(group_index, first_bit, found_length, blocks);
+        start_bit = first_bit + found_length;
     }
 
     ASSERT(blocks.size() == count);
+
+    // Files that keep on growing get an ever bigger window to grow into.
+    if (owner) {
+        size_t size = reservation_size ? min(reservation_size * 2, max_block_reservation_size) : initial_block_reservation_size;
+        if (m_block_reservations.size() >= max_block_reservation_count)
+            m_block_reservations.remove_one_randomly();
+        m_block_reservations.set(owner, { blocks.last() + 1, size });
+    }
     return blocks;
 }
 
@@ -1494,6 +2417,14 @@ void Ext2FSInode::populate_lookup_cache() const
 RefPtr<Inode> Ext2FSInode::lookup(StringView name)
 {
     ASSERT(is_directory());
+    if (is_indexed_directory()) {
+        // Walking the index only touches a handful of blocks, no matter how big the directory is.
+        LOCKER(m_lock);
+        DirectoryEntryLocation location;
+        if (!find_directory_entry(name, location))
+            return {};
+        return fs().get_inode({ fsid(), location.inode });
+    }
     populate_lookup_cache();
     LOCKER(m_lock);
     auto it = m_lookup_cache.find(name.hash(), [&](auto& entry) { return entry.key == name; });
@@ -1572,6 +2503,16 @@ KResultOr<size_t> Ext2FSInode::directory_entry_count() const
 {
     ASSERT(is_directory());
     LOCKER(m_lock);
+    if (is_indexed_directory()) {
+        size_t count = 0;
+        auto result = traverse_as_directory([&](auto&) {
+            ++count;
+            return true;
+        });
+        if (result.is_error())
+            return result;
+        return count;
+    }
     populate_lookup_cache();
     return m_lookup_cache.size();
 }
@@ -1600,12 +2541,17 @@ KResult Ext2FSInode::chown(uid_t uid, gid_t gid)
 KResult Ext2FSInode::truncate(u64 size)
 {
     LOCKER(m_lock);
-    if (static_cast<u64>(m_raw_inode.i_size) == size)
+    auto flush_result = flush_delayed_blocks();
+    if (flush_result.is_error())
+        return flush_result;
+    u64 old_size = m_raw_inode.i_size;
+    if (old_size == size)
         return KSuccess;
     auto result = resize(size);
     if (result.is_error())
         return result;
     set_metadata_dirty(true);
+    inode_size_changed(old_size, size);
     return KSuccess;
 }
 
@@ -1643,6 +2589,7 @@ KResult Ext2FS::prepare_to_unmount() const
     }
 
     m_inode_cache.clear();
+    m_block_reservations.clear();
     return KSuccess;
 }
 
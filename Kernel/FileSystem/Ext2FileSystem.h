@@ -56,6 +56,10 @@ public:
     // ^Inode (RefCounted magic)
     virtual void one_ref_left() override;
 
+    // ^Inode
+    virtual bool is_page_cacheable() const override { return Kernel::is_regular_file(m_raw_inode.i_mode); }
+    virtual void read_ahead_pages(size_t first_page_index, size_t page_count) override;
+
 private:
     // ^Inode
     virtual ssize_t read_bytes(off_t, ssize_t, u8* buffer, FileDescription*) const override;
@@ -79,8 +83,49 @@ private:
 
     bool write_directory(const Vector<Ext2FSDirectoryEntry>&);
     void populate_lookup_cache() const;
+
+    struct DirectoryEntryLocation {
+        size_t block_index { 0 };
+        size_t offset { 0 };
+        Optional<size_t> previous_offset;
+        unsigned inode { 0 };
+    };
+
+    // One step on the way down the hash tree of an indexed directory.
+    struct DirectoryIndexFrame {
+        size_t block_index { 0 };
+        ByteBuffer block;
+        size_t entries_offset { 0 };
+        size_t position { 0 };
+
+        ext2_dx_countlimit& countlimit() { return *reinterpret_cast<ext2_dx_countlimit*>(block.data() + entries_offset); }
+        ext2_dx_entry* entries() { return reinterpret_cast<ext2_dx_entry*>(block.data() + entries_offset); }
+        bool is_valid(size_t block_size);
+    };
+    typedef Vector<DirectoryIndexFrame, 2> DirectoryIndexPath;
+
+    bool is_indexed_directory() const;
+    size_t directory_block_count() const;
+    bool read_directory_block(size_t index, u8* buffer) const;
+    bool write_directory_block(size_t index, const u8* buffer);
+    KResult append_directory_block(const u8* buffer);
+    bool probe_directory_index(const StringView& name, u32& hash, u8& hash_version, DirectoryIndexPath&, size_t& leaf_block) const;
+    bool advance_directory_index(u32 hash, DirectoryIndexPath&, size_t& leaf_block) const;
+    bool find_directory_entry(const StringView& name, DirectoryEntryLocation&) const;
+    KResult add_directory_entry(const StringView& name, unsigned inode, u8 file_type);
+    KResult add_indexed_directory_entry(const StringView& name, unsigned inode, u8 file_type);
+    bool make_indexed_directory();
+    void read_ahead(FileDescription&, off_t offset, size_t first_block_logical_index, size_t last_block_logical_index) const;
+    void read_ahead_block_range(size_t start, size_t end) const;
     KResult resize(u64);
 
+    ssize_t read_bytes_from_blocks(off_t, ssize_t, u8* buffer, FileDescription*) const;
+    ssize_t write_bytes_to_blocks(off_t, ssize_t, const u8* data, bool allow_cache);
+    ssize_t write_delayed_bytes(off_t, size_t, const u8* data);
+    KResult flush_delayed_blocks();
+    void discard_delayed_blocks();
+    u64 logical_size() const { return m_raw_inode.i_size + m_delayed_size; }
+
     Ext2FS& fs();
     const Ext2FS& fs() const;
     Ext2FSInode(Ext2FS&, unsigned index);
@@ -88,6 +133,11 @@ private:
     mutable Vector<unsigned> m_block_list;
     mutable HashMap<String, unsigned> m_lookup_cache;
     ext2_inode m_raw_inode;
+
+    // Data appended to a regular file that hasn't been given any blocks yet. It starts right
+    // at i_size (which stays block-aligned meanwhile) and gets allocated all at once when flushed.
+    Optional<KBuffer> m_delayed_data;
+    size_t m_delayed_size { 0 };
 };
 
 class Ext2FS final : public BlockBasedFS {
@@ -107,6 +157,7 @@ public:
     virtual KResult prepare_to_unmount() const override;
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_lookup_cache() const override { return true; }
 
 private:
     typedef unsigned BlockIndex;
@@ -124,6 +175,10 @@ private:
     unsigned blocks_per_group() const;
     unsigned inode_size() const;
 
+    bool supports_directory_index() const;
+    u8 directory_hash_version(u8 hash_version) const;
+    u32 directory_hash(const StringView& name, u8 hash_version) const;
+
     bool write_ext2_inode(InodeIndex, const ext2_inode&);
     bool find_block_containing_inode(InodeIndex inode, BlockIndex& block_index, unsigned& offset) const;
 
@@ -138,7 +193,11 @@ private:
 
     BlockIndex first_block_index() const;
     InodeIndex find_a_free_inode(GroupIndex preferred_group, off_t expected_size);
-    Vector<BlockIndex> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    Vector<BlockIndex> allocate_blocks(GroupIndex preferred_group_index, size_t count, InodeIndex owner = 0, BlockIndex goal = 0);
+    void allocate_block_run(GroupIndex, size_t first_bit, size_t length, Vector<BlockIndex>&);
+    size_t find_free_block_run(GroupIndex, size_t start_bit, size_t wanted, size_t& found_length) const;
+    bool is_reserved_for_another_inode(BlockIndex first_block, size_t length, BlockIndex& reservation_end) const;
+    void discard_block_reservation(InodeIndex);
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
 
@@ -188,6 +247,18 @@ private:
     CachedBitmap& get_bitmap_block(BlockIndex);
 
     Vector<OwnPtr<CachedBitmap>> m_cached_bitmaps;
+
+    // A stretch of free blocks just past the end of a file that's being written to, which
+    // other files stay away from so that it has room to keep growing contiguously.
+    // These only exist in memory, and nothing is marked as allocated on disk until it's used.
+    struct BlockReservation {
+        BlockIndex first_block { 0 };
+        size_t size { 0 };
+    };
+    mutable HashMap<InodeIndex, BlockReservation> m_block_reservations;
+
+    // Blocks promised to delayed writes across all inodes. They're still counted as free on disk.
+    size_t m_delayed_block_count { 0 };
 };
 
 inline Ext2FS& Ext2FSInode::fs()
@@ -25,6 +25,7 @@
  */
 
 #include <AK/HashTable.h>
+#include <AK/ScopeGuard.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringView.h>
 #include <Kernel/FileSystem/FIFO.h>
@@ -32,6 +33,8 @@
 #include <Kernel/Lock.h>
 #include <Kernel/Process.h>
 #include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/Region.h>
 
 //#define FIFO_DEBUG
 
@@ -137,19 +140,148 @@ void FIFO::detach(Direction direction)
 
 bool FIFO::can_read(const FileDescription&, size_t) const
 {
-    return !m_buffer.is_empty() || !m_writers;
+    return m_size || !m_writers;
 }
 
 bool FIFO::can_write(const FileDescription&, size_t) const
 {
-    return m_buffer.space_for_writing() || !m_readers;
+    return m_size < m_capacity || !m_readers;
+}
+
+KResultOr<size_t> FIFO::set_capacity(size_t capacity)
+{
+    LOCKER(m_lock);
+    capacity = max(PAGE_ROUND_UP(capacity), (size_t)PAGE_SIZE);
+    if (capacity > max_capacity)
+        return KResult(-EINVAL);
+    if (capacity < m_size)
+        return KResult(-EBUSY);
+    if (capacity == m_capacity)
+        return capacity;
+
+    if (m_ring_used) {
+        auto ring = KBuffer::create_with_size(capacity, Region::Access::Read | Region::Access::Write, "FIFO");
+        size_t first_chunk = min(m_ring_used, m_capacity - m_ring_head);
+        memcpy(ring.data(), m_ring.value().data() + m_ring_head, first_chunk);
+        memcpy(ring.data() + first_chunk, m_ring.value().data(), m_ring_used - first_chunk);
+        m_ring = move(ring);
+    } else {
+        // The ring is allocated again on the next write that needs it.
+        m_ring = {};
+    }
+    m_ring_head = 0;
+    m_capacity = capacity;
+#ifdef FIFO_DEBUG
+    dbg() << "FIFO: capacity of fifo:" << m_fifo_id << " is now " << m_capacity;
+#endif
+    return capacity;
+}
+
+size_t FIFO::write_to_ring(const u8* data, size_t size)
+{
+    ASSERT(m_lock.is_locked());
+    size = min(size, m_capacity - m_size);
+    if (!size)
+        return 0;
+    if (!m_ring.has_value())
+        m_ring = KBuffer::create_with_size(m_capacity, Region::Access::Read | Region::Access::Write, "FIFO");
+    size_t tail = (m_ring_head + m_ring_used) % m_capacity;
+    size_t first_chunk = min(size, m_capacity - tail);
+    memcpy(m_ring.value().data() + tail, data, first_chunk);
+    memcpy(m_ring.value().data(), data + first_chunk, size - first_chunk);
+    m_ring_used += size;
+    m_size += size;
+
+    if (!m_segments.is_empty() && !m_segments.last().page)
+        m_segments.last().size += size;
+    else
+        m_segments.append({ nullptr, 0, size });
+    return size;
+}
+
+void FIFO::read_from_ring(u8* buffer, size_t size)
+{
+    ASSERT(m_lock.is_locked());
+    ASSERT(size <= m_ring_used);
+    size_t first_chunk = min(size, m_capacity - m_ring_head);
+    memcpy(buffer, m_ring.value().data() + m_ring_head, first_chunk);
+    memcpy(buffer + first_chunk, m_ring.value().data(), size - first_chunk);
+    m_ring_head = (m_ring_head + size) % m_capacity;
+    m_ring_used -= size;
+    if (!m_ring_used)
+        m_ring_head = 0;
+}
+
+bool FIFO::try_queue_user_page(const u8* data)
+{
+    ASSERT(m_lock.is_locked());
+    auto& process = *Process::current();
+    ASSERT(process.big_lock().is_locked());
+    auto vaddr = VirtualAddress(data);
+    auto* region = MM.find_region_from_vaddr(process, vaddr);
+    if (!region || !region->is_user_accessible())
+        return false;
+    auto page = region->share_anonymous_page(region->page_index_from_address(vaddr));
+    if (!page)
+        return false;
+    m_segments.append({ move(page), 0, PAGE_SIZE });
+    m_size += PAGE_SIZE;
+    return true;
+}
+
+bool FIFO::try_hand_off_page_to_user(u8* buffer)
+{
+    ASSERT(m_lock.is_locked());
+    auto& process = *Process::current();
+    ASSERT(process.big_lock().is_locked());
+    auto& segment = m_segments.first();
+    ASSERT(segment.page && segment.offset == 0 && segment.size == PAGE_SIZE);
+    auto vaddr = VirtualAddress(buffer);
+    auto* region = MM.find_region_from_vaddr(process, vaddr);
+    if (!region || !region->is_user_accessible())
+        return false;
+    return region->replace_anonymous_page(region->page_index_from_address(vaddr), *segment.page);
 }
 
 KResultOr<size_t> FIFO::read(FileDescription&, size_t, u8* buffer, size_t size)
 {
-    if (!m_writers && m_buffer.is_empty())
+    if (!size)
+        return 0;
+
+    // Passing pages into the reader's address space means touching its regions,
+    // so that needs the process lock. Take it before ours to keep the order fixed.
+    auto& process = *Process::current();
+    bool may_hand_off = size >= PAGE_SIZE && !((FlatPtr)buffer & ~PAGE_MASK) && is_user_range(VirtualAddress(buffer), size);
+    if (may_hand_off)
+        process.big_lock().lock();
+    ScopeGuard unlock_process_guard([&] {
+        if (may_hand_off)
+            process.big_lock().unlock();
+    });
+    LOCKER(m_lock);
+
+    if (!m_writers && !m_size)
         return 0;
-    return m_buffer.read(buffer, size);
+
+    size_t nread = 0;
+    while (nread < size && !m_segments.is_empty()) {
+        auto& segment = m_segments.first();
+        size_t chunk_size = min(size - nread, segment.size);
+        if (segment.page) {
+            bool handed_off = may_hand_off && chunk_size == PAGE_SIZE && segment.offset == 0 && try_hand_off_page_to_user(buffer + nread);
+            if (!handed_off)
+                MM.copy_from_physical_page(*segment.page, segment.offset, buffer + nread, chunk_size);
+        } else {
+            read_from_ring(buffer + nread, chunk_size);
+        }
+        nread += chunk_size;
+        m_size -= chunk_size;
+        segment.offset += chunk_size;
+        segment.size -= chunk_size;
+        if (!segment.size)
+            m_segments.take_first();
+    }
+    return nread;
 }
 
 KResultOr<size_t> FIFO::write(FileDescription&, size_t, const u8* buffer, size_t size)
@@ -158,7 +290,33 @@ KResultOr<size_t> FIFO::write(FileDescription&, size_t, const u8* buffer, size_t
         Thread::current()->send_signal(SIGPIPE, Process::current());
         return -EPIPE;
     }
-    return m_buffer.write(buffer, size);
+    if (!size)
+        return 0;
+
+    auto& process = *Process::current();
+    bool may_hand_off = size >= PAGE_SIZE && !((FlatPtr)buffer & ~PAGE_MASK) && is_user_range(VirtualAddress(buffer), size);
+    if (may_hand_off)
+        process.big_lock().lock();
+    ScopeGuard unlock_process_guard([&] {
+        if (may_hand_off)
+            process.big_lock().unlock();
+    });
+    LOCKER(m_lock);
+
+    size_t nwritten = 0;
+    while (nwritten < size && m_size < m_capacity) {
+        size_t remaining = size - nwritten;
+        if (may_hand_off && remaining >= PAGE_SIZE) {
+            if (m_capacity - m_size >= PAGE_SIZE && try_queue_user_page(buffer + nwritten)) {
+                nwritten += PAGE_SIZE;
+                continue;
+            }
+            // Keep the rest of the buffer page-aligned so we can try again on the next page.
+            remaining = PAGE_SIZE;
+        }
+        nwritten += write_to_ring(buffer + nwritten, remaining);
+    }
+    return nwritten;
 }
 
 String FIFO::absolute_path(const FileDescription&) const
@@ -26,8 +26,9 @@
 
 #pragma once
 
-#include <Kernel/DoubleBuffer.h>
+#include <AK/SinglyLinkedList.h>
 #include <Kernel/FileSystem/File.h>
+#include <Kernel/KBuffer.h>
 #include <Kernel/Lock.h>
 #include <Kernel/UnixTypes.h>
 #include <Kernel/WaitQueue.h>
@@ -55,6 +56,12 @@ public:
     void attach(Direction);
     void detach(Direction);
 
+    static constexpr size_t default_capacity = 64 * KiB;
+    static constexpr size_t max_capacity = 1 * MiB;
+
+    size_t capacity() const { return m_capacity; }
+    KResultOr<size_t> set_capacity(size_t);
+
 private:
     // ^File
     virtual KResultOr<size_t> write(FileDescription&, size_t, const u8*, size_t) override;
@@ -67,9 +74,30 @@ private:
 
     explicit FIFO(uid_t);
 
+    // Data is queued as a list of segments. Small writes are copied into the byte ring,
+    // while whole, page-aligned pages of anonymous memory are passed along by reference
+    // (copy-on-write on both ends) instead of being copied in and out again.
+    struct Segment {
+        RefPtr<PhysicalPage> page;
+        size_t offset { 0 };
+        size_t size { 0 };
+    };
+
+    size_t write_to_ring(const u8*, size_t);
+    void read_from_ring(u8*, size_t);
+    bool try_queue_user_page(const u8*);
+    bool try_hand_off_page_to_user(u8*);
+
     unsigned m_writers { 0 };
     unsigned m_readers { 0 };
-    DoubleBuffer m_buffer;
+
+    SinglyLinkedList<Segment> m_segments;
+    Optional<KBuffer> m_ring;
+    size_t m_ring_head { 0 };
+    size_t m_ring_used { 0 };
+    size_t m_size { 0 };
+    size_t m_capacity { default_capacity };
+    Lock m_lock { "FIFO" };
 
     uid_t m_uid { 0 };
 
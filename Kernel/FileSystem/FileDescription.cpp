@@ -153,6 +153,34 @@ KResultOr<size_t> FileDescription::write(const u8* data, size_t size)
     return nwritten_or_error;
 }
 
+KResultOr<size_t> FileDescription::read_at(u8* buffer, size_t count, off_t offset)
+{
+    if (!m_file->is_seekable())
+        return KResult(-ESPIPE);
+    if (offset < 0)
+        return KResult(-EINVAL);
+    Checked<size_t> end_offset = offset;
+    end_offset += count;
+    if (end_offset.has_overflow())
+        return KResult(-EOVERFLOW);
+    SmapDisabler disabler;
+    return m_file->read(*this, offset, buffer, count);
+}
+
+KResultOr<size_t> FileDescription::write_at(const u8* data, size_t size, off_t offset)
+{
+    if (!m_file->is_seekable())
+        return KResult(-ESPIPE);
+    if (offset < 0)
+        return KResult(-EINVAL);
+    Checked<size_t> end_offset = offset;
+    end_offset += size;
+    if (end_offset.has_overflow())
+        return KResult(-EOVERFLOW);
+    SmapDisabler disabler;
+    return m_file->write(*this, offset, data, size);
+}
+
 bool FileDescription::can_write() const
 {
     return m_file->can_write(*this, offset());
@@ -62,6 +62,10 @@ public:
     off_t seek(off_t, int whence);
     KResultOr<size_t> read(u8*, size_t);
     KResultOr<size_t> write(const u8* data, size_t);
+
+    // Positional I/O neither uses nor moves the current offset, so it doesn't need to serialize on it.
+    KResultOr<size_t> read_at(u8*, size_t, off_t offset);
+    KResultOr<size_t> write_at(const u8* data, size_t, off_t offset);
     KResult fstat(stat&);
 
     KResult chmod(mode_t);
@@ -122,6 +126,14 @@ public:
 
     Optional<KBuffer>& generator_cache() { return m_generator_cache; }
 
+    // Sequential access tracking, used by file systems to size read-ahead.
+    struct ReadAheadState {
+        off_t next_offset { 0 };
+        size_t window { 0 };
+        size_t prefetched_until { 0 };
+    };
+    ReadAheadState& read_ahead_state() { return m_read_ahead_state; }
+
     void set_original_inode(Badge<VFS>, NonnullRefPtr<Inode>&& inode) { m_inode = move(inode); }
 
     KResult truncate(u64);
@@ -143,6 +155,8 @@ private:
 
     Optional<KBuffer> m_generator_cache;
 
+    ReadAheadState m_read_ahead_state;
+
     u32 m_file_flags { 0 };
 
     bool m_readable : 1 { false };
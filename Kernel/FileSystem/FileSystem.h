@@ -60,6 +60,10 @@ public:
     virtual NonnullRefPtr<Inode> root_inode() const = 0;
     virtual bool supports_watchers() const { return false; }
 
+    // Whether every change to a directory gets reported through Inode::did_add_child() and
+    // Inode::did_remove_child(), making it safe for the VFS to cache lookups in it.
+    virtual bool supports_lookup_cache() const { return false; }
+
     bool is_readonly() const { return m_readonly; }
 
     virtual unsigned total_block_count() const { return 0; }
@@ -79,6 +83,10 @@ public:
 
     virtual void flush_writes() { }
 
+    // Called after a write from userspace, outside of any file system locks, so that
+    // file systems with a write-back cache can slow down writers that outpace the disk.
+    virtual void throttle_writer() { }
+
     size_t block_size() const { return m_block_size; }
 
     virtual bool is_file_backed() const { return false; }
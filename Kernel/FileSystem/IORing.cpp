@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Atomic.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/Process.h>
+#include <Kernel/Tasks/IORingTask.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+KResultOr<NonnullRefPtr<IORing>> IORing::create(u32 requested_entries)
+{
+    if (requested_entries == 0 || requested_entries > IO_RING_MAX_ENTRIES)
+        return KResult(-EINVAL);
+    // Power-of-two sizes keep the free-running indices valid across wrap-around.
+    u32 entries = 1;
+    while (entries < requested_entries)
+        entries <<= 1;
+
+    size_t size = PAGE_ROUND_UP(sizeof(io_ring_header) + entries * sizeof(io_ring_sqe) + entries * 2 * sizeof(io_ring_cqe));
+    auto vmobject = AnonymousVMObject::create_with_size(size);
+    auto region = MM.allocate_kernel_region_with_vmobject(*vmobject, size, "IORing", Region::Access::Read | Region::Access::Write);
+    if (!region)
+        return KResult(-ENOMEM);
+    if (!region->commit())
+        return KResult(-ENOMEM);
+    return adopt(*new IORing(entries, move(vmobject), region.release_nonnull()));
+}
+
+IORing::IORing(u32 entries, NonnullRefPtr<AnonymousVMObject>&& vmobject, NonnullOwnPtr<Region>&& kernel_region)
+    : m_entries(entries)
+    , m_vmobject(move(vmobject))
+    , m_kernel_region(move(kernel_region))
+{
+}
+
+IORing::~IORing()
+{
+}
+
+void IORing::fill_in_params(io_ring_params& params) const
+{
+    params.sq_entries = m_entries;
+    params.cq_entries = cq_entries();
+    params.sq_offset = sq_offset();
+    params.cq_offset = cq_offset();
+    params.mapping_size = m_vmobject->size();
+}
+
+KResultOr<u32> IORing::submit(Process& process, u32 count)
+{
+    struct ImmediateOperation {
+        io_ring_sqe sqe;
+        NonnullRefPtr<FileDescription> description;
+    };
+    Vector<ImmediateOperation> immediate_operations;
+
+    ScopedSpinLock lock(m_submission_lock);
+    u32 tail = AK::atomic_load(&header().sq_tail, AK::MemoryOrder::memory_order_acquire);
+    u32 available = tail - m_sq_head;
+    // A bogus tail from userspace shouldn't make us run stale entries over and over.
+    if (available > m_entries)
+        available = m_entries;
+    u32 submitted = 0;
+    bool completion_queue_full = false;
+    for (; submitted < min(count, available); ++submitted) {
+        if (!try_reserve_completion()) {
+            completion_queue_full = true;
+            break;
+        }
+        // Take a copy, since userspace may keep scribbling on the entry after handing it over.
+        io_ring_sqe sqe = submission_entries()[m_sq_head & (m_entries - 1)];
+        ++m_sq_head;
+        AK::atomic_store(&header().sq_head, m_sq_head, AK::MemoryOrder::memory_order_release);
+        if (sqe.opcode == IO_RING_OP_NOP) {
+            post_completion(sqe.user_data, 0);
+            continue;
+        }
+        if (sqe.opcode > IO_RING_OP_FSYNC) {
+            post_completion(sqe.user_data, -EINVAL);
+            continue;
+        }
+        auto description = process.file_description(sqe.fd);
+        if (!description) {
+            post_completion(sqe.user_data, -EBADF);
+            continue;
+        }
+        if (sqe.opcode == IO_RING_OP_CONNECT) {
+            immediate_operations.append({ sqe, description.release_nonnull() });
+            continue;
+        }
+        if (!IORingTask::schedule(*this, process, sqe, description.release_nonnull()))
+            post_completion(sqe.user_data, -EAGAIN);
+    }
+    lock.unlock();
+
+    for (auto& operation : immediate_operations)
+        post_completion(operation.sqe.user_data, process.do_io_ring_operation(operation.sqe, *operation.description));
+    if (!submitted && completion_queue_full)
+        return KResult(-EBUSY);
+    return submitted;
+}
+
+bool IORing::try_reserve_completion()
+{
+    ScopedSpinLock lock(m_completion_lock);
+    flush_overflowed_completions_locked();
+    u32 head = AK::atomic_load(&header().cq_head, AK::MemoryOrder::memory_order_acquire);
+    // A head that userspace moved past our tail means the queue is as good as full.
+    u32 queued = min(m_cq_tail - head, cq_entries());
+    if (queued + m_overflowed_completions.size() + m_pending_completions >= cq_entries())
+        return false;
+    ++m_pending_completions;
+    return true;
+}
+
+bool IORing::try_post_completion(const io_ring_cqe& cqe)
+{
+    u32 head = AK::atomic_load(&header().cq_head, AK::MemoryOrder::memory_order_acquire);
+    if (m_cq_tail - head >= cq_entries())
+        return false;
+    completion_entries()[m_cq_tail & (cq_entries() - 1)] = cqe;
+    ++m_cq_tail;
+    AK::atomic_store(&header().cq_tail, m_cq_tail, AK::MemoryOrder::memory_order_release);
+    return true;
+}
+
+void IORing::flush_overflowed_completions_locked()
+{
+    while (!m_overflowed_completions.is_empty()) {
+        if (!try_post_completion(m_overflowed_completions.first()))
+            break;
+        m_overflowed_completions.take_first();
+    }
+}
+
+void IORing::flush_overflowed_completions()
+{
+    ScopedSpinLock lock(m_completion_lock);
+    flush_overflowed_completions_locked();
+}
+
+void IORing::post_completion(u64 user_data, i32 result)
+{
+    ScopedSpinLock lock(m_completion_lock);
+    ASSERT(m_pending_completions);
+    --m_pending_completions;
+    flush_overflowed_completions_locked();
+    io_ring_cqe cqe { user_data, result, 0 };
+    if (!m_overflowed_completions.is_empty() || !try_post_completion(cqe))
+        m_overflowed_completions.append(cqe);
+}
+
+u32 IORing::completion_count() const
+{
+    u32 head = AK::atomic_load(&const_cast<io_ring_header&>(header()).cq_head, AK::MemoryOrder::memory_order_acquire);
+    u32 tail = AK::atomic_load(&const_cast<io_ring_header&>(header()).cq_tail, AK::MemoryOrder::memory_order_acquire);
+    return tail - head;
+}
+
+KResultOr<Region*> IORing::mmap(Process& process, FileDescription&, VirtualAddress preferred_vaddr, size_t offset, size_t size, int prot, bool shared)
+{
+    if (!shared)
+        return KResult(-ENODEV);
+    if (offset != 0 || size != m_vmobject->size())
+        return KResult(-EINVAL);
+    auto* region = process.allocate_region_with_vmobject(preferred_vaddr, size, m_vmobject, 0, "IORing", prot);
+    if (!region)
+        return KResult(-ENOMEM);
+    return region;
+}
+
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Vector.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/UnixTypes.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+// A pair of submission and completion queues shared with userspace. Operations taken from the
+// submission queue are carried out by IORingTask, which posts their results to the completion queue.
+class IORing final : public File {
+public:
+    static KResultOr<NonnullRefPtr<IORing>> create(u32 entries);
+    virtual ~IORing() override;
+
+    void fill_in_params(io_ring_params&) const;
+
+    // Hands up to the given number of submitted operations to IORingTask on behalf of the process.
+    // Connecting can't be made to wait in the background, so it's done right away instead.
+    // Every operation keeps a completion slot reserved until it's done, and we stop taking new ones
+    // once they're all spoken for. If that happens before anything was submitted, this fails with EBUSY.
+    KResultOr<u32> submit(Process&, u32 count);
+    void post_completion(u64 user_data, i32 result);
+    // Moves completions that didn't fit earlier into the space userspace has since freed up.
+    void flush_overflowed_completions();
+    u32 completion_count() const;
+    u32 completion_capacity() const { return cq_entries(); }
+
+    virtual bool can_read(const FileDescription&, size_t) const override { return completion_count() > 0; }
+    virtual bool can_write(const FileDescription&, size_t) const override { return false; }
+    virtual KResultOr<size_t> read(FileDescription&, size_t, u8*, size_t) override { return KResult(-EINVAL); }
+    virtual KResultOr<size_t> write(FileDescription&, size_t, const u8*, size_t) override { return KResult(-EINVAL); }
+    virtual KResultOr<Region*> mmap(Process&, FileDescription&, VirtualAddress preferred_vaddr, size_t offset, size_t size, int prot, bool shared) override;
+    virtual String absolute_path(const FileDescription&) const override { return "IORing"; }
+    virtual const char* class_name() const override { return "IORing"; }
+    virtual bool is_io_ring() const override { return true; }
+
+private:
+    IORing(u32 entries, NonnullRefPtr<AnonymousVMObject>&&, NonnullOwnPtr<Region>&&);
+
+    io_ring_header& header() { return *reinterpret_cast<io_ring_header*>(m_kernel_region->vaddr().as_ptr()); }
+    const io_ring_header& header() const { return *reinterpret_cast<const io_ring_header*>(m_kernel_region->vaddr().as_ptr()); }
+    io_ring_sqe* submission_entries() { return reinterpret_cast<io_ring_sqe*>(m_kernel_region->vaddr().offset(sq_offset()).as_ptr()); }
+    io_ring_cqe* completion_entries() { return reinterpret_cast<io_ring_cqe*>(m_kernel_region->vaddr().offset(cq_offset()).as_ptr()); }
+
+    u32 cq_entries() const { return m_entries * 2; }
+    static size_t sq_offset() { return sizeof(io_ring_header); }
+    size_t cq_offset() const { return sq_offset() + m_entries * sizeof(io_ring_sqe); }
+
+    bool try_post_completion(const io_ring_cqe&);
+    bool try_reserve_completion();
+    void flush_overflowed_completions_locked();
+
+    u32 m_entries { 0 };
+    NonnullRefPtr<AnonymousVMObject> m_vmobject;
+    NonnullOwnPtr<Region> m_kernel_region;
+
+    // Our own copies of the indices we advance, so userspace can't make us skip or repeat entries.
+    SpinLock<u8> m_submission_lock;
+    u32 m_sq_head { 0 };
+
+    SpinLock<u8> m_completion_lock;
+    u32 m_cq_tail { 0 };
+    // Operations that have been submitted, but haven't posted their completion yet.
+    u32 m_pending_completions { 0 };
+    // Completions that didn't fit into the completion queue, in order. Thanks to the reservations
+    // this never holds more than cq_entries(), whatever userspace does with the queue head.
+    Vector<io_ring_cqe> m_overflowed_completions;
+};
+
+}
@@ -33,6 +33,7 @@
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/Net/LocalSocket.h>
+#include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/SharedInodeVMObject.h>
 
 namespace Kernel {
@@ -52,20 +53,85 @@ InlineLinkedList<Inode>& Inode::all_with_lock()
 void Inode::sync()
 {
     NonnullRefPtrVector<Inode, 32> inodes;
+    NonnullRefPtrVector<Inode, 32> inodes_with_dirty_mappings;
     {
         ScopedSpinLock all_inodes_lock(s_all_inodes_lock);
         for (auto& inode : all_with_lock()) {
             if (inode.is_metadata_dirty())
                 inodes.append(inode);
+            if (inode.m_shared_vmobject && inode.m_shared_vmobject->has_dirty_pages())
+                inodes_with_dirty_mappings.append(inode);
         }
     }
 
+    // Only the pages that were written to through a shared mapping get written back.
+    for (auto& inode : inodes_with_dirty_mappings) {
+        RefPtr<SharedInodeVMObject> vmobject = inode.shared_vmobject();
+        if (!vmobject)
+            continue;
+        // sync() has nobody to report to, but the pages stay dirty and get another try next time.
+        auto result = vmobject->write_back_dirty_pages();
+        if (result.is_error())
+            klog() << "Inode::sync: Failed to write back dirty pages of inode " << inode.identifier() << ": " << result.error();
+    }
+
     for (auto& inode : inodes) {
         ASSERT(inode.is_metadata_dirty());
         inode.flush_metadata();
     }
 }
 
+size_t Inode::release_all_unused_cached_pages()
+{
+    NonnullRefPtrVector<Inode, 32> inodes;
+    {
+        ScopedSpinLock all_inodes_lock(s_all_inodes_lock);
+        for (auto& inode : all_with_lock()) {
+            ScopedSpinLock cached_pages_lock(inode.m_cached_pages_lock);
+            if (!inode.m_cached_pages.is_empty())
+                inodes.append(inode);
+        }
+    }
+
+    size_t count = 0;
+    for (auto& inode : inodes)
+        count += inode.release_unused_cached_pages();
+    return count;
+}
+
+size_t Inode::reclaim_unused_cached_pages(size_t max_page_count)
+{
+    // We may be called with the MM lock held from anywhere, including from under these very locks.
+    u32 all_inodes_flags;
+    if (!s_all_inodes_lock.try_lock(all_inodes_flags))
+        return 0;
+
+    size_t released_page_count = 0;
+    for (auto& inode : all_with_lock()) {
+        if (released_page_count >= max_page_count)
+            break;
+        u32 cached_pages_flags;
+        if (!inode.m_cached_pages_lock.try_lock(cached_pages_flags))
+            continue;
+        Vector<size_t, 32> pages_to_release;
+        size_t page_budget = min(max_page_count - released_page_count, pages_to_release.capacity());
+        for (auto& it : inode.m_cached_pages) {
+            if (pages_to_release.size() == page_budget)
+                break;
+            // The cache is always in sync with the disk, so only pages nothing maps need to stay.
+            if (it.value->ref_count() == 1)
+                pages_to_release.append(it.key);
+        }
+        for (auto page_index : pages_to_release)
+            inode.m_cached_pages.remove(page_index);
+        released_page_count += pages_to_release.size();
+        inode.m_cached_pages_lock.unlock(cached_pages_flags);
+    }
+
+    s_all_inodes_lock.unlock(all_inodes_flags);
+    return released_page_count;
+}
+
 KResultOr<KBuffer> Inode::read_entire(FileDescription* descriptor) const
 {
     KBufferBuilder builder;
@@ -127,16 +193,171 @@ void Inode::will_be_destroyed()
 
 void Inode::inode_contents_changed(off_t offset, ssize_t size, const u8* data)
 {
+    update_cached_pages(offset, size, data);
     if (m_shared_vmobject)
         m_shared_vmobject->inode_contents_changed({}, offset, size, data);
 }
 
 void Inode::inode_size_changed(size_t old_size, size_t new_size)
 {
+    if (new_size < old_size)
+        truncate_cached_pages(new_size);
     if (m_shared_vmobject)
         m_shared_vmobject->inode_size_changed({}, old_size, new_size);
 }
 
+KResultOr<NonnullRefPtr<PhysicalPage>> Inode::cached_page(size_t page_index, FileDescription* description)
+{
+    ASSERT(is_page_cacheable());
+    LOCKER(m_lock);
+    if (auto page = cached_page_if_present(page_index))
+        return page.release_nonnull();
+
+    u8 page_buffer[PAGE_SIZE];
+    auto nread = read_bytes(page_index * PAGE_SIZE, PAGE_SIZE, page_buffer, description);
+    if (nread < 0)
+        return KResult(nread);
+    if (nread < PAGE_SIZE) {
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    }
+
+    auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (page.is_null())
+        return KResult(-ENOMEM);
+    {
+        InterruptDisabler disabler;
+        u8* dest_ptr = MM.quickmap_page(*page);
+        memcpy(dest_ptr, page_buffer, PAGE_SIZE);
+        MM.unquickmap_page();
+    }
+    auto cached_page = page.release_nonnull();
+    ScopedSpinLock cached_pages_lock(m_cached_pages_lock);
+    m_cached_pages.set(page_index, cached_page);
+    return cached_page;
+}
+
+RefPtr<PhysicalPage> Inode::cached_page_if_present(size_t page_index)
+{
+    LOCKER(m_lock);
+    ScopedSpinLock cached_pages_lock(m_cached_pages_lock);
+    if (auto it = m_cached_pages.find(page_index); it != m_cached_pages.end())
+        return it->value;
+    return nullptr;
+}
+
+ssize_t Inode::read_bytes_through_page_cache(off_t offset, ssize_t count, u8* buffer, FileDescription* description)
+{
+    ASSERT(offset >= 0);
+    LOCKER(m_lock);
+    if (offset >= (off_t)size())
+        return 0;
+    ssize_t remaining = min((off_t)count, (off_t)size() - offset);
+    ssize_t nread = 0;
+    u8 page_buffer[PAGE_SIZE];
+    while (remaining > 0) {
+        size_t page_index = (offset + nread) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nread) % PAGE_SIZE;
+        size_t chunk_size = min((size_t)remaining, PAGE_SIZE - offset_in_page);
+        auto page_or_error = cached_page(page_index, description);
+        if (page_or_error.is_error())
+            return nread ? nread : page_or_error.error().error();
+        {
+            // The destination may be a userspace buffer, which we can't touch
+            // while the page is quickmapped, so go through the stack.
+            InterruptDisabler disabler;
+            memcpy(page_buffer, MM.quickmap_page(*page_or_error.value()) + offset_in_page, chunk_size);
+            MM.unquickmap_page();
+        }
+        memcpy(buffer + nread, page_buffer, chunk_size);
+        nread += chunk_size;
+        remaining -= chunk_size;
+    }
+    return nread;
+}
+
+void Inode::update_cached_pages(off_t offset, ssize_t size, const u8* data)
+{
+    if (!data || size <= 0)
+        return;
+    LOCKER(m_lock);
+    {
+        ScopedSpinLock cached_pages_lock(m_cached_pages_lock);
+        if (m_cached_pages.is_empty())
+            return;
+    }
+    u8 page_buffer[PAGE_SIZE];
+    ssize_t nwritten = 0;
+    while (nwritten < size) {
+        size_t page_index = (offset + nwritten) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nwritten) % PAGE_SIZE;
+        size_t chunk_size = min((size_t)(size - nwritten), PAGE_SIZE - offset_in_page);
+        if (auto page = cached_page_if_present(page_index)) {
+            memcpy(page_buffer, data + nwritten, chunk_size);
+            InterruptDisabler disabler;
+            memcpy(MM.quickmap_page(*page) + offset_in_page, page_buffer, chunk_size);
+            MM.unquickmap_page();
+        }
+        nwritten += chunk_size;
+    }
+}
+
+void Inode::truncate_cached_pages(size_t new_size)
+{
+    LOCKER(m_lock);
+    ScopedSpinLock cached_pages_lock(m_cached_pages_lock);
+    if (m_cached_pages.is_empty())
+        return;
+    size_t first_page_to_drop = PAGE_ROUND_UP(new_size) / PAGE_SIZE;
+    Vector<size_t> pages_to_drop;
+    for (auto& it : m_cached_pages) {
+        if (it.key >= first_page_to_drop)
+            pages_to_drop.append(it.key);
+    }
+    for (auto page_index : pages_to_drop)
+        m_cached_pages.remove(page_index);
+
+    // The cut-off tail of the last page must read back as zeroes if the file grows again.
+    if (size_t offset_in_page = new_size % PAGE_SIZE) {
+        auto it = m_cached_pages.find(new_size / PAGE_SIZE);
+        if (it != m_cached_pages.end()) {
+            InterruptDisabler disabler;
+            memset(MM.quickmap_page(*it->value) + offset_in_page, 0, PAGE_SIZE - offset_in_page);
+            MM.unquickmap_page();
+        }
+    }
+}
+
+size_t Inode::release_unused_cached_pages()
+{
+    LOCKER(m_lock);
+    ScopedSpinLock cached_pages_lock(m_cached_pages_lock);
+    Vector<size_t> pages_to_release;
+    for (auto& it : m_cached_pages) {
+        // Pages mapped into some address space are still referenced by their VMObject.
+        if (it.value->ref_count() == 1)
+            pages_to_release.append(it.key);
+    }
+    for (auto page_index : pages_to_release)
+        m_cached_pages.remove(page_index);
+    return pages_to_release.size();
+}
+
+size_t Inode::release_unused_cached_pages(size_t first_page_index, size_t page_count)
+{
+    LOCKER(m_lock);
+    ScopedSpinLock cached_pages_lock(m_cached_pages_lock);
+    size_t released_page_count = 0;
+    for (size_t page_index = first_page_index; page_index < first_page_index + page_count; ++page_index) {
+        auto it = m_cached_pages.find(page_index);
+        if (it == m_cached_pages.end() || it->value->ref_count() != 1)
+            continue;
+        m_cached_pages.remove(it);
+        ++released_page_count;
+    }
+    return released_page_count;
+}
+
 int Inode::set_atime(time_t)
 {
     return -ENOTIMPL;
@@ -229,6 +450,7 @@ void Inode::set_metadata_dirty(bool metadata_dirty)
 
 void Inode::did_add_child(const String& name)
 {
+    VFS::the().directory_entry_cache().invalidate(identifier(), name);
     LOCKER(m_lock);
     for (auto& watcher : m_watchers) {
         watcher->notify_child_added({}, name);
@@ -237,6 +459,7 @@ void Inode::did_add_child(const String& name)
 
 void Inode::did_remove_child(const String& name)
 {
+    VFS::the().directory_entry_cache().invalidate(identifier(), name);
     LOCKER(m_lock);
     for (auto& watcher : m_watchers) {
         watcher->notify_child_removed({}, name);
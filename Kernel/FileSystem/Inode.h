@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Function.h>
+#include <AK/HashMap.h>
 #include <AK/HashTable.h>
 #include <AK/InlineLinkedList.h>
 #include <AK/RefCounted.h>
@@ -39,6 +40,7 @@
 #include <Kernel/Forward.h>
 #include <Kernel/KResult.h>
 #include <Kernel/Lock.h>
+#include <Kernel/SpinLock.h>
 
 namespace Kernel {
 
@@ -101,6 +103,20 @@ public:
 
     void will_be_destroyed();
 
+    // The page cache holds file data for read(), write() and mmap() alike.
+    // File systems that keep their data in memory anyway can hand out their own pages instead.
+    virtual bool is_page_cacheable() const { return false; }
+    virtual KResultOr<NonnullRefPtr<PhysicalPage>> cached_page(size_t page_index, FileDescription* = nullptr);
+    virtual RefPtr<PhysicalPage> cached_page_if_present(size_t page_index);
+    // Hint that the given pages are about to be needed, so the file system can start fetching them.
+    virtual void read_ahead_pages(size_t, size_t) { }
+    ssize_t read_bytes_through_page_cache(off_t, ssize_t, u8* buffer, FileDescription*);
+    size_t release_unused_cached_pages();
+    size_t release_unused_cached_pages(size_t first_page_index, size_t page_count);
+    static size_t release_all_unused_cached_pages();
+    // For the MemoryManager running out of physical pages: it can't block, so busy inodes are skipped.
+    static size_t reclaim_unused_cached_pages(size_t max_page_count);
+
     void set_shared_vmobject(SharedInodeVMObject&);
     SharedInodeVMObject* shared_vmobject() { return m_shared_vmobject.ptr(); }
     const SharedInodeVMObject* shared_vmobject() const { return m_shared_vmobject.ptr(); }
@@ -126,6 +142,9 @@ protected:
     void inode_size_changed(size_t old_size, size_t new_size);
     KResult prepare_to_write_data();
 
+    void update_cached_pages(off_t, ssize_t, const u8*);
+    void truncate_cached_pages(size_t new_size);
+
     void did_add_child(const String& name);
     void did_remove_child(const String& name);
 
@@ -139,6 +158,9 @@ private:
     HashTable<InodeWatcher*> m_watchers;
     bool m_metadata_dirty { false };
     RefPtr<FIFO> m_fifo;
+    // Besides m_lock, the cached pages are guarded by a spinlock, so that memory reclaim can drop the unused ones.
+    mutable SpinLock<u8> m_cached_pages_lock;
+    HashMap<size_t, NonnullRefPtr<PhysicalPage>> m_cached_pages;
 };
 
 }
@@ -46,7 +46,11 @@ InodeFile::~InodeFile()
 
 KResultOr<size_t> InodeFile::read(FileDescription& description, size_t offset, u8* buffer, size_t count)
 {
-    ssize_t nread = m_inode->read_bytes(offset, count, buffer, &description);
+    ssize_t nread;
+    if (m_inode->is_page_cacheable() && !description.is_direct())
+        nread = m_inode->read_bytes_through_page_cache(offset, count, buffer, &description);
+    else
+        nread = m_inode->read_bytes(offset, count, buffer, &description);
     if (nread > 0)
         Thread::current()->did_file_read(nread);
     if (nread < 0)
@@ -60,6 +64,7 @@ KResultOr<size_t> InodeFile::write(FileDescription& description, size_t offset,
     if (nwritten > 0) {
         m_inode->set_mtime(kgettimeofday().tv_sec);
         Thread::current()->did_file_write(nwritten);
+        m_inode->fs().throttle_writer();
     }
     if (nwritten < 0)
         return KResult(nwritten);
@@ -513,16 +513,8 @@ bool Plan9FS::Blocker::should_unblock(Thread&)
     return false;
 }
 
-KResult Plan9FS::wait_for_specific_message(u16 tag, Message& out_message)
+KResult Plan9FS::wait_for_completion(ReceiveCompletion& completion, u16 tag)
 {
-    KResult result = KSuccess;
-    ReceiveCompletion completion { *this, out_message, result, false };
-
-    {
-        LOCKER(m_lock);
-        m_completions.set(tag, &completion);
-    }
-
     // Block until either:
     // * Someone else reads the message we're waiting for, and hands it to us;
     // * Or we become the one to read and dispatch messages.
@@ -535,9 +527,10 @@ KResult Plan9FS::wait_for_specific_message(u16 tag, Message& out_message)
     // See for which reason we woke up.
     if (completion.completed) {
         // Somebody else completed it for us; nothing further to do.
-        return result;
+        return completion.result;
     }
 
+    KResult result = KSuccess;
     while (!completion.completed && result.is_success()) {
         result = read_and_dispatch_one_message();
     }
@@ -556,7 +549,7 @@ KResult Plan9FS::wait_for_specific_message(u16 tag, Message& out_message)
     // Wake up someone else, if anyone is interested...
     m_someone_is_reading = false;
     // ...and return.
-    return result;
+    return result.is_error() ? result : completion.result;
 }
 
 KResult Plan9FS::post_message_and_explicitly_ignore_reply(Message& message)
@@ -580,16 +573,79 @@ KResult Plan9FS::post_message_and_wait_for_a_reply(Message& message, bool auto_c
 {
     auto request_type = message.type();
     auto tag = message.tag();
+
+    // Register for the reply before sending, since whoever is reading may receive it right away.
+    ReceiveCompletion completion { *this, message };
+    {
+        LOCKER(m_lock);
+        m_completions.set(tag, &completion);
+    }
+
     auto result = post_message(message);
-    if (result.is_error())
+    if (result.is_error()) {
+        LOCKER(m_lock);
+        m_completions.remove(tag);
         return result;
-    result = wait_for_specific_message(tag, message);
+    }
+    result = wait_for_completion(completion, tag);
     if (result.is_error())
         return result;
 
     if (!auto_convert_error_reply_to_error)
         return KSuccess;
 
+    return check_reply((u8)request_type, message);
+}
+
+KResult Plan9FS::post_messages_and_wait_for_replies(NonnullOwnPtrVector<Message>& messages)
+{
+    // All the requests go out before we wait for any of the replies, so that a large read or
+    // write costs one round trip instead of one per message. The replies replace the requests.
+    Vector<u16, max_requests_in_flight> tags;
+    NonnullOwnPtrVector<ReceiveCompletion, max_requests_in_flight> completions;
+    {
+        LOCKER(m_lock);
+        for (auto& message : messages) {
+            tags.append(message.tag());
+            completions.append(make<ReceiveCompletion>(*this, message));
+            m_completions.set(message.tag(), &completions.last());
+        }
+    }
+
+    KResult result = KSuccess;
+    size_t posted_count = 0;
+    for (; posted_count < messages.size(); ++posted_count) {
+        result = post_message(messages[posted_count]);
+        if (result.is_error())
+            break;
+    }
+
+    size_t completed_count = 0;
+    for (; completed_count < posted_count; ++completed_count) {
+        auto completion_result = wait_for_completion(completions[completed_count], tags[completed_count]);
+        if (completion_result.is_error()) {
+            result = completion_result;
+            break;
+        }
+    }
+
+    if (completed_count < messages.size()) {
+        // We're giving up on the rest, so they mustn't be handed to us anymore.
+        LOCKER(m_lock);
+        for (size_t i = completed_count; i < messages.size(); ++i) {
+            if (completions[i].completed)
+                continue;
+            m_completions.remove(tags[i]);
+            if (i < posted_count)
+                m_tags_to_ignore.set(tags[i]);
+        }
+    }
+
+    return result;
+}
+
+KResult Plan9FS::check_reply(u8 request_type, Message& message) const
+{
     auto reply_type = message.type();
 
     if (reply_type == Message::Type::Rlerror) {
@@ -605,21 +661,25 @@ KResult Plan9FS::post_message_and_wait_for_a_reply(Message& message, bool auto_c
         message >> error_name;
         dbg() << "Plan9FS: Received error name " << error_name;
         return KResult(-EIO);
-    } else if ((u8)reply_type != (u8)request_type + 1) {
+    } else if ((u8)reply_type != request_type + 1) {
         // Other than those error messages. we only expect the matching reply
         // message type.
         dbg() << "Plan9FS: Received unexpected message type " << (u8)reply_type
-              << " in response to " << (u8)request_type;
+              << " in response to " << request_type;
         return KResult(-EIO);
     } else {
         return KSuccess;
     }
 }
 
+size_t Plan9FS::max_data_size() const
+{
+    return m_max_message_size - Message::max_header_size;
+}
+
 ssize_t Plan9FS::adjust_buffer_size(ssize_t size) const
 {
-    ssize_t max_size = m_max_message_size - Message::max_header_size;
-    return min(size, max_size);
+    return min(size, (ssize_t)max_data_size());
 }
 
 Plan9FSInode::Plan9FSInode(Plan9FS& fs, u32 fid)
@@ -677,41 +737,98 @@ KResult Plan9FSInode::ensure_open_for_mode(int mode)
     }
 }
 
+void Plan9FSInode::discard_read_ahead()
+{
+    LOCKER(m_lock);
+    m_read_ahead_data.clear();
+}
+
 ssize_t Plan9FSInode::read_bytes(off_t offset, ssize_t size, u8* buffer, FileDescription*) const
 {
     auto result = const_cast<Plan9FSInode&>(*this).ensure_open_for_mode(O_RDONLY);
     if (result.is_error())
         return result;
 
-    size = fs().adjust_buffer_size(size);
-
-    Plan9FS::Message message { fs(), Plan9FS::Message::Type::Treadlink };
-    StringView data;
-
     // Try readlink first.
-    bool readlink_succeded = false;
     if (fs().m_remote_protocol_version >= Plan9FS::ProtocolVersion::v9P2000L && offset == 0) {
+        Plan9FS::Message message { fs(), Plan9FS::Message::Type::Treadlink };
         message << fid();
         result = fs().post_message_and_wait_for_a_reply(message);
         if (result.is_success()) {
-            readlink_succeded = true;
+            StringView data;
             message >> data;
+            size_t nread = min(data.length(), (size_t)fs().adjust_buffer_size(size));
+            memcpy(buffer, data.characters_without_null_termination(), nread);
+            return nread;
         }
     }
 
-    if (!readlink_succeded) {
-        message = Plan9FS::Message { fs(), Plan9FS::Message::Type::Tread };
-        message << fid() << (u64)offset << (u32)size;
-        result = fs().post_message_and_wait_for_a_reply(message);
-        if (result.is_error())
-            return result.error();
-        data = message.read_data();
+    bool is_sequential;
+    {
+        LOCKER(m_lock);
+        if (m_read_ahead_data.has_value() && (u64)offset >= m_read_ahead_offset && (u64)offset < m_read_ahead_offset + m_read_ahead_data.value().size()) {
+            auto& read_ahead_data = m_read_ahead_data.value();
+            size_t offset_into_read_ahead = offset - m_read_ahead_offset;
+            size_t nread = min((size_t)size, read_ahead_data.size() - offset_into_read_ahead);
+            memcpy(buffer, read_ahead_data.data() + offset_into_read_ahead, nread);
+            m_next_read_offset = offset + nread;
+            return nread;
+        }
+        m_read_ahead_data.clear();
+        is_sequential = (u64)offset == m_next_read_offset;
     }
 
-    // Guard against the server returning more data than requested.
-    size_t nread = min(data.length(), (size_t)size);
-    memcpy(buffer, data.characters_without_null_termination(), nread);
+    // Large reads are split into several Treads that are all sent at once. Sequential readers
+    // also get a whole message worth of data, and whatever they didn't ask for is kept around.
+    size_t chunk_size = fs().max_data_size();
+    size_t wanted = size;
+    if (is_sequential)
+        wanted = max(wanted, chunk_size);
+    size_t request_count = min(ceil_div(wanted, chunk_size), Plan9FS::max_requests_in_flight);
+    if (!request_count)
+        return 0;
+
+    NonnullOwnPtrVector<Plan9FS::Message> messages;
+    for (size_t i = 0; i < request_count; ++i) {
+        auto message = make<Plan9FS::Message>(fs(), Plan9FS::Message::Type::Tread);
+        *message << fid() << (u64)(offset + i * chunk_size) << (u32)min(chunk_size, wanted - i * chunk_size);
+        messages.append(move(message));
+    }
+    result = fs().post_messages_and_wait_for_replies(messages);
+    if (result.is_error())
+        return result.error();
 
+    size_t nread = 0;
+    StringView read_ahead_data;
+    for (size_t i = 0; i < request_count; ++i) {
+        result = fs().check_reply((u8)Plan9FS::Message::Type::Tread, messages[i]);
+        if (result.is_error()) {
+            if (i == 0)
+                return result.error();
+            break;
+        }
+        // Guard against the server returning more data than requested.
+        size_t requested = min(chunk_size, wanted - i * chunk_size);
+        auto data = messages[i].read_data();
+        data = data.substring_view(0, min(data.length(), requested));
+
+        size_t count_for_caller = min(data.length(), (size_t)size - nread);
+        memcpy(buffer + nread, data.characters_without_null_termination(), count_for_caller);
+        nread += count_for_caller;
+        // Only the last reply we need can be longer than what's left to read.
+        if (count_for_caller < data.length())
+            read_ahead_data = data.substring_view(count_for_caller, data.length() - count_for_caller);
+
+        if (data.length() < requested)
+            break;
+    }
+
+    LOCKER(m_lock);
+    m_next_read_offset = offset + nread;
+    if (!read_ahead_data.is_empty()) {
+        m_read_ahead_data = KBuffer::copy(read_ahead_data.characters_without_null_termination(), read_ahead_data.length());
+        m_read_ahead_offset = offset + nread;
+    }
     return nread;
 }
 
@@ -721,18 +838,39 @@ ssize_t Plan9FSInode::write_bytes(off_t offset, ssize_t size, const u8* data, Fi
     if (result.is_error())
         return result;
 
-    size = fs().adjust_buffer_size(size);
+    discard_read_ahead();
 
-    Plan9FS::Message message { fs(), Plan9FS::Message::Type::Twrite };
-    message << fid() << (u64)offset;
-    message.append_data({ data, (size_t)size });
-    result = fs().post_message_and_wait_for_a_reply(message);
+    // Like reads, large writes are sent as several Twrites in flight at once.
+    size_t chunk_size = fs().max_data_size();
+    size_t request_count = max((size_t)1, min(ceil_div((size_t)size, chunk_size), Plan9FS::max_requests_in_flight));
+
+    NonnullOwnPtrVector<Plan9FS::Message> messages;
+    for (size_t i = 0; i < request_count; ++i) {
+        size_t chunk_offset = i * chunk_size;
+        auto message = make<Plan9FS::Message>(fs(), Plan9FS::Message::Type::Twrite);
+        *message << fid() << (u64)(offset + chunk_offset);
+        message->append_data({ data + chunk_offset, min(chunk_size, (size_t)size - chunk_offset) });
+        messages.append(move(message));
+    }
+    result = fs().post_messages_and_wait_for_replies(messages);
     if (result.is_error())
         return result.error();
 
-    u32 nwritten;
-    message >> nwritten;
-    return nwritten;
+    ssize_t total_written = 0;
+    for (size_t i = 0; i < request_count; ++i) {
+        result = fs().check_reply((u8)Plan9FS::Message::Type::Twrite, messages[i]);
+        if (result.is_error()) {
+            if (i == 0)
+                return result.error();
+            break;
+        }
+        u32 nwritten;
+        messages[i] >> nwritten;
+        total_written += nwritten;
+        if (nwritten < min(chunk_size, (size_t)size - i * chunk_size))
+            break;
+    }
+    return total_written;
 }
 
 InodeMetadata Plan9FSInode::metadata() const
@@ -917,6 +1055,7 @@ KResult Plan9FSInode::chown(uid_t, gid_t)
 
 KResult Plan9FSInode::truncate(u64 new_size)
 {
+    discard_read_ahead();
     if (fs().m_remote_protocol_version >= Plan9FS::ProtocolVersion::v9P2000L) {
         Plan9FS::Message message { fs(), Plan9FS::Message::Type::Tsetattr };
         SetAttrMask valid = SetAttrMask::Size;
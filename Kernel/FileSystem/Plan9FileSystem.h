@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Atomic.h>
+#include <AK/NonnullOwnPtrVector.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/KBufferBuilder.h>
@@ -68,11 +69,20 @@ public:
 private:
     Plan9FS(FileDescription&);
 
+    // How many requests a single read() or write() may have in flight at once.
+    static constexpr size_t max_requests_in_flight = 8;
+
     struct ReceiveCompletion {
+        ReceiveCompletion(Plan9FS& fs, Message& message)
+            : fs(fs)
+            , message(message)
+        {
+        }
+
         Plan9FS& fs;
         Message& message;
-        KResult& result;
-        Atomic<bool> completed;
+        KResult result { KSuccess };
+        Atomic<bool> completed { false };
     };
 
     class Blocker final : public Thread::Blocker {
@@ -93,11 +103,14 @@ private:
     KResult post_message(Message&);
     KResult do_read(u8* buffer, size_t);
     KResult read_and_dispatch_one_message();
-    KResult wait_for_specific_message(u16 tag, Message& out_message);
+    KResult wait_for_completion(ReceiveCompletion&, u16 tag);
     KResult post_message_and_wait_for_a_reply(Message&, bool auto_convert_error_reply_to_error = true);
+    KResult post_messages_and_wait_for_replies(NonnullOwnPtrVector<Message>&);
     KResult post_message_and_explicitly_ignore_reply(Message&);
+    KResult check_reply(u8 request_type, Message& reply) const;
 
     ProtocolVersion parse_protocol_version(const StringView&) const;
+    size_t max_data_size() const;
     ssize_t adjust_buffer_size(ssize_t size) const;
 
     RefPtr<Plan9FSInode> m_root_inode;
@@ -105,7 +118,7 @@ private:
     Atomic<u32> m_next_fid { 1 };
 
     ProtocolVersion m_remote_protocol_version { ProtocolVersion::v9P2000 };
-    size_t m_max_message_size { 4 * KiB };
+    size_t m_max_message_size { 64 * KiB };
 
     Lock m_send_lock { "Plan9FS send" };
     Atomic<bool> m_someone_is_reading { false };
@@ -177,6 +190,12 @@ private:
     int m_open_mode { 0 };
     KResult ensure_open_for_mode(int mode);
 
+    // Data just past the end of the last read, fetched along with it when reading sequentially.
+    mutable Optional<KBuffer> m_read_ahead_data;
+    mutable u64 m_read_ahead_offset { 0 };
+    mutable u64 m_next_read_offset { 0 };
+    void discard_read_ahead();
+
     Plan9FS& fs() { return reinterpret_cast<Plan9FS&>(Inode::fs()); }
     Plan9FS& fs() const
     {
@@ -28,6 +28,7 @@
 #include <AK/JsonObject.h>
 #include <AK/JsonObjectSerializer.h>
 #include <AK/JsonValue.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Arch/i386/ProcessorInfo.h>
 #include <Kernel/CommandLine.h>
@@ -54,6 +55,7 @@
 #include <Kernel/Process.h>
 #include <Kernel/Profiling.h>
 #include <Kernel/Scheduler.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/TTY/TTY.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -84,6 +86,8 @@ enum ProcFileType {
     FI_Root_df,
     FI_Root_all,
     FI_Root_memstat,
+    FI_Root_all_binary,
+    FI_Root_memstat_binary,
     FI_Root_cpuinfo,
     FI_Root_inodes,
     FI_Root_dmesg,
@@ -95,6 +99,7 @@ enum ProcFileType {
     FI_Root_cmdline,
     FI_Root_modules,
     FI_Root_profile,
+    FI_Root_spinlocks,
     FI_Root_self, // symlink
     FI_Root_sys,  // directory
     FI_Root_net,  // directory
@@ -116,6 +121,7 @@ enum ProcFileType {
     FI_PID_stacks, // directory
     FI_PID_fds,
     FI_PID_unveil,
+    FI_PID_io,
     FI_PID_exe,  // symlink
     FI_PID_cwd,  // symlink
     FI_PID_root, // symlink
@@ -493,6 +499,33 @@ static Optional<KBuffer> procfs$profile(InodeIdentifier)
     return builder.build();
 }
 
+#ifdef SPINLOCK_STATISTICS
+extern FlatPtr start_of_kernel_data;
+extern FlatPtr end_of_kernel_bss;
+
+static Optional<KBuffer> procfs$spinlocks(InodeIdentifier)
+{
+    KBufferBuilder builder;
+    JsonArraySerializer array { builder };
+    for (auto& statistics : SpinLockStatistics::snapshot()) {
+        auto obj = array.add_object();
+        FlatPtr address = (FlatPtr)statistics.lock;
+        obj.add("address", address);
+        // Only locks that are globals have a symbol of their own, the rest live in some heap object.
+        if (address >= (FlatPtr)&start_of_kernel_data && address < (FlatPtr)&end_of_kernel_bss) {
+            if (auto* symbol = symbolicate_kernel_address(address))
+                obj.add("symbol", String::format("%s+%u", symbol->name, address - symbol->address));
+        }
+        obj.add("acquisitions", statistics.acquisitions);
+        obj.add("contended_acquisitions", statistics.contended_acquisitions);
+        obj.add("spins", statistics.spins);
+        obj.add("max_hold_cycles", statistics.max_hold_cycles);
+    }
+    array.finish();
+    return builder.build();
+}
+#endif
+
 static Optional<KBuffer> procfs$net_adapters(InodeIdentifier)
 {
     KBufferBuilder builder;
@@ -550,6 +583,11 @@ static Optional<KBuffer> procfs$net_tcp(InodeIdentifier)
         obj.add("bytes_in", socket.bytes_in());
         obj.add("packets_out", socket.packets_out());
         obj.add("bytes_out", socket.bytes_out());
+        obj.add("congestion_control", socket.congestion_control_name());
+        obj.add("congestion_window", socket.congestion_window());
+        obj.add("send_window", socket.send_window());
+        obj.add("smoothed_rtt_ms", socket.smoothed_rtt_ms());
+        obj.add("retransmission_timeout_ms", socket.retransmission_timeout_ms());
     });
     array.finish();
     return builder.build();
@@ -630,6 +668,7 @@ static Optional<KBuffer> procfs$pid_unveil(InodeIdentifier identifier)
         return {};
     KBufferBuilder builder;
     JsonArraySerializer array { builder };
+    LOCKER(process->filesystem_lock());
     for (auto& unveiled_path : process->unveiled_paths()) {
         auto obj = array.add_object();
         obj.add("path", unveiled_path.path);
@@ -648,6 +687,55 @@ static Optional<KBuffer> procfs$pid_unveil(InodeIdentifier identifier)
     return builder.build();
 }
 
+static void serialize_io_statistics(JsonObjectSerializer<KBufferBuilder>& object, const IOStatistics& statistics)
+{
+    object.add("syscall_count", statistics.syscall_count);
+    object.add("file_read_bytes", statistics.file_read_bytes);
+    object.add("file_write_bytes", statistics.file_write_bytes);
+    object.add("unix_socket_read_bytes", statistics.unix_socket_read_bytes);
+    object.add("unix_socket_write_bytes", statistics.unix_socket_write_bytes);
+    object.add("ipv4_socket_read_bytes", statistics.ipv4_socket_read_bytes);
+    object.add("ipv4_socket_write_bytes", statistics.ipv4_socket_write_bytes);
+    object.add("block_io_requests", statistics.block_io_requests);
+
+    auto add_histogram = [&](const char* name, const LatencyHistogram& histogram) {
+        auto array = object.add_array(name);
+        for (size_t i = 0; i < LatencyHistogram::bucket_count; ++i)
+            array.add(histogram.at(i));
+        array.finish();
+    };
+    add_histogram("read_latency", statistics.read_latency);
+    add_histogram("write_latency", statistics.write_latency);
+    add_histogram("page_fault_latency", statistics.page_fault_latency);
+}
+
+static Optional<KBuffer> procfs$pid_io(InodeIdentifier identifier)
+{
+    auto process = Process::from_pid(to_pid(identifier));
+    if (!process)
+        return {};
+    KBufferBuilder builder;
+    JsonObjectSerializer object { builder };
+    serialize_io_statistics(object, process->io_statistics());
+
+    // Every histogram bucket ends where the next one begins, except for the last one, which has no end.
+    auto bounds_array = object.add_array("latency_bucket_bounds_us");
+    for (size_t i = 0; i < LatencyHistogram::bucket_count - 1; ++i)
+        bounds_array.add(LatencyHistogram::bucket_upper_bound_us(i));
+    bounds_array.finish();
+
+    auto thread_array = object.add_array("threads");
+    process->for_each_thread([&](const Thread& thread) {
+        auto thread_object = thread_array.add_object();
+        thread_object.add("tid", thread.tid().value());
+        serialize_io_statistics(thread_object, thread.io_statistics());
+        return IterationDecision::Continue;
+    });
+    thread_array.finish();
+    object.finish();
+    return builder.build();
+}
+
 static Optional<KBuffer> procfs$tid_stack(InodeIdentifier identifier)
 {
     auto thread = Thread::from_tid(to_tid(identifier));
@@ -674,7 +762,7 @@ static Optional<KBuffer> procfs$pid_cwd(InodeIdentifier identifier)
     auto process = Process::from_pid(to_pid(identifier));
     if (!process)
         return {};
-    return process->current_directory().absolute_path().to_byte_buffer();
+    return process->current_directory()->absolute_path().to_byte_buffer();
 }
 
 static Optional<KBuffer> procfs$pid_root(InodeIdentifier identifier)
@@ -682,7 +770,7 @@ static Optional<KBuffer> procfs$pid_root(InodeIdentifier identifier)
     auto process = Process::from_pid(to_pid(identifier));
     if (!process)
         return {};
-    return process->root_directory_relative_to_global_root().absolute_path().to_byte_buffer();
+    return process->root_directory_relative_to_global_root()->absolute_path().to_byte_buffer();
 }
 
 static Optional<KBuffer> procfs$self(InodeIdentifier)
@@ -794,14 +882,21 @@ static Optional<KBuffer> procfs$cpuinfo(InodeIdentifier)
 
 Optional<KBuffer> procfs$memstat(InodeIdentifier)
 {
+    kmalloc_stats heap_stats;
+    get_kmalloc_stats(heap_stats);
     InterruptDisabler disabler;
     KBufferBuilder builder;
     JsonObjectSerializer<KBufferBuilder> json { builder };
-    json.add("kmalloc_allocated", g_kmalloc_bytes_allocated);
-    json.add("kmalloc_available", g_kmalloc_bytes_free);
-    json.add("kmalloc_eternal_allocated", g_kmalloc_bytes_eternal);
+    json.add("kmalloc_allocated", heap_stats.bytes_allocated);
+    json.add("kmalloc_available", heap_stats.bytes_free);
+    json.add("kmalloc_eternal_allocated", heap_stats.bytes_eternal);
+    json.add("kmalloc_subheap_count", heap_stats.subheap_count);
+    json.add("kmalloc_free_run_count", heap_stats.free_run_count);
+    json.add("kmalloc_largest_free_run", heap_stats.largest_free_run);
     json.add("user_physical_allocated", MM.user_physical_pages_used());
     json.add("user_physical_available", MM.user_physical_pages() - MM.user_physical_pages_used());
+    json.add("user_physical_compressed", MM.compressed_user_pages());
+    json.add("user_physical_compressed_bytes", MM.compressed_user_bytes());
     json.add("super_physical_allocated", MM.super_physical_pages_used());
     json.add("super_physical_available", MM.super_physical_pages() - MM.super_physical_pages_used());
     json.add("kmalloc_call_count", g_kmalloc_call_count);
@@ -885,12 +980,15 @@ static Optional<KBuffer> procfs$all(InodeIdentifier)
             thread_object.add("inode_faults", thread.inode_faults());
             thread_object.add("zero_faults", thread.zero_faults());
             thread_object.add("cow_faults", thread.cow_faults());
+            thread_object.add("fpu_saves", thread.fpu_saves());
+            thread_object.add("fpu_restores", thread.fpu_restores());
             thread_object.add("file_read_bytes", thread.file_read_bytes());
             thread_object.add("file_write_bytes", thread.file_write_bytes());
             thread_object.add("unix_socket_read_bytes", thread.unix_socket_read_bytes());
             thread_object.add("unix_socket_write_bytes", thread.unix_socket_write_bytes());
             thread_object.add("ipv4_socket_read_bytes", thread.ipv4_socket_read_bytes());
             thread_object.add("ipv4_socket_write_bytes", thread.ipv4_socket_write_bytes());
+            thread_object.add("block_io_requests", thread.block_io_requests());
             return IterationDecision::Continue;
         });
     };
@@ -904,6 +1002,171 @@ static Optional<KBuffer> procfs$all(InodeIdentifier)
     return builder.build();
 }
 
+template<size_t N>
+static void copy_to_record_field(char (&field)[N], const StringView& string)
+{
+    size_t length = min(string.length(), N - 1);
+    memcpy(field, string.characters_without_null_termination(), length);
+    memset(field + length, 0, N - length);
+}
+
+static void append_record(KBufferBuilder& builder, const void* record, size_t size)
+{
+    builder.append(reinterpret_cast<const char*>(record), size);
+}
+
+static Optional<KBuffer> procfs$memstat_binary(InodeIdentifier)
+{
+    kmalloc_stats heap_stats;
+    get_kmalloc_stats(heap_stats);
+    InterruptDisabler disabler;
+    KBufferBuilder builder;
+
+    MemoryStatsFileHeader file_header {};
+    file_header.header = { PROC_STATS_MAGIC, PROC_STATS_VERSION, sizeof(MemoryStatsFileHeader) };
+    file_header.memory_record_size = sizeof(MemoryStatsRecord);
+    file_header.slab_record_size = sizeof(SlabStatsRecord);
+    append_record(builder, &file_header, sizeof(file_header));
+
+    MemoryStatsRecord record;
+    record.kmalloc_allocated = heap_stats.bytes_allocated;
+    record.kmalloc_available = heap_stats.bytes_free;
+    record.kmalloc_eternal_allocated = heap_stats.bytes_eternal;
+    record.kmalloc_subheap_count = heap_stats.subheap_count;
+    record.kmalloc_free_run_count = heap_stats.free_run_count;
+    record.kmalloc_largest_free_run = heap_stats.largest_free_run;
+    record.user_physical_allocated = MM.user_physical_pages_used();
+    record.user_physical_available = MM.user_physical_pages() - MM.user_physical_pages_used();
+    record.user_physical_compressed = MM.compressed_user_pages();
+    record.user_physical_compressed_bytes = MM.compressed_user_bytes();
+    record.super_physical_allocated = MM.super_physical_pages_used();
+    record.super_physical_available = MM.super_physical_pages() - MM.super_physical_pages_used();
+    record.kmalloc_call_count = g_kmalloc_call_count;
+    record.kfree_call_count = g_kfree_call_count;
+    append_record(builder, &record, sizeof(record));
+
+    slab_alloc_stats([&](size_t slab_size, size_t num_allocated, size_t num_free) {
+        SlabStatsRecord slab_record { static_cast<u32>(slab_size), static_cast<u32>(num_allocated), static_cast<u32>(num_free) };
+        append_record(builder, &slab_record, sizeof(slab_record));
+        ++file_header.slab_count;
+    });
+
+    builder.overwrite(0, &file_header, sizeof(file_header));
+    return builder.build();
+}
+
+static Optional<KBuffer> procfs$all_binary(InodeIdentifier)
+{
+    KBufferBuilder builder;
+
+    ProcessStatsFileHeader file_header {};
+    file_header.header = { PROC_STATS_MAGIC, PROC_STATS_VERSION, sizeof(ProcessStatsFileHeader) };
+    file_header.process_record_size = sizeof(ProcessStatsRecord);
+    file_header.thread_record_size = sizeof(ThreadStatsRecord);
+    append_record(builder, &file_header, sizeof(file_header));
+
+    // Keep this in sync with procfs$all().
+    auto build_process = [&](const Process& process) {
+        ProcessStatsRecord record;
+        record.pid = process.pid().value();
+        record.pgid = process.tty() ? process.tty()->pgid().value() : 0;
+        record.pgp = process.pgid().value();
+        record.sid = process.sid().value();
+        record.uid = process.uid();
+        record.gid = process.gid();
+        record.ppid = process.ppid().value();
+        record.nfds = process.number_of_open_file_descriptors();
+        record.amount_virtual = process.amount_virtual();
+        record.amount_resident = process.amount_resident();
+        record.amount_shared = process.amount_shared();
+        record.amount_dirty_private = process.amount_dirty_private();
+        record.amount_clean_inode = process.amount_clean_inode();
+        record.amount_purgeable_volatile = process.amount_purgeable_volatile();
+        record.amount_purgeable_nonvolatile = process.amount_purgeable_nonvolatile();
+        record.icon_id = process.icon_id();
+        record.thread_count = 0;
+        copy_to_record_field(record.name, process.name());
+        if (process.tty())
+            copy_to_record_field(record.tty, process.tty()->tty_name());
+        else
+            copy_to_record_field(record.tty, "notty");
+
+        memset(record.pledge, 0, sizeof(record.pledge));
+        memset(record.veil, 0, sizeof(record.veil));
+        if (process.is_ring3()) {
+            size_t pledge_length = 0;
+            auto append_promise = [&](const StringView& promise) {
+                if (pledge_length + promise.length() + 1 >= sizeof(record.pledge))
+                    return;
+                memcpy(record.pledge + pledge_length, promise.characters_without_null_termination(), promise.length());
+                pledge_length += promise.length();
+                record.pledge[pledge_length++] = ' ';
+            };
+#define __ENUMERATE_PLEDGE_PROMISE(promise)      \
+    if (process.has_promised(Pledge::promise)) { \
+        append_promise(#promise);                \
+    }
+            ENUMERATE_PLEDGE_PROMISES
+#undef __ENUMERATE_PLEDGE_PROMISE
+
+            switch (process.veil_state()) {
+            case VeilState::None:
+                copy_to_record_field(record.veil, "None");
+                break;
+            case VeilState::Dropped:
+                copy_to_record_field(record.veil, "Dropped");
+                break;
+            case VeilState::Locked:
+                copy_to_record_field(record.veil, "Locked");
+                break;
+            }
+        }
+
+        // The thread count is patched in once we've seen all threads.
+        size_t record_offset = builder.size();
+        append_record(builder, &record, sizeof(record));
+        ++file_header.process_count;
+
+        process.for_each_thread([&](const Thread& thread) {
+            ThreadStatsRecord thread_record;
+            thread_record.tid = thread.tid().value();
+            thread_record.times_scheduled = thread.times_scheduled();
+            thread_record.ticks = thread.ticks();
+            thread_record.syscall_count = thread.syscall_count();
+            thread_record.inode_faults = thread.inode_faults();
+            thread_record.zero_faults = thread.zero_faults();
+            thread_record.cow_faults = thread.cow_faults();
+            thread_record.unix_socket_read_bytes = thread.unix_socket_read_bytes();
+            thread_record.unix_socket_write_bytes = thread.unix_socket_write_bytes();
+            thread_record.ipv4_socket_read_bytes = thread.ipv4_socket_read_bytes();
+            thread_record.ipv4_socket_write_bytes = thread.ipv4_socket_write_bytes();
+            thread_record.file_read_bytes = thread.file_read_bytes();
+            thread_record.file_write_bytes = thread.file_write_bytes();
+            thread_record.cpu = thread.cpu();
+            thread_record.priority = thread.priority();
+            thread_record.effective_priority = thread.effective_priority();
+            copy_to_record_field(thread_record.state, thread.state_string());
+            copy_to_record_field(thread_record.name, thread.name());
+            thread_record.fpu_saves = thread.fpu_saves();
+            thread_record.fpu_restores = thread.fpu_restores();
+            thread_record.block_io_requests = thread.block_io_requests();
+            append_record(builder, &thread_record, sizeof(thread_record));
+            ++record.thread_count;
+            return IterationDecision::Continue;
+        });
+        builder.overwrite(record_offset, &record, sizeof(record));
+    };
+
+    ScopedSpinLock lock(g_scheduler_lock);
+    auto processes = Process::all_processes();
+    build_process(*Scheduler::colonel());
+    for (auto& process : processes)
+        build_process(process);
+
+    builder.overwrite(0, &file_header, sizeof(file_header));
+    return builder.build();
+}
+
 static Optional<KBuffer> procfs$inodes(InodeIdentifier)
 {
     KBufferBuilder builder;
@@ -1221,7 +1484,8 @@ ssize_t ProcFSInode::read_bytes(off_t offset, ssize_t count, u8* buffer, FileDes
     if (!description) {
         generated_data = (*read_callback)(identifier());
     } else {
-        if (!description->generator_cache().has_value())
+        // Reading from the start again refreshes the contents, so monitors can keep the file open.
+        if (!description->generator_cache().has_value() || offset == 0)
             description->generator_cache() = (*read_callback)(identifier());
         generated_data = description->generator_cache();
     }
@@ -1525,11 +1789,11 @@ KResultOr<NonnullRefPtr<Custody>> ProcFSInode::resolve_as_link(Custody& base, Re
         return Custody::create(&base, "", proxy_inode, base.mount_flags());
     }
 
-    Custody* res = nullptr;
+    RefPtr<Custody> res;
 
     switch (proc_file_type) {
     case FI_PID_cwd:
-        res = &process->current_directory();
+        res = process->current_directory();
         break;
     case FI_PID_exe:
         res = process->executable();
@@ -1538,7 +1802,7 @@ KResultOr<NonnullRefPtr<Custody>> ProcFSInode::resolve_as_link(Custody& base, Re
         // Note: we open root_directory() here, not
         // root_directory_relative_to_global_root().
         // This seems more useful.
-        res = &process->root_directory();
+        res = process->root_directory();
         break;
     default:
         ASSERT_NOT_REACHED();
@@ -1660,6 +1924,8 @@ ProcFS::ProcFS()
     m_entries[FI_Root_df] = { "df", FI_Root_df, false, procfs$df };
     m_entries[FI_Root_all] = { "all", FI_Root_all, false, procfs$all };
     m_entries[FI_Root_memstat] = { "memstat", FI_Root_memstat, false, procfs$memstat };
+    m_entries[FI_Root_all_binary] = { "all.bin", FI_Root_all_binary, false, procfs$all_binary };
+    m_entries[FI_Root_memstat_binary] = { "memstat.bin", FI_Root_memstat_binary, false, procfs$memstat_binary };
     m_entries[FI_Root_cpuinfo] = { "cpuinfo", FI_Root_cpuinfo, false, procfs$cpuinfo };
     m_entries[FI_Root_inodes] = { "inodes", FI_Root_inodes, true, procfs$inodes };
     m_entries[FI_Root_dmesg] = { "dmesg", FI_Root_dmesg, true, procfs$dmesg };
@@ -1672,6 +1938,9 @@ ProcFS::ProcFS()
     m_entries[FI_Root_cmdline] = { "cmdline", FI_Root_cmdline, true, procfs$cmdline };
     m_entries[FI_Root_modules] = { "modules", FI_Root_modules, true, procfs$modules };
     m_entries[FI_Root_profile] = { "profile", FI_Root_profile, false, procfs$profile };
+#ifdef SPINLOCK_STATISTICS
+    m_entries[FI_Root_spinlocks] = { "spinlocks", FI_Root_spinlocks, true, procfs$spinlocks };
+#endif
     m_entries[FI_Root_sys] = { "sys", FI_Root_sys, true };
     m_entries[FI_Root_net] = { "net", FI_Root_net, false };
 
@@ -1688,6 +1957,7 @@ ProcFS::ProcFS()
     m_entries[FI_PID_exe] = { "exe", FI_PID_exe, false, procfs$pid_exe };
     m_entries[FI_PID_cwd] = { "cwd", FI_PID_cwd, false, procfs$pid_cwd };
     m_entries[FI_PID_unveil] = { "unveil", FI_PID_unveil, false, procfs$pid_unveil };
+    m_entries[FI_PID_io] = { "io", FI_PID_io, false, procfs$pid_io };
     m_entries[FI_PID_root] = { "root", FI_PID_root, false, procfs$pid_root };
     m_entries[FI_PID_fd] = { "fd", FI_PID_fd, false };
 }
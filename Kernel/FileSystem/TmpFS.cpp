@@ -27,6 +27,7 @@
 #include <Kernel/FileSystem/TmpFS.h>
 #include <Kernel/Process.h>
 #include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
 
@@ -148,17 +149,25 @@ ssize_t TmpFSInode::read_bytes(off_t offset, ssize_t size, u8* buffer, FileDescr
     ASSERT(size >= 0);
     ASSERT(offset >= 0);
 
-    if (!m_content.has_value())
-        return 0;
-
     if (offset >= m_metadata.size)
         return 0;
 
     if (static_cast<off_t>(size) > m_metadata.size - offset)
         size = m_metadata.size - offset;
 
-    memcpy(buffer, m_content.value().data() + offset, size);
-    return size;
+    ssize_t nread = 0;
+    while (nread < size) {
+        size_t page_index = (offset + nread) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nread) % PAGE_SIZE;
+        size_t chunk_size = min((size_t)(size - nread), PAGE_SIZE - offset_in_page);
+        auto& page = m_pages[page_index];
+        if (page)
+            MM.copy_from_physical_page(*page, offset_in_page, buffer + nread, chunk_size);
+        else
+            memset(buffer + nread, 0, chunk_size);
+        nread += chunk_size;
+    }
+    return nread;
 }
 
 ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const u8* buffer, FileDescription*)
@@ -177,32 +186,61 @@ ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const u8* buffer, Fi
         new_size = offset + size;
 
     if (new_size > old_size) {
-        if (m_content.has_value() && m_content.value().capacity() >= (size_t)new_size) {
-            m_content.value().set_size(new_size);
-        } else {
-            // Grow the content buffer 2x the new sizeto accomodate repeating write() calls.
-            // Note that we're not actually committing physical memory to the buffer
-            // until it's needed. We only grow VM here.
-
-            // FIXME: Fix this so that no memcpy() is necessary, and we can just grow the
-            //        KBuffer and it will add physical pages as needed while keeping the
-            //        existing ones.
-            auto tmp = KBuffer::create_with_size(new_size * 2);
-            tmp.set_size(new_size);
-            if (m_content.has_value())
-                memcpy(tmp.data(), m_content.value().data(), old_size);
-            m_content = move(tmp);
-        }
+        // Growing never moves the existing pages, the new ones get allocated as they're written to.
+        m_pages.resize(ceil_div((size_t)new_size, PAGE_SIZE));
         m_metadata.size = new_size;
         set_metadata_dirty(true);
         set_metadata_dirty(false);
         inode_size_changed(old_size, new_size);
     }
 
-    memcpy(m_content.value().data() + offset, buffer, size);
-    inode_contents_changed(offset, size, buffer);
+    ssize_t nwritten = 0;
+    while (nwritten < size) {
+        size_t page_index = (offset + nwritten) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nwritten) % PAGE_SIZE;
+        size_t chunk_size = min((size_t)(size - nwritten), PAGE_SIZE - offset_in_page);
+        auto& page = m_pages[page_index];
+        if (!page) {
+            page = MM.allocate_user_physical_page(chunk_size == PAGE_SIZE ? MemoryManager::ShouldZeroFill::No : MemoryManager::ShouldZeroFill::Yes);
+            if (!page)
+                break;
+        }
+        MM.copy_to_physical_page(*page, offset_in_page, buffer + nwritten, chunk_size);
+        nwritten += chunk_size;
+    }
+
+    if (nwritten < size && !nwritten)
+        return -ENOMEM;
+    inode_contents_changed(offset, nwritten, buffer);
+    return nwritten;
+}
+
+KResultOr<NonnullRefPtr<PhysicalPage>> TmpFSInode::cached_page(size_t page_index, FileDescription*)
+{
+    LOCKER(m_lock);
+    ASSERT(is_page_cacheable());
+    if (page_index >= m_pages.size()) {
+        // Past the end of the file, this only has to read back as zeroes.
+        auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+        if (!page)
+            return KResult(-ENOMEM);
+        return page.release_nonnull();
+    }
+    auto& page = m_pages[page_index];
+    if (!page) {
+        page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+        if (!page)
+            return KResult(-ENOMEM);
+    }
+    return NonnullRefPtr<PhysicalPage>(*page);
+}
 
-    return size;
+RefPtr<PhysicalPage> TmpFSInode::cached_page_if_present(size_t page_index)
+{
+    LOCKER(m_lock);
+    if (page_index >= m_pages.size())
+        return nullptr;
+    return m_pages[page_index];
 }
 
 RefPtr<Inode> TmpFSInode::lookup(StringView name)
@@ -321,31 +359,22 @@ KResult TmpFSInode::truncate(u64 size)
     LOCKER(m_lock);
     ASSERT(!is_directory());
 
-    if (size == 0)
-        m_content.clear();
-    else if (!m_content.has_value()) {
-        m_content = KBuffer::create_with_size(size);
-    } else if (static_cast<size_t>(size) < m_content.value().capacity()) {
-        size_t prev_size = m_metadata.size;
-        m_content.value().set_size(size);
-        if (prev_size < static_cast<size_t>(size))
-            memset(m_content.value().data() + prev_size, 0, size - prev_size);
-    } else {
-        size_t prev_size = m_metadata.size;
-        KBuffer tmp = KBuffer::create_with_size(size);
-        memcpy(tmp.data(), m_content.value().data(), prev_size);
-        m_content = move(tmp);
+    size_t old_size = m_metadata.size;
+    m_pages.resize(ceil_div((size_t)size, PAGE_SIZE));
+
+    // The cut-off tail of the last page must read back as zeroes if the file grows again.
+    size_t offset_in_page = size % PAGE_SIZE;
+    if (size < old_size && offset_in_page && m_pages.last()) {
+        InterruptDisabler disabler;
+        memset(MM.quickmap_page(*m_pages.last()) + offset_in_page, 0, PAGE_SIZE - offset_in_page);
+        MM.unquickmap_page();
     }
 
-    size_t old_size = m_metadata.size;
     m_metadata.size = size;
     notify_watchers();
 
-    if (old_size != (size_t)size) {
+    if (old_size != (size_t)size)
         inode_size_changed(old_size, size);
-        if (m_content.has_value())
-            inode_contents_changed(0, size, m_content.value().data());
-    }
 
     return KSuccess;
 }
@@ -30,7 +30,7 @@
 #include <AK/Optional.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
-#include <Kernel/KBuffer.h>
+#include <Kernel/VM/PhysicalPage.h>
 
 namespace Kernel {
 
@@ -47,6 +47,7 @@ public:
     virtual const char* class_name() const override { return "TmpFS"; }
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_lookup_cache() const override { return true; }
 
     virtual NonnullRefPtr<Inode> root_inode() const override;
 
@@ -91,6 +92,9 @@ public:
     virtual int set_ctime(time_t) override;
     virtual int set_mtime(time_t) override;
     virtual void one_ref_left() override;
+    virtual bool is_page_cacheable() const override { return m_metadata.is_regular_file(); }
+    virtual KResultOr<NonnullRefPtr<PhysicalPage>> cached_page(size_t page_index, FileDescription* = nullptr) override;
+    virtual RefPtr<PhysicalPage> cached_page_if_present(size_t page_index) override;
 
 private:
     TmpFSInode(TmpFS& fs, InodeMetadata metadata, InodeIdentifier parent);
@@ -102,7 +106,10 @@ private:
     InodeMetadata m_metadata;
     InodeIdentifier m_parent;
 
-    Optional<KBuffer> m_content;
+    // File contents, one physical page at a time. These are the very pages that mmap() maps.
+    // Pages that were never written to are null and read back as zeroes.
+    Vector<RefPtr<PhysicalPage>> m_pages;
+
     struct Child {
         String name;
         NonnullRefPtr<TmpFSInode> inode;
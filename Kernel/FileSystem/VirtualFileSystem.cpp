@@ -113,6 +113,8 @@ KResult VFS::unmount(Inode& guest_inode)
     for (size_t i = 0; i < m_mounts.size(); ++i) {
         auto& mount = m_mounts.at(i);
         if (&mount.guest() == &guest_inode) {
+            // Cached lookups would otherwise keep the file system's inodes busy.
+            m_directory_entry_cache.invalidate_fs(mount.guest_fs().fsid());
             auto result = mount.guest_fs().prepare_to_unmount();
             if (result.is_error()) {
                 dbg() << "VFS: Failed to unmount!";
@@ -812,6 +814,7 @@ Custody& VFS::root_custody()
 
 const UnveiledPath* VFS::find_matching_unveiled_path(StringView path)
 {
+    ASSERT(Process::current()->filesystem_lock().is_locked());
     for (auto& unveiled_path : Process::current()->unveiled_paths()) {
         if (path == unveiled_path.path)
             return &unveiled_path;
@@ -823,9 +826,12 @@ const UnveiledPath* VFS::find_matching_unveiled_path(StringView path)
 
 KResult VFS::validate_path_against_process_veil(StringView path, int options)
 {
-    if (Process::current()->veil_state() == VeilState::None)
+    auto* current_process = Process::current();
+    if (current_process->veil_state() == VeilState::None)
         return KSuccess;
 
+    LOCKER(current_process->filesystem_lock());
+
     // FIXME: Figure out a nicer way to do this.
     if (String(path).contains("/.."))
         return KResult(-EINVAL);
@@ -900,9 +906,9 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path_without_veil(StringView path
 
     auto parts = path.split_view('/', true);
     auto current_process = Process::current();
-    auto& current_root = current_process->root_directory();
+    auto current_root = current_process->root_directory();
 
-    NonnullRefPtr<Custody> custody = path[0] == '/' ? current_root : base;
+    NonnullRefPtr<Custody> custody = path[0] == '/' ? *current_root : base;
 
     for (size_t i = 0; i < parts.size(); ++i) {
         Custody& parent = custody;
@@ -926,7 +932,7 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path_without_veil(StringView path
         }
 
         // Okay, let's look up this part.
-        auto child_inode = parent.inode().lookup(part);
+        auto child_inode = m_directory_entry_cache.lookup(parent.inode(), part);
         if (!child_inode) {
             if (out_parent) {
                 // ENOENT with a non-null parent custody signals to caller that
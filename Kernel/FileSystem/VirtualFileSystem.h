@@ -33,6 +33,7 @@
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/String.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/InodeIdentifier.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
@@ -115,6 +116,7 @@ public:
     void sync();
 
     Custody& root_custody();
+    DirectoryEntryCache& directory_entry_cache() { return m_directory_entry_cache; }
     KResultOr<NonnullRefPtr<Custody>> resolve_path(StringView path, Custody& base, RefPtr<Custody>* out_parent = nullptr, int options = 0, int symlink_recursion_level = 0);
     KResultOr<NonnullRefPtr<Custody>> resolve_path_without_veil(StringView path, Custody& base, RefPtr<Custody>* out_parent = nullptr, int options = 0, int symlink_recursion_level = 0);
 
@@ -138,6 +140,7 @@ private:
     RefPtr<Inode> m_root_inode;
     Vector<Mount, 16> m_mounts;
     RefPtr<Custody> m_root_custody;
+    DirectoryEntryCache m_directory_entry_cache;
 };
 
 }
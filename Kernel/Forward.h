@@ -28,6 +28,7 @@
 
 namespace Kernel {
 
+class AnonymousVMObject;
 class BlockDevice;
 class CharacterDevice;
 class Custody;
@@ -35,7 +36,9 @@ class Device;
 class DiskCache;
 class DoubleBuffer;
 class File;
+class EventPoll;
 class FileDescription;
+class IORing;
 class IPv4Socket;
 class Inode;
 class InodeIdentifier;
@@ -35,6 +35,12 @@
 
 namespace Kernel {
 
+// Each processor keeps a small magazine of free slabs so that the common
+// alloc/dealloc path doesn't have to touch the shared freelist (the depot).
+// Magazines are refilled from and drained to the depot half a magazine at a time.
+static constexpr size_t slab_magazine_capacity = 32;
+static constexpr size_t max_slab_magazine_processors = 32;
+
 template<size_t templated_slab_size>
 class SlabAllocator {
 public:
@@ -51,22 +57,29 @@ public:
         }
         slabs[0].next = nullptr;
         m_freelist = &slabs[slab_count - 1];
-        m_num_allocated.store(0, AK::MemoryOrder::memory_order_release);
-        m_num_free.store(slab_count, AK::MemoryOrder::memory_order_release);
+        m_slab_count = slab_count;
+        m_num_free_in_depot = slab_count;
     }
 
     constexpr size_t slab_size() const { return templated_slab_size; }
 
     void* alloc()
     {
-        ScopedSpinLock lock(m_lock);
-        if (!m_freelist)
+        void* ptr = nullptr;
+        {
+            InterruptDisabler disabler;
+            if (auto* magazine = current_magazine()) {
+                if (!magazine->count)
+                    refill(*magazine);
+                if (magazine->count)
+                    ptr = magazine->slabs[--magazine->count];
+            } else {
+                ScopedSpinLock lock(m_lock);
+                ptr = take_from_depot();
+            }
+        }
+        if (!ptr)
             return kmalloc(slab_size());
-        ASSERT(m_freelist);
-        void* ptr = m_freelist;
-        m_freelist = m_freelist->next;
-        m_num_allocated.fetch_add(1, AK::MemoryOrder::memory_order_acq_rel);
-        m_num_free.fetch_sub(1, AK::MemoryOrder::memory_order_acq_rel);
 #ifdef SANITIZE_SLABS
         memset(ptr, SLAB_ALLOC_SCRUB_BYTE, slab_size());
 #endif
@@ -75,24 +88,36 @@ public:
 
     void dealloc(void* ptr)
     {
-        ScopedSpinLock lock(m_lock);
         ASSERT(ptr);
         if (ptr < m_base || ptr >= m_end) {
             kfree(ptr);
             return;
         }
-        ((FreeSlab*)ptr)->next = m_freelist;
 #ifdef SANITIZE_SLABS
         if (slab_size() > sizeof(FreeSlab*))
             memset(((FreeSlab*)ptr)->padding, SLAB_DEALLOC_SCRUB_BYTE, sizeof(FreeSlab::padding));
 #endif
-        m_freelist = (FreeSlab*)ptr;
-        m_num_allocated.fetch_sub(1, AK::MemoryOrder::memory_order_acq_rel);
-        m_num_free.fetch_add(1, AK::MemoryOrder::memory_order_acq_rel);
+        InterruptDisabler disabler;
+        auto* magazine = current_magazine();
+        if (!magazine) {
+            ScopedSpinLock lock(m_lock);
+            return_to_depot((FreeSlab*)ptr);
+            return;
+        }
+        if (magazine->count == slab_magazine_capacity)
+            drain(*magazine);
+        magazine->slabs[magazine->count++] = ptr;
     }
 
-    size_t num_allocated() const { return m_num_allocated.load(AK::MemoryOrder::memory_order_consume); }
-    size_t num_free() const { return m_num_free.load(AK::MemoryOrder::memory_order_consume); }
+    size_t num_free() const
+    {
+        // This is only a snapshot, the magazines keep changing under our feet.
+        size_t free = m_num_free_in_depot;
+        for (auto& magazine : m_magazines)
+            free += magazine.count;
+        return free;
+    }
+    size_t num_allocated() const { return m_slab_count - num_free(); }
 
 private:
     struct FreeSlab {
@@ -100,12 +125,67 @@ private:
         char padding[templated_slab_size - sizeof(FreeSlab*)];
     };
 
+    struct Magazine {
+        size_t count { 0 };
+        void* slabs[slab_magazine_capacity];
+    };
+
+    Magazine* current_magazine()
+    {
+        // Interrupts must be disabled so we stay on this processor while using its magazine.
+        ASSERT(!(cpu_flags() & 0x200));
+        if (!Processor::is_initialized())
+            return nullptr;
+        u32 id = Processor::current().id();
+        if (id >= max_slab_magazine_processors)
+            return nullptr;
+        return &m_magazines[id];
+    }
+
+    void* take_from_depot()
+    {
+        ASSERT(m_lock.is_locked());
+        if (!m_freelist)
+            return nullptr;
+        void* ptr = m_freelist;
+        m_freelist = m_freelist->next;
+        --m_num_free_in_depot;
+        return ptr;
+    }
+
+    void return_to_depot(FreeSlab* slab)
+    {
+        ASSERT(m_lock.is_locked());
+        slab->next = m_freelist;
+        m_freelist = slab;
+        ++m_num_free_in_depot;
+    }
+
+    void refill(Magazine& magazine)
+    {
+        ScopedSpinLock lock(m_lock);
+        while (magazine.count < slab_magazine_capacity / 2) {
+            auto* ptr = take_from_depot();
+            if (!ptr)
+                break;
+            magazine.slabs[magazine.count++] = ptr;
+        }
+    }
+
+    void drain(Magazine& magazine)
+    {
+        ScopedSpinLock lock(m_lock);
+        while (magazine.count > slab_magazine_capacity / 2)
+            return_to_depot((FreeSlab*)magazine.slabs[--magazine.count]);
+    }
+
     FreeSlab* m_freelist { nullptr };
-    Atomic<size_t> m_num_allocated;
-    Atomic<size_t> m_num_free;
+    size_t m_num_free_in_depot { 0 };
+    size_t m_slab_count { 0 };
     void* m_base { nullptr };
     void* m_end { nullptr };
     SpinLock<u32> m_lock;
+    Magazine m_magazines[max_slab_magazine_processors];
 
     static_assert(sizeof(FreeSlab) == templated_slab_size);
 };
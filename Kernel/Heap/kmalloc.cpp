@@ -32,6 +32,7 @@
 #include <AK/Assertions.h>
 #include <AK/Bitmap.h>
 #include <AK/Optional.h>
+#include <AK/StringView.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Heap/kmalloc.h>
@@ -40,6 +41,7 @@
 #include <Kernel/Scheduler.h>
 #include <Kernel/SpinLock.h>
 #include <Kernel/StdLib.h>
+#include <Kernel/VM/MemoryManager.h>
 
 #define SANITIZE_KMALLOC
 
@@ -55,8 +57,48 @@ struct AllocationHeader {
 #define ETERNAL_BASE_PHYSICAL (0xc0000000 + (2 * MiB))
 #define ETERNAL_RANGE_SIZE (2 * MiB)
 
+// Once the initial pool is in use, the heap grows by mapping more memory from the
+// MemoryManager. We try to do that before we actually run dry, since the MM needs
+// some kmalloc() space of its own to set up the new region.
+#define SUBHEAP_EXPANSION_SIZE (1 * MiB)
+#define MAX_SUBHEAPS 32
+#define KMALLOC_LOW_WATER_MARK (256 * KiB)
+
+// Runs of free chunks are kept on per-subheap lists, binned by the log2 of their
+// length, so allocation doesn't have to scan the bitmap. The first chunk of a free
+// run holds a FreeRun, and the first word of its last chunk holds the run length
+// so that kfree() can find the start of a free run that precedes it.
+struct FreeRun {
+    size_t chunk_count;
+    FreeRun* prev;
+    FreeRun* next;
+};
+
+static_assert(sizeof(FreeRun) <= CHUNK_SIZE);
+
+#define FREE_RUN_BIN_COUNT 32
+
+struct Subheap {
+    u8* base { nullptr };
+    size_t chunk_count { 0 };
+    u8* alloc_map { nullptr };
+    size_t free_chunks { 0 };
+    u32 nonempty_bins { 0 };
+    FreeRun* bins[FREE_RUN_BIN_COUNT] {};
+
+    bool contains(const void* ptr) const { return ptr >= base && ptr < base + chunk_count * CHUNK_SIZE; }
+    Bitmap bitmap() { return Bitmap::wrap(alloc_map, chunk_count); }
+    FreeRun* run_at(size_t chunk) { return (FreeRun*)(base + chunk * CHUNK_SIZE); }
+    size_t chunk_index(const void* ptr) const { return ((const u8*)ptr - base) / CHUNK_SIZE; }
+};
+
 static u8 alloc_map[POOL_SIZE / CHUNK_SIZE / 8];
 
+static Subheap s_subheaps[MAX_SUBHEAPS];
+static size_t s_subheap_count;
+static bool s_heap_expansion_in_progress;
+static u32 s_heap_expansion_processor;
+
 size_t g_kmalloc_bytes_allocated = 0;
 size_t g_kmalloc_bytes_free = POOL_SIZE;
 size_t g_kmalloc_bytes_eternal = 0;
@@ -69,6 +111,56 @@ static u8* s_end_of_eternal_range;
 
 static RecursiveSpinLock s_lock; // needs to be recursive because of dump_backtrace()
 
+static inline size_t bin_for_chunk_count(size_t chunk_count)
+{
+    ASSERT(chunk_count);
+    return min<size_t>(31 - __builtin_clz(chunk_count), FREE_RUN_BIN_COUNT - 1);
+}
+
+static void insert_free_run(Subheap& subheap, size_t first_chunk, size_t chunk_count)
+{
+    auto* run = subheap.run_at(first_chunk);
+    run->chunk_count = chunk_count;
+    // For single chunk runs this is the same word as run->chunk_count.
+    subheap.run_at(first_chunk + chunk_count - 1)->chunk_count = chunk_count;
+
+    auto bin = bin_for_chunk_count(chunk_count);
+    run->prev = nullptr;
+    run->next = subheap.bins[bin];
+    if (run->next)
+        run->next->prev = run;
+    subheap.bins[bin] = run;
+    subheap.nonempty_bins |= 1u << bin;
+}
+
+static void remove_free_run(Subheap& subheap, FreeRun* run)
+{
+    auto bin = bin_for_chunk_count(run->chunk_count);
+    if (run->prev)
+        run->prev->next = run->next;
+    else
+        subheap.bins[bin] = run->next;
+    if (run->next)
+        run->next->prev = run->prev;
+    if (!subheap.bins[bin])
+        subheap.nonempty_bins &= ~(1u << bin);
+}
+
+static void add_subheap(u8* base, size_t chunk_count, u8* subheap_alloc_map)
+{
+    ASSERT(s_subheap_count < MAX_SUBHEAPS);
+    auto& subheap = s_subheaps[s_subheap_count++];
+    subheap.base = base;
+    subheap.chunk_count = chunk_count;
+    subheap.alloc_map = subheap_alloc_map;
+    subheap.free_chunks = chunk_count;
+    subheap.nonempty_bins = 0;
+    for (auto& bin : subheap.bins)
+        bin = nullptr;
+    subheap.bitmap().fill(false);
+    insert_free_run(subheap, 0, chunk_count);
+}
+
 void kmalloc_init()
 {
     memset(&alloc_map, 0, sizeof(alloc_map));
@@ -79,6 +171,10 @@ void kmalloc_init()
     g_kmalloc_bytes_allocated = 0;
     g_kmalloc_bytes_free = POOL_SIZE;
 
+    s_subheap_count = 0;
+    s_heap_expansion_in_progress = false;
+    add_subheap((u8*)BASE_PHYSICAL, POOL_SIZE / CHUNK_SIZE, alloc_map);
+
     s_next_eternal_ptr = (u8*)ETERNAL_BASE_PHYSICAL;
     s_end_of_eternal_range = s_next_eternal_ptr + ETERNAL_RANGE_SIZE;
 }
@@ -115,14 +211,34 @@ void* kmalloc_page_aligned(size_t size)
     return ptr;
 }
 
-inline void* kmalloc_allocate(size_t first_chunk, size_t chunks_needed)
+static FreeRun* find_free_run(Subheap& subheap, size_t chunks_needed)
 {
-    auto* a = (AllocationHeader*)(BASE_PHYSICAL + (first_chunk * CHUNK_SIZE));
+    // Every run in a higher bin is big enough, so only the bin we'd be in has to be searched.
+    auto bin = bin_for_chunk_count(chunks_needed);
+    for (auto* run = subheap.bins[bin]; run; run = run->next) {
+        if (run->chunk_count >= chunks_needed)
+            return run;
+    }
+    u32 larger_bins = bin + 1 < FREE_RUN_BIN_COUNT ? subheap.nonempty_bins & ~((2u << bin) - 1) : 0;
+    if (!larger_bins)
+        return nullptr;
+    return subheap.bins[__builtin_ctz(larger_bins)];
+}
+
+static void* kmalloc_allocate(Subheap& subheap, FreeRun* run, size_t chunks_needed)
+{
+    size_t first_chunk = subheap.chunk_index(run);
+    size_t run_length = run->chunk_count;
+    remove_free_run(subheap, run);
+    if (run_length > chunks_needed)
+        insert_free_run(subheap, first_chunk + chunks_needed, run_length - chunks_needed);
+
+    auto* a = (AllocationHeader*)run;
     u8* ptr = a->data;
     a->allocation_size_in_chunks = chunks_needed;
 
-    Bitmap bitmap_wrapper = Bitmap::wrap(alloc_map, POOL_SIZE / CHUNK_SIZE);
-    bitmap_wrapper.set_range(first_chunk, chunks_needed, true);
+    subheap.bitmap().set_range(first_chunk, chunks_needed, true);
+    subheap.free_chunks -= chunks_needed;
 
     g_kmalloc_bytes_allocated += a->allocation_size_in_chunks * CHUNK_SIZE;
     g_kmalloc_bytes_free -= a->allocation_size_in_chunks * CHUNK_SIZE;
@@ -132,45 +248,113 @@ inline void* kmalloc_allocate(size_t first_chunk, size_t chunks_needed)
     return ptr;
 }
 
-void* kmalloc_impl(size_t size)
+static void* try_allocate_chunks(size_t chunks_needed)
 {
-    ScopedSpinLock lock(s_lock);
-    ++g_kmalloc_call_count;
-
-    if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
-        dbg() << "kmalloc(" << size << ")";
-        Kernel::dump_backtrace();
+    ASSERT(s_lock.own_lock());
+    for (size_t i = 0; i < s_subheap_count; ++i) {
+        auto& subheap = s_subheaps[i];
+        if (subheap.free_chunks < chunks_needed)
+            continue;
+        if (auto* run = find_free_run(subheap, chunks_needed))
+            return kmalloc_allocate(subheap, run, chunks_needed);
     }
+    return nullptr;
+}
 
-    // We need space for the AllocationHeader at the head of the block.
-    size_t real_size = size + sizeof(AllocationHeader);
+enum class HeapExpansionResult {
+    Expanded,
+    Busy,
+    Failed,
+};
 
-    if (g_kmalloc_bytes_free < real_size) {
-        Kernel::dump_backtrace();
-        klog() << "kmalloc(): PANIC! Out of memory\nsum_free=" << g_kmalloc_bytes_free << ", real_size=" << real_size;
-        Processor::halt();
+// This must be called without s_lock held: the MemoryManager takes its own locks,
+// and other processors may be holding those while waiting for us in kmalloc().
+static HeapExpansionResult expand_heap(size_t minimum_chunk_count)
+{
+    if (!Kernel::MemoryManager::is_initialized())
+        return HeapExpansionResult::Failed;
+
+    {
+        ScopedSpinLock lock(s_lock);
+        if (s_heap_expansion_in_progress)
+            return s_heap_expansion_processor == Processor::current().id() ? HeapExpansionResult::Failed : HeapExpansionResult::Busy;
+        if (s_subheap_count == MAX_SUBHEAPS)
+            return HeapExpansionResult::Failed;
+        s_heap_expansion_in_progress = true;
+        s_heap_expansion_processor = Processor::current().id();
     }
 
-    size_t chunks_needed = (real_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    size_t chunk_count = max<size_t>(SUBHEAP_EXPANSION_SIZE / CHUNK_SIZE, minimum_chunk_count);
+    size_t bitmap_size = round_up_to_power_of_two(ceil_div(chunk_count, (size_t)8), CHUNK_SIZE);
+    size_t region_size = PAGE_ROUND_UP(bitmap_size + chunk_count * CHUNK_SIZE);
+    auto region = MM.allocate_kernel_region(region_size, "kmalloc subheap", Kernel::Region::Access::Read | Kernel::Region::Access::Write);
 
-    Bitmap bitmap_wrapper = Bitmap::wrap(alloc_map, POOL_SIZE / CHUNK_SIZE);
-    Optional<size_t> first_chunk;
+    ScopedSpinLock lock(s_lock);
+    s_heap_expansion_in_progress = false;
+    if (!region)
+        return HeapExpansionResult::Failed;
+
+    // Subheaps live forever, so the region is leaked on purpose.
+    u8* base = region.leak_ptr()->vaddr().as_ptr();
+    chunk_count = min((region_size - bitmap_size) / CHUNK_SIZE, bitmap_size * 8);
+    add_subheap(base + bitmap_size, chunk_count, base);
+    g_kmalloc_bytes_free += chunk_count * CHUNK_SIZE;
+#ifdef KMALLOC_DEBUG_LARGE_ALLOCATIONS
+    dbg() << "kmalloc(): Expanded heap by " << chunk_count * CHUNK_SIZE << " bytes, " << s_subheap_count << " subheaps";
+#endif
+    return HeapExpansionResult::Expanded;
+}
 
-    // Choose the right politic for allocation.
-    constexpr u32 best_fit_threshold = 128;
-    if (chunks_needed < best_fit_threshold) {
-        first_chunk = bitmap_wrapper.find_first_fit(chunks_needed);
-    } else {
-        first_chunk = bitmap_wrapper.find_best_fit(chunks_needed);
+void* kmalloc_impl(size_t size)
+{
+    {
+        ScopedSpinLock lock(s_lock);
+        ++g_kmalloc_call_count;
+
+        if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
+            dbg() << "kmalloc(" << size << ")";
+            Kernel::dump_backtrace();
+        }
     }
 
-    if (!first_chunk.has_value()) {
-        klog() << "kmalloc(): PANIC! Out of memory (no suitable block for size " << size << ")";
-        Kernel::dump_backtrace();
-        Processor::halt();
+    // We need space for the AllocationHeader at the head of the block.
+    size_t real_size = size + sizeof(AllocationHeader);
+    size_t chunks_needed = (real_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    for (;;) {
+        {
+            ScopedSpinLock lock(s_lock);
+            if (auto* ptr = try_allocate_chunks(chunks_needed)) {
+                // Don't grow the heap from inside the MemoryManager or an IRQ handler
+                // unless we have to, since we may be interrupting it halfway through.
+                bool running_low = g_kmalloc_bytes_free < KMALLOC_LOW_WATER_MARK && !s_heap_expansion_in_progress
+                    && !Kernel::s_mm_lock.own_lock() && !Processor::current().in_irq();
+                lock.unlock();
+                if (running_low)
+                    (void)expand_heap(0);
+                return ptr;
+            }
+        }
+
+        auto result = expand_heap(chunks_needed);
+        if (result == HeapExpansionResult::Busy)
+            continue;
+        if (result == HeapExpansionResult::Failed) {
+            klog() << "kmalloc(): PANIC! Out of memory (no suitable block for size " << size << ")\nsum_free=" << g_kmalloc_bytes_free << ", real_size=" << real_size;
+            Kernel::dump_backtrace();
+            Processor::halt();
+        }
     }
+}
 
-    return kmalloc_allocate(first_chunk.value(), chunks_needed);
+static Subheap& subheap_containing(const void* ptr)
+{
+    for (size_t i = 0; i < s_subheap_count; ++i) {
+        if (s_subheaps[i].contains(ptr))
+            return s_subheaps[i];
+    }
+    klog() << "kfree(): Pointer " << ptr << " is not in the kmalloc heap";
+    ASSERT_NOT_REACHED();
 }
 
 static inline void kfree_impl(void* ptr)
@@ -178,17 +362,35 @@ static inline void kfree_impl(void* ptr)
     ++g_kfree_call_count;
 
     auto* a = (AllocationHeader*)((((u8*)ptr) - sizeof(AllocationHeader)));
-    FlatPtr start = ((FlatPtr)a - (FlatPtr)BASE_PHYSICAL) / CHUNK_SIZE;
+    auto& subheap = subheap_containing(a);
+    size_t start = subheap.chunk_index(a);
+    size_t chunk_count = a->allocation_size_in_chunks;
 
-    Bitmap bitmap_wrapper = Bitmap::wrap(alloc_map, POOL_SIZE / CHUNK_SIZE);
-    bitmap_wrapper.set_range(start, a->allocation_size_in_chunks, false);
+    auto bitmap = subheap.bitmap();
+    bitmap.set_range(start, chunk_count, false);
+    subheap.free_chunks += chunk_count;
 
-    g_kmalloc_bytes_allocated -= a->allocation_size_in_chunks * CHUNK_SIZE;
-    g_kmalloc_bytes_free += a->allocation_size_in_chunks * CHUNK_SIZE;
+    g_kmalloc_bytes_allocated -= chunk_count * CHUNK_SIZE;
+    g_kmalloc_bytes_free += chunk_count * CHUNK_SIZE;
 
 #ifdef SANITIZE_KMALLOC
-    memset(a, KFREE_SCRUB_BYTE, a->allocation_size_in_chunks * CHUNK_SIZE);
+    memset(a, KFREE_SCRUB_BYTE, chunk_count * CHUNK_SIZE);
 #endif
+
+    // Merge with the free runs on either side, if any.
+    if (start > 0 && !bitmap.get(start - 1)) {
+        size_t previous_length = subheap.run_at(start - 1)->chunk_count;
+        size_t previous_start = start - previous_length;
+        remove_free_run(subheap, subheap.run_at(previous_start));
+        start = previous_start;
+        chunk_count += previous_length;
+    }
+    if (start + chunk_count < subheap.chunk_count && !bitmap.get(start + chunk_count)) {
+        auto* next_run = subheap.run_at(start + chunk_count);
+        chunk_count += next_run->chunk_count;
+        remove_free_run(subheap, next_run);
+    }
+    insert_free_run(subheap, start, chunk_count);
 }
 
 void kfree(void* ptr)
@@ -205,20 +407,43 @@ void* krealloc(void* ptr, size_t new_size)
     if (!ptr)
         return kmalloc(new_size);
 
-    ScopedSpinLock lock(s_lock);
-
-    auto* a = (AllocationHeader*)((((u8*)ptr) - sizeof(AllocationHeader)));
-    size_t old_size = a->allocation_size_in_chunks * CHUNK_SIZE;
+    size_t old_size;
+    {
+        ScopedSpinLock lock(s_lock);
+        auto* a = (AllocationHeader*)((((u8*)ptr) - sizeof(AllocationHeader)));
+        old_size = a->allocation_size_in_chunks * CHUNK_SIZE;
+    }
 
     if (old_size == new_size)
         return ptr;
 
+    // kmalloc() may have to grow the heap, which it can't do while we hold s_lock.
     auto* new_ptr = kmalloc(new_size);
     memcpy(new_ptr, ptr, min(old_size, new_size));
-    kfree_impl(ptr);
+    kfree(ptr);
     return new_ptr;
 }
 
+void get_kmalloc_stats(kmalloc_stats& stats)
+{
+    ScopedSpinLock lock(s_lock);
+    stats.bytes_allocated = g_kmalloc_bytes_allocated;
+    stats.bytes_free = g_kmalloc_bytes_free;
+    stats.bytes_eternal = g_kmalloc_bytes_eternal;
+    stats.subheap_count = s_subheap_count;
+    stats.free_run_count = 0;
+    stats.largest_free_run = 0;
+    for (size_t i = 0; i < s_subheap_count; ++i) {
+        auto& subheap = s_subheaps[i];
+        for (auto* bin : subheap.bins) {
+            for (auto* run = bin; run; run = run->next) {
+                ++stats.free_run_count;
+                stats.largest_free_run = max(stats.largest_free_run, run->chunk_count * CHUNK_SIZE);
+            }
+        }
+    }
+}
+
 void* operator new(size_t size)
 {
     return kmalloc(size);
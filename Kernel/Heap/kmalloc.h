@@ -42,6 +42,16 @@ void* krealloc(void*, size_t);
 void kfree(void*);
 void kfree_aligned(void*);
 
+struct kmalloc_stats {
+    size_t bytes_allocated;
+    size_t bytes_free;
+    size_t bytes_eternal;
+    size_t subheap_count;
+    size_t free_run_count;
+    size_t largest_free_run;
+};
+void get_kmalloc_stats(kmalloc_stats&);
+
 extern size_t g_kmalloc_bytes_allocated;
 extern size_t g_kmalloc_bytes_free;
 extern size_t g_kmalloc_bytes_eternal;
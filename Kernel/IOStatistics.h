@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Noncopyable.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+// Counts events by how long they took, in power-of-two ranges of microseconds.
+// Bucket 0 holds everything below 1us, bucket n holds [2^(n-1), 2^n) us, and the last bucket everything beyond.
+class LatencyHistogram {
+public:
+    static constexpr size_t bucket_count = 24;
+
+    // The exclusive upper bound of a bucket in microseconds. The last bucket has none.
+    static constexpr u64 bucket_upper_bound_us(size_t bucket) { return (u64)1 << bucket; }
+
+    void record(u64 nanoseconds)
+    {
+        u64 microseconds = nanoseconds / 1000;
+        size_t bucket = bucket_count - 1;
+        if (microseconds < bucket_upper_bound_us(bucket_count - 2))
+            bucket = microseconds ? 32 - __builtin_clz((u32)microseconds) : 0;
+        ++m_buckets[bucket];
+    }
+
+    u32 at(size_t bucket) const { return m_buckets[bucket]; }
+
+    void add(const LatencyHistogram& other)
+    {
+        for (size_t i = 0; i < bucket_count; ++i)
+            m_buckets[i] += other.m_buckets[i];
+    }
+
+private:
+    u32 m_buckets[bucket_count] {};
+};
+
+// Records how long the enclosing scope took into a histogram.
+class ScopedLatencyRecorder {
+    AK_MAKE_NONCOPYABLE(ScopedLatencyRecorder);
+    AK_MAKE_NONMOVABLE(ScopedLatencyRecorder);
+
+public:
+    explicit ScopedLatencyRecorder(LatencyHistogram& histogram)
+        : m_histogram(histogram)
+        , m_start(TimeManagement::the().monotonic_nanoseconds())
+    {
+    }
+
+    ~ScopedLatencyRecorder()
+    {
+        m_histogram.record(TimeManagement::the().monotonic_nanoseconds() - m_start);
+    }
+
+private:
+    LatencyHistogram& m_histogram;
+    u64 m_start { 0 };
+};
+
+// The I/O a thread has done. A process keeps one of these for the threads that have already exited,
+// so that its totals don't drop whenever a thread goes away.
+struct IOStatistics {
+    u64 syscall_count { 0 };
+    u64 file_read_bytes { 0 };
+    u64 file_write_bytes { 0 };
+    u64 unix_socket_read_bytes { 0 };
+    u64 unix_socket_write_bytes { 0 };
+    u64 ipv4_socket_read_bytes { 0 };
+    u64 ipv4_socket_write_bytes { 0 };
+    u64 block_io_requests { 0 };
+    LatencyHistogram read_latency;
+    LatencyHistogram write_latency;
+    LatencyHistogram page_fault_latency;
+
+    void add(const IOStatistics& other)
+    {
+        syscall_count += other.syscall_count;
+        file_read_bytes += other.file_read_bytes;
+        file_write_bytes += other.file_write_bytes;
+        unix_socket_read_bytes += other.unix_socket_read_bytes;
+        unix_socket_write_bytes += other.unix_socket_write_bytes;
+        ipv4_socket_read_bytes += other.ipv4_socket_read_bytes;
+        ipv4_socket_write_bytes += other.ipv4_socket_write_bytes;
+        block_io_requests += other.block_io_requests;
+        read_latency.add(other.read_latency);
+        write_latency.add(other.write_latency);
+        page_fault_latency.add(other.page_fault_latency);
+    }
+};
+
+}
@@ -34,6 +34,7 @@
 #include <Kernel/IO.h>
 #include <Kernel/Interrupts/APIC.h>
 #include <Kernel/Interrupts/SpuriousInterruptHandler.h>
+#include <Kernel/PerformanceCounters.h>
 #include <Kernel/Thread.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
@@ -42,6 +43,7 @@
 //#define APIC_DEBUG
 //#define APIC_SMP_DEBUG
 
+#define IRQ_APIC_PMI (0xfc - IRQ_VECTOR_BASE)
 #define IRQ_APIC_IPI (0xfd - IRQ_VECTOR_BASE)
 #define IRQ_APIC_ERR (0xfe - IRQ_VECTOR_BASE)
 #define IRQ_APIC_SPURIOUS (0xff - IRQ_VECTOR_BASE)
@@ -130,6 +132,36 @@ public:
 private:
 };
 
+class APICPMIInterruptHandler final : public GenericInterruptHandler {
+public:
+    explicit APICPMIInterruptHandler(u8 interrupt_vector)
+        : GenericInterruptHandler(interrupt_vector, true)
+    {
+    }
+    virtual ~APICPMIInterruptHandler()
+    {
+    }
+
+    static void initialize(u8 interrupt_number)
+    {
+        new APICPMIInterruptHandler(interrupt_number);
+    }
+
+    virtual void handle_interrupt(const RegisterState&) override;
+
+    virtual bool eoi() override;
+
+    virtual HandlerType type() const override { return HandlerType::IRQHandler; }
+    virtual const char* purpose() const override { return "Performance Counter Handler"; }
+    virtual const char* controller() const override { ASSERT_NOT_REACHED(); }
+
+    virtual size_t sharing_devices_count() const override { return 0; }
+    virtual bool is_shared_handler() const override { return false; }
+    virtual bool is_sharing_with_others() const override { return false; }
+
+private:
+};
+
 bool APIC::initialized()
 {
     return (s_apic != nullptr);
@@ -198,7 +230,7 @@ void APIC::write_icr(const ICRReg& icr)
 
 #define APIC_LVT_MASKED (1 << 16)
 #define APIC_LVT_TRIGGER_LEVEL (1 << 14)
-#define APIC_LVT(iv, dm) ((iv & 0xff) | ((dm & 0x7) << 8))
+#define APIC_LVT(iv, dm) (((iv) & 0xff) | (((dm) & 0x7) << 8))
 
 extern "C" void apic_ap_start(void);
 extern "C" u16 apic_ap_start_size;
@@ -437,6 +469,9 @@ void APIC::enable(u32 cpu)
 
         // register IPI interrupt vector
         APICIPIInterruptHandler::initialize(IRQ_APIC_IPI);
+
+        // register performance counter overflow vector, the LVT entry stays masked until sampling starts
+        APICPMIInterruptHandler::initialize(IRQ_APIC_PMI);
     }
 
     // set spurious interrupt vector
@@ -454,6 +489,16 @@ void APIC::enable(u32 cpu)
     write_register(APIC_REG_TPR, 0);
 }
 
+void APIC::enable_performance_counter_interrupt()
+{
+    write_register(APIC_REG_LVT_PERFORMANCE_COUNTER, APIC_LVT(IRQ_APIC_PMI + IRQ_VECTOR_BASE, 0));
+}
+
+void APIC::disable_performance_counter_interrupt()
+{
+    write_register(APIC_REG_LVT_PERFORMANCE_COUNTER, APIC_LVT(0, 0) | APIC_LVT_MASKED);
+}
+
 Thread* APIC::get_idle_thread(u32 cpu) const
 {
     ASSERT(cpu > 0);
@@ -541,4 +586,15 @@ bool APICErrInterruptHandler::eoi()
     return true;
 }
 
+void APICPMIInterruptHandler::handle_interrupt(const RegisterState& regs)
+{
+    PerformanceCounters::handle_overflow(regs);
+}
+
+bool APICPMIInterruptHandler::eoi()
+{
+    APIC::the().eoi();
+    return true;
+}
+
 }
@@ -40,6 +40,7 @@
 #include <AK/ByteBuffer.h>
 #include <AK/LogStream.h>
 #include <AK/Memory.h>
+#include <AK/Optional.h>
 #include <AK/StringView.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/Region.h>
@@ -55,6 +56,16 @@ public:
         return adopt(*new KBufferImpl(region.release_nonnull(), size));
     }
 
+    static RefPtr<KBufferImpl> try_create_committed(size_t size, u8 access, const char* name, bool physically_contiguous)
+    {
+        auto region = physically_contiguous
+            ? MM.allocate_contiguous_kernel_region(PAGE_ROUND_UP(size), name, access)
+            : MM.allocate_kernel_region(PAGE_ROUND_UP(size), name, access, false, true);
+        if (!region)
+            return nullptr;
+        return adopt(*new KBufferImpl(region.release_nonnull(), size));
+    }
+
     static NonnullRefPtr<KBufferImpl> copy(const void* data, size_t size, u8 access, const char* name)
     {
         auto buffer = create_with_size(size, access, name);
@@ -100,6 +111,16 @@ public:
         return KBuffer(KBufferImpl::copy(data, size, access, name));
     }
 
+    // Unlike create_with_size(), this backs the whole buffer with physical pages up front
+    // (contiguous ones if asked to, e.g. for DMA) and fails gracefully when memory is short.
+    static Optional<KBuffer> try_create_committed(size_t size, bool physically_contiguous = false, u8 access = Region::Access::Read | Region::Access::Write, const char* name = "KBuffer")
+    {
+        auto impl = KBufferImpl::try_create_committed(size, access, name, physically_contiguous);
+        if (!impl)
+            return {};
+        return KBuffer(impl.release_nonnull());
+    }
+
     u8* data() { return m_impl->data(); }
     const u8* data() const { return m_impl->data(); }
     size_t size() const { return m_impl->size(); }
@@ -69,6 +69,12 @@ void KBufferBuilder::append(const char* characters, int length)
     m_size += length;
 }
 
+void KBufferBuilder::overwrite(size_t offset, const void* data, size_t size)
+{
+    ASSERT(offset + size <= m_size);
+    memcpy(m_buffer.data() + offset, data, size);
+}
+
 void KBufferBuilder::append(char ch)
 {
     if (!can_append(1))
@@ -45,6 +45,11 @@ public:
     void appendf(const char*, ...);
     void appendvf(const char*, va_list);
 
+    size_t size() const { return m_size; }
+
+    // Replaces already appended bytes, e.g. to fill in a count once it's known.
+    void overwrite(size_t offset, const void*, size_t);
+
     KBuffer build();
 
 private:
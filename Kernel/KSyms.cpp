@@ -25,9 +25,11 @@
  */
 
 #include <AK/Demangle.h>
+#include <AK/QuickSort.h>
 #include <AK/TemporaryChange.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/KSyms.h>
+#include <Kernel/Module.h>
 #include <Kernel/Process.h>
 #include <Kernel/Scheduler.h>
 #include <LibELF/Loader.h>
@@ -52,19 +54,41 @@ static u8 parse_hex_digit(char nibble)
 u32 address_for_kernel_symbol(const StringView& name)
 {
     for (size_t i = 0; i < s_symbol_count; ++i) {
-        if (!strncmp(name.characters_without_null_termination(), s_symbols[i].name, name.length()))
+        if (name == s_symbols[i].name)
             return s_symbols[i].address;
     }
     return 0;
 }
 
+static const KernelSymbol* find_symbol_in_sorted_table(const KernelSymbol* symbols, size_t count, u32 address)
+{
+    if (!count || address < symbols[0].address)
+        return nullptr;
+    // Find the last symbol that starts at or below the address.
+    size_t low = 0;
+    size_t high = count;
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if (symbols[middle].address <= address)
+            low = middle;
+        else
+            high = middle;
+    }
+    return &symbols[low];
+}
+
 const KernelSymbol* symbolicate_kernel_address(u32 address)
 {
-    if (address < g_lowest_kernel_symbol_address || address > g_highest_kernel_symbol_address)
+    if (address >= g_lowest_kernel_symbol_address && address <= g_highest_kernel_symbol_address)
+        return find_symbol_in_sorted_table(s_symbols, s_symbol_count, address);
+
+    if (!g_modules)
         return nullptr;
-    for (unsigned i = 0; i < s_symbol_count; ++i) {
-        if (address < s_symbols[i + 1].address)
-            return &s_symbols[i];
+    for (auto& it : *g_modules) {
+        auto& module = *it.value;
+        if (module.symbols.is_empty() || address < module.lowest_address || address >= module.highest_address)
+            continue;
+        return find_symbol_in_sorted_table(module.symbols.data(), module.symbols.size(), address);
     }
     return nullptr;
 }
@@ -83,6 +107,10 @@ static void load_kernel_sybols_from_data(const KBuffer& buffer)
     s_symbols = static_cast<KernelSymbol*>(kmalloc_eternal(sizeof(KernelSymbol) * s_symbol_count));
     ++bufptr; // skip newline
 
+    // All names go into one allocation; they take up less room than the map they came from.
+    char* names = static_cast<char*>(kmalloc_eternal(buffer.size()));
+    bool is_sorted = true;
+
     klog() << "Loading kernel symbol table...";
 
     size_t current_symbol_index = 0;
@@ -97,12 +125,17 @@ static void load_kernel_sybols_from_data(const KBuffer& buffer)
                 break;
             }
         }
+        if (current_symbol_index >= s_symbol_count)
+            break;
         auto& ksym = s_symbols[current_symbol_index];
         ksym.address = address;
-        char* name = static_cast<char*>(kmalloc_eternal((bufptr - start_of_name) + 1));
-        memcpy(name, start_of_name, bufptr - start_of_name);
-        name[bufptr - start_of_name] = '\0';
-        ksym.name = name;
+        memcpy(names, start_of_name, bufptr - start_of_name);
+        names[bufptr - start_of_name] = '\0';
+        ksym.name = names;
+        names += (bufptr - start_of_name) + 1;
+
+        if (current_symbol_index && ksym.address < s_symbols[current_symbol_index - 1].address)
+            is_sorted = false;
 
         if (ksym.address < g_lowest_kernel_symbol_address)
             g_lowest_kernel_symbol_address = ksym.address;
@@ -112,6 +145,12 @@ static void load_kernel_sybols_from_data(const KBuffer& buffer)
         ++bufptr;
         ++current_symbol_index;
     }
+    s_symbol_count = current_symbol_index;
+
+    // The map comes out of `nm -n` and should already be in address order, but lookups depend on it.
+    if (!is_sorted)
+        quick_sort(s_symbols, s_symbols + s_symbol_count, [](auto& a, auto& b) { return a.address < b.address; });
+
     g_kernel_symbols_available = true;
 }
 
@@ -26,9 +26,11 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <Kernel/KBuffer.h>
+#include <Kernel/KSyms.h>
 
 namespace Kernel {
 
@@ -41,6 +43,14 @@ struct Module {
 
     ModuleInitPtr module_init { nullptr };
     ModuleFiniPtr module_fini { nullptr };
+
+    // Function symbols sorted by address, so backtraces through module code can be symbolicated.
+    Vector<KernelSymbol> symbols;
+    Vector<String> symbol_names;
+    FlatPtr lowest_address { 0 };
+    FlatPtr highest_address { 0 };
 };
 
+extern HashMap<String, OwnPtr<Module>>* g_modules;
+
 }
@@ -139,6 +139,9 @@ namespace Kernel {
 #define INTERRUPT_TXD_LOW (1 << 15)
 #define INTERRUPT_SRPD (1 << 16)
 
+static constexpr u32 interrupts_always_enabled = INTERRUPT_LSC | INTERRUPT_TXDW;
+static constexpr u32 interrupts_for_receive = INTERRUPT_RXT0 | INTERRUPT_RXO | INTERRUPT_RXDMT0;
+
 void E1000NetworkAdapter::detect()
 {
     static const PCI::ID qemu_bochs_vbox_id = { 0x8086, 0x100e };
@@ -183,13 +186,17 @@ E1000NetworkAdapter::E1000NetworkAdapter(PCI::Address address, u8 irq)
     u32 flags = in32(REG_CTRL);
     out32(REG_CTRL, flags | ECTRL_SLU);
 
-    out16(REG_INTERRUPT_RATE, 6000); // Interrupt rate of 1.536 milliseconds
+    // Interrupt moderation: at most one interrupt every 488 * 256ns (~8000 per second).
+    out32(REG_INTERRUPT_RATE, 488);
+    // Wait for ~32us of quiet after a frame, but never longer than ~128us after the first one.
+    out32(REG_RDTR, 32);
+    out32(REG_RADV, 128);
 
     initialize_rx_descriptors();
     initialize_tx_descriptors();
 
-    out32(REG_INTERRUPT_MASK_SET, 0x1f6dc);
-    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0);
+    out32(REG_INTERRUPT_MASK_CLEAR, 0xffffffff);
+    out32(REG_INTERRUPT_MASK_SET, interrupts_always_enabled | interrupts_for_receive);
     in32(REG_INTERRUPT_CAUSE_READ);
 
     enable_irq();
@@ -207,20 +214,36 @@ void E1000NetworkAdapter::handle_irq(const RegisterState&)
 
     m_entropy_source.add_random_event(status);
 
-    if (status & 4) {
+    if (status & INTERRUPT_LSC) {
         u32 flags = in32(REG_CTRL);
         out32(REG_CTRL, flags | ECTRL_SLU);
     }
-    if (status & 0x80) {
-        receive();
-    }
-    if (status & 0x10) {
-        // Threshold OK?
-    }
+
+    // Don't touch the RX ring here. Receive interrupts stay masked while the NetworkTask
+    // drains the ring, so a flood of frames can't keep the CPU in interrupt context.
+    if (status & interrupts_for_receive)
+        request_receive_poll();
 
     m_wait_queue.wake_all();
 
-    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0 | INTERRUPT_RXO);
+    out32(REG_INTERRUPT_MASK_SET, is_receive_poll_pending() ? interrupts_always_enabled : (interrupts_always_enabled | interrupts_for_receive));
+}
+
+size_t E1000NetworkAdapter::poll_receive(size_t budget)
+{
+    if (!is_receive_poll_pending())
+        return 0;
+
+    size_t received = receive(budget);
+    if (received == budget)
+        return received;
+
+    // The ring is empty, so go back to interrupt-driven operation. If a frame arrived since we
+    // last looked, its cause bit is still latched and the interrupt fires as soon as we unmask.
+    InterruptDisabler disabler;
+    set_receive_poll_pending(false);
+    out32(REG_INTERRUPT_MASK_SET, interrupts_always_enabled | interrupts_for_receive);
+    return received;
 }
 
 void E1000NetworkAdapter::detect_eeprom()
@@ -282,10 +305,10 @@ void E1000NetworkAdapter::initialize_rx_descriptors()
     auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
     for (size_t i = 0; i < number_of_rx_descriptors; ++i) {
         auto& descriptor = rx_descriptors[i];
-        auto region = MM.allocate_contiguous_kernel_region(8192, "E1000 RX buffer", Region::Access::Read | Region::Access::Write);
-        ASSERT(region);
-        m_rx_buffers_regions.append(region.release_nonnull());
-        descriptor.addr = m_rx_buffers_regions[i].physical_page(0)->paddr().get();
+        auto buffer = create_packet_buffer(rx_buffer_size);
+        ASSERT(buffer.has_value());
+        m_rx_buffers.append(buffer.release_value());
+        descriptor.addr = m_rx_buffers[i].physical_address().get();
         descriptor.status = 0;
     }
 
@@ -295,7 +318,7 @@ void E1000NetworkAdapter::initialize_rx_descriptors()
     out32(REG_RXDESCHEAD, 0);
     out32(REG_RXDESCTAIL, number_of_rx_descriptors - 1);
 
-    out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_8192);
+    out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_4096);
 }
 
 void E1000NetworkAdapter::initialize_tx_descriptors()
@@ -393,15 +416,40 @@ void E1000NetworkAdapter::send_raw(ReadonlyBytes payload)
 {
     disable_irq();
     size_t tx_current = in32(REG_TXDESCTAIL) % number_of_tx_descriptors;
+    ASSERT(payload.size() <= 8192);
+    auto& buffer_region = m_tx_buffers_regions[tx_current];
+    memcpy(buffer_region.vaddr().as_ptr(), payload.data(), payload.size());
+    transmit(tx_current, buffer_region.physical_page(0)->paddr(), payload.size());
+}
+
+void E1000NetworkAdapter::send_packet(PacketBuffer&& frame)
+{
+    if (!frame.is_physically_contiguous()) {
+        NetworkAdapter::send_packet(move(frame));
+        return;
+    }
+
+    if (frame.has_partial_checksum())
+        complete_partial_checksum(frame);
+
+    // Point the descriptor straight at the frame instead of copying it into the TX buffer.
+    disable_irq();
+    size_t tx_current = in32(REG_TXDESCTAIL) % number_of_tx_descriptors;
+    transmit(tx_current, frame.physical_address(), frame.size());
+
+    // transmit() waits for the descriptor to complete, so the device is done with the frame.
+    release_packet_buffer(move(frame));
+}
+
+void E1000NetworkAdapter::transmit(size_t tx_current, PhysicalAddress address, size_t length)
+{
 #ifdef E1000_DEBUG
     klog() << "E1000: Sending packet (" << length << " bytes)";
 #endif
     auto* tx_descriptors = (e1000_tx_desc*)m_tx_descriptors_region->vaddr().as_ptr();
     auto& descriptor = tx_descriptors[tx_current];
-    ASSERT(payload.size() <= 8192);
-    auto* vptr = (void*)m_tx_buffers_regions[tx_current].vaddr().as_ptr();
-    memcpy(vptr, payload.data(), payload.size());
-    descriptor.length = payload.size();
+    descriptor.addr = address.get();
+    descriptor.length = length;
     descriptor.status = 0;
     descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
 #ifdef E1000_DEBUG
@@ -423,27 +471,39 @@ void E1000NetworkAdapter::send_raw(ReadonlyBytes payload)
 #endif
 }
 
-void E1000NetworkAdapter::receive()
+size_t E1000NetworkAdapter::receive(size_t budget)
 {
-    auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
-    u32 rx_current;
-    for (;;) {
-        rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
-        if (rx_current == (in32(REG_RXDESCHEAD) % number_of_rx_descriptors))
-            return;
-        rx_current = (rx_current + 1) % number_of_rx_descriptors;
+    auto* rx_descriptors = (e1000_rx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
+    u32 rx_tail = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
+    size_t received = 0;
+    while (received < budget) {
+        u32 rx_current = (rx_tail + 1) % number_of_rx_descriptors;
         if (!(rx_descriptors[rx_current].status & 1))
             break;
-        auto* buffer = m_rx_buffers_regions[rx_current].vaddr().as_ptr();
         u16 length = rx_descriptors[rx_current].length;
-        ASSERT(length <= 8192);
+        ASSERT(length <= rx_buffer_size);
 #ifdef E1000_DEBUG
-        klog() << "E1000: Received 1 packet @ " << buffer << " (" << length << ") bytes!";
+        klog() << "E1000: Received 1 packet @ " << m_rx_buffers[rx_current].data() << " (" << length << ") bytes!";
 #endif
-        did_receive({ buffer, length });
+        // Hand the filled buffer up the stack as-is and give the descriptor a fresh one.
+        // If we can't get one, the frame is dropped and its buffer is reused.
+        auto replacement = create_packet_buffer(rx_buffer_size);
+        if (replacement.has_value()) {
+            auto packet = move(m_rx_buffers[rx_current]);
+            packet.set_size(length);
+            m_rx_buffers[rx_current] = replacement.release_value();
+            rx_descriptors[rx_current].addr = m_rx_buffers[rx_current].physical_address().get();
+            queue_received_packet(move(packet));
+        }
         rx_descriptors[rx_current].status = 0;
-        out32(REG_RXDESCTAIL, rx_current);
+        rx_tail = rx_current;
+        ++received;
     }
+
+    // Hand the whole batch of descriptors back to the device with a single register write.
+    if (received)
+        out32(REG_RXDESCTAIL, rx_tail);
+    return received;
 }
 
 }
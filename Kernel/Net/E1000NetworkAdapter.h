@@ -46,13 +46,17 @@ public:
     virtual ~E1000NetworkAdapter() override;
 
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_packet(PacketBuffer&&) override;
     virtual bool link_up() override;
 
     virtual const char* purpose() const override { return class_name(); }
 
+    virtual size_t poll_receive(size_t budget) override;
+
 private:
     virtual void handle_irq(const RegisterState&) override;
     virtual const char* class_name() const override { return "E1000NetworkAdapter"; }
+    virtual bool wants_physically_contiguous_packet_buffers() const override { return true; }
 
     struct [[gnu::packed]] e1000_rx_desc
     {
@@ -92,13 +96,14 @@ private:
     u16 in16(u16 address);
     u32 in32(u16 address);
 
-    void receive();
+    size_t receive(size_t budget);
+    void transmit(size_t tx_current, PhysicalAddress, size_t length);
 
     IOAddress m_io_base;
     VirtualAddress m_mmio_base;
     OwnPtr<Region> m_rx_descriptors_region;
     OwnPtr<Region> m_tx_descriptors_region;
-    NonnullOwnPtrVector<Region> m_rx_buffers_regions;
+    Vector<PacketBuffer> m_rx_buffers;
     NonnullOwnPtrVector<Region> m_tx_buffers_regions;
     OwnPtr<Region> m_mmio_region;
     u8 m_interrupt_line { 0 };
@@ -107,6 +112,7 @@ private:
     EntropySource m_entropy_source;
 
     static const size_t number_of_rx_descriptors = 32;
+    static const size_t rx_buffer_size = pooled_packet_buffer_size;
     static const size_t number_of_tx_descriptors = 8;
 
     WaitQueue m_wait_queue;
@@ -136,6 +136,8 @@ inline NetworkOrdered<u16> internet_checksum(const void* ptr, size_t count)
             checksum = (checksum & 0xffff) | (checksum >> 16);
         count -= 2;
     }
+    if (count)
+        checksum += *(const u8*)w << 8;
     while (checksum >> 16)
         checksum = (checksum & 0xffff) + (checksum >> 16);
     return ~checksum & 0xffff;
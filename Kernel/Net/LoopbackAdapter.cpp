@@ -53,4 +53,10 @@ void LoopbackAdapter::send_raw(ReadonlyBytes payload)
     did_receive(payload);
 }
 
+void LoopbackAdapter::send_packet(PacketBuffer&& frame)
+{
+    // The frame we just built is exactly what we're about to receive, so queue it as-is.
+    did_receive(move(frame));
+}
+
 }
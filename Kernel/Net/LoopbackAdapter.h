@@ -38,6 +38,7 @@ public:
     virtual ~LoopbackAdapter() override;
 
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_packet(PacketBuffer&&) override;
     virtual const char* class_name() const override { return "LoopbackAdapter"; }
 
 private:
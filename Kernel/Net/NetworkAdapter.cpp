@@ -108,26 +108,66 @@ void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Addr
         return;
     }
 
-    size_t ethernet_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + payload.size();
-    auto buffer = ByteBuffer::create_zeroed(ethernet_frame_size);
-    auto& eth = *(EthernetFrameHeader*)buffer.data();
-    eth.set_source(mac_address());
-    eth.set_destination(destination_mac);
-    eth.set_ether_type(EtherType::IPv4);
-    auto& ipv4 = *(IPv4Packet*)eth.payload();
+    auto buffer = create_packet_buffer(ipv4_packet_headroom + payload.size(), ipv4_packet_headroom);
+    if (!buffer.has_value())
+        return;
+    memcpy(buffer.value().data(), payload.data(), payload.size());
+    buffer.value().set_size(payload.size());
+    send_ipv4(destination_mac, destination_ipv4, protocol, buffer.release_value(), ttl);
+}
+
+void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, PacketBuffer&& payload, u8 ttl)
+{
+    size_t ipv4_packet_size = sizeof(IPv4Packet) + payload.size();
+    if (ipv4_packet_size > mtu()) {
+        if (payload.has_partial_checksum())
+            complete_partial_checksum(payload);
+        send_ipv4_fragmented(destination_mac, destination_ipv4, protocol, payload.bytes(), ttl);
+        release_packet_buffer(move(payload));
+        return;
+    }
+
+    ASSERT(payload.headroom() >= ipv4_packet_headroom);
+    u8* ipv4_header = payload.push_header(sizeof(IPv4Packet));
+    memset(ipv4_header, 0, sizeof(IPv4Packet));
+    auto& ipv4 = *(IPv4Packet*)ipv4_header;
     ipv4.set_version(4);
     ipv4.set_internet_header_length(5);
     ipv4.set_source(ipv4_address());
     ipv4.set_destination(destination_ipv4);
     ipv4.set_protocol((u8)protocol);
-    ipv4.set_length(sizeof(IPv4Packet) + payload.size());
+    ipv4.set_length(ipv4_packet_size);
     ipv4.set_ident(1);
     ipv4.set_ttl(ttl);
     ipv4.set_checksum(ipv4.compute_checksum());
+
+    auto& eth = *(EthernetFrameHeader*)payload.push_header(sizeof(EthernetFrameHeader));
+    eth.set_source(mac_address());
+    eth.set_destination(destination_mac);
+    eth.set_ether_type(EtherType::IPv4);
+
     m_packets_out++;
-    m_bytes_out += ethernet_frame_size;
-    memcpy(ipv4.payload(), payload.data(), payload.size());
-    send_raw({ (const u8*)&eth, ethernet_frame_size });
+    m_bytes_out += payload.size();
+    send_packet(move(payload));
+}
+
+void NetworkAdapter::complete_partial_checksum(PacketBuffer& packet)
+{
+    ASSERT(packet.has_partial_checksum());
+    size_t start = packet.partial_checksum_start();
+    ASSERT(start + packet.partial_checksum_offset() + sizeof(u16) <= packet.size());
+    // Summing over the pseudo header sum that's already in the checksum field yields the full checksum.
+    auto checksum = internet_checksum(packet.data() + start, packet.size() - start);
+    memcpy(packet.data() + start + packet.partial_checksum_offset(), &checksum, sizeof(checksum));
+    packet.clear_partial_checksum();
+}
+
+void NetworkAdapter::send_packet(PacketBuffer&& frame)
+{
+    if (frame.has_partial_checksum())
+        complete_partial_checksum(frame);
+    send_raw(frame.bytes());
+    release_packet_buffer(move(frame));
 }
 
 void NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, ReadonlyBytes payload, u8 ttl)
@@ -171,44 +211,90 @@ void NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac, con
 void NetworkAdapter::did_receive(ReadonlyBytes payload)
 {
     InterruptDisabler disabler;
-    m_packets_in++;
-    m_bytes_in += payload.size();
-
-    Optional<KBuffer> buffer;
-
-    if (m_unused_packet_buffers.is_empty()) {
-        buffer = KBuffer::copy(payload.data(), payload.size());
-    } else {
-        buffer = m_unused_packet_buffers.take_first();
-        --m_unused_packet_buffers_count;
-        if (payload.size() <= buffer.value().size()) {
-            memcpy(buffer.value().data(), payload.data(), payload.size());
-            buffer.value().set_size(payload.size());
-        } else {
-            buffer = KBuffer::copy(payload.data(), payload.size());
-        }
-    }
+    queue_received_packet(payload);
 
-    m_packet_queue.append(buffer.value());
+    if (on_receive)
+        on_receive();
+}
+
+void NetworkAdapter::did_receive(PacketBuffer&& packet)
+{
+    InterruptDisabler disabler;
+    queue_received_packet(move(packet));
 
     if (on_receive)
         on_receive();
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size)
+void NetworkAdapter::request_receive_poll()
+{
+    InterruptDisabler disabler;
+    m_receive_poll_pending = true;
+
+    if (on_receive)
+        on_receive();
+}
+
+void NetworkAdapter::queue_received_packet(ReadonlyBytes payload)
+{
+    auto buffer = create_packet_buffer(payload.size());
+    if (!buffer.has_value()) {
+        klog() << "NetworkAdapter: Out of packet buffers, dropping " << payload.size() << " byte frame";
+        return;
+    }
+    memcpy(buffer.value().data(), payload.data(), payload.size());
+    buffer.value().set_size(payload.size());
+    queue_received_packet(buffer.release_value());
+}
+
+void NetworkAdapter::queue_received_packet(PacketBuffer&& packet)
+{
+    InterruptDisabler disabler;
+    m_packets_in++;
+    m_bytes_in += packet.size();
+    m_packet_queue.append(move(packet));
+}
+
+Optional<PacketBuffer> NetworkAdapter::dequeue_packet()
 {
     InterruptDisabler disabler;
     if (m_packet_queue.is_empty())
-        return 0;
-    auto packet = m_packet_queue.take_first();
-    size_t packet_size = packet.size();
-    ASSERT(packet_size <= buffer_size);
-    memcpy(buffer, packet.data(), packet_size);
-    if (m_unused_packet_buffers_count < 100) {
-        m_unused_packet_buffers.append(packet);
-        ++m_unused_packet_buffers_count;
+        return {};
+    return m_packet_queue.take_first();
+}
+
+Optional<PacketBuffer> NetworkAdapter::create_packet_buffer(size_t capacity, size_t headroom)
+{
+    capacity += device_headroom();
+    headroom += device_headroom();
+    if (capacity <= pooled_packet_buffer_size) {
+        {
+            InterruptDisabler disabler;
+            if (!m_unused_packet_buffers.is_empty()) {
+                auto buffer = m_unused_packet_buffers.take_first();
+                --m_unused_packet_buffers_count;
+                buffer.reset(headroom);
+                return buffer;
+            }
+        }
+        capacity = pooled_packet_buffer_size;
     }
-    return packet_size;
+    // Only single-page buffers are worth the physically contiguous allocation; adapters
+    // fall back to copying anything bigger, which only ever has to be fragmented anyway.
+    bool physically_contiguous = capacity == pooled_packet_buffer_size && wants_physically_contiguous_packet_buffers();
+    return PacketBuffer::create(capacity, headroom, physically_contiguous);
+}
+
+void NetworkAdapter::release_packet_buffer(PacketBuffer&& buffer)
+{
+    // Sockets may still be holding slices of this buffer; it'll be freed along with the last one.
+    if (buffer.is_shared() || buffer.capacity() != pooled_packet_buffer_size)
+        return;
+    InterruptDisabler disabler;
+    if (m_unused_packet_buffers_count >= 100)
+        return;
+    m_unused_packet_buffers.append(move(buffer));
+    ++m_unused_packet_buffers_count;
 }
 
 void NetworkAdapter::set_ipv4_address(const IPv4Address& address)
@@ -35,8 +35,10 @@
 #include <AK/Weakable.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/Net/ARP.h>
+#include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/PacketBuffer.h>
 
 namespace Kernel {
 
@@ -58,6 +60,9 @@ public:
     IPv4Address ipv4_gateway() const { return m_ipv4_gateway; }
     virtual bool link_up() { return false; }
 
+    // Adapters that can compute TCP checksums get segments with only the pseudo header summed.
+    virtual bool has_checksum_offload() const { return false; }
+
     void set_ipv4_address(const IPv4Address&);
     void set_ipv4_netmask(const IPv4Address&);
     void set_ipv4_gateway(const IPv4Address&);
@@ -66,10 +71,31 @@ public:
     void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, ReadonlyBytes payload, u8 ttl);
     void send_ipv4_fragmented(const MACAddress&, const IPv4Address&, IPv4Protocol, ReadonlyBytes payload, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size);
+    // Sends a payload that was built in place, leaving at least ipv4_packet_headroom bytes
+    // in front of it for the IPv4 and Ethernet headers.
+    static constexpr size_t ipv4_packet_headroom = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
+    void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, PacketBuffer&& payload, u8 ttl);
+
+    // Packet buffers come from (and go back to) a small per-adapter pool, so that steady
+    // traffic doesn't allocate. Buffers that are still shared when released are left to die.
+    static constexpr size_t pooled_packet_buffer_size = PAGE_SIZE;
+    Optional<PacketBuffer> create_packet_buffer(size_t capacity, size_t headroom = 0);
+    void release_packet_buffer(PacketBuffer&&);
+
+    Optional<PacketBuffer> dequeue_packet();
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
 
+    // Adapters that defer receive work out of their IRQ handler request a poll, and the
+    // NetworkTask then calls poll_receive() until it returns less than the budget.
+    // Returns the number of frames moved into the packet queue.
+    bool is_receive_poll_pending() const { return m_receive_poll_pending; }
+    virtual size_t poll_receive(size_t budget)
+    {
+        (void)budget;
+        return 0;
+    }
+
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
 
@@ -85,15 +111,28 @@ protected:
     void set_interface_name(const StringView& basename);
     void set_mac_address(const MACAddress& mac_address) { m_mac_address = mac_address; }
     virtual void send_raw(ReadonlyBytes) = 0;
+    // Adapters that can transmit straight out of a packet buffer override this; the default
+    // copies the frame through send_raw().
+    virtual void send_packet(PacketBuffer&&);
+    virtual bool wants_physically_contiguous_packet_buffers() const { return false; }
+    // Extra room that create_packet_buffer() keeps in front of every buffer, for adapters
+    // that prepend their own descriptor header to frames.
+    virtual size_t device_headroom() const { return 0; }
+    static void complete_partial_checksum(PacketBuffer&);
     void did_receive(ReadonlyBytes);
+    void did_receive(PacketBuffer&&);
+    void queue_received_packet(ReadonlyBytes);
+    void queue_received_packet(PacketBuffer&&);
+    void request_receive_poll();
+    void set_receive_poll_pending(bool pending) { m_receive_poll_pending = pending; }
 
 private:
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     IPv4Address m_ipv4_netmask;
     IPv4Address m_ipv4_gateway;
-    SinglyLinkedList<KBuffer> m_packet_queue;
-    SinglyLinkedList<KBuffer> m_unused_packet_buffers;
+    SinglyLinkedList<PacketBuffer> m_packet_queue;
+    SinglyLinkedList<PacketBuffer> m_unused_packet_buffers;
     size_t m_unused_packet_buffers_count { 0 };
     String m_name;
     u32 m_packets_in { 0 };
@@ -101,6 +140,7 @@ private:
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
     u32 m_mtu { 1500 };
+    bool m_receive_poll_pending { false };
 };
 
 }
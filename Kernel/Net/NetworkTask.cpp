@@ -52,13 +52,16 @@
 namespace Kernel {
 
 static void handle_arp(const EthernetFrameHeader&, size_t frame_size);
-static void handle_ipv4(const EthernetFrameHeader&, size_t frame_size);
-static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&);
-static void handle_udp(const IPv4Packet&);
-static void handle_tcp(const IPv4Packet&);
+static void handle_ipv4(const PacketBuffer& frame);
+static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&, const PacketBuffer& ipv4_packet_buffer);
+static void handle_udp(const IPv4Packet&, const PacketBuffer& ipv4_packet_buffer);
+static void handle_tcp(const IPv4Packet&, const PacketBuffer& ipv4_packet_buffer);
+static void handle_frame(const PacketBuffer& frame);
 
 [[noreturn]] static void NetworkTask_main();
 
+static constexpr size_t receive_poll_budget = 64;
+
 void NetworkTask::spawn()
 {
     Thread* thread = nullptr;
@@ -69,7 +72,6 @@ void NetworkTask_main()
 {
     WaitQueue packet_wait_queue;
     u8 octet = 15;
-    int pending_packets = 0;
     NetworkAdapter::for_each([&](auto& adapter) {
         if (String(adapter.class_name()) == "LoopbackAdapter") {
             adapter.set_ipv4_address({ 127, 0, 0, 1 });
@@ -84,81 +86,96 @@ void NetworkTask_main()
         klog() << "NetworkTask: " << adapter.class_name() << " network adapter found: hw=" << adapter.mac_address().to_string().characters() << " address=" << adapter.ipv4_address().to_string().characters() << " netmask=" << adapter.ipv4_netmask().to_string().characters() << " gateway=" << adapter.ipv4_gateway().to_string().characters();
 
         adapter.on_receive = [&]() {
-            pending_packets++;
             packet_wait_queue.wake_all();
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
+    // Frames are handled in place, straight out of the buffer the adapter received them into.
+    // Once we're done, the buffer goes back to the adapter's pool unless a socket kept a slice of it.
+    auto dequeue_packet = [](RefPtr<NetworkAdapter>& source_adapter) -> Optional<PacketBuffer> {
+        Optional<PacketBuffer> packet;
         NetworkAdapter::for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
+            if (packet.has_value() || !adapter.has_queued_packets())
                 return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size);
-            pending_packets--;
+            packet = adapter.dequeue_packet();
+            source_adapter = adapter;
 #ifdef NETWORK_TASK_DEBUG
-            klog() << "NetworkTask: Dequeued packet from " << adapter.name().characters() << " (" << packet_size << " bytes)";
+            klog() << "NetworkTask: Dequeued packet from " << adapter.name().characters() << " (" << packet.value().size() << " bytes)";
 #endif
         });
-        return packet_size;
+        return packet;
     };
 
-    size_t buffer_size = 64 * KiB;
-    auto buffer_region = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer", Region::Access::Read | Region::Access::Write, false, true);
-    auto buffer = (u8*)buffer_region->vaddr().get();
-
     klog() << "NetworkTask: Enter main loop.";
     for (;;) {
-        size_t packet_size = dequeue_packet(buffer, buffer_size);
-        if (!packet_size) {
-            Thread::current()->wait_on(packet_wait_queue, "NetworkTask");
-            continue;
-        }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            klog() << "NetworkTask: Packet is too small to be an Ethernet packet! (" << packet_size << ")";
+        TCPSocket::handle_timers();
+        RefPtr<NetworkAdapter> source_adapter;
+        auto packet = dequeue_packet(source_adapter);
+        if (!packet.has_value()) {
+            // Only pull the next batch off the adapters once the previous one has been processed,
+            // so that the amount of queued frames stays bounded by the poll budget.
+            size_t polled = 0;
+            NetworkAdapter::for_each([&](auto& adapter) {
+                polled += adapter.poll_receive(receive_poll_budget);
+            });
+            if (polled)
+                continue;
+
+            // Wake up regularly even without traffic so that TCP retransmission timers fire.
+            timeval timeout { 0, 50000 };
+            Thread::current()->wait_on(packet_wait_queue, "NetworkTask", &timeout);
             continue;
         }
-        auto& eth = *(const EthernetFrameHeader*)buffer;
+        handle_frame(packet.value());
+        source_adapter->release_packet_buffer(packet.release_value());
+    }
+}
+
+void handle_frame(const PacketBuffer& frame)
+{
+    size_t packet_size = frame.size();
+    if (packet_size < sizeof(EthernetFrameHeader)) {
+        klog() << "NetworkTask: Packet is too small to be an Ethernet packet! (" << packet_size << ")";
+        return;
+    }
+    auto& eth = *(const EthernetFrameHeader*)frame.data();
 #ifdef ETHERNET_DEBUG
-        klog() << "NetworkTask: From " << eth.source().to_string().characters() << " to " << eth.destination().to_string().characters() << ", ether_type=" << String::format("%w", eth.ether_type()) << ", packet_length=" << packet_size;
+    klog() << "NetworkTask: From " << eth.source().to_string().characters() << " to " << eth.destination().to_string().characters() << ", ether_type=" << String::format("%w", eth.ether_type()) << ", packet_length=" << packet_size;
 #endif
 
 #ifdef ETHERNET_VERY_DEBUG
-        for (size_t i = 0; i < packet_size; i++) {
-            klog() << String::format("%b", buffer[i]);
-
-            switch (i % 16) {
-            case 7:
-                klog() << "  ";
-                break;
-            case 15:
-                klog() << "";
-                break;
-            default:
-                klog() << " ";
-                break;
-            }
-        }
-
-        klog() << "";
-#endif
+    for (size_t i = 0; i < packet_size; i++) {
+        klog() << String::format("%b", frame.data()[i]);
 
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
+        switch (i % 16) {
+        case 7:
+            klog() << "  ";
             break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size);
-            break;
-        case EtherType::IPv6:
-            // ignore
+        case 15:
+            klog() << "";
             break;
         default:
-            klog() << "NetworkTask: Unknown ethernet type 0x" << String::format("%x", eth.ether_type());
+            klog() << " ";
+            break;
         }
     }
+
+    klog() << "";
+#endif
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, packet_size);
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(frame);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        klog() << "NetworkTask: Unknown ethernet type 0x" << String::format("%x", eth.ether_type());
+    }
 }
 
 void handle_arp(const EthernetFrameHeader& eth, size_t frame_size)
@@ -213,8 +230,10 @@ void handle_arp(const EthernetFrameHeader& eth, size_t frame_size)
     }
 }
 
-void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
+void handle_ipv4(const PacketBuffer& frame)
 {
+    auto& eth = *(const EthernetFrameHeader*)frame.data();
+    size_t frame_size = frame.size();
     constexpr size_t minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
         klog() << "handle_ipv4: Frame too small (" << frame_size << ", need " << minimum_ipv4_frame_size << ")";
@@ -237,20 +256,23 @@ void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
     klog() << "handle_ipv4: source=" << packet.source().to_string().characters() << ", target=" << packet.destination().to_string().characters();
 #endif
 
+    // Trailing Ethernet padding isn't part of the IPv4 packet.
+    auto ipv4_packet_buffer = frame.slice(sizeof(EthernetFrameHeader), packet.length());
+
     switch ((IPv4Protocol)packet.protocol()) {
     case IPv4Protocol::ICMP:
-        return handle_icmp(eth, packet);
+        return handle_icmp(eth, packet, ipv4_packet_buffer);
     case IPv4Protocol::UDP:
-        return handle_udp(packet);
+        return handle_udp(packet, ipv4_packet_buffer);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet);
+        return handle_tcp(packet, ipv4_packet_buffer);
     default:
         klog() << "handle_ipv4: Unhandled protocol " << packet.protocol();
         break;
     }
 }
 
-void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
+void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet, const PacketBuffer& ipv4_packet_buffer)
 {
     auto& icmp_header = *static_cast<const ICMPHeader*>(ipv4_packet.payload());
 #ifdef ICMP_DEBUG
@@ -263,7 +285,7 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
             LOCKER(socket->lock());
             if (socket->protocol() != (unsigned)IPv4Protocol::ICMP)
                 continue;
-            socket->did_receive(ipv4_packet.source(), 0, KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+            socket->did_receive(ipv4_packet.source(), 0, PacketBuffer(ipv4_packet_buffer));
         }
     }
 
@@ -289,7 +311,7 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
     }
 }
 
-void handle_udp(const IPv4Packet& ipv4_packet)
+void handle_udp(const IPv4Packet& ipv4_packet, const PacketBuffer& ipv4_packet_buffer)
 {
     if (ipv4_packet.payload_size() < sizeof(UDPPacket)) {
         klog() << "handle_udp: Packet too small (" << ipv4_packet.payload_size() << ", need " << sizeof(UDPPacket) << ")";
@@ -315,10 +337,10 @@ void handle_udp(const IPv4Packet& ipv4_packet)
 
     ASSERT(socket->type() == SOCK_DGRAM);
     ASSERT(socket->local_port() == udp_packet.destination_port());
-    socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+    socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), PacketBuffer(ipv4_packet_buffer));
 }
 
-void handle_tcp(const IPv4Packet& ipv4_packet)
+void handle_tcp(const IPv4Packet& ipv4_packet, const PacketBuffer& ipv4_packet_buffer)
 {
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         klog() << "handle_tcp: IPv4 payload is too small to be a TCP packet (" << ipv4_packet.payload_size() << ", need " << sizeof(TCPPacket) << ")";
@@ -331,6 +353,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
     size_t maximum_tcp_header_size = 15 * sizeof(u32);
     if (tcp_packet.header_size() < minimum_tcp_header_size || tcp_packet.header_size() > maximum_tcp_header_size) {
         klog() << "handle_tcp: TCP packet header has invalid size " << tcp_packet.header_size();
+        return;
     }
 
     if (ipv4_packet.payload_size() < tcp_packet.header_size()) {
@@ -339,6 +362,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
     }
 
     size_t payload_size = ipv4_packet.payload_size() - tcp_packet.header_size();
+    auto payload = ipv4_packet_buffer.slice(sizeof(IPv4Packet) + tcp_packet.header_size(), payload_size);
 
 #ifdef TCP_DEBUG
     klog() << "handle_tcp: source=" << ipv4_packet.source().to_string().characters() << ":" << tcp_packet.source_port() << ", destination=" << ipv4_packet.destination().to_string().characters() << ":" << tcp_packet.destination_port() << " seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << tcp_packet.ack_number() << ", flags=" << String::format("%w", tcp_packet.flags()) << " (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << "), window_size=" << tcp_packet.window_size() << ", payload_size=" << payload_size;
@@ -400,6 +424,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 #endif
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->process_syn_options(tcp_packet);
             client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -547,26 +572,23 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
         }
     case TCPSocket::State::Established:
         if (tcp_packet.has_fin()) {
-            if (payload_size != 0)
-                socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+            // A FIN that arrives ahead of missing data has to wait for the retransmission.
+            if (!socket->receive_segment_data(tcp_packet, payload))
+                return;
 
-            socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->set_ack_number(socket->ack_number() + 1);
             socket->send_tcp_packet(TCPFlags::ACK);
             socket->set_state(TCPSocket::State::CloseWait);
             socket->set_connected(false);
             return;
         }
 
-        socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
-
 #ifdef TCP_DEBUG
-        klog() << "Got packet with ack_no=" << tcp_packet.ack_number() << ", seq_no=" << tcp_packet.sequence_number() << ", payload_size=" << payload_size << ", acking it with new ack_no=" << socket->ack_number() << ", seq_no=" << socket->sequence_number();
+        klog() << "Got packet with ack_no=" << tcp_packet.ack_number() << ", seq_no=" << tcp_packet.sequence_number() << ", payload_size=" << payload_size << ", expecting seq_no=" << socket->ack_number();
 #endif
 
-        if (payload_size) {
-            if (socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size())))
-                socket->send_tcp_packet(TCPFlags::ACK);
-        }
+        if (payload_size)
+            socket->receive_segment_data(tcp_packet, payload);
     }
 }
 
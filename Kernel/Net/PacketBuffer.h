@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/PhysicalAddress.h>
+
+namespace Kernel {
+
+// PacketBuffer: A window into reference-counted packet memory.
+//
+// Network adapters receive frames straight into PacketBuffers and hand them up the
+// stack, where each layer narrows the window with slice() instead of copying. Sockets
+// keep the same storage alive in their receive queues for as long as they need it.
+//
+// Outgoing packets are built with enough headroom in front of the payload that every
+// layer can prepend its header in place with push_header(), so the finished frame can
+// be handed to the NIC as-is.
+
+class PacketBuffer {
+public:
+    static Optional<PacketBuffer> create(size_t capacity, size_t headroom = 0, bool physically_contiguous = false)
+    {
+        ASSERT(headroom <= capacity);
+        auto storage = KBuffer::try_create_committed(capacity, physically_contiguous, Region::Access::Read | Region::Access::Write, "Packet buffer");
+        if (!storage.has_value())
+            return {};
+        return PacketBuffer(storage.release_value(), headroom, 0, physically_contiguous);
+    }
+
+    u8* data() { return m_storage.data() + m_offset; }
+    const u8* data() const { return m_storage.data() + m_offset; }
+    size_t size() const { return m_size; }
+    ReadonlyBytes bytes() const { return { data(), m_size }; }
+
+    size_t headroom() const { return m_offset; }
+    size_t tailroom() const { return m_storage.capacity() - m_offset - m_size; }
+    size_t capacity() const { return m_storage.capacity(); }
+
+    void set_size(size_t size)
+    {
+        ASSERT(m_offset + size <= m_storage.capacity());
+        m_size = size;
+    }
+
+    // Grows the window towards the front of the buffer, returning the new start.
+    u8* push_header(size_t size)
+    {
+        ASSERT(size <= m_offset);
+        m_offset -= size;
+        m_size += size;
+        return data();
+    }
+
+    // Rewinds the window so the buffer can be reused for a new packet.
+    void reset(size_t headroom = 0)
+    {
+        ASSERT(headroom <= m_storage.capacity());
+        m_offset = headroom;
+        m_size = 0;
+        m_has_partial_checksum = false;
+    }
+
+    // Leaves the transport checksum of an outgoing packet to the adapter. The checksum field,
+    // `checksum_offset` bytes into the current window, must already hold the pseudo header sum.
+    void set_partial_checksum(size_t checksum_offset)
+    {
+        m_partial_checksum_start = m_offset;
+        m_partial_checksum_offset = checksum_offset;
+        m_has_partial_checksum = true;
+    }
+    void clear_partial_checksum() { m_has_partial_checksum = false; }
+    bool has_partial_checksum() const { return m_has_partial_checksum; }
+    // Both relative to the start of the current window.
+    size_t partial_checksum_start() const { return m_partial_checksum_start - m_offset; }
+    size_t partial_checksum_offset() const { return m_partial_checksum_offset; }
+
+    // Returns a new window into the same storage; no packet data is copied.
+    PacketBuffer slice(size_t offset, size_t size) const
+    {
+        ASSERT(offset + size <= m_size);
+        return PacketBuffer(m_storage, m_offset + offset, size, m_physically_contiguous);
+    }
+
+    bool is_physically_contiguous() const { return m_physically_contiguous; }
+
+    // Physical address of the first byte, for handing the buffer to a DMA engine.
+    PhysicalAddress physical_address() const
+    {
+        ASSERT(m_physically_contiguous);
+        auto& region = m_storage.impl().region();
+        auto* page = region.physical_page(m_offset / PAGE_SIZE);
+        ASSERT(page);
+        return page->paddr().offset(m_offset % PAGE_SIZE);
+    }
+
+    // True while a slice of this buffer is still referenced elsewhere (e.g. by a socket).
+    bool is_shared() const { return m_storage.impl().ref_count() > 1; }
+
+private:
+    PacketBuffer(const KBuffer& storage, size_t offset, size_t size, bool physically_contiguous)
+        : m_storage(storage)
+        , m_offset(offset)
+        , m_size(size)
+        , m_physically_contiguous(physically_contiguous)
+    {
+    }
+
+    KBuffer m_storage;
+    size_t m_offset { 0 };
+    size_t m_size { 0 };
+    size_t m_partial_checksum_start { 0 };
+    size_t m_partial_checksum_offset { 0 };
+    bool m_physically_contiguous { false };
+    bool m_has_partial_checksum { false };
+};
+
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashFunctions.h>
+#include <AK/HashMap.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Lock.h>
+
+namespace Kernel {
+
+// A map from a demultiplexing key to the socket that owns it, split into shards
+// that are locked independently. Lookups only take their shard's lock in shared mode,
+// so packets for unrelated connections never contend with each other or with
+// sockets being bound, connected or torn down.
+template<typename Key, typename SocketType, size_t shard_count = 16>
+class SocketTable {
+public:
+    RefPtr<SocketType> get(const Key& key)
+    {
+        auto& shard = shard_for(key);
+        LOCKER(shard.lock(), Lock::Mode::Shared);
+        auto it = shard.resource().find(key);
+        if (it == shard.resource().end())
+            return {};
+        return *it->value;
+    }
+
+    bool try_add(const Key& key, SocketType& socket)
+    {
+        auto& shard = shard_for(key);
+        LOCKER(shard.lock());
+        if (shard.resource().contains(key))
+            return false;
+        shard.resource().set(key, &socket);
+        return true;
+    }
+
+    // Only removes the entry if it still belongs to this socket.
+    void remove(const Key& key, SocketType& socket)
+    {
+        auto& shard = shard_for(key);
+        LOCKER(shard.lock());
+        auto it = shard.resource().find(key);
+        if (it != shard.resource().end() && it->value == &socket)
+            shard.resource().remove(it);
+    }
+
+    template<typename Callback>
+    void for_each(Callback callback)
+    {
+        for (auto& shard : m_shards) {
+            LOCKER(shard.lock(), Lock::Mode::Shared);
+            for (auto& it : shard.resource())
+                callback(*it.value);
+        }
+    }
+
+private:
+    using Shard = Lockable<HashMap<Key, SocketType*>>;
+
+    Shard& shard_for(const Key& key)
+    {
+        // Rehash so that the shard index doesn't correlate with the bucket index inside the shard.
+        return m_shards[int_hash(Traits<Key>::hash(key)) % shard_count];
+    }
+
+    Shard m_shards[shard_count];
+};
+
+}
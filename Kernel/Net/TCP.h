@@ -41,12 +41,26 @@ struct TCPFlags {
     };
 };
 
+struct TCPOptionKind {
+    enum : u8 {
+        End = 0,
+        NOP = 1,
+        MSS = 2,
+        WindowScale = 3,
+        SACKPermitted = 4,
+        SACK = 5,
+    };
+};
+
 class [[gnu::packed]] TCPPacket
 {
 public:
     TCPPacket() {}
     ~TCPPacket() {}
 
+    // Where the checksum lives, for adapters that fill it in themselves.
+    static constexpr size_t checksum_offset = 16;
+
     size_t header_size() const { return data_offset() * sizeof(u32); }
 
     u16 source_port() const { return m_source_port; }
@@ -81,6 +95,10 @@ public:
     u16 urgent() const { return m_urgent; }
     void set_urgent(u16 urgent) { m_urgent = urgent; }
 
+    const u8* options() const { return ((const u8*)this) + sizeof(TCPPacket); }
+    u8* options() { return ((u8*)this) + sizeof(TCPPacket); }
+    size_t options_size() const { return header_size() - sizeof(TCPPacket); }
+
     const void* payload() const { return ((const u8*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
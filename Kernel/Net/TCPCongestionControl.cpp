@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <AK/NumericLimits.h>
+#include <Kernel/Net/TCPCongestionControl.h>
+
+namespace Kernel {
+
+OwnPtr<TCPCongestionControl> TCPCongestionControl::create(const StringView& name, size_t mss)
+{
+    if (name == "newreno")
+        return make<TCPNewReno>(mss);
+    if (name == "cubic")
+        return make<TCPCubic>(mss);
+    return nullptr;
+}
+
+// RFC 5681, section 3.1
+static size_t initial_window(size_t mss)
+{
+    if (mss > 2190)
+        return 2 * mss;
+    if (mss > 1095)
+        return 3 * mss;
+    return 4 * mss;
+}
+
+TCPCongestionControl::TCPCongestionControl(size_t mss)
+    : m_mss(mss)
+    , m_congestion_window(initial_window(mss))
+    , m_slow_start_threshold(NumericLimits<size_t>::max())
+{
+}
+
+void TCPCongestionControl::set_mss(size_t mss)
+{
+    m_mss = mss;
+    m_congestion_window = initial_window(mss);
+}
+
+void TCPCongestionControl::slow_start(size_t bytes_acked)
+{
+    // Appropriate byte counting with L = 2 * SMSS (RFC 3465, section 2.2).
+    m_congestion_window += min(bytes_acked, 2 * m_mss);
+}
+
+void TCPCongestionControl::on_retransmission_timeout(size_t bytes_in_flight, u64)
+{
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_mss);
+    m_congestion_window = m_mss;
+}
+
+void TCPNewReno::on_ack(size_t bytes_acked, u64, u32)
+{
+    if (is_in_slow_start()) {
+        slow_start(bytes_acked);
+        return;
+    }
+
+    m_bytes_acked += bytes_acked;
+    if (m_bytes_acked >= m_congestion_window) {
+        m_bytes_acked -= m_congestion_window;
+        m_congestion_window += m_mss;
+    }
+}
+
+void TCPNewReno::on_congestion_event(size_t bytes_in_flight, u64)
+{
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_mss);
+    m_congestion_window = m_slow_start_threshold;
+    m_bytes_acked = 0;
+}
+
+static u64 integer_cube_root(u64 value)
+{
+    u64 low = 0;
+    u64 high = 2097152; // 2^21, whose cube just exceeds 2^63.
+    while (low < high) {
+        u64 middle = (low + high + 1) / 2;
+        if (middle * middle * middle <= value)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+
+// The cubic function uses C = 0.4 and beta = 0.7, as recommended by RFC 8312.
+static constexpr u64 cubic_beta_permille = 700;
+static constexpr u64 tcp_friendly_alpha_permille = 529; // 3 * (1 - beta) / (1 + beta)
+static constexpr i64 max_cubic_time_ms = 60000;
+
+void TCPCubic::on_ack(size_t bytes_acked, u64 now_ms, u32 rtt_ms)
+{
+    if (rtt_ms && (!m_min_rtt_ms || rtt_ms < m_min_rtt_ms))
+        m_min_rtt_ms = rtt_ms;
+
+    if (is_in_slow_start()) {
+        slow_start(bytes_acked);
+        return;
+    }
+
+    if (!m_epoch_start_ms) {
+        m_epoch_start_ms = now_ms;
+        if (m_congestion_window < m_window_maximum) {
+            // K = cbrt((W_max - cwnd) / C), where the window is measured in segments and K in seconds.
+            u64 deficit = m_window_maximum - m_congestion_window;
+            m_k_ms = integer_cube_root(deficit * 2500000000ull / m_mss);
+            m_window_origin = m_window_maximum;
+        } else {
+            m_k_ms = 0;
+            m_window_origin = m_congestion_window;
+        }
+        m_tcp_friendly_window = m_congestion_window;
+    }
+
+    i64 t = (i64)(now_ms + m_min_rtt_ms - m_epoch_start_ms) - (i64)m_k_ms;
+    t = clamp(t, -max_cubic_time_ms, max_cubic_time_ms);
+    i64 offset = (t * t * t / 1000) * 4 * (i64)m_mss / 10000000;
+    // Don't let a single round trip grow the window by more than half (RFC 8312, section 4.3).
+    u64 target = clamp((i64)m_window_origin + offset, (i64)m_mss, (i64)m_congestion_window * 3 / 2);
+
+    if (target > m_congestion_window)
+        m_congestion_window += max((size_t)((target - m_congestion_window) * bytes_acked / m_congestion_window), (size_t)1);
+    else
+        m_congestion_window += max(m_mss * bytes_acked / (100 * m_congestion_window), (size_t)1);
+
+    // Never grow slower than standard TCP would in the same situation (RFC 8312, section 4.2).
+    m_tcp_friendly_window += tcp_friendly_alpha_permille * m_mss * bytes_acked / (1000 * m_tcp_friendly_window);
+    if (m_tcp_friendly_window > m_congestion_window)
+        m_congestion_window = m_tcp_friendly_window;
+}
+
+void TCPCubic::reduce_window_maximum()
+{
+    m_epoch_start_ms = 0;
+    // Fast convergence (RFC 8312, section 4.6).
+    if (m_congestion_window < m_window_maximum)
+        m_window_maximum = m_congestion_window * (1000 + cubic_beta_permille) / 2000;
+    else
+        m_window_maximum = m_congestion_window;
+}
+
+void TCPCubic::on_congestion_event(size_t, u64)
+{
+    reduce_window_maximum();
+    m_slow_start_threshold = max((size_t)(m_congestion_window * cubic_beta_permille / 1000), 2 * m_mss);
+    m_congestion_window = m_slow_start_threshold;
+}
+
+void TCPCubic::on_retransmission_timeout(size_t, u64)
+{
+    reduce_window_maximum();
+    m_slow_start_threshold = max((size_t)(m_congestion_window * cubic_beta_permille / 1000), 2 * m_mss);
+    m_congestion_window = m_mss;
+}
+
+}
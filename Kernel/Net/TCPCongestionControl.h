@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/OwnPtr.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// The congestion controller decides how many bytes a TCPSocket may have in flight.
+// TCPSocket owns the loss detection and recovery logic and only reports events here.
+class TCPCongestionControl {
+public:
+    static OwnPtr<TCPCongestionControl> create(const StringView& name, size_t mss);
+    static const char* default_name() { return "cubic"; }
+
+    virtual ~TCPCongestionControl() { }
+
+    virtual const char* name() const = 0;
+
+    size_t congestion_window() const { return m_congestion_window; }
+    size_t slow_start_threshold() const { return m_slow_start_threshold; }
+    bool is_in_slow_start() const { return m_congestion_window < m_slow_start_threshold; }
+
+    void set_mss(size_t);
+    size_t mss() const { return m_mss; }
+
+    // Called for every ACK that advances the left edge of the send window outside of loss recovery.
+    virtual void on_ack(size_t bytes_acked, u64 now_ms, u32 rtt_ms) = 0;
+
+    // Called once when loss recovery is entered, either by duplicate ACKs or SACK information.
+    virtual void on_congestion_event(size_t bytes_in_flight, u64 now_ms) = 0;
+
+    virtual void on_retransmission_timeout(size_t bytes_in_flight, u64 now_ms);
+
+protected:
+    explicit TCPCongestionControl(size_t mss);
+
+    void slow_start(size_t bytes_acked);
+
+    size_t m_mss { 0 };
+    size_t m_congestion_window { 0 };
+    size_t m_slow_start_threshold { 0 };
+};
+
+// RFC 5681 / RFC 6582 with appropriate byte counting (RFC 3465).
+class TCPNewReno final : public TCPCongestionControl {
+public:
+    explicit TCPNewReno(size_t mss)
+        : TCPCongestionControl(mss)
+    {
+    }
+
+    virtual const char* name() const override { return "newreno"; }
+    virtual void on_ack(size_t bytes_acked, u64 now_ms, u32 rtt_ms) override;
+    virtual void on_congestion_event(size_t bytes_in_flight, u64 now_ms) override;
+
+private:
+    size_t m_bytes_acked { 0 };
+};
+
+// RFC 8312, computed in integer milliseconds and bytes.
+class TCPCubic final : public TCPCongestionControl {
+public:
+    explicit TCPCubic(size_t mss)
+        : TCPCongestionControl(mss)
+    {
+    }
+
+    virtual const char* name() const override { return "cubic"; }
+    virtual void on_ack(size_t bytes_acked, u64 now_ms, u32 rtt_ms) override;
+    virtual void on_congestion_event(size_t bytes_in_flight, u64 now_ms) override;
+    virtual void on_retransmission_timeout(size_t bytes_in_flight, u64 now_ms) override;
+
+private:
+    void reduce_window_maximum();
+
+    size_t m_window_maximum { 0 };
+    size_t m_window_origin { 0 };
+    size_t m_tcp_friendly_window { 0 };
+    u64 m_epoch_start_ms { 0 };
+    u64 m_k_ms { 0 };
+    u32 m_min_rtt_ms { 0 };
+};
+
+}
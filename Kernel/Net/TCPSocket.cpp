@@ -38,11 +38,35 @@
 
 namespace Kernel {
 
+static constexpr size_t tcp_send_buffer_size = 256 * KiB;
+// 65535 << 3 covers the 256 KiB receive buffer of a stream socket.
+static constexpr u8 tcp_receive_window_scale = 3;
+static constexpr u16 tcp_default_mss = 536;
+static constexpr u32 tcp_min_rto_ms = 200;
+static constexpr u32 tcp_max_rto_ms = 60000;
+static constexpr size_t tcp_duplicate_ack_threshold = 3;
+static constexpr u32 tcp_delayed_ack_timeout_ms = 40;
+
+static inline bool sequence_less_than(u32 a, u32 b)
+{
+    return (i32)(a - b) < 0;
+}
+
+static inline bool sequence_less_than_or_equal(u32 a, u32 b)
+{
+    return (i32)(a - b) <= 0;
+}
+
+static u64 current_time_ms()
+{
+    auto now = kgettimeofday();
+    return (u64)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
 void TCPSocket::for_each(Function<void(const TCPSocket&)> callback)
 {
-    LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
-    for (auto& it : sockets_by_tuple().resource())
-        callback(*it.value);
+    listeners().for_each([&](auto& socket) { callback(socket); });
+    connections().for_each([&](auto& socket) { callback(socket); });
 }
 
 void TCPSocket::set_state(State new_state)
@@ -57,6 +81,13 @@ void TCPSocket::set_state(State new_state)
         m_role = Role::Connected;
 
     if (new_state == State::Closed) {
+        {
+            LOCKER(m_not_acked_lock);
+            m_not_acked.clear();
+            m_not_acked_size = 0;
+            m_retransmission_deadline_ms = 0;
+            m_delayed_ack_deadline_ms = 0;
+        }
         LOCKER(closing_sockets().lock());
         closing_sockets().resource().remove(tuple());
     }
@@ -70,33 +101,31 @@ Lockable<HashMap<IPv4SocketTuple, RefPtr<TCPSocket>>>& TCPSocket::closing_socket
     return *s_map;
 }
 
-Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
+SocketTable<IPv4SocketTuple, TCPSocket>& TCPSocket::connections()
 {
-    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>* s_map;
-    if (!s_map)
-        s_map = new Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>;
-    return *s_map;
+    static SocketTable<IPv4SocketTuple, TCPSocket>* s_table;
+    if (!s_table)
+        s_table = new SocketTable<IPv4SocketTuple, TCPSocket>;
+    return *s_table;
 }
 
-RefPtr<TCPSocket> TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
+SocketTable<IPv4SocketTuple, TCPSocket>& TCPSocket::listeners()
 {
-    LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
-
-    auto exact_match = sockets_by_tuple().resource().get(tuple);
-    if (exact_match.has_value())
-        return { *exact_match.value() };
+    static SocketTable<IPv4SocketTuple, TCPSocket>* s_table;
+    if (!s_table)
+        s_table = new SocketTable<IPv4SocketTuple, TCPSocket>;
+    return *s_table;
+}
 
-    auto address_tuple = IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0);
-    auto address_match = sockets_by_tuple().resource().get(address_tuple);
-    if (address_match.has_value())
-        return { *address_match.value() };
+RefPtr<TCPSocket> TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
+{
+    if (auto exact_match = connections().get(tuple))
+        return exact_match;
 
-    auto wildcard_tuple = IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0);
-    auto wildcard_match = sockets_by_tuple().resource().get(wildcard_tuple);
-    if (wildcard_match.has_value())
-        return { *wildcard_match.value() };
+    if (auto address_match = listeners().get(IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0)))
+        return address_match;
 
-    return {};
+    return listeners().get(IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0));
 }
 
 RefPtr<TCPSocket> TCPSocket::from_endpoints(const IPv4Address& local_address, u16 local_port, const IPv4Address& peer_address, u16 peer_port)
@@ -108,10 +137,6 @@ RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address,
 {
     auto tuple = IPv4SocketTuple(new_local_address, new_local_port, new_peer_address, new_peer_port);
 
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple))
-        return {};
-
     auto client = TCPSocket::create(protocol());
 
     client->set_setup_state(SetupState::InProgress);
@@ -122,10 +147,11 @@ RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address,
     client->set_direction(Direction::Incoming);
     client->set_originator(*this);
 
+    if (!connections().try_add(tuple, *client))
+        return {};
     m_pending_release_for_accept.set(tuple, client);
-    sockets_by_tuple().resource().set(tuple, client);
 
-    return from_tuple(tuple);
+    return client;
 }
 
 void TCPSocket::release_to_originator()
@@ -144,13 +170,14 @@ void TCPSocket::release_for_accept(RefPtr<TCPSocket> socket)
 
 TCPSocket::TCPSocket(int protocol)
     : IPv4Socket(SOCK_STREAM, protocol)
+    , m_congestion_control(TCPCongestionControl::create(TCPCongestionControl::default_name(), tcp_default_mss))
 {
 }
 
 TCPSocket::~TCPSocket()
 {
-    LOCKER(sockets_by_tuple().lock());
-    sockets_by_tuple().resource().remove(tuple());
+    connections().remove(tuple(), *this);
+    listeners().remove(tuple(), *this);
 
 #ifdef TCP_SOCKET_DEBUG
     dbg() << "~TCPSocket in state " << to_string(state());
@@ -162,133 +189,681 @@ NonnullRefPtr<TCPSocket> TCPSocket::create(int protocol)
     return adopt(*new TCPSocket(protocol));
 }
 
-KResultOr<size_t> TCPSocket::protocol_receive(const KBuffer& packet_buffer, void* buffer, size_t buffer_size, int flags)
+KResultOr<size_t> TCPSocket::protocol_send(const void* data, size_t data_length)
 {
-    (void)flags;
-    auto& ipv4_packet = *(const IPv4Packet*)(packet_buffer.data());
-    auto& tcp_packet = *static_cast<const TCPPacket*>(ipv4_packet.payload());
-    size_t payload_size = packet_buffer.size() - sizeof(IPv4Packet) - tcp_packet.header_size();
-#ifdef TCP_SOCKET_DEBUG
-    klog() << "payload_size " << payload_size << ", will it fit in " << buffer_size << "?";
-#endif
-    ASSERT(buffer_size >= payload_size);
-    memcpy(buffer, tcp_packet.payload(), payload_size);
-    return payload_size;
+    LOCKER(m_not_acked_lock);
+    if (m_not_acked_size >= tcp_send_buffer_size)
+        return KResult(-EAGAIN);
+
+    // Accept as much as fits in the send buffer; the caller will block until there's room for the rest.
+    size_t accepted = min(data_length, tcp_send_buffer_size - m_not_acked_size);
+    auto* bytes = (const u8*)data;
+    size_t offset = 0;
+
+    // Coalesce small writes into a segment that hasn't gone out yet.
+    if (!m_not_acked.is_empty()) {
+        auto& last = m_not_acked.last();
+        if (!last.tx_counter && last.flags == (TCPFlags::PUSH | TCPFlags::ACK) && last.payload.size() < m_mss) {
+            size_t appended = min(accepted, m_mss - last.payload.size());
+            last.payload.append(bytes, appended);
+            m_sequence_number += appended;
+            m_not_acked_size += appended;
+            offset = appended;
+        }
+    }
+
+    while (offset < accepted) {
+        size_t segment_size = min(accepted - offset, m_mss);
+        m_not_acked.append({ m_sequence_number, TCPFlags::PUSH | TCPFlags::ACK, ByteBuffer::copy(bytes + offset, segment_size) });
+        m_sequence_number += segment_size;
+        m_not_acked_size += segment_size;
+        offset += segment_size;
+    }
+
+    send_outgoing_packets(false);
+    return accepted;
 }
 
-KResultOr<size_t> TCPSocket::protocol_send(const void* data, size_t data_length)
+bool TCPSocket::can_write(const FileDescription& description, size_t size) const
 {
-    send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, data, data_length);
-    return data_length;
+    if (!IPv4Socket::can_write(description, size))
+        return false;
+    return m_not_acked_size < tcp_send_buffer_size;
 }
 
 void TCPSocket::send_tcp_packet(u16 flags, const void* payload, size_t payload_size)
 {
-    auto buffer = ByteBuffer::create_zeroed(sizeof(TCPPacket) + payload_size);
-    auto& tcp_packet = *(TCPPacket*)(buffer.data());
+    // Anything that occupies sequence space must be retransmitted until it's acknowledged.
+    if ((flags & (TCPFlags::SYN | TCPFlags::FIN)) || payload_size > 0) {
+        LOCKER(m_not_acked_lock);
+        OutgoingPacket packet { m_sequence_number, flags, payload_size ? ByteBuffer::copy(payload, payload_size) : ByteBuffer() };
+        m_sequence_number += packet.length();
+        m_not_acked_size += payload_size;
+        m_not_acked.append(move(packet));
+        send_outgoing_packets(false);
+        return;
+    }
+
+    send_segment(m_sequence_number, flags, (const u8*)payload, payload_size);
+}
+
+void TCPSocket::send_segment(u32 sequence_number, u16 flags, const u8* payload, size_t payload_size)
+{
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return;
+
+    u8 options[40];
+    size_t options_size = build_options(flags, options);
+    ASSERT(options_size % sizeof(u32) == 0);
+
+    // Build the segment right where the adapter will transmit it from.
+    auto& adapter = *routing_decision.adapter;
+    size_t segment_size = sizeof(TCPPacket) + options_size + payload_size;
+    auto buffer = adapter.create_packet_buffer(NetworkAdapter::ipv4_packet_headroom + segment_size, NetworkAdapter::ipv4_packet_headroom);
+    if (!buffer.has_value())
+        return;
+    buffer.value().set_size(segment_size);
+    memset(buffer.value().data(), 0, sizeof(TCPPacket));
+    auto& tcp_packet = *(TCPPacket*)(buffer.value().data());
     ASSERT(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(1024);
-    tcp_packet.set_sequence_number(m_sequence_number);
-    tcp_packet.set_data_offset(sizeof(TCPPacket) / sizeof(u32));
+    tcp_packet.set_window_size(advertised_window(flags & TCPFlags::SYN));
+    tcp_packet.set_sequence_number(sequence_number);
+    tcp_packet.set_data_offset((sizeof(TCPPacket) + options_size) / sizeof(u32));
     tcp_packet.set_flags(flags);
 
-    if (flags & TCPFlags::ACK)
+    if (flags & TCPFlags::ACK) {
         tcp_packet.set_ack_number(m_ack_number);
+        // Whatever ACK was pending is now piggy-backed on this segment.
+        m_segments_since_last_ack = 0;
+        m_delayed_ack_deadline_ms = 0;
+    }
 
-    if (flags & TCPFlags::SYN) {
-        ++m_sequence_number;
+    if (options_size)
+        memcpy(tcp_packet.options(), options, options_size);
+    if (payload_size)
+        memcpy(tcp_packet.payload(), payload, payload_size);
+    if (adapter.has_checksum_offload()) {
+        // The adapter sums up the segment itself; it only needs the pseudo header from us.
+        tcp_packet.set_checksum(compute_tcp_pseudo_header_checksum(local_address(), peer_address(), segment_size));
+        buffer.value().set_partial_checksum(TCPPacket::checksum_offset);
     } else {
-        m_sequence_number += payload_size;
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
     }
 
-    memcpy(tcp_packet.payload(), payload, payload_size);
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+#ifdef TCP_SOCKET_DEBUG
+    klog() << "sending tcp packet from " << local_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << " with (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << ") seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << tcp_packet.ack_number() << ", window=" << tcp_packet.window_size() << ", payload_size=" << payload_size;
+#endif
 
-    if (tcp_packet.has_syn() || payload_size > 0) {
-        LOCKER(m_not_acked_lock);
-        m_not_acked.append({ m_sequence_number, move(buffer) });
-        send_outgoing_packets();
-        return;
+    adapter.send_ipv4(
+        routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
+        buffer.release_value(), ttl());
+
+    m_packets_out++;
+    m_bytes_out += segment_size;
+}
+
+size_t TCPSocket::build_options(u16 flags, u8* options) const
+{
+    size_t size = 0;
+
+    if (flags & TCPFlags::SYN) {
+        u16 mss = local_mss();
+        options[size++] = TCPOptionKind::MSS;
+        options[size++] = 4;
+        options[size++] = mss >> 8;
+        options[size++] = mss & 0xff;
+
+        // A SYN-ACK may only carry the options that the peer offered in its SYN.
+        bool is_syn_ack = flags & TCPFlags::ACK;
+        if (!is_syn_ack || m_window_scaling_enabled) {
+            options[size++] = TCPOptionKind::NOP;
+            options[size++] = TCPOptionKind::WindowScale;
+            options[size++] = 3;
+            options[size++] = tcp_receive_window_scale;
+        }
+        if (!is_syn_ack || m_sack_enabled) {
+            options[size++] = TCPOptionKind::NOP;
+            options[size++] = TCPOptionKind::NOP;
+            options[size++] = TCPOptionKind::SACKPermitted;
+            options[size++] = 2;
+        }
+        return size;
     }
 
+    if (!m_sack_enabled || !(flags & TCPFlags::ACK))
+        return 0;
+
+    LOCKER(m_out_of_order_lock);
+    if (m_out_of_order_segments.is_empty())
+        return 0;
+
+    struct Block {
+        u32 left;
+        u32 right;
+    };
+    Vector<Block, 8> blocks;
+    for (auto& segment : m_out_of_order_segments) {
+        u32 right = segment.sequence_number + segment.payload.size();
+        if (!blocks.is_empty() && sequence_less_than_or_equal(segment.sequence_number, blocks.last().right)) {
+            if (sequence_less_than(blocks.last().right, right))
+                blocks.last().right = right;
+            continue;
+        }
+        blocks.append({ segment.sequence_number, right });
+    }
+
+    // The block containing the most recently received segment goes first (RFC 2018, section 4).
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (sequence_less_than_or_equal(blocks[i].left, m_last_out_of_order_sequence_number) && sequence_less_than(m_last_out_of_order_sequence_number, blocks[i].right)) {
+            swap(blocks[0], blocks[i]);
+            break;
+        }
+    }
+
+    auto append_u32 = [&](u32 value) {
+        options[size++] = value >> 24;
+        options[size++] = (value >> 16) & 0xff;
+        options[size++] = (value >> 8) & 0xff;
+        options[size++] = value & 0xff;
+    };
+
+    size_t block_count = min(blocks.size(), (size_t)4);
+    options[size++] = TCPOptionKind::NOP;
+    options[size++] = TCPOptionKind::NOP;
+    options[size++] = TCPOptionKind::SACK;
+    options[size++] = 2 + block_count * 8;
+    for (size_t i = 0; i < block_count; ++i) {
+        append_u32(blocks[i].left);
+        append_u32(blocks[i].right);
+    }
+    return size;
+}
+
+u16 TCPSocket::advertised_window(bool is_syn) const
+{
+    size_t space = receive_buffer_space();
+    // The window field of a SYN is never scaled (RFC 7323, section 2.2).
+    if (is_syn)
+        return min(space, (size_t)65535);
+    return min(space >> m_receive_window_scale, (size_t)65535);
+}
+
+u16 TCPSocket::local_mss() const
+{
     auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    ASSERT(!routing_decision.is_zero());
+    if (routing_decision.is_zero())
+        return tcp_default_mss;
+    return min(routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket), (size_t)65495);
+}
 
-    routing_decision.adapter->send_ipv4(
-        routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-        buffer, ttl());
+template<typename Callback>
+static void for_each_option(const TCPPacket& packet, Callback callback)
+{
+    auto* options = packet.options();
+    size_t options_size = packet.options_size();
+    for (size_t i = 0; i < options_size;) {
+        u8 kind = options[i];
+        if (kind == TCPOptionKind::End)
+            break;
+        if (kind == TCPOptionKind::NOP) {
+            ++i;
+            continue;
+        }
+        if (i + 1 >= options_size)
+            break;
+        u8 length = options[i + 1];
+        if (length < 2 || i + length > options_size)
+            break;
+        callback(kind, options + i + 2, length - 2);
+        i += length;
+    }
+}
 
-    m_packets_out++;
-    m_bytes_out += buffer.size();
+void TCPSocket::process_syn_options(const TCPPacket& packet)
+{
+    u16 peer_mss = tcp_default_mss;
+    bool peer_offered_window_scale = false;
+    u8 peer_window_scale = 0;
+    bool peer_offered_sack = false;
+
+    for_each_option(packet, [&](u8 kind, const u8* data, size_t length) {
+        switch (kind) {
+        case TCPOptionKind::MSS:
+            if (length == 2)
+                peer_mss = (data[0] << 8) | data[1];
+            break;
+        case TCPOptionKind::WindowScale:
+            if (length == 1) {
+                peer_offered_window_scale = true;
+                peer_window_scale = min(data[0], (u8)14);
+            }
+            break;
+        case TCPOptionKind::SACKPermitted:
+            peer_offered_sack = true;
+            break;
+        }
+    });
+
+    m_mss = max(min(peer_mss, local_mss()), (u16)64);
+    m_window_scaling_enabled = peer_offered_window_scale;
+    m_send_window_scale = peer_offered_window_scale ? peer_window_scale : 0;
+    m_receive_window_scale = peer_offered_window_scale ? tcp_receive_window_scale : 0;
+    m_sack_enabled = peer_offered_sack;
+    m_send_window = packet.window_size();
+    m_congestion_control->set_mss(m_mss);
+
+#ifdef TCP_SOCKET_DEBUG
+    dbg() << "TCPSocket{" << this << "} negotiated mss=" << m_mss << ", window_scale=" << m_send_window_scale << "/" << m_receive_window_scale << ", sack=" << m_sack_enabled;
+#endif
 }
 
 void TCPSocket::send_outgoing_packets()
 {
-    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    ASSERT(!routing_decision.is_zero());
+    send_outgoing_packets(false);
+}
 
-    auto now = kgettimeofday();
+size_t TCPSocket::bytes_in_flight() const
+{
+    // This is the "pipe" of RFC 6675: transmitted data that hasn't been SACKed or deemed lost.
+    size_t in_flight = 0;
+    for (auto& packet : m_not_acked) {
+        if (packet.tx_counter && !packet.sacked && !packet.lost)
+            in_flight += packet.length();
+    }
+    // Without SACK, each duplicate ACK means that some segment has left the network.
+    if (!m_sack_enabled && m_in_recovery)
+        in_flight -= min(in_flight, m_duplicate_ack_count * m_mss);
+    return in_flight;
+}
+
+void TCPSocket::transmit_packet(OutgoingPacket& packet, u64 now)
+{
+    packet.tx_counter++;
+    packet.tx_time_ms = now;
+    packet.lost = false;
+    send_segment(packet.sequence_number, packet.flags, packet.payload.data(), packet.payload.size());
+    if (!m_retransmission_deadline_ms)
+        m_retransmission_deadline_ms = now + m_retransmission_timeout_ms;
+}
+
+void TCPSocket::send_outgoing_packets(bool allow_window_probe)
+{
+    LOCKER(m_not_acked_lock);
+    if (m_not_acked.is_empty())
+        return;
 
-    LOCKER(m_not_acked_lock, Lock::Mode::Shared);
+    auto now = current_time_ms();
+    size_t congestion_window = m_congestion_control->congestion_window();
+    size_t in_flight = bytes_in_flight();
+
+    // Retransmit whatever has been deemed lost before sending new data.
     for (auto& packet : m_not_acked) {
-        timeval diff;
-        timeval_sub(packet.tx_time, now, diff);
-        if (diff.tv_sec == 0 && diff.tv_usec <= 500000)
+        if (in_flight >= congestion_window)
+            break;
+        if (!packet.lost || packet.sacked)
             continue;
-        packet.tx_time = now;
-        packet.tx_counter++;
+        transmit_packet(packet, now);
+        in_flight += packet.length();
+    }
 
-#ifdef TCP_SOCKET_DEBUG
-        auto& tcp_packet = *(TCPPacket*)(packet.buffer.data());
-        klog() << "sending tcp packet from " << local_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << " with (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << ") seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << tcp_packet.ack_number() << ", tx_counter=" << packet.tx_counter;
-#endif
-        routing_decision.adapter->send_ipv4(
-            routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-            packet.buffer, ttl());
+    for (auto& packet : m_not_acked) {
+        if (packet.tx_counter)
+            continue;
+        if (in_flight && in_flight + packet.length() > congestion_window)
+            break;
+        // Nagle's algorithm (RFC 896): hold back a small segment while earlier data is unacknowledged,
+        // so that it can grow with subsequent writes.
+        if (!m_no_delay && packet.payload.size() < m_mss && !(packet.flags & (TCPFlags::SYN | TCPFlags::FIN)) && m_send_unacknowledged != packet.sequence_number)
+            break;
+        u32 window_end_offset = packet.end_sequence_number() - m_send_unacknowledged;
+        if (window_end_offset > m_send_window) {
+            // The peer's window is closed. Once nothing is left in flight, the retransmission
+            // timer sends a single segment as a window probe.
+            if (allow_window_probe && !in_flight)
+                transmit_packet(packet, now);
+            break;
+        }
+        transmit_packet(packet, now);
+        in_flight += packet.length();
+    }
+
+    if (!m_retransmission_deadline_ms)
+        m_retransmission_deadline_ms = now + m_retransmission_timeout_ms;
+}
 
-        m_packets_out++;
-        m_bytes_out += packet.buffer.size();
+void TCPSocket::update_rtt(u32 rtt_ms)
+{
+    // RFC 6298, section 2.
+    if (!m_smoothed_rtt_ms && !m_rtt_variance_ms) {
+        m_smoothed_rtt_ms = rtt_ms;
+        m_rtt_variance_ms = rtt_ms / 2;
+    } else {
+        u32 delta = m_smoothed_rtt_ms > rtt_ms ? m_smoothed_rtt_ms - rtt_ms : rtt_ms - m_smoothed_rtt_ms;
+        m_rtt_variance_ms = (3 * m_rtt_variance_ms + delta) / 4;
+        m_smoothed_rtt_ms = (7 * m_smoothed_rtt_ms + rtt_ms) / 8;
     }
+    m_retransmission_timeout_ms = clamp(m_smoothed_rtt_ms + max(4 * m_rtt_variance_ms, 1u), tcp_min_rto_ms, tcp_max_rto_ms);
 }
 
-void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
+void TCPSocket::restart_retransmission_timer(u64 now)
+{
+    for (auto& packet : m_not_acked) {
+        if (packet.tx_counter) {
+            m_retransmission_deadline_ms = now + m_retransmission_timeout_ms;
+            return;
+        }
+    }
+    m_retransmission_deadline_ms = 0;
+}
+
+void TCPSocket::process_sack_blocks(const TCPPacket& tcp_packet)
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    for_each_option(tcp_packet, [&](u8 kind, const u8* data, size_t length) {
+        if (kind != TCPOptionKind::SACK || length % 8)
+            return;
+        for (size_t offset = 0; offset < length; offset += 8) {
+            auto* edges = data + offset;
+            u32 left = (edges[0] << 24) | (edges[1] << 16) | (edges[2] << 8) | edges[3];
+            u32 right = (edges[4] << 24) | (edges[5] << 16) | (edges[6] << 8) | edges[7];
+            for (auto& packet : m_not_acked) {
+                if (sequence_less_than_or_equal(left, packet.sequence_number) && sequence_less_than_or_equal(packet.end_sequence_number(), right)) {
+                    packet.sacked = true;
+                    packet.lost = false;
+                }
+            }
+        }
+    });
+}
+
+void TCPSocket::detect_lost_packets()
+{
+    // A segment is considered lost once DupThresh segments above it have been SACKed (RFC 6675, section 4).
+    // Segments that were already retransmitted are left to the retransmission timer.
+    size_t sacked_above = 0;
+    for (auto& packet : m_not_acked) {
+        if (packet.sacked)
+            ++sacked_above;
+    }
+    for (auto& packet : m_not_acked) {
+        if (!sacked_above)
+            break;
+        if (packet.sacked) {
+            --sacked_above;
+            continue;
+        }
+        if (packet.tx_counter == 1 && sacked_above >= tcp_duplicate_ack_threshold)
+            packet.lost = true;
+    }
+}
+
+void TCPSocket::retransmit_first_unacked(u64 now)
+{
+    for (auto& packet : m_not_acked) {
+        if (packet.sacked || !packet.tx_counter)
+            continue;
+        transmit_packet(packet, now);
+        return;
+    }
+}
+
+void TCPSocket::process_ack(const TCPPacket& tcp_packet, u16 payload_size)
+{
+    LOCKER(m_not_acked_lock);
+
+    u32 ack_number = tcp_packet.ack_number();
+    if (sequence_less_than(m_sequence_number, ack_number) || sequence_less_than(ack_number, m_send_unacknowledged))
+        return;
+
+    auto now = current_time_ms();
+    size_t window = tcp_packet.has_syn() ? tcp_packet.window_size() : (size_t)tcp_packet.window_size() << m_send_window_scale;
+
+    if (m_sack_enabled)
+        process_sack_blocks(tcp_packet);
+
+    if (ack_number == m_send_unacknowledged) {
+        // RFC 5681, section 2: only a pure ACK with an unchanged window counts as a duplicate.
+        bool is_duplicate = !m_not_acked.is_empty() && !payload_size && !tcp_packet.has_syn() && !tcp_packet.has_fin() && window == m_send_window;
+        m_send_window = window;
+        if (is_duplicate) {
+            ++m_duplicate_ack_count;
+            if (m_sack_enabled)
+                detect_lost_packets();
+            if (!m_in_recovery && sequence_less_than_or_equal(m_recovery_point, ack_number)) {
+                bool sack_detected_loss = false;
+                for (auto& packet : m_not_acked) {
+                    if (packet.lost) {
+                        sack_detected_loss = true;
+                        break;
+                    }
+                }
+                if (m_duplicate_ack_count >= tcp_duplicate_ack_threshold || sack_detected_loss) {
+                    // Fast retransmit (RFC 5681, section 3.2).
+                    m_congestion_control->on_congestion_event(bytes_in_flight(), now);
+                    m_in_recovery = true;
+                    m_recovery_point = m_sequence_number;
+                    retransmit_first_unacked(now);
+                }
+            }
+        }
+        send_outgoing_packets(false);
+        return;
+    }
+
+    size_t in_flight_before = bytes_in_flight();
+    size_t bytes_acked = ack_number - m_send_unacknowledged;
+    Optional<u32> rtt_sample;
+    int removed = 0;
+    while (!m_not_acked.is_empty()) {
+        auto& packet = m_not_acked.first();
+        if (!sequence_less_than_or_equal(packet.end_sequence_number(), ack_number))
+            break;
+        // Karn's algorithm: retransmitted segments give ambiguous samples.
+        if (packet.tx_counter == 1)
+            rtt_sample = now - packet.tx_time_ms;
+        m_not_acked_size -= packet.payload.size();
+        m_not_acked.take_first();
+        removed++;
+    }
 
 #ifdef TCP_SOCKET_DEBUG
-        dbg() << "TCPSocket: receive_tcp_packet: " << ack_number;
+    dbg() << "TCPSocket: receive_tcp_packet acknowledged " << removed << " packets";
 #endif
 
-        int removed = 0;
-        LOCKER(m_not_acked_lock);
-        while (!m_not_acked.is_empty()) {
-            auto& packet = m_not_acked.first();
+    m_send_unacknowledged = ack_number;
+    m_send_window = window;
+    if (rtt_sample.has_value())
+        update_rtt(rtt_sample.value());
+
+    if (m_in_recovery) {
+        if (sequence_less_than_or_equal(m_recovery_point, ack_number)) {
+            m_in_recovery = false;
+        } else {
+            // A partial ACK means the next hole was lost as well (RFC 6582, section 3.2).
+            retransmit_first_unacked(now);
+            if (m_sack_enabled)
+                detect_lost_packets();
+        }
+    } else if (in_flight_before + m_mss >= m_congestion_control->congestion_window()) {
+        // Only grow the window while it's actually limiting us.
+        m_congestion_control->on_ack(bytes_acked, now, rtt_sample.value_or(0));
+    }
+
+    m_duplicate_ack_count = 0;
+    restart_retransmission_timer(now);
+    send_outgoing_packets(false);
+}
+
+void TCPSocket::handle_retransmission_timeout(u64 now)
+{
+    LOCKER(m_not_acked_lock);
+    m_retransmission_deadline_ms = 0;
+    if (m_not_acked.is_empty())
+        return;
+
+    bool has_packets_in_flight = false;
+    for (auto& packet : m_not_acked) {
+        if (packet.tx_counter) {
+            has_packets_in_flight = true;
+            break;
+        }
+    }
+
+    m_retransmission_timeout_ms = min(m_retransmission_timeout_ms * 2, tcp_max_rto_ms);
+
+    if (!has_packets_in_flight) {
+        send_outgoing_packets(true);
+        return;
+    }
 
 #ifdef TCP_SOCKET_DEBUG
-            dbg() << "TCPSocket: iterate: " << packet.ack_number;
+    dbg() << "TCPSocket{" << this << "} retransmission timeout, rto is now " << m_retransmission_timeout_ms << "ms";
 #endif
 
-            if (packet.ack_number <= ack_number) {
-                m_not_acked.take_first();
-                removed++;
-            } else {
-                break;
-            }
-        }
+    m_congestion_control->on_retransmission_timeout(bytes_in_flight(), now);
+    m_in_recovery = false;
+    m_recovery_point = m_sequence_number;
+    m_duplicate_ack_count = 0;
 
+    // The receiver may have reneged on what it SACKed, so start over from the left edge (RFC 2018, section 8).
+    for (auto& packet : m_not_acked) {
+        packet.sacked = false;
+        if (packet.tx_counter)
+            packet.lost = true;
+    }
+
+    send_outgoing_packets(false);
+}
+
+void TCPSocket::handle_timers()
+{
+    // The NetworkTask calls this for every packet it processes; no timer needs finer granularity than this.
+    static u64 s_last_run_ms;
+    auto now = current_time_ms();
+    if (now - s_last_run_ms < 10)
+        return;
+    s_last_run_ms = now;
+
+    connections().for_each([&](TCPSocket& socket) {
+        if (socket.m_delayed_ack_deadline_ms && now >= socket.m_delayed_ack_deadline_ms)
+            socket.send_tcp_packet(TCPFlags::ACK);
+        if (socket.m_retransmission_deadline_ms && now >= socket.m_retransmission_deadline_ms)
+            socket.handle_retransmission_timeout(now);
+    });
+}
+
+void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
+{
+    if (packet.has_syn() && m_state == State::SynSent)
+        process_syn_options(packet);
+
+    if (packet.has_ack() && m_state != State::Listen) {
 #ifdef TCP_SOCKET_DEBUG
-        dbg() << "TCPSocket: receive_tcp_packet acknowledged " << removed << " packets";
+        dbg() << "TCPSocket: receive_tcp_packet: " << packet.ack_number();
 #endif
+        process_ack(packet, size - packet.header_size());
     }
 
     m_packets_in++;
     m_bytes_in += packet.header_size() + size;
 }
 
-NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+bool TCPSocket::deliver_data(PacketBuffer&& data)
+{
+    return did_receive(peer_address(), peer_port(), move(data));
+}
+
+bool TCPSocket::receive_segment_data(const TCPPacket& packet, const PacketBuffer& segment_payload)
+{
+    LOCKER(m_out_of_order_lock);
+
+    u32 sequence_number = packet.sequence_number();
+    size_t payload_size = segment_payload.size();
+    size_t offset = 0;
+    size_t size = payload_size;
+
+    // Trim anything we've already received from the front of the segment.
+    if (size && sequence_less_than(sequence_number, m_ack_number)) {
+        size_t overlap = min((size_t)(m_ack_number - sequence_number), size);
+        offset += overlap;
+        size -= overlap;
+        sequence_number += overlap;
+    }
+
+    bool in_order = sequence_number == m_ack_number;
+
+    if (!size) {
+        if (!in_order || (payload_size && !packet.has_fin()))
+            send_tcp_packet(TCPFlags::ACK);
+        return in_order;
+    }
+
+    if (!in_order) {
+        // Hold on to segments that arrive ahead of a hole, as long as they're inside our window.
+        size_t window_offset = sequence_number - m_ack_number;
+        if (window_offset + size <= receive_buffer_space() && m_out_of_order_size + size <= receive_buffer_space()) {
+            size_t index = 0;
+            while (index < m_out_of_order_segments.size() && sequence_less_than(m_out_of_order_segments[index].sequence_number, sequence_number))
+                ++index;
+            if (index == m_out_of_order_segments.size() || m_out_of_order_segments[index].sequence_number != sequence_number) {
+                // This keeps the whole received frame alive, but saves copying the payload out of it.
+                m_out_of_order_segments.insert(index, { sequence_number, segment_payload.slice(offset, size) });
+                m_out_of_order_size += size;
+            }
+            m_last_out_of_order_sequence_number = sequence_number;
+        }
+        send_tcp_packet(TCPFlags::ACK);
+        return false;
+    }
+
+    if (!deliver_data(segment_payload.slice(offset, size))) {
+        // The receive buffer is full; the peer will retransmit once we advertise room again.
+        send_tcp_packet(TCPFlags::ACK);
+        return false;
+    }
+    m_ack_number += size;
+
+    bool filled_hole = !m_out_of_order_segments.is_empty();
+    while (!m_out_of_order_segments.is_empty()) {
+        auto& segment = m_out_of_order_segments.first();
+        if (sequence_less_than(m_ack_number, segment.sequence_number))
+            break;
+        size_t overlap = m_ack_number - segment.sequence_number;
+        if (overlap < segment.payload.size()) {
+            if (!deliver_data(segment.payload.slice(overlap, segment.payload.size() - overlap)))
+                break;
+            m_ack_number += segment.payload.size() - overlap;
+        }
+        m_out_of_order_size -= segment.payload.size();
+        m_out_of_order_segments.remove(0);
+    }
+
+    // If the segment carries a FIN, the caller acknowledges both together.
+    if (packet.has_fin())
+        return true;
+
+    // Filling a hole is acknowledged right away so that the sender can leave recovery (RFC 5681, section 4.2).
+    if (filled_hole)
+        send_tcp_packet(TCPFlags::ACK);
+    else
+        schedule_delayed_ack();
+    return true;
+}
+
+void TCPSocket::schedule_delayed_ack()
+{
+    // Acknowledge at least every second segment, and no later than the delayed ACK timeout (RFC 1122, section 4.2.3.2).
+    if (++m_segments_since_last_ack >= 2) {
+        send_tcp_packet(TCPFlags::ACK);
+        return;
+    }
+    if (!m_delayed_ack_deadline_ms)
+        m_delayed_ack_deadline_ms = current_time_ms() + tcp_delayed_ack_timeout_ms;
+}
+
+u16 TCPSocket::compute_tcp_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, u16 tcp_length)
 {
     struct [[gnu::packed]] PseudoHeader
     {
@@ -299,7 +874,7 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         NetworkOrdered<u16> payload_size;
     };
 
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size };
+    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, tcp_length };
 
     u32 checksum = 0;
     auto* w = (const NetworkOrdered<u16>*)&pseudo_header;
@@ -308,13 +883,18 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
-    w = (const NetworkOrdered<u16>*)&packet;
-    for (size_t i = 0; i < sizeof(packet) / sizeof(u16); ++i) {
+    return checksum;
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+{
+    u32 checksum = compute_tcp_pseudo_header_checksum(source, destination, packet.header_size() + payload_size);
+    auto* w = (const NetworkOrdered<u16>*)&packet;
+    for (size_t i = 0; i < packet.header_size() / sizeof(u16); ++i) {
         checksum += w[i];
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
-    ASSERT(packet.data_offset() * 4 == sizeof(TCPPacket));
     w = (const NetworkOrdered<u16>*)packet.payload();
     for (size_t i = 0; i < payload_size / sizeof(u16); ++i) {
         checksum += w[i];
@@ -330,6 +910,74 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
     return ~(checksum & 0xffff);
 }
 
+KResult TCPSocket::setsockopt(int level, int option, Userspace<const void*> user_value, socklen_t user_value_size)
+{
+    if (level != IPPROTO_TCP)
+        return IPv4Socket::setsockopt(level, option, user_value, user_value_size);
+
+    switch (option) {
+    case TCP_NODELAY: {
+        if (user_value_size < sizeof(int))
+            return KResult(-EINVAL);
+        int value;
+        if (!Process::current()->validate_read_and_copy_typed(&value, static_ptr_cast<const int*>(user_value)))
+            return KResult(-EFAULT);
+        m_no_delay = value != 0;
+        if (m_no_delay)
+            send_outgoing_packets(false);
+        return KSuccess;
+    }
+    case TCP_CONGESTION: {
+        if (user_value_size == 0 || user_value_size > 16)
+            return KResult(-EINVAL);
+        auto name = Process::current()->validate_and_copy_string_from_user(static_ptr_cast<const char*>(user_value), user_value_size);
+        if (name.is_null())
+            return KResult(-EFAULT);
+        LOCKER(m_not_acked_lock);
+        auto congestion_control = TCPCongestionControl::create(name, m_mss);
+        if (!congestion_control)
+            return KResult(-ENOENT);
+        m_congestion_control = move(congestion_control);
+        return KSuccess;
+    }
+    default:
+        return KResult(-ENOPROTOOPT);
+    }
+}
+
+KResult TCPSocket::getsockopt(FileDescription& description, int level, int option, Userspace<void*> value, Userspace<socklen_t*> value_size)
+{
+    if (level != IPPROTO_TCP)
+        return IPv4Socket::getsockopt(description, level, option, value, value_size);
+
+    socklen_t size;
+    if (!Process::current()->validate_read_and_copy_typed(&size, value_size))
+        return KResult(-EFAULT);
+
+    switch (option) {
+    case TCP_NODELAY: {
+        if (size < sizeof(int))
+            return KResult(-EINVAL);
+        int no_delay = m_no_delay;
+        copy_to_user(static_ptr_cast<int*>(value), &no_delay);
+        size = sizeof(int);
+        copy_to_user(value_size, &size);
+        return KSuccess;
+    }
+    case TCP_CONGESTION: {
+        auto* name = m_congestion_control->name();
+        socklen_t length = strlen(name) + 1;
+        if (size < length)
+            return KResult(-EINVAL);
+        copy_to_user(static_ptr_cast<char*>(value), name, length);
+        copy_to_user(value_size, &length);
+        return KSuccess;
+    }
+    default:
+        return KResult(-ENOPROTOOPT);
+    }
+}
+
 KResult TCPSocket::protocol_bind()
 {
     if (has_specific_local_address() && !m_adapter) {
@@ -343,10 +991,8 @@ KResult TCPSocket::protocol_bind()
 
 KResult TCPSocket::protocol_listen()
 {
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple()))
+    if (!listeners().try_add(tuple(), *this))
         return KResult(-EADDRINUSE);
-    sockets_by_tuple().resource().set(tuple(), this);
     set_direction(Direction::Passive);
     set_state(State::Listen);
     set_setup_state(SetupState::Completed);
@@ -363,7 +1009,7 @@ KResult TCPSocket::protocol_connect(FileDescription& description, ShouldBlock sh
 
     allocate_local_port_if_needed();
 
-    m_sequence_number = get_good_random<u32>();
+    set_sequence_number(get_good_random<u32>());
     m_ack_number = 0;
 
     set_setup_state(SetupState::InProgress);
@@ -393,14 +1039,10 @@ int TCPSocket::protocol_allocate_local_port()
     static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    LOCKER(sockets_by_tuple().lock());
     for (u16 port = first_scan_port;;) {
         IPv4SocketTuple proposed_tuple(local_address(), port, peer_address(), peer_port());
-
-        auto it = sockets_by_tuple().resource().find(proposed_tuple);
-        if (it == sockets_by_tuple().resource().end()) {
+        if (connections().try_add(proposed_tuple, *this)) {
             set_local_port(port);
-            sockets_by_tuple().resource().set(proposed_tuple, this);
             return port;
         }
         ++port;
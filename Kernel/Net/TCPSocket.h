@@ -29,8 +29,12 @@
 #include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedList.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/SocketTable.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/TCPCongestionControl.h>
 
 namespace Kernel {
 
@@ -141,7 +145,12 @@ public:
     void set_error(Error error) { m_error = error; }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
-    void set_sequence_number(u32 n) { m_sequence_number = n; }
+    void set_sequence_number(u32 n)
+    {
+        m_sequence_number = n;
+        m_send_unacknowledged = n;
+        m_recovery_point = n;
+    }
     u32 ack_number() const { return m_ack_number; }
     u32 sequence_number() const { return m_sequence_number; }
     u32 packets_in() const { return m_packets_in; }
@@ -149,11 +158,31 @@ public:
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
 
+    u32 smoothed_rtt_ms() const { return m_smoothed_rtt_ms; }
+    u32 retransmission_timeout_ms() const { return m_retransmission_timeout_ms; }
+    size_t congestion_window() const { return m_congestion_control->congestion_window(); }
+    size_t send_window() const { return m_send_window; }
+    const char* congestion_control_name() const { return m_congestion_control->name(); }
+
     void send_tcp_packet(u16 flags, const void* = nullptr, size_t = 0);
     void send_outgoing_packets();
     void receive_tcp_packet(const TCPPacket&, u16 size);
 
-    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
+    // Parses the MSS, window scale and SACK-permitted options of a SYN from the peer.
+    void process_syn_options(const TCPPacket&);
+
+    // Delivers the payload of a segment in sequence order and acknowledges it.
+    // Returns true if the segment ended exactly at the next expected sequence number,
+    // which is when a FIN it carries can be processed.
+    bool receive_segment_data(const TCPPacket&, const PacketBuffer& payload);
+
+    // Called periodically by the NetworkTask to fire retransmission timers.
+    static void handle_timers();
+
+    // Connected and connecting sockets, keyed by their full tuple.
+    static SocketTable<IPv4SocketTuple, TCPSocket>& connections();
+    // Listening sockets, keyed by local address and port with an unspecified peer.
+    static SocketTable<IPv4SocketTuple, TCPSocket>& listeners();
     static RefPtr<TCPSocket> from_tuple(const IPv4SocketTuple& tuple);
     static RefPtr<TCPSocket> from_endpoints(const IPv4Address& local_address, u16 local_port, const IPv4Address& peer_address, u16 peer_port);
 
@@ -166,6 +195,9 @@ public:
     void release_for_accept(RefPtr<TCPSocket>);
 
     virtual KResult close() override;
+    virtual bool can_write(const FileDescription&, size_t) const override;
+    virtual KResult setsockopt(int level, int option, Userspace<const void*>, socklen_t) override;
+    virtual KResult getsockopt(FileDescription&, int level, int option, Userspace<void*>, Userspace<socklen_t*>) override;
 
 protected:
     void set_direction(Direction direction) { m_direction = direction; }
@@ -175,10 +207,42 @@ private:
     virtual const char* class_name() const override { return "TCPSocket"; }
 
     static NetworkOrdered<u16> compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket&, u16 payload_size);
+    static u16 compute_tcp_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, u16 tcp_length);
+
+    struct OutgoingPacket {
+        u32 sequence_number { 0 };
+        u16 flags { 0 };
+        ByteBuffer payload;
+        int tx_counter { 0 };
+        u64 tx_time_ms { 0 };
+        bool sacked { false };
+        bool lost { false };
+
+        // SYN and FIN each occupy one sequence number.
+        u32 length() const { return payload.size() + ((flags & TCPFlags::SYN) ? 1 : 0) + ((flags & TCPFlags::FIN) ? 1 : 0); }
+        u32 end_sequence_number() const { return sequence_number + length(); }
+    };
+
+    void send_segment(u32 sequence_number, u16 flags, const u8* payload, size_t payload_size);
+    size_t build_options(u16 flags, u8* options) const;
+    u16 advertised_window(bool is_syn) const;
+    u16 local_mss() const;
+
+    void transmit_packet(OutgoingPacket&, u64 now_ms);
+    void send_outgoing_packets(bool allow_window_probe);
+    size_t bytes_in_flight() const;
+    void process_ack(const TCPPacket&, u16 payload_size);
+    void process_sack_blocks(const TCPPacket&);
+    void update_rtt(u32 rtt_ms);
+    void detect_lost_packets();
+    void retransmit_first_unacked(u64 now_ms);
+    void restart_retransmission_timer(u64 now_ms);
+    void handle_retransmission_timeout(u64 now_ms);
+    bool deliver_data(PacketBuffer&&);
+    void schedule_delayed_ack();
 
     virtual void shut_down_for_writing() override;
 
-    virtual KResultOr<size_t> protocol_receive(const KBuffer&, void* buffer, size_t buffer_size, int flags) override;
     virtual KResultOr<size_t> protocol_send(const void*, size_t) override;
     virtual KResult protocol_connect(FileDescription&, ShouldBlock) override;
     virtual int protocol_allocate_local_port() override;
@@ -191,23 +255,55 @@ private:
     Direction m_direction { Direction::Unspecified };
     Error m_error { Error::None };
     RefPtr<NetworkAdapter> m_adapter;
+
+    // SND.NXT, SND.UNA and RCV.NXT in RFC 793 terms.
     u32 m_sequence_number { 0 };
+    u32 m_send_unacknowledged { 0 };
     u32 m_ack_number { 0 };
+
+    // The peer's receive window, already scaled.
+    size_t m_send_window { 65535 };
+    u8 m_send_window_scale { 0 };
+    u8 m_receive_window_scale { 0 };
+    bool m_window_scaling_enabled { false };
+    bool m_sack_enabled { false };
+    size_t m_mss { 536 };
+
+    OwnPtr<TCPCongestionControl> m_congestion_control;
+
+    // RFC 6298 round-trip time estimation.
+    u32 m_smoothed_rtt_ms { 0 };
+    u32 m_rtt_variance_ms { 0 };
+    u32 m_retransmission_timeout_ms { 1000 };
+    u64 m_retransmission_deadline_ms { 0 };
+
+    u32 m_segments_since_last_ack { 0 };
+    u64 m_delayed_ack_deadline_ms { 0 };
+    bool m_no_delay { false };
+
+    u32 m_duplicate_ack_count { 0 };
+    bool m_in_recovery { false };
+    u32 m_recovery_point { 0 };
+
     State m_state { State::Closed };
     u32 m_packets_in { 0 };
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
 
-    struct OutgoingPacket {
-        u32 ack_number { 0 };
-        ByteBuffer buffer;
-        int tx_counter { 0 };
-        timeval tx_time { 0, 0 };
-    };
-
     Lock m_not_acked_lock { "TCPSocket unacked packets" };
     SinglyLinkedList<OutgoingPacket> m_not_acked;
+    size_t m_not_acked_size { 0 };
+
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        PacketBuffer payload;
+    };
+
+    mutable Lock m_out_of_order_lock { "TCPSocket out-of-order segments" };
+    Vector<OutOfOrderSegment> m_out_of_order_segments;
+    size_t m_out_of_order_size { 0 };
+    u32 m_last_out_of_order_sequence_number { 0 };
 };
 
 }
@@ -36,30 +36,22 @@ namespace Kernel {
 
 void UDPSocket::for_each(Function<void(const UDPSocket&)> callback)
 {
-    LOCKER(sockets_by_port().lock(), Lock::Mode::Shared);
-    for (auto it : sockets_by_port().resource())
-        callback(*it.value);
+    sockets_by_port().for_each([&](auto& socket) { callback(socket); });
 }
 
-Lockable<HashMap<u16, UDPSocket*>>& UDPSocket::sockets_by_port()
+SocketTable<u16, UDPSocket>& UDPSocket::sockets_by_port()
 {
-    static Lockable<HashMap<u16, UDPSocket*>>* s_map;
-    if (!s_map)
-        s_map = new Lockable<HashMap<u16, UDPSocket*>>;
-    return *s_map;
+    static SocketTable<u16, UDPSocket>* s_table;
+    if (!s_table)
+        s_table = new SocketTable<u16, UDPSocket>;
+    return *s_table;
 }
 
 SocketHandle<UDPSocket> UDPSocket::from_port(u16 port)
 {
-    RefPtr<UDPSocket> socket;
-    {
-        LOCKER(sockets_by_port().lock(), Lock::Mode::Shared);
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end())
-            return {};
-        socket = (*it).value;
-        ASSERT(socket);
-    }
+    auto socket = sockets_by_port().get(port);
+    if (!socket)
+        return {};
     return { *socket };
 }
 
@@ -70,8 +62,7 @@ UDPSocket::UDPSocket(int protocol)
 
 UDPSocket::~UDPSocket()
 {
-    LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(local_port());
+    sockets_by_port().remove(local_port(), *this);
 }
 
 NonnullRefPtr<UDPSocket> UDPSocket::create(int protocol)
@@ -79,7 +70,7 @@ NonnullRefPtr<UDPSocket> UDPSocket::create(int protocol)
     return adopt(*new UDPSocket(protocol));
 }
 
-KResultOr<size_t> UDPSocket::protocol_receive(const KBuffer& packet_buffer, void* buffer, size_t buffer_size, int flags)
+KResultOr<size_t> UDPSocket::protocol_receive(ReadonlyBytes packet_buffer, void* buffer, size_t buffer_size, int flags)
 {
     (void)flags;
     auto& ipv4_packet = *(const IPv4Packet*)(packet_buffer.data());
@@ -95,14 +86,20 @@ KResultOr<size_t> UDPSocket::protocol_send(const void* data, size_t data_length)
     auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
     if (routing_decision.is_zero())
         return KResult(-EHOSTUNREACH);
-    auto buffer = ByteBuffer::create_zeroed(sizeof(UDPPacket) + data_length);
-    auto& udp_packet = *(UDPPacket*)(buffer.data());
+    auto& adapter = *routing_decision.adapter;
+    size_t udp_packet_size = sizeof(UDPPacket) + data_length;
+    auto buffer = adapter.create_packet_buffer(NetworkAdapter::ipv4_packet_headroom + udp_packet_size, NetworkAdapter::ipv4_packet_headroom);
+    if (!buffer.has_value())
+        return KResult(-ENOMEM);
+    buffer.value().set_size(udp_packet_size);
+    memset(buffer.value().data(), 0, sizeof(UDPPacket));
+    auto& udp_packet = *(UDPPacket*)(buffer.value().data());
     udp_packet.set_source_port(local_port());
     udp_packet.set_destination_port(peer_port());
     udp_packet.set_length(sizeof(UDPPacket) + data_length);
     memcpy(udp_packet.payload(), data, data_length);
     klog() << "sending as udp packet from " << routing_decision.adapter->ipv4_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << "!";
-    routing_decision.adapter->send_ipv4(routing_decision.next_hop, peer_address(), IPv4Protocol::UDP, buffer, ttl());
+    adapter.send_ipv4(routing_decision.next_hop, peer_address(), IPv4Protocol::UDP, buffer.release_value(), ttl());
     return data_length;
 }
 
@@ -120,12 +117,9 @@ int UDPSocket::protocol_allocate_local_port()
     static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    LOCKER(sockets_by_port().lock());
     for (u16 port = first_scan_port;;) {
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end()) {
+        if (sockets_by_port().try_add(port, *this)) {
             set_local_port(port);
-            sockets_by_port().resource().set(port, this);
             return port;
         }
         ++port;
@@ -139,10 +133,8 @@ int UDPSocket::protocol_allocate_local_port()
 
 KResult UDPSocket::protocol_bind()
 {
-    LOCKER(sockets_by_port().lock());
-    if (sockets_by_port().resource().contains(local_port()))
+    if (!sockets_by_port().try_add(local_port(), *this))
         return KResult(-EADDRINUSE);
-    sockets_by_port().resource().set(local_port(), this);
     return KSuccess;
 }
 
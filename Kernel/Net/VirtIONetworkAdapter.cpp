@@ -0,0 +1,464 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/MACAddress.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/IO.h>
+#include <Kernel/Net/VirtIONetworkAdapter.h>
+#include <Kernel/Random.h>
+#include <Kernel/Thread.h>
+
+//#define VIRTIO_NET_DEBUG
+
+namespace Kernel {
+
+#define VIRTIO_NET_DEVICE_ID 0x1000
+
+#define VIRTIO_NET_F_CSUM (1u << 0)
+#define VIRTIO_NET_F_GUEST_CSUM (1u << 1)
+#define VIRTIO_NET_F_MAC (1u << 5)
+#define VIRTIO_NET_F_MRG_RXBUF (1u << 15)
+#define VIRTIO_NET_F_STATUS (1u << 16)
+#define VIRTIO_NET_F_CTRL_VQ (1u << 17)
+#define VIRTIO_NET_F_MQ (1u << 22)
+
+#define VIRTIO_NET_S_LINK_UP 1
+
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM 1
+#define VIRTIO_NET_HDR_GSO_NONE 0
+
+#define VIRTIO_NET_CTRL_MQ 4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET 0
+#define VIRTIO_NET_OK 0
+
+// Offsets into the device-specific configuration.
+#define CONFIG_MAC 0
+#define CONFIG_STATUS 6
+#define CONFIG_MAX_QUEUE_PAIRS 8
+
+struct [[gnu::packed]] VirtIONetHeader
+{
+    u8 flags;
+    u8 gso_type;
+    u16 header_length;
+    u16 gso_size;
+    u16 checksum_start;
+    u16 checksum_offset;
+    // Only present with VIRTIO_NET_F_MRG_RXBUF.
+    u16 buffer_count;
+};
+
+static constexpr size_t max_queue_pairs = 8;
+static constexpr size_t max_receive_buffers_per_queue = 128;
+
+void VirtIONetworkAdapter::detect()
+{
+    PCI::enumerate([&](const PCI::Address& address, PCI::ID id) {
+        if (address.is_null())
+            return;
+        if (id.vendor_id != VIRTIO_PCI_VENDOR_ID || id.device_id != VIRTIO_NET_DEVICE_ID)
+            return;
+        (void)adopt(*new VirtIONetworkAdapter(address)).leak_ref();
+    });
+}
+
+VirtIONetworkAdapter::VirtIONetworkAdapter(PCI::Address address)
+    : VirtIODevice(address, "VirtIONetworkAdapter")
+{
+    set_interface_name("vio");
+
+    if (!initialize()) {
+        klog() << "VirtIONetworkAdapter: Initialization failed";
+        fail_initialization();
+        return;
+    }
+
+    const auto& mac = mac_address();
+    klog() << "VirtIONetworkAdapter: MAC address: " << String::format("%b", mac[0]) << ":" << String::format("%b", mac[1]) << ":" << String::format("%b", mac[2]) << ":" << String::format("%b", mac[3]) << ":" << String::format("%b", mac[4]) << ":" << String::format("%b", mac[5]);
+    klog() << "VirtIONetworkAdapter: " << m_queue_pairs.size() << " queue pair(s), checksum offload: " << m_checksum_offload << ", mergeable receive buffers: " << m_mergeable_receive_buffers;
+
+    m_initialized = true;
+    enable_irq();
+}
+
+VirtIONetworkAdapter::~VirtIONetworkAdapter()
+{
+}
+
+bool VirtIONetworkAdapter::initialize()
+{
+    begin_initialization();
+
+    // We don't verify checksums on receive, so we can let the device skip them too.
+    u32 accepted = negotiate_features(VIRTIO_NET_F_CSUM | VIRTIO_NET_F_GUEST_CSUM | VIRTIO_NET_F_MAC | VIRTIO_NET_F_MRG_RXBUF | VIRTIO_NET_F_STATUS | VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_MQ | VIRTIO_F_ANY_LAYOUT);
+    m_checksum_offload = accepted & VIRTIO_NET_F_CSUM;
+    m_mergeable_receive_buffers = accepted & VIRTIO_NET_F_MRG_RXBUF;
+    m_header_size = m_mergeable_receive_buffers ? sizeof(VirtIONetHeader) : sizeof(VirtIONetHeader) - sizeof(u16);
+    // Legacy devices want the header in a descriptor of its own unless they can take any layout.
+    m_separate_header_descriptor = !(accepted & VIRTIO_F_ANY_LAYOUT);
+
+    read_mac_address();
+
+    // Use as many queue pairs as there are processors, so that they can transmit without
+    // contending on a single ring.
+    size_t device_queue_pairs = 1;
+    if (is_feature_accepted(VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_MQ))
+        device_queue_pairs = max((u16)1, config_read16(CONFIG_MAX_QUEUE_PAIRS));
+    size_t queue_pair_count = min(min(device_queue_pairs, (size_t)Processor::count()), max_queue_pairs);
+
+    for (size_t i = 0; i < queue_pair_count; ++i) {
+        QueuePair pair;
+        pair.receive_queue = 2 * i;
+        pair.transmit_queue = 2 * i + 1;
+        if (!setup_queue(pair.receive_queue) || !setup_queue(pair.transmit_queue)) {
+            if (i == 0)
+                return false;
+            break;
+        }
+        for (size_t j = 0; j < queue(pair.receive_queue).size(); ++j)
+            pair.receive_buffers.append(Optional<PacketBuffer>());
+        for (size_t j = 0; j < queue(pair.transmit_queue).size(); ++j)
+            pair.transmit_buffers.append(Optional<PacketBuffer>());
+        // Completed transmissions are reclaimed on the next send; we only ask for an
+        // interrupt when the ring has filled up.
+        queue(pair.transmit_queue).disable_interrupts();
+        m_queue_pairs.append(move(pair));
+    }
+
+    if (is_feature_accepted(VIRTIO_NET_F_CTRL_VQ)) {
+        m_control_queue = is_feature_accepted(VIRTIO_NET_F_MQ) ? 2 * device_queue_pairs : 2;
+        m_has_control_queue = setup_queue(m_control_queue);
+    }
+
+    for (auto& pair : m_queue_pairs)
+        fill_receive_queue(pair);
+
+    finish_initialization();
+
+    if (m_queue_pairs.size() > 1 && !set_queue_pair_count(m_queue_pairs.size())) {
+        klog() << "VirtIONetworkAdapter: Device refused " << m_queue_pairs.size() << " queue pairs, using just one";
+        // Buffers supplied to the other receive queues simply stay unused.
+        m_queue_pairs.shrink(1);
+    }
+    return true;
+}
+
+bool VirtIONetworkAdapter::set_queue_pair_count(u16 count)
+{
+    if (!m_has_control_queue)
+        return false;
+
+    struct [[gnu::packed]] Command
+    {
+        u8 command_class;
+        u8 command;
+        u16 queue_pairs;
+    };
+
+    auto region = MM.allocate_contiguous_kernel_region(PAGE_SIZE, "VirtIO net control", Region::Access::Read | Region::Access::Write);
+    if (!region)
+        return false;
+    auto& command = *(Command*)region->vaddr().as_ptr();
+    command.command_class = VIRTIO_NET_CTRL_MQ;
+    command.command = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+    command.queue_pairs = count;
+    auto* ack = (volatile u8*)(region->vaddr().as_ptr() + sizeof(Command));
+    *ack = 0xff;
+
+    auto address = region->physical_page(0)->paddr();
+    VirtIOQueue::BufferSegment segments[] = {
+        { address, sizeof(Command), false },
+        { address.offset(sizeof(Command)), sizeof(u8), true },
+    };
+    auto& control_queue = queue(m_control_queue);
+    if (!control_queue.supply_buffer(segments, 2).has_value())
+        return false;
+    notify_queue(m_control_queue);
+
+    // This only happens once during boot, so just poll for the answer.
+    u16 head;
+    u32 length;
+    for (size_t attempt = 0; attempt < 1000; ++attempt) {
+        if (control_queue.take_used_buffer(head, length))
+            return *ack == VIRTIO_NET_OK;
+        IO::delay(100);
+    }
+    // The device still owns the buffer, so it has to stay around.
+    (void)region.leak_ptr();
+    return false;
+}
+
+void VirtIONetworkAdapter::read_mac_address()
+{
+    u8 mac[6];
+    if (is_feature_accepted(VIRTIO_NET_F_MAC)) {
+        for (size_t i = 0; i < sizeof(mac); ++i)
+            mac[i] = config_read8(CONFIG_MAC + i);
+    } else {
+        // Make up a locally administered unicast address.
+        get_good_random_bytes(mac, sizeof(mac));
+        mac[0] = (mac[0] & ~1) | 2;
+    }
+    set_mac_address(mac);
+}
+
+bool VirtIONetworkAdapter::link_up()
+{
+    if (!is_feature_accepted(VIRTIO_NET_F_STATUS))
+        return m_initialized;
+    return config_read16(CONFIG_STATUS) & VIRTIO_NET_S_LINK_UP;
+}
+
+void VirtIONetworkAdapter::handle_irq(const RegisterState&)
+{
+    // The interrupt line may be shared; the ISR status tells whether it was us.
+    u8 status = read_isr_status();
+    if (!status || !m_initialized)
+        return;
+
+    if (status & VIRTIO_ISR_QUEUE_INTERRUPT) {
+        m_transmit_wait_queue.wake_all();
+
+        // Like the E1000, leave the receive queues to the NetworkTask and keep their
+        // interrupts off until it has drained them.
+        if (!is_receive_poll_pending()) {
+            for (auto& pair : m_queue_pairs)
+                queue(pair.receive_queue).disable_interrupts();
+            request_receive_poll();
+        }
+    }
+}
+
+void VirtIONetworkAdapter::fill_receive_queue(QueuePair& pair)
+{
+    auto& receive_queue = queue(pair.receive_queue);
+    size_t descriptors_per_buffer = m_separate_header_descriptor ? 2 : 1;
+    size_t target = min(receive_queue.size() / descriptors_per_buffer, max_receive_buffers_per_queue);
+
+    bool supplied = false;
+    while (pair.receive_buffer_count < target && receive_queue.free_descriptor_count() >= descriptors_per_buffer) {
+        auto buffer = create_packet_buffer(pooled_packet_buffer_size - m_header_size);
+        if (!buffer.has_value())
+            break;
+        // The device writes the header and the frame contiguously into the same buffer.
+        auto& packet = buffer.value();
+        packet.push_header(m_header_size);
+        packet.set_size(packet.size() + packet.tailroom());
+        auto address = packet.physical_address();
+        VirtIOQueue::BufferSegment segments[] = {
+            { address, (u32)packet.size(), true },
+            { address.offset(m_header_size), (u32)(packet.size() - m_header_size), true },
+        };
+        if (m_separate_header_descriptor)
+            segments[0].length = m_header_size;
+        auto head = receive_queue.supply_buffer(segments, descriptors_per_buffer);
+        if (!head.has_value())
+            break;
+        pair.receive_buffers[head.value()] = buffer.release_value();
+        ++pair.receive_buffer_count;
+        supplied = true;
+    }
+
+    if (supplied && receive_queue.should_notify())
+        notify_queue(pair.receive_queue);
+}
+
+size_t VirtIONetworkAdapter::receive(QueuePair& pair, size_t budget)
+{
+    auto& receive_queue = queue(pair.receive_queue);
+    size_t received = 0;
+    u16 head;
+    u32 length;
+    while (received < budget && receive_queue.take_used_buffer(head, length)) {
+        ASSERT(pair.receive_buffers[head].has_value());
+        auto packet = pair.receive_buffers[head].release_value();
+        --pair.receive_buffer_count;
+        ++received;
+
+        if (length < m_header_size || length > packet.size()) {
+            klog() << "VirtIONetworkAdapter: Bogus receive length " << length;
+            continue;
+        }
+        packet.set_size(length);
+        auto& header = *(const VirtIONetHeader*)packet.data();
+        u16 buffer_count = m_mergeable_receive_buffers ? header.buffer_count : 1;
+#ifdef VIRTIO_NET_DEBUG
+        klog() << "VirtIONetworkAdapter: Received " << length << " bytes in " << buffer_count << " buffer(s) on queue " << pair.receive_queue;
+#endif
+
+        if (buffer_count <= 1) {
+            // The frame follows the header in the same buffer, so hand it up as-is.
+            queue_received_packet(packet.slice(m_header_size, length - m_header_size));
+            continue;
+        }
+
+        // We don't negotiate any receive offloads, so the device shouldn't need to spread a frame
+        // over several buffers. If it does anyway, stitch them back together.
+        auto merged = create_packet_buffer(buffer_count * pooled_packet_buffer_size);
+        if (merged.has_value()) {
+            merged.value().reset();
+            memcpy(merged.value().data(), packet.data() + m_header_size, length - m_header_size);
+            merged.value().set_size(length - m_header_size);
+        }
+        for (u16 i = 1; i < buffer_count; ++i) {
+            if (!receive_queue.take_used_buffer(head, length))
+                break;
+            ASSERT(pair.receive_buffers[head].has_value());
+            auto next = pair.receive_buffers[head].release_value();
+            --pair.receive_buffer_count;
+            if (merged.has_value() && length <= merged.value().tailroom()) {
+                memcpy(merged.value().data() + merged.value().size(), next.data(), length);
+                merged.value().set_size(merged.value().size() + length);
+            }
+        }
+        if (merged.has_value())
+            queue_received_packet(merged.release_value());
+    }
+
+    fill_receive_queue(pair);
+    return received;
+}
+
+size_t VirtIONetworkAdapter::poll_receive(size_t budget)
+{
+    if (!is_receive_poll_pending())
+        return 0;
+
+    size_t received = 0;
+    for (size_t i = 0; i < m_queue_pairs.size() && received < budget; ++i) {
+        auto& pair = m_queue_pairs[(m_next_receive_pair + i) % m_queue_pairs.size()];
+        received += receive(pair, budget - received);
+    }
+    m_next_receive_pair = (m_next_receive_pair + 1) % m_queue_pairs.size();
+    if (received == budget)
+        return received;
+
+    // All queues are drained, so go back to interrupt-driven operation. Anything that arrived
+    // before the interrupts were back on would otherwise sit there until the next frame.
+    InterruptDisabler disabler;
+    set_receive_poll_pending(false);
+    bool more_pending = false;
+    for (auto& pair : m_queue_pairs) {
+        auto& receive_queue = queue(pair.receive_queue);
+        receive_queue.enable_interrupts();
+        if (receive_queue.has_used_buffers())
+            more_pending = true;
+    }
+    if (more_pending) {
+        for (auto& pair : m_queue_pairs)
+            queue(pair.receive_queue).disable_interrupts();
+        request_receive_poll();
+    }
+    return received;
+}
+
+void VirtIONetworkAdapter::reclaim_transmit_buffers(QueuePair& pair)
+{
+    auto& transmit_queue = queue(pair.transmit_queue);
+    u16 head;
+    u32 length;
+    while (transmit_queue.take_used_buffer(head, length)) {
+        ASSERT(pair.transmit_buffers[head].has_value());
+        release_packet_buffer(pair.transmit_buffers[head].release_value());
+    }
+}
+
+void VirtIONetworkAdapter::send_raw(ReadonlyBytes payload)
+{
+    auto buffer = create_packet_buffer(payload.size());
+    if (!buffer.has_value() || !buffer.value().is_physically_contiguous()) {
+        klog() << "VirtIONetworkAdapter: Can't send " << payload.size() << " byte frame";
+        return;
+    }
+    memcpy(buffer.value().data(), payload.data(), payload.size());
+    buffer.value().set_size(payload.size());
+    transmit(buffer.release_value());
+}
+
+void VirtIONetworkAdapter::send_packet(PacketBuffer&& frame)
+{
+    if (frame.is_physically_contiguous() && frame.headroom() >= m_header_size) {
+        transmit(move(frame));
+        return;
+    }
+    NetworkAdapter::send_packet(move(frame));
+}
+
+void VirtIONetworkAdapter::transmit(PacketBuffer&& frame)
+{
+    if (!m_initialized)
+        return;
+
+    if (frame.has_partial_checksum() && !m_checksum_offload)
+        complete_partial_checksum(frame);
+
+    VirtIONetHeader header {};
+    header.gso_type = VIRTIO_NET_HDR_GSO_NONE;
+    if (frame.has_partial_checksum()) {
+        header.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        header.checksum_start = frame.partial_checksum_start();
+        header.checksum_offset = frame.partial_checksum_offset();
+    }
+    size_t frame_size = frame.size();
+    memcpy(frame.push_header(m_header_size), &header, m_header_size);
+
+    auto address = frame.physical_address();
+    VirtIOQueue::BufferSegment segments[] = {
+        { address, (u32)frame.size(), false },
+        { address.offset(m_header_size), (u32)frame_size, false },
+    };
+    size_t segment_count = 1;
+    if (m_separate_header_descriptor) {
+        segments[0].length = m_header_size;
+        segment_count = 2;
+    }
+
+    auto& pair = m_queue_pairs[Processor::current().id() % m_queue_pairs.size()];
+    auto& transmit_queue = queue(pair.transmit_queue);
+    for (;;) {
+        {
+            ScopedSpinLock lock(transmit_queue.lock());
+            reclaim_transmit_buffers(pair);
+            if (transmit_queue.free_descriptor_count() >= segment_count) {
+                auto head = transmit_queue.supply_buffer(segments, segment_count);
+                ASSERT(head.has_value());
+                pair.transmit_buffers[head.value()] = move(frame);
+                if (transmit_queue.should_notify())
+                    notify_queue(pair.transmit_queue);
+                transmit_queue.disable_interrupts();
+                return;
+            }
+            // The ring is full; have the device tell us when it has caught up.
+            transmit_queue.enable_interrupts();
+            if (transmit_queue.has_used_buffers())
+                continue;
+        }
+        timeval timeout { 0, 10000 };
+        Thread::current()->wait_on(m_transmit_wait_queue, "VirtIONetworkAdapter", &timeout);
+    }
+}
+
+}
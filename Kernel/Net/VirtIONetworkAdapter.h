@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/VirtIO/VirtIO.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+class VirtIONetworkAdapter final : public NetworkAdapter
+    , public VirtIODevice {
+public:
+    static void detect();
+
+    explicit VirtIONetworkAdapter(PCI::Address);
+    virtual ~VirtIONetworkAdapter() override;
+
+    virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_packet(PacketBuffer&&) override;
+    virtual bool link_up() override;
+    virtual bool has_checksum_offload() const override { return m_checksum_offload; }
+
+    virtual const char* purpose() const override { return class_name(); }
+
+    virtual size_t poll_receive(size_t budget) override;
+
+private:
+    virtual void handle_irq(const RegisterState&) override;
+    virtual const char* class_name() const override { return "VirtIONetworkAdapter"; }
+    virtual bool wants_physically_contiguous_packet_buffers() const override { return true; }
+    virtual size_t device_headroom() const override { return m_header_size; }
+
+    // Each receive queue is only ever touched by the NetworkTask, while transmit queues are
+    // shared by every processor sending through this adapter and guarded by their spinlock.
+    struct QueuePair {
+        u16 receive_queue { 0 };
+        u16 transmit_queue { 0 };
+        size_t receive_buffer_count { 0 };
+        // Buffers the device owns, indexed by the head descriptor they were supplied with.
+        Vector<Optional<PacketBuffer>> receive_buffers;
+        Vector<Optional<PacketBuffer>> transmit_buffers;
+    };
+
+    bool initialize();
+    bool set_queue_pair_count(u16);
+    void read_mac_address();
+    void fill_receive_queue(QueuePair&);
+    size_t receive(QueuePair&, size_t budget);
+    void reclaim_transmit_buffers(QueuePair&);
+    void transmit(PacketBuffer&&);
+
+    Vector<QueuePair> m_queue_pairs;
+    size_t m_next_receive_pair { 0 };
+    size_t m_header_size { 0 };
+    u16 m_control_queue { 0 };
+    bool m_has_control_queue { false };
+    bool m_mergeable_receive_buffers { false };
+    bool m_separate_header_descriptor { true };
+    bool m_checksum_offload { false };
+    bool m_initialized { false };
+
+    WaitQueue m_transmit_wait_queue;
+};
+
+}
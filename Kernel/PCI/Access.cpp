@@ -183,6 +183,11 @@ u8 get_revision_id(Address address)
     return read8(address, PCI_REVISION_ID);
 }
 
+u8 get_programming_interface(Address address)
+{
+    return read8(address, PCI_PROG_IF);
+}
+
 u8 get_subclass(Address address)
 {
     return read8(address, PCI_SUBCLASS);
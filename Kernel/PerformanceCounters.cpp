@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Interrupts/APIC.h>
+#include <Kernel/PerformanceCounters.h>
+#include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/Process.h>
+#include <Kernel/UnixTypes.h>
+
+//#define PERFORMANCE_COUNTERS_DEBUG
+
+#define IA32_PMC0 0xc1
+#define IA32_PERFEVTSEL0 0x186
+#define IA32_PERF_GLOBAL_STATUS 0x38e
+#define IA32_PERF_GLOBAL_CTRL 0x38f
+#define IA32_PERF_GLOBAL_OVF_CTRL 0x390
+
+#define PERFEVTSEL_USR (1 << 16)
+#define PERFEVTSEL_OS (1 << 17)
+#define PERFEVTSEL_INT (1 << 20)
+#define PERFEVTSEL_EN (1 << 22)
+
+namespace Kernel {
+
+namespace PerformanceCounters {
+
+struct ArchitecturalEvent {
+    u8 event_select;
+    u8 unit_mask;
+    // Bit in CPUID.0AH:EBX that is set when the CPU does *not* have this event.
+    u8 unavailable_bit;
+};
+
+static ProcessID s_pid { -1 };
+static int s_counter { 0 };
+static u32 s_period { 0 };
+
+static Optional<ArchitecturalEvent> event_for_counter(int counter)
+{
+    switch (counter) {
+    case PERF_COUNTER_CYCLES:
+        return ArchitecturalEvent { 0x3c, 0x00, 0 };
+    case PERF_COUNTER_INSTRUCTIONS:
+        return ArchitecturalEvent { 0xc0, 0x00, 1 };
+    case PERF_COUNTER_CACHE_MISSES:
+        return ArchitecturalEvent { 0x2e, 0x41, 4 };
+    case PERF_COUNTER_BRANCH_MISSES:
+        return ArchitecturalEvent { 0xc5, 0x00, 6 };
+    default:
+        return {};
+    }
+}
+
+bool is_supported(int counter)
+{
+    auto event = event_for_counter(counter);
+    if (!event.has_value())
+        return false;
+    if (!APIC::initialized() || !MSR::have())
+        return false;
+    if (CPUID(0).eax() < 0xa)
+        return false;
+    CPUID perfmon(0xa);
+    u8 version = perfmon.eax() & 0xff;
+    u8 counter_count = (perfmon.eax() >> 8) & 0xff;
+    u8 event_vector_length = (perfmon.eax() >> 24) & 0xff;
+    // We rely on the global control and overflow status MSRs, which came with version 2.
+    if (version < 2 || counter_count == 0)
+        return false;
+    if (event.value().unavailable_bit >= event_vector_length)
+        return false;
+    return !(perfmon.ebx() & (1 << event.value().unavailable_bit));
+}
+
+ProcessID pid()
+{
+    return s_pid;
+}
+
+static void reload_counter()
+{
+    // Writes to the legacy PMC MSR sign-extend from bit 31, so this counts up from -period.
+    MSR(IA32_PMC0).set(-s_period, 0);
+    MSR(IA32_PERF_GLOBAL_OVF_CTRL).set(1, 0);
+}
+
+static void program_this_processor()
+{
+    MSR(IA32_PERF_GLOBAL_CTRL).set(0, 0);
+    MSR(IA32_PERFEVTSEL0).set(0, 0);
+
+    if (!s_counter) {
+        APIC::the().disable_performance_counter_interrupt();
+        return;
+    }
+
+    auto event = event_for_counter(s_counter).value();
+    reload_counter();
+    MSR(IA32_PERFEVTSEL0).set(event.event_select | (event.unit_mask << 8) | PERFEVTSEL_USR | PERFEVTSEL_OS | PERFEVTSEL_INT | PERFEVTSEL_EN, 0);
+    APIC::the().enable_performance_counter_interrupt();
+    MSR(IA32_PERF_GLOBAL_CTRL).set(1, 0);
+}
+
+static void program_all_processors()
+{
+    if (Processor::count() > 1)
+        Processor::smp_broadcast([] { program_this_processor(); }, false);
+    InterruptDisabler disabler;
+    program_this_processor();
+}
+
+KResult start(ProcessID pid, int counter, u32 period)
+{
+    if (!is_supported(counter))
+        return KResult(-ENOTSUP);
+    // Anything shorter would mostly have us measuring our own interrupt handler.
+    if (period < 1000 || period > NumericLimits<i32>::max())
+        return KResult(-EINVAL);
+
+    stop();
+    s_pid = pid;
+    s_period = period;
+    s_counter = counter;
+    program_all_processors();
+#ifdef PERFORMANCE_COUNTERS_DEBUG
+    dbg() << "PerformanceCounters: Sampling counter " << counter << " every " << period << " events for pid " << pid.value();
+#endif
+    return KSuccess;
+}
+
+void stop()
+{
+    if (!s_counter)
+        return;
+    s_counter = 0;
+    program_all_processors();
+    s_pid = -1;
+}
+
+void handle_overflow(const RegisterState& regs)
+{
+    u32 status_low, status_high;
+    MSR(IA32_PERF_GLOBAL_STATUS).get(status_low, status_high);
+    if (!(status_low & 1) || !s_counter)
+        return;
+
+    MSR(IA32_PERF_GLOBAL_CTRL).set(0, 0);
+
+    // The counters run for everyone, but only the target's share of the overflows is recorded.
+    auto* current_thread = Thread::current();
+    if (current_thread && current_thread->process().pid() == s_pid) {
+        if (auto* buffer = current_thread->process().perf_events())
+            (void)buffer->append_sample(s_counter, s_period, regs.ebp, regs.eip);
+    }
+
+    reload_counter();
+    // The local APIC masks the performance counter LVT entry every time it delivers the interrupt.
+    APIC::the().enable_performance_counter_interrupt();
+    MSR(IA32_PERF_GLOBAL_CTRL).set(1, 0);
+}
+
+}
+
+}
@@ -27,21 +27,28 @@
 #include <AK/JsonArraySerializer.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonObjectSerializer.h>
+#include <AK/StringBuilder.h>
+#include <Kernel/API/Perfcore.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/PerformanceEventBuffer.h>
 
 namespace Kernel {
 
+static const size_t ring_size_per_cpu = 4 * MiB;
+
+NonnullRefPtr<PerformanceEventBuffer> PerformanceEventBuffer::create()
+{
+    return adopt(*new PerformanceEventBuffer);
+}
+
 PerformanceEventBuffer::PerformanceEventBuffer()
-    : m_buffer(KBuffer::create_with_size(4 * MiB))
 {
+    for (u32 cpu = 0; cpu < Processor::count(); ++cpu)
+        m_rings.append(make<Ring>(ring_size_per_cpu));
 }
 
 KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
 {
-    if (count() >= capacity())
-        return KResult(-ENOBUFS);
-
     PerformanceEvent event;
     event.type = type;
 
@@ -66,12 +73,63 @@ KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
     FlatPtr ebp;
     asm volatile("movl %%ebp, %%eax"
                  : "=a"(ebp));
-    auto current_thread = Thread::current();
-    auto eip = current_thread->get_register_dump_from_stack().eip;
+    capture_backtrace(event, ebp, Thread::current()->get_register_dump_from_stack().eip);
+    m_has_profile_events = true;
+    return push(event);
+}
+
+KResult PerformanceEventBuffer::append_sample(int counter, u32 period, FlatPtr ebp, FlatPtr eip)
+{
+    PerformanceEvent event;
+    event.type = PERF_EVENT_SAMPLE;
+    event.data.sample.counter = counter;
+    event.data.sample.period = period;
+    capture_backtrace(event, ebp, eip);
+    m_has_profile_events = true;
+    return push(event);
+}
+
+KResult PerformanceEventBuffer::append_off_cpu(const char* reason, u64 duration_ns)
+{
+    PerformanceEvent event;
+    event.type = PERF_EVENT_OFF_CPU;
+    event.data.off_cpu.duration_ns = duration_ns;
+    size_t reason_length = reason ? min(strlen(reason), sizeof(event.data.off_cpu.reason) - 1) : 0;
+    memcpy(event.data.off_cpu.reason, reason, reason_length);
+    event.data.off_cpu.reason[reason_length] = '\0';
+
+    // Start at our caller, so the stack doesn't begin with the tracing code itself.
+    FlatPtr ebp;
+    asm volatile("movl %%ebp, %%eax"
+                 : "=a"(ebp));
+    auto* frame = reinterpret_cast<FlatPtr*>(ebp);
+    capture_backtrace(event, frame[0], frame[1]);
+    m_has_profile_events = true;
+    return push(event);
+}
+
+KResult PerformanceEventBuffer::append_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3, u32 return_value, u64 duration_ns)
+{
+    PerformanceEvent event;
+    event.type = PERF_EVENT_SYSCALL;
+    event.stack_size = 0;
+    event.timestamp = g_uptime;
+    event.data.syscall_trace.function = function;
+    event.data.syscall_trace.arguments[0] = arg1;
+    event.data.syscall_trace.arguments[1] = arg2;
+    event.data.syscall_trace.arguments[2] = arg3;
+    event.data.syscall_trace.return_value = return_value;
+    event.data.syscall_trace.tid = Thread::current()->tid().value();
+    event.data.syscall_trace.duration_ns = duration_ns;
+    return push(event);
+}
+
+void PerformanceEventBuffer::capture_backtrace(PerformanceEvent& event, FlatPtr ebp, FlatPtr eip)
+{
     Vector<FlatPtr> backtrace;
     {
         SmapDisabler disabler;
-        backtrace = current_thread->raw_backtrace(ebp, eip);
+        backtrace = Thread::current()->raw_backtrace(ebp, eip);
     }
     event.stack_size = min(sizeof(event.stack) / sizeof(FlatPtr), static_cast<size_t>(backtrace.size()));
     memcpy(event.stack, backtrace.data(), event.stack_size * sizeof(FlatPtr));
@@ -82,50 +140,161 @@ KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
 #endif
 
     event.timestamp = g_uptime;
-    at(m_count++) = event;
+}
+
+KResult PerformanceEventBuffer::push(const PerformanceEvent& event)
+{
+    // Samples are pushed from the performance counter interrupt, so keeping interrupts off
+    // (rather than just staying on this CPU) is what makes us the only one touching the head of its ring.
+    InterruptDisabler disabler;
+    auto& ring = m_rings[Processor::current().id() % m_rings.size()];
+    u64 head = ring.head.load(AK::memory_order_relaxed);
+    if (head - ring.tail.load(AK::memory_order_acquire) >= ring.capacity()) {
+        m_lost_count.fetch_add(1, AK::memory_order_relaxed);
+        return KResult(-ENOBUFS);
+    }
+    ring.at(head) = event;
+    ring.head.store(head + 1, AK::memory_order_release);
     return KSuccess;
 }
 
-PerformanceEvent& PerformanceEventBuffer::at(size_t index)
+bool PerformanceEventBuffer::take_oldest(PerformanceEvent& out_event)
+{
+    LOCKER(m_read_lock);
+    Ring* oldest_ring = nullptr;
+    for (auto& ring : m_rings) {
+        u64 tail = ring.tail.load(AK::memory_order_relaxed);
+        if (tail == ring.head.load(AK::memory_order_acquire))
+            continue;
+        if (!oldest_ring || ring.at(tail).timestamp < oldest_ring->at(oldest_ring->tail.load(AK::memory_order_relaxed)).timestamp)
+            oldest_ring = &ring;
+    }
+    if (!oldest_ring)
+        return false;
+    u64 tail = oldest_ring->tail.load(AK::memory_order_relaxed);
+    out_event = oldest_ring->at(tail);
+    oldest_ring->tail.store(tail + 1, AK::memory_order_release);
+    return true;
+}
+
+size_t PerformanceEventBuffer::count() const
+{
+    size_t count = 0;
+    for (auto& ring : m_rings)
+        count += ring.head.load(AK::memory_order_acquire) - ring.tail.load(AK::memory_order_relaxed);
+    return count;
+}
+
+static const char* counter_name(u32 counter)
+{
+    switch (counter) {
+    case PERF_COUNTER_CYCLES:
+        return "cycles";
+    case PERF_COUNTER_INSTRUCTIONS:
+        return "instructions";
+    case PERF_COUNTER_CACHE_MISSES:
+        return "cache_misses";
+    case PERF_COUNTER_BRANCH_MISSES:
+        return "branch_misses";
+    default:
+        return "unknown";
+    }
+}
+
+template<typename Builder>
+void PerformanceEventBuffer::serialize_event(JsonObjectSerializer<Builder>& event_object, const PerformanceEvent& event)
 {
-    ASSERT(index < capacity());
-    auto* events = reinterpret_cast<PerformanceEvent*>(m_buffer.data());
-    return events[index];
+    switch (event.type) {
+    case PERF_EVENT_MALLOC:
+        event_object.add("type", "malloc");
+        event_object.add("ptr", static_cast<u64>(event.data.malloc.ptr));
+        event_object.add("size", static_cast<u64>(event.data.malloc.size));
+        break;
+    case PERF_EVENT_FREE:
+        event_object.add("type", "free");
+        event_object.add("ptr", static_cast<u64>(event.data.free.ptr));
+        break;
+    case PERF_EVENT_OFF_CPU:
+        event_object.add("type", "off_cpu");
+        event_object.add("reason", event.data.off_cpu.reason);
+        event_object.add("duration_ns", event.data.off_cpu.duration_ns);
+        break;
+    case PERF_EVENT_SAMPLE:
+        event_object.add("type", "sample");
+        event_object.add("counter", counter_name(event.data.sample.counter));
+        event_object.add("period", static_cast<u64>(event.data.sample.period));
+        break;
+    case PERF_EVENT_SYSCALL: {
+        event_object.add("type", "syscall");
+        event_object.add("function", event.data.syscall_trace.function);
+        auto arguments_array = event_object.add_array("arguments");
+        for (auto argument : event.data.syscall_trace.arguments)
+            arguments_array.add(argument);
+        arguments_array.finish();
+        event_object.add("return_value", static_cast<i32>(event.data.syscall_trace.return_value));
+        event_object.add("tid", event.data.syscall_trace.tid);
+        event_object.add("duration_ns", event.data.syscall_trace.duration_ns);
+        break;
+    }
+    }
+    event_object.add("timestamp", event.timestamp);
+    auto stack_array = event_object.add_array("stack");
+    for (size_t j = 0; j < event.stack_size; ++j) {
+        stack_array.add(event.stack[j]);
+    }
+    stack_array.finish();
 }
 
-KBuffer PerformanceEventBuffer::to_json(ProcessID pid, const String& executable_path) const
+template void PerformanceEventBuffer::serialize_event(JsonObjectSerializer<KBufferBuilder>&, const PerformanceEvent&);
+template void PerformanceEventBuffer::serialize_event(JsonObjectSerializer<StringBuilder>&, const PerformanceEvent&);
+
+KBuffer PerformanceEventBuffer::to_perfcore(ProcessID pid, const String& executable_path)
 {
     KBufferBuilder builder;
 
-    JsonObjectSerializer object(builder);
-    object.add("pid", pid.value());
-    object.add("executable", executable_path);
+    PerfcoreHeader header {};
+    header.magic = PERFCORE_MAGIC;
+    header.version = PERFCORE_VERSION;
+    header.header_size = sizeof(header);
+    header.event_record_size = sizeof(PerfcoreEventRecord);
+    header.pid = pid.value();
+    header.lost_events = lost_count();
+    header.executable_path_length = executable_path.length();
+    builder.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    builder.append(executable_path.characters(), executable_path.length());
 
-    auto array = object.add_array("events");
-    for (size_t i = 0; i < m_count; ++i) {
-        auto& event = at(i);
-        auto event_object = array.add_object();
+    PerformanceEvent event;
+    while (take_oldest(event)) {
+        // Syscall records are for strace, not the profiler.
+        if (event.type == PERF_EVENT_SYSCALL)
+            continue;
+        PerfcoreEventRecord record {};
+        record.type = event.type;
+        record.stack_size = event.stack_size;
+        record.timestamp = event.timestamp;
         switch (event.type) {
         case PERF_EVENT_MALLOC:
-            event_object.add("type", "malloc");
-            event_object.add("ptr", static_cast<u64>(event.data.malloc.ptr));
-            event_object.add("size", static_cast<u64>(event.data.malloc.size));
+            record.ptr = event.data.malloc.ptr;
+            record.size = event.data.malloc.size;
             break;
         case PERF_EVENT_FREE:
-            event_object.add("type", "free");
-            event_object.add("ptr", static_cast<u64>(event.data.free.ptr));
+            record.ptr = event.data.free.ptr;
+            break;
+        case PERF_EVENT_OFF_CPU:
+            record.duration_ns = event.data.off_cpu.duration_ns;
+            memcpy(record.reason, event.data.off_cpu.reason, sizeof(record.reason));
+            break;
+        case PERF_EVENT_SAMPLE:
+            record.counter = event.data.sample.counter;
+            record.period = event.data.sample.period;
             break;
         }
-        event_object.add("timestamp", event.timestamp);
-        auto stack_array = event_object.add_array("stack");
+        builder.append(reinterpret_cast<const char*>(&record), sizeof(record));
         for (size_t j = 0; j < event.stack_size; ++j) {
-            stack_array.add(event.stack[j]);
+            u32 address = event.stack[j];
+            builder.append(reinterpret_cast<const char*>(&address), sizeof(address));
         }
-        stack_array.finish();
-        event_object.finish();
     }
-    array.finish();
-    object.finish();
     return builder.build();
 }
 
@@ -26,8 +26,13 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
+#include <AK/JsonObjectSerializer.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/RefCounted.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/KResult.h>
+#include <Kernel/Lock.h>
 
 namespace Kernel {
 
@@ -43,6 +48,27 @@ struct [[gnu::packed]] FreePerformanceEvent
     FlatPtr ptr;
 };
 
+struct [[gnu::packed]] SamplePerformanceEvent
+{
+    u32 counter;
+    u32 period;
+};
+
+struct [[gnu::packed]] OffCpuPerformanceEvent
+{
+    u64 duration_ns;
+    char reason[24];
+};
+
+struct [[gnu::packed]] SyscallPerformanceEvent
+{
+    u32 function;
+    u32 arguments[3];
+    u32 return_value;
+    u32 tid;
+    u64 duration_ns;
+};
+
 struct [[gnu::packed]] PerformanceEvent
 {
     u8 type { 0 };
@@ -51,30 +77,76 @@ struct [[gnu::packed]] PerformanceEvent
     union {
         MallocPerformanceEvent malloc;
         FreePerformanceEvent free;
+        SamplePerformanceEvent sample;
+        OffCpuPerformanceEvent off_cpu;
+        SyscallPerformanceEvent syscall_trace;
     } data;
     FlatPtr stack[32];
 };
 
-class PerformanceEventBuffer {
+// Events are appended to a ring buffer belonging to the CPU we're running on, so recording never
+// takes a lock. They can be consumed while the process runs, which frees up room for new ones,
+// and whatever is left over gets written out in the binary perfcore format when the process exits.
+class PerformanceEventBuffer : public RefCounted<PerformanceEventBuffer> {
 public:
-    PerformanceEventBuffer();
+    static NonnullRefPtr<PerformanceEventBuffer> create();
 
     KResult append(int type, FlatPtr arg1, FlatPtr arg2);
 
-    size_t capacity() const { return m_buffer.size() / sizeof(PerformanceEvent); }
-    size_t count() const { return m_count; }
-    const PerformanceEvent& at(size_t index) const
-    {
-        return const_cast<PerformanceEventBuffer&>(*this).at(index);
-    }
+    // Records a hardware counter overflow at the given interrupted frame. Safe to call from an IRQ handler.
+    KResult append_sample(int counter, u32 period, FlatPtr ebp, FlatPtr eip);
+
+    // Records that the current thread was blocked for the given time, with the kernel stack it blocked on.
+    KResult append_off_cpu(const char* reason, u64 duration_ns);
 
-    KBuffer to_json(ProcessID, const String& executable_path) const;
+    // Records a finished syscall. There's no backtrace, which keeps this cheap enough to do on every syscall.
+    KResult append_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3, u32 return_value, u64 duration_ns);
+
+    // Whether anything besides syscalls was recorded, and so is worth a perfcore file.
+    bool has_profile_events() const { return m_has_profile_events; }
+
+    // Takes out the oldest buffered event of all CPUs.
+    bool take_oldest(PerformanceEvent&);
+
+    size_t count() const;
+    size_t lost_count() const { return m_lost_count.load(AK::memory_order_relaxed); }
+
+    // Set once the process is gone, so readers know that nothing more is coming.
+    bool is_finished() const { return m_finished; }
+    void set_finished() { m_finished = true; }
+
+    // See Kernel/API/Perfcore.h for the layout.
+    KBuffer to_perfcore(ProcessID, const String& executable_path);
+
+    template<typename Builder>
+    static void serialize_event(JsonObjectSerializer<Builder>&, const PerformanceEvent&);
 
 private:
-    PerformanceEvent& at(size_t index);
+    PerformanceEventBuffer();
+
+    void capture_backtrace(PerformanceEvent&, FlatPtr ebp, FlatPtr eip);
+    KResult push(const PerformanceEvent&);
+
+    struct Ring {
+        explicit Ring(size_t size)
+            : buffer(KBuffer::create_with_size(size))
+        {
+        }
+
+        size_t capacity() const { return buffer.size() / sizeof(PerformanceEvent); }
+        PerformanceEvent& at(u64 index) { return reinterpret_cast<PerformanceEvent*>(buffer.data())[index % capacity()]; }
+
+        KBuffer buffer;
+        // Only the producing CPU moves the head and only a reader moves the tail.
+        Atomic<u64> head { 0 };
+        Atomic<u64> tail { 0 };
+    };
 
-    size_t m_count { 0 };
-    KBuffer m_buffer;
+    NonnullOwnPtrVector<Ring> m_rings;
+    Atomic<size_t> m_lost_count { 0 };
+    Lock m_read_lock { "PerformanceEventBuffer" };
+    bool m_finished { false };
+    bool m_has_profile_events { false };
 };
 
 }
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <AK/StringBuilder.h>
+#include <Kernel/PerformanceEventStream.h>
+
+namespace Kernel {
+
+NonnullRefPtr<PerformanceEventStream> PerformanceEventStream::create(ProcessID pid, PerformanceEventBuffer& buffer)
+{
+    return adopt(*new PerformanceEventStream(pid, buffer));
+}
+
+PerformanceEventStream::PerformanceEventStream(ProcessID pid, PerformanceEventBuffer& buffer)
+    : m_pid(pid)
+    , m_buffer(buffer)
+{
+}
+
+PerformanceEventStream::~PerformanceEventStream()
+{
+}
+
+bool PerformanceEventStream::can_read(const FileDescription&, size_t) const
+{
+    return m_pending_offset < m_pending.size() || m_buffer->count() || m_buffer->is_finished();
+}
+
+KResultOr<size_t> PerformanceEventStream::read(FileDescription&, size_t, u8* buffer, size_t size)
+{
+    LOCKER(m_lock);
+    size_t nread = 0;
+    while (nread < size) {
+        if (m_pending_offset == m_pending.size()) {
+            PerformanceEvent event;
+            if (!m_buffer->take_oldest(event))
+                break;
+            StringBuilder builder;
+            {
+                JsonObjectSerializer object(builder);
+                PerformanceEventBuffer::serialize_event(object, event);
+            }
+            builder.append('\n');
+            m_pending = builder.to_byte_buffer();
+            m_pending_offset = 0;
+        }
+        size_t chunk_size = min(size - nread, m_pending.size() - m_pending_offset);
+        memcpy(buffer + nread, m_pending.data() + m_pending_offset, chunk_size);
+        m_pending_offset += chunk_size;
+        nread += chunk_size;
+    }
+    if (!nread && !m_buffer->is_finished())
+        return KResult(-EAGAIN);
+    return nread;
+}
+
+KResultOr<size_t> PerformanceEventStream::write(FileDescription&, size_t, const u8*, size_t)
+{
+    return KResult(-EBADF);
+}
+
+String PerformanceEventStream::absolute_path(const FileDescription&) const
+{
+    return String::format("PerformanceEventStream:%d", m_pid.value());
+}
+
+}
@@ -25,7 +25,6 @@
  */
 
 #include <AK/Demangle.h>
-#include <AK/QuickSort.h>
 #include <AK/RefPtr.h>
 #include <AK/ScopeGuard.h>
 #include <AK/ScopedValueRollback.h>
@@ -56,6 +55,7 @@
 #include <Kernel/KSyms.h>
 #include <Kernel/Module.h>
 #include <Kernel/Multiboot.h>
+#include <Kernel/PerformanceCounters.h>
 #include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/RTC.h>
@@ -141,6 +141,7 @@ NonnullRefPtrVector<Process> Process::all_processes()
 
 bool Process::in_group(gid_t gid) const
 {
+    ScopedSpinLock lock(m_credentials_lock);
     return m_gid == gid || m_extra_gids.contains(gid);
 }
 
@@ -155,6 +156,7 @@ Range Process::allocate_range(VirtualAddress vaddr, size_t size, size_t alignmen
 
 Region& Process::allocate_split_region(const Region& source_region, const Range& range, size_t offset_in_vmobject)
 {
+    LOCKER(m_address_space_lock);
     auto& region = add_region(Region::create_user_accessible(range, source_region.vmobject(), offset_in_vmobject, source_region.name(), source_region.access()));
     region.set_mmap(source_region.is_mmap());
     region.set_stack(source_region.is_stack());
@@ -169,6 +171,7 @@ Region& Process::allocate_split_region(const Region& source_region, const Range&
 Region* Process::allocate_region(const Range& range, const String& name, int prot, bool should_commit)
 {
     ASSERT(range.is_valid());
+    LOCKER(m_address_space_lock);
     auto vmobject = AnonymousVMObject::create_with_size(range.size());
     auto region = Region::create_user_accessible(range, vmobject, 0, name, prot_to_region_access_flags(prot));
     region->map(page_directory());
@@ -177,6 +180,30 @@ Region* Process::allocate_region(const Range& range, const String& name, int pro
     return &add_region(move(region));
 }
 
+Region* Process::allocate_large_page_region(const Range& range, const String& name, int prot)
+{
+    ASSERT(range.is_valid());
+    LOCKER(m_address_space_lock);
+    auto vmobject = AnonymousVMObject::create_with_size(range.size());
+
+    // Back every aligned 2 MiB chunk with physically contiguous, aligned pages so the
+    // region can be mapped with large pages. Any unaligned edges are filled in on demand.
+    FlatPtr first_chunk = round_up_to_power_of_two(range.base().get(), MemoryManager::large_page_size);
+    FlatPtr end = range.end().get() & ~(MemoryManager::large_page_size - 1);
+    for (FlatPtr chunk = first_chunk; chunk + MemoryManager::large_page_size <= end; chunk += MemoryManager::large_page_size) {
+        auto pages = MM.allocate_contiguous_user_physical_pages(MemoryManager::large_page_size, MemoryManager::large_page_size);
+        if (pages.is_empty())
+            return nullptr;
+        size_t first_page_index = (chunk - range.base().get()) / PAGE_SIZE;
+        for (size_t i = 0; i < pages.size(); ++i)
+            vmobject->physical_pages()[first_page_index + i] = pages[i];
+    }
+
+    auto region = Region::create_user_accessible(range, vmobject, 0, name, prot_to_region_access_flags(prot));
+    region->map(page_directory());
+    return &add_region(move(region));
+}
+
 Region* Process::allocate_region(VirtualAddress vaddr, size_t size, const String& name, int prot, bool should_commit)
 {
     auto range = allocate_range(vaddr, size);
@@ -202,6 +229,7 @@ Region* Process::allocate_region_with_vmobject(const Range& range, NonnullRefPtr
         return nullptr;
     }
     offset_in_vmobject &= PAGE_MASK;
+    LOCKER(m_address_space_lock);
     auto& region = add_region(Region::create_user_accessible(range, move(vmobject), offset_in_vmobject, name, prot_to_region_access_flags(prot)));
     region.map(page_directory());
     return &region;
@@ -218,17 +246,39 @@ Region* Process::allocate_region_with_vmobject(VirtualAddress vaddr, size_t size
 bool Process::deallocate_region(Region& region)
 {
     OwnPtr<Region> region_protector;
+    LOCKER(m_address_space_lock);
     ScopedSpinLock lock(m_lock);
 
     if (m_region_lookup_cache.region == &region)
         m_region_lookup_cache.region = nullptr;
-    for (size_t i = 0; i < m_regions.size(); ++i) {
-        if (&m_regions[i] == &region) {
-            region_protector = m_regions.unstable_take(i);
-            return true;
-        }
+    size_t index = region_index_after(region.vaddr());
+    if (!index || &m_regions[index - 1] != &region)
+        return false;
+    region_protector = m_regions.take(index - 1);
+    return true;
+}
+
+size_t Process::region_index_after(VirtualAddress vaddr) const
+{
+    size_t low = 0;
+    size_t high = m_regions.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (m_regions[middle].vaddr() <= vaddr)
+            low = middle + 1;
+        else
+            high = middle;
     }
-    return false;
+    return low;
+}
+
+Region* Process::region_at_or_below(VirtualAddress vaddr)
+{
+    // Regions don't overlap, so the last one starting at or below vaddr is the only one that may contain it.
+    size_t index = region_index_after(vaddr);
+    if (!index)
+        return nullptr;
+    return &m_regions[index - 1];
 }
 
 Region* Process::find_region_from_range(const Range& range)
@@ -238,24 +288,21 @@ Region* Process::find_region_from_range(const Range& range)
         return m_region_lookup_cache.region;
 
     size_t size = PAGE_ROUND_UP(range.size());
-    for (auto& region : m_regions) {
-        if (region.vaddr() == range.base() && region.size() == size) {
-            m_region_lookup_cache.range = range;
-            m_region_lookup_cache.region = region.make_weak_ptr();
-            return &region;
-        }
-    }
-    return nullptr;
+    auto* region = region_at_or_below(range.base());
+    if (!region || region->vaddr() != range.base() || region->size() != size)
+        return nullptr;
+    m_region_lookup_cache.range = range;
+    m_region_lookup_cache.region = region->make_weak_ptr();
+    return region;
 }
 
 Region* Process::find_region_containing(const Range& range)
 {
     ScopedSpinLock lock(m_lock);
-    for (auto& region : m_regions) {
-        if (region.contains(range))
-            return &region;
-    }
-    return nullptr;
+    auto* region = region_at_or_below(range.base());
+    if (!region || !region->contains(range))
+        return nullptr;
+    return region;
 }
 
 void Process::kill_threads_except_self()
@@ -396,16 +443,7 @@ void Process::dump_regions()
 
     ScopedSpinLock lock(m_lock);
 
-    Vector<Region*> sorted_regions;
-    sorted_regions.ensure_capacity(m_regions.size());
-    for (auto& region : m_regions)
-        sorted_regions.append(&region);
-    quick_sort(sorted_regions, [](auto& a, auto& b) {
-        return a->vaddr() < b->vaddr();
-    });
-
-    for (auto& sorted_region : sorted_regions) {
-        auto& region = *sorted_region;
+    for (auto& region : m_regions) {
         klog() << String::format("%08x", region.vaddr().get()) << " -- " << String::format("%08x", region.vaddr().offset(region.size() - 1).get()) << "    " << String::format("%08x", region.size()) << "    " << (region.is_readable() ? 'R' : ' ') << (region.is_writable() ? 'W' : ' ') << (region.is_executable() ? 'X' : ' ') << (region.is_shared() ? 'S' : ' ') << (region.is_stack() ? 'T' : ' ') << (region.vmobject().is_purgeable() ? 'P' : ' ') << "    " << region.name().characters();
     }
     MM.dump_kernel_regions();
@@ -505,6 +543,7 @@ RefPtr<FileDescription> Process::file_description(int fd) const
 {
     if (fd < 0)
         return nullptr;
+    ScopedSpinLock lock(m_fds_lock);
     if (static_cast<size_t>(fd) < m_fds.size())
         return m_fds[fd].description();
     return nullptr;
@@ -514,6 +553,7 @@ int Process::fd_flags(int fd) const
 {
     if (fd < 0)
         return -1;
+    ScopedSpinLock lock(m_fds_lock);
     if (static_cast<size_t>(fd) < m_fds.size())
         return m_fds[fd].flags();
     return -1;
@@ -539,6 +579,7 @@ String Process::validate_and_copy_string_from_user(const Syscall::StringArgument
 
 int Process::number_of_open_file_descriptors() const
 {
+    ScopedSpinLock lock(m_fds_lock);
     int count = 0;
     for (auto& description : m_fds) {
         if (description)
@@ -549,6 +590,8 @@ int Process::number_of_open_file_descriptors() const
 
 int Process::alloc_fd(int first_candidate_fd)
 {
+    // The caller must hold m_fds_lock until the new fd has been filled in.
+    ASSERT(m_fds_lock.is_locked());
     for (int i = first_candidate_fd; i < (int)m_max_open_file_descriptors; ++i) {
         if (!m_fds[i])
             return i;
@@ -622,8 +665,9 @@ bool Process::validate_write(void* address, size_t size) const
     return MM.validate_user_write(*this, VirtualAddress(address), size);
 }
 
-Custody& Process::current_directory()
+NonnullRefPtr<Custody> Process::current_directory()
 {
+    LOCKER(m_filesystem_lock);
     if (!m_cwd)
         m_cwd = VFS::the().root_custody();
     return *m_cwd;
@@ -652,15 +696,22 @@ void Process::finalize()
     dbg() << "Finalizing process " << *this;
 #endif
 
-    if (m_perf_event_buffer) {
+    if (PerformanceCounters::pid() == m_pid)
+        PerformanceCounters::stop();
+
+    if (m_perf_event_buffer && m_perf_event_buffer->has_profile_events()) {
         auto description_or_error = VFS::the().open(String::format("perfcore.%d", m_pid), O_CREAT | O_EXCL, 0400, current_directory(), UidAndGid { m_uid, m_gid });
         if (!description_or_error.is_error()) {
             auto& description = description_or_error.value();
-            auto json = m_perf_event_buffer->to_json(m_pid, m_executable ? m_executable->absolute_path() : "");
+            auto perfcore = m_perf_event_buffer->to_perfcore(m_pid, m_executable ? m_executable->absolute_path() : "");
             // FIXME: Should this error path be surfaced somehow?
-            (void)description->write(json.data(), json.size());
+            (void)description->write(perfcore.data(), perfcore.size());
         }
     }
+    if (m_perf_event_buffer) {
+        m_perf_event_buffer->set_finished();
+        m_perf_event_buffer = nullptr;
+    }
 
     m_fds.clear();
     m_tty = nullptr;
@@ -767,6 +818,20 @@ size_t Process::amount_shared() const
     return amount;
 }
 
+IOStatistics Process::io_statistics() const
+{
+    IOStatistics statistics;
+    {
+        ScopedSpinLock lock(m_lock);
+        statistics = m_exited_threads_io_statistics;
+    }
+    for_each_thread([&](const Thread& thread) {
+        statistics.add(thread.io_statistics());
+        return IterationDecision::Continue;
+    });
+    return statistics;
+}
+
 size_t Process::amount_purgeable_volatile() const
 {
     size_t amount = 0;
@@ -864,15 +929,17 @@ KBuffer Process::backtrace() const
     return builder.build();
 }
 
-Custody& Process::root_directory()
+NonnullRefPtr<Custody> Process::root_directory()
 {
+    LOCKER(m_filesystem_lock);
     if (!m_root_directory)
         m_root_directory = VFS::the().root_custody();
     return *m_root_directory;
 }
 
-Custody& Process::root_directory_relative_to_global_root()
+NonnullRefPtr<Custody> Process::root_directory_relative_to_global_root()
 {
+    LOCKER(m_filesystem_lock);
     if (!m_root_directory_relative_to_global_root)
         m_root_directory_relative_to_global_root = root_directory();
     return *m_root_directory_relative_to_global_root;
@@ -880,14 +947,16 @@ Custody& Process::root_directory_relative_to_global_root()
 
 void Process::set_root_directory(const Custody& root)
 {
+    LOCKER(m_filesystem_lock);
     m_root_directory = root;
 }
 
 Region& Process::add_region(NonnullOwnPtr<Region> region)
 {
     auto* ptr = region.ptr();
+    LOCKER(m_address_space_lock);
     ScopedSpinLock lock(m_lock);
-    m_regions.append(move(region));
+    m_regions.insert(region_index_after(ptr->vaddr()), move(region));
     return *ptr;
 }
 
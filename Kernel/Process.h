@@ -39,6 +39,7 @@
 #include <Kernel/API/Syscall.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
 #include <Kernel/Forward.h>
+#include <Kernel/IOStatistics.h>
 #include <Kernel/Lock.h>
 #include <Kernel/ProcessGroup.h>
 #include <Kernel/StdLib.h>
@@ -138,6 +139,12 @@ public:
     bool is_profiling() const { return m_profiling; }
     void set_profiling(bool profiling) { m_profiling = profiling; }
 
+    PerformanceEventBuffer* perf_events() { return m_perf_event_buffer; }
+    bool is_tracing_off_cpu() const { return m_tracing_off_cpu; }
+    bool is_recording_syscalls() const { return m_recording_syscalls; }
+    // Must be called with the big lock held.
+    PerformanceEventBuffer& ensure_perf_events();
+
     enum RingLevel : u8 {
         Ring0 = 0,
         Ring3 = 3,
@@ -225,6 +232,18 @@ public:
     ssize_t sys$read(int fd, Userspace<u8*>, ssize_t);
     ssize_t sys$write(int fd, const u8*, ssize_t);
     ssize_t sys$writev(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$readv(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$pread(Userspace<const Syscall::SC_pread_params*>);
+    ssize_t sys$pwrite(Userspace<const Syscall::SC_pwrite_params*>);
+    ssize_t sys$preadv(Userspace<const Syscall::SC_preadv_params*>);
+    ssize_t sys$pwritev(Userspace<const Syscall::SC_preadv_params*>);
+    ssize_t sys$sendfile(Userspace<const Syscall::SC_sendfile_params*>);
+    int sys$io_ring_setup(u32 entries, Userspace<io_ring_params*>);
+    int sys$io_ring_enter(int ring_fd, u32 to_submit, u32 min_completions);
+
+    // Carries out an operation submitted through an IORing. This may run on another thread,
+    // which has to be in this process' paging scope.
+    i32 do_io_ring_operation(const io_ring_sqe&, FileDescription&);
     int sys$fstat(int fd, Userspace<stat*>);
     int sys$stat(Userspace<const Syscall::SC_stat_params*>);
     int sys$lseek(int fd, off_t, int whence);
@@ -238,9 +257,13 @@ public:
     int sys$mprotect(void*, size_t, int prot);
     int sys$madvise(void*, size_t, int advice);
     int sys$minherit(void*, size_t, int inherit);
+    int sys$msync(void*, size_t, int flags);
     int sys$purge(int mode);
     int sys$select(const Syscall::SC_select_params*);
     int sys$poll(Userspace<const Syscall::SC_poll_params*>);
+    int sys$epoll_create(int flags);
+    int sys$epoll_ctl(Userspace<const Syscall::SC_epoll_ctl_params*>);
+    int sys$epoll_wait(Userspace<const Syscall::SC_epoll_wait_params*>);
     ssize_t sys$get_dir_entries(int fd, void*, ssize_t);
     int sys$getcwd(Userspace<char*>, ssize_t);
     int sys$chdir(Userspace<const char*>, size_t);
@@ -259,6 +282,7 @@ public:
     int sys$ptsname(int fd, Userspace<char*>, size_t);
     pid_t sys$fork(RegisterState&);
     int sys$execve(Userspace<const Syscall::SC_execve_params*>);
+    pid_t sys$posix_spawn(Userspace<const Syscall::SC_posix_spawn_params*>);
     int sys$dup2(int old_fd, int new_fd);
     int sys$sigaction(int signum, const sigaction* act, sigaction* old_act);
     int sys$sigprocmask(int how, Userspace<const sigset_t*> set, Userspace<sigset_t*> old_set);
@@ -336,6 +360,10 @@ public:
     int sys$pledge(Userspace<const Syscall::SC_pledge_params*>);
     int sys$unveil(Userspace<const Syscall::SC_unveil_params*>);
     int sys$perf_event(int type, FlatPtr arg1, FlatPtr arg2);
+    int sys$perf_event_stream(pid_t);
+    int sys$perf_counter_sampling(pid_t, int counter, u32 period);
+    int sys$perf_off_cpu_tracing(pid_t, int enabled);
+    int sys$perf_syscall_tracing(pid_t, int enabled);
     int sys$get_stack_bounds(FlatPtr* stack_base, size_t* stack_size);
     int sys$ptrace(Userspace<const Syscall::SC_ptrace_params*>);
     int sys$sendfd(int sockfd, int fd);
@@ -472,8 +500,9 @@ public:
     }
 
     [[nodiscard]] String validate_and_copy_string_from_user(const Syscall::StringArgument&) const;
+    [[nodiscard]] bool copy_string_list_from_user(const Syscall::StringListArgument&, Vector<String>& output);
 
-    Custody& current_directory();
+    NonnullRefPtr<Custody> current_directory();
     Custody* executable()
     {
         return m_executable.ptr();
@@ -493,6 +522,9 @@ public:
     size_t amount_purgeable_volatile() const;
     size_t amount_purgeable_nonvolatile() const;
 
+    // The I/O done by all of the process's threads, including the ones that have exited.
+    IOStatistics io_statistics() const;
+
     int exec(String path, Vector<String> arguments, Vector<String> environment, int recusion_depth = 0);
 
     bool is_superuser() const
@@ -504,6 +536,7 @@ public:
     Region* allocate_region(VirtualAddress, size_t, const String& name, int prot = PROT_READ | PROT_WRITE, bool should_commit = true);
     Region* allocate_region_with_vmobject(const Range&, NonnullRefPtr<VMObject>, size_t offset_in_vmobject, const String& name, int prot);
     Region* allocate_region(const Range&, const String& name, int prot = PROT_READ | PROT_WRITE, bool should_commit = true);
+    Region* allocate_large_page_region(const Range&, const String& name, int prot = PROT_READ | PROT_WRITE);
     bool deallocate_region(Region& region);
 
     Region& allocate_split_region(const Region& source_region, const Range&, size_t offset_in_vmobject);
@@ -522,6 +555,16 @@ public:
         return m_big_lock;
     }
 
+    Lock& address_space_lock()
+    {
+        return m_address_space_lock;
+    }
+
+    Lock& filesystem_lock() const
+    {
+        return m_filesystem_lock;
+    }
+
     struct ELFBundle {
         OwnPtr<Region> region;
         RefPtr<ELF::Loader> elf_loader;
@@ -538,8 +581,8 @@ public:
         return m_priority_boost;
     }
 
-    Custody& root_directory();
-    Custody& root_directory_relative_to_global_root();
+    NonnullRefPtr<Custody> root_directory();
+    NonnullRefPtr<Custody> root_directory_relative_to_global_root();
     void set_root_directory(const Custody&);
 
     bool has_promises() const
@@ -555,6 +598,7 @@ public:
     {
         return m_veil_state;
     }
+    // Callers must hold filesystem_lock() while looking at the unveiled paths.
     const Vector<UnveiledPath>& unveiled_paths() const
     {
         return m_unveiled_paths;
@@ -589,6 +633,8 @@ private:
 
     int do_exec(NonnullRefPtr<FileDescription> main_program_description, Vector<String> arguments, Vector<String> environment, RefPtr<FileDescription> interpreter_description, Thread*& new_main_thread, u32& prev_flags);
     ssize_t do_write(FileDescription&, const u8*, int data_size);
+    KResultOr<Vector<iovec, 32>> copy_iovecs_from_user(const struct iovec* iov, int iov_count, bool for_writing);
+    int madvise_access_pattern(VirtualAddress, size_t, int advice);
 
     KResultOr<NonnullRefPtr<FileDescription>> find_elf_interpreter_for_executable(const String& path, char (&first_page)[PAGE_SIZE], int nread, size_t file_size);
     Vector<AuxiliaryValue> generate_auxiliary_vector() const;
@@ -610,6 +656,8 @@ private:
     }
     KResultOr<String> get_syscall_path_argument(const Syscall::StringArgument&) const;
 
+    KResult apply_spawn_file_action(const Syscall::SC_posix_spawn_file_action&, const String& path);
+
     bool has_tracee_thread(ProcessID tracer_pid) const;
 
     RefPtr<PageDirectory> m_page_directory;
@@ -662,6 +710,10 @@ private:
 
     bool m_dead { false };
     bool m_profiling { false };
+    bool m_tracing_off_cpu { false };
+    bool m_recording_syscalls { false };
+
+    IOStatistics m_exited_threads_io_statistics;
 
     RefPtr<Custody> m_executable;
     RefPtr<Custody> m_cwd;
@@ -672,7 +724,10 @@ private:
 
     Region* find_region_from_range(const Range&);
     Region* find_region_containing(const Range&);
+    size_t region_index_after(VirtualAddress) const;
+    Region* region_at_or_below(VirtualAddress);
 
+    // Sorted by base address.
     NonnullOwnPtrVector<Region> m_regions;
     struct RegionLookupCache {
         Range range;
@@ -692,6 +747,14 @@ private:
     Lock m_big_lock { "Process" };
     mutable SpinLock<u32> m_lock;
 
+    // These protect process state touched by syscalls that don't take the big lock.
+    // They are always taken after the big lock, never before it.
+    mutable SpinLock<u8> m_fds_lock;
+    mutable SpinLock<u8> m_credentials_lock;
+    mutable Lock m_filesystem_lock { "ProcessFS" };
+    // Taken by everything that adds or removes regions, or holds on to a Region* while others may run.
+    Lock m_address_space_lock { "AddressSpace" };
+
     u64 m_alarm_deadline { 0 };
 
     int m_icon_id { -1 };
@@ -705,9 +768,14 @@ private:
     Vector<UnveiledPath> m_unveiled_paths;
 
     WaitQueue& futex_queue(Userspace<const i32*>);
+    int futex_lock_pi(Userspace<i32*>, timeval* timeout, bool try_only);
+    int futex_unlock_pi(Userspace<i32*>);
+    void update_inherited_priority(Thread&);
     HashMap<u32, OwnPtr<WaitQueue>> m_futex_queues;
+    // The owners of PI futexes that have waiters, so we know whom to lend priority to.
+    HashMap<u32, ThreadID> m_pi_futex_owners;
 
-    OwnPtr<PerformanceEventBuffer> m_perf_event_buffer;
+    RefPtr<PerformanceEventBuffer> m_perf_event_buffer;
 
     // This member is used in the implementation of ptrace's PT_TRACEME flag.
     // If it is set to true, the process will stop at the next execve syscall
@@ -815,7 +883,7 @@ inline const LogStream& operator<<(const LogStream& stream, const Process& proce
 
 inline u32 Thread::effective_priority() const
 {
-    return m_priority + m_process->priority_boost() + m_priority_boost + m_extra_priority;
+    return max(m_priority + m_process->priority_boost() + m_priority_boost + m_extra_priority, m_inherited_priority);
 }
 
 #define REQUIRE_NO_PROMISES                        \
@@ -24,16 +24,18 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/QuickSort.h>
 #include <AK/ScopeGuard.h>
 #include <AK/TemporaryChange.h>
 #include <AK/Time.h>
+#include <Kernel/FileSystem/EventPoll.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/IORing.h>
 #include <Kernel/Net/Socket.h>
 #include <Kernel/Process.h>
 #include <Kernel/Profiling.h>
 #include <Kernel/RTC.h>
 #include <Kernel/Scheduler.h>
+#include <Kernel/Tasks/IORingTask.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/TimerQueue.h>
 
@@ -71,6 +73,176 @@ static u32 time_slice_for(const Thread& thread)
     return 10;
 }
 
+// Runnable threads live in per-processor ready queues, one queue per
+// priority bucket. The bit for a bucket is set in the mask while its queue
+// is non-empty, so the highest priority runnable thread is one bit scan away.
+static constexpr u32 g_ready_queue_buckets = 32;
+static constexpr u32 g_max_processors = sizeof(u32) * 8; // One bit per processor in Thread::affinity()
+
+struct ThreadReadyQueue {
+    IntrusiveList<Thread, &Thread::m_ready_queue_node> thread_list;
+};
+
+struct ProcessorReadyQueues {
+    SpinLock<u8> lock;
+    u32 mask { 0 };
+    ThreadReadyQueue queues[g_ready_queue_buckets];
+};
+
+static ProcessorReadyQueues* s_ready_queues;
+
+static inline u32 ready_queue_bucket_for(const Thread& thread)
+{
+    // Bucket 0 holds the highest priority threads.
+    constexpr u32 priority_count = THREAD_PRIORITY_MAX - THREAD_PRIORITY_MIN + 1;
+    u32 priority = min<u32>(max<u32>(thread.effective_priority(), THREAD_PRIORITY_MIN), THREAD_PRIORITY_MAX);
+    return (THREAD_PRIORITY_MAX - priority) * g_ready_queue_buckets / priority_count;
+}
+
+static inline u32 bucket_mask_up_to(u32 max_bucket)
+{
+    if (max_bucket >= g_ready_queue_buckets - 1)
+        return 0xffffffff;
+    return (1u << (max_bucket + 1)) - 1;
+}
+
+static u32 ready_queue_processor_for(const Thread& thread)
+{
+    // Prefer the processor the thread last ran on to keep its caches warm,
+    // otherwise queue it on the first online processor it may run on.
+    u32 processor_count = min(Processor::count(), g_max_processors);
+    u32 online_mask = processor_count >= g_max_processors ? 0xffffffff : (1u << processor_count) - 1;
+    u32 allowed = thread.affinity() & online_mask;
+    u32 cpu = thread.cpu();
+    if (cpu < g_max_processors && (allowed & (1u << cpu)))
+        return cpu;
+    if (allowed)
+        return __builtin_ffs(allowed) - 1;
+    if (thread.affinity())
+        return __builtin_ffs(thread.affinity()) - 1;
+    return 0;
+}
+
+void Scheduler::enqueue_runnable_thread(Thread& thread)
+{
+    ASSERT(s_ready_queues);
+    u32 cpu = ready_queue_processor_for(thread);
+    u32 bucket = ready_queue_bucket_for(thread);
+    auto& ready_queues = s_ready_queues[cpu];
+
+    ScopedSpinLock lock(ready_queues.lock);
+    ASSERT(!thread.m_ready_queue_node.is_in_list());
+    thread.m_ready_queue_cpu = cpu;
+    thread.m_ready_queue_bucket = bucket;
+    ready_queues.queues[bucket].thread_list.append(thread);
+    ready_queues.mask |= 1u << bucket;
+}
+
+bool Scheduler::dequeue_runnable_thread(Thread& thread)
+{
+    ASSERT(s_ready_queues);
+    auto& ready_queues = s_ready_queues[thread.m_ready_queue_cpu];
+
+    ScopedSpinLock lock(ready_queues.lock);
+    if (!thread.m_ready_queue_node.is_in_list())
+        return false;
+    auto& queue = ready_queues.queues[thread.m_ready_queue_bucket];
+    queue.thread_list.remove(thread);
+    if (queue.thread_list.is_empty())
+        ready_queues.mask &= ~(1u << thread.m_ready_queue_bucket);
+    return true;
+}
+
+static Thread* pull_from_ready_queues(ProcessorReadyQueues& ready_queues, u32 cpu, u32 max_bucket)
+{
+    ScopedSpinLock lock(ready_queues.lock);
+    u32 mask = ready_queues.mask & bucket_mask_up_to(max_bucket);
+    while (mask) {
+        u32 bucket = __builtin_ffs(mask) - 1;
+        auto& queue = ready_queues.queues[bucket];
+        for (auto& thread : queue.thread_list) {
+            if (!(thread.affinity() & (1u << cpu)))
+                continue;
+            if (thread.process().exec_tid() && thread.process().exec_tid() != thread.tid())
+                continue;
+            ASSERT(thread.state() == Thread::Runnable);
+            queue.thread_list.remove(thread);
+            if (queue.thread_list.is_empty())
+                ready_queues.mask &= ~(1u << bucket);
+            return &thread;
+        }
+        mask &= ~(1u << bucket);
+    }
+    return nullptr;
+}
+
+Thread* Scheduler::pull_next_runnable_thread(u32 max_bucket)
+{
+    ASSERT(s_ready_queues);
+    u32 cpu = Processor::current().id();
+    if (auto* thread = pull_from_ready_queues(s_ready_queues[cpu], cpu, max_bucket))
+        return thread;
+
+    // Nothing for us locally, steal from the processor with the most urgent
+    // work. The masks are only read as a hint here, pull_from_ready_queues()
+    // re-checks them under the victim's lock.
+    u32 processor_count = min(Processor::count(), g_max_processors);
+    u32 best_victim = cpu;
+    u32 best_bucket = g_ready_queue_buckets;
+    for (u32 victim = 0; victim < processor_count; victim++) {
+        u32 mask = AK::atomic_load(&s_ready_queues[victim].mask, AK::MemoryOrder::memory_order_relaxed);
+        if (victim == cpu || !mask)
+            continue;
+        u32 bucket = __builtin_ffs(mask) - 1;
+        if (bucket < best_bucket) {
+            best_bucket = bucket;
+            best_victim = victim;
+        }
+    }
+    if (best_victim != cpu) {
+        if (auto* thread = pull_from_ready_queues(s_ready_queues[best_victim], cpu, max_bucket))
+            return thread;
+    }
+
+    // The most urgent work may be pinned elsewhere, try everyone else in turn.
+    for (u32 i = 1; i < processor_count; i++) {
+        u32 victim = (cpu + i) % processor_count;
+        if (victim == best_victim)
+            continue;
+        if (auto* thread = pull_from_ready_queues(s_ready_queues[victim], cpu, max_bucket))
+            return thread;
+    }
+    return nullptr;
+}
+
+void Scheduler::age_runnable_threads()
+{
+    // The thread at the front of each queue gains a little priority every time it's passed
+    // over, and moves up a bucket once it has enough. This way a busy higher priority thread
+    // can't starve the others forever, while we only ever look at one thread per bucket.
+    ASSERT(s_ready_queues);
+    auto& ready_queues = s_ready_queues[Processor::current().id()];
+    ScopedSpinLock lock(ready_queues.lock);
+    u32 mask = ready_queues.mask;
+    while (mask) {
+        u32 bucket = __builtin_ffs(mask) - 1;
+        mask &= ~(1u << bucket);
+        auto& queue = ready_queues.queues[bucket];
+        auto& thread = *queue.thread_list.first();
+        if (thread.m_extra_priority < THREAD_PRIORITY_MAX)
+            thread.m_extra_priority++;
+        u32 new_bucket = ready_queue_bucket_for(thread);
+        if (new_bucket == bucket)
+            continue;
+        queue.thread_list.remove(thread);
+        if (queue.thread_list.is_empty())
+            ready_queues.mask &= ~(1u << bucket);
+        thread.m_ready_queue_bucket = new_bucket;
+        ready_queues.queues[new_bucket].thread_list.append(thread);
+        ready_queues.mask |= 1u << new_bucket;
+    }
+}
+
 timeval Scheduler::time_since_boot()
 {
     return { TimeManagement::the().seconds_since_boot(), (suseconds_t)TimeManagement::the().ticks_this_second() * 1000 };
@@ -198,7 +370,23 @@ Thread::SleepBlocker::SleepBlocker(u64 wakeup_time)
 
 bool Thread::SleepBlocker::should_unblock(Thread&)
 {
-    return m_wakeup_time <= g_uptime;
+    if (m_wakeup_time <= g_uptime)
+        return true;
+    TimeManagement::the().request_wakeup_at_tick(m_wakeup_time);
+    return false;
+}
+
+Thread::MonotonicSleepBlocker::MonotonicSleepBlocker(u64 wakeup_time)
+    : m_wakeup_time(wakeup_time)
+{
+}
+
+bool Thread::MonotonicSleepBlocker::should_unblock(Thread&)
+{
+    if (m_wakeup_time <= TimeManagement::the().monotonic_nanoseconds())
+        return true;
+    TimeManagement::the().request_wakeup_at(m_wakeup_time);
+    return false;
 }
 
 Thread::SelectBlocker::SelectBlocker(const FDVector& read_fds, const FDVector& write_fds, const FDVector& except_fds)
@@ -227,6 +415,32 @@ bool Thread::SelectBlocker::should_unblock(Thread& thread)
     return false;
 }
 
+Thread::EventPollBlocker::EventPollBlocker(const EventPoll& event_poll)
+    : m_event_poll(event_poll)
+{
+}
+
+bool Thread::EventPollBlocker::should_unblock(Thread&)
+{
+    return m_event_poll.has_ready_events();
+}
+
+Thread::IORingBlocker::IORingBlocker(const IORing& ring, u32 min_completions)
+    : m_ring(ring)
+    , m_min_completions(min_completions)
+{
+}
+
+bool Thread::IORingBlocker::should_unblock(Thread&)
+{
+    return m_ring.completion_count() >= m_min_completions;
+}
+
+bool Thread::IORingTaskBlocker::should_unblock(Thread&)
+{
+    return IORingTask::has_runnable_work();
+}
+
 Thread::WaitBlocker::WaitBlocker(int wait_options, ProcessID& waitee_pid)
     : m_wait_options(wait_options)
     , m_waitee_pid(waitee_pid)
@@ -302,8 +516,12 @@ void Thread::consider_unblock(time_t now_sec, long now_usec)
         now.tv_sec = now_sec,
         now.tv_nsec = now_usec * 1000ull;
         bool timed_out = m_blocker_timeout && now >= *m_blocker_timeout;
-        if (timed_out || m_blocker->should_unblock(*this))
+        if (timed_out || m_blocker->should_unblock(*this)) {
             unblock();
+            return;
+        }
+        if (m_blocker_timeout)
+            TimeManagement::the().request_wakeup_at((u64)m_blocker_timeout->tv_sec * 1'000'000'000ull + m_blocker_timeout->tv_nsec);
         return;
     }
     case Thread::Skip1SchedulerPass:
@@ -400,6 +618,8 @@ bool Scheduler::pick_next()
             process.m_alarm_deadline = 0;
             // FIXME: Should we observe this signal somehow?
             (void)process.send_signal(SIGALRM, nullptr);
+        } else if (process.m_alarm_deadline) {
+            TimeManagement::the().request_wakeup_at_tick(process.m_alarm_deadline + 1);
         }
         return IterationDecision::Continue;
     });
@@ -443,32 +663,25 @@ bool Scheduler::pick_next()
     });
 #endif
 
-    Vector<Thread*, 128> sorted_runnables;
-    for_each_runnable([&sorted_runnables](auto& thread) {
-        if ((thread.affinity() & (1u << Processor::current().id())) != 0)
-            sorted_runnables.append(&thread);
-        return IterationDecision::Continue;
-    });
-    quick_sort(sorted_runnables, [](auto& a, auto& b) { return a->effective_priority() >= b->effective_priority(); });
-
-    Thread* thread_to_schedule = nullptr;
-
-    for (auto* thread : sorted_runnables) {
-        if (thread->process().exec_tid() && thread->process().exec_tid() != thread->tid())
-            continue;
+    // The current thread keeps running unless someone at the same or a
+    // higher priority is waiting, in which case it goes to the back of its queue.
+    auto& proc = Processor::current();
+    bool current_can_continue = current_thread->state() == Thread::Running
+        && current_thread != proc.idle_thread()
+        && (current_thread->affinity() & (1u << proc.id()))
+        && !(current_thread->process().exec_tid() && current_thread->process().exec_tid() != current_thread->tid());
+    u32 max_bucket = current_can_continue ? ready_queue_bucket_for(*current_thread) : g_ready_queue_buckets - 1;
 
-        ASSERT(thread->state() == Thread::Runnable || thread->state() == Thread::Running);
+    age_runnable_threads();
+    Thread* thread_to_schedule = pull_next_runnable_thread(max_bucket);
+    if (thread_to_schedule)
+        thread_to_schedule->m_extra_priority = 0;
 
-        if (!thread_to_schedule) {
-            thread->m_extra_priority = 0;
-            thread_to_schedule = thread;
-        } else {
-            thread->m_extra_priority++;
-        }
-    }
+    if (!thread_to_schedule && current_can_continue)
+        thread_to_schedule = current_thread;
 
     if (!thread_to_schedule)
-        thread_to_schedule = Processor::current().idle_thread();
+        thread_to_schedule = proc.idle_thread();
 
 #ifdef SCHEDULER_DEBUG
     dbg() << "Scheduler[" << Processor::current().id() << "]: Switch to " << *thread_to_schedule << " @ " << String::format("%04x:%08x", thread_to_schedule->tss().cs, thread_to_schedule->tss().eip);
@@ -650,6 +863,7 @@ void Scheduler::initialize()
 
     Thread* idle_thread = nullptr;
     g_scheduler_data = new SchedulerData;
+    s_ready_queues = new ProcessorReadyQueues[g_max_processors];
     g_finalizer_wait_queue = new WaitQueue;
 
     g_finalizer_has_work.store(false, AK::MemoryOrder::memory_order_release);
@@ -691,7 +905,19 @@ void Scheduler::timer_tick(const RegisterState& regs)
     if (!current_thread)
         return;
 
-    ++g_uptime;
+    auto& time_management = TimeManagement::the();
+    u32 elapsed_ticks = 1;
+    bool wakeup_is_due = false;
+    if (time_management.is_tickless()) {
+        // The timer doesn't fire on every tick while idle, and it may fire
+        // in between ticks when someone asked to be woken up precisely.
+        u64 uptime = time_management.uptime_in_ticks();
+        elapsed_ticks = uptime > g_uptime ? uptime - g_uptime : 0;
+        g_uptime += elapsed_ticks;
+        wakeup_is_due = time_management.rearm_system_timer();
+    } else {
+        ++g_uptime;
+    }
 
     g_timeofday = TimeManagement::now_as_timeval();
 
@@ -709,7 +935,7 @@ void Scheduler::timer_tick(const RegisterState& regs)
 
     TimerQueue::the().fire();
 
-    if (current_thread->tick())
+    if (!wakeup_is_due && (!elapsed_ticks || current_thread->tick(elapsed_ticks)))
         return;
 
     ASSERT_INTERRUPTS_DISABLED();
@@ -742,10 +968,20 @@ void Scheduler::idle_loop()
     ASSERT(are_interrupts_enabled());
 
     for (;;) {
-        asm("hlt");
-
-        if (Processor::current().id() == 0)
+        if (Processor::current().id() == 0) {
+            // Interrupts stay off between programming the system timer and halting,
+            // so that we can't miss an interrupt that makes a thread runnable.
+            cli();
+            TimeManagement::the().enter_idle();
+            asm volatile("sti\n"
+                "hlt");
+            cli();
+            TimeManagement::the().leave_idle();
+            sti();
             yield();
+        } else {
+            asm("hlt");
+        }
     }
 }
 
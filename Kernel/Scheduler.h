@@ -70,6 +70,10 @@ public:
     static void idle_loop();
     static void invoke_async();
     static void notify_finalizer();
+    static void enqueue_runnable_thread(Thread&);
+    static bool dequeue_runnable_thread(Thread&);
+    static Thread* pull_next_runnable_thread(u32 max_bucket);
+    static void age_runnable_threads();
 
     template<typename Callback>
     static inline IterationDecision for_each_runnable(Callback);
@@ -86,6 +86,7 @@ void* SharedBuffer::ref_for_process_and_get_address(Process& process)
 
     for (auto& ref : m_refs) {
         if (ref.pid == process.pid()) {
+            LOCKER(process.address_space_lock());
             if (!ref.region) {
                 auto* region = process.allocate_region_with_vmobject(VirtualAddress(), size(), m_vmobject, 0, "SharedBuffer", PROT_READ | (m_writable ? PROT_WRITE : 0));
                 if (!region)
@@ -94,6 +95,7 @@ void* SharedBuffer::ref_for_process_and_get_address(Process& process)
                 ref.region->set_shared(true);
             }
             ref.count++;
+            ref.offered = false;
             m_total_refs++;
             sanity_check("ref_for_process_and_get_address");
             return ref.region->vaddr().as_ptr();
@@ -110,6 +112,8 @@ void SharedBuffer::share_with(ProcessID peer_pid)
     for (auto& ref : m_refs) {
         if (ref.pid == peer_pid) {
             // don't increment the reference count yet; let them shbuf_get it first.
+            if (!ref.count)
+                ref.offered = true;
             sanity_check("share_with (old ref)");
             return;
         }
@@ -131,7 +135,10 @@ void SharedBuffer::deref_for_process(Process& process)
 #ifdef SHARED_BUFFER_DEBUG
                 dbg() << "Releasing shared buffer reference on " << m_shbuf_id << " of size " << size() << " by PID " << process.pid();
 #endif
-                process.deallocate_region(*ref.region);
+                LOCKER(process.address_space_lock());
+                // The region may already be gone if the process unmapped it by hand.
+                if (ref.region)
+                    process.deallocate_region(*ref.region);
 #ifdef SHARED_BUFFER_DEBUG
                 dbg() << "Released shared buffer reference on " << m_shbuf_id << " of size " << size() << " by PID " << process.pid();
 #endif
@@ -170,14 +177,18 @@ void SharedBuffer::destroy_if_unused()
 {
     LOCKER(shared_buffers().lock());
     sanity_check("destroy_if_unused");
-    if (m_total_refs == 0) {
+    if (m_total_refs != 0)
+        return;
+    for (auto& ref : m_refs) {
+        if (ref.offered)
+            return;
+    }
 #ifdef SHARED_BUFFER_DEBUG
-        dbg() << "Destroying unused SharedBuffer{" << this << "} id: " << m_shbuf_id;
+    dbg() << "Destroying unused SharedBuffer{" << this << "} id: " << m_shbuf_id;
 #endif
-        auto count_before = shared_buffers().resource().size();
-        shared_buffers().resource().remove(m_shbuf_id);
-        ASSERT(count_before != shared_buffers().resource().size());
-    }
+    auto count_before = shared_buffers().resource().size();
+    shared_buffers().resource().remove(m_shbuf_id);
+    ASSERT(count_before != shared_buffers().resource().size());
 }
 
 void SharedBuffer::seal()
@@ -43,6 +43,9 @@ private:
 
         ProcessID pid;
         unsigned count { 0 };
+        // Set while the buffer has been shared with this process, but not taken by it yet.
+        // This keeps the buffer alive if the sharer lets go of it before the peer gets to it.
+        bool offered { true };
         WeakPtr<Region> region;
     };
 
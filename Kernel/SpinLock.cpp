@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/SpinLock.h>
+
+#ifdef SPINLOCK_STATISTICS
+
+namespace Kernel {
+
+// This can't be a SpinLock itself, and it's only ever held with interrupts disabled,
+// so that an interrupt handler taking its first lock can't deadlock against us.
+static Atomic<bool> s_statistics_lock;
+static SpinLockStatistics* s_statistics_head;
+static size_t s_statistics_count;
+
+static void lock_statistics_list()
+{
+    while (s_statistics_lock.exchange(true, AK::memory_order_acquire))
+        asm volatile("pause");
+}
+
+static void unlock_statistics_list()
+{
+    s_statistics_lock.store(false, AK::memory_order_release);
+}
+
+void SpinLockStatistics::register_lock(const void* lock_address)
+{
+    InterruptDisabler disabler;
+    lock_statistics_list();
+    lock = lock_address;
+    registered = true;
+    next = s_statistics_head;
+    if (next)
+        next->prev = this;
+    s_statistics_head = this;
+    ++s_statistics_count;
+    unlock_statistics_list();
+}
+
+void SpinLockStatistics::unregister_lock()
+{
+    if (!registered)
+        return;
+    InterruptDisabler disabler;
+    lock_statistics_list();
+    if (prev)
+        prev->next = next;
+    else
+        s_statistics_head = next;
+    if (next)
+        next->prev = prev;
+    --s_statistics_count;
+    registered = false;
+    unlock_statistics_list();
+}
+
+Vector<SpinLockStatistics> SpinLockStatistics::snapshot()
+{
+    Vector<SpinLockStatistics> statistics;
+    // We can't allocate while holding the list lock, so make some room up front.
+    statistics.ensure_capacity(s_statistics_count + 64);
+
+    InterruptDisabler disabler;
+    lock_statistics_list();
+    for (auto* entry = s_statistics_head; entry && statistics.size() < statistics.capacity(); entry = entry->next)
+        statistics.unchecked_append(*entry);
+    unlock_statistics_list();
+    return statistics;
+}
+
+}
+
+#endif
@@ -31,8 +31,56 @@
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Forward.h>
 
+//#define SPINLOCK_STATISTICS
+
+#ifdef SPINLOCK_STATISTICS
+#    include <AK/Vector.h>
+#endif
+
 namespace Kernel {
 
+#ifdef SPINLOCK_STATISTICS
+// Contention counters for a single lock, exported in /proc/spinlocks.
+// Apart from registration, they're only ever updated by whoever holds the lock.
+struct SpinLockStatistics {
+    const void* lock { nullptr };
+    u64 acquisitions { 0 };
+    u64 contended_acquisitions { 0 };
+    u64 spins { 0 };
+    u64 max_hold_cycles { 0 };
+    u64 acquired_at { 0 };
+    bool registered { false };
+    SpinLockStatistics* next { nullptr };
+    SpinLockStatistics* prev { nullptr };
+
+    ALWAYS_INLINE void did_lock(const void* lock_address, u32 spin_count)
+    {
+        if (!registered)
+            register_lock(lock_address);
+        ++acquisitions;
+        if (spin_count) {
+            ++contended_acquisitions;
+            spins += spin_count;
+        }
+        acquired_at = read_tsc();
+    }
+
+    ALWAYS_INLINE void will_unlock()
+    {
+        u64 hold_cycles = read_tsc() - acquired_at;
+        if (hold_cycles > max_hold_cycles)
+            max_hold_cycles = hold_cycles;
+    }
+
+    void register_lock(const void* lock_address);
+    void unregister_lock();
+
+    static Vector<SpinLockStatistics> snapshot();
+};
+#endif
+
+// A ticket lock: every CPU that wants the lock takes a number and waits until it's being served.
+// This hands the lock out in FIFO order, and waiters only read the shared line until it's their turn.
 template<typename BaseType = u32>
 class SpinLock {
     AK_MAKE_NONCOPYABLE(SpinLock);
@@ -41,37 +89,71 @@ class SpinLock {
 public:
     SpinLock() = default;
 
+#ifdef SPINLOCK_STATISTICS
+    ~SpinLock()
+    {
+        m_statistics.unregister_lock();
+    }
+#endif
+
     ALWAYS_INLINE u32 lock()
     {
         u32 prev_flags;
         Processor::current().enter_critical(prev_flags);
-        BaseType expected = 0;
-        while (!m_lock.compare_exchange_strong(expected, 1, AK::memory_order_acq_rel)) {
+        BaseType ticket = m_next_ticket.fetch_add(1, AK::memory_order_relaxed);
+        [[maybe_unused]] u32 spin_count = 0;
+        while (m_now_serving.load(AK::memory_order_acquire) != ticket) {
             Processor::wait_check();
-            expected = 0;
+            ++spin_count;
         }
+#ifdef SPINLOCK_STATISTICS
+        m_statistics.did_lock(this, spin_count);
+#endif
         return prev_flags;
     }
 
+    // Takes the lock only if nobody holds it or is waiting for it.
+    ALWAYS_INLINE bool try_lock(u32& prev_flags)
+    {
+        Processor::current().enter_critical(prev_flags);
+        BaseType ticket = m_now_serving.load(AK::memory_order_acquire);
+        if (m_next_ticket.compare_exchange_strong(ticket, ticket + 1, AK::memory_order_acquire)) {
+#ifdef SPINLOCK_STATISTICS
+            m_statistics.did_lock(this, 0);
+#endif
+            return true;
+        }
+        Processor::current().leave_critical(prev_flags);
+        return false;
+    }
+
     ALWAYS_INLINE void unlock(u32 prev_flags)
     {
         ASSERT(is_locked());
-        m_lock.store(0, AK::memory_order_release);
+#ifdef SPINLOCK_STATISTICS
+        m_statistics.will_unlock();
+#endif
+        m_now_serving.store(m_now_serving.load(AK::memory_order_relaxed) + 1, AK::memory_order_release);
         Processor::current().leave_critical(prev_flags);
     }
 
     ALWAYS_INLINE bool is_locked() const
     {
-        return m_lock.load(AK::memory_order_consume) != 0;
+        return m_next_ticket.load(AK::memory_order_consume) != m_now_serving.load(AK::memory_order_consume);
     }
 
     ALWAYS_INLINE void initialize()
     {
-        m_lock.store(0, AK::memory_order_release);
+        m_next_ticket.store(0, AK::memory_order_release);
+        m_now_serving.store(0, AK::memory_order_release);
     }
 
 private:
-    AK::Atomic<BaseType> m_lock { 0 };
+    AK::Atomic<BaseType> m_next_ticket { 0 };
+    AK::Atomic<BaseType> m_now_serving { 0 };
+#ifdef SPINLOCK_STATISTICS
+    SpinLockStatistics m_statistics;
+#endif
 };
 
 class RecursiveSpinLock {
@@ -81,18 +163,30 @@ class RecursiveSpinLock {
 public:
     RecursiveSpinLock() = default;
 
+#ifdef SPINLOCK_STATISTICS
+    ~RecursiveSpinLock()
+    {
+        m_statistics.unregister_lock();
+    }
+#endif
+
     ALWAYS_INLINE u32 lock()
     {
         auto& proc = Processor::current();
         FlatPtr cpu = FlatPtr(&proc);
         u32 prev_flags;
         proc.enter_critical(prev_flags);
-        FlatPtr expected = 0;
-        while (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel)) {
-            if (expected == cpu)
-                break;
-            Processor::wait_check();
-            expected = 0;
+        if (m_owner.load(AK::memory_order_relaxed) != cpu) {
+            u32 ticket = m_next_ticket.fetch_add(1, AK::memory_order_relaxed);
+            [[maybe_unused]] u32 spin_count = 0;
+            while (m_now_serving.load(AK::memory_order_acquire) != ticket) {
+                Processor::wait_check();
+                ++spin_count;
+            }
+            m_owner.store(cpu, AK::memory_order_relaxed);
+#ifdef SPINLOCK_STATISTICS
+            m_statistics.did_lock(this, spin_count);
+#endif
         }
         m_recursions++;
         return prev_flags;
@@ -101,30 +195,42 @@ public:
     ALWAYS_INLINE void unlock(u32 prev_flags)
     {
         ASSERT(m_recursions > 0);
-        ASSERT(m_lock.load(AK::memory_order_consume) == FlatPtr(&Processor::current()));
-        if (--m_recursions == 0)
-            m_lock.store(0, AK::memory_order_release);
+        ASSERT(m_owner.load(AK::memory_order_consume) == FlatPtr(&Processor::current()));
+        if (--m_recursions == 0) {
+#ifdef SPINLOCK_STATISTICS
+            m_statistics.will_unlock();
+#endif
+            m_owner.store(0, AK::memory_order_relaxed);
+            m_now_serving.store(m_now_serving.load(AK::memory_order_relaxed) + 1, AK::memory_order_release);
+        }
         Processor::current().leave_critical(prev_flags);
     }
 
     ALWAYS_INLINE bool is_locked() const
     {
-        return m_lock.load(AK::memory_order_consume) != 0;
+        return m_next_ticket.load(AK::memory_order_consume) != m_now_serving.load(AK::memory_order_consume);
     }
 
     ALWAYS_INLINE bool own_lock() const
     {
-        return m_lock.load(AK::memory_order_consume) == FlatPtr(&Processor::current());
+        return m_owner.load(AK::memory_order_consume) == FlatPtr(&Processor::current());
     }
 
     ALWAYS_INLINE void initialize()
     {
-        m_lock.store(0, AK::memory_order_release);
+        m_owner.store(0, AK::memory_order_relaxed);
+        m_next_ticket.store(0, AK::memory_order_release);
+        m_now_serving.store(0, AK::memory_order_release);
     }
 
 private:
-    AK::Atomic<FlatPtr> m_lock { 0 };
+    AK::Atomic<u32> m_next_ticket { 0 };
+    AK::Atomic<u32> m_now_serving { 0 };
+    AK::Atomic<FlatPtr> m_owner { 0 };
     u32 m_recursions { 0 };
+#ifdef SPINLOCK_STATISTICS
+    SpinLockStatistics m_statistics;
+#endif
 };
 
 template<typename LockType>
@@ -25,10 +25,12 @@
  */
 
 #include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
 #include <Kernel/API/Syscall.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
@@ -76,12 +78,26 @@ void initialize()
 
 #pragma GCC diagnostic ignored "-Wcast-function-type"
 typedef int (Process::*Handler)(u32, u32, u32);
-#define __ENUMERATE_SYSCALL(x) reinterpret_cast<Handler>(&Process::sys$##x),
-static Handler s_syscall_table[] = {
+
+struct HandlerMetadata {
+    Handler handler;
+    NeedsBigProcessLock needs_lock;
+};
+
+#define __ENUMERATE_SYSCALL(x, needs_lock) { reinterpret_cast<Handler>(&Process::sys$##x), needs_lock },
+static const HandlerMetadata s_syscall_table[] = {
     ENUMERATE_SYSCALLS(__ENUMERATE_SYSCALL)
 };
 #undef __ENUMERATE_SYSCALL
 
+static bool needs_big_process_lock(u32 function)
+{
+    // Unknown syscalls are rejected in handle(), the lock doesn't matter for them.
+    if (function >= Function::__Count)
+        return true;
+    return s_syscall_table[function].needs_lock == NeedsBigProcessLock::Yes;
+}
+
 int handle(RegisterState& regs, u32 function, u32 arg1, u32 arg2, u32 arg3)
 {
     ASSERT_INTERRUPTS_ENABLED();
@@ -111,11 +127,11 @@ int handle(RegisterState& regs, u32 function, u32 arg1, u32 arg2, u32 arg3)
         return -ENOSYS;
     }
 
-    if (s_syscall_table[function] == nullptr) {
+    if (s_syscall_table[function].handler == nullptr) {
         dbg() << process << ": Null syscall " << function << " requested: \"" << to_string((Function)function) << "\", you probably need to rebuild this program.";
         return -ENOSYS;
     }
-    return (process.*(s_syscall_table[function]))(arg1, arg2, arg3);
+    return (process.*(s_syscall_table[function].handler))(arg1, arg2, arg3);
 }
 
 }
@@ -169,19 +185,34 @@ void syscall_handler(TrapFrame* trap)
         ASSERT_NOT_REACHED();
     }
 
-    process.big_lock().lock();
     u32 function = regs.eax;
     u32 arg1 = regs.edx;
     u32 arg2 = regs.ecx;
     u32 arg3 = regs.ebx;
+
+    bool needs_big_lock = Syscall::needs_big_process_lock(function);
+    if (needs_big_lock)
+        process.big_lock().lock();
+
+    // Recorded syscalls don't stop the thread like ptrace does; they only leave a record in the perf event buffer.
+    // Note that syscalls which never return here (exit, a successful execve) aren't recorded.
+    bool recording = process.is_recording_syscalls();
+    u64 start_ns = recording ? TimeManagement::the().monotonic_nanoseconds() : 0;
+
     regs.eax = (u32)Syscall::handle(regs, function, arg1, arg2, arg3);
 
+    if (recording) {
+        if (auto* perf_events = process.perf_events())
+            (void)perf_events->append_syscall(function, arg1, arg2, arg3, regs.eax, TimeManagement::the().monotonic_nanoseconds() - start_ns);
+    }
+
     if (current_thread->tracer() && current_thread->tracer()->is_tracing_syscalls()) {
         current_thread->tracer()->set_trace_syscalls(false);
         current_thread->tracer_trap(regs);
     }
 
-    process.big_lock().unlock();
+    if (needs_big_lock)
+        process.big_lock().unlock();
 
     // Check if we're supposed to return to userspace or just die.
     current_thread->die_if_needed();
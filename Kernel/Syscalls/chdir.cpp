@@ -40,6 +40,7 @@ int Process::sys$chdir(Userspace<const char*> user_path, size_t path_length)
     auto directory_or_error = VFS::the().open_directory(path.value(), current_directory());
     if (directory_or_error.is_error())
         return directory_or_error.error();
+    LOCKER(m_filesystem_lock);
     m_cwd = *directory_or_error.value();
     return 0;
 }
@@ -57,6 +58,7 @@ int Process::sys$fchdir(int fd)
     if (!description->metadata().may_execute(*this))
         return -EACCES;
 
+    LOCKER(m_filesystem_lock);
     m_cwd = description->custody();
     return 0;
 }
@@ -68,7 +70,7 @@ int Process::sys$getcwd(Userspace<char*> buffer, ssize_t size)
         return -EINVAL;
     if (!validate_write(buffer, size))
         return -EFAULT;
-    auto path = current_directory().absolute_path();
+    auto path = current_directory()->absolute_path();
     if ((size_t)size < path.length() + 1)
         return -ERANGE;
     copy_to_user(buffer, path.characters(), path.length() + 1);
@@ -43,6 +43,7 @@ int Process::sys$chroot(Userspace<const char*> user_path, size_t path_length, in
     if (directory_or_error.is_error())
         return directory_or_error.error();
     auto directory = directory_or_error.value();
+    LOCKER(m_filesystem_lock);
     m_root_directory_relative_to_global_root = directory;
     int chroot_mount_flags = mount_flags == -1 ? directory->mount_flags() : mount_flags;
     set_root_directory(Custody::create(nullptr, "", directory->inode(), chroot_mount_flags));
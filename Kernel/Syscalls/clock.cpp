@@ -39,8 +39,7 @@ int Process::sys$clock_gettime(clockid_t clock_id, Userspace<timespec*> user_ts)
 
     switch (clock_id) {
     case CLOCK_MONOTONIC:
-        ts.tv_sec = TimeManagement::the().seconds_since_boot();
-        ts.tv_nsec = TimeManagement::the().ticks_this_second() * 1000000;
+        ts = TimeManagement::the().monotonic_time();
         break;
     case CLOCK_REALTIME:
         ts.tv_sec = TimeManagement::the().epoch_time();
@@ -94,21 +93,18 @@ int Process::sys$clock_nanosleep(Userspace<const Syscall::SC_clock_nanosleep_par
 
     bool is_absolute = params.flags & TIMER_ABSTIME;
 
+    if (requested_sleep.tv_sec < 0 || requested_sleep.tv_nsec < 0 || requested_sleep.tv_nsec >= 1'000'000'000)
+        return -EINVAL;
+
     switch (params.clock_id) {
     case CLOCK_MONOTONIC: {
-        u64 wakeup_time;
-        if (is_absolute) {
-            u64 time_to_wake = (requested_sleep.tv_sec * 1000 + requested_sleep.tv_nsec / 1000000);
-            wakeup_time = Thread::current()->sleep_until(time_to_wake);
-        } else {
-            u64 ticks_to_sleep = requested_sleep.tv_sec * TimeManagement::the().ticks_per_second();
-            ticks_to_sleep += requested_sleep.tv_nsec * TimeManagement::the().ticks_per_second() / 1000000000;
-            if (!ticks_to_sleep)
-                return 0;
-            wakeup_time = Thread::current()->sleep(ticks_to_sleep);
-        }
-        if (wakeup_time > g_uptime) {
-            u64 ticks_left = wakeup_time - g_uptime;
+        u64 requested_time = (u64)requested_sleep.tv_sec * 1'000'000'000ull + requested_sleep.tv_nsec;
+        u64 now = TimeManagement::the().monotonic_nanoseconds();
+        u64 wakeup_time = is_absolute ? requested_time : now + requested_time;
+        if (wakeup_time <= now)
+            return 0;
+        if (!Thread::current()->sleep_until_monotonic(wakeup_time)) {
+            now = TimeManagement::the().monotonic_nanoseconds();
             if (!is_absolute && params.remaining_sleep) {
                 if (!validate_write_typed(params.remaining_sleep)) {
                     // This can happen because the lock is dropped while
@@ -117,10 +113,10 @@ int Process::sys$clock_nanosleep(Userspace<const Syscall::SC_clock_nanosleep_par
                     return -EFAULT;
                 }
 
+                u64 time_left = wakeup_time > now ? wakeup_time - now : 0;
                 timespec remaining_sleep = {};
-                remaining_sleep.tv_sec = ticks_left / TimeManagement::the().ticks_per_second();
-                ticks_left -= remaining_sleep.tv_sec * TimeManagement::the().ticks_per_second();
-                remaining_sleep.tv_nsec = ticks_left * 1000000000 / TimeManagement::the().ticks_per_second();
+                remaining_sleep.tv_sec = time_left / 1'000'000'000ull;
+                remaining_sleep.tv_nsec = time_left % 1'000'000'000ull;
                 copy_to_user(params.remaining_sleep, &remaining_sleep);
             }
             return -EINTR;
@@ -39,6 +39,10 @@ int Process::sys$dup2(int old_fd, int new_fd)
         return 0;
     if (new_fd < 0 || new_fd >= m_max_open_file_descriptors)
         return -EINVAL;
+    // Keep whatever was at new_fd alive until we've dropped the lock.
+    RefPtr<FileDescription> replaced_description;
+    ScopedSpinLock lock(m_fds_lock);
+    replaced_description = m_fds[new_fd].description();
     m_fds[new_fd].set(*description);
     return new_fd;
 }
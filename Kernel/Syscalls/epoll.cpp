@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/ScopedValueRollback.h>
+#include <AK/Time.h>
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+int Process::sys$epoll_create(int flags)
+{
+    REQUIRE_PROMISE(stdio);
+    if (flags & ~EPOLL_CLOEXEC)
+        return -EINVAL;
+
+    auto description = FileDescription::create(EventPoll::create());
+    description->set_readable(true);
+
+    u32 fd_flags = (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0;
+    ScopedSpinLock lock(m_fds_lock);
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+    m_fds[fd].set(move(description), fd_flags);
+    return fd;
+}
+
+int Process::sys$epoll_ctl(Userspace<const Syscall::SC_epoll_ctl_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_epoll_ctl_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    auto epoll_description = file_description(params.epoll_fd);
+    if (!epoll_description)
+        return -EBADF;
+    if (!epoll_description->file().is_event_poll())
+        return -EINVAL;
+    auto& event_poll = static_cast<EventPoll&>(epoll_description->file());
+
+    // Removing works for fds that have already been closed, so callers don't have to be careful about the order.
+    if (params.op == EPOLL_CTL_DEL)
+        return event_poll.remove(params.fd);
+
+    epoll_event event;
+    if (!validate_read_and_copy_typed(&event, params.event))
+        return -EFAULT;
+    if (event.events & ~(EPOLLIN | EPOLLOUT))
+        return -EINVAL;
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+
+    switch (params.op) {
+    case EPOLL_CTL_ADD:
+        return event_poll.add(params.fd, *description, event.events, event.data.u64);
+    case EPOLL_CTL_MOD:
+        return event_poll.modify(params.fd, *description, event.events, event.data.u64);
+    }
+    return -EINVAL;
+}
+
+int Process::sys$epoll_wait(Userspace<const Syscall::SC_epoll_wait_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_epoll_wait_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    if (params.max_events <= 0 || params.max_events > FD_SETSIZE)
+        return -EINVAL;
+    if (!validate_write_typed(params.events, params.max_events))
+        return -EFAULT;
+
+    timespec timeout = {};
+    if (params.timeout && !validate_read_and_copy_typed(&timeout, params.timeout))
+        return -EFAULT;
+
+    sigset_t sigmask = {};
+    if (params.sigmask && !validate_read_and_copy_typed(&sigmask, params.sigmask))
+        return -EFAULT;
+
+    auto epoll_description = file_description(params.epoll_fd);
+    if (!epoll_description)
+        return -EBADF;
+    if (!epoll_description->file().is_event_poll())
+        return -EINVAL;
+    auto& event_poll = static_cast<EventPoll&>(epoll_description->file());
+
+    timespec actual_timeout;
+    bool has_timeout = false;
+    if (params.timeout && (timeout.tv_sec || timeout.tv_nsec)) {
+        timespec ts_since_boot;
+        timeval_to_timespec(Scheduler::time_since_boot(), ts_since_boot);
+        timespec_add(ts_since_boot, timeout, actual_timeout);
+        has_timeout = true;
+    }
+
+    auto current_thread = Thread::current();
+    ScopedValueRollback scoped_sigmask(current_thread->m_signal_mask);
+    if (params.sigmask)
+        current_thread->m_signal_mask = sigmask;
+
+    if (!params.timeout || has_timeout) {
+        if (current_thread->block<Thread::EventPollBlocker>(has_timeout ? &actual_timeout : nullptr, event_poll).was_interrupted())
+            return -EINTR;
+    }
+
+    Vector<epoll_event, 32> ready_events;
+    ready_events.resize(params.max_events);
+    size_t ready_count = event_poll.collect_ready_events(*this, ready_events.data(), ready_events.size());
+
+    // Validate we can still write after waking up.
+    if (!validate_write_typed(params.events, ready_count))
+        return -EFAULT;
+    copy_to_user(params.events, ready_events.data(), ready_count * sizeof(epoll_event));
+    return ready_count;
+}
+
+}
@@ -89,6 +89,8 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     NonnullOwnPtrVector<Region> old_regions;
 
     {
+        // Other threads may still be in mmap() and friends until they notice they're dying.
+        LOCKER(m_address_space_lock);
         // Need to make sure we don't swap contexts in the middle
         ScopedCritical critical;
         old_page_directory = move(m_page_directory);
@@ -131,7 +133,7 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     RefPtr<ELF::Loader> loader;
     {
         ArmedScopeGuard rollback_regions_guard([&]() {
-            ASSERT(Process::current() == this);
+            LOCKER(m_address_space_lock);
             // Need to make sure we don't swap contexts in the middle
             ScopedCritical critical;
             m_page_directory = move(old_page_directory);
@@ -154,6 +156,7 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
                 prot |= PROT_WRITE;
             if (is_executable)
                 prot |= PROT_EXEC;
+            LOCKER(m_address_space_lock);
             if (auto* region = allocate_region_with_vmobject(vaddr.offset(m_load_offset), size, *vmobject, offset_in_image, String(name), prot)) {
                 region->set_shared(true);
                 return region->vaddr().as_ptr();
@@ -168,6 +171,7 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
                 prot |= PROT_READ;
             if (is_writable)
                 prot |= PROT_WRITE;
+            LOCKER(m_address_space_lock);
             if (auto* region = allocate_region(vaddr.offset(m_load_offset), size, String(name), prot))
                 return region->vaddr().as_ptr();
             return nullptr;
@@ -181,6 +185,7 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
         //     some ELF Auxilliary Vector so the loader can use it/create new ones as necessary.
         loader->tls_section_hook = [&](size_t size, size_t alignment) {
             ASSERT(size);
+            LOCKER(m_address_space_lock);
             master_tls_region = allocate_region({}, size, String(), PROT_READ | PROT_WRITE);
             master_tls_size = size;
             master_tls_alignment = alignment;
@@ -217,8 +222,11 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
 
     m_promises = m_execpromises;
 
-    m_veil_state = VeilState::None;
-    m_unveiled_paths.clear();
+    {
+        LOCKER(m_filesystem_lock);
+        m_veil_state = VeilState::None;
+        m_unveiled_paths.clear();
+    }
 
     // Copy of the master TLS region that we will clone for new threads
     // FIXME: Handle this in userspace
@@ -227,16 +235,13 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     auto main_program_metadata = main_program_description->metadata();
 
     if (!(main_program_description->custody()->mount_flags() & MS_NOSUID)) {
+        ScopedSpinLock lock(m_credentials_lock);
         if (main_program_metadata.is_setuid())
             m_euid = m_suid = main_program_metadata.uid;
         if (main_program_metadata.is_setgid())
             m_egid = m_sgid = main_program_metadata.gid;
     }
 
-    current_thread->set_default_signal_dispositions();
-    current_thread->m_signal_mask = 0;
-    current_thread->m_pending_signals = 0;
-
     m_futex_queues.clear();
 
     m_region_lookup_cache = {};
@@ -244,12 +249,17 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     disown_all_shared_buffers();
 
     for (size_t i = 0; i < m_fds.size(); ++i) {
-        auto& description_and_flags = m_fds[i];
-        if (description_and_flags.description() && description_and_flags.flags() & FD_CLOEXEC) {
-            // FIXME: Should this error path be observed somehow?
-            (void)description_and_flags.description()->close();
+        RefPtr<FileDescription> description;
+        {
+            ScopedSpinLock lock(m_fds_lock);
+            auto& description_and_flags = m_fds[i];
+            if (!description_and_flags.description() || !(description_and_flags.flags() & FD_CLOEXEC))
+                continue;
+            description = description_and_flags.description();
             description_and_flags = {};
         }
+        // FIXME: Should this error path be observed somehow?
+        (void)description->close();
     }
 
     new_main_thread = nullptr;
@@ -263,12 +273,21 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     }
     ASSERT(new_main_thread);
 
+    new_main_thread->set_default_signal_dispositions();
+    new_main_thread->m_signal_mask = 0;
+    new_main_thread->m_pending_signals = 0;
+
     auto auxv = generate_auxiliary_vector();
 
     // NOTE: We create the new stack before disabling interrupts since it will zero-fault
     //       and we don't want to deal with faults after this point.
     u32 new_userspace_esp = new_main_thread->make_userspace_stack_for_main_thread(move(arguments), move(environment), move(auxv));
 
+    // Same for the thread-specific region, which also has to take the address space lock.
+    m_master_tls_size = master_tls_size;
+    m_master_tls_alignment = master_tls_alignment;
+    new_main_thread->make_thread_specific_region({});
+
     if (wait_for_tracer_at_next_execve())
         Thread::current()->send_urgent_signal_to_self(SIGSTOP);
 
@@ -282,12 +301,8 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     m_name = parts.take_last();
     new_main_thread->set_name(m_name);
 
-    m_master_tls_size = master_tls_size;
-    m_master_tls_alignment = master_tls_alignment;
-
     // FIXME: PID/TID ISSUE
     m_pid = new_main_thread->tid().value();
-    new_main_thread->make_thread_specific_region({});
     new_main_thread->reset_fpu_state();
 
     auto& tss = new_main_thread->m_tss;
@@ -547,6 +562,24 @@ int Process::exec(String path, Vector<String> arguments, Vector<String> environm
     return 0;
 }
 
+bool Process::copy_string_list_from_user(const Syscall::StringListArgument& list, Vector<String>& output)
+{
+    if (!list.length)
+        return true;
+    if (!validate_read_typed(list.strings, list.length))
+        return false;
+    Vector<Syscall::StringArgument, 32> strings;
+    strings.resize(list.length);
+    copy_from_user(strings.data(), list.strings.unsafe_userspace_ptr(), list.length * sizeof(Syscall::StringArgument));
+    for (size_t i = 0; i < list.length; ++i) {
+        auto string = validate_and_copy_string_from_user(strings[i]);
+        if (string.is_null())
+            return false;
+        output.append(move(string));
+    }
+    return true;
+}
+
 int Process::sys$execve(Userspace<const Syscall::SC_execve_params*> user_params)
 {
     REQUIRE_PROMISE(exec);
@@ -571,29 +604,12 @@ int Process::sys$execve(Userspace<const Syscall::SC_execve_params*> user_params)
         path = path_arg.value();
     }
 
-    auto copy_user_strings = [this](const auto& list, auto& output) {
-        if (!list.length)
-            return true;
-        if (!validate_read_typed(list.strings, list.length))
-            return false;
-        Vector<Syscall::StringArgument, 32> strings;
-        strings.resize(list.length);
-        copy_from_user(strings.data(), list.strings.unsafe_userspace_ptr(), list.length * sizeof(Syscall::StringArgument));
-        for (size_t i = 0; i < list.length; ++i) {
-            auto string = validate_and_copy_string_from_user(strings[i]);
-            if (string.is_null())
-                return false;
-            output.append(move(string));
-        }
-        return true;
-    };
-
     Vector<String> arguments;
-    if (!copy_user_strings(params.arguments, arguments))
+    if (!copy_string_list_from_user(params.arguments, arguments))
         return -EFAULT;
 
     Vector<String> environment;
-    if (!copy_user_strings(params.environment, environment))
+    if (!copy_string_list_from_user(params.environment, environment))
         return -EFAULT;
 
     int rc = exec(move(path), move(arguments), move(environment));
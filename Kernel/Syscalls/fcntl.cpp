@@ -45,6 +45,7 @@ int Process::sys$fcntl(int fd, int cmd, u32 arg)
         int arg_fd = (int)arg;
         if (arg_fd < 0)
             return -EINVAL;
+        ScopedSpinLock lock(m_fds_lock);
         int new_fd = alloc_fd(arg_fd);
         if (new_fd < 0)
             return new_fd;
@@ -52,10 +53,14 @@ int Process::sys$fcntl(int fd, int cmd, u32 arg)
         return new_fd;
     }
     case F_GETFD:
-        return m_fds[fd].flags();
-    case F_SETFD:
+        return fd_flags(fd);
+    case F_SETFD: {
+        ScopedSpinLock lock(m_fds_lock);
+        if (description != m_fds[fd].description())
+            return -EBADF;
         m_fds[fd].set_flags(arg);
         break;
+    }
     case F_GETFL:
         return description->file_flags();
     case F_SETFL:
@@ -63,6 +68,18 @@ int Process::sys$fcntl(int fd, int cmd, u32 arg)
         break;
     case F_ISTTY:
         return description->is_tty();
+    case F_GETPIPE_SZ:
+        if (!description->is_fifo())
+            return -EINVAL;
+        return description->fifo()->capacity();
+    case F_SETPIPE_SZ: {
+        if (!description->is_fifo())
+            return -EINVAL;
+        auto result = description->fifo()->set_capacity(arg);
+        if (result.is_error())
+            return result.error();
+        return result.value();
+    }
     default:
         return -EINVAL;
     }
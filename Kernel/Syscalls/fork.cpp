@@ -26,8 +26,11 @@
 
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Process.h>
+#include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/Region.h>
+#include <LibC/limits.h>
 
 //#define FORK_DEBUG
 
@@ -37,14 +40,20 @@ pid_t Process::sys$fork(RegisterState& regs)
 {
     REQUIRE_PROMISE(proc);
     Thread* child_first_thread = nullptr;
-    auto* child = new Process(child_first_thread, m_name, m_uid, m_gid, m_pid, m_ring, m_cwd, m_executable, m_tty, this);
-    child->m_root_directory = m_root_directory;
-    child->m_root_directory_relative_to_global_root = m_root_directory_relative_to_global_root;
+    auto* child = new Process(child_first_thread, m_name, m_uid, m_gid, m_pid, m_ring, current_directory(), m_executable, m_tty, this);
+    {
+        LOCKER(m_filesystem_lock);
+        child->m_root_directory = m_root_directory;
+        child->m_root_directory_relative_to_global_root = m_root_directory_relative_to_global_root;
+        child->m_veil_state = m_veil_state;
+        child->m_unveiled_paths = m_unveiled_paths;
+    }
     child->m_promises = m_promises;
     child->m_execpromises = m_execpromises;
-    child->m_veil_state = m_veil_state;
-    child->m_unveiled_paths = m_unveiled_paths;
-    child->m_fds = m_fds;
+    {
+        ScopedSpinLock lock(m_fds_lock);
+        child->m_fds = m_fds;
+    }
     child->m_sid = m_sid;
     child->m_pg = m_pg;
     child->m_umask = m_umask;
@@ -77,13 +86,17 @@ pid_t Process::sys$fork(RegisterState& regs)
     dbg() << "fork: child will begin executing at " << String::format("%w", child_tss.cs) << ":" << String::format("%x", child_tss.eip) << " with stack " << String::format("%w", child_tss.ss) << ":" << String::format("%x", child_tss.esp) << ", kstack " << String::format("%w", child_tss.ss0) << ":" << String::format("%x", child_tss.esp0);
 #endif
 
-    ScopedSpinLock lock(m_lock);
+    // Keep our other threads from mapping or unmapping anything while we copy the region list.
+    // All changes to it are made with this lock held, so we don't need m_lock for reading.
+    LOCKER(m_address_space_lock);
     for (auto& region : m_regions) {
 #ifdef FORK_DEBUG
         dbg() << "fork: cloning Region{" << &region << "} '" << region.name() << "' @ " << region.vaddr();
 #endif
+        // The child's page tables are filled in on demand, since the child will most likely
+        // execve() or touch only a small part of its address space before it does.
         auto& child_region = child->add_region(region.clone());
-        child_region.map(child->page_directory());
+        child_region.map_lazily(child->page_directory());
 
         if (&region == m_master_tls_region)
             child->m_master_tls_region = child_region.make_weak_ptr();
@@ -98,4 +111,174 @@ pid_t Process::sys$fork(RegisterState& regs)
     return child->pid().value();
 }
 
+KResult Process::apply_spawn_file_action(const Syscall::SC_posix_spawn_file_action& action, const String& path)
+{
+    switch (action.type) {
+    case Syscall::SpawnFileActionType::Close: {
+        RefPtr<FileDescription> description;
+        {
+            ScopedSpinLock lock(m_fds_lock);
+            if (action.fd >= 0 && static_cast<size_t>(action.fd) < m_fds.size()) {
+                description = m_fds[action.fd].description();
+                m_fds[action.fd] = {};
+            }
+        }
+        if (!description)
+            return KResult(-EBADF);
+        return description->close();
+    }
+    case Syscall::SpawnFileActionType::Dup2: {
+        auto description = file_description(action.fd);
+        if (!description)
+            return KResult(-EBADF);
+        if (action.new_fd < 0 || action.new_fd >= m_max_open_file_descriptors)
+            return KResult(-EINVAL);
+        if (action.fd == action.new_fd)
+            return KSuccess;
+        RefPtr<FileDescription> replaced_description;
+        ScopedSpinLock lock(m_fds_lock);
+        replaced_description = m_fds[action.new_fd].description();
+        m_fds[action.new_fd].set(*description);
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Open: {
+        if (action.fd < 0 || action.fd >= m_max_open_file_descriptors)
+            return KResult(-EBADF);
+        auto result = VFS::the().open(path, action.options, (action.mode & 04777) & ~umask(), current_directory());
+        if (result.is_error())
+            return result.error();
+        u32 fd_flags = (action.options & O_CLOEXEC) ? FD_CLOEXEC : 0;
+        RefPtr<FileDescription> replaced_description;
+        ScopedSpinLock lock(m_fds_lock);
+        replaced_description = m_fds[action.fd].description();
+        m_fds[action.fd].set(result.release_value(), fd_flags);
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Chdir: {
+        auto directory_or_error = VFS::the().open_directory(path, current_directory());
+        if (directory_or_error.is_error())
+            return directory_or_error.error();
+        LOCKER(m_filesystem_lock);
+        m_cwd = *directory_or_error.value();
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Fchdir: {
+        auto description = file_description(action.fd);
+        if (!description)
+            return KResult(-EBADF);
+        if (!description->is_directory())
+            return KResult(-ENOTDIR);
+        if (!description->metadata().may_execute(*this))
+            return KResult(-EACCES);
+        LOCKER(m_filesystem_lock);
+        m_cwd = description->custody();
+        return KSuccess;
+    }
+    }
+    return KResult(-EINVAL);
+}
+
+// Creates a new process and execs the program in it straight away. Unlike fork() + execve(),
+// none of our mappings are ever cloned into the child.
+pid_t Process::sys$posix_spawn(Userspace<const Syscall::SC_posix_spawn_params*> user_params)
+{
+    REQUIRE_PROMISE(proc);
+    REQUIRE_PROMISE(exec);
+
+    Syscall::SC_posix_spawn_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    if (params.arguments.length > ARG_MAX || params.environment.length > ARG_MAX)
+        return -E2BIG;
+
+    // Each file action can at most touch one descriptor, so there's no use for more than that.
+    if (params.file_action_count > (size_t)m_max_open_file_descriptors)
+        return -E2BIG;
+
+    String path;
+    {
+        auto path_arg = get_syscall_path_argument(params.path);
+        if (path_arg.is_error())
+            return path_arg.error();
+        path = path_arg.value();
+    }
+
+    Vector<String> arguments;
+    if (!copy_string_list_from_user(params.arguments, arguments))
+        return -EFAULT;
+
+    Vector<String> environment;
+    if (!copy_string_list_from_user(params.environment, environment))
+        return -EFAULT;
+
+    Vector<Syscall::SC_posix_spawn_file_action> file_actions;
+    Vector<String> file_action_paths;
+    if (params.file_action_count) {
+        if (!validate_read_typed(params.file_actions, params.file_action_count))
+            return -EFAULT;
+        file_actions.resize(params.file_action_count);
+        copy_from_user(file_actions.data(), params.file_actions.unsafe_userspace_ptr(), params.file_action_count * sizeof(Syscall::SC_posix_spawn_file_action));
+        for (auto& action : file_actions) {
+            if (action.type != Syscall::SpawnFileActionType::Open && action.type != Syscall::SpawnFileActionType::Chdir) {
+                file_action_paths.append(String());
+                continue;
+            }
+            auto path_arg = get_syscall_path_argument(action.path);
+            if (path_arg.is_error())
+                return path_arg.error();
+            file_action_paths.append(path_arg.value());
+        }
+    }
+
+    Thread* child_first_thread = nullptr;
+    auto child = adopt(*new Process(child_first_thread, m_name, m_uid, m_gid, m_pid, m_ring, current_directory(), m_executable, m_tty));
+    {
+        LOCKER(m_filesystem_lock);
+        child->m_root_directory = m_root_directory;
+        child->m_root_directory_relative_to_global_root = m_root_directory_relative_to_global_root;
+        child->m_veil_state = m_veil_state;
+        child->m_unveiled_paths = m_unveiled_paths;
+    }
+    child->m_promises = m_promises;
+    child->m_execpromises = m_execpromises;
+    {
+        ScopedSpinLock lock(m_fds_lock);
+        child->m_fds = m_fds;
+    }
+    child->m_euid = m_euid;
+    child->m_egid = m_egid;
+    child->m_suid = m_suid;
+    child->m_sgid = m_sgid;
+    child->m_sid = m_sid;
+    child->m_pg = m_pg;
+    child->m_umask = m_umask;
+    child->m_extra_gids = m_extra_gids;
+
+    for (size_t i = 0; i < file_actions.size(); ++i) {
+        auto result = child->apply_spawn_file_action(file_actions[i], file_action_paths[i]);
+        if (result.is_error()) {
+            delete child_first_thread;
+            return result;
+        }
+    }
+
+    int rc = child->exec(move(path), move(arguments), move(environment));
+
+    // exec() loads the program through the child's page directory, so switch back to ours.
+    MM.enter_process_paging_scope(*this);
+
+    if (rc < 0) {
+        delete child_first_thread;
+        return rc;
+    }
+
+    {
+        ScopedSpinLock lock(g_processes_lock);
+        g_processes->prepend(child);
+        child->ref();
+    }
+    return child->pid().value();
+}
+
 }
@@ -24,8 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+
 #include <AK/Time.h>
 #include <Kernel/Process.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
@@ -42,6 +44,31 @@ static void compute_relative_timeout_from_absolute(const timespec& absolute_time
     compute_relative_timeout_from_absolute(tv_absolute_time, relative_time);
 }
 
+static void compute_relative_timeout_from_absolute_monotonic(const timespec& absolute_time, timeval& relative_time)
+{
+    timespec relative_timespec;
+    timespec_sub(absolute_time, TimeManagement::the().monotonic_time(), relative_timespec);
+    timespec_to_timeval(relative_timespec, relative_time);
+}
+
+static u32 futex_load(Userspace<i32*> userspace_address)
+{
+    SmapDisabler disabler;
+    return __atomic_load_n((const u32*)userspace_address.unsafe_userspace_ptr(), __ATOMIC_SEQ_CST);
+}
+
+static bool futex_compare_exchange(Userspace<i32*> userspace_address, u32& expected, u32 desired)
+{
+    SmapDisabler disabler;
+    return __atomic_compare_exchange_n((u32*)userspace_address.unsafe_userspace_ptr(), &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static void futex_store(Userspace<i32*> userspace_address, u32 value)
+{
+    SmapDisabler disabler;
+    __atomic_store_n((u32*)userspace_address.unsafe_userspace_ptr(), value, __ATOMIC_SEQ_CST);
+}
+
 WaitQueue& Process::futex_queue(Userspace<const i32*> userspace_address)
 {
     auto& queue = m_futex_queues.ensure(userspace_address.ptr());
@@ -50,6 +77,92 @@ WaitQueue& Process::futex_queue(Userspace<const i32*> userspace_address)
     return *queue;
 }
 
+void Process::update_inherited_priority(Thread& thread)
+{
+    u32 priority = 0;
+    for (auto& it : m_pi_futex_owners) {
+        if (it.value != thread.tid())
+            continue;
+        auto queue = m_futex_queues.find(it.key);
+        if (queue != m_futex_queues.end())
+            priority = max(priority, queue->value->highest_waiter_priority());
+    }
+    thread.set_inherited_priority(priority);
+}
+
+int Process::futex_lock_pi(Userspace<i32*> userspace_address, timeval* timeout, bool try_only)
+{
+    auto* current_thread = Thread::current();
+    u32 tid = current_thread->tid().value();
+
+    for (;;) {
+        u32 value = futex_load(userspace_address);
+        u32 owner_tid = value & FUTEX_TID_MASK;
+        if (owner_tid == tid)
+            return -EDEADLK;
+
+        // A lock whose owner is gone is up for grabs, same as an unlocked one.
+        auto* owner = owner_tid ? Thread::from_tid(owner_tid) : nullptr;
+        if (owner && &owner->process() != this)
+            owner = nullptr;
+        if (!owner) {
+            if (!futex_compare_exchange(userspace_address, value, tid | (value & FUTEX_WAITERS)))
+                continue;
+            if (value & FUTEX_WAITERS)
+                m_pi_futex_owners.set(userspace_address.ptr(), tid);
+            return 0;
+        }
+
+        if (try_only)
+            return -EAGAIN;
+
+        if (!(value & FUTEX_WAITERS) && !futex_compare_exchange(userspace_address, value, value | FUTEX_WAITERS))
+            continue;
+
+        m_pi_futex_owners.set(userspace_address.ptr(), owner->tid());
+        owner->set_inherited_priority(max(owner->inherited_priority(), current_thread->effective_priority()));
+
+        auto result = current_thread->wait_on(futex_queue(userspace_address.ptr()), "Futex PI", timeout);
+
+        // The unlocking thread hands the lock straight to the waiter it wakes.
+        if ((futex_load(userspace_address) & FUTEX_TID_MASK) == tid)
+            return 0;
+        if (result == Thread::BlockResult::InterruptedByTimeout) {
+            if (auto* current_owner = Thread::from_tid(futex_load(userspace_address) & FUTEX_TID_MASK))
+                update_inherited_priority(*current_owner);
+            return -ETIMEDOUT;
+        }
+    }
+}
+
+int Process::futex_unlock_pi(Userspace<i32*> userspace_address)
+{
+    auto* current_thread = Thread::current();
+    u32 tid = current_thread->tid().value();
+
+    u32 value = futex_load(userspace_address);
+    if ((value & FUTEX_TID_MASK) != tid)
+        return -EPERM;
+
+    auto& queue = futex_queue(userspace_address.ptr());
+    auto* next_owner = queue.wake_highest_priority();
+    if (!next_owner) {
+        m_pi_futex_owners.remove(userspace_address.ptr());
+        futex_store(userspace_address, 0);
+    } else {
+        bool has_more_waiters = !queue.is_empty();
+        futex_store(userspace_address, next_owner->tid().value() | (has_more_waiters ? FUTEX_WAITERS : 0));
+        if (has_more_waiters)
+            m_pi_futex_owners.set(userspace_address.ptr(), next_owner->tid());
+        else
+            m_pi_futex_owners.remove(userspace_address.ptr());
+        update_inherited_priority(*next_owner);
+    }
+
+    update_inherited_priority(*current_thread);
+    return 0;
+}
+
 int Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
 {
     REQUIRE_PROMISE(thread);
@@ -61,27 +174,46 @@ int Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
     if (!validate_read_typed(params.userspace_address))
         return -EFAULT;
 
-    switch (params.futex_op) {
-    case FUTEX_WAIT: {
-        i32 user_value;
-        copy_from_user(&user_value, params.userspace_address);
-        if (user_value != params.val)
-            return -EAGAIN;
+    int command = params.futex_op & FUTEX_CMD_MASK;
+    bool use_realtime_clock = params.futex_op & FUTEX_CLOCK_REALTIME;
 
+    timeval* optional_timeout = nullptr;
+    timeval relative_timeout { 0, 0 };
+    if (params.timeout && (command == FUTEX_WAIT || command == FUTEX_WAIT_BITSET || command == FUTEX_LOCK_PI)) {
         timespec ts_abstimeout { 0, 0 };
-        if (params.timeout && !validate_read_and_copy_typed(&ts_abstimeout, params.timeout))
+        if (!validate_read_and_copy_typed(&ts_abstimeout, params.timeout))
             return -EFAULT;
-
-        timeval* optional_timeout = nullptr;
-        timeval relative_timeout { 0, 0 };
-        if (params.timeout) {
+        // FUTEX_WAIT has always taken a wall-clock deadline here, and so do PI locks on Linux.
+        if (command == FUTEX_WAIT_BITSET && !use_realtime_clock)
+            compute_relative_timeout_from_absolute_monotonic(ts_abstimeout, relative_timeout);
+        else
             compute_relative_timeout_from_absolute(ts_abstimeout, relative_timeout);
-            optional_timeout = &relative_timeout;
-        }
+        if (relative_timeout.tv_sec < 0)
+            relative_timeout = { 0, 0 };
+        optional_timeout = &relative_timeout;
+    }
+
+    // The PI operations write to the futex word, so they get a non-const view of it.
+    Userspace<i32*> pi_futex_address { params.userspace_address.ptr() };
+
+    switch (command) {
+    case FUTEX_WAIT:
+    case FUTEX_WAIT_BITSET: {
+        u32 bitset = command == FUTEX_WAIT_BITSET ? (u32)params.val3 : FUTEX_BITSET_MATCH_ANY;
+        if (!bitset)
+            return -EINVAL;
+
+        i32 user_value;
+        copy_from_user(&user_value, params.userspace_address);
+        if (user_value != params.val)
+            return -EAGAIN;
 
         // FIXME: This is supposed to be interruptible by a signal, but right now WaitQueue cannot be interrupted.
         WaitQueue& wait_queue = futex_queue(params.userspace_address);
-        Thread::BlockResult result = Thread::current()->wait_on(wait_queue, "Futex", optional_timeout);
+        auto* current_thread = Thread::current();
+        current_thread->set_wait_bitset(bitset);
+        Thread::BlockResult result = current_thread->wait_on(wait_queue, "Futex", optional_timeout);
+        current_thread->set_wait_bitset(Thread::wait_bitset_match_any);
         if (result == Thread::BlockResult::InterruptedByTimeout) {
             return -ETIMEDOUT;
         }
@@ -89,14 +221,46 @@ int Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
         break;
     }
     case FUTEX_WAKE:
-        if (params.val == 0)
+    case FUTEX_WAKE_BITSET: {
+        u32 bitset = command == FUTEX_WAKE_BITSET ? (u32)params.val3 : FUTEX_BITSET_MATCH_ANY;
+        if (!bitset)
+            return -EINVAL;
+        if (params.val <= 0)
             return 0;
-        if (params.val == 1) {
-            futex_queue(params.userspace_address).wake_one();
-        } else {
-            futex_queue(params.userspace_address).wake_n(params.val);
+        return futex_queue(params.userspace_address).wake_n(params.val, bitset);
+    }
+    case FUTEX_REQUEUE:
+    case FUTEX_CMP_REQUEUE: {
+        if (!validate_read_typed(params.userspace_address2))
+            return -EFAULT;
+        if (params.val < 0 || (i32)params.val2 < 0)
+            return -EINVAL;
+
+        if (command == FUTEX_CMP_REQUEUE) {
+            i32 user_value;
+            copy_from_user(&user_value, params.userspace_address);
+            if (user_value != params.val3)
+                return -EAGAIN;
         }
-        break;
+
+        u32 requeued_count = 0;
+        auto& target_queue = futex_queue(params.userspace_address2);
+        u32 woken_count = futex_queue(params.userspace_address).requeue(target_queue, params.val, params.val2, &requeued_count);
+        if (command == FUTEX_CMP_REQUEUE)
+            return woken_count + requeued_count;
+        return woken_count;
+    }
+    case FUTEX_LOCK_PI:
+    case FUTEX_TRYLOCK_PI:
+        if (!validate_write(pi_futex_address.unsafe_userspace_ptr(), sizeof(i32)))
+            return -EFAULT;
+        return futex_lock_pi(pi_futex_address, optional_timeout, command == FUTEX_TRYLOCK_PI);
+    case FUTEX_UNLOCK_PI:
+        if (!validate_write(pi_futex_address.unsafe_userspace_ptr(), sizeof(i32)))
+            return -EFAULT;
+        return futex_unlock_pi(pi_futex_address);
+    default:
+        return -ENOSYS;
     }
 
     return 0;
@@ -57,9 +57,16 @@ int Process::sys$getresuid(Userspace<uid_t*> ruid, Userspace<uid_t*> euid, Users
     REQUIRE_PROMISE(stdio);
     if (!validate_write_typed(ruid) || !validate_write_typed(euid) || !validate_write_typed(suid))
         return -EFAULT;
-    copy_to_user(ruid, &m_uid);
-    copy_to_user(euid, &m_euid);
-    copy_to_user(suid, &m_suid);
+    uid_t uids[3];
+    {
+        ScopedSpinLock lock(m_credentials_lock);
+        uids[0] = m_uid;
+        uids[1] = m_euid;
+        uids[2] = m_suid;
+    }
+    copy_to_user(ruid, &uids[0]);
+    copy_to_user(euid, &uids[1]);
+    copy_to_user(suid, &uids[2]);
     return 0;
 }
 
@@ -68,9 +75,16 @@ int Process::sys$getresgid(Userspace<gid_t*> rgid, Userspace<gid_t*> egid, Users
     REQUIRE_PROMISE(stdio);
     if (!validate_write_typed(rgid) || !validate_write_typed(egid) || !validate_write_typed(sgid))
         return -EFAULT;
-    copy_to_user(rgid, &m_gid);
-    copy_to_user(egid, &m_egid);
-    copy_to_user(sgid, &m_sgid);
+    gid_t gids[3];
+    {
+        ScopedSpinLock lock(m_credentials_lock);
+        gids[0] = m_gid;
+        gids[1] = m_egid;
+        gids[2] = m_sgid;
+    }
+    copy_to_user(rgid, &gids[0]);
+    copy_to_user(egid, &gids[1]);
+    copy_to_user(sgid, &gids[2]);
     return 0;
 }
 
@@ -79,17 +93,22 @@ int Process::sys$getgroups(ssize_t count, Userspace<gid_t*> user_gids)
     REQUIRE_PROMISE(stdio);
     if (count < 0)
         return -EINVAL;
+
+    Vector<gid_t> gids;
+    {
+        ScopedSpinLock lock(m_credentials_lock);
+        gids.ensure_capacity(m_extra_gids.size());
+        for (auto gid : m_extra_gids)
+            gids.append(gid);
+    }
+
     if (!count)
-        return m_extra_gids.size();
-    if (count != (int)m_extra_gids.size())
+        return gids.size();
+    if (count != (int)gids.size())
         return -EINVAL;
-    if (!validate_write_typed(user_gids, m_extra_gids.size()))
+    if (!validate_write_typed(user_gids, gids.size()))
         return -EFAULT;
 
-    Vector<gid_t> gids;
-    for (auto gid : m_extra_gids)
-        gids.append(gid);
-
     copy_to_user(user_gids, gids.data(), sizeof(gid_t) * count);
     return 0;
 }
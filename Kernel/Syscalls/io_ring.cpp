@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/Process.h>
+#include <Kernel/VM/SharedInodeVMObject.h>
+
+namespace Kernel {
+
+int Process::sys$io_ring_setup(u32 entries, Userspace<io_ring_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    if (!validate_write_typed(user_params))
+        return -EFAULT;
+
+    auto ring_or_error = IORing::create(entries);
+    if (ring_or_error.is_error())
+        return ring_or_error.error();
+    auto& ring = ring_or_error.value();
+
+    io_ring_params params;
+    ring->fill_in_params(params);
+
+    auto description = FileDescription::create(ring);
+    description->set_readable(true);
+
+    ScopedSpinLock lock(m_fds_lock);
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+    m_fds[fd].set(move(description));
+    copy_to_user(user_params, &params);
+    return fd;
+}
+
+int Process::sys$io_ring_enter(int ring_fd, u32 to_submit, u32 min_completions)
+{
+    REQUIRE_PROMISE(stdio);
+    auto description = file_description(ring_fd);
+    if (!description)
+        return -EBADF;
+    if (!description->file().is_io_ring())
+        return -EINVAL;
+    auto& ring = static_cast<IORing&>(description->file());
+
+    ring.flush_overflowed_completions();
+    auto submitted_or_error = ring.submit(*this, to_submit);
+    if (submitted_or_error.is_error())
+        return submitted_or_error.error();
+    u32 submitted = submitted_or_error.value();
+
+    // Waiting for more than fits into the completion queue would never finish.
+    min_completions = min(min_completions, ring.completion_capacity());
+    if (ring.completion_count() < min_completions) {
+        if (Thread::current()->block<Thread::IORingBlocker>(nullptr, ring, min_completions).was_interrupted()) {
+            if (!submitted)
+                return -EINTR;
+        }
+    }
+    return submitted;
+}
+
+i32 Process::do_io_ring_operation(const io_ring_sqe& sqe, FileDescription& description)
+{
+    switch (sqe.opcode) {
+    case IO_RING_OP_READ:
+    case IO_RING_OP_WRITE: {
+        bool is_read = sqe.opcode == IO_RING_OP_READ;
+        if (is_read ? !description.is_readable() : !description.is_writable())
+            return -EBADF;
+        if (description.is_directory())
+            return -EISDIR;
+        if (sqe.len > (u32)NumericLimits<i32>::max())
+            return -EINVAL;
+        if (sqe.offset > NumericLimits<off_t>::max())
+            return -EOVERFLOW;
+        if (is_read ? !validate_write(sqe.addr, sqe.len) : !validate_read(sqe.addr, sqe.len))
+            return -EFAULT;
+        // A negative offset means to use (and advance) the description's current offset, like read() and write().
+        KResultOr<size_t> result = 0;
+        if (is_read)
+            result = sqe.offset < 0 ? description.read((u8*)sqe.addr, sqe.len) : description.read_at((u8*)sqe.addr, sqe.len, sqe.offset);
+        else
+            result = sqe.offset < 0 ? description.write((const u8*)sqe.addr, sqe.len) : description.write_at((const u8*)sqe.addr, sqe.len, sqe.offset);
+        if (result.is_error())
+            return result.error();
+        return result.value();
+    }
+    case IO_RING_OP_ACCEPT: {
+        // accept() changes the fd table, so it must not race with the process' own syscalls.
+        LOCKER(big_lock());
+        return sys$accept(sqe.fd, Userspace<sockaddr*>((FlatPtr)sqe.addr), Userspace<socklen_t*>((FlatPtr)sqe.addr2));
+    }
+    case IO_RING_OP_CONNECT:
+        return sys$connect(sqe.fd, Userspace<const sockaddr*>((FlatPtr)sqe.addr), sqe.len);
+    case IO_RING_OP_FSYNC: {
+        auto* inode = description.inode();
+        if (!inode)
+            return -EINVAL;
+        if (auto* vmobject = inode->shared_vmobject()) {
+            auto result = vmobject->write_back_dirty_pages();
+            if (result.is_error())
+                return result;
+        }
+        inode->flush_metadata();
+        inode->fs().flush_writes();
+        return 0;
+    }
+    default:
+        return -EINVAL;
+    }
+}
+
+}
@@ -79,6 +79,7 @@ static bool validate_inode_mmap_prot(const Process& process, int prot, const Ino
 void* Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
 {
     REQUIRE_PROMISE(stdio);
+    LOCKER(m_address_space_lock);
 
     Syscall::SC_mmap_params params;
     if (!validate_read_and_copy_typed(&params, user_params))
@@ -118,6 +119,7 @@ void* Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
     bool map_private = flags & MAP_PRIVATE;
     bool map_stack = flags & MAP_STACK;
     bool map_fixed = flags & MAP_FIXED;
+    bool map_large_pages = flags & MAP_LARGE_PAGES;
 
     if (map_shared && map_private)
         return (void*)-EINVAL;
@@ -131,6 +133,13 @@ void* Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
     if (map_stack && (!map_private || !map_anonymous))
         return (void*)-EINVAL;
 
+    if (map_large_pages && (!map_anonymous || map_purgeable || map_stack))
+        return (void*)-EINVAL;
+
+    // Large pages need the virtual range to be aligned to them as well.
+    if (map_large_pages && !map_fixed && !addr)
+        alignment = max(alignment, MemoryManager::large_page_size);
+
     Region* region = nullptr;
 
     auto range = allocate_range(VirtualAddress(addr), size, alignment);
@@ -142,6 +151,10 @@ void* Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
         region = allocate_region_with_vmobject(range, vmobject, 0, !name.is_null() ? name : "mmap (purgeable)", prot);
         if (!region && (!map_fixed && addr != 0))
             region = allocate_region_with_vmobject({}, size, vmobject, 0, !name.is_null() ? name : "mmap (purgeable)", prot);
+    } else if (map_large_pages && size >= MemoryManager::large_page_size) {
+        region = allocate_large_page_region(range, !name.is_null() ? name : "mmap (large pages)", prot);
+        if (!region)
+            region = allocate_region(range, !name.is_null() ? name : "mmap", prot, false);
     } else if (map_anonymous) {
         region = allocate_region(range, !name.is_null() ? name : "mmap", prot, false);
         if (!region && (!map_fixed && addr != 0))
@@ -194,6 +207,7 @@ void* Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> user_params)
 int Process::sys$mprotect(void* addr, size_t size, int prot)
 {
     REQUIRE_PROMISE(stdio);
+    LOCKER(m_address_space_lock);
 
     if (!size)
         return -EINVAL;
@@ -261,9 +275,48 @@ int Process::sys$mprotect(void* addr, size_t size, int prot)
     return -EINVAL;
 }
 
+int Process::madvise_access_pattern(VirtualAddress address, size_t size, int advice)
+{
+    if (address.page_base() != address)
+        return -EINVAL;
+    auto* region = find_region_containing({ address, size });
+    if (!region)
+        return -ENOMEM;
+    if (!region->is_mmap())
+        return -EPERM;
+
+    // Access patterns apply to the whole region, the rest only to the given range.
+    size_t first_page_index = region->page_index_from_address(address);
+    size_t page_count = PAGE_ROUND_UP(size) / PAGE_SIZE;
+    switch (advice) {
+    case MADV_NORMAL:
+        region->set_access_pattern(Region::AccessPattern::Normal);
+        return 0;
+    case MADV_RANDOM:
+        region->set_access_pattern(Region::AccessPattern::Random);
+        return 0;
+    case MADV_SEQUENTIAL:
+        region->set_access_pattern(Region::AccessPattern::Sequential);
+        return 0;
+    case MADV_WILLNEED:
+        if (region->vmobject().is_inode())
+            region->read_ahead_inode_pages(first_page_index, page_count);
+        return 0;
+    case MADV_DONTNEED:
+        // Anonymous memory has no backing store to bring it back from.
+        if (!region->vmobject().is_inode())
+            return -EINVAL;
+        region->release_clean_inode_pages(first_page_index, page_count);
+        return 0;
+    default:
+        return -EINVAL;
+    }
+}
+
 int Process::sys$madvise(void* address, size_t size, int advice)
 {
     REQUIRE_PROMISE(stdio);
+    LOCKER(m_address_space_lock);
 
     if (!size)
         return -EINVAL;
@@ -271,6 +324,9 @@ int Process::sys$madvise(void* address, size_t size, int advice)
     if (!is_user_range(VirtualAddress(address), size))
         return -EFAULT;
 
+    if (!(advice & (MADV_SET_VOLATILE | MADV_SET_NONVOLATILE | MADV_GET_VOLATILE)))
+        return madvise_access_pattern(VirtualAddress(address), size, advice);
+
     auto* region = find_region_from_range({ VirtualAddress(address), size });
     if (!region)
         return -EINVAL;
@@ -308,6 +364,7 @@ int Process::sys$madvise(void* address, size_t size, int advice)
 int Process::sys$minherit(void* address, size_t size, int inherit)
 {
     REQUIRE_PROMISE(stdio);
+    LOCKER(m_address_space_lock);
 
     auto* region = find_region_from_range({ VirtualAddress(address), size });
     if (!region)
@@ -331,9 +388,48 @@ int Process::sys$minherit(void* address, size_t size, int inherit)
     return -EINVAL;
 }
 
+int Process::sys$msync(void* address, size_t size, int flags)
+{
+    REQUIRE_PROMISE(stdio);
+    LOCKER(m_address_space_lock);
+
+    if (flags & ~(MS_ASYNC | MS_INVALIDATE | MS_SYNC))
+        return -EINVAL;
+    if ((flags & MS_ASYNC) && (flags & MS_SYNC))
+        return -EINVAL;
+
+    VirtualAddress vaddr(address);
+    if (vaddr.page_base() != vaddr)
+        return -EINVAL;
+    if (!is_user_range(vaddr, size))
+        return -ENOMEM;
+
+    auto* region = find_region_containing({ vaddr, size });
+    if (!region)
+        return -ENOMEM;
+
+    // Private and anonymous mappings have nothing to write back.
+    if (!region->is_shared() || !region->vmobject().is_shared_inode())
+        return 0;
+
+    // With MS_ASYNC, the dirty pages are picked up by the next periodic sync.
+    if (!(flags & MS_SYNC))
+        return 0;
+
+    auto& vmobject = static_cast<SharedInodeVMObject&>(region->vmobject());
+    size_t first_page_index = region->first_page_index() + region->page_index_from_address(vaddr);
+    size_t page_count = PAGE_ROUND_UP(size) / PAGE_SIZE;
+    auto result = vmobject.write_back_dirty_pages(first_page_index, page_count);
+    if (result.is_error())
+        return result;
+    vmobject.inode().fs().flush_writes();
+    return 0;
+}
+
 int Process::sys$set_mmap_name(Userspace<const Syscall::SC_set_mmap_name_params*> user_params)
 {
     REQUIRE_PROMISE(stdio);
+    LOCKER(m_address_space_lock);
 
     Syscall::SC_set_mmap_name_params params;
     if (!validate_read_and_copy_typed(&params, user_params))
@@ -376,6 +472,7 @@ Vector<Region*, 2> Process::split_region_around_range(const Region& source_regio
 int Process::sys$munmap(void* addr, size_t size)
 {
     REQUIRE_PROMISE(stdio);
+    LOCKER(m_address_space_lock);
 
     if (!size)
         return -EINVAL;
@@ -412,7 +509,39 @@ int Process::sys$munmap(void* addr, size_t size)
         return 0;
     }
 
-    // FIXME: We should also support munmap() across multiple regions. (#175)
+    // The range may also be tiled exactly by several adjacent regions,
+    // e.g. a malloc() block that was grown in place by mapping more memory after it.
+    Vector<Region*, 4> regions_to_unmap;
+    {
+        ScopedSpinLock lock(m_lock);
+        auto* first_region = region_at_or_below(range_to_unmap.base());
+        if (first_region && first_region->vaddr() == range_to_unmap.base()) {
+            size_t index = region_index_after(range_to_unmap.base()) - 1;
+            auto expected_base = range_to_unmap.base();
+            for (; index < m_regions.size() && expected_base < range_to_unmap.end(); ++index) {
+                auto& region = m_regions[index];
+                if (region.vaddr() != expected_base || !range_to_unmap.contains(region.vaddr(), region.size()))
+                    break;
+                regions_to_unmap.append(&region);
+                expected_base = region.range().end();
+            }
+            if (expected_base != range_to_unmap.end())
+                regions_to_unmap.clear();
+        }
+    }
+    if (!regions_to_unmap.is_empty()) {
+        for (auto* region : regions_to_unmap) {
+            if (!region->is_mmap())
+                return -EPERM;
+        }
+        for (auto* region : regions_to_unmap) {
+            bool success = deallocate_region(*region);
+            ASSERT(success);
+        }
+        return 0;
+    }
+
+    // FIXME: We should also support munmap() of partial regions across multiple regions. (#175)
 
     return -EINVAL;
 }
@@ -24,6 +24,8 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/QuickSort.h>
+#include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/KSyms.h>
@@ -33,8 +35,6 @@
 
 namespace Kernel {
 
-extern HashMap<String, OwnPtr<Module>>* g_modules;
-
 int Process::sys$module_load(Userspace<const char*> user_path, size_t path_length)
 {
     if (!is_superuser())
@@ -149,6 +149,24 @@ int Process::sys$module_load(Userspace<const char*> user_path, size_t path_lengt
     if (!module->module_init)
         return -EINVAL;
 
+    elf_image->for_each_symbol([&](const ELF::Image::Symbol& symbol) {
+        if (symbol.type() != STT_FUNC || symbol.section_index() == SHN_UNDEF)
+            return IterationDecision::Continue;
+        auto* storage = section_storage_by_name.get(symbol.section().name()).value_or(nullptr);
+        if (!storage)
+            return IterationDecision::Continue;
+        module->symbol_names.append(symbol.name());
+        module->symbols.append({ (u32)(storage + symbol.value()), module->symbol_names.last().characters() });
+        return IterationDecision::Continue;
+    });
+    quick_sort(module->symbols, [](auto& a, auto& b) { return a.address < b.address; });
+    for (auto& section : module->sections) {
+        FlatPtr section_start = (FlatPtr)section.data();
+        if (!module->lowest_address || section_start < module->lowest_address)
+            module->lowest_address = section_start;
+        module->highest_address = max(module->highest_address, section_start + section.size());
+    }
+
     if (g_modules->contains(module->name)) {
         dbg() << "a module with the name " << module->name << " is already loaded; please unload it first";
         return -EEXIST;
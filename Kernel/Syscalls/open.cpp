@@ -64,10 +64,6 @@ int Process::sys$open(Userspace<const Syscall::SC_open_params*> user_params)
 #ifdef DEBUG_IO
     dbg() << "sys$open(dirfd=" << dirfd << ", path=\"" << path.value() << "\", options=" << options << ", mode=" << mode << ")";
 #endif
-    int fd = alloc_fd();
-    if (fd < 0)
-        return fd;
-
     RefPtr<Custody> base;
     if (dirfd == AT_FDCWD) {
         base = current_directory();
@@ -91,6 +87,10 @@ int Process::sys$open(Userspace<const Syscall::SC_open_params*> user_params)
         return -ENXIO;
 
     u32 fd_flags = (options & O_CLOEXEC) ? FD_CLOEXEC : 0;
+    ScopedSpinLock lock(m_fds_lock);
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
     m_fds[fd].set(move(description), fd_flags);
     return fd;
 }
@@ -98,15 +98,22 @@ int Process::sys$open(Userspace<const Syscall::SC_open_params*> user_params)
 int Process::sys$close(int fd)
 {
     REQUIRE_PROMISE(stdio);
-    auto description = file_description(fd);
+    RefPtr<FileDescription> description;
+    {
+        // Take the description out of the table first, so that we don't end up
+        // closing it while holding a spinlock.
+        ScopedSpinLock lock(m_fds_lock);
+        if (fd >= 0 && static_cast<size_t>(fd) < m_fds.size()) {
+            description = m_fds[fd].description();
+            m_fds[fd] = {};
+        }
+    }
 #ifdef DEBUG_IO
     dbg() << "sys$close(" << fd << ") " << description.ptr();
 #endif
     if (!description)
         return -EBADF;
-    int rc = description->close();
-    m_fds[fd] = {};
-    return rc;
+    return description->close();
 }
 
 }
@@ -24,16 +24,122 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/PerformanceCounters.h>
 #include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/PerformanceEventStream.h>
 #include <Kernel/Process.h>
 
 namespace Kernel {
 
 int Process::sys$perf_event(int type, FlatPtr arg1, FlatPtr arg2)
 {
+    return ensure_perf_events().append(type, arg1, arg2);
+}
+
+int Process::sys$perf_event_stream(pid_t pid)
+{
+    REQUIRE_PROMISE(proc);
+    RefPtr<Process> process;
+    {
+        ScopedSpinLock lock(g_processes_lock);
+        process = Process::from_pid(pid);
+    }
+    if (!process || process->is_dead())
+        return -ESRCH;
+    if (!is_superuser() && process->uid() != m_uid)
+        return -EPERM;
+
+    RefPtr<PerformanceEventBuffer> buffer;
+    {
+        LOCKER(process->big_lock());
+        buffer = process->ensure_perf_events();
+    }
+
+    auto description = FileDescription::create(*PerformanceEventStream::create(process->pid(), *buffer));
+    description->set_readable(true);
+
+    ScopedSpinLock lock(m_fds_lock);
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+    m_fds[fd].set(move(description));
+    return fd;
+}
+
+int Process::sys$perf_counter_sampling(pid_t pid, int counter, u32 period)
+{
+    REQUIRE_NO_PROMISES;
+    RefPtr<Process> process;
+    {
+        ScopedSpinLock lock(g_processes_lock);
+        process = Process::from_pid(pid);
+    }
+    if (!process || process->is_dead())
+        return -ESRCH;
+    if (!is_superuser() && process->uid() != m_uid)
+        return -EPERM;
+
+    if (!counter) {
+        if (PerformanceCounters::pid() == process->pid())
+            PerformanceCounters::stop();
+        return 0;
+    }
+
+    {
+        // The samples are recorded from an interrupt handler, which can't allocate the buffer itself.
+        LOCKER(process->big_lock());
+        process->ensure_perf_events();
+    }
+    return PerformanceCounters::start(process->pid(), counter, period);
+}
+
+int Process::sys$perf_off_cpu_tracing(pid_t pid, int enabled)
+{
+    REQUIRE_NO_PROMISES;
+    RefPtr<Process> process;
+    {
+        ScopedSpinLock lock(g_processes_lock);
+        process = Process::from_pid(pid);
+    }
+    if (!process || process->is_dead())
+        return -ESRCH;
+    if (!is_superuser() && process->uid() != m_uid)
+        return -EPERM;
+
+    LOCKER(process->big_lock());
+    if (enabled)
+        process->ensure_perf_events();
+    process->m_tracing_off_cpu = enabled;
+    return 0;
+}
+
+int Process::sys$perf_syscall_tracing(pid_t pid, int enabled)
+{
+    REQUIRE_NO_PROMISES;
+    RefPtr<Process> process;
+    {
+        ScopedSpinLock lock(g_processes_lock);
+        process = Process::from_pid(pid);
+    }
+    if (!process || process->is_dead())
+        return -ESRCH;
+    if (!is_superuser() && process->uid() != m_uid)
+        return -EPERM;
+
+    LOCKER(process->big_lock());
+    if (enabled)
+        process->ensure_perf_events();
+    process->m_recording_syscalls = enabled;
+    return 0;
+}
+
+PerformanceEventBuffer& Process::ensure_perf_events()
+{
+    ASSERT(big_lock().is_locked());
     if (!m_perf_event_buffer)
-        m_perf_event_buffer = make<PerformanceEventBuffer>();
-    return m_perf_event_buffer->append(type, arg1, arg2);
+        m_perf_event_buffer = PerformanceEventBuffer::create();
+    return *m_perf_event_buffer;
 }
 
 }
@@ -44,16 +44,27 @@ int Process::sys$pipe(int pipefd[2], int flags)
     u32 fd_flags = (flags & O_CLOEXEC) ? FD_CLOEXEC : 0;
     auto fifo = FIFO::create(m_uid);
 
-    int reader_fd = alloc_fd();
-    m_fds[reader_fd].set(fifo->open_direction(FIFO::Direction::Reader), fd_flags);
-    m_fds[reader_fd].description()->set_readable(true);
-    copy_to_user(&pipefd[0], &reader_fd);
+    auto reader_description = fifo->open_direction(FIFO::Direction::Reader);
+    reader_description->set_readable(true);
+    auto writer_description = fifo->open_direction(FIFO::Direction::Writer);
+    writer_description->set_writable(true);
 
-    int writer_fd = alloc_fd();
-    m_fds[writer_fd].set(fifo->open_direction(FIFO::Direction::Writer), fd_flags);
-    m_fds[writer_fd].description()->set_writable(true);
-    copy_to_user(&pipefd[1], &writer_fd);
+    int reader_fd;
+    int writer_fd;
+    {
+        ScopedSpinLock lock(m_fds_lock);
+        reader_fd = alloc_fd();
+        if (reader_fd < 0)
+            return reader_fd;
+        writer_fd = alloc_fd(reader_fd + 1);
+        if (writer_fd < 0)
+            return writer_fd;
+        m_fds[reader_fd].set(move(reader_description), fd_flags);
+        m_fds[writer_fd].set(move(writer_description), fd_flags);
+    }
 
+    copy_to_user(&pipefd[0], &reader_fd);
+    copy_to_user(&pipefd[1], &writer_fd);
     return 0;
 }
 
@@ -25,6 +25,7 @@
  */
 
 #include <AK/NonnullRefPtrVector.h>
+#include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Process.h>
 #include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -63,6 +64,7 @@ int Process::sys$purge(int mode)
         for (auto& vmobject : vmobjects) {
             purged_page_count += vmobject.release_all_clean_pages();
         }
+        purged_page_count += Inode::release_all_unused_cached_pages();
     }
     return purged_page_count;
 }
@@ -48,6 +48,8 @@ ssize_t Process::sys$read(int fd, Userspace<u8*> buffer, ssize_t size)
         return -EBADF;
     if (description->is_directory())
         return -EISDIR;
+    ScopedLatencyRecorder latency_recorder(Thread::current()->read_latency());
+
     if (description->is_blocking()) {
         if (!description->can_read()) {
             if (Thread::current()->block<Thread::ReadBlocker>(nullptr, *description).was_interrupted())
@@ -62,4 +64,110 @@ ssize_t Process::sys$read(int fd, Userspace<u8*> buffer, ssize_t size)
     return result.value();
 }
 
+ssize_t Process::sys$readv(int fd, const struct iovec* iov, int iov_count)
+{
+    REQUIRE_PROMISE(stdio);
+    auto vecs_or_error = copy_iovecs_from_user(iov, iov_count, true);
+    if (vecs_or_error.is_error())
+        return vecs_or_error.error();
+
+    auto description = file_description(fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+    ScopedLatencyRecorder latency_recorder(Thread::current()->read_latency());
+
+    // Like read(), only block until there's something to read, then fill in what we can.
+    if (description->is_blocking()) {
+        if (!description->can_read()) {
+            if (Thread::current()->block<Thread::ReadBlocker>(nullptr, *description).was_interrupted())
+                return -EINTR;
+            if (!description->can_read())
+                return -EAGAIN;
+        }
+    }
+
+    ssize_t nread = 0;
+    for (auto& vec : vecs_or_error.value()) {
+        if (!vec.iov_len)
+            continue;
+        if (nread && !description->can_read())
+            break;
+        auto result = description->read((u8*)vec.iov_base, vec.iov_len);
+        if (result.is_error()) {
+            if (nread == 0)
+                return result.error();
+            break;
+        }
+        nread += result.value();
+        if (result.value() < vec.iov_len)
+            break;
+    }
+    return nread;
+}
+
+ssize_t Process::sys$pread(Userspace<const Syscall::SC_pread_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_pread_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    if (params.size < 0)
+        return -EINVAL;
+    if (params.size == 0)
+        return 0;
+    if (!validate_write(params.buffer, params.size))
+        return -EFAULT;
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+    ScopedLatencyRecorder latency_recorder(Thread::current()->read_latency());
+
+    auto result = description->read_at(params.buffer.unsafe_userspace_ptr(), params.size, params.offset);
+    if (result.is_error())
+        return result.error();
+    return result.value();
+}
+
+ssize_t Process::sys$preadv(Userspace<const Syscall::SC_preadv_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_preadv_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    auto vecs_or_error = copy_iovecs_from_user(params.iov.unsafe_userspace_ptr(), params.iov_count, true);
+    if (vecs_or_error.is_error())
+        return vecs_or_error.error();
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+    ScopedLatencyRecorder latency_recorder(Thread::current()->read_latency());
+
+    ssize_t nread = 0;
+    for (auto& vec : vecs_or_error.value()) {
+        auto result = description->read_at((u8*)vec.iov_base, vec.iov_len, params.offset + nread);
+        if (result.is_error()) {
+            if (nread == 0)
+                return result.error();
+            break;
+        }
+        nread += result.value();
+        if (result.value() < vec.iov_len)
+            break;
+    }
+    return nread;
+}
+
 }
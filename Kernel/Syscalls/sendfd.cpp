@@ -64,9 +64,8 @@ int Process::sys$recvfd(int sockfd)
     if (!socket.is_local())
         return -EAFNOSUPPORT;
 
-    int new_fd = alloc_fd();
-    if (new_fd < 0)
-        return new_fd;
+    if (number_of_open_file_descriptors() >= max_open_file_descriptors())
+        return -EMFILE;
 
     auto& local_socket = static_cast<LocalSocket&>(socket);
     auto received_descriptor_or_error = local_socket.recvfd(*socket_description);
@@ -74,6 +73,10 @@ int Process::sys$recvfd(int sockfd)
     if (received_descriptor_or_error.is_error())
         return received_descriptor_or_error.error();
 
+    ScopedSpinLock lock(m_fds_lock);
+    int new_fd = alloc_fd();
+    if (new_fd < 0)
+        return new_fd;
     m_fds[new_fd].set(*received_descriptor_or_error.value(), 0);
     return new_fd;
 }
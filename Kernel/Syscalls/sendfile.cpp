@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Process.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+static constexpr size_t sendfile_buffer_size = 16 * PAGE_SIZE;
+
+ssize_t Process::sys$sendfile(Userspace<const Syscall::SC_sendfile_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_sendfile_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    if (params.count < 0)
+        return -EINVAL;
+
+    auto out_description = file_description(params.out_fd);
+    if (!out_description)
+        return -EBADF;
+    if (!out_description->is_writable())
+        return -EBADF;
+    auto in_description = file_description(params.in_fd);
+    if (!in_description)
+        return -EBADF;
+    if (!in_description->is_readable())
+        return -EBADF;
+    if (in_description->is_directory())
+        return -EISDIR;
+
+    // With an explicit offset we read from there and report back where we stopped,
+    // leaving the input's own offset alone. Otherwise we read from (and advance) its offset.
+    bool seekable = in_description->file().is_seekable();
+    off_t offset = 0;
+    if (params.offset) {
+        if (!seekable)
+            return -ESPIPE;
+        if (!validate_read_and_copy_typed(&offset, params.offset))
+            return -EFAULT;
+        if (!validate_write_typed(params.offset))
+            return -EFAULT;
+        if (offset < 0)
+            return -EINVAL;
+    } else if (seekable) {
+        offset = in_description->offset();
+    }
+
+    if (params.count == 0)
+        return 0;
+
+    Checked<off_t> end_offset = offset;
+    end_offset += params.count;
+    if (end_offset.has_overflow())
+        return -EOVERFLOW;
+
+    ssize_t total_sent = 0;
+    auto* inode = in_description->inode();
+    if (in_description->file().is_inode() && inode && inode->is_page_cacheable()) {
+        // Hand the page cache pages directly to the output file instead of copying
+        // the data into a bounce buffer first.
+        size_t file_size = inode->size();
+        size_t remaining = min((size_t)params.count, (size_t)(offset < (off_t)file_size ? file_size - offset : 0));
+        if (remaining)
+            inode->read_ahead_pages(offset / PAGE_SIZE, PAGE_ROUND_UP(offset + remaining) / PAGE_SIZE - offset / PAGE_SIZE);
+        while (remaining) {
+            size_t page_index = (offset + total_sent) / PAGE_SIZE;
+            size_t offset_in_page = (offset + total_sent) % PAGE_SIZE;
+            size_t chunk_size = min(remaining, PAGE_SIZE - offset_in_page);
+            auto page_or_error = inode->cached_page(page_index, in_description);
+            if (page_or_error.is_error()) {
+                if (total_sent)
+                    break;
+                return page_or_error.error();
+            }
+            auto region = MM.allocate_kernel_region_with_vmobject(AnonymousVMObject::create_with_physical_page(*page_or_error.value()), PAGE_SIZE, "sendfile", Region::Access::Read);
+            if (!region) {
+                if (total_sent)
+                    break;
+                return -ENOMEM;
+            }
+            ssize_t nwritten = do_write(*out_description, region->vaddr().offset(offset_in_page).as_ptr(), chunk_size);
+            if (nwritten < 0) {
+                if (total_sent)
+                    break;
+                return nwritten;
+            }
+            total_sent += nwritten;
+            remaining -= nwritten;
+            if ((size_t)nwritten < chunk_size)
+                break;
+        }
+        if (total_sent)
+            Thread::current()->did_file_read(total_sent);
+    } else {
+        // Pipes, devices and other non-cacheable files go through a kernel buffer,
+        // which still spares the data a trip through userspace.
+        if (!seekable && in_description->is_blocking() && !in_description->can_read()) {
+            if (Thread::current()->block<Thread::ReadBlocker>(nullptr, *in_description).was_interrupted())
+                return -EINTR;
+            if (!in_description->can_read())
+                return -EAGAIN;
+        }
+        auto buffer = KBuffer::create_with_size(min((size_t)params.count, sendfile_buffer_size), Region::Access::Read | Region::Access::Write, "sendfile");
+        while (total_sent < params.count) {
+            // Like read(), we only block until there's something to send.
+            if (!seekable && total_sent && !in_description->can_read())
+                break;
+            size_t chunk_size = min((size_t)(params.count - total_sent), buffer.capacity());
+            auto nread_or_error = seekable ? in_description->read_at(buffer.data(), chunk_size, offset + total_sent) : in_description->read(buffer.data(), chunk_size);
+            if (nread_or_error.is_error()) {
+                if (total_sent)
+                    break;
+                return nread_or_error.error();
+            }
+            size_t nread = nread_or_error.value();
+            if (nread == 0)
+                break;
+            ssize_t nwritten = do_write(*out_description, buffer.data(), nread);
+            if (nwritten < 0) {
+                if (total_sent)
+                    break;
+                return nwritten;
+            }
+            total_sent += nwritten;
+            if ((size_t)nwritten < nread)
+                break;
+        }
+    }
+
+    if (params.offset) {
+        off_t new_offset = offset + total_sent;
+        copy_to_user(params.offset, &new_offset);
+    } else if (seekable) {
+        in_description->seek(offset + total_sent, SEEK_SET);
+    }
+    return total_sent;
+}
+
+}
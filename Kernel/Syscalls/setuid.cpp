@@ -35,6 +35,7 @@ int Process::sys$seteuid(uid_t euid)
     if (euid != m_uid && euid != m_suid && !is_superuser())
         return -EPERM;
 
+    ScopedSpinLock lock(m_credentials_lock);
     m_euid = euid;
     return 0;
 }
@@ -46,6 +47,7 @@ int Process::sys$setegid(gid_t egid)
     if (egid != m_gid && egid != m_sgid && !is_superuser())
         return -EPERM;
 
+    ScopedSpinLock lock(m_credentials_lock);
     m_egid = egid;
     return 0;
 }
@@ -57,6 +59,7 @@ int Process::sys$setuid(uid_t uid)
     if (uid != m_uid && uid != m_euid && !is_superuser())
         return -EPERM;
 
+    ScopedSpinLock lock(m_credentials_lock);
     m_uid = uid;
     m_euid = uid;
     m_suid = uid;
@@ -70,6 +73,7 @@ int Process::sys$setgid(gid_t gid)
     if (gid != m_gid && gid != m_egid && !is_superuser())
         return -EPERM;
 
+    ScopedSpinLock lock(m_credentials_lock);
     m_gid = gid;
     m_egid = gid;
     m_sgid = gid;
@@ -91,6 +95,7 @@ int Process::sys$setresuid(uid_t ruid, uid_t euid, uid_t suid)
     if ((!ok(ruid) || !ok(euid) || !ok(suid)) && !is_superuser())
         return -EPERM;
 
+    ScopedSpinLock lock(m_credentials_lock);
     m_uid = ruid;
     m_euid = euid;
     m_suid = suid;
@@ -112,6 +117,7 @@ int Process::sys$setresgid(gid_t rgid, gid_t egid, gid_t sgid)
     if ((!ok(rgid) || !ok(egid) || !ok(sgid)) && !is_superuser())
         return -EPERM;
 
+    ScopedSpinLock lock(m_credentials_lock);
     m_gid = rgid;
     m_egid = egid;
     m_sgid = sgid;
@@ -129,7 +135,9 @@ int Process::sys$setgroups(ssize_t count, Userspace<const gid_t*> user_gids)
         return -EFAULT;
 
     if (!count) {
-        m_extra_gids.clear();
+        FixedArray<gid_t> old_extra_gids;
+        ScopedSpinLock lock(m_credentials_lock);
+        m_extra_gids.swap(old_extra_gids);
         return 0;
     }
 
@@ -143,13 +151,16 @@ int Process::sys$setgroups(ssize_t count, Userspace<const gid_t*> user_gids)
             unique_extra_gids.set(gid);
     }
 
-    m_extra_gids.resize(unique_extra_gids.size());
+    FixedArray<gid_t> extra_gids(unique_extra_gids.size());
     size_t i = 0;
     for (auto& gid : unique_extra_gids) {
         if (gid == m_gid)
             continue;
-        m_extra_gids[i++] = gid;
+        extra_gids[i++] = gid;
     }
+
+    ScopedSpinLock lock(m_credentials_lock);
+    m_extra_gids.swap(extra_gids);
     return 0;
 }
 
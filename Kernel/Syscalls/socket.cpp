@@ -45,9 +45,6 @@ int Process::sys$socket(int domain, int type, int protocol)
 
     if ((type & SOCK_TYPE_MASK) == SOCK_RAW && !is_superuser())
         return -EACCES;
-    int fd = alloc_fd();
-    if (fd < 0)
-        return fd;
     auto result = Socket::create(domain, type, protocol);
     if (result.is_error())
         return result.error();
@@ -59,6 +56,10 @@ int Process::sys$socket(int domain, int type, int protocol)
         flags |= FD_CLOEXEC;
     if (type & SOCK_NONBLOCK)
         description->set_blocking(false);
+    ScopedSpinLock lock(m_fds_lock);
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
     m_fds[fd].set(move(description), flags);
     return fd;
 }
@@ -107,9 +108,8 @@ int Process::sys$accept(int accepting_socket_fd, Userspace<sockaddr*> user_addre
             return -EFAULT;
     }
 
-    int accepted_socket_fd = alloc_fd();
-    if (accepted_socket_fd < 0)
-        return accepted_socket_fd;
+    if (number_of_open_file_descriptors() >= max_open_file_descriptors())
+        return -EMFILE;
     auto accepting_socket_description = file_description(accepting_socket_fd);
     if (!accepting_socket_description)
         return -EBADF;
@@ -142,7 +142,15 @@ int Process::sys$accept(int accepting_socket_fd, Userspace<sockaddr*> user_addre
     // NOTE: The accepted socket inherits fd flags from the accepting socket.
     //       I'm not sure if this matches other systems but it makes sense to me.
     accepted_socket_description->set_blocking(accepting_socket_description->is_blocking());
-    m_fds[accepted_socket_fd].set(move(accepted_socket_description), m_fds[accepting_socket_fd].flags());
+    int accepting_socket_fd_flags = fd_flags(accepting_socket_fd);
+    int accepted_socket_fd;
+    {
+        ScopedSpinLock lock(m_fds_lock);
+        accepted_socket_fd = alloc_fd();
+        if (accepted_socket_fd < 0)
+            return accepted_socket_fd;
+        m_fds[accepted_socket_fd].set(move(accepted_socket_description), max(accepting_socket_fd_flags, 0));
+    }
 
     // NOTE: Moving this state to Completed is what causes connect() to unblock on the client side.
     accepted_socket->set_setup_state(Socket::SetupState::Completed);
@@ -153,9 +161,8 @@ int Process::sys$connect(int sockfd, Userspace<const sockaddr*> user_address, so
 {
     if (!validate_read(user_address, user_address_size))
         return -EFAULT;
-    int fd = alloc_fd();
-    if (fd < 0)
-        return fd;
+    if (number_of_open_file_descriptors() >= max_open_file_descriptors())
+        return -EMFILE;
     auto description = file_description(sockfd);
     if (!description)
         return -EBADF;
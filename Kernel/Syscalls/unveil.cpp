@@ -38,6 +38,7 @@ int Process::sys$unveil(Userspace<const Syscall::SC_unveil_params*> user_params)
         return -EFAULT;
 
     if (!params.path.characters && !params.permissions.characters) {
+        LOCKER(m_filesystem_lock);
         m_veil_state = VeilState::Locked;
         return 0;
     }
@@ -90,6 +91,7 @@ int Process::sys$unveil(Userspace<const Syscall::SC_unveil_params*> user_params)
         }
     }
 
+    LOCKER(m_filesystem_lock);
     for (auto& unveiled_path : m_unveiled_paths) {
         if (unveiled_path.path == new_unveiled_path) {
             if (new_permissions & ~unveiled_path.permissions)
@@ -25,6 +25,7 @@
  */
 
 #include <AK/StringView.h>
+#include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Process.h>
 
@@ -48,12 +48,14 @@ int Process::sys$watch_file(Userspace<const char*> user_path, size_t path_length
     if (!inode.fs().supports_watchers())
         return -ENOTSUP;
 
+    auto description = FileDescription::create(*InodeWatcher::create(inode));
+    description->set_readable(true);
+
+    ScopedSpinLock lock(m_fds_lock);
     int fd = alloc_fd();
     if (fd < 0)
         return fd;
-
-    m_fds[fd].set(FileDescription::create(*InodeWatcher::create(inode)));
-    m_fds[fd].description()->set_readable(true);
+    m_fds[fd].set(move(description));
     return fd;
 }
 
@@ -30,26 +30,35 @@
 
 namespace Kernel {
 
-ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
+KResultOr<Vector<iovec, 32>> Process::copy_iovecs_from_user(const struct iovec* iov, int iov_count, bool for_writing)
 {
-    REQUIRE_PROMISE(stdio);
     if (iov_count < 0)
-        return -EINVAL;
+        return KResult(-EINVAL);
 
     if (!validate_read_typed(iov, iov_count))
-        return -EFAULT;
+        return KResult(-EFAULT);
 
     u64 total_length = 0;
     Vector<iovec, 32> vecs;
     vecs.resize(iov_count);
     copy_from_user(vecs.data(), iov, iov_count * sizeof(iovec));
     for (auto& vec : vecs) {
-        if (!validate_read(vec.iov_base, vec.iov_len))
-            return -EFAULT;
+        if (for_writing ? !validate_write(vec.iov_base, vec.iov_len) : !validate_read(vec.iov_base, vec.iov_len))
+            return KResult(-EFAULT);
         total_length += vec.iov_len;
         if (total_length > NumericLimits<i32>::max())
-            return -EINVAL;
+            return KResult(-EINVAL);
     }
+    return vecs;
+}
+
+ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
+{
+    REQUIRE_PROMISE(stdio);
+    auto vecs_or_error = copy_iovecs_from_user(iov, iov_count, false);
+    if (vecs_or_error.is_error())
+        return vecs_or_error.error();
+    auto& vecs = vecs_or_error.value();
 
     auto description = file_description(fd);
     if (!description)
@@ -57,6 +66,7 @@ ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
 
     if (!description->is_writable())
         return -EBADF;
+    ScopedLatencyRecorder latency_recorder(Thread::current()->write_latency());
 
     int nwritten = 0;
     for (auto& vec : vecs) {
@@ -125,8 +135,66 @@ ssize_t Process::sys$write(int fd, const u8* data, ssize_t size)
         return -EBADF;
     if (!description->is_writable())
         return -EBADF;
+    ScopedLatencyRecorder latency_recorder(Thread::current()->write_latency());
 
     return do_write(*description, data, size);
 }
 
+ssize_t Process::sys$pwrite(Userspace<const Syscall::SC_pwrite_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_pwrite_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    if (params.size < 0)
+        return -EINVAL;
+    if (params.size == 0)
+        return 0;
+    if (!validate_read(params.data, params.size))
+        return -EFAULT;
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_writable())
+        return -EBADF;
+    ScopedLatencyRecorder latency_recorder(Thread::current()->write_latency());
+
+    auto result = description->write_at(params.data.unsafe_userspace_ptr(), params.size, params.offset);
+    if (result.is_error())
+        return result.error();
+    return result.value();
+}
+
+ssize_t Process::sys$pwritev(Userspace<const Syscall::SC_preadv_params*> user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_preadv_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    auto vecs_or_error = copy_iovecs_from_user(params.iov.unsafe_userspace_ptr(), params.iov_count, false);
+    if (vecs_or_error.is_error())
+        return vecs_or_error.error();
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_writable())
+        return -EBADF;
+    ScopedLatencyRecorder latency_recorder(Thread::current()->write_latency());
+
+    ssize_t nwritten = 0;
+    for (auto& vec : vecs_or_error.value()) {
+        auto result = description->write_at((const u8*)vec.iov_base, vec.iov_len, params.offset + nwritten);
+        if (result.is_error()) {
+            if (nwritten == 0)
+                return result.error();
+            break;
+        }
+        nwritten += result.value();
+        if (result.value() < vec.iov_len)
+            break;
+    }
+    return nwritten;
+}
+
 }
@@ -32,9 +32,16 @@
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/IO.h>
 #include <Kernel/StdLib.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <Kernel/TimerQueue.h>
 
 namespace Kernel {
 
+// The text mode buffer is 32 KiB, so the visible window can be panned over this many rows.
+static constexpr u16 s_max_vga_rows = 0x8000 / 160;
+// Don't redraw the screen more often than this while output keeps coming in.
+static constexpr u64 s_flush_interval_ms = 16;
+
 static u8* s_vga_buffer;
 static VirtualConsole* s_consoles[s_max_virtual_consoles];
 static int s_active_console;
@@ -119,6 +126,7 @@ void VirtualConsole::set_active(bool active)
         KeyboardDevice::the().set_client(this);
 
         m_terminal.m_need_full_flush = true;
+        m_terminal.m_scrolled_lines = 0;
         flush_dirty_lines();
     } else {
         KeyboardDevice::the().set_client(nullptr);
@@ -244,13 +252,35 @@ void VirtualConsole::on_key_pressed(KeyboardDevice::Event event)
 ssize_t VirtualConsole::on_tty_write(const u8* data, ssize_t size)
 {
     ScopedSpinLock lock(s_lock);
-    for (ssize_t i = 0; i < size; ++i)
-        m_terminal.on_input(data[i]);
+    m_terminal.on_input(data, size);
     if (m_active)
-        flush_dirty_lines();
+        schedule_flush();
     return size;
 }
 
+void VirtualConsole::schedule_flush()
+{
+    ASSERT(s_lock.is_locked());
+    if (m_flush_pending)
+        return;
+    // Draw right away unless we just did, so typing stays snappy but a stream of
+    // output is only drawn once per interval.
+    u64 now = TimeManagement::the().uptime_in_ticks();
+    u64 interval = max((u64)1, s_flush_interval_ms * TimeManagement::the().ticks_per_second() / 1000);
+    if (now - m_last_flush_ticks >= interval) {
+        flush_dirty_lines();
+        return;
+    }
+    m_flush_pending = true;
+    timeval timeout { 0, (suseconds_t)(s_flush_interval_ms * 1000) };
+    TimerQueue::the().add_timer(timeout, [this] {
+        ScopedSpinLock lock(s_lock);
+        m_flush_pending = false;
+        if (m_active)
+            flush_dirty_lines();
+    });
+}
+
 void VirtualConsole::set_vga_start_row(u16 row)
 {
     m_vga_start_row = row;
@@ -262,6 +292,21 @@ void VirtualConsole::set_vga_start_row(u16 row)
     IO::out8(0x3d5, LSB(m_current_vga_start_address));
 }
 
+void VirtualConsole::scroll_vga_up(u16 lines)
+{
+    ASSERT(lines < m_terminal.rows());
+    u16 kept_rows = m_terminal.rows() - lines;
+    if (!m_graphical && m_vga_start_row + lines + m_terminal.rows() <= s_max_vga_rows) {
+        // There's room further down in VGA memory, so just pan the visible window.
+        set_vga_start_row(m_vga_start_row + lines);
+    } else {
+        memmove(s_vga_buffer, m_current_vga_window + lines * 160, kept_rows * 160);
+        set_vga_start_row(0);
+    }
+    for (u16 row = kept_rows; row < m_terminal.rows(); ++row)
+        clear_vga_row(row);
+}
+
 static inline u8 attribute_to_vga(const VT::Attribute& attribute)
 {
     u8 vga_attr = 0x07;
@@ -282,21 +327,45 @@ static inline u8 attribute_to_vga(const VT::Attribute& attribute)
 
 void VirtualConsole::flush_dirty_lines()
 {
+    bool full_flush = m_terminal.m_need_full_flush;
+    // If the only reason for a full flush is that the screen scrolled, move what's already
+    // on screen instead, and then draw just the lines that changed.
+    if (full_flush && m_terminal.m_scrolled_lines && m_terminal.m_scrolled_lines < m_terminal.rows()) {
+        scroll_vga_up(m_terminal.m_scrolled_lines);
+        full_flush = false;
+    }
+
+    // Most runs of text share the same attribute, so avoid converting it for every cell.
+    u32 last_foreground_color = 0;
+    u32 last_background_color = 0;
+    u8 last_flags = 0;
+    u8 last_vga_attribute = 0;
+    bool have_last_attribute = false;
+
     for (u16 visual_row = 0; visual_row < m_terminal.rows(); ++visual_row) {
         auto& line = m_terminal.visible_line(visual_row);
-        if (!line.is_dirty() && !m_terminal.m_need_full_flush)
+        if (!line.is_dirty() && !full_flush)
             continue;
+        u8* row_memory = &m_current_vga_window[visual_row * 160];
         for (size_t column = 0; column < line.length(); ++column) {
             u32 code_point = line.code_point(column);
-            auto attribute = line.attributes()[column];
-            u16 vga_index = (visual_row * 160) + (column * 2);
-            m_current_vga_window[vga_index] = code_point < 128 ? code_point : '?';
-            m_current_vga_window[vga_index + 1] = attribute_to_vga(attribute);
+            auto& attribute = line.attributes()[column];
+            if (!have_last_attribute || attribute.foreground_color != last_foreground_color || attribute.background_color != last_background_color || attribute.flags != last_flags) {
+                last_foreground_color = attribute.foreground_color;
+                last_background_color = attribute.background_color;
+                last_flags = attribute.flags;
+                last_vga_attribute = attribute_to_vga(attribute);
+                have_last_attribute = true;
+            }
+            row_memory[column * 2] = code_point < 128 ? code_point : '?';
+            row_memory[column * 2 + 1] = last_vga_attribute;
         }
         line.set_dirty(false);
     }
     flush_vga_cursor();
     m_terminal.m_need_full_flush = false;
+    m_terminal.m_scrolled_lines = 0;
+    m_last_flush_ticks = TimeManagement::the().uptime_in_ticks();
 }
 
 void VirtualConsole::beep()
@@ -73,6 +73,7 @@ private:
 
     void flush_vga_cursor();
     void flush_dirty_lines();
+    void schedule_flush();
 
     unsigned m_index;
     bool m_active { false };
@@ -80,10 +81,14 @@ private:
 
     void clear_vga_row(u16 row);
     void set_vga_start_row(u16 row);
+    void scroll_vga_up(u16 lines);
     u16 m_vga_start_row { 0 };
     u16 m_current_vga_start_address { 0 };
     u8* m_current_vga_window { nullptr };
 
+    u64 m_last_flush_ticks { 0 };
+    bool m_flush_pending { false };
+
     VT::Terminal m_terminal;
 
     String m_tty_name;
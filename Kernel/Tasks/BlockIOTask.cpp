@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Process.h>
+#include <Kernel/Tasks/BlockIOTask.h>
+
+namespace Kernel {
+
+static SpinLock<u8> s_lock;
+static BlockDevice::BlockIOList* s_devices_with_work;
+static WaitQueue* s_wait_queue;
+
+void BlockIOTask::spawn()
+{
+    s_devices_with_work = new BlockDevice::BlockIOList;
+    s_wait_queue = new WaitQueue;
+
+    Thread* block_io_thread = nullptr;
+    Process::create_kernel_process(block_io_thread, "BlockIOTask", [] {
+        Thread::current()->set_priority(THREAD_PRIORITY_HIGH);
+        for (;;) {
+            BlockDevice* device;
+            {
+                ScopedSpinLock lock(s_lock);
+                device = s_devices_with_work->take_first();
+            }
+            if (!device) {
+                Thread::current()->wait_on(*s_wait_queue, "BlockIOTask");
+                continue;
+            }
+            device->dispatch_pending_requests();
+        }
+    });
+}
+
+void BlockIOTask::schedule(BlockDevice& device)
+{
+    if (!s_wait_queue) {
+        // We're still booting, so just do the work right here.
+        device.dispatch_pending_requests();
+        return;
+    }
+    {
+        ScopedSpinLock lock(s_lock);
+        if (device.m_block_io_node.is_in_list())
+            return;
+        s_devices_with_work->append(device);
+    }
+    s_wait_queue->wake_all();
+}
+
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Vector.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/Process.h>
+#include <Kernel/Tasks/IORingTask.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+struct IORingOperation {
+    NonnullRefPtr<IORing> ring;
+    ProcessID pid;
+    io_ring_sqe sqe;
+    NonnullRefPtr<FileDescription> description;
+};
+
+// Don't let userspace queue up an unbounded amount of kernel memory.
+static constexpr size_t max_queued_operations = 4 * IO_RING_MAX_ENTRIES;
+
+static SpinLock<u8> s_lock;
+static Vector<IORingOperation>* s_operations;
+
+static bool is_ready(const IORingOperation& operation)
+{
+    auto& description = *operation.description;
+    // Regular files are always "ready", the wait for the disk happens in here instead of in the caller.
+    if (description.file().is_seekable())
+        return true;
+    switch (operation.sqe.opcode) {
+    case IO_RING_OP_READ:
+    case IO_RING_OP_ACCEPT:
+        return description.can_read();
+    case IO_RING_OP_WRITE:
+        return description.can_write();
+    default:
+        return true;
+    }
+}
+
+static Optional<IORingOperation> take_ready_operation()
+{
+    ScopedSpinLock lock(s_lock);
+    for (size_t i = 0; i < s_operations->size(); ++i) {
+        if (is_ready(s_operations->at(i)))
+            return s_operations->take(i);
+    }
+    return {};
+}
+
+static void run(IORingOperation& operation)
+{
+    auto process = Process::from_pid(operation.pid);
+    if (!process || process->is_dead())
+        return;
+
+    // User pointers in the entry refer to the submitting process' address space.
+    MM.enter_process_paging_scope(*process);
+    i32 result = process->do_io_ring_operation(operation.sqe, *operation.description);
+    MM.enter_process_paging_scope(*Process::current());
+    operation.ring->post_completion(operation.sqe.user_data, result);
+}
+
+void IORingTask::spawn()
+{
+    s_operations = new Vector<IORingOperation>;
+
+    Thread* io_ring_thread = nullptr;
+    Process::create_kernel_process(io_ring_thread, "IORingTask", [] {
+        for (;;) {
+            auto operation = take_ready_operation();
+            if (!operation.has_value()) {
+                (void)Thread::current()->block<Thread::IORingTaskBlocker>(nullptr);
+                continue;
+            }
+            run(operation.value());
+        }
+    });
+}
+
+bool IORingTask::schedule(IORing& ring, Process& process, const io_ring_sqe& sqe, NonnullRefPtr<FileDescription>&& description)
+{
+    ScopedSpinLock lock(s_lock);
+    if (!s_operations || s_operations->size() >= max_queued_operations)
+        return false;
+    s_operations->append({ ring, process.pid(), sqe, move(description) });
+    return true;
+}
+
+bool IORingTask::has_runnable_work()
+{
+    ScopedSpinLock lock(s_lock);
+    for (auto& operation : *s_operations) {
+        if (is_ready(operation))
+            return true;
+    }
+    return false;
+}
+
+}
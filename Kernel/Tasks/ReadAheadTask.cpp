@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Vector.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Process.h>
+#include <Kernel/Tasks/ReadAheadTask.h>
+#include <Kernel/VM/MemoryManager.h>
+
+namespace Kernel {
+
+struct ReadAheadRequest {
+    NonnullRefPtr<Inode> inode;
+    size_t first_page_index { 0 };
+    size_t page_count { 0 };
+};
+
+// Don't let a single madvise() queue up an unbounded amount of work.
+static constexpr size_t max_queued_requests = 32;
+static constexpr size_t pages_per_chunk = 64;
+
+static SpinLock<u8> s_lock;
+static Vector<ReadAheadRequest>* s_requests;
+static WaitQueue* s_wait_queue;
+
+static bool enough_free_memory()
+{
+    // Reading ahead is only worth it if it doesn't push out something else.
+    return MM.user_physical_pages() - MM.user_physical_pages_used() > MM.user_physical_pages() / 16;
+}
+
+static void read_ahead(ReadAheadRequest& request)
+{
+    auto& inode = *request.inode;
+    size_t last_page_index = min(request.first_page_index + request.page_count, ceil_div(inode.size(), PAGE_SIZE));
+    for (size_t chunk = request.first_page_index; chunk < last_page_index; chunk += pages_per_chunk) {
+        if (!enough_free_memory())
+            return;
+        size_t chunk_page_count = min(last_page_index - chunk, pages_per_chunk);
+        inode.read_ahead_pages(chunk, chunk_page_count);
+        if (!inode.is_page_cacheable())
+            continue;
+        for (size_t page_index = chunk; page_index < chunk + chunk_page_count; ++page_index) {
+            if (inode.cached_page(page_index).is_error())
+                return;
+        }
+    }
+}
+
+void ReadAheadTask::spawn()
+{
+    s_requests = new Vector<ReadAheadRequest>;
+    s_wait_queue = new WaitQueue;
+
+    Thread* read_ahead_thread = nullptr;
+    Process::create_kernel_process(read_ahead_thread, "ReadAheadTask", [] {
+        for (;;) {
+            Optional<ReadAheadRequest> request;
+            {
+                ScopedSpinLock lock(s_lock);
+                if (!s_requests->is_empty())
+                    request = s_requests->take_first();
+            }
+            if (!request.has_value()) {
+                Thread::current()->wait_on(*s_wait_queue, "ReadAheadTask");
+                continue;
+            }
+            read_ahead(request.value());
+        }
+    });
+}
+
+void ReadAheadTask::schedule(Inode& inode, size_t first_page_index, size_t page_count)
+{
+    if (!s_wait_queue || !page_count)
+        return;
+    {
+        ScopedSpinLock lock(s_lock);
+        if (s_requests->size() >= max_queued_requests)
+            return;
+        s_requests->append({ inode, first_page_index, page_count });
+    }
+    s_wait_queue->wake_all();
+}
+
+}
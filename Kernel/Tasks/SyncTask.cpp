@@ -31,16 +31,27 @@
 
 namespace Kernel {
 
+static WaitQueue* s_wait_queue;
+
 void SyncTask::spawn()
 {
+    s_wait_queue = new WaitQueue;
+
     Thread* syncd_thread = nullptr;
     Process::create_kernel_process(syncd_thread, "SyncTask", [] {
         dbg() << "SyncTask is running";
         for (;;) {
             VFS::the().sync();
-            Thread::current()->sleep(1 * TimeManagement::the().ticks_per_second());
+            timeval timeout { 1, 0 };
+            Thread::current()->wait_on(*s_wait_queue, "SyncTask", &timeout);
         }
     });
 }
 
+void SyncTask::wake()
+{
+    if (s_wait_queue)
+        s_wait_queue->wake_all();
+}
+
 }
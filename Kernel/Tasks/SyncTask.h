@@ -30,5 +30,8 @@ namespace Kernel {
 class SyncTask {
 public:
     static void spawn();
+
+    // Asks for a write-back before the next periodic one is due.
+    static void wake();
 };
 }
@@ -29,11 +29,13 @@
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/KSyms.h>
+#include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/Profiling.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/Thread.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/TimerQueue.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
@@ -60,6 +62,12 @@ Thread::Thread(NonnullRefPtr<Process> process)
     dbg() << "Created new thread " << m_process->name() << "(" << m_process->pid().value() << ":" << m_tid.value() << ")";
 #endif
     set_default_signal_dispositions();
+    m_wait_timer.callback = [this] {
+        // The thread may have been woken up normally while this was about to fire.
+        ScopedSpinLock lock(g_scheduler_lock);
+        if (state() == State::Queued)
+            wake_from_queue();
+    };
     m_fpu_state = (FPUState*)kmalloc_aligned(sizeof(FPUState), 16);
     reset_fpu_state();
     memset(&m_tss, 0, sizeof(m_tss));
@@ -106,6 +114,7 @@ Thread::Thread(NonnullRefPtr<Process> process)
 
 Thread::~Thread()
 {
+    ASSERT(!m_wait_timer.is_queued());
     kfree_aligned(m_fpu_state);
 
     auto thread_cnt_before = m_process->m_thread_count.fetch_sub(1, AK::MemoryOrder::memory_order_acq_rel);
@@ -218,13 +227,11 @@ u64 Thread::sleep(u64 ticks)
     return wakeup_time;
 }
 
-u64 Thread::sleep_until(u64 wakeup_time)
+bool Thread::sleep_until_monotonic(u64 nanoseconds)
 {
     ASSERT(state() == Thread::Running);
-    auto ret = Thread::current()->block<Thread::SleepBlocker>(nullptr, wakeup_time);
-    if (wakeup_time > g_uptime)
-        ASSERT(ret.was_interrupted());
-    return wakeup_time;
+    auto ret = Thread::current()->block<Thread::MonotonicSleepBlocker>(nullptr, nanoseconds);
+    return !ret.was_interrupted();
 }
 
 const char* Thread::state_string() const
@@ -267,6 +274,11 @@ void Thread::finalize()
 #endif
     set_state(Thread::State::Dead);
 
+    {
+        ScopedSpinLock lock(m_process->get_lock());
+        m_process->m_exited_threads_io_statistics.add(m_io_statistics);
+    }
+
     if (m_joiner) {
         ScopedSpinLock lock(m_joiner->m_lock);
         ASSERT(m_joiner->m_joinee == this);
@@ -302,14 +314,32 @@ void Thread::finalize_dying_threads()
     }
 }
 
-bool Thread::tick()
+void Thread::set_inherited_priority(u32 priority)
 {
-    ++m_ticks;
+    ScopedSpinLock lock(g_scheduler_lock);
+    if (m_inherited_priority == priority)
+        return;
+    // The ready queues are bucketed by priority, so move the thread
+    // to its new bucket if it's waiting to run.
+    bool was_queued = Scheduler::dequeue_runnable_thread(*this);
+    m_inherited_priority = priority;
+    if (was_queued)
+        Scheduler::enqueue_runnable_thread(*this);
+}
+
+bool Thread::tick(u32 ticks)
+{
+    m_ticks += ticks;
     if (tss().cs & 3)
-        ++m_process->m_ticks_in_user;
+        m_process->m_ticks_in_user += ticks;
     else
-        ++m_process->m_ticks_in_kernel;
-    return --m_ticks_left;
+        m_process->m_ticks_in_kernel += ticks;
+    if (m_ticks_left <= ticks) {
+        m_ticks_left = 0;
+        return false;
+    }
+    m_ticks_left -= ticks;
+    return true;
 }
 
 void Thread::send_signal(u8 signal, [[maybe_unused]] Process* sender)
@@ -619,6 +649,7 @@ RegisterState& Thread::get_register_dump_from_stack()
 
 u32 Thread::make_userspace_stack_for_main_thread(Vector<String> arguments, Vector<String> environment, Vector<AuxiliaryValue> auxiliary_values)
 {
+    LOCKER(m_process->address_space_lock());
     auto* region = m_process->allocate_region(VirtualAddress(), default_userspace_stack_size, "Stack (Main thread)", PROT_READ | PROT_WRITE, false);
     ASSERT(region);
     region->set_stack(true);
@@ -693,6 +724,9 @@ Thread* Thread::clone(Process& process)
     auto* clone = new Thread(process);
     memcpy(clone->m_signal_action_data, m_signal_action_data, sizeof(m_signal_action_data));
     clone->m_signal_mask = m_signal_mask;
+    // Our FPU registers may have changed since they were last saved.
+    ASSERT(this == Thread::current());
+    Processor::current().save_fpu_state_of_current_thread();
     memcpy(clone->m_fpu_state, m_fpu_state, sizeof(FPUState));
     clone->m_thread_specific_data = m_thread_specific_data;
     clone->m_thread_specific_region_size = m_thread_specific_region_size;
@@ -747,6 +781,11 @@ void Thread::update_state_for_thread(Thread::State previous_state)
         previous_list.remove(*this);
     }
 
+    if (m_state == Runnable)
+        Scheduler::enqueue_runnable_thread(*this);
+    else if (previous_state == Runnable)
+        Scheduler::dequeue_runnable_thread(*this);
+
     if (list.contains(*this))
         return;
 
@@ -851,6 +890,7 @@ void Thread::make_thread_specific_region(Badge<Process>)
 {
     size_t thread_specific_region_alignment = max(process().m_master_tls_alignment, alignof(ThreadSpecificData));
     m_thread_specific_region_size = align_up_to(process().m_master_tls_size, thread_specific_region_alignment) + sizeof(ThreadSpecificData);
+    LOCKER(process().address_space_lock());
     auto* region = process().allocate_region({}, m_thread_specific_region_size, "Thread-specific", PROT_READ | PROT_WRITE, true);
     SmapDisabler disabler;
     auto* thread_specific_data = (ThreadSpecificData*)region->vaddr().offset(align_up_to(process().m_master_tls_size, thread_specific_region_alignment)).as_ptr();
@@ -869,8 +909,8 @@ const LogStream& operator<<(const LogStream& stream, const Thread& value)
 Thread::BlockResult Thread::wait_on(WaitQueue& queue, const char* reason, timeval* timeout, Atomic<bool>* lock, Thread* beneficiary)
 {
     auto* current_thread = Thread::current();
-    TimerId timer_id {};
     bool did_unlock;
+    u64 off_cpu_start = current_thread->begin_off_cpu_trace();
 
     {
         ScopedCritical critical;
@@ -899,9 +939,10 @@ Thread::BlockResult Thread::wait_on(WaitQueue& queue, const char* reason, timeva
             m_wait_reason = reason;
 
             if (timeout) {
-                timer_id = TimerQueue::the().add_timer(*timeout, [&]() {
-                    wake_from_queue();
-                });
+                u64 ticks = TimerQueue::the().ticks_from_timeval(*timeout);
+                m_wait_timer.expires = g_uptime + ticks;
+                m_wait_timer.slack = TimerQueue::default_slack_for(ticks);
+                TimerQueue::the().add_timer(m_wait_timer);
             }
 
             // Yield and wait for the queue to wake us up again.
@@ -943,21 +984,44 @@ Thread::BlockResult Thread::wait_on(WaitQueue& queue, const char* reason, timeva
         // scheduler lock, which is held when we insert into the queue
         ScopedSpinLock sched_lock(g_scheduler_lock);
 
-        // If our thread was still in the queue, we timed out
-        if (queue.dequeue(*current_thread))
+        // If our thread was still in the queue, we timed out. Note that
+        // we may have been moved over to another queue in the meantime.
+        auto& current_queue = current_thread->m_wait_queue ? *current_thread->m_wait_queue : queue;
+        current_thread->m_wait_queue = nullptr;
+        if (current_queue.dequeue(*current_thread))
             result = BlockResult::InterruptedByTimeout;
 
         // Make sure we cancel the timer if woke normally.
         if (timeout && !result.was_interrupted())
-            TimerQueue::the().cancel_timer(timer_id);
+            TimerQueue::the().cancel_timer(m_wait_timer);
     }
 
     // The API contract guarantees we return with interrupts enabled,
     // regardless of how we got called
     sti();
+
+    current_thread->end_off_cpu_trace(off_cpu_start, reason);
     return result;
 }
 
+u64 Thread::begin_off_cpu_trace() const
+{
+    if (!m_process->is_tracing_off_cpu())
+        return 0;
+    return TimeManagement::the().monotonic_nanoseconds();
+}
+
+void Thread::end_off_cpu_trace(u64 start, const char* reason)
+{
+    if (!start)
+        return;
+    auto* buffer = m_process->perf_events();
+    if (!buffer)
+        return;
+    u64 now = TimeManagement::the().monotonic_nanoseconds();
+    (void)buffer->append_off_cpu(reason, now > start ? now - start : 0);
+}
+
 void Thread::wake_from_queue()
 {
     ScopedSpinLock lock(g_scheduler_lock);
@@ -985,6 +1049,12 @@ Thread* Thread::from_tid(ThreadID tid)
 
 void Thread::reset_fpu_state()
 {
+    // Whatever is still loaded in some processor's FPU registers is stale now, and must neither be
+    // saved over the new state nor be used again.
+    ScopedCritical critical;
+    m_fpu_cpu = 0xffffffff;
+    if (this == Thread::current())
+        write_cr0(read_cr0() | CR0_TS);
     memcpy(m_fpu_state, &Processor::current().clean_fpu_state(), sizeof(FPUState));
 }
 
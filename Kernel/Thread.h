@@ -34,9 +34,11 @@
 #include <AK/Vector.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Forward.h>
+#include <Kernel/IOStatistics.h>
 #include <Kernel/KResult.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/TimerQueue.h>
 #include <Kernel/UnixTypes.h>
 #include <LibC/fd_set.h>
 #include <LibELF/AuxiliaryVector.h>
@@ -94,8 +96,15 @@ public:
     void set_priority_boost(u32 boost) { m_priority_boost = boost; }
     u32 priority_boost() const { return m_priority_boost; }
 
+    // Priority lent to us by higher priority threads waiting on a lock we hold.
+    void set_inherited_priority(u32);
+    u32 inherited_priority() const { return m_inherited_priority; }
+
     u32 effective_priority() const;
 
+    static constexpr u32 wait_bitset_match_any = 0xffffffff;
+    void set_wait_bitset(u32 bitset) { m_wait_bitset = bitset; }
+
     void set_joinable(bool j) { m_is_joinable = j; }
     bool is_joinable() const { return m_is_joinable; }
 
@@ -221,6 +230,16 @@ public:
         u64 m_wakeup_time { 0 };
     };
 
+    class MonotonicSleepBlocker final : public Blocker {
+    public:
+        explicit MonotonicSleepBlocker(u64 wakeup_time);
+        virtual bool should_unblock(Thread&) override;
+        virtual const char* state_string() const override { return "Sleeping"; }
+
+    private:
+        u64 m_wakeup_time { 0 };
+    };
+
     class SelectBlocker final : public Blocker {
     public:
         typedef Vector<int, FD_SETSIZE> FDVector;
@@ -234,6 +253,33 @@ public:
         const FDVector& m_select_exceptional_fds;
     };
 
+    class EventPollBlocker final : public Blocker {
+    public:
+        explicit EventPollBlocker(const EventPoll&);
+        virtual bool should_unblock(Thread&) override;
+        virtual const char* state_string() const override { return "Selecting"; }
+
+    private:
+        const EventPoll& m_event_poll;
+    };
+
+    class IORingBlocker final : public Blocker {
+    public:
+        IORingBlocker(const IORing&, u32 min_completions);
+        virtual bool should_unblock(Thread&) override;
+        virtual const char* state_string() const override { return "IORing"; }
+
+    private:
+        const IORing& m_ring;
+        u32 m_min_completions { 0 };
+    };
+
+    class IORingTaskBlocker final : public Blocker {
+    public:
+        virtual bool should_unblock(Thread&) override;
+        virtual const char* state_string() const override { return "IORing"; }
+    };
+
     class WaitBlocker final : public Blocker {
     public:
         WaitBlocker(int wait_options, ProcessID& waitee_pid);
@@ -300,7 +346,8 @@ public:
     size_t thread_specific_region_size() const { return m_thread_specific_region_size; }
 
     u64 sleep(u64 ticks);
-    u64 sleep_until(u64 wakeup_time);
+    // Sleeps until the given monotonic time, in nanoseconds since boot. Returns false if interrupted.
+    bool sleep_until_monotonic(u64 nanoseconds);
 
     class BlockResult {
     public:
@@ -361,9 +408,13 @@ public:
             set_state(Thread::Blocked);
         }
 
+        u64 off_cpu_start = begin_off_cpu_trace();
+
         // Yield to the scheduler, and wait for us to resume unblocked.
         yield_without_holding_big_lock();
 
+        end_off_cpu_trace(off_cpu_start, t.state_string());
+
         ScopedSpinLock lock(m_lock);
         // We should no longer be blocked once we woke up
         ASSERT(state() != Thread::Blocked);
@@ -391,13 +442,18 @@ public:
 
     void unblock();
 
+    // Off-CPU tracing: returns a start time (or 0 if the process isn't being traced)
+    // and records how long we were blocked, and from where, once we're back.
+    u64 begin_off_cpu_trace() const;
+    void end_off_cpu_trace(u64 start, const char* reason);
+
     // Tell this thread to unblock if needed,
     // gracefully unwind the stack and die.
     void set_should_die();
     bool should_die() const { return m_should_die; }
     void die_if_needed();
 
-    bool tick();
+    bool tick(u32 ticks = 1);
     void set_ticks_left(u32 t) { m_ticks_left = t; }
     u32 ticks_left() const { return m_ticks_left; }
 
@@ -424,6 +480,20 @@ public:
     bool has_pending_signal(u8 signal) const { return m_pending_signals & (1 << (signal - 1)); }
 
     FPUState& fpu_state() { return *m_fpu_state; }
+    u32 fpu_cpu() const { return m_fpu_cpu; }
+    void did_save_fpu_state(u32 cpu)
+    {
+        ++m_fpu_saves;
+        m_fpu_cpu = cpu;
+    }
+    void did_restore_fpu_state(u32 cpu)
+    {
+        ++m_fpu_restores;
+        m_fpu_cpu = cpu;
+    }
+    // Every time the thread was scheduled without needing a restore, we saved one.
+    unsigned fpu_saves() const { return m_fpu_saves; }
+    unsigned fpu_restores() const { return m_fpu_restores; }
 
     void set_default_signal_dispositions();
     void push_value_on_stack(FlatPtr);
@@ -432,8 +502,10 @@ public:
 
     void make_thread_specific_region(Badge<Process>);
 
-    unsigned syscall_count() const { return m_syscall_count; }
-    void did_syscall() { ++m_syscall_count; }
+    const IOStatistics& io_statistics() const { return m_io_statistics; }
+
+    unsigned syscall_count() const { return m_io_statistics.syscall_count; }
+    void did_syscall() { ++m_io_statistics.syscall_count; }
     unsigned inode_faults() const { return m_inode_faults; }
     void did_inode_fault() { ++m_inode_faults; }
     unsigned zero_faults() const { return m_zero_faults; }
@@ -441,45 +513,52 @@ public:
     unsigned cow_faults() const { return m_cow_faults; }
     void did_cow_fault() { ++m_cow_faults; }
 
-    unsigned file_read_bytes() const { return m_file_read_bytes; }
-    unsigned file_write_bytes() const { return m_file_write_bytes; }
+    unsigned file_read_bytes() const { return m_io_statistics.file_read_bytes; }
+    unsigned file_write_bytes() const { return m_io_statistics.file_write_bytes; }
 
     void did_file_read(unsigned bytes)
     {
-        m_file_read_bytes += bytes;
+        m_io_statistics.file_read_bytes += bytes;
     }
 
     void did_file_write(unsigned bytes)
     {
-        m_file_write_bytes += bytes;
+        m_io_statistics.file_write_bytes += bytes;
     }
 
-    unsigned unix_socket_read_bytes() const { return m_unix_socket_read_bytes; }
-    unsigned unix_socket_write_bytes() const { return m_unix_socket_write_bytes; }
+    unsigned unix_socket_read_bytes() const { return m_io_statistics.unix_socket_read_bytes; }
+    unsigned unix_socket_write_bytes() const { return m_io_statistics.unix_socket_write_bytes; }
 
     void did_unix_socket_read(unsigned bytes)
     {
-        m_unix_socket_read_bytes += bytes;
+        m_io_statistics.unix_socket_read_bytes += bytes;
     }
 
     void did_unix_socket_write(unsigned bytes)
     {
-        m_unix_socket_write_bytes += bytes;
+        m_io_statistics.unix_socket_write_bytes += bytes;
     }
 
-    unsigned ipv4_socket_read_bytes() const { return m_ipv4_socket_read_bytes; }
-    unsigned ipv4_socket_write_bytes() const { return m_ipv4_socket_write_bytes; }
+    unsigned ipv4_socket_read_bytes() const { return m_io_statistics.ipv4_socket_read_bytes; }
+    unsigned ipv4_socket_write_bytes() const { return m_io_statistics.ipv4_socket_write_bytes; }
 
     void did_ipv4_socket_read(unsigned bytes)
     {
-        m_ipv4_socket_read_bytes += bytes;
+        m_io_statistics.ipv4_socket_read_bytes += bytes;
     }
 
     void did_ipv4_socket_write(unsigned bytes)
     {
-        m_ipv4_socket_write_bytes += bytes;
+        m_io_statistics.ipv4_socket_write_bytes += bytes;
     }
 
+    unsigned block_io_requests() const { return m_io_statistics.block_io_requests; }
+    void did_block_io_request() { ++m_io_statistics.block_io_requests; }
+
+    LatencyHistogram& read_latency() { return m_io_statistics.read_latency; }
+    LatencyHistogram& write_latency() { return m_io_statistics.write_latency; }
+    LatencyHistogram& page_fault_latency() { return m_io_statistics.page_fault_latency; }
+
     const char* wait_reason() const
     {
         return m_wait_reason;
@@ -524,9 +603,13 @@ public:
 private:
     IntrusiveListNode m_runnable_list_node;
     IntrusiveListNode m_wait_queue_node;
+    WaitQueue* m_wait_queue { nullptr };
+    u32 m_wait_bitset { wait_bitset_match_any };
+    IntrusiveListNode m_ready_queue_node;
 
 private:
     friend class SchedulerData;
+    friend struct ThreadReadyQueue;
     friend class WaitQueue;
     bool unlock_process_if_locked();
     void relock_process(bool did_unlock);
@@ -553,6 +636,7 @@ private:
     Blocker* m_blocker { nullptr };
     timespec* m_blocker_timeout { nullptr };
     const char* m_wait_reason { nullptr };
+    Timer m_wait_timer;
 
     bool m_is_active { false };
     bool m_is_joinable { true };
@@ -560,26 +644,24 @@ private:
     Thread* m_joinee { nullptr };
     void* m_exit_value { nullptr };
 
-    unsigned m_syscall_count { 0 };
     unsigned m_inode_faults { 0 };
     unsigned m_zero_faults { 0 };
     unsigned m_cow_faults { 0 };
 
-    unsigned m_file_read_bytes { 0 };
-    unsigned m_file_write_bytes { 0 };
-
-    unsigned m_unix_socket_read_bytes { 0 };
-    unsigned m_unix_socket_write_bytes { 0 };
-
-    unsigned m_ipv4_socket_read_bytes { 0 };
-    unsigned m_ipv4_socket_write_bytes { 0 };
+    IOStatistics m_io_statistics;
 
     FPUState* m_fpu_state { nullptr };
+    u32 m_fpu_cpu { 0xffffffff }; // The processor whose FPU registers last held our state
+    unsigned m_fpu_saves { 0 };
+    unsigned m_fpu_restores { 0 };
     State m_state { Invalid };
     String m_name;
     u32 m_priority { THREAD_PRIORITY_NORMAL };
-    u32 m_extra_priority { 0 };
     u32 m_priority_boost { 0 };
+    u32 m_inherited_priority { 0 };
+    u32 m_extra_priority { 0 };
+    u32 m_ready_queue_cpu { 0 };
+    u32 m_ready_queue_bucket { 0 };
 
     u8 m_stop_signal { 0 };
     State m_stop_state { Invalid };
@@ -36,7 +36,6 @@
 namespace Kernel {
 
 #define ABSOLUTE_MAXIMUM_COUNTER_TICK_PERIOD 0x05F5E100
-#define NANOSECOND_PERIOD_TO_HERTZ(x) 1000000000 / x
 #define MEGAHERTZ_TO_HERTZ(x) (x / 1000000)
 
 //#define HPET_DEBUG
@@ -185,6 +184,26 @@ void HPET::set_non_periodic_comparator_value(const HPETComparator& comparator, u
     registers().timers[comparator.comparator_number()].comparator_value = main_counter_value() + value;
 }
 
+void HPET::set_comparator_deadline(const HPETComparator& comparator, u64 main_counter_deadline)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(!comparator.is_periodic());
+    ASSERT(comparator.comparator_number() <= m_comparators.size());
+    volatile auto& timer = registers().timers[comparator.comparator_number()];
+
+    // The comparator only fires when the counter passes its exact value, so a deadline
+    // that has already gone by would never fire. Keep it a little ahead of the counter.
+    u64 minimum_distance = max<u64>(m_minimum_tick, m_frequency / 100'000);
+    for (;;) {
+        u64 now = read_main_counter();
+        if (main_counter_deadline < now + minimum_distance)
+            main_counter_deadline = now + minimum_distance;
+        timer.comparator_value = main_counter_deadline;
+        if (read_main_counter() < main_counter_deadline)
+            return;
+    }
+}
+
 void HPET::enable_periodic_interrupt(const HPETComparator& comparator)
 {
 #ifdef HPET_DEBUG
@@ -233,7 +252,39 @@ void HPET::enable(const HPETComparator& comparator)
 
 u64 HPET::main_counter_value() const
 {
-    return registers().main_counter_value.reg;
+    // Note: Reading a 64-bit counter takes two 32-bit accesses on i386, so make sure the
+    //       upper half didn't change underneath us.
+    auto* main_counter = (const volatile u32*)&registers().main_counter_value.reg;
+    if (!counter_is_64_bit_capable)
+        return main_counter[0];
+    for (;;) {
+        u32 high = main_counter[1];
+        u32 low = main_counter[0];
+        if (high == main_counter[1])
+            return ((u64)high << 32) | low;
+    }
+}
+
+u64 HPET::read_main_counter()
+{
+    if (counter_is_64_bit_capable)
+        return main_counter_value();
+    ScopedSpinLock lock(m_main_counter_lock);
+    u32 current_value = main_counter_value();
+    if (current_value < m_main_counter_last_read)
+        m_main_counter_wraps += 0x100000000ull;
+    m_main_counter_last_read = current_value;
+    return m_main_counter_wraps + current_value;
+}
+
+u64 HPET::raw_counter_ticks_to_ns(u64 raw_ticks) const
+{
+    return (raw_ticks / m_frequency) * 1'000'000'000ull + (raw_ticks % m_frequency) * 1'000'000'000ull / m_frequency;
+}
+
+u64 HPET::ns_to_raw_counter_ticks(u64 ns) const
+{
+    return (ns / 1'000'000'000ull) * m_frequency + (ns % 1'000'000'000ull) * m_frequency / 1'000'000'000ull;
 }
 
 u64 HPET::frequency() const
@@ -306,11 +357,6 @@ volatile HPETRegistersBlock& HPET::registers()
     return *(volatile HPETRegistersBlock*)m_hpet_mmio_region->vaddr().offset(m_physical_acpi_hpet_registers.offset_in_page()).as_ptr();
 }
 
-u64 HPET::calculate_ticks_in_nanoseconds() const
-{
-    return ABSOLUTE_MAXIMUM_COUNTER_TICK_PERIOD / registers().capabilities.main_counter_tick_period;
-}
-
 HPET::HPET(PhysicalAddress acpi_hpet)
     : m_physical_acpi_hpet_table(acpi_hpet)
     , m_physical_acpi_hpet_registers(find_acpi_hpet_registers_block())
@@ -329,13 +375,18 @@ HPET::HPET(PhysicalAddress acpi_hpet)
 
     global_disable();
 
-    m_frequency = NANOSECOND_PERIOD_TO_HERTZ(calculate_ticks_in_nanoseconds());
+    counter_is_64_bit_capable = capabilities_register->attributes & (u32)HPETFlags::Attributes::Counter64BitCapable;
+    legacy_replacement_route_capable = capabilities_register->attributes & (u32)HPETFlags::Attributes::LegacyReplacementRouteCapable;
+
+    // Note: The tick period is given in femtoseconds, which is too fine-grained to
+    //       round it to whole nanoseconds first (e.g. 69841279 fs for a 14.318 MHz HPET).
+    m_frequency = 1'000'000'000'000'000ull / capabilities_register->main_counter_tick_period;
     klog() << "HPET: frequency " << m_frequency << " Hz (" << MEGAHERTZ_TO_HERTZ(m_frequency) << " MHz)";
     ASSERT(capabilities_register->main_counter_tick_period <= ABSOLUTE_MAXIMUM_COUNTER_TICK_PERIOD);
 
     // Reset the counter, just in case...
     registers().main_counter_value.reg = 0;
-    if (registers().raw_capabilites.reg & (u32)HPETFlags::Attributes::LegacyReplacementRouteCapable)
+    if (legacy_replacement_route_capable)
         registers().configuration.reg = registers().configuration.reg | (u32)HPETFlags::Configuration::LegacyReplacementRoute;
 
     m_comparators.append(HPETComparator::create(0, 0, is_periodic_capable(0)));
@@ -32,6 +32,7 @@
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <Kernel/PhysicalAddress.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/VM/Region.h>
 
 namespace Kernel {
@@ -47,14 +48,21 @@ public:
     static HPET& the();
 
     u64 main_counter_value() const;
+    // Unlike main_counter_value(), this keeps counting past the wrap-around of 32-bit counters,
+    // as long as it's called at least once per wrap-around period.
+    u64 read_main_counter();
     u64 frequency() const;
 
+    u64 raw_counter_ticks_to_ns(u64) const;
+    u64 ns_to_raw_counter_ticks(u64) const;
+
     const NonnullRefPtrVector<HPETComparator>& comparators() const { return m_comparators; }
     void disable(const HPETComparator&);
     void enable(const HPETComparator&);
 
     void set_periodic_comparator_value(const HPETComparator& comparator, u64 value);
     void set_non_periodic_comparator_value(const HPETComparator& comparator, u64 value);
+    void set_comparator_deadline(const HPETComparator& comparator, u64 main_counter_deadline);
 
     void set_comparator_irq_vector(u8 comparator_number, u8 irq_vector);
 
@@ -74,8 +82,6 @@ private:
     bool is_periodic_capable(u8 comparator_number) const;
     void set_comparators_to_optimal_interrupt_state(size_t timers_count);
 
-    u64 calculate_ticks_in_nanoseconds() const;
-
     PhysicalAddress find_acpi_hpet_registers_block();
     explicit HPET(PhysicalAddress acpi_hpet);
     PhysicalAddress m_physical_acpi_hpet_table;
@@ -90,6 +96,10 @@ private:
     bool counter_is_64_bit_capable : 1;
     bool legacy_replacement_route_capable : 1;
 
+    SpinLock<u8> m_main_counter_lock;
+    u32 m_main_counter_last_read { 0 };
+    u64 m_main_counter_wraps { 0 };
+
     NonnullRefPtrVector<HPETComparator> m_comparators;
 };
 }
@@ -41,6 +41,7 @@ HPETComparator::HPETComparator(u8 number, u8 irq, bool periodic_capable)
     : HardwareTimer(irq)
     , m_periodic(false)
     , m_periodic_capable(periodic_capable)
+    , m_one_shot(false)
     , m_comparator_number(number)
 {
 }
@@ -58,10 +59,26 @@ void HPETComparator::set_non_periodic()
     m_periodic = false;
 }
 
+void HPETComparator::set_one_shot_mode()
+{
+    InterruptDisabler disabler;
+    if (is_periodic())
+        set_non_periodic();
+    m_one_shot = true;
+    HPET::the().enable(*this);
+}
+
+void HPETComparator::set_one_shot_deadline(u64 nanoseconds_since_boot)
+{
+    ASSERT(m_one_shot);
+    auto& hpet = HPET::the();
+    hpet.set_comparator_deadline(*this, hpet.ns_to_raw_counter_ticks(nanoseconds_since_boot));
+}
+
 void HPETComparator::handle_irq(const RegisterState& regs)
 {
     HardwareTimer::handle_irq(regs);
-    if (!is_periodic())
+    if (!is_periodic() && !m_one_shot)
         set_new_countdown();
 }
 
@@ -55,6 +55,10 @@ public:
     virtual bool is_capable_of_frequency(size_t frequency) const override;
     virtual size_t calculate_nearest_possible_frequency(size_t frequency) const override;
 
+    virtual bool is_capable_of_one_shot_mode() const override { return true; }
+    virtual void set_one_shot_mode() override;
+    virtual void set_one_shot_deadline(u64 nanoseconds_since_boot) override;
+
 private:
     void set_new_countdown();
     virtual void handle_irq(const RegisterState&) override;
@@ -62,6 +66,7 @@ private:
     bool m_periodic : 1;
     bool m_periodic_capable : 1;
     bool m_edge_triggered : 1;
+    bool m_one_shot : 1;
     u8 m_comparator_number { 0 };
 };
 }
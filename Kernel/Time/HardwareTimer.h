@@ -62,6 +62,12 @@ public:
     virtual bool is_capable_of_frequency(size_t frequency) const = 0;
     virtual size_t calculate_nearest_possible_frequency(size_t frequency) const = 0;
 
+    // In one-shot mode the timer no longer re-arms itself after every interrupt,
+    // and instead fires once at the last deadline it has been given.
+    virtual bool is_capable_of_one_shot_mode() const { return false; }
+    virtual void set_one_shot_mode() { ASSERT_NOT_REACHED(); }
+    virtual void set_one_shot_deadline(u64 /* nanoseconds_since_boot */) { ASSERT_NOT_REACHED(); }
+
 protected:
     HardwareTimer(u8 irq_number, Function<void(const RegisterState&)> = nullptr);
     //^IRQHandler
@@ -33,6 +33,7 @@
 #include <Kernel/Time/PIT.h>
 #include <Kernel/Time/RTC.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/TimerQueue.h>
 #include <Kernel/VM/MemoryManager.h>
 
 //#define TIME_DEBUG
@@ -55,11 +56,17 @@ bool TimeManagement::is_system_timer(const HardwareTimer& timer) const
 void TimeManagement::set_epoch_time(time_t value)
 {
     InterruptDisabler disabler;
-    m_epoch_time = value;
+    if (m_tickless)
+        m_epoch_time = value - seconds_since_boot();
+    else
+        m_epoch_time = value;
 }
 
 time_t TimeManagement::epoch_time() const
 {
+    // In tickless mode, nothing counts the seconds, so m_epoch_time is the epoch time at boot.
+    if (m_tickless)
+        return m_epoch_time + seconds_since_boot();
     return m_epoch_time;
 }
 
@@ -73,6 +80,8 @@ void TimeManagement::initialize()
 }
 time_t TimeManagement::seconds_since_boot() const
 {
+    if (m_tickless)
+        return monotonic_nanoseconds() / 1'000'000'000ull;
     return m_seconds_since_boot;
 }
 time_t TimeManagement::ticks_per_second() const
@@ -82,9 +91,109 @@ time_t TimeManagement::ticks_per_second() const
 
 time_t TimeManagement::ticks_this_second() const
 {
+    if (m_tickless)
+        return (monotonic_nanoseconds() % 1'000'000'000ull) * m_time_keeper_timer->ticks_per_second() / 1'000'000'000ull;
     return m_ticks_this_second;
 }
 
+u64 TimeManagement::monotonic_nanoseconds() const
+{
+    if (m_can_query_precise_time)
+        return HPET::the().raw_counter_ticks_to_ns(HPET::the().read_main_counter());
+    return (u64)m_seconds_since_boot * 1'000'000'000ull + (u64)m_ticks_this_second * 1'000'000'000ull / m_time_keeper_timer->ticks_per_second();
+}
+
+timespec TimeManagement::monotonic_time() const
+{
+    u64 nanoseconds = monotonic_nanoseconds();
+    return { (time_t)(nanoseconds / 1'000'000'000ull), (long)(nanoseconds % 1'000'000'000ull) };
+}
+
+u64 TimeManagement::ticks_to_nanoseconds(u64 ticks) const
+{
+    // Rounds up, so that the result is the first nanosecond at which the given tick has begun.
+    u64 ticks_per_second = m_system_timer->ticks_per_second();
+    return (ticks / ticks_per_second) * 1'000'000'000ull + ((ticks % ticks_per_second) * 1'000'000'000ull + ticks_per_second - 1) / ticks_per_second;
+}
+
+u64 TimeManagement::nanoseconds_to_ticks(u64 nanoseconds) const
+{
+    u64 ticks_per_second = m_system_timer->ticks_per_second();
+    return (nanoseconds / 1'000'000'000ull) * ticks_per_second + (nanoseconds % 1'000'000'000ull) * ticks_per_second / 1'000'000'000ull;
+}
+
+u64 TimeManagement::uptime_in_ticks() const
+{
+    return nanoseconds_to_ticks(monotonic_nanoseconds());
+}
+
+void TimeManagement::program_system_timer(u64 deadline)
+{
+    ASSERT(m_system_timer_lock.is_locked());
+    m_programmed_deadline = deadline;
+    m_system_timer->set_one_shot_deadline(deadline);
+}
+
+void TimeManagement::request_wakeup_at(u64 monotonic_nanoseconds)
+{
+    if (!m_tickless)
+        return;
+    ScopedSpinLock lock(m_system_timer_lock);
+    if (monotonic_nanoseconds < m_next_wakeup)
+        m_next_wakeup = monotonic_nanoseconds;
+    if (monotonic_nanoseconds < m_programmed_deadline)
+        program_system_timer(monotonic_nanoseconds);
+}
+
+void TimeManagement::request_wakeup_at_tick(u64 uptime_ticks)
+{
+    if (!m_tickless)
+        return;
+    request_wakeup_at(ticks_to_nanoseconds(uptime_ticks));
+}
+
+bool TimeManagement::rearm_system_timer()
+{
+    ASSERT(m_tickless);
+    ASSERT_INTERRUPTS_DISABLED();
+    u64 now = monotonic_nanoseconds();
+    ScopedSpinLock lock(m_system_timer_lock);
+    bool wakeup_is_due = m_next_wakeup <= now;
+    if (wakeup_is_due)
+        m_next_wakeup = NumericLimits<u64>::max();
+    u64 next_tick = ticks_to_nanoseconds(nanoseconds_to_ticks(now) + 1);
+    program_system_timer(min(next_tick, m_next_wakeup));
+    return wakeup_is_due;
+}
+
+void TimeManagement::enter_idle()
+{
+    if (!m_tickless)
+        return;
+    ASSERT_INTERRUPTS_DISABLED();
+
+    // FIXME: Threads woken up from another processor don't kick this one out of
+    //        its idle sleep, so only sleep for long while we're the only one.
+    u64 now = monotonic_nanoseconds();
+    u64 deadline = now + (Processor::count() > 1 ? 10'000'000ull : 1'000'000'000ull);
+    if (auto next_timer = TimerQueue::the().next_timer_due(); next_timer.has_value())
+        deadline = min(deadline, ticks_to_nanoseconds(next_timer.value() + 1));
+
+    ScopedSpinLock lock(m_system_timer_lock);
+    program_system_timer(min(deadline, m_next_wakeup));
+}
+
+void TimeManagement::leave_idle()
+{
+    if (!m_tickless)
+        return;
+    ASSERT_INTERRUPTS_DISABLED();
+    u64 next_tick = ticks_to_nanoseconds(uptime_in_ticks() + 1);
+    ScopedSpinLock lock(m_system_timer_lock);
+    if (next_tick < m_programmed_deadline)
+        program_system_timer(next_tick);
+}
+
 time_t TimeManagement::boot_time() const
 {
     return RTC::boot_time();
@@ -198,6 +307,32 @@ bool TimeManagement::probe_and_set_non_legacy_hardware_timers()
     m_time_keeper_timer->set_callback(TimeManagement::update_time);
     m_time_keeper_timer->try_to_set_frequency(OPTIMAL_TICKS_PER_SECOND_RATE);
 
+    m_can_query_precise_time = true;
+    if (kernel_command_line().lookup("tickless").value_or("off") == "on")
+        try_to_enable_tickless_mode();
+
+    return true;
+}
+
+bool TimeManagement::try_to_enable_tickless_mode()
+{
+    ASSERT(m_can_query_precise_time);
+    if (!m_system_timer->is_capable_of_one_shot_mode()) {
+        klog() << "Time: System timer can't do one-shot mode, staying periodic";
+        return false;
+    }
+
+    InterruptDisabler disabler;
+    // The time keeper is no longer needed, as the time is read from the HPET's main counter.
+    m_time_keeper_timer->disable_irq();
+    auto epoch_time = m_epoch_time;
+    m_tickless = true;
+    m_epoch_time = epoch_time - seconds_since_boot();
+
+    m_system_timer->set_one_shot_mode();
+    ScopedSpinLock lock(m_system_timer_lock);
+    program_system_timer(ticks_to_nanoseconds(uptime_in_ticks() + 1));
+    klog() << "Time: Tickless mode enabled";
     return true;
 }
 
@@ -28,8 +28,10 @@
 
 #include <AK/FixedArray.h>
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/NumericLimits.h>
 #include <AK/RefPtr.h>
 #include <AK/Types.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel {
@@ -62,12 +64,39 @@ public:
 
     static timeval now_as_timeval();
 
+    // Time since boot, as precise as the best clock source we have. With the HPET,
+    // this has a resolution well below a microsecond.
+    u64 monotonic_nanoseconds() const;
+    timespec monotonic_time() const;
+    bool can_query_precise_time() const { return m_can_query_precise_time; }
+
+    // In tickless mode, the system timer runs one-shot: it fires on tick boundaries
+    // while there is something to run, and only when something is due while idle.
+    bool is_tickless() const { return m_tickless; }
+    u64 uptime_in_ticks() const;
+
+    // Makes sure the system timer fires by the given time, so that whatever is waiting
+    // for it gets looked at on time. Only needed in tickless mode.
+    void request_wakeup_at(u64 monotonic_nanoseconds);
+    void request_wakeup_at_tick(u64 uptime_ticks);
+
+    // Re-arms the system timer from its interrupt handler, and returns whether a
+    // requested wakeup has come due.
+    bool rearm_system_timer();
+    void enter_idle();
+    void leave_idle();
+
 private:
     explicit TimeManagement(bool probe_non_legacy_hardware_timers);
     bool probe_and_set_legacy_hardware_timers();
     bool probe_and_set_non_legacy_hardware_timers();
     Vector<HardwareTimer*> scan_and_initialize_periodic_timers();
     Vector<HardwareTimer*> scan_for_non_periodic_timers();
+    bool try_to_enable_tickless_mode();
+
+    u64 ticks_to_nanoseconds(u64 ticks) const;
+    u64 nanoseconds_to_ticks(u64 nanoseconds) const;
+    void program_system_timer(u64 deadline);
     NonnullRefPtrVector<HardwareTimer> m_hardware_timers;
 
     u32 m_ticks_this_second { 0 };
@@ -75,6 +104,13 @@ private:
     time_t m_epoch_time { 0 };
     RefPtr<HardwareTimer> m_system_timer;
     RefPtr<HardwareTimer> m_time_keeper_timer;
+
+    bool m_can_query_precise_time { false };
+    bool m_tickless { false };
+    SpinLock<u8> m_system_timer_lock;
+    // Both of these are in nanoseconds since boot.
+    u64 m_next_wakeup { NumericLimits<u64>::max() };
+    u64 m_programmed_deadline { NumericLimits<u64>::max() };
 };
 
 }
@@ -35,6 +35,100 @@ namespace Kernel {
 
 static TimerQueue* s_the;
 
+void TimerWheel::add(Timer& timer)
+{
+    ASSERT(!timer.m_list);
+
+    // Deadlines that have already passed go into the very next tick's slot,
+    // and ones beyond the end of the wheel go into its last slot; they get
+    // put back where they belong when that slot is cascaded.
+    u64 delta = timer.expires > m_next_tick ? timer.expires - m_next_tick : 0;
+    if (delta > max_delta)
+        delta = max_delta;
+    u64 expires = m_next_tick + delta;
+
+    size_t level = 0;
+    while (level + 1 < level_count && delta >= (1ull << (bits_per_level * (level + 1))))
+        ++level;
+
+    auto& slot = m_slots[level][(expires >> (bits_per_level * level)) & slot_mask];
+    slot.append(&timer);
+    timer.m_list = &slot;
+    ++m_timer_count;
+}
+
+void TimerWheel::remove(Timer& timer)
+{
+    ASSERT(timer.m_list);
+    timer.m_list->remove(&timer);
+    timer.m_list = nullptr;
+    --m_timer_count;
+}
+
+void TimerWheel::cascade(size_t level)
+{
+    auto& slot = m_slots[level][(m_next_tick >> (bits_per_level * level)) & slot_mask];
+    while (auto* timer = slot.remove_head()) {
+        timer->m_list = nullptr;
+        --m_timer_count;
+        add(*timer);
+    }
+}
+
+Timer* TimerWheel::take_next_due(u64 now)
+{
+    while (m_next_tick < now) {
+        if (!m_timer_count) {
+            m_next_tick = now;
+            return nullptr;
+        }
+
+        auto& slot = m_slots[0][m_next_tick & slot_mask];
+        if (auto* timer = slot.remove_head()) {
+            timer->m_list = nullptr;
+            --m_timer_count;
+            return timer;
+        }
+
+        ++m_next_tick;
+        for (size_t level = 1; level < level_count; ++level) {
+            if ((m_next_tick >> (bits_per_level * (level - 1))) & slot_mask)
+                break;
+            cascade(level);
+        }
+    }
+    return nullptr;
+}
+
+Optional<u64> TimerWheel::next_event_tick() const
+{
+    if (!m_timer_count)
+        return {};
+
+    // Everything in the lowest level expires within the next 64 ticks,
+    // one slot per tick.
+    for (size_t offset = 0; offset < slots_per_level; ++offset) {
+        if (!m_slots[0][(m_next_tick + offset) & slot_mask].is_empty())
+            return m_next_tick + offset;
+    }
+
+    // Higher levels only tell us when their slots get cascaded,
+    // which is early enough to then find out the actual deadline.
+    Optional<u64> next_cascade;
+    for (size_t level = 1; level < level_count; ++level) {
+        size_t shift = bits_per_level * level;
+        for (size_t offset = 1; offset <= slots_per_level; ++offset) {
+            if (m_slots[level][((m_next_tick >> shift) + offset) & slot_mask].is_empty())
+                continue;
+            u64 tick = ((m_next_tick >> shift) + offset) << shift;
+            if (!next_cascade.has_value() || tick < next_cascade.value())
+                next_cascade = tick;
+            break;
+        }
+    }
+    return next_cascade;
+}
+
 TimerQueue& TimerQueue::the()
 {
     if (!s_the)
@@ -43,81 +137,121 @@ TimerQueue& TimerQueue::the()
 }
 
 TimerQueue::TimerQueue()
+    : m_wheel(g_uptime)
 {
     m_ticks_per_second = TimeManagement::the().ticks_per_second();
 }
 
-TimerId TimerQueue::add_timer(NonnullOwnPtr<Timer>&& timer)
+u64 TimerQueue::ticks_from_timeval(const timeval& timeout) const
 {
-    u64 timer_expiration = timer->expires;
-    ASSERT(timer_expiration >= g_uptime);
+    return seconds_to_ticks(timeout.tv_sec) + microseconds_to_ticks(timeout.tv_usec);
+}
 
-    timer->id = ++m_timer_id_count;
+u64 TimerQueue::apply_slack(u64 expires, u64 slack)
+{
+    // Round the deadline down to the coarsest boundary that still lies within
+    // its slack, so that timers with similar deadlines end up on the same tick.
+    if (!slack)
+        return expires;
+    u64 mask = (expires + slack) ^ expires;
+    if (!mask)
+        return expires;
+    u64 bit = 63 - __builtin_clzll(mask);
+    mask = (1ull << bit) - 1;
+    return (expires + slack) & ~mask;
+}
 
-    if (m_timer_queue.is_empty()) {
-        m_timer_queue.append(move(timer));
-        m_next_timer_due = timer_expiration;
-    } else {
-        auto following_timer = m_timer_queue.find([&timer_expiration](auto& other) { return other->expires > timer_expiration; });
+void TimerQueue::enqueue(Timer& timer)
+{
+    ASSERT(m_lock.is_locked());
+    if (timer.m_list)
+        m_wheel.remove(timer);
+    timer.id = ++m_timer_id_count;
+    timer.expires = apply_slack(timer.expires, timer.slack);
+    m_wheel.add(timer);
+}
 
-        if (following_timer.is_end()) {
-            m_timer_queue.append(move(timer));
-        } else {
-            auto next_timer_needs_update = following_timer.is_begin();
-            m_timer_queue.insert_before(following_timer, move(timer));
+TimerId TimerQueue::add_timer(Timer& timer)
+{
+    ScopedSpinLock lock(m_lock);
+    ASSERT(!timer.m_owned_by_queue);
+    enqueue(timer);
+    return timer.id;
+}
 
-            if (next_timer_needs_update)
-                m_next_timer_due = timer_expiration;
-        }
-    }
+bool TimerQueue::cancel_timer(Timer& timer)
+{
+    ScopedSpinLock lock(m_lock);
+    ASSERT(!timer.m_owned_by_queue);
+    if (!timer.m_list)
+        return false;
+    m_wheel.remove(timer);
+    return true;
+}
+
+TimerId TimerQueue::add_timer(NonnullOwnPtr<Timer>&& timer)
+{
+    ASSERT(timer->expires >= g_uptime);
+
+    auto* raw_timer = timer.leak_ptr();
+    raw_timer->m_owned_by_queue = true;
 
-    return m_timer_id_count;
+    ScopedSpinLock lock(m_lock);
+    enqueue(*raw_timer);
+    m_owned_timers.set(raw_timer->id, raw_timer);
+    return raw_timer->id;
 }
 
 TimerId TimerQueue::add_timer(timeval& deadline, Function<void()>&& callback)
 {
-    NonnullOwnPtr timer = make<Timer>();
-    timer->expires = g_uptime + seconds_to_ticks(deadline.tv_sec) + microseconds_to_ticks(deadline.tv_usec);
-    timer->callback = move(callback);
+    NonnullOwnPtr timer = make<Timer>(move(callback));
+    u64 ticks = ticks_from_timeval(deadline);
+    timer->expires = g_uptime + ticks;
+    timer->slack = default_slack_for(ticks);
     return add_timer(move(timer));
 }
 
 bool TimerQueue::cancel_timer(TimerId id)
 {
-    auto it = m_timer_queue.find([id](auto& timer) { return timer->id == id; });
-    if (it.is_end())
-        return false;
-
-    auto was_next_timer = it.is_begin();
-    m_timer_queue.remove(it);
-
-    if (was_next_timer)
-        update_next_timer_due();
-
+    Timer* timer;
+    {
+        ScopedSpinLock lock(m_lock);
+        auto it = m_owned_timers.find(id);
+        if (it == m_owned_timers.end())
+            return false;
+        timer = it->value;
+        m_owned_timers.remove(it);
+        m_wheel.remove(*timer);
+    }
+    delete timer;
     return true;
 }
 
-void TimerQueue::fire()
+Optional<u64> TimerQueue::next_timer_due()
 {
-    if (m_timer_queue.is_empty())
-        return;
+    ScopedSpinLock lock(m_lock);
+    return m_wheel.next_event_tick();
+}
 
-    ASSERT(m_next_timer_due == m_timer_queue.first()->expires);
+void TimerQueue::fire()
+{
+    for (;;) {
+        Timer* timer;
+        {
+            ScopedSpinLock lock(m_lock);
+            timer = m_wheel.take_next_due(g_uptime);
+            if (!timer)
+                return;
+            if (timer->m_owned_by_queue)
+                m_owned_timers.remove(timer->id);
+        }
 
-    while (!m_timer_queue.is_empty() && g_uptime > m_timer_queue.first()->expires) {
-        auto timer = m_timer_queue.take_first();
+        // The callback runs without the lock held, so it may add or cancel timers.
         timer->callback();
-    }
 
-    update_next_timer_due();
-}
-
-void TimerQueue::update_next_timer_due()
-{
-    if (m_timer_queue.is_empty())
-        m_next_timer_due = 0;
-    else
-        m_next_timer_due = m_timer_queue.first()->expires;
+        if (timer->m_owned_by_queue)
+            delete timer;
+    }
 }
 
 }
@@ -27,54 +27,119 @@
 #pragma once
 
 #include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/InlineLinkedList.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
 #include <AK/OwnPtr.h>
-#include <AK/SinglyLinkedList.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
 typedef u64 TimerId;
 
-struct Timer {
-    TimerId id;
-    u64 expires;
-    Function<void()> callback;
-    bool operator<(const Timer& rhs) const
-    {
-        return expires < rhs.expires;
-    }
-    bool operator>(const Timer& rhs) const
+class Timer : public InlineLinkedListNode<Timer> {
+    friend class TimerQueue;
+    friend class TimerWheel;
+    friend class InlineLinkedListNode<Timer>;
+
+public:
+    Timer() { }
+    explicit Timer(Function<void()>&& callback)
+        : callback(move(callback))
     {
-        return expires > rhs.expires;
     }
-    bool operator==(const Timer& rhs) const
+
+    TimerId id { 0 };
+    u64 expires { 0 };
+    // The number of ticks this timer may fire late, which lets nearby deadlines share a tick.
+    u64 slack { 0 };
+    Function<void()> callback;
+
+    bool is_queued() const { return m_list; }
+
+private:
+    Timer* m_next { nullptr };
+    Timer* m_prev { nullptr };
+    InlineLinkedList<Timer>* m_list { nullptr };
+    bool m_owned_by_queue { false };
+};
+
+// A hierarchical timer wheel: every level has 64 slots, and each slot of a level
+// covers 64 times as many ticks as a slot of the level below it. Timers are only
+// ever moved (cascaded) into a lower level when the wheel reaches their slot, so
+// adding and cancelling a timer is O(1) regardless of how many are pending.
+class TimerWheel {
+public:
+    explicit TimerWheel(u64 current_tick)
+        : m_next_tick(current_tick)
     {
-        return id == rhs.id;
     }
+
+    void add(Timer&);
+    void remove(Timer&);
+
+    // Unlinks and returns the next timer whose deadline lies before the given tick.
+    Timer* take_next_due(u64 now);
+
+    // The earliest tick at which a timer might expire or need to be cascaded, if any.
+    Optional<u64> next_event_tick() const;
+
+    size_t timer_count() const { return m_timer_count; }
+
+private:
+    static constexpr size_t bits_per_level = 6;
+    static constexpr size_t slots_per_level = 1 << bits_per_level;
+    static constexpr size_t slot_mask = slots_per_level - 1;
+    static constexpr size_t level_count = 4;
+    static constexpr u64 max_delta = (1ull << (bits_per_level * level_count)) - 1;
+
+    void cascade(size_t level);
+
+    u64 m_next_tick { 0 };
+    size_t m_timer_count { 0 };
+    InlineLinkedList<Timer> m_slots[level_count][slots_per_level];
 };
 
 class TimerQueue {
 public:
     static TimerQueue& the();
 
+    // These timers belong to the queue, and are freed once they have fired or been cancelled.
     TimerId add_timer(NonnullOwnPtr<Timer>&&);
     TimerId add_timer(timeval& timeout, Function<void()>&& callback);
     bool cancel_timer(TimerId id);
+
+    // These timers belong to the caller, who must make sure they are no longer queued
+    // before destroying them. Re-adding a queued timer moves it to its new deadline.
+    TimerId add_timer(Timer&);
+    bool cancel_timer(Timer&);
+
     void fire();
 
+    // The earliest tick by which fire() needs to be called again.
+    Optional<u64> next_timer_due();
+
+    u64 ticks_from_timeval(const timeval&) const;
+    static u64 default_slack_for(u64 ticks) { return ticks / 256; }
+
 private:
     TimerQueue();
 
-    void update_next_timer_due();
+    void enqueue(Timer&);
+    static u64 apply_slack(u64 expires, u64 slack);
 
-    u64 microseconds_to_ticks(u64 micro_seconds) { return micro_seconds * (m_ticks_per_second / 1'000'000); }
-    u64 seconds_to_ticks(u64 seconds) { return seconds * m_ticks_per_second; }
+    u64 microseconds_to_ticks(u64 micro_seconds) const { return micro_seconds * m_ticks_per_second / 1'000'000; }
+    u64 seconds_to_ticks(u64 seconds) const { return seconds * m_ticks_per_second; }
 
-    u64 m_next_timer_due { 0 };
     u64 m_timer_id_count { 0 };
     u64 m_ticks_per_second { 0 };
-    SinglyLinkedList<NonnullOwnPtr<Timer>> m_timer_queue;
+    // FIXME: Only the BSP handles timer ticks right now. Once APs get their own
+    //        ticks, this should become one wheel per processor.
+    TimerWheel m_wheel;
+    HashMap<TimerId, Timer*> m_owned_timers;
+    SpinLock<u8> m_lock;
 };
 
 }
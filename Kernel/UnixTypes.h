@@ -64,6 +64,14 @@ enum {
 
 #define PERF_EVENT_MALLOC 1
 #define PERF_EVENT_FREE 2
+#define PERF_EVENT_SAMPLE 3
+#define PERF_EVENT_OFF_CPU 4
+#define PERF_EVENT_SYSCALL 5
+
+#define PERF_COUNTER_CYCLES 1
+#define PERF_COUNTER_INSTRUCTIONS 2
+#define PERF_COUNTER_CACHE_MISSES 3
+#define PERF_COUNTER_BRANCH_MISSES 4
 
 #define WNOHANG 1
 #define WUNTRACED 2
@@ -91,29 +99,58 @@ enum {
 #define MAP_ANON MAP_ANONYMOUS
 #define MAP_STACK 0x40
 #define MAP_PURGEABLE 0x80
+#define MAP_LARGE_PAGES 0x100
 
 #define PROT_READ 0x1
 #define PROT_WRITE 0x2
 #define PROT_EXEC 0x4
 #define PROT_NONE 0x0
 
+#define MADV_NORMAL 0x0
+#define MADV_RANDOM 0x1
+#define MADV_SEQUENTIAL 0x2
+#define MADV_WILLNEED 0x3
+#define MADV_DONTNEED 0x4
 #define MADV_SET_VOLATILE 0x100
 #define MADV_SET_NONVOLATILE 0x200
 #define MADV_GET_VOLATILE 0x400
 
 #define MAP_INHERIT_ZERO 1
 
+#define MS_ASYNC 0x1
+#define MS_INVALIDATE 0x2
+#define MS_SYNC 0x4
+
 #define F_DUPFD 0
 #define F_GETFD 1
 #define F_SETFD 2
 #define F_GETFL 3
 #define F_SETFL 4
 #define F_ISTTY 5
+#define F_SETPIPE_SZ 8
+#define F_GETPIPE_SZ 9
 
 #define FD_CLOEXEC 1
 
 #define FUTEX_WAIT 1
 #define FUTEX_WAKE 2
+#define FUTEX_REQUEUE 3
+#define FUTEX_CMP_REQUEUE 4
+#define FUTEX_LOCK_PI 6
+#define FUTEX_UNLOCK_PI 7
+#define FUTEX_TRYLOCK_PI 8
+#define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
+
+#define FUTEX_PRIVATE_FLAG 128
+#define FUTEX_CLOCK_REALTIME 256
+#define FUTEX_CMD_MASK ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME)
+
+#define FUTEX_BITSET_MATCH_ANY 0xffffffff
+
+#define FUTEX_WAITERS 0x80000000u
+#define FUTEX_OWNER_DIED 0x40000000u
+#define FUTEX_TID_MASK 0x3fffffffu
 
 #define S_IFMT 0170000
 #define S_IFDIR 0040000
@@ -437,6 +474,67 @@ struct pollfd {
     short revents;
 };
 
+#define EPOLLIN (1u << 0)
+#define EPOLLOUT (1u << 3)
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLL_CLOEXEC O_CLOEXEC
+
+typedef union epoll_data {
+    void* ptr;
+    int fd;
+    uint32_t u32;
+    uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+    u32 events;
+    epoll_data_t data;
+};
+
+#define IO_RING_OP_NOP 0
+#define IO_RING_OP_READ 1
+#define IO_RING_OP_WRITE 2
+#define IO_RING_OP_ACCEPT 3
+#define IO_RING_OP_CONNECT 4
+#define IO_RING_OP_FSYNC 5
+
+#define IO_RING_MAX_ENTRIES 4096
+
+struct io_ring_sqe {
+    u32 opcode;
+    int fd;
+    i64 offset;
+    void* addr;
+    void* addr2;
+    u32 len;
+    u64 user_data;
+};
+
+struct io_ring_cqe {
+    u64 user_data;
+    i32 result;
+    u32 flags;
+};
+
+struct io_ring_header {
+    u32 sq_head;
+    u32 sq_tail;
+    u32 cq_head;
+    u32 cq_tail;
+};
+
+struct io_ring_params {
+    u32 sq_entries;
+    u32 cq_entries;
+    u32 sq_offset;
+    u32 cq_offset;
+    u32 mapping_size;
+};
+
 #define AF_MASK 0xff
 #define AF_UNSPEC 0
 #define AF_LOCAL 1
@@ -475,6 +573,9 @@ struct pollfd {
 
 #define IP_TTL 2
 
+#define TCP_NODELAY 1
+#define TCP_CONGESTION 13
+
 struct ucred {
     pid_t pid;
     uid_t uid;
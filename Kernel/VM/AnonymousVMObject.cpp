@@ -24,8 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Kernel/StdLib.h>
 #include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/PageCompression.h>
 #include <Kernel/VM/PhysicalPage.h>
 
 namespace Kernel {
@@ -54,10 +56,8 @@ NonnullRefPtr<AnonymousVMObject> AnonymousVMObject::create_with_physical_page(Ph
 AnonymousVMObject::AnonymousVMObject(size_t size)
     : VMObject(size)
 {
-#ifndef MAP_SHARED_ZERO_PAGE_LAZILY
-    for (size_t i = 0; i < page_count(); ++i)
-        physical_pages()[i] = MM.shared_zero_page();
-#endif
+    // Pages start out empty. Region::handle_fault() maps the shared zero page on the
+    // first read and only allocates a physical page on the first write.
 }
 
 AnonymousVMObject::AnonymousVMObject(PhysicalAddress paddr, size_t size)
@@ -70,11 +70,66 @@ AnonymousVMObject::AnonymousVMObject(PhysicalAddress paddr, size_t size)
 
 AnonymousVMObject::AnonymousVMObject(const AnonymousVMObject& other)
     : VMObject(other)
+    , m_compressed_pages(other.m_compressed_pages)
 {
+    // The compressed data itself is shared, it's never modified after being stored.
+    for (auto& it : m_compressed_pages)
+        MM.update_compressed_page_stats(1, it.value.size());
 }
 
 AnonymousVMObject::~AnonymousVMObject()
 {
+    discard_compressed_pages();
+}
+
+void AnonymousVMObject::store_compressed_page(Badge<MemoryManager>, size_t page_index, ByteBuffer&& compressed_page)
+{
+    ASSERT(s_mm_lock.own_lock());
+    ASSERT(m_physical_pages[page_index].is_null());
+    MM.update_compressed_page_stats(1, compressed_page.size());
+    m_compressed_pages.set(page_index, move(compressed_page));
+}
+
+bool AnonymousVMObject::decompress_page(size_t page_index)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    ASSERT(m_physical_pages[page_index].is_null());
+
+    // Allocate before looking up the compressed copy, since making room may
+    // compress (or purge) more of our pages.
+    auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (!page) {
+        klog() << "MM: decompress_page was unable to allocate a physical page";
+        return false;
+    }
+
+    u8* dest_ptr = MM.quickmap_page(*page);
+    auto it = m_compressed_pages.find(page_index);
+    if (it == m_compressed_pages.end()) {
+        // We were purged while allocating, so the page is zero now.
+        memset(dest_ptr, 0, PAGE_SIZE);
+    } else {
+        auto compressed_page = move(it->value);
+        m_compressed_pages.remove(it);
+        MM.update_compressed_page_stats(-1, -(ssize_t)compressed_page.size());
+        bool success = PageCompression::decompress(compressed_page.data(), compressed_page.size(), dest_ptr, PAGE_SIZE);
+        ASSERT(success);
+    }
+    MM.unquickmap_page();
+
+    m_physical_pages[page_index] = move(page);
+    return true;
+}
+
+void AnonymousVMObject::discard_compressed_pages()
+{
+    if (m_compressed_pages.is_empty())
+        return;
+    ssize_t bytes = 0;
+    for (auto& it : m_compressed_pages)
+        bytes += it.value.size();
+    MM.update_compressed_page_stats(-(ssize_t)m_compressed_pages.size(), -bytes);
+    m_compressed_pages.clear();
 }
 
 NonnullRefPtr<VMObject> AnonymousVMObject::clone()
@@ -26,6 +26,9 @@
 
 #pragma once
 
+#include <AK/Badge.h>
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
 #include <Kernel/PhysicalAddress.h>
 #include <Kernel/VM/VMObject.h>
 
@@ -40,10 +43,19 @@ public:
     static NonnullRefPtr<AnonymousVMObject> create_with_physical_page(PhysicalPage&);
     virtual NonnullRefPtr<VMObject> clone() override;
 
+    // Cold pages can be evicted into a compressed copy, which is expanded into a
+    // fresh physical page the next time someone faults on it.
+    bool has_compressed_page(size_t page_index) const { return m_compressed_pages.contains(page_index); }
+    size_t compressed_page_count() const { return m_compressed_pages.size(); }
+    void store_compressed_page(Badge<MemoryManager>, size_t page_index, ByteBuffer&&);
+    bool decompress_page(size_t page_index);
+
 protected:
     explicit AnonymousVMObject(size_t);
     explicit AnonymousVMObject(const AnonymousVMObject&);
 
+    void discard_compressed_pages();
+
     virtual const char* class_name() const override { return "AnonymousVMObject"; }
 
 private:
@@ -54,6 +66,8 @@ private:
     AnonymousVMObject(AnonymousVMObject&&) = delete;
 
     virtual bool is_anonymous() const override { return true; }
+
+    HashMap<size_t, ByteBuffer> m_compressed_pages;
 };
 
 }
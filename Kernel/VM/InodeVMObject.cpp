@@ -25,6 +25,7 @@
  */
 
 #include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Thread.h>
 #include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/Region.h>
@@ -96,9 +97,17 @@ void InodeVMObject::inode_contents_changed(Badge<Inode>, off_t offset, ssize_t s
     InterruptDisabler disabler;
     ASSERT(offset >= 0);
 
-    // FIXME: Only invalidate the parts that actually changed.
-    for (auto& physical_page : m_physical_pages)
-        physical_page = nullptr;
+    // Writing back our own dirty pages doesn't change what we have mapped.
+    if (m_writeback_thread && m_writeback_thread == Thread::current())
+        return;
+
+    // Drop the pages that were written to, they'll be faulted back in with the new contents.
+    size_t first_page_index = offset / PAGE_SIZE;
+    size_t end_page_index = min(ceil_div((size_t)offset + size, PAGE_SIZE), page_count());
+    for (size_t i = first_page_index; i < end_page_index; ++i) {
+        m_physical_pages[i] = nullptr;
+        m_dirty_pages.set(i, false);
+    }
 
 #if 0
     size_t current_offset = offset;
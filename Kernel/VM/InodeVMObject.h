@@ -32,6 +32,8 @@
 
 namespace Kernel {
 
+class Thread;
+
 class InodeVMObject : public VMObject {
 public:
     virtual ~InodeVMObject() override;
@@ -44,6 +46,8 @@ public:
 
     size_t amount_dirty() const;
     size_t amount_clean() const;
+    bool is_page_dirty(size_t page_index) const { return m_dirty_pages.get(page_index); }
+    void set_page_dirty(size_t page_index, bool dirty) { m_dirty_pages.set(page_index, dirty); }
 
     int release_all_clean_pages();
 
@@ -64,6 +68,9 @@ protected:
 
     NonnullRefPtr<Inode> m_inode;
     Bitmap m_dirty_pages;
+
+    // Set while this thread writes our own pages back to the inode.
+    Thread* m_writeback_thread { nullptr };
 };
 
 }
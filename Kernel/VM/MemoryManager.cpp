@@ -29,12 +29,15 @@
 #include <AK/StringView.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/CMOS.h>
+#include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Heap/kmalloc.h>
 #include <Kernel/Multiboot.h>
 #include <Kernel/Process.h>
 #include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/ContiguousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/PageCompression.h>
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/PhysicalRegion.h>
 #include <Kernel/VM/PurgeableVMObject.h>
@@ -46,6 +49,7 @@
 
 extern FlatPtr start_of_kernel_text;
 extern FlatPtr start_of_kernel_data;
+extern FlatPtr end_of_kernel_image;
 extern FlatPtr end_of_kernel_bss;
 
 namespace Kernel {
@@ -58,6 +62,11 @@ MemoryManager& MM
     return *s_the;
 }
 
+bool MemoryManager::is_initialized()
+{
+    return s_the != nullptr;
+}
+
 MemoryManager::MemoryManager()
 {
     ScopedSpinLock lock(s_mm_lock);
@@ -65,6 +74,7 @@ MemoryManager::MemoryManager()
     parse_memory_map();
     write_cr3(kernel_page_directory().cr3());
     protect_kernel_image();
+    map_low_memory_with_large_pages();
 
     m_shared_zero_page = allocate_user_physical_page();
 }
@@ -90,6 +100,17 @@ void MemoryManager::protect_kernel_image()
     }
 }
 
+void MemoryManager::map_low_memory_with_large_pages()
+{
+    // The kernel image keeps its 4 KiB mappings since text and data need different protections,
+    // but everything above it in the low 8 MiB (the eternal heap and the kmalloc pool) is plain data.
+    FlatPtr start = round_up_to_power_of_two((FlatPtr)&end_of_kernel_image, large_page_size);
+    for (FlatPtr vaddr = start; vaddr < 0xc0800000; vaddr += large_page_size) {
+        map_large_page(kernel_page_directory(), VirtualAddress(vaddr), PhysicalAddress(virtual_to_low_physical(vaddr)), true, false, false, true);
+        flush_tlb(&kernel_page_directory(), VirtualAddress(vaddr), pages_per_large_page);
+    }
+}
+
 void MemoryManager::parse_memory_map()
 {
     RefPtr<PhysicalRegion> region;
@@ -163,6 +184,12 @@ void MemoryManager::parse_memory_map()
     ASSERT(m_user_physical_pages > 0);
 }
 
+static inline u32 page_table_key(VirtualAddress vaddr)
+{
+    // Page tables are tracked per page directory entry, across all four page directories.
+    return vaddr.get() >> 21;
+}
+
 const PageTableEntry* MemoryManager::pte(const PageDirectory& page_directory, VirtualAddress vaddr)
 {
     ASSERT_INTERRUPTS_DISABLED();
@@ -173,12 +200,17 @@ const PageTableEntry* MemoryManager::pte(const PageDirectory& page_directory, Vi
 
     auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
     const PageDirectoryEntry& pde = pd[page_directory_index];
-    if (!pde.is_present())
+    if (!pde.is_present() || pde.is_huge())
         return nullptr;
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
 
+PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    return const_cast<PageTableEntry*>(pte(const_cast<const PageDirectory&>(page_directory), vaddr));
+}
+
 PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, VirtualAddress vaddr)
 {
     ASSERT_INTERRUPTS_DISABLED();
@@ -189,6 +221,8 @@ PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && pde.is_huge())
+        split_large_page(page_directory, pde, vaddr);
     if (!pde.is_present()) {
 #ifdef MM_DEBUG
         dbg() << "MM: PDE " << page_directory_index << " not present (requested for " << vaddr << "), allocating";
@@ -202,12 +236,94 @@ PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pde.set_present(true);
         pde.set_writable(true);
         pde.set_global(&page_directory == m_kernel_page_directory.ptr());
-        page_directory.m_physical_pages.set(page_directory_index, move(page_table));
+        page_directory.m_physical_pages.set(page_table_key(vaddr), move(page_table));
     }
 
     return quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
 
+void MemoryManager::split_large_page(PageDirectory& page_directory, PageDirectoryEntry& pde, VirtualAddress vaddr)
+{
+    // Someone wants to change a single page inside a large page, so break it
+    // up into a page table that maps the same memory with the same permissions.
+    ASSERT(pde.is_huge());
+#ifdef MM_DEBUG
+    dbg() << "MM: Splitting large page at " << VirtualAddress(vaddr.get() & ~(large_page_size - 1));
+#endif
+    auto page_table = allocate_user_physical_page(ShouldZeroFill::No);
+    ASSERT(page_table);
+    PageDirectoryEntry large_pde = pde;
+    FlatPtr base = (FlatPtr)large_pde.page_table_base();
+
+    auto* pt = quickmap_pt(page_table->paddr());
+    for (size_t i = 0; i < pages_per_large_page; ++i) {
+        auto& pte = pt[i];
+        pte.clear();
+        pte.set_physical_page_base(base + i * PAGE_SIZE);
+        pte.set_writable(large_pde.is_writable());
+        pte.set_user_allowed(large_pde.is_user_allowed());
+        pte.set_cache_disabled(large_pde.is_cache_disabled());
+        pte.set_execute_disabled(large_pde.is_execute_disabled());
+        pte.set_global(large_pde.is_global());
+        pte.set_present(true);
+    }
+
+    // The page directory entry itself stays permissive, the page table entries carry the restrictions.
+    pde.clear();
+    pde.set_page_table_base(page_table->paddr().get());
+    pde.set_user_allowed(true);
+    pde.set_present(true);
+    pde.set_writable(true);
+    pde.set_global(&page_directory == m_kernel_page_directory.ptr());
+    page_directory.m_physical_pages.set(page_table_key(vaddr), page_table.release_nonnull());
+}
+
+void MemoryManager::map_large_page(PageDirectory& page_directory, VirtualAddress vaddr, PhysicalAddress paddr, bool writable, bool user_allowed, bool executable, bool cacheable)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(s_mm_lock.own_lock());
+    ASSERT(!(vaddr.get() & (large_page_size - 1)));
+    ASSERT(!(paddr.get() & (large_page_size - 1)));
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    pde.clear();
+    pde.set_page_table_base(paddr.get());
+    pde.set_huge(true);
+    pde.set_writable(writable);
+    pde.set_user_allowed(user_allowed);
+    pde.set_cache_disabled(!cacheable);
+    if (Processor::current().has_feature(CPUFeature::NX))
+        pde.set_execute_disabled(!executable);
+    pde.set_global(&page_directory == m_kernel_page_directory.ptr());
+    pde.set_present(true);
+#ifdef MM_DEBUG
+    dbg() << "MM: >> large page map " << vaddr << " => " << paddr;
+#endif
+
+    // The page table that used to cover this range (if any) is no longer needed.
+    page_directory.m_physical_pages.remove(page_table_key(vaddr));
+}
+
+bool MemoryManager::unmap_large_page(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(s_mm_lock.own_lock());
+    if (vaddr.get() & (large_page_size - 1))
+        return false;
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    if (!pde.is_present() || !pde.is_huge())
+        return false;
+    pde.clear();
+    return true;
+}
+
 void MemoryManager::initialize(u32 cpu)
 {
     auto mm_data = new MemoryManagerData;
@@ -230,14 +346,35 @@ Region* MemoryManager::kernel_region_from_vaddr(VirtualAddress vaddr)
     return nullptr;
 }
 
-Region* MemoryManager::user_region_from_vaddr(Process& process, VirtualAddress vaddr)
+Optional<PhysicalAddress> MemoryManager::physical_address_for_dma(VirtualAddress vaddr)
 {
+    // The first 8 MiB of physical memory are identity mapped at 0xc0000000.
+    if (vaddr.get() >= 0xc0000000 && vaddr.get() < 0xc0800000)
+        return PhysicalAddress(virtual_to_low_physical(vaddr.get()));
+
     ScopedSpinLock lock(s_mm_lock);
-    // FIXME: Use a binary search tree (maybe red/black?) or some other more appropriate data structure!
-    for (auto& region : process.m_regions) {
-        if (region.contains(vaddr))
-            return &region;
+    auto* region = kernel_region_from_vaddr(vaddr);
+    if (!region)
+        return {};
+    auto page_index = region->page_index_from_address(vaddr);
+    if (region->vmobject().is_anonymous() || region->vmobject().is_purgeable()) {
+        // The device is about to write behind the CPU's back, so make sure the page is really ours.
+        if (!region->commit(page_index))
+            return {};
+        flush_tlb(&kernel_page_directory(), region->vaddr_from_page_index(page_index));
     }
+    auto* physical_page = region->physical_page(page_index);
+    if (!physical_page || physical_page->is_shared_zero_page())
+        return {};
+    return physical_page->paddr().offset(vaddr.get() & (PAGE_SIZE - 1));
+}
+
+Region* MemoryManager::user_region_from_vaddr(Process& process, VirtualAddress vaddr)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    auto* region = process.region_at_or_below(vaddr);
+    if (region && region->contains(vaddr))
+        return region;
 #ifdef MM_DEBUG
     dbg() << process << " Couldn't find user region for " << vaddr;
 #endif
@@ -291,6 +428,7 @@ PageFaultResponse MemoryManager::handle_page_fault(const PageFault& fault)
         return PageFaultResponse::ShouldCrash;
     }
 
+    ScopedLatencyRecorder latency_recorder(Thread::current()->page_fault_latency());
     return region->handle_fault(fault);
 }
 
@@ -416,17 +554,8 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
 
     if (!page) {
         // We didn't have a single free physical page. Let's try to free something up!
-        // First, we look for a purgeable VMObject in the volatile state.
-        for_each_vmobject_of_type<PurgeableVMObject>([&](auto& vmobject) {
-            int purged_page_count = vmobject.purge_with_interrupts_disabled({});
-            if (purged_page_count) {
-                klog() << "MM: Purge saved the day! Purged " << purged_page_count << " pages from PurgeableVMObject{" << &vmobject << "}";
-                page = find_free_user_physical_page();
-                ASSERT(page);
-                return IterationDecision::Break;
-            }
-            return IterationDecision::Continue;
-        });
+        if (reclaim_user_physical_pages())
+            page = find_free_user_physical_page();
 
         if (!page) {
             klog() << "MM: no user physical pages available";
@@ -475,8 +604,8 @@ NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_
 
     for (auto& region : m_super_physical_regions) {
         physical_pages = region.take_contiguous_free_pages((count), true);
-        if (physical_pages.is_empty())
-            continue;
+        if (!physical_pages.is_empty())
+            break;
     }
 
     if (physical_pages.is_empty()) {
@@ -495,6 +624,28 @@ NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_
     return physical_pages;
 }
 
+NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_user_physical_pages(size_t size, size_t physical_alignment)
+{
+    ASSERT(!(size % PAGE_SIZE));
+    ScopedSpinLock lock(s_mm_lock);
+    size_t count = ceil_div(size, PAGE_SIZE);
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+
+    for (auto& region : m_user_physical_regions) {
+        physical_pages = region.take_contiguous_free_pages(count, false, physical_alignment);
+        if (!physical_pages.is_empty())
+            break;
+    }
+
+    if (physical_pages.is_empty())
+        return {};
+
+    auto cleanup_region = MM.allocate_kernel_region(physical_pages[0].paddr(), PAGE_SIZE * count, "MemoryManager Allocation Sanitization", Region::Access::Read | Region::Access::Write);
+    fast_u32_fill((u32*)cleanup_region->vaddr().as_ptr(), 0, (PAGE_SIZE * count) / sizeof(u32));
+    m_user_physical_pages_used += count;
+    return physical_pages;
+}
+
 RefPtr<PhysicalPage> MemoryManager::allocate_supervisor_physical_page()
 {
     ScopedSpinLock lock(s_mm_lock);
@@ -502,8 +653,8 @@ RefPtr<PhysicalPage> MemoryManager::allocate_supervisor_physical_page()
 
     for (auto& region : m_super_physical_regions) {
         page = region.take_free_page(true);
-        if (page.is_null())
-            continue;
+        if (!page.is_null())
+            break;
     }
 
     if (!page) {
@@ -543,12 +694,12 @@ void MemoryManager::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
     Processor::flush_tlb_local(vaddr, page_count);
 }
 
-void MemoryManager::flush_tlb(VirtualAddress vaddr, size_t page_count)
+void MemoryManager::flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
 #ifdef MM_DEBUG
     dbg() << "MM: Flush " << page_count << " pages at " << vaddr;
 #endif
-    Processor::flush_tlb(vaddr, page_count);
+    Processor::flush_tlb(page_directory, vaddr, page_count);
 }
 
 extern "C" PageTableEntry boot_pd3_pt1023[1024];
@@ -594,6 +745,180 @@ PageTableEntry* MemoryManager::quickmap_pt(PhysicalAddress pt_paddr)
     return (PageTableEntry*)0xffe00000;
 }
 
+bool MemoryManager::reclaim_user_physical_pages()
+{
+    ASSERT(s_mm_lock.own_lock());
+
+    // We can be called from the middle of ensure_pte(), which is still using the page
+    // directory and page table quickmaps, so put them back the way we found them.
+    auto saved_pt_quickmap = boot_pd3_pt1023[0];
+    auto saved_pd_quickmap = boot_pd3_pt1023[4];
+
+    // First, we look for a purgeable VMObject in the volatile state.
+    bool reclaimed = false;
+    for_each_vmobject_of_type<PurgeableVMObject>([&](auto& vmobject) {
+        int purged_page_count = vmobject.purge_with_interrupts_disabled({});
+        if (purged_page_count) {
+            klog() << "MM: Purge saved the day! Purged " << purged_page_count << " pages from PurgeableVMObject{" << &vmobject << "}";
+            reclaimed = true;
+            return IterationDecision::Break;
+        }
+        return IterationDecision::Continue;
+    });
+
+    // Next, drop file pages from the page cache. They can always be read back from disk.
+    if (!reclaimed) {
+        size_t released_page_count = Inode::reclaim_unused_cached_pages(compression_batch_size);
+#ifdef MM_DEBUG
+        dbg() << "MM: Released " << released_page_count << " cached file pages";
+#endif
+        reclaimed = released_page_count > 0;
+    }
+
+    // The block caches keep clean copies of disk blocks too, give back whole chunks of those.
+    if (!reclaimed) {
+        size_t released_page_count = BlockBasedFS::reclaim_clean_cache_pages(compression_batch_size);
+#ifdef MM_DEBUG
+        dbg() << "MM: Released " << released_page_count << " disk cache pages";
+#endif
+        reclaimed = released_page_count > 0;
+    }
+
+    // Then, squeeze some cold anonymous pages into the compressed pool.
+    if (!reclaimed) {
+        size_t compressed_page_count = compress_cold_anonymous_pages(compression_batch_size);
+#ifdef MM_DEBUG
+        dbg() << "MM: Compressed " << compressed_page_count << " cold pages";
+#endif
+        reclaimed = compressed_page_count > 0;
+    }
+
+    boot_pd3_pt1023[0] = saved_pt_quickmap;
+    boot_pd3_pt1023[4] = saved_pd_quickmap;
+    flush_tlb_local(VirtualAddress(0xffe00000));
+    flush_tlb_local(VirtualAddress(0xffe04000));
+    return reclaimed;
+}
+
+size_t MemoryManager::compress_cold_anonymous_pages(size_t page_count)
+{
+    ASSERT(s_mm_lock.own_lock());
+
+    // Keep enough of the kmalloc heap around for everyone else, since we're
+    // not allowed to grow it while holding the MM lock.
+    kmalloc_stats stats;
+    get_kmalloc_stats(stats);
+    if (stats.bytes_free <= compression_kmalloc_reserve || stats.largest_free_run < PAGE_SIZE)
+        return 0;
+    size_t kmalloc_budget = stats.bytes_free - compression_kmalloc_reserve;
+
+    // The first pass may only clear the accessed bits of pages that are in use,
+    // which gives them a second chance and makes the second pass find the rest.
+    size_t compressed_page_count = 0;
+    for (int pass = 0; pass < 2 && compressed_page_count < page_count; ++pass) {
+        for_each_vmobject_of_type<AnonymousVMObject>([&](auto& vmobject) {
+            compressed_page_count += compress_cold_pages(vmobject, page_count - compressed_page_count, kmalloc_budget);
+            return compressed_page_count < page_count ? IterationDecision::Continue : IterationDecision::Break;
+        });
+    }
+    return compressed_page_count;
+}
+
+size_t MemoryManager::compress_cold_pages(AnonymousVMObject& vmobject, size_t page_count, size_t& kmalloc_budget)
+{
+    if (vmobject.m_paging_lock.is_locked())
+        return 0;
+
+    // Only touch memory that is solely mapped into userspace, where faulting it
+    // back in is always fine. Kernel mappings and stacks are left alone.
+    bool has_regions = false;
+    bool is_eligible = true;
+    vmobject.for_each_region([&](Region& region) {
+        has_regions = true;
+        if (!region.is_user_accessible() || region.is_kernel() || region.is_stack() || !region.m_page_directory)
+            is_eligible = false;
+    });
+    if (!has_regions || !is_eligible)
+        return 0;
+
+    size_t compressed_page_count = 0;
+    for (size_t page_index = 0; page_index < vmobject.page_count() && compressed_page_count < page_count; ++page_index) {
+        auto& page = vmobject.m_physical_pages[page_index];
+        if (!page || page->is_shared_zero_page() || page->ref_count() != 1 || !page->m_may_return_to_freelist || page->m_supervisor)
+            continue;
+
+        bool was_accessed = false;
+        vmobject.for_each_region([&](Region& region) {
+            if (page_index < region.first_page_index() || page_index > region.last_page_index())
+                return;
+            auto vaddr = region.vaddr_from_page_index(page_index - region.first_page_index());
+            auto* page_pte = pte(*region.m_page_directory, vaddr);
+            if (!page_pte) {
+                // Part of a large page, which we don't break up here.
+                was_accessed = true;
+                return;
+            }
+            if (page_pte->is_accessed()) {
+                page_pte->set_accessed(false);
+                flush_tlb(region.m_page_directory.ptr(), vaddr);
+                was_accessed = true;
+            }
+        });
+        if (was_accessed)
+            continue;
+
+        if (compress_page(vmobject, page_index, kmalloc_budget))
+            ++compressed_page_count;
+    }
+    return compressed_page_count;
+}
+
+bool MemoryManager::compress_page(AnonymousVMObject& vmobject, size_t page_index, size_t& kmalloc_budget)
+{
+    // Protected by s_mm_lock.
+    static u8 s_compression_buffer[max_compressed_page_size];
+
+    auto& page = vmobject.m_physical_pages[page_index];
+
+    // Take the page away from everyone before reading it, so nobody can write to it behind our back.
+    vmobject.for_each_region([&](Region& region) {
+        if (page_index < region.first_page_index() || page_index > region.last_page_index())
+            return;
+        auto vaddr = region.vaddr_from_page_index(page_index - region.first_page_index());
+        if (auto* page_pte = pte(*region.m_page_directory, vaddr)) {
+            page_pte->clear();
+            flush_tlb(region.m_page_directory.ptr(), vaddr);
+        }
+    });
+
+    auto* data = quickmap_page(*page);
+    size_t compressed_size = PageCompression::compress(data, PAGE_SIZE, s_compression_buffer, sizeof(s_compression_buffer));
+    unquickmap_page();
+
+    // Account for the ByteBuffer and hash table entry along with the data itself.
+    size_t cost = compressed_size + 64;
+    if (!compressed_size || cost > kmalloc_budget) {
+        vmobject.for_each_region([&](Region& region) {
+            if (page_index >= region.first_page_index() && page_index <= region.last_page_index())
+                region.remap_page(page_index - region.first_page_index());
+        });
+        return false;
+    }
+    kmalloc_budget -= cost;
+
+    // Dropping the last reference returns the page to the free list.
+    page = nullptr;
+    vmobject.store_compressed_page({}, page_index, ByteBuffer::copy(s_compression_buffer, compressed_size));
+    return true;
+}
+
+void MemoryManager::update_compressed_page_stats(ssize_t page_delta, ssize_t byte_delta)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    m_compressed_user_pages += page_delta;
+    m_compressed_user_bytes += byte_delta;
+}
+
 u8* MemoryManager::quickmap_page(PhysicalPage& physical_page)
 {
     ASSERT_INTERRUPTS_DISABLED();
@@ -632,6 +957,30 @@ void MemoryManager::unquickmap_page()
     mm_data.m_quickmap_in_use.unlock(mm_data.m_quickmap_prev_flags);
 }
 
+// The other side may be a userspace buffer, which we can't touch while the page is quickmapped,
+// so these go through the stack.
+void MemoryManager::copy_from_physical_page(const PhysicalPage& page, size_t offset_in_page, u8* buffer, size_t count)
+{
+    ASSERT(offset_in_page + count <= PAGE_SIZE);
+    u8 page_buffer[PAGE_SIZE];
+    {
+        InterruptDisabler disabler;
+        memcpy(page_buffer, quickmap_page(const_cast<PhysicalPage&>(page)) + offset_in_page, count);
+        unquickmap_page();
+    }
+    memcpy(buffer, page_buffer, count);
+}
+
+void MemoryManager::copy_to_physical_page(PhysicalPage& page, size_t offset_in_page, const u8* data, size_t count)
+{
+    ASSERT(offset_in_page + count <= PAGE_SIZE);
+    u8 page_buffer[PAGE_SIZE];
+    memcpy(page_buffer, data, count);
+    InterruptDisabler disabler;
+    memcpy(quickmap_page(page) + offset_in_page, page_buffer, count);
+    unquickmap_page();
+}
+
 template<MemoryManager::AccessSpace space, MemoryManager::AccessType access_type>
 bool MemoryManager::validate_range(const Process& process, VirtualAddress base_vaddr, size_t size) const
 {
@@ -28,6 +28,7 @@
 
 #include <AK/HashTable.h>
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/Optional.h>
 #include <AK/String.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Forward.h>
@@ -76,16 +77,30 @@ extern RecursiveSpinLock s_mm_lock;
 
 class MemoryManager {
     AK_MAKE_ETERNAL
+    friend class AnonymousVMObject;
+    friend class Inode;
     friend class PageDirectory;
     friend class PhysicalPage;
     friend class PhysicalRegion;
     friend class Region;
+    friend class SharedInodeVMObject;
+    friend class TmpFSInode;
     friend class VMObject;
     friend Optional<KBuffer> procfs$mm(InodeIdentifier);
     friend Optional<KBuffer> procfs$memstat(InodeIdentifier);
 
 public:
+    // With PAE paging, a page directory entry can map a 2 MiB large page directly.
+    static constexpr size_t large_page_size = 2 * MiB;
+    static constexpr size_t pages_per_large_page = large_page_size / PAGE_SIZE;
+
+    // Cold anonymous pages are only worth compressing if they shrink to this size.
+    static constexpr size_t max_compressed_page_size = PAGE_SIZE * 3 / 4;
+    static constexpr size_t compression_batch_size = 32;
+    static constexpr size_t compression_kmalloc_reserve = 1 * MiB;
+
     static MemoryManager& the();
+    static bool is_initialized();
 
     static void initialize(u32 cpu);
     
@@ -114,6 +129,7 @@ public:
     RefPtr<PhysicalPage> allocate_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes);
     RefPtr<PhysicalPage> allocate_supervisor_physical_page();
     NonnullRefPtrVector<PhysicalPage> allocate_contiguous_supervisor_physical_pages(size_t size);
+    NonnullRefPtrVector<PhysicalPage> allocate_contiguous_user_physical_pages(size_t size, size_t physical_alignment = PAGE_SIZE);
     void deallocate_user_physical_page(PhysicalPage&&);
     void deallocate_supervisor_physical_page(PhysicalPage&&);
 
@@ -129,6 +145,8 @@ public:
     unsigned user_physical_pages_used() const { return m_user_physical_pages_used; }
     unsigned super_physical_pages() const { return m_super_physical_pages; }
     unsigned super_physical_pages_used() const { return m_super_physical_pages_used; }
+    size_t compressed_user_pages() const { return m_compressed_user_pages; }
+    size_t compressed_user_bytes() const { return m_compressed_user_bytes; }
 
     template<typename Callback>
     static void for_each_vmobject(Callback callback)
@@ -155,6 +173,13 @@ public:
 
     void dump_kernel_regions();
 
+    // Resolves a kernel virtual address to the physical address backing it, committing
+    // the page first if needed. Used by drivers that want to DMA into kernel buffers.
+    Optional<PhysicalAddress> physical_address_for_dma(VirtualAddress);
+
+    void copy_from_physical_page(const PhysicalPage&, size_t offset_in_page, u8* buffer, size_t count);
+    void copy_to_physical_page(PhysicalPage&, size_t offset_in_page, const u8* data, size_t count);
+
     PhysicalPage& shared_zero_page() { return *m_shared_zero_page; }
 
     PageDirectory& kernel_page_directory() { return *m_kernel_page_directory; }
@@ -177,9 +202,10 @@ private:
 
     void detect_cpu_features();
     void protect_kernel_image();
+    void map_low_memory_with_large_pages();
     void parse_memory_map();
     static void flush_tlb_local(VirtualAddress, size_t page_count = 1);
-    static void flush_tlb(VirtualAddress, size_t page_count = 1);
+    static void flush_tlb(const PageDirectory*, VirtualAddress, size_t page_count = 1);
 
     static Region* user_region_from_vaddr(Process&, VirtualAddress);
     static Region* kernel_region_from_vaddr(VirtualAddress);
@@ -187,6 +213,12 @@ private:
     static Region* find_region_from_vaddr(VirtualAddress);
 
     RefPtr<PhysicalPage> find_free_user_physical_page();
+    bool reclaim_user_physical_pages();
+    size_t compress_cold_anonymous_pages(size_t page_count);
+    size_t compress_cold_pages(AnonymousVMObject&, size_t page_count, size_t& kmalloc_budget);
+    bool compress_page(AnonymousVMObject&, size_t page_index, size_t& kmalloc_budget);
+    void update_compressed_page_stats(ssize_t page_delta, ssize_t byte_delta);
+
     u8* quickmap_page(PhysicalPage&);
     void unquickmap_page();
 
@@ -194,7 +226,11 @@ private:
     PageTableEntry* quickmap_pt(PhysicalAddress);
 
     const PageTableEntry* pte(const PageDirectory&, VirtualAddress);
+    PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry& ensure_pte(PageDirectory&, VirtualAddress);
+    void split_large_page(PageDirectory&, PageDirectoryEntry&, VirtualAddress);
+    void map_large_page(PageDirectory&, VirtualAddress, PhysicalAddress, bool writable, bool user_allowed, bool executable, bool cacheable);
+    bool unmap_large_page(PageDirectory&, VirtualAddress);
 
     RefPtr<PageDirectory> m_kernel_page_directory;
     RefPtr<PhysicalPage> m_low_page_table;
@@ -205,6 +241,8 @@ private:
     unsigned m_user_physical_pages_used { 0 };
     unsigned m_super_physical_pages { 0 };
     unsigned m_super_physical_pages_used { 0 };
+    size_t m_compressed_user_pages { 0 };
+    size_t m_compressed_user_bytes { 0 };
 
     NonnullRefPtrVector<PhysicalRegion> m_user_physical_regions;
     NonnullRefPtrVector<PhysicalRegion> m_super_physical_regions;
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <AK/StdLibExtras.h>
+#include <Kernel/StdLib.h>
+#include <Kernel/VM/PageCompression.h>
+
+namespace Kernel {
+namespace PageCompression {
+
+static constexpr size_t min_match_length = 4;
+static constexpr size_t hash_bits = 10;
+static constexpr u16 empty_slot = 0xffff;
+
+static inline u32 read_u32(const u8* data)
+{
+    u32 value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+size_t compress(const u8* input, size_t input_size, u8* output, size_t output_capacity)
+{
+    // Positions are stored as u16 in the hash table, with 0xffff meaning "empty".
+    ASSERT(input_size < empty_slot);
+
+    u16 table[1 << hash_bits];
+    memset(table, 0xff, sizeof(table));
+
+    size_t in = 0;
+    size_t anchor = 0;
+    size_t out = 0;
+
+    auto emit_length = [&](size_t length) {
+        while (length >= 255) {
+            if (out >= output_capacity)
+                return false;
+            output[out++] = 255;
+            length -= 255;
+        }
+        if (out >= output_capacity)
+            return false;
+        output[out++] = length;
+        return true;
+    };
+
+    auto emit_sequence = [&](size_t literal_length, size_t match_offset, size_t match_length) {
+        if (out >= output_capacity)
+            return false;
+        size_t token_offset = out++;
+        u8 token = min(literal_length, (size_t)15) << 4;
+        if (literal_length >= 15 && !emit_length(literal_length - 15))
+            return false;
+        if (literal_length > output_capacity - out)
+            return false;
+        memcpy(output + out, input + anchor, literal_length);
+        out += literal_length;
+        if (match_length) {
+            if (output_capacity - out < 2)
+                return false;
+            output[out++] = match_offset & 0xff;
+            output[out++] = match_offset >> 8;
+            size_t extra_match_length = match_length - min_match_length;
+            token |= min(extra_match_length, (size_t)15);
+            if (extra_match_length >= 15 && !emit_length(extra_match_length - 15))
+                return false;
+        }
+        output[token_offset] = token;
+        return true;
+    };
+
+    while (in + min_match_length <= input_size) {
+        u32 sequence = read_u32(input + in);
+        u32 hash = (sequence * 2654435761u) >> (32 - hash_bits);
+        size_t candidate = table[hash];
+        table[hash] = in;
+        if (candidate == empty_slot || read_u32(input + candidate) != sequence) {
+            ++in;
+            continue;
+        }
+        size_t match_length = min_match_length;
+        while (in + match_length < input_size && input[candidate + match_length] == input[in + match_length])
+            ++match_length;
+        if (!emit_sequence(in - anchor, in - candidate, match_length))
+            return 0;
+        in += match_length;
+        anchor = in;
+    }
+
+    if (!emit_sequence(input_size - anchor, 0, 0))
+        return 0;
+    return out;
+}
+
+bool decompress(const u8* input, size_t input_size, u8* output, size_t output_size)
+{
+    size_t in = 0;
+    size_t out = 0;
+
+    auto read_length = [&](size_t& length) {
+        u8 byte;
+        do {
+            if (in >= input_size)
+                return false;
+            byte = input[in++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (in < input_size) {
+        u8 token = input[in++];
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(literal_length))
+            return false;
+        if (literal_length > input_size - in || literal_length > output_size - out)
+            return false;
+        memcpy(output + out, input + in, literal_length);
+        in += literal_length;
+        out += literal_length;
+
+        if (in == input_size)
+            break;
+
+        if (input_size - in < 2)
+            return false;
+        size_t match_offset = input[in] | (input[in + 1] << 8);
+        in += 2;
+        if (!match_offset || match_offset > out)
+            return false;
+        size_t match_length = token & 0xf;
+        if (match_length == 15 && !read_length(match_length))
+            return false;
+        match_length += min_match_length;
+        if (match_length > output_size - out)
+            return false;
+        // The match may overlap the bytes it produces, so copy one byte at a time.
+        for (size_t i = 0; i < match_length; ++i, ++out)
+            output[out] = output[out - match_offset];
+    }
+    return out == output_size;
+}
+
+}
+}
@@ -28,6 +28,7 @@
 #include <AK/NonnullRefPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/Vector.h>
+#include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Assertions.h>
 #include <Kernel/VM/PhysicalPage.h>
 #include <Kernel/VM/PhysicalRegion.h>
@@ -42,7 +43,6 @@ NonnullRefPtr<PhysicalRegion> PhysicalRegion::create(PhysicalAddress lower, Phys
 PhysicalRegion::PhysicalRegion(PhysicalAddress lower, PhysicalAddress upper)
     : m_lower(lower)
     , m_upper(upper)
-    , m_bitmap(Bitmap::create())
 {
 }
 
@@ -59,53 +59,204 @@ unsigned PhysicalRegion::finalize_capacity()
     ASSERT(!m_pages);
 
     m_pages = (m_upper.get() - m_lower.get()) / PAGE_SIZE;
-    m_bitmap.grow(m_pages, false);
+    for (unsigned order = 0; order <= max_order; ++order) {
+        if (m_pages >> order)
+            m_free_blocks[order] = Bitmap::create(m_pages >> order, false);
+    }
+
+    // Carve the region into the largest naturally aligned blocks that fit.
+    unsigned page = 0;
+    while (page < m_pages) {
+        unsigned order = max_order;
+        while (order && ((page & ((1u << order) - 1)) || page + (1u << order) > m_pages))
+            --order;
+        set_block_free(order, page >> order, true);
+        page += 1u << order;
+    }
 
     return size();
 }
 
-NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(size_t count, bool supervisor)
+void PhysicalRegion::set_block_free(unsigned order, unsigned block, bool free)
 {
-    ASSERT(m_pages);
-    ASSERT(m_used != m_pages);
+    ASSERT(m_free_blocks[order].get(block) != free);
+    m_free_blocks[order].set(block, free);
+    if (free) {
+        ++m_free_block_count[order];
+        if (block < m_free_block_hint[order])
+            m_free_block_hint[order] = block;
+    } else {
+        --m_free_block_count[order];
+    }
+}
 
-    NonnullRefPtrVector<PhysicalPage> physical_pages;
-    physical_pages.ensure_capacity(count);
+Optional<unsigned> PhysicalRegion::find_free_block(unsigned order)
+{
+    if (!m_free_block_count[order])
+        return {};
+    auto& bitmap = m_free_blocks[order];
+    const u8* data = bitmap.data();
+    size_t byte_count = ceil_div(bitmap.size(), static_cast<size_t>(8));
+    for (size_t i = m_free_block_hint[order] / 8; i < byte_count; ++i) {
+        if (!data[i])
+            continue;
+        unsigned block = i * 8 + __builtin_ctz(data[i]);
+        m_free_block_hint[order] = block;
+        return block;
+    }
+    ASSERT_NOT_REACHED();
+}
 
-    auto first_contiguous_page = find_contiguous_free_pages(count);
+Optional<unsigned> PhysicalRegion::allocate_block(unsigned order)
+{
+    ASSERT(order <= max_order);
+    unsigned found_order = order;
+    while (found_order <= max_order && !m_free_block_count[found_order])
+        ++found_order;
+    if (found_order > max_order)
+        return {};
 
-    for (size_t index = 0; index < count; index++)
-        physical_pages.append(PhysicalPage::create(m_lower.offset(PAGE_SIZE * (index + first_contiguous_page)), supervisor));
-    return physical_pages;
+    unsigned block = find_free_block(found_order).value();
+    set_block_free(found_order, block, false);
+
+    // Split it up, giving back the upper half each time.
+    while (found_order > order) {
+        --found_order;
+        block <<= 1;
+        set_block_free(found_order, block + 1, true);
+    }
+    return block << order;
 }
 
-unsigned PhysicalRegion::find_contiguous_free_pages(size_t count)
+void PhysicalRegion::free_block(unsigned first_page, unsigned order)
 {
-    ASSERT(count != 0);
-    // search from the last page we allocated
-    auto range = find_and_allocate_contiguous_range(count);
-    ASSERT(range.has_value());
-    return range.value();
+    unsigned block = first_page >> order;
+    while (order < max_order) {
+        unsigned buddy = block ^ 1;
+        if (buddy >= m_free_blocks[order].size() || !m_free_blocks[order].get(buddy))
+            break;
+        set_block_free(order, buddy, false);
+        block >>= 1;
+        ++order;
+    }
+    set_block_free(order, block, true);
 }
 
-Optional<unsigned> PhysicalRegion::find_and_allocate_contiguous_range(size_t count)
+Optional<unsigned> PhysicalRegion::allocate_max_order_run(size_t count)
 {
+    // Runs larger than the biggest buddy block are made from consecutive max order blocks.
+    size_t blocks_needed = ceil_div(count, static_cast<size_t>(1u << max_order));
+    auto& bitmap = m_free_blocks[max_order];
+    if (m_free_block_count[max_order] < blocks_needed)
+        return {};
+    size_t run_start = 0;
+    size_t run_length = 0;
+    for (size_t block = m_free_block_hint[max_order]; block < bitmap.size(); ++block) {
+        if (!bitmap.get(block)) {
+            run_length = 0;
+            continue;
+        }
+        if (!run_length++)
+            run_start = block;
+        if (run_length == blocks_needed)
+            break;
+    }
+    if (run_length < blocks_needed)
+        return {};
+    for (size_t block = run_start; block < run_start + blocks_needed; ++block)
+        set_block_free(max_order, block, false);
+    unsigned first_page = run_start << max_order;
+    for (unsigned page = first_page + count; page < first_page + (blocks_needed << max_order); ++page)
+        free_block(page, 0);
+    return first_page;
+}
+
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(size_t count, bool supervisor, size_t physical_alignment)
+{
+    ASSERT(m_pages);
     ASSERT(count != 0);
-    size_t found_pages_count = 0;
-    auto first_index = m_bitmap.find_longest_range_of_unset_bits(count, found_pages_count);
-    if (!first_index.has_value())
+    ASSERT(physical_alignment && !(physical_alignment & (physical_alignment - 1)) && physical_alignment >= PAGE_SIZE);
+
+    if (count > free())
         return {};
 
-    auto page = first_index.value();
-    if (count == found_pages_count) {
-        for (unsigned page_index = page; page_index < (page + count); page_index++) {
-            m_bitmap.set(page_index, true);
-        }
-        m_used += count;
-        m_last = page + count;
-        return page;
+    // Blocks are aligned relative to the start of the region, which itself may not be
+    // aligned, so leave enough slack to find a suitably aligned run inside the block.
+    size_t alignment_in_pages = physical_alignment / PAGE_SIZE;
+    size_t pages_to_allocate = count + alignment_in_pages - 1;
+
+    auto allocate = [&]() -> Optional<unsigned> {
+        if (alignment_in_pages == 1 && count > (1u << max_order))
+            return allocate_max_order_run(count);
+        if (pages_to_allocate > (1u << max_order))
+            return {};
+        unsigned order = pages_to_allocate == 1 ? 0 : 32 - __builtin_clz(pages_to_allocate - 1);
+        auto block = allocate_block(order);
+        if (!block.has_value())
+            return {};
+        unsigned block_start = block.value();
+        unsigned block_end = block_start + (1u << order);
+        FlatPtr block_paddr = m_lower.offset(block_start * PAGE_SIZE).get();
+        unsigned first_page = block_start + (round_up_to_power_of_two(block_paddr, physical_alignment) - block_paddr) / PAGE_SIZE;
+        ASSERT(first_page + count <= block_end);
+        // Give back the parts of the block we don't need.
+        for (unsigned page = block_start; page < first_page; ++page)
+            free_block(page, 0);
+        for (unsigned page = first_page + count; page < block_end; ++page)
+            free_block(page, 0);
+        return first_page;
+    };
+
+    auto first_page = allocate();
+    if (!first_page.has_value()) {
+        // The pages cached by the processors might be what's keeping the buddies apart.
+        drain_all_hot_page_lists();
+        first_page = allocate();
+        if (!first_page.has_value())
+            return {};
     }
-    return {};
+
+    m_used += count;
+
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    physical_pages.ensure_capacity(count);
+    for (size_t index = 0; index < count; index++)
+        physical_pages.append(PhysicalPage::create(m_lower.offset(PAGE_SIZE * (index + first_page.value())), supervisor));
+    return physical_pages;
+}
+
+PhysicalRegion::HotPageList* PhysicalRegion::current_hot_page_list()
+{
+    // The MM lock keeps interrupts disabled, so we won't migrate while using the list.
+    ASSERT(!(cpu_flags() & 0x200));
+    if (!Processor::is_initialized())
+        return nullptr;
+    u32 id = Processor::current().id();
+    if (id >= max_hot_page_list_processors)
+        return nullptr;
+    return &m_hot_page_lists[id];
+}
+
+void PhysicalRegion::refill(HotPageList& list)
+{
+    while (list.count < hot_page_list_capacity / 2) {
+        auto page = allocate_block(0);
+        if (!page.has_value())
+            break;
+        list.pages[list.count++] = page.value();
+    }
+}
+
+void PhysicalRegion::drain(HotPageList& list, size_t count)
+{
+    while (count-- && list.count)
+        free_block(list.pages[--list.count], 0);
+}
+
+void PhysicalRegion::drain_all_hot_page_lists()
+{
+    for (auto& list : m_hot_page_lists)
+        drain(list, list.count);
 }
 
 RefPtr<PhysicalPage> PhysicalRegion::take_free_page(bool supervisor)
@@ -115,7 +266,24 @@ RefPtr<PhysicalPage> PhysicalRegion::take_free_page(bool supervisor)
     if (m_used == m_pages)
         return nullptr;
 
-    return PhysicalPage::create(m_lower.offset(find_contiguous_free_pages(1) * PAGE_SIZE), supervisor);
+    Optional<unsigned> page;
+    if (auto* list = current_hot_page_list()) {
+        if (!list->count)
+            refill(*list);
+        if (list->count)
+            page = list->pages[--list->count];
+    }
+    if (!page.has_value())
+        page = allocate_block(0);
+    if (!page.has_value()) {
+        // Every free page is sitting in some other processor's list.
+        drain_all_hot_page_lists();
+        page = allocate_block(0);
+    }
+    ASSERT(page.has_value());
+
+    ++m_used;
+    return PhysicalPage::create(m_lower.offset(page.value() * PAGE_SIZE), supervisor);
 }
 
 void PhysicalRegion::return_page_at(PhysicalAddress addr)
@@ -131,11 +299,16 @@ void PhysicalRegion::return_page_at(PhysicalAddress addr)
     ASSERT((FlatPtr)local_offset < (FlatPtr)(m_pages * PAGE_SIZE));
 
     auto page = (FlatPtr)local_offset / PAGE_SIZE;
-    if (page < m_last)
-        m_last = page;
-
-    m_bitmap.set(page, false);
     m_used--;
+
+    auto* list = current_hot_page_list();
+    if (!list) {
+        free_block(page, 0);
+        return;
+    }
+    if (list->count == hot_page_list_capacity)
+        drain(*list, hot_page_list_capacity / 2);
+    list->pages[list->count++] = page;
 }
 
 }
@@ -34,10 +34,17 @@
 
 namespace Kernel {
 
+// Physical pages are handed out by a binary buddy allocator. A free block of
+// order N covers 2^N pages and is aligned to its size within the region, so
+// contiguous allocations are served by splitting the smallest free block that fits.
+// Each processor additionally caches a few single pages, which keeps the common
+// page fault path from having to touch the buddy free lists at all.
 class PhysicalRegion : public RefCounted<PhysicalRegion> {
     AK_MAKE_ETERNAL
 
 public:
+    static constexpr unsigned max_order = 10;
+
     static NonnullRefPtr<PhysicalRegion> create(PhysicalAddress lower, PhysicalAddress upper);
     ~PhysicalRegion() {}
 
@@ -52,13 +59,29 @@ public:
     bool contains(PhysicalPage& page) const { return page.paddr() >= m_lower && page.paddr() <= m_upper; }
 
     RefPtr<PhysicalPage> take_free_page(bool supervisor);
-    NonnullRefPtrVector<PhysicalPage> take_contiguous_free_pages(size_t count, bool supervisor);
+    NonnullRefPtrVector<PhysicalPage> take_contiguous_free_pages(size_t count, bool supervisor, size_t physical_alignment = PAGE_SIZE);
     void return_page_at(PhysicalAddress addr);
     void return_page(PhysicalPage&& page) { return_page_at(page.paddr()); }
 
 private:
-    unsigned find_contiguous_free_pages(size_t count);
-    Optional<unsigned> find_and_allocate_contiguous_range(size_t count);
+    static constexpr size_t hot_page_list_capacity = 32;
+    static constexpr size_t max_hot_page_list_processors = 32;
+
+    struct HotPageList {
+        size_t count { 0 };
+        unsigned pages[hot_page_list_capacity];
+    };
+
+    Optional<unsigned> allocate_block(unsigned order);
+    void free_block(unsigned first_page, unsigned order);
+    Optional<unsigned> allocate_max_order_run(size_t count);
+    Optional<unsigned> find_free_block(unsigned order);
+    void set_block_free(unsigned order, unsigned block, bool free);
+
+    HotPageList* current_hot_page_list();
+    void refill(HotPageList&);
+    void drain(HotPageList&, size_t count);
+    void drain_all_hot_page_lists();
 
     PhysicalRegion(PhysicalAddress lower, PhysicalAddress upper);
 
@@ -66,8 +89,15 @@ private:
     PhysicalAddress m_upper;
     unsigned m_pages { 0 };
     unsigned m_used { 0 };
-    unsigned m_last { 0 };
-    Bitmap m_bitmap;
+
+    // One bit per block of each order, set if that block is free as a whole
+    // (and not part of a larger free block).
+    Bitmap m_free_blocks[max_order + 1];
+    unsigned m_free_block_count[max_order + 1] {};
+    // No free block of a given order lives below its hint.
+    unsigned m_free_block_hint[max_order + 1] {};
+
+    HotPageList m_hot_page_lists[max_hot_page_list_processors];
 };
 
 }
@@ -78,6 +78,7 @@ int PurgeableVMObject::purge_impl()
             ++purged_page_count;
         m_physical_pages[i] = MM.shared_zero_page();
     }
+    discard_compressed_pages();
     m_was_purged = true;
 
     for_each_region([&](auto& region) {
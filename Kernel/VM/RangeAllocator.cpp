@@ -50,6 +50,7 @@ void RangeAllocator::initialize_with_range(VirtualAddress base, size_t size)
 
 void RangeAllocator::initialize_from_parent(const RangeAllocator& parent_allocator)
 {
+    ScopedSpinLock lock(parent_allocator.m_lock);
     m_total_range = parent_allocator.m_total_range;
     m_available_ranges = parent_allocator.m_available_ranges;
 }
@@ -97,6 +98,8 @@ Range RangeAllocator::allocate_anywhere(size_t size, size_t alignment)
     if (!size)
         return {};
 
+    ScopedSpinLock lock(m_lock);
+
 #ifdef VM_GUARD_PAGES
     // NOTE: We pad VM allocations with a guard page on each side.
     size_t effective_size = size + PAGE_SIZE * 2;
@@ -139,28 +142,41 @@ Range RangeAllocator::allocate_specific(VirtualAddress base, size_t size)
     if (!size)
         return {};
 
+    ScopedSpinLock lock(m_lock);
     Range allocated_range(base, size);
-    for (size_t i = 0; i < m_available_ranges.size(); ++i) {
-        auto& available_range = m_available_ranges[i];
-        if (!available_range.contains(base, size))
-            continue;
-        if (available_range == allocated_range) {
-            m_available_ranges.remove(i);
-            return allocated_range;
-        }
-        carve_at_index(i, allocated_range);
-#ifdef VRA_DEBUG
-        dbg() << "VRA: Allocated specific(" << size << "): " << String::format("%x", available_range.base().get());
-        dump();
-#endif
+
+    // The available ranges are sorted and disjoint, so only the last one starting at or below base can contain it.
+    size_t low = 0;
+    size_t high = m_available_ranges.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (m_available_ranges[middle].base() <= base)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if (!low || !m_available_ranges[low - 1].contains(base, size)) {
+        dbg() << "VRA: Failed to allocate specific range: " << base << "(" << size << ")";
+        return {};
+    }
+
+    size_t i = low - 1;
+    if (m_available_ranges[i] == allocated_range) {
+        m_available_ranges.remove(i);
         return allocated_range;
     }
-    dbg() << "VRA: Failed to allocate specific range: " << base << "(" << size << ")";
-    return {};
+    carve_at_index(i, allocated_range);
+#ifdef VRA_DEBUG
+    dbg() << "VRA: Allocated specific(" << size << "): " << String::format("%x", base.get());
+    dump();
+#endif
+    return allocated_range;
 }
 
 void RangeAllocator::deallocate(Range range)
 {
+    ScopedSpinLock lock(m_lock);
     ASSERT(m_total_range.contains(range));
     ASSERT(range.size());
     ASSERT(range.base() < range.end());
@@ -29,6 +29,7 @@
 #include <AK/String.h>
 #include <AK/Traits.h>
 #include <AK/Vector.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/VirtualAddress.h>
 
 namespace Kernel {
@@ -100,6 +101,7 @@ private:
 
     Vector<Range> m_available_ranges;
     Range m_total_range;
+    mutable SpinLock<u8> m_lock;
 };
 
 inline const LogStream& operator<<(const LogStream& stream, const Range& value)
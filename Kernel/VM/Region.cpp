@@ -28,6 +28,7 @@
 #include <AK/StringView.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Process.h>
+#include <Kernel/Tasks/ReadAheadTask.h>
 #include <Kernel/Thread.h>
 #include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -40,6 +41,11 @@
 
 namespace Kernel {
 
+// Inode faults also map in the rest of the aligned window of pages around the faulting one.
+static constexpr size_t fault_around_page_count = 16;
+// Mappings advised as sequential use a larger window, and drop the pages left behind.
+static constexpr size_t sequential_fault_around_page_count = 64;
+
 Region::Region(const Range& range, NonnullRefPtr<VMObject> vmobject, size_t offset_in_vmobject, const String& name, u8 access, bool cacheable, bool kernel)
     : m_range(range)
     , m_offset_in_vmobject(offset_in_vmobject)
@@ -92,6 +98,7 @@ NonnullOwnPtr<Region> Region::clone()
         auto region = Region::create_user_accessible(m_range, m_vmobject, m_offset_in_vmobject, m_name, m_access);
         region->set_mmap(m_mmap);
         region->set_shared(m_shared);
+        region->set_access_pattern(m_access_pattern);
         return region;
     }
 
@@ -113,6 +120,7 @@ NonnullOwnPtr<Region> Region::clone()
         clone_region->set_stack(true);
     }
     clone_region->set_mmap(m_mmap);
+    clone_region->set_access_pattern(m_access_pattern);
     return clone_region;
 }
 
@@ -126,11 +134,11 @@ bool Region::commit()
         if (!commit(i)) {
             // Flush what we did commit
             if (i > 0)
-                MM.flush_tlb(vaddr(), i + 1);
+                MM.flush_tlb(m_page_directory.ptr(), vaddr(), i + 1);
             return false;
         }
     }
-    MM.flush_tlb(vaddr(), page_count());
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
     return true;
 }
 
@@ -141,6 +149,12 @@ bool Region::commit(size_t page_index)
     auto& vmobject_physical_page_entry = physical_page_slot(page_index);
     if (!vmobject_physical_page_entry.is_null() && !vmobject_physical_page_entry->is_shared_zero_page())
         return true;
+    if (vmobject_physical_page_entry.is_null() && static_cast<AnonymousVMObject&>(vmobject()).has_compressed_page(first_page_index() + page_index)) {
+        if (!static_cast<AnonymousVMObject&>(vmobject()).decompress_page(first_page_index() + page_index))
+            return false;
+        remap_page(page_index, false); // caller is in charge of flushing tlb
+        return true;
+    }
     auto physical_page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
     if (!physical_page) {
         klog() << "MM: commit was unable to allocate a physical page";
@@ -231,15 +245,19 @@ Bitmap& Region::ensure_cow_map() const
 void Region::map_individual_page_impl(size_t page_index)
 {
     auto page_vaddr = vaddr_from_page_index(page_index);
-    auto& pte = MM.ensure_pte(*m_page_directory, page_vaddr);
     auto* page = physical_page(page_index);
+    // Untouched anonymous pages are filled in on fault, so don't allocate a page table
+    // just to store a non-present entry in it.
+    if (!page && !MM.pte(*m_page_directory, page_vaddr))
+        return;
+    auto& pte = MM.ensure_pte(*m_page_directory, page_vaddr);
     if (!page || (!is_readable() && !is_writable())) {
         pte.clear();
     } else {
         pte.set_cache_disabled(!m_cacheable);
         pte.set_physical_page_base(page->paddr().get());
         pte.set_present(true);
-        if (should_cow(page_index))
+        if (should_cow(page_index) || is_clean_shared_inode_page(page_index))
             pte.set_writable(false);
         else
             pte.set_writable(is_writable());
@@ -259,7 +277,7 @@ void Region::remap_page(size_t page_index, bool with_flush)
     ASSERT(physical_page(page_index));
     map_individual_page_impl(page_index);
     if (with_flush)
-        MM.flush_tlb(vaddr_from_page_index(page_index));
+        MM.flush_tlb(m_page_directory.ptr(), vaddr_from_page_index(page_index));
 }
 
 void Region::unmap(ShouldDeallocateVirtualMemoryRange deallocate_range)
@@ -268,14 +286,19 @@ void Region::unmap(ShouldDeallocateVirtualMemoryRange deallocate_range)
     ASSERT(m_page_directory);
     for (size_t i = 0; i < page_count(); ++i) {
         auto vaddr = vaddr_from_page_index(i);
-        auto& pte = MM.ensure_pte(*m_page_directory, vaddr);
-        pte.clear();
+        if (i + MemoryManager::pages_per_large_page <= page_count() && MM.unmap_large_page(*m_page_directory, vaddr)) {
+            i += MemoryManager::pages_per_large_page - 1;
+            continue;
+        }
+        // Don't allocate page tables for pages that were never mapped in.
+        if (auto* pte = MM.pte(*m_page_directory, vaddr))
+            pte->clear();
 #ifdef MM_DEBUG
         auto* page = physical_page(i);
         dbg() << "MM: >> Unmapped " << vaddr << " => P" << String::format("%p", page ? page->paddr().get() : 0) << " <<";
 #endif
     }
-    MM.flush_tlb(vaddr(), page_count());
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
     if (deallocate_range == ShouldDeallocateVirtualMemoryRange::Yes) {
         if (m_page_directory->range_allocator().contains(range()))
             m_page_directory->range_allocator().deallocate(range());
@@ -299,9 +322,54 @@ void Region::map(PageDirectory& page_directory)
 #ifdef MM_DEBUG
     dbg() << "MM: Region::map() will map VMO pages " << first_page_index() << " - " << last_page_index() << " (VMO page count: " << vmobject().page_count() << ")";
 #endif
-    for (size_t page_index = 0; page_index < page_count(); ++page_index)
+    for (size_t page_index = 0; page_index < page_count();) {
+        if (can_map_large_page(page_index)) {
+            auto* page = physical_page(page_index);
+            MM.map_large_page(*m_page_directory, vaddr_from_page_index(page_index), page->paddr(), is_writable(), is_user_accessible(), is_executable(), m_cacheable);
+            page_index += MemoryManager::pages_per_large_page;
+            continue;
+        }
         map_individual_page_impl(page_index);
-    MM.flush_tlb(vaddr(), page_count());
+        ++page_index;
+    }
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
+}
+
+void Region::map_lazily(PageDirectory& page_directory)
+{
+    // Only anonymous and file-backed memory knows how to fault its pages back in.
+    if (!vmobject().is_anonymous() && !vmobject().is_inode()) {
+        map(page_directory);
+        return;
+    }
+    ScopedSpinLock lock(s_mm_lock);
+    set_page_directory(page_directory);
+}
+
+bool Region::can_map_large_page(size_t page_index) const
+{
+    // A large page needs 2 MiB of virtual and physical memory that are both aligned,
+    // physically contiguous, and mapped with the same permissions throughout.
+    if (vaddr_from_page_index(page_index).get() & (MemoryManager::large_page_size - 1))
+        return false;
+    if (page_index + MemoryManager::pages_per_large_page > page_count())
+        return false;
+    if (!is_readable() && !is_writable())
+        return false;
+    // File-backed pages are tracked (and written back) one page at a time.
+    if (vmobject().is_inode())
+        return false;
+    auto* first_page = physical_page(page_index);
+    if (!first_page || first_page->is_shared_zero_page() || (first_page->paddr().get() & (MemoryManager::large_page_size - 1)))
+        return false;
+    for (size_t i = 0; i < MemoryManager::pages_per_large_page; ++i) {
+        auto* page = physical_page(page_index + i);
+        if (!page || page->paddr() != first_page->paddr().offset(i * PAGE_SIZE))
+            return false;
+        if (should_cow(page_index + i))
+            return false;
+    }
+    return true;
 }
 
 void Region::remap()
@@ -326,19 +394,44 @@ PageFaultResponse Region::handle_fault(const PageFault& fault)
 #ifdef PAGE_FAULT_DEBUG
             dbg() << "NP(inode) fault in Region{" << this << "}[" << page_index_in_region << "]";
 #endif
-            return handle_inode_fault(page_index_in_region);
+            auto response = handle_inode_fault(page_index_in_region);
+            if (response == PageFaultResponse::Continue && fault.is_write() && vmobject().is_shared_inode())
+                return handle_shared_inode_write_fault(page_index_in_region);
+            return response;
+        }
+        if (!vmobject().is_anonymous()) {
+            dbg() << "BUG! Unexpected NP fault at " << fault.vaddr();
+            return PageFaultResponse::ShouldCrash;
+        }
+        if (auto* page = physical_page(page_index_in_region)) {
+            // The page is there but isn't mapped yet, e.g. in a lazily mapped child after fork(),
+            // or someone else filled it in while we were on our way here.
+            remap_page(page_index_in_region);
+            if (fault.is_write() && should_cow(page_index_in_region)) {
+                if (page->is_shared_zero_page())
+                    return handle_zero_fault(page_index_in_region);
+                return handle_cow_fault(page_index_in_region);
+            }
+            return PageFaultResponse::Continue;
+        }
+        if (static_cast<AnonymousVMObject&>(vmobject()).has_compressed_page(first_page_index() + page_index_in_region)) {
+#ifdef PAGE_FAULT_DEBUG
+            dbg() << "NP(compressed) fault in Region{" << this << "}[" << page_index_in_region << "]";
+#endif
+            return handle_compressed_fault(page_index_in_region);
         }
-#ifdef MAP_SHARED_ZERO_PAGE_LAZILY
         if (fault.is_read()) {
+#ifdef PAGE_FAULT_DEBUG
+            dbg() << "NP(zero, read) fault in Region{" << this << "}[" << page_index_in_region << "]";
+#endif
             physical_page_slot(page_index_in_region) = MM.shared_zero_page();
             remap_page(page_index_in_region);
             return PageFaultResponse::Continue;
         }
-        return handle_zero_fault(page_index_in_region);
-#else
-        dbg() << "BUG! Unexpected NP fault at " << fault.vaddr();
-        return PageFaultResponse::ShouldCrash;
+#ifdef PAGE_FAULT_DEBUG
+        dbg() << "NP(zero) fault in Region{" << this << "}[" << page_index_in_region << "]";
 #endif
+        return handle_zero_fault(page_index_in_region);
     }
     ASSERT(fault.type() == PageFault::Type::ProtectionViolation);
     if (fault.access() == PageFault::Access::Write && is_writable() && should_cow(page_index_in_region)) {
@@ -353,6 +446,12 @@ PageFaultResponse Region::handle_fault(const PageFault& fault)
         }
         return handle_cow_fault(page_index_in_region);
     }
+    if (fault.access() == PageFault::Access::Write && is_writable() && vmobject().is_shared_inode()) {
+#ifdef PAGE_FAULT_DEBUG
+        dbg() << "PV(dirty) fault in Region{" << this << "}[" << page_index_in_region << "]";
+#endif
+        return handle_shared_inode_write_fault(page_index_in_region);
+    }
     dbg() << "PV(error) fault in Region{" << this << "}[" << page_index_in_region << "] at " << fault.vaddr();
     return PageFaultResponse::ShouldCrash;
 }
@@ -394,6 +493,17 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+PageFaultResponse Region::handle_compressed_fault(size_t page_index_in_region)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(vmobject().is_anonymous());
+
+    if (!static_cast<AnonymousVMObject&>(vmobject()).decompress_page(first_page_index() + page_index_in_region))
+        return PageFaultResponse::OutOfMemory;
+    remap_page(page_index_in_region);
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     ASSERT_INTERRUPTS_DISABLED();
@@ -464,10 +574,31 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
 #ifdef MM_DEBUG
     dbg() << "MM: page_in_from_inode ready to read from inode";
 #endif
+    auto& inode = inode_vmobject.inode();
+    size_t page_index_in_vmobject = first_page_index() + page_index_in_region;
+    if (inode.is_page_cacheable()) {
+        // Map the inode's page cache page directly. Private mappings must
+        // never write to it, so they get their own copy on first write.
+        sti();
+        auto page_or_error = inode.cached_page(page_index_in_vmobject);
+        cli();
+        if (page_or_error.is_error()) {
+            klog() << "MM: handle_inode_fault had error (" << page_or_error.error() << ") while reading!";
+            return page_or_error.error() == -ENOMEM ? PageFaultResponse::OutOfMemory : PageFaultResponse::ShouldCrash;
+        }
+        vmobject_physical_page_entry = page_or_error.release_value();
+        if (!is_shared())
+            set_should_cow(page_index_in_region, true);
+        remap_page(page_index_in_region);
+        fault_around_inode_page(page_index_in_region);
+        if (m_access_pattern == AccessPattern::Sequential)
+            drop_behind_inode_page(page_index_in_region);
+        return PageFaultResponse::Continue;
+    }
+
     sti();
     u8 page_buffer[PAGE_SIZE];
-    auto& inode = inode_vmobject.inode();
-    auto nread = inode.read_bytes((first_page_index() + page_index_in_region) * PAGE_SIZE, PAGE_SIZE, page_buffer, nullptr);
+    auto nread = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, page_buffer, nullptr);
     if (nread < 0) {
         klog() << "MM: handle_inode_fault had error (" << nread << ") while reading!";
         return PageFaultResponse::ShouldCrash;
@@ -491,4 +622,216 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+PageFaultResponse Region::handle_shared_inode_write_fault(size_t page_index_in_region)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(vmobject().is_shared_inode());
+
+    sti();
+    LOCKER(vmobject().m_paging_lock);
+    cli();
+
+    // If the page went away while we were waiting, the retried access will fault it back in.
+    if (!physical_page(page_index_in_region))
+        return PageFaultResponse::Continue;
+
+    // Shared file pages start out write-protected, so the first write tells us what needs writing back.
+    static_cast<InodeVMObject&>(vmobject()).set_page_dirty(first_page_index() + page_index_in_region, true);
+    remap_page(page_index_in_region);
+    return PageFaultResponse::Continue;
+}
+
+bool Region::is_clean_shared_inode_page(size_t page_index) const
+{
+    if (!vmobject().is_shared_inode())
+        return false;
+    return !static_cast<const InodeVMObject&>(vmobject()).is_page_dirty(first_page_index() + page_index);
+}
+
+void Region::remap_vmobject_page(size_t page_index_in_vmobject, bool with_flush)
+{
+    if (!m_page_directory || page_index_in_vmobject < first_page_index() || page_index_in_vmobject > last_page_index())
+        return;
+    ScopedSpinLock lock(s_mm_lock);
+    size_t page_index_in_region = page_index_in_vmobject - first_page_index();
+    map_individual_page_impl(page_index_in_region);
+    if (with_flush)
+        MM.flush_tlb(m_page_directory.ptr(), vaddr_from_page_index(page_index_in_region));
+}
+
+bool Region::can_exchange_anonymous_page(size_t page_index) const
+{
+    ASSERT(s_mm_lock.is_locked());
+    if (m_shared || !m_page_directory || !vmobject().is_anonymous() || vmobject().is_purgeable())
+        return false;
+    return !static_cast<const AnonymousVMObject&>(vmobject()).has_compressed_page(first_page_index() + page_index);
+}
+
+RefPtr<PhysicalPage> Region::share_anonymous_page(size_t page_index)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    if (!can_exchange_anonymous_page(page_index))
+        return nullptr;
+    auto page = physical_page_slot(page_index);
+    if (!page || page->is_shared_zero_page())
+        return nullptr;
+    if (!should_cow(page_index)) {
+        set_should_cow(page_index, true);
+        remap_page(page_index);
+    }
+    return page;
+}
+
+bool Region::replace_anonymous_page(size_t page_index, PhysicalPage& page)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    if (!is_writable() || !can_exchange_anonymous_page(page_index))
+        return false;
+    physical_page_slot(page_index) = page;
+    set_should_cow(page_index, true);
+    remap_page(page_index);
+    return true;
+}
+
+void Region::fault_around_inode_page(size_t page_index_in_region)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(vmobject().m_paging_lock.is_locked());
+
+    auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+    auto& inode = inode_vmobject.inode();
+    auto& vmobject_pages = inode_vmobject.physical_pages();
+
+    if (m_access_pattern == AccessPattern::Random)
+        return;
+    size_t window_size = m_access_pattern == AccessPattern::Sequential ? sequential_fault_around_page_count : fault_around_page_count;
+    size_t window_start = page_index_in_region & ~(window_size - 1);
+    size_t window_end = min(window_start + window_size, page_count());
+    window_end = min(window_end, inode_vmobject.page_count() - first_page_index());
+
+    auto needs_page = [&](size_t index) {
+        return index != page_index_in_region && vmobject_pages[first_page_index() + index].is_null();
+    };
+
+    RefPtr<PhysicalPage> pages[sequential_fault_around_page_count];
+    sti();
+
+    // Pick up whatever is already in the page cache.
+    size_t first_missing_page = window_end;
+    for (size_t i = window_start; i < window_end; ++i) {
+        if (!needs_page(i))
+            continue;
+        pages[i - window_start] = inode.cached_page_if_present(first_page_index() + i);
+        if (!pages[i - window_start] && i > page_index_in_region && first_missing_page == window_end)
+            first_missing_page = i;
+    }
+
+    // Pages behind the fault are likely to be needed next, so fetch them in one go and cache them.
+    if (first_missing_page < window_end) {
+        inode.read_ahead_pages(first_page_index() + first_missing_page, window_end - first_missing_page);
+        for (size_t i = first_missing_page; i < window_end; ++i) {
+            if (!needs_page(i) || pages[i - window_start])
+                continue;
+            auto page_or_error = inode.cached_page(first_page_index() + i);
+            if (page_or_error.is_error())
+                break;
+            pages[i - window_start] = page_or_error.release_value();
+        }
+    }
+
+    cli();
+    for (size_t i = window_start; i < window_end; ++i) {
+        if (!pages[i - window_start] || !needs_page(i))
+            continue;
+        vmobject_pages[first_page_index() + i] = move(pages[i - window_start]);
+        if (!is_shared())
+            set_should_cow(i, true);
+        // These PTEs were not present, so there's nothing stale in the TLB to flush.
+        remap_page(i, false);
+    }
+}
+
+void Region::drop_behind_inode_page(size_t page_index_in_region)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+
+    // Leave one window behind the reader mapped, in case it backs up a little.
+    size_t window_start = page_index_in_region & ~(sequential_fault_around_page_count - 1);
+    if (window_start < 2 * sequential_fault_around_page_count)
+        return;
+    sti();
+    release_clean_inode_pages_impl(window_start - 2 * sequential_fault_around_page_count, sequential_fault_around_page_count);
+    cli();
+}
+
+size_t Region::release_clean_inode_pages(size_t first_page_index_in_region, size_t page_count_to_release)
+{
+    ASSERT(vmobject().is_inode());
+    LOCKER(vmobject().m_paging_lock);
+
+    size_t end = min(first_page_index_in_region + page_count_to_release, page_count());
+    end = min(end, vmobject().page_count() - first_page_index());
+    size_t released_page_count = 0;
+    for (size_t i = first_page_index_in_region; i < end; i += sequential_fault_around_page_count)
+        released_page_count += release_clean_inode_pages_impl(i, min(end - i, sequential_fault_around_page_count));
+    return released_page_count;
+}
+
+size_t Region::release_clean_inode_pages_impl(size_t first_page_index_in_region, size_t page_count_to_release)
+{
+    ASSERT(vmobject().m_paging_lock.is_locked());
+    ASSERT(page_count_to_release <= sequential_fault_around_page_count);
+
+    auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+    auto& inode = inode_vmobject.inode();
+    size_t first_page_index_in_vmobject = first_page_index() + first_page_index_in_region;
+
+    // Pages of a private mapping may have been modified, so they're only known to be
+    // clean as long as they are still the page cache's copy.
+    bool is_private = inode_vmobject.is_private_inode();
+    RefPtr<PhysicalPage> cached_pages[sequential_fault_around_page_count];
+    if (is_private) {
+        if (!inode.is_page_cacheable())
+            return 0;
+        for (size_t i = 0; i < page_count_to_release; ++i)
+            cached_pages[i] = inode.cached_page_if_present(first_page_index_in_vmobject + i);
+    }
+
+    size_t released_page_count = 0;
+    {
+        ScopedSpinLock lock(s_mm_lock);
+        for (size_t i = 0; i < page_count_to_release; ++i) {
+            size_t page_index_in_vmobject = first_page_index_in_vmobject + i;
+            auto& page = inode_vmobject.physical_pages()[page_index_in_vmobject];
+            if (!page)
+                continue;
+            if (is_private ? page.ptr() != cached_pages[i].ptr() : inode_vmobject.is_page_dirty(page_index_in_vmobject))
+                continue;
+            page = nullptr;
+            ++released_page_count;
+            inode_vmobject.for_each_region([&](Region& region) {
+                region.remap_vmobject_page(page_index_in_vmobject);
+            });
+        }
+    }
+
+    // Let go of our own references, then give the pages back if nobody else is using them.
+    for (size_t i = 0; i < page_count_to_release; ++i)
+        cached_pages[i] = nullptr;
+    if (released_page_count && inode.is_page_cacheable())
+        inode.release_unused_cached_pages(first_page_index_in_vmobject, page_count_to_release);
+    return released_page_count;
+}
+
+void Region::read_ahead_inode_pages(size_t first_page_index_in_region, size_t page_count_to_read)
+{
+    ASSERT(vmobject().is_inode());
+    size_t end = min(first_page_index_in_region + page_count_to_read, page_count());
+    end = min(end, vmobject().page_count() - first_page_index());
+    if (first_page_index_in_region >= end)
+        return;
+    auto& inode = static_cast<InodeVMObject&>(vmobject()).inode();
+    ReadAheadTask::schedule(inode, first_page_index() + first_page_index_in_region, end - first_page_index_in_region);
+}
+
 }
@@ -63,6 +63,12 @@ public:
         ZeroedOnFork,
     };
 
+    enum class AccessPattern {
+        Normal,
+        Random,
+        Sequential,
+    };
+
     static NonnullOwnPtr<Region> create_user_accessible(const Range&, NonnullRefPtr<VMObject>, size_t offset_in_vmobject, const StringView& name, u8 access, bool cacheable = true);
     static NonnullOwnPtr<Region> create_kernel_only(const Range&, NonnullRefPtr<VMObject>, size_t offset_in_vmobject, const StringView& name, u8 access, bool cacheable = true);
 
@@ -172,6 +178,8 @@ public:
 
     void set_page_directory(PageDirectory&);
     void map(PageDirectory&);
+    // Like map(), but leaves the page tables empty and maps pages in on first access.
+    void map_lazily(PageDirectory&);
     enum class ShouldDeallocateVirtualMemoryRange {
         No,
         Yes,
@@ -189,6 +197,22 @@ public:
 
     void set_inherit_mode(InheritMode inherit_mode) { m_inherit_mode = inherit_mode; }
 
+    AccessPattern access_pattern() const { return m_access_pattern; }
+    void set_access_pattern(AccessPattern access_pattern) { m_access_pattern = access_pattern; }
+
+    // For file-backed regions: drop clean pages from the mapping so their memory can be
+    // reclaimed, or start reading pages into the page cache in the background.
+    size_t release_clean_inode_pages(size_t first_page_index, size_t page_count);
+    void read_ahead_inode_pages(size_t first_page_index, size_t page_count);
+
+    // Updates our mapping of the given VMObject page, if we map it at all.
+    void remap_vmobject_page(size_t page_index_in_vmobject, bool with_flush = true);
+
+    // For private anonymous regions: pass whole resident pages to or from another address space
+    // without copying them. Both sides end up mapping the page copy-on-write.
+    RefPtr<PhysicalPage> share_anonymous_page(size_t page_index);
+    bool replace_anonymous_page(size_t page_index, PhysicalPage&);
+
 private:
     Bitmap& ensure_cow_map() const;
 
@@ -204,10 +228,18 @@ private:
     void remap_page(size_t index, bool with_flush = true);
 
     PageFaultResponse handle_cow_fault(size_t page_index);
+    PageFaultResponse handle_compressed_fault(size_t page_index);
     PageFaultResponse handle_inode_fault(size_t page_index);
+    PageFaultResponse handle_shared_inode_write_fault(size_t page_index);
+    bool is_clean_shared_inode_page(size_t page_index) const;
+    bool can_exchange_anonymous_page(size_t page_index) const;
+    void fault_around_inode_page(size_t page_index);
+    void drop_behind_inode_page(size_t page_index);
+    size_t release_clean_inode_pages_impl(size_t first_page_index, size_t page_count);
     PageFaultResponse handle_zero_fault(size_t page_index);
 
     void map_individual_page_impl(size_t page_index);
+    bool can_map_large_page(size_t page_index) const;
 
     RefPtr<PageDirectory> m_page_directory;
     Range m_range;
@@ -216,6 +248,7 @@ private:
     String m_name;
     u8 m_access { 0 };
     InheritMode m_inherit_mode : 3 { InheritMode::Default };
+    AccessPattern m_access_pattern : 2 { AccessPattern::Normal };
     bool m_shared : 1 { false };
     bool m_user_accessible : 1 { false };
     bool m_cacheable : 1 { false };
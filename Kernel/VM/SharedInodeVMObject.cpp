@@ -25,6 +25,7 @@
  */
 
 #include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Thread.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/Region.h>
 #include <Kernel/VM/SharedInodeVMObject.h>
@@ -61,4 +62,49 @@ SharedInodeVMObject::~SharedInodeVMObject()
     ASSERT(inode().shared_vmobject() == this);
 }
 
+KResult SharedInodeVMObject::write_back_dirty_pages(size_t first_page_index, size_t page_count)
+{
+    LOCKER(m_paging_lock);
+
+    KResult result = KSuccess;
+    size_t end_page_index = min(first_page_index + page_count, this->page_count());
+    for (size_t page_index = first_page_index; page_index < end_page_index; ++page_index) {
+        off_t offset = page_index * PAGE_SIZE;
+        if (!m_dirty_pages.get(page_index) || offset >= (off_t)inode().size())
+            continue;
+
+        RefPtr<PhysicalPage> page;
+        {
+            ScopedSpinLock lock(s_mm_lock);
+            page = m_physical_pages[page_index];
+            m_dirty_pages.set(page_index, false);
+            if (!page)
+                continue;
+            // Write-protect the page before looking at it, so the next write marks it dirty again.
+            // Writers block on the paging lock until we're done.
+            for_each_region([&](Region& region) {
+                region.remap_vmobject_page(page_index);
+            });
+        }
+
+        u8 page_buffer[PAGE_SIZE];
+        {
+            InterruptDisabler disabler;
+            memcpy(page_buffer, MM.quickmap_page(*page), PAGE_SIZE);
+            MM.unquickmap_page();
+        }
+
+        ssize_t size = min((off_t)PAGE_SIZE, (off_t)inode().size() - offset);
+        m_writeback_thread = Thread::current();
+        ssize_t nwritten = inode().write_bytes(offset, size, page_buffer, nullptr);
+        m_writeback_thread = nullptr;
+        if (nwritten < 0) {
+            ScopedSpinLock lock(s_mm_lock);
+            m_dirty_pages.set(page_index, true);
+            result = KResult(nwritten);
+        }
+    }
+    return result;
+}
+
 }
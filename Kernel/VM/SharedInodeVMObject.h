@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Bitmap.h>
+#include <Kernel/KResult.h>
 #include <Kernel/UnixTypes.h>
 #include <Kernel/VM/InodeVMObject.h>
 
@@ -41,6 +42,11 @@ public:
     static NonnullRefPtr<SharedInodeVMObject> create_with_inode(Inode&);
     virtual NonnullRefPtr<VMObject> clone() override;
 
+    // Writes the modified pages in the given range back to the inode.
+    KResult write_back_dirty_pages(size_t first_page_index, size_t page_count);
+    KResult write_back_dirty_pages() { return write_back_dirty_pages(0, page_count()); }
+    bool has_dirty_pages() const { return m_dirty_pages.find_first_set().has_value(); }
+
 private:
     virtual bool is_shared_inode() const override { return true; }
 
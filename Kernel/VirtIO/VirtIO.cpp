@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/VirtIO/VirtIO.h>
+
+//#define VIRTIO_DEBUG
+
+namespace Kernel {
+
+// Legacy virtio PCI register layout, relative to BAR0.
+#define REG_DEVICE_FEATURES 0x00
+#define REG_GUEST_FEATURES 0x04
+#define REG_QUEUE_ADDRESS 0x08
+#define REG_QUEUE_SIZE 0x0c
+#define REG_QUEUE_SELECT 0x0e
+#define REG_QUEUE_NOTIFY 0x10
+#define REG_DEVICE_STATUS 0x12
+#define REG_ISR_STATUS 0x13
+// Without MSI-X, the device-specific configuration follows right after.
+#define REG_DEVICE_CONFIG 0x14
+
+VirtIODevice::VirtIODevice(PCI::Address address, const char* name)
+    : PCI::Device(address, PCI::get_interrupt_line(address))
+    , m_name(name)
+    , m_io_base(PCI::get_BAR0(address) & ~1)
+{
+    klog() << m_name << ": Found @ " << pci_address() << ", port base: " << m_io_base;
+    enable_bus_mastering(pci_address());
+}
+
+VirtIODevice::~VirtIODevice()
+{
+}
+
+void VirtIODevice::begin_initialization()
+{
+    m_io_base.offset(REG_DEVICE_STATUS).out<u8>(0);
+    m_io_base.offset(REG_DEVICE_STATUS).out<u8>(VIRTIO_STATUS_ACKNOWLEDGE);
+    m_io_base.offset(REG_DEVICE_STATUS).out<u8>(VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+}
+
+u32 VirtIODevice::negotiate_features(u32 supported)
+{
+    u32 device_features = m_io_base.offset(REG_DEVICE_FEATURES).in<u32>();
+    m_accepted_features = device_features & supported;
+    m_io_base.offset(REG_GUEST_FEATURES).out<u32>(m_accepted_features);
+#ifdef VIRTIO_DEBUG
+    klog() << m_name << ": Device features " << String::format("%x", device_features) << ", accepted " << String::format("%x", m_accepted_features);
+#endif
+    return m_accepted_features;
+}
+
+bool VirtIODevice::setup_queue(u16 queue_index)
+{
+    m_io_base.offset(REG_QUEUE_SELECT).out<u16>(queue_index);
+    u16 queue_size = m_io_base.offset(REG_QUEUE_SIZE).in<u16>();
+    if (!queue_size) {
+        klog() << m_name << ": Queue " << queue_index << " isn't available";
+        return false;
+    }
+
+    auto queue = make<VirtIOQueue>(queue_size);
+    if (queue->is_null()) {
+        klog() << m_name << ": Couldn't allocate queue " << queue_index;
+        return false;
+    }
+    m_io_base.offset(REG_QUEUE_ADDRESS).out<u32>(queue->physical_address().get() >> 12);
+#ifdef VIRTIO_DEBUG
+    klog() << m_name << ": Queue " << queue_index << " has " << queue_size << " descriptors @ " << queue->physical_address();
+#endif
+
+    while (m_queues.size() <= queue_index)
+        m_queues.append(nullptr);
+    m_queues[queue_index] = move(queue);
+    return true;
+}
+
+void VirtIODevice::finish_initialization()
+{
+    u8 status = m_io_base.offset(REG_DEVICE_STATUS).in<u8>();
+    m_io_base.offset(REG_DEVICE_STATUS).out<u8>(status | VIRTIO_STATUS_DRIVER_OK);
+}
+
+void VirtIODevice::fail_initialization()
+{
+    u8 status = m_io_base.offset(REG_DEVICE_STATUS).in<u8>();
+    m_io_base.offset(REG_DEVICE_STATUS).out<u8>(status | VIRTIO_STATUS_FAILED);
+}
+
+void VirtIODevice::notify_queue(u16 queue_index)
+{
+    m_io_base.offset(REG_QUEUE_NOTIFY).out<u16>(queue_index);
+}
+
+u8 VirtIODevice::read_isr_status()
+{
+    return m_io_base.offset(REG_ISR_STATUS).in<u8>();
+}
+
+u8 VirtIODevice::config_read8(u16 offset)
+{
+    return m_io_base.offset(REG_DEVICE_CONFIG + offset).in<u8>();
+}
+
+u16 VirtIODevice::config_read16(u16 offset)
+{
+    return m_io_base.offset(REG_DEVICE_CONFIG + offset).in<u16>();
+}
+
+u32 VirtIODevice::config_read32(u16 offset)
+{
+    return m_io_base.offset(REG_DEVICE_CONFIG + offset).in<u32>();
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/IO.h>
+#include <Kernel/PCI/Access.h>
+#include <Kernel/PCI/Device.h>
+#include <Kernel/VirtIO/VirtIOQueue.h>
+
+namespace Kernel {
+
+#define VIRTIO_PCI_VENDOR_ID 0x1af4
+
+#define VIRTIO_STATUS_ACKNOWLEDGE 1
+#define VIRTIO_STATUS_DRIVER 2
+#define VIRTIO_STATUS_DRIVER_OK 4
+#define VIRTIO_STATUS_FAILED 128
+
+#define VIRTIO_ISR_QUEUE_INTERRUPT 1
+#define VIRTIO_ISR_CONFIGURATION_CHANGE 2
+
+#define VIRTIO_F_NOTIFY_ON_EMPTY (1u << 24)
+#define VIRTIO_F_ANY_LAYOUT (1u << 27)
+
+// VirtIODevice: The legacy virtio PCI transport.
+//
+// This is the I/O port register interface in BAR0 that transitional devices (which is what
+// QEMU offers by default) expose. Drivers subclass it, negotiate their features, set up
+// their virtqueues and then tell the device they're ready with finish_initialization().
+
+class VirtIODevice : public PCI::Device {
+public:
+    virtual ~VirtIODevice() override;
+
+protected:
+    VirtIODevice(PCI::Address, const char* name);
+
+    const char* device_name() const { return m_name; }
+
+    // Resets the device and acknowledges that we've found it and have a driver for it.
+    void begin_initialization();
+    // Accepts the subset of `supported` that the device offers, and returns it.
+    u32 negotiate_features(u32 supported);
+    bool is_feature_accepted(u32 feature) const { return (m_accepted_features & feature) == feature; }
+    bool setup_queue(u16 queue_index);
+    void finish_initialization();
+    void fail_initialization();
+
+    VirtIOQueue& queue(u16 queue_index)
+    {
+        ASSERT(queue_index < m_queues.size() && m_queues[queue_index]);
+        return *m_queues[queue_index];
+    }
+    void notify_queue(u16 queue_index);
+
+    // Reading the ISR status also acknowledges the interrupt.
+    u8 read_isr_status();
+
+    u8 config_read8(u16 offset);
+    u16 config_read16(u16 offset);
+    u32 config_read32(u16 offset);
+
+private:
+    const char* m_name { nullptr };
+    IOAddress m_io_base;
+    Vector<OwnPtr<VirtIOQueue>> m_queues;
+    u32 m_accepted_features { 0 };
+};
+
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StringView.h>
+#include <Kernel/StdLib.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/PhysicalPage.h>
+#include <Kernel/VirtIO/VirtIOQueue.h>
+
+namespace Kernel {
+
+// The device reads the ring concurrently, so ring updates must reach memory in order.
+static inline void full_memory_barrier()
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+VirtIOQueue::VirtIOQueue(u16 queue_size)
+    : m_queue_size(queue_size)
+{
+    // The legacy transport places the used ring on the first page boundary after the
+    // descriptor table and the available ring.
+    size_t descriptors_size = sizeof(VirtIOQueueDescriptor) * queue_size;
+    size_t available_size = sizeof(u16) * (3 + queue_size);
+    size_t used_offset = PAGE_ROUND_UP(descriptors_size + available_size);
+    size_t used_size = sizeof(u16) * 3 + sizeof(VirtIOQueueUsedElement) * queue_size;
+
+    m_region = MM.allocate_contiguous_kernel_region(used_offset + PAGE_ROUND_UP(used_size), "VirtIO queue", Region::Access::Read | Region::Access::Write);
+    if (!m_region)
+        return;
+
+    auto* base = m_region->vaddr().as_ptr();
+    memset(base, 0, m_region->size());
+    m_descriptors = (VirtIOQueueDescriptor*)base;
+    m_available = (VirtIOQueueAvailable*)(base + descriptors_size);
+    m_used = (VirtIOQueueUsed*)(base + used_offset);
+
+    for (u16 i = 0; i + 1 < queue_size; ++i)
+        m_descriptors[i].next = i + 1;
+    m_free_head = 0;
+    m_free_descriptor_count = queue_size;
+}
+
+VirtIOQueue::~VirtIOQueue()
+{
+}
+
+PhysicalAddress VirtIOQueue::physical_address() const
+{
+    return m_region->physical_page(0)->paddr();
+}
+
+Optional<u16> VirtIOQueue::supply_buffer(const BufferSegment* segments, size_t count)
+{
+    ASSERT(count);
+    if (count > m_free_descriptor_count)
+        return {};
+
+    u16 head = m_free_head;
+    u16 descriptor_index = head;
+    for (size_t i = 0; i < count; ++i) {
+        auto& descriptor = m_descriptors[descriptor_index];
+        descriptor.address = segments[i].address.get();
+        descriptor.length = segments[i].length;
+        descriptor.flags = segments[i].device_writable ? VIRTQ_DESC_F_WRITE : 0;
+        if (i + 1 < count)
+            descriptor.flags |= VIRTQ_DESC_F_NEXT;
+        else
+            m_free_head = descriptor.next;
+        descriptor_index = descriptor.next;
+    }
+    m_free_descriptor_count -= count;
+
+    u16 available_index = m_available->index;
+    m_available->rings[available_index % m_queue_size] = head;
+    full_memory_barrier();
+    m_available->index = available_index + 1;
+    full_memory_barrier();
+    return head;
+}
+
+bool VirtIOQueue::has_used_buffers() const
+{
+    return *(volatile u16*)&m_used->index != m_last_used_index;
+}
+
+bool VirtIOQueue::take_used_buffer(u16& head, u32& written_length)
+{
+    if (!has_used_buffers())
+        return false;
+    full_memory_barrier();
+
+    auto& element = m_used->rings[m_last_used_index % m_queue_size];
+    head = element.index;
+    written_length = element.length;
+    ++m_last_used_index;
+
+    // Put the whole chain back on the free list.
+    u16 last = head;
+    size_t chain_length = 1;
+    while (m_descriptors[last].flags & VIRTQ_DESC_F_NEXT) {
+        last = m_descriptors[last].next;
+        ++chain_length;
+    }
+    m_descriptors[last].next = m_free_head;
+    m_free_head = head;
+    m_free_descriptor_count += chain_length;
+    return true;
+}
+
+bool VirtIOQueue::should_notify() const
+{
+    full_memory_barrier();
+    return !(*(volatile u16*)&m_used->flags & VIRTQ_USED_F_NO_NOTIFY);
+}
+
+void VirtIOQueue::enable_interrupts()
+{
+    m_available->flags = 0;
+    full_memory_barrier();
+}
+
+void VirtIOQueue::disable_interrupts()
+{
+    m_available->flags = VIRTQ_AVAIL_F_NO_INTERRUPT;
+}
+
+}
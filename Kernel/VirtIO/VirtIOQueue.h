@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Types.h>
+#include <Kernel/PhysicalAddress.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+#define VIRTQ_DESC_F_NEXT 1
+#define VIRTQ_DESC_F_WRITE 2
+
+#define VIRTQ_AVAIL_F_NO_INTERRUPT 1
+#define VIRTQ_USED_F_NO_NOTIFY 1
+
+struct [[gnu::packed]] VirtIOQueueDescriptor
+{
+    u64 address;
+    u32 length;
+    u16 flags;
+    u16 next;
+};
+
+struct [[gnu::packed]] VirtIOQueueAvailable
+{
+    u16 flags;
+    u16 index;
+    u16 rings[];
+};
+
+struct [[gnu::packed]] VirtIOQueueUsedElement
+{
+    u32 index;
+    u32 length;
+};
+
+struct [[gnu::packed]] VirtIOQueueUsed
+{
+    u16 flags;
+    u16 index;
+    VirtIOQueueUsedElement rings[];
+};
+
+// VirtIOQueue: A split virtqueue, laid out the way the legacy virtio transport expects.
+//
+// Drivers hand chains of buffers to the device with supply_buffer() and get them back,
+// identified by the index of their head descriptor, with take_used_buffer(). Callers are
+// expected to hold lock() around both, since a queue can be shared between processors.
+
+class VirtIOQueue {
+public:
+    struct BufferSegment {
+        PhysicalAddress address;
+        u32 length { 0 };
+        bool device_writable { false };
+    };
+
+    explicit VirtIOQueue(u16 queue_size);
+    ~VirtIOQueue();
+
+    bool is_null() const { return !m_region; }
+    u16 size() const { return m_queue_size; }
+    PhysicalAddress physical_address() const;
+    size_t free_descriptor_count() const { return m_free_descriptor_count; }
+
+    // Makes a chain of segments available to the device, returning the index of its head
+    // descriptor, or nothing if the queue doesn't have enough free descriptors.
+    Optional<u16> supply_buffer(const BufferSegment*, size_t count);
+
+    // Returns false once the device hasn't finished with any more buffers.
+    bool take_used_buffer(u16& head, u32& written_length);
+    bool has_used_buffers() const;
+
+    // Whether the device wants to be told about newly supplied buffers.
+    bool should_notify() const;
+
+    void enable_interrupts();
+    void disable_interrupts();
+
+    SpinLock<u8>& lock() { return m_lock; }
+
+private:
+    u16 m_queue_size { 0 };
+    u16 m_free_head { 0 };
+    u16 m_free_descriptor_count { 0 };
+    u16 m_last_used_index { 0 };
+
+    VirtIOQueueDescriptor* m_descriptors { nullptr };
+    VirtIOQueueAvailable* m_available { nullptr };
+    VirtIOQueueUsed* m_used { nullptr };
+
+    OwnPtr<Region> m_region;
+    SpinLock<u8> m_lock;
+};
+
+}
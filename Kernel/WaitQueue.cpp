@@ -53,6 +53,7 @@ bool WaitQueue::enqueue(Thread& thread)
         return false;
     }
     m_threads.append(thread);
+    thread.m_wait_queue = this;
     return true;
 }
 
@@ -91,7 +92,7 @@ void WaitQueue::wake_one(Atomic<bool>* lock)
     Scheduler::yield();
 }
 
-void WaitQueue::wake_n(u32 wake_count)
+u32 WaitQueue::wake_n(u32 wake_count, u32 bitset)
 {
     ScopedSpinLock queue_lock(m_lock);
     if (m_threads.is_empty()) {
@@ -100,23 +101,101 @@ void WaitQueue::wake_n(u32 wake_count)
 #ifdef WAITQUEUE_DEBUG
         dbg() << "WaitQueue " << VirtualAddress(this) << ": wake_n: nobody to wake, mark as pending";
 #endif
-        return;
+        return 0;
     }
 
 #ifdef WAITQUEUE_DEBUG
     dbg() << "WaitQueue " << VirtualAddress(this) << ": wake_n: " << wake_count;
 #endif
-    for (u32 i = 0; i < wake_count; ++i) {
-        Thread* thread = m_threads.take_first();
-        if (!thread)
-            break;
+    u32 woken_count = 0;
+    for (auto it = m_threads.begin(); it != m_threads.end() && woken_count < wake_count;) {
+        auto& thread = *it;
+        ++it;
+        if (!(thread.m_wait_bitset & bitset))
+            continue;
+        m_threads.remove(thread);
 #ifdef WAITQUEUE_DEBUG
-        dbg() << "WaitQueue " << VirtualAddress(this) << ": wake_n: wake thread " << *thread;
+        dbg() << "WaitQueue " << VirtualAddress(this) << ": wake_n: wake thread " << thread;
 #endif
-        thread->wake_from_queue();
+        thread.wake_from_queue();
+        ++woken_count;
     }
     m_wake_requested = false;
     Scheduler::yield();
+    return woken_count;
+}
+
+u32 WaitQueue::requeue(WaitQueue& other, u32 wake_count, u32 requeue_count, u32* requeued_count)
+{
+    if (requeued_count)
+        *requeued_count = 0;
+    if (&other == this)
+        return wake_n(wake_count);
+
+    // Thread::wait_on() looks at which queue a thread ended up on with the scheduler
+    // lock held, so moving it over needs it too.
+    ScopedSpinLock sched_lock(g_scheduler_lock);
+    WaitQueue* first = this < &other ? this : &other;
+    WaitQueue* second = this < &other ? &other : this;
+    ScopedSpinLock first_lock(first->m_lock);
+    ScopedSpinLock second_lock(second->m_lock);
+
+    u32 woken_count = 0;
+    while (woken_count < wake_count) {
+        auto* thread = m_threads.take_first();
+        if (!thread)
+            break;
+        thread->wake_from_queue();
+        ++woken_count;
+    }
+
+    u32 moved_count = 0;
+    while (moved_count < requeue_count) {
+        auto* thread = m_threads.take_first();
+        if (!thread)
+            break;
+        other.m_threads.append(*thread);
+        thread->m_wait_queue = &other;
+        ++moved_count;
+    }
+#ifdef WAITQUEUE_DEBUG
+    dbg() << "WaitQueue " << VirtualAddress(this) << ": requeue: woke " << woken_count << ", moved " << moved_count << " to " << VirtualAddress(&other);
+#endif
+    if (requeued_count)
+        *requeued_count = moved_count;
+    if (woken_count)
+        m_wake_requested = false;
+    return woken_count;
+}
+
+Thread* WaitQueue::wake_highest_priority()
+{
+    ScopedSpinLock queue_lock(m_lock);
+    Thread* best_thread = nullptr;
+    for (auto& thread : m_threads) {
+        if (!best_thread || thread.effective_priority() > best_thread->effective_priority())
+            best_thread = &thread;
+    }
+    if (!best_thread)
+        return nullptr;
+    m_threads.remove(*best_thread);
+    best_thread->wake_from_queue();
+    return best_thread;
+}
+
+u32 WaitQueue::highest_waiter_priority()
+{
+    ScopedSpinLock queue_lock(m_lock);
+    u32 priority = 0;
+    for (auto& thread : m_threads)
+        priority = max(priority, thread.effective_priority());
+    return priority;
+}
+
+bool WaitQueue::is_empty()
+{
+    ScopedSpinLock queue_lock(m_lock);
+    return m_threads.is_empty();
 }
 
 void WaitQueue::wake_all()
@@ -42,10 +42,19 @@ public:
     bool enqueue(Thread&);
     bool dequeue(Thread&);
     void wake_one(Atomic<bool>* lock = nullptr);
-    void wake_n(u32 wake_count);
+    // Only wakes threads whose wait bitset shares a bit with the given one; returns how many were woken.
+    u32 wake_n(u32 wake_count, u32 bitset = Thread::wait_bitset_match_any);
     void wake_all();
     void clear();
 
+    // Wakes up to wake_count threads, then moves up to requeue_count of the remaining ones
+    // over to the other queue without waking them. Returns the number of threads woken.
+    u32 requeue(WaitQueue& other, u32 wake_count, u32 requeue_count, u32* requeued_count = nullptr);
+
+    Thread* wake_highest_priority();
+    u32 highest_waiter_priority();
+    bool is_empty();
+
 private:
     typedef IntrusiveList<Thread, &Thread::m_wait_queue_node> ThreadList;
     ThreadList m_threads;
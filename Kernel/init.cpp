@@ -31,6 +31,8 @@
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/CMOS.h>
 #include <Kernel/CommandLine.h>
+#include <Kernel/Devices/AHCIController.h>
+#include <Kernel/Devices/AHCIDiskDevice.h>
 #include <Kernel/Devices/BXVGADevice.h>
 #include <Kernel/Devices/DiskPartition.h>
 #include <Kernel/Devices/EBRPartitionTable.h>
@@ -61,6 +63,7 @@
 #include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/RTL8139NetworkAdapter.h>
+#include <Kernel/Net/VirtIONetworkAdapter.h>
 #include <Kernel/PCI/Access.h>
 #include <Kernel/PCI/Initializer.h>
 #include <Kernel/Process.h>
@@ -69,7 +72,10 @@
 #include <Kernel/Scheduler.h>
 #include <Kernel/TTY/PTYMultiplexer.h>
 #include <Kernel/TTY/VirtualConsole.h>
+#include <Kernel/Tasks/BlockIOTask.h>
 #include <Kernel/Tasks/FinalizerTask.h>
+#include <Kernel/Tasks/IORingTask.h>
+#include <Kernel/Tasks/ReadAheadTask.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -213,6 +219,9 @@ void init_stage2()
 
     SyncTask::spawn();
     FinalizerTask::spawn();
+    BlockIOTask::spawn();
+    ReadAheadTask::spawn();
+    IORingTask::spawn();
 
     PCI::initialize();
 
@@ -244,6 +253,7 @@ void init_stage2()
 
     E1000NetworkAdapter::detect();
     RTL8139NetworkAdapter::detect();
+    VirtIONetworkAdapter::detect();
 
     LoopbackAdapter::the();
 
@@ -260,15 +270,30 @@ void init_stage2()
 
     auto root = kernel_command_line().lookup("root").value_or("/dev/hda");
 
-    if (!root.starts_with("/dev/hda")) {
-        klog() << "init_stage2: root filesystem must be on the first IDE hard drive (/dev/hda)";
+    auto pata0 = PATAChannel::create(PATAChannel::ChannelType::Primary, force_pio);
+    auto ahci = AHCIController::detect();
+
+    RefPtr<BlockDevice> root_disk;
+    StringView root_disk_name;
+    if (root.starts_with("/dev/hda")) {
+        root_disk_name = "/dev/hda";
+        root_disk = pata0->master_device();
+    } else if (root.starts_with("/dev/sda")) {
+        root_disk_name = "/dev/sda";
+        if (ahci && !ahci->disks().is_empty())
+            root_disk = ahci->disks().first();
+    } else {
+        klog() << "init_stage2: root filesystem must be on the first IDE hard drive (/dev/hda) or the first SATA disk (/dev/sda)";
         Processor::halt();
     }
 
-    auto pata0 = PATAChannel::create(PATAChannel::ChannelType::Primary, force_pio);
-    NonnullRefPtr<BlockDevice> root_dev = *pata0->master_device();
+    if (!root_disk) {
+        klog() << "init_stage2: couldn't find root disk " << root_disk_name;
+        Processor::halt();
+    }
+    NonnullRefPtr<BlockDevice> root_dev = *root_disk;
 
-    root = root.substring(strlen("/dev/hda"), root.length() - strlen("/dev/hda"));
+    root = root.substring(root_disk_name.length(), root.length() - root_disk_name.length());
 
     if (root.length()) {
         auto partition_number = root.to_uint();
@@ -88,31 +88,21 @@ struct Sample {
     double right;
 };
 
-// Small helper to resample from one playback rate to another
-// This isn't really "smart", in that we just insert (or drop) samples.
-// Should do better...
-class ResampleHelper {
-public:
-    ResampleHelper(double source, double target);
-
-    void process_sample(double sample_l, double sample_r);
-    bool read_sample(double& next_l, double& next_r);
-
-private:
-    const double m_ratio;
-    double m_current_ratio { 0 };
-    double m_last_sample_l { 0 };
-    double m_last_sample_r { 0 };
-};
+class Resampler;
 
 // A buffer of audio samples, normalized to 44100hz.
 class Buffer : public RefCounted<Buffer> {
 public:
-    static RefPtr<Buffer> from_pcm_data(ByteBuffer& data, ResampleHelper& resampler, int num_channels, int bits_per_sample);
+    static RefPtr<Buffer> from_pcm_data(ByteBuffer& data, Resampler& resampler, int num_channels, int bits_per_sample);
     static NonnullRefPtr<Buffer> create_with_samples(Vector<Sample>&& samples)
     {
         return adopt(*new Buffer(move(samples)));
     }
+    // An empty buffer that can be filled (and refilled) with up to sample_capacity samples.
+    static NonnullRefPtr<Buffer> create_with_capacity(int sample_capacity)
+    {
+        return adopt(*new Buffer(*SharedBuffer::create_with_size(sample_capacity * sizeof(Sample)), 0));
+    }
     static NonnullRefPtr<Buffer> create_with_shared_buffer(NonnullRefPtr<SharedBuffer>&& buffer, int sample_count)
     {
         return adopt(*new Buffer(move(buffer), sample_count));
@@ -120,11 +110,20 @@ public:
 
     const Sample* samples() const { return (const Sample*)data(); }
     int sample_count() const { return m_sample_count; }
+    int sample_capacity() const { return m_buffer->size() / (int)sizeof(Sample); }
     const void* data() const { return m_buffer->data(); }
     int size_in_bytes() const { return m_sample_count * (int)sizeof(Sample); }
     int shbuf_id() const { return m_buffer->shbuf_id(); }
     SharedBuffer& shared_buffer() { return *m_buffer; }
 
+    // Only for buffers the server is done with, or hasn't seen yet.
+    void set_samples(const Sample* samples, int count)
+    {
+        ASSERT(count <= sample_capacity());
+        memcpy(m_buffer->data(), samples, count * sizeof(Sample));
+        m_sample_count = count;
+    }
+
 private:
     explicit Buffer(Vector<Sample>&& samples)
         : m_buffer(*SharedBuffer::create_with_size(samples.size() * sizeof(Sample)))
@@ -140,7 +139,7 @@ private:
     }
 
     NonnullRefPtr<SharedBuffer> m_buffer;
-    const int m_sample_count;
+    int m_sample_count;
 };
 
 }
@@ -79,6 +79,16 @@ void ClientConnection::set_main_mix_volume(int volume)
     send_sync<Messages::AudioServer::SetMainMixVolume>(volume);
 }
 
+int ClientConnection::get_period_size()
+{
+    return send_sync<Messages::AudioServer::GetPeriodSize>()->frames();
+}
+
+int ClientConnection::set_period_size(int frames)
+{
+    return send_sync<Messages::AudioServer::SetPeriodSize>(frames)->frames();
+}
+
 int ClientConnection::get_remaining_samples()
 {
     return send_sync<Messages::AudioServer::GetRemainingSamples>()->remaining_samples();
@@ -104,6 +114,12 @@ int ClientConnection::get_playing_buffer()
     return send_sync<Messages::AudioServer::GetPlayingBuffer>()->buffer_id();
 }
 
+PlaybackStatistics ClientConnection::get_playback_statistics()
+{
+    auto response = send_sync<Messages::AudioServer::GetPlaybackStatistics>();
+    return { response->latency_in_samples(), response->underrun_count() };
+}
+
 void ClientConnection::handle(const Messages::AudioClient::FinishedPlayingBuffer& message)
 {
     if (on_finish_playing_buffer)
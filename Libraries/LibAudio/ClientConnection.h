@@ -34,6 +34,13 @@ namespace Audio {
 
 class Buffer;
 
+struct PlaybackStatistics {
+    // How long a sample enqueued now would take to reach the device.
+    int latency_in_samples { 0 };
+    // How often the queue ran dry while there was still more to come.
+    u32 underrun_count { 0 };
+};
+
 class ClientConnection : public IPC::ServerConnection<AudioClientEndpoint, AudioServerEndpoint>
     , public AudioClientEndpoint {
     C_OBJECT(ClientConnection)
@@ -50,9 +57,14 @@ public:
     int get_main_mix_volume();
     void set_main_mix_volume(int);
 
+    int get_period_size();
+    // Returns the period size the server settled on.
+    int set_period_size(int frames);
+
     int get_remaining_samples();
     int get_played_samples();
     int get_playing_buffer();
+    PlaybackStatistics get_playback_statistics();
 
     void set_paused(bool paused);
     void clear_buffer(bool paused = false);
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <LibAudio/Resampler.h>
+#include <math.h>
+
+namespace Audio {
+
+// The filter looks at this many input frames on either side of each output sample.
+static constexpr int half_taps = 8;
+static constexpr int taps = half_taps * 2;
+// The number of precomputed fractional positions between two input frames.
+static constexpr int phase_bits = 8;
+static constexpr int phases = 1 << phase_bits;
+// Keep the cutoff a little below Nyquist, so the filter has room to roll off in.
+static constexpr double passband = 0.95;
+
+static double blackman_window(double offset)
+{
+    return 0.42 + 0.5 * cos(M_PI * offset / half_taps) + 0.08 * cos(2 * M_PI * offset / half_taps);
+}
+
+Resampler::Resampler(u32 source_rate, u32 target_rate)
+    : m_source_rate(source_rate)
+    , m_target_rate(target_rate)
+{
+    ASSERT(source_rate && target_rate);
+    m_step = ((u64)source_rate << 32) / target_rate;
+
+    if (m_source_rate != m_target_rate) {
+        // When going down in rate, the cutoff has to come down with it to avoid aliasing.
+        double cutoff = passband * min(1.0, (double)target_rate / source_rate);
+        m_coefficients.resize((phases + 1) * taps);
+        for (int phase = 0; phase <= phases; ++phase) {
+            float* coefficients = &m_coefficients[phase * taps];
+            double sum = 0;
+            for (int tap = 0; tap < taps; ++tap) {
+                double offset = (tap - (half_taps - 1)) - (double)phase / phases;
+                double x = M_PI * cutoff * offset;
+                double value = x == 0 ? 1 : sin(x) / x;
+                value *= blackman_window(offset);
+                coefficients[tap] = value;
+                sum += value;
+            }
+            // Normalize every phase, so a constant signal stays exactly where it is.
+            for (int tap = 0; tap < taps; ++tap)
+                coefficients[tap] /= sum;
+        }
+    }
+
+    reset();
+}
+
+void Resampler::reset()
+{
+    // Pretend there was silence before the input, so the first output sample lines up with the first input frame.
+    m_history.clear_with_capacity();
+    for (int i = 0; i < (half_taps - 1) * 2; ++i)
+        m_history.append(0);
+    m_position = (u64)(half_taps - 1) << 32;
+    m_has_input = false;
+}
+
+template<typename Callback>
+void Resampler::process_impl(const Sample* input, size_t count, Callback emit)
+{
+    if (m_source_rate == m_target_rate) {
+        for (size_t i = 0; i < count; ++i)
+            emit(input[i].left, input[i].right);
+        return;
+    }
+
+    if (count)
+        m_has_input = true;
+    m_history.ensure_capacity(m_history.size() + count * 2);
+    for (size_t i = 0; i < count; ++i) {
+        m_history.unchecked_append(input[i].left);
+        m_history.unchecked_append(input[i].right);
+    }
+
+    size_t frames = m_history.size() / 2;
+    for (;;) {
+        size_t center = m_position >> 32;
+        if (center + half_taps >= frames)
+            break;
+
+        u32 fraction = (u32)m_position;
+        size_t phase = fraction >> (32 - phase_bits);
+        float interpolation = (float)(fraction & ((1u << (32 - phase_bits)) - 1)) / (1u << (32 - phase_bits));
+        const float* coefficients = &m_coefficients[phase * taps];
+        const float* next_coefficients = coefficients + taps;
+        const float* frame = &m_history[(center - (half_taps - 1)) * 2];
+
+        // Two plain dot products, which the compiler is free to vectorize.
+        float left = 0;
+        float right = 0;
+        float next_left = 0;
+        float next_right = 0;
+        for (int tap = 0; tap < taps; ++tap) {
+            left += frame[tap * 2] * coefficients[tap];
+            right += frame[tap * 2 + 1] * coefficients[tap];
+            next_left += frame[tap * 2] * next_coefficients[tap];
+            next_right += frame[tap * 2 + 1] * next_coefficients[tap];
+        }
+        emit(left + (next_left - left) * interpolation, right + (next_right - right) * interpolation);
+
+        m_position += m_step;
+    }
+
+    // Drop the frames that no future output sample reaches back to.
+    size_t center = m_position >> 32;
+    if (center >= (size_t)half_taps) {
+        size_t consumed = min(center - (half_taps - 1), frames);
+        size_t remaining = m_history.size() - consumed * 2;
+        __builtin_memmove(m_history.data(), m_history.data() + consumed * 2, remaining * sizeof(float));
+        m_history.shrink(remaining, true);
+        m_position -= (u64)consumed << 32;
+    }
+}
+
+template<typename Callback>
+void Resampler::flush_impl(Callback emit)
+{
+    if (m_has_input && m_source_rate != m_target_rate) {
+        Sample silence[half_taps];
+        process_impl(silence, half_taps, emit);
+    }
+    reset();
+}
+
+static void append_sample(Vector<Sample>& output, float left, float right)
+{
+    output.append(Sample(left, right));
+}
+
+static void append_sample(Vector<i16>& output, float left, float right)
+{
+    auto to_i16 = [](float value) -> i16 {
+        if (value >= 1)
+            return NumericLimits<i16>::max();
+        if (value <= -1)
+            return -NumericLimits<i16>::max();
+        return value * NumericLimits<i16>::max();
+    };
+    output.append(to_i16(left));
+    output.append(to_i16(right));
+}
+
+void Resampler::process(const Sample* input, size_t count, Vector<Sample>& output)
+{
+    output.ensure_capacity(output.size() + ((u64)count << 32) / m_step + 1);
+    process_impl(input, count, [&](float left, float right) { append_sample(output, left, right); });
+}
+
+void Resampler::process(const Sample* input, size_t count, Vector<i16>& output)
+{
+    output.ensure_capacity(output.size() + (((u64)count << 32) / m_step + 1) * 2);
+    process_impl(input, count, [&](float left, float right) { append_sample(output, left, right); });
+}
+
+void Resampler::flush(Vector<Sample>& output)
+{
+    flush_impl([&](float left, float right) { append_sample(output, left, right); });
+}
+
+void Resampler::flush(Vector<i16>& output)
+{
+    flush_impl([&](float left, float right) { append_sample(output, left, right); });
+}
+
+}
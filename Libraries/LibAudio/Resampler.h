@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <LibAudio/Buffer.h>
+
+namespace Audio {
+
+// Converts a stream of samples from one rate to another with a windowed-sinc filter.
+// Input can be fed in pieces of any size, and the filter state carries over between them,
+// so chunk boundaries don't produce clicks.
+class Resampler {
+public:
+    Resampler(u32 source_rate, u32 target_rate);
+
+    u32 source_rate() const { return m_source_rate; }
+    u32 target_rate() const { return m_target_rate; }
+
+    // Appends every output sample that the input so far allows for.
+    void process(const Sample* input, size_t count, Vector<Sample>& output);
+    // Same, but as interleaved, clipped 16-bit stereo, which is what the audio device takes.
+    void process(const Sample* input, size_t count, Vector<i16>& output);
+
+    // Appends what's left once there's no more input, and starts over.
+    void flush(Vector<Sample>& output);
+    void flush(Vector<i16>& output);
+
+    // Forgets about all input, e.g. after seeking.
+    void reset();
+
+private:
+    template<typename Callback>
+    void process_impl(const Sample* input, size_t count, Callback);
+    template<typename Callback>
+    void flush_impl(Callback);
+
+    const u32 m_source_rate;
+    const u32 m_target_rate;
+
+    // How far one output sample advances in the input, in 32.32 fixed point.
+    u64 m_step { 0 };
+    // The input position of the next output sample, relative to the start of m_history.
+    u64 m_position { 0 };
+
+    // Interleaved stereo input, starting with the frames still needed by the filter.
+    Vector<float> m_history;
+    bool m_has_input { false };
+
+    // One set of taps for each fractional position, with one extra to interpolate towards.
+    Vector<float> m_coefficients;
+};
+
+}
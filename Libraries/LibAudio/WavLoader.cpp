@@ -27,9 +27,11 @@
 #include <AK/BufferStream.h>
 #include <AK/NumericLimits.h>
 #include <AK/OwnPtr.h>
+#include <LibAudio/Resampler.h>
 #include <LibAudio/WavLoader.h>
 #include <LibCore/File.h>
 #include <LibCore/IODeviceStreamReader.h>
+#include <unistd.h>
 
 namespace Audio {
 
@@ -44,33 +46,75 @@ WavLoader::WavLoader(const StringView& path)
     if (!parse_header())
         return;
 
-    m_resampler = make<ResampleHelper>(m_sample_rate, 44100);
+    m_resampler = make<Resampler>(m_sample_rate, 44100);
 }
 
+static void decode_pcm_data(ByteBuffer& data, int num_channels, int bits_per_sample, Vector<Sample>& samples);
+
 RefPtr<Buffer> WavLoader::get_more_samples(size_t max_bytes_to_read_from_input)
 {
 #ifdef AWAVLOADER_DEBUG
     dbgprintf("Read WAV of format PCM with num_channels %u sample rate %u, bits per sample %u\n", m_num_channels, m_sample_rate, m_bits_per_sample);
 #endif
 
-    auto raw_samples = m_file->read(max_bytes_to_read_from_input);
-    if (raw_samples.is_empty())
-        return nullptr;
+    int bytes_per_frame = m_num_channels * (m_bits_per_sample / 8);
+    int frames_to_read = min<i64>(max_bytes_to_read_from_input / bytes_per_frame, m_total_samples - m_loaded_samples);
+    int frames_read = 0;
+    if (frames_to_read > 0) {
+        size_t bytes_to_read = frames_to_read * bytes_per_frame;
+        if (m_raw_buffer.size() < bytes_to_read)
+            m_raw_buffer = ByteBuffer::create_uninitialized(bytes_to_read);
+        // The header was parsed through m_file's read buffer, but seek() threw that away.
+        ssize_t nread = ::read(m_file->fd(), m_raw_buffer.data(), bytes_to_read);
+        if (nread > 0)
+            frames_read = nread / bytes_per_frame;
+    }
+
+    m_resampled_samples.clear_with_capacity();
+    if (frames_read) {
+        auto raw_samples = ByteBuffer::wrap(m_raw_buffer.data(), frames_read * bytes_per_frame);
+        m_decoded_samples.clear_with_capacity();
+        decode_pcm_data(raw_samples, m_num_channels, m_bits_per_sample, m_decoded_samples);
+        m_resampler->process(m_decoded_samples.data(), m_decoded_samples.size(), m_resampled_samples);
+        m_loaded_samples += frames_read;
+    } else {
+        // The resampler still holds on to the last few frames.
+        m_resampler->flush(m_resampled_samples);
+        if (m_resampled_samples.is_empty())
+            return nullptr;
+    }
 
-    auto buffer = Buffer::from_pcm_data(raw_samples, *m_resampler, m_num_channels, m_bits_per_sample);
-    //Buffer contains normalized samples, but m_loaded_samples should containt the ammount of actually loaded samples
-    m_loaded_samples += static_cast<int>(max_bytes_to_read_from_input) / (m_num_channels * (m_bits_per_sample / 8));
-    m_loaded_samples = min(m_total_samples, m_loaded_samples);
+    RefPtr<Buffer> buffer;
+    while (!m_spare_buffers.is_empty()) {
+        auto spare = m_spare_buffers.take_last();
+        if (spare->sample_capacity() >= (int)m_resampled_samples.size()) {
+            buffer = move(spare);
+            break;
+        }
+    }
+    if (!buffer) {
+        // Size new buffers for a whole block, so that they can take any block that comes later.
+        size_t block_frames = max_bytes_to_read_from_input / bytes_per_frame;
+        int capacity = ((u64)block_frames * 44100) / m_sample_rate + 16;
+        buffer = Buffer::create_with_capacity(max(capacity, (int)m_resampled_samples.size()));
+    }
+    buffer->set_samples(m_resampled_samples.data(), m_resampled_samples.size());
     return buffer;
 }
 
+void WavLoader::recycle_buffer(NonnullRefPtr<Buffer> buffer)
+{
+    m_spare_buffers.append(move(buffer));
+}
+
 void WavLoader::seek(const int position)
 {
     if (position < 0 || position > m_total_samples)
         return;
 
     m_loaded_samples = position;
-    m_file->seek(position * m_num_channels * (m_bits_per_sample / 8));
+    m_resampler->reset();
+    m_file->seek(m_data_offset + (size_t)position * m_num_channels * (m_bits_per_sample / 8));
 }
 
 void WavLoader::reset()
@@ -191,65 +235,31 @@ bool WavLoader::parse_header()
     // Just make sure we're good before we read the data...
     ASSERT(!stream.handle_read_failure());
 
+    m_data_offset = stream.offset();
+    // Samples are read straight from the file descriptor from here on.
+    m_file->seek(m_data_offset);
     return true;
 }
 
-ResampleHelper::ResampleHelper(double source, double target)
-    : m_ratio(source / target)
-{
-}
-
-void ResampleHelper::process_sample(double sample_l, double sample_r)
-{
-    m_last_sample_l = sample_l;
-    m_last_sample_r = sample_r;
-    m_current_ratio += 1;
-}
-
-bool ResampleHelper::read_sample(double& next_l, double& next_r)
-{
-    if (m_current_ratio > 0) {
-        m_current_ratio -= m_ratio;
-        next_l = m_last_sample_l;
-        next_r = m_last_sample_r;
-        return true;
-    }
-
-    return false;
-}
-
 template<typename SampleReader>
-static void read_samples_from_stream(BufferStream& stream, SampleReader read_sample, Vector<Sample>& samples, ResampleHelper& resampler, int num_channels)
+static void read_samples_from_stream(BufferStream& stream, SampleReader read_sample, Vector<Sample>& samples, int num_channels)
 {
-    double norm_l = 0;
-    double norm_r = 0;
-
     switch (num_channels) {
     case 1:
         for (;;) {
-            while (resampler.read_sample(norm_l, norm_r)) {
-                samples.append(Sample(norm_l));
-            }
-            norm_l = read_sample(stream);
-
-            if (stream.handle_read_failure()) {
+            double sample = read_sample(stream);
+            if (stream.handle_read_failure())
                 break;
-            }
-            resampler.process_sample(norm_l, norm_r);
+            samples.append(Sample(sample));
         }
         break;
     case 2:
         for (;;) {
-            while (resampler.read_sample(norm_l, norm_r)) {
-                samples.append(Sample(norm_l, norm_r));
-            }
-            norm_l = read_sample(stream);
-            norm_r = read_sample(stream);
-
-            if (stream.handle_read_failure()) {
+            double left = read_sample(stream);
+            double right = read_sample(stream);
+            if (stream.handle_read_failure())
                 break;
-            }
-            resampler.process_sample(norm_l, norm_r);
+            samples.append(Sample(left, right));
         }
         break;
     default:
@@ -291,24 +301,23 @@ static double read_norm_sample_8(BufferStream& stream)
 // ### can't const this because BufferStream is non-const
 // perhaps we need a reading class separate from the writing one, that can be
 // entirely consted.
-RefPtr<Buffer> Buffer::from_pcm_data(ByteBuffer& data, ResampleHelper& resampler, int num_channels, int bits_per_sample)
+static void decode_pcm_data(ByteBuffer& data, int num_channels, int bits_per_sample, Vector<Sample>& fdata)
 {
     BufferStream stream(data);
-    Vector<Sample> fdata;
-    fdata.ensure_capacity(data.size() / (bits_per_sample / 8));
+    fdata.ensure_capacity(fdata.size() + data.size() / (bits_per_sample / 8) / num_channels);
 #ifdef AWAVLOADER_DEBUG
     dbg() << "Reading " << bits_per_sample << " bits and " << num_channels << " channels, total bytes: " << data.size();
 #endif
 
     switch (bits_per_sample) {
     case 8:
-        read_samples_from_stream(stream, read_norm_sample_8, fdata, resampler, num_channels);
+        read_samples_from_stream(stream, read_norm_sample_8, fdata, num_channels);
         break;
     case 16:
-        read_samples_from_stream(stream, read_norm_sample_16, fdata, resampler, num_channels);
+        read_samples_from_stream(stream, read_norm_sample_16, fdata, num_channels);
         break;
     case 24:
-        read_samples_from_stream(stream, read_norm_sample_24, fdata, resampler, num_channels);
+        read_samples_from_stream(stream, read_norm_sample_24, fdata, num_channels);
         break;
     default:
         ASSERT_NOT_REACHED();
@@ -318,8 +327,16 @@ RefPtr<Buffer> Buffer::from_pcm_data(ByteBuffer& data, ResampleHelper& resampler
     // just make sure we're good. Worst case we just write some 0s where they
     // don't belong.
     ASSERT(!stream.handle_read_failure());
+}
+
+RefPtr<Buffer> Buffer::from_pcm_data(ByteBuffer& data, Resampler& resampler, int num_channels, int bits_per_sample)
+{
+    Vector<Sample> fdata;
+    decode_pcm_data(data, num_channels, bits_per_sample, fdata);
 
-    return Buffer::create_with_samples(move(fdata));
+    Vector<Sample> resampled;
+    resampler.process(fdata.data(), fdata.size(), resampled);
+    return Buffer::create_with_samples(move(resampled));
 }
 
 }
@@ -31,12 +31,13 @@
 #include <AK/String.h>
 #include <AK/StringView.h>
 #include <LibAudio/Buffer.h>
+#include <LibAudio/Resampler.h>
 #include <LibCore/File.h>
 
 namespace Audio {
 class Buffer;
 
-// Parses a WAV file and produces an Audio::Buffer.
+// Parses a WAV file and streams it out as Audio::Buffers, one block at a time.
 class WavLoader {
 public:
     explicit WavLoader(const StringView& path);
@@ -46,6 +47,9 @@ public:
 
     RefPtr<Buffer> get_more_samples(size_t max_bytes_to_read_from_input = 128 * KiB);
 
+    // Hands back a buffer the server has finished playing, for get_more_samples() to fill again.
+    void recycle_buffer(NonnullRefPtr<Buffer>);
+
     void reset();
     void seek(const int position);
 
@@ -60,7 +64,16 @@ private:
     bool parse_header();
     RefPtr<Core::File> m_file;
     String m_error_string;
-    OwnPtr<ResampleHelper> m_resampler;
+    OwnPtr<Resampler> m_resampler;
+
+    // Where the samples start in the file.
+    size_t m_data_offset { 0 };
+
+    // Kept around between blocks so that streaming doesn't allocate.
+    ByteBuffer m_raw_buffer;
+    Vector<Sample> m_decoded_samples;
+    Vector<Sample> m_resampled_samples;
+    Vector<NonnullRefPtr<Buffer>> m_spare_buffers;
 
     u32 m_sample_rate { 0 };
     u16 m_num_channels { 0 };
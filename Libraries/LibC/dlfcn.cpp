@@ -37,6 +37,7 @@
 #include <AK/RefPtr.h>
 #include <AK/ScopeGuard.h>
 #include <AK/String.h>
+#include <AK/Vector.h>
 #include <AK/StringBuilder.h>
 #include <LibELF/DynamicLoader.h>
 
@@ -44,6 +45,11 @@
 String g_dlerror_msg;
 
 HashMap<String, RefPtr<ELF::DynamicLoader>> g_elf_objects;
+// The same objects in the order they were loaded, which is the order symbols are searched in.
+Vector<ELF::DynamicLoader*> g_elf_objects_in_load_order;
+// Symbols that dlsym() with RTLD_DEFAULT has already found. Loading another object never
+// changes where an existing symbol resolves to, so these stay valid; misses aren't cached.
+HashMap<String, void*> g_resolved_symbols;
 
 extern "C" {
 
@@ -105,6 +111,7 @@ void* dlopen(const char* filename, int flags)
         return nullptr;
     }
 
+    g_elf_objects_in_load_order.append(loader.ptr());
     g_elf_objects.set(basename, move(loader));
     g_dlerror_msg = "Successfully loaded ELF object.";
 
@@ -112,12 +119,31 @@ void* dlopen(const char* filename, int flags)
     return const_cast<ELF::DynamicLoader*>(g_elf_objects.get(basename).value());
 }
 
+static void* lookup_symbol_in_all_objects(const char* symbol_name)
+{
+    // FIXME: This should search the main executable first.
+    auto cached_symbol = g_resolved_symbols.get(symbol_name);
+    if (cached_symbol.has_value())
+        return cached_symbol.value();
+
+    for (auto* dso : g_elf_objects_in_load_order) {
+        if (void* symbol = dso->symbol_for_name(symbol_name)) {
+            g_resolved_symbols.set(symbol_name, symbol);
+            return symbol;
+        }
+    }
+    return nullptr;
+}
+
 void* dlsym(void* handle, const char* symbol_name)
 {
-    // FIXME: When called with a NULL handle we're supposed to search every dso in the process... that'll get expensive
-    ASSERT(handle);
-    auto* dso = reinterpret_cast<ELF::DynamicLoader*>(handle);
-    void* symbol = dso->symbol_for_name(symbol_name);
+    void* symbol = nullptr;
+    if (handle == RTLD_DEFAULT) {
+        symbol = lookup_symbol_in_all_objects(symbol_name);
+    } else {
+        auto* dso = reinterpret_cast<ELF::DynamicLoader*>(handle);
+        symbol = dso->symbol_for_name(symbol_name);
+    }
     if (!symbol) {
         g_dlerror_msg = "Symbol not found";
         return nullptr;
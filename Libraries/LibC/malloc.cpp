@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Checked.h>
 #include <AK/InlineLinkedList.h>
 #include <AK/LogStream.h>
 #include <AK/ScopedValueRollback.h>
@@ -38,8 +39,6 @@
 #include <sys/internals.h>
 #include <sys/mman.h>
 
-// FIXME: Thread safety.
-
 //#define MALLOC_DEBUG
 #define RECYCLE_BIG_ALLOCATIONS
 
@@ -65,6 +64,8 @@ static LibThread::Lock& malloc_lock()
 
 constexpr size_t number_of_chunked_blocks_to_keep_around_per_size_class = 4;
 constexpr size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
+constexpr size_t largest_recycled_big_allocation = 4 * MiB;
+constexpr size_t max_recycled_big_allocation_bytes = 16 * MiB;
 
 static bool s_log_malloc = false;
 static bool s_scrub_malloc = true;
@@ -89,10 +90,14 @@ struct MallocStats {
 
     size_t number_of_big_allocator_keeps;
     size_t number_of_big_allocator_frees;
+    size_t number_of_big_allocations_grown_in_place;
 
     size_t number_of_freed_full_blocks;
     size_t number_of_keeps;
     size_t number_of_frees;
+
+    size_t number_of_thread_cache_refills;
+    size_t number_of_thread_cache_flushes;
 };
 static MallocStats g_malloc_stats = {};
 
@@ -110,7 +115,10 @@ struct BigAllocationBlock : public CommonHeader {
         m_magic = MAGIC_BIGALLOC_HEADER;
         m_size = size;
     }
-    unsigned char* m_slot[0];
+    // Set once realloc() has grown the block by mapping more memory right after it.
+    // Such a block spans several regions and can't be marked volatile in one go.
+    bool m_is_extended { false };
+    [[gnu::aligned(16)]] unsigned char m_slot[0];
 };
 
 struct FreelistEntry {
@@ -163,6 +171,7 @@ struct Allocator {
 };
 
 struct BigAllocator {
+    size_t size { 0 };
     Vector<BigAllocationBlock*, number_of_big_blocks_to_keep_around_per_size_class> blocks;
 };
 
@@ -173,16 +182,31 @@ struct BigAllocator {
 // them. We could have used AK::NeverDestoyed to prevent the latter,
 // but it would have not helped with the former.
 static u8 g_allocators_storage[sizeof(Allocator) * num_size_classes];
-static u8 g_big_allocators_storage[sizeof(BigAllocator)];
+// One bucket per mapping size that big_allocation_size() can produce, up to largest_recycled_big_allocation.
+constexpr size_t num_big_size_classes = 20;
+static u8 g_big_allocators_storage[sizeof(BigAllocator) * num_big_size_classes];
+static size_t s_recycled_big_allocation_bytes = 0;
 
 static inline Allocator (&allocators())[num_size_classes]
 {
     return reinterpret_cast<Allocator(&)[num_size_classes]>(g_allocators_storage);
 }
 
-static inline BigAllocator (&big_allocators())[1]
+static inline BigAllocator (&big_allocators())[num_big_size_classes]
+{
+    return reinterpret_cast<BigAllocator(&)[num_big_size_classes]>(g_big_allocators_storage);
+}
+
+// Big allocations are mapped in steps of a quarter of a power of two (but at least block_size).
+// This keeps the number of distinct mapping sizes small enough to recycle them, wastes at most
+// a quarter of the mapping, and leaves room for realloc() to grow into without moving.
+static size_t big_allocation_size(size_t needed)
 {
-    return reinterpret_cast<BigAllocator(&)[1]>(g_big_allocators_storage);
+    if (needed <= block_size)
+        return block_size;
+    size_t power_of_two = (size_t)1 << (31 - __builtin_clz(needed - 1));
+    size_t step = max(power_of_two / 4, block_size);
+    return (needed + step - 1) & ~(step - 1);
 }
 
 static Allocator* allocator_for_size(size_t size, size_t& good_size)
@@ -197,11 +221,44 @@ static Allocator* allocator_for_size(size_t size, size_t& good_size)
     return nullptr;
 }
 
+// Each thread keeps a few free chunks of every small size class to itself, so that most
+// malloc() and free() calls don't have to take the global lock. Chunks move between a thread
+// and the global allocators in batches of half a cache.
+constexpr size_t number_of_thread_cached_size_classes = 8; // Up to 1016 bytes.
+constexpr size_t thread_cache_bytes_per_size_class = 8 * KiB;
+
+static inline size_t thread_cache_capacity(size_t size_class_index)
+{
+    return clamp<size_t>(thread_cache_bytes_per_size_class / size_classes[size_class_index], 4, 64);
+}
+
+struct ThreadCache {
+    struct Bin {
+        FreelistEntry* head;
+        size_t count;
+    };
+    Bin bins[number_of_thread_cached_size_classes];
+
+    // Folded into g_malloc_stats whenever this thread takes the global lock anyway.
+    size_t number_of_malloc_calls;
+    size_t number_of_free_calls;
+};
+
+static bool s_use_thread_cache = true;
+static __thread ThreadCache t_thread_cache;
+
+static inline size_t size_class_index(const Allocator& allocator)
+{
+    return &allocator - &allocators()[0];
+}
+
 #ifdef RECYCLE_BIG_ALLOCATIONS
 static BigAllocator* big_allocator_for_size(size_t size)
 {
-    if (size == 65536)
-        return &big_allocators()[0];
+    for (auto& allocator : big_allocators()) {
+        if (allocator.size == size)
+            return &allocator;
+    }
     return nullptr;
 }
 #endif
@@ -221,65 +278,19 @@ static void os_free(void* ptr, size_t size)
     assert(rc == 0);
 }
 
-static void* malloc_impl(size_t size)
+// Takes one chunk from the global allocator. Must be called with the malloc lock held.
+static void* allocate_chunk(Allocator& allocator, size_t good_size)
 {
-    LOCKER(malloc_lock());
-
-    if (s_log_malloc)
-        dbgprintf("LibC: malloc(%zu)\n", size);
-
-    if (!size)
-        return nullptr;
-
-    g_malloc_stats.number_of_malloc_calls++;
-
-    size_t good_size;
-    auto* allocator = allocator_for_size(size, good_size);
-
-    if (!allocator) {
-        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, block_size);
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(real_size)) {
-            if (!allocator->blocks.is_empty()) {
-                g_malloc_stats.number_of_big_allocator_hits++;
-                auto* block = allocator->blocks.take_last();
-                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
-                bool this_block_was_purged = rc == 1;
-                if (rc < 0) {
-                    perror("madvise");
-                    ASSERT_NOT_REACHED();
-                }
-                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
-                    perror("mprotect");
-                    ASSERT_NOT_REACHED();
-                }
-                if (this_block_was_purged) {
-                    g_malloc_stats.number_of_big_allocator_purge_hits++;
-                    new (block) BigAllocationBlock(real_size);
-                }
-
-                ue_notify_malloc(&block->m_slot[0], size);
-                return &block->m_slot[0];
-            }
-        }
-#endif
-        g_malloc_stats.number_of_big_allocs++;
-        auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
-        new (block) BigAllocationBlock(real_size);
-        ue_notify_malloc(&block->m_slot[0], size);
-        return &block->m_slot[0];
-    }
-
     ChunkedBlock* block = nullptr;
 
-    for (block = allocator->usable_blocks.head(); block; block = block->next()) {
+    for (block = allocator.usable_blocks.head(); block; block = block->next()) {
         if (block->free_chunks())
             break;
     }
 
-    if (!block && allocator->empty_block_count) {
+    if (!block && allocator.empty_block_count) {
         g_malloc_stats.number_of_empty_block_hits++;
-        block = allocator->empty_blocks[--allocator->empty_block_count];
+        block = allocator.empty_blocks[--allocator.empty_block_count];
         int rc = madvise(block, block_size, MADV_SET_NONVOLATILE);
         bool this_block_was_purged = rc == 1;
         if (rc < 0) {
@@ -295,7 +306,7 @@ static void* malloc_impl(size_t size)
             g_malloc_stats.number_of_empty_block_purge_hits++;
             new (block) ChunkedBlock(good_size);
         }
-        allocator->usable_blocks.append(block);
+        allocator.usable_blocks.append(block);
     }
 
     if (!block) {
@@ -304,8 +315,8 @@ static void* malloc_impl(size_t size)
         snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
         block = (ChunkedBlock*)os_alloc(block_size, buffer);
         new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(block);
-        ++allocator->block_count;
+        allocator.usable_blocks.append(block);
+        ++allocator.block_count;
     }
 
     --block->m_free_chunks;
@@ -316,15 +327,162 @@ static void* malloc_impl(size_t size)
 #ifdef MALLOC_DEBUG
         dbgprintf("Block %p is now full in size class %zu\n", block, good_size);
 #endif
-        allocator->usable_blocks.remove(block);
-        allocator->full_blocks.append(block);
+        allocator.usable_blocks.remove(block);
+        allocator.full_blocks.append(block);
     }
 #ifdef MALLOC_DEBUG
     dbgprintf("LibC: allocated %p (chunk in block %p, size %zu)\n", ptr, block, block->bytes_per_chunk());
 #endif
+    return ptr;
+}
+
+// Returns one chunk to its block. Must be called with the malloc lock held.
+static void free_chunk(ChunkedBlock* block, void* ptr)
+{
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block->m_freelist;
+    block->m_freelist = entry;
+
+    if (block->is_full()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+#ifdef MALLOC_DEBUG
+        dbgprintf("Block %p no longer full in size class %u\n", block, good_size);
+#endif
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator->full_blocks.remove(block);
+        allocator->usable_blocks.prepend(block);
+    }
+
+    ++block->m_free_chunks;
+
+    if (!block->used_chunks()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        if (allocator->block_count < number_of_chunked_blocks_to_keep_around_per_size_class) {
+#ifdef MALLOC_DEBUG
+            dbgprintf("Keeping block %p around for size class %u\n", block, good_size);
+#endif
+            g_malloc_stats.number_of_keeps++;
+            allocator->usable_blocks.remove(block);
+            allocator->empty_blocks[allocator->empty_block_count++] = block;
+            mprotect(block, block_size, PROT_NONE);
+            madvise(block, block_size, MADV_SET_VOLATILE);
+            return;
+        }
+#ifdef MALLOC_DEBUG
+        dbgprintf("Releasing block %p for size class %u\n", block, good_size);
+#endif
+        g_malloc_stats.number_of_frees++;
+        allocator->usable_blocks.remove(block);
+        --allocator->block_count;
+        os_free(block, block_size);
+    }
+}
+
+// Must be called with the malloc lock held.
+static void fold_thread_cache_stats()
+{
+    g_malloc_stats.number_of_malloc_calls += exchange(t_thread_cache.number_of_malloc_calls, 0);
+    g_malloc_stats.number_of_free_calls += exchange(t_thread_cache.number_of_free_calls, 0);
+}
+
+static void refill_thread_cache(Allocator& allocator, size_t good_size)
+{
+    auto& bin = t_thread_cache.bins[size_class_index(allocator)];
+    size_t batch = thread_cache_capacity(size_class_index(allocator)) / 2;
+
+    LOCKER(malloc_lock());
+    g_malloc_stats.number_of_thread_cache_refills++;
+    fold_thread_cache_stats();
+    for (size_t i = 0; i < batch; ++i) {
+        auto* entry = (FreelistEntry*)allocate_chunk(allocator, good_size);
+        entry->next = bin.head;
+        bin.head = entry;
+        ++bin.count;
+    }
+}
+
+static void flush_thread_cache_bin(ThreadCache::Bin& bin, size_t count)
+{
+    // Called with the malloc lock held.
+    g_malloc_stats.number_of_thread_cache_flushes++;
+    for (; count && bin.head; --count) {
+        auto* entry = bin.head;
+        bin.head = entry->next;
+        --bin.count;
+        free_chunk((ChunkedBlock*)((FlatPtr)entry & block_mask), entry);
+    }
+}
+
+static void* malloc_impl(size_t size)
+{
+    if (s_log_malloc)
+        dbgprintf("LibC: malloc(%zu)\n", size);
+
+    if (!size)
+        return nullptr;
+
+    size_t good_size;
+    auto* allocator = allocator_for_size(size, good_size);
+
+    if (allocator && s_use_thread_cache && size_class_index(*allocator) < number_of_thread_cached_size_classes) {
+        auto& bin = t_thread_cache.bins[size_class_index(*allocator)];
+        if (!bin.head)
+            refill_thread_cache(*allocator, good_size);
+        auto* entry = bin.head;
+        bin.head = entry->next;
+        --bin.count;
+        t_thread_cache.number_of_malloc_calls++;
+        if (s_scrub_malloc)
+            memset(entry, MALLOC_SCRUB_BYTE, good_size);
+        ue_notify_malloc(entry, size);
+        return entry;
+    }
+
+    LOCKER(malloc_lock());
+
+    g_malloc_stats.number_of_malloc_calls++;
+
+    if (!allocator) {
+        size_t real_size = big_allocation_size(sizeof(BigAllocationBlock) + size);
+#ifdef RECYCLE_BIG_ALLOCATIONS
+        if (auto* allocator = big_allocator_for_size(real_size)) {
+            if (!allocator->blocks.is_empty()) {
+                g_malloc_stats.number_of_big_allocator_hits++;
+                auto* block = allocator->blocks.take_last();
+                s_recycled_big_allocation_bytes -= real_size;
+                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
+                bool this_block_was_purged = rc == 1;
+                if (rc < 0) {
+                    perror("madvise");
+                    ASSERT_NOT_REACHED();
+                }
+                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
+                    perror("mprotect");
+                    ASSERT_NOT_REACHED();
+                }
+                if (this_block_was_purged) {
+                    g_malloc_stats.number_of_big_allocator_purge_hits++;
+                    new (block) BigAllocationBlock(real_size);
+                }
+
+                ue_notify_malloc(&block->m_slot[0], size);
+                return &block->m_slot[0];
+            }
+        }
+#endif
+        g_malloc_stats.number_of_big_allocs++;
+        auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
+        new (block) BigAllocationBlock(real_size);
+        ue_notify_malloc(&block->m_slot[0], size);
+        return &block->m_slot[0];
+    }
+
+    void* ptr = allocate_chunk(*allocator, good_size);
 
     if (s_scrub_malloc)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
     ue_notify_malloc(ptr, size);
     return ptr;
@@ -337,20 +495,47 @@ static void free_impl(void* ptr)
     if (!ptr)
         return;
 
-    g_malloc_stats.number_of_free_calls++;
+    void* block_base = (void*)((FlatPtr)ptr & block_mask);
+    size_t magic = *(size_t*)block_base;
+
+    if (magic == MAGIC_PAGE_HEADER && s_use_thread_cache) {
+        auto* block = (ChunkedBlock*)block_base;
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        size_t index = size_class_index(*allocator);
+        if (index < number_of_thread_cached_size_classes) {
+            if (s_scrub_free)
+                memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+            auto& bin = t_thread_cache.bins[index];
+            auto* entry = (FreelistEntry*)ptr;
+            entry->next = bin.head;
+            bin.head = entry;
+            ++bin.count;
+            t_thread_cache.number_of_free_calls++;
+            if (bin.count > thread_cache_capacity(index)) {
+                LOCKER(malloc_lock());
+                fold_thread_cache_stats();
+                flush_thread_cache_bin(bin, thread_cache_capacity(index) / 2);
+            }
+            return;
+        }
+    }
 
     LOCKER(malloc_lock());
 
-    void* block_base = (void*)((FlatPtr)ptr & block_mask);
-    size_t magic = *(size_t*)block_base;
+    g_malloc_stats.number_of_free_calls++;
 
     if (magic == MAGIC_BIGALLOC_HEADER) {
         auto* block = (BigAllocationBlock*)block_base;
 #ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(block->m_size)) {
+        // Rather than unmapping the block, keep it around (volatile, so the kernel may
+        // reclaim its pages under memory pressure) for the next allocation of this size.
+        auto* allocator = block->m_is_extended ? nullptr : big_allocator_for_size(block->m_size);
+        if (allocator && s_recycled_big_allocation_bytes + block->m_size <= max_recycled_big_allocation_bytes) {
             if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
                 g_malloc_stats.number_of_big_allocator_keeps++;
                 allocator->blocks.append(block);
+                s_recycled_big_allocation_bytes += block->m_size;
                 size_t this_block_size = block->m_size;
                 if (mprotect(block, this_block_size, PROT_NONE) < 0) {
                     perror("mprotect");
@@ -379,45 +564,17 @@ static void free_impl(void* ptr)
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
-
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-#ifdef MALLOC_DEBUG
-        dbgprintf("Block %p no longer full in size class %u\n", block, good_size);
-#endif
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(block);
-        allocator->usable_blocks.prepend(block);
-    }
-
-    ++block->m_free_chunks;
+    free_chunk(block, ptr);
+}
 
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (allocator->block_count < number_of_chunked_blocks_to_keep_around_per_size_class) {
-#ifdef MALLOC_DEBUG
-            dbgprintf("Keeping block %p around for size class %u\n", block, good_size);
-#endif
-            g_malloc_stats.number_of_keeps++;
-            allocator->usable_blocks.remove(block);
-            allocator->empty_blocks[allocator->empty_block_count++] = block;
-            mprotect(block, block_size, PROT_NONE);
-            madvise(block, block_size, MADV_SET_VOLATILE);
-            return;
-        }
-#ifdef MALLOC_DEBUG
-        dbgprintf("Releasing block %p for size class %u\n", block, good_size);
-#endif
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(block);
-        --allocator->block_count;
-        os_free(block, block_size);
-    }
+void __malloc_thread_exit()
+{
+    if (!s_use_thread_cache)
+        return;
+    LOCKER(malloc_lock());
+    fold_thread_cache_stats();
+    for (auto& bin : t_thread_cache.bins)
+        flush_thread_cache_bin(bin, bin.count);
 }
 
 [[gnu::flatten]] void* malloc(size_t size)
@@ -454,10 +611,38 @@ size_t malloc_size(void* ptr)
     auto* header = (const CommonHeader*)page_base;
     auto size = header->m_size;
     if (header->m_magic == MAGIC_BIGALLOC_HEADER)
-        size -= sizeof(CommonHeader);
+        size -= sizeof(BigAllocationBlock);
     return size;
 }
 
+// Tries to map fresh memory directly after a big block so it can grow without being copied.
+// Must be called with the malloc lock held.
+static bool try_grow_big_allocation_in_place(void* ptr, size_t size)
+{
+    auto* block = (BigAllocationBlock*)((FlatPtr)ptr & block_mask);
+    if (block->m_magic != MAGIC_BIGALLOC_HEADER)
+        return false;
+    if (Checked<size_t>::addition_would_overflow(sizeof(BigAllocationBlock), size))
+        return false;
+    size_t new_size = big_allocation_size(sizeof(BigAllocationBlock) + size);
+    auto* extension_base = (u8*)block + block->m_size;
+    size_t extension_size = new_size - block->m_size;
+    // Without MAP_FIXED, a hint that overlaps an existing mapping fails instead of landing elsewhere.
+    auto* extension = serenity_mmap(extension_base, extension_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, 0, "malloc: BigAllocationBlock");
+    if (extension == MAP_FAILED)
+        return false;
+    if (extension != extension_base) {
+        os_free(extension, extension_size);
+        return false;
+    }
+    g_malloc_stats.number_of_big_allocations_grown_in_place++;
+    block->m_size = new_size;
+    block->m_is_extended = true;
+    ue_notify_free(ptr);
+    ue_notify_malloc(ptr, size);
+    return true;
+}
+
 void* realloc(void* ptr, size_t size)
 {
     if (!ptr)
@@ -469,6 +654,8 @@ void* realloc(void* ptr, size_t size)
     auto existing_allocation_size = malloc_size(ptr);
     if (size <= existing_allocation_size)
         return ptr;
+    if (try_grow_big_allocation_in_place(ptr, size))
+        return ptr;
     auto* new_ptr = malloc(size);
     if (new_ptr) {
         memcpy(new_ptr, ptr, min(existing_allocation_size, size));
@@ -488,13 +675,23 @@ void __malloc_init()
         s_log_malloc = true;
     if (getenv("LIBC_PROFILE_MALLOC"))
         s_profiling = true;
+    if (getenv("LIBC_NO_THREAD_CACHE_MALLOC"))
+        s_use_thread_cache = false;
 
     for (size_t i = 0; i < num_size_classes; ++i) {
         new (&allocators()[i]) Allocator();
         allocators()[i].size = size_classes[i];
     }
 
-    new (&big_allocators()[0])(BigAllocator);
+    size_t big_size = block_size;
+    for (size_t i = 0; i < num_big_size_classes; ++i) {
+        new (&big_allocators()[i]) BigAllocator();
+        if (big_size <= largest_recycled_big_allocation) {
+            big_allocators()[i].size = big_size;
+            big_size = big_allocation_size(big_size + 1);
+        }
+    }
+    ASSERT(big_size > largest_recycled_big_allocation);
 }
 
 void serenity_dump_malloc_stats()
@@ -514,9 +711,13 @@ void serenity_dump_malloc_stats()
     dbg();
     dbg() << "big alloc keeps: " << g_malloc_stats.number_of_big_allocator_keeps;
     dbg() << "big alloc frees: " << g_malloc_stats.number_of_big_allocator_frees;
+    dbg() << "big allocs grown in place: " << g_malloc_stats.number_of_big_allocations_grown_in_place;
     dbg();
     dbg() << "full block frees: " << g_malloc_stats.number_of_freed_full_blocks;
     dbg() << "number of keeps: " << g_malloc_stats.number_of_keeps;
     dbg() << "number of frees: " << g_malloc_stats.number_of_frees;
+    dbg();
+    dbg() << "thread cache refills: " << g_malloc_stats.number_of_thread_cache_refills;
+    dbg() << "thread cache flushes: " << g_malloc_stats.number_of_thread_cache_flushes;
 }
 }
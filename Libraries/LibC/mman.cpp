@@ -87,4 +87,10 @@ int minherit(void* address, size_t size, int inherit)
     int rc = syscall(SC_minherit, address, size, inherit);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
+
+int msync(void* address, size_t size, int flags)
+{
+    int rc = syscall(SC_msync, address, size, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
 }
@@ -37,6 +37,7 @@
 #define MAP_ANON MAP_ANONYMOUS
 #define MAP_STACK 0x40
 #define MAP_PURGEABLE 0x80
+#define MAP_LARGE_PAGES 0x100
 
 #define PROT_READ 0x1
 #define PROT_WRITE 0x2
@@ -45,12 +46,21 @@
 
 #define MAP_FAILED ((void*)-1)
 
+#define MADV_NORMAL 0x0
+#define MADV_RANDOM 0x1
+#define MADV_SEQUENTIAL 0x2
+#define MADV_WILLNEED 0x3
+#define MADV_DONTNEED 0x4
 #define MADV_SET_VOLATILE 0x100
 #define MADV_SET_NONVOLATILE 0x200
 #define MADV_GET_VOLATILE 0x400
 
 #define MAP_INHERIT_ZERO 1
 
+#define MS_ASYNC 0x1
+#define MS_INVALIDATE 0x2
+#define MS_SYNC 0x4
+
 __BEGIN_DECLS
 
 void* mmap(void* addr, size_t, int prot, int flags, int fd, off_t);
@@ -61,5 +71,6 @@ int mprotect(void*, size_t, int prot);
 int set_mmap_name(void*, size_t, const char*);
 int madvise(void*, size_t, int advice);
 int minherit(void*, size_t, int inherit);
+int msync(void*, size_t, int flags);
 
 __END_DECLS
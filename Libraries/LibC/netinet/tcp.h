@@ -25,3 +25,6 @@
  */
 
 #pragma once
+
+#define TCP_NODELAY 1
+#define TCP_CONGESTION 13
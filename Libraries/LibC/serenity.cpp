@@ -72,9 +72,15 @@ int set_process_boost(pid_t tid, int amount)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
-int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout)
+int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout, int32_t* userspace_address2, int32_t value3)
 {
-    Syscall::SC_futex_params params { userspace_address, futex_op, value, timeout };
+    u32 value2 = 0;
+    int command = futex_op & FUTEX_CMD_MASK;
+    if (command == FUTEX_REQUEUE || command == FUTEX_CMP_REQUEUE) {
+        value2 = (u32)(FlatPtr)timeout;
+        timeout = nullptr;
+    }
+    Syscall::SC_futex_params params { userspace_address, futex_op, value, timeout, value2, userspace_address2, value3 };
     int rc = syscall(SC_futex, &params);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
@@ -91,6 +97,30 @@ int perf_event(int type, uintptr_t arg1, FlatPtr arg2)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int perf_event_stream(pid_t pid)
+{
+    int rc = syscall(SC_perf_event_stream, pid);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int perf_counter_sampling(pid_t pid, int counter, uint32_t period)
+{
+    int rc = syscall(SC_perf_counter_sampling, pid, counter, period);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int perf_off_cpu_tracing(pid_t pid, int enabled)
+{
+    int rc = syscall(SC_perf_off_cpu_tracing, pid, enabled);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int perf_syscall_tracing(pid_t pid, int enabled)
+{
+    int rc = syscall(SC_perf_syscall_tracing, pid, enabled);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 void* shbuf_get(int shbuf_id, size_t* size)
 {
     int rc = syscall(SC_shbuf_get, shbuf_id, size);
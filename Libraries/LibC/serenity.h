@@ -57,8 +57,26 @@ int set_process_boost(pid_t, int amount);
 
 #define FUTEX_WAIT 1
 #define FUTEX_WAKE 2
+#define FUTEX_REQUEUE 3
+#define FUTEX_CMP_REQUEUE 4
+#define FUTEX_LOCK_PI 6
+#define FUTEX_UNLOCK_PI 7
+#define FUTEX_TRYLOCK_PI 8
+#define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
 
-int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout);
+#define FUTEX_PRIVATE_FLAG 128
+#define FUTEX_CLOCK_REALTIME 256
+#define FUTEX_CMD_MASK ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME)
+
+#define FUTEX_BITSET_MATCH_ANY 0xffffffff
+
+#define FUTEX_WAITERS 0x80000000u
+#define FUTEX_OWNER_DIED 0x40000000u
+#define FUTEX_TID_MASK 0x3fffffffu
+
+// As on Linux, FUTEX_REQUEUE and FUTEX_CMP_REQUEUE take the maximum number of waiters to requeue in place of the timeout.
+int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout, int32_t* userspace_address2, int32_t value3);
 
 #define PURGE_ALL_VOLATILE 0x1
 #define PURGE_ALL_CLEAN_INODE 0x2
@@ -67,8 +85,20 @@ int purge(int mode);
 
 #define PERF_EVENT_MALLOC 1
 #define PERF_EVENT_FREE 2
+#define PERF_EVENT_SAMPLE 3
+#define PERF_EVENT_OFF_CPU 4
+#define PERF_EVENT_SYSCALL 5
+
+#define PERF_COUNTER_CYCLES 1
+#define PERF_COUNTER_INSTRUCTIONS 2
+#define PERF_COUNTER_CACHE_MISSES 3
+#define PERF_COUNTER_BRANCH_MISSES 4
 
 int perf_event(int type, uintptr_t arg1, uintptr_t arg2);
+int perf_event_stream(pid_t);
+int perf_counter_sampling(pid_t, int counter, uint32_t period);
+int perf_off_cpu_tracing(pid_t, int enabled);
+int perf_syscall_tracing(pid_t, int enabled);
 
 int get_stack_bounds(uintptr_t* user_stack_base, size_t* user_stack_size);
 
@@ -34,21 +34,59 @@
 
 #include <spawn.h>
 
+#include <alloca.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <AK/Function.h>
+#include <AK/String.h>
 #include <AK/Vector.h>
+#include <Kernel/API/Syscall.h>
+
+struct posix_spawn_file_action {
+    Syscall::SpawnFileActionType type { Syscall::SpawnFileActionType::Close };
+    int fd { -1 };
+    int new_fd { -1 };
+    int options { 0 };
+    mode_t mode { 0 };
+    String path;
+};
 
 struct posix_spawn_file_actions_state {
-    Vector<Function<int()>, 4> actions;
+    Vector<posix_spawn_file_action, 4> actions;
+    // Hands the terminal on this descriptor to the child's process group, before any other file action.
+    int tcsetpgrp_fd { -1 };
 };
 
 extern "C" {
 
+static int run_file_action(const posix_spawn_file_action& action)
+{
+    switch (action.type) {
+    case Syscall::SpawnFileActionType::Close:
+        return close(action.fd);
+    case Syscall::SpawnFileActionType::Dup2:
+        return dup2(action.fd, action.new_fd);
+    case Syscall::SpawnFileActionType::Open: {
+        int opened_fd = open(action.path.characters(), action.options, action.mode);
+        if (opened_fd < 0 || opened_fd == action.fd)
+            return opened_fd;
+        if (int rc = dup2(opened_fd, action.fd); rc < 0)
+            return rc;
+        return close(opened_fd);
+    }
+    case Syscall::SpawnFileActionType::Chdir:
+        return chdir(action.path.characters());
+    case Syscall::SpawnFileActionType::Fchdir:
+        return fchdir(action.fd);
+    }
+    ASSERT_NOT_REACHED();
+}
+
 [[noreturn]] static void posix_spawn_child(const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[], int (*exec)(const char*, char* const[], char* const[]))
 {
     if (attr) {
@@ -105,9 +143,16 @@ extern "C" {
         // FIXME: POSIX_SPAWN_SETSCHEDULER
     }
 
+    if (file_actions && file_actions->state->tcsetpgrp_fd >= 0) {
+        if (tcsetpgrp(file_actions->state->tcsetpgrp_fd, getpgrp()) < 0) {
+            perror("posix_spawn tcsetpgrp");
+            _exit(127);
+        }
+    }
+
     if (file_actions) {
         for (const auto& action : file_actions->state->actions) {
-            if (action() < 0) {
+            if (run_file_action(action) < 0) {
                 perror("posix_spawn file action");
                 _exit(127);
             }
@@ -119,8 +164,64 @@ extern "C" {
     _exit(127);
 }
 
+// The kernel can start the child without fork()ing us first unless it has to run with
+// different ids, in a different session or process group, or take over the terminal.
+static bool can_spawn_without_fork(const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr)
+{
+    if (file_actions && file_actions->state->tcsetpgrp_fd >= 0)
+        return false;
+    if (!attr)
+        return true;
+    // exec() resets the signal mask and all signal dispositions anyway.
+    return !(attr->flags & ~(POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK));
+}
+
+static int spawn_without_fork(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, char* const argv[], char* const envp[])
+{
+    size_t arg_count = 0;
+    for (size_t i = 0; argv[i]; ++i)
+        ++arg_count;
+
+    size_t env_count = 0;
+    for (size_t i = 0; envp[i]; ++i)
+        ++env_count;
+
+    auto copy_strings = [&](auto& vec, size_t count, auto& output) {
+        output.length = count;
+        for (size_t i = 0; vec[i]; ++i) {
+            output.strings.ptr()[i].characters = vec[i];
+            output.strings.ptr()[i].length = strlen(vec[i]);
+        }
+    };
+
+    Syscall::SC_posix_spawn_params params;
+    params.arguments.strings = (Syscall::StringArgument*)alloca(arg_count * sizeof(Syscall::StringArgument));
+    params.environment.strings = (Syscall::StringArgument*)alloca(env_count * sizeof(Syscall::StringArgument));
+
+    params.path = { path, strlen(path) };
+    copy_strings(argv, arg_count, params.arguments);
+    copy_strings(envp, env_count, params.environment);
+
+    Vector<Syscall::SC_posix_spawn_file_action, 4> actions;
+    if (file_actions) {
+        for (auto& action : file_actions->state->actions)
+            actions.append({ action.type, action.fd, action.new_fd, action.options, (u16)action.mode, { action.path.characters(), action.path.length() } });
+    }
+    params.file_actions = actions.data();
+    params.file_action_count = actions.size();
+
+    int rc = syscall(SC_posix_spawn, &params);
+    if (rc < 0)
+        return -rc;
+    *out_pid = rc;
+    return 0;
+}
+
 int posix_spawn(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
 {
+    if (can_spawn_without_fork(file_actions, attr))
+        return spawn_without_fork(out_pid, path, file_actions, argv, envp);
+
     pid_t child_pid = fork();
     if (child_pid < 0)
         return errno;
@@ -135,6 +236,22 @@ int posix_spawn(pid_t* out_pid, const char* path, const posix_spawn_file_actions
 
 int posix_spawnp(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
 {
+    if (can_spawn_without_fork(file_actions, attr)) {
+        if (strchr(path, '/'))
+            return spawn_without_fork(out_pid, path, file_actions, argv, envp);
+
+        String search_path = getenv("PATH");
+        if (search_path.is_empty())
+            search_path = "/bin:/usr/bin";
+        for (auto& part : search_path.split(':')) {
+            auto candidate = String::format("%s/%s", part.characters(), path);
+            int rc = spawn_without_fork(out_pid, candidate.characters(), file_actions, argv, envp);
+            if (rc != ENOENT)
+                return rc;
+        }
+        return ENOENT;
+    }
+
     pid_t child_pid = fork();
     if (child_pid < 0)
         return errno;
@@ -149,38 +266,56 @@ int posix_spawnp(pid_t* out_pid, const char* path, const posix_spawn_file_action
 
 int posix_spawn_file_actions_addchdir(posix_spawn_file_actions_t* actions, const char* path)
 {
-    actions->state->actions.append([path]() { return chdir(path); });
+    posix_spawn_file_action action;
+    action.type = Syscall::SpawnFileActionType::Chdir;
+    action.path = path;
+    actions->state->actions.append(move(action));
     return 0;
 }
 
 int posix_spawn_file_actions_addfchdir(posix_spawn_file_actions_t* actions, int fd)
 {
-    actions->state->actions.append([fd]() { return fchdir(fd); });
+    posix_spawn_file_action action;
+    action.type = Syscall::SpawnFileActionType::Fchdir;
+    action.fd = fd;
+    actions->state->actions.append(move(action));
     return 0;
 }
 
 int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* actions, int fd)
 {
-    actions->state->actions.append([fd]() { return close(fd); });
+    posix_spawn_file_action action;
+    action.type = Syscall::SpawnFileActionType::Close;
+    action.fd = fd;
+    actions->state->actions.append(move(action));
     return 0;
 }
 
 int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* actions, int old_fd, int new_fd)
 {
-    actions->state->actions.append([old_fd, new_fd]() { return dup2(old_fd, new_fd); });
+    posix_spawn_file_action action;
+    action.type = Syscall::SpawnFileActionType::Dup2;
+    action.fd = old_fd;
+    action.new_fd = new_fd;
+    actions->state->actions.append(move(action));
     return 0;
 }
 
 int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* actions, int want_fd, const char* path, int flags, mode_t mode)
 {
-    actions->state->actions.append([want_fd, path, flags, mode]() {
-        int opened_fd = open(path, flags, mode);
-        if (opened_fd < 0 || opened_fd == want_fd)
-            return opened_fd;
-        if (int rc = dup2(opened_fd, want_fd); rc < 0)
-            return rc;
-        return close(opened_fd);
-    });
+    posix_spawn_file_action action;
+    action.type = Syscall::SpawnFileActionType::Open;
+    action.fd = want_fd;
+    action.path = path;
+    action.options = flags;
+    action.mode = mode;
+    actions->state->actions.append(move(action));
+    return 0;
+}
+
+int posix_spawn_file_actions_addtcsetpgrp_np(posix_spawn_file_actions_t* actions, int fd)
+{
+    actions->state->tcsetpgrp_fd = fd;
     return 0;
 }
 
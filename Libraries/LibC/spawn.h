@@ -78,6 +78,8 @@ int posix_spawn_file_actions_addfchdir(posix_spawn_file_actions_t*, int);
 int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t*, int);
 int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t*, int old_fd, int new_fd);
 int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t*, int fd, const char*, int flags, mode_t);
+// Like glibc's: makes the child's process group the foreground one on the terminal behind fd.
+int posix_spawn_file_actions_addtcsetpgrp_np(posix_spawn_file_actions_t*, int fd);
 int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t*);
 int posix_spawn_file_actions_init(posix_spawn_file_actions_t*);
 
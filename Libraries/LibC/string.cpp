@@ -36,6 +36,349 @@
 #include <stdlib.h>
 #include <string.h>
 
+// The routines below are reached through function pointers that are filled in on first use,
+// so that the best variant for the CPU we're running on gets picked without any startup code.
+// FIXME: The kernel only preserves the SSE register file across context switches (fxsave),
+//        so wider AVX variants can't be used in userland yet.
+
+static size_t strlen_generic(const char* str)
+{
+    size_t len = 0;
+    while (*(str++))
+        ++len;
+    return len;
+}
+
+static char* strchr_generic(const char* str, int c)
+{
+    char ch = c;
+    for (;; ++str) {
+        if (*str == ch)
+            return const_cast<char*>(str);
+        if (!*str)
+            return nullptr;
+    }
+}
+
+static void* memchr_generic(const void* ptr, int c, size_t size)
+{
+    char ch = c;
+    auto* cptr = (const char*)ptr;
+    for (size_t i = 0; i < size; ++i) {
+        if (cptr[i] == ch)
+            return const_cast<char*>(cptr + i);
+    }
+    return nullptr;
+}
+
+static int memcmp_generic(const void* v1, const void* v2, size_t n)
+{
+    auto* s1 = (const uint8_t*)v1;
+    auto* s2 = (const uint8_t*)v2;
+    while (n-- > 0) {
+        if (*s1++ != *s2++)
+            return s1[-1] < s2[-1] ? -1 : 1;
+    }
+    return 0;
+}
+
+#if ARCH(I386)
+static void* memcpy_generic(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    void* original_dest = dest_ptr;
+    asm volatile(
+        "rep movsb"
+        : "+D"(dest_ptr), "+S"(src_ptr), "+c"(n)::"memory");
+    return original_dest;
+}
+
+static void* memset_generic(void* dest_ptr, int c, size_t n)
+{
+    void* original_dest = dest_ptr;
+    asm volatile(
+        "rep stosb\n"
+        : "=D"(dest_ptr), "=c"(n)
+        : "0"(dest_ptr), "1"(n), "a"(c)
+        : "memory");
+    return original_dest;
+}
+#else
+static void* memcpy_generic(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    auto* dest = (u8*)dest_ptr;
+    auto* src = (const u8*)src_ptr;
+    for (size_t i = 0; i < n; ++i)
+        dest[i] = src[i];
+    return dest_ptr;
+}
+
+static void* memset_generic(void* dest_ptr, int c, size_t n)
+{
+    auto* dest = (u8*)dest_ptr;
+    for (size_t i = 0; i < n; ++i)
+        dest[i] = (u8)c;
+    return dest_ptr;
+}
+#endif
+
+static void* memmove_generic(void* dest, const void* src, size_t n)
+{
+    if (dest < src)
+        return memcpy_generic(dest, src, n);
+
+    u8* pd = (u8*)dest;
+    const u8* ps = (const u8*)src;
+    for (pd += n, ps += n; n--;)
+        *--pd = *--ps;
+    return dest;
+}
+
+#if ARCH(I386)
+typedef char v16qi __attribute__((vector_size(16)));
+typedef char v16qi_u __attribute__((vector_size(16), aligned(1), may_alias));
+
+#    define SSE2 __attribute__((target("sse2")))
+
+SSE2 static inline v16qi load_unaligned(const void* ptr) { return *(const v16qi_u*)ptr; }
+SSE2 static inline void store_unaligned(void* ptr, v16qi value) { *(v16qi_u*)ptr = value; }
+SSE2 static inline v16qi splat(char ch) { return (v16qi) {} + ch; }
+SSE2 static inline unsigned mask_of_equal_bytes(v16qi a, v16qi b) { return __builtin_ia32_pmovmskb128((v16qi)(a == b)); }
+
+static void cpuid(u32 leaf, u32& eax, u32& ebx, u32& ecx, u32& edx)
+{
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(leaf), "c"(0));
+}
+
+// With "enhanced rep movsb", microcode beats a vector loop once copies get large enough
+// to amortize its startup cost.
+static constexpr size_t rep_movsb_threshold = 2 * KiB;
+static bool s_cpu_has_erms;
+
+SSE2 static void* memcpy_sse2(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    if (n < 16 || (n >= rep_movsb_threshold && s_cpu_has_erms))
+        return memcpy_generic(dest_ptr, src_ptr, n);
+
+    auto* dest = (u8*)dest_ptr;
+    auto* src = (const u8*)src_ptr;
+
+    // Copy the unaligned head and tail up front; everything in between is stored 16-byte aligned.
+    auto head = load_unaligned(src);
+    auto tail = load_unaligned(src + n - 16);
+    store_unaligned(dest, head);
+    size_t offset = 16 - ((FlatPtr)dest & 15);
+    for (; offset + 64 <= n; offset += 64) {
+        auto a = load_unaligned(src + offset);
+        auto b = load_unaligned(src + offset + 16);
+        auto c = load_unaligned(src + offset + 32);
+        auto d = load_unaligned(src + offset + 48);
+        *(v16qi*)(dest + offset) = a;
+        *(v16qi*)(dest + offset + 16) = b;
+        *(v16qi*)(dest + offset + 32) = c;
+        *(v16qi*)(dest + offset + 48) = d;
+    }
+    for (; offset + 16 <= n; offset += 16)
+        *(v16qi*)(dest + offset) = load_unaligned(src + offset);
+    store_unaligned(dest + n - 16, tail);
+    return dest_ptr;
+}
+
+SSE2 static void* memset_sse2(void* dest_ptr, int c, size_t n)
+{
+    if (n < 16 || (n >= rep_movsb_threshold && s_cpu_has_erms))
+        return memset_generic(dest_ptr, c, n);
+
+    auto* dest = (u8*)dest_ptr;
+    auto value = splat(c);
+    store_unaligned(dest, value);
+    size_t offset = 16 - ((FlatPtr)dest & 15);
+    for (; offset + 64 <= n; offset += 64) {
+        *(v16qi*)(dest + offset) = value;
+        *(v16qi*)(dest + offset + 16) = value;
+        *(v16qi*)(dest + offset + 32) = value;
+        *(v16qi*)(dest + offset + 48) = value;
+    }
+    for (; offset + 16 <= n; offset += 16)
+        *(v16qi*)(dest + offset) = value;
+    store_unaligned(dest + n - 16, value);
+    return dest_ptr;
+}
+
+SSE2 static void* memmove_sse2(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    auto* dest = (u8*)dest_ptr;
+    auto* src = (const u8*)src_ptr;
+    if (dest + n <= src || src + n <= dest)
+        return memcpy_sse2(dest_ptr, src_ptr, n);
+
+    // The ranges overlap. Each block is loaded before it's stored, and blocks are walked
+    // away from the destination, so no source byte is overwritten before it's been read.
+    size_t offset = 0;
+    if (dest < src) {
+        for (; offset + 16 <= n; offset += 16)
+            store_unaligned(dest + offset, load_unaligned(src + offset));
+        for (; offset < n; ++offset)
+            dest[offset] = src[offset];
+    } else {
+        for (; offset + 16 <= n; offset += 16)
+            store_unaligned(dest + n - offset - 16, load_unaligned(src + n - offset - 16));
+        for (; offset < n; ++offset)
+            dest[n - offset - 1] = src[n - offset - 1];
+    }
+    return dest_ptr;
+}
+
+SSE2 static int memcmp_sse2(const void* v1, const void* v2, size_t n)
+{
+    auto* s1 = (const u8*)v1;
+    auto* s2 = (const u8*)v2;
+    for (; n >= 16; n -= 16, s1 += 16, s2 += 16) {
+        unsigned mask = mask_of_equal_bytes(load_unaligned(s1), load_unaligned(s2));
+        if (mask != 0xffff) {
+            unsigned index = __builtin_ctz(~mask);
+            return s1[index] < s2[index] ? -1 : 1;
+        }
+    }
+    return memcmp_generic(s1, s2, n);
+}
+
+SSE2 static void* memchr_sse2(const void* ptr, int c, size_t size)
+{
+    auto* cptr = (const char*)ptr;
+    auto needle = splat(c);
+    for (; size >= 16; size -= 16, cptr += 16) {
+        if (unsigned mask = mask_of_equal_bytes(load_unaligned(cptr), needle))
+            return const_cast<char*>(cptr + __builtin_ctz(mask));
+    }
+    return memchr_generic(cptr, c, size);
+}
+
+// strlen() and strchr() don't know how far they may read, so they only ever load aligned blocks.
+// An aligned block never straddles a page boundary, so it can't fault if its first byte is readable.
+
+SSE2 static size_t strlen_sse2(const char* str)
+{
+    auto* block = (const char*)((FlatPtr)str & ~15);
+    unsigned mask = mask_of_equal_bytes(*(const v16qi*)block, v16qi {}) >> ((FlatPtr)str & 15);
+    if (mask)
+        return __builtin_ctz(mask);
+    for (;;) {
+        block += 16;
+        mask = mask_of_equal_bytes(*(const v16qi*)block, v16qi {});
+        if (mask)
+            return block + __builtin_ctz(mask) - str;
+    }
+}
+
+SSE2 static char* strchr_sse2(const char* str, int c)
+{
+    auto needle = splat(c);
+    auto* block = (const char*)((FlatPtr)str & ~15);
+    auto data = *(const v16qi*)block;
+    unsigned mask = (mask_of_equal_bytes(data, needle) | mask_of_equal_bytes(data, v16qi {})) >> ((FlatPtr)str & 15);
+    if (!mask) {
+        for (;;) {
+            block += 16;
+            data = *(const v16qi*)block;
+            mask = mask_of_equal_bytes(data, needle) | mask_of_equal_bytes(data, v16qi {});
+            if (mask)
+                break;
+        }
+        str = block;
+    }
+    auto* found = str + __builtin_ctz(mask);
+    return *found == (char)c ? const_cast<char*>(found) : nullptr;
+}
+
+#    undef SSE2
+#endif
+
+static void select_string_implementations();
+
+static void* memcpy_resolver(void* dest, const void* src, size_t n)
+{
+    select_string_implementations();
+    return memcpy(dest, src, n);
+}
+
+static void* memmove_resolver(void* dest, const void* src, size_t n)
+{
+    select_string_implementations();
+    return memmove(dest, src, n);
+}
+
+static void* memset_resolver(void* dest, int c, size_t n)
+{
+    select_string_implementations();
+    return memset(dest, c, n);
+}
+
+static int memcmp_resolver(const void* v1, const void* v2, size_t n)
+{
+    select_string_implementations();
+    return memcmp(v1, v2, n);
+}
+
+static void* memchr_resolver(const void* ptr, int c, size_t size)
+{
+    select_string_implementations();
+    return memchr(ptr, c, size);
+}
+
+static size_t strlen_resolver(const char* str)
+{
+    select_string_implementations();
+    return strlen(str);
+}
+
+static char* strchr_resolver(const char* str, int c)
+{
+    select_string_implementations();
+    return strchr(str, c);
+}
+
+static void* (*s_memcpy)(void*, const void*, size_t) = memcpy_resolver;
+static void* (*s_memmove)(void*, const void*, size_t) = memmove_resolver;
+static void* (*s_memset)(void*, int, size_t) = memset_resolver;
+static int (*s_memcmp)(const void*, const void*, size_t) = memcmp_resolver;
+static void* (*s_memchr)(const void*, int, size_t) = memchr_resolver;
+static size_t (*s_strlen)(const char*) = strlen_resolver;
+static char* (*s_strchr)(const char*, int) = strchr_resolver;
+
+static void select_string_implementations()
+{
+#if ARCH(I386)
+    u32 max_leaf, ebx, ecx, edx;
+    cpuid(0, max_leaf, ebx, ecx, edx);
+    u32 eax;
+    cpuid(1, eax, ebx, ecx, edx);
+    bool has_sse2 = edx & (1 << 26);
+    if (max_leaf >= 7) {
+        cpuid(7, eax, ebx, ecx, edx);
+        s_cpu_has_erms = ebx & (1 << 9);
+    }
+    if (has_sse2) {
+        s_memcpy = memcpy_sse2;
+        s_memmove = memmove_sse2;
+        s_memset = memset_sse2;
+        s_memcmp = memcmp_sse2;
+        s_memchr = memchr_sse2;
+        s_strlen = strlen_sse2;
+        s_strchr = strchr_sse2;
+        return;
+    }
+#endif
+    s_memcpy = memcpy_generic;
+    s_memmove = memmove_generic;
+    s_memset = memset_generic;
+    s_memcmp = memcmp_generic;
+    s_memchr = memchr_generic;
+    s_strlen = strlen_generic;
+    s_strchr = strchr_generic;
+}
+
 extern "C" {
 
 void bzero(void* dest, size_t n)
@@ -76,12 +419,8 @@ size_t strcspn(const char* s, const char* reject)
 
 size_t strlen(const char* str)
 {
-    size_t len = 0;
-    while (*(str++))
-        ++len;
-    return len;
+    return s_strlen(str);
 }
-
 size_t strnlen(const char* str, size_t maxlen)
 {
     size_t len = 0;
@@ -131,66 +470,22 @@ int strncmp(const char* s1, const char* s2, size_t n)
 
 int memcmp(const void* v1, const void* v2, size_t n)
 {
-    auto* s1 = (const uint8_t*)v1;
-    auto* s2 = (const uint8_t*)v2;
-    while (n-- > 0) {
-        if (*s1++ != *s2++)
-            return s1[-1] < s2[-1] ? -1 : 1;
-    }
-    return 0;
+    return s_memcmp(v1, v2, n);
 }
-
-#if ARCH(I386)
 void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
 {
-    void* original_dest = dest_ptr;
-    asm volatile(
-        "rep movsb"
-        : "+D"(dest_ptr), "+S"(src_ptr), "+c"(n)::"memory");
-    return original_dest;
-}
-
-void* memset(void* dest_ptr, int c, size_t n)
-{
-    void* original_dest = dest_ptr;
-    asm volatile(
-        "rep stosb\n"
-        : "=D"(dest_ptr), "=c"(n)
-        : "0"(dest_ptr), "1"(n), "a"(c)
-        : "memory");
-    return original_dest;
-}
-#else
-void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
-{
-    auto* dest = (u8*)dest_ptr;
-    auto* src = (const u8*)src_ptr;
-    for (size_t i = 0; i < n; ++i)
-        dest[i] = src[i];
-    return dest_ptr;
+    return s_memcpy(dest_ptr, src_ptr, n);
 }
 
 void* memset(void* dest_ptr, int c, size_t n)
 {
-    auto* dest = (u8*)dest_ptr;
-    for (size_t i = 0; i < n; ++i)
-        dest[i] = (u8)c;
-    return dest_ptr;
+    return s_memset(dest_ptr, c, n);
 }
-#endif
 
 void* memmove(void* dest, const void* src, size_t n)
 {
-    if (dest < src)
-        return memcpy(dest, src, n);
-
-    u8* pd = (u8*)dest;
-    const u8* ps = (const u8*)src;
-    for (pd += n, ps += n; n--;)
-        *--pd = *--ps;
-    return dest;
+    return s_memmove(dest, src, n);
 }
-
 const void* memmem(const void* haystack, size_t haystack_length, const void* needle, size_t needle_length)
 {
     return AK::memmem(haystack, haystack_length, needle, needle_length);
@@ -229,15 +524,8 @@ size_t strlcpy(char* dest, const char* src, size_t n)
 
 char* strchr(const char* str, int c)
 {
-    char ch = c;
-    for (;; ++str) {
-        if (*str == ch)
-            return const_cast<char*>(str);
-        if (!*str)
-            return nullptr;
-    }
+    return s_strchr(str, c);
 }
-
 char* strchrnul(const char* str, int c)
 {
     char ch = c;
@@ -249,15 +537,8 @@ char* strchrnul(const char* str, int c)
 
 void* memchr(const void* ptr, int c, size_t size)
 {
-    char ch = c;
-    auto* cptr = (const char*)ptr;
-    for (size_t i = 0; i < size; ++i) {
-        if (cptr[i] == ch)
-            return const_cast<char*>(cptr + i);
-    }
-    return nullptr;
+    return s_memchr(ptr, c, size);
 }
-
 char* strrchr(const char* str, int ch)
 {
     char* last = nullptr;
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+#define IO_RING_OP_NOP 0
+#define IO_RING_OP_READ 1
+#define IO_RING_OP_WRITE 2
+#define IO_RING_OP_ACCEPT 3
+#define IO_RING_OP_CONNECT 4
+#define IO_RING_OP_FSYNC 5
+
+#define IO_RING_MAX_ENTRIES 4096
+
+// A submission queue entry. For reads and writes, addr and len describe the buffer, and a
+// negative offset means the file's current offset. For accept(), addr and addr2 are the
+// address and address length out-parameters. For connect(), addr and len are the address.
+struct io_ring_sqe {
+    uint32_t opcode;
+    int fd;
+    int64_t offset;
+    void* addr;
+    void* addr2;
+    uint32_t len;
+    uint64_t user_data;
+};
+
+// A completion queue entry. The result is what the corresponding syscall would have
+// returned, with errors as negative errno values.
+struct io_ring_cqe {
+    uint64_t user_data;
+    int32_t result;
+    uint32_t flags;
+};
+
+// Lives at the start of the ring mapping. Userspace advances sq_tail and cq_head,
+// the kernel advances sq_head and cq_tail. All four are free-running counters.
+struct io_ring_header {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+};
+
+struct io_ring_params {
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sq_offset;
+    uint32_t cq_offset;
+    uint32_t mapping_size;
+};
+
+int io_ring_setup(uint32_t entries, struct io_ring_params*);
+int io_ring_enter(int ring_fd, uint32_t to_submit, uint32_t min_completions);
+
+__END_DECLS
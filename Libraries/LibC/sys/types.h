@@ -83,22 +83,33 @@ typedef struct __pthread_mutex_t {
     pthread_t owner;
     int level;
     int type;
+    int protocol;
 } pthread_mutex_t;
 
 typedef void* pthread_attr_t;
 typedef struct __pthread_mutexattr_t {
     int type;
+    int protocol;
 } pthread_mutexattr_t;
 
 typedef struct __pthread_cond_t {
     int32_t value;
-    uint32_t previous;
+    pthread_mutex_t* mutex;
     int clockid; // clockid_t
 } pthread_cond_t;
 
-typedef void* pthread_rwlock_t;
-typedef void* pthread_rwlockatrr_t;
-typedef void* pthread_spinlock_t;
+typedef struct __pthread_rwlock_t {
+    uint32_t state;
+    pthread_t writer;
+} pthread_rwlock_t;
+
+typedef void* pthread_rwlockattr_t;
+typedef pthread_rwlockattr_t pthread_rwlockatrr_t;
+
+typedef struct __pthread_spinlock_t {
+    uint32_t lock;
+} pthread_spinlock_t;
+
 typedef struct __pthread_condattr_t {
     int clockid; // clockid_t
 } pthread_condattr_t;
@@ -122,6 +122,200 @@ String Move::to_long_algebraic() const
     return builder.build();
 }
 
+namespace {
+
+struct Magic {
+    Bitboard mask;
+    u64 multiplier;
+    unsigned shift;
+    const Bitboard* attacks;
+};
+
+// Lookup tables for attacks and hashing, shared by all boards. Sliding pieces use "fancy" magic
+// bitboards: the blockers on a piece's lines are multiplied by a magic number whose top bits
+// then index straight into that square's table of attacked squares.
+struct Tables {
+    Tables();
+
+    Bitboard knight_attacks[64];
+    Bitboard king_attacks[64];
+    Bitboard pawn_attacks[2][64];
+    Magic bishop_magics[64];
+    Magic rook_magics[64];
+    Vector<Bitboard> sliding_attacks;
+
+    u64 piece_keys[2][6][64];
+    u64 castling_keys[4];
+    u64 black_to_move_key;
+};
+
+constexpr int bishop_directions[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+constexpr int rook_directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+// Squares of the same shade as b1.
+constexpr Bitboard light_squares = 0x55AA55AA55AA55AAull;
+
+constexpr Bitboard bit(unsigned index)
+{
+    return 1ull << index;
+}
+
+// A fixed seed keeps the Zobrist keys the same from run to run.
+u64 next_random(u64& state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+template<size_t step_count>
+Bitboard step_attacks(unsigned square, const int (&steps)[step_count][2])
+{
+    Bitboard attacks = 0;
+    for (auto& step : steps) {
+        int rank = square / 8 + step[0];
+        int file = square % 8 + step[1];
+        if (rank >= 0 && rank < 8 && file >= 0 && file < 8)
+            attacks |= bit(rank * 8 + file);
+    }
+    return attacks;
+}
+
+// Walks each line until it leaves the board or hits a blocker. With `relevant_only`, the last
+// square of each line is left out, since whether it's occupied never changes the attacks.
+Bitboard ray_attacks(unsigned square, Bitboard occupancy, const int (&directions)[4][2], bool relevant_only = false)
+{
+    Bitboard attacks = 0;
+    for (auto& direction : directions) {
+        int rank = square / 8 + direction[0];
+        int file = square % 8 + direction[1];
+        for (; rank >= 0 && rank < 8 && file >= 0 && file < 8; rank += direction[0], file += direction[1]) {
+            int next_rank = rank + direction[0];
+            int next_file = file + direction[1];
+            if (relevant_only && (next_rank < 0 || next_rank >= 8 || next_file < 0 || next_file >= 8))
+                break;
+            attacks |= bit(rank * 8 + file);
+            if (occupancy & bit(rank * 8 + file))
+                break;
+        }
+    }
+    return attacks;
+}
+
+// Found with the usual search: sparse random numbers, kept once they send every set of blockers
+// to a slot of its own (or to one that holds the same attacks).
+constexpr u64 bishop_magic_numbers[64] = {
+    0x40106000a1160020ull, 0x0020010250810120ull, 0x2010010220280081ull, 0x002806004050c040ull,
+    0x0002021018000000ull, 0x2001112010000400ull, 0x0881010120218080ull, 0x1030820110010500ull,
+    0x0000120222042400ull, 0x2000020404040044ull, 0x8000480094208000ull, 0x0003422a02000001ull,
+    0x000a220210100040ull, 0x8004820202226000ull, 0x0018234854100800ull, 0x0100004042101040ull,
+    0x0004001004082820ull, 0x0010000810010048ull, 0x1014004208081300ull, 0x2080818802044202ull,
+    0x0040880c00a00100ull, 0x0080400200522010ull, 0x0001000188180b04ull, 0x0080249202020204ull,
+    0x1004400004100410ull, 0x00013100a0022206ull, 0x2148500001040080ull, 0x4241080011004300ull,
+    0x4020848004002000ull, 0x10101380d1004100ull, 0x0008004422020284ull, 0x01010a1041008080ull,
+    0x0808080400082121ull, 0x0808080400082121ull, 0x0091128200100c00ull, 0x0202200802010104ull,
+    0x8c0a020200440085ull, 0x01a0008080b10040ull, 0x0889520080122800ull, 0x100902022202010aull,
+    0x04081a0816002000ull, 0x0000681208005000ull, 0x8170840041008802ull, 0x0a00004200810805ull,
+    0x0830404408210100ull, 0x2602208106006102ull, 0x1048300680802628ull, 0x2602208106006102ull,
+    0x0602010120110040ull, 0x0941010801043000ull, 0x000040440a210428ull, 0x0008240020880021ull,
+    0x0400002012048200ull, 0x00ac102001210220ull, 0x0220021002009900ull, 0x84440c080a013080ull,
+    0x0001008044200440ull, 0x0004c04410841000ull, 0x2000500104011130ull, 0x1a0c010011c20229ull,
+    0x0044800112202200ull, 0x0434804908100424ull, 0x0300404822c08200ull, 0x48081010008a2a80ull,
+};
+
+constexpr u64 rook_magic_numbers[64] = {
+    0x0a80004000801220ull, 0x8040004010002008ull, 0x2080200010008008ull, 0x1100100008210004ull,
+    0xc200209084020008ull, 0x2100010004000208ull, 0x0400081000822421ull, 0x0200010422048844ull,
+    0x0800800080400024ull, 0x0001402000401000ull, 0x3000801000802001ull, 0x4400800800100083ull,
+    0x0904802402480080ull, 0x4040800400020080ull, 0x0018808042000100ull, 0x4040800080004100ull,
+    0x0040048001458024ull, 0x00a0004000205000ull, 0x3100808010002000ull, 0x4825010010000820ull,
+    0x5004808008000401ull, 0x2024818004000a00ull, 0x0005808002000100ull, 0x2100060004806104ull,
+    0x0080400880008421ull, 0x4062220600410280ull, 0x010a004a00108022ull, 0x0000100080080080ull,
+    0x0021000500080010ull, 0x0044000202001008ull, 0x0000100400080102ull, 0xc020128200040545ull,
+    0x0080002000400040ull, 0x0000804000802004ull, 0x0000120022004080ull, 0x010a386103001001ull,
+    0x9010080080800400ull, 0x8440020080800400ull, 0x0004228824001001ull, 0x000000490a000084ull,
+    0x0080002000504000ull, 0x200020005000c000ull, 0x0012088020420010ull, 0x0010010080080800ull,
+    0x0085001008010004ull, 0x0002000204008080ull, 0x0040413002040008ull, 0x0000304081020004ull,
+    0x0080204000800080ull, 0x3008804000290100ull, 0x1010100080200080ull, 0x2008100208028080ull,
+    0x5000850800910100ull, 0x8402019004680200ull, 0x0120911028020400ull, 0x0000008044010200ull,
+    0x0020850200244012ull, 0x0020850200244012ull, 0x0000102001040841ull, 0x140900040a100021ull,
+    0x000200282410a102ull, 0x000200282410a102ull, 0x000200282410a102ull, 0x4048240043802106ull,
+};
+
+void fill_magic(unsigned square, const int (&directions)[4][2], u64 multiplier, Magic& magic, Bitboard* table)
+{
+    magic.mask = ray_attacks(square, 0, directions, true);
+    magic.multiplier = multiplier;
+    magic.shift = 64 - __builtin_popcountll(magic.mask);
+    magic.attacks = table;
+
+    // Enumerate every subset of the mask (the Carry-Rippler trick).
+    Bitboard subset = 0;
+    do {
+        table[(subset * multiplier) >> magic.shift] = ray_attacks(square, subset, directions);
+        subset = (subset - magic.mask) & magic.mask;
+    } while (subset);
+}
+
+Tables::Tables()
+{
+    static constexpr int knight_steps[8][2] = { { 2, 1 }, { 2, -1 }, { -2, 1 }, { -2, -1 }, { 1, 2 }, { 1, -2 }, { -1, 2 }, { -1, -2 } };
+    static constexpr int king_steps[8][2] = { { 1, 1 }, { 1, 0 }, { 1, -1 }, { 0, 1 }, { 0, -1 }, { -1, 1 }, { -1, 0 }, { -1, -1 } };
+    static constexpr int white_pawn_steps[2][2] = { { 1, 1 }, { 1, -1 } };
+    static constexpr int black_pawn_steps[2][2] = { { -1, 1 }, { -1, -1 } };
+
+    size_t table_size = 0;
+    for (unsigned square = 0; square < 64; ++square) {
+        knight_attacks[square] = step_attacks(square, knight_steps);
+        king_attacks[square] = step_attacks(square, king_steps);
+        pawn_attacks[(int)Colour::White][square] = step_attacks(square, white_pawn_steps);
+        pawn_attacks[(int)Colour::Black][square] = step_attacks(square, black_pawn_steps);
+        table_size += 1u << __builtin_popcountll(ray_attacks(square, 0, bishop_directions, true));
+        table_size += 1u << __builtin_popcountll(ray_attacks(square, 0, rook_directions, true));
+    }
+
+    sliding_attacks.resize(table_size);
+    Bitboard* table = sliding_attacks.data();
+    for (unsigned square = 0; square < 64; ++square) {
+        fill_magic(square, bishop_directions, bishop_magic_numbers[square], bishop_magics[square], table);
+        table += 1u << (64 - bishop_magics[square].shift);
+        fill_magic(square, rook_directions, rook_magic_numbers[square], rook_magics[square], table);
+        table += 1u << (64 - rook_magics[square].shift);
+    }
+
+    u64 random_state = 0x9E3779B97F4A7C15ull;
+    for (auto& colour_keys : piece_keys) {
+        for (auto& type_keys : colour_keys) {
+            for (auto& key : type_keys)
+                key = next_random(random_state);
+        }
+    }
+    for (auto& key : castling_keys)
+        key = next_random(random_state);
+    black_to_move_key = next_random(random_state);
+}
+
+const Tables& tables()
+{
+    static Tables tables;
+    return tables;
+}
+
+Bitboard bishop_attacks(unsigned square, Bitboard occupancy)
+{
+    auto& magic = tables().bishop_magics[square];
+    return magic.attacks[((occupancy & magic.mask) * magic.multiplier) >> magic.shift];
+}
+
+Bitboard rook_attacks(unsigned square, Bitboard occupancy)
+{
+    auto& magic = tables().rook_magics[square];
+    return magic.attacks[((occupancy & magic.mask) * magic.multiplier) >> magic.shift];
+}
+
+}
+
 Board::Board()
 {
     // Fill empty spaces.
@@ -166,14 +360,29 @@ Piece Board::get_piece(const Square& square) const
 {
     ASSERT(square.rank < 8);
     ASSERT(square.file < 8);
-    return m_board[square.rank][square.file];
+    return m_board[index_of(square)];
 }
 
 Piece Board::set_piece(const Square& square, const Piece& piece)
 {
     ASSERT(square.rank < 8);
     ASSERT(square.file < 8);
-    return m_board[square.rank][square.file] = piece;
+    unsigned index = index_of(square);
+    auto& keys = tables().piece_keys;
+
+    auto& old_piece = m_board[index];
+    if (old_piece.colour != Colour::None && old_piece.type != Type::None) {
+        m_pieces[(int)old_piece.colour][(int)old_piece.type] &= ~bit(index);
+        m_occupancy[(int)old_piece.colour] &= ~bit(index);
+        m_piece_key ^= keys[(int)old_piece.colour][(int)old_piece.type][index];
+    }
+    if (piece.colour != Colour::None && piece.type != Type::None) {
+        m_pieces[(int)piece.colour][(int)piece.type] |= bit(index);
+        m_occupancy[(int)piece.colour] |= bit(index);
+        m_piece_key ^= keys[(int)piece.colour][(int)piece.type][index];
+    }
+
+    return old_piece = piece;
 }
 
 bool Board::is_legal(const Move& move, Colour colour) const
@@ -184,31 +393,33 @@ bool Board::is_legal(const Move& move, Colour colour) const
     if (!is_legal_no_check(move, colour))
         return false;
 
-    Board clone = *this;
-    clone.apply_illegal_move(move, colour);
-    if (clone.in_check(colour))
+    return is_legal_pseudo_legal_move(move, colour);
+}
+
+bool Board::is_legal_pseudo_legal_move(const Move& move, Colour colour) const
+{
+    if (leaves_king_in_check(move, colour))
         return false;
 
-    // Don't allow castling through check or out of check.
-    Vector<Square> check_squares;
-    if (colour == Colour::White && move.from == Square("e1") && get_piece(Square("e1")) == Piece(Colour::White, Type::King)) {
-        if (move.to == Square("a1") || move.to == Square("c1")) {
-            check_squares = { Square("e1"), Square("d1"), Square("c1") };
-        } else if (move.to == Square("h1") || move.to == Square("g1")) {
-            check_squares = { Square("e1"), Square("f1"), Square("g1") };
-        }
-    } else if (colour == Colour::Black && move.from == Square("e8") && get_piece(Square("e8")) == Piece(Colour::Black, Type::King)) {
-        if (move.to == Square("a8") || move.to == Square("c8")) {
-            check_squares = { Square("e8"), Square("d8"), Square("c8") };
-        } else if (move.to == Square("h8") || move.to == Square("g8")) {
-            check_squares = { Square("e8"), Square("f8"), Square("g8") };
-        }
+    // Don't allow castling through check or out of check. The square the king lands on was checked above.
+    unsigned king_square = (colour == Colour::White) ? 4 : 60;
+    if (index_of(move.from) != king_square || m_board[king_square] != Piece(colour, Type::King))
+        return true;
+
+    unsigned to = index_of(move.to);
+    unsigned crossed_square;
+    if (to == king_square - 4 || to == king_square - 2) {
+        crossed_square = king_square - 1;
+    } else if (to == king_square + 3 || to == king_square + 2) {
+        crossed_square = king_square + 1;
+    } else {
+        return true;
     }
-    for (auto& square : check_squares) {
-        Board clone = *this;
-        clone.set_piece(move.from, EmptyPiece);
-        clone.set_piece(square, { colour, Type::King });
-        if (clone.in_check(colour))
+
+    auto opponent = opposing_colour(colour);
+    Bitboard occupancy_without_king = occupancy() & ~bit(king_square);
+    for (auto square : { king_square, crossed_square }) {
+        if (is_attacked(square, opponent, m_pieces[(int)opponent], occupancy_without_king | bit(square)))
             return false;
     }
 
@@ -217,11 +428,11 @@ bool Board::is_legal(const Move& move, Colour colour) const
 
 bool Board::is_legal_no_check(const Move& move, Colour colour) const
 {
-    auto piece = get_piece(move.from);
-    if (piece.colour != colour)
+    if (!move.from.in_bounds() || !move.to.in_bounds())
         return false;
 
-    if (move.to.rank > 7 || move.to.file > 7)
+    auto piece = get_piece(move.from);
+    if (piece.colour != colour)
         return false;
 
     if (piece.type != Type::Pawn && move.promote_to != Type::None)
@@ -230,144 +441,184 @@ bool Board::is_legal_no_check(const Move& move, Colour colour) const
     if (move.promote_to == Type::Pawn || move.promote_to == Type::King)
         return false;
 
+    unsigned from = index_of(move.from);
+    unsigned to = index_of(move.to);
+
     if (piece.type == Type::Pawn) {
-        int dir = (colour == Colour::White) ? +1 : -1;
-        unsigned start_rank = (colour == Colour::White) ? 1 : 6;
-        unsigned other_start_rank = (colour == Colour::White) ? 6 : 1;
-        unsigned en_passant_rank = (colour == Colour::White) ? 4 : 3;
         unsigned promotion_rank = (colour == Colour::White) ? 7 : 0;
-
         if (move.to.rank == promotion_rank) {
-            if (move.promote_to == Type::Pawn || move.promote_to == Type::King || move.promote_to == Type::None)
+            if (move.promote_to == Type::None)
                 return false;
         } else if (move.promote_to != Type::None) {
             return false;
         }
+    }
 
-        if (move.to.rank == move.from.rank + dir && move.to.file == move.from.file && get_piece(move.to).type == Type::None) {
-            // Regular pawn move.
-            return true;
-        } else if (move.to.rank == move.from.rank + dir && (move.to.file == move.from.file + 1 || move.to.file == move.from.file - 1)) {
-            Move en_passant_last_move = { { other_start_rank, move.to.file }, { en_passant_rank, move.to.file } };
-            if (get_piece(move.to).colour == opposing_colour(colour)) {
-                // Pawn capture.
-                return true;
-            } else if (m_last_move.has_value() && move.from.rank == en_passant_rank && m_last_move.value() == en_passant_last_move
-                && get_piece(en_passant_last_move.to) == Piece(opposing_colour(colour), Type::Pawn)) {
-                // En passant.
-                return true;
-            }
-        } else if (move.from.rank == start_rank && move.to.rank == move.from.rank + (2 * dir) && move.to.file == move.from.file
-            && get_piece(move.to).type == Type::None && get_piece({ move.from.rank + dir, move.from.file }).type == Type::None) {
-            // 2 square pawn move from initial position.
-            return true;
-        }
+    // Castling may also be written as the king moving onto its own rook.
+    unsigned king_square = (colour == Colour::White) ? 4 : 60;
+    if (piece.type == Type::King && from == king_square) {
+        if (to == king_square - 4)
+            to = king_square - 2;
+        else if (to == king_square + 3)
+            to = king_square + 2;
+    }
 
-        return false;
-    } else if (piece.type == Type::Knight) {
-        int rank_delta = abs(move.to.rank - move.from.rank);
-        int file_delta = abs(move.to.file - move.from.file);
-        if (get_piece(move.to).colour != colour && max(rank_delta, file_delta) == 2 && min(rank_delta, file_delta) == 1) {
-            return true;
-        }
-    } else if (piece.type == Type::Bishop) {
-        int rank_delta = move.to.rank - move.from.rank;
-        int file_delta = move.to.file - move.from.file;
-        if (abs(rank_delta) == abs(file_delta)) {
-            int dr = rank_delta / abs(rank_delta);
-            int df = file_delta / abs(file_delta);
-            for (Square sq = move.from; sq != move.to; sq.rank += dr, sq.file += df) {
-                if (get_piece(sq).type != Type::None && sq != move.from) {
-                    return false;
-                }
-            }
-
-            if (get_piece(move.to).colour != colour) {
-                return true;
-            }
-        }
-    } else if (piece.type == Type::Rook) {
-        int rank_delta = move.to.rank - move.from.rank;
-        int file_delta = move.to.file - move.from.file;
-        if (rank_delta == 0 || file_delta == 0) {
-            int dr = (rank_delta) ? rank_delta / abs(rank_delta) : 0;
-            int df = (file_delta) ? file_delta / abs(file_delta) : 0;
-            for (Square sq = move.from; sq != move.to; sq.rank += dr, sq.file += df) {
-                if (get_piece(sq).type != Type::None && sq != move.from) {
-                    return false;
-                }
-            }
-
-            if (get_piece(move.to).colour != colour) {
-                return true;
-            }
-        }
-    } else if (piece.type == Type::Queen) {
-        int rank_delta = move.to.rank - move.from.rank;
-        int file_delta = move.to.file - move.from.file;
-        if (abs(rank_delta) == abs(file_delta) || rank_delta == 0 || file_delta == 0) {
-            int dr = (rank_delta) ? rank_delta / abs(rank_delta) : 0;
-            int df = (file_delta) ? file_delta / abs(file_delta) : 0;
-            for (Square sq = move.from; sq != move.to; sq.rank += dr, sq.file += df) {
-                if (get_piece(sq).type != Type::None && sq != move.from) {
-                    return false;
-                }
-            }
-
-            if (get_piece(move.to).colour != colour) {
-                return true;
-            }
+    return pseudo_legal_targets(from, colour) & bit(to);
+}
+
+Bitboard Board::pseudo_legal_targets(unsigned from, Colour colour) const
+{
+    auto& tables = Chess::tables();
+    auto opponent = opposing_colour(colour);
+    Bitboard own_pieces = m_occupancy[(int)colour];
+    Bitboard all_pieces = occupancy();
+
+    switch (m_board[from].type) {
+    case Type::Pawn: {
+        unsigned rank = from / 8;
+        unsigned start_rank = (colour == Colour::White) ? 1 : 6;
+        unsigned en_passant_rank = (colour == Colour::White) ? 4 : 3;
+        unsigned promotion_rank = (colour == Colour::White) ? 7 : 0;
+        if (rank == promotion_rank)
+            return 0;
+
+        int forward = (colour == Colour::White) ? 8 : -8;
+        Bitboard targets = tables.pawn_attacks[(int)colour][from] & m_occupancy[(int)opponent];
+        unsigned one_step = from + forward;
+        if (!(all_pieces & bit(one_step))) {
+            targets |= bit(one_step);
+            if (rank == start_rank && !(all_pieces & bit(one_step + forward)))
+                targets |= bit(one_step + forward);
         }
-    } else if (piece.type == Type::King) {
-        int rank_delta = move.to.rank - move.from.rank;
-        int file_delta = move.to.file - move.from.file;
-        if (abs(rank_delta) <= 1 && abs(file_delta) <= 1) {
-            if (get_piece(move.to).colour != colour) {
-                return true;
-            }
+
+        if (rank == en_passant_rank && m_last_move.has_value()) {
+            // En passant, right after an enemy pawn went past us with a two square move.
+            auto& last_move = m_last_move.value();
+            unsigned jumped_over = index_of(last_move.to) + forward;
+            if (last_move.from.file == last_move.to.file && last_move.to.rank == en_passant_rank
+                && last_move.from.rank == en_passant_rank + 2 * (forward / 8)
+                && m_board[index_of(last_move.to)] == Piece(opponent, Type::Pawn)
+                && (tables.pawn_attacks[(int)colour][from] & bit(jumped_over)))
+                targets |= bit(jumped_over);
         }
+        return targets;
+    }
+    case Type::Knight:
+        return tables.knight_attacks[from] & ~own_pieces;
+    case Type::Bishop:
+        return bishop_attacks(from, all_pieces) & ~own_pieces;
+    case Type::Rook:
+        return rook_attacks(from, all_pieces) & ~own_pieces;
+    case Type::Queen:
+        return (bishop_attacks(from, all_pieces) | rook_attacks(from, all_pieces)) & ~own_pieces;
+    case Type::King: {
+        Bitboard targets = tables.king_attacks[from] & ~own_pieces;
+        unsigned king_square = (colour == Colour::White) ? 4 : 60;
+        if (from != king_square)
+            return targets;
+
+        // The rook's path to the king has to be clear; whether the king passes through check is up to is_legal().
+        bool can_castle_queenside = (colour == Colour::White) ? m_white_can_castle_queenside : m_black_can_castle_queenside;
+        bool can_castle_kingside = (colour == Colour::White) ? m_white_can_castle_kingside : m_black_can_castle_kingside;
+        if (can_castle_queenside && !(all_pieces & (bit(from - 1) | bit(from - 2) | bit(from - 3))))
+            targets |= bit(from - 2);
+        if (can_castle_kingside && !(all_pieces & (bit(from + 1) | bit(from + 2))))
+            targets |= bit(from + 2);
+        return targets;
+    }
+    default:
+        return 0;
+    }
+}
 
-        if (colour == Colour::White) {
-            if ((move.to == Square("a1") || move.to == Square("c1")) && m_white_can_castle_queenside && get_piece(Square("b1")).type == Type::None && get_piece(Square("c1")).type == Type::None && get_piece(Square("d1")).type == Type::None) {
+bool Board::is_attacked(unsigned square, Colour attacker_colour, const Bitboard (&attackers)[6], Bitboard occupancy)
+{
+    auto& tables = Chess::tables();
+    // A pawn attacks the square if a pawn of the other colour standing there would attack the pawn.
+    if (tables.pawn_attacks[(int)opposing_colour(attacker_colour)][square] & attackers[(int)Type::Pawn])
+        return true;
+    if (tables.knight_attacks[square] & attackers[(int)Type::Knight])
+        return true;
+    if (tables.king_attacks[square] & attackers[(int)Type::King])
+        return true;
+    if (bishop_attacks(square, occupancy) & (attackers[(int)Type::Bishop] | attackers[(int)Type::Queen]))
+        return true;
+    if (rook_attacks(square, occupancy) & (attackers[(int)Type::Rook] | attackers[(int)Type::Queen]))
+        return true;
+    return false;
+}
 
-                return true;
-            } else if ((move.to == Square("h1") || move.to == Square("g1")) && m_white_can_castle_kingside && get_piece(Square("f1")).type == Type::None && get_piece(Square("g1")).type == Type::None) {
-                return true;
-            }
-        } else {
-            if ((move.to == Square("a8") || move.to == Square("c8")) && m_black_can_castle_queenside && get_piece(Square("b8")).type == Type::None && get_piece(Square("c8")).type == Type::None && get_piece(Square("d8")).type == Type::None) {
+bool Board::is_attacked(unsigned square, Colour attacker_colour) const
+{
+    return is_attacked(square, attacker_colour, m_pieces[(int)attacker_colour], occupancy());
+}
 
-                return true;
-            } else if ((move.to == Square("h8") || move.to == Square("g8")) && m_black_can_castle_kingside && get_piece(Square("f8")).type == Type::None && get_piece(Square("g8")).type == Type::None) {
-                return true;
-            }
+bool Board::leaves_king_in_check(const Move& move, Colour colour) const
+{
+    auto opponent = opposing_colour(colour);
+    unsigned from = index_of(move.from);
+    unsigned to = index_of(move.to);
+    auto piece = m_board[from];
+
+    unsigned captured = to;
+    if (piece.type == Type::Pawn && move.from.file != move.to.file && m_board[to].type == Type::None)
+        captured = (colour == Colour::White) ? to - 8 : to + 8;
+
+    Bitboard enemies[6];
+    for (int type = 0; type < 6; ++type)
+        enemies[type] = m_pieces[(int)opponent][type] & ~bit(captured);
+
+    Bitboard occupancy_after = (occupancy() & ~bit(from) & ~bit(captured)) | bit(to);
+
+    Bitboard king = pieces(colour, Type::King);
+    if (piece.type == Type::King) {
+        unsigned king_square = (colour == Colour::White) ? 4 : 60;
+        if (from == king_square && (to == king_square - 4 || to == king_square - 2)) {
+            to = king_square - 2;
+            occupancy_after = (occupancy() & ~bit(from) & ~bit(king_square - 4)) | bit(king_square - 2) | bit(king_square - 1);
+        } else if (from == king_square && (to == king_square + 3 || to == king_square + 2)) {
+            to = king_square + 2;
+            occupancy_after = (occupancy() & ~bit(from) & ~bit(king_square + 3)) | bit(king_square + 2) | bit(king_square + 1);
         }
+        king = bit(to);
     }
 
-    return false;
+    if (!king)
+        return false;
+
+    return is_attacked(__builtin_ctzll(king), opponent, enemies, occupancy_after);
 }
 
 bool Board::in_check(Colour colour) const
 {
-    Square king_square = { 50, 50 };
-    Square::for_each([&](const Square& square) {
-        if (get_piece(square) == Piece(colour, Type::King)) {
-            king_square = square;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
+    Bitboard king = pieces(colour, Type::King);
+    if (!king)
+        return false;
 
-    bool check = false;
-    Square::for_each([&](const Square& square) {
-        if (is_legal_no_check({ square, king_square }, opposing_colour(colour))) {
-            check = true;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
+    return is_attacked(__builtin_ctzll(king), opposing_colour(colour));
+}
+
+u64 Board::zobrist_key() const
+{
+    auto& tables = Chess::tables();
+    u64 key = m_piece_key;
+    if (m_white_can_castle_kingside)
+        key ^= tables.castling_keys[0];
+    if (m_white_can_castle_queenside)
+        key ^= tables.castling_keys[1];
+    if (m_black_can_castle_kingside)
+        key ^= tables.castling_keys[2];
+    if (m_black_can_castle_queenside)
+        key ^= tables.castling_keys[3];
+    if (m_turn == Colour::Black)
+        key ^= tables.black_to_move_key;
+    return key;
+}
 
-    return check;
+u32 Board::hash() const
+{
+    u64 key = zobrist_key();
+    return key ^ (key >> 32);
 }
 
 bool Board::apply_move(const Move& move, Colour colour)
@@ -383,14 +634,7 @@ bool Board::apply_move(const Move& move, Colour colour)
 
 bool Board::apply_illegal_move(const Move& move, Colour colour)
 {
-    Board clone = *this;
-    clone.m_previous_states = {};
-    clone.m_moves = {};
-    auto state_count = 0;
-    if (m_previous_states.contains(clone))
-        state_count = m_previous_states.get(clone).value();
-
-    m_previous_states.set(clone, state_count + 1);
+    m_previous_keys.append(zobrist_key());
     m_moves.append(move);
 
     m_turn = opposing_colour(colour);
@@ -482,40 +726,26 @@ Move Board::random_move(Colour colour) const
 
 Board::Result Board::game_result() const
 {
-    bool sufficient_material = false;
-    bool no_more_pieces_allowed = false;
-    Optional<Square> bishop;
-    Square::for_each([&](Square sq) {
-        if (get_piece(sq).type == Type::Queen || get_piece(sq).type == Type::Rook || get_piece(sq).type == Type::Pawn) {
-            sufficient_material = true;
-            return IterationDecision::Break;
-        }
-
-        if (get_piece(sq).type != Type::None && get_piece(sq).type != Type::King && no_more_pieces_allowed) {
-            sufficient_material = true;
-            return IterationDecision::Break;
-        }
-
-        if (get_piece(sq).type == Type::Knight)
-            no_more_pieces_allowed = true;
-
-        if (get_piece(sq).type == Type::Bishop) {
-            if (bishop.has_value()) {
-                if (get_piece(sq).colour == get_piece(bishop.value()).colour) {
-                    sufficient_material = true;
-                    return IterationDecision::Break;
-                } else if (sq.is_light() != bishop.value().is_light()) {
-                    sufficient_material = true;
-                    return IterationDecision::Break;
-                }
-                no_more_pieces_allowed = true;
-            } else {
-                bishop = sq;
-            }
+    // Only a lone minor piece, or a bishop each on the same shade of square, can't mate.
+    Bitboard heavy_pieces_and_pawns = 0;
+    Bitboard bishops = 0;
+    Bitboard minor_pieces = 0;
+    for (int colour = 0; colour < 2; ++colour) {
+        heavy_pieces_and_pawns |= m_pieces[colour][(int)Type::Pawn] | m_pieces[colour][(int)Type::Rook] | m_pieces[colour][(int)Type::Queen];
+        bishops |= m_pieces[colour][(int)Type::Bishop];
+        minor_pieces |= m_pieces[colour][(int)Type::Bishop] | m_pieces[colour][(int)Type::Knight];
+    }
+    bool sufficient_material = true;
+    if (!heavy_pieces_and_pawns) {
+        int minor_piece_count = __builtin_popcountll(minor_pieces);
+        if (minor_piece_count <= 1) {
+            sufficient_material = false;
+        } else if (minor_piece_count == 2 && minor_pieces == bishops) {
+            bool one_each = pieces(Colour::White, Type::Bishop) && pieces(Colour::Black, Type::Bishop);
+            bool same_shade = !(bishops & light_squares) || !(bishops & ~light_squares);
+            sufficient_material = !(one_each && same_shade);
         }
-
-        return IterationDecision::Continue;
-    });
+    }
 
     if (!sufficient_material)
         return Result::InsufficientMaterial;
@@ -533,13 +763,18 @@ Board::Result Board::game_result() const
         if (m_moves_since_capture == 50 * 2)
             return Result::FiftyMoveRule;
 
-        auto repeats = m_previous_states.get(*this);
-        if (repeats.has_value()) {
-            if (repeats.value() == 3)
-                return Result::ThreeFoldRepitition;
-            if (repeats.value() >= 5)
-                return Result::FiveFoldRepitition;
+        // Positions from before the last capture can't come back, so there's no need to look at them.
+        u64 key = zobrist_key();
+        int repeats = 0;
+        size_t first_candidate = m_previous_keys.size() - min(m_previous_keys.size(), (size_t)m_moves_since_capture);
+        for (size_t i = first_candidate; i < m_previous_keys.size(); ++i) {
+            if (m_previous_keys[i] == key)
+                ++repeats;
         }
+        if (repeats == 3)
+            return Result::ThreeFoldRepitition;
+        if (repeats >= 5)
+            return Result::FiveFoldRepitition;
 
         return Result::NotFinished;
     }
@@ -578,34 +813,12 @@ bool Board::game_finished() const
 
 int Board::material_imbalance() const
 {
+    static constexpr int values[] = { 1, 3, 3, 5, 9 };
     int imbalance = 0;
-    Square::for_each([&](Square square) {
-        int value = 0;
-        switch (get_piece(square).type) {
-        case Type::Pawn:
-            value = 1;
-            break;
-        case Type::Knight:
-        case Type::Bishop:
-            value = 3;
-            break;
-        case Type::Rook:
-            value = 5;
-            break;
-        case Type::Queen:
-            value = 9;
-            break;
-        default:
-            break;
-        }
-
-        if (get_piece(square).colour == Colour::White) {
-            imbalance += value;
-        } else {
-            imbalance -= value;
-        }
-        return IterationDecision::Continue;
-    });
+    for (int type = 0; type < 5; ++type) {
+        imbalance += values[type] * __builtin_popcountll(m_pieces[(int)Colour::White][type]);
+        imbalance -= values[type] * __builtin_popcountll(m_pieces[(int)Colour::Black][type]);
+    }
     return imbalance;
 }
 
@@ -627,17 +840,16 @@ bool Board::is_promotion_move(const Move& move, Colour colour) const
 
 bool Board::operator==(const Board& other) const
 {
-    bool equal_squares = true;
-    Square::for_each([&](Square sq) {
-        if (get_piece(sq) != other.get_piece(sq)) {
-            equal_squares = false;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-    if (!equal_squares)
+    if (m_piece_key != other.m_piece_key)
         return false;
 
+    for (int colour = 0; colour < 2; ++colour) {
+        for (int type = 0; type < 6; ++type) {
+            if (m_pieces[colour][type] != other.m_pieces[colour][type])
+                return false;
+        }
+    }
+
     if (m_white_can_castle_queenside != other.m_white_can_castle_queenside)
         return false;
     if (m_white_can_castle_kingside != other.m_white_can_castle_kingside)
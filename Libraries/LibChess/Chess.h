@@ -117,6 +117,9 @@ struct Move {
     String to_long_algebraic() const;
 };
 
+// A set of squares, one bit per square. Square (rank, file) is bit rank * 8 + file.
+using Bitboard = u64;
+
 class Board {
 public:
     Board();
@@ -155,13 +158,42 @@ public:
     Colour turn() const { return m_turn; }
     const Vector<Move>& moves() const { return m_moves; }
 
+    // A Zobrist hash of the pieces, the castling rights and the side to move.
+    u32 hash() const;
+    u64 zobrist_key() const;
+
     bool operator==(const Board& other) const;
 
 private:
+    static unsigned index_of(const Square& square) { return square.rank * 8 + square.file; }
+    static Square square_at(unsigned index) { return { index / 8, index % 8 }; }
+    static unsigned pop_lowest_square(Bitboard& bitboard)
+    {
+        unsigned index = __builtin_ctzll(bitboard);
+        bitboard &= bitboard - 1;
+        return index;
+    }
+
+    Bitboard pieces(Colour colour, Type type) const { return m_pieces[(int)colour][(int)type]; }
+    Bitboard occupancy() const { return m_occupancy[0] | m_occupancy[1]; }
+
+    // Whether any piece in `attackers` (indexed by type, all of one colour) attacks the square, given the occupancy.
+    static bool is_attacked(unsigned square, Colour attacker_colour, const Bitboard (&attackers)[6], Bitboard occupancy);
+    bool is_attacked(unsigned square, Colour attacker_colour) const;
+
+    // The squares the piece on `from` could move to, without looking at promotions or checks.
+    // Castling shows up as the king moving two squares.
+    Bitboard pseudo_legal_targets(unsigned from, Colour colour) const;
+    bool leaves_king_in_check(const Move&, Colour colour) const;
+    bool is_legal_pseudo_legal_move(const Move&, Colour colour) const;
     bool is_legal_no_check(const Move&, Colour colour) const;
     bool apply_illegal_move(const Move&, Colour colour);
 
-    Piece m_board[8][8];
+    Piece m_board[64];
+    Bitboard m_pieces[2][6] {};
+    Bitboard m_occupancy[2] {};
+    u64 m_piece_key { 0 };
+
     Colour m_turn { Colour::White };
     Optional<Move> m_last_move;
     int m_moves_since_capture { 0 };
@@ -171,9 +203,9 @@ private:
     bool m_black_can_castle_kingside { true };
     bool m_black_can_castle_queenside { true };
 
-    HashMap<Board, int> m_previous_states;
+    // The keys of the positions before each move, oldest first.
+    Vector<u64> m_previous_keys;
     Vector<Move> m_moves;
-    friend struct AK::Traits<Board>;
 };
 
 template<typename Callback>
@@ -182,93 +214,31 @@ void Board::generate_moves(Callback callback, Colour colour) const
     if (colour == Colour::None)
         colour = turn();
 
-    auto try_move = [&](Move m) {
-        if (is_legal(m, colour)) {
-            if (callback(m) == IterationDecision::Break)
-                return false;
-        }
-        return true;
-    };
-
-    Square::for_each([&](Square sq) {
-        auto piece = get_piece(sq);
-        if (piece.colour != colour)
-            return IterationDecision::Continue;
-
-        bool keep_going = true;
-        if (piece.type == Type::Pawn) {
-            for (auto& piece : Vector({ Type::None, Type::Knight, Type::Bishop, Type::Rook, Type::Queen })) {
-                keep_going = try_move({ sq, { sq.rank + 1, sq.file }, piece })
-                    && try_move({ sq, { sq.rank + 2, sq.file }, piece })
-                    && try_move({ sq, { sq.rank - 1, sq.file }, piece })
-                    && try_move({ sq, { sq.rank - 2, sq.file }, piece })
-                    && try_move({ sq, { sq.rank + 1, sq.file + 1 }, piece })
-                    && try_move({ sq, { sq.rank + 1, sq.file - 1 }, piece })
-                    && try_move({ sq, { sq.rank - 1, sq.file + 1 }, piece })
-                    && try_move({ sq, { sq.rank - 1, sq.file - 1 }, piece });
-            }
-        } else if (piece.type == Type::Knight) {
-            keep_going = try_move({ sq, { sq.rank + 2, sq.file + 1 } })
-                && try_move({ sq, { sq.rank + 2, sq.file - 1 } })
-                && try_move({ sq, { sq.rank + 1, sq.file + 2 } })
-                && try_move({ sq, { sq.rank + 1, sq.file - 2 } })
-                && try_move({ sq, { sq.rank - 2, sq.file + 1 } })
-                && try_move({ sq, { sq.rank - 2, sq.file - 1 } })
-                && try_move({ sq, { sq.rank - 1, sq.file + 2 } })
-                && try_move({ sq, { sq.rank - 1, sq.file - 2 } });
-        } else if (piece.type == Type::Bishop) {
-            for (int dr = -1; dr <= 1; dr += 2) {
-                for (int df = -1; df <= 1; df += 2) {
-                    for (Square to = sq; to.in_bounds(); to = { to.rank + dr, to.file + df }) {
-                        if (!try_move({ sq, to }))
-                            return IterationDecision::Break;
-                    }
-                }
-            }
-        } else if (piece.type == Type::Rook) {
-            for (int dr = -1; dr <= 1; dr++) {
-                for (int df = -1; df <= 1; df++) {
-                    if ((dr == 0) != (df == 0)) {
-                        for (Square to = sq; to.in_bounds(); to = { to.rank + dr, to.file + df }) {
-                            if (!try_move({ sq, to }))
-                                return IterationDecision::Break;
-                        }
-                    }
-                }
-            }
-        } else if (piece.type == Type::Queen) {
-            for (int dr = -1; dr <= 1; dr++) {
-                for (int df = -1; df <= 1; df++) {
-                    if (dr != 0 || df != 0) {
-                        for (Square to = sq; to.in_bounds(); to = { to.rank + dr, to.file + df }) {
-                            if (!try_move({ sq, to }))
-                                return IterationDecision::Break;
-                        }
-                    }
-                }
-            }
-        } else if (piece.type == Type::King) {
-            for (int dr = -1; dr <= 1; dr++) {
-                for (int df = -1; df <= 1; df++) {
-                    if (!try_move({ sq, { sq.rank + dr, sq.file + df } }))
-                        return IterationDecision::Break;
-                }
+    static constexpr Type promotion_types[] = { Type::Knight, Type::Bishop, Type::Rook, Type::Queen };
+    unsigned promotion_rank = (colour == Colour::White) ? 7 : 0;
+
+    Bitboard own_pieces = m_occupancy[(int)colour];
+    while (own_pieces) {
+        unsigned from = pop_lowest_square(own_pieces);
+        bool is_pawn = m_board[from].type == Type::Pawn;
+        Bitboard targets = pseudo_legal_targets(from, colour);
+        while (targets) {
+            Move move = { square_at(from), square_at(pop_lowest_square(targets)) };
+            if (!is_pawn || move.to.rank != promotion_rank) {
+                if (is_legal_pseudo_legal_move(move, colour) && callback(move) == IterationDecision::Break)
+                    return;
+                continue;
             }
-
-            // Castling moves.
-            if (sq == Square("e1")) {
-                keep_going = try_move({ sq, Square("c1") }) && try_move({ sq, Square("g1") });
-            } else if (sq == Square("e8")) {
-                keep_going = try_move({ sq, Square("c8") }) && try_move({ sq, Square("g8") });
+            // Whether a pawn may go there doesn't depend on what it turns into.
+            if (!is_legal_pseudo_legal_move(move, colour))
+                continue;
+            for (auto type : promotion_types) {
+                move.promote_to = type;
+                if (callback(move) == IterationDecision::Break)
+                    return;
             }
         }
-
-        if (keep_going) {
-            return IterationDecision::Continue;
-        } else {
-            return IterationDecision::Break;
-        }
-    });
+    }
 }
 
 }
@@ -283,21 +253,5 @@ struct AK::Traits<Chess::Piece> : public GenericTraits<Chess::Piece> {
 
 template<>
 struct AK::Traits<Chess::Board> : public GenericTraits<Chess::Board> {
-    static unsigned hash(Chess::Board chess)
-    {
-        unsigned hash = 0;
-        hash = pair_int_hash(hash, static_cast<u32>(chess.m_white_can_castle_queenside));
-        hash = pair_int_hash(hash, static_cast<u32>(chess.m_white_can_castle_kingside));
-        hash = pair_int_hash(hash, static_cast<u32>(chess.m_black_can_castle_queenside));
-        hash = pair_int_hash(hash, static_cast<u32>(chess.m_black_can_castle_kingside));
-
-        hash = pair_int_hash(hash, static_cast<u32>(chess.m_black_can_castle_kingside));
-
-        Chess::Square::for_each([&](Chess::Square sq) {
-            hash = pair_int_hash(hash, Traits<Chess::Piece>::hash(chess.get_piece(sq)));
-            return IterationDecision::Continue;
-        });
-
-        return hash;
-    }
+    static unsigned hash(const Chess::Board& chess) { return chess.hash(); }
 };
@@ -26,403 +26,1043 @@
 
 #include <AK/Assertions.h>
 #include <AK/LogStream.h>
+#include <AK/QuickSort.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
-#include <AK/Vector.h>
 #include <LibCompress/Deflate.h>
+#include <string.h>
 
 namespace Compress {
 
-bool DeflateStream::read_next_block() const
+void BitStreamReader::refill(u8 count)
 {
-    if (m_read_last_block)
-        return false;
+    while (m_buffered_bits < count) {
+        u8 byte = 0;
+        if (m_padding_bits || !m_stream.read({ &byte, sizeof(byte) }))
+            m_padding_bits += 8;
+        m_buffer |= (u64)byte << m_buffered_bits;
+        m_buffered_bits += 8;
+    }
+}
 
-    m_read_last_block = m_reader.read_bits(1);
-    auto block_type = m_reader.read_bits(2);
+size_t BitStreamReader::read_aligned_bytes(Bytes bytes)
+{
+    ASSERT(m_buffered_bits % 8 == 0);
+
+    size_t nread = 0;
+    while (m_buffered_bits && nread < bytes.size())
+        bytes[nread++] = read_bits(8);
+    if (overrun())
+        return 0;
+    if (nread < bytes.size() && !m_padding_bits)
+        nread += m_stream.read(bytes.slice(nread));
+    return nread;
+}
 
-    switch (block_type) {
-    case 0:
-        decompress_uncompressed_block();
-        break;
-    case 1:
-        decompress_static_block();
-        break;
-    case 2:
-        decompress_dynamic_block();
-        break;
-    case 3:
-        dbg() << "Block contains reserved block type...";
-        ASSERT_NOT_REACHED();
-        break;
-    default:
-        dbg() << "Invalid block type was read...";
-        ASSERT_NOT_REACHED();
-        break;
+Optional<CanonicalCode> CanonicalCode::from_lengths(ReadonlyBytes lengths)
+{
+    if (lengths.size() > max_symbol_count)
+        return {};
+
+    CanonicalCode code;
+    for (auto length : lengths) {
+        if (length > max_code_length)
+            return {};
+        ++code.m_length_counts[length];
+    }
+    code.m_length_counts[0] = 0;
+
+    // Codes that don't use up all of their bit patterns are allowed; deflate has to deal with a
+    // single distance code, for example. Decoding one of the missing patterns is an error though.
+    int left = 1;
+    for (size_t length = 1; length <= max_code_length; ++length) {
+        left = (left << 1) - code.m_length_counts[length];
+        if (left < 0) {
+            dbg() << "Canonical code overflows the huffman tree";
+            return {};
+        }
     }
 
-    return true;
+    u16 offsets[max_code_length + 1] {};
+    for (size_t length = 1; length < max_code_length; ++length)
+        offsets[length + 1] = offsets[length] + code.m_length_counts[length];
+    for (size_t symbol = 0; symbol < lengths.size(); ++symbol) {
+        if (lengths[symbol])
+            code.m_symbols[offsets[lengths[symbol]]++] = symbol;
+    }
+
+    // The codes are stored most significant bit first, while the stream hands them out least
+    // significant bit first. So the table is indexed by the reversed code, with every possible
+    // combination of the bits that follow it.
+    u32 next_code = 0;
+    size_t index = 0;
+    for (size_t length = 1; length <= fast_bits; ++length) {
+        for (size_t i = 0; i < code.m_length_counts[length]; ++i, ++next_code, ++index) {
+            u32 reversed_code = 0;
+            for (size_t bit = 0; bit < length; ++bit)
+                reversed_code |= ((next_code >> bit) & 1) << (length - bit - 1);
+            for (u32 entry = reversed_code; entry < (1 << fast_bits); entry += 1 << length)
+                code.m_fast_table[entry] = code.m_symbols[index] << 4 | length;
+        }
+        next_code <<= 1;
+    }
+
+    return code;
 }
 
-void DeflateStream::decompress_uncompressed_block() const
+u32 CanonicalCode::read_symbol_slow(BitStreamReader& reader) const
 {
-    // Align to the next byte boundary.
-    while (m_reader.get_bit_byte_offset() != 0) {
-        m_reader.read();
+    // Walk the code one bit at a time. The codes of each length are consecutive numbers starting
+    // at `first`, and their symbols are found at `index` onwards.
+    u32 code = 0;
+    u32 first = 0;
+    u32 index = 0;
+    for (size_t length = 1; length <= max_code_length; ++length) {
+        code |= reader.read_bits(1);
+        u32 count = m_length_counts[length];
+        if (code - first < count)
+            return m_symbols[index + code - first];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
     }
+    return invalid_symbol;
+}
 
-    auto length = m_reader.read_bits(16) & 0xFFFF;
-    auto negated_length = m_reader.read_bits(16) & 0xFFFF;
+static const CanonicalCode& fixed_literal_length_codes()
+{
+    static Optional<CanonicalCode> codes;
+    if (!codes.has_value()) {
+        u8 lengths[288];
+        memset(lengths + 0, 8, 144 - 0);
+        memset(lengths + 144, 9, 256 - 144);
+        memset(lengths + 256, 7, 280 - 256);
+        memset(lengths + 280, 8, 288 - 280);
+        codes = CanonicalCode::from_lengths({ lengths, sizeof(lengths) });
+    }
+    return codes.value();
+}
 
-    if ((length ^ 0xFFFF) != negated_length) {
-        dbg() << "Block length is invalid...";
-        ASSERT_NOT_REACHED();
+static const CanonicalCode& fixed_distance_codes()
+{
+    static Optional<CanonicalCode> codes;
+    if (!codes.has_value()) {
+        u8 lengths[32];
+        memset(lengths, 5, sizeof(lengths));
+        codes = CanonicalCode::from_lengths({ lengths, sizeof(lengths) });
     }
+    return codes.value();
+}
 
-    for (size_t i = 0; i < length; i++) {
-        auto byte = m_reader.read_byte();
-        if (byte < 0) {
-            dbg() << "Ran out of bytes while reading uncompressed block...";
-            ASSERT_NOT_REACHED();
-        }
+Optional<ByteBuffer> DeflateStream::decompress_all(ReadonlyBytes bytes)
+{
+    InputMemoryStream memory_stream { bytes };
+    DeflateStream deflate_stream { memory_stream };
 
-        m_intermediate_stream << byte;
+    auto output = ByteBuffer::create_uninitialized(max(bytes.size() * 2, (size_t)4096));
+    size_t output_size = 0;
+    for (;;) {
+        if (output_size == output.size())
+            output.grow(output.size() * 2);
+        auto nread = deflate_stream.read(output.bytes().slice(output_size));
+        if (!nread)
+            break;
+        output_size += nread;
     }
+
+    if (deflate_stream.handle_error())
+        return {};
+
+    output.trim(output_size);
+    return output;
 }
 
-void DeflateStream::decompress_static_block() const
+DeflateStream::DeflateStream(InputStream& stream)
+    : m_reader(stream)
 {
-    decompress_huffman_block(m_literal_length_codes, &m_fixed_distance_codes);
 }
 
-void DeflateStream::decompress_dynamic_block() const
+size_t DeflateStream::read(Bytes bytes)
 {
-    auto codes = decode_huffman_codes();
-    if (codes.size() == 2) {
-        decompress_huffman_block(codes[0], &codes[1]);
-    } else {
-        decompress_huffman_block(codes[0], nullptr);
+    size_t nread = 0;
+    while (nread < bytes.size()) {
+        if (!m_unread_size && !decompress_more())
+            break;
+        auto read_position = (m_write_position - m_unread_size) % window_size;
+        auto count = min(min(bytes.size() - nread, m_unread_size), window_size - read_position);
+        memcpy(bytes.data() + nread, m_window.data() + read_position, count);
+        nread += count;
+        m_unread_size -= count;
     }
+    return nread;
 }
 
-void DeflateStream::decompress_huffman_block(CanonicalCode& length_codes, CanonicalCode* distance_codes) const
+bool DeflateStream::read_or_error(Bytes bytes)
 {
-    for (;;) {
-        u32 symbol = length_codes.next_symbol(m_reader);
+    if (read(bytes) < bytes.size()) {
+        m_error = true;
+        return false;
+    }
+    return true;
+}
 
-        // End of block.
-        if (symbol == 256) {
+bool DeflateStream::eof() const
+{
+    if (m_unread_size)
+        return false;
+    return !const_cast<DeflateStream&>(*this).decompress_more();
+}
+
+bool DeflateStream::discard_or_error(size_t count)
+{
+    while (count) {
+        if (!m_unread_size && !decompress_more()) {
+            m_error = true;
+            return false;
+        }
+        auto discarded = min(count, m_unread_size);
+        count -= discarded;
+        m_unread_size -= discarded;
+    }
+    return true;
+}
+
+void DeflateStream::fail()
+{
+    m_error = true;
+    m_state = State::Finished;
+}
+
+bool DeflateStream::decompress_more()
+{
+    while (m_unread_size < history_size) {
+        switch (m_state) {
+        case State::Idle:
+            if (m_read_final_block)
+                m_state = State::Finished;
+            else
+                read_block_header();
+            break;
+        case State::ReadingCompressedBlock:
+            decompress_huffman_block();
             break;
+        case State::ReadingUncompressedBlock:
+            decompress_uncompressed_block();
+            break;
+        case State::Finished:
+            return m_unread_size > 0;
         }
+    }
+    return true;
+}
+
+void DeflateStream::read_block_header()
+{
+    m_read_final_block = m_reader.read_bits(1);
+    auto block_type = m_reader.read_bits(2);
+    if (m_reader.overrun()) {
+        dbg() << "Ran out of bytes while reading block header...";
+        fail();
+        return;
+    }
+
+    switch (block_type) {
+    case 0: {
+        m_reader.align_to_byte_boundary();
+        auto length = m_reader.read_bits(16);
+        auto negated_length = m_reader.read_bits(16);
+        if ((length ^ 0xFFFF) != negated_length || m_reader.overrun()) {
+            dbg() << "Block length is invalid...";
+            fail();
+            return;
+        }
+        m_uncompressed_bytes_left = length;
+        m_state = State::ReadingUncompressedBlock;
+        break;
+    }
+    case 1:
+        m_literal_length_codes = fixed_literal_length_codes();
+        m_distance_codes = fixed_distance_codes();
+        m_state = State::ReadingCompressedBlock;
+        break;
+    case 2:
+        if (!decode_huffman_codes()) {
+            fail();
+            return;
+        }
+        m_state = State::ReadingCompressedBlock;
+        break;
+    default:
+        dbg() << "Block contains reserved block type...";
+        fail();
+        break;
+    }
+}
+
+void DeflateStream::decompress_uncompressed_block()
+{
+    while (m_uncompressed_bytes_left && m_unread_size < history_size) {
+        auto write_position = m_write_position % window_size;
+        auto count = min(min(m_uncompressed_bytes_left, history_size - m_unread_size), window_size - write_position);
+        auto nread = m_reader.read_aligned_bytes({ m_window.data() + write_position, count });
+        if (!nread) {
+            dbg() << "Ran out of bytes while reading uncompressed block...";
+            fail();
+            return;
+        }
+        m_write_position += nread;
+        m_unread_size += nread;
+        m_history_available = min(m_history_available + nread, history_size);
+        m_uncompressed_bytes_left -= nread;
+    }
+
+    if (!m_uncompressed_bytes_left)
+        m_state = State::Idle;
+}
+
+void DeflateStream::decompress_huffman_block()
+{
+    auto& literal_length_codes = m_literal_length_codes.value();
+
+    // Every symbol adds at most 258 bytes, so this stays well within the window.
+    while (m_unread_size < history_size) {
+        auto symbol = literal_length_codes.read_symbol(m_reader);
 
-        // literal byte.
         if (symbol < 256) {
-            m_intermediate_stream << static_cast<u8>(symbol);
+            write_byte(symbol);
+            if (m_history_available < history_size)
+                ++m_history_available;
             continue;
         }
 
-        // Length and distance for copying.
-        ASSERT(distance_codes);
+        // End of block.
+        if (symbol == 256) {
+            m_state = State::Idle;
+            break;
+        }
 
-        auto run = decode_run_length(symbol);
-        if (run < 3 || run > 258) {
+        u32 length;
+        if (!decode_run_length(symbol, length)) {
             dbg() << "Invalid run length";
-            ASSERT_NOT_REACHED();
+            fail();
+            return;
         }
 
-        auto distance_symbol = distance_codes->next_symbol(m_reader);
-        auto distance = decode_distance(distance_symbol);
-        if (distance < 1 || distance > 32768) {
+        if (!m_distance_codes.has_value()) {
+            dbg() << "Block has no distance codes";
+            fail();
+            return;
+        }
+
+        u32 distance;
+        if (!decode_distance(m_distance_codes.value().read_symbol(m_reader), distance)) {
             dbg() << "Invalid distance";
-            ASSERT_NOT_REACHED();
+            fail();
+            return;
+        }
+
+        if (!copy_from_history(distance, length)) {
+            dbg() << "Distance reaches past the start of the data";
+            fail();
+            return;
         }
+    }
 
-        copy_from_history(distance, run);
+    if (m_reader.overrun()) {
+        dbg() << "Ran out of bytes while reading compressed block...";
+        fail();
     }
 }
 
-Vector<CanonicalCode> DeflateStream::decode_huffman_codes() const
+bool DeflateStream::decode_huffman_codes()
 {
-    // FIXME: This path is not tested.
-    Vector<CanonicalCode> result;
-
     auto length_code_count = m_reader.read_bits(5) + 257;
     auto distance_code_count = m_reader.read_bits(5) + 1;
+    auto code_length_count = m_reader.read_bits(4) + 4;
 
-    size_t length_code_code_length = m_reader.read_bits(4) + 4;
+    static constexpr u8 code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    u8 code_length_code_lengths[19] {};
+    for (size_t i = 0; i < code_length_count; i++)
+        code_length_code_lengths[code_length_order[i]] = m_reader.read_bits(3);
 
-    Vector<u8> code_length_code_length;
-    code_length_code_length.resize(19);
-    code_length_code_length[16] = m_reader.read_bits(3);
-    code_length_code_length[17] = m_reader.read_bits(3);
-    code_length_code_length[18] = m_reader.read_bits(3);
-    code_length_code_length[0] = m_reader.read_bits(3);
-    for (size_t i = 0; i < length_code_code_length; i++) {
-        auto index = (i % 2 == 0) ? (8 + (i / 2)) : (7 - (i / 2));
-        code_length_code_length[index] = m_reader.read_bits(3);
-    }
-
-    auto code_length_code = CanonicalCode(code_length_code_length);
+    auto code_length_code = CanonicalCode::from_lengths({ code_length_code_lengths, sizeof(code_length_code_lengths) });
+    if (!code_length_code.has_value())
+        return false;
 
-    Vector<u32> code_lens;
-    code_lens.resize(length_code_count + distance_code_count);
+    u8 code_lengths[288 + 32];
+    auto code_lengths_count = length_code_count + distance_code_count;
 
-    for (size_t index = 0; index < code_lens.capacity();) {
-        auto symbol = code_length_code.next_symbol(m_reader);
+    for (size_t index = 0; index < code_lengths_count;) {
+        auto symbol = code_length_code.value().read_symbol(m_reader);
 
         if (symbol <= 15) {
-            code_lens[index] = symbol;
+            code_lengths[index] = symbol;
             index++;
             continue;
         }
 
         u32 run_length;
-        u32 run_value = 0;
+        u8 run_value = 0;
 
         if (symbol == 16) {
             if (index == 0) {
                 dbg() << "No code length value avaliable";
-                ASSERT_NOT_REACHED();
+                return false;
             }
 
             run_length = m_reader.read_bits(2) + 3;
-            run_value = code_lens[index - 1];
+            run_value = code_lengths[index - 1];
         } else if (symbol == 17) {
             run_length = m_reader.read_bits(3) + 3;
         } else if (symbol == 18) {
             run_length = m_reader.read_bits(7) + 11;
         } else {
             dbg() << "Code symbol is out of range!";
-            ASSERT_NOT_REACHED();
+            return false;
         }
 
         u32 end = index + run_length;
-        if (end > code_lens.capacity()) {
+        if (end > code_lengths_count) {
             dbg() << "Code run is out of range!";
-            ASSERT_NOT_REACHED();
+            return false;
         }
 
-        memset(code_lens.data() + index, run_value, run_length);
+        memset(code_lengths + index, run_value, run_length);
         index = end;
     }
 
-    Vector<u8> literal_codes;
-    literal_codes.resize(length_code_count);
-    memcpy(literal_codes.data(), code_lens.data(), literal_codes.capacity());
-    result.append(CanonicalCode(literal_codes));
-
-    Vector<u8> distance_codes;
-    distance_codes.resize(distance_code_count);
-    memcpy(distance_codes.data(), code_lens.data() + length_code_count, distance_codes.capacity());
-
-    if (distance_code_count == 1 && distance_codes[0] == 0) {
-        return result;
+    if (m_reader.overrun()) {
+        dbg() << "Ran out of bytes while reading huffman codes...";
+        return false;
     }
 
-    u8 one_count = 0;
-    u8 other_count = 0;
-
-    for (size_t i = 0; i < distance_codes.capacity(); i++) {
-        u8 value = distance_codes.at(i);
-
-        if (value == 1) {
-            one_count++;
-        } else if (value > 1) {
-            other_count++;
-        }
-    }
+    m_literal_length_codes = CanonicalCode::from_lengths({ code_lengths, length_code_count });
+    if (!m_literal_length_codes.has_value())
+        return false;
 
-    if (one_count == 1 && other_count == 0) {
-        distance_codes.resize(32);
-        distance_codes[31] = 1;
+    // A single zero-length distance code means that the block only consists of literals.
+    if (distance_code_count == 1 && code_lengths[length_code_count] == 0) {
+        m_distance_codes.clear();
+        return true;
     }
 
-    result.append(CanonicalCode(distance_codes));
-    return result;
+    m_distance_codes = CanonicalCode::from_lengths({ code_lengths + length_code_count, distance_code_count });
+    return m_distance_codes.has_value();
 }
 
-u32 DeflateStream::decode_run_length(u32 symbol) const
+bool DeflateStream::decode_run_length(u32 symbol, u32& length)
 {
+    if (symbol <= 256)
+        return false;
+
     if (symbol <= 264) {
-        return symbol - 254;
+        length = symbol - 254;
+        return true;
     }
 
     if (symbol <= 284) {
         auto extra_bits = (symbol - 261) / 4;
-        return ((((symbol - 265) % 4) + 4) << extra_bits) + 3 + m_reader.read_bits(extra_bits);
+        length = ((((symbol - 265) % 4) + 4) << extra_bits) + 3 + m_reader.read_bits(extra_bits);
+        return true;
     }
 
     if (symbol == 285) {
-        return 258;
+        length = 258;
+        return true;
     }
 
-    dbg() << "Found invalid symbol in run length " << symbol;
-    ASSERT_NOT_REACHED();
+    return false;
 }
 
-u32 DeflateStream::decode_distance(u32 symbol) const
+bool DeflateStream::decode_distance(u32 symbol, u32& distance)
 {
     if (symbol <= 3) {
-        return symbol + 1;
+        distance = symbol + 1;
+        return true;
     }
 
     if (symbol <= 29) {
         auto extra_bits = (symbol / 2) - 1;
-        return (((symbol % 2) + 2) << extra_bits) + 1 + m_reader.read_bits(extra_bits);
+        distance = (((symbol % 2) + 2) << extra_bits) + 1 + m_reader.read_bits(extra_bits);
+        return true;
     }
 
-    dbg() << "Found invalid symbol in distance" << symbol;
-    ASSERT_NOT_REACHED();
+    return false;
 }
 
-void DeflateStream::copy_from_history(u32 distance, u32 run) const
+bool DeflateStream::copy_from_history(u32 distance, u32 length)
 {
-    for (size_t i = 0; i < run; i++) {
-        u8 byte;
+    if (distance > m_history_available)
+        return false;
 
-        // FIXME: In many cases we can read more than one byte at a time, this should
-        //        be refactored into a while loop. Beware, edge case:
-        //
-        //            // The first four bytes are on the stream already, the other four
-        //            // are written by copy_from_history() itself.
-        //            copy_from_history(4, 8);
-        m_intermediate_stream.read({ &byte, sizeof(byte) }, m_intermediate_stream.woffset() - distance);
-        m_intermediate_stream << byte;
+    auto* window = m_window.data();
+    auto source = (m_write_position - distance) % window_size;
+    auto destination = m_write_position % window_size;
+    if (distance >= length && source + length <= window_size && destination + length <= window_size) {
+        memcpy(window + destination, window + source, length);
+    } else {
+        // The source and destination either overlap or wrap around, so this has to go one byte at a time.
+        for (size_t i = 0; i < length; ++i)
+            window[(destination + i) % window_size] = window[(source + i) % window_size];
     }
+
+    m_write_position += length;
+    m_unread_size += length;
+    m_history_available = min(m_history_available + length, history_size);
+    return true;
 }
 
-i8 BitStreamReader::read()
+void BitStreamWriter::align_to_byte_boundary()
 {
-    if (m_current_byte == -1) {
-        return -1;
+    if (m_buffered_bits % 8)
+        write_bits(0, 8 - m_buffered_bits % 8);
+}
+
+void BitStreamWriter::write_aligned_bytes(ReadonlyBytes bytes)
+{
+    ASSERT(m_buffered_bits == 0);
+    flush_output();
+    m_stream.write_or_error(bytes);
+}
+
+void BitStreamWriter::flush()
+{
+    align_to_byte_boundary();
+    flush_output();
+}
+
+void BitStreamWriter::flush_output()
+{
+    if (!m_output_size)
+        return;
+    m_stream.write_or_error({ m_output, m_output_size });
+    m_output_size = 0;
+}
+
+static constexpr u16 length_bases[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static constexpr u8 length_extra_bits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static constexpr u16 distance_bases[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static constexpr u8 distance_extra_bits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static constexpr u8 code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+struct LengthCodeTable {
+    u8 data[259];
+
+    constexpr LengthCodeTable()
+        : data()
+    {
+        for (size_t code = 0; code < 29; ++code) {
+            for (size_t length = length_bases[code]; length < 259 && (code == 28 || length < length_bases[code + 1]); ++length)
+                data[length] = code;
+        }
+    }
+};
+
+static constexpr auto length_codes = LengthCodeTable();
+
+// Returns the index into length_bases, not the actual literal/length symbol.
+ALWAYS_INLINE static size_t length_code_for(size_t length)
+{
+    return length_codes.data[length];
+}
+
+ALWAYS_INLINE static size_t distance_code_for(size_t distance)
+{
+    u32 value = distance - 1;
+    if (value < 4)
+        return value;
+    u32 top_bit = 31 - __builtin_clz(value);
+    return 2 * top_bit + ((value >> (top_bit - 1)) & 1);
+}
+
+// Computes the code lengths of a Huffman code for the given frequencies, none of them longer than max_length.
+static void generate_huffman_lengths(u8* lengths, const u32* frequencies, size_t count, size_t max_length)
+{
+    // Two leaves and an internal node per leaf at most, see below.
+    static constexpr size_t max_count = 288;
+    ASSERT(count <= max_count);
+
+    u32 weights[2 * max_count];
+    u16 leaves[max_count];
+    size_t leaf_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        lengths[i] = 0;
+        weights[i] = frequencies[i];
+        if (frequencies[i])
+            leaves[leaf_count++] = i;
+    }
+
+    // A code needs at least two symbols to be a code, even if only one of them is ever used.
+    if (leaf_count < 2) {
+        if (leaf_count == 1)
+            lengths[leaves[0]] = 1;
+        lengths[leaf_count == 1 && leaves[0] == 0 ? 1 : 0] = 1;
+        return;
     }
 
-    if (m_remaining_bits == 0) {
-        if (m_data_index + 1 > m_data.size())
-            return -1;
+    for (;;) {
+        quick_sort(leaves, leaves + leaf_count, [&](auto a, auto b) { return weights[a] < weights[b] || (weights[a] == weights[b] && a < b); });
+
+        // Internal nodes are created in order of increasing weight, so the two lightest nodes are
+        // always at the front of either the leaves or the internal nodes.
+        u16 parents[2 * max_count];
+        size_t next_leaf = 0;
+        size_t next_node = count;
+        size_t node_count = count;
+        auto take_lightest = [&] {
+            if (next_leaf < leaf_count && (next_node == node_count || weights[leaves[next_leaf]] <= weights[next_node]))
+                return (size_t)leaves[next_leaf++];
+            return next_node++;
+        };
+        for (size_t i = 0; i < leaf_count - 1; ++i) {
+            auto a = take_lightest();
+            auto b = take_lightest();
+            weights[node_count] = weights[a] + weights[b];
+            parents[a] = node_count;
+            parents[b] = node_count;
+            ++node_count;
+        }
 
-        m_current_byte = m_data.at(m_data_index++);
-        m_remaining_bits = 8;
+        u8 depths[2 * max_count];
+        depths[node_count - 1] = 0;
+        for (size_t node = node_count - 1; node-- > count;)
+            depths[node] = depths[parents[node]] + 1;
+
+        size_t longest = 0;
+        for (size_t i = 0; i < leaf_count; ++i) {
+            auto leaf = leaves[i];
+            lengths[leaf] = depths[parents[leaf]] + 1;
+            longest = max(longest, (size_t)lengths[leaf]);
+        }
+        if (longest <= max_length)
+            return;
+
+        // Flatten out the distribution and try again, this converges quickly and rarely costs much.
+        for (size_t i = 0; i < leaf_count; ++i)
+            weights[leaves[i]] = (weights[leaves[i]] >> 1) | 1;
     }
+}
+
+// Assigns the canonical codes for the given lengths, bit-reversed so that they can be written least significant bit first.
+static void generate_huffman_codes(u16* codes, const u8* lengths, size_t count)
+{
+    u16 length_counts[16] {};
+    for (size_t i = 0; i < count; ++i)
+        ++length_counts[lengths[i]];
+    length_counts[0] = 0;
+
+    u16 next_code[16] {};
+    u16 code = 0;
+    for (size_t length = 1; length < 16; ++length) {
+        code = (code + length_counts[length - 1]) << 1;
+        next_code[length] = code;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        auto length = lengths[i];
+        if (!length)
+            continue;
+        u16 value = next_code[length]++;
+        u16 reversed = 0;
+        for (size_t bit = 0; bit < length; ++bit)
+            reversed |= ((value >> bit) & 1) << (length - bit - 1);
+        codes[i] = reversed;
+    }
+}
 
-    m_remaining_bits--;
-    return (m_current_byte >> (7 - m_remaining_bits)) & 1;
+const DeflateCompressor::LevelParameters& DeflateCompressor::parameters_for(CompressionLevel level)
+{
+    static constexpr LevelParameters parameters[] = {
+        { 0, 0, 0, 0 },
+        { 4, 8, 0, 4 },
+        { 16, 32, 0, 16 },
+        { 128, 128, 16, max_match_length },
+        { 4096, max_match_length, max_match_length, max_match_length },
+    };
+    return parameters[(size_t)level];
 }
 
-i8 BitStreamReader::read_byte()
+Optional<ByteBuffer> DeflateCompressor::compress_all(ReadonlyBytes bytes, CompressionLevel level)
 {
-    m_current_byte = 0;
-    m_remaining_bits = 0;
+    DuplexMemoryStream output_stream;
+    DeflateCompressor deflate_stream { output_stream, level };
+
+    deflate_stream.write_or_error(bytes);
+    deflate_stream.final_flush();
 
-    if (m_data_index + 1 > m_data.size())
-        return -1;
+    if (deflate_stream.handle_error() || output_stream.handle_error())
+        return {};
 
-    return m_data.at(m_data_index++);
+    auto buffer = ByteBuffer::create_uninitialized(output_stream.remaining());
+    output_stream.read(buffer);
+    return buffer;
 }
 
-u8 BitStreamReader::get_bit_byte_offset()
+DeflateCompressor::DeflateCompressor(OutputStream& stream, CompressionLevel level)
+    : m_writer(stream)
+    , m_level(level)
+    , m_parameters(parameters_for(level))
 {
-    return (8 - m_remaining_bits) % 8;
+    for (size_t i = 0; i < m_hash_head.size(); ++i)
+        m_hash_head[i] = -1;
+    for (size_t i = 0; i < m_hash_prev.size(); ++i)
+        m_hash_prev[i] = -1;
 }
 
-u32 BitStreamReader::read_bits(u8 count)
+DeflateCompressor::~DeflateCompressor()
 {
-    ASSERT(count > 0 && count < 32);
+    ASSERT(m_finished);
+}
 
-    u32 result = 0;
-    for (size_t i = 0; i < count; i++) {
-        result |= read() << i;
+size_t DeflateCompressor::write(ReadonlyBytes bytes)
+{
+    ASSERT(!m_finished);
+
+    size_t nwritten = 0;
+    while (nwritten < bytes.size()) {
+        auto count = bytes.slice(nwritten).copy_trimmed_to(m_window.bytes().slice(m_window_end));
+        nwritten += count;
+        m_window_end += count;
+        if (m_window_end == window_size) {
+            compress_window(false);
+            slide_window();
+        }
     }
-    return result;
+    return nwritten;
 }
 
-Vector<u8> DeflateStream::generate_literal_length_codes() const
+bool DeflateCompressor::write_or_error(ReadonlyBytes bytes)
 {
-    Vector<u8> ll_codes;
-    ll_codes.resize(288);
-    memset(ll_codes.data() + 0, 8, 144 - 0);
-    memset(ll_codes.data() + 144, 9, 256 - 144);
-    memset(ll_codes.data() + 256, 7, 280 - 256);
-    memset(ll_codes.data() + 280, 8, 288 - 280);
-    return ll_codes;
+    write(bytes);
+    return true;
 }
 
-Vector<u8> DeflateStream::generate_fixed_distance_codes() const
+void DeflateCompressor::final_flush()
 {
-    Vector<u8> fd_codes;
-    fd_codes.resize(32);
-    memset(fd_codes.data(), 5, 32);
-    return fd_codes;
+    ASSERT(!m_finished);
+    compress_window(true);
+    m_writer.flush();
+    m_finished = true;
 }
 
-CanonicalCode::CanonicalCode(Vector<u8> codes)
+void DeflateCompressor::compress_window(bool final)
 {
-    m_symbol_codes.resize(codes.size());
-    m_symbol_values.resize(codes.size());
+    if (m_level == CompressionLevel::Store) {
+        write_stored_blocks(m_window.bytes().slice(m_position, m_window_end - m_position), final);
+        m_position = m_window_end;
+        m_block_start = m_position;
+        return;
+    }
 
-    auto allocated_symbols_count = 0;
-    auto next_code = 0;
+    // Leave enough data for a full length match at the end, unless there isn't any more coming.
+    auto limit = final ? m_window_end : m_window_end - max_match_length;
+    if (m_parameters.max_lazy)
+        find_matches_lazy(limit);
+    else
+        find_matches_greedy(limit);
 
-    for (size_t code_length = 1; code_length <= 15; code_length++) {
-        next_code <<= 1;
-        auto start_bit = 1 << code_length;
+    write_block(m_window.bytes().slice(m_block_start, m_position - m_block_start), final);
+    m_symbols.clear_with_capacity();
+    m_block_start = m_position;
+}
 
-        for (size_t symbol = 0; symbol < codes.size(); symbol++) {
-            if (codes.at(symbol) != code_length) {
-                continue;
-            }
+void DeflateCompressor::slide_window()
+{
+    ASSERT(m_position >= history_size);
+
+    memmove(m_window.data(), m_window.data() + history_size, m_window_end - history_size);
+    m_window_end -= history_size;
+    m_position -= history_size;
+    m_block_start -= history_size;
+
+    auto slide = [](FixedArray<i32>& positions) {
+        for (size_t i = 0; i < positions.size(); ++i)
+            positions[i] = positions[i] >= (i32)history_size ? positions[i] - (i32)history_size : -1;
+    };
+    slide(m_hash_head);
+    slide(m_hash_prev);
+}
 
-            if (next_code > start_bit) {
-                dbg() << "Canonical code overflows the huffman tree";
-                ASSERT_NOT_REACHED();
-            }
+u32 DeflateCompressor::hash(size_t position) const
+{
+    auto* bytes = m_window.data() + position;
+    u32 value = bytes[0] | bytes[1] << 8 | bytes[2] << 16;
+    return (value * 2654435761u) >> (32 - hash_bits);
+}
 
-            m_symbol_codes[allocated_symbols_count] = start_bit | next_code;
-            m_symbol_values[allocated_symbols_count] = symbol;
+void DeflateCompressor::insert_hash(size_t position)
+{
+    if (position + min_match_length > m_window_end)
+        return;
+    auto& head = m_hash_head[hash(position)];
+    m_hash_prev[position % history_size] = head;
+    head = position;
+}
 
-            allocated_symbols_count++;
-            next_code++;
+size_t DeflateCompressor::longest_match(size_t position, size_t best_length, u16& distance) const
+{
+    auto max_length = min(max_match_length, m_window_end - position);
+    if (max_length < min_match_length || best_length >= max_length)
+        return 0;
+
+    auto* window = m_window.data();
+    auto* current = window + position;
+    i32 lowest_position = position > history_size ? position - history_size : 0;
+    auto chain_left = m_parameters.max_chain;
+    auto length_to_beat = best_length;
+
+    for (i32 candidate = m_hash_head[hash(position)]; candidate >= lowest_position && chain_left--;) {
+        auto* match = window + candidate;
+        if (match[length_to_beat] == current[length_to_beat] && match[0] == current[0] && match[1] == current[1]) {
+            size_t length = 2;
+            while (length < max_length && match[length] == current[length])
+                ++length;
+            if (length > length_to_beat) {
+                length_to_beat = length;
+                distance = position - candidate;
+                if (length >= m_parameters.nice_length || length == max_length)
+                    break;
+            }
         }
-    }
 
-    if (next_code != (1 << 15)) {
-        dbg() << "Canonical code underflows the huffman tree " << next_code;
-        ASSERT_NOT_REACHED();
+        auto next = m_hash_prev[candidate % history_size];
+        if (next >= candidate)
+            break;
+        candidate = next;
     }
+
+    if (length_to_beat <= best_length || length_to_beat < min_match_length)
+        return 0;
+    return length_to_beat;
 }
 
-static i32 binary_search(Vector<u32>& heystack, u32 needle)
+void DeflateCompressor::find_matches_greedy(size_t limit)
 {
-    i32 low = 0;
-    i32 high = heystack.size();
-
-    while (low <= high) {
-        u32 mid = (low + high) >> 1;
-        u32 value = heystack.at(mid);
+    while (m_position < limit) {
+        u16 distance = 0;
+        auto length = longest_match(m_position, min_match_length - 1, distance);
+        if (!length) {
+            insert_hash(m_position);
+            m_symbols.append({ m_window[m_position], 0 });
+            ++m_position;
+            continue;
+        }
 
-        if (value < needle) {
-            low = mid + 1;
-        } else if (value > needle) {
-            high = mid - 1;
+        m_symbols.append({ (u16)length, distance });
+        if (length <= m_parameters.max_insert) {
+            for (size_t i = 0; i < length; ++i)
+                insert_hash(m_position + i);
         } else {
-            return mid;
+            insert_hash(m_position);
         }
+        m_position += length;
     }
+}
 
-    return -1;
+void DeflateCompressor::find_matches_lazy(size_t limit)
+{
+    // Every match is held back for one position, and only emitted if the next position doesn't
+    // have a longer one. Otherwise its first byte goes out as a literal instead.
+    size_t previous_length = 0;
+    u16 previous_distance = 0;
+    bool has_previous = false;
+
+    while (m_position < limit) {
+        u16 distance = 0;
+        size_t length = 0;
+        if (previous_length < m_parameters.max_lazy)
+            length = longest_match(m_position, max(previous_length, min_match_length - 1), distance);
+        insert_hash(m_position);
+
+        if (previous_length >= min_match_length && length <= previous_length) {
+            auto match_start = m_position - 1;
+            m_symbols.append({ (u16)previous_length, previous_distance });
+            for (size_t i = 2; i < previous_length; ++i)
+                insert_hash(match_start + i);
+            m_position = match_start + previous_length;
+            previous_length = 0;
+            has_previous = false;
+            continue;
+        }
+
+        if (has_previous)
+            m_symbols.append({ m_window[m_position - 1], 0 });
+        has_previous = true;
+        previous_length = length;
+        previous_distance = distance;
+        ++m_position;
+    }
+
+    if (!has_previous)
+        return;
+    if (previous_length >= min_match_length) {
+        auto match_start = m_position - 1;
+        m_symbols.append({ (u16)previous_length, previous_distance });
+        for (size_t i = 2; i < previous_length; ++i)
+            insert_hash(match_start + i);
+        m_position = match_start + previous_length;
+    } else {
+        m_symbols.append({ m_window[m_position - 1], 0 });
+    }
 }
 
-u32 CanonicalCode::next_symbol(BitStreamReader& reader)
+void DeflateCompressor::write_stored_blocks(ReadonlyBytes bytes, bool final)
 {
-    auto code_bits = 1;
+    do {
+        auto block = bytes.slice(0, min(bytes.size(), (size_t)0xffff));
+        bytes = bytes.slice(block.size());
+        m_writer.write_bits(final && bytes.is_empty(), 1);
+        m_writer.write_bits(0, 2);
+        m_writer.align_to_byte_boundary();
+        m_writer.write_bits(block.size(), 16);
+        m_writer.write_bits(block.size() ^ 0xffff, 16);
+        m_writer.write_aligned_bytes(block);
+    } while (!bytes.is_empty());
+}
 
-    for (;;) {
-        code_bits = code_bits << 1 | reader.read();
-        i32 index = binary_search(m_symbol_codes, code_bits);
-        if (index >= 0) {
-            return m_symbol_values.at(index);
+void DeflateCompressor::write_block(ReadonlyBytes bytes, bool final)
+{
+    u32 literal_frequencies[286] {};
+    u32 distance_frequencies[30] {};
+    size_t extra_bits = 0;
+    for (auto& symbol : m_symbols) {
+        if (!symbol.distance) {
+            ++literal_frequencies[symbol.literal_or_length];
+            continue;
+        }
+        auto length_code = length_code_for(symbol.literal_or_length);
+        auto distance_code = distance_code_for(symbol.distance);
+        ++literal_frequencies[257 + length_code];
+        ++distance_frequencies[distance_code];
+        extra_bits += length_extra_bits[length_code] + distance_extra_bits[distance_code];
+    }
+    literal_frequencies[256] = 1;
+
+    // Room for the two symbols that only exist in the fixed code.
+    u8 literal_lengths[288] {};
+    u8 distance_lengths[30];
+    generate_huffman_lengths(literal_lengths, literal_frequencies, 286, 15);
+    generate_huffman_lengths(distance_lengths, distance_frequencies, 30, 15);
+
+    size_t literal_count = 286;
+    while (literal_count > 257 && !literal_lengths[literal_count - 1])
+        --literal_count;
+    size_t distance_count = 30;
+    while (distance_count > 1 && !distance_lengths[distance_count - 1])
+        --distance_count;
+
+    // Run-length encode the code lengths, which are then Huffman coded themselves.
+    u8 all_lengths[286 + 30];
+    memcpy(all_lengths, literal_lengths, literal_count);
+    memcpy(all_lengths + literal_count, distance_lengths, distance_count);
+    auto all_lengths_count = literal_count + distance_count;
+
+    struct CodeLengthSymbol {
+        u8 symbol;
+        u8 extra;
+    };
+    Vector<CodeLengthSymbol, 286 + 30> code_length_symbols;
+    u32 code_length_frequencies[19] {};
+    for (size_t i = 0; i < all_lengths_count;) {
+        auto value = all_lengths[i];
+        size_t run = 1;
+        while (i + run < all_lengths_count && all_lengths[i + run] == value)
+            ++run;
+        i += run;
+
+        auto emit = [&](u8 symbol, u8 extra) {
+            code_length_symbols.append({ symbol, extra });
+            ++code_length_frequencies[symbol];
+        };
+        if (!value) {
+            for (; run >= 11; run -= min(run, (size_t)138))
+                emit(18, min(run, (size_t)138) - 11);
+            if (run >= 3) {
+                emit(17, run - 3);
+                run = 0;
+            }
+        } else {
+            emit(value, 0);
+            --run;
+            for (; run >= 3; run -= min(run, (size_t)6))
+                emit(16, min(run, (size_t)6) - 3);
+        }
+        for (; run; --run)
+            emit(value, 0);
+    }
+
+    u8 code_length_lengths[19];
+    generate_huffman_lengths(code_length_lengths, code_length_frequencies, 19, 7);
+    size_t code_length_count = 19;
+    while (code_length_count > 4 && !code_length_lengths[code_length_order[code_length_count - 1]])
+        --code_length_count;
+
+    // Now figure out which kind of block is the smallest.
+    static constexpr u8 code_length_extra_bits[19] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7 };
+    size_t dynamic_size = 3 + 5 + 5 + 4 + 3 * code_length_count + extra_bits;
+    for (size_t i = 0; i < 19; ++i)
+        dynamic_size += code_length_frequencies[i] * (code_length_lengths[i] + code_length_extra_bits[i]);
+    for (size_t i = 0; i < 286; ++i)
+        dynamic_size += literal_frequencies[i] * literal_lengths[i];
+    for (size_t i = 0; i < 30; ++i)
+        dynamic_size += distance_frequencies[i] * distance_lengths[i];
+
+    size_t fixed_size = 3 + extra_bits;
+    for (size_t i = 0; i < 286; ++i)
+        fixed_size += literal_frequencies[i] * (i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+    for (size_t i = 0; i < 30; ++i)
+        fixed_size += distance_frequencies[i] * 5;
+
+    size_t stored_size = 3 + 7 + 32 + 8 * bytes.size();
+    if (stored_size <= fixed_size && stored_size <= dynamic_size) {
+        write_stored_blocks(bytes, final);
+        return;
+    }
+
+    m_writer.write_bits(final, 1);
+    if (fixed_size <= dynamic_size) {
+        m_writer.write_bits(1, 2);
+        for (size_t i = 0; i < 288; ++i)
+            literal_lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+        for (size_t i = 0; i < 30; ++i)
+            distance_lengths[i] = 5;
+    } else {
+        m_writer.write_bits(2, 2);
+        m_writer.write_bits(literal_count - 257, 5);
+        m_writer.write_bits(distance_count - 1, 5);
+        m_writer.write_bits(code_length_count - 4, 4);
+        for (size_t i = 0; i < code_length_count; ++i)
+            m_writer.write_bits(code_length_lengths[code_length_order[i]], 3);
+
+        u16 code_length_codes[19];
+        generate_huffman_codes(code_length_codes, code_length_lengths, 19);
+        for (auto& symbol : code_length_symbols) {
+            m_writer.write_bits(code_length_codes[symbol.symbol], code_length_lengths[symbol.symbol]);
+            if (code_length_extra_bits[symbol.symbol])
+                m_writer.write_bits(symbol.extra, code_length_extra_bits[symbol.symbol]);
+        }
+    }
+
+    u16 literal_codes[288];
+    u16 distance_codes[30];
+    generate_huffman_codes(literal_codes, literal_lengths, 288);
+    generate_huffman_codes(distance_codes, distance_lengths, 30);
+
+    for (auto& symbol : m_symbols) {
+        if (!symbol.distance) {
+            m_writer.write_bits(literal_codes[symbol.literal_or_length], literal_lengths[symbol.literal_or_length]);
+            continue;
         }
+        auto length_code = length_code_for(symbol.literal_or_length);
+        m_writer.write_bits(literal_codes[257 + length_code], literal_lengths[257 + length_code]);
+        if (length_extra_bits[length_code])
+            m_writer.write_bits(symbol.literal_or_length - length_bases[length_code], length_extra_bits[length_code]);
+        auto distance_code = distance_code_for(symbol.distance);
+        m_writer.write_bits(distance_codes[distance_code], distance_lengths[distance_code]);
+        if (distance_extra_bits[distance_code])
+            m_writer.write_bits(symbol.distance - distance_bases[distance_code], distance_extra_bits[distance_code]);
     }
+    m_writer.write_bits(literal_codes[256], literal_lengths[256]);
 }
 
 }
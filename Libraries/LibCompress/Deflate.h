@@ -26,160 +26,278 @@
 
 #pragma once
 
-#include <AK/CircularQueue.h>
+#include <AK/ByteBuffer.h>
+#include <AK/FixedArray.h>
+#include <AK/Optional.h>
 #include <AK/Span.h>
 #include <AK/Stream.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
-#include <cstring>
 
 namespace Compress {
 
-// Reads one bit at a time starting with the rightmost bit
+// Reads bits from an input stream, starting with the least significant bit of each byte.
+// Bits past the end of the input read as zero, overrun() tells whether any of them were consumed.
 class BitStreamReader {
 public:
-    BitStreamReader(ReadonlyBytes data)
-        : m_data(data)
+    explicit BitStreamReader(InputStream& stream)
+        : m_stream(stream)
     {
     }
 
-    i8 read();
-    i8 read_byte();
-    u32 read_bits(u8);
-    u8 get_bit_byte_offset();
+    ALWAYS_INLINE u32 peek_bits(u8 count)
+    {
+        ASSERT(count <= 32);
+        if (m_buffered_bits < count)
+            refill(count);
+        return m_buffer & ((1ull << count) - 1);
+    }
+
+    ALWAYS_INLINE void discard_bits(u8 count)
+    {
+        ASSERT(count <= m_buffered_bits);
+        m_buffer >>= count;
+        m_buffered_bits -= count;
+    }
+
+    ALWAYS_INLINE u32 read_bits(u8 count)
+    {
+        auto bits = peek_bits(count);
+        discard_bits(count);
+        return bits;
+    }
+
+    void align_to_byte_boundary() { discard_bits(m_buffered_bits % 8); }
+
+    // Must only be called on a byte boundary.
+    size_t read_aligned_bytes(Bytes);
+
+    bool overrun() const { return m_padding_bits > m_buffered_bits; }
 
 private:
-    ReadonlyBytes m_data;
-    size_t m_data_index { 0 };
+    void refill(u8 count);
 
-    i8 m_current_byte { 0 };
-    u8 m_remaining_bits { 0 };
+    InputStream& m_stream;
+    u64 m_buffer { 0 };
+    u8 m_buffered_bits { 0 };
+    size_t m_padding_bits { 0 };
 };
 
+// A canonical Huffman code, as described by the code length of each of its symbols.
 class CanonicalCode {
 public:
-    CanonicalCode(Vector<u8>);
-    u32 next_symbol(BitStreamReader&);
+    static constexpr u32 invalid_symbol = 0xffffffff;
+
+    static Optional<CanonicalCode> from_lengths(ReadonlyBytes);
+
+    ALWAYS_INLINE u32 read_symbol(BitStreamReader& reader) const
+    {
+        auto entry = m_fast_table[reader.peek_bits(fast_bits)];
+        if (!entry)
+            return read_symbol_slow(reader);
+        reader.discard_bits(entry & 0xf);
+        return entry >> 4;
+    }
 
 private:
-    Vector<u32> m_symbol_codes;
-    Vector<u32> m_symbol_values;
+    static constexpr size_t max_code_length = 15;
+    static constexpr size_t max_symbol_count = 288;
+
+    // Codes up to this long are decoded with a single table lookup.
+    static constexpr size_t fast_bits = 9;
+
+    u32 read_symbol_slow(BitStreamReader&) const;
+
+    // Indexed by the next fast_bits bits of input. Holds the symbol shifted left by 4 and the
+    // length of its code, or zero if the code is longer than that.
+    u16 m_fast_table[1 << fast_bits] {};
+
+    // The symbols in the order of their codes, and how many codes there are of each length.
+    u16 m_symbols[max_symbol_count] {};
+    u16 m_length_counts[max_code_length + 1] {};
 };
 
 // Implements a DEFLATE decompressor according to RFC 1951.
+//
+// Data is only decompressed as the reader asks for it, so at no point is more than the 32 KiB
+// of history that back references can reach (plus what hasn't been read yet) kept in memory.
 class DeflateStream final : public InputStream {
 public:
-    // FIXME: This should really return a ByteBuffer.
-    static Vector<u8> decompress_all(ReadonlyBytes bytes)
-    {
-        DeflateStream stream { bytes };
-        while (stream.read_next_block()) {
-        }
+    static Optional<ByteBuffer> decompress_all(ReadonlyBytes);
 
-        Vector<u8> vector;
-        vector.resize(stream.m_intermediate_stream.remaining());
-        stream >> vector;
+    explicit DeflateStream(InputStream&);
 
-        return vector;
-    }
+    size_t read(Bytes) override;
+    bool read_or_error(Bytes) override;
+    bool eof() const override;
+    bool discard_or_error(size_t) override;
 
-    DeflateStream(ReadonlyBytes data)
-        : m_reader(data)
-        , m_literal_length_codes(generate_literal_length_codes())
-        , m_fixed_distance_codes(generate_fixed_distance_codes())
-    {
-    }
+private:
+    static constexpr size_t history_size = 32 * 1024;
+    static constexpr size_t window_size = 2 * history_size;
 
-    // FIXME: Accept an InputStream.
+    enum class State {
+        Idle,
+        ReadingCompressedBlock,
+        ReadingUncompressedBlock,
+        Finished,
+    };
 
-    size_t read(Bytes bytes) override
-    {
-        if (m_intermediate_stream.remaining() >= bytes.size())
-            return m_intermediate_stream.read_or_error(bytes);
+    // Decompresses up to another history_size of data. Returns false once there's nothing left.
+    bool decompress_more();
 
-        while (read_next_block()) {
-            if (m_intermediate_stream.remaining() >= bytes.size())
-                return m_intermediate_stream.read_or_error(bytes);
-        }
+    void read_block_header();
+    bool decode_huffman_codes();
+    void decompress_huffman_block();
+    void decompress_uncompressed_block();
 
-        return m_intermediate_stream.read(bytes);
-    }
+    bool decode_run_length(u32 symbol, u32& length);
+    bool decode_distance(u32 symbol, u32& distance);
+    bool copy_from_history(u32 distance, u32 length);
 
-    bool read_or_error(Bytes bytes) override
+    ALWAYS_INLINE void write_byte(u8 byte)
     {
-        if (m_intermediate_stream.remaining() >= bytes.size()) {
-            m_intermediate_stream.read_or_error(bytes);
-            return true;
-        }
+        m_window.data()[m_write_position++ % window_size] = byte;
+        ++m_unread_size;
+    }
 
-        while (read_next_block()) {
-            if (m_intermediate_stream.remaining() >= bytes.size()) {
-                m_intermediate_stream.read_or_error(bytes);
-                return true;
-            }
-        }
+    void fail();
 
-        m_error = true;
-        return false;
-    }
+    BitStreamReader m_reader;
+    State m_state { State::Idle };
+    bool m_read_final_block { false };
 
-    bool eof() const override
-    {
-        if (!m_intermediate_stream.eof())
-            return false;
+    Optional<CanonicalCode> m_literal_length_codes;
+    Optional<CanonicalCode> m_distance_codes;
+    size_t m_uncompressed_bytes_left { 0 };
 
-        while (read_next_block()) {
-            if (!m_intermediate_stream.eof())
-                return false;
-        }
+    // Decompressed data goes into this ring buffer, where it's handed out to the reader and stays
+    // available for back references until it gets overwritten.
+    FixedArray<u8> m_window { window_size };
+    size_t m_write_position { 0 };
+    size_t m_unread_size { 0 };
+    size_t m_history_available { 0 };
+};
 
-        return true;
+// Writes bits to an output stream, starting with the least significant bit of each byte.
+class BitStreamWriter {
+public:
+    explicit BitStreamWriter(OutputStream& stream)
+        : m_stream(stream)
+    {
     }
 
-    bool discard_or_error(size_t count) override
+    ALWAYS_INLINE void write_bits(u32 bits, u8 count)
     {
-        if (m_intermediate_stream.remaining() >= count) {
-            m_intermediate_stream.discard_or_error(count);
-            return true;
+        ASSERT(count <= 32);
+        m_buffer |= (u64)bits << m_buffered_bits;
+        m_buffered_bits += count;
+        while (m_buffered_bits >= 8) {
+            m_output[m_output_size++] = m_buffer;
+            m_buffer >>= 8;
+            m_buffered_bits -= 8;
+            if (m_output_size == sizeof(m_output))
+                flush_output();
         }
+    }
 
-        while (read_next_block()) {
-            if (m_intermediate_stream.remaining() >= count) {
-                m_intermediate_stream.discard_or_error(count);
-                return true;
-            }
-        }
+    void align_to_byte_boundary();
 
-        m_error = true;
-        return false;
-    }
+    // Must only be called on a byte boundary.
+    void write_aligned_bytes(ReadonlyBytes);
+
+    // Pads the last byte with zero bits and hands everything to the stream.
+    void flush();
 
 private:
-    void decompress_uncompressed_block() const;
-    void decompress_static_block() const;
-    void decompress_dynamic_block() const;
-    void decompress_huffman_block(CanonicalCode&, CanonicalCode*) const;
+    void flush_output();
 
-    Vector<CanonicalCode> decode_huffman_codes() const;
-    u32 decode_run_length(u32) const;
-    u32 decode_distance(u32) const;
+    OutputStream& m_stream;
+    u64 m_buffer { 0 };
+    u8 m_buffered_bits { 0 };
+    u8 m_output[4096];
+    size_t m_output_size { 0 };
+};
 
-    void copy_from_history(u32, u32) const;
+// Implements a DEFLATE compressor according to RFC 1951.
+//
+// Input is collected into blocks of up to 32 KiB, which are then written as whichever of a stored,
+// fixed Huffman or dynamic Huffman block comes out smallest.
+class DeflateCompressor final : public OutputStream {
+public:
+    enum class CompressionLevel {
+        Store,
+        Fastest,
+        Fast,
+        Good,
+        Best,
+    };
 
-    Vector<u8> generate_literal_length_codes() const;
-    Vector<u8> generate_fixed_distance_codes() const;
+    static Optional<ByteBuffer> compress_all(ReadonlyBytes, CompressionLevel = CompressionLevel::Good);
 
-    mutable BitStreamReader m_reader;
+    explicit DeflateCompressor(OutputStream&, CompressionLevel = CompressionLevel::Good);
+    ~DeflateCompressor();
 
-    mutable CanonicalCode m_literal_length_codes;
-    mutable CanonicalCode m_fixed_distance_codes;
+    size_t write(ReadonlyBytes) override;
+    bool write_or_error(ReadonlyBytes) override;
 
-    // FIXME: Theoretically, blocks can be extremly large, reading a single block could
-    //        exhaust memory. Maybe wait for C++20 coroutines?
-    bool read_next_block() const;
+    // Compresses whatever is left and terminates the stream. This has to be called exactly once,
+    // and nothing can be written afterwards.
+    void final_flush();
 
-    mutable bool m_read_last_block { false };
-    mutable DuplexMemoryStream m_intermediate_stream;
+private:
+    static constexpr size_t history_size = 32 * 1024;
+    static constexpr size_t window_size = 2 * history_size;
+    static constexpr size_t min_match_length = 3;
+    static constexpr size_t max_match_length = 258;
+    static constexpr size_t hash_bits = 15;
+
+    struct LevelParameters {
+        size_t max_chain;
+        size_t nice_length;
+        // Matches up to this long get a second look at the next position, zero means never.
+        size_t max_lazy;
+        // The positions inside matches up to this long are added to the hash chains.
+        size_t max_insert;
+    };
+
+    // A literal if distance is zero, otherwise a back reference of the given length.
+    struct Symbol {
+        u16 literal_or_length;
+        u16 distance;
+    };
+
+    static const LevelParameters& parameters_for(CompressionLevel);
+
+    void compress_window(bool final);
+    void slide_window();
+
+    ALWAYS_INLINE u32 hash(size_t position) const;
+    ALWAYS_INLINE void insert_hash(size_t position);
+    size_t longest_match(size_t position, size_t best_length, u16& distance) const;
+
+    void find_matches_greedy(size_t limit);
+    void find_matches_lazy(size_t limit);
+
+    void write_block(ReadonlyBytes, bool final);
+    void write_stored_blocks(ReadonlyBytes, bool final);
+
+    BitStreamWriter m_writer;
+    CompressionLevel m_level;
+    const LevelParameters& m_parameters;
+    bool m_finished { false };
+
+    // Holds up to history_size of already compressed data, followed by what's still waiting for it.
+    FixedArray<u8> m_window { window_size };
+    size_t m_window_end { 0 };
+    size_t m_position { 0 };
+    size_t m_block_start { 0 };
+
+    // The most recent position for each hash of three bytes, and the one before that for each position.
+    FixedArray<i32> m_hash_head { 1 << hash_bits };
+    FixedArray<i32> m_hash_prev { history_size };
+
+    Vector<Symbol> m_symbols;
 };
 
 }
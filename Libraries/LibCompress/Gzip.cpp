@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Types.h>
+#include <LibCompress/Gzip.h>
+#include <LibCrypto/Checksum/CRC32.h>
+#include <string.h>
+
+namespace Compress {
+
+// see: https://tools.ietf.org/html/rfc1952#page-5
+Optional<ByteBuffer> Gzip::compress_all(ReadonlyBytes bytes, DeflateCompressor::CompressionLevel level)
+{
+    auto compressed = DeflateCompressor::compress_all(bytes, level);
+    if (!compressed.has_value())
+        return {};
+
+    u8 extra_flags = 0;
+    if (level == DeflateCompressor::CompressionLevel::Best)
+        extra_flags = 2;
+    else if (level == DeflateCompressor::CompressionLevel::Fastest)
+        extra_flags = 4;
+
+    // No file name or modification time, and an "unknown" operating system.
+    const u8 header[] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, extra_flags, 0xff };
+
+    u32 crc32 = Crypto::Checksum::CRC32 { bytes }.digest();
+    u32 input_size = bytes.size();
+    const u8 trailer[] = {
+        (u8)crc32, (u8)(crc32 >> 8), (u8)(crc32 >> 16), (u8)(crc32 >> 24),
+        (u8)input_size, (u8)(input_size >> 8), (u8)(input_size >> 16), (u8)(input_size >> 24)
+    };
+
+    auto output = ByteBuffer::create_uninitialized(sizeof(header) + compressed.value().size() + sizeof(trailer));
+    memcpy(output.data(), header, sizeof(header));
+    memcpy(output.data() + sizeof(header), compressed.value().data(), compressed.value().size());
+    memcpy(output.data() + sizeof(header) + compressed.value().size(), trailer, sizeof(trailer));
+    return output;
+}
+
+}
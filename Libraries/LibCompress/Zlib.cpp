@@ -27,7 +27,6 @@
 #include <AK/Assertions.h>
 #include <AK/Span.h>
 #include <AK/Types.h>
-#include <AK/Vector.h>
 #include <LibCompress/Deflate.h>
 #include <LibCompress/Zlib.h>
 
@@ -55,19 +54,152 @@ Zlib::Zlib(ReadonlyBytes data)
     m_data_bytes = data.slice(2, data.size() - 2 - 4);
 }
 
-Vector<u8> Zlib::decompress()
+Optional<ByteBuffer> Zlib::decompress()
 {
     return DeflateStream::decompress_all(m_data_bytes);
 }
 
+Optional<ByteBuffer> Zlib::compress_all(ReadonlyBytes bytes, DeflateCompressor::CompressionLevel level)
+{
+    DuplexMemoryStream output_stream;
+    ZlibCompressor zlib_stream { output_stream, level };
+
+    zlib_stream.write_or_error(bytes);
+    zlib_stream.final_flush();
+
+    if (zlib_stream.handle_error() || output_stream.handle_error())
+        return {};
+
+    auto buffer = ByteBuffer::create_uninitialized(output_stream.remaining());
+    output_stream.read(buffer);
+    return buffer;
+}
+
 u32 Zlib::checksum()
 {
     if (!m_checksum) {
         auto bytes = m_input_data.slice(m_input_data.size() - 4, 4);
-        m_checksum = bytes.at(0) << 24 | bytes.at(1) << 16 | bytes.at(2) << 8 || bytes.at(3);
+        m_checksum = bytes.at(0) << 24 | bytes.at(1) << 16 | bytes.at(2) << 8 | bytes.at(3);
     }
 
     return m_checksum;
 }
 
+ZlibStream::ZlibStream(InputStream& stream)
+    : m_deflate_stream(stream)
+{
+    u8 header[2];
+    if (stream.read({ header, sizeof(header) }) != sizeof(header))
+        return;
+
+    u8 compression_method = header[0] & 0xF;
+    u8 compression_info = (header[0] >> 4) & 0xF;
+    bool has_dictionary = (header[1] >> 5) & 0x1;
+    m_has_valid_header = compression_method == 8 && compression_info <= 7 && !has_dictionary && (header[0] * 256 + header[1]) % 31 == 0;
+}
+
+bool ZlibStream::check_deflate_stream() const
+{
+    if (!m_has_valid_header || m_deflate_stream.handle_error()) {
+        m_error = true;
+        return false;
+    }
+    return true;
+}
+
+size_t ZlibStream::read(Bytes bytes)
+{
+    if (!m_has_valid_header) {
+        m_error = true;
+        return 0;
+    }
+    auto nread = m_deflate_stream.read(bytes);
+    check_deflate_stream();
+    return nread;
+}
+
+bool ZlibStream::read_or_error(Bytes bytes)
+{
+    if (read(bytes) < bytes.size()) {
+        m_error = true;
+        return false;
+    }
+    return true;
+}
+
+bool ZlibStream::eof() const
+{
+    if (!m_has_valid_header)
+        return true;
+    auto eof = m_deflate_stream.eof();
+    check_deflate_stream();
+    return eof;
+}
+
+bool ZlibStream::discard_or_error(size_t count)
+{
+    if (!m_has_valid_header) {
+        m_error = true;
+        return false;
+    }
+    auto success = m_deflate_stream.discard_or_error(count);
+    return check_deflate_stream() && success;
+}
+
+ZlibCompressor::ZlibCompressor(OutputStream& stream, DeflateCompressor::CompressionLevel level)
+    : m_output_stream(stream)
+    , m_compressor(stream, level)
+{
+    u8 compression_level = 0;
+    switch (level) {
+    case DeflateCompressor::CompressionLevel::Store:
+    case DeflateCompressor::CompressionLevel::Fastest:
+        compression_level = 0;
+        break;
+    case DeflateCompressor::CompressionLevel::Fast:
+        compression_level = 1;
+        break;
+    case DeflateCompressor::CompressionLevel::Good:
+        compression_level = 2;
+        break;
+    case DeflateCompressor::CompressionLevel::Best:
+        compression_level = 3;
+        break;
+    }
+
+    // Deflate with a 32 KiB window, and no preset dictionary.
+    u8 compression_info = 0x78;
+    u8 flags = compression_level << 6;
+    flags += 31 - (compression_info * 256 + flags) % 31;
+    m_output_stream << compression_info << flags;
+}
+
+ZlibCompressor::~ZlibCompressor()
+{
+}
+
+size_t ZlibCompressor::write(ReadonlyBytes bytes)
+{
+    m_adler32.update(bytes);
+    return m_compressor.write(bytes);
+}
+
+bool ZlibCompressor::write_or_error(ReadonlyBytes bytes)
+{
+    if (write(bytes) < bytes.size()) {
+        m_error = true;
+        return false;
+    }
+    return true;
+}
+
+void ZlibCompressor::final_flush()
+{
+    m_compressor.final_flush();
+
+    u32 checksum = m_adler32.digest();
+    u8 checksum_bytes[4] = { (u8)(checksum >> 24), (u8)(checksum >> 16), (u8)(checksum >> 8), (u8)checksum };
+    m_output_stream.write_or_error({ checksum_bytes, sizeof(checksum_bytes) });
+}
+
 }
@@ -26,16 +26,22 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
 #include <AK/Span.h>
+#include <AK/Stream.h>
 #include <AK/Types.h>
-#include <AK/Vector.h>
+#include <LibCompress/Deflate.h>
+#include <LibCrypto/Checksum/Adler32.h>
 
 namespace Compress {
 class Zlib {
 public:
     Zlib(ReadonlyBytes data);
 
-    Vector<u8> decompress();
+    static Optional<ByteBuffer> compress_all(ReadonlyBytes, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::Good);
+
+    Optional<ByteBuffer> decompress();
     u32 checksum();
 
 private:
@@ -50,4 +56,40 @@ private:
     ReadonlyBytes m_data_bytes;
 };
 
+// Decompresses zlib data (RFC 1950) while it's being read from another stream.
+// NOTE: The trailing Adler-32 checksum is not verified.
+class ZlibStream final : public InputStream {
+public:
+    explicit ZlibStream(InputStream&);
+
+    size_t read(Bytes) override;
+    bool read_or_error(Bytes) override;
+    bool eof() const override;
+    bool discard_or_error(size_t) override;
+
+private:
+    bool check_deflate_stream() const;
+
+    bool m_has_valid_header { false };
+    mutable DeflateStream m_deflate_stream;
+};
+
+// Compresses data into the zlib format (RFC 1950) while it's being written.
+class ZlibCompressor final : public OutputStream {
+public:
+    explicit ZlibCompressor(OutputStream&, DeflateCompressor::CompressionLevel = DeflateCompressor::CompressionLevel::Good);
+    ~ZlibCompressor();
+
+    size_t write(ReadonlyBytes) override;
+    bool write_or_error(ReadonlyBytes) override;
+
+    // Like DeflateCompressor::final_flush(), but also writes the checksum.
+    void final_flush();
+
+private:
+    OutputStream& m_output_stream;
+    DeflateCompressor m_compressor;
+    Crypto::Checksum::Adler32 m_adler32;
+};
+
 }
@@ -82,38 +82,43 @@ void ConfigFile::reparse()
     HashMap<String, String>* current_group = nullptr;
 
     while (file->can_read_line()) {
-        auto line = file->read_line(BUFSIZ);
-        auto* cp = (const char*)line.data();
+        auto line = file->read_line_view(BUFSIZ);
+        size_t i = 0;
 
-        while (*cp && (*cp == ' ' || *cp == '\t' || *cp == '\n'))
-            ++cp;
+        while (i < line.length() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\n'))
+            ++i;
 
-        switch (*cp) {
-        case '\0': // EOL...
-        case '#':  // Comment, skip entire line.
-        case ';':  // -||-
+        if (i == line.length())
+            continue; // EOL...
+
+        switch (line[i]) {
+        case '#': // Comment, skip entire line.
+        case ';': // -||-
             continue;
         case '[': { // Start of new group.
-            StringBuilder builder;
-            ++cp; // Skip the '['
-            while (*cp && (*cp != ']'))
-                builder.append(*(cp++));
-            current_group = &m_groups.ensure(builder.to_string());
+            ++i; // Skip the '['
+            auto start = i;
+            while (i < line.length() && line[i] != ']')
+                ++i;
+            current_group = &m_groups.ensure(line.substring_view(start, i - start));
             break;
         }
         default: { // Start of key{
-            StringBuilder key_builder;
-            StringBuilder value_builder;
-            while (*cp && (*cp != '='))
-                key_builder.append(*(cp++));
-            ++cp; // Skip the '='
-            while (*cp && (*cp != '\n'))
-                value_builder.append(*(cp++));
+            auto key_start = i;
+            while (i < line.length() && line[i] != '=' && line[i] != '\n')
+                ++i;
+            auto key = line.substring_view(key_start, i - key_start);
+            ++i; // Skip the '='
+            auto value_start = min(i, line.length());
+            i = value_start;
+            while (i < line.length() && line[i] != '\n')
+                ++i;
+            auto value = line.substring_view(value_start, i - value_start);
             if (!current_group) {
                 // We're not in a group yet, create one with the name ""...
                 current_group = &m_groups.ensure("");
             }
-            current_group->set(key_builder.to_string(), value_builder.to_string());
+            current_group->set(key, value);
         }
         }
     }
@@ -52,6 +52,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#ifdef __serenity__
+#    include <sys/epoll.h>
+#endif
+
 //#define EVENTLOOP_DEBUG
 //#define DEFERRED_INVOKE_DEBUG
 
@@ -62,13 +66,25 @@ class RPCClient;
 struct EventLoopTimer {
     int timer_id { 0 };
     int interval { 0 };
+    int slack { 0 };
     timeval fire_time { 0, 0 };
     bool should_reload { false };
     TimerShouldFireWhenNotVisible fire_when_not_visible { TimerShouldFireWhenNotVisible::No };
     WeakPtr<Object> owner;
 
+    // Position in s_timer_heap, or -1 while the timer is parked in s_parked_timers.
+    int heap_index { -1 };
+
+    u64 fire_count { 0 };
+    u64 wakeup_count { 0 };
+
     void reload(const timeval& now);
     bool has_expired(const timeval& now) const;
+    bool fires_before(const EventLoopTimer& other) const;
+    bool is_suppressed() const
+    {
+        return fire_when_not_visible == TimerShouldFireWhenNotVisible::No && owner && !owner->is_visible_for_timer_purposes();
+    }
 };
 
 struct EventLoop::Private {
@@ -79,7 +95,18 @@ static EventLoop* s_main_event_loop;
 static Vector<EventLoop*>* s_event_loop_stack;
 static NeverDestroyed<IDAllocator> s_id_allocator;
 static HashMap<int, NonnullOwnPtr<EventLoopTimer>>* s_timers;
+// A min-heap of the timers by fire time. The ones that expired while their owner wasn't visible are
+// parked outside of it instead, so they don't keep waking us up. We look at those on every wakeup.
+static Vector<EventLoopTimer*>* s_timer_heap;
+static Vector<EventLoopTimer*>* s_parked_timers;
 static HashTable<Notifier*>* s_notifiers;
+#ifdef __serenity__
+// Notifiers are registered with an epoll set once, instead of being collected into fd_sets on every wait.
+static HashMap<int, Vector<Notifier*, 1>>* s_notifiers_by_fd;
+static int s_epoll_fd = -1;
+static pid_t s_epoll_pid;
+static constexpr int max_ready_events_per_wait = 32;
+#endif
 int EventLoop::s_wake_pipe_fds[2];
 HashMap<int, EventLoop::SignalHandlers> EventLoop::s_signal_handlers;
 int EventLoop::s_handling_signal = 0;
@@ -88,6 +115,68 @@ pid_t EventLoop::s_pid;
 static RefPtr<LocalServer> s_rpc_server;
 HashMap<int, RefPtr<RPCClient>> s_rpc_clients;
 
+static void timer_heap_swap(size_t a, size_t b)
+{
+    auto& heap = *s_timer_heap;
+    swap(heap[a], heap[b]);
+    heap[a]->heap_index = a;
+    heap[b]->heap_index = b;
+}
+
+static void timer_heap_sift_up(size_t index)
+{
+    auto& heap = *s_timer_heap;
+    while (index > 0) {
+        auto parent = (index - 1) / 2;
+        if (!heap[index]->fires_before(*heap[parent]))
+            break;
+        timer_heap_swap(index, parent);
+        index = parent;
+    }
+}
+
+static void timer_heap_sift_down(size_t index)
+{
+    auto& heap = *s_timer_heap;
+    for (;;) {
+        auto soonest = index;
+        auto left = index * 2 + 1;
+        auto right = left + 1;
+        if (left < heap.size() && heap[left]->fires_before(*heap[soonest]))
+            soonest = left;
+        if (right < heap.size() && heap[right]->fires_before(*heap[soonest]))
+            soonest = right;
+        if (soonest == index)
+            break;
+        timer_heap_swap(index, soonest);
+        index = soonest;
+    }
+}
+
+static void timer_heap_insert(EventLoopTimer& timer)
+{
+    ASSERT(timer.heap_index == -1);
+    timer.heap_index = s_timer_heap->size();
+    s_timer_heap->append(&timer);
+    timer_heap_sift_up(timer.heap_index);
+}
+
+static void timer_heap_remove(EventLoopTimer& timer)
+{
+    auto& heap = *s_timer_heap;
+    size_t index = timer.heap_index;
+    ASSERT(heap[index] == &timer);
+    auto last = heap.size() - 1;
+    if (index != last)
+        timer_heap_swap(index, last);
+    heap.take_last();
+    timer.heap_index = -1;
+    if (index != last) {
+        timer_heap_sift_up(index);
+        timer_heap_sift_down(index);
+    }
+}
+
 class RPCClient : public Object {
     C_OBJECT(RPCClient)
 public:
@@ -226,7 +315,12 @@ EventLoop::EventLoop()
     if (!s_event_loop_stack) {
         s_event_loop_stack = new Vector<EventLoop*>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
+        s_timer_heap = new Vector<EventLoopTimer*>;
+        s_parked_timers = new Vector<EventLoopTimer*>;
         s_notifiers = new HashTable<Notifier*>;
+#ifdef __serenity__
+        s_notifiers_by_fd = new HashMap<int, Vector<Notifier*, 1>>;
+#endif
     }
 
     if (!s_main_event_loop) {
@@ -519,8 +613,59 @@ void EventLoop::unregister_signal(int handler_id)
         s_signal_handlers.remove(remove_signo);
 }
 
+#ifdef __serenity__
+static void update_epoll_interest(int epoll_fd, int fd)
+{
+    auto it = s_notifiers_by_fd->find(fd);
+    if (it == s_notifiers_by_fd->end()) {
+        // This is fine to fail, the fd may have been closed (or never watched) already.
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+
+    epoll_event event {};
+    event.data.fd = fd;
+    for (auto* notifier : it->value) {
+        if (notifier->event_mask() & Notifier::Read)
+            event.events |= EPOLLIN;
+        if (notifier->event_mask() & Notifier::Write)
+            event.events |= EPOLLOUT;
+        if (notifier->event_mask() & Notifier::Exceptional)
+            ASSERT_NOT_REACHED();
+    }
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0 && epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+        dbg() << "Core::EventLoop: Failed to watch fd " << fd << ": " << strerror(errno);
+}
+
+static int ensure_epoll_fd(int wake_pipe_fd)
+{
+    // After a fork(), the epoll set is shared with the parent. Make our own so we don't change what it watches.
+    pid_t pid = getpid();
+    if (s_epoll_fd >= 0 && s_epoll_pid == pid)
+        return s_epoll_fd;
+    if (s_epoll_fd >= 0)
+        close(s_epoll_fd);
+    s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    ASSERT(s_epoll_fd >= 0);
+    s_epoll_pid = pid;
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = wake_pipe_fd;
+    int rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, wake_pipe_fd, &event);
+    ASSERT(rc == 0);
+    for (auto& it : *s_notifiers_by_fd)
+        update_epoll_interest(s_epoll_fd, it.key);
+    return s_epoll_fd;
+}
+#endif
+
 void EventLoop::wait_for_event(WaitMode mode)
 {
+#ifdef __serenity__
+    epoll_event ready_events[max_ready_events_per_wait];
+retry:
+#else
     fd_set rfds;
     fd_set wfds;
 retry:
@@ -545,6 +690,7 @@ retry:
         if (notifier->event_mask() & Notifier::Exceptional)
             ASSERT_NOT_REACHED();
     }
+#endif
 
     bool queued_events_is_empty;
     {
@@ -555,6 +701,8 @@ retry:
     timeval now;
     struct timeval timeout = { 0, 0 };
     bool should_wait_forever = false;
+    // The timer we'll wake up for if nothing else happens first, so we can blame the wakeup on it.
+    int waking_timer_id = 0;
     if (mode == WaitMode::WaitForEvents && queued_events_is_empty) {
         auto next_timer_expiration = get_next_timer_expiration();
         if (next_timer_expiration.has_value()) {
@@ -567,13 +715,20 @@ retry:
                 timeout.tv_sec = 0;
                 timeout.tv_usec = 0;
             }
+            if (timeout.tv_sec || timeout.tv_usec)
+                waking_timer_id = s_timer_heap->first()->timer_id;
         } else {
             should_wait_forever = true;
         }
     }
 
 try_select_again:
+#ifdef __serenity__
+    int timeout_ms = should_wait_forever ? -1 : (timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000);
+    int marked_fd_count = epoll_wait(ensure_epoll_fd(s_wake_pipe_fds[0]), ready_events, max_ready_events_per_wait, timeout_ms);
+#else
     int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+#endif
     if (marked_fd_count < 0) {
         int saved_errno = errno;
         if (saved_errno == EINTR) {
@@ -587,7 +742,16 @@ try_select_again:
         // Blow up, similar to Core::safe_syscall.
         ASSERT_NOT_REACHED();
     }
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+#ifdef __serenity__
+    bool wake_pipe_is_readable = false;
+    for (int i = 0; i < marked_fd_count; ++i) {
+        if (ready_events[i].data.fd == s_wake_pipe_fds[0])
+            wake_pipe_is_readable = true;
+    }
+#else
+    bool wake_pipe_is_readable = FD_ISSET(s_wake_pipe_fds[0], &rfds);
+#endif
+    if (wake_pipe_is_readable) {
         int wake_events[8];
         auto nread = read(s_wake_pipe_fds[0], wake_events, sizeof(wake_events));
         if (nread < 0) {
@@ -615,30 +779,65 @@ try_select_again:
         now.tv_usec = now_spec.tv_nsec / 1000;
     }
 
-    for (auto& it : *s_timers) {
-        auto& timer = *it.value;
-        if (!timer.has_expired(now))
+    if (!marked_fd_count && waking_timer_id) {
+        if (auto it = s_timers->find(waking_timer_id); it != s_timers->end())
+            ++it->value->wakeup_count;
+    }
+
+    for (size_t i = 0; i < s_parked_timers->size();) {
+        auto& timer = *s_parked_timers->at(i);
+        if (timer.is_suppressed()) {
+            ++i;
             continue;
-        if (it.value->fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && it.value->owner
-            && !it.value->owner->is_visible_for_timer_purposes()) {
+        }
+        s_parked_timers->unstable_take(i);
+        timer_heap_insert(timer);
+    }
+
+    // Take all the expired timers out before rescheduling any of them, so a zero-interval timer only fires once per wakeup.
+    Vector<EventLoopTimer*, 8> expired_timers;
+    while (!s_timer_heap->is_empty() && s_timer_heap->first()->has_expired(now)) {
+        auto& timer = *s_timer_heap->first();
+        timer_heap_remove(timer);
+        expired_timers.append(&timer);
+    }
+
+    for (auto* timer : expired_timers) {
+        if (timer->is_suppressed()) {
+            s_parked_timers->append(timer);
             continue;
         }
 #ifdef EVENTLOOP_DEBUG
-        dbg() << "Core::EventLoop: Timer " << timer.timer_id << " has expired, sending Core::TimerEvent to " << timer.owner;
+        dbg() << "Core::EventLoop: Timer " << timer->timer_id << " has expired, sending Core::TimerEvent to " << timer->owner;
 #endif
-        post_event(*timer.owner, make<TimerEvent>(timer.timer_id));
-        if (timer.should_reload) {
-            timer.reload(now);
+        post_event(*timer->owner, make<TimerEvent>(timer->timer_id));
+        ++timer->fire_count;
+        if (timer->should_reload) {
+            timer->reload(now);
         } else {
             // FIXME: Support removing expired timers that don't want to reload.
             ASSERT_NOT_REACHED();
         }
+        timer_heap_insert(*timer);
     }
 
     if (!marked_fd_count)
         return;
 
+#ifdef __serenity__
+    for (int i = 0; i < marked_fd_count; ++i) {
+        int fd = ready_events[i].data.fd;
+        auto it = s_notifiers_by_fd->find(fd);
+        if (it == s_notifiers_by_fd->end())
+            continue;
+        for (auto* notifier : it->value) {
+            if ((ready_events[i].events & EPOLLIN) && (notifier->event_mask() & Notifier::Event::Read))
+                post_event(*notifier, make<NotifierReadEvent>(fd));
+            if ((ready_events[i].events & EPOLLOUT) && (notifier->event_mask() & Notifier::Event::Write))
+                post_event(*notifier, make<NotifierWriteEvent>(fd));
+        }
+    }
+#else
     for (auto& notifier : *s_notifiers) {
         if (FD_ISSET(notifier->fd(), &rfds)) {
             if (notifier->event_mask() & Notifier::Event::Read)
@@ -649,6 +848,7 @@ try_select_again:
                 post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
         }
     }
+#endif
 }
 
 bool EventLoopTimer::has_expired(const timeval& now) const
@@ -658,33 +858,44 @@ bool EventLoopTimer::has_expired(const timeval& now) const
 
 void EventLoopTimer::reload(const timeval& now)
 {
-    fire_time = now;
-    fire_time.tv_sec += interval / 1000;
-    fire_time.tv_usec += (interval % 1000) * 1000;
+    if (!slack) {
+        fire_time = now;
+        fire_time.tv_sec += interval / 1000;
+        fire_time.tv_usec += (interval % 1000) * 1000;
+        if (fire_time.tv_usec >= 1000000) {
+            ++fire_time.tv_sec;
+            fire_time.tv_usec -= 1000000;
+        }
+        return;
+    }
+    // Round the fire time up to a multiple of the slack, so that timers with the same slack
+    // which would fire close to each other end up firing in the same wakeup.
+    u64 fire_time_ms = (u64)now.tv_sec * 1000 + now.tv_usec / 1000 + interval;
+    fire_time_ms = (fire_time_ms + slack - 1) / slack * slack;
+    fire_time.tv_sec = fire_time_ms / 1000;
+    fire_time.tv_usec = (fire_time_ms % 1000) * 1000;
+}
+
+bool EventLoopTimer::fires_before(const EventLoopTimer& other) const
+{
+    return fire_time.tv_sec < other.fire_time.tv_sec || (fire_time.tv_sec == other.fire_time.tv_sec && fire_time.tv_usec < other.fire_time.tv_usec);
 }
 
 Optional<struct timeval> EventLoop::get_next_timer_expiration()
 {
-    Optional<struct timeval> soonest {};
-    for (auto& it : *s_timers) {
-        auto& fire_time = it.value->fire_time;
-        if (it.value->fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && it.value->owner
-            && !it.value->owner->is_visible_for_timer_purposes()) {
-            continue;
-        }
-        if (!soonest.has_value() || fire_time.tv_sec < soonest.value().tv_sec || (fire_time.tv_sec == soonest.value().tv_sec && fire_time.tv_usec < soonest.value().tv_usec))
-            soonest = fire_time;
-    }
-    return soonest;
+    if (s_timer_heap->is_empty())
+        return {};
+    return s_timer_heap->first()->fire_time;
 }
 
-int EventLoop::register_timer(Object& object, int milliseconds, bool should_reload, TimerShouldFireWhenNotVisible fire_when_not_visible)
+int EventLoop::register_timer(Object& object, int milliseconds, bool should_reload, TimerShouldFireWhenNotVisible fire_when_not_visible, int slack_milliseconds)
 {
     ASSERT(milliseconds >= 0);
+    ASSERT(slack_milliseconds >= 0);
     auto timer = make<EventLoopTimer>();
     timer->owner = object.make_weak_ptr();
     timer->interval = milliseconds;
+    timer->slack = slack_milliseconds;
     timeval now;
     timespec now_spec;
     clock_gettime(CLOCK_MONOTONIC, &now_spec);
@@ -695,6 +906,7 @@ int EventLoop::register_timer(Object& object, int milliseconds, bool should_relo
     timer->fire_when_not_visible = fire_when_not_visible;
     int timer_id = s_id_allocator->allocate();
     timer->timer_id = timer_id;
+    timer_heap_insert(*timer);
     s_timers->set(timer_id, move(timer));
     return timer_id;
 }
@@ -705,18 +917,58 @@ bool EventLoop::unregister_timer(int timer_id)
     auto it = s_timers->find(timer_id);
     if (it == s_timers->end())
         return false;
+    auto& timer = *it->value;
+    if (timer.heap_index != -1) {
+        timer_heap_remove(timer);
+    } else {
+        s_parked_timers->remove_first_matching([&](auto* parked_timer) { return parked_timer == &timer; });
+    }
     s_timers->remove(it);
     return true;
 }
 
+Optional<EventLoop::TimerStatistics> EventLoop::timer_statistics(int timer_id)
+{
+    auto it = s_timers->find(timer_id);
+    if (it == s_timers->end())
+        return {};
+    auto& timer = *it->value;
+    return TimerStatistics { timer.interval, timer.slack, timer.fire_count, timer.wakeup_count };
+}
+
 void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
     s_notifiers->set(&notifier);
+#ifdef __serenity__
+    auto& notifiers = s_notifiers_by_fd->ensure(notifier.fd());
+    if (!notifiers.contains_slow(&notifier))
+        notifiers.append(&notifier);
+    update_epoll_interest(ensure_epoll_fd(s_wake_pipe_fds[0]), notifier.fd());
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
     s_notifiers->remove(&notifier);
+#ifdef __serenity__
+    auto it = s_notifiers_by_fd->find(notifier.fd());
+    if (it == s_notifiers_by_fd->end())
+        return;
+    it->value.remove_first_matching([&](auto* entry) { return entry == &notifier; });
+    if (it->value.is_empty())
+        s_notifiers_by_fd->remove(it);
+    update_epoll_interest(ensure_epoll_fd(s_wake_pipe_fds[0]), notifier.fd());
+#endif
+}
+
+void EventLoop::notifier_event_mask_changed(Badge<Notifier>, Notifier& notifier)
+{
+#ifdef __serenity__
+    if (s_notifiers_by_fd->contains(notifier.fd()))
+        update_epoll_interest(ensure_epoll_fd(s_wake_pipe_fds[0]), notifier.fd());
+#else
+    (void)notifier;
+#endif
 }
 
 void EventLoop::wake()
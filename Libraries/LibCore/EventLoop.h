@@ -62,11 +62,23 @@ public:
 
     bool was_exit_requested() const { return m_exit_requested; }
 
-    static int register_timer(Object&, int milliseconds, bool should_reload, TimerShouldFireWhenNotVisible);
+    // A timer with some slack may fire up to that many milliseconds late, so that it can
+    // share a wakeup with other timers.
+    static int register_timer(Object&, int milliseconds, bool should_reload, TimerShouldFireWhenNotVisible, int slack_milliseconds = 0);
     static bool unregister_timer(int timer_id);
 
+    struct TimerStatistics {
+        int interval { 0 };
+        int slack { 0 };
+        u64 fire_count { 0 };
+        // How many times this timer was the reason we stopped waiting for events.
+        u64 wakeup_count { 0 };
+    };
+    static Optional<TimerStatistics> timer_statistics(int timer_id);
+
     static void register_notifier(Badge<Notifier>, Notifier&);
     static void unregister_notifier(Badge<Notifier>, Notifier&);
+    static void notifier_event_mask_changed(Badge<Notifier>, Notifier&);
 
     void quit(int);
     void unquit();
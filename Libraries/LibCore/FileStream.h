@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Stream.h>
+#include <errno.h>
+#include <unistd.h>
+
+namespace Core {
+
+// An AK::InputStream that reads straight from a file descriptor, without buffering the whole file.
+class InputFileStream final : public InputStream {
+public:
+    explicit InputFileStream(int fd)
+        : m_fd(fd)
+    {
+    }
+
+    bool eof() const override { return m_eof; }
+
+    size_t read(Bytes bytes) override
+    {
+        size_t nread = 0;
+        while (nread < bytes.size() && !m_eof) {
+            ssize_t rc = ::read(m_fd, bytes.data() + nread, bytes.size() - nread);
+            if (rc < 0) {
+                if (errno == EINTR)
+                    continue;
+                m_error = true;
+                break;
+            }
+            if (rc == 0) {
+                m_eof = true;
+                break;
+            }
+            nread += rc;
+        }
+        return nread;
+    }
+
+    bool read_or_error(Bytes bytes) override
+    {
+        if (read(bytes) < bytes.size()) {
+            m_error = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool discard_or_error(size_t count) override
+    {
+        u8 buffer[4096];
+        while (count) {
+            size_t chunk = min(count, sizeof(buffer));
+            if (!read_or_error({ buffer, chunk }))
+                return false;
+            count -= chunk;
+        }
+        return true;
+    }
+
+private:
+    int m_fd { -1 };
+    bool m_eof { false };
+};
+
+}
@@ -38,7 +38,9 @@ class ElapsedTimer;
 class Event;
 class EventLoop;
 class File;
+class InputFileStream;
 class IODevice;
+class IORing;
 class LocalServer;
 class LocalSocket;
 class MimeData;
@@ -34,6 +34,7 @@
 #include <sys/select.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace Core {
@@ -57,10 +58,56 @@ int IODevice::read(u8* buffer, int length)
     auto read_buffer = read(length);
     if (read_buffer.is_null())
         return 0;
-    memcpy(buffer, read_buffer.data(), length);
+    memcpy(buffer, read_buffer.data(), read_buffer.size());
     return read_buffer.size();
 }
 
+Optional<size_t> IODevice::find_in_read_buffer(u8 byte, size_t max_size) const
+{
+    auto size = min(max_size, m_buffered_size);
+    auto first_size = min(size, m_read_buffer.size() - m_buffered_start);
+    if (auto* found = (const u8*)memchr(m_read_buffer.data() + m_buffered_start, byte, first_size))
+        return found - (m_read_buffer.data() + m_buffered_start);
+    if (first_size == size)
+        return {};
+    if (auto* found = (const u8*)memchr(m_read_buffer.data(), byte, size - first_size))
+        return first_size + (found - m_read_buffer.data());
+    return {};
+}
+
+void IODevice::copy_from_read_buffer(u8* destination, size_t size) const
+{
+    ASSERT(size <= m_buffered_size);
+    auto first_size = min(size, m_read_buffer.size() - m_buffered_start);
+    memcpy(destination, m_read_buffer.data() + m_buffered_start, first_size);
+    memcpy(destination + first_size, m_read_buffer.data(), size - first_size);
+}
+
+void IODevice::consume_from_read_buffer(size_t size) const
+{
+    ASSERT(size <= m_buffered_size);
+    m_buffered_size -= size;
+    m_buffered_start = m_buffered_size ? (m_buffered_start + size) % m_read_buffer.size() : 0;
+}
+
+void IODevice::reallocate_read_buffer(size_t capacity) const
+{
+    ASSERT(capacity >= m_buffered_size);
+    auto new_buffer = ByteBuffer::create_uninitialized(capacity);
+    if (m_buffered_size)
+        copy_from_read_buffer(new_buffer.data(), m_buffered_size);
+    m_read_buffer = move(new_buffer);
+    m_buffered_start = 0;
+}
+
+void IODevice::set_read_buffer_size(size_t size)
+{
+    ASSERT(size > 0);
+    m_read_buffer_size = size;
+    if (!m_read_buffer.is_null() && m_read_buffer.size() < size)
+        reallocate_read_buffer(size);
+}
+
 ByteBuffer IODevice::read(size_t max_size)
 {
     if (m_fd < 0)
@@ -71,12 +118,10 @@ ByteBuffer IODevice::read(size_t max_size)
     auto* buffer_ptr = (char*)buffer.data();
     size_t remaining_buffer_space = buffer.size();
     size_t taken_from_buffered = 0;
-    if (!m_buffered_data.is_empty()) {
-        taken_from_buffered = min(remaining_buffer_space, m_buffered_data.size());
-        memcpy(buffer_ptr, m_buffered_data.data(), taken_from_buffered);
-        Vector<u8> new_buffered_data;
-        new_buffered_data.append(m_buffered_data.data() + taken_from_buffered, m_buffered_data.size() - taken_from_buffered);
-        m_buffered_data = move(new_buffered_data);
+    if (m_buffered_size) {
+        taken_from_buffered = min(remaining_buffer_space, m_buffered_size);
+        copy_from_read_buffer((u8*)buffer_ptr, taken_from_buffered);
+        consume_from_read_buffer(taken_from_buffered);
         remaining_buffer_space -= taken_from_buffered;
         buffer_ptr += taken_from_buffered;
     }
@@ -123,19 +168,22 @@ bool IODevice::can_read_from_fd() const
 
 bool IODevice::can_read_line() const
 {
-    if (m_eof && !m_buffered_data.is_empty())
-        return true;
-    if (m_buffered_data.contains_slow('\n'))
+    if (find_in_read_buffer('\n', m_buffered_size).has_value())
         return true;
-    if (!can_read_from_fd())
-        return false;
-    populate_read_buffer();
-    return m_buffered_data.contains_slow('\n');
+    // Keep reading for as long as that doesn't block, since the line may be longer than the buffer.
+    while (!m_eof && can_read_from_fd()) {
+        if (!populate_read_buffer())
+            break;
+        if (find_in_read_buffer('\n', m_buffered_size).has_value())
+            return true;
+    }
+    // What's left at the end of the file counts as a line, even without a newline.
+    return m_eof && m_buffered_size;
 }
 
 bool IODevice::can_read() const
 {
-    return !m_buffered_data.is_empty() || can_read_from_fd();
+    return m_buffered_size || can_read_from_fd();
 }
 
 ByteBuffer IODevice::read_all()
@@ -147,11 +195,12 @@ ByteBuffer IODevice::read_all()
         file_size = st.st_size;
 
     Vector<u8> data;
-    data.ensure_capacity(file_size);
+    data.ensure_capacity(max(file_size, (off_t)m_buffered_size));
 
-    if (!m_buffered_data.is_empty()) {
-        data.append(m_buffered_data.data(), m_buffered_data.size());
-        m_buffered_data.clear();
+    if (m_buffered_size) {
+        data.resize(m_buffered_size);
+        copy_from_read_buffer(data.data(), m_buffered_size);
+        consume_from_read_buffer(m_buffered_size);
     }
 
     while (true) {
@@ -172,7 +221,7 @@ ByteBuffer IODevice::read_all()
     return ByteBuffer::copy(data.data(), data.size());
 }
 
-ByteBuffer IODevice::read_line(size_t max_size)
+StringView IODevice::read_line_view(size_t max_size)
 {
     if (m_fd < 0)
         return {};
@@ -180,38 +229,65 @@ ByteBuffer IODevice::read_line(size_t max_size)
         return {};
     if (!can_read_line())
         return {};
-    if (m_eof) {
-        if (m_buffered_data.size() > max_size) {
+
+    size_t line_length = 0;
+    if (auto newline = find_in_read_buffer('\n', max_size); newline.has_value()) {
+        line_length = newline.value() + 1;
+    } else if (m_eof && m_buffered_size <= max_size) {
+        line_length = m_buffered_size;
+    } else {
+        if (m_eof)
             dbgprintf("IODevice::read_line: At EOF but there's more than max_size(%zu) buffered\n", max_size);
-            return {};
-        }
-        auto buffer = ByteBuffer::copy(m_buffered_data.data(), m_buffered_data.size());
-        m_buffered_data.clear();
-        return buffer;
-    }
-    auto line = ByteBuffer::create_uninitialized(max_size + 1);
-    size_t line_index = 0;
-    while (line_index < max_size) {
-        u8 ch = m_buffered_data[line_index];
-        line[line_index++] = ch;
-        if (ch == '\n') {
-            Vector<u8> new_buffered_data;
-            new_buffered_data.append(m_buffered_data.data() + line_index, m_buffered_data.size() - line_index);
-            m_buffered_data = move(new_buffered_data);
-            line[line_index] = '\0';
-            line.trim(line_index + 1);
-            return line;
-        }
+        return {};
     }
-    return {};
+
+    // The line has to be contiguous to be viewed, so straighten out the buffer if it wraps around.
+    if (m_buffered_start + line_length > m_read_buffer.size())
+        reallocate_read_buffer(m_read_buffer.size());
+    StringView line { (const char*)m_read_buffer.data() + m_buffered_start, line_length };
+    consume_from_read_buffer(line_length);
+    return line;
+}
+
+ByteBuffer IODevice::read_line(size_t max_size)
+{
+    auto line = read_line_view(max_size);
+    if (line.is_null())
+        return {};
+    if (!line.ends_with('\n'))
+        return ByteBuffer::copy(line.characters_without_null_termination(), line.length());
+    // Lines that end in a newline have always been null-terminated, and callers rely on that.
+    auto buffer = ByteBuffer::create_uninitialized(line.length() + 1);
+    memcpy(buffer.data(), line.characters_without_null_termination(), line.length());
+    buffer[line.length()] = '\0';
+    return buffer;
 }
 
 bool IODevice::populate_read_buffer() const
 {
     if (m_fd < 0)
         return false;
-    u8 buffer[1024];
-    int nread = ::read(m_fd, buffer, sizeof(buffer));
+    if (m_read_buffer.is_null())
+        reallocate_read_buffer(m_read_buffer_size);
+    else if (m_buffered_size == m_read_buffer.size())
+        reallocate_read_buffer(m_read_buffer.size() * 2);
+
+    // Fill all the free space in one go, even if it wraps around the end of the buffer.
+    auto capacity = m_read_buffer.size();
+    auto free_start = (m_buffered_start + m_buffered_size) % capacity;
+    iovec iov[2];
+    int iov_count = 1;
+    if (free_start >= m_buffered_start) {
+        iov[0] = { m_read_buffer.data() + free_start, capacity - free_start };
+        if (m_buffered_start) {
+            iov[1] = { m_read_buffer.data(), m_buffered_start };
+            iov_count = 2;
+        }
+    } else {
+        iov[0] = { m_read_buffer.data() + free_start, m_buffered_start - free_start };
+    }
+
+    int nread = ::readv(m_fd, iov, iov_count);
     if (nread < 0) {
         set_error(errno);
         return false;
@@ -220,7 +296,7 @@ bool IODevice::populate_read_buffer() const
         set_eof(true);
         return false;
     }
-    m_buffered_data.append(buffer, nread);
+    m_buffered_size += nread;
     return true;
 }
 
@@ -259,7 +335,8 @@ bool IODevice::seek(i64 offset, SeekMode mode, off_t* pos)
             *pos = -1;
         return false;
     }
-    m_buffered_data.clear();
+    m_buffered_start = 0;
+    m_buffered_size = 0;
     m_eof = false;
     if (pos)
         *pos = rc;
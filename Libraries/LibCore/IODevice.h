@@ -26,7 +26,10 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/Forward.h>
+#include <AK/Optional.h>
+#include <AK/StringView.h>
 #include <LibCore/Object.h>
 
 namespace Core {
@@ -62,6 +65,14 @@ public:
     ByteBuffer read_line(size_t max_size);
     ByteBuffer read_all();
 
+    // Like read_line(), but returns a view into the read buffer instead of copying the line.
+    // The view includes the trailing newline (if any), and is only valid until the next read.
+    StringView read_line_view(size_t max_size);
+
+    // Reads from the fd are done in chunks of (at least) this size. Lines longer than this
+    // temporarily grow the buffer.
+    void set_read_buffer_size(size_t);
+
     bool write(const u8*, int size);
     bool write(const StringView&);
 
@@ -96,11 +107,21 @@ private:
     bool populate_read_buffer() const;
     bool can_read_from_fd() const;
 
+    Optional<size_t> find_in_read_buffer(u8, size_t max_size) const;
+    void copy_from_read_buffer(u8*, size_t) const;
+    void consume_from_read_buffer(size_t) const;
+    void reallocate_read_buffer(size_t capacity) const;
+
     int m_fd { -1 };
     OpenMode m_mode { NotOpen };
     mutable int m_error { 0 };
     mutable bool m_eof { false };
-    mutable Vector<u8> m_buffered_data;
+
+    // The buffered data is m_buffered_size bytes starting at m_buffered_start, wrapping around the end of m_read_buffer.
+    mutable ByteBuffer m_read_buffer;
+    mutable size_t m_buffered_start { 0 };
+    mutable size_t m_buffered_size { 0 };
+    size_t m_read_buffer_size { 4096 };
 };
 
 }
@@ -43,11 +43,15 @@ public:
         return exchange(m_had_failure, false);
     }
 
+    // The number of bytes read from the device so far.
+    size_t offset() const { return m_offset; }
+
     template<typename T>
     IODeviceStreamReader& operator>>(T& value)
     {
         int nread = m_device.read((u8*)&value, sizeof(T));
         ASSERT(nread == sizeof(T));
+        m_offset += nread;
         if (nread != sizeof(T))
             m_had_failure = true;
         return *this;
@@ -56,6 +60,7 @@ public:
 private:
     IODevice& m_device;
     bool m_had_failure { false };
+    size_t m_offset { 0 };
 };
 
 }
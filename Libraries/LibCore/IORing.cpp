@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef __serenity__
+
+#    include <AK/Atomic.h>
+#    include <LibCore/IORing.h>
+#    include <errno.h>
+#    include <stdio.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+
+namespace Core {
+
+IORing::IORing(u32 entries, Object* parent)
+    : Object(parent)
+{
+    m_fd = io_ring_setup(entries, &m_params);
+    if (m_fd < 0) {
+        perror("io_ring_setup");
+        return;
+    }
+    auto* mapping = mmap(nullptr, m_params.mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_mapping = static_cast<u8*>(mapping);
+
+    m_notifier = Notifier::construct(m_fd, Notifier::Event::Read, this);
+    m_notifier->on_ready_to_read = [this] {
+        drain_completions();
+    };
+}
+
+IORing::~IORing()
+{
+    if (m_mapping)
+        munmap(m_mapping, m_params.mapping_size);
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+bool IORing::enqueue(const io_ring_sqe& sqe)
+{
+    if (!is_valid())
+        return false;
+    u32 head = AK::atomic_load(&header().sq_head, AK::MemoryOrder::memory_order_acquire);
+    u32 tail = header().sq_tail;
+    if (tail - head >= m_params.sq_entries)
+        return false;
+    submission_entries()[tail & (m_params.sq_entries - 1)] = sqe;
+    AK::atomic_store(&header().sq_tail, tail + 1, AK::MemoryOrder::memory_order_release);
+    ++m_queued_count;
+    return true;
+}
+
+bool IORing::enqueue_read(int fd, void* buffer, size_t size, i64 offset, u64 user_data)
+{
+    return enqueue({ IO_RING_OP_READ, fd, offset, buffer, nullptr, (u32)size, user_data });
+}
+
+bool IORing::enqueue_write(int fd, const void* data, size_t size, i64 offset, u64 user_data)
+{
+    return enqueue({ IO_RING_OP_WRITE, fd, offset, const_cast<void*>(data), nullptr, (u32)size, user_data });
+}
+
+bool IORing::enqueue_accept(int fd, sockaddr* address, socklen_t* address_size, u64 user_data)
+{
+    return enqueue({ IO_RING_OP_ACCEPT, fd, 0, address, address_size, 0, user_data });
+}
+
+bool IORing::enqueue_connect(int fd, const sockaddr* address, socklen_t address_size, u64 user_data)
+{
+    return enqueue({ IO_RING_OP_CONNECT, fd, 0, const_cast<sockaddr*>(address), nullptr, address_size, user_data });
+}
+
+bool IORing::enqueue_fsync(int fd, u64 user_data)
+{
+    return enqueue({ IO_RING_OP_FSYNC, fd, 0, nullptr, nullptr, 0, user_data });
+}
+
+int IORing::submit()
+{
+    if (!is_valid())
+        return -1;
+    int rc = io_ring_enter(m_fd, m_queued_count, 0);
+    if (rc < 0 && errno == EBUSY) {
+        // Every completion slot is taken, so make some room before trying again.
+        if (!wait_for_completions(1))
+            return -1;
+        rc = io_ring_enter(m_fd, m_queued_count, 0);
+    }
+    if (rc < 0) {
+        perror("io_ring_enter");
+        return rc;
+    }
+    m_queued_count -= rc;
+    return rc;
+}
+
+bool IORing::wait_for_completions(u32 count)
+{
+    if (!is_valid())
+        return false;
+    if (io_ring_enter(m_fd, 0, count) < 0) {
+        perror("io_ring_enter");
+        return false;
+    }
+    drain_completions();
+    return true;
+}
+
+void IORing::drain_completions()
+{
+    for (;;) {
+        u32 head = header().cq_head;
+        u32 tail = AK::atomic_load(&header().cq_tail, AK::MemoryOrder::memory_order_acquire);
+        if (head == tail) {
+            // The kernel may be holding on to completions that didn't fit before.
+            if (io_ring_enter(m_fd, 0, 0) < 0)
+                perror("io_ring_enter");
+            if (AK::atomic_load(&header().cq_tail, AK::MemoryOrder::memory_order_acquire) == head)
+                return;
+            continue;
+        }
+        auto cqe = completion_entries()[head & (m_params.cq_entries - 1)];
+        AK::atomic_store(&header().cq_head, head + 1, AK::MemoryOrder::memory_order_release);
+        if (on_completion)
+            on_completion(cqe.user_data, cqe.result);
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <LibCore/Notifier.h>
+#include <LibCore/Object.h>
+#include <sys/io_ring.h>
+#include <sys/socket.h>
+
+namespace Core {
+
+// Batches I/O operations into a kernel submission ring and reports their results
+// from the event loop, so reads and writes can overlap without extra threads.
+class IORing final : public Object {
+    C_OBJECT(IORing)
+public:
+    virtual ~IORing() override;
+
+    bool is_valid() const { return m_fd >= 0; }
+
+    // These only queue the operation, nothing is started until submit().
+    // A negative offset means to use (and advance) the file's current offset.
+    bool enqueue_read(int fd, void* buffer, size_t size, i64 offset, u64 user_data);
+    bool enqueue_write(int fd, const void* data, size_t size, i64 offset, u64 user_data);
+    bool enqueue_accept(int fd, sockaddr* address, socklen_t* address_size, u64 user_data);
+    bool enqueue_connect(int fd, const sockaddr* address, socklen_t address_size, u64 user_data);
+    bool enqueue_fsync(int fd, u64 user_data);
+
+    // Hands everything queued so far to the kernel. Returns the number of submitted operations, or -1.
+    // If the completion queue is full, this waits for (and handles) a completion first.
+    int submit();
+
+    // Blocks until at least this many operations have completed and reports them right away,
+    // for callers that drive the ring themselves rather than from the event loop.
+    bool wait_for_completions(u32 count);
+
+    Function<void(u64 user_data, i32 result)> on_completion;
+
+private:
+    explicit IORing(u32 entries = 64, Object* parent = nullptr);
+
+    bool enqueue(const io_ring_sqe&);
+    void drain_completions();
+
+    io_ring_header& header() { return *reinterpret_cast<io_ring_header*>(m_mapping); }
+    io_ring_sqe* submission_entries() { return reinterpret_cast<io_ring_sqe*>(m_mapping + m_params.sq_offset); }
+    io_ring_cqe* completion_entries() { return reinterpret_cast<io_ring_cqe*>(m_mapping + m_params.cq_offset); }
+
+    int m_fd { -1 };
+    u8* m_mapping { nullptr };
+    io_ring_params m_params {};
+    u32 m_queued_count { 0 };
+    RefPtr<Notifier> m_notifier;
+};
+
+}
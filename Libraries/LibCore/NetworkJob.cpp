@@ -88,6 +88,22 @@ void NetworkJob::did_progress(Optional<u32> total_size, u32 downloaded)
         on_progress(total_size, downloaded);
 }
 
+void NetworkJob::did_receive_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, Optional<u32> response_code)
+{
+    NonnullRefPtr<NetworkJob> protector(*this);
+
+    if (on_headers_received)
+        on_headers_received(response_headers, response_code);
+}
+
+void NetworkJob::did_receive_data(ReadonlyBytes data)
+{
+    NonnullRefPtr<NetworkJob> protector(*this);
+
+    if (on_data_received)
+        on_data_received(data);
+}
+
 const char* to_string(NetworkJob::Error error)
 {
     switch (error) {
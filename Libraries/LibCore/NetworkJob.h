@@ -27,6 +27,9 @@
 #pragma once
 
 #include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/Span.h>
+#include <AK/String.h>
 #include <LibCore/Object.h>
 
 namespace Core {
@@ -46,6 +49,11 @@ public:
     Function<void(bool success)> on_finish;
     Function<void(Optional<u32>, u32)> on_progress;
 
+    // These are for clients that want to look at the response body while it's still coming in.
+    // NOTE: Not every job can provide them, and the complete body is always passed along in the final response.
+    Function<void(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, Optional<u32> response_code)> on_headers_received;
+    Function<void(ReadonlyBytes)> on_data_received;
+
     bool is_cancelled() const { return m_error == Error::Cancelled; }
     bool has_error() const { return m_error != Error::None; }
     Error error() const { return m_error; }
@@ -66,6 +74,8 @@ protected:
     void did_finish(NonnullRefPtr<NetworkResponse>&&);
     void did_fail(Error);
     void did_progress(Optional<u32> total_size, u32 downloaded);
+    void did_receive_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, Optional<u32> response_code);
+    void did_receive_data(ReadonlyBytes);
 
 private:
     RefPtr<NetworkResponse> m_response;
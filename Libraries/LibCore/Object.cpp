@@ -131,14 +131,14 @@ void Object::custom_event(CustomEvent&)
 {
 }
 
-void Object::start_timer(int ms, TimerShouldFireWhenNotVisible fire_when_not_visible)
+void Object::start_timer(int ms, TimerShouldFireWhenNotVisible fire_when_not_visible, int slack_ms)
 {
     if (m_timer_id) {
         dbgprintf("Object{%p} already has a timer!\n", this);
         ASSERT_NOT_REACHED();
     }
 
-    m_timer_id = Core::EventLoop::register_timer(*this, ms, true, fire_when_not_visible);
+    m_timer_id = Core::EventLoop::register_timer(*this, ms, true, fire_when_not_visible, slack_ms);
 }
 
 void Object::stop_timer()
@@ -174,6 +174,15 @@ void Object::save_to(JsonObject& json)
     json.set("address", (FlatPtr)this);
     json.set("name", name());
     json.set("parent", (FlatPtr)parent());
+    if (m_timer_id) {
+        auto statistics = Core::EventLoop::timer_statistics(m_timer_id);
+        if (statistics.has_value()) {
+            json.set("timer_interval", statistics.value().interval);
+            json.set("timer_slack", statistics.value().slack);
+            json.set("timer_fire_count", statistics.value().fire_count);
+            json.set("timer_wakeup_count", statistics.value().wakeup_count);
+        }
+    }
 }
 
 bool Object::set_property(const StringView& name, const JsonValue& value)
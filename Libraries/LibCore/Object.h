@@ -95,7 +95,7 @@ public:
     Object* parent() { return m_parent; }
     const Object* parent() const { return m_parent; }
 
-    void start_timer(int ms, TimerShouldFireWhenNotVisible = TimerShouldFireWhenNotVisible::No);
+    void start_timer(int ms, TimerShouldFireWhenNotVisible = TimerShouldFireWhenNotVisible::No, int slack_ms = 0);
     void stop_timer();
     bool has_timer() const { return m_timer_id; }
 
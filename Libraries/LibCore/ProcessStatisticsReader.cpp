@@ -24,20 +24,264 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashTable.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <LibCore/File.h>
 #include <LibCore/ProcessStatisticsReader.h>
+#include <errno.h>
+#include <limits.h>
 #include <pwd.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 namespace Core {
 
 HashMap<uid_t, String> ProcessStatisticsReader::s_usernames;
+RefPtr<Core::File> ProcessStatisticsReader::s_binary_file;
+
+ProcessStatisticsReader::ProcessStatisticsReader()
+{
+}
+
+ProcessStatisticsReader::~ProcessStatisticsReader()
+{
+}
+
+template<size_t N>
+static String string_from_record_field(const char (&field)[N])
+{
+    return String(field, strnlen(field, N));
+}
+
+// Calls callback(record, record_bytes) for every process in a /proc/all.bin snapshot, where
+// record_bytes covers the process record and all of its thread records. The whole snapshot
+// is validated up front, so the callback never sees a partial one.
+template<typename Callback>
+static bool for_each_binary_record(ReadonlyBytes contents, Callback callback)
+{
+    if (contents.size() < sizeof(ProcessStatsFileHeader))
+        return false;
+    auto& file_header = *reinterpret_cast<const ProcessStatsFileHeader*>(contents.data());
+    if (file_header.header.magic != PROC_STATS_MAGIC || file_header.header.version != PROC_STATS_VERSION)
+        return false;
+    if (file_header.process_record_size < sizeof(ProcessStatsRecord) || file_header.thread_record_size < sizeof(ThreadStatsRecord))
+        return false;
+
+    size_t offset = file_header.header.header_size;
+    for (u32 i = 0; i < file_header.process_count; ++i) {
+        if (offset + file_header.process_record_size > contents.size())
+            return false;
+        auto& record = *reinterpret_cast<const ProcessStatsRecord*>(contents.data() + offset);
+        offset += file_header.process_record_size + (size_t)record.thread_count * file_header.thread_record_size;
+        if (offset > contents.size())
+            return false;
+    }
+
+    offset = file_header.header.header_size;
+    for (u32 i = 0; i < file_header.process_count; ++i) {
+        auto& record = *reinterpret_cast<const ProcessStatsRecord*>(contents.data() + offset);
+        size_t record_size = file_header.process_record_size + (size_t)record.thread_count * file_header.thread_record_size;
+        callback(file_header, record, contents.slice(offset, record_size));
+        offset += record_size;
+    }
+    return true;
+}
+
+static void fill_from_binary_record(Core::ProcessStatistics& process, const ProcessStatsFileHeader& file_header, const ProcessStatsRecord& record, ReadonlyBytes record_bytes)
+{
+    process.pid = record.pid;
+    process.pgid = record.pgid;
+    process.pgp = record.pgp;
+    process.sid = record.sid;
+    process.uid = record.uid;
+    process.gid = record.gid;
+    process.ppid = record.ppid;
+    process.nfds = record.nfds;
+    process.name = string_from_record_field(record.name);
+    process.tty = string_from_record_field(record.tty);
+    process.pledge = string_from_record_field(record.pledge);
+    process.veil = string_from_record_field(record.veil);
+    process.amount_virtual = record.amount_virtual;
+    process.amount_resident = record.amount_resident;
+    process.amount_shared = record.amount_shared;
+    process.amount_dirty_private = record.amount_dirty_private;
+    process.amount_clean_inode = record.amount_clean_inode;
+    process.amount_purgeable_volatile = record.amount_purgeable_volatile;
+    process.amount_purgeable_nonvolatile = record.amount_purgeable_nonvolatile;
+    process.icon_id = record.icon_id;
+
+    process.threads.clear();
+    process.threads.ensure_capacity(record.thread_count);
+    size_t offset = file_header.process_record_size;
+    for (u32 j = 0; j < record.thread_count; ++j) {
+        auto& thread_record = *reinterpret_cast<const ThreadStatsRecord*>(record_bytes.offset(offset));
+        offset += file_header.thread_record_size;
+
+        Core::ThreadStatistics thread;
+        thread.tid = thread_record.tid;
+        thread.times_scheduled = thread_record.times_scheduled;
+        thread.name = string_from_record_field(thread_record.name);
+        thread.state = string_from_record_field(thread_record.state);
+        thread.ticks = thread_record.ticks;
+        thread.cpu = thread_record.cpu;
+        thread.priority = thread_record.priority;
+        thread.effective_priority = thread_record.effective_priority;
+        thread.syscall_count = thread_record.syscall_count;
+        thread.inode_faults = thread_record.inode_faults;
+        thread.zero_faults = thread_record.zero_faults;
+        thread.cow_faults = thread_record.cow_faults;
+        thread.unix_socket_read_bytes = thread_record.unix_socket_read_bytes;
+        thread.unix_socket_write_bytes = thread_record.unix_socket_write_bytes;
+        thread.ipv4_socket_read_bytes = thread_record.ipv4_socket_read_bytes;
+        thread.ipv4_socket_write_bytes = thread_record.ipv4_socket_write_bytes;
+        thread.file_read_bytes = thread_record.file_read_bytes;
+        thread.file_write_bytes = thread_record.file_write_bytes;
+        thread.fpu_saves = thread_record.fpu_saves;
+        thread.fpu_restores = thread_record.fpu_restores;
+        thread.block_io_requests = thread_record.block_io_requests;
+        process.threads.append(move(thread));
+    }
+}
+
+static RefPtr<Core::File> open_binary_file()
+{
+    auto file = Core::File::construct("/proc/all.bin");
+    if (!file->open(Core::IODevice::ReadOnly))
+        return nullptr;
+    return file;
+}
+
+Optional<HashMap<pid_t, Core::ProcessStatistics>> ProcessStatisticsReader::get_all_from_binary()
+{
+    // Keeping the file open saves us the path resolution, and reading from the start regenerates it.
+    if (!s_binary_file) {
+        s_binary_file = open_binary_file();
+        if (!s_binary_file)
+            return {};
+    } else if (!s_binary_file->seek(0)) {
+        return {};
+    }
+
+    auto file_contents = s_binary_file->read_all();
+    HashMap<pid_t, Core::ProcessStatistics> map;
+    bool ok = for_each_binary_record(file_contents, [&](auto& file_header, auto& record, auto record_bytes) {
+        Core::ProcessStatistics process;
+        fill_from_binary_record(process, file_header, record, record_bytes);
+        process.username = username_from_uid(process.uid);
+        map.set(process.pid, move(process));
+    });
+    if (!ok)
+        return {};
+    return map;
+}
+
+bool ProcessStatisticsReader::read_binary_snapshot()
+{
+    if (!m_binary_file) {
+        m_binary_file = open_binary_file();
+        if (!m_binary_file)
+            return false;
+    }
+
+    // Read straight into a buffer we keep between updates instead of allocating a fresh one each time.
+    int fd = m_binary_file->fd();
+    if (lseek(fd, 0, SEEK_SET) < 0)
+        return false;
+    m_snapshot_size = 0;
+    for (;;) {
+        if (m_snapshot.size() - m_snapshot_size < (size_t)PAGE_SIZE)
+            m_snapshot.grow(max(m_snapshot.size() * 2, (size_t)4 * PAGE_SIZE));
+        ssize_t nread = ::read(fd, m_snapshot.data() + m_snapshot_size, m_snapshot.size() - m_snapshot_size);
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (nread == 0)
+            return true;
+        m_snapshot_size += nread;
+    }
+}
+
+bool ProcessStatisticsReader::update_from_binary()
+{
+    if (!read_binary_snapshot())
+        return false;
+
+    HashTable<pid_t> live_pids;
+    bool ok = for_each_binary_record(m_snapshot.bytes().slice(0, m_snapshot_size), [&](auto& file_header, auto& record, auto record_bytes) {
+        live_pids.set(record.pid);
+
+        auto it = m_raw_records.find(record.pid);
+        bool is_new = it == m_raw_records.end();
+        if (!is_new) {
+            auto& previous_bytes = (*it).value;
+            if (previous_bytes.size() == record_bytes.size() && !memcmp(previous_bytes.data(), record_bytes.data(), record_bytes.size()))
+                return;
+            if (previous_bytes.size() == record_bytes.size())
+                memcpy(previous_bytes.data(), record_bytes.data(), record_bytes.size());
+            else
+                previous_bytes = ByteBuffer::copy(record_bytes.data(), record_bytes.size());
+        } else {
+            m_raw_records.set(record.pid, ByteBuffer::copy(record_bytes.data(), record_bytes.size()));
+        }
+
+        auto& process = m_processes.ensure(record.pid);
+        fill_from_binary_record(process, file_header, record, record_bytes);
+        process.username = username_from_uid(process.uid);
+        (is_new ? m_changes.added : m_changes.changed).append(record.pid);
+    });
+    if (!ok)
+        return false;
+
+    for (auto& it : m_processes) {
+        if (!live_pids.contains(it.key))
+            m_changes.exited.append(it.key);
+    }
+    for (auto pid : m_changes.exited) {
+        m_processes.remove(pid);
+        m_raw_records.remove(pid);
+    }
+    return true;
+}
+
+void ProcessStatisticsReader::update_from_json()
+{
+    // Without the raw records there's nothing cheap to compare, so every surviving process counts as changed.
+    m_raw_records.clear();
+    auto processes = get_all();
+    for (auto& it : m_processes) {
+        if (!processes.contains(it.key))
+            m_changes.exited.append(it.key);
+    }
+    for (auto& it : processes)
+        (m_processes.contains(it.key) ? m_changes.changed : m_changes.added).append(it.key);
+    m_processes = move(processes);
+}
+
+const ProcessStatisticsReader::Changes& ProcessStatisticsReader::update()
+{
+    m_changes.added.clear_with_capacity();
+    m_changes.changed.clear_with_capacity();
+    m_changes.exited.clear_with_capacity();
+
+    if (!update_from_binary()) {
+        m_changes.added.clear_with_capacity();
+        m_changes.changed.clear_with_capacity();
+        update_from_json();
+    }
+    return m_changes;
+}
 
 HashMap<pid_t, Core::ProcessStatistics> ProcessStatisticsReader::get_all()
 {
+    if (auto map = get_all_from_binary(); map.has_value())
+        return map.release_value();
+
     auto file = Core::File::construct("/proc/all");
     if (!file->open(Core::IODevice::ReadOnly)) {
         fprintf(stderr, "ProcessStatisticsReader: Failed to open /proc/all: %s\n", file->error_string());
@@ -92,12 +336,15 @@ HashMap<pid_t, Core::ProcessStatistics> ProcessStatisticsReader::get_all()
             thread.inode_faults = thread_object.get("inode_faults").to_u32();
             thread.zero_faults = thread_object.get("zero_faults").to_u32();
             thread.cow_faults = thread_object.get("cow_faults").to_u32();
+            thread.fpu_saves = thread_object.get("fpu_saves").to_u32();
+            thread.fpu_restores = thread_object.get("fpu_restores").to_u32();
             thread.unix_socket_read_bytes = thread_object.get("unix_socket_read_bytes").to_u32();
             thread.unix_socket_write_bytes = thread_object.get("unix_socket_write_bytes").to_u32();
             thread.ipv4_socket_read_bytes = thread_object.get("ipv4_socket_read_bytes").to_u32();
             thread.ipv4_socket_write_bytes = thread_object.get("ipv4_socket_write_bytes").to_u32();
             thread.file_read_bytes = thread_object.get("file_read_bytes").to_u32();
             thread.file_write_bytes = thread_object.get("file_write_bytes").to_u32();
+            thread.block_io_requests = thread_object.get("block_io_requests").to_u32();
             process.threads.append(move(thread));
         });
 
@@ -26,8 +26,12 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <AK/RefPtr.h>
 #include <AK/String.h>
+#include <LibCore/Forward.h>
 #include <unistd.h>
 
 namespace Core {
@@ -40,12 +44,15 @@ struct ThreadStatistics {
     unsigned inode_faults;
     unsigned zero_faults;
     unsigned cow_faults;
+    unsigned fpu_saves;
+    unsigned fpu_restores;
     unsigned unix_socket_read_bytes;
     unsigned unix_socket_write_bytes;
     unsigned ipv4_socket_read_bytes;
     unsigned ipv4_socket_write_bytes;
     unsigned file_read_bytes;
     unsigned file_write_bytes;
+    unsigned block_io_requests;
     String state;
     u32 cpu;
     u32 priority;
@@ -85,11 +92,39 @@ struct ProcessStatistics {
 
 class ProcessStatisticsReader {
 public:
+    ProcessStatisticsReader();
+    ~ProcessStatisticsReader();
+
     static HashMap<pid_t, Core::ProcessStatistics> get_all();
 
+    struct Changes {
+        Vector<pid_t> added;
+        Vector<pid_t> changed;
+        Vector<pid_t> exited;
+    };
+
+    // For pollers: keeps the previous snapshot around so that only processes whose kernel
+    // record changed since the last call get parsed again, and reports what changed.
+    // Exited processes are already gone from processes() when update() returns.
+    const Changes& update();
+    const HashMap<pid_t, Core::ProcessStatistics>& processes() const { return m_processes; }
+
 private:
+    static Optional<HashMap<pid_t, Core::ProcessStatistics>> get_all_from_binary();
+    bool read_binary_snapshot();
+    bool update_from_binary();
+    void update_from_json();
+
+    RefPtr<Core::File> m_binary_file;
+    ByteBuffer m_snapshot;
+    size_t m_snapshot_size { 0 };
+    HashMap<pid_t, ByteBuffer> m_raw_records;
+    HashMap<pid_t, Core::ProcessStatistics> m_processes;
+    Changes m_changes;
+
     static String username_from_uid(uid_t);
     static HashMap<uid_t, String> s_usernames;
+    static RefPtr<Core::File> s_binary_file;
 };
 
 }
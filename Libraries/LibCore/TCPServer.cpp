@@ -29,6 +29,7 @@
 #include <LibCore/Notifier.h>
 #include <LibCore/TCPServer.h>
 #include <LibCore/TCPSocket.h>
+#include <errno.h>
 #include <stdio.h>
 #include <sys/socket.h>
 
@@ -86,7 +87,8 @@ RefPtr<TCPSocket> TCPServer::accept()
     socklen_t in_size = sizeof(in);
     int accepted_fd = ::accept(m_fd, (sockaddr*)&in, &in_size);
     if (accepted_fd < 0) {
-        perror("accept");
+        if (errno != EAGAIN)
+            perror("accept");
         return nullptr;
     }
 
@@ -54,7 +54,7 @@ void Timer::start(int interval)
     if (m_active)
         return;
     m_interval = interval;
-    start_timer(interval);
+    start_timer(interval, TimerShouldFireWhenNotVisible::No, m_slack);
     m_active = true;
 }
 
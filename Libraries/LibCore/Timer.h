@@ -60,6 +60,11 @@ public:
         m_interval_dirty = true;
     }
 
+    // Lets the timer fire up to this many milliseconds late, so it can share a wakeup with others.
+    // Takes effect the next time the timer is started.
+    int slack() const { return m_slack; }
+    void set_slack(int slack) { m_slack = slack; }
+
     bool is_single_shot() const { return m_single_shot; }
     void set_single_shot(bool single_shot) { m_single_shot = single_shot; }
 
@@ -75,6 +80,7 @@ private:
     bool m_single_shot { false };
     bool m_interval_dirty { false };
     int m_interval { 0 };
+    int m_slack { 0 };
 };
 
 }
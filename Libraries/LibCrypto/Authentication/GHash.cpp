@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Platform.h>
+#include <AK/StdLibExtras.h>
+#include <LibCrypto/Authentication/GHash.h>
+
+namespace Crypto {
+namespace Authentication {
+
+static u64 read_u64(const u8* bytes)
+{
+    u64 value = 0;
+    for (size_t i = 0; i < 8; ++i)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static void write_u64(u8* bytes, u64 value)
+{
+    for (size_t i = 0; i < 8; ++i)
+        bytes[i] = value >> (56 - i * 8);
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+typedef long long v2di __attribute__((vector_size(16)));
+typedef unsigned long long v2du __attribute__((vector_size(16)));
+typedef unsigned v4su __attribute__((vector_size(16)));
+
+#    define PCLMUL __attribute__((target("pclmul,sse2")))
+
+// Multiplies two byte-reflected field elements, as in figure 5 of Intel's
+// "Carry-Less Multiplication Instruction and its Usage for Computing the GCM Mode".
+PCLMUL static v2du multiply_pclmul(v2du a, v2du b)
+{
+    auto low = (v4su)__builtin_ia32_pclmulqdq128((v2di)a, (v2di)b, 0x00);
+    auto middle = (v2du)__builtin_ia32_pclmulqdq128((v2di)a, (v2di)b, 0x10) ^ (v2du)__builtin_ia32_pclmulqdq128((v2di)a, (v2di)b, 0x01);
+    auto high = (v4su)__builtin_ia32_pclmulqdq128((v2di)a, (v2di)b, 0x11);
+    low ^= (v4su)(v2du) { 0, middle[0] };
+    high ^= (v4su)(v2du) { middle[1], 0 };
+
+    // Shift the 256-bit product left by one bit, since the operands were reflected.
+    v4su low_carry = low >> 31;
+    v4su high_carry = high >> 31;
+    low = (low << 1) | (v4su) { 0, low_carry[0], low_carry[1], low_carry[2] };
+    high = (high << 1) | (v4su) { low_carry[3], high_carry[0], high_carry[1], high_carry[2] };
+
+    // Reduce modulo x^128 + x^7 + x^2 + x + 1.
+    v4su t = (low << 31) ^ (low << 30) ^ (low << 25);
+    low ^= (v4su) { 0, 0, 0, t[0] };
+    v4su u = (low >> 1) ^ (low >> 2) ^ (low >> 7) ^ (v4su) { t[1], t[2], t[3], 0 };
+    return (v2du)(high ^ low ^ u);
+}
+
+static bool cpu_has_pclmul()
+{
+    u32 eax, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(1), "c"(0));
+    return ecx & (1 << 1);
+}
+#endif
+
+bool GHash::is_hardware_accelerated()
+{
+#if ARCH(I386) || ARCH(X86_64)
+    static int s_has_pclmul = -1;
+    if (s_has_pclmul < 0)
+        s_has_pclmul = cpu_has_pclmul();
+    return s_has_pclmul;
+#else
+    return false;
+#endif
+}
+
+GHash::GHash(ReadonlyBytes key)
+{
+    ASSERT(key.size() >= 16);
+    m_key_high = read_u64(key.data());
+    m_key_low = read_u64(key.data() + 8);
+
+    // Shoup's method: m_table[i] holds H multiplied by the 4-bit polynomial i, where,
+    // in GCM's reflected bit order, 8 is the unit and 1 is x^3.
+    m_table_high[0] = 0;
+    m_table_low[0] = 0;
+    m_table_high[8] = m_key_high;
+    m_table_low[8] = m_key_low;
+    u64 high = m_key_high;
+    u64 low = m_key_low;
+    for (size_t i = 4; i > 0; i >>= 1) {
+        u64 reduction = (low & 1) ? 0xe100000000000000ull : 0;
+        low = (high << 63) | (low >> 1);
+        high = (high >> 1) ^ reduction;
+        m_table_high[i] = high;
+        m_table_low[i] = low;
+    }
+    for (size_t i = 2; i <= 8; i *= 2) {
+        for (size_t j = 1; j < i; ++j) {
+            m_table_high[i + j] = m_table_high[i] ^ m_table_high[j];
+            m_table_low[i + j] = m_table_low[i] ^ m_table_low[j];
+        }
+    }
+}
+
+void GHash::multiply()
+{
+#if ARCH(I386) || ARCH(X86_64)
+    if (is_hardware_accelerated()) {
+        auto result = multiply_pclmul((v2du) { m_state_low, m_state_high }, (v2du) { m_key_low, m_key_high });
+        m_state_low = result[0];
+        m_state_high = result[1];
+        return;
+    }
+#endif
+
+    // The reductions of the four bits that get shifted out of the low end.
+    static constexpr u64 remainders[16] = {
+        0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+        0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+    };
+
+    u8 x[16];
+    write_u64(x, m_state_high);
+    write_u64(x + 8, m_state_low);
+
+    // Horner's rule over the nibbles, starting with the highest power of x.
+    u64 high = 0;
+    u64 low = 0;
+    auto accumulate = [&](u8 nibble) {
+        auto remainder = low & 0xf;
+        low = (high << 60) | (low >> 4);
+        high = (high >> 4) ^ (remainders[remainder] << 48);
+        high ^= m_table_high[nibble];
+        low ^= m_table_low[nibble];
+    };
+    for (int i = 15; i >= 0; --i) {
+        accumulate(x[i] & 0xf);
+        accumulate(x[i] >> 4);
+    }
+    m_state_high = high;
+    m_state_low = low;
+}
+
+void GHash::update(ReadonlyBytes data)
+{
+    for (size_t offset = 0; offset < data.size(); offset += 16) {
+        u8 block[16] {};
+        __builtin_memcpy(block, data.offset(offset), min<size_t>(16, data.size() - offset));
+        m_state_high ^= read_u64(block);
+        m_state_low ^= read_u64(block + 8);
+        multiply();
+    }
+}
+
+GHash::TagType GHash::process(ReadonlyBytes aad, ReadonlyBytes cipher)
+{
+    m_state_high = 0;
+    m_state_low = 0;
+
+    // Both inputs are padded with zeroes to a whole block, followed by a block of their lengths in bits.
+    update(aad);
+    update(cipher);
+    m_state_high ^= (u64)aad.size() * 8;
+    m_state_low ^= (u64)cipher.size() * 8;
+    multiply();
+
+    TagType tag;
+    write_u64(tag.data, m_state_high);
+    write_u64(tag.data + 8, m_state_low);
+    return tag;
+}
+
+}
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Span.h>
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Authentication {
+
+// The universal hash of GCM (NIST SP 800-38D), keyed with H = E(K, 0^128).
+class GHash {
+public:
+    struct TagType {
+        u8 data[16];
+    };
+
+    static constexpr size_t digest_size() { return 16; }
+
+    explicit GHash(ReadonlyBytes key);
+
+    TagType process(ReadonlyBytes aad, ReadonlyBytes cipher);
+
+    // Whether the multiplications are done with PCLMULQDQ instead of the 4-bit tables.
+    static bool is_hardware_accelerated();
+
+private:
+    void update(ReadonlyBytes);
+    void multiply();
+
+    u64 m_key_high { 0 };
+    u64 m_key_low { 0 };
+    u64 m_table_high[16];
+    u64 m_table_low[16];
+
+    u64 m_state_high { 0 };
+    u64 m_state_low { 0 };
+};
+
+}
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <AK/StdLibExtras.h>
+#include <LibCrypto/Authentication/Poly1305.h>
+
+namespace Crypto {
+namespace Authentication {
+
+static u32 read_u32_le(const u8* bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((u32)bytes[3] << 24);
+}
+
+static void write_u32_le(u8* bytes, u32 value)
+{
+    bytes[0] = value;
+    bytes[1] = value >> 8;
+    bytes[2] = value >> 16;
+    bytes[3] = value >> 24;
+}
+
+// The accumulator and r are kept in five 26-bit limbs, so that the products fit into 64 bits.
+static constexpr u32 limb_mask = 0x3ffffff;
+
+Poly1305::Poly1305(ReadonlyBytes key)
+{
+    ASSERT(key.size() >= key_size());
+    auto* bytes = key.data();
+
+    // r is clamped as described in section 2.5.1.
+    m_r[0] = read_u32_le(bytes) & 0x3ffffff;
+    m_r[1] = (read_u32_le(bytes + 3) >> 2) & 0x3ffff03;
+    m_r[2] = (read_u32_le(bytes + 6) >> 4) & 0x3ffc0ff;
+    m_r[3] = (read_u32_le(bytes + 9) >> 6) & 0x3f03fff;
+    m_r[4] = (read_u32_le(bytes + 12) >> 8) & 0x00fffff;
+
+    for (size_t i = 0; i < 4; ++i)
+        m_pad[i] = read_u32_le(bytes + 16 + i * 4);
+}
+
+void Poly1305::process_block(const u8* block, u32 high_bit)
+{
+    u32 r0 = m_r[0], r1 = m_r[1], r2 = m_r[2], r3 = m_r[3], r4 = m_r[4];
+    u32 s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    u32 h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4];
+
+    h0 += read_u32_le(block) & limb_mask;
+    h1 += (read_u32_le(block + 3) >> 2) & limb_mask;
+    h2 += (read_u32_le(block + 6) >> 4) & limb_mask;
+    h3 += (read_u32_le(block + 9) >> 6) & limb_mask;
+    h4 += (read_u32_le(block + 12) >> 8) | high_bit;
+
+    // h *= r, where the limbs that overflow 2^130 wrap around multiplied by 5.
+    u64 d0 = (u64)h0 * r0 + (u64)h1 * s4 + (u64)h2 * s3 + (u64)h3 * s2 + (u64)h4 * s1;
+    u64 d1 = (u64)h0 * r1 + (u64)h1 * r0 + (u64)h2 * s4 + (u64)h3 * s3 + (u64)h4 * s2;
+    u64 d2 = (u64)h0 * r2 + (u64)h1 * r1 + (u64)h2 * r0 + (u64)h3 * s4 + (u64)h4 * s3;
+    u64 d3 = (u64)h0 * r3 + (u64)h1 * r2 + (u64)h2 * r1 + (u64)h3 * r0 + (u64)h4 * s4;
+    u64 d4 = (u64)h0 * r4 + (u64)h1 * r3 + (u64)h2 * r2 + (u64)h3 * r1 + (u64)h4 * r0;
+
+    u32 carry = d0 >> 26;
+    h0 = d0 & limb_mask;
+    d1 += carry;
+    carry = d1 >> 26;
+    h1 = d1 & limb_mask;
+    d2 += carry;
+    carry = d2 >> 26;
+    h2 = d2 & limb_mask;
+    d3 += carry;
+    carry = d3 >> 26;
+    h3 = d3 & limb_mask;
+    d4 += carry;
+    carry = d4 >> 26;
+    h4 = d4 & limb_mask;
+    h0 += carry * 5;
+    carry = h0 >> 26;
+    h0 &= limb_mask;
+    h1 += carry;
+
+    m_h[0] = h0;
+    m_h[1] = h1;
+    m_h[2] = h2;
+    m_h[3] = h3;
+    m_h[4] = h4;
+}
+
+void Poly1305::update(ReadonlyBytes data)
+{
+    size_t offset = 0;
+    if (m_buffer_size) {
+        auto length = min(data.size(), sizeof(m_buffer) - m_buffer_size);
+        __builtin_memcpy(m_buffer + m_buffer_size, data.data(), length);
+        m_buffer_size += length;
+        offset += length;
+        if (m_buffer_size < sizeof(m_buffer))
+            return;
+        process_block(m_buffer, 1 << 24);
+        m_buffer_size = 0;
+    }
+    for (; offset + 16 <= data.size(); offset += 16)
+        process_block(data.offset(offset), 1 << 24);
+    m_buffer_size = data.size() - offset;
+    __builtin_memcpy(m_buffer, data.data() + offset, m_buffer_size);
+}
+
+Poly1305::TagType Poly1305::digest()
+{
+    // A final partial block gets its 2^(8 * length) bit as an explicit 1 byte instead.
+    if (m_buffer_size) {
+        m_buffer[m_buffer_size] = 1;
+        __builtin_memset(m_buffer + m_buffer_size + 1, 0, sizeof(m_buffer) - m_buffer_size - 1);
+        process_block(m_buffer, 0);
+        m_buffer_size = 0;
+    }
+
+    u32 h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4];
+
+    // Fully carry h.
+    u32 carry = h1 >> 26;
+    h1 &= limb_mask;
+    h2 += carry;
+    carry = h2 >> 26;
+    h2 &= limb_mask;
+    h3 += carry;
+    carry = h3 >> 26;
+    h3 &= limb_mask;
+    h4 += carry;
+    carry = h4 >> 26;
+    h4 &= limb_mask;
+    h0 += carry * 5;
+    carry = h0 >> 26;
+    h0 &= limb_mask;
+    h1 += carry;
+
+    // Compute g = h - (2^130 - 5), and pick it over h without branching if it didn't underflow.
+    u32 g0 = h0 + 5;
+    carry = g0 >> 26;
+    g0 &= limb_mask;
+    u32 g1 = h1 + carry;
+    carry = g1 >> 26;
+    g1 &= limb_mask;
+    u32 g2 = h2 + carry;
+    carry = g2 >> 26;
+    g2 &= limb_mask;
+    u32 g3 = h3 + carry;
+    carry = g3 >> 26;
+    g3 &= limb_mask;
+    u32 g4 = h4 + carry - (1 << 26);
+
+    u32 mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    // tag = (h + s) % 2^128
+    u32 words[4] = {
+        h0 | (h1 << 26),
+        (h1 >> 6) | (h2 << 20),
+        (h2 >> 12) | (h3 << 14),
+        (h3 >> 18) | (h4 << 8),
+    };
+    TagType tag;
+    u64 sum = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        sum = (u64)words[i] + m_pad[i] + (sum >> 32);
+        write_u32_le(tag.data + i * 4, (u32)sum);
+    }
+    return tag;
+}
+
+}
+}
@@ -595,32 +595,152 @@ FLATTEN void UnsignedBigInteger::shift_left_without_allocation(
  * So to multiple x*y, we go over each '1' bit in x (say the i'th bit), 
  * and add y<<i to the result.
  */
+// Below this many words, splitting the numbers up costs more than it saves.
+static constexpr size_t karatsuba_threshold = 32;
+
+static void multiply_words(u32* output, const u32* left, size_t left_length, const u32* right, size_t right_length)
+{
+    __builtin_memset(output, 0, (left_length + right_length) * sizeof(u32));
+    for (size_t i = 0; i < left_length; ++i) {
+        u64 word = left[i];
+        u64 carry = 0;
+        for (size_t j = 0; j < right_length; ++j) {
+            // (2^32 - 1)^2 + 2 * (2^32 - 1) still fits into 64 bits.
+            carry += word * right[j] + output[i + j];
+            output[i + j] = (u32)carry;
+            carry >>= 32;
+        }
+        output[i + right_length] = (u32)carry;
+    }
+}
+
+// output = left + right, where right is no longer than left. Returns the carry out of the top word.
+static u32 add_words(u32* output, const u32* left, size_t left_length, const u32* right, size_t right_length)
+{
+    u64 carry = 0;
+    for (size_t i = 0; i < left_length; ++i) {
+        carry += (u64)left[i] + (i < right_length ? right[i] : 0);
+        output[i] = (u32)carry;
+        carry >>= 32;
+    }
+    return carry;
+}
+
+static void add_words_in_place(u32* output, size_t output_length, const u32* input, size_t input_length)
+{
+    u64 carry = 0;
+    size_t i = 0;
+    for (; i < input_length; ++i) {
+        carry += (u64)output[i] + input[i];
+        output[i] = (u32)carry;
+        carry >>= 32;
+    }
+    for (; carry && i < output_length; ++i) {
+        carry += output[i];
+        output[i] = (u32)carry;
+        carry >>= 32;
+    }
+    ASSERT(!carry);
+}
+
+static void subtract_words_in_place(u32* output, size_t output_length, const u32* input, size_t input_length)
+{
+    u64 borrow = 0;
+    size_t i = 0;
+    for (; i < input_length; ++i) {
+        u64 difference = (u64)output[i] - input[i] - borrow;
+        output[i] = (u32)difference;
+        borrow = difference >> 63;
+    }
+    for (; borrow && i < output_length; ++i) {
+        u64 difference = (u64)output[i] - borrow;
+        output[i] = (u32)difference;
+        borrow = difference >> 63;
+    }
+    ASSERT(!borrow);
+}
+
+static size_t karatsuba_scratch_size(size_t length)
+{
+    if (length < karatsuba_threshold)
+        return 0;
+    size_t high = length - length / 2;
+    return 4 * (high + 1) + karatsuba_scratch_size(high + 1);
+}
+
+// output (2 * length words) = left * right, with both operands split into halves x = x1 * B + x0, so that
+// x * y = x1y1 * B^2 + ((x0 + x1)(y0 + y1) - x0y0 - x1y1) * B + x0y0 takes three multiplications instead of four.
+static void karatsuba_multiply(u32* output, const u32* left, const u32* right, size_t length, u32* scratch)
+{
+    if (length < karatsuba_threshold) {
+        multiply_words(output, left, length, right, length);
+        return;
+    }
+
+    size_t low = length / 2;
+    size_t high = length - low;
+    karatsuba_multiply(output, left, right, low, scratch);
+    karatsuba_multiply(output + 2 * low, left + low, right + low, high, scratch);
+
+    u32* left_sum = scratch;
+    u32* right_sum = left_sum + high + 1;
+    u32* middle = right_sum + high + 1;
+    size_t middle_length = 2 * (high + 1);
+    left_sum[high] = add_words(left_sum, left + low, high, left, low);
+    right_sum[high] = add_words(right_sum, right + low, high, right, low);
+    karatsuba_multiply(middle, left_sum, right_sum, high + 1, middle + middle_length);
+
+    subtract_words_in_place(middle, middle_length, output, 2 * low);
+    subtract_words_in_place(middle, middle_length, output + 2 * low, 2 * high);
+    // The top words of the middle term are zero, and there's no room for them in the output anyway.
+    add_words_in_place(output + low, 2 * length - low, middle, min(middle_length, 2 * length - low));
+}
+
+/**
+ * Complexity: O(N^2) where N is the number of words in the larger number, or
+ * O(N^1.58) once both numbers are at least `karatsuba_threshold` words long.
+ * temp_shift_result is used as scratch space, the other temporaries are unused.
+ */
 FLATTEN void UnsignedBigInteger::multiply_without_allocation(
     const UnsignedBigInteger& left,
     const UnsignedBigInteger& right,
     UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
-    UnsignedBigInteger& temp_shift,
-    UnsignedBigInteger& temp_plus,
+    UnsignedBigInteger&,
+    UnsignedBigInteger&,
+    UnsignedBigInteger&,
     UnsignedBigInteger& output)
 {
     output.set_to_0();
 
-    // iterate all bits
-    for (size_t word_index = 0; word_index < left.length(); ++word_index) {
-        for (size_t bit_index = 0; bit_index < UnsignedBigInteger::BITS_IN_WORD; ++bit_index) {
-            // If the bit is off - skip over it
-            if (!(left.m_words[word_index] & (1 << bit_index)))
-                continue;
+    size_t left_length = left.trimmed_length();
+    size_t right_length = right.trimmed_length();
+    if (!left_length || !right_length)
+        return;
 
-            const size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
+    output.m_words.resize_and_keep_capacity(left_length + right_length);
 
-            // output += (right << shift_amount);
-            shift_left_without_allocation(right, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-            add_without_allocation(output, temp_shift, temp_plus);
-            output.set_to(temp_plus);
-        }
+    size_t shorter_length = min(left_length, right_length);
+    size_t longer_length = max(left_length, right_length);
+    if (shorter_length < karatsuba_threshold || longer_length > 2 * shorter_length) {
+        multiply_words(output.m_words.data(), left.m_words.data(), left_length, right.m_words.data(), right_length);
+        output.m_words.resize_and_keep_capacity(output.trimmed_length());
+        return;
     }
+
+    // Karatsuba wants both halves to be the same size, so the shorter number gets padded with zeros.
+    auto& scratch = temp_shift_result.m_words;
+    scratch.resize_and_keep_capacity(2 * longer_length + karatsuba_scratch_size(longer_length));
+    temp_shift_result.m_cached_trimmed_length = {};
+    u32* padded_left = scratch.data();
+    u32* padded_right = padded_left + longer_length;
+    __builtin_memset(padded_left, 0, 2 * longer_length * sizeof(u32));
+    __builtin_memcpy(padded_left, left.m_words.data(), left_length * sizeof(u32));
+    __builtin_memcpy(padded_right, right.m_words.data(), right_length * sizeof(u32));
+
+    // The padded product has room for 2 * longer_length words, but the ones past the real product will be zero.
+    output.m_words.resize_and_keep_capacity(2 * longer_length);
+    karatsuba_multiply(output.m_words.data(), padded_left, padded_right, longer_length, padded_right + longer_length);
+    output.m_words.resize_and_keep_capacity(output.trimmed_length());
 }
 
 /**
@@ -32,10 +32,24 @@ namespace Crypto::Checksum {
 
 void CRC32::update(ReadonlyBytes data)
 {
-    for (size_t i = 0; i < data.size(); i++) {
-        m_state = table[(m_state ^ data.at(i)) & 0xFF] ^ (m_state >> 8);
+    auto* bytes = data.data();
+    size_t size = data.size();
+    u32 state = m_state;
+
+    while (size >= 8) {
+        u32 low = (bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (u32)bytes[3] << 24) ^ state;
+        u32 high = bytes[4] | bytes[5] << 8 | bytes[6] << 16 | (u32)bytes[7] << 24;
+        state = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+            ^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+        bytes += 8;
+        size -= 8;
     }
-};
+
+    for (size_t i = 0; i < size; i++)
+        state = table[0][(state ^ bytes[i]) & 0xFF] ^ (state >> 8);
+
+    m_state = state;
+}
 
 u32 CRC32::digest()
 {
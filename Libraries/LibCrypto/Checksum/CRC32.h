@@ -33,8 +33,11 @@
 
 namespace Crypto::Checksum {
 
+// Holds the tables for slicing-by-8: data[0] is the classic byte-at-a-time table, and data[n]
+// gives the CRC of a byte followed by n zero bytes, so that eight input bytes can be folded in
+// with eight independent lookups.
 struct Table {
-    u32 data[256];
+    u32 data[8][256];
 
     constexpr Table()
         : data()
@@ -50,12 +53,18 @@ struct Table {
                 }
             }
 
-            data[i] = value;
+            data[0][i] = value;
+        }
+
+        for (auto slice = 1; slice < 8; slice++) {
+            for (auto i = 0; i < 256; i++)
+                data[slice][i] = data[0][data[slice - 1][i] & 0xFF] ^ (data[slice - 1][i] >> 8);
         }
     }
 
-    constexpr u32 operator[](int index) const {
-        return data[index];
+    constexpr const u32* operator[](int slice) const
+    {
+        return data[slice];
     }
 };
 
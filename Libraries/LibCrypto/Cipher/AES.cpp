@@ -24,12 +24,66 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Platform.h>
 #include <AK/StringBuilder.h>
 #include <LibCrypto/Cipher/AES.h>
 
+// The kernel is built without SSE, and doesn't save the FPU state for its own use either.
+#if (ARCH(I386) || ARCH(X86_64)) && !defined(KERNEL)
+#    define HAVE_AESNI
+#endif
+
 namespace Crypto {
 namespace Cipher {
 
+#ifdef HAVE_AESNI
+typedef long long v2di __attribute__((vector_size(16)));
+typedef long long v2di_u __attribute__((vector_size(16), aligned(1), may_alias));
+
+#    define AESNI __attribute__((target("aes,sse2")))
+
+AESNI static inline v2di load_unaligned(const u8* ptr) { return *(const v2di_u*)ptr; }
+
+AESNI static void encrypt_block_aesni(const u8* round_keys, size_t rounds, const u8* in, u8* out)
+{
+    v2di state = load_unaligned(in) ^ load_unaligned(round_keys);
+    for (size_t i = 1; i < rounds; ++i)
+        state = __builtin_ia32_aesenc128(state, load_unaligned(round_keys + i * 16));
+    *(v2di_u*)out = __builtin_ia32_aesenclast128(state, load_unaligned(round_keys + rounds * 16));
+}
+
+// The decryption key schedule already has the inverse mix-column applied to the middle
+// rounds, which is exactly what AESDEC expects (the "equivalent inverse cipher").
+AESNI static void decrypt_block_aesni(const u8* round_keys, size_t rounds, const u8* in, u8* out)
+{
+    v2di state = load_unaligned(in) ^ load_unaligned(round_keys);
+    for (size_t i = 1; i < rounds; ++i)
+        state = __builtin_ia32_aesdec128(state, load_unaligned(round_keys + i * 16));
+    *(v2di_u*)out = __builtin_ia32_aesdeclast128(state, load_unaligned(round_keys + rounds * 16));
+}
+
+static bool cpu_has_aesni()
+{
+    u32 eax, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(1), "c"(0));
+    return ecx & (1 << 25);
+}
+#endif
+
+bool AESCipher::is_hardware_accelerated()
+{
+#ifdef HAVE_AESNI
+    static int s_has_aesni = -1;
+    if (s_has_aesni < 0)
+        s_has_aesni = cpu_has_aesni();
+    return s_has_aesni;
+#else
+    return false;
+#endif
+}
+
 template<typename T>
 constexpr u32 get_key(T pt)
 {
@@ -214,8 +268,28 @@ void AESCipherKey::expand_decrypt_key(const ByteBuffer& user_key, size_t bits)
     }
 }
 
+void AESCipherKey::store_round_key_bytes()
+{
+    for (size_t i = 0; i < (rounds() + 1) * 4; ++i) {
+        auto word = m_rd_keys[i];
+        m_rd_key_bytes[i * 4] = word >> 24;
+        m_rd_key_bytes[i * 4 + 1] = word >> 16;
+        m_rd_key_bytes[i * 4 + 2] = word >> 8;
+        m_rd_key_bytes[i * 4 + 3] = word;
+    }
+}
+
 void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
+#ifdef HAVE_AESNI
+    if (is_hardware_accelerated()) {
+        u8 result[16];
+        encrypt_block_aesni(key().round_key_bytes(), key().rounds(), in.data().data(), result);
+        out.overwrite({ result, sizeof(result) });
+        return;
+    }
+#endif
+
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
     size_t r { 0 };
 
@@ -308,6 +382,14 @@ void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 
 void AESCipher::decrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
+#ifdef HAVE_AESNI
+    if (is_hardware_accelerated()) {
+        u8 result[16];
+        decrypt_block_aesni(key().round_key_bytes(), key().rounds(), in.data().data(), result);
+        out.overwrite({ result, sizeof(result) });
+        return;
+    }
+#endif
 
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
     size_t r { 0 };
@@ -31,6 +31,7 @@
 #include <LibCrypto/Cipher/Cipher.h>
 #include <LibCrypto/Cipher/Mode/CBC.h>
 #include <LibCrypto/Cipher/Mode/CTR.h>
+#include <LibCrypto/Cipher/Mode/GCM.h>
 
 namespace Crypto {
 namespace Cipher {
@@ -81,6 +82,8 @@ struct AESCipherKey : public CipherKey {
     {
         return (const u32*)m_rd_keys;
     }
+    // The same round keys in memory order, which is what the AES-NI instructions expect.
+    const u8* round_key_bytes() const { return m_rd_key_bytes; }
 
     AESCipherKey(const ByteBuffer& user_key, size_t key_bits, Intent intent)
         : m_bits(key_bits)
@@ -89,6 +92,7 @@ struct AESCipherKey : public CipherKey {
             expand_encrypt_key(user_key, key_bits);
         else
             expand_decrypt_key(user_key, key_bits);
+        store_round_key_bytes();
     }
 
     virtual ~AESCipherKey() override { }
@@ -103,8 +107,11 @@ protected:
     }
 
 private:
+    void store_round_key_bytes();
+
     static constexpr size_t MAX_ROUND_COUNT = 14;
     u32 m_rd_keys[(MAX_ROUND_COUNT + 1) * 4] { 0 };
+    u8 m_rd_key_bytes[(MAX_ROUND_COUNT + 1) * 16] { 0 };
     size_t m_rounds;
     size_t m_bits;
 };
@@ -113,6 +120,7 @@ class AESCipher final : public Cipher<AESCipherKey, AESCipherBlock> {
 public:
     using CBCMode = CBC<AESCipher>;
     using CTRMode = CTR<AESCipher>;
+    using GCMMode = GCM<AESCipher>;
 
     constexpr static size_t BlockSizeInBits = BlockType::BlockSizeInBits;
 
@@ -130,6 +138,9 @@ public:
 
     virtual String class_name() const override { return "AES"; }
 
+    // Whether the blocks are en/decrypted with the AES-NI instructions instead of the lookup tables below.
+    static bool is_hardware_accelerated();
+
 protected:
     AESCipherKey m_key;
 };
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <AK/StdLibExtras.h>
+#include <LibCrypto/Authentication/Poly1305.h>
+#include <LibCrypto/Cipher/ChaCha20.h>
+
+namespace Crypto {
+namespace Cipher {
+
+static u32 read_u32_le(const u8* bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((u32)bytes[3] << 24);
+}
+
+static void write_u32_le(u8* bytes, u32 value)
+{
+    bytes[0] = value;
+    bytes[1] = value >> 8;
+    bytes[2] = value >> 16;
+    bytes[3] = value >> 24;
+}
+
+static void write_u64_le(u8* bytes, u64 value)
+{
+    write_u32_le(bytes, value);
+    write_u32_le(bytes + 4, value >> 32);
+}
+
+static constexpr u32 rotate_left(u32 value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static constexpr void quarter_round(u32* x, int a, int b, int c, int d)
+{
+    x[a] += x[b];
+    x[d] = rotate_left(x[d] ^ x[a], 16);
+    x[c] += x[d];
+    x[b] = rotate_left(x[b] ^ x[c], 12);
+    x[a] += x[b];
+    x[d] = rotate_left(x[d] ^ x[a], 8);
+    x[c] += x[d];
+    x[b] = rotate_left(x[b] ^ x[c], 7);
+}
+
+ChaCha20::ChaCha20(ReadonlyBytes key, ReadonlyBytes nonce, u32 initial_counter)
+{
+    ASSERT(key.size() == key_size());
+    ASSERT(nonce.size() == nonce_size());
+
+    // "expand 32-byte k"
+    m_state[0] = 0x61707865;
+    m_state[1] = 0x3320646e;
+    m_state[2] = 0x79622d32;
+    m_state[3] = 0x6b206574;
+    for (size_t i = 0; i < 8; ++i)
+        m_state[4 + i] = read_u32_le(key.offset(i * 4));
+    m_state[12] = initial_counter;
+    for (size_t i = 0; i < 3; ++i)
+        m_state[13 + i] = read_u32_le(nonce.offset(i * 4));
+}
+
+void ChaCha20::generate_block()
+{
+    u32 x[16];
+    __builtin_memcpy(x, m_state, sizeof(x));
+    for (size_t i = 0; i < 10; ++i) {
+        quarter_round(x, 0, 4, 8, 12);
+        quarter_round(x, 1, 5, 9, 13);
+        quarter_round(x, 2, 6, 10, 14);
+        quarter_round(x, 3, 7, 11, 15);
+        quarter_round(x, 0, 5, 10, 15);
+        quarter_round(x, 1, 6, 11, 12);
+        quarter_round(x, 2, 7, 8, 13);
+        quarter_round(x, 3, 4, 9, 14);
+    }
+    for (size_t i = 0; i < 16; ++i)
+        write_u32_le(m_key_stream + i * 4, x[i] + m_state[i]);
+
+    ++m_state[12];
+    m_key_stream_offset = 0;
+}
+
+void ChaCha20::process(ReadonlyBytes in, Bytes out)
+{
+    ASSERT(in.size() <= out.size());
+    for (size_t offset = 0; offset < in.size();) {
+        if (m_key_stream_offset == sizeof(m_key_stream))
+            generate_block();
+        auto length = min(in.size() - offset, sizeof(m_key_stream) - m_key_stream_offset);
+        for (size_t i = 0; i < length; ++i)
+            out[offset + i] = in[offset + i] ^ m_key_stream[m_key_stream_offset + i];
+        offset += length;
+        m_key_stream_offset += length;
+    }
+}
+
+ChaCha20Poly1305::ChaCha20Poly1305(ReadonlyBytes key)
+{
+    ASSERT(key.size() == sizeof(m_key));
+    __builtin_memcpy(m_key, key.data(), sizeof(m_key));
+}
+
+void ChaCha20Poly1305::compute_tag(ReadonlyBytes cipher_text, ReadonlyBytes nonce, ReadonlyBytes aad, u8* tag)
+{
+    // The one-time Poly1305 key is the start of the key stream block with counter 0.
+    u8 one_time_key[Authentication::Poly1305::key_size()] {};
+    ChaCha20 key_generator({ m_key, sizeof(m_key) }, nonce, 0);
+    key_generator.process({ one_time_key, sizeof(one_time_key) }, { one_time_key, sizeof(one_time_key) });
+
+    static constexpr u8 zeroes[16] {};
+    Authentication::Poly1305 poly1305({ one_time_key, sizeof(one_time_key) });
+    poly1305.update(aad);
+    poly1305.update({ zeroes, (16 - aad.size() % 16) % 16 });
+    poly1305.update(cipher_text);
+    poly1305.update({ zeroes, (16 - cipher_text.size() % 16) % 16 });
+    u8 lengths[16];
+    write_u64_le(lengths, aad.size());
+    write_u64_le(lengths + 8, cipher_text.size());
+    poly1305.update({ lengths, sizeof(lengths) });
+
+    auto digest = poly1305.digest();
+    __builtin_memcpy(tag, digest.data, TagSize);
+}
+
+void ChaCha20Poly1305::encrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes nonce, ReadonlyBytes aad, Bytes tag)
+{
+    ASSERT(in.size() <= out.size());
+    ASSERT(tag.size() >= TagSize);
+
+    ChaCha20 cipher({ m_key, sizeof(m_key) }, nonce, 1);
+    cipher.process(in, out);
+    compute_tag(out.slice(0, in.size()), nonce, aad, tag.data());
+}
+
+bool ChaCha20Poly1305::decrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes nonce, ReadonlyBytes aad, ReadonlyBytes tag)
+{
+    ASSERT(in.size() <= out.size());
+    if (tag.size() != TagSize)
+        return false;
+
+    u8 expected_tag[TagSize];
+    compute_tag(in, nonce, aad, expected_tag);
+    u8 difference = 0;
+    for (size_t i = 0; i < TagSize; ++i)
+        difference |= expected_tag[i] ^ tag[i];
+    if (difference)
+        return false;
+
+    ChaCha20 cipher({ m_key, sizeof(m_key) }, nonce, 1);
+    cipher.process(in, out);
+    return true;
+}
+
+}
+}
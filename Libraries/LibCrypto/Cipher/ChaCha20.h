@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Span.h>
+#include <AK/String.h>
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Cipher {
+
+// The stream cipher from RFC 8439, with a 96-bit nonce and a 32-bit block counter.
+class ChaCha20 {
+public:
+    static constexpr size_t key_size() { return 32; }
+    static constexpr size_t nonce_size() { return 12; }
+    static constexpr size_t block_size() { return 64; }
+
+    ChaCha20(ReadonlyBytes key, ReadonlyBytes nonce, u32 initial_counter = 0);
+
+    // XORs `in' with the next bytes of the key stream into `out'. Encryption and decryption are the same thing.
+    void process(ReadonlyBytes in, Bytes out);
+
+    String class_name() const { return "ChaCha20"; }
+
+private:
+    void generate_block();
+
+    u32 m_state[16];
+    u8 m_key_stream[64];
+    size_t m_key_stream_offset { 64 };
+};
+
+// The AEAD construction from RFC 8439, section 2.8.
+class ChaCha20Poly1305 {
+public:
+    static constexpr size_t TagSize = 16;
+
+    explicit ChaCha20Poly1305(ReadonlyBytes key);
+
+    void encrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes nonce, ReadonlyBytes aad, Bytes tag);
+
+    // Returns false, leaving `out' untouched, if `in' or `aad' didn't match the tag.
+    bool decrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes nonce, ReadonlyBytes aad, ReadonlyBytes tag);
+
+    String class_name() const { return "ChaCha20_Poly1305"; }
+
+private:
+    void compute_tag(ReadonlyBytes cipher_text, ReadonlyBytes nonce, ReadonlyBytes aad, u8* tag);
+
+    u8 m_key[32];
+};
+
+}
+}
@@ -133,6 +133,9 @@ public:
     }
 
 private:
+    // Reads the block in place, rather than making a copy of it with get().
+    const u8* block_data() const { return m_cipher_block.data().data(); }
+
     u8 m_ivec_storage[IVSizeInBits / 8];
     typename T::BlockType m_cipher_block {};
 
@@ -186,7 +189,7 @@ private:
             auto write_size = min(block_size, length);
 
             ASSERT(offset + write_size <= out.size());
-            __builtin_memcpy(out.offset(offset), m_cipher_block.get().data(), write_size);
+            __builtin_memcpy(out.offset(offset), block_data(), write_size);
 
             increment_inplace(iv);
             length -= write_size;
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/OwnPtr.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+#include <AK/StringView.h>
+#include <LibCrypto/Authentication/GHash.h>
+#include <LibCrypto/Cipher/Mode/Mode.h>
+
+namespace Crypto {
+namespace Cipher {
+
+// Galois/Counter Mode (NIST SP 800-38D): CTR encryption authenticated with GHASH.
+template<typename T>
+class GCM : public Mode<T> {
+public:
+    constexpr static size_t IVSizeInBits = 96;
+    constexpr static size_t TagSize = Authentication::GHash::digest_size();
+
+    virtual ~GCM() { }
+
+    // GCM only ever runs the block cipher forwards, so the intent is ignored.
+    template<typename KeyType, typename... Args>
+    explicit GCM<T>(const KeyType& user_key, size_t key_bits, Intent = Intent::Encryption, Args... args)
+        : Mode<T>(user_key, key_bits, Intent::Encryption, args...)
+    {
+        typename T::BlockType hash_key;
+        this->cipher().encrypt_block(hash_key, hash_key);
+        m_ghash = make<Authentication::GHash>(static_cast<const typename T::BlockType&>(hash_key).data().bytes());
+    }
+
+    virtual String class_name() const override
+    {
+        StringBuilder builder;
+        builder.append(this->cipher().class_name());
+        builder.append("_GCM");
+        return builder.build();
+    }
+
+    virtual size_t IV_length() const override { return IVSizeInBits / 8; }
+
+    // These drop the authentication tag; use the overloads below when it matters.
+    virtual void encrypt(const ReadonlyBytes& in, Bytes& out, const Bytes& ivec = {}, Bytes* ivec_out = nullptr) override
+    {
+        ASSERT(!ivec_out);
+        u8 tag[TagSize];
+        encrypt(in, out, ivec, {}, { tag, TagSize });
+    }
+
+    virtual void decrypt(const ReadonlyBytes& in, Bytes& out, const Bytes& ivec = {}) override
+    {
+        u8 counter[16];
+        initial_counter(ivec, counter);
+        apply_key_stream(in, out, counter);
+    }
+
+    void encrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes iv, ReadonlyBytes aad, Bytes tag)
+    {
+        ASSERT(in.size() <= out.size());
+        ASSERT(tag.size() <= TagSize);
+
+        u8 counter[16];
+        initial_counter(iv, counter);
+        apply_key_stream(in, out, counter);
+        compute_tag(out.slice(0, in.size()), aad, counter, tag);
+    }
+
+    // Returns false, leaving `out' untouched, if `in' or `aad' didn't match the tag.
+    bool decrypt(ReadonlyBytes in, Bytes out, ReadonlyBytes iv, ReadonlyBytes aad, ReadonlyBytes tag)
+    {
+        ASSERT(in.size() <= out.size());
+        ASSERT(tag.size() <= TagSize);
+
+        u8 counter[16];
+        initial_counter(iv, counter);
+
+        u8 expected_tag[TagSize];
+        compute_tag(in, aad, counter, { expected_tag, tag.size() });
+        u8 difference = 0;
+        for (size_t i = 0; i < tag.size(); ++i)
+            difference |= expected_tag[i] ^ tag[i];
+        if (difference)
+            return false;
+
+        apply_key_stream(in, out, counter);
+        return true;
+    }
+
+private:
+    // J0 in the specification.
+    void initial_counter(ReadonlyBytes iv, u8* counter)
+    {
+        ASSERT(!iv.is_empty());
+        if (iv.size() == IV_length()) {
+            __builtin_memcpy(counter, iv.data(), iv.size());
+            counter[12] = 0;
+            counter[13] = 0;
+            counter[14] = 0;
+            counter[15] = 1;
+            return;
+        }
+        auto hash = m_ghash->process({}, iv);
+        __builtin_memcpy(counter, hash.data, sizeof(hash.data));
+    }
+
+    static void increment32(u8* counter)
+    {
+        for (size_t i = 16; i > 12;) {
+            --i;
+            if (++counter[i])
+                break;
+        }
+    }
+
+    void apply_key_stream(ReadonlyBytes in, Bytes out, const u8* initial_counter)
+    {
+        u8 counter[16];
+        __builtin_memcpy(counter, initial_counter, sizeof(counter));
+
+        auto& cipher = this->cipher();
+        for (size_t offset = 0; offset < in.size(); offset += 16) {
+            increment32(counter);
+            m_cipher_block.overwrite(counter, sizeof(counter));
+            cipher.encrypt_block(m_cipher_block, m_cipher_block);
+            auto* key_stream = block_data();
+            auto length = min<size_t>(16, in.size() - offset);
+            for (size_t i = 0; i < length; ++i)
+                out[offset + i] = in[offset + i] ^ key_stream[i];
+        }
+    }
+
+    void compute_tag(ReadonlyBytes cipher_text, ReadonlyBytes aad, const u8* initial_counter, Bytes tag)
+    {
+        auto hash = m_ghash->process(aad, cipher_text);
+        m_cipher_block.overwrite(initial_counter, 16);
+        this->cipher().encrypt_block(m_cipher_block, m_cipher_block);
+        auto* mask = block_data();
+        for (size_t i = 0; i < tag.size(); ++i)
+            tag[i] = hash.data[i] ^ mask[i];
+    }
+
+    // Reads the block in place, rather than making a copy of it with get().
+    const u8* block_data() const { return m_cipher_block.data().data(); }
+
+    OwnPtr<Authentication::GHash> m_ghash;
+    typename T::BlockType m_cipher_block {};
+};
+
+}
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Span.h>
+#include <AK/String.h>
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Curves {
+
+// A curve that we can do (ephemeral) Diffie-Hellman key agreement over.
+// All of the secret-dependent arithmetic is done in constant time.
+class EllipticCurve {
+public:
+    virtual ~EllipticCurve() { }
+
+    virtual size_t key_size() const = 0;
+    virtual size_t public_key_size() const = 0;
+    virtual size_t shared_secret_size() const = 0;
+
+    virtual void generate_private_key(Bytes private_key) = 0;
+    virtual bool compute_public_key(ReadonlyBytes private_key, Bytes public_key) = 0;
+
+    // Returns false if the peer's public key isn't acceptable, which leaves `shared_secret' unspecified.
+    virtual bool compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key, Bytes shared_secret) = 0;
+
+    virtual String class_name() const = 0;
+};
+
+}
+}
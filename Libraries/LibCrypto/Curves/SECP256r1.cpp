@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Random.h>
+#include <LibCrypto/Curves/SECP256r1.h>
+#include <string.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Field elements and scalars are 256-bit integers in eight little-endian 32-bit limbs.
+// Everything that touches secret data works on all of the limbs and selects its results
+// with masks, so neither the timing nor the memory access pattern depend on the secret.
+typedef u32 Element[8];
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+static constexpr Element prime = { 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff };
+static constexpr Element prime_minus_two = { 0xfffffffd, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff };
+static constexpr Element order = { 0xfc632551, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff };
+
+// Montgomery form uses R = 2^256, these are R^2, R and b * R (all mod p).
+static constexpr Element r_squared = { 0x00000003, 0x00000000, 0xffffffff, 0xfffffffb, 0xfffffffe, 0xffffffff, 0xfffffffd, 0x00000004 };
+static constexpr Element montgomery_one = { 0x00000001, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xffffffff, 0xfffffffe, 0x00000000 };
+static constexpr Element montgomery_b = { 0x29c4bddf, 0xd89cdf62, 0x78843090, 0xacf005cd, 0xf7212ed6, 0xe5a220ab, 0x04874834, 0xdc30061d };
+
+static constexpr u8 generator[SECP256r1::PointSize] = {
+    0x04,
+    0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47, 0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+    0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0, 0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96,
+    0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b, 0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+    0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce, 0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5
+};
+
+static void import_big_endian(Element out, const u8* in)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        auto* word = in + 28 - 4 * i;
+        out[i] = ((u32)word[0] << 24) | ((u32)word[1] << 16) | ((u32)word[2] << 8) | word[3];
+    }
+}
+
+static void export_big_endian(u8* out, const Element in)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        auto* word = out + 28 - 4 * i;
+        word[0] = in[i] >> 24;
+        word[1] = in[i] >> 16;
+        word[2] = in[i] >> 8;
+        word[3] = in[i];
+    }
+}
+
+// out = condition ? a : b, where condition is 0 or 1.
+static void select(Element out, const Element a, const Element b, u32 condition)
+{
+    u32 mask = 0 - condition;
+    for (size_t i = 0; i < 8; ++i)
+        out[i] = (a[i] & mask) | (b[i] & ~mask);
+}
+
+static u32 add_limbs(Element out, const Element a, const Element b)
+{
+    u64 carry = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        carry += (u64)a[i] + b[i];
+        out[i] = (u32)carry;
+        carry >>= 32;
+    }
+    return carry;
+}
+
+static u32 subtract_limbs(Element out, const Element a, const Element b)
+{
+    u64 borrow = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        u64 difference = (u64)a[i] - b[i] - borrow;
+        out[i] = (u32)difference;
+        borrow = difference >> 63;
+    }
+    return borrow;
+}
+
+// Tells whether a < b, for public values only.
+static bool is_less_than(const Element a, const Element b)
+{
+    Element unused;
+    return subtract_limbs(unused, a, b);
+}
+
+static bool is_zero(const Element a)
+{
+    u32 bits = 0;
+    for (size_t i = 0; i < 8; ++i)
+        bits |= a[i];
+    return !bits;
+}
+
+static void field_add(Element out, const Element a, const Element b)
+{
+    Element sum, reduced;
+    u32 carry = add_limbs(sum, a, b);
+    u32 borrow = subtract_limbs(reduced, sum, prime);
+    select(out, reduced, sum, carry | (borrow ^ 1));
+}
+
+static void field_subtract(Element out, const Element a, const Element b)
+{
+    Element difference, corrected;
+    u32 borrow = subtract_limbs(difference, a, b);
+    add_limbs(corrected, difference, prime);
+    select(out, corrected, difference, borrow);
+}
+
+// out = a * b / R (mod p), by word-by-word Montgomery reduction.
+static void field_multiply(Element out, const Element a, const Element b)
+{
+    u32 t[10] = {};
+    for (size_t i = 0; i < 8; ++i) {
+        u64 carry = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            u64 sum = (u64)t[j] + (u64)a[j] * b[i] + carry;
+            t[j] = (u32)sum;
+            carry = sum >> 32;
+        }
+        u64 sum = (u64)t[8] + carry;
+        t[8] = (u32)sum;
+        t[9] = (u32)(sum >> 32);
+
+        // -p^-1 = 1 (mod 2^32), so t[0] itself is the multiple of p that clears the lowest limb.
+        u32 m = t[0];
+        sum = (u64)t[0] + (u64)m * prime[0];
+        carry = sum >> 32;
+        for (size_t j = 1; j < 8; ++j) {
+            sum = (u64)t[j] + (u64)m * prime[j] + carry;
+            t[j - 1] = (u32)sum;
+            carry = sum >> 32;
+        }
+        sum = (u64)t[8] + carry;
+        t[7] = (u32)sum;
+        t[8] = t[9] + (u32)(sum >> 32);
+    }
+
+    // The result is below 2p, one conditional subtraction brings it into range.
+    Element reduced;
+    u32 borrow = subtract_limbs(reduced, t, prime);
+    select(out, reduced, t, t[8] | (borrow ^ 1));
+}
+
+static void to_montgomery(Element out, const Element a)
+{
+    field_multiply(out, a, r_squared);
+}
+
+static void from_montgomery(Element out, const Element a)
+{
+    static constexpr Element one = { 1 };
+    field_multiply(out, a, one);
+}
+
+static void field_invert(Element out, const Element a)
+{
+    // a^(p - 2) by square-and-multiply; the exponent is public, so branching on it is fine.
+    Element result;
+    memcpy(result, montgomery_one, sizeof(Element));
+    for (int i = 255; i >= 0; --i) {
+        field_multiply(result, result, result);
+        if ((prime_minus_two[i / 32] >> (i % 32)) & 1)
+            field_multiply(result, result, a);
+    }
+    memcpy(out, result, sizeof(Element));
+}
+
+// Homogeneous projective coordinates, with every coordinate in Montgomery form.
+struct Point {
+    Element x;
+    Element y;
+    Element z;
+};
+
+// The complete addition formula for a = -3 from Renes, Costello and Batina,
+// "Complete addition formulas for prime order elliptic curves" (2015), algorithm 4.
+// It has no exceptional cases, so the same code adds, doubles and handles the point at infinity.
+static void point_add(Point& out, const Point& p1, const Point& p2)
+{
+    Element t0, t1, t2, t3, t4, x3, y3, z3;
+    field_multiply(t0, p1.x, p2.x);
+    field_multiply(t1, p1.y, p2.y);
+    field_multiply(t2, p1.z, p2.z);
+    field_add(t3, p1.x, p1.y);
+    field_add(t4, p2.x, p2.y);
+    field_multiply(t3, t3, t4);
+    field_add(t4, t0, t1);
+    field_subtract(t3, t3, t4);
+    field_add(t4, p1.y, p1.z);
+    field_add(x3, p2.y, p2.z);
+    field_multiply(t4, t4, x3);
+    field_add(x3, t1, t2);
+    field_subtract(t4, t4, x3);
+    field_add(x3, p1.x, p1.z);
+    field_add(y3, p2.x, p2.z);
+    field_multiply(x3, x3, y3);
+    field_add(y3, t0, t2);
+    field_subtract(y3, x3, y3);
+    field_multiply(z3, montgomery_b, t2);
+    field_subtract(x3, y3, z3);
+    field_add(z3, x3, x3);
+    field_add(x3, x3, z3);
+    field_subtract(z3, t1, x3);
+    field_add(x3, t1, x3);
+    field_multiply(y3, montgomery_b, y3);
+    field_add(t1, t2, t2);
+    field_add(t2, t1, t2);
+    field_subtract(y3, y3, t2);
+    field_subtract(y3, y3, t0);
+    field_add(t1, y3, y3);
+    field_add(y3, t1, y3);
+    field_add(t1, t0, t0);
+    field_add(t0, t1, t0);
+    field_subtract(t0, t0, t2);
+    field_multiply(t1, t4, y3);
+    field_multiply(t2, t0, y3);
+    field_multiply(y3, x3, z3);
+    field_add(y3, y3, t2);
+    field_multiply(x3, t3, x3);
+    field_subtract(x3, x3, t1);
+    field_multiply(z3, t4, z3);
+    field_multiply(t1, t3, t0);
+    field_add(z3, z3, t1);
+    memcpy(out.x, x3, sizeof(Element));
+    memcpy(out.y, y3, sizeof(Element));
+    memcpy(out.z, z3, sizeof(Element));
+}
+
+static void scalar_multiply(Point& out, const u8* scalar, const Point& point)
+{
+    // Double-and-add-always, keeping the sum only if the scalar bit is set.
+    Point result {};
+    memcpy(result.y, montgomery_one, sizeof(Element));
+    for (int i = 255; i >= 0; --i) {
+        u32 bit = (scalar[31 - i / 8] >> (i % 8)) & 1;
+        point_add(result, result, result);
+        Point sum;
+        point_add(sum, result, point);
+        select(result.x, sum.x, result.x, bit);
+        select(result.y, sum.y, result.y, bit);
+        select(result.z, sum.z, result.z, bit);
+    }
+    out = result;
+}
+
+// Reads an uncompressed point and checks that it's actually on the curve (SEC 1, section 3.2.2.1).
+static bool decode_point(Point& out, ReadonlyBytes encoded)
+{
+    if (encoded.size() != SECP256r1::PointSize || encoded[0] != 0x04)
+        return false;
+    Element x, y;
+    import_big_endian(x, encoded.data() + 1);
+    import_big_endian(y, encoded.data() + 1 + SECP256r1::KeySize);
+    if (!is_less_than(x, prime) || !is_less_than(y, prime))
+        return false;
+
+    to_montgomery(out.x, x);
+    to_montgomery(out.y, y);
+    memcpy(out.z, montgomery_one, sizeof(Element));
+
+    // y^2 = x^3 - 3x + b
+    Element left, right, three_x;
+    field_multiply(left, out.y, out.y);
+    field_multiply(right, out.x, out.x);
+    field_multiply(right, right, out.x);
+    field_add(three_x, out.x, out.x);
+    field_add(three_x, three_x, out.x);
+    field_subtract(right, right, three_x);
+    field_add(right, right, montgomery_b);
+    return !memcmp(left, right, sizeof(Element));
+}
+
+// Writes out the affine coordinates of a point, which fails for the point at infinity.
+static bool encode_point(u8* out, const Point& point)
+{
+    if (is_zero(point.z))
+        return false;
+    Element z_inverse, x, y;
+    field_invert(z_inverse, point.z);
+    field_multiply(x, point.x, z_inverse);
+    field_multiply(y, point.y, z_inverse);
+    from_montgomery(x, x);
+    from_montgomery(y, y);
+    out[0] = 0x04;
+    export_big_endian(out + 1, x);
+    export_big_endian(out + 1 + SECP256r1::KeySize, y);
+    return true;
+}
+
+static bool is_valid_private_key(ReadonlyBytes private_key)
+{
+    if (private_key.size() != SECP256r1::KeySize)
+        return false;
+    Element scalar;
+    import_big_endian(scalar, private_key.data());
+    return !is_zero(scalar) && is_less_than(scalar, order);
+}
+
+void SECP256r1::generate_private_key(Bytes private_key)
+{
+    ASSERT(private_key.size() == KeySize);
+    // Rejection sampling keeps the key uniform in [1, n - 1], and almost never needs a second try.
+    do {
+        AK::fill_with_random(private_key.data(), KeySize);
+    } while (!is_valid_private_key(private_key));
+}
+
+bool SECP256r1::compute_public_key(ReadonlyBytes private_key, Bytes public_key)
+{
+    if (!is_valid_private_key(private_key) || public_key.size() != PointSize)
+        return false;
+    Point base, result;
+    bool ok = decode_point(base, { generator, sizeof(generator) });
+    ASSERT(ok);
+    scalar_multiply(result, private_key.data(), base);
+    return encode_point(public_key.data(), result);
+}
+
+bool SECP256r1::compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key, Bytes shared_secret)
+{
+    if (!is_valid_private_key(private_key) || shared_secret.size() != KeySize)
+        return false;
+    Point peer, result;
+    if (!decode_point(peer, peer_public_key))
+        return false;
+    scalar_multiply(result, private_key.data(), peer);
+    u8 encoded[PointSize];
+    if (!encode_point(encoded, result))
+        return false;
+    memcpy(shared_secret.data(), encoded + 1, KeySize);
+    return true;
+}
+
+}
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <LibCrypto/Curves/EllipticCurve.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Diffie-Hellman over NIST P-256 (SEC 2, section 2.4.2). Public keys are
+// points in uncompressed form (SEC 1, section 2.3.3), shared secrets are the
+// x coordinate of the shared point.
+class SECP256r1 final : public EllipticCurve {
+public:
+    static constexpr size_t KeySize = 32;
+    static constexpr size_t PointSize = 1 + 2 * KeySize;
+
+    virtual size_t key_size() const override { return KeySize; }
+    virtual size_t public_key_size() const override { return PointSize; }
+    virtual size_t shared_secret_size() const override { return KeySize; }
+
+    virtual void generate_private_key(Bytes private_key) override;
+    virtual bool compute_public_key(ReadonlyBytes private_key, Bytes public_key) override;
+    virtual bool compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key, Bytes shared_secret) override;
+
+    virtual String class_name() const override { return "SECP256r1"; }
+};
+
+}
+}
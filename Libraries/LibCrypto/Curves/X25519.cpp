@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Random.h>
+#include <LibCrypto/Curves/X25519.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Field elements mod 2^255 - 19, as sixteen 16-bit limbs held in 64-bit integers so that
+// products and carries never overflow. The arithmetic follows TweetNaCl, which has no
+// data-dependent branches or memory accesses.
+typedef i64 FieldElement[16];
+
+static constexpr FieldElement a24 = { 0xdb41, 1 };
+
+static void carry(FieldElement o)
+{
+    for (size_t i = 0; i < 16; ++i) {
+        o[i] += (i64)1 << 16;
+        i64 c = o[i] >> 16;
+        o[(i + 1) * (i < 15)] += c - 1 + 37 * (c - 1) * (i == 15);
+        o[i] -= c * ((i64)1 << 16);
+    }
+}
+
+// Swaps `p' and `q' if `b' is 1, and does nothing (in the same amount of time) if it's 0.
+static void conditional_swap(FieldElement p, FieldElement q, i64 b)
+{
+    i64 mask = ~(b - 1);
+    for (size_t i = 0; i < 16; ++i) {
+        i64 t = mask & (p[i] ^ q[i]);
+        p[i] ^= t;
+        q[i] ^= t;
+    }
+}
+
+static void pack(u8* out, const FieldElement n)
+{
+    FieldElement m, t;
+    for (size_t i = 0; i < 16; ++i)
+        t[i] = n[i];
+    carry(t);
+    carry(t);
+    carry(t);
+    for (size_t j = 0; j < 2; ++j) {
+        m[0] = t[0] - 0xffed;
+        for (size_t i = 1; i < 15; ++i) {
+            m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        i64 b = (m[15] >> 16) & 1;
+        m[14] &= 0xffff;
+        conditional_swap(t, m, 1 - b);
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        out[2 * i] = t[i] & 0xff;
+        out[2 * i + 1] = t[i] >> 8;
+    }
+}
+
+static void unpack(FieldElement o, const u8* n)
+{
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = n[2 * i] + ((i64)n[2 * i + 1] << 8);
+    // RFC 7748, section 5: "implementations of X25519 MUST mask the most significant bit in the final byte."
+    o[15] &= 0x7fff;
+}
+
+static void add(FieldElement o, const FieldElement a, const FieldElement b)
+{
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = a[i] + b[i];
+}
+
+static void subtract(FieldElement o, const FieldElement a, const FieldElement b)
+{
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = a[i] - b[i];
+}
+
+static void multiply(FieldElement o, const FieldElement a, const FieldElement b)
+{
+    i64 t[31] = {};
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t j = 0; j < 16; ++j)
+            t[i + j] += a[i] * b[j];
+    }
+    // 2^256 = 38 (mod 2^255 - 19)
+    for (size_t i = 0; i < 15; ++i)
+        t[i] += 38 * t[i + 16];
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = t[i];
+    carry(o);
+    carry(o);
+}
+
+static void square(FieldElement o, const FieldElement a)
+{
+    multiply(o, a, a);
+}
+
+static void invert(FieldElement o, const FieldElement in)
+{
+    // a^(p - 2), where the exponent only has bits 2 and 4 cleared.
+    FieldElement c;
+    for (size_t i = 0; i < 16; ++i)
+        c[i] = in[i];
+    for (int a = 253; a >= 0; --a) {
+        square(c, c);
+        if (a != 2 && a != 4)
+            multiply(c, c, in);
+    }
+    for (size_t i = 0; i < 16; ++i)
+        o[i] = c[i];
+}
+
+static void scalar_multiply(u8* out, const u8* scalar, const u8* point)
+{
+    u8 clamped[32];
+    for (size_t i = 0; i < 32; ++i)
+        clamped[i] = scalar[i];
+    clamped[0] &= 248;
+    clamped[31] = (clamped[31] & 127) | 64;
+
+    FieldElement x, a = { 1 }, b, c = {}, d = { 1 }, e, f;
+    unpack(x, point);
+    for (size_t i = 0; i < 16; ++i)
+        b[i] = x[i];
+
+    // The Montgomery ladder from RFC 7748, section 5.
+    for (int i = 254; i >= 0; --i) {
+        i64 bit = (clamped[i >> 3] >> (i & 7)) & 1;
+        conditional_swap(a, b, bit);
+        conditional_swap(c, d, bit);
+        add(e, a, c);
+        subtract(a, a, c);
+        add(c, b, d);
+        subtract(b, b, d);
+        square(d, e);
+        square(f, a);
+        multiply(a, c, a);
+        multiply(c, b, e);
+        add(e, a, c);
+        subtract(a, a, c);
+        square(b, a);
+        subtract(c, d, f);
+        multiply(a, c, a24);
+        add(a, a, d);
+        multiply(c, c, a);
+        multiply(a, d, f);
+        multiply(d, b, x);
+        square(b, e);
+        conditional_swap(a, b, bit);
+        conditional_swap(c, d, bit);
+    }
+
+    invert(c, c);
+    multiply(a, a, c);
+    pack(out, a);
+}
+
+void X25519::generate_private_key(Bytes private_key)
+{
+    ASSERT(private_key.size() == KeySize);
+    AK::fill_with_random(private_key.data(), KeySize);
+}
+
+bool X25519::compute_public_key(ReadonlyBytes private_key, Bytes public_key)
+{
+    static constexpr u8 base_point[KeySize] = { 9 };
+    if (private_key.size() != KeySize || public_key.size() != KeySize)
+        return false;
+    scalar_multiply(public_key.data(), private_key.data(), base_point);
+    return true;
+}
+
+bool X25519::compute_shared_secret(ReadonlyBytes private_key, ReadonlyBytes peer_public_key, Bytes shared_secret)
+{
+    if (private_key.size() != KeySize || peer_public_key.size() != KeySize || shared_secret.size() != KeySize)
+        return false;
+    scalar_multiply(shared_secret.data(), private_key.data(), peer_public_key.data());
+
+    // A point of small order gives an all-zero secret, which the caller can't be allowed to use (RFC 7748, section 6.1).
+    u8 bits = 0;
+    for (size_t i = 0; i < KeySize; ++i)
+        bits |= shared_secret[i];
+    return bits != 0;
+}
+
+}
+}
@@ -24,9 +24,16 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Platform.h>
+#include <AK/StdLibExtras.h>
 #include <AK/Types.h>
 #include <LibCrypto/Hash/SHA1.h>
 
+// The kernel is built without SSE, and doesn't save the FPU state for its own use either.
+#if (ARCH(I386) || ARCH(X86_64)) && !defined(KERNEL)
+#    define HAVE_SHANI
+#endif
+
 namespace Crypto {
 namespace Hash {
 
@@ -85,15 +92,124 @@ inline void SHA1::transform(const u8* data)
     __builtin_memset(blocks, 0, 16 * sizeof(u32));
 }
 
+#ifdef HAVE_SHANI
+typedef int v4si __attribute__((vector_size(16)));
+typedef int v4si_u __attribute__((vector_size(16), aligned(1), may_alias));
+typedef char v16qi __attribute__((vector_size(16)));
+
+#    define SHANI __attribute__((target("sha,sse4.1")))
+
+SHANI static inline v4si load_unaligned(const void* ptr) { return *(const v4si_u*)ptr; }
+
+// Four rounds for every word in `w', where each message word is added into `e' by SHA1NEXTE.
+template<int function>
+SHANI static inline void rounds(v4si& abcd, v4si& previous_abcd, const v4si* w, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        auto e = __builtin_ia32_sha1nexte(previous_abcd, w[i]);
+        previous_abcd = abcd;
+        abcd = __builtin_ia32_sha1rnds4(abcd, e, function);
+    }
+}
+
+// The SHA extensions do four rounds per SHA1RNDS4, and keep `e' in the top lane of its own register.
+SHANI static void transform_blocks_shani(u32* state, const u8* data, size_t count)
+{
+    const v16qi byte_swap { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+
+    auto abcd = __builtin_ia32_pshufd(load_unaligned(state), 0x1b);
+    v4si e0 { 0, 0, 0, (int)state[4] };
+
+    for (; count; --count, data += 64) {
+        auto abcd_saved = abcd;
+        auto e0_saved = e0;
+
+        v4si w[20];
+        for (size_t i = 0; i < 4; ++i)
+            w[i] = (v4si)__builtin_ia32_pshufb128((v16qi)load_unaligned(data + i * 16), byte_swap);
+        for (size_t i = 4; i < 20; ++i)
+            w[i] = __builtin_ia32_sha1msg2(__builtin_ia32_sha1msg1(w[i - 4], w[i - 3]) ^ w[i - 2], w[i - 1]);
+
+        auto previous_abcd = abcd;
+        abcd = __builtin_ia32_sha1rnds4(abcd, e0 + w[0], 0);
+        rounds<0>(abcd, previous_abcd, w + 1, 4);
+        rounds<1>(abcd, previous_abcd, w + 5, 5);
+        rounds<2>(abcd, previous_abcd, w + 10, 5);
+        rounds<3>(abcd, previous_abcd, w + 15, 5);
+
+        e0 = __builtin_ia32_sha1nexte(previous_abcd, e0_saved);
+        abcd += abcd_saved;
+    }
+
+    *(v4si_u*)state = __builtin_ia32_pshufd(abcd, 0x1b);
+    state[4] = e0[3];
+}
+
+static bool cpu_has_sha()
+{
+    u32 eax, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(1), "c"(0));
+    bool has_sse41 = ecx & (1 << 19);
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(7), "c"(0));
+    return has_sse41 && (ebx & (1 << 29));
+}
+#endif
+
+bool SHA1::is_hardware_accelerated()
+{
+#ifdef HAVE_SHANI
+    static int s_has_sha = -1;
+    if (s_has_sha < 0)
+        s_has_sha = cpu_has_sha();
+    return s_has_sha;
+#else
+    return false;
+#endif
+}
+
+void SHA1::transform_blocks(const u8* data, size_t count)
+{
+#ifdef HAVE_SHANI
+    if (is_hardware_accelerated()) {
+        transform_blocks_shani(m_state, data, count);
+        return;
+    }
+#endif
+    for (; count; --count, data += BlockSize)
+        transform(data);
+}
+
 void SHA1::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
-        if (m_data_length == BlockSize) {
-            transform(m_data_buffer);
-            m_bit_length += 512;
-            m_data_length = 0;
-        }
-        m_data_buffer[m_data_length++] = message[i];
+    // Top up a partially filled block first, then hash whole blocks straight out of the message.
+    if (m_data_length) {
+        auto size = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, size);
+        m_data_length += size;
+        message += size;
+        length -= size;
+        if (m_data_length < BlockSize)
+            return;
+        transform_blocks(m_data_buffer, 1);
+        m_bit_length += BlockSize * 8;
+        m_data_length = 0;
+    }
+
+    auto blocks = length / BlockSize;
+    if (blocks) {
+        transform_blocks(message, blocks);
+        m_bit_length += blocks * BlockSize * 8;
+        message += blocks * BlockSize;
+        length -= blocks * BlockSize;
+    }
+
+    if (length) {
+        __builtin_memcpy(m_data_buffer, message, length);
+        m_data_length = length;
     }
 }
 
@@ -116,7 +232,7 @@ SHA1::DigestType SHA1::peek()
     __builtin_memcpy(state, m_state, 20);
 
     if (BlockSize == m_data_length) {
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
         m_bit_length += BlockSize * 8;
         m_data_length = 0;
         i = 0;
@@ -132,7 +248,7 @@ SHA1::DigestType SHA1::peek()
         m_data_buffer[i++] = 0x80;
         while (i < BlockSize)
             m_data_buffer[i++] = 0x00;
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
 
         // Then start another block with BlockSize - 8 bytes of zeros
         __builtin_memset(m_data_buffer, 0, FinalBlockDataSize);
@@ -149,7 +265,7 @@ SHA1::DigestType SHA1::peek()
     m_data_buffer[BlockSize - 7] = m_bit_length >> 48;
     m_data_buffer[BlockSize - 8] = m_bit_length >> 56;
 
-    transform(m_data_buffer);
+    transform_blocks(m_data_buffer, 1);
 
     for (size_t i = 0; i < 4; ++i) {
         digest.data[i + 0] = (m_state[0] >> (24 - i * 8)) & 0x000000ff;
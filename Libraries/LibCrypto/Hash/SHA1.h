@@ -79,6 +79,9 @@ public:
     inline static DigestType hash(const ByteBuffer& buffer) { return hash(buffer.data(), buffer.size()); }
     inline static DigestType hash(const StringView& buffer) { return hash((const u8*)buffer.characters_without_null_termination(), buffer.length()); }
 
+    // Whether the SHA extensions are available.
+    static bool is_hardware_accelerated();
+
     virtual String class_name() const override
     {
         return "SHA1";
@@ -93,6 +96,7 @@ public:
 
 private:
     inline void transform(const u8*);
+    void transform_blocks(const u8*, size_t count);
 
     u8 m_data_buffer[BlockSize];
     size_t m_data_length { 0 };
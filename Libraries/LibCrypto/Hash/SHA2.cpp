@@ -24,9 +24,16 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Platform.h>
+#include <AK/StdLibExtras.h>
 #include <AK/Types.h>
 #include <LibCrypto/Hash/SHA2.h>
 
+// The kernel is built without SSE, and doesn't save the FPU state for its own use either.
+#if (ARCH(I386) || ARCH(X86_64)) && !defined(KERNEL)
+#    define HAVE_X86_SIMD
+#endif
+
 namespace Crypto {
 namespace Hash {
 constexpr inline static auto ROTRIGHT(u32 a, size_t b) { return (a >> b) | (a << (32 - b)); }
@@ -86,15 +93,148 @@ inline void SHA256::transform(const u8* data)
     m_state[7] += h;
 }
 
-void SHA256::update(const u8* message, size_t length)
+#ifdef HAVE_X86_SIMD
+typedef int v4si __attribute__((vector_size(16)));
+typedef int v4si_u __attribute__((vector_size(16), aligned(1), may_alias));
+typedef long long v2di __attribute__((vector_size(16)));
+typedef short v8hi __attribute__((vector_size(16)));
+typedef char v16qi __attribute__((vector_size(16)));
+
+#    define SHANI __attribute__((target("sha,sse4.1")))
+
+SHANI static inline v4si load_unaligned(const void* ptr) { return *(const v4si_u*)ptr; }
+
+// The SHA extensions keep the state as ABEF and CDGH, and do two rounds per SHA256RNDS2.
+SHANI static void sha256_transform_blocks_shani(u32* state, const u8* data, size_t count)
 {
-    for (size_t i = 0; i < length; ++i) {
-        if (m_data_length == BlockSize) {
-            transform(m_data_buffer);
-            m_bit_length += 512;
-            m_data_length = 0;
+    const v16qi byte_swap { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+
+    auto cdab = __builtin_ia32_pshufd(load_unaligned(state), 0xb1);
+    auto efgh = __builtin_ia32_pshufd(load_unaligned(state + 4), 0x1b);
+    auto abef = (v4si)__builtin_ia32_palignr128((v2di)cdab, (v2di)efgh, 64);
+    auto cdgh = (v4si)__builtin_ia32_pblendw128((v8hi)efgh, (v8hi)cdab, 0xf0);
+
+    for (; count; --count, data += 64) {
+        auto abef_saved = abef;
+        auto cdgh_saved = cdgh;
+
+        v4si m[16];
+        for (size_t i = 0; i < 4; ++i)
+            m[i] = (v4si)__builtin_ia32_pshufb128((v16qi)load_unaligned(data + i * 16), byte_swap);
+        for (size_t i = 4; i < 16; ++i) {
+            auto partial = __builtin_ia32_sha256msg1(m[i - 4], m[i - 3]) + (v4si)__builtin_ia32_palignr128((v2di)m[i - 1], (v2di)m[i - 2], 32);
+            m[i] = __builtin_ia32_sha256msg2(partial, m[i - 1]);
+        }
+
+        for (size_t i = 0; i < 16; ++i) {
+            auto words = m[i] + load_unaligned(SHA256Constants::RoundConstants + i * 4);
+            cdgh = __builtin_ia32_sha256rnds2(cdgh, abef, words);
+            abef = __builtin_ia32_sha256rnds2(abef, cdgh, __builtin_ia32_pshufd(words, 0x0e));
         }
-        m_data_buffer[m_data_length++] = message[i];
+
+        abef += abef_saved;
+        cdgh += cdgh_saved;
+    }
+
+    auto feba = __builtin_ia32_pshufd(abef, 0x1b);
+    auto dchg = __builtin_ia32_pshufd(cdgh, 0xb1);
+    *(v4si_u*)state = (v4si)__builtin_ia32_pblendw128((v8hi)feba, (v8hi)dchg, 0xf0);
+    *(v4si_u*)(state + 4) = (v4si)__builtin_ia32_palignr128((v2di)dchg, (v2di)feba, 64);
+}
+
+static void cpuid(u32 leaf, u32& ebx, u32& ecx, u32& edx)
+{
+    u32 eax;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(leaf), "c"(0));
+}
+
+static bool cpu_has_sha()
+{
+    u32 ebx, ecx, edx;
+    cpuid(1, ebx, ecx, edx);
+    bool has_sse41 = ecx & (1 << 19);
+    cpuid(7, ebx, ecx, edx);
+    return has_sse41 && (ebx & (1 << 29));
+}
+
+// AVX2 also needs the OS to save the upper halves of the YMM registers on context switches.
+static bool cpu_has_avx2()
+{
+    u32 ebx, ecx, edx;
+    cpuid(1, ebx, ecx, edx);
+    if (!(ecx & (1 << 27)))
+        return false;
+    u32 xcr0_low, xcr0_high;
+    asm volatile("xgetbv"
+                 : "=a"(xcr0_low), "=d"(xcr0_high)
+                 : "c"(0));
+    if ((xcr0_low & 6) != 6)
+        return false;
+    cpuid(7, ebx, ecx, edx);
+    return ebx & (1 << 5);
+}
+
+static bool cpu_has_sse2()
+{
+    u32 ebx, ecx, edx;
+    cpuid(1, ebx, ecx, edx);
+    return edx & (1 << 26);
+}
+#endif
+
+bool SHA256::is_hardware_accelerated()
+{
+#ifdef HAVE_X86_SIMD
+    static int s_has_sha = -1;
+    if (s_has_sha < 0)
+        s_has_sha = cpu_has_sha();
+    return s_has_sha;
+#else
+    return false;
+#endif
+}
+
+void SHA256::transform_blocks(const u8* data, size_t count)
+{
+#ifdef HAVE_X86_SIMD
+    if (is_hardware_accelerated()) {
+        sha256_transform_blocks_shani(m_state, data, count);
+        return;
+    }
+#endif
+    for (; count; --count, data += BlockSize)
+        transform(data);
+}
+
+void SHA256::update(const u8* message, size_t length)
+{
+    // Top up a partially filled block first, then hash whole blocks straight out of the message.
+    if (m_data_length) {
+        auto size = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, size);
+        m_data_length += size;
+        message += size;
+        length -= size;
+        if (m_data_length < BlockSize)
+            return;
+        transform_blocks(m_data_buffer, 1);
+        m_bit_length += BlockSize * 8;
+        m_data_length = 0;
+    }
+
+    auto blocks = length / BlockSize;
+    if (blocks) {
+        transform_blocks(message, blocks);
+        m_bit_length += blocks * BlockSize * 8;
+        message += blocks * BlockSize;
+        length -= blocks * BlockSize;
+    }
+
+    if (length) {
+        __builtin_memcpy(m_data_buffer, message, length);
+        m_data_length = length;
     }
 }
 
@@ -111,7 +251,7 @@ SHA256::DigestType SHA256::peek()
     size_t i = m_data_length;
 
     if (BlockSize == m_data_length) {
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
         m_bit_length += BlockSize * 8;
         m_data_length = 0;
         i = 0;
@@ -127,7 +267,7 @@ SHA256::DigestType SHA256::peek()
         m_data_buffer[i++] = 0x80;
         while (i < BlockSize)
             m_data_buffer[i++] = 0x00;
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
 
         // Then start another block with BlockSize - 8 bytes of zeros
         __builtin_memset(m_data_buffer, 0, FinalBlockDataSize);
@@ -144,7 +284,7 @@ SHA256::DigestType SHA256::peek()
     m_data_buffer[BlockSize - 7] = m_bit_length >> 48;
     m_data_buffer[BlockSize - 8] = m_bit_length >> 56;
 
-    transform(m_data_buffer);
+    transform_blocks(m_data_buffer, 1);
 
     // SHA uses big-endian and we assume little-endian
     // FIXME: looks like a thing for AK::NetworkOrdered,
@@ -162,6 +302,179 @@ SHA256::DigestType SHA256::peek()
     return digest;
 }
 
+#ifdef HAVE_X86_SIMD
+typedef u32 v4su __attribute__((vector_size(16)));
+typedef u32 v8su __attribute__((vector_size(32)));
+
+// One SHA-256 block for each lane. The message words are gathered out of the separate blocks,
+// and then every operation works on all of the lanes at once.
+template<typename Vector, size_t Lanes>
+ALWAYS_INLINE static void sha256_transform_lanes(Vector* state, const u8* const* blocks)
+{
+    // The rotations are spelled out, since a helper returning a 256-bit vector would change the ABI of the SSE2 lanes.
+    Vector m[64];
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            auto* data = blocks[lane] + i * 4;
+            m[i][lane] = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+        }
+    }
+    for (size_t i = 16; i < 64; ++i) {
+        auto x = m[i - 15];
+        auto y = m[i - 2];
+        auto sigma0 = ((x >> 7) | (x << 25)) ^ ((x >> 18) | (x << 14)) ^ (x >> 3);
+        auto sigma1 = ((y >> 17) | (y << 15)) ^ ((y >> 19) | (y << 13)) ^ (y >> 10);
+        m[i] = sigma1 + m[i - 7] + sigma0 + m[i - 16];
+    }
+
+    auto a = state[0], b = state[1],
+         c = state[2], d = state[3],
+         e = state[4], f = state[5],
+         g = state[6], h = state[7];
+
+    for (size_t i = 0; i < 64; ++i) {
+        auto ep1 = ((e >> 6) | (e << 26)) ^ ((e >> 11) | (e << 21)) ^ ((e >> 25) | (e << 7));
+        auto temp0 = h + ep1 + ((e & f) ^ (g & ~e)) + SHA256Constants::RoundConstants[i] + m[i];
+        auto ep0 = ((a >> 2) | (a << 30)) ^ ((a >> 13) | (a << 19)) ^ ((a >> 22) | (a << 10));
+        auto temp1 = ep0 + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp0;
+        d = c;
+        c = b;
+        b = a;
+        a = temp0 + temp1;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+// Hashes up to `Lanes' messages side by side. Each lane goes through the whole blocks of its message
+// in place, then through one or two padded final blocks, and then sits idle until the longest one is done.
+template<typename Vector, size_t Lanes>
+ALWAYS_INLINE static void sha256_hash_lanes(const ReadonlyBytes* messages, SHA256::DigestType* digests, size_t count)
+{
+    constexpr size_t block_size = SHA256::BlockSize;
+    static const u8 idle_block[block_size] {};
+
+    u8 final_blocks[Lanes][2 * block_size];
+    size_t whole_blocks[Lanes];
+    size_t total_blocks[Lanes];
+    size_t longest = 0;
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        if (lane >= count) {
+            whole_blocks[lane] = 0;
+            total_blocks[lane] = 0;
+            continue;
+        }
+        auto& message = messages[lane];
+        whole_blocks[lane] = message.size() / block_size;
+        size_t remaining = message.size() % block_size;
+        size_t final_block_count = remaining < block_size - 8 ? 1 : 2;
+        auto* final_block = final_blocks[lane];
+        __builtin_memset(final_block, 0, final_block_count * block_size);
+        if (remaining)
+            __builtin_memcpy(final_block, message.data() + whole_blocks[lane] * block_size, remaining);
+        final_block[remaining] = 0x80;
+        u64 bit_length = (u64)message.size() * 8;
+        for (size_t i = 0; i < 8; ++i)
+            final_block[final_block_count * block_size - 1 - i] = bit_length >> (i * 8);
+        total_blocks[lane] = whole_blocks[lane] + final_block_count;
+        longest = max(longest, total_blocks[lane]);
+    }
+
+    Vector state[8];
+    for (size_t i = 0; i < 8; ++i)
+        state[i] = Vector {} + SHA256Constants::InitializationHashes[i];
+
+    for (size_t block = 0; block < longest; ++block) {
+        const u8* blocks[Lanes];
+        Vector active {};
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            if (block < whole_blocks[lane])
+                blocks[lane] = messages[lane].data() + block * block_size;
+            else if (block < total_blocks[lane])
+                blocks[lane] = final_blocks[lane] + (block - whole_blocks[lane]) * block_size;
+            else
+                blocks[lane] = idle_block;
+            active[lane] = block < total_blocks[lane] ? 0xffffffff : 0;
+        }
+
+        Vector previous_state[8];
+        for (size_t i = 0; i < 8; ++i)
+            previous_state[i] = state[i];
+        sha256_transform_lanes<Vector, Lanes>(state, blocks);
+        for (size_t i = 0; i < 8; ++i)
+            state[i] = (state[i] & active) | (previous_state[i] & ~active);
+    }
+
+    for (size_t lane = 0; lane < count; ++lane) {
+        for (size_t i = 0; i < 8; ++i) {
+            for (size_t j = 0; j < 4; ++j)
+                digests[lane].data[i * 4 + j] = state[i][lane] >> (24 - j * 8);
+        }
+    }
+}
+
+__attribute__((target("sse2"))) static void sha256_hash_4_lanes(const ReadonlyBytes* messages, SHA256::DigestType* digests, size_t count)
+{
+    sha256_hash_lanes<v4su, 4>(messages, digests, count);
+}
+
+__attribute__((target("avx2"))) static void sha256_hash_8_lanes(const ReadonlyBytes* messages, SHA256::DigestType* digests, size_t count)
+{
+    sha256_hash_lanes<v8su, 8>(messages, digests, count);
+}
+#endif
+
+size_t SHA256::multi_buffer_lanes()
+{
+#ifdef HAVE_X86_SIMD
+    static size_t s_lanes = 0;
+    if (!s_lanes) {
+        // A single stream with the SHA extensions beats eight AVX2 lanes, so don't bother splitting up the work then.
+        if (is_hardware_accelerated())
+            s_lanes = 1;
+        else if (cpu_has_avx2())
+            s_lanes = 8;
+        else if (cpu_has_sse2())
+            s_lanes = 4;
+        else
+            s_lanes = 1;
+    }
+    return s_lanes;
+#else
+    return 1;
+#endif
+}
+
+void SHA256::hash_many(Span<const ReadonlyBytes> messages, Span<DigestType> digests)
+{
+    ASSERT(digests.size() >= messages.size());
+    size_t i = 0;
+#ifdef HAVE_X86_SIMD
+    auto lanes = multi_buffer_lanes();
+    while (lanes > 1 && messages.size() - i > 1) {
+        auto count = min(lanes, messages.size() - i);
+        if (lanes == 8)
+            sha256_hash_8_lanes(messages.data() + i, digests.data() + i, count);
+        else
+            sha256_hash_4_lanes(messages.data() + i, digests.data() + i, count);
+        i += count;
+    }
+#endif
+    for (; i < messages.size(); ++i)
+        digests[i] = hash(messages[i].data(), messages[i].size());
+}
+
 inline void SHA512::transform(const u8* data)
 {
     u64 m[80];
@@ -205,13 +518,28 @@ inline void SHA512::transform(const u8* data)
 
 void SHA512::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
-        if (m_data_length == BlockSize) {
-            transform(m_data_buffer);
-            m_bit_length += 1024;
-            m_data_length = 0;
-        }
-        m_data_buffer[m_data_length++] = message[i];
+    // There are no SHA-512 instructions to reach for, but at least we don't need to copy whole blocks around.
+    if (m_data_length) {
+        auto size = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, size);
+        m_data_length += size;
+        message += size;
+        length -= size;
+        if (m_data_length < BlockSize)
+            return;
+        transform(m_data_buffer);
+        m_bit_length += BlockSize * 8;
+        m_data_length = 0;
+    }
+
+    for (; length >= BlockSize; length -= BlockSize, message += BlockSize) {
+        transform(message);
+        m_bit_length += BlockSize * 8;
+    }
+
+    if (length) {
+        __builtin_memcpy(m_data_buffer, message, length);
+        m_data_length = length;
     }
 }
 
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Span.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 #include <LibCrypto/Hash/HashFunction.h>
@@ -119,6 +120,15 @@ public:
     inline static DigestType hash(const ByteBuffer& buffer) { return hash(buffer.data(), buffer.size()); }
     inline static DigestType hash(const StringView& buffer) { return hash((const u8*)buffer.characters_without_null_termination(), buffer.length()); }
 
+    // Hashes each message into the digest at the same index, running several of them
+    // side by side in SIMD lanes where the CPU has them.
+    static void hash_many(Span<const ReadonlyBytes> messages, Span<DigestType> digests);
+    // How many messages hash_many() works on at once.
+    static size_t multi_buffer_lanes();
+
+    // Whether the SHA extensions are available.
+    static bool is_hardware_accelerated();
+
     virtual String class_name() const override
     {
         StringBuilder builder;
@@ -136,6 +146,7 @@ public:
 
 private:
     inline void transform(const u8*);
+    void transform_blocks(const u8*, size_t count);
 
     u8 m_data_buffer[BlockSize];
     size_t m_data_length { 0 };
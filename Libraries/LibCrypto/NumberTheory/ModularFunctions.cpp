@@ -116,11 +116,167 @@ UnsignedBigInteger ModularInverse(const UnsignedBigInteger& a_, const UnsignedBi
     return temp_remainder;
 }
 
+// Returns -m^-1 mod 2^32, for an odd m.
+static u32 montgomery_inverse(u32 m)
+{
+    // m * m = 1 (mod 8) for any odd m, and each Newton step doubles the number of correct bits.
+    u32 inverse = m;
+    for (size_t i = 0; i < 4; ++i)
+        inverse *= 2 - m * inverse;
+    return -inverse;
+}
+
+// output = left * right / R (mod modulus), for R = 2^(32 * length), with all of the numbers `length' words long
+// and below the modulus. `temp' needs room for length + 2 words. The output may alias either operand.
+static void montgomery_multiply(u32* output, const u32* left, const u32* right, const u32* modulus, size_t length, u32 inverse, u32* temp)
+{
+    __builtin_memset(temp, 0, (length + 2) * sizeof(u32));
+    for (size_t i = 0; i < length; ++i) {
+        u64 word = right[i];
+        u64 carry = 0;
+        for (size_t j = 0; j < length; ++j) {
+            carry += left[j] * word + temp[j];
+            temp[j] = (u32)carry;
+            carry >>= 32;
+        }
+        carry += temp[length];
+        temp[length] = (u32)carry;
+        temp[length + 1] = (u32)(carry >> 32);
+
+        // Adding this multiple of the modulus clears the lowest word, which is then shifted out.
+        u64 factor = (u32)(temp[0] * inverse);
+        carry = (factor * modulus[0] + temp[0]) >> 32;
+        for (size_t j = 1; j < length; ++j) {
+            carry += factor * modulus[j] + temp[j];
+            temp[j - 1] = (u32)carry;
+            carry >>= 32;
+        }
+        carry += temp[length];
+        temp[length - 1] = (u32)carry;
+        temp[length] = temp[length + 1] + (u32)(carry >> 32);
+    }
+
+    // The result is below 2 * modulus. Subtract the modulus once and pick the right one of the two
+    // with a mask, so that the time this takes doesn't depend on the (possibly secret) operands.
+    u64 borrow = 0;
+    for (size_t j = 0; j < length; ++j) {
+        u64 difference = (u64)temp[j] - modulus[j] - borrow;
+        output[j] = (u32)difference;
+        borrow = difference >> 63;
+    }
+    u32 keep_unreduced = 0 - (u32)(borrow & (temp[length] ^ 1));
+    for (size_t j = 0; j < length; ++j)
+        output[j] = (temp[j] & keep_unreduced) | (output[j] & ~keep_unreduced);
+}
+
+// x = 2 * x (mod modulus), for x below the modulus. This only ever sees values derived from the modulus.
+static void double_modulo(u32* x, const u32* modulus, size_t length)
+{
+    u32 carry = 0;
+    for (size_t i = 0; i < length; ++i) {
+        u32 next_carry = x[i] >> 31;
+        x[i] = (x[i] << 1) | carry;
+        carry = next_carry;
+    }
+    // Reduce if x >= modulus, including when the doubling carried out of the top word.
+    bool needs_reduction = true;
+    if (!carry) {
+        for (size_t i = length; i > 0; --i) {
+            if (x[i - 1] != modulus[i - 1]) {
+                needs_reduction = x[i - 1] > modulus[i - 1];
+                break;
+            }
+        }
+    }
+    if (!needs_reduction)
+        return;
+    u64 borrow = 0;
+    for (size_t i = 0; i < length; ++i) {
+        u64 difference = (u64)x[i] - modulus[i] - borrow;
+        x[i] = (u32)difference;
+        borrow = difference >> 63;
+    }
+}
+
+// Fixed-window exponentiation in the Montgomery domain: every window costs the same four
+// squarings and one multiplication, and the table is read in full for every lookup.
+static constexpr size_t montgomery_window_bits = 4;
+static constexpr size_t montgomery_table_size = 1 << montgomery_window_bits;
+
+static UnsignedBigInteger montgomery_power(const UnsignedBigInteger& b, const UnsignedBigInteger& e, const UnsignedBigInteger& m)
+{
+    size_t length = m.trimmed_length();
+    const u32* modulus = m.words().data();
+    u32 inverse = montgomery_inverse(modulus[0]);
+
+    // All of the intermediates live in one buffer, so nothing gets allocated once we're going.
+    Vector<u32, STARTING_WORD_SIZE> storage;
+    storage.resize((montgomery_table_size + 6) * length + 2);
+    __builtin_memset(storage.data(), 0, storage.size() * sizeof(u32));
+    u32* r_squared = storage.data();
+    u32* base = r_squared + length;
+    u32* accumulator = base + length;
+    u32* selected = accumulator + length;
+    u32* one = selected + length;
+    u32* table = one + length;
+    u32* temp = table + montgomery_table_size * length;
+
+    // R (which is one in Montgomery form) and R^2, by doubling 1 all the way up.
+    r_squared[0] = 1;
+    for (size_t i = 0; i < 2 * 32 * length; ++i) {
+        double_modulo(r_squared, modulus, length);
+        if (i == 32 * length - 1)
+            __builtin_memcpy(table, r_squared, length * sizeof(u32));
+    }
+
+    if (b < m) {
+        __builtin_memcpy(base, b.words().data(), b.trimmed_length() * sizeof(u32));
+    } else {
+        auto reduced = b.divided_by(m).remainder;
+        __builtin_memcpy(base, reduced.words().data(), reduced.trimmed_length() * sizeof(u32));
+    }
+
+    // table[i] = base^i, in Montgomery form
+    montgomery_multiply(table + length, base, r_squared, modulus, length, inverse, temp);
+    for (size_t i = 2; i < montgomery_table_size; ++i)
+        montgomery_multiply(table + i * length, table + (i - 1) * length, table + length, modulus, length, inverse, temp);
+
+    __builtin_memcpy(accumulator, table, length * sizeof(u32));
+    size_t exponent_length = e.trimmed_length();
+    const u32* exponent = e.words().data();
+    for (size_t window = exponent_length * 32 / montgomery_window_bits; window > 0; --window) {
+        size_t bit_index = (window - 1) * montgomery_window_bits;
+        u32 window_value = (exponent[bit_index / 32] >> (bit_index % 32)) & (montgomery_table_size - 1);
+
+        for (size_t i = 0; i < montgomery_window_bits; ++i)
+            montgomery_multiply(accumulator, accumulator, accumulator, modulus, length, inverse, temp);
+
+        for (size_t i = 0; i < montgomery_table_size; ++i) {
+            u32 mask = 0 - (u32)(i == window_value);
+            for (size_t j = 0; j < length; ++j)
+                selected[j] = (selected[j] & ~mask) | (table[i * length + j] & mask);
+        }
+        montgomery_multiply(accumulator, accumulator, selected, modulus, length, inverse, temp);
+    }
+
+    // Out of the Montgomery domain, by multiplying with a plain 1.
+    one[0] = 1;
+    montgomery_multiply(accumulator, accumulator, one, modulus, length, inverse, temp);
+
+    AK::Vector<u32, STARTING_WORD_SIZE> result;
+    result.append(accumulator, length);
+    return UnsignedBigInteger(move(result));
+}
+
 UnsignedBigInteger ModularPower(const UnsignedBigInteger& b, const UnsignedBigInteger& e, const UnsignedBigInteger& m)
 {
     if (m == 1)
         return 0;
 
+    // Every modulus that matters (RSA, primality tests) is odd, which is what Montgomery reduction needs.
+    if (m.trimmed_length() && m.words()[0] % 2 == 1)
+        return montgomery_power(b, e, m);
+
     UnsignedBigInteger ep { e };
     UnsignedBigInteger base { b };
     UnsignedBigInteger exp { 1 };
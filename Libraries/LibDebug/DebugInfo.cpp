@@ -33,6 +33,37 @@
 
 //#define DEBUG_SPAM
 
+// Returns the index of the first element that starts after the address, in a vector sorted by start address.
+template<typename T, typename GetAddress>
+static size_t first_index_after(const Vector<T>& elements, u32 address, GetAddress get_address)
+{
+    size_t begin = 0;
+    size_t end = elements.size();
+    while (begin < end) {
+        size_t middle = begin + (end - begin) / 2;
+        if (get_address(elements[middle]) <= address)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin;
+}
+
+// Functions don't overlap, so the closest one that starts at or before the address is the only candidate.
+static Optional<size_t> index_of_containing_function(const Vector<DebugInfo::VariablesScope>& scopes, u32 address)
+{
+    auto index = first_index_after(scopes, address, [](auto& scope) { return scope.address_low; });
+    while (index > 0) {
+        auto& scope = scopes[--index];
+        if (!scope.is_function)
+            continue;
+        if (address < scope.address_high)
+            return index;
+        return {};
+    }
+    return {};
+}
+
 DebugInfo::DebugInfo(NonnullRefPtr<const ELF::Loader> elf)
     : m_elf(elf)
     , m_dwarf_info(Dwarf::DwarfInfo::create(m_elf))
@@ -44,12 +75,93 @@ DebugInfo::DebugInfo(NonnullRefPtr<const ELF::Loader> elf)
 void DebugInfo::prepare_variable_scopes()
 {
     m_dwarf_info->for_each_compilation_unit([&](const Dwarf::CompilationUnit& unit) {
-        auto root = unit.root_die();
-        parse_scopes_impl(root);
+        m_units.append({ &unit, false, {} });
+        auto unit_index = m_units.size() - 1;
+        if (append_ranges_of_unit(unit, unit_index))
+            return;
+        // Without address information for the unit as a whole, we have to look at what its functions cover.
+        auto& scopes = *scopes_of_unit(unit_index);
+        for (auto& scope : scopes) {
+            if (scope.is_function)
+                m_unit_ranges.append({ scope.address_low, scope.address_high, unit_index });
+        }
+    });
+    quick_sort(m_unit_ranges, [](auto& a, auto& b) {
+        return a.address_low < b.address_low;
     });
 }
 
-void DebugInfo::parse_scopes_impl(const Dwarf::DIE& die)
+bool DebugInfo::append_ranges_of_unit(const Dwarf::CompilationUnit& unit, size_t unit_index)
+{
+    auto root = unit.root_die();
+    auto low_pc = root.get_attribute(Dwarf::Attribute::LowPc);
+
+    auto ranges = root.get_attribute(Dwarf::Attribute::Ranges);
+    if (ranges.has_value()) {
+        auto& ranges_data = m_dwarf_info->debug_ranges_data();
+        if (ranges_data.is_null() || ranges.value().type != Dwarf::DIE::AttributeValue::Type::SecOffset)
+            return false;
+
+        // A list of [begin, end) pairs relative to the unit's base address, which ends with a pair of zeroes.
+        InputMemoryStream stream { ranges_data };
+        stream.discard_or_error(ranges.value().data.as_u32);
+        u32 base_address = low_pc.has_value() ? low_pc.value().data.as_u32 : 0;
+        Vector<AddressRange> unit_ranges;
+        for (;;) {
+            u32 begin = 0;
+            u32 end = 0;
+            stream >> begin >> end;
+            if (stream.handle_error())
+                return false;
+            if (!begin && !end)
+                break;
+            if (begin == 0xffffffff) {
+                base_address = end;
+                continue;
+            }
+            unit_ranges.append({ base_address + begin, base_address + end, unit_index });
+        }
+        m_unit_ranges.append(move(unit_ranges));
+        return true;
+    }
+
+    auto high_pc = root.get_attribute(Dwarf::Attribute::HighPc);
+    if (!low_pc.has_value() || !high_pc.has_value())
+        return false;
+    // Just like for scopes, HighPc is an offset from LowPc.
+    m_unit_ranges.append({ low_pc.value().data.as_u32, low_pc.value().data.as_u32 + high_pc.value().data.as_u32, unit_index });
+    return true;
+}
+
+const Vector<DebugInfo::VariablesScope>* DebugInfo::scopes_of_unit(size_t unit_index) const
+{
+    auto& unit = m_units[unit_index];
+    if (!unit.is_parsed) {
+        unit.is_parsed = true;
+        parse_scopes_impl(unit.unit->root_die(), unit.scopes);
+        quick_sort(unit.scopes, [](auto& a, auto& b) {
+            if (a.address_low != b.address_low)
+                return a.address_low < b.address_low;
+            if (a.address_high != b.address_high)
+                return a.address_high > b.address_high;
+            return a.is_function && !b.is_function;
+        });
+    }
+    return &unit.scopes;
+}
+
+const Vector<DebugInfo::VariablesScope>* DebugInfo::scopes_containing(u32 address) const
+{
+    auto index = first_index_after(m_unit_ranges, address, [](auto& range) { return range.address_low; });
+    if (index == 0)
+        return nullptr;
+    auto& range = m_unit_ranges[index - 1];
+    if (address >= range.address_high)
+        return nullptr;
+    return scopes_of_unit(range.unit_index);
+}
+
+void DebugInfo::parse_scopes_impl(const Dwarf::DIE& die, Vector<VariablesScope>& scopes) const
 {
     die.for_each_child([&](const Dwarf::DIE& child) {
         if (child.is_null())
@@ -92,9 +204,9 @@ void DebugInfo::parse_scopes_impl(const Dwarf::DIE& die)
                 return;
             scope.dies_of_variables.append(variable_entry);
         });
-        m_scopes.append(scope);
+        scopes.append(scope);
 
-        parse_scopes_impl(child);
+        parse_scopes_impl(child, scopes);
     });
 }
 
@@ -113,35 +225,50 @@ void DebugInfo::prepare_lines()
         all_lines.append(program.lines());
     }
 
+    // Most lines share their file with many others, so each distinct path is only shortened (and stored) once.
+    HashMap<String, String> shortened_paths;
     for (auto& line_info : all_lines) {
-        String file_path = line_info.file;
-        if (file_path.contains("Toolchain/") || file_path.contains("libgcc"))
-            continue;
-        if (file_path.contains("serenity/")) {
-            auto start_index = file_path.index_of("serenity/").value() + String("serenity/").length();
-            file_path = file_path.substring(start_index, file_path.length() - start_index);
+        auto file_path = shortened_paths.get(line_info.file);
+        if (!file_path.has_value()) {
+            String shortened_path = line_info.file;
+            if (shortened_path.contains("Toolchain/") || shortened_path.contains("libgcc")) {
+                shortened_path = {};
+            } else if (shortened_path.contains("serenity/")) {
+                auto start_index = shortened_path.index_of("serenity/").value() + String("serenity/").length();
+                shortened_path = shortened_path.substring(start_index, shortened_path.length() - start_index);
+            }
+            shortened_paths.set(line_info.file, shortened_path);
+            file_path = shortened_path;
         }
-        m_sorted_lines.append({ line_info.address, file_path, line_info.line });
+        if (file_path.value().is_null())
+            continue;
+        m_sorted_lines.append({ line_info.address, file_path.value(), line_info.line });
     }
     quick_sort(m_sorted_lines, [](auto& a, auto& b) {
         return a.address < b.address;
     });
+
+    for (auto& line_info : m_sorted_lines) {
+        if (!m_lines_by_file.contains(line_info.file))
+            m_lines_by_file.set(line_info.file, {});
+        m_lines_by_file.find(line_info.file)->value.append({ line_info.line, line_info.address });
+    }
+    for (auto& it : m_lines_by_file) {
+        quick_sort(it.value, [](auto& a, auto& b) {
+            if (a.line != b.line)
+                return a.line < b.line;
+            return a.address < b.address;
+        });
+    }
 }
 
 Optional<DebugInfo::SourcePosition> DebugInfo::get_source_position(u32 target_address) const
 {
-    if (m_sorted_lines.is_empty())
+    auto index = first_index_after(m_sorted_lines, target_address, [](auto& line) { return line.address; });
+    // Nothing is known about what comes after the last line.
+    if (index == 0 || index == m_sorted_lines.size())
         return {};
-    if (target_address < m_sorted_lines[0].address)
-        return {};
-
-    // TODO: We can do a binray search here
-    for (size_t i = 0; i < m_sorted_lines.size() - 1; ++i) {
-        if (m_sorted_lines[i + 1].address > target_address) {
-            return SourcePosition::from_line_info(m_sorted_lines[i]);
-        }
-    }
-    return {};
+    return SourcePosition::from_line_info(m_sorted_lines[index - 1]);
 }
 
 Optional<u32> DebugInfo::get_instruction_from_source(const String& file, size_t line) const
@@ -152,19 +279,41 @@ Optional<u32> DebugInfo::get_instruction_from_source(const String& file, size_t
         file_path = file.substring(sizeof(SERENITY_LIBS_PREFIX), file.length() - sizeof(SERENITY_LIBS_PREFIX));
         file_path = String::format("../%s", file_path.characters());
     }
-    for (const auto& line_entry : m_sorted_lines) {
-        if (line_entry.file == file_path && line_entry.line == line)
-            return Optional<u32>(line_entry.address);
+    auto it = m_lines_by_file.find(file_path);
+    if (it == m_lines_by_file.end())
+        return {};
+
+    // Find the first entry for the line, which is the one with the lowest address.
+    auto& lines = it->value;
+    size_t begin = 0;
+    size_t end = lines.size();
+    while (begin < end) {
+        size_t middle = begin + (end - begin) / 2;
+        if (lines[middle].line < line)
+            begin = middle + 1;
+        else
+            end = middle;
     }
-    return {};
+    if (begin == lines.size() || lines[begin].line != line)
+        return {};
+    return lines[begin].address;
 }
 
 NonnullOwnPtrVector<DebugInfo::VariableInfo> DebugInfo::get_variables_in_current_scope(const PtraceRegisters& regs) const
 {
     NonnullOwnPtrVector<DebugInfo::VariableInfo> variables;
 
-    // TODO: We can store the scopes in a better data strucutre
-    for (const auto& scope : m_scopes) {
+    auto* scopes = scopes_containing(regs.eip);
+    if (!scopes)
+        return variables;
+    auto function_index = index_of_containing_function(*scopes, regs.eip);
+    if (!function_index.has_value())
+        return variables;
+
+    // Everything nested inside the function comes right after it.
+    auto& function = scopes->at(function_index.value());
+    for (size_t i = function_index.value(); i < scopes->size() && scopes->at(i).address_low < function.address_high; ++i) {
+        auto& scope = scopes->at(i);
         if (regs.eip < scope.address_low || regs.eip >= scope.address_high)
             continue;
 
@@ -309,21 +458,22 @@ String DebugInfo::name_of_containing_function(u32 address) const
 
 Optional<DebugInfo::VariablesScope> DebugInfo::get_containing_function(u32 address) const
 {
-    for (const auto& scope : m_scopes) {
-        if (!scope.is_function || address < scope.address_low || address >= scope.address_high)
-            continue;
-        return scope;
-    }
-    return {};
+    auto* scopes = scopes_containing(address);
+    if (!scopes)
+        return {};
+    auto function_index = index_of_containing_function(*scopes, address);
+    if (!function_index.has_value())
+        return {};
+    return scopes->at(function_index.value());
 }
 
 Vector<DebugInfo::SourcePosition> DebugInfo::source_lines_in_scope(const VariablesScope& scope) const
 {
     Vector<DebugInfo::SourcePosition> source_lines;
-    for (const auto& line : m_sorted_lines) {
-        if (line.address < scope.address_low)
-            continue;
-
+    // Start at the first line that isn't below the scope.
+    size_t index = scope.address_low ? first_index_after(m_sorted_lines, scope.address_low - 1, [](auto& line) { return line.address; }) : 0;
+    for (; index < m_sorted_lines.size(); ++index) {
+        auto& line = m_sorted_lines[index];
         if (line.address >= scope.address_high)
             break;
         source_lines.append(SourcePosition::from_line_info(line));
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/Optional.h>
@@ -110,14 +111,37 @@ public:
     Optional<VariablesScope> get_containing_function(u32 address) const;
 
 private:
+    // The scopes of a compilation unit are only parsed once something asks about an address inside it.
+    struct UnitScopes {
+        const Dwarf::CompilationUnit* unit { nullptr };
+        bool is_parsed { false };
+        Vector<VariablesScope> scopes; // Sorted by address_low, enclosing scopes first
+    };
+
+    struct AddressRange {
+        u32 address_low { 0 };
+        u32 address_high { 0 };
+        size_t unit_index { 0 };
+    };
+
+    struct LineAddress {
+        size_t line { 0 };
+        u32 address { 0 };
+    };
+
     void prepare_variable_scopes();
     void prepare_lines();
-    void parse_scopes_impl(const Dwarf::DIE& die);
+    bool append_ranges_of_unit(const Dwarf::CompilationUnit&, size_t unit_index);
+    void parse_scopes_impl(const Dwarf::DIE& die, Vector<VariablesScope>&) const;
+    const Vector<VariablesScope>* scopes_of_unit(size_t unit_index) const;
+    const Vector<VariablesScope>* scopes_containing(u32 address) const;
     OwnPtr<VariableInfo> create_variable_info(const Dwarf::DIE& variable_die, const PtraceRegisters&) const;
 
     NonnullRefPtr<const ELF::Loader> m_elf;
     NonnullRefPtr<Dwarf::DwarfInfo> m_dwarf_info;
 
-    Vector<VariablesScope> m_scopes;
+    mutable Vector<UnitScopes> m_units;
+    Vector<AddressRange> m_unit_ranges;
     Vector<LineProgram::LineInfo> m_sorted_lines;
+    HashMap<String, Vector<LineAddress>> m_lines_by_file; // Sorted by line, then address
 };
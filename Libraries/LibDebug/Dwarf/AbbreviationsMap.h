@@ -47,7 +47,8 @@ public:
         Vector<AttributeSpecification> attribute_specifications;
     };
 
-    Optional<AbbreviationEntry> get(u32 code) const;
+    // The entries live as long as the map, so DIEs can hold on to them instead of looking them up again.
+    const AbbreviationEntry* get(u32 code) const;
 
 private:
     void populate_map();
@@ -45,14 +45,14 @@ DIE::DIE(const CompilationUnit& unit, u32 offset)
         // An abbrevation code of 0 ( = null DIE entry) means the end of a chain of sibilings
         m_tag = EntryTag::None;
     } else {
-        auto abbreviation_info = m_compilation_unit.abbreviations_map().get(m_abbreviation_code);
-        ASSERT(abbreviation_info.has_value());
+        m_abbreviation = m_compilation_unit.abbreviations_map().get(m_abbreviation_code);
+        ASSERT(m_abbreviation);
 
-        m_tag = abbreviation_info.value().tag;
-        m_has_children = abbreviation_info.value().has_children;
+        m_tag = m_abbreviation->tag;
+        m_has_children = m_abbreviation->has_children;
 
         // We iterate the attributes data only to calculate this DIE's size
-        for (auto attribute_spec : abbreviation_info.value().attribute_specifications) {
+        for (auto& attribute_spec : m_abbreviation->attribute_specifications) {
             get_attribute_value(attribute_spec.form, stream);
         }
     }
@@ -78,7 +78,7 @@ DIE::AttributeValue DIE::get_attribute_value(AttributeDataForm form,
         debug_info_stream >> offset;
         value.type = AttributeValue::Type::String;
 
-        auto strings_data = m_compilation_unit.dwarf_info().debug_strings_data();
+        auto& strings_data = m_compilation_unit.dwarf_info().debug_strings_data();
         value.data.as_string = reinterpret_cast<const char*>(strings_data.data() + offset);
         break;
     }
@@ -137,9 +137,12 @@ DIE::AttributeValue DIE::get_attribute_value(AttributeDataForm form,
         break;
     }
     case AttributeDataForm::String: {
-        String str;
+        // The string is used in place, so all we have to do is skip past its null terminator.
         u32 str_offset = debug_info_stream.offset();
-        debug_info_stream >> str;
+        u8 byte = 0;
+        do {
+            debug_info_stream >> byte;
+        } while (byte && !debug_info_stream.has_error());
         value.type = AttributeValue::Type::String;
         value.data.as_string = reinterpret_cast<const char*>(str_offset + m_compilation_unit.dwarf_info().debug_info_data().data());
         break;
@@ -184,10 +187,9 @@ Optional<DIE::AttributeValue> DIE::get_attribute(const Attribute& attribute) con
     InputMemoryStream stream { m_compilation_unit.dwarf_info().debug_info_data() };
     stream.discard_or_error(m_data_offset);
 
-    auto abbreviation_info = m_compilation_unit.abbreviations_map().get(m_abbreviation_code);
-    ASSERT(abbreviation_info.has_value());
+    ASSERT(m_abbreviation);
 
-    for (const auto& attribute_spec : abbreviation_info.value().attribute_specifications) {
+    for (const auto& attribute_spec : m_abbreviation->attribute_specifications) {
         auto value = get_attribute_value(attribute_spec.form, stream);
         if (attribute_spec.attribute == attribute) {
             return value;
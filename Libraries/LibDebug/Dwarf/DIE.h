@@ -87,6 +87,7 @@ private:
     u32 m_offset { 0 };
     u32 m_data_offset { 0 };
     size_t m_abbreviation_code { 0 };
+    const AbbreviationsMap::AbbreviationEntry* m_abbreviation { nullptr };
     EntryTag m_tag { EntryTag::None };
     bool m_has_children { false };
     u32 m_size { 0 };
@@ -43,6 +43,7 @@ public:
     const ByteBuffer& debug_info_data() const { return m_debug_info_data; }
     const ByteBuffer& abbreviation_data() const { return m_abbreviation_data; }
     const ByteBuffer& debug_strings_data() const { return m_debug_strings_data; }
+    const ByteBuffer& debug_ranges_data() const { return m_debug_ranges_data; }
 
     template<typename Callback>
     void for_each_compilation_unit(Callback) const;
@@ -57,6 +58,7 @@ private:
     ByteBuffer m_debug_info_data;
     ByteBuffer m_abbreviation_data;
     ByteBuffer m_debug_strings_data;
+    ByteBuffer m_debug_ranges_data;
 
     Vector<Dwarf::CompilationUnit> m_compilation_units;
 };
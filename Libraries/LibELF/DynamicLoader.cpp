@@ -98,7 +98,8 @@ void* DynamicLoader::symbol_for_name(const char* name)
 {
     auto symbol = m_dynamic_object->hash_section().lookup_symbol(name);
 
-    if (symbol.is_undefined())
+    // A DT_HASH table also lists the symbols this object imports; those aren't ours to hand out.
+    if (symbol.is_undefined() || symbol.section_index() == SHN_UNDEF)
         return nullptr;
 
     return m_dynamic_object->base_address().offset(symbol.value()).as_ptr();
@@ -124,7 +125,8 @@ bool DynamicLoader::load_from_image(unsigned flags)
     munmap(m_file_mapping, m_file_size);
     m_file_mapping = MAP_FAILED;
 
-    m_dynamic_object = AK::make<DynamicObject>(m_text_segment_load_address, m_dynamic_section_address);
+    // Symbol values and DT_* pointers are link-time addresses, so they are offset by the load bias.
+    m_dynamic_object = AK::make<DynamicObject>(VirtualAddress(m_load_bias), m_dynamic_section_address);
 
     return load_stage_2(flags);
 }
@@ -196,21 +198,37 @@ void DynamicLoader::load_program_headers(const Image& elf_image)
 
     // Process regions in order: .text, .data, .tls
     auto* region = text_region_ptr;
-    void* text_segment_begin = mmap_with_name(nullptr, region->required_load_size(), region->mmap_prot(), MAP_PRIVATE, m_image_fd, region->offset(), String::format(".text: %s", m_filename.characters()).characters());
+    String text_segment_name = String::format(".text: %s", m_filename.characters());
+
+    // A prelinked object was linked to run at a particular address. If we get to put it there,
+    // the relocations that only depend on the load address are already applied in the file.
+    // Without MAP_FIXED, we either get exactly the address we asked for or nothing at all.
+    void* text_segment_begin = MAP_FAILED;
+    VirtualAddress text_segment_desired_address = region->desired_load_address().page_base();
+    if (!text_segment_desired_address.is_null())
+        text_segment_begin = mmap_with_name(text_segment_desired_address.as_ptr(), region->required_load_size(), region->mmap_prot(), MAP_PRIVATE, m_image_fd, region->offset(), text_segment_name.characters());
+    if (MAP_FAILED == text_segment_begin)
+        text_segment_begin = mmap_with_name(nullptr, region->required_load_size(), region->mmap_prot(), MAP_PRIVATE, m_image_fd, region->offset(), text_segment_name.characters());
     if (MAP_FAILED == text_segment_begin) {
         ASSERT_NOT_REACHED();
     }
     m_text_segment_size = region->required_load_size();
     m_text_segment_load_address = VirtualAddress { (FlatPtr)text_segment_begin };
+    m_load_bias = m_text_segment_load_address.get() - text_segment_desired_address.get();
 
-    m_dynamic_section_address = dynamic_region_desired_vaddr.offset(m_text_segment_load_address.get());
+#ifdef DYNAMIC_LOAD_DEBUG
+    if (!text_segment_desired_address.is_null())
+        dbgprintf("%s is prelinked at %p, loaded at %p\n", m_filename.characters(), text_segment_desired_address.as_ptr(), text_segment_begin);
+#endif
+
+    m_dynamic_section_address = dynamic_region_desired_vaddr.offset(m_load_bias);
 
     region = data_region_ptr;
     void* data_segment_begin = mmap_with_name((u8*)text_segment_begin + m_text_segment_size, region->required_load_size(), region->mmap_prot(), MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, String::format(".data: %s", m_filename.characters()).characters());
     if (MAP_FAILED == data_segment_begin) {
         ASSERT_NOT_REACHED();
     }
-    VirtualAddress data_segment_actual_addr = region->desired_load_address().offset((FlatPtr)text_segment_begin);
+    VirtualAddress data_segment_actual_addr = region->desired_load_address().offset(m_load_bias);
     memcpy(data_segment_actual_addr.as_ptr(), (u8*)m_file_mapping + region->offset(), region->size_in_image());
 
     // FIXME: Do some kind of 'allocate TLS section' or some such from a per-application pool
@@ -218,7 +236,7 @@ void DynamicLoader::load_program_headers(const Image& elf_image)
         region = tls_region_ptr;
         // FIXME: This can't be right either. TLS needs some real work i'd say :)
         m_tls_segment_address = tls_region_ptr->desired_load_address();
-        VirtualAddress tls_segment_actual_addr = region->desired_load_address().offset((FlatPtr)text_segment_begin);
+        VirtualAddress tls_segment_actual_addr = region->desired_load_address().offset(m_load_bias);
         memcpy(tls_segment_actual_addr.as_ptr(), (u8*)m_file_mapping + region->offset(), region->size_in_image());
     }
 }
@@ -265,6 +283,10 @@ void DynamicLoader::do_relocations()
             break;
         }
         case R_386_RELATIVE: {
+            // A prelinked object loaded where it asked to be already has these applied;
+            // skipping them also keeps its data pages from being dirtied for nothing.
+            if (!load_base_address)
+                break;
             // FIXME: According to the spec, R_386_relative ones must be done first.
             //     We could explicitly do them first using m_number_of_relocatoins from DT_RELCOUNT
             //     However, our compiler is nice enough to put them at the front of the relocations for us :)
@@ -301,6 +323,8 @@ void DynamicLoader::do_relocations()
             // LAZY-ily bind the PLT slots by just adding the base address to the offsets stored there
             // This avoids doing symbol lookup, which might be expensive
             ASSERT(relocation.type() == R_386_JMP_SLOT);
+            if (!load_base_address)
+                return IterationDecision::Continue;
 
             u8* relocation_address = relocation.address().as_ptr();
 
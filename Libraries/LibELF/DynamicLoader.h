@@ -116,6 +116,9 @@ private:
 
     VirtualAddress m_text_segment_load_address;
     size_t m_text_segment_size { 0 };
+    // Difference between where the object was linked to run and where it got loaded.
+    // This is 0 for a prelinked object that got its preferred address.
+    FlatPtr m_load_bias { 0 };
 
     VirtualAddress m_tls_segment_address;
     VirtualAddress m_dynamic_section_address;
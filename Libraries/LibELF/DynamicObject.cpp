@@ -91,6 +91,9 @@ void DynamicObject::parse()
         case DT_HASH:
             m_hash_table_offset = entry.ptr();
             break;
+        case DT_GNU_HASH:
+            m_gnu_hash_table_offset = entry.ptr();
+            break;
         case DT_SYMTAB:
             m_symbol_table_offset = entry.ptr();
             break;
@@ -151,9 +154,7 @@ void DynamicObject::parse()
         return IterationDecision::Continue;
     });
 
-    auto hash_section_address = hash_section().address().as_ptr();
-    auto num_hash_chains = ((u32*)hash_section_address)[1];
-    m_symbol_count = num_hash_chains;
+    m_symbol_count = hash_section().symbol_count();
 }
 
 const DynamicObject::Relocation DynamicObject::RelocationSection::relocation(unsigned index) const
@@ -200,6 +201,10 @@ const DynamicObject::Section DynamicObject::fini_array_section() const
 
 const DynamicObject::HashSection DynamicObject::hash_section() const
 {
+    // Prefer the GNU table when the object has both: its bloom filter rejects most misses
+    // without touching the symbol table, and its chains are shorter.
+    if (m_gnu_hash_table_offset)
+        return HashSection(Section(*this, m_gnu_hash_table_offset, 0, 0, "DT_GNU_HASH"), HashType::GNU);
     return HashSection(Section(*this, m_hash_table_offset, 0, 0, "DT_HASH"), HashType::SYSV);
 }
 
@@ -213,7 +218,7 @@ const DynamicObject::RelocationSection DynamicObject::plt_relocation_section() c
     return RelocationSection(Section(*this, m_plt_relocation_offset_location, m_size_of_plt_relocation_entry_list, m_size_of_relocation_entry, "DT_JMPREL"));
 }
 
-u32 DynamicObject::HashSection::calculate_elf_hash(const char* name) const
+u32 DynamicObject::HashSection::calculate_elf_hash(const char* name)
 {
     // SYSV ELF hash algorithm
     // Note that the GNU HASH algorithm has less collisions
@@ -235,17 +240,62 @@ u32 DynamicObject::HashSection::calculate_elf_hash(const char* name) const
     return hash;
 }
 
-u32 DynamicObject::HashSection::calculate_gnu_hash(const char*) const
+u32 DynamicObject::HashSection::calculate_gnu_hash(const char* name)
+{
+    // GNU ELF hash algorithm (Bernstein's djb2)
+    u32 hash = 5381;
+
+    for (; *name != '\0'; ++name)
+        hash = hash * 33 + (u8)*name;
+
+    return hash;
+}
+
+// The DT_GNU_HASH table starts with this header; the words after it are, in order,
+// the bloom filter (bloom_size words of the ELF class size, so 32-bit here), the buckets and the chains.
+struct GnuHashTableHeader {
+    u32 num_buckets;
+    u32 symbol_offset; // Index of the first symbol that is covered by the table.
+    u32 bloom_size;
+    u32 bloom_shift;
+};
+
+u32 DynamicObject::HashSection::symbol_count() const
 {
-    // FIXME: Implement the GNU hash algorithm
-    ASSERT_NOT_REACHED();
+    u32* hash_table_begin = (u32*)address().as_ptr();
+
+    if (m_hash_type == HashType::SYSV) {
+        // Interestingly, num_chains is required to be num_symbols
+        return hash_table_begin[1];
+    }
+
+    auto& header = *(const GnuHashTableHeader*)hash_table_begin;
+    const u32* buckets = (const u32*)(&header + 1) + header.bloom_size;
+    const u32* chains = &buckets[header.num_buckets];
+
+    // Symbols are sorted by bucket, so the last one belongs to the highest bucket index.
+    u32 highest_symbol_index = 0;
+    for (u32 i = 0; i < header.num_buckets; ++i)
+        highest_symbol_index = max(highest_symbol_index, buckets[i]);
+    if (highest_symbol_index < header.symbol_offset)
+        return header.symbol_offset;
+
+    // The lowest bit of a chain entry marks the end of its chain.
+    while (!(chains[highest_symbol_index - header.symbol_offset] & 1))
+        ++highest_symbol_index;
+    return highest_symbol_index + 1;
 }
 
 const DynamicObject::Symbol DynamicObject::HashSection::lookup_symbol(const char* name) const
 {
-    // FIXME: If we enable gnu hash in the compiler, we should use that here instead
-    //     The algo is way better with less collisions
-    u32 hash_value = (this->*(m_hash_function))(name);
+    if (m_hash_type == HashType::GNU)
+        return lookup_gnu_symbol(name);
+    return lookup_elf_symbol(name);
+}
+
+const DynamicObject::Symbol DynamicObject::HashSection::lookup_elf_symbol(const char* name) const
+{
+    u32 hash_value = calculate_elf_hash(name);
 
     u32* hash_table_begin = (u32*)address().as_ptr();
 
@@ -271,6 +321,50 @@ const DynamicObject::Symbol DynamicObject::HashSection::lookup_symbol(const char
     return m_dynamic.the_undefined_symbol();
 }
 
+const DynamicObject::Symbol DynamicObject::HashSection::lookup_gnu_symbol(const char* name) const
+{
+    constexpr u32 bloom_word_bits = sizeof(Elf32_Addr) * 8;
+
+    auto& header = *(const GnuHashTableHeader*)address().as_ptr();
+    if (!header.num_buckets || !header.bloom_size)
+        return m_dynamic.the_undefined_symbol();
+
+    const Elf32_Addr* bloom = (const Elf32_Addr*)(&header + 1);
+    const u32* buckets = bloom + header.bloom_size;
+    const u32* chains = &buckets[header.num_buckets];
+
+    u32 hash_value = calculate_gnu_hash(name);
+
+    // Each name sets two bits in one bloom word; if either is clear, the name is not in here.
+    Elf32_Addr bloom_word = bloom[(hash_value / bloom_word_bits) % header.bloom_size];
+    Elf32_Addr bloom_mask = (1u << (hash_value % bloom_word_bits))
+        | (1u << ((hash_value >> header.bloom_shift) % bloom_word_bits));
+    if ((bloom_word & bloom_mask) != bloom_mask)
+        return m_dynamic.the_undefined_symbol();
+
+    u32 symbol_index = buckets[hash_value % header.num_buckets];
+    if (symbol_index < header.symbol_offset)
+        return m_dynamic.the_undefined_symbol();
+
+    // A chain holds the hashes of the symbols of one bucket, with the lowest bit
+    // repurposed to mark its last entry. Only compare names when the hashes match.
+    for (;; ++symbol_index) {
+        u32 chain_hash = chains[symbol_index - header.symbol_offset];
+        if ((hash_value | 1) == (chain_hash | 1)) {
+            auto symbol = m_dynamic.symbol(symbol_index);
+            if (strcmp(name, symbol.name()) == 0) {
+#ifdef DYNAMIC_LOAD_DEBUG
+                dbgprintf("Returning dynamic symbol with index %d for %s: %p\n", symbol_index, symbol.name(), symbol.address());
+#endif
+                return symbol;
+            }
+        }
+        if (chain_hash & 1)
+            break;
+    }
+    return m_dynamic.the_undefined_symbol();
+}
+
 const char* DynamicObject::symbol_string_table_string(Elf32_Word index) const
 {
     return (const char*)base_address().offset(m_string_table_offset + index).as_ptr();
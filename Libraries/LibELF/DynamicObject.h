@@ -80,7 +80,8 @@ public:
         unsigned index() const { return m_index; }
         unsigned type() const { return ELF32_ST_TYPE(m_sym.st_info); }
         unsigned bind() const { return ELF32_ST_BIND(m_sym.st_info); }
-        bool is_undefined() const { return this == &m_dynamic.the_undefined_symbol(); }
+        // Symbol 0 is reserved as the undefined symbol (STN_UNDEF).
+        bool is_undefined() const { return m_index == 0; }
         VirtualAddress address() const { return m_dynamic.base_address().offset(value()); }
 
     private:
@@ -164,28 +165,26 @@ public:
     public:
         HashSection(const Section& section, HashType hash_type = HashType::SYSV)
             : Section(section.m_dynamic, section.m_section_offset, section.m_section_size_bytes, section.m_entry_size, section.m_name)
+            , m_hash_type(hash_type)
         {
-            switch (hash_type) {
-            case HashType::SYSV:
-                m_hash_function = &HashSection::calculate_elf_hash;
-                break;
-            case HashType::GNU:
-                m_hash_function = &HashSection::calculate_gnu_hash;
-                break;
-            default:
-                ASSERT_NOT_REACHED();
-                break;
-            }
         }
 
+        HashType hash_type() const { return m_hash_type; }
+
         const Symbol lookup_symbol(const char*) const;
 
+        // The number of entries in the symbol table. DT_HASH records it, but for DT_GNU_HASH
+        // it has to be found by walking to the end of the last chain.
+        u32 symbol_count() const;
+
+        static u32 calculate_elf_hash(const char* name);
+        static u32 calculate_gnu_hash(const char* name);
+
     private:
-        u32 calculate_elf_hash(const char* name) const;
-        u32 calculate_gnu_hash(const char* name) const;
+        const Symbol lookup_elf_symbol(const char*) const;
+        const Symbol lookup_gnu_symbol(const char*) const;
 
-        typedef u32 (HashSection::*HashFunction)(const char*) const;
-        HashFunction m_hash_function;
+        HashType m_hash_type;
     };
 
     unsigned symbol_count() const { return m_symbol_count; }
@@ -227,7 +226,8 @@ private:
 
     VirtualAddress m_base_address;
     VirtualAddress m_dynamic_address;
-    Symbol m_the_undefined_symbol { *this, 0, {} };
+    Elf32_Sym m_the_undefined_elf_symbol {};
+    Symbol m_the_undefined_symbol { *this, 0, m_the_undefined_elf_symbol };
 
     unsigned m_symbol_count { 0 };
 
@@ -241,6 +241,7 @@ private:
     size_t m_fini_array_size { 0 };
 
     FlatPtr m_hash_table_offset { 0 };
+    FlatPtr m_gnu_hash_table_offset { 0 };
 
     FlatPtr m_string_table_offset { 0 };
     size_t m_size_of_string_table { 0 };
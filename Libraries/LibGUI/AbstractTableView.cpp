@@ -57,14 +57,25 @@ void AbstractTableView::select_all()
     }
 }
 
+// Measuring every cell of a big model takes ages, so columns are sized to fit an even sample of
+// this many rows (plus whatever is on screen) instead.
+static constexpr int max_rows_to_measure = 1000;
+
 void AbstractTableView::update_column_sizes()
 {
     if (!model())
         return;
+    update_column_sizes_for_rows(0, model()->row_count() - 1);
+}
 
+void AbstractTableView::update_column_sizes_for_rows(int first_row, int last_row)
+{
     auto& model = *this->model();
     int column_count = model.column_count();
-    int row_count = model.row_count();
+    int row_count = last_row - first_row + 1;
+    int step = max(1, row_count / max_rows_to_measure);
+    int first_visible_row = this->first_visible_row();
+    int last_visible_row = this->last_visible_row();
 
     for (int column = 0; column < column_count; ++column) {
         if (is_column_hidden(column))
@@ -73,7 +84,7 @@ void AbstractTableView::update_column_sizes()
         if (column == m_key_column && model.is_column_sortable(column))
             header_width += font().width(" \xE2\xAC\x86"); // UPWARDS BLACK ARROW
         int column_width = header_width;
-        for (int row = 0; row < row_count; ++row) {
+        auto measure_row = [&](int row) {
             auto cell_data = model.index(row, column).data();
             int cell_width = 0;
             if (cell_data.is_icon()) {
@@ -84,6 +95,13 @@ void AbstractTableView::update_column_sizes()
                 cell_width = font().width(cell_data.to_string());
             }
             column_width = max(column_width, cell_width);
+        };
+        for (int row = first_row; row <= last_row; row += step)
+            measure_row(row);
+        if (step > 1) {
+            measure_row(last_row);
+            for (int row = max(first_row, first_visible_row); row <= min(last_row, last_visible_row); ++row)
+                measure_row(row);
         }
         auto& column_data = this->column_data(column);
         column_data.width = max(column_data.width, column_width);
@@ -91,6 +109,17 @@ void AbstractTableView::update_column_sizes()
     }
 }
 
+int AbstractTableView::first_visible_row() const
+{
+    return max(0, (vertical_scrollbar().value() - header_height()) / item_height());
+}
+
+int AbstractTableView::last_visible_row() const
+{
+    int row_count = model() ? model()->row_count() : 0;
+    return min(row_count - 1, (vertical_scrollbar().value() + frame_inner_rect().height() - header_height()) / item_height());
+}
+
 void AbstractTableView::update_content_size()
 {
     if (!model())
@@ -390,18 +419,19 @@ ModelIndex AbstractTableView::index_at_event_position(const Gfx::IntPoint& posit
     if (!model())
         return {};
 
+    // Rows are all the same height, so the row under the position can be worked out directly.
     auto adjusted_position = this->adjusted_position(position);
-    for (int row = 0, row_count = model()->row_count(); row < row_count; ++row) {
-        if (!row_rect(row).contains(adjusted_position))
+    if (adjusted_position.y() < header_height())
+        return {};
+    int row = (adjusted_position.y() - header_height()) / item_height();
+    if (row >= model()->row_count() || !row_rect(row).contains(adjusted_position))
+        return {};
+    for (int column = 0, column_count = model()->column_count(); column < column_count; ++column) {
+        if (!content_rect(row, column).contains(adjusted_position))
             continue;
-        for (int column = 0, column_count = model()->column_count(); column < column_count; ++column) {
-            if (!content_rect(row, column).contains(adjusted_position))
-                continue;
-            return model()->index(row, column);
-        }
-        return model()->index(row, 0);
+        return model()->index(row, column);
     }
-    return {};
+    return model()->index(row, 0);
 }
 
 ModelIndex AbstractTableView::index_at_event_position(const Gfx::IntPoint& position) const
@@ -520,4 +550,15 @@ void AbstractTableView::did_update_model(unsigned flags)
     update();
 }
 
+void AbstractTableView::did_update_rows(int first_row, int last_row)
+{
+    if (!model())
+        return;
+    // Everything else is still in place, so there's no need to drop the selection or re-measure other rows.
+    m_hovered_index = {};
+    update_column_sizes_for_rows(first_row, min(last_row, model()->row_count() - 1));
+    update_content_size();
+    update();
+}
+
 }
@@ -76,6 +76,7 @@ protected:
     AbstractTableView();
 
     virtual void did_update_model(unsigned flags) override;
+    virtual void did_update_rows(int first_row, int last_row) override;
     virtual void mouseup_event(MouseEvent&) override;
     virtual void mousedown_event(MouseEvent&) override;
     virtual void mousemove_event(MouseEvent&) override;
@@ -110,6 +111,9 @@ protected:
     int column_width(int) const;
     void update_content_size();
     virtual void update_column_sizes();
+    void update_column_sizes_for_rows(int first_row, int last_row);
+    int first_visible_row() const;
+    int last_visible_row() const;
     virtual int item_count() const;
 
 private:
@@ -72,6 +72,11 @@ void AbstractView::did_update_model(unsigned flags)
     }
 }
 
+void AbstractView::did_update_rows(int, int)
+{
+    did_update_model(GUI::Model::DontInvalidateIndexes);
+}
+
 void AbstractView::clear_selection()
 {
     m_selection.clear();
@@ -52,6 +52,7 @@ public:
 
     virtual bool accepts_focus() const override { return true; }
     virtual void did_update_model(unsigned flags);
+    virtual void did_update_rows(int first_row, int last_row);
     virtual void did_update_selection();
 
     virtual Gfx::IntRect content_rect(const ModelIndex&) const { return {}; }
@@ -25,7 +25,6 @@
  */
 
 #include <AK/Badge.h>
-#include <AK/SharedBuffer.h>
 #include <Clipboard/ClipboardClientEndpoint.h>
 #include <Clipboard/ClipboardServerEndpoint.h>
 #include <LibGUI/Clipboard.h>
@@ -79,37 +78,17 @@ Clipboard::Clipboard()
 Clipboard::DataAndType Clipboard::data_and_type() const
 {
     auto response = connection().send_sync<Messages::ClipboardServer::GetClipboardData>();
-    if (response->shbuf_id() < 0)
+    if (response->mime_type().is_null())
         return {};
-    auto shared_buffer = SharedBuffer::create_from_shbuf_id(response->shbuf_id());
-    if (!shared_buffer) {
-        dbgprintf("GUI::Clipboard::data() failed to attach to the shared buffer\n");
-        return {};
-    }
-    if (response->data_size() > shared_buffer->size()) {
-        dbgprintf("GUI::Clipboard::data() clipping contents size is greater than shared buffer size\n");
-        return {};
-    }
-    auto data = String((const char*)shared_buffer->data(), response->data_size());
+    auto data = String((const char*)response->data().data(), response->data().size());
     auto type = response->mime_type();
     return { data, type };
 }
 
 void Clipboard::set_data(const StringView& data, const String& type)
 {
-    auto shared_buffer = SharedBuffer::create_with_size(data.length() + 1);
-    if (!shared_buffer) {
-        dbgprintf("GUI::Clipboard::set_data() failed to create a shared buffer\n");
-        return;
-    }
-    if (!data.is_empty())
-        memcpy(shared_buffer->data(), data.characters_without_null_termination(), data.length() + 1);
-    else
-        ((u8*)shared_buffer->data())[0] = '\0';
-    shared_buffer->seal();
-    shared_buffer->share_with(connection().server_pid());
-
-    connection().send_sync<Messages::ClipboardServer::SetClipboardData>(shared_buffer->shbuf_id(), data.length(), type);
+    IPC::LargeBuffer buffer(ReadonlyBytes { (const u8*)data.characters_without_null_termination(), data.length() });
+    connection().send_sync<Messages::ClipboardServer::SetClipboardData>(buffer, type);
 }
 
 void ClipboardServerConnection::handle(const Messages::ClipboardClient::ClipboardDataChanged& message)
@@ -25,6 +25,7 @@
  */
 
 #include <AK/LexicalPath.h>
+#include <AK/MappedFile.h>
 #include <AK/QuickSort.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/DirIterator.h>
@@ -34,8 +35,10 @@
 #include <LibGUI/FileSystemModel.h>
 #include <LibGUI/Painter.h>
 #include <LibGfx/Bitmap.h>
+#include <LibGfx/JPGLoader.h>
 #include <LibThread/BackgroundAction.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <grp.h>
 #include <pwd.h>
 #include <stdio.h>
@@ -55,34 +58,56 @@ ModelIndex FileSystemModel::Node::index(int column) const
     ASSERT_NOT_REACHED();
 }
 
-bool FileSystemModel::Node::fetch_data(const String& full_path, bool is_root)
+FileSystemModel::Node::~Node()
+{
+    m_model.m_loading_nodes.remove(this);
+    close(m_watch_fd);
+}
+
+// This may run on a worker thread, so it only fills in what it is given.
+static int stat_entry(const String& full_path, bool is_root, struct stat& st, String& symlink_target)
 {
-    struct stat st;
     int rc;
     if (is_root)
         rc = stat(full_path.characters(), &st);
     else
         rc = lstat(full_path.characters(), &st);
     if (rc < 0) {
-        m_error = errno;
+        int error = errno;
         perror("stat/lstat");
+        return error;
+    }
+
+    if (S_ISLNK(st.st_mode)) {
+        symlink_target = Core::File::read_link(full_path);
+        if (symlink_target.is_null())
+            perror("readlink");
+    }
+    return 0;
+}
+
+bool FileSystemModel::Node::fetch_data(const String& full_path, bool is_root)
+{
+    struct stat st;
+    String symlink_target;
+    int error = stat_entry(full_path, is_root, st, symlink_target);
+    if (error) {
+        m_error = error;
         return false;
     }
+    set_data(st, move(symlink_target));
+    return true;
+}
 
+void FileSystemModel::Node::set_data(const struct stat& st, String symlink_target)
+{
     size = st.st_size;
     mode = st.st_mode;
     uid = st.st_uid;
     gid = st.st_gid;
     inode = st.st_ino;
     mtime = st.st_mtime;
-
-    if (S_ISLNK(mode)) {
-        symlink_target = Core::File::read_link(full_path);
-        if (symlink_target.is_null())
-            perror("readlink");
-    }
-
-    return true;
+    this->symlink_target = move(symlink_target);
 }
 
 void FileSystemModel::Node::traverse_if_needed()
@@ -92,37 +117,16 @@ void FileSystemModel::Node::traverse_if_needed()
     has_traversed = true;
     total_size = 0;
 
-    auto full_path = this->full_path();
-    Core::DirIterator di(full_path, m_model.should_show_dotfiles() ? Core::DirIterator::SkipParentAndBaseDir : Core::DirIterator::SkipDots);
-    if (di.has_error()) {
-        m_error = di.error();
-        fprintf(stderr, "DirIterator: %s\n", di.error_string());
-        return;
-    }
-
-    Vector<String> child_names;
-    while (di.has_next()) {
-        child_names.append(di.next_path());
-    }
-    quick_sort(child_names);
-
-    for (auto& name : child_names) {
-        String child_path = String::format("%s/%s", full_path.characters(), name.characters());
-        auto child = adopt_own(*new Node(m_model));
-        bool ok = child->fetch_data(child_path, false);
-        if (!ok)
-            continue;
-        if (m_model.m_mode == DirectoriesOnly && !S_ISDIR(child->mode))
-            continue;
-        child->name = name;
-        child->parent = this;
-        total_size += child->size;
-        children.append(move(child));
-    }
+    m_model.start_loading_children(*this);
+    watch_if_needed();
+}
 
+void FileSystemModel::Node::watch_if_needed()
+{
     if (m_watch_fd >= 0)
         return;
 
+    auto full_path = this->full_path();
     m_watch_fd = watch_file(full_path.characters(), full_path.length());
     if (m_watch_fd < 0) {
         perror("watch_file");
@@ -136,14 +140,199 @@ void FileSystemModel::Node::traverse_if_needed()
         int rc = read(m_notifier->fd(), buffer, sizeof(buffer));
         ASSERT(rc >= 0);
 
-        has_traversed = false;
-        mode = 0;
-        children.clear();
-        reify_if_needed();
-        m_model.did_update();
+        // We aren't told what changed, so list the directory again and only apply the difference.
+        // That way, nodes that didn't change (and everything below them) stay as they are.
+        fetch_data(this->full_path(), parent == nullptr);
+        if (is_directory())
+            m_model.start_loading_children(*this);
+        else
+            m_model.did_update();
     };
 }
 
+// How many entries are stat'ed in one go before they are handed to the model.
+static constexpr size_t entries_per_batch = 64;
+
+struct FileSystemModel::DirectoryListing {
+    Vector<String> names;
+    int error { 0 };
+};
+
+struct FileSystemModel::EntryData {
+    String name;
+    struct stat st;
+    String symlink_target;
+};
+
+FileSystemModel::DirectoryListing FileSystemModel::list_directory(const String& path, bool should_show_dotfiles)
+{
+    DirectoryListing listing;
+    Core::DirIterator di(path, should_show_dotfiles ? Core::DirIterator::SkipParentAndBaseDir : Core::DirIterator::SkipDots);
+    if (di.has_error()) {
+        listing.error = di.error();
+        fprintf(stderr, "DirIterator: %s\n", di.error_string());
+        return listing;
+    }
+    while (di.has_next())
+        listing.names.append(di.next_path());
+    quick_sort(listing.names);
+    return listing;
+}
+
+Vector<FileSystemModel::EntryData> FileSystemModel::stat_entries(const String& directory_path, const Vector<String>& names)
+{
+    Vector<EntryData> entries;
+    entries.ensure_capacity(names.size());
+    for (auto& name : names) {
+        EntryData entry;
+        entry.name = name;
+        if (stat_entry(String::format("%s/%s", directory_path.characters(), name.characters()), false, entry.st, entry.symlink_target))
+            continue;
+        entries.append(move(entry));
+    }
+    return entries;
+}
+
+bool FileSystemModel::is_current_load(const Node& node, u32 token) const
+{
+    auto it = m_loading_nodes.find(&node);
+    return it != m_loading_nodes.end() && it->value == token;
+}
+
+void FileSystemModel::start_loading_children(Node& node)
+{
+    u32 token = ++m_last_load_token;
+    m_loading_nodes.set(&node, token);
+
+    auto path = node.full_path();
+    bool should_show_dotfiles = m_should_show_dotfiles;
+    auto weak_this = make_weak_ptr();
+    auto* node_ptr = &node;
+
+    LibThread::BackgroundAction<DirectoryListing>::create(
+        [path, should_show_dotfiles] {
+            return list_directory(path, should_show_dotfiles);
+        },
+        [this, weak_this, node_ptr, token](auto listing) {
+            if (weak_this.is_null() || !is_current_load(*node_ptr, token))
+                return;
+            did_list_children(*node_ptr, move(listing));
+            load_next_batch(*node_ptr, token);
+        });
+}
+
+void FileSystemModel::did_list_children(Node& node, DirectoryListing&& listing)
+{
+    node.m_error = listing.error;
+    node.m_pending_child_names.clear();
+    node.m_next_pending_child_name = 0;
+
+    HashTable<String> listed_names;
+    for (auto& name : listing.names)
+        listed_names.set(name);
+
+    HashTable<String> existing_names;
+    bool removed_any = false;
+    for (size_t i = node.children.size(); i > 0; --i) {
+        auto& child = node.children[i - 1];
+        if (listed_names.contains(child.name)) {
+            existing_names.set(child.name);
+            continue;
+        }
+        node.total_size -= child.size;
+        node.children.remove(i - 1);
+        removed_any = true;
+    }
+
+    for (auto& name : listing.names) {
+        if (!existing_names.contains(name))
+            node.m_pending_child_names.append(name);
+    }
+
+    if (removed_any)
+        did_update();
+}
+
+void FileSystemModel::load_next_batch(Node& node, u32 token)
+{
+    if (node.m_next_pending_child_name >= node.m_pending_child_names.size()) {
+        finish_loading_children(node);
+        return;
+    }
+
+    size_t batch_size = min(entries_per_batch, node.m_pending_child_names.size() - node.m_next_pending_child_name);
+    Vector<String> names;
+    names.ensure_capacity(batch_size);
+    for (size_t i = 0; i < batch_size; ++i)
+        names.append(node.m_pending_child_names[node.m_next_pending_child_name + i]);
+    node.m_next_pending_child_name += batch_size;
+
+    auto path = node.full_path();
+    auto weak_this = make_weak_ptr();
+    auto* node_ptr = &node;
+
+    LibThread::BackgroundAction<Vector<EntryData>>::create(
+        [path, names = move(names)] {
+            return stat_entries(path, names);
+        },
+        [this, weak_this, node_ptr, token](auto entries) {
+            if (weak_this.is_null() || !is_current_load(*node_ptr, token))
+                return;
+            did_load_entries(*node_ptr, move(entries));
+            load_next_batch(*node_ptr, token);
+        });
+}
+
+void FileSystemModel::did_load_entries(Node& node, Vector<EntryData>&& entries)
+{
+    size_t old_child_count = node.children.size();
+    for (auto& entry : entries) {
+        if (m_mode == DirectoriesOnly && !S_ISDIR(entry.st.st_mode))
+            continue;
+        auto child = adopt_own(*new Node(*this));
+        child->set_data(entry.st, move(entry.symlink_target));
+        child->name = move(entry.name);
+        child->parent = &node;
+        node.total_size += child->size;
+        node.children.append(move(child));
+    }
+
+    if (node.children.size() == old_child_count)
+        return;
+
+    // New children only ever go to the end, so everything that's already there keeps its index.
+    if (&node == m_root.ptr())
+        did_update_rows(old_child_count, node.children.size() - 1);
+    else
+        did_update(DontInvalidateIndexes);
+}
+
+void FileSystemModel::finish_loading_children(Node& node)
+{
+    m_loading_nodes.remove(&node);
+    node.m_pending_child_names.clear();
+    node.m_next_pending_child_name = 0;
+}
+
+// Looking up a node by path has to give an answer right away, so this does the whole load on the spot.
+void FileSystemModel::load_children_synchronously(Node& node)
+{
+    if (!node.is_directory() || (node.has_traversed && !is_loading_children(node)))
+        return;
+    node.has_traversed = true;
+    // Whatever a load that is already underway would come up with, we're about to find out ourselves.
+    m_loading_nodes.remove(&node);
+
+    auto path = node.full_path();
+    did_list_children(node, list_directory(path, m_should_show_dotfiles));
+    Vector<String> names;
+    for (size_t i = node.m_next_pending_child_name; i < node.m_pending_child_names.size(); ++i)
+        names.append(node.m_pending_child_names[i]);
+    did_load_entries(node, stat_entries(path, names));
+    finish_loading_children(node);
+    node.watch_if_needed();
+}
+
 void FileSystemModel::Node::reify_if_needed()
 {
     traverse_if_needed();
@@ -178,6 +367,7 @@ ModelIndex FileSystemModel::index(const StringView& path, int column) const
     for (size_t i = 0; i < lexical_path.parts().size(); ++i) {
         auto& part = lexical_path.parts()[i];
         bool found = false;
+        const_cast<FileSystemModel*>(this)->load_children_synchronously(const_cast<Node&>(*node));
         for (auto& child : node->children) {
             if (child.name == part) {
                 const_cast<Node&>(child).reify_if_needed();
@@ -468,20 +658,115 @@ Icon FileSystemModel::icon_for(const Node& node) const
 
 static HashMap<String, RefPtr<Gfx::Bitmap>> s_thumbnail_cache;
 
-static RefPtr<Gfx::Bitmap> render_thumbnail(const StringView& path)
+static constexpr int thumbnail_size = 32;
+
+// Rendered thumbnails are also kept in ~/.cache/thumbnails, so that they don't have to be rendered
+// again on every visit. They're stored as raw pixels, along with the path, size and modification
+// time of the image they were made from, and can be used without decoding anything.
+static String s_thumbnail_cache_directory;
+
+static constexpr u32 thumbnail_magic = 0x4d4e4854; // "THNM"
+
+struct [[gnu::packed]] ThumbnailHeader {
+    u32 magic;
+    u32 format;
+    i64 mtime;
+    u64 size;
+    u32 path_length;
+};
+
+static void ensure_thumbnail_cache_directory()
+{
+    if (!s_thumbnail_cache_directory.is_null())
+        return;
+    auto cache_directory = String::format("%s/.cache", Core::StandardPaths::home_directory().characters());
+    mkdir(cache_directory.characters(), 0700);
+    s_thumbnail_cache_directory = String::format("%s/thumbnails", cache_directory.characters());
+    mkdir(s_thumbnail_cache_directory.characters(), 0700);
+}
+
+static String thumbnail_cache_path_for(const String& path)
+{
+    return String::format("%s/%08x", s_thumbnail_cache_directory.characters(), string_hash(path.characters(), path.length()));
+}
+
+static RefPtr<Gfx::Bitmap> load_cached_thumbnail(const String& cache_path, const String& path, time_t mtime, size_t size)
+{
+    MappedFile file(cache_path);
+    if (!file.is_valid() || file.size() < sizeof(ThumbnailHeader))
+        return nullptr;
+
+    // Different paths may end up in the same file, which is only a problem if we don't notice.
+    auto& header = *(const ThumbnailHeader*)file.data();
+    auto pixels_size = thumbnail_size * thumbnail_size * sizeof(Gfx::RGBA32);
+    if (header.magic != thumbnail_magic || header.mtime != mtime || header.size != size || header.path_length != path.length())
+        return nullptr;
+    if (file.size() != sizeof(ThumbnailHeader) + header.path_length + pixels_size)
+        return nullptr;
+    auto* stored_path = (const char*)file.data() + sizeof(ThumbnailHeader);
+    if (memcmp(stored_path, path.characters(), path.length()))
+        return nullptr;
+
+    auto format = (Gfx::BitmapFormat)header.format;
+    if (format != Gfx::BitmapFormat::RGB32 && format != Gfx::BitmapFormat::RGBA32)
+        return nullptr;
+    auto thumbnail = Gfx::Bitmap::create(format, { thumbnail_size, thumbnail_size });
+    if (!thumbnail)
+        return nullptr;
+    auto* pixels = (const Gfx::RGBA32*)(stored_path + header.path_length);
+    for (int y = 0; y < thumbnail_size; ++y)
+        memcpy(thumbnail->scanline(y), pixels + y * thumbnail_size, thumbnail_size * sizeof(Gfx::RGBA32));
+    return thumbnail;
+}
+
+static void store_cached_thumbnail(const String& cache_path, const String& path, time_t mtime, size_t size, const Gfx::Bitmap& thumbnail)
+{
+    ASSERT(thumbnail.size() == Gfx::IntSize(thumbnail_size, thumbnail_size));
+
+    // Write to a temporary file first, so nobody ever sees a partial thumbnail.
+    auto temporary_path = String::format("%s.%d", cache_path.characters(), getpid());
+    int fd = open(temporary_path.characters(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        return;
+
+    ThumbnailHeader header { thumbnail_magic, (u32)thumbnail.format(), mtime, size, (u32)path.length() };
+    bool success = write(fd, &header, sizeof(header)) == sizeof(header)
+        && write(fd, path.characters(), path.length()) == (ssize_t)path.length();
+    for (int y = 0; success && y < thumbnail_size; ++y)
+        success = write(fd, thumbnail.scanline(y), thumbnail_size * sizeof(Gfx::RGBA32)) == thumbnail_size * sizeof(Gfx::RGBA32);
+    close(fd);
+
+    if (!success || rename(temporary_path.characters(), cache_path.characters()) < 0)
+        unlink(temporary_path.characters());
+}
+
+static RefPtr<Gfx::Bitmap> load_image_for_thumbnail(const String& path)
+{
+    // JPEGs can be decoded at an eighth of their size for much less, which is still
+    // enough for a thumbnail unless the image is tiny to begin with.
+    auto lowercase_path = path.to_lowercase();
+    if (lowercase_path.ends_with(".jpg") || lowercase_path.ends_with(".jpeg")) {
+        auto bitmap = Gfx::load_jpg_at_eighth_size(path);
+        if (bitmap && (bitmap->width() >= thumbnail_size || bitmap->height() >= thumbnail_size))
+            return bitmap;
+    }
+    return Gfx::Bitmap::load_from_file(path);
+}
+
+static RefPtr<Gfx::Bitmap> render_thumbnail(const String& path)
 {
-    auto png_bitmap = Gfx::Bitmap::load_from_file(path);
-    if (!png_bitmap)
+    auto bitmap = load_image_for_thumbnail(path);
+    if (!bitmap)
         return nullptr;
 
-    double scale = min(32 / (double)png_bitmap->width(), 32 / (double)png_bitmap->height());
+    double scale = min(thumbnail_size / (double)bitmap->width(), thumbnail_size / (double)bitmap->height());
 
-    auto thumbnail = Gfx::Bitmap::create(png_bitmap->format(), { 32, 32 });
-    Gfx::IntRect destination = Gfx::IntRect(0, 0, (int)(png_bitmap->width() * scale), (int)(png_bitmap->height() * scale));
+    auto thumbnail = Gfx::Bitmap::create(bitmap->format(), { thumbnail_size, thumbnail_size });
+    Gfx::IntRect destination = Gfx::IntRect(0, 0, (int)(bitmap->width() * scale), (int)(bitmap->height() * scale));
     destination.center_within(thumbnail->rect());
 
     Painter painter(*thumbnail);
-    painter.draw_scaled_bitmap(destination, *png_bitmap, png_bitmap->rect());
+    painter.draw_scaled_bitmap(destination, *bitmap, bitmap->rect(), 1.0f, Gfx::ScalingMode::BilinearBlend);
     return thumbnail;
 }
 
@@ -504,11 +789,17 @@ bool FileSystemModel::fetch_thumbnail_for(const Node& node)
     s_thumbnail_cache.set(path, nullptr);
     m_thumbnail_progress_total++;
 
+    ensure_thumbnail_cache_directory();
     auto weak_this = make_weak_ptr();
 
     LibThread::BackgroundAction<RefPtr<Gfx::Bitmap>>::create(
-        [path] {
-            return render_thumbnail(path);
+        [path, cache_path = thumbnail_cache_path_for(path), mtime = node.mtime, size = node.size] {
+            if (auto thumbnail = load_cached_thumbnail(cache_path, path, mtime, size))
+                return thumbnail;
+            auto thumbnail = render_thumbnail(path);
+            if (thumbnail)
+                store_cached_thumbnail(cache_path, path, mtime, size, *thumbnail);
+            return thumbnail;
         },
 
         [this, path, weak_this](auto thumbnail) {
@@ -63,7 +63,7 @@ public:
     };
 
     struct Node {
-        ~Node() { close(m_watch_fd); }
+        ~Node();
 
         String name;
         String symlink_target;
@@ -110,10 +110,16 @@ public:
 
         int m_error { 0 };
 
+        // Names that were listed but whose children haven't been stat'ed yet.
+        Vector<String> m_pending_child_names;
+        size_t m_next_pending_child_name { 0 };
+
         ModelIndex index(int column) const;
         void traverse_if_needed();
         void reify_if_needed();
+        void watch_if_needed();
         bool fetch_data(const String& full_path, bool is_root);
+        void set_data(const struct stat&, String symlink_target);
     };
 
     static NonnullRefPtr<FileSystemModel> create(const StringView& root_path = "/", Mode mode = Mode::FilesAndDirectories)
@@ -168,8 +174,29 @@ private:
     bool fetch_thumbnail_for(const Node& node);
     GUI::Icon icon_for(const Node& node) const;
 
+    struct DirectoryListing;
+    struct EntryData;
+    static DirectoryListing list_directory(const String& path, bool should_show_dotfiles);
+    static Vector<EntryData> stat_entries(const String& directory_path, const Vector<String>& names);
+
+    // Directories are listed and their entries stat'ed on a worker thread, and the children show
+    // up in batches. Every load of a node gets a new token, so results of an older one are dropped.
+    void start_loading_children(Node&);
+    void load_children_synchronously(Node&);
+    void did_list_children(Node&, DirectoryListing&&);
+    void load_next_batch(Node&, u32 token);
+    void did_load_entries(Node&, Vector<EntryData>&&);
+    void finish_loading_children(Node&);
+    bool is_current_load(const Node&, u32 token) const;
+    bool is_loading_children(const Node& node) const { return m_loading_nodes.contains(&node); }
+
     String m_root_path;
     Mode m_mode { Invalid };
+
+    // Declared before m_root, since nodes take themselves out of it when they are destroyed.
+    HashMap<const Node*, u32> m_loading_nodes;
+    u32 m_last_load_token { 0 };
+
     OwnPtr<Node> m_root { nullptr };
 
     unsigned m_thumbnail_progress { 0 };
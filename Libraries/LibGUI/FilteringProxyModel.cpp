@@ -68,9 +68,19 @@ void FilteringProxyModel::update()
 {
     m_model.update();
     filter();
+    m_has_filtered = true;
     did_update();
 }
 
+bool FilteringProxyModel::matches(const ModelIndex& index) const
+{
+    auto filter_matches = m_model.data_matches(index, m_filter_term);
+    if (filter_matches != TriState::Unknown)
+        return filter_matches == TriState::True;
+    auto data = index.data();
+    return data.is_string() && data.as_string().contains(m_filter_term);
+}
+
 void FilteringProxyModel::filter()
 {
     m_matching_indices.clear();
@@ -81,14 +91,7 @@ void FilteringProxyModel::filter()
             if (!index.is_valid())
                 continue;
 
-            auto filter_matches = m_model.data_matches(index, m_filter_term);
-            bool matches = filter_matches == TriState::True;
-            if (filter_matches == TriState::Unknown) {
-                auto data = index.data();
-                if (data.is_string() && data.as_string().contains(m_filter_term))
-                    matches = true;
-            }
-            if (matches)
+            if (matches(index))
                 m_matching_indices.append(index);
 
             add_matching(index);
@@ -103,6 +106,18 @@ void FilteringProxyModel::set_filter_term(const StringView& term)
 {
     if (m_filter_term == term)
         return;
+
+    // Whatever contains the new term also contains the old one, so only the current matches
+    // need to be looked at again (which is the common case of typing into a search box).
+    if (m_has_filtered && !m_filter_term.is_empty() && term.contains(m_filter_term)) {
+        m_filter_term = term;
+        m_matching_indices.remove_all_matching([&](auto& index) {
+            return !matches(index);
+        });
+        did_update();
+        return;
+    }
+
     m_filter_term = term;
     update();
 }
@@ -55,6 +55,7 @@ public:
 
 private:
     void filter();
+    bool matches(const ModelIndex&) const;
     explicit FilteringProxyModel(Model& model)
         : m_model(model)
     {
@@ -66,6 +67,7 @@ private:
     Vector<ModelIndex> m_matching_indices;
 
     String m_filter_term;
+    bool m_has_filtered { false };
 };
 
 }
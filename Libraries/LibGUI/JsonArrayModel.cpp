@@ -71,7 +71,7 @@ bool JsonArrayModel::add(const Vector<JsonValue>&& values)
         obj.set(field_spec.json_field_name, values.at(i));
     }
     m_array.append(move(obj));
-    did_update();
+    did_update_rows(m_array.size() - 1, m_array.size() - 1);
     return true;
 }
 
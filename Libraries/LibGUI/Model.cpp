@@ -63,6 +63,21 @@ void Model::did_update(unsigned flags)
     });
 }
 
+void Model::did_update_rows(int first_row, int last_row)
+{
+    for (auto* client : m_clients)
+        client->model_did_update_rows(first_row, last_row);
+
+    for_each_view([&](auto& view) {
+        view.did_update_rows(first_row, last_row);
+    });
+}
+
+void ModelClient::model_did_update_rows(int, int)
+{
+    model_did_update(Model::DontInvalidateIndexes);
+}
+
 ModelIndex Model::create_index(int row, int column, const void* data) const
 {
     return ModelIndex(*this, row, column, const_cast<void*>(data));
@@ -50,6 +50,9 @@ public:
     virtual ~ModelClient() { }
 
     virtual void model_did_update(unsigned flags) = 0;
+
+    // Only the given (top level) rows have new data, or were just appended.
+    virtual void model_did_update_rows(int first_row, int last_row);
 };
 
 class Model : public RefCounted<Model> {
@@ -65,6 +68,7 @@ public:
     virtual int column_count(const ModelIndex& = ModelIndex()) const = 0;
     virtual String column_name(int) const { return {}; }
     virtual Variant data(const ModelIndex&, ModelRole = ModelRole::Display) const = 0;
+    // Filters expect matching to work like a substring search: anything that matches a term also matches every part of it.
     virtual TriState data_matches(const ModelIndex&, Variant) const { return TriState::Unknown; }
     virtual void update() = 0;
     virtual ModelIndex parent_index(const ModelIndex&) const { return {}; }
@@ -97,6 +101,10 @@ protected:
     void for_each_view(Function<void(AbstractView&)>);
     void did_update(unsigned flags = UpdateFlag::InvalidateAllIndexes);
 
+    // Lets views look at just the top level rows that changed, or that were appended at the end,
+    // instead of the whole model. Any other change has to go through did_update().
+    void did_update_rows(int first_row, int last_row);
+
     ModelIndex create_index(int row, int column, const void* data = nullptr) const;
 
 private:
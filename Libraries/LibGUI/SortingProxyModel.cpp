@@ -45,7 +45,8 @@ SortingProxyModel::~SortingProxyModel()
 void SortingProxyModel::invalidate(unsigned int flags)
 {
     if (flags == UpdateFlag::DontInvalidateIndexes) {
-        sort(m_last_key_column, m_last_sort_order);
+        for (auto& it : m_mappings)
+            resort_mapping(*it.value, m_last_key_column, m_last_sort_order);
     } else {
         m_mappings.clear();
 
@@ -62,6 +63,15 @@ void SortingProxyModel::model_did_update(unsigned flags)
     invalidate(flags);
 }
 
+void SortingProxyModel::model_did_update_rows(int first_row, int last_row)
+{
+    // Only the top level rows changed, so the mappings of everything below them are still good.
+    auto it = m_mappings.find({});
+    if (it != m_mappings.end())
+        resort_mapping(*it->value, m_last_key_column, m_last_sort_order, first_row, last_row);
+    did_update(UpdateFlag::DontInvalidateIndexes);
+}
+
 int SortingProxyModel::row_count(const ModelIndex& proxy_index) const
 {
     return source().row_count(map_to_source(proxy_index));
@@ -174,10 +184,21 @@ ModelIndex SortingProxyModel::parent_index(const ModelIndex& proxy_index) const
     return map_to_proxy(it->value->source_parent);
 }
 
+bool SortingProxyModel::row_less_than(const Mapping& mapping, int row1, int row2, int column, SortOrder sort_order) const
+{
+    auto index1 = source().index(row1, column, mapping.source_parent);
+    auto index2 = source().index(row2, column, mapping.source_parent);
+    return sort_order == SortOrder::Ascending ? less_than(index1, index2) : less_than(index2, index1);
+}
+
 void SortingProxyModel::sort_mapping(Mapping& mapping, int column, SortOrder sort_order)
 {
+    // Rows may have been appended to the source since the mapping was built.
+    int row_count = source().row_count(mapping.source_parent);
+    mapping.source_rows.resize(row_count);
+    mapping.proxy_rows.resize(row_count);
+
     if (column == -1) {
-        int row_count = source().row_count(mapping.source_parent);
         for (int i = 0; i < row_count; ++i) {
             mapping.source_rows[i] = i;
             mapping.proxy_rows[i] = i;
@@ -187,7 +208,6 @@ void SortingProxyModel::sort_mapping(Mapping& mapping, int column, SortOrder sor
 
     auto old_source_rows = mapping.source_rows;
 
-    int row_count = source().row_count(mapping.source_parent);
     for (int i = 0; i < row_count; ++i)
         mapping.source_rows[i] = i;
 
@@ -199,6 +219,79 @@ void SortingProxyModel::sort_mapping(Mapping& mapping, int column, SortOrder sor
     for (int i = 0; i < row_count; ++i)
         mapping.proxy_rows[mapping.source_rows[i]] = i;
 
+    update_selection_after_reordering(mapping, old_source_rows);
+}
+
+void SortingProxyModel::resort_mapping(Mapping& mapping, int column, SortOrder sort_order, int first_changed_row, int last_changed_row)
+{
+    if (column == -1)
+        return sort_mapping(mapping, column, sort_order);
+
+    int row_count = source().row_count(mapping.source_parent);
+    auto old_source_rows = mapping.source_rows;
+    int old_row_count = old_source_rows.size();
+
+    // Walk the rows in their current order. Whatever is still in order with the rows kept so far
+    // stays, and everything else (changed rows, rows that fell out of order, and new rows) gets
+    // inserted again afterwards. When only a few rows changed, that's a lot cheaper than sorting.
+    Vector<int> kept_rows;
+    Vector<int> displaced_rows;
+    kept_rows.ensure_capacity(row_count);
+    for (int source_row : old_source_rows) {
+        if (source_row >= row_count)
+            continue;
+        if ((source_row >= first_changed_row && source_row <= last_changed_row)
+            || (!kept_rows.is_empty() && row_less_than(mapping, source_row, kept_rows.last(), column, sort_order))) {
+            displaced_rows.append(source_row);
+            continue;
+        }
+        kept_rows.append(source_row);
+    }
+    for (int source_row = old_row_count; source_row < row_count; ++source_row)
+        displaced_rows.append(source_row);
+
+    if (displaced_rows.is_empty() && row_count == old_row_count)
+        return;
+
+    // With this much out of place, sorting from scratch is faster.
+    if (displaced_rows.size() > kept_rows.size() / 4 + 16)
+        return sort_mapping(mapping, column, sort_order);
+
+    quick_sort(displaced_rows, [&](int row1, int row2) {
+        return row_less_than(mapping, row1, row2, column, sort_order);
+    });
+
+    Vector<int> new_source_rows;
+    new_source_rows.ensure_capacity(row_count);
+    size_t next_kept_row = 0;
+    for (int displaced_row : displaced_rows) {
+        // Binary search for the first kept row that sorts after the displaced one.
+        size_t low = next_kept_row;
+        size_t high = kept_rows.size();
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (row_less_than(mapping, displaced_row, kept_rows[middle], column, sort_order))
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        for (; next_kept_row < low; ++next_kept_row)
+            new_source_rows.append(kept_rows[next_kept_row]);
+        new_source_rows.append(displaced_row);
+    }
+    for (; next_kept_row < kept_rows.size(); ++next_kept_row)
+        new_source_rows.append(kept_rows[next_kept_row]);
+
+    mapping.source_rows = move(new_source_rows);
+    mapping.proxy_rows.resize(row_count);
+    for (int i = 0; i < row_count; ++i)
+        mapping.proxy_rows[mapping.source_rows[i]] = i;
+
+    update_selection_after_reordering(mapping, old_source_rows);
+}
+
+void SortingProxyModel::update_selection_after_reordering(Mapping& mapping, const Vector<int>& old_source_rows)
+{
     // FIXME: I really feel like this should be done at the view layer somehow.
     for_each_view([&](AbstractView& view) {
         view.selection().change_from_model({}, [&](ModelSelection& selection) {
@@ -207,7 +300,8 @@ void SortingProxyModel::sort_mapping(Mapping& mapping, int column, SortOrder sor
             selection.for_each_index([&](const ModelIndex& index) {
                 if (index.parent() == mapping.source_parent) {
                     stale_indexes_in_selection.append(index);
-                    selected_indexes_in_source.append(source().index(old_source_rows[index.row()], index.column(), mapping.source_parent));
+                    if (static_cast<size_t>(index.row()) < old_source_rows.size())
+                        selected_indexes_in_source.append(source().index(old_source_rows[index.row()], index.column(), mapping.source_parent));
                 }
             });
 
@@ -216,13 +310,10 @@ void SortingProxyModel::sort_mapping(Mapping& mapping, int column, SortOrder sor
             }
 
             for (auto& index : selected_indexes_in_source) {
-                for (size_t i = 0; i < mapping.source_rows.size(); ++i) {
-                    if (mapping.source_rows[i] == index.row()) {
-                        auto new_source_index = this->index(i, index.column(), mapping.source_parent);
-                        selection.add(new_source_index);
-                        break;
-                    }
-                }
+                if (!index.is_valid() || static_cast<size_t>(index.row()) >= mapping.proxy_rows.size())
+                    continue;
+                auto new_source_index = this->index(mapping.proxy_rows[index.row()], index.column(), mapping.source_parent);
+                selection.add(new_source_index);
             }
         });
     });
@@ -71,9 +71,14 @@ private:
     using InternalMapIterator = HashMap<ModelIndex, NonnullOwnPtr<Mapping>>::IteratorType;
 
     void sort_mapping(Mapping&, int column, SortOrder);
+    // Like sort_mapping(), but only moves the rows that are out of place (or in the given range of changed rows).
+    void resort_mapping(Mapping&, int column, SortOrder, int first_changed_row = -1, int last_changed_row = -1);
+    void update_selection_after_reordering(Mapping&, const Vector<int>& old_source_rows);
+    bool row_less_than(const Mapping&, int row1, int row2, int column, SortOrder) const;
 
     // ^ModelClient
     virtual void model_did_update(unsigned) override;
+    virtual void model_did_update_rows(int first_row, int last_row) override;
 
     Model& source() { return *m_source; }
     const Model& source() const { return *m_source; }
@@ -67,14 +67,8 @@ void TableView::paint_event(PaintEvent& event)
     int exposed_width = max(content_size().width(), width());
     int y_offset = header_height();
 
-    bool dummy;
-    int first_visible_row = index_at_event_position(frame_inner_rect().top_left(), dummy).row();
-    int last_visible_row = index_at_event_position(frame_inner_rect().bottom_right(), dummy).row();
-
-    if (first_visible_row == -1)
-        first_visible_row = 0;
-    if (last_visible_row == -1)
-        last_visible_row = model()->row_count() - 1;
+    int first_visible_row = this->first_visible_row();
+    int last_visible_row = this->last_visible_row();
 
     int painted_item_index = first_visible_row;
 
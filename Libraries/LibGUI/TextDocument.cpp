@@ -25,6 +25,7 @@
  */
 
 #include <AK/Badge.h>
+#include <AK/MemMem.h>
 #include <AK/StringBuilder.h>
 #include <AK/Utf8View.h>
 #include <LibCore/Timer.h>
@@ -60,22 +61,32 @@ void TextDocument::set_text(const StringView& text)
 {
     m_client_notifications_enabled = false;
     m_spans.clear();
+    auto original_text = ByteBuffer::copy(text.characters_without_null_termination(), text.length());
     remove_all_lines();
+    m_original_text = move(original_text);
 
+    auto* characters = reinterpret_cast<const char*>(m_original_text.data());
     size_t start_of_current_line = 0;
+    bool current_line_is_ascii = true;
 
     auto add_line = [&](size_t current_position) {
-        size_t line_length = current_position - start_of_current_line;
-        auto line = make<TextDocumentLine>(*this);
-        if (line_length)
-            line->set_text(*this, text.substring_view(start_of_current_line, current_position - start_of_current_line));
-        append_line(move(line));
+        StringView line_text(characters + start_of_current_line, current_position - start_of_current_line);
+        size_t length = line_text.length();
+        if (!current_line_is_ascii) {
+            length = 0;
+            for ([[maybe_unused]] auto code_point : Utf8View(line_text))
+                ++length;
+        }
+        append_line(adopt_own(*new TextDocumentLine(Badge<TextDocument> {}, line_text, length)));
         start_of_current_line = current_position + 1;
+        current_line_is_ascii = true;
     };
     size_t i = 0;
-    for (i = 0; i < text.length(); ++i) {
-        if (text[i] == '\n')
+    for (i = 0; i < m_original_text.size(); ++i) {
+        if (characters[i] == '\n')
             add_line(i);
+        else if ((u8)characters[i] >= 0x80)
+            current_line_is_ascii = false;
     }
     add_line(i);
     m_client_notifications_enabled = true;
@@ -96,6 +107,8 @@ size_t TextDocumentLine::first_non_whitespace_column() const
 
 String TextDocumentLine::to_utf8() const
 {
+    if (m_original_text)
+        return String(m_original_text, m_original_byte_length);
     StringBuilder builder;
     builder.append(view());
     return builder.to_string();
@@ -111,14 +124,35 @@ TextDocumentLine::TextDocumentLine(TextDocument& document, const StringView& tex
     set_text(document, text);
 }
 
+TextDocumentLine::TextDocumentLine(Badge<TextDocument>, const StringView& original_text, size_t length)
+    : m_original_text(original_text.characters_without_null_termination())
+    , m_original_byte_length(original_text.length())
+    , m_original_length(length)
+{
+    // An empty line has nothing to decode.
+    if (!m_original_byte_length)
+        m_original_text = nullptr;
+}
+
+void TextDocumentLine::decode() const
+{
+    ASSERT(m_original_text);
+    m_text.ensure_capacity(m_original_length);
+    for (auto code_point : Utf8View(StringView(m_original_text, m_original_byte_length)))
+        m_text.append(code_point);
+    m_original_text = nullptr;
+}
+
 void TextDocumentLine::clear(TextDocument& document)
 {
+    m_original_text = nullptr;
     m_text.clear();
     document.update_views({});
 }
 
 void TextDocumentLine::set_text(TextDocument& document, const Vector<u32> text)
 {
+    m_original_text = nullptr;
     m_text = move(text);
     document.update_views({});
 }
@@ -129,6 +163,7 @@ void TextDocumentLine::set_text(TextDocument& document, const StringView& text)
         clear(document);
         return;
     }
+    m_original_text = nullptr;
     m_text.clear();
     Utf8View utf8_view(text);
     for (auto code_point : utf8_view)
@@ -140,6 +175,8 @@ void TextDocumentLine::append(TextDocument& document, const u32* code_points, si
 {
     if (length == 0)
         return;
+    if (m_original_text)
+        decode();
     m_text.append(code_points, length);
     document.update_views({});
 }
@@ -156,6 +193,8 @@ void TextDocumentLine::prepend(TextDocument& document, u32 code_point)
 
 void TextDocumentLine::insert(TextDocument& document, size_t index, u32 code_point)
 {
+    if (m_original_text)
+        decode();
     if (index == length()) {
         m_text.append(code_point);
     } else {
@@ -166,6 +205,8 @@ void TextDocumentLine::insert(TextDocument& document, size_t index, u32 code_poi
 
 void TextDocumentLine::remove(TextDocument& document, size_t index)
 {
+    if (m_original_text)
+        decode();
     if (index == length()) {
         m_text.take_last();
     } else {
@@ -176,6 +217,8 @@ void TextDocumentLine::remove(TextDocument& document, size_t index)
 
 void TextDocumentLine::remove_range(TextDocument& document, size_t start, size_t length)
 {
+    if (m_original_text)
+        decode();
     ASSERT(length <= m_text.size());
 
     Vector<u32> new_data;
@@ -190,6 +233,8 @@ void TextDocumentLine::remove_range(TextDocument& document, size_t start, size_t
 
 void TextDocumentLine::truncate(TextDocument& document, size_t length)
 {
+    if (m_original_text)
+        decode();
     m_text.resize(length);
     document.update_views({});
 }
@@ -321,11 +366,63 @@ TextPosition TextDocument::previous_position_before(const TextPosition& position
     return { position.line(), position.column() - 1 };
 }
 
+static Vector<u32> code_points_of(const StringView& needle)
+{
+    Vector<u32> code_points;
+    for (u32 code_point : Utf8View(needle))
+        code_points.append(code_point);
+    return code_points;
+}
+
+// Returns the column of the first match in a line that starts within [from, to), if any.
+static Optional<size_t> find_in_line(const TextDocumentLine& line, const Vector<u32>& needle, size_t from, size_t to)
+{
+    size_t end = min(line.length(), to + needle.size() - 1);
+    if (from >= end)
+        return {};
+    auto* match = find_sequence(line.code_points() + from, end - from, needle.data(), needle.size());
+    if (!match)
+        return {};
+    return match - line.code_points();
+}
+
+// Returns the column of the last match in a line that ends at or before the given column, if any.
+static Optional<size_t> find_last_in_line(const TextDocumentLine& line, const Vector<u32>& needle, size_t end)
+{
+    Optional<size_t> last_match;
+    size_t from = 0;
+    end = min(end, line.length());
+    for (;;) {
+        auto match = find_in_line(line, needle, from, end);
+        if (!match.has_value() || match.value() + needle.size() > end)
+            break;
+        last_match = match;
+        from = match.value() + 1;
+    }
+    return last_match;
+}
+
 TextRange TextDocument::find_next(const StringView& needle, const TextPosition& start, SearchShouldWrap should_wrap) const
 {
     if (needle.is_empty())
         return {};
 
+    // Matches that don't cross lines can be looked for a line at a time.
+    if (!needle.contains('\n')) {
+        auto code_points = code_points_of(needle);
+        TextPosition position = start.is_valid() ? start : TextPosition(0, 0);
+        for (size_t i = 0; i <= line_count(); ++i) {
+            if (position.line() + i >= line_count() && should_wrap == SearchShouldWrap::No)
+                break;
+            size_t line_index = (position.line() + i) % line_count();
+            size_t from = i == 0 ? position.column() : 0;
+            size_t to = i == line_count() ? position.column() : NumericLimits<size_t>::max() - code_points.size();
+            if (auto column = find_in_line(line(line_index), code_points, from, to); column.has_value())
+                return { { line_index, column.value() }, { line_index, column.value() + code_points.size() } };
+        }
+        return {};
+    }
+
     TextPosition position = start.is_valid() ? start : TextPosition(0, 0);
     TextPosition original_position = position;
 
@@ -357,6 +454,20 @@ TextRange TextDocument::find_previous(const StringView& needle, const TextPositi
     if (needle.is_empty())
         return {};
 
+    if (!needle.contains('\n')) {
+        auto code_points = code_points_of(needle);
+        TextPosition position = start.is_valid() ? start : TextPosition(0, 0);
+        for (size_t i = 0; i <= line_count(); ++i) {
+            if (i > position.line() && should_wrap == SearchShouldWrap::No)
+                break;
+            size_t line_index = (position.line() + line_count() - i % line_count()) % line_count();
+            size_t end = i == 0 ? position.column() : NumericLimits<size_t>::max();
+            if (auto column = find_last_in_line(line(line_index), code_points, end); column.has_value())
+                return { { line_index, column.value() }, { line_index, column.value() + code_points.size() } };
+        }
+        return {};
+    }
+
     TextPosition position = start.is_valid() ? start : TextPosition(0, 0);
     position = previous_position_before(position, should_wrap);
     TextPosition original_position = position;
@@ -388,6 +499,22 @@ Vector<TextRange> TextDocument::find_all(const StringView& needle) const
 {
     Vector<TextRange> ranges;
 
+    if (!needle.is_empty() && !needle.contains('\n')) {
+        auto code_points = code_points_of(needle);
+        for (size_t line_index = 0; line_index < line_count(); ++line_index) {
+            auto& line = this->line(line_index);
+            size_t from = 0;
+            for (;;) {
+                auto column = find_in_line(line, code_points, from, line.length());
+                if (!column.has_value())
+                    break;
+                ranges.append({ { line_index, column.value() }, { line_index, column.value() + code_points.size() } });
+                from = column.value() + code_points.size();
+            }
+        }
+        return ranges;
+    }
+
     TextPosition position;
     for (;;) {
         auto range = find_next(needle, position, SearchShouldWrap::No);
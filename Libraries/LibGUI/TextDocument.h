@@ -26,12 +26,15 @@
 
 #pragma once
 
+#include <AK/Badge.h>
+#include <AK/ByteBuffer.h>
 #include <AK/HashTable.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/Optional.h>
 #include <AK/RefCounted.h>
 #include <AK/Utf32View.h>
+#include <AK/Utf8View.h>
 #include <LibCore/Forward.h>
 #include <LibGUI/Command.h>
 #include <LibGUI/Forward.h>
@@ -148,6 +151,9 @@ private:
     NonnullOwnPtrVector<TextDocumentLine> m_lines;
     Vector<TextDocumentSpan> m_spans;
 
+    // The text given to set_text(). Lines point into it until they are looked at or changed.
+    ByteBuffer m_original_text;
+
     HashTable<Client*> m_clients;
     bool m_client_notifications_enabled { true };
 
@@ -159,12 +165,18 @@ class TextDocumentLine {
 public:
     explicit TextDocumentLine(TextDocument&);
     explicit TextDocumentLine(TextDocument&, const StringView&);
+    TextDocumentLine(Badge<TextDocument>, const StringView& original_text, size_t length);
 
     String to_utf8() const;
 
     Utf32View view() const { return { code_points(), length() }; }
-    const u32* code_points() const { return m_text.data(); }
-    size_t length() const { return m_text.size(); }
+    const u32* code_points() const
+    {
+        if (m_original_text)
+            decode();
+        return m_text.data();
+    }
+    size_t length() const { return m_original_text ? m_original_length : m_text.size(); }
     void set_text(TextDocument&, const StringView&);
     void set_text(TextDocument&, Vector<u32>);
     void append(TextDocument&, u32);
@@ -178,9 +190,30 @@ public:
 
     size_t first_non_whitespace_column() const;
 
+    // Walks the line without decoding it, for things like layout that need to see every line once.
+    template<typename Callback>
+    void for_each_code_point(Callback callback) const
+    {
+        if (m_original_text) {
+            size_t index = 0;
+            for (auto code_point : Utf8View(StringView(m_original_text, m_original_byte_length)))
+                callback(index++, code_point);
+            return;
+        }
+        for (size_t i = 0; i < m_text.size(); ++i)
+            callback(i, m_text[i]);
+    }
+
 private:
-    // NOTE: This vector is null terminated.
-    Vector<u32> m_text;
+    void decode() const;
+
+    // Lines start out as UTF-8 in the document's original text, and are only decoded into
+    // code points the first time they are needed.
+    mutable const char* m_original_text { nullptr };
+    u32 m_original_byte_length { 0 };
+    u32 m_original_length { 0 };
+
+    mutable Vector<u32> m_text;
 };
 
 class TextDocumentUndoCommand : public Command {
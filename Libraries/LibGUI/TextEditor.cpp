@@ -1155,7 +1155,7 @@ void TextEditor::focusin_event(FocusEvent& event)
         select_all();
     m_cursor_state = true;
     update_cursor();
-    start_timer(500);
+    start_timer(500, Core::TimerShouldFireWhenNotVisible::No, 50);
     if (on_focusin)
         on_focusin();
 }
@@ -1524,28 +1524,33 @@ void TextEditor::recompute_visual_lines(size_t line_index)
 
     int available_width = visible_text_rect_in_inner_coordinates().width();
 
+    // This runs for every line of the document, so it walks the lines without decoding them.
+    auto glyph_spacing = font().glyph_spacing();
     if (is_line_wrapping_enabled()) {
         int line_width_so_far = 0;
 
-        auto glyph_spacing = font().glyph_spacing();
-        for (size_t i = 0; i < line.length(); ++i) {
-            auto code_point = line.code_points()[i];
+        line.for_each_code_point([&](size_t i, u32 code_point) {
             auto glyph_width = font().glyph_or_emoji_width(code_point);
             if ((line_width_so_far + glyph_width + glyph_spacing) > available_width) {
                 visual_data.visual_line_breaks.append(i);
                 line_width_so_far = glyph_width + glyph_spacing;
-                continue;
+                return;
             }
             line_width_so_far += glyph_width + glyph_spacing;
-        }
+        });
     }
 
     visual_data.visual_line_breaks.append(line.length());
 
-    if (is_line_wrapping_enabled())
+    if (is_line_wrapping_enabled()) {
         visual_data.visual_rect = { m_horizontal_content_padding, 0, available_width, static_cast<int>(visual_data.visual_line_breaks.size()) * line_height() };
-    else
-        visual_data.visual_rect = { m_horizontal_content_padding, 0, font().width(line.view()), line_height() };
+    } else {
+        int line_width = line.length() ? -glyph_spacing : 0;
+        line.for_each_code_point([&](size_t, u32 code_point) {
+            line_width += font().glyph_or_emoji_width(code_point) + glyph_spacing;
+        });
+        visual_data.visual_rect = { m_horizontal_content_padding, 0, line_width, line_height() };
+    }
 }
 
 template<typename Callback>
@@ -1642,6 +1647,7 @@ void TextEditor::document_did_change()
 void TextEditor::document_did_set_text()
 {
     m_line_visual_data.clear();
+    m_line_visual_data.ensure_capacity(m_document->line_count());
     for (size_t i = 0; i < m_document->line_count(); ++i)
         m_line_visual_data.append(make<LineVisualData>());
     document_did_change();
@@ -1660,6 +1666,7 @@ void TextEditor::set_document(TextDocument& document)
         m_document->unregister_client(*this);
     m_document = document;
     m_line_visual_data.clear();
+    m_line_visual_data.ensure_capacity(m_document->line_count());
     for (size_t i = 0; i < m_document->line_count(); ++i) {
         m_line_visual_data.append(make<LineVisualData>());
     }
@@ -380,10 +380,18 @@ void TreeView::scroll_into_view(const ModelIndex& a_index, Orientation orientati
 
 void TreeView::did_update_model(unsigned flags)
 {
-    m_view_metadata.clear();
+    // As long as the indexes stay valid, so does what we know about them (like which ones are open).
+    if (flags & Model::InvalidateAllIndexes)
+        m_view_metadata.clear();
     AbstractTableView::did_update_model(flags);
 }
 
+void TreeView::did_update_rows(int, int)
+{
+    // The rows of a tree don't line up with the top level rows of its model.
+    did_update_model(Model::DontInvalidateIndexes);
+}
+
 void TreeView::did_update_selection()
 {
     AbstractView::did_update_selection();
@@ -54,6 +54,7 @@ protected:
     virtual void keydown_event(KeyEvent&) override;
     virtual void did_update_selection() override;
     virtual void did_update_model(unsigned flags) override;
+    virtual void did_update_rows(int first_row, int last_row) override;
 
 private:
     virtual ModelIndex index_at_event_position(const Gfx::IntPoint&, bool& is_toggle) const override;
@@ -115,6 +115,8 @@ void Window::show()
     m_visible = true;
 
     apply_icon();
+    if (m_wants_mouse_move_history)
+        WindowServerConnection::the().post_message(Messages::WindowServer::SetWindowWantsMouseMoveHistory(m_window_id, true));
 
     reified_windows->set(m_window_id, this);
     Application::the()->did_create_window({});
@@ -138,6 +140,9 @@ void Window::server_did_destroy()
     m_pending_paint_event_rects.clear();
     m_back_bitmap = nullptr;
     m_front_bitmap = nullptr;
+    m_spare_bitmap = nullptr;
+    m_pending_presents = 0;
+    m_deferred_paint_rects.clear();
     m_override_cursor = StandardCursor::None;
 }
 
@@ -210,6 +215,8 @@ void Window::set_rect(const Gfx::IntRect& a_rect)
         m_back_bitmap = nullptr;
     if (m_front_bitmap && m_front_bitmap->size() != window_rect.size())
         m_front_bitmap = nullptr;
+    if (m_spare_bitmap && m_spare_bitmap->size() != window_rect.size())
+        m_spare_bitmap = nullptr;
     if (m_main_widget)
         m_main_widget->resize(window_rect.size());
 }
@@ -296,6 +303,12 @@ void Window::handle_multi_paint_event(MultiPaintEvent& event)
         return;
     auto rects = event.rects();
     ASSERT(!rects.is_empty());
+    if (m_double_buffering_enabled && m_back_bitmap && m_pending_presents > 1) {
+        // The server may still be showing the back bitmap, so wait until it has let go of it.
+        for (auto& rect : rects)
+            m_deferred_paint_rects.append(rect.is_empty() ? Gfx::IntRect { {}, event.window_size() } : rect);
+        return;
+    }
     if (m_back_bitmap && m_back_bitmap->size() != event.window_size()) {
         // Eagerly discard the backing store if we learn from this paint event that it needs to be bigger.
         // Otherwise we would have to wait for a resize event to tell us. This way we don't waste the
@@ -315,10 +328,28 @@ void Window::handle_multi_paint_event(MultiPaintEvent& event)
         }
     }
 
+    if (m_double_buffering_enabled && !created_new_backing_store && (!m_front_bitmap || m_front_bitmap->size() != m_back_bitmap->size()))
+        created_new_backing_store = true;
+
     auto rect = rects.first();
     if (rect.is_empty() || created_new_backing_store) {
         rects.clear();
         rects.append({ {}, event.window_size() });
+    } else if (m_double_buffering_enabled) {
+        // The back bitmap was last presented a couple of frames ago. Bring it up to date with what has been
+        // presented since then, except for what's about to be painted over anyway.
+        Painter painter(*m_back_bitmap);
+        auto bring_up_to_date = [&](const Gfx::IntRect& stale_rect) {
+            for (auto& rect : rects) {
+                if (rect.contains(stale_rect))
+                    return;
+            }
+            painter.blit(stale_rect.location(), *m_front_bitmap, stale_rect);
+        };
+        for (auto& stale_rect : m_spare_bitmap_rects)
+            bring_up_to_date(stale_rect);
+        for (auto& stale_rect : m_front_bitmap_rects)
+            bring_up_to_date(stale_rect);
     }
 
     for (auto& rect : rects) {
@@ -326,9 +357,12 @@ void Window::handle_multi_paint_event(MultiPaintEvent& event)
         m_main_widget->dispatch_event(paint_event, this);
     }
 
-    if (m_double_buffering_enabled)
-        flip(rects);
-    else if (created_new_backing_store)
+    if (m_double_buffering_enabled) {
+        present(rects);
+        return;
+    }
+
+    if (created_new_backing_store)
         set_current_backing_bitmap(*m_back_bitmap, true);
 
     if (is_visible()) {
@@ -352,6 +386,8 @@ void Window::handle_resize_event(ResizeEvent& event)
     auto new_size = event.size();
     if (m_back_bitmap && m_back_bitmap->size() != new_size)
         m_back_bitmap = nullptr;
+    if (m_spare_bitmap && m_spare_bitmap->size() != new_size)
+        m_spare_bitmap = nullptr;
     if (!m_pending_paint_event_rects.is_empty()) {
         m_pending_paint_event_rects.clear_with_capacity();
         m_pending_paint_event_rects.append({ {}, new_size });
@@ -574,6 +610,7 @@ void Window::set_has_alpha_channel(bool value)
     m_pending_paint_event_rects.clear();
     m_back_bitmap = nullptr;
     m_front_bitmap = nullptr;
+    m_spare_bitmap = nullptr;
 
     WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowHasAlphaChannel>(m_window_id, value);
     update();
@@ -593,6 +630,16 @@ void Window::set_opacity(float opacity)
     WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowOpacity>(m_window_id, opacity);
 }
 
+void Window::set_wants_mouse_move_history(bool wants)
+{
+    if (m_wants_mouse_move_history == wants)
+        return;
+    m_wants_mouse_move_history = wants;
+    if (!is_visible())
+        return;
+    WindowServerConnection::the().post_message(Messages::WindowServer::SetWindowWantsMouseMoveHistory(m_window_id, wants));
+}
+
 void Window::set_hovered_widget(Widget* widget)
 {
     if (widget == m_hovered_widget)
@@ -612,26 +659,39 @@ void Window::set_current_backing_bitmap(Gfx::Bitmap& bitmap, bool flush_immediat
     WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowBackingStore>(m_window_id, 32, bitmap.pitch(), bitmap.shbuf_id(), bitmap.has_alpha_channel(), bitmap.size(), flush_immediately);
 }
 
-void Window::flip(const Vector<Gfx::IntRect, 32>& dirty_rects)
+void Window::present(const Vector<Gfx::IntRect, 32>& dirty_rects)
 {
-    swap(m_front_bitmap, m_back_bitmap);
+    Vector<Gfx::IntRect> rects_to_send;
+    for (auto& rect : dirty_rects)
+        rects_to_send.append(rect);
+    WindowServerConnection::the().post_message(Messages::WindowServer::PresentBackingStore(m_window_id, m_back_bitmap->shbuf_id(), m_back_bitmap->has_alpha_channel(), m_back_bitmap->size(), rects_to_send));
+    ++m_pending_presents;
 
-    set_current_backing_bitmap(*m_front_bitmap);
+    // There are three bitmaps, so that we can start on the next frame while the server may still be showing the last one.
+    auto spare_bitmap = move(m_spare_bitmap);
+    m_spare_bitmap = move(m_front_bitmap);
+    m_front_bitmap = move(m_back_bitmap);
+    m_back_bitmap = move(spare_bitmap);
+    m_spare_bitmap_rects = move(m_front_bitmap_rects);
+    m_front_bitmap_rects = dirty_rects;
+    if (m_back_bitmap && m_back_bitmap->size() != m_front_bitmap->size())
+        m_back_bitmap = nullptr;
+}
 
-    if (!m_back_bitmap || m_back_bitmap->size() != m_front_bitmap->size()) {
-        m_back_bitmap = create_backing_bitmap(m_front_bitmap->size());
-        ASSERT(m_back_bitmap);
-        memcpy(m_back_bitmap->scanline(0), m_front_bitmap->scanline(0), m_front_bitmap->size_in_bytes());
-        m_back_bitmap->shared_buffer()->set_volatile();
+void Window::did_present_backing_store(Badge<WindowServerConnection>)
+{
+    if (m_pending_presents)
+        --m_pending_presents;
+    if (m_pending_presents > 1)
         return;
-    }
 
-    // Copy whatever was painted from the front to the back.
-    Painter painter(*m_back_bitmap);
-    for (auto& dirty_rect : dirty_rects)
-        painter.blit(dirty_rect.location(), *m_front_bitmap, dirty_rect);
+    // Nothing reads from the back bitmap anymore until it's presented again.
+    if (m_back_bitmap)
+        m_back_bitmap->shared_buffer()->set_volatile();
 
-    m_back_bitmap->shared_buffer()->set_volatile();
+    auto deferred_paint_rects = move(m_deferred_paint_rects);
+    for (auto& rect : deferred_paint_rects)
+        update(rect);
 }
 
 RefPtr<Gfx::Bitmap> Window::create_shared_bitmap(Gfx::BitmapFormat format, const Gfx::IntSize& size)
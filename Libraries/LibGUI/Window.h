@@ -84,6 +84,10 @@ public:
     void set_has_alpha_channel(bool);
     void set_opacity(float);
 
+    // Get a MouseMove event for every position the cursor went through, even if the server had to coalesce them.
+    bool wants_mouse_move_history() const { return m_wants_mouse_move_history; }
+    void set_wants_mouse_move_history(bool);
+
     WindowType window_type() const { return m_window_type; }
     void set_window_type(WindowType);
 
@@ -200,6 +204,7 @@ public:
     static void for_each_window(Badge<WindowServerConnection>, Function<void(Window&)>);
     static void update_all_windows(Badge<WindowServerConnection>);
     void notify_state_changed(Badge<WindowServerConnection>, bool minimized, bool occluded);
+    void did_present_backing_store(Badge<WindowServerConnection>);
 
     virtual bool is_visible_for_timer_purposes() const override { return m_visible_for_timer_purposes; }
 
@@ -236,11 +241,18 @@ private:
     RefPtr<Gfx::Bitmap> create_backing_bitmap(const Gfx::IntSize&);
     RefPtr<Gfx::Bitmap> create_shared_bitmap(Gfx::BitmapFormat, const Gfx::IntSize&);
     void set_current_backing_bitmap(Gfx::Bitmap&, bool flush_immediately = false);
-    void flip(const Vector<Gfx::IntRect, 32>& dirty_rects);
+    void present(const Vector<Gfx::IntRect, 32>& dirty_rects);
     void force_update();
 
+    // With double buffering, we paint into the back bitmap, while the server shows the front one (or, until it gets
+    // around to that, the spare one). The rects are what was painted into a bitmap before it was last presented.
     RefPtr<Gfx::Bitmap> m_front_bitmap;
     RefPtr<Gfx::Bitmap> m_back_bitmap;
+    RefPtr<Gfx::Bitmap> m_spare_bitmap;
+    Vector<Gfx::IntRect, 32> m_front_bitmap_rects;
+    Vector<Gfx::IntRect, 32> m_spare_bitmap_rects;
+    Vector<Gfx::IntRect, 32> m_deferred_paint_rects;
+    int m_pending_presents { 0 };
     RefPtr<Gfx::Bitmap> m_icon;
     RefPtr<Gfx::Bitmap> m_custom_cursor;
     int m_window_id { 0 };
@@ -273,6 +285,7 @@ private:
     bool m_visible { false };
     bool m_accessory { false };
     bool m_moved_by_client { false };
+    bool m_wants_mouse_move_history { false };
 };
 
 }
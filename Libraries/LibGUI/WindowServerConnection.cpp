@@ -94,6 +94,12 @@ void WindowServerConnection::handle(const Messages::WindowClient::WindowResized&
     }
 }
 
+void WindowServerConnection::handle(const Messages::WindowClient::BackingStorePresented& message)
+{
+    if (auto* window = Window::from_window_id(message.window_id()))
+        window->did_present_backing_store({});
+}
+
 void WindowServerConnection::handle(const Messages::WindowClient::WindowActivated& message)
 {
     if (auto* window = Window::from_window_id(message.window_id()))
@@ -240,10 +246,17 @@ void WindowServerConnection::handle(const Messages::WindowClient::MouseUp& messa
 void WindowServerConnection::handle(const Messages::WindowClient::MouseMove& message)
 {
     if (auto* window = Window::from_window_id(message.window_id())) {
-        if (message.is_drag())
+        if (message.is_drag()) {
             Core::EventLoop::current().post_event(*window, make<DragEvent>(Event::DragMove, message.mouse_position(), message.drag_data_type()));
-        else
+            return;
+        }
+        // The history is only sent to windows that asked for it, and always ends with the current position.
+        if (message.mouse_position_history().is_empty()) {
             Core::EventLoop::current().post_event(*window, make<MouseEvent>(Event::MouseMove, message.mouse_position(), message.buttons(), to_gmousebutton(message.button()), message.modifiers(), message.wheel_delta()));
+            return;
+        }
+        for (auto& position : message.mouse_position_history())
+            Core::EventLoop::current().post_event(*window, make<MouseEvent>(Event::MouseMove, position, message.buttons(), to_gmousebutton(message.button()), message.modifiers(), message.wheel_delta()));
     }
 }
 
@@ -63,6 +63,7 @@ private:
     virtual void handle(const Messages::WindowClient::WindowInputLeft&) override;
     virtual void handle(const Messages::WindowClient::WindowCloseRequest&) override;
     virtual void handle(const Messages::WindowClient::WindowResized&) override;
+    virtual void handle(const Messages::WindowClient::BackingStorePresented&) override;
     virtual void handle(const Messages::WindowClient::MenuItemActivated&) override;
     virtual void handle(const Messages::WindowClient::ScreenRectChanged&) override;
     virtual void handle(const Messages::WindowClient::WM_WindowRemoved&) override;
@@ -37,6 +37,7 @@
 #include <LibGfx/PGMLoader.h>
 #include <LibGfx/PNGLoader.h>
 #include <LibGfx/PPMLoader.h>
+#include <LibGfx/Painter.h>
 #include <LibGfx/ShareableBitmap.h>
 #include <fcntl.h>
 #include <stdio.h>
@@ -187,6 +188,17 @@ RefPtr<Gfx::Bitmap> Bitmap::flipped(Gfx::Orientation orientation) const
     return new_bitmap;
 }
 
+RefPtr<Gfx::Bitmap> Bitmap::scaled(const IntSize& size, ScalingMode scaling_mode) const
+{
+    auto new_bitmap = Gfx::Bitmap::create(has_alpha_channel() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, size);
+    if (!new_bitmap)
+        return nullptr;
+
+    Painter painter(*new_bitmap);
+    painter.draw_scaled_bitmap(new_bitmap->rect(), *this, rect(), 1.0f, scaling_mode);
+    return new_bitmap;
+}
+
 RefPtr<Bitmap> Bitmap::to_bitmap_backed_by_shared_buffer() const
 {
     if (m_shared_buffer)
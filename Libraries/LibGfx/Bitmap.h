@@ -61,6 +61,12 @@ enum RotationDirection {
     Right
 };
 
+enum class ScalingMode {
+    NearestNeighbor,
+    // Interpolates between the closest source pixels, or averages all of them when shrinking by more than half.
+    BilinearBlend,
+};
+
 class Bitmap : public RefCounted<Bitmap> {
 public:
     static RefPtr<Bitmap> create(BitmapFormat, const IntSize&);
@@ -82,6 +88,7 @@ public:
 
     RefPtr<Gfx::Bitmap> rotated(Gfx::RotationDirection) const;
     RefPtr<Gfx::Bitmap> flipped(Gfx::Orientation) const;
+    RefPtr<Gfx::Bitmap> scaled(const IntSize&, ScalingMode) const;
     RefPtr<Bitmap> to_bitmap_backed_by_shared_buffer() const;
 
     ShareableBitmap to_shareable_bitmap(pid_t peer_pid = -1) const;
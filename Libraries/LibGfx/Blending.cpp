@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Platform.h>
+#include <LibGfx/Blending.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC optimize("O3")
+#endif
+
+namespace Gfx {
+
+static void blend_scalar(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        u8 alpha = Color::from_rgba(src[i]).alpha();
+        if (alpha == 0xff)
+            dst[i] = src[i];
+        else if (alpha)
+            dst[i] = Color::from_rgba(dst[i]).blend(Color::from_rgba(src[i])).value();
+    }
+}
+
+static void blend_opaque_with_alpha_scalar(RGBA32* dst, const RGBA32* src, size_t count, u8 alpha)
+{
+    for (size_t i = 0; i < count; ++i) {
+        Color src_color = Color::from_rgb(src[i]);
+        src_color.set_alpha(alpha);
+        dst[i] = Color::from_rgb(dst[i]).blend(src_color).value();
+    }
+}
+
+static void blend_color_scalar(RGBA32* dst, Color color, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = Color::from_rgba(dst[i]).blend(color).value();
+}
+
+static const BlendFunctions s_scalar_functions { "scalar", blend_scalar, blend_opaque_with_alpha_scalar, blend_color_scalar };
+
+#if ARCH(I386) || ARCH(X86_64)
+typedef char v16qi __attribute__((vector_size(16)));
+typedef short v8hi __attribute__((vector_size(16)));
+typedef unsigned short v8hu __attribute__((vector_size(16)));
+typedef int v4si __attribute__((vector_size(16)));
+typedef int v4si_u __attribute__((vector_size(16), aligned(1), may_alias));
+
+#    define SSE2 __attribute__((target("sse2")))
+
+static constexpr int alpha_mask = (int)0xff000000;
+
+SSE2 static inline v4si load_unaligned(const RGBA32* ptr) { return *(const v4si_u*)ptr; }
+SSE2 static inline void store_unaligned(RGBA32* ptr, v4si value) { *(v4si_u*)ptr = value; }
+SSE2 static inline bool all_lanes(v4si mask) { return __builtin_ia32_pmovmskb128((v16qi)mask) == 0xffff; }
+
+// Widens the channels of the first or last two pixels to 16 bits each.
+SSE2 static inline v8hu unpack_low(v4si pixels) { return (v8hu)__builtin_ia32_punpcklbw128((v16qi)pixels, (v16qi) {}); }
+SSE2 static inline v8hu unpack_high(v4si pixels) { return (v8hu)__builtin_ia32_punpckhbw128((v16qi)pixels, (v16qi) {}); }
+SSE2 static inline v4si pack(v8hu low, v8hu high) { return (v4si)__builtin_ia32_packuswb128((v8hi)low, (v8hi)high); }
+
+// Copies each pixel's alpha into all four of its channels.
+SSE2 static inline v8hu broadcast_alpha(v8hu pixels) { return (v8hu)__builtin_ia32_pshufhw(__builtin_ia32_pshuflw((v8hi)pixels, 0xff), 0xff); }
+
+// (d * (255 - a) + s * a) / 255, rounded down. With an opaque destination, that's exactly what
+// Color::blend() computes, since its divisor 255 * (255 + a) - 255 * a is then just 255 * 255.
+SSE2 static inline v8hu blend_channels(v8hu d, v8hu s, v8hu a)
+{
+    v8hu x = d * (255 - a) + s * a + 1;
+    return (x + (x >> 8)) >> 8;
+}
+
+SSE2 static inline v4si blend_onto_opaque(v4si dst, v8hu src_low, v8hu src_high, v8hu alpha_low, v8hu alpha_high)
+{
+    auto low = blend_channels(unpack_low(dst), src_low, alpha_low);
+    auto high = blend_channels(unpack_high(dst), src_high, alpha_high);
+    return pack(low, high) | alpha_mask;
+}
+
+SSE2 static void blend_sse2(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto s = load_unaligned(src + i);
+        auto src_alpha = s & alpha_mask;
+        if (all_lanes(src_alpha == alpha_mask)) {
+            store_unaligned(dst + i, s);
+            continue;
+        }
+        if (all_lanes(src_alpha == 0))
+            continue;
+        auto d = load_unaligned(dst + i);
+        if (!all_lanes((d & alpha_mask) == alpha_mask)) {
+            blend_scalar(dst + i, src + i, 4);
+            continue;
+        }
+        auto src_low = unpack_low(s);
+        auto src_high = unpack_high(s);
+        store_unaligned(dst + i, blend_onto_opaque(d, src_low, src_high, broadcast_alpha(src_low), broadcast_alpha(src_high)));
+    }
+    blend_scalar(dst + i, src + i, count - i);
+}
+
+SSE2 static void blend_opaque_with_alpha_sse2(RGBA32* dst, const RGBA32* src, size_t count, u8 alpha)
+{
+    v8hu alpha_lanes = (v8hu) {} + alpha;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto s = load_unaligned(src + i);
+        store_unaligned(dst + i, blend_onto_opaque(load_unaligned(dst + i), unpack_low(s), unpack_high(s), alpha_lanes, alpha_lanes));
+    }
+    blend_opaque_with_alpha_scalar(dst + i, src + i, count - i, alpha);
+}
+
+SSE2 static void blend_color_sse2(RGBA32* dst, Color color, size_t count)
+{
+    auto src = unpack_low((v4si) {} + (int)color.value());
+    auto alpha_lanes = broadcast_alpha(src);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto d = load_unaligned(dst + i);
+        if (!all_lanes((d & alpha_mask) == alpha_mask)) {
+            blend_color_scalar(dst + i, color, 4);
+            continue;
+        }
+        store_unaligned(dst + i, blend_onto_opaque(d, src, src, alpha_lanes, alpha_lanes));
+    }
+    blend_color_scalar(dst + i, color, count - i);
+}
+
+static const BlendFunctions s_sse2_functions { "sse2", blend_sse2, blend_opaque_with_alpha_sse2, blend_color_sse2 };
+
+static bool cpu_has_sse2()
+{
+#    if ARCH(X86_64)
+    return true;
+#    else
+    u32 eax, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(1), "c"(0));
+    return edx & (1 << 26);
+#    endif
+}
+#endif
+
+Vector<const BlendFunctions*> available_blend_functions()
+{
+    Vector<const BlendFunctions*> functions;
+    functions.append(&s_scalar_functions);
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_has_sse2())
+        functions.append(&s_sse2_functions);
+#endif
+    return functions;
+}
+
+const BlendFunctions& blend_functions()
+{
+    static const BlendFunctions* s_functions;
+    if (!s_functions)
+        s_functions = available_blend_functions().last();
+    return *s_functions;
+}
+
+}
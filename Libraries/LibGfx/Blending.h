@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <LibGfx/Color.h>
+
+namespace Gfx {
+
+// Row kernels for source-over blending into RGBA32 pixels. All implementations produce exactly
+// what Color::blend() would; the vectorized ones are only used when the CPU supports them.
+struct BlendFunctions {
+    const char* name;
+
+    // dst[i] = dst[i].blend(src[i]), leaving dst[i] alone where src[i] is fully transparent.
+    void (*blend)(RGBA32* dst, const RGBA32* src, size_t count);
+
+    // Treats both rows as opaque and draws the source with the given alpha on top. The result is opaque.
+    void (*blend_opaque_with_alpha)(RGBA32* dst, const RGBA32* src, size_t count, u8 alpha);
+
+    // dst[i] = dst[i].blend(color)
+    void (*blend_color)(RGBA32* dst, Color color, size_t count);
+};
+
+// The fastest implementation this CPU can run.
+const BlendFunctions& blend_functions();
+
+// Every implementation this CPU can run, starting with the scalar one.
+Vector<const BlendFunctions*> available_blend_functions();
+
+}
@@ -267,6 +267,55 @@ GlyphBitmap Font::glyph_bitmap(u32 code_point) const
     return GlyphBitmap(&m_rows[code_point * m_glyph_height], { glyph_width(code_point), m_glyph_height });
 }
 
+const u8* Font::glyph_runs(u32 code_point) const
+{
+    ASSERT(code_point < m_glyph_count);
+
+    if (m_glyph_run_offsets.size() != m_glyph_count) {
+        m_glyph_run_offsets.resize(m_glyph_count);
+        for (auto& offset : m_glyph_run_offsets)
+            offset = 0;
+        // An offset of 0 means that the runs haven't been built yet, so no glyph may start there.
+        m_glyph_runs.clear();
+        m_glyph_runs.append(0);
+    }
+
+    if (auto offset = m_glyph_run_offsets[code_point])
+        return m_glyph_runs.data() + offset;
+
+    size_t offset = m_glyph_runs.size();
+    auto bitmap = glyph_bitmap(code_point);
+    for (int y = 0; y < bitmap.height(); ++y) {
+        // Bits past the glyph width are never painted.
+        u32 row = bitmap.row(y);
+        if (bitmap.width() < 32)
+            row &= (1u << bitmap.width()) - 1;
+
+        size_t count_index = m_glyph_runs.size();
+        m_glyph_runs.append(0);
+        while (row) {
+            int start = __builtin_ctz(row);
+            u32 inverted = ~(row >> start);
+            int length = inverted ? __builtin_ctz(inverted) : 32 - start;
+            m_glyph_runs.append(start);
+            m_glyph_runs.append(length);
+            ++m_glyph_runs[count_index];
+            row = start + length < 32 ? row & (~0u << (start + length)) : 0;
+        }
+    }
+
+    m_glyph_run_offsets[code_point] = offset;
+    return m_glyph_runs.data() + offset;
+}
+
+void Font::invalidate_caches() const
+{
+    m_glyph_run_offsets.clear();
+    m_glyph_runs.clear();
+    for (auto& entry : m_width_cache)
+        entry = {};
+}
+
 int Font::glyph_or_emoji_width(u32 code_point) const
 {
     if (code_point < m_glyph_count)
@@ -283,12 +332,31 @@ int Font::glyph_or_emoji_width(u32 code_point) const
 
 int Font::width(const StringView& string) const
 {
-    Utf8View utf8 { string };
-    return width(utf8);
+    if (string.length() < width_cache_min_length)
+        return width(Utf8View { string });
+
+    auto& entry = m_width_cache[string_hash(string.characters_without_null_termination(), string.length()) % width_cache_size];
+    if (entry.text == string)
+        return entry.width;
+
+    entry.text = string;
+    entry.width = width(Utf8View { string });
+    return entry.width;
 }
 
 int Font::width(const Utf8View& utf8) const
 {
+    // Plain ASCII doesn't need to be decoded, and can't contain any emoji.
+    auto string = utf8.as_string();
+    if (string.is_empty())
+        return 0;
+    int ascii_width = (string.length() - 1) * glyph_spacing();
+    size_t i = 0;
+    for (; i < string.length() && (u8)string[i] < 0x80; ++i)
+        ascii_width += glyph_width((u8)string[i]);
+    if (i == string.length())
+        return ascii_width;
+
     bool first = true;
     int width = 0;
 
@@ -320,6 +388,8 @@ void Font::set_type(FontTypes type)
     if (type == FontTypes::Default)
         return;
 
+    invalidate_caches();
+
     size_t new_glyph_count = glyph_count_by_type(type);
     if (new_glyph_count <= m_glyph_count) {
         m_glyph_count = new_glyph_count;
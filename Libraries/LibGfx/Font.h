@@ -31,6 +31,7 @@
 #include <AK/RefPtr.h>
 #include <AK/String.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <LibGfx/Size.h>
 
 namespace Gfx {
@@ -91,6 +92,14 @@ public:
 
     GlyphBitmap glyph_bitmap(u32 code_point) const;
 
+    // The glyph pre-expanded into horizontal runs of set pixels, which is a lot quicker to paint than
+    // testing the bitmap bit by bit. Each row is a run count, followed by the first column and length
+    // of every run. The runs are built on first use, and the pointer is only good until the next call.
+    const u8* glyph_runs(u32 code_point) const;
+
+    // Has to be called after modifying glyph bitmaps in place, since glyph_runs() wouldn't notice.
+    void invalidate_caches() const;
+
     u8 glyph_width(size_t ch) const { return m_fixed_width ? m_glyph_width : m_glyph_widths[ch]; }
     int glyph_or_emoji_width(u32 code_point) const;
     u8 glyph_height() const { return m_glyph_height; }
@@ -108,19 +117,28 @@ public:
     void set_name(const StringView& name) { m_name = name; }
 
     bool is_fixed_width() const { return m_fixed_width; }
-    void set_fixed_width(bool b) { m_fixed_width = b; }
+    void set_fixed_width(bool b)
+    {
+        m_fixed_width = b;
+        invalidate_caches();
+    }
 
     const Font& bold_family_font() const { return *m_bold_family_font; }
     bool has_boldface() const { return m_boldface; }
     void set_boldface(bool b) { m_boldface = b; }
 
     u8 glyph_spacing() const { return m_glyph_spacing; }
-    void set_glyph_spacing(u8 spacing) { m_glyph_spacing = spacing; }
+    void set_glyph_spacing(u8 spacing)
+    {
+        m_glyph_spacing = spacing;
+        invalidate_caches();
+    }
 
     void set_glyph_width(size_t ch, u8 width)
     {
         ASSERT(m_glyph_widths);
         m_glyph_widths[ch] = width;
+        invalidate_caches();
     }
 
     int glyph_count() const { return m_glyph_count; }
@@ -154,6 +172,19 @@ private:
 
     bool m_fixed_width { false };
     bool m_boldface { false };
+
+    mutable Vector<u32> m_glyph_run_offsets;
+    mutable Vector<u8> m_glyph_runs;
+
+    // Widths of recently measured strings, since the same labels tend to get measured on every paint.
+    // Short strings are quicker to measure than to look up.
+    struct CachedWidth {
+        String text;
+        int width { 0 };
+    };
+    static constexpr size_t width_cache_size = 64;
+    static constexpr size_t width_cache_min_length = 16;
+    mutable CachedWidth m_width_cache[width_cache_size];
 };
 
 }
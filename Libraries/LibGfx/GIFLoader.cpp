@@ -28,14 +28,21 @@
 #include <AK/ByteBuffer.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
+#include <AK/Memory.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <LibGfx/GIFLoader.h>
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
 
+//#define GIF_DEBUG
+
 namespace Gfx {
 
+// Decoded frames are kept around up to this many bytes per image, so that short animations
+// don't have to be decoded again on every loop.
+static constexpr size_t frame_cache_budget = 16 * MiB;
+
 struct RGB {
     u8 r;
     u8 g;
@@ -48,9 +55,12 @@ struct ImageDescriptor {
     u16 width { 0 };
     u16 height { 0 };
     bool use_global_color_map { true };
+    bool interlaced { false };
     RGB color_map[256];
     u8 lzw_min_code_size { 0 };
     Vector<u8> lzw_encoded_bytes;
+
+    // The fully composed frame, if it's in the frame cache.
     RefPtr<Gfx::Bitmap> bitmap;
 
     // Fields from optional graphic control extension block
@@ -80,13 +90,22 @@ struct GIFLoadingContext {
         FrameDescriptorsLoaded,
     };
     State state { NotDecoded };
-    size_t frames_decoded { 0 };
     const u8* data { nullptr };
     size_t data_size { 0 };
     LogicalScreen logical_screen {};
     u8 background_color_index { 0 };
     NonnullOwnPtrVector<ImageDescriptor> images {};
     size_t loops { 1 };
+
+    // The canvas that frames are drawn onto, one after another. It holds current_frame, so moving on
+    // to later frames only has to draw those, while going back has to start over from the first frame.
+    RefPtr<Gfx::Bitmap> frame_buffer;
+    Optional<size_t> current_frame;
+    // What the canvas looked like below a frame that gets disposed with RestorePrevious.
+    RefPtr<Gfx::Bitmap> prev_frame_buffer;
+
+    // Indices of the frames in the frame cache, least recently used first.
+    Vector<size_t> cached_frames;
 };
 
 RefPtr<Gfx::Bitmap> load_gif(const StringView& path)
@@ -260,86 +279,199 @@ private:
     Vector<u8> m_output {};
 };
 
-static bool decode_frames_up_to_index(GIFLoadingContext& context, size_t frame_index)
+static IntRect frame_rect(const GIFLoadingContext& context, const ImageDescriptor& image)
 {
-    if (frame_index >= context.images.size()) {
-        return false;
-    }
-
-    for (size_t i = context.frames_decoded; i <= frame_index; ++i) {
-        auto& image = context.images.at(i);
-        printf("Image %zu: %d,%d %dx%d  %zu bytes LZW-encoded\n", i, image.x, image.y, image.width, image.height, image.lzw_encoded_bytes.size());
-
-        dbg() << "Decoding frame: " << i + 1 << " of " << context.images.size();
+    return IntRect { image.x, image.y, image.width, image.height }.intersected({ 0, 0, context.logical_screen.width, context.logical_screen.height });
+}
 
-        LZWDecoder decoder(image.lzw_encoded_bytes, image.lzw_min_code_size);
+static void copy_rect(Bitmap& destination, const Bitmap& source, const IntRect& rect)
+{
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        fast_u32_copy(destination.scanline(y) + rect.x(), source.scanline(y) + rect.x(), rect.width());
+}
 
-        // Add GIF-specific control codes
-        const int clear_code = decoder.add_control_code();
-        const int end_of_information_code = decoder.add_control_code();
+static void clear_rect(Bitmap& bitmap, const IntRect& rect)
+{
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        fast_u32_fill(bitmap.scanline(y) + rect.x(), Color(Color::Transparent).value(), rect.width());
+}
 
-        auto& color_map = image.use_global_color_map ? context.logical_screen.color_map : image.color_map;
+// Draws a single frame on top of the frame buffer. Only the frame's own rect is touched.
+static bool draw_frame(GIFLoadingContext& context, const ImageDescriptor& image)
+{
+#ifdef GIF_DEBUG
+    dbg() << "Drawing frame: " << image.x << "," << image.y << " " << image.width << "x" << image.height << ", " << image.lzw_encoded_bytes.size() << " bytes LZW-encoded";
+#endif
+
+    LZWDecoder decoder(image.lzw_encoded_bytes, image.lzw_min_code_size);
+
+    // Add GIF-specific control codes
+    const int clear_code = decoder.add_control_code();
+    const int end_of_information_code = decoder.add_control_code();
+
+    auto& color_map = image.use_global_color_map ? context.logical_screen.color_map : image.color_map;
+    RGBA32 colors[256];
+    for (size_t i = 0; i < 256; ++i)
+        colors[i] = Color(color_map[i].r, color_map[i].g, color_map[i].b).value();
+
+    // Interlaced frames store every 8th row first, then the rows in between, and so on.
+    static const int interlace_row_starts[] = { 0, 4, 2, 1 };
+    static const int interlace_row_steps[] = { 8, 8, 4, 2 };
+    int interlace_pass = 0;
+
+    auto& frame_buffer = *context.frame_buffer;
+    int column = 0;
+    int row = 0;
+    while (true) {
+        Optional<u16> code = decoder.next_code();
+        if (!code.has_value()) {
+            dbg() << "Unexpectedly reached end of gif frame data";
+            return false;
+        }
 
-        auto background_rgb = color_map[context.background_color_index];
-        Color background_color = Color(background_rgb.r, background_rgb.g, background_rgb.b);
+        if (code.value() == clear_code) {
+            decoder.reset();
+            continue;
+        } else if (code.value() == end_of_information_code) {
+            break;
+        }
 
-        image.bitmap = Bitmap::create_purgeable(BitmapFormat::RGBA32, { context.logical_screen.width, context.logical_screen.height });
+        auto& output = decoder.get_output();
+        for (u8 color : output) {
+            if (row >= image.height)
+                break;
 
-        const auto previous_image_disposal_method = i > 0 ? context.images.at(i - 1).disposal_method : ImageDescriptor::DisposalMethod::None;
+            int x = image.x + column;
+            int y = image.y + row;
+            // Transparent pixels let the canvas below show through.
+            if (x < frame_buffer.width() && y < frame_buffer.height() && (!image.transparent || color != image.transparency_index))
+                frame_buffer.scanline(y)[x] = colors[color];
 
-        if (previous_image_disposal_method == ImageDescriptor::DisposalMethod::InPlace) {
-            for (int y = 0; y < image.bitmap->height(); ++y) {
-                for (int x = 0; x < image.bitmap->width(); ++x) {
-                    image.bitmap->set_pixel(x, y, context.images.at(i - 1).bitmap->get_pixel(x, y));
-                }
+            if (++column < image.width)
+                continue;
+            column = 0;
+            if (!image.interlaced) {
+                ++row;
+                continue;
             }
-        } else if (previous_image_disposal_method == ImageDescriptor::DisposalMethod::RestoreBackground) {
-            image.bitmap->fill(background_color);
-        } else if (previous_image_disposal_method == ImageDescriptor::DisposalMethod::RestorePrevious) {
-            image.bitmap->fill(Color(Color::NamedColor::Transparent));
+            row += interlace_row_steps[interlace_pass];
+            while (row >= image.height && interlace_pass < 3)
+                row = interlace_row_starts[++interlace_pass];
         }
+    }
 
-        int pixel_index = 0;
-        while (true) {
-            Optional<u16> code = decoder.next_code();
-            if (!code.has_value()) {
-                dbg() << "Unexpectedly reached end of gif frame data";
-                return false;
-            }
+    return true;
+}
 
-            if (code.value() == clear_code) {
-                decoder.reset();
-                continue;
-            } else if (code.value() == end_of_information_code) {
-                break;
-            }
+static size_t max_cached_frames(const GIFLoadingContext& context)
+{
+    size_t frame_size = (size_t)context.frame_buffer->size_in_bytes();
+    return max((size_t)1, frame_cache_budget / max(frame_size, (size_t)1));
+}
 
-            auto colors = decoder.get_output();
+static bool cache_frame(GIFLoadingContext& context, size_t frame_index)
+{
+    auto& image = context.images.at(frame_index);
+
+    while (context.cached_frames.size() >= max_cached_frames(context))
+        context.images.at(context.cached_frames.take_first()).bitmap = nullptr;
+
+    if (context.images.size() == 1) {
+        // Nothing is ever going to be drawn on top of a still image, so the canvas can just be handed out.
+        image.bitmap = move(context.frame_buffer);
+        context.current_frame.clear();
+    } else {
+        image.bitmap = Bitmap::create_purgeable(BitmapFormat::RGBA32, context.frame_buffer->size());
+        if (!image.bitmap)
+            return false;
+        ASSERT(image.bitmap->pitch() == context.frame_buffer->pitch());
+        memcpy(image.bitmap->scanline(0), context.frame_buffer->scanline(0), context.frame_buffer->size_in_bytes());
+    }
 
-            for (const auto& color : colors) {
-                auto rgb = color_map[color];
+    context.cached_frames.append(frame_index);
+    return true;
+}
 
-                int x = pixel_index % image.width + image.x;
-                int y = pixel_index / image.width + image.y;
+static void uncache_frame(GIFLoadingContext& context, size_t cache_index)
+{
+    auto& image = context.images.at(context.cached_frames.at(cache_index));
+    if (image.bitmap == context.frame_buffer) {
+        context.frame_buffer = nullptr;
+        context.current_frame.clear();
+    }
+    image.bitmap = nullptr;
+    context.cached_frames.remove(cache_index);
+}
 
-                Color c = Color(rgb.r, rgb.g, rgb.b);
+static bool decode_frame(GIFLoadingContext& context, size_t frame_index)
+{
+    if (frame_index >= context.images.size()) {
+        return false;
+    }
 
-                if (image.transparent && color == image.transparency_index) {
-                    c.set_alpha(0);
-                }
+    for (size_t i = 0; i < context.cached_frames.size(); ++i) {
+        if (context.cached_frames[i] != frame_index)
+            continue;
+        auto& bitmap = *context.images.at(frame_index).bitmap;
+        if (bitmap.is_volatile() && !bitmap.set_nonvolatile()) {
+            uncache_frame(context, i);
+            break;
+        }
+        context.cached_frames.remove(i);
+        context.cached_frames.append(frame_index);
+        return true;
+    }
 
-                if (!image.transparent || previous_image_disposal_method == ImageDescriptor::DisposalMethod::None || color != image.transparency_index) {
-                    image.bitmap->set_pixel(x, y, c);
-                }
+    if (context.frame_buffer && context.frame_buffer->is_volatile() && !context.frame_buffer->set_nonvolatile()) {
+        context.frame_buffer = nullptr;
+        context.current_frame.clear();
+    }
+
+    size_t first_frame_to_draw = 0;
+    if (context.frame_buffer && context.current_frame.has_value() && context.current_frame.value() < frame_index) {
+        first_frame_to_draw = context.current_frame.value() + 1;
+    } else {
+        if (!context.frame_buffer) {
+            context.frame_buffer = Bitmap::create_purgeable(BitmapFormat::RGBA32, { context.logical_screen.width, context.logical_screen.height });
+            if (!context.frame_buffer)
+                return false;
+        }
+        context.frame_buffer->fill(Color::Transparent);
+        context.current_frame.clear();
+    }
+
+#ifdef GIF_DEBUG
+    dbg() << "Decoding frames " << first_frame_to_draw + 1 << " to " << frame_index + 1 << " of " << context.images.size();
+#endif
+
+    for (size_t i = first_frame_to_draw; i <= frame_index; ++i) {
+        auto& image = context.images.at(i);
+
+        if (i > 0) {
+            auto& previous_image = context.images.at(i - 1);
+            if (previous_image.disposal_method == ImageDescriptor::DisposalMethod::RestoreBackground)
+                clear_rect(*context.frame_buffer, frame_rect(context, previous_image));
+            else if (previous_image.disposal_method == ImageDescriptor::DisposalMethod::RestorePrevious)
+                copy_rect(*context.frame_buffer, *context.prev_frame_buffer, frame_rect(context, previous_image));
+        }
 
-                ++pixel_index;
+        if (image.disposal_method == ImageDescriptor::DisposalMethod::RestorePrevious) {
+            if (!context.prev_frame_buffer) {
+                context.prev_frame_buffer = Bitmap::create(BitmapFormat::RGBA32, context.frame_buffer->size());
+                if (!context.prev_frame_buffer)
+                    return false;
             }
+            copy_rect(*context.prev_frame_buffer, *context.frame_buffer, frame_rect(context, image));
         }
 
-        ++context.frames_decoded;
+        if (!draw_frame(context, image)) {
+            context.current_frame.clear();
+            return false;
+        }
+        context.current_frame = i;
     }
 
-    return true;
+    return cache_frame(context, frame_index);
 }
 
 static bool load_gif_frame_descriptors(GIFLoadingContext& context)
@@ -497,6 +629,7 @@ static bool load_gif_frame_descriptors(GIFLoadingContext& context)
                 return false;
 
             image.use_global_color_map = !(packed_fields & 0x80);
+            image.interlaced = packed_fields & 0x40;
 
             if (!image.use_global_color_map) {
                 size_t local_color_table_size = pow(2, (packed_fields & 7) + 1);
@@ -586,9 +719,10 @@ RefPtr<Gfx::Bitmap> GIFImageDecoderPlugin::bitmap()
 
 void GIFImageDecoderPlugin::set_volatile()
 {
-    for (size_t i = 0; i < m_context->frames_decoded; ++i) {
-        m_context->images.at(i).bitmap->set_volatile();
-    }
+    for (auto frame_index : m_context->cached_frames)
+        m_context->images.at(frame_index).bitmap->set_volatile();
+    if (m_context->frame_buffer)
+        m_context->frame_buffer->set_volatile();
 }
 
 bool GIFImageDecoderPlugin::set_nonvolatile()
@@ -597,11 +731,18 @@ bool GIFImageDecoderPlugin::set_nonvolatile()
         return false;
     }
 
-    bool success = true;
-    for (size_t i = 0; i < m_context->frames_decoded; ++i) {
-        success &= m_context->images.at(i).bitmap->set_nonvolatile();
+    if (m_context->frame_buffer && !m_context->frame_buffer->set_nonvolatile()) {
+        m_context->frame_buffer = nullptr;
+        m_context->current_frame.clear();
+    }
+
+    // Purged frames are simply decoded again when they're needed.
+    for (size_t i = m_context->cached_frames.size(); i > 0; --i) {
+        auto& bitmap = m_context->images.at(m_context->cached_frames[i - 1]).bitmap;
+        if (bitmap != m_context->frame_buffer && !bitmap->set_nonvolatile())
+            uncache_frame(*m_context, i - 1);
     }
-    return success;
+    return true;
 }
 
 bool GIFImageDecoderPlugin::sniff()
@@ -660,7 +801,7 @@ ImageFrameDescriptor GIFImageDecoderPlugin::frame(size_t i)
         }
     }
 
-    if (!decode_frames_up_to_index(*m_context, i)) {
+    if (!decode_frame(*m_context, i)) {
         m_context->state = GIFLoadingContext::State::Error;
         return {};
     }
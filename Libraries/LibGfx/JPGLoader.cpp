@@ -33,7 +33,7 @@
 #include <AK/Vector.h>
 #include <LibGfx/Bitmap.h>
 #include <LibGfx/JPGLoader.h>
-#include <math.h>
+#include <string.h>
 
 #define JPG_DBG 0
 #define jpg_dbg(x) \
@@ -205,6 +205,8 @@ struct JPGLoadingContext {
     size_t data_size { 0 };
     u32 luma_table[64] = { 0 };
     u32 chroma_table[64] = { 0 };
+    i32 luma_multipliers[64] = { 0 };
+    i32 chroma_multipliers[64] = { 0 };
     StartOfFrame frame;
     u8 hsample_factor { 0 };
     u8 vsample_factor { 0 };
@@ -218,6 +220,8 @@ struct JPGLoadingContext {
     HuffmanStreamState huffman_stream;
     i32 previous_dc_values[3] = { 0 };
     MacroblockMeta mblock_meta;
+    // Whether to only produce one pixel per block, from its DC coefficient.
+    bool decode_at_eighth_size { false };
 };
 
 static void generate_huffman_codes(HuffmanTableSpec& table)
@@ -373,58 +377,6 @@ static bool build_macroblocks(JPGLoadingContext& context, Vector<Macroblock>& ma
     return true;
 }
 
-static Optional<Vector<Macroblock>> decode_huffman_stream(JPGLoadingContext& context)
-{
-    Vector<Macroblock> macroblocks;
-    macroblocks.resize(context.mblock_meta.padded_total);
-
-    jpg_dbg("Image width: " << context.frame.width);
-    jpg_dbg("Image height: " << context.frame.height);
-    jpg_dbg("Macroblocks in a row: " << context.mblock_meta.hpadded_count);
-    jpg_dbg("Macroblocks in a column: " << context.mblock_meta.vpadded_count);
-
-    // Compute huffman codes for DC and AC tables.
-    for (auto& dc_table : context.dc_tables)
-        generate_huffman_codes(dc_table);
-
-    for (auto& ac_table : context.ac_tables)
-        generate_huffman_codes(ac_table);
-
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            u32 i = vcursor * context.mblock_meta.hpadded_count + hcursor;
-            if (context.dc_reset_interval > 0) {
-                if (i % context.dc_reset_interval == 0) {
-                    context.previous_dc_values[0] = 0;
-                    context.previous_dc_values[1] = 0;
-                    context.previous_dc_values[2] = 0;
-
-                    // Restart markers are stored in byte boundaries. Advance the huffman stream cursor to
-                    //  the 0th bit of the next byte.
-                    if (context.huffman_stream.byte_offset < context.huffman_stream.stream.size()) {
-                        if (context.huffman_stream.bit_offset > 0) {
-                            context.huffman_stream.bit_offset = 0;
-                            context.huffman_stream.byte_offset++;
-                        }
-
-                        // Skip the restart marker (RSTn).
-                        context.huffman_stream.byte_offset++;
-                    }
-                }
-            }
-
-            if (!build_macroblocks(context, macroblocks, hcursor, vcursor)) {
-                dbg() << "Failed to build Macroblock " << i;
-                dbg() << "Huffman stream byte offset " << context.huffman_stream.byte_offset;
-                dbg() << "Huffman stream bit offset " << context.huffman_stream.bit_offset;
-                return {};
-            }
-        }
-    }
-
-    return macroblocks;
-}
-
 static inline bool bounds_okay(const size_t cursor, const size_t delta, const size_t bound)
 {
     return (delta + cursor) < bound;
@@ -798,243 +750,321 @@ static bool skip_marker_with_length(BufferStream& stream)
     return !stream.handle_read_failure();
 }
 
-static void dequantize(JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+// The scale factors of the AAN IDCT in natural order, in 14-bit fixed point. They get folded into the
+// quantization tables, which leaves five multiplications per 1-D transform.
+constexpr static u16 aan_scales[64] {
+    16384, 22725, 21407, 19266, 16384, 12873, 8867, 4520,
+    22725, 31521, 29692, 26722, 22725, 17855, 12299, 6270,
+    21407, 29692, 27969, 25172, 21407, 16819, 11585, 5906,
+    19266, 26722, 25172, 22654, 19266, 15137, 10426, 5315,
+    16384, 22725, 21407, 19266, 16384, 12873, 8867, 4520,
+    12873, 17855, 16819, 15137, 12873, 10114, 6967, 3552,
+    8867, 12299, 11585, 10426, 8867, 6967, 4799, 2446,
+    4520, 6270, 5906, 5315, 4520, 3552, 2446, 1247
+};
+
+// Dequantized coefficients carry this many extra fractional bits through the first pass of the IDCT.
+static constexpr int idct_pass1_bits = 2;
+
+// Multipliers of the IDCT and of the color conversion, in 8-bit and 16-bit fixed point respectively.
+static constexpr i32 fix_1_082392200 = 277;
+static constexpr i32 fix_1_414213562 = 362;
+static constexpr i32 fix_1_847759065 = 473;
+static constexpr i32 fix_2_613125930 = 669;
+static constexpr i32 fix_cr_to_r = 91881;
+static constexpr i32 fix_cb_to_g = 22544;
+static constexpr i32 fix_cr_to_g = 46793;
+static constexpr i32 fix_cb_to_b = 116130;
+
+static void prepare_dequantization_table(const u32* table, i32* multipliers)
 {
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            for (u8 cindex = 0; cindex < context.component_count; cindex++) {
-                auto& component = context.components[cindex];
-                const u32* table = component.qtable_id == 0 ? context.luma_table : context.chroma_table;
-                for (u32 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-                    for (u32 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                        u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                        Macroblock& block = macroblocks[mb_index];
-                        int* block_component = cindex == 0 ? block.y : (cindex == 1 ? block.cb : block.cr);
-                        for (u32 k = 0; k < 64; k++)
-                            block_component[k] *= table[k];
-                    }
-                }
-            }
+    for (int i = 0; i < 64; ++i)
+        multipliers[i] = ((i64)table[i] * aan_scales[i] + (1 << (13 - idct_pass1_bits))) >> (14 - idct_pass1_bits);
+}
+
+// Both the IDCT and the color conversion work on four lanes at a time. They're written with generic
+// vector types, and also get compiled for SSE2 where that's available.
+typedef i32 v4i32 __attribute__((vector_size(16)));
+typedef i32 v4i32_u __attribute__((vector_size(16), aligned(1), may_alias));
+
+// These helpers always get inlined, so passing vectors by value never crosses an actual call boundary.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+ALWAYS_INLINE static v4i32 load_lanes(const i32* ptr) { return *(const v4i32_u*)ptr; }
+ALWAYS_INLINE static void store_lanes(i32* ptr, v4i32 value) { *(v4i32_u*)ptr = value; }
+ALWAYS_INLINE static v4i32 multiply(v4i32 value, i32 constant) { return (value * constant) >> 8; }
+
+ALWAYS_INLINE static void idct_1d(v4i32* v)
+{
+    auto tmp10 = v[0] + v[4];
+    auto tmp11 = v[0] - v[4];
+    auto tmp13 = v[2] + v[6];
+    auto tmp12 = multiply(v[2] - v[6], fix_1_414213562) - tmp13;
+
+    auto even0 = tmp10 + tmp13;
+    auto even3 = tmp10 - tmp13;
+    auto even1 = tmp11 + tmp12;
+    auto even2 = tmp11 - tmp12;
+
+    auto z13 = v[5] + v[3];
+    auto z10 = v[5] - v[3];
+    auto z11 = v[1] + v[7];
+    auto z12 = v[1] - v[7];
+
+    auto odd7 = z11 + z13;
+    auto z5 = multiply(z10 + z12, fix_1_847759065);
+    auto odd6 = multiply(z10, -fix_2_613125930) + z5 - odd7;
+    auto odd5 = multiply(z11 - z13, fix_1_414213562) - odd6;
+    auto odd4 = multiply(z12, fix_1_082392200) - z5 + odd5;
+
+    v[0] = even0 + odd7;
+    v[7] = even0 - odd7;
+    v[1] = even1 + odd6;
+    v[6] = even1 - odd6;
+    v[2] = even2 + odd5;
+    v[5] = even2 - odd5;
+    v[4] = even3 + odd4;
+    v[3] = even3 - odd4;
+}
+
+// Dequantizes and transforms a block in place. The output is centered around zero.
+ALWAYS_INLINE static void do_inverse_dct(i32* block, const i32* multipliers)
+{
+    i32 workspace[64];
+    v4i32 lanes[8];
+
+    // Columns first, four at a time. The results are stored transposed, so the rows can be loaded the same way.
+    for (int half = 0; half < 8; half += 4) {
+        for (int row = 0; row < 8; ++row)
+            lanes[row] = load_lanes(block + row * 8 + half) * load_lanes(multipliers + row * 8 + half);
+        idct_1d(lanes);
+        for (int row = 0; row < 8; ++row) {
+            for (int lane = 0; lane < 4; ++lane)
+                workspace[(half + lane) * 8 + row] = lanes[row][lane];
+        }
+    }
+
+    for (int half = 0; half < 8; half += 4) {
+        for (int column = 0; column < 8; ++column)
+            lanes[column] = load_lanes(workspace + column * 8 + half);
+        idct_1d(lanes);
+        for (int column = 0; column < 8; ++column) {
+            auto result = (lanes[column] + (1 << (idct_pass1_bits + 2))) >> (idct_pass1_bits + 3);
+            for (int lane = 0; lane < 4; ++lane)
+                block[(half + lane) * 8 + column] = result[lane];
         }
     }
 }
 
-static void inverse_dct(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+ALWAYS_INLINE static v4i32 clamp_to_u8(v4i32 value)
 {
-    static const float m0 = 2.0 * cos(1.0 / 16.0 * 2.0 * M_PI);
-    static const float m1 = 2.0 * cos(2.0 / 16.0 * 2.0 * M_PI);
-    static const float m3 = 2.0 * cos(2.0 / 16.0 * 2.0 * M_PI);
-    static const float m5 = 2.0 * cos(3.0 / 16.0 * 2.0 * M_PI);
-    static const float m2 = m0 - m5;
-    static const float m4 = m0 + m5;
-    static const float s0 = cos(0.0 / 16.0 * M_PI) / sqrt(8);
-    static const float s1 = cos(1.0 / 16.0 * M_PI) / 2.0;
-    static const float s2 = cos(2.0 / 16.0 * M_PI) / 2.0;
-    static const float s3 = cos(3.0 / 16.0 * M_PI) / 2.0;
-    static const float s4 = cos(4.0 / 16.0 * M_PI) / 2.0;
-    static const float s5 = cos(5.0 / 16.0 * M_PI) / 2.0;
-    static const float s6 = cos(6.0 / 16.0 * M_PI) / 2.0;
-    static const float s7 = cos(7.0 / 16.0 * M_PI) / 2.0;
+    v4i32 zero = {};
+    v4i32 max = zero + 255;
+    value = value < zero ? zero : value;
+    return value > max ? max : value;
+}
 
-    for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
-        for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            for (u8 cindex = 0; cindex < context.component_count; cindex++) {
-                auto& component = context.components[cindex];
-                for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
-                    for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
-                        u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
-                        Macroblock& block = macroblocks[mb_index];
-                        i32* block_component = cindex == 0 ? block.y : (cindex == 1 ? block.cb : block.cr);
-                        for (u32 k = 0; k < 8; ++k) {
-                            const float g0 = block_component[0 * 8 + k] * s0;
-                            const float g1 = block_component[4 * 8 + k] * s4;
-                            const float g2 = block_component[2 * 8 + k] * s2;
-                            const float g3 = block_component[6 * 8 + k] * s6;
-                            const float g4 = block_component[5 * 8 + k] * s5;
-                            const float g5 = block_component[1 * 8 + k] * s1;
-                            const float g6 = block_component[7 * 8 + k] * s7;
-                            const float g7 = block_component[3 * 8 + k] * s3;
-
-                            const float f0 = g0;
-                            const float f1 = g1;
-                            const float f2 = g2;
-                            const float f3 = g3;
-                            const float f4 = g4 - g7;
-                            const float f5 = g5 + g6;
-                            const float f6 = g5 - g6;
-                            const float f7 = g4 + g7;
-
-                            const float e0 = f0;
-                            const float e1 = f1;
-                            const float e2 = f2 - f3;
-                            const float e3 = f2 + f3;
-                            const float e4 = f4;
-                            const float e5 = f5 - f7;
-                            const float e6 = f6;
-                            const float e7 = f5 + f7;
-                            const float e8 = f4 + f6;
-
-                            const float d0 = e0;
-                            const float d1 = e1;
-                            const float d2 = e2 * m1;
-                            const float d3 = e3;
-                            const float d4 = e4 * m2;
-                            const float d5 = e5 * m3;
-                            const float d6 = e6 * m4;
-                            const float d7 = e7;
-                            const float d8 = e8 * m5;
-
-                            const float c0 = d0 + d1;
-                            const float c1 = d0 - d1;
-                            const float c2 = d2 - d3;
-                            const float c3 = d3;
-                            const float c4 = d4 + d8;
-                            const float c5 = d5 + d7;
-                            const float c6 = d6 - d8;
-                            const float c7 = d7;
-                            const float c8 = c5 - c6;
-
-                            const float b0 = c0 + c3;
-                            const float b1 = c1 + c2;
-                            const float b2 = c1 - c2;
-                            const float b3 = c0 - c3;
-                            const float b4 = c4 - c8;
-                            const float b5 = c8;
-                            const float b6 = c6 - c7;
-                            const float b7 = c7;
-
-                            block_component[0 * 8 + k] = b0 + b7;
-                            block_component[1 * 8 + k] = b1 + b6;
-                            block_component[2 * 8 + k] = b2 + b5;
-                            block_component[3 * 8 + k] = b3 + b4;
-                            block_component[4 * 8 + k] = b3 - b4;
-                            block_component[5 * 8 + k] = b2 - b5;
-                            block_component[6 * 8 + k] = b1 - b6;
-                            block_component[7 * 8 + k] = b0 - b7;
-                        }
-                        for (u32 l = 0; l < 8; ++l) {
-                            const float g0 = block_component[l * 8 + 0] * s0;
-                            const float g1 = block_component[l * 8 + 4] * s4;
-                            const float g2 = block_component[l * 8 + 2] * s2;
-                            const float g3 = block_component[l * 8 + 6] * s6;
-                            const float g4 = block_component[l * 8 + 5] * s5;
-                            const float g5 = block_component[l * 8 + 1] * s1;
-                            const float g6 = block_component[l * 8 + 7] * s7;
-                            const float g7 = block_component[l * 8 + 3] * s3;
-
-                            const float f0 = g0;
-                            const float f1 = g1;
-                            const float f2 = g2;
-                            const float f3 = g3;
-                            const float f4 = g4 - g7;
-                            const float f5 = g5 + g6;
-                            const float f6 = g5 - g6;
-                            const float f7 = g4 + g7;
-
-                            const float e0 = f0;
-                            const float e1 = f1;
-                            const float e2 = f2 - f3;
-                            const float e3 = f2 + f3;
-                            const float e4 = f4;
-                            const float e5 = f5 - f7;
-                            const float e6 = f6;
-                            const float e7 = f5 + f7;
-                            const float e8 = f4 + f6;
-
-                            const float d0 = e0;
-                            const float d1 = e1;
-                            const float d2 = e2 * m1;
-                            const float d3 = e3;
-                            const float d4 = e4 * m2;
-                            const float d5 = e5 * m3;
-                            const float d6 = e6 * m4;
-                            const float d7 = e7;
-                            const float d8 = e8 * m5;
-
-                            const float c0 = d0 + d1;
-                            const float c1 = d0 - d1;
-                            const float c2 = d2 - d3;
-                            const float c3 = d3;
-                            const float c4 = d4 + d8;
-                            const float c5 = d5 + d7;
-                            const float c6 = d6 - d8;
-                            const float c7 = d7;
-                            const float c8 = c5 - c6;
-
-                            const float b0 = c0 + c3;
-                            const float b1 = c1 + c2;
-                            const float b2 = c1 - c2;
-                            const float b3 = c0 - c3;
-                            const float b4 = c4 - c8;
-                            const float b5 = c8;
-                            const float b6 = c6 - c7;
-                            const float b7 = c7;
-
-                            block_component[l * 8 + 0] = b0 + b7;
-                            block_component[l * 8 + 1] = b1 + b6;
-                            block_component[l * 8 + 2] = b2 + b5;
-                            block_component[l * 8 + 3] = b3 + b4;
-                            block_component[l * 8 + 4] = b3 - b4;
-                            block_component[l * 8 + 5] = b2 - b5;
-                            block_component[l * 8 + 6] = b1 - b6;
-                            block_component[l * 8 + 7] = b0 - b7;
-                        }
-                    }
+// Converts four pixels to RGB32.
+ALWAYS_INLINE static v4i32 do_ycbcr_to_rgb(v4i32 y, v4i32 cb, v4i32 cr)
+{
+    y += 128;
+    auto r = clamp_to_u8(y + ((cr * fix_cr_to_r + 32768) >> 16));
+    auto g = clamp_to_u8(y + ((cb * -fix_cb_to_g + cr * -fix_cr_to_g + 32768) >> 16));
+    auto b = clamp_to_u8(y + ((cb * fix_cb_to_b + 32768) >> 16));
+    return (r << 16) | (g << 8) | b | (i32)0xff000000;
+}
+
+ALWAYS_INLINE static void do_ycbcr_row_to_rgb(const i32* y, const i32* cb, const i32* cr, i32* pixels)
+{
+    store_lanes(pixels, do_ycbcr_to_rgb(load_lanes(y), load_lanes(cb), load_lanes(cr)));
+    store_lanes(pixels + 4, do_ycbcr_to_rgb(load_lanes(y + 4), load_lanes(cb + 4), load_lanes(cr + 4)));
+}
+
+// Vectors aren't passed the same way with and without SSE2, so the kernels only take pointers.
+static void inverse_dct_generic(i32* block, const i32* multipliers) { do_inverse_dct(block, multipliers); }
+static void ycbcr_row_to_rgb_generic(const i32* y, const i32* cb, const i32* cr, i32* pixels) { do_ycbcr_row_to_rgb(y, cb, cr, pixels); }
+
+static void (*s_inverse_dct)(i32*, const i32*) = inverse_dct_generic;
+static void (*s_ycbcr_row_to_rgb)(const i32*, const i32*, const i32*, i32*) = ycbcr_row_to_rgb_generic;
+
+#if ARCH(I386) || ARCH(X86_64)
+#    define SSE2 __attribute__((target("sse2")))
+
+SSE2 static void inverse_dct_sse2(i32* block, const i32* multipliers) { do_inverse_dct(block, multipliers); }
+SSE2 static void ycbcr_row_to_rgb_sse2(const i32* y, const i32* cb, const i32* cr, i32* pixels) { do_ycbcr_row_to_rgb(y, cb, cr, pixels); }
+#endif
+
+static void select_kernels()
+{
+    static bool s_selected;
+    if (s_selected)
+        return;
+    s_selected = true;
+#if ARCH(X86_64)
+    bool has_sse2 = true;
+#elif ARCH(I386)
+    u32 eax, ebx, ecx, edx;
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(1), "c"(0));
+    bool has_sse2 = edx & (1 << 26);
+#endif
+#if ARCH(I386) || ARCH(X86_64)
+    if (has_sse2) {
+        s_inverse_dct = inverse_dct_sse2;
+        s_ycbcr_row_to_rgb = ycbcr_row_to_rgb_sse2;
+    }
+#endif
+}
+
+static void inverse_dct(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks, u32 hcursor)
+{
+    for (u8 cindex = 0; cindex < context.component_count; cindex++) {
+        auto& component = context.components[cindex];
+        const i32* multipliers = component.qtable_id == 0 ? context.luma_multipliers : context.chroma_multipliers;
+        for (u8 vfactor_i = 0; vfactor_i < component.vsample_factor; vfactor_i++) {
+            for (u8 hfactor_i = 0; hfactor_i < component.hsample_factor; hfactor_i++) {
+                u32 mb_index = vfactor_i * context.mblock_meta.hpadded_count + (hfactor_i + hcursor);
+                Macroblock& block = macroblocks[mb_index];
+                s_inverse_dct(cindex == 0 ? block.y : (cindex == 1 ? block.cb : block.cr), multipliers);
+            }
+        }
+    }
+}
+
+static void compose_bitmap(JPGLoadingContext& context, const Vector<Macroblock>& macroblocks, u32 vcursor, u32 hcursor)
+{
+    // The chroma of all the blocks in an MCU is stored in its first block.
+    const Macroblock& chroma = macroblocks[hcursor];
+    for (u8 vfactor_i = 0; vfactor_i < context.vsample_factor; vfactor_i++) {
+        for (u8 hfactor_i = 0; hfactor_i < context.hsample_factor; hfactor_i++) {
+            u32 x = (hcursor + hfactor_i) * 8;
+            if (x >= context.frame.width)
+                continue;
+            u32 width = min(8u, context.frame.width - x);
+            const i32* y = macroblocks[vfactor_i * context.mblock_meta.hpadded_count + (hcursor + hfactor_i)].y;
+            for (u32 i = 0; i < 8; i++) {
+                u32 pixel_row = (vcursor + vfactor_i) * 8 + i;
+                if (pixel_row >= context.frame.height)
+                    break;
+                i32 cb[8];
+                i32 cr[8];
+                const u32 chroma_pxrow = (i / context.vsample_factor) + 4 * vfactor_i;
+                for (u32 j = 0; j < 8; j++) {
+                    const u32 chroma_pixel = chroma_pxrow * 8 + (j / context.hsample_factor) + 4 * hfactor_i;
+                    cb[j] = chroma.cb[chroma_pixel];
+                    cr[j] = chroma.cr[chroma_pixel];
                 }
+                i32 pixels[8];
+                s_ycbcr_row_to_rgb(y + i * 8, cb, cr, pixels);
+                memcpy(context.bitmap->scanline(pixel_row) + x, pixels, width * sizeof(RGBA32));
             }
         }
     }
 }
 
-static void ycbcr_to_rgb(const JPGLoadingContext& context, Vector<Macroblock>& macroblocks)
+// Without any AC coefficients, the inverse DCT of a block is flat: every pixel is an eighth of its
+// dequantized DC coefficient. So at an eighth of the size, we can skip the transform altogether.
+static void compose_bitmap_from_dc(JPGLoadingContext& context, const Vector<Macroblock>& macroblocks, u32 vcursor, u32 hcursor)
 {
+    auto dequantize_dc = [&](u8 cindex, i32 coefficient) {
+        const u32* table = context.components[cindex].qtable_id == 0 ? context.luma_table : context.chroma_table;
+        return (coefficient * (i32)table[0] + 4) >> 3;
+    };
+
+    // The chroma of all the blocks in an MCU is stored in its first block.
+    const Macroblock& chroma = macroblocks[hcursor];
+    v4i32 zero = {};
+    auto cb = zero + dequantize_dc(1, chroma.cb[0]);
+    auto cr = zero + dequantize_dc(2, chroma.cr[0]);
+    for (u8 vfactor_i = 0; vfactor_i < context.vsample_factor; vfactor_i++) {
+        u32 pixel_row = vcursor + vfactor_i;
+        if (pixel_row >= (u32)context.bitmap->height())
+            break;
+        for (u8 hfactor_i = 0; hfactor_i < context.hsample_factor; hfactor_i++) {
+            u32 x = hcursor + hfactor_i;
+            if (x >= (u32)context.bitmap->width())
+                continue;
+            auto y = zero + dequantize_dc(0, macroblocks[vfactor_i * context.mblock_meta.hpadded_count + x].y[0]);
+            context.bitmap->scanline(pixel_row)[x] = do_ycbcr_to_rgb(y, cb, cr)[0];
+        }
+    }
+}
+
+// Decodes one row of MCUs at a time and writes it straight to the bitmap,
+// so that only a single row's worth of coefficients is ever held in memory.
+static bool decode_huffman_stream(JPGLoadingContext& context)
+{
+    jpg_dbg("Image width: " << context.frame.width);
+    jpg_dbg("Image height: " << context.frame.height);
+    jpg_dbg("Macroblocks in a row: " << context.mblock_meta.hpadded_count);
+    jpg_dbg("Macroblocks in a column: " << context.mblock_meta.vpadded_count);
+
+    // Compute huffman codes for DC and AC tables.
+    for (auto& dc_table : context.dc_tables)
+        generate_huffman_codes(dc_table);
+
+    for (auto& ac_table : context.ac_tables)
+        generate_huffman_codes(ac_table);
+
+    select_kernels();
+    prepare_dequantization_table(context.luma_table, context.luma_multipliers);
+    prepare_dequantization_table(context.chroma_table, context.chroma_multipliers);
+
+    IntSize size { context.frame.width, context.frame.height };
+    if (context.decode_at_eighth_size)
+        size = { (size.width() + 7) / 8, (size.height() + 7) / 8 };
+    context.bitmap = Bitmap::create_purgeable(BitmapFormat::RGB32, size);
+    if (!context.bitmap)
+        return false;
+
+    Vector<Macroblock> macroblocks;
+    macroblocks.resize(context.mblock_meta.hpadded_count * context.vsample_factor);
+
     for (u32 vcursor = 0; vcursor < context.mblock_meta.vcount; vcursor += context.vsample_factor) {
+        // Only the non-zero coefficients are written while decoding.
+        for (auto& block : macroblocks)
+            block = {};
+
         for (u32 hcursor = 0; hcursor < context.mblock_meta.hcount; hcursor += context.hsample_factor) {
-            const u32 chroma_block_index = vcursor * context.mblock_meta.hpadded_count + hcursor;
-            const Macroblock& chroma = macroblocks[chroma_block_index];
-            // Overflows are intentional.
-            for (u8 vfactor_i = context.vsample_factor - 1; vfactor_i < context.vsample_factor; --vfactor_i) {
-                for (u8 hfactor_i = context.hsample_factor - 1; hfactor_i < context.hsample_factor; --hfactor_i) {
-                    u32 mb_index = (vcursor + vfactor_i) * context.mblock_meta.hpadded_count + (hcursor + hfactor_i);
-                    i32* y = macroblocks[mb_index].y;
-                    i32* cb = macroblocks[mb_index].cb;
-                    i32* cr = macroblocks[mb_index].cr;
-                    for (u8 i = 7; i < 8; --i) {
-                        for (u8 j = 7; j < 8; --j) {
-                            const u8 pixel = i * 8 + j;
-                            const u32 chroma_pxrow = (i / context.vsample_factor) + 4 * vfactor_i;
-                            const u32 chroma_pxcol = (j / context.hsample_factor) + 4 * hfactor_i;
-                            const u32 chroma_pixel = chroma_pxrow * 8 + chroma_pxcol;
-                            int r = y[pixel] + 1.402f * chroma.cr[chroma_pixel] + 128;
-                            int g = y[pixel] - 0.344f * chroma.cb[chroma_pixel] - 0.714f * chroma.cr[chroma_pixel] + 128;
-                            int b = y[pixel] + 1.772f * chroma.cb[chroma_pixel] + 128;
-                            y[pixel] = r < 0 ? 0 : (r > 255 ? 255 : r);
-                            cb[pixel] = g < 0 ? 0 : (g > 255 ? 255 : g);
-                            cr[pixel] = b < 0 ? 0 : (b > 255 ? 255 : b);
+            u32 i = vcursor * context.mblock_meta.hpadded_count + hcursor;
+            if (context.dc_reset_interval > 0) {
+                if (i % context.dc_reset_interval == 0) {
+                    context.previous_dc_values[0] = 0;
+                    context.previous_dc_values[1] = 0;
+                    context.previous_dc_values[2] = 0;
+
+                    // Restart markers are stored in byte boundaries. Advance the huffman stream cursor to
+                    //  the 0th bit of the next byte.
+                    if (context.huffman_stream.byte_offset < context.huffman_stream.stream.size()) {
+                        if (context.huffman_stream.bit_offset > 0) {
+                            context.huffman_stream.bit_offset = 0;
+                            context.huffman_stream.byte_offset++;
                         }
+
+                        // Skip the restart marker (RSTn).
+                        context.huffman_stream.byte_offset++;
                     }
                 }
             }
-        }
-    }
-}
 
-static void compose_bitmap(JPGLoadingContext& context, const Vector<Macroblock>& macroblocks)
-{
-    context.bitmap = Bitmap::create_purgeable(BitmapFormat::RGB32, { context.frame.width, context.frame.height });
-
-    for (u32 y = context.frame.height - 1; y < context.frame.height; y--) {
-        const u32 block_row = y / 8;
-        const u32 pixel_row = y % 8;
-        for (u32 x = 0; x < context.frame.width; x++) {
-            const u32 block_column = x / 8;
-            auto& block = macroblocks[block_row * context.mblock_meta.hpadded_count + block_column];
-            const u32 pixel_column = x % 8;
-            const u32 pixel_index = pixel_row * 8 + pixel_column;
-            const Color color { (u8)block.y[pixel_index], (u8)block.cb[pixel_index], (u8)block.cr[pixel_index] };
-            context.bitmap->set_pixel(x, y, color);
+            if (!build_macroblocks(context, macroblocks, hcursor, 0)) {
+                dbg() << "Failed to build Macroblock " << i;
+                dbg() << "Huffman stream byte offset " << context.huffman_stream.byte_offset;
+                dbg() << "Huffman stream bit offset " << context.huffman_stream.bit_offset;
+                return false;
+            }
+
+            if (context.decode_at_eighth_size) {
+                compose_bitmap_from_dc(context, macroblocks, vcursor, hcursor);
+                continue;
+            }
+            inverse_dct(context, macroblocks, hcursor);
+            compose_bitmap(context, macroblocks, vcursor, hcursor);
         }
     }
+
+    return true;
 }
 
 static bool parse_header(BufferStream& stream, JPGLoadingContext& context)
@@ -1153,26 +1183,21 @@ static bool decode_jpg(JPGLoadingContext& context)
     if (!scan_huffman_stream(stream, context))
         return false;
 
-    auto result = decode_huffman_stream(context);
-    if (!result.has_value()) {
+    if (!decode_huffman_stream(context)) {
         dbg() << stream.offset() << ": Failed to decode Macroblocks!";
+        context.bitmap = nullptr;
         return false;
     }
 
-    auto macroblocks = result.release_value();
-    dbg() << String::format("%i macroblocks decoded successfully :^)", macroblocks.size());
-    dequantize(context, macroblocks);
-    inverse_dct(context, macroblocks);
-    ycbcr_to_rgb(context, macroblocks);
-    compose_bitmap(context, macroblocks);
     return true;
 }
 
-static RefPtr<Gfx::Bitmap> load_jpg_impl(const u8* data, size_t data_size)
+static RefPtr<Gfx::Bitmap> load_jpg_impl(const u8* data, size_t data_size, bool decode_at_eighth_size = false)
 {
     JPGLoadingContext context;
     context.data = data;
     context.data_size = data_size;
+    context.decode_at_eighth_size = decode_at_eighth_size;
 
     if (!decode_jpg(context))
         return nullptr;
@@ -1193,6 +1218,18 @@ RefPtr<Gfx::Bitmap> load_jpg(const StringView& path)
     return bitmap;
 }
 
+RefPtr<Gfx::Bitmap> load_jpg_at_eighth_size(const StringView& path)
+{
+    MappedFile mapped_file(path);
+    if (!mapped_file.is_valid())
+        return nullptr;
+
+    auto bitmap = load_jpg_impl((const u8*)mapped_file.data(), mapped_file.size(), true);
+    if (bitmap)
+        bitmap->set_mmap_name(String::format("Gfx::Bitmap [%dx%d] - Decoded JPG at 1/8: %s", bitmap->width(), bitmap->height(), LexicalPath::canonicalized_path(path).characters()));
+    return bitmap;
+}
+
 RefPtr<Gfx::Bitmap> load_jpg_from_memory(const u8* data, size_t length)
 {
     auto bitmap = load_jpg_impl(data, length);
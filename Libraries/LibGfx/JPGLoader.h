@@ -35,6 +35,9 @@ namespace Gfx {
 
 RefPtr<Gfx::Bitmap> load_jpg(const StringView& path);
 RefPtr<Gfx::Bitmap> load_jpg_from_memory(const u8* data, size_t length);
+// Only looks at the DC coefficient of each 8x8 block, which makes it a lot cheaper than load_jpg().
+// Handy when the image is going to be scaled down anyway.
+RefPtr<Gfx::Bitmap> load_jpg_at_eighth_size(const StringView& path);
 
 struct JPGLoadingContext;
 
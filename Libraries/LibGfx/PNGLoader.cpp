@@ -28,20 +28,15 @@
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
 #include <AK/NetworkOrdered.h>
-#include <LibCore/puff.h>
+#include <LibCompress/Zlib.h>
 #include <LibGfx/PNGLoader.h>
 #include <fcntl.h>
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
-#ifdef __serenity__
-#    include <serenity.h>
-#endif
-
 //#define PNG_DEBUG
 
 namespace Gfx {
@@ -60,11 +55,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    u8 filter { 0 };
-    ByteBuffer data {};
-};
-
 struct [[gnu::packed]] PaletteEntry
 {
     u8 r;
@@ -124,11 +114,8 @@ struct PNGLoadingContext {
     u8 channels { 0 };
     bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4 || palette_transparency_data.size() > 0; }
-    Vector<Scanline> scanlines;
     RefPtr<Gfx::Bitmap> bitmap;
-    u8* decompression_buffer { nullptr };
-    size_t decompression_buffer_size { 0 };
-    Vector<u8> compressed_data;
+    Vector<ReadonlyBytes> compressed_chunks;
     Vector<PaletteEntry> palette_data;
     Vector<u8> palette_transparency_data;
 };
@@ -179,6 +166,61 @@ private:
     size_t m_size_remaining { 0 };
 };
 
+// Hands out the contents of all IDAT chunks as one continuous stream, without copying them together first.
+class IDATStream final : public InputStream {
+public:
+    explicit IDATStream(const Vector<ReadonlyBytes>& chunks)
+        : m_chunks(chunks)
+    {
+    }
+
+    size_t read(Bytes bytes) override
+    {
+        size_t nread = 0;
+        while (nread < bytes.size() && m_chunk_index < m_chunks.size()) {
+            auto chunk = m_chunks[m_chunk_index].slice(m_chunk_offset);
+            auto count = chunk.copy_trimmed_to(bytes.slice(nread));
+            nread += count;
+            m_chunk_offset += count;
+            if (m_chunk_offset == m_chunks[m_chunk_index].size()) {
+                ++m_chunk_index;
+                m_chunk_offset = 0;
+            }
+        }
+        return nread;
+    }
+
+    bool read_or_error(Bytes bytes) override
+    {
+        if (read(bytes) < bytes.size()) {
+            m_error = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool eof() const override { return m_chunk_index == m_chunks.size(); }
+
+    bool discard_or_error(size_t count) override
+    {
+        u8 buffer[256];
+        while (count) {
+            auto nread = read({ buffer, min(count, sizeof(buffer)) });
+            if (!nread) {
+                m_error = true;
+                return false;
+            }
+            count -= nread;
+        }
+        return true;
+    }
+
+private:
+    const Vector<ReadonlyBytes>& m_chunks;
+    size_t m_chunk_index { 0 };
+    size_t m_chunk_offset { 0 };
+};
+
 static RefPtr<Gfx::Bitmap> load_png_impl(const u8*, size_t);
 static bool process_chunk(Streamer&, PNGLoadingContext& context);
 
@@ -310,74 +352,65 @@ ALWAYS_INLINE static void unfilter_impl(Gfx::Bitmap& bitmap, int y, const void*
 }
 
 template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_without_alpha(PNGLoadingContext& context)
+ALWAYS_INLINE static void unpack_grayscale_without_alpha(PNGLoadingContext& context, int y, const u8* data)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* gray_values = reinterpret_cast<const T*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = gray_values[i];
-            pixel.g = gray_values[i];
-            pixel.b = gray_values[i];
-            pixel.a = 0xff;
-        }
+    auto* gray_values = reinterpret_cast<const T*>(data);
+    for (int i = 0; i < context.width; ++i) {
+        auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
+        pixel.r = gray_values[i];
+        pixel.g = gray_values[i];
+        pixel.b = gray_values[i];
+        pixel.a = 0xff;
     }
 }
 
 template<typename T>
-ALWAYS_INLINE static void unpack_grayscale_with_alpha(PNGLoadingContext& context)
+ALWAYS_INLINE static void unpack_grayscale_with_alpha(PNGLoadingContext& context, int y, const u8* data)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* tuples = reinterpret_cast<const Tuple<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = tuples[i].gray;
-            pixel.g = tuples[i].gray;
-            pixel.b = tuples[i].gray;
-            pixel.a = tuples[i].a;
-        }
+    auto* tuples = reinterpret_cast<const Tuple<T>*>(data);
+    for (int i = 0; i < context.width; ++i) {
+        auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
+        pixel.r = tuples[i].gray;
+        pixel.g = tuples[i].gray;
+        pixel.b = tuples[i].gray;
+        pixel.a = tuples[i].a;
     }
 }
 
 template<typename T>
-ALWAYS_INLINE static void unpack_triplets_without_alpha(PNGLoadingContext& context)
+ALWAYS_INLINE static void unpack_triplets_without_alpha(PNGLoadingContext& context, int y, const u8* data)
 {
-    for (int y = 0; y < context.height; ++y) {
-        auto* triplets = reinterpret_cast<const Triplet<T>*>(context.scanlines[y].data.data());
-        for (int i = 0; i < context.width; ++i) {
-            auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-            pixel.r = triplets[i].r;
-            pixel.g = triplets[i].g;
-            pixel.b = triplets[i].b;
-            pixel.a = 0xff;
-        }
+    auto* triplets = reinterpret_cast<const Triplet<T>*>(data);
+    for (int i = 0; i < context.width; ++i) {
+        auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
+        pixel.r = triplets[i].r;
+        pixel.g = triplets[i].g;
+        pixel.b = triplets[i].b;
+        pixel.a = 0xff;
     }
 }
 
-NEVER_INLINE FLATTEN static void unfilter(PNGLoadingContext& context)
+NEVER_INLINE FLATTEN static void unfilter_scanline(PNGLoadingContext& context, int y, u8 filter, const u8* data, const u8* dummy_scanline)
 {
-    // First unpack the scanlines to RGBA:
+    // First unpack the scanline to RGBA:
     switch (context.color_type) {
     case 0:
         if (context.bit_depth == 8) {
-            unpack_grayscale_without_alpha<u8>(context);
+            unpack_grayscale_without_alpha<u8>(context, y, data);
         } else if (context.bit_depth == 16) {
-            unpack_grayscale_without_alpha<u16>(context);
+            unpack_grayscale_without_alpha<u16>(context, y, data);
         } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
             auto bit_depth_squared = context.bit_depth * context.bit_depth;
             auto pixels_per_byte = 8 / context.bit_depth;
             auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* gray_values = (u8*)context.scanlines[y].data.data();
-                for (int x = 0; x < context.width; ++x) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
-                    auto value = (gray_values[x / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[x];
-                    pixel.r = value * (0xff / bit_depth_squared);
-                    pixel.g = value * (0xff / bit_depth_squared);
-                    pixel.b = value * (0xff / bit_depth_squared);
-                    pixel.a = 0xff;
-                }
+            for (int x = 0; x < context.width; ++x) {
+                auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (x % pixels_per_byte));
+                auto value = (data[x / pixels_per_byte] >> bit_offset) & mask;
+                auto& pixel = (Pixel&)context.bitmap->scanline(y)[x];
+                pixel.r = value * (0xff / bit_depth_squared);
+                pixel.g = value * (0xff / bit_depth_squared);
+                pixel.b = value * (0xff / bit_depth_squared);
+                pixel.a = 0xff;
             }
         } else {
             ASSERT_NOT_REACHED();
@@ -385,37 +418,33 @@ NEVER_INLINE FLATTEN static void unfilter(PNGLoadingContext& context)
         break;
     case 4:
         if (context.bit_depth == 8) {
-            unpack_grayscale_with_alpha<u8>(context);
+            unpack_grayscale_with_alpha<u8>(context, y, data);
         } else if (context.bit_depth == 16) {
-            unpack_grayscale_with_alpha<u16>(context);
+            unpack_grayscale_with_alpha<u16>(context, y, data);
         } else {
             ASSERT_NOT_REACHED();
         }
         break;
     case 2:
         if (context.bit_depth == 8) {
-            unpack_triplets_without_alpha<u8>(context);
+            unpack_triplets_without_alpha<u8>(context, y, data);
         } else if (context.bit_depth == 16) {
-            unpack_triplets_without_alpha<u16>(context);
+            unpack_triplets_without_alpha<u16>(context, y, data);
         } else {
             ASSERT_NOT_REACHED();
         }
         break;
     case 6:
         if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                memcpy(context.bitmap->scanline(y), context.scanlines[y].data.data(), context.scanlines[y].data.size());
-            }
+            memcpy(context.bitmap->scanline(y), data, context.width * sizeof(RGBA32));
         } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* triplets = reinterpret_cast<const Quad<u16>*>(context.scanlines[y].data.data());
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = triplets[i].r & 0xFF;
-                    pixel.g = triplets[i].g & 0xFF;
-                    pixel.b = triplets[i].b & 0xFF;
-                    pixel.a = triplets[i].a & 0xFF;
-                }
+            auto* triplets = reinterpret_cast<const Quad<u16>*>(data);
+            for (int i = 0; i < context.width; ++i) {
+                auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
+                pixel.r = triplets[i].r & 0xFF;
+                pixel.g = triplets[i].g & 0xFF;
+                pixel.b = triplets[i].b & 0xFF;
+                pixel.a = triplets[i].a & 0xFF;
             }
         } else {
             ASSERT_NOT_REACHED();
@@ -423,38 +452,34 @@ NEVER_INLINE FLATTEN static void unfilter(PNGLoadingContext& context)
         break;
     case 3:
         if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_index = (u8*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    auto& color = context.palette_data.at((int)palette_index[i]);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1u
-                        ? context.palette_transparency_data.data()[palette_index[i]]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
+            auto* palette_index = data;
+            for (int i = 0; i < context.width; ++i) {
+                auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
+                auto& color = context.palette_data.at((int)palette_index[i]);
+                auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1u
+                    ? context.palette_transparency_data.data()[palette_index[i]]
+                    : 0xff;
+                pixel.r = color.r;
+                pixel.g = color.g;
+                pixel.b = color.b;
+                pixel.a = transparency;
             }
         } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
             auto pixels_per_byte = 8 / context.bit_depth;
             auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_indexes = (u8*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
-                    auto palette_index = (palette_indexes[i / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    auto& color = context.palette_data.at(palette_index);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index + 1u
-                        ? context.palette_transparency_data.data()[palette_index]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
+            auto* palette_indexes = data;
+            for (int i = 0; i < context.width; ++i) {
+                auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
+                auto palette_index = (palette_indexes[i / pixels_per_byte] >> bit_offset) & mask;
+                auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
+                auto& color = context.palette_data.at(palette_index);
+                auto transparency = context.palette_transparency_data.size() >= palette_index + 1u
+                    ? context.palette_transparency_data.data()[palette_index]
+                    : 0xff;
+                pixel.r = color.r;
+                pixel.g = color.g;
+                pixel.b = color.b;
+                pixel.a = transparency;
             }
         } else {
             ASSERT_NOT_REACHED();
@@ -465,45 +490,40 @@ NEVER_INLINE FLATTEN static void unfilter(PNGLoadingContext& context)
         break;
     }
 
-    auto dummy_scanline = ByteBuffer::create_zeroed(context.width * sizeof(RGBA32));
-
-    for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
+    // ...then undo the filter, which needs the previous scanline to be done already.
+    if (filter == 0) {
+        if (context.has_alpha())
+            unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline);
+        else
+            unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline);
+        return;
+    }
+    if (filter == 1) {
+        if (context.has_alpha())
+            unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline);
+        else
+            unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline);
+        return;
+    }
+    if (filter == 2) {
+        if (context.has_alpha())
+            unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline);
+        else
+            unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline);
+        return;
+    }
+    if (filter == 3) {
+        if (context.has_alpha())
+            unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline);
+        else
+            unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline);
+        return;
+    }
+    if (filter == 4) {
+        if (context.has_alpha())
+            unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline);
+        else
+            unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline);
     }
 }
 
@@ -573,8 +593,6 @@ static bool decode_png_chunks(PNGLoadingContext& context)
     const u8* data_ptr = context.data + sizeof(png_header);
     int data_remaining = context.data_size - sizeof(png_header);
 
-    context.compressed_data.ensure_capacity(context.data_size);
-
     Streamer streamer(data_ptr, data_remaining);
     while (!streamer.at_end()) {
         if (!process_chunk(streamer, context)) {
@@ -587,37 +605,39 @@ static bool decode_png_chunks(PNGLoadingContext& context)
     return true;
 }
 
-static bool decode_png_bitmap_simple(PNGLoadingContext& context)
+// Reads the scanlines of an image from the decompressed data, and unfilters each as soon as it's complete.
+static bool decode_png_scanlines(PNGLoadingContext& context, InputStream& stream)
 {
-    Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
+    auto row_size = ((context.width * context.channels * context.bit_depth) + 7) / 8;
+    auto row_buffer = ByteBuffer::create_uninitialized(row_size);
+    auto dummy_scanline = ByteBuffer::create_zeroed(context.width * sizeof(RGBA32));
 
     for (int y = 0; y < context.height; ++y) {
         u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
+        if (!stream.read_or_error({ &filter, sizeof(filter) }))
             return false;
-        }
 
         if (filter > 4) {
             dbg() << "Invalid PNG filter: " << filter;
-            context.state = PNGLoadingContext::State::Error;
             return false;
         }
 
-        context.scanlines.append({ filter });
-        auto& scanline_buffer = context.scanlines.last().data;
-        auto row_size = ((context.width * context.channels * context.bit_depth) + 7) / 8;
-        if (!streamer.wrap_bytes(scanline_buffer, row_size)) {
-            context.state = PNGLoadingContext::State::Error;
+        if (!stream.read_or_error(row_buffer.bytes()))
             return false;
-        }
+
+        unfilter_scanline(context, y, filter, row_buffer.data(), dummy_scanline.data());
     }
 
-    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
+    return true;
+}
 
-    unfilter(context);
+static bool decode_png_bitmap_simple(PNGLoadingContext& context, InputStream& stream)
+{
+    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
+    if (!context.bitmap)
+        return false;
 
-    return true;
+    return decode_png_scanlines(context, stream);
 }
 
 static int adam7_height(PNGLoadingContext& context, int pass)
@@ -670,7 +690,7 @@ static int adam7_startx[8] = { 0, 0, 4, 0, 2, 0, 1, 0 };
 static int adam7_stepy[8] = { 1, 8, 8, 8, 4, 4, 2, 2 };
 static int adam7_stepx[8] = { 1, 8, 8, 4, 4, 2, 2, 1 };
 
-static bool decode_adam7_pass(PNGLoadingContext& context, Streamer& streamer, int pass)
+static bool decode_adam7_pass(PNGLoadingContext& context, InputStream& stream, int pass)
 {
     PNGLoadingContext subimage_context;
     subimage_context.width = adam7_width(context, pass);
@@ -686,31 +706,9 @@ static bool decode_adam7_pass(PNGLoadingContext& context, Streamer& streamer, in
     if (!subimage_context.width || !subimage_context.height)
         return true;
 
-    subimage_context.scanlines.clear_with_capacity();
-    for (int y = 0; y < subimage_context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-
-        if (filter > 4) {
-            dbg() << "Invalid PNG filter: " << filter;
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-
-        subimage_context.scanlines.append({ filter });
-        auto& scanline_buffer = subimage_context.scanlines.last().data;
-        auto row_size = ((subimage_context.width * context.channels * context.bit_depth) + 7) / 8;
-        if (!streamer.wrap_bytes(scanline_buffer, row_size)) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-    }
-
     subimage_context.bitmap = Bitmap::create(context.bitmap->format(), { subimage_context.width, subimage_context.height });
-    unfilter(subimage_context);
+    if (!subimage_context.bitmap || !decode_png_scanlines(subimage_context, stream))
+        return false;
 
     // Copy the subimage data into the main image according to the pass pattern
     for (int y = 0, dy = adam7_starty[pass]; y < subimage_context.height && dy < context.height; ++y, dy += adam7_stepy[pass]) {
@@ -721,13 +719,14 @@ static bool decode_adam7_pass(PNGLoadingContext& context, Streamer& streamer, in
     return true;
 }
 
-static bool decode_png_adam7(PNGLoadingContext& context)
+static bool decode_png_adam7(PNGLoadingContext& context, InputStream& stream)
 {
-    Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
     context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
+    if (!context.bitmap)
+        return false;
 
     for (int pass = 1; pass <= 7; ++pass) {
-        if (!decode_adam7_pass(context, streamer, pass))
+        if (!decode_adam7_pass(context, stream, pass))
             return false;
     }
     return true;
@@ -743,44 +742,30 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
     if (context.state >= PNGLoadingContext::State::BitmapDecoded)
         return true;
 
-    unsigned long srclen = context.compressed_data.size() - 6;
-    unsigned long destlen = 0;
-    int ret = puff(NULL, &destlen, context.compressed_data.data() + 2, &srclen);
-    if (ret != 0) {
-        context.state = PNGLoadingContext::State::Error;
-        return false;
-    }
-    context.decompression_buffer_size = destlen;
-#ifdef __serenity__
-    context.decompression_buffer = (u8*)mmap_with_name(nullptr, context.decompression_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, "PNG decompression buffer");
-#else
-    context.decompression_buffer = (u8*)mmap(nullptr, context.decompression_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
-#endif
-
-    ret = puff(context.decompression_buffer, &destlen, context.compressed_data.data() + 2, &srclen);
-    if (ret != 0) {
-        context.state = PNGLoadingContext::State::Error;
-        return false;
-    }
-    context.compressed_data.clear();
+    IDATStream idat_stream { context.compressed_chunks };
+    Compress::ZlibStream zlib_stream { idat_stream };
 
-    context.scanlines.ensure_capacity(context.height);
+    bool success = false;
     switch (context.interlace_method) {
     case PngInterlaceMethod::Null:
-        if (!decode_png_bitmap_simple(context))
-            return false;
+        success = decode_png_bitmap_simple(context, zlib_stream);
         break;
     case PngInterlaceMethod::Adam7:
-        if (!decode_png_adam7(context))
-            return false;
+        success = decode_png_adam7(context, zlib_stream);
         break;
     default:
         ASSERT_NOT_REACHED();
     }
 
-    munmap(context.decompression_buffer, context.decompression_buffer_size);
-    context.decompression_buffer = nullptr;
-    context.decompression_buffer_size = 0;
+    zlib_stream.handle_error();
+    idat_stream.handle_error();
+    context.compressed_chunks.clear();
+
+    if (!success) {
+        context.bitmap = nullptr;
+        context.state = PNGLoadingContext::State::Error;
+        return false;
+    }
 
     context.state = PNGLoadingContext::State::BitmapDecoded;
     return true;
@@ -851,7 +836,7 @@ static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context)
 
 static bool process_IDAT(const ByteBuffer& data, PNGLoadingContext& context)
 {
-    context.compressed_data.append(data.data(), data.size());
+    context.compressed_chunks.append(data.bytes());
     return true;
 }
 
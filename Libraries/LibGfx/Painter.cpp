@@ -36,6 +36,7 @@
 #include <AK/StringBuilder.h>
 #include <AK/Utf32View.h>
 #include <AK/Utf8View.h>
+#include <LibGfx/Blending.h>
 #include <LibGfx/CharacterBitmap.h>
 #include <LibGfx/Path.h>
 #include <math.h>
@@ -135,9 +136,9 @@ void Painter::fill_rect(const IntRect& a_rect, Color color)
     RGBA32* dst = m_target->scanline(rect.top()) + rect.left();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
+    auto& functions = blend_functions();
     for (int i = rect.height() - 1; i >= 0; --i) {
-        for (int j = 0; j < rect.width(); ++j)
-            dst[j] = Color::from_rgba(dst[j]).blend(color).value();
+        functions.blend_color(dst, color, rect.width());
         dst += dst_skip;
     }
 }
@@ -446,22 +447,25 @@ void Painter::blit_scaled(const IntRect& dst_rect_raw, const Gfx::Bitmap& source
     RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
+    // Step through the source in 16.16 fixed point instead of scaling every coordinate separately.
+    i64 hstep = hscale * 65536;
+    i64 vstep = vscale * 65536;
     int x_start = first_column + src_rect.left();
     for (int row = first_row; row <= last_row; ++row) {
-        int sr = (row + src_rect.top()) * vscale;
+        int sr = ((row + src_rect.top()) * vstep) >> 16;
         if (sr >= source.size().height() || sr < 0) {
             dst += dst_skip;
             continue;
         }
         const RGBA32* sl = source.scanline(sr);
-        for (int x = x_start; x < clipped_rect.width() + x_start; ++x) {
-            int sx = x * hscale;
+        i64 position = x_start * hstep;
+        for (int i = 0; i < clipped_rect.width(); ++i, position += hstep) {
+            int sx = position >> 16;
             if (sx < source.size().width() && sx >= 0)
-                dst[x - x_start] = sl[sx];
+                dst[i] = sl[sx];
         }
         dst += dst_skip;
     }
-    return;
 }
 
 void Painter::blit_with_opacity(const IntPoint& position, const Gfx::Bitmap& source, const IntRect& src_rect, float opacity)
@@ -490,13 +494,9 @@ void Painter::blit_with_opacity(const IntPoint& position, const Gfx::Bitmap& sou
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const unsigned src_skip = source.pitch() / sizeof(RGBA32);
 
+    auto& functions = blend_functions();
     for (int row = first_row; row <= last_row; ++row) {
-        for (int x = 0; x <= (last_column - first_column); ++x) {
-            Color src_color_with_alpha = Color::from_rgb(src[x]);
-            src_color_with_alpha.set_alpha(alpha);
-            Color dst_color = Color::from_rgb(dst[x]);
-            dst[x] = dst_color.blend(src_color_with_alpha).value();
-        }
+        functions.blend_opaque_with_alpha(dst, src, last_column - first_column + 1, alpha);
         dst += dst_skip;
         src += src_skip;
     }
@@ -629,16 +629,9 @@ void Painter::blit_with_alpha(const IntPoint& position, const Gfx::Bitmap& sourc
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+    auto& functions = blend_functions();
     for (int row = first_row; row <= last_row; ++row) {
-        for (int x = 0; x <= (last_column - first_column); ++x) {
-            u8 alpha = Color::from_rgba(src[x]).alpha();
-            if (alpha == 0xff)
-                dst[x] = src[x];
-            else if (!alpha)
-                continue;
-            else
-                dst[x] = Color::from_rgba(dst[x]).blend(Color::from_rgba(src[x])).value();
-        }
+        functions.blend(dst, src, last_column - first_column + 1);
         dst += dst_skip;
         src += src_skip;
     }
@@ -688,10 +681,35 @@ void Painter::blit(const IntPoint& position, const Gfx::Bitmap& source, const In
     ASSERT_NOT_REACHED();
 }
 
+// Scaled pixels are gathered this many at a time, so that blending can work on whole runs of them.
+static constexpr int scaled_pixel_chunk_size = 256;
+
 template<bool has_alpha_channel, typename GetPixel>
 ALWAYS_INLINE static void do_draw_integer_scaled_bitmap(Gfx::Bitmap& target, const IntRect& dst_rect, const Gfx::Bitmap& source, int hfactor, int vfactor, GetPixel get_pixel, float opacity)
 {
     bool has_opacity = opacity != 1.0f;
+    if constexpr (has_alpha_channel) {
+        auto& functions = blend_functions();
+        RGBA32 chunk[scaled_pixel_chunk_size];
+        int dst_x = dst_rect.x() + source.rect().left() * hfactor;
+        int width = source.width() * hfactor;
+        for (int y = source.rect().top(); y <= source.rect().bottom(); ++y) {
+            int dst_y = dst_rect.y() + y * vfactor;
+            for (int chunk_x = 0; chunk_x < width; chunk_x += scaled_pixel_chunk_size) {
+                int chunk_width = min(scaled_pixel_chunk_size, width - chunk_x);
+                for (int i = 0; i < chunk_width; ++i) {
+                    auto src_pixel = get_pixel(source, source.rect().left() + (chunk_x + i) / hfactor, y);
+                    if (has_opacity)
+                        src_pixel.set_alpha(src_pixel.alpha() * opacity);
+                    chunk[i] = src_pixel.value();
+                }
+                for (int yo = 0; yo < vfactor; ++yo)
+                    functions.blend(target.scanline(dst_y + yo) + dst_x + chunk_x, chunk, chunk_width);
+            }
+        }
+        return;
+    }
+
     for (int y = source.rect().top(); y <= source.rect().bottom(); ++y) {
         int dst_y = dst_rect.y() + y * vfactor;
         for (int x = source.rect().left(); x <= source.rect().right(); ++x) {
@@ -701,12 +719,8 @@ ALWAYS_INLINE static void do_draw_integer_scaled_bitmap(Gfx::Bitmap& target, con
             for (int yo = 0; yo < vfactor; ++yo) {
                 auto* scanline = (Color*)target.scanline(dst_y + yo);
                 int dst_x = dst_rect.x() + x * hfactor;
-                for (int xo = 0; xo < hfactor; ++xo) {
-                    if constexpr (has_alpha_channel)
-                        scanline[dst_x + xo] = scanline[dst_x + xo].blend(src_pixel);
-                    else
-                        scanline[dst_x + xo] = src_pixel;
-                }
+                for (int xo = 0; xo < hfactor; ++xo)
+                    scanline[dst_x + xo] = src_pixel;
             }
         }
     }
@@ -729,6 +743,27 @@ ALWAYS_INLINE static void do_draw_scaled_bitmap(Gfx::Bitmap& target, const IntRe
 
     bool has_opacity = opacity != 1.0f;
 
+    if constexpr (has_alpha_channel) {
+        auto& functions = blend_functions();
+        RGBA32 chunk[scaled_pixel_chunk_size];
+        for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
+            auto* scanline = target.scanline(y);
+            auto scaled_y = ((y - dst_rect.y()) * vscale) >> 16;
+            for (int chunk_x = clipped_rect.left(); chunk_x <= clipped_rect.right(); chunk_x += scaled_pixel_chunk_size) {
+                int chunk_width = min(scaled_pixel_chunk_size, clipped_rect.right() - chunk_x + 1);
+                for (int i = 0; i < chunk_width; ++i) {
+                    auto scaled_x = ((chunk_x + i - dst_rect.x()) * hscale) >> 16;
+                    auto src_pixel = get_pixel(source, scaled_x, scaled_y);
+                    if (has_opacity)
+                        src_pixel.set_alpha(src_pixel.alpha() * opacity);
+                    chunk[i] = src_pixel.value();
+                }
+                functions.blend(scanline + chunk_x, chunk, chunk_width);
+            }
+        }
+        return;
+    }
+
     for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
         auto* scanline = (Color*)target.scanline(y);
         for (int x = clipped_rect.left(); x <= clipped_rect.right(); ++x) {
@@ -737,15 +772,175 @@ ALWAYS_INLINE static void do_draw_scaled_bitmap(Gfx::Bitmap& target, const IntRe
             auto src_pixel = get_pixel(source, scaled_x, scaled_y);
             if (has_opacity)
                 src_pixel.set_alpha(src_pixel.alpha() * opacity);
-            if constexpr (has_alpha_channel) {
-                scanline[x] = scanline[x].blend(src_pixel);
-            } else
-                scanline[x] = src_pixel;
+            scanline[x] = src_pixel;
         }
     }
 }
 
-void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const IntRect& src_rect, float opacity)
+// Shrinking by more than this switches BilinearBlend over to averaging every covered source pixel,
+// since interpolating between four of them would skip over most of the image.
+static constexpr int box_filter_threshold = 2;
+
+template<bool has_alpha_channel>
+ALWAYS_INLINE static Color interpolate_bilinear(Color p00, Color p01, Color p10, Color p11, u32 fx, u32 fy)
+{
+    // The weights are in 8-bit fixed point and sum up to 65536.
+    u32 w00 = (256 - fx) * (256 - fy);
+    u32 w01 = fx * (256 - fy);
+    u32 w10 = (256 - fx) * fy;
+    u32 w11 = fx * fy;
+
+    if constexpr (!has_alpha_channel) {
+        auto channel = [&](u8 c00, u8 c01, u8 c10, u8 c11) -> u8 {
+            return (c00 * w00 + c01 * w01 + c10 * w10 + c11 * w11 + 32768) >> 16;
+        };
+        return Color(
+            channel(p00.red(), p01.red(), p10.red(), p11.red()),
+            channel(p00.green(), p01.green(), p10.green(), p11.green()),
+            channel(p00.blue(), p01.blue(), p10.blue(), p11.blue()));
+    }
+
+    // Weigh each color by its alpha, so that (invisible) colors of transparent pixels don't bleed into their neighbors.
+    w00 *= p00.alpha();
+    w01 *= p01.alpha();
+    w10 *= p10.alpha();
+    w11 *= p11.alpha();
+    u32 alpha_sum = w00 + w01 + w10 + w11;
+    if (!alpha_sum)
+        return Color::from_rgba(0);
+    auto channel = [&](u8 c00, u8 c01, u8 c10, u8 c11) -> u8 {
+        return (c00 * w00 + c01 * w01 + c10 * w10 + c11 * w11 + alpha_sum / 2) / alpha_sum;
+    };
+    return Color(
+        channel(p00.red(), p01.red(), p10.red(), p11.red()),
+        channel(p00.green(), p01.green(), p10.green(), p11.green()),
+        channel(p00.blue(), p01.blue(), p10.blue(), p11.blue()),
+        (alpha_sum + 32768) >> 16);
+}
+
+template<bool has_alpha_channel, typename GetPixel>
+ALWAYS_INLINE static Color average_box(const Gfx::Bitmap& source, int left, int right, int top, int bottom, GetPixel get_pixel)
+{
+    u64 red = 0;
+    u64 green = 0;
+    u64 blue = 0;
+    u64 alpha = 0;
+    for (int y = top; y < bottom; ++y) {
+        for (int x = left; x < right; ++x) {
+            auto pixel = get_pixel(source, x, y);
+            u32 weight = has_alpha_channel ? pixel.alpha() : 1;
+            red += pixel.red() * weight;
+            green += pixel.green() * weight;
+            blue += pixel.blue() * weight;
+            alpha += weight;
+        }
+    }
+    u64 count = (u64)(right - left) * (bottom - top);
+    if constexpr (has_alpha_channel) {
+        if (!alpha)
+            return Color::from_rgba(0);
+        return Color((red + alpha / 2) / alpha, (green + alpha / 2) / alpha, (blue + alpha / 2) / alpha, (alpha + count / 2) / count);
+    }
+    return Color((red + count / 2) / count, (green + count / 2) / count, (blue + count / 2) / count);
+}
+
+// Maps destination offsets onto the source in 16.16 fixed point, going through pixel centers
+// so that the image doesn't shift by half a pixel.
+struct ScaledAxis {
+    ScaledAxis(int src_origin, int src_length, int dst_length)
+        : step(((i64)src_length << 16) / dst_length)
+        , origin(((i64)src_origin << 16) + step / 2 - 32768)
+        , first(src_origin)
+        , last(src_origin + src_length - 1)
+        , src_origin(src_origin)
+        , src_length(src_length)
+        , dst_length(dst_length)
+    {
+    }
+
+    i64 position(int offset) const { return origin + offset * step; }
+
+    // The two source pixels surrounding a position, and the 8-bit weight of the second one.
+    void sample(i64 position, int& a, int& b, u32& fraction) const
+    {
+        if (position <= ((i64)first << 16)) {
+            a = b = first;
+            fraction = 0;
+        } else if (position >= ((i64)last << 16)) {
+            a = b = last;
+            fraction = 0;
+        } else {
+            a = position >> 16;
+            b = a + 1;
+            fraction = (position >> 8) & 0xff;
+        }
+    }
+
+    // The source pixels that are covered by a destination pixel. There's always at least one.
+    void span(int offset, int& begin, int& end) const
+    {
+        begin = src_origin + (int)(((i64)offset * src_length) / dst_length);
+        end = max(begin + 1, src_origin + (int)(((i64)(offset + 1) * src_length) / dst_length));
+    }
+
+    i64 step;
+    i64 origin;
+    int first;
+    int last;
+    int src_origin;
+    int src_length;
+    int dst_length;
+};
+
+template<bool has_alpha_channel, typename GetPixel>
+static void do_draw_smooth_scaled_bitmap(Gfx::Bitmap& target, const IntRect& dst_rect, const IntRect& clipped_rect, const Gfx::Bitmap& source, const IntRect& src_rect, GetPixel get_pixel, float opacity)
+{
+    ScaledAxis horizontal(src_rect.left(), src_rect.width(), dst_rect.width());
+    ScaledAxis vertical(src_rect.top(), src_rect.height(), dst_rect.height());
+    bool use_box_filter = src_rect.width() > dst_rect.width() * box_filter_threshold || src_rect.height() > dst_rect.height() * box_filter_threshold;
+    bool has_opacity = opacity != 1.0f;
+    bool needs_blending = has_alpha_channel || has_opacity;
+
+    auto& functions = blend_functions();
+    RGBA32 chunk[scaled_pixel_chunk_size];
+    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
+        int dst_y = y - dst_rect.top();
+        int y0, y1;
+        u32 fy;
+        vertical.sample(vertical.position(dst_y), y0, y1, fy);
+        int top, bottom;
+        vertical.span(dst_y, top, bottom);
+
+        auto* scanline = target.scanline(y);
+        for (int chunk_x = clipped_rect.left(); chunk_x <= clipped_rect.right(); chunk_x += scaled_pixel_chunk_size) {
+            int chunk_width = min(scaled_pixel_chunk_size, clipped_rect.right() - chunk_x + 1);
+            int dst_x = chunk_x - dst_rect.left();
+            i64 position = horizontal.position(dst_x);
+            for (int i = 0; i < chunk_width; ++i, position += horizontal.step) {
+                Color color;
+                if (use_box_filter) {
+                    int left, right;
+                    horizontal.span(dst_x + i, left, right);
+                    color = average_box<has_alpha_channel>(source, left, right, top, bottom, get_pixel);
+                } else {
+                    int x0, x1;
+                    u32 fx;
+                    horizontal.sample(position, x0, x1, fx);
+                    color = interpolate_bilinear<has_alpha_channel>(get_pixel(source, x0, y0), get_pixel(source, x1, y0), get_pixel(source, x0, y1), get_pixel(source, x1, y1), fx, fy);
+                }
+                if (has_opacity)
+                    color.set_alpha(color.alpha() * opacity);
+                chunk[i] = color.value();
+            }
+            if (needs_blending)
+                functions.blend(scanline + chunk_x, chunk, chunk_width);
+            else
+                fast_u32_copy(scanline + chunk_x, chunk, chunk_width);
+        }
+    }
+}
+
+void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& source, const IntRect& src_rect, float opacity, ScalingMode scaling_mode)
 {
     auto dst_rect = a_dst_rect;
     if (dst_rect.size() == src_rect.size())
@@ -758,6 +953,16 @@ void Painter::draw_scaled_bitmap(const IntRect& a_dst_rect, const Gfx::Bitmap& s
     if (clipped_rect.is_empty())
         return;
 
+    if (scaling_mode == ScalingMode::BilinearBlend) {
+        if (source.format() == BitmapFormat::RGB32)
+            do_draw_smooth_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::RGB32>, opacity);
+        else if (source.format() == BitmapFormat::RGBA32)
+            do_draw_smooth_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::RGBA32>, opacity);
+        else
+            do_draw_smooth_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, get_pixel<BitmapFormat::Invalid>, opacity);
+        return;
+    }
+
     int hscale = (src_rect.width() << 16) / dst_rect.width();
     int vscale = (src_rect.height() << 16) / dst_rect.height();
 
@@ -810,7 +1015,37 @@ FLATTEN void Painter::draw_glyph(const IntPoint& point, u32 code_point, Color co
 
 FLATTEN void Painter::draw_glyph(const IntPoint& point, u32 code_point, const Font& font, Color color)
 {
-    draw_bitmap(point, font.glyph_bitmap(code_point), color);
+    if (code_point >= (u32)font.glyph_count()) {
+        draw_bitmap(point, font.glyph_bitmap(code_point), color);
+        return;
+    }
+
+    auto dst_rect = IntRect(point, { font.glyph_width(code_point), font.glyph_height() }).translated(translation());
+    auto clipped_rect = dst_rect.intersected(clip_rect());
+    if (clipped_rect.is_empty())
+        return;
+    const int first_row = clipped_rect.top() - dst_rect.top();
+    const int last_row = clipped_rect.bottom() - dst_rect.top();
+    const int first_column = clipped_rect.left() - dst_rect.left();
+    const int end_column = clipped_rect.right() - dst_rect.left() + 1;
+    RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
+    const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
+    const RGBA32 value = color.value();
+
+    auto* runs = font.glyph_runs(code_point);
+    for (int row = 0; row < first_row; ++row)
+        runs += 1 + 2 * runs[0];
+
+    for (int row = first_row; row <= last_row; ++row) {
+        int run_count = *runs++;
+        for (int i = 0; i < run_count; ++i, runs += 2) {
+            int start = max((int)runs[0], first_column);
+            int end = min(runs[0] + runs[1], end_column);
+            for (int x = start; x < end; ++x)
+                dst[x - first_column] = value;
+        }
+        dst += dst_skip;
+    }
 }
 
 void Painter::draw_emoji(const IntPoint& point, const Gfx::Bitmap& emoji, const Font& font)
@@ -905,7 +1140,14 @@ void Painter::draw_text_line(const IntRect& a_rect, const Utf8View& text, const
     auto point = rect.location();
     int space_width = font.glyph_width(' ') + font.glyph_spacing();
 
+    // Everything is painted at or after the current point, so nothing past the clip rect will show up.
+    auto clip = clip_rect().translated(-translation());
+    if (point.y() > clip.bottom())
+        return;
+
     for (u32 code_point : final_text) {
+        if (point.x() > clip.right())
+            break;
         if (code_point == ' ') {
             point.move_by(space_width, 0);
             continue;
@@ -970,7 +1212,14 @@ void Painter::draw_text_line(const IntRect& a_rect, const Utf32View& text, const
     auto point = rect.location();
     int space_width = font.glyph_width(' ') + font.glyph_spacing();
 
+    // Everything is painted at or after the current point, so nothing past the clip rect will show up.
+    auto clip = clip_rect().translated(-translation());
+    if (point.y() > clip.bottom())
+        return;
+
     for (size_t i = 0; i < final_text.length(); ++i) {
+        if (point.x() > clip.right())
+            break;
         auto code_point = final_text.code_points()[i];
         if (code_point == ' ') {
             point.move_by(space_width, 0);
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
+#include <math.h>
+
+namespace Gfx {
+
+void PathRasterizer::fill(Painter& painter, Path& path, Color color, Painter::WindingRule winding_rule)
+{
+    auto& lines = path.split_lines();
+    if (lines.is_empty() || color.alpha() == 0)
+        return;
+
+    FloatPoint translation { (float)painter.translation().x(), (float)painter.translation().y() };
+
+    float min_x = lines.first().from.x();
+    float max_x = min_x;
+    float min_y = lines.first().from.y();
+    float max_y = min_y;
+    for (auto& line : lines) {
+        min_x = min(min_x, min(line.from.x(), line.to.x()));
+        max_x = max(max_x, max(line.from.x(), line.to.x()));
+        min_y = min(min_y, min(line.from.y(), line.to.y()));
+        max_y = max(max_y, max(line.from.y(), line.to.y()));
+    }
+
+    IntRect path_rect { (int)floorf(min_x + translation.x()), (int)floorf(min_y + translation.y()), 0, 0 };
+    path_rect.set_width((int)ceilf(max_x + translation.x()) - path_rect.x() + 1);
+    path_rect.set_height((int)ceilf(max_y + translation.y()) - path_rect.y() + 1);
+
+    m_bounds = path_rect.intersected(painter.clip_rect());
+    if (m_bounds.is_empty())
+        return;
+
+    // Two extra cells per row catch the area spilling past the right edge of the bounds.
+    m_pitch = m_bounds.width() + 2;
+    size_t cells_needed = m_pitch * m_bounds.height();
+    if (m_coverage.size() < cells_needed)
+        m_coverage.resize(cells_needed);
+
+    FloatPoint origin { (float)m_bounds.x() - translation.x(), (float)m_bounds.y() - translation.y() };
+    for (auto& line : lines)
+        accumulate_line(line.from - origin, line.to - origin);
+
+    composite(painter, color, winding_rule);
+}
+
+void PathRasterizer::accumulate_line(FloatPoint from, FloatPoint to)
+{
+    if (from.y() == to.y())
+        return;
+
+    float direction = 1;
+    if (from.y() > to.y()) {
+        direction = -1;
+        swap(from, to);
+    }
+
+    float width = m_bounds.width();
+    float height = m_bounds.height();
+    if (to.y() <= 0 || from.y() >= height)
+        return;
+
+    float dxdy = (to.x() - from.x()) / (to.y() - from.y());
+    float x = from.x();
+    if (from.y() < 0)
+        x -= from.y() * dxdy;
+
+    int first_row = max(0, (int)floorf(from.y()));
+    int last_row = min((int)height, (int)ceilf(to.y()));
+
+    for (int row = first_row; row < last_row; ++row) {
+        float* cells = &m_coverage[row * m_pitch];
+        float dy = min((float)(row + 1), to.y()) - max((float)row, from.y());
+        float next_x = x + dxdy * dy;
+        float d = dy * direction;
+
+        // Anything left of the bounds covers the whole row span, anything right of it nothing.
+        float x0 = clamp(min(x, next_x), 0.0f, width);
+        float x1 = clamp(max(x, next_x), 0.0f, width);
+
+        float x0_floor = floorf(x0);
+        int x0_index = (int)x0_floor;
+        float x1_ceil = ceilf(x1);
+        int x1_index = (int)x1_ceil;
+
+        if (x1_index <= x0_index + 1) {
+            // The edge stays within one pixel on this row.
+            float x_mid = 0.5f * (x0 + x1) - x0_floor;
+            cells[x0_index] += d - d * x_mid;
+            cells[x0_index + 1] += d * x_mid;
+        } else {
+            float inverse_span = 1.0f / (x1 - x0);
+            float x0_fraction = x0 - x0_floor;
+            float area_first = 0.5f * inverse_span * (1.0f - x0_fraction) * (1.0f - x0_fraction);
+            float x1_fraction = x1 - x1_ceil + 1.0f;
+            float area_last = 0.5f * inverse_span * x1_fraction * x1_fraction;
+
+            cells[x0_index] += d * area_first;
+            if (x1_index == x0_index + 2) {
+                cells[x0_index + 1] += d * (1.0f - area_first - area_last);
+            } else {
+                float area_second = inverse_span * (1.5f - x0_fraction);
+                cells[x0_index + 1] += d * (area_second - area_first);
+                for (int i = x0_index + 2; i < x1_index - 1; ++i)
+                    cells[i] += d * inverse_span;
+                float area_before_last = area_second + (x1_index - x0_index - 3) * inverse_span;
+                cells[x1_index - 1] += d * (1.0f - area_before_last - area_last);
+            }
+            cells[x1_index] += d * area_last;
+        }
+
+        x = next_x;
+    }
+}
+
+void PathRasterizer::composite(Painter& painter, Color color, Painter::WindingRule winding_rule)
+{
+    auto& target = *painter.target();
+    bool has_alpha_channel = target.has_alpha_channel();
+
+    for (int row = 0; row < m_bounds.height(); ++row) {
+        float* cells = &m_coverage[row * m_pitch];
+        auto* scanline = target.scanline(m_bounds.y() + row) + m_bounds.x();
+        float accumulator = 0;
+        for (int column = 0; column < m_bounds.width(); ++column) {
+            accumulator += cells[column];
+            // Clear the buffer as we go so it's ready for the next fill.
+            cells[column] = 0;
+
+            float coverage = fabsf(accumulator);
+            if (winding_rule == Painter::WindingRule::EvenOdd) {
+                coverage = fmodf(coverage, 2.0f);
+                if (coverage > 1.0f)
+                    coverage = 2.0f - coverage;
+            } else if (coverage > 1.0f) {
+                coverage = 1.0f;
+            }
+
+            u8 alpha = (u8)(coverage * color.alpha() + 0.5f);
+            if (!alpha)
+                continue;
+
+            auto& pixel = scanline[column];
+            auto source = color.with_alpha(alpha);
+            if (alpha == 255)
+                pixel = source.value();
+            else if (has_alpha_channel)
+                pixel = Color::from_rgba(pixel).blend(source).value();
+            else
+                pixel = Color::from_rgb(pixel).blend(source).value();
+        }
+        cells[m_bounds.width()] = 0;
+        cells[m_bounds.width() + 1] = 0;
+    }
+}
+
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibHTTP/ContentDecoder.h>
+
+namespace HTTP {
+
+OwnPtr<ContentDecoder> ContentDecoder::create(const String& content_encoding)
+{
+    if (content_encoding.equals_ignoring_case("gzip") || content_encoding.equals_ignoring_case("x-gzip"))
+        return adopt_own(*new ContentDecoder(Format::Gzip));
+    if (content_encoding.equals_ignoring_case("deflate"))
+        return adopt_own(*new ContentDecoder(Format::Deflate));
+    return nullptr;
+}
+
+ContentDecoder::ContentDecoder(Format format)
+    : m_format(format)
+{
+}
+
+ContentDecoder::~ContentDecoder()
+{
+    if (m_deflate_stream)
+        m_deflate_stream->handle_error();
+    m_input.handle_error();
+}
+
+ContentDecoder::HeaderResult ContentDecoder::skip_header(size_t& header_size) const
+{
+    auto* data = m_header.data();
+    size_t size = m_header.size();
+
+    if (m_format == Format::Deflate) {
+        // Servers disagree on whether "deflate" means a zlib stream (RFC 1950) or raw DEFLATE data, so accept both.
+        if (size < 2)
+            return HeaderResult::Incomplete;
+        u8 cmf = data[0];
+        u8 flg = data[1];
+        bool is_zlib = (cmf & 0xf) == 8 && (cmf >> 4) <= 7 && !(flg & 0x20) && ((cmf << 8) | flg) % 31 == 0;
+        header_size = is_zlib ? 2 : 0;
+        return HeaderResult::Complete;
+    }
+
+    // See RFC 1952, section 2.3.
+    if (size < 10)
+        return HeaderResult::Incomplete;
+    if (data[0] != 0x1f || data[1] != 0x8b || data[2] != 8)
+        return HeaderResult::Invalid;
+
+    u8 flags = data[3];
+    size_t offset = 10;
+    if (flags & 4) {
+        if (size < offset + 2)
+            return HeaderResult::Incomplete;
+        offset += 2 + (data[offset] | (data[offset + 1] << 8));
+    }
+    // The file name and the comment are both zero-terminated.
+    auto skip_string = [&] {
+        while (offset < size && data[offset])
+            ++offset;
+        if (offset >= size)
+            return false;
+        ++offset;
+        return true;
+    };
+    if ((flags & 8) && !skip_string())
+        return HeaderResult::Incomplete;
+    if ((flags & 16) && !skip_string())
+        return HeaderResult::Incomplete;
+    if (flags & 2)
+        offset += 2;
+
+    if (offset > size)
+        return HeaderResult::Incomplete;
+    header_size = offset;
+    return HeaderResult::Complete;
+}
+
+Optional<ByteBuffer> ContentDecoder::decode(ReadonlyBytes bytes, bool is_final)
+{
+    if (m_failed)
+        return {};
+
+    if (!m_deflate_stream) {
+        m_header.append(bytes.data(), bytes.size());
+        size_t header_size = 0;
+        auto result = skip_header(header_size);
+        if (result == HeaderResult::Invalid || (result == HeaderResult::Incomplete && is_final)) {
+            m_failed = true;
+            return {};
+        }
+        if (result == HeaderResult::Incomplete)
+            return ByteBuffer {};
+        m_input.write(m_header.bytes().slice(header_size));
+        m_header.clear();
+        m_deflate_stream = make<Compress::DeflateStream>(m_input);
+    } else {
+        m_input.write(bytes);
+    }
+
+    ByteBuffer output;
+    u8 buffer[16 * KiB];
+    while (is_final || m_input.remaining() > input_margin) {
+        auto nread = m_deflate_stream->read({ buffer, sizeof(buffer) });
+        if (m_deflate_stream->handle_error()) {
+            m_failed = true;
+            return {};
+        }
+        if (!nread)
+            break;
+        output.append(buffer, nread);
+    }
+    return output;
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/OwnPtr.h>
+#include <AK/Stream.h>
+#include <AK/String.h>
+#include <LibCompress/Deflate.h>
+
+namespace HTTP {
+
+// Undoes a gzip or deflate Content-Encoding while the body is still arriving.
+//
+// DeflateStream can't be told that more input is on the way, so running out of it in the middle
+// of a block would look like a corrupt stream. Decoding therefore holds back until there's enough
+// input buffered that the next step can't possibly run dry, and only catches up once the body is complete.
+class ContentDecoder {
+public:
+    // Returns null for encodings that can't (or needn't) be decoded.
+    static OwnPtr<ContentDecoder> create(const String& content_encoding);
+
+    ~ContentDecoder();
+
+    // Returns whatever can be decoded so far, or an empty Optional if the data turned out to be malformed.
+    // Once is_final is set, everything that's left is decoded.
+    Optional<ByteBuffer> decode(ReadonlyBytes, bool is_final = false);
+
+private:
+    enum class Format {
+        Gzip,
+        Deflate,
+    };
+
+    explicit ContentDecoder(Format);
+
+    enum class HeaderResult {
+        Incomplete,
+        Invalid,
+        Complete,
+    };
+    HeaderResult skip_header(size_t& header_size) const;
+
+    // Decompressing another 32 KiB of output never takes more input than this.
+    static constexpr size_t input_margin = 128 * KiB;
+
+    Format m_format;
+    bool m_failed { false };
+    ByteBuffer m_header;
+    DuplexMemoryStream m_input;
+    OwnPtr<Compress::DeflateStream> m_deflate_stream;
+};
+
+}
@@ -52,6 +52,27 @@ void HttpJob::start()
     }
 }
 
+void HttpJob::start(NonnullRefPtr<Core::Socket> socket)
+{
+    ASSERT(!m_socket);
+    m_socket = move(socket);
+    m_socket->on_connected = nullptr;
+    m_connection_was_reused = true;
+    add_child(*m_socket);
+    deferred_invoke([this](auto&) {
+        on_socket_connected();
+    });
+}
+
+RefPtr<Core::Socket> HttpJob::take_socket()
+{
+    if (!m_socket || !can_reuse_connection())
+        return nullptr;
+    m_socket->on_ready_to_read = nullptr;
+    remove_child(*m_socket);
+    return move(m_socket);
+}
+
 void HttpJob::shutdown()
 {
     if (!m_socket)
@@ -73,6 +94,15 @@ void HttpJob::register_on_ready_to_write(Function<void()> callback)
     callback();
 }
 
+void HttpJob::read_while_data_available(Function<IterationDecision()> read)
+{
+    // Reading a line may have pulled in more than the line, and the socket won't notify us about data that's already buffered.
+    while (m_socket->can_read()) {
+        if (read() == IterationDecision::Break)
+            break;
+    }
+}
+
 bool HttpJob::can_read_line() const
 {
     return m_socket->can_read_line();
@@ -50,6 +50,11 @@ public:
     virtual void start() override;
     virtual void shutdown() override;
 
+    // Sends the request over a connection that an earlier job has finished with.
+    void start(NonnullRefPtr<Core::Socket>);
+    // Hands over the connection once the job has finished, if it can be used again. See Job::can_reuse_connection().
+    RefPtr<Core::Socket> take_socket();
+
 protected:
     virtual bool should_fail_on_empty_payload() const override { return false; }
     virtual void register_on_ready_to_read(Function<void()>) override;
@@ -61,6 +66,7 @@ protected:
     virtual bool eof() const override;
     virtual bool write(const ByteBuffer&) override;
     virtual bool is_established() const override { return true; }
+    virtual void read_while_data_available(Function<IterationDecision()>) override;
 
 private:
     RefPtr<Core::Socket> m_socket;
@@ -78,7 +78,7 @@ ByteBuffer HttpRequest::to_raw_request() const
         builder.append(header.value);
         builder.append("\r\n");
     }
-    builder.append("Connection: close\r\n\r\n");
+    builder.append(m_keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
     return builder.to_byte_buffer();
 }
 
@@ -183,6 +183,7 @@ Optional<HttpRequest> HttpRequest::from_raw_request(const ByteBuffer& raw_reques
         return {};
 
     request.m_resource = resource;
+    request.m_protocol = protocol;
     request.m_headers = move(headers);
 
     return request;
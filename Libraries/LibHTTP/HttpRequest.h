@@ -52,6 +52,7 @@ public:
     ~HttpRequest();
 
     const String& resource() const { return m_resource; }
+    const String& protocol() const { return m_protocol; }
     const Vector<Header>& headers() const { return m_headers; }
 
     const URL& url() const { return m_url; }
@@ -60,6 +61,10 @@ public:
     Method method() const { return m_method; }
     void set_method(Method method) { m_method = method; }
 
+    // Asks the server to keep the connection open after responding, so that it can be used for another request.
+    bool keep_alive() const { return m_keep_alive; }
+    void set_keep_alive(bool keep_alive) { m_keep_alive = keep_alive; }
+
     String method_name() const;
     ByteBuffer to_raw_request() const;
 
@@ -72,8 +77,10 @@ public:
 private:
     URL m_url;
     String m_resource;
+    String m_protocol;
     Method m_method { GET };
     Vector<Header> m_headers;
+    bool m_keep_alive { false };
 };
 
 }
@@ -40,6 +40,43 @@ void HttpsJob::start()
 {
     ASSERT(!m_socket);
     m_socket = TLS::TLSv12::construct(this);
+    set_up_socket_callbacks();
+    bool success = ((TLS::TLSv12&)*m_socket).connect(m_request.url().host(), m_request.url().port());
+    if (!success) {
+        deferred_invoke([this](auto&) {
+            return did_fail(Core::NetworkJob::Error::ConnectionFailed);
+        });
+    }
+}
+
+void HttpsJob::start(NonnullRefPtr<TLS::TLSv12> socket)
+{
+    ASSERT(!m_socket);
+    m_socket = move(socket);
+    m_connection_was_reused = true;
+    add_child(*m_socket);
+    set_up_socket_callbacks();
+    deferred_invoke([this](auto&) {
+        on_socket_connected();
+    });
+}
+
+RefPtr<TLS::TLSv12> HttpsJob::take_socket()
+{
+    if (!m_socket || !can_reuse_connection())
+        return nullptr;
+    m_socket->on_tls_ready_to_read = nullptr;
+    m_socket->on_tls_ready_to_write = nullptr;
+    m_socket->on_tls_connected = nullptr;
+    m_socket->on_tls_error = nullptr;
+    m_socket->on_tls_finished = nullptr;
+    m_socket->on_tls_certificate_request = nullptr;
+    remove_child(*m_socket);
+    return move(m_socket);
+}
+
+void HttpsJob::set_up_socket_callbacks()
+{
     m_socket->on_tls_connected = [this] {
 #ifdef HTTPSJOB_DEBUG
         dbg() << "HttpsJob: on_connected callback";
@@ -62,18 +99,14 @@ void HttpsJob::start()
         }
     };
     m_socket->on_tls_finished = [&] {
+        if (m_state == State::InStatus)
+            return did_lose_connection();
         finish_up();
     };
     m_socket->on_tls_certificate_request = [this](auto&) {
         if (on_certificate_requested)
             on_certificate_requested(*this);
     };
-    bool success = ((TLS::TLSv12&)*m_socket).connect(m_request.url().host(), m_request.url().port());
-    if (!success) {
-        deferred_invoke([this](auto&) {
-            return did_fail(Core::NetworkJob::Error::ConnectionFailed);
-        });
-    }
 }
 
 void HttpsJob::shutdown()
@@ -118,6 +151,9 @@ void HttpsJob::register_on_ready_to_write(Function<void()> callback)
     m_socket->on_tls_ready_to_write = [callback = move(callback)](auto&) {
         callback();
     };
+    // A connection from an earlier job won't call us back on its own.
+    if (m_socket->is_established())
+        m_socket->on_tls_ready_to_write(*m_socket);
 }
 
 bool HttpsJob::can_read_line() const
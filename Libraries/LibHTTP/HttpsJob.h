@@ -49,6 +49,10 @@ public:
 
     virtual void start() override;
     virtual void shutdown() override;
+
+    // Like the ones in HttpJob, but for connections that have already done their TLS handshake.
+    void start(NonnullRefPtr<TLS::TLSv12>);
+    RefPtr<TLS::TLSv12> take_socket();
     void set_certificate(String certificate, String key);
 
     Function<void(HttpsJob&)> on_certificate_requested;
@@ -67,6 +71,8 @@ protected:
     virtual void read_while_data_available(Function<IterationDecision()>) override;
 
 private:
+    void set_up_socket_callbacks();
+
     RefPtr<TLS::TLSv12> m_socket;
 };
 
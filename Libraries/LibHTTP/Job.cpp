@@ -24,7 +24,6 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <LibCore/Gzip.h>
 #include <LibCore/TCPSocket.h>
 #include <LibHTTP/HttpResponse.h>
 #include <LibHTTP/Job.h>
@@ -35,39 +34,6 @@
 
 namespace HTTP {
 
-static ByteBuffer handle_content_encoding(const ByteBuffer& buf, const String& content_encoding)
-{
-#ifdef JOB_DEBUG
-    dbg() << "Job::handle_content_encoding: buf has content_encoding = " << content_encoding;
-#endif
-
-    if (content_encoding == "gzip") {
-        if (!Core::Gzip::is_compressed(buf)) {
-            dbg() << "Job::handle_content_encoding: buf is not gzip compressed!";
-        }
-
-#ifdef JOB_DEBUG
-        dbg() << "Job::handle_content_encoding: buf is gzip compressed!";
-#endif
-
-        auto uncompressed = Core::Gzip::decompress(buf);
-        if (!uncompressed.has_value()) {
-            dbg() << "Job::handle_content_encoding: Gzip::decompress() failed. Returning original buffer.";
-            return buf;
-        }
-
-#ifdef JOB_DEBUG
-        dbg() << "Job::handle_content_encoding: Gzip::decompress() successful.\n"
-              << "  Input size = " << buf.size() << "\n"
-              << "  Output size = " << uncompressed.value().size();
-#endif
-
-        return uncompressed.value();
-    }
-
-    return buf;
-}
-
 Job::Job(const HttpRequest& request)
     : m_request(request)
 {
@@ -93,11 +59,14 @@ void Job::on_socket_connected()
             deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
     });
     register_on_ready_to_read([&] {
-        if (is_cancelled())
+        if (is_cancelled() || m_state == State::Finished)
             return;
         if (m_state == State::InStatus) {
-            if (!can_read_line())
+            if (!can_read_line()) {
+                if (eof())
+                    did_lose_connection();
                 return;
+            }
             auto line = read_line(PAGE_SIZE);
             if (line.is_null()) {
                 fprintf(stderr, "Job: Expected HTTP status\n");
@@ -114,6 +83,7 @@ void Job::on_socket_connected()
                 return deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
             }
             m_code = code.value();
+            m_response_is_http_1_1 = parts[0] == "HTTP/1.1";
             m_state = State::InHeaders;
             return;
         }
@@ -134,9 +104,19 @@ void Job::on_socket_connected()
             auto chomped_line = String::copy(line, Chomp);
             if (chomped_line.is_empty()) {
                 if (m_state == State::Trailers) {
+                    m_body_was_delimited = true;
                     return finish_up();
                 } else {
                     m_state = State::InBody;
+                    auto content_encoding = m_headers.get("Content-Encoding");
+                    if (content_encoding.has_value())
+                        m_content_decoder = ContentDecoder::create(content_encoding.value());
+                    deferred_invoke([this, headers = m_headers, code = m_code](auto&) { did_receive_headers(headers, code); });
+                    // Without a body there's nothing to wait for, and on a persistent connection, nothing would come.
+                    if (!has_body()) {
+                        m_body_was_delimited = true;
+                        finish_up();
+                    }
                 }
                 return;
             }
@@ -177,7 +157,21 @@ void Job::on_socket_connected()
             if (m_current_chunk_remaining_size.has_value()) {
             read_chunk_size:;
                 auto remaining = m_current_chunk_remaining_size.value();
+                if (remaining == -2) {
+                    // The line break that ends the previous chunk.
+                    if (!can_read_line())
+                        return IterationDecision::Break;
+                    auto line = read_line(PAGE_SIZE);
+#ifdef JOB_DEBUG
+                    dbg() << "Line following (should be empty): _" << line << "_";
+#endif
+                    (void)line;
+                    m_current_chunk_remaining_size = remaining = -1;
+                }
                 if (remaining == -1) {
+                    // The size line may be split across packets, so wait until all of it is here.
+                    if (!can_read_line())
+                        return IterationDecision::Break;
                     // read size
                     auto size_data = read_line(PAGE_SIZE);
                     auto size_lines = StringView { size_data.data(), size_data.size() }.lines();
@@ -252,11 +246,13 @@ void Job::on_socket_connected()
                 }
             }
 
-            m_received_buffers.append(payload);
-            m_received_size += payload.size();
+            auto payload_size = payload.size();
+            m_received_size += payload_size;
+            if (!did_receive_body_data(move(payload)))
+                return IterationDecision::Break;
 
             if (m_current_chunk_remaining_size.has_value()) {
-                auto size = m_current_chunk_remaining_size.value() - payload.size();
+                auto size = m_current_chunk_remaining_size.value() - payload_size;
 #ifdef JOB_DEBUG
                 dbg() << "Job: We have " << size << " bytes left over in this chunk";
 #endif
@@ -271,12 +267,7 @@ void Job::on_socket_connected()
                     }
 
                     // we've read everything, now let's get the next chunk
-                    size = -1;
-                    auto line = read_line(PAGE_SIZE);
-#ifdef JOB_DEBUG
-                    dbg() << "Line following (should be empty): _" << line << "_";
-#endif
-                    (void)line;
+                    size = -2;
                 }
                 m_current_chunk_remaining_size = size;
             }
@@ -296,6 +287,7 @@ void Job::on_socket_connected()
                 auto length = content_length.value();
                 if (m_received_size >= length) {
                     m_received_size = length;
+                    m_body_was_delimited = true;
                     finish_up();
                     return IterationDecision::Break;
                 }
@@ -312,21 +304,83 @@ void Job::on_socket_connected()
     });
 }
 
+void Job::did_lose_connection()
+{
+    // A connection that sat idle after an earlier request may have been closed by the server in the meantime.
+    // We haven't heard anything back yet, so it's safe to try again from scratch.
+    if (m_connection_was_reused && m_state == State::InStatus) {
+        m_connection_was_reused = false;
+        m_sent_data = false;
+        deferred_invoke([this](auto&) {
+            shutdown();
+            start();
+        });
+        return;
+    }
+    deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
+}
+
+bool Job::did_receive_body_data(ByteBuffer data, bool is_final)
+{
+    if (m_content_decoder) {
+        auto decoded = m_content_decoder->decode(data.bytes(), is_final);
+        if (!decoded.has_value()) {
+            fprintf(stderr, "Job: Failed to decode response body\n");
+            deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
+            return false;
+        }
+        data = decoded.value();
+    }
+
+    if (data.is_empty())
+        return true;
+
+    if (m_should_buffer_payload) {
+        m_received_buffers.append(data);
+        m_buffered_size += data.size();
+    }
+    deferred_invoke([this, data](auto&) { did_receive_data(data.bytes()); });
+    return true;
+}
+
+bool Job::has_body() const
+{
+    if (m_request.method() == HttpRequest::Method::HEAD)
+        return false;
+    if ((m_code >= 100 && m_code < 200) || m_code == 204 || m_code == 304)
+        return false;
+    auto content_length = m_headers.get("Content-Length");
+    return !content_length.has_value() || content_length.value().to_uint().value_or(1) != 0;
+}
+
+bool Job::can_reuse_connection() const
+{
+    if (!m_request.keep_alive() || m_state != State::Finished || !m_body_was_delimited || !m_response_is_http_1_1 || m_server_closes_connection)
+        return false;
+    return !eof();
+}
+
 void Job::finish_up()
 {
     m_state = State::Finished;
-    auto flattened_buffer = ByteBuffer::create_uninitialized(m_received_size);
+    auto connection = m_headers.get("Connection");
+    m_server_closes_connection = connection.has_value() && connection.value().equals_ignoring_case("close");
+
+    if (m_content_decoder) {
+        bool decoded = did_receive_body_data({}, true);
+        m_content_decoder = nullptr;
+        if (!decoded)
+            return;
+    }
+
+    auto flattened_buffer = ByteBuffer::create_uninitialized(m_buffered_size);
     u8* flat_ptr = flattened_buffer.data();
     for (auto& received_buffer : m_received_buffers) {
         memcpy(flat_ptr, received_buffer.data(), received_buffer.size());
         flat_ptr += received_buffer.size();
     }
     m_received_buffers.clear();
-
-    auto content_encoding = m_headers.get("Content-Encoding");
-    if (content_encoding.has_value()) {
-        flattened_buffer = handle_content_encoding(flattened_buffer, content_encoding.value());
-    }
+    m_buffered_size = 0;
 
     auto response = HttpResponse::create(m_code, move(m_headers), move(flattened_buffer));
     deferred_invoke([this, response](auto&) {
@@ -28,8 +28,10 @@
 
 #include <AK/HashMap.h>
 #include <AK/Optional.h>
+#include <AK/OwnPtr.h>
 #include <LibCore/NetworkJob.h>
 #include <LibCore/TCPSocket.h>
+#include <LibHTTP/ContentDecoder.h>
 #include <LibHTTP/HttpRequest.h>
 #include <LibHTTP/HttpResponse.h>
 
@@ -46,8 +48,19 @@ public:
     HttpResponse* response() { return static_cast<HttpResponse*>(Core::NetworkJob::response()); }
     const HttpResponse* response() const { return static_cast<const HttpResponse*>(Core::NetworkJob::response()); }
 
+    // Whether the connection can be used for another request, now that this one has finished.
+    // That takes a request that asked for it, and a response that neither refused nor ran until the connection closed.
+    bool can_reuse_connection() const;
+
+    // The body is always handed to on_data_received as it arrives. Consumers that deal with it there
+    // can turn this off, so that the whole of it doesn't have to be kept around for the response.
+    void set_should_buffer_payload(bool should_buffer_payload) { m_should_buffer_payload = should_buffer_payload; }
+
 protected:
     void finish_up();
+    bool did_receive_body_data(ByteBuffer, bool is_final = false);
+    void did_lose_connection();
+    bool has_body() const;
     void on_socket_connected();
     virtual void register_on_ready_to_read(Function<void()>) = 0;
     virtual void register_on_ready_to_write(Function<void()>) = 0;
@@ -75,7 +88,14 @@ protected:
     HashMap<String, String, CaseInsensitiveStringTraits> m_headers;
     Vector<ByteBuffer> m_received_buffers;
     size_t m_received_size { 0 };
+    size_t m_buffered_size { 0 };
+    bool m_should_buffer_payload { true };
+    OwnPtr<ContentDecoder> m_content_decoder;
     bool m_sent_data { 0 };
+    bool m_connection_was_reused { false };
+    bool m_response_is_http_1_1 { false };
+    bool m_body_was_delimited { false };
+    bool m_server_closes_connection { false };
     Optional<ssize_t> m_current_chunk_remaining_size;
     Optional<size_t> m_current_chunk_total_size;
 };
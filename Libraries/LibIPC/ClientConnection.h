@@ -34,10 +34,12 @@
 #include <LibCore/Timer.h>
 #include <LibIPC/Endpoint.h>
 #include <LibIPC/Message.h>
+#include <LibIPC/SharedRingTransport.h>
 #include <errno.h>
 #include <stdio.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace IPC {
@@ -102,6 +104,8 @@ public:
     virtual void may_have_become_unresponsive() { }
     virtual void did_become_responsive() { }
 
+    // Messages aren't sent right away, but queued up and written with a single writev() once the
+    // current event loop iteration is done, or once we're done handling what the client sent us.
     void post_message(const Message& message)
     {
         // NOTE: If this connection is being shut down, but has not yet been destroyed,
@@ -109,30 +113,59 @@ public:
         if (!m_socket->is_open())
             return;
 
-        auto buffer = message.encode();
+        // Only the most recently queued message may absorb this one, otherwise we'd reorder it with
+        // whatever was posted in between.
+        if (m_coalescable_message && m_coalescable_message->coalesce(message))
+            return;
 
-        auto bytes_remaining = buffer.size();
-        while (bytes_remaining) {
-            auto nwritten = write(m_socket->fd(), buffer.data(), buffer.size());
-            if (nwritten < 0) {
-                switch (errno) {
-                case EPIPE:
-                    dbg() << *this << "::post_message: Disconnected from peer";
-                    shutdown();
-                    return;
-                case EAGAIN:
-                    dbg() << *this << "::post_message: Client buffer overflowed.";
-                    did_misbehave();
-                    return;
-                default:
-                    perror("Connection::post_message write");
-                    shutdown();
-                    return;
-                }
-            }
-            bytes_remaining -= nwritten;
+        if (m_coalescable_message) {
+            queue_encoded_message(*m_coalescable_message);
+            m_coalescable_message = nullptr;
+        }
+
+        if (message.is_coalescable())
+            m_coalescable_message = message.clone();
+        else
+            queue_encoded_message(message);
+
+        if (m_flush_scheduled)
+            return;
+        m_flush_scheduled = true;
+        deferred_invoke([this](auto&) { flush_queued_messages(); });
+    }
+
+    void flush_queued_messages()
+    {
+        m_flush_scheduled = false;
+
+        if (m_coalescable_message) {
+            queue_encoded_message(*m_coalescable_message);
+            m_coalescable_message = nullptr;
         }
 
+        if (m_queued_messages.is_empty())
+            return;
+
+        auto messages = move(m_queued_messages);
+        if (!m_socket->is_open())
+            return;
+
+        // Large messages may go through the shared ring instead, which writes its own frame to the
+        // socket, so everything queued before such a message has to be written out first.
+        size_t batch_start = 0;
+        for (size_t i = 0; i < messages.size(); ++i) {
+            if (messages[i].data.size() < SharedRingTransport::min_message_size)
+                continue;
+            if (!write_messages(messages, batch_start, i))
+                return;
+            if (m_shared_ring.try_send(m_socket->fd(), messages[i]))
+                batch_start = i + 1;
+            else
+                batch_start = i;
+        }
+        if (!write_messages(messages, batch_start, messages.size()))
+            return;
+
         m_responsiveness_timer->start();
     }
 
@@ -167,8 +200,23 @@ public:
 
         size_t decoded_bytes = 0;
         for (size_t index = 0; index < bytes.size(); index += decoded_bytes) {
-            auto remaining_bytes = ByteBuffer::wrap(bytes.data() + index, bytes.size() - index);
-            auto message = Endpoint::decode_message(remaining_bytes, decoded_bytes);
+            ByteBuffer ring_message;
+            auto frame_result = m_shared_ring.handle_frame(m_socket->fd(), m_client_pid, bytes.data() + index, bytes.size() - index, decoded_bytes, ring_message);
+            if (frame_result == SharedRingTransport::FrameResult::Invalid) {
+                did_misbehave("invalid shared ring frame");
+                return;
+            }
+            if (frame_result == SharedRingTransport::FrameResult::Handled)
+                continue;
+
+            OwnPtr<Message> message;
+            if (frame_result == SharedRingTransport::FrameResult::Message) {
+                size_t ring_message_size = 0;
+                message = Endpoint::decode_message(ring_message, ring_message_size);
+            } else {
+                auto remaining_bytes = ByteBuffer::wrap(bytes.data() + index, bytes.size() - index);
+                message = Endpoint::decode_message(remaining_bytes, decoded_bytes);
+            }
             if (!message) {
                 dbg() << "drain_messages_from_client: Endpoint didn't recognize message";
                 did_misbehave();
@@ -178,6 +226,9 @@ public:
                 post_message(*response);
             ASSERT(decoded_bytes);
         }
+
+        // The client may be blocked waiting for a response, so don't make it wait for the event loop.
+        flush_queued_messages();
     }
 
     void did_misbehave()
@@ -221,9 +272,62 @@ protected:
     }
 
 private:
+    void queue_encoded_message(const Message& message)
+    {
+        auto buffer = message.encode();
+        if (!buffer.share_with(m_client_pid)) {
+            dbg() << *this << "::post_message: Couldn't share buffers with client";
+            return;
+        }
+        m_queued_messages.append(move(buffer));
+    }
+
+    bool write_messages(const Vector<MessageBuffer>& messages, size_t start, size_t end)
+    {
+        Vector<iovec, 32> iovecs;
+        for (size_t i = start; i < end; ++i)
+            iovecs.append({ const_cast<u8*>(messages[i].data.data()), messages[i].data.size() });
+
+        size_t first_iovec = 0;
+        while (first_iovec < iovecs.size()) {
+            auto nwritten = writev(m_socket->fd(), iovecs.data() + first_iovec, iovecs.size() - first_iovec);
+            if (nwritten < 0) {
+                switch (errno) {
+                case EINTR:
+                    continue;
+                case EPIPE:
+                    dbg() << *this << "::post_message: Disconnected from peer";
+                    shutdown();
+                    return false;
+                case EAGAIN:
+                    dbg() << *this << "::post_message: Client buffer overflowed.";
+                    did_misbehave();
+                    return false;
+                default:
+                    perror("Connection::post_message writev");
+                    shutdown();
+                    return false;
+                }
+            }
+            // Skip past what was written, which may have ended in the middle of a message.
+            size_t bytes_written = nwritten;
+            while (first_iovec < iovecs.size() && bytes_written >= iovecs[first_iovec].iov_len)
+                bytes_written -= iovecs[first_iovec++].iov_len;
+            if (bytes_written) {
+                iovecs[first_iovec].iov_base = (u8*)iovecs[first_iovec].iov_base + bytes_written;
+                iovecs[first_iovec].iov_len -= bytes_written;
+            }
+        }
+        return true;
+    }
+
     Endpoint& m_endpoint;
     NonnullRefPtr<Core::LocalSocket> m_socket;
+    SharedRingTransport m_shared_ring;
     RefPtr<Core::Timer> m_responsiveness_timer;
+    Vector<MessageBuffer> m_queued_messages;
+    OwnPtr<Message> m_coalescable_message;
+    bool m_flush_scheduled { false };
     int m_client_id { -1 };
     int m_client_pid { -1 };
 };
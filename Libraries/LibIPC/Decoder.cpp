@@ -28,6 +28,7 @@
 #include <AK/URL.h>
 #include <LibIPC/Decoder.h>
 #include <LibIPC/Dictionary.h>
+#include <LibIPC/LargeBuffer.h>
 
 namespace IPC {
 
@@ -146,4 +147,37 @@ bool Decoder::decode(Dictionary& dictionary)
     return true;
 }
 
+bool Decoder::decode(LargeBuffer& buffer)
+{
+    bool is_shared = false;
+    if (!decode(is_shared))
+        return false;
+
+    if (is_shared) {
+        i32 shbuf_id = 0;
+        u32 size = 0;
+        if (!decode(shbuf_id) || !decode(size))
+            return false;
+        auto shared_buffer = SharedBuffer::create_from_shbuf_id(shbuf_id);
+        if (!shared_buffer || size > static_cast<u32>(shared_buffer->size()))
+            return false;
+        buffer.m_shared_buffer = move(shared_buffer);
+        buffer.m_inline_data = {};
+        buffer.m_size = size;
+        return true;
+    }
+
+    u32 size = 0;
+    if (!decode(size))
+        return false;
+    auto data = ByteBuffer::create_uninitialized(size);
+    m_stream.read_raw(data.data(), size);
+    if (m_stream.handle_read_failure())
+        return false;
+    buffer.m_shared_buffer = nullptr;
+    buffer.m_inline_data = move(data);
+    buffer.m_size = size;
+    return true;
+}
+
 }
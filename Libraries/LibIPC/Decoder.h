@@ -61,6 +61,7 @@ public:
     bool decode(String&);
     bool decode(URL&);
     bool decode(Dictionary&);
+    bool decode(LargeBuffer&);
 
     template<typename T>
     bool decode(T& value)
@@ -28,6 +28,7 @@
 #include <AK/URL.h>
 #include <LibIPC/Dictionary.h>
 #include <LibIPC/Encoder.h>
+#include <LibIPC/LargeBuffer.h>
 
 namespace IPC {
 
@@ -38,77 +39,77 @@ Encoder& Encoder::operator<<(bool value)
 
 Encoder& Encoder::operator<<(u8 value)
 {
-    m_buffer.append(value);
+    m_buffer.data.append(value);
     return *this;
 }
 
 Encoder& Encoder::operator<<(u16 value)
 {
-    m_buffer.ensure_capacity(m_buffer.size() + 2);
-    m_buffer.unchecked_append((u8)value);
-    m_buffer.unchecked_append((u8)(value >> 8));
+    m_buffer.data.ensure_capacity(m_buffer.data.size() + 2);
+    m_buffer.data.unchecked_append((u8)value);
+    m_buffer.data.unchecked_append((u8)(value >> 8));
     return *this;
 }
 
 Encoder& Encoder::operator<<(u32 value)
 {
-    m_buffer.ensure_capacity(m_buffer.size() + 4);
-    m_buffer.unchecked_append((u8)value);
-    m_buffer.unchecked_append((u8)(value >> 8));
-    m_buffer.unchecked_append((u8)(value >> 16));
-    m_buffer.unchecked_append((u8)(value >> 24));
+    m_buffer.data.ensure_capacity(m_buffer.data.size() + 4);
+    m_buffer.data.unchecked_append((u8)value);
+    m_buffer.data.unchecked_append((u8)(value >> 8));
+    m_buffer.data.unchecked_append((u8)(value >> 16));
+    m_buffer.data.unchecked_append((u8)(value >> 24));
     return *this;
 }
 
 Encoder& Encoder::operator<<(u64 value)
 {
-    m_buffer.ensure_capacity(m_buffer.size() + 8);
-    m_buffer.unchecked_append((u8)value);
-    m_buffer.unchecked_append((u8)(value >> 8));
-    m_buffer.unchecked_append((u8)(value >> 16));
-    m_buffer.unchecked_append((u8)(value >> 24));
-    m_buffer.unchecked_append((u8)(value >> 32));
-    m_buffer.unchecked_append((u8)(value >> 40));
-    m_buffer.unchecked_append((u8)(value >> 48));
-    m_buffer.unchecked_append((u8)(value >> 56));
+    m_buffer.data.ensure_capacity(m_buffer.data.size() + 8);
+    m_buffer.data.unchecked_append((u8)value);
+    m_buffer.data.unchecked_append((u8)(value >> 8));
+    m_buffer.data.unchecked_append((u8)(value >> 16));
+    m_buffer.data.unchecked_append((u8)(value >> 24));
+    m_buffer.data.unchecked_append((u8)(value >> 32));
+    m_buffer.data.unchecked_append((u8)(value >> 40));
+    m_buffer.data.unchecked_append((u8)(value >> 48));
+    m_buffer.data.unchecked_append((u8)(value >> 56));
     return *this;
 }
 
 Encoder& Encoder::operator<<(i8 value)
 {
-    m_buffer.append((u8)value);
+    m_buffer.data.append((u8)value);
     return *this;
 }
 
 Encoder& Encoder::operator<<(i16 value)
 {
-    m_buffer.ensure_capacity(m_buffer.size() + 2);
-    m_buffer.unchecked_append((u8)value);
-    m_buffer.unchecked_append((u8)(value >> 8));
+    m_buffer.data.ensure_capacity(m_buffer.data.size() + 2);
+    m_buffer.data.unchecked_append((u8)value);
+    m_buffer.data.unchecked_append((u8)(value >> 8));
     return *this;
 }
 
 Encoder& Encoder::operator<<(i32 value)
 {
-    m_buffer.ensure_capacity(m_buffer.size() + 4);
-    m_buffer.unchecked_append((u8)value);
-    m_buffer.unchecked_append((u8)(value >> 8));
-    m_buffer.unchecked_append((u8)(value >> 16));
-    m_buffer.unchecked_append((u8)(value >> 24));
+    m_buffer.data.ensure_capacity(m_buffer.data.size() + 4);
+    m_buffer.data.unchecked_append((u8)value);
+    m_buffer.data.unchecked_append((u8)(value >> 8));
+    m_buffer.data.unchecked_append((u8)(value >> 16));
+    m_buffer.data.unchecked_append((u8)(value >> 24));
     return *this;
 }
 
 Encoder& Encoder::operator<<(i64 value)
 {
-    m_buffer.ensure_capacity(m_buffer.size() + 8);
-    m_buffer.unchecked_append((u8)value);
-    m_buffer.unchecked_append((u8)(value >> 8));
-    m_buffer.unchecked_append((u8)(value >> 16));
-    m_buffer.unchecked_append((u8)(value >> 24));
-    m_buffer.unchecked_append((u8)(value >> 32));
-    m_buffer.unchecked_append((u8)(value >> 40));
-    m_buffer.unchecked_append((u8)(value >> 48));
-    m_buffer.unchecked_append((u8)(value >> 56));
+    m_buffer.data.ensure_capacity(m_buffer.data.size() + 8);
+    m_buffer.data.unchecked_append((u8)value);
+    m_buffer.data.unchecked_append((u8)(value >> 8));
+    m_buffer.data.unchecked_append((u8)(value >> 16));
+    m_buffer.data.unchecked_append((u8)(value >> 24));
+    m_buffer.data.unchecked_append((u8)(value >> 32));
+    m_buffer.data.unchecked_append((u8)(value >> 40));
+    m_buffer.data.unchecked_append((u8)(value >> 48));
+    m_buffer.data.unchecked_append((u8)(value >> 56));
     return *this;
 }
 
@@ -129,7 +130,7 @@ Encoder& Encoder::operator<<(const char* value)
 
 Encoder& Encoder::operator<<(const StringView& value)
 {
-    m_buffer.append((const u8*)value.characters_without_null_termination(), value.length());
+    m_buffer.data.append((const u8*)value.characters_without_null_termination(), value.length());
     return *this;
 }
 
@@ -155,4 +156,18 @@ Encoder& Encoder::operator<<(const Dictionary& dictionary)
     return *this;
 }
 
+Encoder& Encoder::operator<<(const LargeBuffer& buffer)
+{
+    if (buffer.m_shared_buffer) {
+        m_buffer.shared_buffers.append(*buffer.m_shared_buffer);
+        *this << true;
+        *this << buffer.m_shared_buffer->shbuf_id();
+        return *this << (u32)buffer.size();
+    }
+    *this << false;
+    *this << (u32)buffer.size();
+    m_buffer.data.append(buffer.data(), buffer.size());
+    return *this;
+}
+
 }
@@ -60,6 +60,7 @@ public:
     Encoder& operator<<(const String&);
     Encoder& operator<<(const URL&);
     Encoder& operator<<(const Dictionary&);
+    Encoder& operator<<(const LargeBuffer&);
 
     template<typename T>
     Encoder& operator<<(const Vector<T>& vector)
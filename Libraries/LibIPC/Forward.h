@@ -31,6 +31,7 @@ namespace IPC {
 class Decoder;
 class Dictionary;
 class Encoder;
+class LargeBuffer;
 class Message;
 
 }
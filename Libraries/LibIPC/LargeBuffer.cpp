@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/LogStream.h>
+#include <LibIPC/LargeBuffer.h>
+#include <string.h>
+
+namespace IPC {
+
+LargeBuffer::LargeBuffer(ReadonlyBytes bytes)
+    : m_size(bytes.size())
+{
+    if (bytes.size() > inline_size_limit) {
+        m_shared_buffer = SharedBuffer::create_with_size(bytes.size());
+        if (m_shared_buffer) {
+            memcpy(m_shared_buffer->data(), bytes.data(), bytes.size());
+            m_shared_buffer->seal();
+            return;
+        }
+        dbg() << "LargeBuffer: Couldn't create a shared buffer of " << bytes.size() << " bytes, sending it inline";
+    }
+    m_inline_data = ByteBuffer::copy(bytes.data(), bytes.size());
+}
+
+LargeBuffer::LargeBuffer(NonnullRefPtr<SharedBuffer> shared_buffer, size_t size)
+    : m_shared_buffer(move(shared_buffer))
+    , m_size(size)
+{
+    ASSERT(size <= static_cast<size_t>(m_shared_buffer->size()));
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/RefPtr.h>
+#include <AK/SharedBuffer.h>
+#include <AK/Span.h>
+
+namespace IPC {
+
+// A blob of bytes to be passed as a message argument. Small ones are copied into the message like
+// any other argument, but anything bigger than inline_size_limit lives in a sealed shared buffer.
+// That's shared with the peer when the message is sent, and the receiver maps it instead of
+// copying it out of the socket.
+class LargeBuffer {
+public:
+    static constexpr size_t inline_size_limit = 64 * KiB;
+
+    LargeBuffer() { }
+    explicit LargeBuffer(ReadonlyBytes);
+    explicit LargeBuffer(const ByteBuffer& buffer)
+        : LargeBuffer(ReadonlyBytes { buffer.data(), buffer.size() })
+    {
+    }
+
+    // The shared buffer should already be sealed, since the receiver may look at it at any time.
+    LargeBuffer(NonnullRefPtr<SharedBuffer>, size_t size);
+
+    const u8* data() const { return m_shared_buffer ? static_cast<const u8*>(m_shared_buffer->data()) : m_inline_data.data(); }
+    size_t size() const { return m_size; }
+    bool is_empty() const { return !m_size; }
+    ReadonlyBytes bytes() const { return { data(), size() }; }
+
+    const SharedBuffer* shared_buffer() const { return m_shared_buffer; }
+
+private:
+    friend class Decoder;
+    friend class Encoder;
+
+    ByteBuffer m_inline_data;
+    RefPtr<SharedBuffer> m_shared_buffer;
+    size_t m_size { 0 };
+};
+
+}
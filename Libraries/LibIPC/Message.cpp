@@ -36,4 +36,14 @@ Message::~Message()
 {
 }
 
+bool MessageBuffer::share_with(pid_t peer_pid)
+{
+    for (auto& shared_buffer : shared_buffers) {
+        if (!shared_buffer->share_with(peer_pid))
+            return false;
+    }
+    shared_buffers.clear();
+    return true;
+}
+
 }
@@ -26,11 +26,22 @@
 
 #pragma once
 
+#include <AK/NonnullRefPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/SharedBuffer.h>
 #include <AK/Vector.h>
 
 namespace IPC {
 
-typedef Vector<u8, 1024> MessageBuffer;
+struct MessageBuffer {
+    Vector<u8, 1024> data;
+
+    // Shared buffers referred to by the message. The connection shares these with the peer before
+    // sending the message, after which we can let go of them.
+    Vector<NonnullRefPtr<SharedBuffer>> shared_buffers;
+
+    bool share_with(pid_t peer_pid);
+};
 
 class Message {
 public:
@@ -41,6 +52,12 @@ public:
     virtual const char* message_name() const = 0;
     virtual MessageBuffer encode() const = 0;
 
+    // Messages declared with the [Coalesce] attribute can absorb a newer message of the same
+    // kind while they're still queued for sending. coalesce() returns false if it couldn't.
+    virtual bool is_coalescable() const { return false; }
+    virtual OwnPtr<Message> clone() const { return nullptr; }
+    virtual bool coalesce(const Message&) { return false; }
+
 protected:
     Message();
 };
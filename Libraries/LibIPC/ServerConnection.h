@@ -27,12 +27,16 @@
 #pragma once
 
 #include <AK/ByteBuffer.h>
+#include <AK/Function.h>
+#include <AK/HashMap.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <AK/Queue.h>
 #include <LibCore/Event.h>
 #include <LibCore/LocalSocket.h>
 #include <LibCore/Notifier.h>
 #include <LibCore/SyscallUtils.h>
 #include <LibIPC/Message.h>
+#include <LibIPC/SharedRingTransport.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/select.h>
@@ -80,6 +84,13 @@ public:
     void set_my_client_id(int id) { m_my_client_id = id; }
     int my_client_id() const { return m_my_client_id; }
 
+    // Offers the server a shared ring for large messages. It's only used once the server has
+    // accepted it, and the server offers one back for the messages it sends us.
+    bool enable_shared_ring()
+    {
+        return m_shared_ring.offer(m_connection->fd(), m_server_pid);
+    }
+
     template<typename MessageType>
     OwnPtr<MessageType> wait_for_specific_message()
     {
@@ -89,27 +100,113 @@ public:
     bool post_message(const Message& message)
     {
         auto buffer = message.encode();
-        int nwritten = write(m_connection->fd(), buffer.data(), buffer.size());
+        if (!buffer.share_with(m_server_pid)) {
+            perror("share_with");
+            return false;
+        }
+        if (m_shared_ring.try_send(m_connection->fd(), buffer))
+            return true;
+        int nwritten = write(m_connection->fd(), buffer.data.data(), buffer.data.size());
         if (nwritten < 0) {
             perror("write");
             ASSERT_NOT_REACHED();
             return false;
         }
-        ASSERT(static_cast<size_t>(nwritten) == buffer.size());
+        ASSERT(static_cast<size_t>(nwritten) == buffer.data.size());
         return true;
     }
 
     template<typename RequestType, typename... Args>
     OwnPtr<typename RequestType::ResponseType> send_sync(Args&&... args)
     {
-        bool success = post_message(RequestType(forward<Args>(args)...));
-        ASSERT(success);
-        auto response = wait_for_specific_endpoint_message<typename RequestType::ResponseType, PeerEndpoint>();
+        auto request_id = post_request(RequestType(forward<Args>(args)...), RequestType::ResponseType::static_message_id(), nullptr);
+        auto response = wait_for_response(request_id);
         ASSERT(response);
-        return response;
+        return response.template release_nonnull<typename RequestType::ResponseType>();
+    }
+
+    // Like send_sync(), but returns right away. The callback is invoked from the event loop once
+    // the response arrives, so any number of requests can be in flight at the same time.
+    template<typename RequestType, typename... Args>
+    void send_async(Function<void(NonnullOwnPtr<typename RequestType::ResponseType>)> on_response, Args&&... args)
+    {
+        using ResponseType = typename RequestType::ResponseType;
+        ASSERT(on_response);
+        post_request(RequestType(forward<Args>(args)...), ResponseType::static_message_id(), [on_response = move(on_response)](NonnullOwnPtr<Message> response) {
+            on_response(response.template release_nonnull<ResponseType>());
+        });
+    }
+
+    // Blocks until every outstanding request has been answered, then runs the callbacks of the
+    // ones that were sent with send_async().
+    void wait_for_pending_responses()
+    {
+        while (!m_pending_requests.is_empty()) {
+            if (!wait_for_incoming_data())
+                return;
+        }
+        handle_messages();
     }
 
 private:
+    // The server handles requests one at a time and responds to each before looking at the next one,
+    // so responses arrive in the order we sent the requests. That's what lets us match them up.
+    struct PendingRequest {
+        u32 request_id { 0 };
+        i32 response_message_id { 0 };
+        Function<void(NonnullOwnPtr<Message>)> on_response;
+    };
+
+    u32 post_request(const Message& request, i32 response_message_id, Function<void(NonnullOwnPtr<Message>)> on_response)
+    {
+        auto request_id = m_next_request_id++;
+        m_pending_requests.enqueue({ request_id, response_message_id, move(on_response) });
+        bool success = post_message(request);
+        ASSERT(success);
+        return request_id;
+    }
+
+    void did_receive_response(NonnullOwnPtr<Message> response)
+    {
+        ASSERT(!m_pending_requests.is_empty());
+        auto request = m_pending_requests.dequeue();
+        ASSERT(response->message_id() == request.response_message_id);
+        if (!request.on_response) {
+            m_sync_responses.set(request.request_id, move(response));
+            return;
+        }
+        // Don't call back into the client from wherever we happened to be draining the socket.
+        m_unprocessed_responses.append({ move(request.on_response), move(response) });
+    }
+
+    OwnPtr<Message> wait_for_response(u32 request_id)
+    {
+        for (;;) {
+            auto it = m_sync_responses.find(request_id);
+            if (it != m_sync_responses.end()) {
+                auto response = move(it->value);
+                m_sync_responses.remove(it);
+                return response;
+            }
+            if (!wait_for_incoming_data())
+                return nullptr;
+        }
+    }
+
+    bool wait_for_incoming_data()
+    {
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(m_connection->fd(), &rfds);
+        int rc = Core::safe_syscall(select, m_connection->fd() + 1, &rfds, nullptr, nullptr, nullptr);
+        if (rc < 0) {
+            perror("select");
+        }
+        ASSERT(rc > 0);
+        ASSERT(FD_ISSET(m_connection->fd(), &rfds));
+        return drain_messages_from_server();
+    }
+
     template<typename MessageType, typename Endpoint>
     OwnPtr<MessageType> wait_for_specific_endpoint_message()
     {
@@ -124,16 +221,7 @@ private:
                     return m_unprocessed_messages.take(i).template release_nonnull<MessageType>();
             }
 
-            fd_set rfds;
-            FD_ZERO(&rfds);
-            FD_SET(m_connection->fd(), &rfds);
-            int rc = Core::safe_syscall(select, m_connection->fd() + 1, &rfds, nullptr, nullptr, nullptr);
-            if (rc < 0) {
-                perror("select");
-            }
-            ASSERT(rc > 0);
-            ASSERT(FD_ISSET(m_connection->fd(), &rfds));
-            if (!drain_messages_from_server())
+            if (!wait_for_incoming_data())
                 return nullptr;
         }
     }
@@ -162,18 +250,34 @@ private:
 
         size_t decoded_bytes = 0;
         for (size_t index = 0; index < bytes.size(); index += decoded_bytes) {
+            ByteBuffer ring_message;
+            auto frame_result = m_shared_ring.handle_frame(m_connection->fd(), m_server_pid, bytes.data() + index, bytes.size() - index, decoded_bytes, ring_message);
+            ASSERT(frame_result != SharedRingTransport::FrameResult::Invalid);
+            if (frame_result == SharedRingTransport::FrameResult::Handled)
+                continue;
+            if (frame_result == SharedRingTransport::FrameResult::Message) {
+                size_t ring_message_size = 0;
+                if (auto message = LocalEndpoint::decode_message(ring_message, ring_message_size))
+                    m_unprocessed_messages.append(message.release_nonnull());
+                else if (auto message = PeerEndpoint::decode_message(ring_message, ring_message_size))
+                    did_receive_response(message.release_nonnull());
+                else
+                    ASSERT_NOT_REACHED();
+                continue;
+            }
+
             auto remaining_bytes = ByteBuffer::wrap(bytes.data() + index, bytes.size() - index);
             if (auto message = LocalEndpoint::decode_message(remaining_bytes, decoded_bytes)) {
                 m_unprocessed_messages.append(message.release_nonnull());
             } else if (auto message = PeerEndpoint::decode_message(remaining_bytes, decoded_bytes)) {
-                m_unprocessed_messages.append(message.release_nonnull());
+                did_receive_response(message.release_nonnull());
             } else {
                 ASSERT_NOT_REACHED();
             }
             ASSERT(decoded_bytes);
         }
 
-        if (!m_unprocessed_messages.is_empty()) {
+        if (!m_unprocessed_messages.is_empty() || !m_unprocessed_responses.is_empty()) {
             deferred_invoke([this](auto&) {
                 handle_messages();
             });
@@ -184,16 +288,29 @@ private:
     void handle_messages()
     {
         auto messages = move(m_unprocessed_messages);
+        auto responses = move(m_unprocessed_responses);
         for (auto& message : messages) {
             if (message.endpoint_magic() == LocalEndpoint::static_magic())
                 m_local_endpoint.handle(message);
         }
+        for (auto& response : responses)
+            response.on_response(move(response.response));
     }
 
     LocalEndpoint& m_local_endpoint;
     RefPtr<Core::LocalSocket> m_connection;
     RefPtr<Core::Notifier> m_notifier;
+    SharedRingTransport m_shared_ring;
     NonnullOwnPtrVector<Message> m_unprocessed_messages;
+
+    struct UnprocessedResponse {
+        Function<void(NonnullOwnPtr<Message>)> on_response;
+        NonnullOwnPtr<Message> response;
+    };
+    Vector<UnprocessedResponse> m_unprocessed_responses;
+    Queue<PendingRequest> m_pending_requests;
+    HashMap<u32, OwnPtr<Message>> m_sync_responses;
+    u32 m_next_request_id { 1 };
     int m_server_pid { -1 };
     int m_my_client_id { -1 };
 };
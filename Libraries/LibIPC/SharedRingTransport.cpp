@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Atomic.h>
+#include <AK/LogStream.h>
+#include <LibIPC/SharedRingTransport.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+//#define SHARED_RING_DEBUG
+
+namespace IPC {
+
+struct RingHeader {
+    u32 head;
+    u32 tail;
+    u32 data_size;
+};
+
+// The head and tail are free-running counters, and the data size is a power of two,
+// so the amount of data in the ring is always tail - head.
+class SharedRingTransport::Ring {
+public:
+    static OwnPtr<Ring> create_for_peer(pid_t peer_pid, size_t data_size)
+    {
+        auto buffer = SharedBuffer::create_with_size(sizeof(RingHeader) + data_size);
+        if (!buffer || !buffer->share_with(peer_pid))
+            return nullptr;
+        auto& header = *reinterpret_cast<RingHeader*>(buffer->data());
+        header.head = 0;
+        header.tail = 0;
+        header.data_size = data_size;
+        return adopt_own(*new Ring(buffer.release_nonnull(), data_size));
+    }
+
+    static OwnPtr<Ring> attach(int shbuf_id)
+    {
+        auto buffer = SharedBuffer::create_from_shbuf_id(shbuf_id);
+        if (!buffer || (size_t)buffer->size() < sizeof(RingHeader))
+            return nullptr;
+        // The peer can scribble over the header at any time, so we only trust our copy of the size.
+        u32 data_size = reinterpret_cast<const RingHeader*>(buffer->data())->data_size;
+        if (!data_size || (data_size & (data_size - 1)) || data_size > buffer->size() - sizeof(RingHeader))
+            return nullptr;
+        return adopt_own(*new Ring(buffer.release_nonnull(), data_size));
+    }
+
+    int shbuf_id() const { return m_buffer->shbuf_id(); }
+    size_t data_size() const { return m_data_size; }
+
+    bool try_write(const u8* data, size_t size)
+    {
+        u32 head = AK::atomic_load(&header().head, AK::memory_order_acquire);
+        u32 tail = header().tail;
+        u32 used = tail - head;
+        if (used > m_data_size || size > m_data_size - used)
+            return false;
+        copy_in(tail, data, size);
+        AK::atomic_store(&header().tail, tail + (u32)size, AK::memory_order_release);
+        return true;
+    }
+
+    bool read(u8* buffer, size_t size)
+    {
+        u32 head = header().head;
+        u32 tail = AK::atomic_load(&header().tail, AK::memory_order_acquire);
+        if (size > tail - head || size > m_data_size)
+            return false;
+        copy_out(head, buffer, size);
+        AK::atomic_store(&header().head, head + (u32)size, AK::memory_order_release);
+        return true;
+    }
+
+private:
+    Ring(NonnullRefPtr<SharedBuffer>&& buffer, u32 data_size)
+        : m_buffer(move(buffer))
+        , m_data_size(data_size)
+    {
+    }
+
+    RingHeader& header() { return *reinterpret_cast<RingHeader*>(m_buffer->data()); }
+    u8* ring_data() { return reinterpret_cast<u8*>(m_buffer->data()) + sizeof(RingHeader); }
+
+    void copy_in(u32 position, const u8* data, size_t size)
+    {
+        size_t offset = position & (m_data_size - 1);
+        size_t first_chunk = min(size, m_data_size - offset);
+        memcpy(ring_data() + offset, data, first_chunk);
+        memcpy(ring_data(), data + first_chunk, size - first_chunk);
+    }
+
+    void copy_out(u32 position, u8* buffer, size_t size)
+    {
+        size_t offset = position & (m_data_size - 1);
+        size_t first_chunk = min(size, m_data_size - offset);
+        memcpy(buffer, ring_data() + offset, first_chunk);
+        memcpy(buffer + first_chunk, ring_data(), size - first_chunk);
+    }
+
+    NonnullRefPtr<SharedBuffer> m_buffer;
+    u32 m_data_size { 0 };
+};
+
+SharedRingTransport::SharedRingTransport()
+{
+}
+
+SharedRingTransport::~SharedRingTransport()
+{
+}
+
+bool SharedRingTransport::send_frame(int fd, FrameType type, u32 value)
+{
+    ControlFrame frame { control_frame_magic, type, value };
+    ssize_t nwritten = write(fd, &frame, sizeof(frame));
+    if (nwritten < 0) {
+        perror("SharedRingTransport: write");
+        return false;
+    }
+    ASSERT((size_t)nwritten == sizeof(frame));
+    return true;
+}
+
+bool SharedRingTransport::offer(int fd, pid_t peer_pid)
+{
+    if (m_outgoing_ring)
+        return true;
+    m_outgoing_ring = Ring::create_for_peer(peer_pid, default_ring_size);
+    if (!m_outgoing_ring)
+        return false;
+#ifdef SHARED_RING_DEBUG
+    dbg() << "SharedRingTransport: Offering ring " << m_outgoing_ring->shbuf_id() << " to " << peer_pid;
+#endif
+    return send_frame(fd, FrameType::Offer, m_outgoing_ring->shbuf_id());
+}
+
+bool SharedRingTransport::try_send(int fd, const MessageBuffer& buffer)
+{
+    if (!m_outgoing_ring_accepted || buffer.data.size() < min_message_size)
+        return false;
+    if (!m_outgoing_ring->try_write(buffer.data.data(), buffer.data.size()))
+        return false;
+    // The bytes are in the ring now, so the frame pointing at them has to go out no matter what.
+    send_frame(fd, FrameType::Data, buffer.data.size());
+    return true;
+}
+
+SharedRingTransport::FrameResult SharedRingTransport::handle_frame(int fd, pid_t peer_pid, const u8* data, size_t size, size_t& consumed_bytes, ByteBuffer& message)
+{
+    if (size < sizeof(ControlFrame))
+        return FrameResult::NotAFrame;
+    ControlFrame frame;
+    memcpy(&frame, data, sizeof(frame));
+    if (frame.magic != control_frame_magic)
+        return FrameResult::NotAFrame;
+    consumed_bytes = sizeof(frame);
+
+    switch (frame.type) {
+    case FrameType::Offer:
+        if (m_incoming_ring)
+            return FrameResult::Invalid;
+        m_incoming_ring = Ring::attach(frame.value);
+        if (!m_incoming_ring) {
+            // Not fatal; the peer keeps sending everything through the socket.
+            dbg() << "SharedRingTransport: Unable to attach to offered ring " << frame.value;
+            return FrameResult::Handled;
+        }
+        send_frame(fd, FrameType::Accept, frame.value);
+        // Offer one back, so large messages can go both ways.
+        offer(fd, peer_pid);
+        return FrameResult::Handled;
+    case FrameType::Accept:
+        if (!m_outgoing_ring || frame.value != (u32)m_outgoing_ring->shbuf_id())
+            return FrameResult::Invalid;
+        m_outgoing_ring_accepted = true;
+        return FrameResult::Handled;
+    case FrameType::Data:
+        if (!m_incoming_ring || frame.value > m_incoming_ring->data_size())
+            return FrameResult::Invalid;
+        message = ByteBuffer::create_uninitialized(frame.value);
+        if (!m_incoming_ring->read(message.data(), message.size()))
+            return FrameResult::Invalid;
+        return FrameResult::Message;
+    }
+    return FrameResult::Invalid;
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/OwnPtr.h>
+#include <AK/SharedBuffer.h>
+#include <LibIPC/Message.h>
+#include <sys/types.h>
+
+namespace IPC {
+
+// An optional transport for large messages. Each side of a connection may offer the other
+// a single-producer, single-consumer byte ring in a shared buffer. Once the peer has accepted
+// it, large messages are written straight into the ring, and the socket only carries a small
+// control frame telling the peer how many bytes to take out of it. Since these frames travel
+// in order with the regular messages, message order is preserved.
+class SharedRingTransport {
+public:
+    static constexpr u32 control_frame_magic = 0x474e4952; // "RING"
+    static constexpr size_t default_ring_size = 256 * KiB;
+    static constexpr size_t min_message_size = 4 * KiB;
+
+    enum class FrameType : u32 {
+        Offer = 1,
+        Accept,
+        Data,
+    };
+
+    struct [[gnu::packed]] ControlFrame
+    {
+        u32 magic;
+        FrameType type;
+        u32 value;
+    };
+
+    SharedRingTransport();
+    ~SharedRingTransport();
+
+    enum class FrameResult {
+        NotAFrame,
+        Handled,
+        Message,
+        Invalid,
+    };
+
+    // Offers the peer a ring for the messages we send.
+    bool offer(int fd, pid_t peer_pid);
+
+    // Returns true if the message went through the ring, false if it should go through the socket.
+    bool try_send(int fd, const MessageBuffer&);
+
+    // Looks for a control frame at the start of some bytes received from the socket. If there is
+    // one, it's consumed; when it refers to a message in the peer's ring, that's copied into `message`.
+    FrameResult handle_frame(int fd, pid_t peer_pid, const u8* data, size_t size, size_t& consumed_bytes, ByteBuffer& message);
+
+private:
+    class Ring;
+
+    bool send_frame(int fd, FrameType, u32 value);
+
+    OwnPtr<Ring> m_outgoing_ring;
+    OwnPtr<Ring> m_incoming_ring;
+    bool m_outgoing_ring_accepted { false };
+};
+
+}
@@ -40,17 +40,15 @@ void Client::handshake()
     auto response = send_sync<Messages::ImageDecoderServer::Greet>(getpid());
     set_my_client_id(response->client_id());
     set_server_pid(response->server_pid());
+    enable_shared_ring();
 }
 
 void Client::handle(const Messages::ImageDecoderClient::Dummy&)
 {
 }
 
-RefPtr<Gfx::Bitmap> Client::decode_image(const ByteBuffer& encoded_data)
+static RefPtr<SharedBuffer> create_encoded_buffer(const ByteBuffer& encoded_data, pid_t server_pid)
 {
-    if (encoded_data.is_empty())
-        return nullptr;
-
     auto encoded_buffer = SharedBuffer::create_with_size(encoded_data.size());
     if (!encoded_buffer) {
         dbg() << "Could not allocate encoded shbuf";
@@ -60,10 +58,13 @@ RefPtr<Gfx::Bitmap> Client::decode_image(const ByteBuffer& encoded_data)
     memcpy(encoded_buffer->data(), encoded_data.data(), encoded_data.size());
 
     encoded_buffer->seal();
-    encoded_buffer->share_with(server_pid());
+    encoded_buffer->share_with(server_pid);
+    return encoded_buffer;
+}
 
-    auto response = send_sync<Messages::ImageDecoderServer::DecodeImage>(encoded_buffer->shbuf_id(), encoded_data.size());
-    auto bitmap_format = (Gfx::BitmapFormat)response->bitmap_format();
+static RefPtr<Gfx::Bitmap> bitmap_from_response(const Messages::ImageDecoderServer::DecodeImageResponse& response)
+{
+    auto bitmap_format = (Gfx::BitmapFormat)response.bitmap_format();
     if (bitmap_format == Gfx::BitmapFormat::Invalid) {
 #ifdef IMAGE_DECODER_CLIENT_DEBUG
         dbg() << "Response image was invalid";
@@ -71,18 +72,52 @@ RefPtr<Gfx::Bitmap> Client::decode_image(const ByteBuffer& encoded_data)
         return nullptr;
     }
 
-    if (response->size().is_empty()) {
+    if (response.size().is_empty()) {
         dbg() << "Response image was empty";
         return nullptr;
     }
 
-    auto decoded_buffer = SharedBuffer::create_from_shbuf_id(response->decoded_shbuf_id());
+    auto decoded_buffer = SharedBuffer::create_from_shbuf_id(response.decoded_shbuf_id());
     if (!decoded_buffer) {
-        dbg() << "Could not map decoded image shbuf_id=" << response->decoded_shbuf_id();
+        dbg() << "Could not map decoded image shbuf_id=" << response.decoded_shbuf_id();
         return nullptr;
     }
 
-    return Gfx::Bitmap::create_with_shared_buffer(bitmap_format, decoded_buffer.release_nonnull(), response->size(), response->palette());
+    return Gfx::Bitmap::create_with_shared_buffer(bitmap_format, decoded_buffer.release_nonnull(), response.size(), response.palette());
+}
+
+RefPtr<Gfx::Bitmap> Client::decode_image(const ByteBuffer& encoded_data)
+{
+    if (encoded_data.is_empty())
+        return nullptr;
+
+    auto encoded_buffer = create_encoded_buffer(encoded_data, server_pid());
+    if (!encoded_buffer)
+        return nullptr;
+
+    auto response = send_sync<Messages::ImageDecoderServer::DecodeImage>(encoded_buffer->shbuf_id(), encoded_data.size());
+    return bitmap_from_response(*response);
+}
+
+void Client::decode_image(const ByteBuffer& encoded_data, Function<void(RefPtr<Gfx::Bitmap>)> on_decoded)
+{
+    if (encoded_data.is_empty()) {
+        on_decoded(nullptr);
+        return;
+    }
+
+    auto encoded_buffer = create_encoded_buffer(encoded_data, server_pid());
+    if (!encoded_buffer) {
+        on_decoded(nullptr);
+        return;
+    }
+
+    auto shbuf_id = encoded_buffer->shbuf_id();
+    send_async<Messages::ImageDecoderServer::DecodeImage>(
+        [encoded_buffer = encoded_buffer.release_nonnull(), on_decoded = move(on_decoded)](auto response) {
+            on_decoded(bitmap_from_response(*response));
+        },
+        shbuf_id, encoded_data.size());
 }
 
 }
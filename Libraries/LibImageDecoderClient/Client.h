@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <ImageDecoder/ImageDecoderClientEndpoint.h>
 #include <ImageDecoder/ImageDecoderServerEndpoint.h>
@@ -39,10 +40,17 @@ class Client
     C_OBJECT(Client);
 
 public:
+    // The server keeps the bitmaps of this many of its most recent responses alive, so no more
+    // than this many requests may be outstanding at once. Must match ImageDecoder's ClientConnection.
+    static constexpr size_t max_requests_in_flight = 4;
+
     virtual void handshake() override;
 
     RefPtr<Gfx::Bitmap> decode_image(const ByteBuffer&);
 
+    // Doesn't wait for the server, so many images can be decoding at once.
+    void decode_image(const ByteBuffer&, Function<void(RefPtr<Gfx::Bitmap>)> on_decoded);
+
 private:
     Client();
 
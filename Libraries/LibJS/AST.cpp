@@ -30,10 +30,12 @@
 #include <AK/StringBuilder.h>
 #include <LibCrypto/BigInt/SignedBigInteger.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/Accessor.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/BigInt.h>
+#include <LibJS/Runtime/EnvironmentLayout.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/IteratorOperations.h>
@@ -45,11 +47,12 @@
 #include <LibJS/Runtime/ScriptFunction.h>
 #include <LibJS/Runtime/Shape.h>
 #include <LibJS/Runtime/StringObject.h>
+#include <LibJS/Runtime/TypedArray.h>
 #include <stdio.h>
 
 namespace JS {
 
-static void update_function_name(Value& value, const FlyString& name)
+void update_function_name(Value& value, const FlyString& name)
 {
     if (!value.is_object())
         return;
@@ -65,6 +68,18 @@ static void update_function_name(Value& value, const FlyString& name)
     }
 }
 
+// The equivalent of Interpreter::set_variable() for an identifier the parser resolved to a slot.
+static void assign_to_slot(Interpreter& interpreter, const Identifier& identifier, Value value)
+{
+    auto& environment = identifier.resolve_environment(interpreter);
+    auto slot = identifier.environment_coordinate().value().slot;
+    if (environment.slot_declaration_kind(slot) == DeclarationKind::Const) {
+        interpreter.throw_exception<TypeError>(ErrorType::InvalidAssignToConst);
+        return;
+    }
+    environment.set_slot(slot, value);
+}
+
 static String get_function_name(Interpreter& interpreter, Value value)
 {
     if (value.is_symbol())
@@ -74,11 +89,33 @@ static String get_function_name(Interpreter& interpreter, Value value)
     return value.to_string(interpreter);
 }
 
+ScopeNode::ScopeNode()
+{
+}
+
+ScopeNode::~ScopeNode()
+{
+}
+
+void ScopeNode::set_environment_layout(NonnullRefPtr<EnvironmentLayout> layout) const
+{
+    m_environment_layout = move(layout);
+}
+
 Value ScopeNode::execute(Interpreter& interpreter, GlobalObject& global_object) const
 {
     return interpreter.run(global_object, *this);
 }
 
+const Bytecode::Executable* ScopeNode::bytecode_executable() const
+{
+    if (!m_tried_generating_bytecode) {
+        m_tried_generating_bytecode = true;
+        m_bytecode_executable = Bytecode::Generator::generate(*this);
+    }
+    return m_bytecode_executable.ptr();
+}
+
 Value FunctionDeclaration::execute(Interpreter&, GlobalObject&) const
 {
     return js_undefined();
@@ -86,7 +123,7 @@ Value FunctionDeclaration::execute(Interpreter&, GlobalObject&) const
 
 Value FunctionExpression::execute(Interpreter& interpreter, GlobalObject& global_object) const
 {
-    return ScriptFunction::create(global_object, name(), body(), parameters(), function_length(), interpreter.current_environment(), m_is_arrow_function);
+    return ScriptFunction::create(global_object, *this, interpreter.current_environment(), m_is_arrow_function);
 }
 
 Value ExpressionStatement::execute(Interpreter& interpreter, GlobalObject& global_object) const
@@ -122,7 +159,7 @@ CallExpression::ThisAndCallee CallExpression::compute_this_and_callee(Interprete
         auto* this_value = is_super_property_lookup ? &interpreter.this_value(global_object).as_object() : lookup_target.to_object(interpreter, global_object);
         if (interpreter.exception())
             return {};
-        auto callee = lookup_target.to_object(interpreter, global_object)->get(member_expression.computed_property_name(interpreter, global_object)).value_or(js_undefined());
+        auto callee = member_expression.get_property(interpreter, global_object, *lookup_target.to_object(interpreter, global_object));
         return { this_value, callee };
     }
     return { &global_object, m_callee->execute(interpreter, global_object) };
@@ -556,7 +593,10 @@ Reference MemberExpression::to_reference(Interpreter& interpreter, GlobalObject&
     auto property_name = computed_property_name(interpreter, global_object);
     if (!property_name.is_valid())
         return {};
-    return { object_value, property_name };
+    Reference reference { object_value, property_name };
+    if (!is_computed())
+        reference.set_inline_caches(get_cache(), put_cache());
+    return reference;
 }
 
 Value UnaryExpression::execute(Interpreter& interpreter, GlobalObject& global_object) const
@@ -1042,7 +1082,12 @@ void FunctionNode::dump(int indent, const char* class_name) const
     }
     print_indent(indent + 1);
     printf("(Body)\n");
-    body().dump(indent + 2);
+    if (m_body) {
+        m_body->dump(indent + 2);
+    } else {
+        print_indent(indent + 2);
+        printf("(Not parsed yet)\n");
+    }
 }
 
 void FunctionDeclaration::dump(int indent) const
@@ -1134,8 +1179,20 @@ void ForOfStatement::dump(int indent) const
     body().dump(indent + 1);
 }
 
+LexicalEnvironment& Identifier::resolve_environment(Interpreter& interpreter) const
+{
+    ASSERT(m_environment_coordinate.has_value());
+    auto* environment = interpreter.current_environment();
+    for (u32 i = 0; i < m_environment_coordinate.value().hops; ++i)
+        environment = environment->parent();
+    return *environment;
+}
+
 Value Identifier::execute(Interpreter& interpreter, GlobalObject& global_object) const
 {
+    if (m_environment_coordinate.has_value())
+        return resolve_environment(interpreter).get_slot(m_environment_coordinate.value().slot);
+
     auto value = interpreter.get_variable(string(), global_object);
     if (value.is_empty())
         return interpreter.throw_exception<ReferenceError>(ErrorType::UnknownIdentifier, string().characters());
@@ -1255,6 +1312,17 @@ Value AssignmentExpression::execute(Interpreter& interpreter, GlobalObject& glob
     if (interpreter.exception())
         return {};
 
+    if (m_lhs->is_identifier()) {
+        auto& identifier = static_cast<const Identifier&>(*m_lhs);
+        if (identifier.environment_coordinate().has_value()) {
+            update_function_name(rhs_result, identifier.string());
+            assign_to_slot(interpreter, identifier, rhs_result);
+            if (interpreter.exception())
+                return {};
+            return rhs_result;
+        }
+    }
+
     auto reference = m_lhs->to_reference(interpreter, global_object);
     if (interpreter.exception())
         return {};
@@ -1272,12 +1340,22 @@ Value AssignmentExpression::execute(Interpreter& interpreter, GlobalObject& glob
 
 Value UpdateExpression::execute(Interpreter& interpreter, GlobalObject& global_object) const
 {
-    auto reference = m_argument->to_reference(interpreter, global_object);
-    if (interpreter.exception())
-        return {};
-    auto old_value = reference.get(interpreter, global_object);
-    if (interpreter.exception())
-        return {};
+    const Identifier* resolved_identifier = nullptr;
+    if (m_argument->is_identifier() && static_cast<const Identifier&>(*m_argument).environment_coordinate().has_value())
+        resolved_identifier = static_cast<const Identifier*>(m_argument.ptr());
+
+    Reference reference;
+    Value old_value;
+    if (resolved_identifier) {
+        old_value = resolved_identifier->execute(interpreter, global_object);
+    } else {
+        reference = m_argument->to_reference(interpreter, global_object);
+        if (interpreter.exception())
+            return {};
+        old_value = reference.get(interpreter, global_object);
+        if (interpreter.exception())
+            return {};
+    }
     old_value = old_value.to_numeric(interpreter);
     if (interpreter.exception())
         return {};
@@ -1300,7 +1378,10 @@ Value UpdateExpression::execute(Interpreter& interpreter, GlobalObject& global_o
         ASSERT_NOT_REACHED();
     }
 
-    reference.put(interpreter, global_object, new_value);
+    if (resolved_identifier)
+        assign_to_slot(interpreter, *resolved_identifier, new_value);
+    else
+        reference.put(interpreter, global_object, new_value);
     if (interpreter.exception())
         return {};
     return m_prefixed ? new_value : old_value;
@@ -1390,7 +1471,10 @@ Value VariableDeclaration::execute(Interpreter& interpreter, GlobalObject& globa
                 return {};
             auto variable_name = declarator.id().string();
             update_function_name(initalizer_result, variable_name);
-            interpreter.set_variable(variable_name, initalizer_result, global_object, true);
+            if (auto& coordinate = declarator.id().environment_coordinate(); coordinate.has_value())
+                declarator.id().resolve_environment(interpreter).set_slot(coordinate.value().slot, initalizer_result);
+            else
+                interpreter.set_variable(variable_name, initalizer_result, global_object, true);
         }
     }
     return js_undefined();
@@ -1539,16 +1623,8 @@ void MemberExpression::dump(int indent) const
     m_property->dump(indent + 1);
 }
 
-PropertyName MemberExpression::computed_property_name(Interpreter& interpreter, GlobalObject& global_object) const
+static PropertyName property_name_from_computed_value(Interpreter& interpreter, Value index)
 {
-    if (!is_computed()) {
-        ASSERT(m_property->is_identifier());
-        return static_cast<const Identifier&>(*m_property).string();
-    }
-    auto index = m_property->execute(interpreter, global_object);
-    if (interpreter.exception())
-        return {};
-
     ASSERT(!index.is_empty());
 
     if (index.is_integer() && index.as_i32() >= 0)
@@ -1563,6 +1639,18 @@ PropertyName MemberExpression::computed_property_name(Interpreter& interpreter,
     return index_string;
 }
 
+PropertyName MemberExpression::computed_property_name(Interpreter& interpreter, GlobalObject& global_object) const
+{
+    if (!is_computed()) {
+        ASSERT(m_property->is_identifier());
+        return static_cast<const Identifier&>(*m_property).string();
+    }
+    auto index = m_property->execute(interpreter, global_object);
+    if (interpreter.exception())
+        return {};
+    return property_name_from_computed_value(interpreter, index);
+}
+
 String MemberExpression::to_string_approximation() const
 {
     String object_string = "<object>";
@@ -1582,7 +1670,39 @@ Value MemberExpression::execute(Interpreter& interpreter, GlobalObject& global_o
     auto* object_result = object_value.to_object(interpreter, global_object);
     if (interpreter.exception())
         return {};
-    return object_result->get(computed_property_name(interpreter, global_object)).value_or(js_undefined());
+    return get_property(interpreter, global_object, *object_result);
+}
+
+Value MemberExpression::get_property(Interpreter& interpreter, GlobalObject& global_object, Object& object) const
+{
+    if (!is_computed()) {
+        String property_name = static_cast<const Identifier&>(*m_property).string();
+        return object.get_cached(property_name, get_cache()).value_or(js_undefined());
+    }
+    auto index = m_property->execute(interpreter, global_object);
+    if (interpreter.exception())
+        return {};
+    // Typed array elements can't be inherited or be accessors, so they are read straight from the buffer.
+    if (object.is_typed_array() && index.is_integer() && index.as_i32() >= 0)
+        return static_cast<TypedArrayBase&>(object).get_by_index(index.as_i32()).value_or(js_undefined());
+    auto property_name = property_name_from_computed_value(interpreter, index);
+    if (interpreter.exception())
+        return {};
+    return object.get(property_name).value_or(js_undefined());
+}
+
+InlineCache& MemberExpression::get_cache() const
+{
+    if (!m_get_cache)
+        m_get_cache = make<InlineCache>();
+    return *m_get_cache;
+}
+
+InlineCache& MemberExpression::put_cache() const
+{
+    if (!m_put_cache)
+        m_put_cache = make<InlineCache>();
+    return *m_put_cache;
 }
 
 Value StringLiteral::execute(Interpreter& interpreter, GlobalObject&) const
@@ -1618,7 +1738,10 @@ void RegExpLiteral::dump(int indent) const
 
 Value RegExpLiteral::execute(Interpreter&, GlobalObject& global_object) const
 {
-    return RegExpObject::create(global_object, content(), flags());
+    auto* regexp_object = RegExpObject::create(global_object, content(), flags());
+    if (!regexp_object)
+        return {};
+    return regexp_object;
 }
 
 void ArrayExpression::dump(int indent) const
@@ -1668,19 +1791,35 @@ void TemplateLiteral::dump(int indent) const
 
 Value TemplateLiteral::execute(Interpreter& interpreter, GlobalObject& global_object) const
 {
+    // Ropes are spliced in rather than copied, so that something like s = `${s}<li>${item}</li>`
+    // in a loop doesn't have to copy the whole string every time around.
+    PrimitiveString* result = nullptr;
     StringBuilder string_builder;
+    auto append_to_result = [&](PrimitiveString& string) {
+        result = result ? js_rope_string(interpreter.heap(), *result, string) : &string;
+    };
 
     for (auto& expression : m_expressions) {
         auto expr = expression.execute(interpreter, global_object);
         if (interpreter.exception())
             return {};
+        if (expr.is_string() && expr.as_string().is_rope()) {
+            if (!string_builder.is_empty()) {
+                append_to_result(*js_string(interpreter, string_builder.build()));
+                string_builder.clear();
+            }
+            append_to_result(expr.as_string());
+            continue;
+        }
         auto string = expr.to_string(interpreter);
         if (interpreter.exception())
             return {};
         string_builder.append(string);
     }
 
-    return js_string(interpreter, string_builder.build());
+    if (!result || !string_builder.is_empty())
+        append_to_result(*js_string(interpreter, string_builder.build()));
+    return result;
 }
 
 void TaggedTemplateLiteral::dump(int indent) const
@@ -30,10 +30,13 @@
 #include <AK/FlyString.h>
 #include <AK/HashMap.h>
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <LibJS/Forward.h>
+#include <LibJS/Runtime/InlineCache.h>
 #include <LibJS/Runtime/PropertyName.h>
 #include <LibJS/Runtime/Value.h>
 
@@ -42,6 +45,8 @@ namespace JS {
 class VariableDeclaration;
 class FunctionDeclaration;
 
+void update_function_name(Value&, const FlyString& name);
+
 template<class T, class... Args>
 static inline NonnullRefPtr<T>
 create_ast_node(Args&&... args)
@@ -76,6 +81,9 @@ public:
     const FlyString& label() const { return m_label; }
     void set_label(FlyString string) { m_label = string; }
 
+    // Returns false if the statement can't be compiled, which keeps the whole function in the AST interpreter.
+    virtual bool generate_bytecode(Bytecode::Generator&) const;
+
 protected:
     FlyString m_label;
 };
@@ -83,6 +91,7 @@ protected:
 class EmptyStatement final : public Statement {
 public:
     Value execute(Interpreter&, GlobalObject&) const override { return js_undefined(); }
+    virtual bool generate_bytecode(Bytecode::Generator&) const override { return true; }
     const char* class_name() const override { return "EmptyStatement"; }
 };
 
@@ -100,6 +109,7 @@ public:
     }
 
     Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
     const char* class_name() const override { return "ExpressionStatement"; }
     virtual void dump(int indent) const override;
 
@@ -109,6 +119,8 @@ private:
 
 class ScopeNode : public Statement {
 public:
+    virtual ~ScopeNode() override;
+
     template<typename T, typename... Args>
     T& append(Args&&... args)
     {
@@ -132,8 +144,15 @@ public:
     bool in_strict_mode() const { return m_strict_mode; }
     void set_strict_mode() { m_strict_mode = true; }
 
+    // Compiled on first use when this is a function body; null if it can't be compiled.
+    const Bytecode::Executable* bytecode_executable() const;
+
+    // Shared by every environment created for this scope, see EnvironmentLayout.
+    EnvironmentLayout* environment_layout() const { return m_environment_layout.ptr(); }
+    void set_environment_layout(NonnullRefPtr<EnvironmentLayout>) const;
+
 protected:
-    ScopeNode() { }
+    ScopeNode();
 
 private:
     virtual bool is_scope_node() const final { return true; }
@@ -141,6 +160,9 @@ private:
     NonnullRefPtrVector<VariableDeclaration> m_variables;
     NonnullRefPtrVector<FunctionDeclaration> m_functions;
     bool m_strict_mode { false };
+    mutable OwnPtr<Bytecode::Executable> m_bytecode_executable;
+    mutable bool m_tried_generating_bytecode { false };
+    mutable RefPtr<EnvironmentLayout> m_environment_layout;
 };
 
 class Program : public ScopeNode {
@@ -156,6 +178,8 @@ class BlockStatement : public ScopeNode {
 public:
     BlockStatement() { }
 
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
+
 private:
     virtual const char* class_name() const override { return "BlockStatement"; }
 };
@@ -163,11 +187,40 @@ private:
 class Expression : public ASTNode {
 public:
     virtual Reference to_reference(Interpreter&, GlobalObject&) const;
+
+    // Puts the expression's value into dst. Expressions without instructions of their own are evaluated by the AST interpreter.
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const;
 };
 
 class Declaration : public Statement {
 };
 
+// The body of a function that the parser only skipped over to find its end. It's parsed
+// in full the first time it's needed, and shared by every function object created from it.
+class LazyFunctionBody : public RefCounted<LazyFunctionBody> {
+public:
+    virtual ~LazyFunctionBody() { }
+
+    // Null if the body turned out to have a syntax error, which is then in error().
+    const Statement* body()
+    {
+        if (!m_parsed) {
+            m_body = parse(m_error);
+            m_parsed = true;
+        }
+        return m_body.ptr();
+    }
+    const String& error() const { return m_error; }
+
+protected:
+    virtual RefPtr<Statement> parse(String& error) = 0;
+
+private:
+    RefPtr<Statement> m_body;
+    String m_error;
+    bool m_parsed { false };
+};
+
 class FunctionNode {
 public:
     struct Parameter {
@@ -177,10 +230,25 @@ public:
     };
 
     const FlyString& name() const { return m_name; }
-    const Statement& body() const { return *m_body; }
+    const Statement& body() const
+    {
+        ASSERT(m_body);
+        return *m_body;
+    }
+    // Either the body or the lazy body is set.
+    const RefPtr<Statement>& body_ptr() const { return m_body; }
+    const RefPtr<LazyFunctionBody>& lazy_body() const { return m_lazy_body; }
     const Vector<Parameter>& parameters() const { return m_parameters; };
     i32 function_length() const { return m_function_length; }
 
+    size_t source_line() const { return m_source_line; }
+    size_t source_column() const { return m_source_column; }
+    void set_source_position(size_t line, size_t column)
+    {
+        m_source_line = line;
+        m_source_column = column;
+    }
+
 protected:
     FunctionNode(const FlyString& name, NonnullRefPtr<Statement> body, Vector<Parameter> parameters, i32 function_length, NonnullRefPtrVector<VariableDeclaration> variables)
         : m_name(name)
@@ -191,16 +259,27 @@ protected:
     {
     }
 
+    FunctionNode(const FlyString& name, Vector<Parameter> parameters, i32 function_length, NonnullRefPtr<LazyFunctionBody> lazy_body)
+        : m_name(name)
+        , m_lazy_body(move(lazy_body))
+        , m_parameters(move(parameters))
+        , m_function_length(function_length)
+    {
+    }
+
     void dump(int indent, const char* class_name) const;
 
     const NonnullRefPtrVector<VariableDeclaration>& variables() const { return m_variables; }
 
 private:
     FlyString m_name;
-    NonnullRefPtr<Statement> m_body;
+    RefPtr<Statement> m_body;
+    RefPtr<LazyFunctionBody> m_lazy_body;
     const Vector<Parameter> m_parameters;
     NonnullRefPtrVector<VariableDeclaration> m_variables;
     const i32 m_function_length;
+    size_t m_source_line { 0 };
+    size_t m_source_column { 0 };
 };
 
 class FunctionDeclaration final
@@ -214,6 +293,11 @@ public:
     {
     }
 
+    FunctionDeclaration(const FlyString& name, Vector<Parameter> parameters, i32 function_length, NonnullRefPtr<LazyFunctionBody> lazy_body)
+        : FunctionNode(name, move(parameters), function_length, move(lazy_body))
+    {
+    }
+
     virtual Value execute(Interpreter&, GlobalObject&) const override;
     virtual void dump(int indent) const override;
 
@@ -233,6 +317,12 @@ public:
     {
     }
 
+    FunctionExpression(const FlyString& name, Vector<Parameter> parameters, i32 function_length, NonnullRefPtr<LazyFunctionBody> lazy_body)
+        : FunctionNode(name, move(parameters), function_length, move(lazy_body))
+        , m_is_arrow_function(false)
+    {
+    }
+
     virtual Value execute(Interpreter&, GlobalObject&) const override;
     virtual void dump(int indent) const override;
 
@@ -258,6 +348,7 @@ public:
     const Expression* argument() const { return m_argument; }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -280,6 +371,7 @@ public:
     const Statement* alternate() const { return m_alternate; }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -302,6 +394,7 @@ public:
     const Statement& body() const { return *m_body; }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -323,6 +416,7 @@ public:
     const Statement& body() const { return *m_body; }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -348,6 +442,7 @@ public:
     const Statement& body() const { return *m_body; }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -442,6 +537,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -468,6 +564,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -497,6 +594,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -515,6 +613,7 @@ public:
 
     virtual void dump(int indent) const override;
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
 
 private:
     virtual const char* class_name() const override { return "SequenceExpression"; }
@@ -535,6 +634,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -551,6 +651,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -585,6 +686,7 @@ public:
     StringView value() const { return m_value; }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -598,6 +700,7 @@ public:
     explicit NullLiteral() { }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -634,7 +737,20 @@ public:
 
     const FlyString& string() const { return m_string; }
 
+    // Where the binding lives when the parser could resolve it: how many environments up from
+    // the current one it is, and which slot of that environment it's in.
+    struct EnvironmentCoordinate {
+        u32 hops { 0 };
+        u32 slot { 0 };
+    };
+    const Optional<EnvironmentCoordinate>& environment_coordinate() const { return m_environment_coordinate; }
+    void set_environment_coordinate(EnvironmentCoordinate coordinate) { m_environment_coordinate = coordinate; }
+
+    // Only valid with an environment coordinate.
+    LexicalEnvironment& resolve_environment(Interpreter&) const;
+
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
     virtual bool is_identifier() const override { return true; }
     virtual Reference to_reference(Interpreter&, GlobalObject&) const override;
@@ -643,6 +759,7 @@ private:
     virtual const char* class_name() const override { return "Identifier"; }
 
     FlyString m_string;
+    Optional<EnvironmentCoordinate> m_environment_coordinate;
 };
 
 class ClassMethod final : public ASTNode {
@@ -821,6 +938,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -846,6 +964,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -900,6 +1019,7 @@ public:
     DeclarationKind declaration_kind() const { return m_declaration_kind; }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
     const NonnullRefPtrVector<VariableDeclarator>& declarations() const { return m_declarations; }
@@ -1046,6 +1166,7 @@ public:
     const Expression& property() const { return *m_property; }
 
     PropertyName computed_property_name(Interpreter&, GlobalObject&) const;
+    Value get_property(Interpreter&, GlobalObject&, Object&) const;
 
     String to_string_approximation() const;
 
@@ -1053,9 +1174,16 @@ private:
     virtual bool is_member_expression() const override { return true; }
     virtual const char* class_name() const override { return "MemberExpression"; }
 
+    // Only non-computed accesses have a fixed name to cache lookups for. The caches
+    // are allocated the first time they're needed, as most expressions never run.
+    InlineCache& get_cache() const;
+    InlineCache& put_cache() const;
+
     NonnullRefPtr<Expression> m_object;
     NonnullRefPtr<Expression> m_property;
     bool m_computed { false };
+    mutable OwnPtr<InlineCache> m_get_cache;
+    mutable OwnPtr<InlineCache> m_put_cache;
 };
 
 class ConditionalExpression final : public Expression {
@@ -1069,6 +1197,7 @@ public:
 
     virtual void dump(int indent) const override;
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual void generate_bytecode(Bytecode::Generator&, Bytecode::Register dst) const override;
 
 private:
     virtual const char* class_name() const override { return "ConditionalExpression"; }
@@ -1188,6 +1317,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
 
     const FlyString& target_label() const { return m_target_label; }
 
@@ -1205,6 +1335,7 @@ public:
     }
 
     virtual Value execute(Interpreter&, GlobalObject&) const override;
+    virtual bool generate_bytecode(Bytecode::Generator&) const override;
 
     const FlyString& target_label() const { return m_target_label; }
 
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Bytecode/Register.h>
+
+namespace JS {
+
+using Bytecode::Generator;
+using Bytecode::OpCode;
+using Bytecode::Register;
+
+bool Statement::generate_bytecode(Generator&) const
+{
+    return false;
+}
+
+void Expression::generate_bytecode(Generator& generator, Register dst) const
+{
+    generator.emit(OpCode::EvaluateNode, dst, generator.add_node(*this));
+}
+
+bool ExpressionStatement::generate_bytecode(Generator& generator) const
+{
+    m_expression->generate_bytecode(generator, generator.allocate_register());
+    return true;
+}
+
+bool BlockStatement::generate_bytecode(Generator& generator) const
+{
+    // Declarations would need a scope of their own.
+    if (!variables().is_empty() || !functions().is_empty())
+        return false;
+    return generator.generate_statements(children());
+}
+
+bool ReturnStatement::generate_bytecode(Generator& generator) const
+{
+    auto result = generator.allocate_register();
+    if (m_argument)
+        m_argument->generate_bytecode(generator, result);
+    else
+        generator.emit(OpCode::LoadConstant, result, generator.add_constant(js_undefined()));
+    generator.emit(OpCode::Return, result.index());
+    return true;
+}
+
+bool IfStatement::generate_bytecode(Generator& generator) const
+{
+    auto predicate = generator.allocate_register();
+    m_predicate->generate_bytecode(generator, predicate);
+    auto jump_to_alternate = generator.emit_jump(OpCode::JumpIfFalse, predicate);
+    if (!m_consequent->generate_bytecode(generator))
+        return false;
+
+    if (!m_alternate) {
+        generator.patch_jump(jump_to_alternate, generator.next_instruction_index());
+        return true;
+    }
+
+    auto jump_to_end = generator.emit_jump();
+    generator.patch_jump(jump_to_alternate, generator.next_instruction_index());
+    if (!m_alternate->generate_bytecode(generator))
+        return false;
+    generator.patch_jump(jump_to_end, generator.next_instruction_index());
+    return true;
+}
+
+bool WhileStatement::generate_bytecode(Generator& generator) const
+{
+    auto test_index = generator.next_instruction_index();
+    auto test = generator.allocate_register();
+    m_test->generate_bytecode(generator, test);
+    auto jump_to_end = generator.emit_jump(OpCode::JumpIfFalse, test);
+
+    generator.begin_loop();
+    if (!m_body->generate_bytecode(generator))
+        return false;
+    generator.patch_jump(generator.emit_jump(), test_index);
+
+    generator.patch_jump(jump_to_end, generator.next_instruction_index());
+    generator.end_loop(test_index, generator.next_instruction_index());
+    return true;
+}
+
+bool DoWhileStatement::generate_bytecode(Generator& generator) const
+{
+    auto body_index = generator.next_instruction_index();
+    generator.begin_loop();
+    if (!m_body->generate_bytecode(generator))
+        return false;
+
+    auto test_index = generator.next_instruction_index();
+    auto test = generator.allocate_register();
+    m_test->generate_bytecode(generator, test);
+    generator.patch_jump(generator.emit_jump(OpCode::JumpIfTrue, test), body_index);
+
+    generator.end_loop(test_index, generator.next_instruction_index());
+    return true;
+}
+
+bool ForStatement::generate_bytecode(Generator& generator) const
+{
+    if (m_init) {
+        if (m_init->is_variable_declaration()) {
+            // let and const in the head get a scope of their own, every iteration.
+            auto& declaration = static_cast<const VariableDeclaration&>(*m_init);
+            if (declaration.declaration_kind() != DeclarationKind::Var)
+                return false;
+            if (!declaration.generate_bytecode(generator))
+                return false;
+        } else {
+            static_cast<const Expression&>(*m_init).generate_bytecode(generator, generator.allocate_register());
+        }
+    }
+
+    auto test_index = generator.next_instruction_index();
+    Optional<size_t> jump_to_end;
+    if (m_test) {
+        auto test = generator.allocate_register();
+        m_test->generate_bytecode(generator, test);
+        jump_to_end = generator.emit_jump(OpCode::JumpIfFalse, test);
+    }
+
+    generator.begin_loop();
+    if (!m_body->generate_bytecode(generator))
+        return false;
+
+    auto update_index = generator.next_instruction_index();
+    if (m_update)
+        m_update->generate_bytecode(generator, generator.allocate_register());
+    generator.patch_jump(generator.emit_jump(), test_index);
+
+    if (jump_to_end.has_value())
+        generator.patch_jump(jump_to_end.value(), generator.next_instruction_index());
+    generator.end_loop(update_index, generator.next_instruction_index());
+    return true;
+}
+
+bool VariableDeclaration::generate_bytecode(Generator& generator) const
+{
+    for (auto& declarator : m_declarations) {
+        if (!declarator.init())
+            continue;
+        auto value = generator.allocate_register();
+        declarator.init()->generate_bytecode(generator, value);
+        generator.emit(OpCode::InitializeVariable, value.index(), generator.add_identifier(declarator.id().string()));
+    }
+    return true;
+}
+
+bool BreakStatement::generate_bytecode(Generator& generator) const
+{
+    if (!m_target_label.is_null())
+        return false;
+    return generator.emit_break();
+}
+
+bool ContinueStatement::generate_bytecode(Generator& generator) const
+{
+    if (!m_target_label.is_null())
+        return false;
+    return generator.emit_continue();
+}
+
+static OpCode opcode_for_binary_op(BinaryOp op)
+{
+    switch (op) {
+    case BinaryOp::Addition:
+        return OpCode::Add;
+    case BinaryOp::Subtraction:
+        return OpCode::Sub;
+    case BinaryOp::Multiplication:
+        return OpCode::Mul;
+    case BinaryOp::Division:
+        return OpCode::Div;
+    case BinaryOp::Modulo:
+        return OpCode::Mod;
+    case BinaryOp::Exponentiation:
+        return OpCode::Exp;
+    case BinaryOp::TypedEquals:
+        return OpCode::StrictlyEquals;
+    case BinaryOp::TypedInequals:
+        return OpCode::StrictlyInequals;
+    case BinaryOp::AbstractEquals:
+        return OpCode::LooselyEquals;
+    case BinaryOp::AbstractInequals:
+        return OpCode::LooselyInequals;
+    case BinaryOp::GreaterThan:
+        return OpCode::GreaterThan;
+    case BinaryOp::GreaterThanEquals:
+        return OpCode::GreaterThanEquals;
+    case BinaryOp::LessThan:
+        return OpCode::LessThan;
+    case BinaryOp::LessThanEquals:
+        return OpCode::LessThanEquals;
+    case BinaryOp::BitwiseAnd:
+        return OpCode::BitwiseAnd;
+    case BinaryOp::BitwiseOr:
+        return OpCode::BitwiseOr;
+    case BinaryOp::BitwiseXor:
+        return OpCode::BitwiseXor;
+    case BinaryOp::LeftShift:
+        return OpCode::LeftShift;
+    case BinaryOp::RightShift:
+        return OpCode::RightShift;
+    case BinaryOp::UnsignedRightShift:
+        return OpCode::UnsignedRightShift;
+    case BinaryOp::In:
+        return OpCode::In;
+    case BinaryOp::InstanceOf:
+        return OpCode::InstanceOf;
+    }
+    ASSERT_NOT_REACHED();
+}
+
+static OpCode opcode_for_assignment_op(AssignmentOp op)
+{
+    switch (op) {
+    case AssignmentOp::AdditionAssignment:
+        return OpCode::Add;
+    case AssignmentOp::SubtractionAssignment:
+        return OpCode::Sub;
+    case AssignmentOp::MultiplicationAssignment:
+        return OpCode::Mul;
+    case AssignmentOp::DivisionAssignment:
+        return OpCode::Div;
+    case AssignmentOp::ModuloAssignment:
+        return OpCode::Mod;
+    case AssignmentOp::ExponentiationAssignment:
+        return OpCode::Exp;
+    case AssignmentOp::BitwiseAndAssignment:
+        return OpCode::BitwiseAnd;
+    case AssignmentOp::BitwiseOrAssignment:
+        return OpCode::BitwiseOr;
+    case AssignmentOp::BitwiseXorAssignment:
+        return OpCode::BitwiseXor;
+    case AssignmentOp::LeftShiftAssignment:
+        return OpCode::LeftShift;
+    case AssignmentOp::RightShiftAssignment:
+        return OpCode::RightShift;
+    case AssignmentOp::UnsignedRightShiftAssignment:
+        return OpCode::UnsignedRightShift;
+    case AssignmentOp::Assignment:
+        break;
+    }
+    ASSERT_NOT_REACHED();
+}
+
+void BinaryExpression::generate_bytecode(Generator& generator, Register dst) const
+{
+    auto lhs = generator.allocate_register();
+    auto rhs = generator.allocate_register();
+    m_lhs->generate_bytecode(generator, lhs);
+    m_rhs->generate_bytecode(generator, rhs);
+    generator.emit(opcode_for_binary_op(m_op), dst, lhs.index(), rhs.index());
+}
+
+void LogicalExpression::generate_bytecode(Generator& generator, Register dst) const
+{
+    m_lhs->generate_bytecode(generator, dst);
+
+    size_t jump_to_end = 0;
+    switch (m_op) {
+    case LogicalOp::And:
+        jump_to_end = generator.emit_jump(OpCode::JumpIfFalse, dst);
+        break;
+    case LogicalOp::Or:
+        jump_to_end = generator.emit_jump(OpCode::JumpIfTrue, dst);
+        break;
+    case LogicalOp::NullishCoalescing:
+        jump_to_end = generator.emit_jump(OpCode::JumpIfNotNullish, dst);
+        break;
+    }
+
+    m_rhs->generate_bytecode(generator, dst);
+    generator.patch_jump(jump_to_end, generator.next_instruction_index());
+}
+
+void UnaryExpression::generate_bytecode(Generator& generator, Register dst) const
+{
+    // delete needs a reference, and typeof must not throw for an undeclared identifier.
+    if (m_op == UnaryOp::Delete || (m_op == UnaryOp::Typeof && m_lhs->is_identifier())) {
+        Expression::generate_bytecode(generator, dst);
+        return;
+    }
+
+    auto operand = generator.allocate_register();
+    m_lhs->generate_bytecode(generator, operand);
+
+    switch (m_op) {
+    case UnaryOp::BitwiseNot:
+        generator.emit(OpCode::BitwiseNot, dst, operand.index());
+        break;
+    case UnaryOp::Not:
+        generator.emit(OpCode::Not, dst, operand.index());
+        break;
+    case UnaryOp::Plus:
+        generator.emit(OpCode::UnaryPlus, dst, operand.index());
+        break;
+    case UnaryOp::Minus:
+        generator.emit(OpCode::UnaryMinus, dst, operand.index());
+        break;
+    case UnaryOp::Typeof:
+        generator.emit(OpCode::Typeof, dst, operand.index());
+        break;
+    case UnaryOp::Void:
+        generator.emit(OpCode::LoadConstant, dst, generator.add_constant(js_undefined()));
+        break;
+    case UnaryOp::Delete:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+void SequenceExpression::generate_bytecode(Generator& generator, Register dst) const
+{
+    for (auto& expression : m_expressions)
+        expression.generate_bytecode(generator, dst);
+}
+
+void BooleanLiteral::generate_bytecode(Generator& generator, Register dst) const
+{
+    generator.emit(OpCode::LoadConstant, dst, generator.add_constant(Value(m_value)));
+}
+
+void NumericLiteral::generate_bytecode(Generator& generator, Register dst) const
+{
+    generator.emit(OpCode::LoadConstant, dst, generator.add_constant(Value(m_value)));
+}
+
+void StringLiteral::generate_bytecode(Generator& generator, Register dst) const
+{
+    generator.emit(OpCode::LoadString, dst, generator.add_string(m_value));
+}
+
+void NullLiteral::generate_bytecode(Generator& generator, Register dst) const
+{
+    generator.emit(OpCode::LoadConstant, dst, generator.add_constant(js_null()));
+}
+
+void Identifier::generate_bytecode(Generator& generator, Register dst) const
+{
+    generator.emit(OpCode::GetVariable, dst, generator.add_identifier(m_string));
+}
+
+void AssignmentExpression::generate_bytecode(Generator& generator, Register dst) const
+{
+    if (!m_lhs->is_identifier()) {
+        Expression::generate_bytecode(generator, dst);
+        return;
+    }
+    auto identifier = generator.add_identifier(static_cast<const Identifier&>(*m_lhs).string());
+
+    // Like the AST interpreter, this evaluates the right hand side before reading the variable.
+    m_rhs->generate_bytecode(generator, dst);
+    if (m_op != AssignmentOp::Assignment) {
+        auto lhs = generator.allocate_register();
+        generator.emit(OpCode::GetVariable, lhs, identifier);
+        generator.emit(opcode_for_assignment_op(m_op), dst, lhs.index(), dst.index());
+    }
+    generator.emit(OpCode::SetVariable, dst.index(), identifier);
+}
+
+void UpdateExpression::generate_bytecode(Generator& generator, Register dst) const
+{
+    if (!m_argument->is_identifier()) {
+        Expression::generate_bytecode(generator, dst);
+        return;
+    }
+    auto identifier = generator.add_identifier(static_cast<const Identifier&>(*m_argument).string());
+
+    auto old_value = generator.allocate_register();
+    auto new_value = generator.allocate_register();
+    generator.emit(OpCode::GetVariable, old_value, identifier);
+    generator.emit(OpCode::ToNumeric, old_value, old_value.index());
+    generator.emit(m_op == UpdateOp::Increment ? OpCode::Increment : OpCode::Decrement, new_value, old_value.index());
+    generator.emit(OpCode::SetVariable, new_value.index(), identifier);
+    generator.emit(OpCode::Move, dst, m_prefixed ? new_value.index() : old_value.index());
+}
+
+void ConditionalExpression::generate_bytecode(Generator& generator, Register dst) const
+{
+    auto test = generator.allocate_register();
+    m_test->generate_bytecode(generator, test);
+    auto jump_to_alternate = generator.emit_jump(OpCode::JumpIfFalse, test);
+    m_consequent->generate_bytecode(generator, dst);
+    auto jump_to_end = generator.emit_jump();
+    generator.patch_jump(jump_to_alternate, generator.next_instruction_index());
+    m_alternate->generate_bytecode(generator, dst);
+    generator.patch_jump(jump_to_end, generator.next_instruction_index());
+}
+
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+
+namespace JS::Bytecode {
+
+Generator::Generator()
+    : m_executable(make<Executable>())
+{
+}
+
+OwnPtr<Executable> Generator::generate(const ScopeNode& function_body)
+{
+    Generator generator;
+    if (!generator.generate_statements(function_body.children()))
+        return nullptr;
+
+    // Falling off the end of a function returns undefined.
+    auto result = generator.allocate_register();
+    generator.emit(OpCode::LoadConstant, result, generator.add_constant(js_undefined()));
+    generator.emit(OpCode::Return, result.index());
+    return move(generator.m_executable);
+}
+
+Register Generator::allocate_register()
+{
+    return Register(m_executable->register_count++);
+}
+
+size_t Generator::emit(OpCode opcode, Register dst, u32 a, u32 b)
+{
+    m_executable->instructions.append(Instruction { opcode, dst.index(), a, b });
+    return m_executable->instructions.size() - 1;
+}
+
+size_t Generator::emit(OpCode opcode, u32 a, u32 b)
+{
+    m_executable->instructions.append(Instruction { opcode, 0, a, b });
+    return m_executable->instructions.size() - 1;
+}
+
+size_t Generator::emit_jump(OpCode opcode, Register condition)
+{
+    ASSERT(opcode == OpCode::JumpIfTrue || opcode == OpCode::JumpIfFalse || opcode == OpCode::JumpIfNotNullish);
+    return emit(opcode, condition.index());
+}
+
+size_t Generator::emit_jump()
+{
+    return emit(OpCode::Jump);
+}
+
+void Generator::patch_jump(size_t jump_index, size_t target)
+{
+    m_executable->instructions[jump_index].b = target;
+}
+
+u32 Generator::add_constant(Value value)
+{
+    ASSERT(!value.is_cell());
+    m_executable->constants.append(value);
+    return m_executable->constants.size() - 1;
+}
+
+u32 Generator::add_string(const String& string)
+{
+    m_executable->strings.append(string);
+    return m_executable->strings.size() - 1;
+}
+
+u32 Generator::add_identifier(const FlyString& identifier)
+{
+    if (auto it = m_identifier_indices.find(identifier); it != m_identifier_indices.end())
+        return (*it).value;
+    m_executable->identifiers.append(identifier);
+    u32 index = m_executable->identifiers.size() - 1;
+    m_identifier_indices.set(identifier, index);
+    return index;
+}
+
+u32 Generator::add_node(const Expression& node)
+{
+    m_executable->nodes.append(&node);
+    return m_executable->nodes.size() - 1;
+}
+
+bool Generator::generate_statements(const NonnullRefPtrVector<Statement>& statements)
+{
+    for (auto& statement : statements) {
+        if (!statement.generate_bytecode(*this))
+            return false;
+    }
+    return true;
+}
+
+void Generator::begin_loop()
+{
+    m_loops.append(Loop {});
+}
+
+void Generator::end_loop(size_t continue_target, size_t break_target)
+{
+    auto loop = m_loops.take_last();
+    for (auto jump_index : loop.continues)
+        patch_jump(jump_index, continue_target);
+    for (auto jump_index : loop.breaks)
+        patch_jump(jump_index, break_target);
+}
+
+bool Generator::emit_break()
+{
+    if (m_loops.is_empty())
+        return false;
+    m_loops.last().breaks.append(emit_jump());
+    return true;
+}
+
+bool Generator::emit_continue()
+{
+    if (m_loops.is_empty())
+        return false;
+    m_loops.last().continues.append(emit_jump());
+    return true;
+}
+
+}
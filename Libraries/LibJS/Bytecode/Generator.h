@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Register.h>
+#include <LibJS/Forward.h>
+
+namespace JS::Bytecode {
+
+// Compiles a function body into an Executable. Statements the generator doesn't know how to
+// compile make the whole body fall back to the AST interpreter, while expressions it doesn't
+// know are embedded as EvaluateNode instructions instead.
+class Generator {
+public:
+    static OwnPtr<Executable> generate(const ScopeNode& function_body);
+
+    Register allocate_register();
+
+    size_t emit(OpCode, Register dst, u32 a = 0, u32 b = 0);
+    size_t emit(OpCode, u32 a = 0, u32 b = 0);
+    size_t emit_jump(OpCode, Register condition);
+    size_t emit_jump();
+    void patch_jump(size_t jump_index, size_t target);
+    size_t next_instruction_index() const { return m_executable->instructions.size(); }
+
+    u32 add_constant(Value);
+    u32 add_string(const String&);
+    u32 add_identifier(const FlyString&);
+    u32 add_node(const Expression&);
+
+    bool generate_statements(const NonnullRefPtrVector<Statement>&);
+
+    // Breaks and continues inside a loop jump to targets that are only known once the
+    // whole loop has been generated, so they're collected here and patched at the end.
+    void begin_loop();
+    void end_loop(size_t continue_target, size_t break_target);
+    bool emit_break();
+    bool emit_continue();
+
+private:
+    Generator();
+
+    struct Loop {
+        Vector<size_t> breaks;
+        Vector<size_t> continues;
+    };
+
+    OwnPtr<Executable> m_executable;
+    HashMap<FlyString, u32> m_identifier_indices;
+    Vector<Loop> m_loops;
+};
+
+}
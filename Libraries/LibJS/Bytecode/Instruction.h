@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace JS::Bytecode {
+
+// Binary operators that map directly onto one of the Value.h operator functions.
+#define JS_ENUMERATE_BYTECODE_BINARY_OPS(O)         \
+    O(Add, add)                                     \
+    O(Sub, sub)                                     \
+    O(Mul, mul)                                     \
+    O(Div, div)                                     \
+    O(Mod, mod)                                     \
+    O(Exp, exp)                                     \
+    O(GreaterThan, greater_than)                    \
+    O(GreaterThanEquals, greater_than_equals)       \
+    O(LessThan, less_than)                          \
+    O(LessThanEquals, less_than_equals)             \
+    O(BitwiseAnd, bitwise_and)                      \
+    O(BitwiseOr, bitwise_or)                        \
+    O(BitwiseXor, bitwise_xor)                      \
+    O(LeftShift, left_shift)                        \
+    O(RightShift, right_shift)                      \
+    O(UnsignedRightShift, unsigned_right_shift)     \
+    O(In, in)                                       \
+    O(InstanceOf, instance_of)
+
+#define JS_ENUMERATE_BYTECODE_UNARY_OPS(O) \
+    O(BitwiseNot, bitwise_not)             \
+    O(UnaryPlus, unary_plus)               \
+    O(UnaryMinus, unary_minus)
+
+// Operands are named after the Instruction fields they use: dst, a and b are registers, except
+// where they index into one of the Executable's tables, or hold the target of a jump.
+enum class OpCode : u8 {
+    LoadConstant,       // dst = constants[a]
+    LoadString,         // dst = js_string(strings[a])
+    Move,               // dst = a
+    GetVariable,        // dst = identifiers[a], throwing if it's not defined
+    SetVariable,        // identifiers[b] = a
+    InitializeVariable, // identifiers[b] = a, allowing the first assignment to a const
+    EvaluateNode,       // dst = nodes[a]->execute(), for expressions without instructions of their own
+    // dst = function(a, b) and dst = function(a) respectively
+#define __JS_ENUMERATE_OPCODE(name, function) name,
+    JS_ENUMERATE_BYTECODE_BINARY_OPS(__JS_ENUMERATE_OPCODE)
+    JS_ENUMERATE_BYTECODE_UNARY_OPS(__JS_ENUMERATE_OPCODE)
+#undef __JS_ENUMERATE_OPCODE
+    StrictlyEquals,     // dst = a === b
+    StrictlyInequals,   // dst = a !== b
+    LooselyEquals,      // dst = a == b
+    LooselyInequals,    // dst = a != b
+    Not,                // dst = !a
+    Typeof,             // dst = typeof a
+    ToNumeric,          // dst = a.to_numeric()
+    Increment,          // dst = a + 1, where a is numeric
+    Decrement,          // dst = a - 1, where a is numeric
+    Jump,               // goto b
+    JumpIfTrue,         // if (a) goto b
+    JumpIfFalse,        // if (!a) goto b
+    JumpIfNotNullish,   // if (a !== null && a !== undefined) goto b
+    Return,             // return a
+};
+
+struct Instruction {
+    OpCode opcode;
+    u32 dst { 0 };
+    u32 a { 0 };
+    u32 b { 0 };
+};
+
+const char* opcode_name(OpCode);
+
+}
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/LogStream.h>
+#include <LibCrypto/BigInt/SignedBigInteger.h>
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Runtime/BigInt.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/MarkedValueList.h>
+#include <LibJS/Runtime/PrimitiveString.h>
+
+namespace JS::Bytecode {
+
+const char* opcode_name(OpCode opcode)
+{
+    switch (opcode) {
+#define __JS_ENUMERATE_OPCODE(name, function) \
+    case OpCode::name:                        \
+        return #name;
+        JS_ENUMERATE_BYTECODE_BINARY_OPS(__JS_ENUMERATE_OPCODE)
+        JS_ENUMERATE_BYTECODE_UNARY_OPS(__JS_ENUMERATE_OPCODE)
+#undef __JS_ENUMERATE_OPCODE
+    case OpCode::LoadConstant:
+        return "LoadConstant";
+    case OpCode::LoadString:
+        return "LoadString";
+    case OpCode::Move:
+        return "Move";
+    case OpCode::GetVariable:
+        return "GetVariable";
+    case OpCode::SetVariable:
+        return "SetVariable";
+    case OpCode::InitializeVariable:
+        return "InitializeVariable";
+    case OpCode::EvaluateNode:
+        return "EvaluateNode";
+    case OpCode::StrictlyEquals:
+        return "StrictlyEquals";
+    case OpCode::StrictlyInequals:
+        return "StrictlyInequals";
+    case OpCode::LooselyEquals:
+        return "LooselyEquals";
+    case OpCode::LooselyInequals:
+        return "LooselyInequals";
+    case OpCode::Not:
+        return "Not";
+    case OpCode::Typeof:
+        return "Typeof";
+    case OpCode::ToNumeric:
+        return "ToNumeric";
+    case OpCode::Increment:
+        return "Increment";
+    case OpCode::Decrement:
+        return "Decrement";
+    case OpCode::Jump:
+        return "Jump";
+    case OpCode::JumpIfTrue:
+        return "JumpIfTrue";
+    case OpCode::JumpIfFalse:
+        return "JumpIfFalse";
+    case OpCode::JumpIfNotNullish:
+        return "JumpIfNotNullish";
+    case OpCode::Return:
+        return "Return";
+    }
+    ASSERT_NOT_REACHED();
+}
+
+void Executable::dump() const
+{
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        auto& instruction = instructions[i];
+        dbg() << String::format("%4zu: %-20s dst=%u a=%u b=%u", i, opcode_name(instruction.opcode), instruction.dst, instruction.a, instruction.b);
+    }
+}
+
+static Value typeof_value(JS::Interpreter& interpreter, Value value)
+{
+    switch (value.type()) {
+    case Value::Type::Undefined:
+        return js_string(interpreter, "undefined");
+    case Value::Type::Null:
+        return js_string(interpreter, "object");
+    case Value::Type::Number:
+        return js_string(interpreter, "number");
+    case Value::Type::String:
+        return js_string(interpreter, "string");
+    case Value::Type::Object:
+        if (value.is_function())
+            return js_string(interpreter, "function");
+        return js_string(interpreter, "object");
+    case Value::Type::Boolean:
+        return js_string(interpreter, "boolean");
+    case Value::Type::Symbol:
+        return js_string(interpreter, "symbol");
+    case Value::Type::BigInt:
+        return js_string(interpreter, "bigint");
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+Value run(JS::Interpreter& interpreter, GlobalObject& global_object, const ScopeNode& function_body, const Executable& executable, ArgumentVector arguments)
+{
+    ASSERT(!interpreter.exception());
+
+    interpreter.enter_scope(function_body, move(arguments), ScopeType::Function, global_object);
+
+    // The register file is a MarkedValueList so that values only held in registers stay alive.
+    MarkedValueList register_list(interpreter.heap());
+    register_list.values().resize(executable.register_count);
+    auto* registers = register_list.values().data();
+    auto& instructions = executable.instructions;
+
+    Value result = js_undefined();
+    size_t pc = 0;
+    for (;;) {
+        ASSERT(pc < instructions.size());
+        auto& instruction = instructions[pc++];
+        auto& dst = registers[instruction.dst];
+
+        switch (instruction.opcode) {
+        case OpCode::LoadConstant:
+            dst = executable.constants[instruction.a];
+            continue;
+        case OpCode::LoadString:
+            dst = js_string(interpreter, executable.strings[instruction.a]);
+            continue;
+        case OpCode::Move:
+            dst = registers[instruction.a];
+            continue;
+        case OpCode::GetVariable: {
+            auto& name = executable.identifiers[instruction.a];
+            dst = interpreter.get_variable(name, global_object);
+            if (dst.is_empty())
+                interpreter.throw_exception<ReferenceError>(ErrorType::UnknownIdentifier, name.characters());
+            break;
+        }
+        case OpCode::SetVariable:
+        case OpCode::InitializeVariable: {
+            auto& name = executable.identifiers[instruction.b];
+            auto value = registers[instruction.a];
+            update_function_name(value, name);
+            interpreter.set_variable(name, value, global_object, instruction.opcode == OpCode::InitializeVariable);
+            break;
+        }
+        case OpCode::EvaluateNode:
+            dst = executable.nodes[instruction.a]->execute(interpreter, global_object);
+            break;
+#define __JS_ENUMERATE_BINARY_OP(name, function)                                          \
+    case OpCode::name:                                                                    \
+        dst = function(interpreter, registers[instruction.a], registers[instruction.b]); \
+        break;
+            JS_ENUMERATE_BYTECODE_BINARY_OPS(__JS_ENUMERATE_BINARY_OP)
+#undef __JS_ENUMERATE_BINARY_OP
+#define __JS_ENUMERATE_UNARY_OP(name, function)              \
+    case OpCode::name:                                       \
+        dst = function(interpreter, registers[instruction.a]); \
+        break;
+            JS_ENUMERATE_BYTECODE_UNARY_OPS(__JS_ENUMERATE_UNARY_OP)
+#undef __JS_ENUMERATE_UNARY_OP
+        case OpCode::StrictlyEquals:
+            dst = Value(strict_eq(interpreter, registers[instruction.a], registers[instruction.b]));
+            continue;
+        case OpCode::StrictlyInequals:
+            dst = Value(!strict_eq(interpreter, registers[instruction.a], registers[instruction.b]));
+            continue;
+        case OpCode::LooselyEquals:
+            dst = Value(abstract_eq(interpreter, registers[instruction.a], registers[instruction.b]));
+            break;
+        case OpCode::LooselyInequals:
+            dst = Value(!abstract_eq(interpreter, registers[instruction.a], registers[instruction.b]));
+            break;
+        case OpCode::Not:
+            dst = Value(!registers[instruction.a].to_boolean());
+            continue;
+        case OpCode::Typeof:
+            dst = typeof_value(interpreter, registers[instruction.a]);
+            continue;
+        case OpCode::ToNumeric:
+            dst = registers[instruction.a].to_numeric(interpreter);
+            break;
+        case OpCode::Increment: {
+            auto value = registers[instruction.a];
+            if (value.is_number())
+                dst = Value(value.as_double() + 1);
+            else
+                dst = js_bigint(interpreter, value.as_bigint().big_integer().plus(Crypto::SignedBigInteger { 1 }));
+            continue;
+        }
+        case OpCode::Decrement: {
+            auto value = registers[instruction.a];
+            if (value.is_number())
+                dst = Value(value.as_double() - 1);
+            else
+                dst = js_bigint(interpreter, value.as_bigint().big_integer().minus(Crypto::SignedBigInteger { 1 }));
+            continue;
+        }
+        case OpCode::Jump:
+            pc = instruction.b;
+            continue;
+        case OpCode::JumpIfTrue:
+            if (registers[instruction.a].to_boolean())
+                pc = instruction.b;
+            continue;
+        case OpCode::JumpIfFalse:
+            if (!registers[instruction.a].to_boolean())
+                pc = instruction.b;
+            continue;
+        case OpCode::JumpIfNotNullish:
+            if (!registers[instruction.a].is_null() && !registers[instruction.a].is_undefined())
+                pc = instruction.b;
+            continue;
+        case OpCode::Return:
+            result = registers[instruction.a];
+            goto done;
+        }
+
+        // Only instructions that can throw get here.
+        if (interpreter.exception()) {
+            result = {};
+            break;
+        }
+    }
+
+done:
+    interpreter.exit_scope(function_body);
+    return result;
+}
+
+}
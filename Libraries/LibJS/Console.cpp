@@ -98,6 +98,20 @@ Value Console::count_reset()
     return js_undefined();
 }
 
+Value Console::profile()
+{
+    if (m_client)
+        return m_client->profile();
+    return js_undefined();
+}
+
+Value Console::profile_end()
+{
+    if (m_client)
+        return m_client->profile_end();
+    return js_undefined();
+}
+
 unsigned Console::counter_increment(String label)
 {
     auto value = m_counters.get(label);
@@ -120,6 +134,23 @@ bool Console::counter_reset(String label)
     return true;
 }
 
+bool Console::profile_start(String label)
+{
+    if (m_interpreter.is_profiling())
+        return false;
+    m_profile_label = move(label);
+    m_interpreter.start_profiling();
+    return true;
+}
+
+OwnPtr<Profiler> Console::profile_stop(String label)
+{
+    if (!m_interpreter.is_profiling() || m_profile_label != label)
+        return nullptr;
+    m_profile_label = {};
+    return m_interpreter.stop_profiling();
+}
+
 Vector<String> ConsoleClient::get_trace() const
 {
     Vector<String> trace;
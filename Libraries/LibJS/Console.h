@@ -29,6 +29,8 @@
 #include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/Noncopyable.h>
+#include <AK/OwnPtr.h>
+#include <AK/String.h>
 #include <LibJS/Forward.h>
 
 namespace JS {
@@ -63,14 +65,23 @@ public:
     Value count();
     Value count_reset();
 
+    Value profile();
+    Value profile_end();
+
     unsigned counter_increment(String label);
     bool counter_reset(String label);
 
+    // Only one profile can be recorded at a time. Returns false if one is already running.
+    bool profile_start(String label);
+    // Returns the finished profile, or null if no profile with the given label is running.
+    OwnPtr<Profiler> profile_stop(String label);
+
 private:
     Interpreter& m_interpreter;
     ConsoleClient* m_client { nullptr };
 
     HashMap<String, unsigned> m_counters;
+    String m_profile_label;
 };
 
 class ConsoleClient {
@@ -89,6 +100,8 @@ public:
     virtual Value trace() = 0;
     virtual Value count() = 0;
     virtual Value count_reset() = 0;
+    virtual Value profile() = 0;
+    virtual Value profile_end() = 0;
 
 protected:
     Interpreter& interpreter() { return m_console.interpreter(); }
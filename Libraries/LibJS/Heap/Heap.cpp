@@ -46,6 +46,10 @@
 //#define HEAP_DEBUG
 #endif
 
+// Checks every young generation collection against a full trace of the heap, which
+// catches references that were stored into old cells without a write barrier.
+//#define HEAP_VERIFY_YOUNG_GENERATION
+
 namespace JS {
 
 Heap::Heap(Interpreter& interpreter)
@@ -58,28 +62,40 @@ Heap::~Heap()
     collect_garbage(CollectionType::CollectEverything);
 }
 
+// How long a step of incremental marking may take when allocation has to make progress on it.
+static constexpr int incremental_marking_budget_on_allocation_ms = 2;
+
 Cell* Heap::allocate_cell(size_t size)
 {
     if (should_collect_on_every_allocation()) {
-        collect_garbage();
+        collect_garbage(CollectionType::CollectYoungGeneration);
     } else if (m_allocations_since_last_gc > m_max_allocations_between_gc) {
         m_allocations_since_last_gc = 0;
-        collect_garbage();
+        collect_garbage(CollectionType::CollectYoungGeneration);
     } else {
         ++m_allocations_since_last_gc;
     }
 
-    for (auto& block : m_blocks) {
-        if (size > block->cell_size())
-            continue;
-        if (auto* cell = block->allocate())
-            return cell;
-    }
+    auto* cell = [&]() -> Cell* {
+        for (auto& block : m_blocks) {
+            if (size > block->cell_size())
+                continue;
+            if (block->needs_sweep()) {
+                size_t live_cells = 0;
+                size_t collected_cells = 0;
+                sweep_block(*block, live_cells, collected_cells);
+            }
+            if (auto* cell = block->allocate())
+                return cell;
+        }
 
-    size_t cell_size = round_up_to_power_of_two(size, 16);
-    auto block = HeapBlock::create_with_cell_size(*this, cell_size);
-    auto* cell = block->allocate();
-    m_blocks.append(move(block));
+        size_t cell_size = round_up_to_power_of_two(size, 16);
+        auto block = HeapBlock::create_with_cell_size(*this, cell_size);
+        auto* cell = block->allocate();
+        m_blocks.append(move(block));
+        return cell;
+    }();
+    m_young_cells.append(cell);
     return cell;
 }
 
@@ -87,16 +103,89 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
 {
     Core::ElapsedTimer collection_measurement_timer;
     collection_measurement_timer.start();
-    if (collection_type == CollectionType::CollectGarbage) {
-        if (m_gc_deferrals) {
-            m_should_gc_when_deferral_ends = true;
+
+    if (collection_type == CollectionType::CollectEverything) {
+        if (m_is_marking_incrementally) {
+            m_is_marking_incrementally = false;
+            m_mark_stack.clear();
+            Cell::did_finish_incremental_marking({});
+        }
+        m_young_cells.clear();
+        m_remembered_cells.clear();
+        m_old_cells_without_write_barriers.clear();
+        for (auto& block : m_blocks) {
+            block->for_each_cell([](Cell* cell) {
+                cell->set_marked(false);
+            });
+        }
+        sweep_dead_cells(print_report, collection_measurement_timer);
+        return;
+    }
+
+    if (m_gc_deferrals) {
+        m_should_gc_when_deferral_ends = true;
+        return;
+    }
+
+    if (collection_type == CollectionType::CollectYoungGeneration) {
+        if (m_is_marking_incrementally) {
+            // Young generation collections wait for the marking to finish, so allocation
+            // keeps it going instead.
+            if (mark_incrementally(collection_measurement_timer, incremental_marking_budget_on_allocation_ms)) {
+                finish_marking(print_report, collection_measurement_timer);
+                schedule_incremental_collection_work();
+            }
+            return;
+        }
+        if (!should_collect_old_generation()) {
+            HashTable<Cell*> roots;
+            gather_roots(roots);
+            mark_live_young_cells(roots);
+#ifdef HEAP_VERIFY_YOUNG_GENERATION
+            verify_young_generation_marking(roots);
+#endif
+            sweep_dead_young_cells(print_report, collection_measurement_timer);
             return;
         }
-        HashTable<Cell*> roots;
-        gather_roots(roots);
-        mark_live_cells(roots);
+        if (m_incremental_collection_callback) {
+            start_marking();
+            schedule_incremental_collection_work();
+            return;
+        }
+    }
+
+    if (!m_is_marking_incrementally)
+        start_marking();
+    finish_marking(print_report, collection_measurement_timer);
+    if (print_report)
+        sweep_dead_cells(true, collection_measurement_timer);
+    else
+        schedule_incremental_collection_work();
+}
+
+bool Heap::perform_incremental_collection_work(int time_budget_ms)
+{
+    Core::ElapsedTimer timer;
+    timer.start();
+
+    if (m_is_marking_incrementally) {
+        if (!mark_incrementally(timer, time_budget_ms) || m_gc_deferrals)
+            return true;
+        finish_marking(false, timer);
+        return m_blocks_pending_sweep;
     }
-    sweep_dead_cells(print_report, collection_measurement_timer);
+    return sweep_pending_blocks(timer, time_budget_ms);
+}
+
+void Heap::schedule_incremental_collection_work()
+{
+    if (m_incremental_collection_callback && (m_is_marking_incrementally || m_blocks_pending_sweep))
+        m_incremental_collection_callback();
+}
+
+bool Heap::should_collect_old_generation() const
+{
+    return m_promoted_cells_since_last_full_gc > max(m_live_cells_after_last_full_gc, m_max_allocations_between_gc);
 }
 
 void Heap::gather_roots(HashTable<Cell*>& roots)
@@ -185,7 +274,8 @@ void Heap::gather_conservative_roots(HashTable<Cell*>& roots)
         dbg() << "  ? " << (const void*)possible_pointer;
 #endif
         if (auto* cell = cell_from_possible_pointer(possible_pointer)) {
-            if (cell->is_live()) {
+            // A cell that didn't survive the last full collection may not have been swept yet.
+            if (cell->is_live() && (cell->is_marked() || !HeapBlock::from_cell(cell)->needs_sweep())) {
 #ifdef HEAP_DEBUG
                 dbg() << "  ?-> " << (const void*)cell;
 #endif
@@ -207,9 +297,20 @@ Cell* Heap::cell_from_possible_pointer(FlatPtr pointer)
     return possible_heap_block->cell_from_possible_pointer(pointer);
 }
 
-class MarkingVisitor final : public Cell::Visitor {
+static bool needs_scanning_when_old(const Cell& cell)
+{
+    // A cell that gets promoted in the middle of its construction may have had references
+    // stored into it without barriers, so it's only trusted once it's complete.
+    return !cell.is_fully_constructed() || !cell.has_write_barriers();
+}
+
+class GrayingVisitor final : public Cell::Visitor {
 public:
-    MarkingVisitor() { }
+    GrayingVisitor(Vector<Cell*>& mark_stack, size_t& marked_cells)
+        : m_mark_stack(mark_stack)
+        , m_marked_cells(marked_cells)
+    {
+    }
 
     virtual void visit_impl(Cell* cell)
     {
@@ -219,61 +320,341 @@ public:
         dbg() << "  ! " << cell;
 #endif
         cell->set_marked(true);
-        cell->visit_children(*this);
+        m_mark_stack.append(cell);
+        ++m_marked_cells;
     }
+
+private:
+    Vector<Cell*>& m_mark_stack;
+    size_t& m_marked_cells;
 };
 
-void Heap::mark_live_cells(const HashTable<Cell*>& roots)
+void Heap::start_marking()
+{
+#ifdef HEAP_DEBUG
+    dbg() << "start_marking:";
+#endif
+    ASSERT(!m_is_marking_incrementally);
+
+    // The mark bits of the last full collection have to be gone before the next one starts.
+    if (m_blocks_pending_sweep) {
+        Core::ElapsedTimer timer;
+        timer.start();
+        sweep_pending_blocks(timer, 0);
+    }
+
+    // Everything is old while marking, so that the write barriers record every store.
+    for (auto* cell : m_remembered_cells)
+        cell->set_remembered(false);
+    m_remembered_cells.clear_with_capacity();
+    for (auto* cell : m_young_cells) {
+        cell->set_old(true);
+        if (needs_scanning_when_old(*cell)) {
+            cell->set_remembered(true);
+            m_old_cells_without_write_barriers.append(cell);
+        }
+    }
+    m_young_cells.clear_with_capacity();
+
+    m_marked_cells = 0;
+    HashTable<Cell*> roots;
+    gather_roots(roots);
+    GrayingVisitor visitor(m_mark_stack, m_marked_cells);
+    for (auto* root : roots)
+        visitor.visit(root);
+
+    m_is_marking_incrementally = true;
+    Cell::did_start_incremental_marking({});
+}
+
+bool Heap::mark_incrementally(const Core::ElapsedTimer& timer, int time_budget_ms)
+{
+    GrayingVisitor visitor(m_mark_stack, m_marked_cells);
+    size_t visited_cells = 0;
+    while (!m_mark_stack.is_empty()) {
+        if (time_budget_ms && (++visited_cells % 256) == 0 && timer.elapsed() >= time_budget_ms)
+            return false;
+        m_mark_stack.take_last()->visit_children(visitor);
+    }
+    return true;
+}
+
+void Heap::finish_marking(bool print_report, const Core::ElapsedTimer& measurement_timer)
 {
 #ifdef HEAP_DEBUG
-    dbg() << "mark_live_cells:";
+    dbg() << "finish_marking:";
 #endif
-    MarkingVisitor visitor;
+    ASSERT(m_is_marking_incrementally);
+
+    // The roots may have changed since marking started, and so may the cells that were already
+    // visited. Those are the ones the write barriers recorded, the ones without barriers, and
+    // the ones allocated since.
+    HashTable<Cell*> roots;
+    gather_roots(roots);
+    GrayingVisitor visitor(m_mark_stack, m_marked_cells);
     for (auto* root : roots)
         visitor.visit(root);
+    auto revisit_if_marked = [&](Cell* cell) {
+        if (cell->is_marked())
+            cell->visit_children(visitor);
+    };
+    for (auto* cell : m_remembered_cells)
+        revisit_if_marked(cell);
+    for (auto* cell : m_old_cells_without_write_barriers)
+        revisit_if_marked(cell);
+    for (auto* cell : m_young_cells)
+        revisit_if_marked(cell);
+    mark_incrementally(measurement_timer, 0);
+
+    m_is_marking_incrementally = false;
+    Cell::did_finish_incremental_marking({});
+
+    for (auto* cell : m_remembered_cells)
+        cell->set_remembered(false);
+    m_remembered_cells.clear_with_capacity();
+
+    // Every surviving cell is old now, and the unmarked ones are left for sweeping.
+    Vector<Cell*> cells_without_write_barriers;
+    auto promote_if_marked = [&](Cell* cell) {
+        if (!cell->is_marked())
+            return;
+        cell->set_old(true);
+        cell->set_remembered(needs_scanning_when_old(*cell));
+        if (cell->is_remembered())
+            cells_without_write_barriers.append(cell);
+    };
+    for (auto* cell : m_old_cells_without_write_barriers)
+        promote_if_marked(cell);
+    for (auto* cell : m_young_cells)
+        promote_if_marked(cell);
+    m_old_cells_without_write_barriers = move(cells_without_write_barriers);
+    m_young_cells.clear_with_capacity();
+
+    for (auto& block : m_blocks)
+        block->set_needs_sweep(true);
+    m_blocks_pending_sweep = m_blocks.size();
+
+    m_live_cells_after_last_full_gc = m_marked_cells;
+    m_promoted_cells_since_last_full_gc = 0;
+
+    if (print_report) {
+        dbg() << "Garbage collection marking report";
+        dbg() << "=============================================";
+        dbg() << "     Time spent: " << measurement_timer.elapsed() << " ms";
+        dbg() << "   Marked cells: " << m_marked_cells;
+        dbg() << "=============================================";
+    }
 }
 
-void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
+class YoungGenerationMarkingVisitor final : public Cell::Visitor {
+public:
+    YoungGenerationMarkingVisitor() { }
+
+    virtual void visit_impl(Cell* cell)
+    {
+        if (cell->is_old() || cell->is_marked())
+            return;
+#ifdef HEAP_DEBUG
+        dbg() << "  ! " << cell;
+#endif
+        cell->set_marked(true);
+        m_cells_to_visit.append(cell);
+    }
+
+    // Young structures can be arbitrarily deep (ropes, linked lists), so their children are
+    // visited from a stack instead of recursively.
+    void visit_pending_children()
+    {
+        while (!m_cells_to_visit.is_empty())
+            m_cells_to_visit.take_last()->visit_children(*this);
+    }
+
+private:
+    Vector<Cell*> m_cells_to_visit;
+};
+
+void Heap::mark_live_young_cells(const HashTable<Cell*>& roots)
 {
 #ifdef HEAP_DEBUG
-    dbg() << "sweep_dead_cells:";
+    dbg() << "mark_live_young_cells:";
 #endif
-    Vector<HeapBlock*, 32> empty_blocks;
+    YoungGenerationMarkingVisitor visitor;
+    for (auto* root : roots)
+        visitor.visit(root);
+
+    // Old cells can only keep young ones alive through references stored since they were
+    // promoted. Those are either recorded by a write barrier, or could have happened at any time.
+    for (auto* cell : m_remembered_cells)
+        cell->visit_children(visitor);
+    for (auto* cell : m_old_cells_without_write_barriers)
+        cell->visit_children(visitor);
 
+    visitor.visit_pending_children();
+}
+
+#ifdef HEAP_VERIFY_YOUNG_GENERATION
+class ReachabilityVisitor final : public Cell::Visitor {
+public:
+    explicit ReachabilityVisitor(HashTable<Cell*>& reachable)
+        : m_reachable(reachable)
+    {
+    }
+
+    virtual void visit_impl(Cell* cell)
+    {
+        if (m_reachable.contains(cell))
+            return;
+        m_reachable.set(cell);
+        m_cells_to_visit.append(cell);
+    }
+
+    void visit_pending_children()
+    {
+        while (!m_cells_to_visit.is_empty())
+            m_cells_to_visit.take_last()->visit_children(*this);
+    }
+
+private:
+    HashTable<Cell*>& m_reachable;
+    Vector<Cell*> m_cells_to_visit;
+};
+
+void Heap::verify_young_generation_marking(const HashTable<Cell*>& roots)
+{
+    HashTable<Cell*> reachable;
+    ReachabilityVisitor visitor(reachable);
+    for (auto* root : roots)
+        visitor.visit(root);
+    visitor.visit_pending_children();
+    for (auto* cell : reachable) {
+        if (!cell->is_old() && !cell->is_marked()) {
+            dbg() << "Reachable young cell " << cell << " was not marked";
+            ASSERT_NOT_REACHED();
+        }
+    }
+}
+#endif
+
+void Heap::sweep_dead_young_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
+{
+#ifdef HEAP_DEBUG
+    dbg() << "sweep_dead_young_cells:";
+#endif
     size_t collected_cells = 0;
-    size_t live_cells = 0;
-    size_t collected_cell_bytes = 0;
-    size_t live_cell_bytes = 0;
+    size_t promoted_cells = 0;
 
-    for (auto& block : m_blocks) {
-        bool block_has_live_cells = false;
-        block->for_each_cell([&](Cell* cell) {
-            if (cell->is_live()) {
-                if (!cell->is_marked()) {
+    for (auto* cell : m_young_cells) {
+        ASSERT(cell->is_live());
+        ASSERT(!cell->is_old());
+        if (!cell->is_marked()) {
 #ifdef HEAP_DEBUG
-                    dbg() << "  ~ " << cell;
+            dbg() << "  ~ " << cell;
 #endif
-                    block->deallocate(cell);
-                    ++collected_cells;
-                    collected_cell_bytes += block->cell_size();
-                } else {
-                    cell->set_marked(false);
-                    block_has_live_cells = true;
-                    ++live_cells;
-                    live_cell_bytes += block->cell_size();
-                }
-            }
-        });
-        if (!block_has_live_cells)
-            empty_blocks.append(block);
+            HeapBlock::from_cell(cell)->deallocate(cell);
+            ++collected_cells;
+            continue;
+        }
+        cell->set_marked(false);
+        cell->set_old(true);
+        if (needs_scanning_when_old(*cell)) {
+            // These are always scanned anyway, so there's no need for their barriers to fire.
+            cell->set_remembered(true);
+            m_old_cells_without_write_barriers.append(cell);
+        }
+        ++promoted_cells;
     }
+    m_young_cells.clear_with_capacity();
+    m_promoted_cells_since_last_full_gc += promoted_cells;
+
+    for (auto* cell : m_remembered_cells)
+        cell->set_remembered(false);
+    m_remembered_cells.clear_with_capacity();
+
+    int time_spent = measurement_timer.elapsed();
 
+    if (print_report) {
+        dbg() << "Young generation collection report";
+        dbg() << "=============================================";
+        dbg() << "     Time spent: " << time_spent << " ms";
+        dbg() << " Promoted cells: " << promoted_cells;
+        dbg() << "Collected cells: " << collected_cells;
+        dbg() << "=============================================";
+    }
+}
+
+void Heap::sweep_block(HeapBlock& block, size_t& live_cells, size_t& collected_cells)
+{
+    block.for_each_cell([&](Cell* cell) {
+        if (!cell->is_live())
+            return;
+        if (!cell->is_marked()) {
+#ifdef HEAP_DEBUG
+            dbg() << "  ~ " << cell;
+#endif
+            block.deallocate(cell);
+            ++collected_cells;
+            return;
+        }
+        cell->set_marked(false);
+        ++live_cells;
+    });
+    if (block.needs_sweep()) {
+        block.set_needs_sweep(false);
+        --m_blocks_pending_sweep;
+    }
+}
+
+void Heap::release_empty_blocks(const Vector<HeapBlock*, 32>& empty_blocks)
+{
     for (auto* block : empty_blocks) {
 #ifdef HEAP_DEBUG
         dbg() << " - Reclaim HeapBlock @ " << block << ": cell_size=" << block->cell_size();
 #endif
         m_blocks.remove_first_matching([block](auto& entry) { return entry == block; });
     }
+}
+
+bool Heap::sweep_pending_blocks(const Core::ElapsedTimer& timer, int time_budget_ms)
+{
+#ifdef HEAP_DEBUG
+    dbg() << "sweep_pending_blocks:";
+#endif
+    Vector<HeapBlock*, 32> empty_blocks;
+    for (auto& block : m_blocks) {
+        if (!m_blocks_pending_sweep || (time_budget_ms && timer.elapsed() >= time_budget_ms))
+            break;
+        if (!block->needs_sweep())
+            continue;
+        size_t live_cells = 0;
+        size_t collected_cells = 0;
+        sweep_block(*block, live_cells, collected_cells);
+        if (!live_cells)
+            empty_blocks.append(block);
+    }
+    release_empty_blocks(empty_blocks);
+    return m_blocks_pending_sweep;
+}
+
+void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measurement_timer)
+{
+#ifdef HEAP_DEBUG
+    dbg() << "sweep_dead_cells:";
+#endif
+    Vector<HeapBlock*, 32> empty_blocks;
+
+    size_t collected_cells = 0;
+    size_t live_cells = 0;
+
+    for (auto& block : m_blocks) {
+        size_t live_cells_in_block = 0;
+        sweep_block(*block, live_cells_in_block, collected_cells);
+        if (!live_cells_in_block)
+            empty_blocks.append(block);
+        live_cells += live_cells_in_block;
+    }
+    ASSERT(!m_blocks_pending_sweep);
+
+    release_empty_blocks(empty_blocks);
 
 #ifdef HEAP_DEBUG
     for (auto& block : m_blocks) {
@@ -287,8 +668,8 @@ void Heap::sweep_dead_cells(bool print_report, const Core::ElapsedTimer& measure
         dbg() << "Garbage collection report";
         dbg() << "=============================================";
         dbg() << "     Time spent: " << time_spent << " ms";
-        dbg() << "     Live cells: " << live_cells << " (" << live_cell_bytes << " bytes)";
-        dbg() << "Collected cells: " << collected_cells << " (" << collected_cell_bytes << " bytes)";
+        dbg() << "     Live cells: " << live_cells;
+        dbg() << "Collected cells: " << collected_cells;
         dbg() << "    Live blocks: " << m_blocks.size() << " (" << m_blocks.size() * HeapBlock::block_size << " bytes)";
         dbg() << "   Freed blocks: " << empty_blocks.size() << " (" << empty_blocks.size() * HeapBlock::block_size << " bytes)";
         dbg() << "=============================================";
@@ -319,6 +700,14 @@ void Heap::did_destroy_marked_value_list(Badge<MarkedValueList>, MarkedValueList
     m_marked_value_lists.remove(&list);
 }
 
+void Heap::remember(Badge<Cell>, Cell& cell)
+{
+    ASSERT(cell.is_old());
+    ASSERT(!cell.is_remembered());
+    cell.set_remembered(true);
+    m_remembered_cells.append(&cell);
+}
+
 void Heap::defer_gc(Badge<DeferGC>)
 {
     ++m_gc_deferrals;
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Function.h>
 #include <AK/HashTable.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
@@ -51,7 +52,9 @@ public:
     {
         auto* memory = allocate_cell(sizeof(T));
         new (memory) T(forward<Args>(args)...);
-        return static_cast<T*>(memory);
+        auto* cell = static_cast<T*>(memory);
+        cell->set_fully_constructed(true);
+        return cell;
     }
 
     template<typename T, typename... Args>
@@ -61,16 +64,29 @@ public:
         new (memory) T(forward<Args>(args)...);
         auto* cell = static_cast<T*>(memory);
         cell->initialize(global_object);
+        cell->set_fully_constructed(true);
         return cell;
     }
 
     enum class CollectionType {
         CollectGarbage,
+        CollectYoungGeneration,
         CollectEverything,
     };
 
     void collect_garbage(CollectionType = CollectionType::CollectGarbage, bool print_report = false);
 
+    // Once this is set, full collections triggered by allocation are marked in increments,
+    // and the heap is swept one block at a time. The callback is invoked whenever there is
+    // such work pending, which the embedder should do with perform_incremental_collection_work()
+    // when it's idle. Allocation keeps making progress on it otherwise.
+    void set_incremental_collection_callback(AK::Function<void()> callback) { m_incremental_collection_callback = move(callback); }
+
+    // Returns whether there is work left to do.
+    bool perform_incremental_collection_work(int time_budget_ms);
+
+    bool is_marking_incrementally() const { return m_is_marking_incrementally; }
+
     Interpreter& interpreter() { return m_interpreter; }
 
     bool should_collect_on_every_allocation() const { return m_should_collect_on_every_allocation; }
@@ -85,23 +101,53 @@ public:
     void defer_gc(Badge<DeferGC>);
     void undefer_gc(Badge<DeferGC>);
 
+    void remember(Badge<Cell>, Cell&);
+
 private:
     Cell* allocate_cell(size_t);
 
     void gather_roots(HashTable<Cell*>&);
     void gather_conservative_roots(HashTable<Cell*>&);
-    void mark_live_cells(const HashTable<Cell*>& live_cells);
+    void start_marking();
+    bool mark_incrementally(const Core::ElapsedTimer&, int time_budget_ms);
+    void finish_marking(bool print_report, const Core::ElapsedTimer&);
     void sweep_dead_cells(bool print_report, const Core::ElapsedTimer&);
+    bool sweep_pending_blocks(const Core::ElapsedTimer&, int time_budget_ms);
+    void sweep_block(HeapBlock&, size_t& live_cells, size_t& collected_cells);
+    void release_empty_blocks(const Vector<HeapBlock*, 32>&);
+    void mark_live_young_cells(const HashTable<Cell*>& roots);
+    void verify_young_generation_marking(const HashTable<Cell*>& roots);
+    void sweep_dead_young_cells(bool print_report, const Core::ElapsedTimer&);
+    bool should_collect_old_generation() const;
 
     Cell* cell_from_possible_pointer(FlatPtr);
+    void schedule_incremental_collection_work();
 
     size_t m_max_allocations_between_gc { 10000 };
     size_t m_allocations_since_last_gc { false };
 
     bool m_should_collect_on_every_allocation { false };
 
+    // Young generation collections promote every surviving cell, and the old generation is
+    // only collected once it has grown by as many cells as were live after the last time.
+    size_t m_live_cells_after_last_full_gc { 0 };
+    size_t m_promoted_cells_since_last_full_gc { 0 };
+
     Interpreter& m_interpreter;
     Vector<NonnullOwnPtr<HeapBlock>> m_blocks;
+
+    Vector<Cell*> m_young_cells;
+    // Old cells written to since the last collection, and old cells without write barriers.
+    Vector<Cell*> m_remembered_cells;
+    Vector<Cell*> m_old_cells_without_write_barriers;
+
+    // Cells that have been marked but whose children haven't been visited yet.
+    Vector<Cell*> m_mark_stack;
+    bool m_is_marking_incrementally { false };
+    size_t m_marked_cells { 0 };
+    size_t m_blocks_pending_sweep { 0 };
+    AK::Function<void()> m_incremental_collection_callback;
+
     HashTable<HandleImpl*> m_handles;
 
     HashTable<MarkedValueList*> m_marked_value_lists;
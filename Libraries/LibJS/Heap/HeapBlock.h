@@ -54,6 +54,11 @@ public:
 
     Heap& heap() { return m_heap; }
 
+    // Set after a full collection until the block has been swept. Until then, only its marked
+    // cells are actually alive, and the freelist is out of date.
+    bool needs_sweep() const { return m_needs_sweep; }
+    void set_needs_sweep(bool b) { m_needs_sweep = b; }
+
     static HeapBlock* from_cell(const Cell* cell)
     {
         return reinterpret_cast<HeapBlock*>((FlatPtr)cell & ~(block_size - 1));
@@ -64,6 +69,8 @@ public:
         if (pointer < reinterpret_cast<FlatPtr>(m_storage))
             return nullptr;
         size_t cell_index = (pointer - reinterpret_cast<FlatPtr>(m_storage)) / m_cell_size;
+        if (cell_index >= cell_count())
+            return nullptr;
         return cell(cell_index);
     }
 
@@ -88,6 +95,7 @@ private:
 
     Heap& m_heap;
     size_t m_cell_size { 0 };
+    bool m_needs_sweep { false };
     FreelistEntry* m_freelist { nullptr };
     u8 m_storage[];
 };
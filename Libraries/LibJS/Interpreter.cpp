@@ -28,6 +28,7 @@
 #include <AK/StringBuilder.h>
 #include <LibJS/AST.h>
 #include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/EnvironmentLayout.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/LexicalEnvironment.h>
@@ -85,6 +86,7 @@ Value Interpreter::run(GlobalObject& global_object, const Statement& statement,
         m_last_value = js_undefined();
 
     for (auto& node : block.children()) {
+        poll_profiler();
         m_last_value = node.execute(*this, global_object);
         if (should_unwind()) {
             if (should_unwind_until(ScopeType::Breakable, block.label()))
@@ -106,7 +108,7 @@ Value Interpreter::run(GlobalObject& global_object, const Statement& statement,
 void Interpreter::enter_scope(const ScopeNode& scope_node, ArgumentVector arguments, ScopeType scope_type, GlobalObject& global_object)
 {
     for (auto& declaration : scope_node.functions()) {
-        auto* function = ScriptFunction::create(global_object, declaration.name(), declaration.body(), declaration.parameters(), declaration.function_length(), current_environment());
+        auto* function = ScriptFunction::create(global_object, declaration, current_environment());
         set_variable(declaration.name(), function, global_object);
     }
 
@@ -115,31 +117,29 @@ void Interpreter::enter_scope(const ScopeNode& scope_node, ArgumentVector argume
         return;
     }
 
-    HashMap<FlyString, Variable> scope_variables_with_declaration_kind;
-    scope_variables_with_declaration_kind.ensure_capacity(16);
+    bool pushed_lexical_environment = false;
 
-    for (auto& declaration : scope_node.variables()) {
-        for (auto& declarator : declaration.declarations()) {
-            if (scope_node.is_program()) {
+    if (scope_node.is_program()) {
+        for (auto& declaration : scope_node.variables()) {
+            for (auto& declarator : declaration.declarations()) {
                 global_object.put(declarator.id().string(), js_undefined());
                 if (exception())
                     return;
-            } else {
-                scope_variables_with_declaration_kind.set(declarator.id().string(), { js_undefined(), declaration.declaration_kind() });
             }
         }
-    }
-
-    for (auto& argument : arguments) {
-        scope_variables_with_declaration_kind.set(argument.name, { argument.value, DeclarationKind::Var });
-    }
-
-    bool pushed_lexical_environment = false;
-
-    if (!scope_variables_with_declaration_kind.is_empty()) {
-        auto* block_lexical_environment = heap().allocate<LexicalEnvironment>(global_object, move(scope_variables_with_declaration_kind), current_environment());
-        m_call_stack.last().environment = block_lexical_environment;
-        pushed_lexical_environment = true;
+    } else {
+        Vector<FlyString> argument_names;
+        for (auto& argument : arguments)
+            argument_names.append(argument.name);
+        auto layout = EnvironmentLayout::for_block(scope_node, argument_names);
+
+        if (!layout->is_empty()) {
+            auto* block_lexical_environment = heap().allocate<LexicalEnvironment>(global_object, move(layout), current_environment());
+            for (auto& argument : arguments)
+                block_lexical_environment->set(argument.name, { argument.value, DeclarationKind::Var });
+            m_call_stack.last().environment = block_lexical_environment;
+            pushed_lexical_environment = true;
+        }
     }
 
     m_scope_stack.append({ scope_type, scope_node, pushed_lexical_environment });
@@ -233,6 +233,8 @@ void Interpreter::gather_roots(Badge<Heap>, HashTable<Cell*>& roots)
             if (argument.is_cell())
                 roots.set(argument.as_cell());
         }
+        if (call_frame.function)
+            roots.set(call_frame.function);
         roots.set(call_frame.environment);
     }
 
@@ -251,6 +253,7 @@ Value Interpreter::call(Function& function, Value this_value, Optional<MarkedVal
 
     auto& call_frame = push_call_frame();
     call_frame.function_name = function.name();
+    call_frame.function = &function;
     call_frame.this_value = function.bound_this().value_or(this_value);
     call_frame.arguments = function.bound_arguments();
     if (arguments.has_value())
@@ -260,6 +263,7 @@ Value Interpreter::call(Function& function, Value this_value, Optional<MarkedVal
     ASSERT(call_frame.environment->this_binding_status() == LexicalEnvironment::ThisBindingStatus::Uninitialized);
     call_frame.environment->bind_this_value(call_frame.this_value);
 
+    poll_profiler();
     auto result = function.call(*this);
     pop_call_frame();
     return result;
@@ -269,6 +273,7 @@ Value Interpreter::construct(Function& function, Function& new_target, Optional<
 {
     auto& call_frame = push_call_frame();
     call_frame.function_name = function.name();
+    call_frame.function = &function;
     call_frame.arguments = function.bound_arguments();
     if (arguments.has_value())
         call_frame.arguments.append(arguments.value().values());
@@ -295,6 +300,7 @@ Value Interpreter::construct(Function& function, Function& new_target, Optional<
     // If we are a Derived constructor, |this| has not been constructed before super is called.
     Value this_value = function.constructor_kind() == Function::ConstructorKind::Base ? new_object : Value {};
     call_frame.this_value = this_value;
+    poll_profiler();
     auto result = function.construct(*this, new_target);
 
     this_value = current_environment()->get_this_binding();
@@ -324,6 +330,17 @@ Value Interpreter::construct(Function& function, Function& new_target, Optional<
     return this_value;
 }
 
+void Interpreter::start_profiling(u64 sample_interval_us)
+{
+    if (!m_profiler)
+        m_profiler = make<Profiler>(*this, sample_interval_us);
+}
+
+OwnPtr<Profiler> Interpreter::stop_profiling()
+{
+    return move(m_profiler);
+}
+
 Value Interpreter::throw_exception(Exception* exception)
 {
 #ifdef INTERPRETER_DEBUG
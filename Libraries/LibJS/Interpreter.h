@@ -28,6 +28,7 @@
 
 #include <AK/FlyString.h>
 #include <AK/HashMap.h>
+#include <AK/OwnPtr.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <AK/Weakable.h>
@@ -35,6 +36,7 @@
 #include <LibJS/Console.h>
 #include <LibJS/Forward.h>
 #include <LibJS/Heap/Heap.h>
+#include <LibJS/Profiler.h>
 #include <LibJS/Runtime/ErrorTypes.h>
 #include <LibJS/Runtime/Exception.h>
 #include <LibJS/Runtime/LexicalEnvironment.h>
@@ -60,6 +62,8 @@ struct ScopeFrame {
 
 struct CallFrame {
     FlyString function_name;
+    // Null for the global execution context and native property accessors.
+    Function* function { nullptr };
     Value this_value;
     Vector<Value> arguments;
     LexicalEnvironment* environment { nullptr };
@@ -123,7 +127,7 @@ public:
 
     CallFrame& push_call_frame()
     {
-        m_call_stack.append({ {}, js_undefined(), {}, nullptr });
+        m_call_stack.append({ {}, nullptr, js_undefined(), {}, nullptr });
         return m_call_stack.last();
     }
     void pop_call_frame() { m_call_stack.take_last(); }
@@ -198,6 +202,20 @@ public:
     bool underscore_is_last_value() const { return m_underscore_is_last_value; }
     void set_underscore_is_last_value(bool b) { m_underscore_is_last_value = b; }
 
+    // Run function bodies through the bytecode interpreter where the generator supports them.
+    bool bytecode_enabled() const { return m_bytecode_enabled; }
+    void set_bytecode_enabled(bool b) { m_bytecode_enabled = b; }
+
+    // Starts sampling the call stack. Stopping hands the collected profile over to the caller.
+    void start_profiling(u64 sample_interval_us = 1000);
+    OwnPtr<Profiler> stop_profiling();
+    bool is_profiling() const { return m_profiler; }
+    ALWAYS_INLINE void poll_profiler()
+    {
+        if (m_profiler)
+            m_profiler->poll();
+    }
+
     Console& console() { return m_console; }
     const Console& console() const { return m_console; }
 
@@ -230,6 +248,9 @@ private:
     FlyString m_unwind_until_label;
 
     bool m_underscore_is_last_value { false };
+    bool m_bytecode_enabled { false };
+
+    OwnPtr<Profiler> m_profiler;
 
     Console m_console;
 
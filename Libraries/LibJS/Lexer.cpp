@@ -147,6 +147,17 @@ Lexer::Lexer(StringView source)
     consume();
 }
 
+Lexer::Lexer(StringView source, size_t offset, size_t line_number, size_t line_column)
+    : Lexer(source.substring_view(0, 0))
+{
+    ASSERT(offset < source.length());
+    m_source = source;
+    m_position = offset + 1;
+    m_current_char = source[offset];
+    m_line_number = line_number;
+    m_line_column = line_column;
+}
+
 void Lexer::consume()
 {
     if (m_position > m_source.length())
@@ -37,9 +37,13 @@ namespace JS {
 class Lexer {
 public:
     explicit Lexer(StringView source);
+    // Starts in the middle of the source, at a token that an earlier lexer found at the given offset.
+    Lexer(StringView source, size_t offset, size_t line_number, size_t line_column);
 
     Token next();
 
+    const StringView& source() const { return m_source; }
+
 private:
     void consume();
     void consume_exponent();
@@ -65,6 +65,36 @@ public:
     unsigned m_mask { 0 };
 };
 
+class BindingScopePusher {
+public:
+    explicit BindingScopePusher(Parser& parser, bool should_push = true, bool is_function_declaration = false)
+        : m_parser(parser)
+        , m_should_push(should_push)
+    {
+        if (!m_should_push)
+            return;
+        auto scope = adopt(*new Parser::BindingScope);
+        scope->parent = m_parser.m_parser_state.m_binding_scope;
+        scope->is_function_declaration = is_function_declaration;
+        m_parser.m_parser_state.m_binding_scope = move(scope);
+    }
+
+    ~BindingScopePusher()
+    {
+        if (m_should_push)
+            m_parser.m_parser_state.m_binding_scope = m_parser.m_parser_state.m_binding_scope->parent;
+    }
+
+    void set_layout(NonnullRefPtr<EnvironmentLayout> layout)
+    {
+        ASSERT(m_should_push);
+        m_parser.m_parser_state.m_binding_scope->layout = move(layout);
+    }
+
+    Parser& m_parser;
+    bool m_should_push { true };
+};
+
 class OperatorPrecedenceTable {
 public:
     constexpr OperatorPrecedenceTable()
@@ -184,9 +214,63 @@ Parser::ParserState::ParserState(Lexer lexer)
 
 Parser::Parser(Lexer lexer)
     : m_parser_state(move(lexer))
+    , m_source_context(adopt(*new SourceContext))
 {
 }
 
+class DeferredFunctionBody final : public LazyFunctionBody {
+public:
+    DeferredFunctionBody(NonnullRefPtr<Parser::SourceContext> source_context, NonnullRefPtr<Parser::BindingScope> binding_scope, const Token& curly_open, size_t offset, const Parser::ParserState& state, const Vector<FunctionNode::Parameter>& parameters)
+        : m_source_context(move(source_context))
+        , m_binding_scope(move(binding_scope))
+        , m_offset(offset)
+        , m_line_number(curly_open.line_number())
+        , m_line_column(curly_open.line_column())
+        , m_strict_mode(state.m_strict_mode)
+        , m_allow_super_property_lookup(state.m_allow_super_property_lookup)
+        , m_allow_super_constructor_call(state.m_allow_super_constructor_call)
+        , m_parameters(parameters)
+    {
+    }
+
+private:
+    virtual RefPtr<Statement> parse(String& error) override
+    {
+        Parser parser(Lexer(m_source_context->source, m_offset, m_line_number, m_line_column));
+        parser.m_source_context = m_source_context;
+        parser.m_lazy_function_parsing = true;
+
+        auto& state = parser.m_parser_state;
+        state.m_strict_mode = m_strict_mode;
+        state.m_allow_super_property_lookup = m_allow_super_property_lookup;
+        state.m_allow_super_constructor_call = m_allow_super_constructor_call;
+        state.m_binding_scope = m_binding_scope;
+
+        ScopePusher scope(parser, ScopePusher::Var | ScopePusher::Function);
+        auto body = parser.parse_block_statement(false);
+        body->add_variables(state.m_var_scopes.last());
+        body->add_functions(state.m_function_scopes.last());
+        if (parser.has_errors()) {
+            error = parser.errors()[0].to_string();
+            return nullptr;
+        }
+        m_binding_scope->layout = EnvironmentLayout::for_function(m_parameters, *body);
+        m_binding_scope->has_deferred_layout = false;
+        parser.resolve_identifier_references();
+        return body;
+    }
+
+    NonnullRefPtr<Parser::SourceContext> m_source_context;
+    NonnullRefPtr<Parser::BindingScope> m_binding_scope;
+    size_t m_offset { 0 };
+    size_t m_line_number { 0 };
+    size_t m_line_column { 0 };
+    bool m_strict_mode { false };
+    bool m_allow_super_property_lookup { false };
+    bool m_allow_super_constructor_call { false };
+    Vector<FunctionNode::Parameter> m_parameters;
+};
+
 Associativity Parser::operator_associativity(TokenType type) const
 {
     switch (type) {
@@ -231,6 +315,7 @@ Associativity Parser::operator_associativity(TokenType type) const
 NonnullRefPtr<Program> Parser::parse_program()
 {
     ScopePusher scope(*this, ScopePusher::Var | ScopePusher::Let | ScopePusher::Function);
+    BindingScopePusher binding_scope(*this);
     auto program = adopt(*new Program);
 
     bool first = true;
@@ -258,9 +343,108 @@ NonnullRefPtr<Program> Parser::parse_program()
     } else {
         syntax_error("Unclosed scope");
     }
+    resolve_identifier_references();
     return program;
 }
 
+NonnullRefPtr<Identifier> Parser::create_identifier_reference(const FlyString& name)
+{
+    auto identifier = create_ast_node<Identifier>(name);
+    if (m_parser_state.m_binding_scope)
+        m_identifier_references.append({ identifier, *m_parser_state.m_binding_scope });
+    return identifier;
+}
+
+void Parser::resolve_identifier_references()
+{
+    for (auto& reference : m_identifier_references) {
+        auto& name = reference.identifier->string();
+        // A class declaration adds its binding to whatever environment is current when it runs.
+        if (m_source_context->class_declaration_names.contains(name))
+            continue;
+        u32 hops = 0;
+        for (auto* scope = reference.scope.ptr(); scope; scope = scope->parent.ptr()) {
+            if (scope->has_deferred_layout)
+                break;
+            if (scope->layout) {
+                if (auto slot = scope->layout->slot_of(name); slot.has_value()) {
+                    reference.identifier->set_environment_coordinate({ hops, static_cast<u32>(slot.value()) });
+                    break;
+                }
+                ++hops;
+            }
+            // Function declarations are instantiated again by every scope they're hoisted into,
+            // so the parent of their environment depends on which of those ran last.
+            if (scope->is_function_declaration)
+                break;
+        }
+    }
+    m_identifier_references.clear();
+}
+
+// Finds the end of the function body starting at the current token by matching up brackets, which is
+// also all the syntax checking that happens before it's parsed. Returns null, without consuming anything,
+// if the body has to be parsed right away.
+RefPtr<LazyFunctionBody> Parser::try_skip_function_body(const Vector<FunctionNode::Parameter>& parameters)
+{
+    if (!match(TokenType::CurlyOpen))
+        return nullptr;
+
+    auto lexer = m_parser_state.m_lexer;
+    Vector<TokenType, 32> expected_closing_brackets;
+    expected_closing_brackets.append(TokenType::CurlyClose);
+    while (!expected_closing_brackets.is_empty()) {
+        auto token = lexer.next();
+        switch (token.type()) {
+        case TokenType::CurlyOpen:
+            expected_closing_brackets.append(TokenType::CurlyClose);
+            break;
+        case TokenType::ParenOpen:
+            expected_closing_brackets.append(TokenType::ParenClose);
+            break;
+        case TokenType::BracketOpen:
+            expected_closing_brackets.append(TokenType::BracketClose);
+            break;
+        case TokenType::TemplateLiteralExprStart:
+            expected_closing_brackets.append(TokenType::TemplateLiteralExprEnd);
+            break;
+        case TokenType::CurlyClose:
+        case TokenType::ParenClose:
+        case TokenType::BracketClose:
+        case TokenType::TemplateLiteralExprEnd:
+            if (expected_closing_brackets.take_last() != token.type())
+                return nullptr;
+            break;
+        case TokenType::Super:
+            // Whether it's allowed depends on the functions in between.
+            if (!m_parser_state.m_allow_super_property_lookup || !m_parser_state.m_allow_super_constructor_call)
+                return nullptr;
+            break;
+        case TokenType::Eof:
+        case TokenType::Invalid:
+        case TokenType::UnterminatedRegexLiteral:
+        case TokenType::UnterminatedStringLiteral:
+        case TokenType::UnterminatedTemplateLiteral:
+            // Let the parser report it.
+            return nullptr;
+        default:
+            break;
+        }
+    }
+
+    if (m_source_context->source.is_null())
+        m_source_context->source = m_parser_state.m_lexer.source();
+    auto& curly_open = m_parser_state.m_current_token;
+    size_t offset = curly_open.value().characters_without_null_termination() - m_parser_state.m_lexer.source().characters_without_null_termination();
+    auto& binding_scope = *m_parser_state.m_binding_scope;
+    binding_scope.has_deferred_layout = true;
+    auto lazy_body = adopt(*new DeferredFunctionBody(m_source_context, binding_scope, curly_open, offset, m_parser_state, parameters));
+
+    m_parser_state.m_lexer = move(lexer);
+    m_parser_state.m_current_token = m_parser_state.m_lexer.next();
+    return lazy_body;
+}
+
 NonnullRefPtr<Statement> Parser::parse_statement()
 {
     auto statement = [this]() -> NonnullRefPtr<Statement> {
@@ -324,6 +508,8 @@ NonnullRefPtr<Statement> Parser::parse_statement()
 
 RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expect_parens)
 {
+    auto start_line = m_parser_state.m_current_token.line_number();
+    auto start_column = m_parser_state.m_current_token.line_column();
     save_state();
     m_parser_state.m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
 
@@ -331,6 +517,7 @@ RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expe
         m_parser_state.m_var_scopes.take_last();
         load_state();
     };
+    BindingScopePusher binding_scope(*this);
 
     Vector<FunctionNode::Parameter> parameters;
     bool parse_failed = false;
@@ -396,7 +583,7 @@ RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expe
     auto function_body_result = [this]() -> RefPtr<BlockStatement> {
         if (match(TokenType::CurlyOpen)) {
             // Parse a function body with statements
-            return parse_block_statement();
+            return parse_block_statement(false);
         }
         if (match_expression()) {
             // Parse a function body which returns a single expression
@@ -417,7 +604,10 @@ RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expe
     if (!function_body_result.is_null()) {
         state_rollback_guard.disarm();
         auto body = function_body_result.release_nonnull();
-        return create_ast_node<FunctionExpression>("", move(body), move(parameters), function_length, m_parser_state.m_var_scopes.take_last(), true);
+        binding_scope.set_layout(EnvironmentLayout::for_function(parameters, *body));
+        auto function = create_ast_node<FunctionExpression>("", move(body), move(parameters), function_length, m_parser_state.m_var_scopes.take_last(), true);
+        function->set_source_position(start_line, start_column);
+        return function;
     }
 
     return nullptr;
@@ -446,7 +636,9 @@ RefPtr<Statement> Parser::try_parse_labelled_statement()
 
 NonnullRefPtr<ClassDeclaration> Parser::parse_class_declaration()
 {
-    return create_ast_node<ClassDeclaration>(parse_class_expression(true));
+    auto class_expression = parse_class_expression(true);
+    m_source_context->class_declaration_names.set(class_expression->name());
+    return create_ast_node<ClassDeclaration>(move(class_expression));
 }
 
 NonnullRefPtr<ClassExpression> Parser::parse_class_expression(bool expect_class_name)
@@ -607,7 +799,7 @@ NonnullRefPtr<Expression> Parser::parse_primary_expression()
         if (!arrow_function_result.is_null()) {
             return arrow_function_result.release_nonnull();
         }
-        return create_ast_node<Identifier>(consume().value());
+        return create_identifier_reference(consume().value());
     }
     case TokenType::NumericLiteral:
         return create_ast_node<NumericLiteral>(consume().double_value());
@@ -755,7 +947,7 @@ NonnullRefPtr<ObjectExpression> Parser::parse_object_expression()
                 property_name = parse_property_key();
             } else {
                 property_name = create_ast_node<StringLiteral>(identifier);
-                property_value = create_ast_node<Identifier>(identifier);
+                property_value = create_identifier_reference(identifier);
             }
         } else {
             property_name = parse_property_key();
@@ -1197,9 +1389,10 @@ NonnullRefPtr<ReturnStatement> Parser::parse_return_statement()
     return create_ast_node<ReturnStatement>(nullptr);
 }
 
-NonnullRefPtr<BlockStatement> Parser::parse_block_statement()
+NonnullRefPtr<BlockStatement> Parser::parse_block_statement(bool has_own_environment)
 {
     ScopePusher scope(*this, ScopePusher::Let);
+    BindingScopePusher binding_scope(*this, has_own_environment);
     auto block = create_ast_node<BlockStatement>();
     consume(TokenType::CurlyOpen);
 
@@ -1236,6 +1429,8 @@ NonnullRefPtr<BlockStatement> Parser::parse_block_statement()
     consume(TokenType::CurlyClose);
     block->add_variables(m_parser_state.m_let_scopes.last());
     block->add_functions(m_parser_state.m_function_scopes.last());
+    if (has_own_environment && !block->variables().is_empty())
+        binding_scope.set_layout(EnvironmentLayout::for_block(*block));
     return block;
 }
 
@@ -1244,8 +1439,11 @@ NonnullRefPtr<FunctionNodeType> Parser::parse_function_node(bool check_for_funct
 {
     TemporaryChange super_property_access_rollback(m_parser_state.m_allow_super_property_lookup, allow_super_property_lookup);
     TemporaryChange super_constructor_call_rollback(m_parser_state.m_allow_super_constructor_call, allow_super_constructor_call);
+    auto start_line = m_parser_state.m_current_token.line_number();
+    auto start_column = m_parser_state.m_current_token.line_column();
 
     ScopePusher scope(*this, ScopePusher::Var | ScopePusher::Function);
+    BindingScopePusher binding_scope(*this, true, IsSame<FunctionNodeType, FunctionDeclaration>::value);
 
     if (check_for_function_and_name)
         consume(TokenType::Function);
@@ -1287,10 +1485,21 @@ NonnullRefPtr<FunctionNodeType> Parser::parse_function_node(bool check_for_funct
     if (function_length == -1)
         function_length = parameters.size();
 
-    auto body = parse_block_statement();
+    if (m_lazy_function_parsing) {
+        if (auto lazy_body = try_skip_function_body(parameters)) {
+            auto function = create_ast_node<FunctionNodeType>(name, move(parameters), function_length, lazy_body.release_nonnull());
+            function->set_source_position(start_line, start_column);
+            return function;
+        }
+    }
+
+    auto body = parse_block_statement(false);
     body->add_variables(m_parser_state.m_var_scopes.last());
     body->add_functions(m_parser_state.m_function_scopes.last());
-    return create_ast_node<FunctionNodeType>(name, move(body), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>());
+    binding_scope.set_layout(EnvironmentLayout::for_function(parameters, *body));
+    auto function = create_ast_node<FunctionNodeType>(name, move(body), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>());
+    function->set_source_position(start_line, start_column);
+    return function;
 }
 
 NonnullRefPtr<VariableDeclaration> Parser::parse_variable_declaration(bool with_semicolon)
@@ -1322,7 +1531,7 @@ NonnullRefPtr<VariableDeclaration> Parser::parse_variable_declaration(bool with_
             consume();
             init = parse_expression(2);
         }
-        declarations.append(create_ast_node<VariableDeclarator>(create_ast_node<Identifier>(move(id)), move(init)));
+        declarations.append(create_ast_node<VariableDeclarator>(create_identifier_reference(move(id)), move(init)));
         if (match(TokenType::Comma)) {
             consume();
             continue;
@@ -1490,7 +1699,9 @@ NonnullRefPtr<CatchClause> Parser::parse_catch_clause()
         consume(TokenType::ParenClose);
     }
 
-    auto body = parse_block_statement();
+    BindingScopePusher binding_scope(*this);
+    auto body = parse_block_statement(false);
+    binding_scope.set_layout(EnvironmentLayout::for_block(*body, { parameter }));
     return create_ast_node<CatchClause>(parameter, move(body));
 }
 
@@ -1521,6 +1732,8 @@ NonnullRefPtr<Statement> Parser::parse_for_statement()
 
     bool in_scope = false;
     RefPtr<ASTNode> init;
+    // A let or const in the head gets an environment of its own, see ForStatement::execute().
+    BindingScopePusher binding_scope(*this, match_variable_declaration() && !match(TokenType::Var));
     if (!match(TokenType::Semicolon)) {
         if (match_expression()) {
             init = parse_expression(0, Associativity::Right, { TokenType::In });
@@ -1534,6 +1747,11 @@ NonnullRefPtr<Statement> Parser::parse_for_statement()
             init = parse_variable_declaration(false);
             if (match_for_in_of())
                 return parse_for_in_of_statement(*init);
+            if (in_scope) {
+                NonnullRefPtrVector<VariableDeclaration> declarations;
+                declarations.append(static_cast<VariableDeclaration&>(*init));
+                binding_scope.set_layout(EnvironmentLayout::create(declarations));
+            }
         } else {
             syntax_error("Unexpected token in for loop");
         }
@@ -1790,6 +2008,7 @@ void Parser::syntax_error(const String& message, size_t line, size_t column)
 
 void Parser::save_state()
 {
+    m_parser_state.m_identifier_reference_count = m_identifier_references.size();
     m_saved_state.append(m_parser_state);
 }
 
@@ -1797,6 +2016,7 @@ void Parser::load_state()
 {
     ASSERT(!m_saved_state.is_empty());
     m_parser_state = m_saved_state.take_last();
+    m_identifier_references.shrink(m_parser_state.m_identifier_reference_count);
 }
 
 }
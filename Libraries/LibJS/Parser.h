@@ -26,10 +26,13 @@
 
 #pragma once
 
+#include <AK/HashTable.h>
 #include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
 #include <AK/StringBuilder.h>
 #include <LibJS/AST.h>
 #include <LibJS/Lexer.h>
+#include <LibJS/Runtime/EnvironmentLayout.h>
 #include <stdio.h>
 
 namespace JS {
@@ -45,11 +48,16 @@ public:
 
     NonnullRefPtr<Program> parse_program();
 
+    // Only find the end of function bodies, and parse them the first time the function is called.
+    // Syntax errors inside of them are then thrown as a SyntaxError by that call.
+    void set_lazy_function_parsing(bool enabled) { m_lazy_function_parsing = enabled; }
+
     template<typename FunctionNodeType>
     NonnullRefPtr<FunctionNodeType> parse_function_node(bool check_for_function_and_name = true, bool allow_super_property_lookup = false, bool allow_super_constructor_call = false);
 
     NonnullRefPtr<Statement> parse_statement();
-    NonnullRefPtr<BlockStatement> parse_block_statement();
+    // Function and catch bodies share the environment of their function or catch clause.
+    NonnullRefPtr<BlockStatement> parse_block_statement(bool has_own_environment = true);
     NonnullRefPtr<ReturnStatement> parse_return_statement();
     NonnullRefPtr<VariableDeclaration> parse_variable_declaration(bool with_semicolon = true);
     NonnullRefPtr<Statement> parse_for_statement();
@@ -120,6 +128,8 @@ public:
 
 private:
     friend class ScopePusher;
+    friend class BindingScopePusher;
+    friend class DeferredFunctionBody;
 
     Associativity operator_associativity(TokenType) const;
     bool match_expression() const;
@@ -139,6 +149,34 @@ private:
     void save_state();
     void load_state();
 
+    // A scope that creates an environment at runtime, or one that ends the chain of
+    // environments the parser can reason about (the program and function declarations).
+    struct BindingScope : public RefCounted<BindingScope> {
+        RefPtr<BindingScope> parent;
+        // Null if the scope doesn't create an environment.
+        RefPtr<EnvironmentLayout> layout;
+        bool is_function_declaration { false };
+        // The body of the function hasn't been parsed yet, so its layout isn't known.
+        bool has_deferred_layout { false };
+    };
+
+    // What the parser of a lazily parsed function body needs to know about the rest of the source.
+    struct SourceContext : public RefCounted<SourceContext> {
+        // A copy that outlives the source given to the lexer. Only made once the first body is skipped.
+        String source;
+        HashTable<FlyString> class_declaration_names;
+    };
+
+    struct IdentifierReference {
+        NonnullRefPtr<Identifier> identifier;
+        NonnullRefPtr<BindingScope> scope;
+    };
+
+    NonnullRefPtr<Identifier> create_identifier_reference(const FlyString&);
+    void resolve_identifier_references();
+
+    RefPtr<LazyFunctionBody> try_skip_function_body(const Vector<FunctionNode::Parameter>&);
+
     enum class UseStrictDirectiveState {
         None,
         Looking,
@@ -156,11 +194,18 @@ private:
         bool m_strict_mode { false };
         bool m_allow_super_property_lookup { false };
         bool m_allow_super_constructor_call { false };
+        RefPtr<BindingScope> m_binding_scope;
+        size_t m_identifier_reference_count { 0 };
 
         explicit ParserState(Lexer);
     };
 
     ParserState m_parser_state;
     Vector<ParserState> m_saved_state;
+
+    // Kept outside of the ParserState, so that saving the state doesn't copy them.
+    Vector<IdentifierReference> m_identifier_references;
+    NonnullRefPtr<SourceContext> m_source_context;
+    bool m_lazy_function_parsing { false };
 };
 }
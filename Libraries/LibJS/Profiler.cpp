@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/JsonArraySerializer.h>
+#include <AK/JsonObjectSerializer.h>
+#include <AK/StringBuilder.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Profiler.h>
+#include <LibJS/Runtime/ScriptFunction.h>
+#include <time.h>
+
+namespace JS {
+
+static u64 monotonic_time_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<u64>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+Profiler::Profiler(Interpreter& interpreter, u64 sample_interval_us)
+    : m_interpreter(interpreter)
+    , m_sample_interval_us(max(sample_interval_us, (u64)1))
+    , m_start_time_us(monotonic_time_us())
+{
+    m_next_sample_time_us = m_start_time_us + m_sample_interval_us;
+}
+
+u32 Profiler::frame_index(const String& name)
+{
+    if (auto index = m_frame_indices.get(name); index.has_value())
+        return index.value();
+    u32 index = m_frame_names.size();
+    m_frame_names.append(name);
+    m_frame_indices.set(name, index);
+    return index;
+}
+
+void Profiler::sample_if_due()
+{
+    m_polls_until_clock_check = polls_per_clock_check;
+    auto now = monotonic_time_us();
+    if (now < m_next_sample_time_us)
+        return;
+    m_next_sample_time_us = now + m_sample_interval_us;
+
+    Sample sample;
+    sample.timestamp_ms = (now - m_start_time_us) / 1000;
+    auto& call_stack = m_interpreter.call_stack();
+    for (ssize_t i = call_stack.size() - 1; i >= 0; --i) {
+        auto& call_frame = call_stack[i];
+        if (!call_frame.function) {
+            // Native property accessors don't have a function or a name, and aren't interesting on their own.
+            if (!call_frame.function_name.is_empty())
+                sample.frames.append(frame_index(call_frame.function_name));
+            continue;
+        }
+        auto* name = call_frame.function_name.is_empty() ? "(anonymous)" : call_frame.function_name.characters();
+        if (call_frame.function->is_script_function()) {
+            auto& function = static_cast<const ScriptFunction&>(*call_frame.function);
+            sample.frames.append(frame_index(String::format("%s (%zu:%zu)", name, function.source_line(), function.source_column())));
+        } else {
+            sample.frames.append(frame_index(String::format("%s (native)", name)));
+        }
+    }
+    m_samples.append(move(sample));
+}
+
+String Profiler::to_json(const String& script_name) const
+{
+    StringBuilder builder;
+    JsonObjectSerializer object(builder);
+    object.add("executable", script_name);
+    object.add("kind", "javascript");
+    auto events_array = object.add_array("events");
+    for (auto& sample : m_samples) {
+        auto event_object = events_array.add_object();
+        event_object.add("type", "sample");
+        event_object.add("timestamp", sample.timestamp_ms);
+        auto stack_array = event_object.add_array("stack");
+        for (auto index : sample.frames)
+            stack_array.add(m_frame_names[index]);
+        stack_array.finish();
+        event_object.finish();
+    }
+    events_array.finish();
+    object.finish();
+    return builder.to_string();
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/Noncopyable.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibJS/Forward.h>
+
+namespace JS {
+
+// Samples the JavaScript call stack while scripts run. Nothing can safely interrupt the interpreter
+// while it's in the middle of changing the call stack, so instead of using a timer signal the clock is
+// polled at safe points (function calls and statement boundaries), and the stack is recorded there
+// whenever the sample interval has passed.
+class Profiler {
+    AK_MAKE_NONCOPYABLE(Profiler);
+    AK_MAKE_NONMOVABLE(Profiler);
+
+public:
+    explicit Profiler(Interpreter&, u64 sample_interval_us = 1000);
+
+    ALWAYS_INLINE void poll()
+    {
+        if (--m_polls_until_clock_check == 0)
+            sample_if_due();
+    }
+
+    size_t sample_count() const { return m_samples.size(); }
+
+    // Serializes the samples in the same JSON format as the kernel's perfcore files, with the frames
+    // already symbolicated, so that they can be opened in the Profiler.
+    String to_json(const String& script_name) const;
+
+private:
+    struct Sample {
+        u64 timestamp_ms { 0 };
+        // Indices into m_frame_names, from the innermost frame to the outermost one.
+        Vector<u32> frames;
+    };
+
+    void sample_if_due();
+    u32 frame_index(const String&);
+
+    static constexpr u32 polls_per_clock_check = 32;
+
+    Interpreter& m_interpreter;
+    u64 m_sample_interval_us { 0 };
+    u64 m_start_time_us { 0 };
+    u64 m_next_sample_time_us { 0 };
+    u32 m_polls_until_clock_check { polls_per_clock_check };
+
+    Vector<Sample> m_samples;
+    Vector<String> m_frame_names;
+    HashMap<String, u32> m_frame_indices;
+};
+
+}
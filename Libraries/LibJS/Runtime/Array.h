@@ -43,6 +43,7 @@ public:
 
 private:
     virtual bool is_array() const override { return true; }
+    virtual bool has_write_barriers() const override { return true; }
 
     JS_DECLARE_NATIVE_GETTER(length_getter);
     JS_DECLARE_NATIVE_SETTER(length_setter);
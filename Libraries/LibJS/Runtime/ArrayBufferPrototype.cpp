@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/ArrayBuffer.h>
+#include <LibJS/Runtime/ArrayBufferPrototype.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <math.h>
+
+namespace JS {
+
+ArrayBufferPrototype::ArrayBufferPrototype(GlobalObject& global_object)
+    : Object(*global_object.object_prototype())
+{
+}
+
+void ArrayBufferPrototype::initialize(GlobalObject& global_object)
+{
+    Object::initialize(global_object);
+    u8 attr = Attribute::Writable | Attribute::Configurable;
+    define_native_function("slice", slice, 2, attr);
+
+    define_native_property("byteLength", byte_length_getter, nullptr, Attribute::Configurable);
+}
+
+ArrayBufferPrototype::~ArrayBufferPrototype()
+{
+}
+
+static ArrayBuffer* array_buffer_from(Interpreter& interpreter, GlobalObject& global_object)
+{
+    auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
+    if (!this_object)
+        return nullptr;
+    if (!this_object->is_array_buffer()) {
+        interpreter.throw_exception<TypeError>(ErrorType::NotAn, "ArrayBuffer");
+        return nullptr;
+    }
+    return static_cast<ArrayBuffer*>(this_object);
+}
+
+static size_t resolve_relative_index(Interpreter& interpreter, Value argument, size_t length, size_t default_index)
+{
+    if (argument.is_undefined())
+        return default_index;
+    auto number = argument.to_number(interpreter);
+    if (interpreter.exception() || number.is_nan())
+        return 0;
+    auto relative_index = trunc(number.as_double());
+    if (relative_index < 0)
+        return max(relative_index + length, 0.0);
+    return min(relative_index, static_cast<double>(length));
+}
+
+JS_DEFINE_NATIVE_FUNCTION(ArrayBufferPrototype::slice)
+{
+    auto* array_buffer = array_buffer_from(interpreter, global_object);
+    if (!array_buffer)
+        return {};
+    auto length = array_buffer->byte_length();
+    auto start = resolve_relative_index(interpreter, interpreter.argument(0), length, 0);
+    if (interpreter.exception())
+        return {};
+    auto end = resolve_relative_index(interpreter, interpreter.argument(1), length, length);
+    if (interpreter.exception())
+        return {};
+    auto new_length = end > start ? end - start : 0;
+    return ArrayBuffer::create(global_object, ByteBuffer::copy(array_buffer->buffer().data() + start, new_length));
+}
+
+JS_DEFINE_NATIVE_GETTER(ArrayBufferPrototype::byte_length_getter)
+{
+    auto* array_buffer = array_buffer_from(interpreter, global_object);
+    if (!array_buffer)
+        return {};
+    return Value(static_cast<unsigned>(array_buffer->byte_length()));
+}
+
+}
@@ -127,7 +127,13 @@ static void for_each_item(Interpreter& interpreter, GlobalObject& global_object,
     auto this_value = interpreter.argument(1);
 
     for (size_t i = 0; i < initial_length; ++i) {
-        auto value = this_object->get(i);
+        // The callback can do anything to the array, so this has to be checked again for every element.
+        auto* packed_storage = this_object->is_array() ? this_object->indexed_properties().packed_storage() : nullptr;
+        Value value;
+        if (packed_storage && i < packed_storage->array_like_size())
+            value = packed_storage->value_at(i);
+        else
+            value = this_object->get(i);
         if (interpreter.exception())
             return;
         if (value.is_empty()) {
@@ -178,13 +184,19 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::map)
     if (interpreter.exception())
         return {};
     auto* new_array = Array::create(global_object);
-    new_array->indexed_properties().set_array_like_size(initial_length);
     for_each_item(interpreter, global_object, "map", [&](auto index, auto, auto callback_result) {
         if (interpreter.exception())
             return IterationDecision::Break;
-        new_array->define_property(index, callback_result);
+        // Nobody else can see the new array yet, so results for consecutive indices can simply be
+        // appended, which keeps it packed.
+        if (index == new_array->indexed_properties().array_like_size())
+            new_array->indexed_properties().append(callback_result);
+        else
+            new_array->define_property(index, callback_result);
         return IterationDecision::Continue;
     });
+    if (new_array->indexed_properties().array_like_size() < initial_length)
+        new_array->indexed_properties().set_array_like_size(initial_length);
     return Value(new_array);
 }
 
@@ -235,7 +247,7 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::pop)
         return {};
     if (this_object->is_array()) {
         auto* array = static_cast<Array*>(this_object);
-        if (array->indexed_properties().is_empty())
+        if (array->indexed_properties().array_like_size() == 0)
             return js_undefined();
         return array->indexed_properties().take_last(array).value.value_or(js_undefined());
     }
@@ -407,6 +419,17 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::slice)
             end_slice = array_size;
     }
 
+    if (auto* packed_storage = array->indexed_properties().packed_storage(); packed_storage && start_slice >= 0) {
+        Vector<Value> elements;
+        if (start_slice < end_slice) {
+            elements.ensure_capacity(end_slice - start_slice);
+            for (ssize_t i = start_slice; i < end_slice; ++i)
+                elements.unchecked_append(packed_storage->value_at(i));
+        }
+        new_array->set_indexed_property_elements(move(elements));
+        return new_array;
+    }
+
     for (ssize_t i = start_slice; i < end_slice; ++i) {
         new_array->indexed_properties().append(array->get(i));
         if (interpreter.exception())
@@ -416,6 +439,43 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::slice)
     return new_array;
 }
 
+static i32 packed_index_of(Interpreter& interpreter, const SimpleIndexedPropertyStorage& storage, Value search_element, i32 from_index, i32 length)
+{
+    switch (storage.element_kind()) {
+    case SimpleIndexedPropertyStorage::ElementKind::PackedInt32: {
+        // Nothing but an integral number (including -0) can be strictly equal to an int32.
+        if (!search_element.is_integer())
+            return -1;
+        auto& elements = storage.int32_elements();
+        auto target = search_element.as_i32();
+        for (i32 i = from_index; i < length; ++i) {
+            if (elements[i] == target)
+                return i;
+        }
+        return -1;
+    }
+    case SimpleIndexedPropertyStorage::ElementKind::PackedDouble: {
+        if (!search_element.is_number())
+            return -1;
+        auto& elements = storage.double_elements();
+        auto target = search_element.as_double();
+        for (i32 i = from_index; i < length; ++i) {
+            if (elements[i] == target)
+                return i;
+        }
+        return -1;
+    }
+    default: {
+        auto& elements = storage.value_elements();
+        for (i32 i = from_index; i < length; ++i) {
+            if (strict_eq(interpreter, elements[i], search_element))
+                return i;
+        }
+        return -1;
+    }
+    }
+}
+
 JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::index_of)
 {
     auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
@@ -437,6 +497,10 @@ JS_DEFINE_NATIVE_FUNCTION(ArrayPrototype::index_of)
             from_index = max(length + from_index, 0);
     }
     auto search_element = interpreter.argument(0);
+    if (this_object->is_array()) {
+        if (auto* packed_storage = this_object->indexed_properties().packed_storage())
+            return Value(packed_index_of(interpreter, *packed_storage, search_element, from_index, min<i32>(length, packed_storage->array_like_size())));
+    }
     for (i32 i = from_index; i < length; ++i) {
         auto element = this_object->get(i);
         if (interpreter.exception())
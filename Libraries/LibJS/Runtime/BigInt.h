@@ -42,6 +42,7 @@ public:
 
 private:
     virtual const char* class_name() const override { return "BigInt"; }
+    virtual bool has_write_barriers() const override { return true; }
 
     Crypto::SignedBigInteger m_big_integer;
 };
@@ -34,6 +34,8 @@
 
 namespace JS {
 
+size_t Cell::s_heaps_marking_incrementally { 0 };
+
 void Cell::Visitor::visit(Cell* cell)
 {
     if (cell)
@@ -51,6 +53,11 @@ Heap& Cell::heap() const
     return HeapBlock::from_cell(this)->heap();
 }
 
+void Cell::remember()
+{
+    heap().remember({}, *this);
+}
+
 Interpreter& Cell::interpreter()
 {
     return heap().interpreter();
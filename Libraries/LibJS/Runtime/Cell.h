@@ -26,9 +26,11 @@
 
 #pragma once
 
+#include <AK/Badge.h>
 #include <AK/Forward.h>
 #include <AK/Noncopyable.h>
 #include <LibJS/Forward.h>
+#include <LibJS/Runtime/Value.h>
 
 namespace JS {
 
@@ -46,6 +48,41 @@ public:
     bool is_live() const { return m_live; }
     void set_live(bool b) { m_live = b; }
 
+    // Cells start out in the young generation and are promoted to the old one once they
+    // survive a collection. Young generation collections only trace young cells.
+    bool is_old() const { return m_old; }
+    void set_old(bool b) { m_old = b; }
+
+    bool is_remembered() const { return m_remembered; }
+    void set_remembered(bool b) { m_remembered = b; }
+
+    bool is_fully_constructed() const { return m_fully_constructed; }
+    void set_fully_constructed(bool b) { m_fully_constructed = b; }
+
+    // Whether every store of a cell reference into a cell of this class, once it has been
+    // constructed, is followed by a write_barrier() call. Old cells that don't promise this
+    // may point to young cells at any time, so they are scanned by every young collection.
+    virtual bool has_write_barriers() const { return false; }
+
+    // Must be called after storing a reference to another cell, so that references from old
+    // cells to young ones are known to the next young generation collection. While a heap is
+    // being marked incrementally, references to old cells are recorded as well, since those
+    // may not have been marked yet.
+    void write_barrier(Cell* cell)
+    {
+        if (m_old && !m_remembered && cell && (!cell->m_old || s_heaps_marking_incrementally))
+            remember();
+    }
+
+    void write_barrier(Value value)
+    {
+        if (value.is_cell())
+            write_barrier(value.as_cell());
+    }
+
+    static void did_start_incremental_marking(Badge<Heap>) { ++s_heaps_marking_incrementally; }
+    static void did_finish_incremental_marking(Badge<Heap>) { --s_heaps_marking_incrementally; }
+
     virtual const char* class_name() const = 0;
 
     class Visitor {
@@ -67,8 +104,15 @@ protected:
     Cell() { }
 
 private:
-    bool m_mark { false };
-    bool m_live { true };
+    void remember();
+
+    static size_t s_heaps_marking_incrementally;
+
+    bool m_mark : 1 { false };
+    bool m_live : 1 { true };
+    bool m_old : 1 { false };
+    bool m_remembered : 1 { false };
+    bool m_fully_constructed : 1 { false };
 };
 
 const LogStream& operator<<(const LogStream&, const Cell*);
@@ -52,6 +52,8 @@ void ConsoleObject::initialize(GlobalObject& global_object)
     define_native_function("count", count);
     define_native_function("countReset", count_reset);
     define_native_function("clear", clear);
+    define_native_function("profile", profile);
+    define_native_function("profileEnd", profile_end);
 }
 
 ConsoleObject::~ConsoleObject()
@@ -103,4 +105,14 @@ JS_DEFINE_NATIVE_FUNCTION(ConsoleObject::clear)
     return interpreter.console().clear();
 }
 
+JS_DEFINE_NATIVE_FUNCTION(ConsoleObject::profile)
+{
+    return interpreter.console().profile();
+}
+
+JS_DEFINE_NATIVE_FUNCTION(ConsoleObject::profile_end)
+{
+    return interpreter.console().profile_end();
+}
+
 }
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/DataView.h>
+#include <LibJS/Runtime/DataViewPrototype.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/TypedArray.h>
+#include <string.h>
+
+namespace JS {
+
+DataViewPrototype::DataViewPrototype(GlobalObject& global_object)
+    : Object(*global_object.object_prototype())
+{
+}
+
+void DataViewPrototype::initialize(GlobalObject& global_object)
+{
+    Object::initialize(global_object);
+    u8 attr = Attribute::Writable | Attribute::Configurable;
+    define_native_function("getInt8", get_int8, 1, attr);
+    define_native_function("getUint8", get_uint8, 1, attr);
+    define_native_function("getInt16", get_int16, 1, attr);
+    define_native_function("getUint16", get_uint16, 1, attr);
+    define_native_function("getInt32", get_int32, 1, attr);
+    define_native_function("getUint32", get_uint32, 1, attr);
+    define_native_function("getFloat32", get_float32, 1, attr);
+    define_native_function("getFloat64", get_float64, 1, attr);
+    define_native_function("setInt8", set_int8, 2, attr);
+    define_native_function("setUint8", set_uint8, 2, attr);
+    define_native_function("setInt16", set_int16, 2, attr);
+    define_native_function("setUint16", set_uint16, 2, attr);
+    define_native_function("setInt32", set_int32, 2, attr);
+    define_native_function("setUint32", set_uint32, 2, attr);
+    define_native_function("setFloat32", set_float32, 2, attr);
+    define_native_function("setFloat64", set_float64, 2, attr);
+
+    define_native_property("buffer", buffer_getter, nullptr, Attribute::Configurable);
+    define_native_property("byteLength", byte_length_getter, nullptr, Attribute::Configurable);
+    define_native_property("byteOffset", byte_offset_getter, nullptr, Attribute::Configurable);
+}
+
+DataViewPrototype::~DataViewPrototype()
+{
+}
+
+static DataView* data_view_from(Interpreter& interpreter, GlobalObject& global_object)
+{
+    auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
+    if (!this_object)
+        return nullptr;
+    if (!this_object->is_data_view()) {
+        interpreter.throw_exception<TypeError>(ErrorType::NotA, "DataView");
+        return nullptr;
+    }
+    return static_cast<DataView*>(this_object);
+}
+
+// Returns the address of the sizeof(T) bytes at the offset given as the first argument, or nullptr if they aren't all inside the view.
+template<typename T>
+static u8* view_bytes_for_argument(Interpreter& interpreter, DataView& data_view)
+{
+    auto offset = interpreter.argument(0).to_index(interpreter);
+    if (interpreter.exception())
+        return nullptr;
+    if (data_view.byte_length() < sizeof(T) || offset > data_view.byte_length() - sizeof(T)) {
+        interpreter.throw_exception<RangeError>(ErrorType::DataViewOutOfBounds);
+        return nullptr;
+    }
+    return data_view.bytes() + offset;
+}
+
+static void swap_bytes_unless_little_endian(u8* bytes, size_t size, bool little_endian)
+{
+    if constexpr (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) {
+        if (little_endian)
+            return;
+    } else {
+        if (!little_endian)
+            return;
+    }
+    for (size_t i = 0; i < size / 2; ++i)
+        swap(bytes[i], bytes[size - i - 1]);
+}
+
+template<typename T>
+static Value get_view_value(Interpreter& interpreter, GlobalObject& global_object)
+{
+    auto* data_view = data_view_from(interpreter, global_object);
+    if (!data_view)
+        return {};
+    auto* bytes = view_bytes_for_argument<T>(interpreter, *data_view);
+    if (!bytes)
+        return {};
+    bool little_endian = interpreter.argument(1).to_boolean();
+
+    u8 raw_value[sizeof(T)];
+    memcpy(raw_value, bytes, sizeof(T));
+    swap_bytes_unless_little_endian(raw_value, sizeof(T), little_endian);
+    T value;
+    memcpy(&value, raw_value, sizeof(T));
+    return TypedArray<T>::element_to_value(value);
+}
+
+template<typename T>
+static Value set_view_value(Interpreter& interpreter, GlobalObject& global_object)
+{
+    auto* data_view = data_view_from(interpreter, global_object);
+    if (!data_view)
+        return {};
+    auto* bytes = view_bytes_for_argument<T>(interpreter, *data_view);
+    if (!bytes)
+        return {};
+    auto number = interpreter.argument(1).to_number(interpreter);
+    if (interpreter.exception())
+        return {};
+    bool little_endian = interpreter.argument(2).to_boolean();
+
+    auto value = TypedArray<T>::number_to_element(number.as_double());
+    u8 raw_value[sizeof(T)];
+    memcpy(raw_value, &value, sizeof(T));
+    swap_bytes_unless_little_endian(raw_value, sizeof(T), little_endian);
+    memcpy(bytes, raw_value, sizeof(T));
+    return js_undefined();
+}
+
+#define __DEFINE_DATA_VIEW_ACCESSORS(name, Type)                  \
+    JS_DEFINE_NATIVE_FUNCTION(DataViewPrototype::get_##name)      \
+    {                                                             \
+        return get_view_value<Type>(interpreter, global_object);  \
+    }                                                             \
+    JS_DEFINE_NATIVE_FUNCTION(DataViewPrototype::set_##name)      \
+    {                                                             \
+        return set_view_value<Type>(interpreter, global_object);  \
+    }
+__DEFINE_DATA_VIEW_ACCESSORS(int8, i8)
+__DEFINE_DATA_VIEW_ACCESSORS(uint8, u8)
+__DEFINE_DATA_VIEW_ACCESSORS(int16, i16)
+__DEFINE_DATA_VIEW_ACCESSORS(uint16, u16)
+__DEFINE_DATA_VIEW_ACCESSORS(int32, i32)
+__DEFINE_DATA_VIEW_ACCESSORS(uint32, u32)
+__DEFINE_DATA_VIEW_ACCESSORS(float32, float)
+__DEFINE_DATA_VIEW_ACCESSORS(float64, double)
+#undef __DEFINE_DATA_VIEW_ACCESSORS
+
+JS_DEFINE_NATIVE_GETTER(DataViewPrototype::buffer_getter)
+{
+    auto* data_view = data_view_from(interpreter, global_object);
+    if (!data_view)
+        return {};
+    return &data_view->viewed_array_buffer();
+}
+
+JS_DEFINE_NATIVE_GETTER(DataViewPrototype::byte_length_getter)
+{
+    auto* data_view = data_view_from(interpreter, global_object);
+    if (!data_view)
+        return {};
+    return Value(data_view->byte_length());
+}
+
+JS_DEFINE_NATIVE_GETTER(DataViewPrototype::byte_offset_getter)
+{
+    auto* data_view = data_view_from(interpreter, global_object);
+    if (!data_view)
+        return {};
+    return Value(data_view->byte_offset());
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/Runtime/EnvironmentLayout.h>
+
+namespace JS {
+
+void EnvironmentLayout::add(const FlyString& name, DeclarationKind declaration_kind)
+{
+    // A name that's bound twice keeps its first slot, but like HashMap::set() the last declaration wins.
+    if (auto slot = slot_of(name); slot.has_value()) {
+        m_declaration_kinds[slot.value()] = declaration_kind;
+        return;
+    }
+    m_slots.set(name, m_names.size());
+    m_names.append(name);
+    m_declaration_kinds.append(declaration_kind);
+}
+
+NonnullRefPtr<EnvironmentLayout> EnvironmentLayout::create(const NonnullRefPtrVector<VariableDeclaration>& declarations, const Vector<FlyString>& extra_names)
+{
+    auto layout = adopt(*new EnvironmentLayout);
+    for (auto& declaration : declarations) {
+        for (auto& declarator : declaration.declarations())
+            layout->add(declarator.id().string(), declaration.declaration_kind());
+    }
+    for (auto& name : extra_names)
+        layout->add(name, DeclarationKind::Var);
+    return layout;
+}
+
+NonnullRefPtr<EnvironmentLayout> EnvironmentLayout::for_function(const Vector<FunctionNode::Parameter>& parameters, const Statement& body)
+{
+    if (body.is_scope_node()) {
+        if (auto* layout = static_cast<const ScopeNode&>(body).environment_layout())
+            return *layout;
+    }
+
+    auto layout = adopt(*new EnvironmentLayout);
+    for (auto& parameter : parameters)
+        layout->add(parameter.name, DeclarationKind::Var);
+    if (body.is_scope_node()) {
+        // Everything in a function's environment is treated as a var, including the body's lets and consts.
+        for (auto& declaration : static_cast<const ScopeNode&>(body).variables()) {
+            for (auto& declarator : declaration.declarations())
+                layout->add(declarator.id().string(), DeclarationKind::Var);
+        }
+        static_cast<const ScopeNode&>(body).set_environment_layout(layout);
+    }
+    return layout;
+}
+
+NonnullRefPtr<EnvironmentLayout> EnvironmentLayout::for_block(const ScopeNode& block, const Vector<FlyString>& extra_names)
+{
+    if (auto* layout = block.environment_layout())
+        return *layout;
+    auto layout = create(block.variables(), extra_names);
+    block.set_environment_layout(layout);
+    return layout;
+}
+
+}
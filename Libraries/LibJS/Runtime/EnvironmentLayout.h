@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/FlyString.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/Vector.h>
+#include <LibJS/AST.h>
+
+namespace JS {
+
+// The names a LexicalEnvironment binds, and the slot each of them is stored in.
+// All environments created for the same scope share a layout, which is what lets
+// the parser resolve identifiers to slots ahead of time.
+class EnvironmentLayout : public RefCounted<EnvironmentLayout> {
+public:
+    static NonnullRefPtr<EnvironmentLayout> create(const NonnullRefPtrVector<VariableDeclaration>&, const Vector<FlyString>& extra_names = {});
+
+    // The environment a function call creates: the parameters, then everything declared in the body.
+    static NonnullRefPtr<EnvironmentLayout> for_function(const Vector<FunctionNode::Parameter>&, const Statement& body);
+
+    // The environment entering a block creates: its declarations, then the extra names (the
+    // parameter of a catch clause). Blocks without any bindings don't create an environment.
+    static NonnullRefPtr<EnvironmentLayout> for_block(const ScopeNode&, const Vector<FlyString>& extra_names = {});
+
+    bool is_empty() const { return m_names.is_empty(); }
+    size_t size() const { return m_names.size(); }
+
+    Optional<size_t> slot_of(const FlyString& name) const
+    {
+        auto it = m_slots.find(name);
+        if (it == m_slots.end())
+            return {};
+        return (*it).value;
+    }
+
+    const FlyString& name_at(size_t slot) const { return m_names[slot]; }
+    DeclarationKind declaration_kind_at(size_t slot) const { return m_declaration_kinds[slot]; }
+
+private:
+    EnvironmentLayout() { }
+
+    void add(const FlyString& name, DeclarationKind);
+
+    Vector<FlyString> m_names;
+    Vector<DeclarationKind> m_declaration_kinds;
+    HashMap<FlyString, size_t> m_slots;
+};
+
+}
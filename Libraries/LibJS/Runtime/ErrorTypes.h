@@ -37,13 +37,16 @@
     M(BigIntIntArgument, "BigInt argument must be an integer")                                         \
     M(BigIntInvalidValue, "Invalid value for BigInt: %s")                                              \
     M(ClassDoesNotExtendAConstructorOrNull, "Class extends value %s is not a constructor or null")     \
+    M(ConstructorWithoutNew, "%s constructor must be called with 'new'")                               \
     M(Convert, "Cannot convert %s to %s")                                                              \
     M(ConvertUndefinedToObject, "Cannot convert undefined to object")                                  \
+    M(DataViewOutOfBounds, "Offset is outside the bounds of the DataView")                             \
     M(DescChangeNonConfigurable, "Cannot change attributes of non-configurable property '%s'")         \
     M(FunctionArgsNotObject, "Argument array must be an object")                                       \
     M(InOperatorWithObject, "'in' operator must be used on an object")                                 \
     M(InstanceOfOperatorBadPrototype, "'prototype' property of %s is not an object")                   \
     M(InvalidAssignToConst, "Invalid assignment to const variable")                                    \
+    M(InvalidIndex, "Index must be a non-negative integer")                                            \
     M(InvalidLeftHandAssignment, "Invalid left-hand side in assignment")                               \
     M(InvalidRadix, "Radix must be an integer no less than 2, and no greater than 36")                 \
     M(IsNotA, "%s is not a %s")                                                                        \
@@ -145,11 +148,17 @@
     M(ReflectBadArgumentsList, "Arguments list must be an object")                                     \
     M(ReflectBadNewTarget, "Optional third argument of Reflect.construct() must be a constructor")     \
     M(ReflectBadDescriptorArgument, "Descriptor argument is not an object")                            \
+    M(RegExpInvalidFlags, "Invalid regular expression flags '%s'")                                     \
+    M(RegExpInvalidPattern, "Invalid regular expression /%s/: %s")                                     \
     M(StringRawCannotConvert, "Cannot convert property 'raw' to object from %s")                       \
     M(StringRepeatCountMustBe, "repeat count must be a %s number")                                     \
     M(ThisHasNotBeenInitialized, "|this| has not been initialized")                                    \
     M(ThisIsAlreadyInitialized, "|this| is already initialized")                                       \
     M(ToObjectNullOrUndef, "ToObject on null or undefined")                                            \
+    M(TypedArrayInvalidBufferLength, "Length of the buffer of %s must be a multiple of %d")            \
+    M(TypedArrayInvalidLength, "Invalid typed array length")                                           \
+    M(TypedArrayMisalignedOffset, "Start offset of %s must be a multiple of %d")                       \
+    M(TypedArrayOutOfBounds, "Offset or length is outside the bounds of the buffer")                   \
     M(UnknownIdentifier, "'%s' is not defined")                                                        \
     /* LibWeb bindings */                                                                              \
     M(NotAByteString, "Argument to %s() must be a byte string")                                        \
@@ -49,6 +49,15 @@ public:
     JS_ENUMERATE_BUILTIN_TYPES
 #undef __JS_ENUMERATE
 
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, Type)     \
+    ConstructorName* snake_name##_constructor() { return m_##snake_name##_constructor; } \
+    Object* snake_name##_prototype() { return m_##snake_name##_prototype; }
+    JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+    // The %TypedArray%.prototype object that the prototypes of all typed arrays inherit from.
+    Object* typed_array_prototype() { return m_typed_array_prototype; }
+
 #define __JS_ENUMERATE(ClassName, snake_name) \
     Object* snake_name##_prototype() { return m_##snake_name##_prototype; }
     JS_ENUMERATE_ITERATOR_PROTOTYPES
@@ -74,6 +83,14 @@ private:
     JS_ENUMERATE_BUILTIN_TYPES
 #undef __JS_ENUMERATE
 
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, Type) \
+    ConstructorName* m_##snake_name##_constructor { nullptr };                      \
+    Object* m_##snake_name##_prototype { nullptr };
+    JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+    Object* m_typed_array_prototype { nullptr };
+
 #define __JS_ENUMERATE(ClassName, snake_name) \
     Object* m_##snake_name##_prototype { nullptr };
     JS_ENUMERATE_ITERATOR_PROTOTYPES
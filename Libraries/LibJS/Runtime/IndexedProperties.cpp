@@ -29,22 +29,81 @@
 
 namespace JS {
 
+using ElementKind = SimpleIndexedPropertyStorage::ElementKind;
+
+static ElementKind element_kind_for(Value value)
+{
+    if (value.is_empty())
+        return ElementKind::HoleyValues;
+    // -0 has to stay a double, or it would read back as 0.
+    if (value.is_integer() && !value.is_negative_zero())
+        return ElementKind::PackedInt32;
+    if (value.is_number())
+        return ElementKind::PackedDouble;
+    return ElementKind::PackedValues;
+}
+
 SimpleIndexedPropertyStorage::SimpleIndexedPropertyStorage(Vector<Value>&& initial_values)
-    : m_array_size(initial_values.size())
+    : m_kind(ElementKind::PackedValues)
+    , m_array_size(initial_values.size())
     , m_packed_elements(move(initial_values))
 {
+    auto kind = ElementKind::PackedInt32;
+    for (auto& value : m_packed_elements)
+        kind = max(kind, element_kind_for(value));
+
+    if (kind == ElementKind::HoleyValues) {
+        m_kind = kind;
+        return;
+    }
+    if (kind == ElementKind::PackedValues)
+        return;
+
+    m_kind = kind;
+    if (kind == ElementKind::PackedInt32) {
+        m_int32_elements.ensure_capacity(m_array_size);
+        for (auto& value : m_packed_elements)
+            m_int32_elements.unchecked_append(value.as_i32());
+    } else {
+        m_double_elements.ensure_capacity(m_array_size);
+        for (auto& value : m_packed_elements)
+            m_double_elements.unchecked_append(value.as_double());
+    }
+    m_packed_elements.clear();
+}
+
+void SimpleIndexedPropertyStorage::transition_to(ElementKind new_kind)
+{
+    ASSERT(new_kind > m_kind);
+
+    if (new_kind == ElementKind::PackedDouble) {
+        m_double_elements.ensure_capacity(m_array_size);
+        for (auto value : m_int32_elements)
+            m_double_elements.unchecked_append(value);
+        m_int32_elements.clear();
+    } else if (is_unboxed()) {
+        m_packed_elements.ensure_capacity(m_array_size);
+        for (size_t i = 0; i < m_array_size; ++i)
+            m_packed_elements.unchecked_append(value_at(i));
+        m_int32_elements.clear();
+        m_double_elements.clear();
+    }
+
+    m_kind = new_kind;
 }
 
 bool SimpleIndexedPropertyStorage::has_index(u32 index) const
 {
-    return index < m_array_size && !m_packed_elements[index].is_empty();
+    if (index >= m_array_size)
+        return false;
+    return is_packed() || !m_packed_elements[index].is_empty();
 }
 
 Optional<ValueAndAttributes> SimpleIndexedPropertyStorage::get(u32 index) const
 {
     if (index >= m_array_size)
         return {};
-    return ValueAndAttributes { m_packed_elements[index], default_attributes };
+    return ValueAndAttributes { value_at(index), default_attributes };
 }
 
 void SimpleIndexedPropertyStorage::put(u32 index, Value value, PropertyAttributes attributes)
@@ -52,54 +111,137 @@ void SimpleIndexedPropertyStorage::put(u32 index, Value value, PropertyAttribute
     ASSERT(attributes == default_attributes);
     ASSERT(index < SPARSE_ARRAY_THRESHOLD);
 
-    if (index >= m_array_size) {
-        m_array_size = index + 1;
-        if (index >= m_packed_elements.size())
+    auto kind = index > m_array_size ? ElementKind::HoleyValues : element_kind_for(value);
+    if (kind > m_kind)
+        transition_to(kind);
+
+    switch (m_kind) {
+    case ElementKind::PackedInt32:
+        if (index == m_array_size)
+            m_int32_elements.append(value.as_i32());
+        else
+            m_int32_elements[index] = value.as_i32();
+        break;
+    case ElementKind::PackedDouble:
+        if (index == m_array_size)
+            m_double_elements.append(value.as_double());
+        else
+            m_double_elements[index] = value.as_double();
+        break;
+    default:
+        if (index >= m_array_size && index >= m_packed_elements.size())
             m_packed_elements.resize(index + MIN_PACKED_RESIZE_AMOUNT >= SPARSE_ARRAY_THRESHOLD ? SPARSE_ARRAY_THRESHOLD : index + MIN_PACKED_RESIZE_AMOUNT);
+        m_packed_elements[index] = value;
+        break;
     }
-    m_packed_elements[index] = value;
+
+    if (index >= m_array_size)
+        m_array_size = index + 1;
 }
 
 void SimpleIndexedPropertyStorage::remove(u32 index)
 {
-    if (index < m_array_size)
-        m_packed_elements[index] = {};
+    if (index >= m_array_size)
+        return;
+    if (m_kind != ElementKind::HoleyValues)
+        transition_to(ElementKind::HoleyValues);
+    m_packed_elements[index] = {};
 }
 
 void SimpleIndexedPropertyStorage::insert(u32 index, Value value, PropertyAttributes attributes)
 {
     ASSERT(attributes == default_attributes);
     ASSERT(index < SPARSE_ARRAY_THRESHOLD);
+    if (index >= m_array_size) {
+        put(index, value, attributes);
+        return;
+    }
+
     m_array_size++;
     ASSERT(m_array_size <= SPARSE_ARRAY_THRESHOLD);
-    m_packed_elements.insert(index, value);
+
+    auto kind = element_kind_for(value);
+    if (kind > m_kind)
+        transition_to(kind);
+
+    switch (m_kind) {
+    case ElementKind::PackedInt32:
+        m_int32_elements.insert(index, value.as_i32());
+        break;
+    case ElementKind::PackedDouble:
+        m_double_elements.insert(index, value.as_double());
+        break;
+    default:
+        m_packed_elements.insert(index, value);
+        break;
+    }
 }
 
 ValueAndAttributes SimpleIndexedPropertyStorage::take_first()
 {
     m_array_size--;
-    return { m_packed_elements.take_first(), default_attributes };
+    switch (m_kind) {
+    case ElementKind::PackedInt32:
+        return { Value(m_int32_elements.take_first()), default_attributes };
+    case ElementKind::PackedDouble:
+        return { Value(m_double_elements.take_first()), default_attributes };
+    default:
+        return { m_packed_elements.take_first(), default_attributes };
+    }
 }
 
 ValueAndAttributes SimpleIndexedPropertyStorage::take_last()
 {
     m_array_size--;
-    auto last_element = m_packed_elements[m_array_size];
-    m_packed_elements[m_array_size] = {};
-    return { last_element, default_attributes };
+    switch (m_kind) {
+    case ElementKind::PackedInt32:
+        return { Value(m_int32_elements.take_last()), default_attributes };
+    case ElementKind::PackedDouble:
+        return { Value(m_double_elements.take_last()), default_attributes };
+    default: {
+        auto last_element = m_packed_elements[m_array_size];
+        m_packed_elements[m_array_size] = {};
+        return { last_element, default_attributes };
+    }
+    }
 }
 
 void SimpleIndexedPropertyStorage::set_array_like_size(size_t new_size)
 {
     ASSERT(new_size <= SPARSE_ARRAY_THRESHOLD);
+    if (new_size > m_array_size && m_kind != ElementKind::HoleyValues)
+        transition_to(ElementKind::HoleyValues);
+
     m_array_size = new_size;
-    m_packed_elements.resize(new_size);
+    switch (m_kind) {
+    case ElementKind::PackedInt32:
+        m_int32_elements.resize(new_size);
+        break;
+    case ElementKind::PackedDouble:
+        m_double_elements.resize(new_size);
+        break;
+    default:
+        m_packed_elements.resize(new_size);
+        break;
+    }
+}
+
+Vector<Value> SimpleIndexedPropertyStorage::elements() const
+{
+    if (!is_unboxed())
+        return m_packed_elements;
+
+    Vector<Value> elements;
+    elements.ensure_capacity(m_array_size);
+    for (size_t i = 0; i < m_array_size; ++i)
+        elements.unchecked_append(value_at(i));
+    return elements;
 }
 
 GenericIndexedPropertyStorage::GenericIndexedPropertyStorage(SimpleIndexedPropertyStorage&& storage)
 {
     m_array_size = storage.array_like_size();
-    for (auto& element : move(storage.m_packed_elements))
+    for (auto& element : storage.elements())
         m_packed_elements.append({ element, default_attributes });
 }
 
@@ -208,6 +350,7 @@ ValueAndAttributes GenericIndexedPropertyStorage::take_last()
 
 void GenericIndexedPropertyStorage::set_array_like_size(size_t new_size)
 {
+    m_array_size = new_size;
     if (new_size < SPARSE_ARRAY_THRESHOLD) {
         m_packed_elements.resize(new_size);
         m_sparse_elements.clear();
@@ -287,6 +430,7 @@ void IndexedProperties::put(Object* this_object, u32 index, Value value, Propert
         switch_to_generic_storage();
     if (m_storage->is_simple_storage() || !evaluate_accessors) {
         m_storage->put(index, value, attributes);
+        m_owner->write_barrier(value);
         return;
     }
 
@@ -296,6 +440,7 @@ void IndexedProperties::put(Object* this_object, u32 index, Value value, Propert
         value_here.value().value.as_accessor().call_setter(this_object, value);
     } else {
         m_storage->put(index, value, attributes);
+        m_owner->write_barrier(value);
     }
 }
 
@@ -315,6 +460,7 @@ void IndexedProperties::insert(u32 index, Value value, PropertyAttributes attrib
     if (m_storage->is_simple_storage() && (index >= SPARSE_ARRAY_THRESHOLD || attributes != default_attributes || array_like_size() == SPARSE_ARRAY_THRESHOLD))
         switch_to_generic_storage();
     m_storage->insert(index, value, attributes);
+    m_owner->write_barrier(value);
 }
 
 ValueAndAttributes IndexedProperties::take_first(Object *this_object)
@@ -343,9 +489,17 @@ void IndexedProperties::append_all(Object* this_object, const IndexedProperties&
         if (this_object && this_object->interpreter().exception())
             return;
         m_storage->put(m_storage->array_like_size(), element.value, element.attributes);
+        m_owner->write_barrier(element.value);
     }
 }
 
+void IndexedProperties::set_array_like_size(size_t new_size)
+{
+    if (m_storage->is_simple_storage() && new_size > SPARSE_ARRAY_THRESHOLD)
+        switch_to_generic_storage();
+    m_storage->set_array_like_size(new_size);
+}
+
 Vector<ValueAndAttributes> IndexedProperties::values_unordered() const
 {
     if (m_storage->is_simple_storage()) {
@@ -364,6 +518,16 @@ Vector<ValueAndAttributes> IndexedProperties::values_unordered() const
     return values;
 }
 
+const SimpleIndexedPropertyStorage* IndexedProperties::packed_storage() const
+{
+    if (!m_storage->is_simple_storage())
+        return nullptr;
+    auto& storage = static_cast<const SimpleIndexedPropertyStorage&>(*m_storage);
+    if (!storage.is_packed())
+        return nullptr;
+    return &storage;
+}
+
 void IndexedProperties::switch_to_generic_storage()
 {
     auto storage = static_cast<const SimpleIndexedPropertyStorage&>(*m_storage);
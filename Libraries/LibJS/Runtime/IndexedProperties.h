@@ -66,6 +66,16 @@ public:
 
 class SimpleIndexedPropertyStorage final : public IndexedPropertyStorage {
 public:
+    // Elements are kept unboxed for as long as they are all int32s or all numbers, and only become
+    // Values once something else is stored. Kinds only ever move down this list, and every kind but
+    // HoleyValues has an element at each index below the array-like size.
+    enum class ElementKind : u8 {
+        PackedInt32,
+        PackedDouble,
+        PackedValues,
+        HoleyValues,
+    };
+
     SimpleIndexedPropertyStorage() = default;
     explicit SimpleIndexedPropertyStorage(Vector<Value>&& initial_values);
 
@@ -78,17 +88,40 @@ public:
     virtual ValueAndAttributes take_first() override;
     virtual ValueAndAttributes take_last() override;
 
-    virtual size_t size() const override { return m_packed_elements.size(); }
+    virtual size_t size() const override { return is_unboxed() ? m_array_size : m_packed_elements.size(); }
     virtual size_t array_like_size() const override { return m_array_size; }
     virtual void set_array_like_size(size_t new_size) override;
 
     virtual bool is_simple_storage() const override { return true; }
-    Vector<Value> elements() const { return m_packed_elements; }
+    Vector<Value> elements() const;
+
+    ElementKind element_kind() const { return m_kind; }
+    bool is_packed() const { return m_kind != ElementKind::HoleyValues; }
+    bool is_unboxed() const { return m_kind == ElementKind::PackedInt32 || m_kind == ElementKind::PackedDouble; }
+
+    const Vector<i32>& int32_elements() const { return m_int32_elements; }
+    const Vector<double>& double_elements() const { return m_double_elements; }
+    const Vector<Value>& value_elements() const { return m_packed_elements; }
+
+    Value value_at(size_t index) const
+    {
+        switch (m_kind) {
+        case ElementKind::PackedInt32:
+            return Value(m_int32_elements[index]);
+        case ElementKind::PackedDouble:
+            return Value(m_double_elements[index]);
+        default:
+            return m_packed_elements[index];
+        }
+    }
 
 private:
-    friend GenericIndexedPropertyStorage;
+    void transition_to(ElementKind);
 
+    ElementKind m_kind { ElementKind::PackedInt32 };
     size_t m_array_size { 0 };
+    Vector<i32> m_int32_elements;
+    Vector<double> m_double_elements;
     Vector<Value> m_packed_elements;
 };
 
@@ -137,11 +170,18 @@ private:
 
 class IndexedProperties {
 public:
-    IndexedProperties() = default;
+    // The owner is told about every value stored, for the sake of its write barriers.
+    explicit IndexedProperties(Cell& owner)
+        : m_owner(&owner)
+    {
+    }
 
-    IndexedProperties(Vector<Value>&& values)
-        : m_storage(make<SimpleIndexedPropertyStorage>(move(values)))
+    IndexedProperties(Cell& owner, Vector<Value>&& values)
+        : m_owner(&owner)
     {
+        for (auto& value : values)
+            owner.write_barrier(value);
+        m_storage = make<SimpleIndexedPropertyStorage>(move(values));
     }
 
     bool has_index(u32 index) const { return m_storage->has_index(index); }
@@ -162,13 +202,18 @@ public:
     size_t size() const { return m_storage->size(); }
     bool is_empty() const { return size() == 0; }
     size_t array_like_size() const { return m_storage->array_like_size(); }
-    void set_array_like_size(size_t new_size) { m_storage->set_array_like_size(new_size); };
+    void set_array_like_size(size_t new_size);
 
     Vector<ValueAndAttributes> values_unordered() const;
 
+    // The storage if it's simple and has no holes, for fast paths that want to read the elements
+    // directly. Anything that may run user code can change the storage, so don't hold on to it.
+    const SimpleIndexedPropertyStorage* packed_storage() const;
+
 private:
     void switch_to_generic_storage();
 
+    Cell* m_owner { nullptr };
     NonnullOwnPtr<IndexedPropertyStorage> m_storage { make<SimpleIndexedPropertyStorage>() };
 };
 
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace JS {
+
+// An InlineCache belongs to a single property access site in the AST and remembers
+// where the property was found the last few times it ran, keyed on the shape ids of
+// the objects the lookup walked through. A shape never changes while keeping its id
+// (unique shapes get a fresh one whenever they are modified in place), so a matching
+// entry means the property is still at the same offset and nothing in front of it
+// on the prototype chain has changed.
+struct InlineCache {
+    static constexpr size_t max_entries = 4;
+    static constexpr size_t max_prototype_depth = 4;
+
+    struct Entry {
+        // Shape ids of the receiver and the prototypes up to and including `depth`.
+        u64 shape_ids[max_prototype_depth + 1] { 0 };
+        u8 depth { 0 };
+        u32 offset { 0 };
+    };
+
+    void add(const Entry& entry)
+    {
+        if (entry_count < max_entries) {
+            entries[entry_count++] = entry;
+            return;
+        }
+        entries[next_victim] = entry;
+        next_victim = (next_victim + 1) % max_entries;
+    }
+
+    Entry entries[max_entries];
+    u8 entry_count { 0 };
+    u8 next_victim { 0 };
+};
+
+}
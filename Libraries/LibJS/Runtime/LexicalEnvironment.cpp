@@ -25,6 +25,7 @@
  */
 
 #include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/EnvironmentLayout.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/Function.h>
 #include <LibJS/Runtime/LexicalEnvironment.h>
@@ -41,17 +42,19 @@ LexicalEnvironment::LexicalEnvironment(EnvironmentRecordType environment_record_
 {
 }
 
-LexicalEnvironment::LexicalEnvironment(HashMap<FlyString, Variable> variables, LexicalEnvironment* parent)
-    : m_parent(parent)
-    , m_variables(move(variables))
+LexicalEnvironment::LexicalEnvironment(NonnullRefPtr<EnvironmentLayout> layout, LexicalEnvironment* parent)
+    : LexicalEnvironment(move(layout), parent, EnvironmentRecordType::Declarative)
 {
 }
 
-LexicalEnvironment::LexicalEnvironment(HashMap<FlyString, Variable> variables, LexicalEnvironment* parent, EnvironmentRecordType environment_record_type)
+LexicalEnvironment::LexicalEnvironment(NonnullRefPtr<EnvironmentLayout> layout, LexicalEnvironment* parent, EnvironmentRecordType environment_record_type)
     : m_parent(parent)
-    , m_variables(move(variables))
+    , m_layout(move(layout))
     , m_environment_record_type(environment_record_type)
 {
+    m_slots.resize(m_layout->size());
+    for (auto& value : m_slots)
+        value = js_undefined();
 }
 
 LexicalEnvironment::~LexicalEnvironment()
@@ -66,18 +69,43 @@ void LexicalEnvironment::visit_children(Visitor& visitor)
     visitor.visit(m_home_object);
     visitor.visit(m_new_target);
     visitor.visit(m_current_function);
-    for (auto& it : m_variables)
+    for (auto& value : m_slots)
+        visitor.visit(value);
+    for (auto& it : m_dynamic_variables)
         visitor.visit(it.value.value);
 }
 
 Optional<Variable> LexicalEnvironment::get(const FlyString& name) const
 {
-    return m_variables.get(name);
+    if (m_layout) {
+        if (auto slot = m_layout->slot_of(name); slot.has_value())
+            return Variable { m_slots[slot.value()], m_layout->declaration_kind_at(slot.value()) };
+    }
+    return m_dynamic_variables.get(name);
 }
 
 void LexicalEnvironment::set(const FlyString& name, Variable variable)
 {
-    m_variables.set(name, variable);
+    if (m_layout) {
+        if (auto slot = m_layout->slot_of(name); slot.has_value()) {
+            m_slots[slot.value()] = variable.value;
+            write_barrier(variable.value);
+            return;
+        }
+    }
+    m_dynamic_variables.set(name, variable);
+    write_barrier(variable.value);
+}
+
+DeclarationKind LexicalEnvironment::slot_declaration_kind(size_t slot) const
+{
+    return m_layout->declaration_kind_at(slot);
+}
+
+void LexicalEnvironment::set_current_function(Function& function)
+{
+    m_current_function = &function;
+    write_barrier(&function);
 }
 
 bool LexicalEnvironment::has_super_binding() const
@@ -126,6 +154,7 @@ void LexicalEnvironment::bind_this_value(Value this_value)
         return;
     }
     m_this_value = this_value;
+    write_barrier(this_value);
     m_this_binding_status = ThisBindingStatus::Initialized;
 }
 
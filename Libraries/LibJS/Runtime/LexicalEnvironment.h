@@ -28,6 +28,8 @@
 
 #include <AK/FlyString.h>
 #include <AK/HashMap.h>
+#include <AK/RefPtr.h>
+#include <AK/Vector.h>
 #include <LibJS/Runtime/Cell.h>
 #include <LibJS/Runtime/Value.h>
 
@@ -56,8 +58,8 @@ public:
 
     LexicalEnvironment();
     LexicalEnvironment(EnvironmentRecordType);
-    LexicalEnvironment(HashMap<FlyString, Variable> variables, LexicalEnvironment* parent);
-    LexicalEnvironment(HashMap<FlyString, Variable> variables, LexicalEnvironment* parent, EnvironmentRecordType);
+    LexicalEnvironment(NonnullRefPtr<EnvironmentLayout>, LexicalEnvironment* parent);
+    LexicalEnvironment(NonnullRefPtr<EnvironmentLayout>, LexicalEnvironment* parent, EnvironmentRecordType);
     virtual ~LexicalEnvironment() override;
 
     LexicalEnvironment* parent() const { return m_parent; }
@@ -65,11 +67,22 @@ public:
     Optional<Variable> get(const FlyString&) const;
     void set(const FlyString&, Variable);
 
-    void clear();
+    // Direct access to the bindings of the layout, by slot.
+    Value get_slot(size_t slot) const { return m_slots[slot]; }
+    void set_slot(size_t slot, Value value)
+    {
+        m_slots[slot] = value;
+        write_barrier(value);
+    }
+    DeclarationKind slot_declaration_kind(size_t slot) const;
 
-    const HashMap<FlyString, Variable>& variables() const { return m_variables; }
+    void clear();
 
-    void set_home_object(Value object) { m_home_object = object; }
+    void set_home_object(Value object)
+    {
+        m_home_object = object;
+        write_barrier(object);
+    }
     bool has_super_binding() const;
     Value get_super_base();
 
@@ -79,20 +92,33 @@ public:
     void bind_this_value(Value this_value);
 
     // Not a standard operation.
-    void replace_this_binding(Value this_value) { m_this_value = this_value; }
+    void replace_this_binding(Value this_value)
+    {
+        m_this_value = this_value;
+        write_barrier(this_value);
+    }
 
     Value new_target() const { return m_new_target; };
-    void set_new_target(Value new_target) { m_new_target = new_target; }
+    void set_new_target(Value new_target)
+    {
+        m_new_target = new_target;
+        write_barrier(new_target);
+    }
 
     Function* current_function() const { return m_current_function; }
-    void set_current_function(Function& function) { m_current_function = &function; }
+    void set_current_function(Function&);
 
 private:
     virtual const char* class_name() const override { return "LexicalEnvironment"; }
+    virtual bool has_write_barriers() const override { return true; }
     virtual void visit_children(Visitor&) override;
 
     LexicalEnvironment* m_parent { nullptr };
-    HashMap<FlyString, Variable> m_variables;
+    RefPtr<EnvironmentLayout> m_layout;
+    Vector<Value> m_slots;
+    // Bindings that aren't part of the layout, like those of class declarations, which are
+    // added to whatever environment is current when they run.
+    HashMap<FlyString, Variable> m_dynamic_variables;
     EnvironmentRecordType m_environment_record_type = EnvironmentRecordType::Declarative;
     ThisBindingStatus m_this_binding_status = ThisBindingStatus::Uninitialized;
     Value m_home_object;
@@ -31,6 +31,7 @@
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/InlineCache.h>
 #include <LibJS/Runtime/NativeFunction.h>
 #include <LibJS/Runtime/NativeProperty.h>
 #include <LibJS/Runtime/Object.h>
@@ -134,6 +135,7 @@ bool Object::set_prototype(Object* new_prototype)
         return true;
     }
     m_shape = m_shape->create_prototype_transition(new_prototype);
+    write_barrier(m_shape);
     return true;
 }
 
@@ -334,6 +336,7 @@ void Object::set_shape(Shape& new_shape)
 {
     m_storage.resize(new_shape.property_count());
     m_shape = &new_shape;
+    write_barrier(m_shape);
 }
 
 bool Object::define_property(const StringOrSymbol& property_name, const Object& descriptor, bool throw_exceptions)
@@ -531,6 +534,7 @@ bool Object::put_own_property(Object& this_object, const StringOrSymbol& propert
         call_native_property_setter(const_cast<Object*>(&this_object), value_here, value);
     } else {
         m_storage[metadata.value().offset] = value;
+        write_barrier(value);
     }
     return true;
 }
@@ -619,6 +623,7 @@ void Object::ensure_shape_is_unique()
         return;
 
     m_shape = m_shape->create_unique_clone();
+    write_barrier(m_shape);
 }
 
 Value Object::get_by_index(u32 property_index) const
@@ -742,6 +747,108 @@ bool Object::put(const PropertyName& property_name, Value value, Value receiver)
     return put_own_property(*this, string_or_symbol, value, default_attributes, PutOwnPropertyMode::Put);
 }
 
+static bool is_cacheable_property_name(const StringOrSymbol& property_name)
+{
+    // Names that look like array indices are looked up in the indexed storage instead.
+    return !property_name.is_string() || property_name.as_string().to_int().value_or(-1) < 0;
+}
+
+const Object* Object::match_inline_cache_entry(const InlineCache& cache, size_t entry_index) const
+{
+    auto& entry = cache.entries[entry_index];
+    const Object* object = this;
+    for (size_t depth = 0;; ++depth) {
+        if (object->shape().id() != entry.shape_ids[depth])
+            return nullptr;
+        if (depth == entry.depth)
+            return object;
+        object = object->shape().prototype();
+        if (!object)
+            return nullptr;
+    }
+}
+
+Value Object::get_cached(const StringOrSymbol& property_name, InlineCache& cache) const
+{
+    for (size_t i = 0; i < cache.entry_count; ++i) {
+        auto* holder = match_inline_cache_entry(cache, i);
+        if (!holder)
+            continue;
+        auto value_here = holder->m_storage[cache.entries[i].offset].value_or(js_undefined());
+        if (value_here.is_accessor())
+            return value_here.as_accessor().call_getter(Value(const_cast<Object*>(this)));
+        if (value_here.is_native_property())
+            return call_native_property_getter(const_cast<Object*>(this), value_here);
+        return value_here;
+    }
+
+    if (is_cacheable_property_name(property_name)) {
+        InlineCache::Entry entry;
+        const Object* object = this;
+        for (size_t depth = 0; object && !object->is_proxy_object() && depth <= InlineCache::max_prototype_depth; ++depth) {
+            entry.shape_ids[depth] = object->shape().id();
+            auto metadata = object->shape().lookup(property_name);
+            if (metadata.has_value()) {
+                entry.depth = depth;
+                entry.offset = metadata.value().offset;
+                cache.add(entry);
+                break;
+            }
+            object = object->shape().prototype();
+        }
+    }
+
+    return get(property_name);
+}
+
+bool Object::put_cached(const StringOrSymbol& property_name, Value value, InlineCache& cache)
+{
+    ASSERT(!value.is_empty());
+
+    for (size_t i = 0; i < cache.entry_count; ++i) {
+        if (!match_inline_cache_entry(cache, i))
+            continue;
+        auto& value_here = m_storage[cache.entries[i].offset];
+        if (value_here.is_accessor() || value_here.is_native_property())
+            break;
+        value_here = value;
+        write_barrier(value);
+        return true;
+    }
+
+    // Only plain writes to an existing own data property are cached. Since put() lets a
+    // setter anywhere on the prototype chain take over, the entry covers the whole chain.
+    auto metadata = shape().lookup(property_name);
+    if (is_cacheable_property_name(property_name) && metadata.has_value() && metadata.value().attributes.is_writable()) {
+        InlineCache::Entry entry;
+        entry.offset = metadata.value().offset;
+        bool is_cacheable = true;
+        const Object* object = this;
+        for (size_t depth = 0; is_cacheable; ++depth) {
+            if (depth > InlineCache::max_prototype_depth || object->is_proxy_object()) {
+                is_cacheable = false;
+                break;
+            }
+            entry.shape_ids[depth] = object->shape().id();
+            auto metadata_here = object == this ? metadata : object->shape().lookup(property_name);
+            if (metadata_here.has_value()) {
+                auto value_here = object->m_storage[metadata_here.value().offset];
+                if (value_here.is_accessor() || value_here.is_native_property())
+                    is_cacheable = false;
+            }
+            if (!object->shape().prototype()) {
+                entry.depth = depth;
+                break;
+            }
+            object = object->shape().prototype();
+        }
+        if (is_cacheable)
+            cache.add(entry);
+    }
+
+    return put(property_name, value);
+}
+
 bool Object::define_native_function(const StringOrSymbol& property_name, AK::Function<Value(Interpreter&, GlobalObject&)> native_function, i32 length, PropertyAttributes attribute)
 {
     String function_name;
@@ -765,6 +872,13 @@ bool Object::define_native_property(const StringOrSymbol& property_name, AK::Fun
     return define_property(property_name, heap().allocate_without_global_object<NativeProperty>(move(getter), move(setter)), attribute);
 }
 
+bool Object::has_write_barriers() const
+{
+    // All of the references an Object holds itself are stored with write barriers, but
+    // subclasses may have their own, so they need to opt in separately.
+    return StringView(class_name()) == "Object";
+}
+
 void Object::visit_children(Cell::Visitor& visitor)
 {
     Cell::visit_children(visitor);
@@ -773,6 +887,10 @@ void Object::visit_children(Cell::Visitor& visitor)
     for (auto& value : m_storage)
         visitor.visit(value);
 
+    // Unboxed int32 and double elements can't point at any cells.
+    auto* packed_storage = m_indexed_properties.packed_storage();
+    if (packed_storage && packed_storage->is_unboxed())
+        return;
     for (auto& value : m_indexed_properties.values_unordered())
         visitor.visit(value.value);
 }
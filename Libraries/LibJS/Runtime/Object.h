@@ -96,6 +96,12 @@ public:
 
     virtual bool put(const PropertyName&, Value, Value receiver = {});
 
+    // Named property access through the inline cache of a particular access site.
+    // These behave exactly like get() and put(), but skip the property table lookups
+    // when the shapes involved match an earlier lookup made from the same site.
+    Value get_cached(const StringOrSymbol&, InlineCache&) const;
+    bool put_cached(const StringOrSymbol&, Value, InlineCache&);
+
     Value get_own_property(const Object& this_object, PropertyName, Value receiver) const;
     Value get_own_properties(const Object& this_object, PropertyKind, bool only_enumerable_properties = false, GetOwnPropertyReturnType = GetOwnPropertyReturnType::StringOnly) const;
     virtual Optional<PropertyDescriptor> get_own_property_descriptor(const PropertyName&) const;
@@ -125,6 +131,11 @@ public:
     virtual bool is_bigint_object() const { return false; }
     virtual bool is_string_iterator_object() const { return false; }
     virtual bool is_array_iterator_object() const { return false; }
+    virtual bool is_array_buffer() const { return false; }
+    virtual bool is_typed_array() const { return false; }
+    virtual bool is_data_view() const { return false; }
+
+    virtual bool has_write_barriers() const override;
 
     virtual const char* class_name() const override { return "Object"; }
     virtual void visit_children(Cell::Visitor&) override;
@@ -145,7 +156,7 @@ public:
 
     const IndexedProperties& indexed_properties() const { return m_indexed_properties; }
     IndexedProperties& indexed_properties() { return m_indexed_properties; }
-    void set_indexed_property_elements(Vector<Value>&& values) { m_indexed_properties = IndexedProperties(move(values)); }
+    void set_indexed_property_elements(Vector<Value>&& values) { m_indexed_properties = IndexedProperties(*this, move(values)); }
 
     Value invoke(const StringOrSymbol& property_name, Optional<MarkedValueList> arguments = {});
 
@@ -167,10 +178,12 @@ private:
     void set_shape(Shape&);
     void ensure_shape_is_unique();
 
+    const Object* match_inline_cache_entry(const InlineCache&, size_t entry_index) const;
+
     bool m_is_extensible { true };
     Shape* m_shape { nullptr };
     Vector<Value> m_storage;
-    IndexedProperties m_indexed_properties;
+    IndexedProperties m_indexed_properties { *this };
 };
 
 }
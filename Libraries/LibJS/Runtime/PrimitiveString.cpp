@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StringBuilder.h>
 #include <LibJS/Heap/Heap.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/PrimitiveString.h>
@@ -35,10 +36,49 @@ PrimitiveString::PrimitiveString(String string)
 {
 }
 
+PrimitiveString::PrimitiveString(PrimitiveString& lhs, PrimitiveString& rhs)
+    : m_is_rope(true)
+    , m_length(lhs.length() + rhs.length())
+    , m_lhs(&lhs)
+    , m_rhs(&rhs)
+{
+}
+
 PrimitiveString::~PrimitiveString()
 {
 }
 
+void PrimitiveString::visit_children(Cell::Visitor& visitor)
+{
+    Cell::visit_children(visitor);
+    visitor.visit(m_lhs);
+    visitor.visit(m_rhs);
+}
+
+void PrimitiveString::resolve_rope() const
+{
+    ASSERT(m_is_rope);
+
+    // Ropes built in a loop are as deep as the loop ran, so walk them with an explicit stack.
+    StringBuilder builder(m_length);
+    Vector<const PrimitiveString*> pieces;
+    pieces.append(this);
+    while (!pieces.is_empty()) {
+        auto* piece = pieces.take_last();
+        if (piece->m_is_rope) {
+            pieces.append(piece->m_rhs);
+            pieces.append(piece->m_lhs);
+            continue;
+        }
+        builder.append(piece->m_string);
+    }
+
+    m_string = builder.to_string();
+    m_is_rope = false;
+    m_lhs = nullptr;
+    m_rhs = nullptr;
+}
+
 PrimitiveString* js_string(Heap& heap, String string)
 {
     return heap.allocate_without_global_object<PrimitiveString>(move(string));
@@ -49,4 +89,23 @@ PrimitiveString* js_string(Interpreter& interpreter, String string)
     return js_string(interpreter.heap(), string);
 }
 
+PrimitiveString* js_rope_string(Heap& heap, PrimitiveString& lhs, PrimitiveString& rhs)
+{
+    if (lhs.length() == 0)
+        return &rhs;
+    if (rhs.length() == 0)
+        return &lhs;
+
+    // Short strings are cheaper to copy than to keep around as a rope.
+    static constexpr size_t min_rope_length = 32;
+    if (lhs.length() + rhs.length() < min_rope_length) {
+        StringBuilder builder(lhs.length() + rhs.length());
+        builder.append(lhs.string());
+        builder.append(rhs.string());
+        return js_string(heap, builder.to_string());
+    }
+
+    return heap.allocate_without_global_object<PrimitiveString>(lhs, rhs);
+}
+
 }
@@ -34,17 +34,37 @@ namespace JS {
 class PrimitiveString final : public Cell {
 public:
     explicit PrimitiveString(String);
+    // A rope is the concatenation of two strings that isn't flattened into a single String
+    // until somebody needs its characters, which keeps building a string piece by piece linear.
+    PrimitiveString(PrimitiveString& lhs, PrimitiveString& rhs);
     virtual ~PrimitiveString();
 
-    const String& string() const { return m_string; }
+    const String& string() const
+    {
+        if (m_is_rope)
+            resolve_rope();
+        return m_string;
+    }
+
+    size_t length() const { return m_is_rope ? m_length : m_string.length(); }
+    bool is_rope() const { return m_is_rope; }
 
 private:
     virtual const char* class_name() const override { return "PrimitiveString"; }
+    virtual bool has_write_barriers() const override { return true; }
+    virtual void visit_children(Cell::Visitor&) override;
+
+    void resolve_rope() const;
 
-    String m_string;
+    mutable bool m_is_rope { false };
+    size_t m_length { 0 };
+    mutable String m_string;
+    mutable PrimitiveString* m_lhs { nullptr };
+    mutable PrimitiveString* m_rhs { nullptr };
 };
 
 PrimitiveString* js_string(Heap&, String);
 PrimitiveString* js_string(Interpreter&, String);
+PrimitiveString* js_rope_string(Heap&, PrimitiveString& lhs, PrimitiveString& rhs);
 
 }
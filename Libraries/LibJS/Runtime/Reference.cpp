@@ -59,6 +59,10 @@ void Reference::put(Interpreter& interpreter, GlobalObject& global_object, Value
     if (!object)
         return;
 
+    if (m_put_cache) {
+        object->put_cached(m_name.to_string_or_symbol(), value, *m_put_cache);
+        return;
+    }
     object->put(m_name, value);
 }
 
@@ -101,6 +105,8 @@ Value Reference::get(Interpreter& interpreter, GlobalObject& global_object)
     if (!object)
         return {};
 
+    if (m_get_cache)
+        return object->get_cached(m_name.to_string_or_symbol(), *m_get_cache).value_or(js_undefined());
     return object->get(m_name).value_or(js_undefined());
 }
 
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/String.h>
+#include <LibJS/Forward.h>
 #include <LibJS/Runtime/PropertyName.h>
 #include <LibJS/Runtime/Value.h>
 
@@ -85,6 +86,12 @@ public:
         return m_global_variable;
     }
 
+    void set_inline_caches(InlineCache& get_cache, InlineCache& put_cache)
+    {
+        m_get_cache = &get_cache;
+        m_put_cache = &put_cache;
+    }
+
     void put(Interpreter&, GlobalObject&, Value);
     Value get(Interpreter&, GlobalObject&);
 
@@ -96,6 +103,8 @@ private:
     bool m_strict { false };
     bool m_local_variable { false };
     bool m_global_variable { false };
+    InlineCache* m_get_cache { nullptr };
+    InlineCache* m_put_cache { nullptr };
 };
 
 const LogStream& operator<<(const LogStream&, const Value&);
@@ -55,15 +55,30 @@ Value RegExpConstructor::call(Interpreter& interpreter)
 
 Value RegExpConstructor::construct(Interpreter& interpreter, Function&)
 {
-    if (!interpreter.argument_count())
-        return RegExpObject::create(global_object(), "(?:)", "");
-    auto contents = interpreter.argument(0).to_string(interpreter);
-    if (interpreter.exception())
-        return {};
-    auto flags = interpreter.argument_count() > 1 ? interpreter.argument(1).to_string(interpreter) : "";
-    if (interpreter.exception())
+    auto pattern = interpreter.argument(0);
+    auto flags = interpreter.argument(1);
+
+    String content;
+    String flags_string;
+    if (pattern.is_object() && pattern.as_object().is_regexp_object()) {
+        auto& regexp_object = static_cast<RegExpObject&>(pattern.as_object());
+        content = regexp_object.content();
+        flags_string = regexp_object.flags();
+    } else if (!pattern.is_undefined()) {
+        content = pattern.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+    if (!flags.is_undefined()) {
+        flags_string = flags.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+
+    auto* regexp_object = RegExpObject::create(global_object(), content.is_empty() ? "(?:)" : content, flags_string.is_null() ? "" : flags_string);
+    if (!regexp_object)
         return {};
-    return RegExpObject::create(global_object(), contents, flags);
+    return regexp_object;
 }
 
 }
@@ -26,31 +26,109 @@
 
 #include <AK/StringBuilder.h>
 #include <LibJS/Heap/Heap.h>
+#include <LibJS/Runtime/Error.h>
 #include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/PrimitiveString.h>
 #include <LibJS/Runtime/RegExpObject.h>
 #include <LibJS/Runtime/Value.h>
 
-
 namespace JS {
 
 RegExpObject* RegExpObject::create(GlobalObject& global_object, String content, String flags)
 {
-    return global_object.heap().allocate<RegExpObject>(global_object, content, flags, *global_object.regexp_prototype());
+    auto& interpreter = global_object.interpreter();
+    Regex::Options options;
+    for (size_t i = 0; i < flags.length(); ++i) {
+        auto flag = flags[i];
+        // The u flag is accepted, but patterns are matched byte by byte either way.
+        if (!StringView("gimsuy").contains(flag) || flags.substring_view(i + 1, flags.length() - i - 1).contains(flag)) {
+            interpreter.throw_exception<SyntaxError>(ErrorType::RegExpInvalidFlags, flags.characters());
+            return nullptr;
+        }
+        if (flag == 'i')
+            options.ignore_case = true;
+        else if (flag == 'm')
+            options.multiline = true;
+        else if (flag == 's')
+            options.dot_all = true;
+    }
+
+    auto pattern = Regex::Pattern::compile(content, options);
+    if (pattern.is_error()) {
+        interpreter.throw_exception<SyntaxError>(ErrorType::RegExpInvalidPattern, content.characters(), pattern.error().characters());
+        return nullptr;
+    }
+    return global_object.heap().allocate<RegExpObject>(global_object, content, flags, pattern.value(), *global_object.regexp_prototype());
 }
 
-RegExpObject::RegExpObject(String content, String flags, Object& prototype)
+RegExpObject::RegExpObject(String content, String flags, RefPtr<Regex::Pattern> pattern, Object& prototype)
     : Object(prototype)
     , m_content(content)
     , m_flags(flags)
+    , m_pattern(move(pattern))
+{
+}
+
+void RegExpObject::initialize(GlobalObject& global_object)
 {
+    Object::initialize(global_object);
+    if (m_pattern)
+        define_property("lastIndex", Value(0), Attribute::Writable);
 }
 
 RegExpObject::~RegExpObject()
 {
 }
 
+Optional<Regex::Match> RegExpObject::match(const String& string)
+{
+    ASSERT(m_pattern);
+    auto& interpreter = this->interpreter();
+
+    bool uses_last_index = is_global() || is_sticky();
+    size_t last_index = 0;
+    if (uses_last_index) {
+        auto last_index_value = get("lastIndex");
+        if (interpreter.exception())
+            return {};
+        last_index = last_index_value.to_size_t(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+
+    Optional<Regex::Match> result;
+    if (last_index <= string.length())
+        result = is_sticky() ? m_pattern->match_at(string, last_index) : m_pattern->search(string, last_index);
+
+    if (uses_last_index)
+        put("lastIndex", Value((i32)(result.has_value() ? result.value().end() : 0)));
+    return result;
+}
+
+Value RegExpObject::exec(const String& string)
+{
+    auto& interpreter = this->interpreter();
+    auto result = match(string);
+    if (interpreter.exception())
+        return {};
+    if (!result.has_value())
+        return js_null();
+
+    auto* array = Array::create(global_object());
+    for (auto& capture : result.value().captures) {
+        if (capture.matched)
+            array->indexed_properties().append(js_string(interpreter, string.substring(capture.start, capture.length())));
+        else
+            array->indexed_properties().append(js_undefined());
+    }
+    array->put("index", Value((i32)result.value().start()));
+    array->put("input", js_string(interpreter, string));
+    array->put("groups", js_undefined());
+    return array;
+}
+
 Value RegExpObject::to_string() const
 {
     return js_string(interpreter(), String::format("/%s/%s", content().characters(), flags().characters()));
@@ -28,6 +28,7 @@
 
 #include <LibJS/AST.h>
 #include <LibJS/Runtime/Object.h>
+#include <LibRegex/Pattern.h>
 
 namespace JS {
 
@@ -35,14 +36,28 @@ class RegExpObject : public Object {
     JS_OBJECT(RegExpObject, Object);
 
 public:
+    // Throws a SyntaxError and returns nullptr if the pattern or the flags are invalid.
     static RegExpObject* create(GlobalObject&, String content, String flags);
 
-    RegExpObject(String content, String flags, Object& prototype);
+    RegExpObject(String content, String flags, RefPtr<Regex::Pattern>, Object& prototype);
+    virtual void initialize(GlobalObject&) override;
     virtual ~RegExpObject() override;
 
     const String& content() const { return m_content; }
     const String& flags() const { return m_flags; }
 
+    bool is_global() const { return m_flags.view().contains('g'); }
+    bool is_sticky() const { return m_flags.view().contains('y'); }
+
+    // Null for RegExp.prototype, which isn't a regular expression itself.
+    const Regex::Pattern* pattern() const { return m_pattern.ptr(); }
+
+    // Matches from lastIndex and moves it past the match if the expression is global or sticky,
+    // and from the start of the string otherwise. Check for an exception when this returns nothing.
+    Optional<Regex::Match> match(const String&);
+    // Like match(), but returns the array that RegExp.prototype.exec() does, or null.
+    Value exec(const String&);
+
     Value to_string() const override;
 
 private:
@@ -50,6 +65,7 @@ private:
 
     String m_content;
     String m_flags;
+    RefPtr<Regex::Pattern> m_pattern;
 };
 
 }
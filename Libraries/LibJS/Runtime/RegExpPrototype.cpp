@@ -28,6 +28,7 @@
 #include <AK/StringBuilder.h>
 #include <LibJS/Heap/Heap.h>
 #include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/PrimitiveString.h>
 #include <LibJS/Runtime/RegExpObject.h>
@@ -36,12 +37,156 @@
 namespace JS {
 
 RegExpPrototype::RegExpPrototype(GlobalObject& global_object)
-    : RegExpObject({}, {}, *global_object.object_prototype())
+    : RegExpObject({}, {}, nullptr, *global_object.object_prototype())
 {
 }
 
+void RegExpPrototype::initialize(GlobalObject& global_object)
+{
+    RegExpObject::initialize(global_object);
+    u8 attr = Attribute::Writable | Attribute::Configurable;
+    define_native_function("exec", exec, 1, attr);
+    define_native_function("test", test, 1, attr);
+    define_native_function("toString", to_string, 0, attr);
+
+    define_native_property("source", source, nullptr, Attribute::Configurable);
+    define_native_property("flags", flags, nullptr, Attribute::Configurable);
+    define_native_property("global", global, nullptr, Attribute::Configurable);
+    define_native_property("ignoreCase", ignore_case, nullptr, Attribute::Configurable);
+    define_native_property("multiline", multiline, nullptr, Attribute::Configurable);
+    define_native_property("dotAll", dot_all, nullptr, Attribute::Configurable);
+    define_native_property("unicode", unicode, nullptr, Attribute::Configurable);
+    define_native_property("sticky", sticky, nullptr, Attribute::Configurable);
+}
+
 RegExpPrototype::~RegExpPrototype()
 {
 }
 
+static RegExpObject* regexp_object_from(Interpreter& interpreter, GlobalObject& global_object)
+{
+    auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
+    if (!this_object)
+        return nullptr;
+    if (!this_object->is_regexp_object() || !static_cast<RegExpObject*>(this_object)->pattern()) {
+        interpreter.throw_exception<TypeError>(ErrorType::NotA, "RegExp");
+        return nullptr;
+    }
+    return static_cast<RegExpObject*>(this_object);
+}
+
+static Value flag_getter(Interpreter& interpreter, GlobalObject& global_object, char flag)
+{
+    auto this_value = interpreter.this_value(global_object);
+    if (this_value.is_object() && &this_value.as_object() == global_object.regexp_prototype())
+        return js_undefined();
+    auto* regexp_object = regexp_object_from(interpreter, global_object);
+    if (!regexp_object)
+        return {};
+    return Value(regexp_object->flags().view().contains(flag));
+}
+
+JS_DEFINE_NATIVE_FUNCTION(RegExpPrototype::exec)
+{
+    auto* regexp_object = regexp_object_from(interpreter, global_object);
+    if (!regexp_object)
+        return {};
+    auto string = interpreter.argument(0).to_string(interpreter);
+    if (interpreter.exception())
+        return {};
+    return regexp_object->exec(string);
+}
+
+JS_DEFINE_NATIVE_FUNCTION(RegExpPrototype::test)
+{
+    auto* regexp_object = regexp_object_from(interpreter, global_object);
+    if (!regexp_object)
+        return {};
+    auto string = interpreter.argument(0).to_string(interpreter);
+    if (interpreter.exception())
+        return {};
+    auto match = regexp_object->match(string);
+    if (interpreter.exception())
+        return {};
+    return Value(match.has_value());
+}
+
+JS_DEFINE_NATIVE_FUNCTION(RegExpPrototype::to_string)
+{
+    auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
+    if (!this_object)
+        return {};
+    auto source = this_object->get("source").value_or(js_undefined()).to_string(interpreter);
+    if (interpreter.exception())
+        return {};
+    auto flags = this_object->get("flags").value_or(js_undefined()).to_string(interpreter);
+    if (interpreter.exception())
+        return {};
+    return js_string(interpreter, String::format("/%s/%s", source.characters(), flags.characters()));
+}
+
+JS_DEFINE_NATIVE_GETTER(RegExpPrototype::source)
+{
+    auto this_value = interpreter.this_value(global_object);
+    if (this_value.is_object() && &this_value.as_object() == global_object.regexp_prototype())
+        return js_string(interpreter, "(?:)");
+    auto* regexp_object = regexp_object_from(interpreter, global_object);
+    if (!regexp_object)
+        return {};
+    return js_string(interpreter, regexp_object->content());
+}
+
+JS_DEFINE_NATIVE_GETTER(RegExpPrototype::flags)
+{
+    auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
+    if (!this_object)
+        return {};
+    // The flags always come out in the same order, whatever order they were given in.
+    struct Flag {
+        const char* property_name;
+        char character;
+    };
+    static const Flag flag_order[] = { { "global", 'g' }, { "ignoreCase", 'i' }, { "multiline", 'm' }, { "dotAll", 's' }, { "unicode", 'u' }, { "sticky", 'y' } };
+
+    StringBuilder builder(6);
+    for (auto& flag : flag_order) {
+        auto value = this_object->get(flag.property_name);
+        if (interpreter.exception())
+            return {};
+        if (value.to_boolean())
+            builder.append(flag.character);
+    }
+    return js_string(interpreter, builder.to_string());
+}
+
+JS_DEFINE_NATIVE_GETTER(RegExpPrototype::global)
+{
+    return flag_getter(interpreter, global_object, 'g');
+}
+
+JS_DEFINE_NATIVE_GETTER(RegExpPrototype::ignore_case)
+{
+    return flag_getter(interpreter, global_object, 'i');
+}
+
+JS_DEFINE_NATIVE_GETTER(RegExpPrototype::multiline)
+{
+    return flag_getter(interpreter, global_object, 'm');
+}
+
+JS_DEFINE_NATIVE_GETTER(RegExpPrototype::dot_all)
+{
+    return flag_getter(interpreter, global_object, 's');
+}
+
+JS_DEFINE_NATIVE_GETTER(RegExpPrototype::unicode)
+{
+    return flag_getter(interpreter, global_object, 'u');
+}
+
+JS_DEFINE_NATIVE_GETTER(RegExpPrototype::sticky)
+{
+    return flag_getter(interpreter, global_object, 'y');
+}
+
 }
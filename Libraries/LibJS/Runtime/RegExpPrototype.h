@@ -35,7 +35,22 @@ class RegExpPrototype final : public RegExpObject {
 
 public:
     explicit RegExpPrototype(GlobalObject&);
+    virtual void initialize(GlobalObject&) override;
     virtual ~RegExpPrototype() override;
+
+private:
+    JS_DECLARE_NATIVE_FUNCTION(exec);
+    JS_DECLARE_NATIVE_FUNCTION(test);
+    JS_DECLARE_NATIVE_FUNCTION(to_string);
+
+    JS_DECLARE_NATIVE_GETTER(source);
+    JS_DECLARE_NATIVE_GETTER(flags);
+    JS_DECLARE_NATIVE_GETTER(global);
+    JS_DECLARE_NATIVE_GETTER(ignore_case);
+    JS_DECLARE_NATIVE_GETTER(multiline);
+    JS_DECLARE_NATIVE_GETTER(dot_all);
+    JS_DECLARE_NATIVE_GETTER(unicode);
+    JS_DECLARE_NATIVE_GETTER(sticky);
 };
 
 }
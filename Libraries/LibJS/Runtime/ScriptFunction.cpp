@@ -26,8 +26,10 @@
 
 #include <AK/Function.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/Array.h>
+#include <LibJS/Runtime/EnvironmentLayout.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/ScriptFunction.h>
@@ -47,18 +49,21 @@ static ScriptFunction* typed_this(Interpreter& interpreter, GlobalObject& global
     return static_cast<ScriptFunction*>(this_object);
 }
 
-ScriptFunction* ScriptFunction::create(GlobalObject& global_object, const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, bool is_arrow_function)
+ScriptFunction* ScriptFunction::create(GlobalObject& global_object, const FunctionNode& function_node, LexicalEnvironment* parent_environment, bool is_arrow_function)
 {
-    return global_object.heap().allocate<ScriptFunction>(global_object, global_object, name, body, move(parameters), m_function_length, parent_environment, *global_object.function_prototype(), is_arrow_function);
+    return global_object.heap().allocate<ScriptFunction>(global_object, global_object, function_node, parent_environment, *global_object.function_prototype(), is_arrow_function);
 }
 
-ScriptFunction::ScriptFunction(GlobalObject& global_object, const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, Object& prototype, bool is_arrow_function)
+ScriptFunction::ScriptFunction(GlobalObject& global_object, const FunctionNode& function_node, LexicalEnvironment* parent_environment, Object& prototype, bool is_arrow_function)
     : Function(prototype, is_arrow_function ? interpreter().this_value(global_object) : Value(), {})
-    , m_name(name)
-    , m_body(body)
-    , m_parameters(move(parameters))
+    , m_name(function_node.name())
+    , m_body(function_node.body_ptr())
+    , m_lazy_body(function_node.lazy_body())
+    , m_parameters(function_node.parameters())
     , m_parent_environment(parent_environment)
-    , m_function_length(m_function_length)
+    , m_function_length(function_node.function_length())
+    , m_source_line(function_node.source_line())
+    , m_source_column(function_node.source_column())
     , m_is_arrow_function(is_arrow_function)
 {
 }
@@ -85,22 +90,20 @@ void ScriptFunction::visit_children(Visitor& visitor)
     visitor.visit(m_parent_environment);
 }
 
-LexicalEnvironment* ScriptFunction::create_environment()
+bool ScriptFunction::ensure_body_is_parsed()
 {
-    HashMap<FlyString, Variable> variables;
-    for (auto& parameter : m_parameters) {
-        variables.set(parameter.name, { js_undefined(), DeclarationKind::Var });
-    }
-
-    if (body().is_scope_node()) {
-        for (auto& declaration : static_cast<const ScopeNode&>(body()).variables()) {
-            for (auto& declarator : declaration.declarations()) {
-                variables.set(declarator.id().string(), { js_undefined(), DeclarationKind::Var });
-            }
-        }
-    }
+    if (m_body)
+        return true;
+    ASSERT(m_lazy_body);
+    m_body = m_lazy_body->body();
+    return m_body;
+}
 
-    auto* environment = heap().allocate<LexicalEnvironment>(global_object(), move(variables), m_parent_environment, LexicalEnvironment::EnvironmentRecordType::Function);
+LexicalEnvironment* ScriptFunction::create_environment()
+{
+    // A body with a syntax error gets reported when the function is called, but the call still needs an environment.
+    auto layout = ensure_body_is_parsed() ? EnvironmentLayout::for_function(m_parameters, body()) : EnvironmentLayout::create({});
+    auto* environment = heap().allocate<LexicalEnvironment>(global_object(), move(layout), m_parent_environment, LexicalEnvironment::EnvironmentRecordType::Function);
     environment->set_home_object(home_object());
     environment->set_current_function(*this);
     return environment;
@@ -108,6 +111,9 @@ LexicalEnvironment* ScriptFunction::create_environment()
 
 Value ScriptFunction::call(Interpreter& interpreter)
 {
+    if (!ensure_body_is_parsed())
+        return interpreter.throw_exception<SyntaxError>(m_lazy_body->error());
+
     auto& argument_values = interpreter.call_frame().arguments;
     ArgumentVector arguments;
     for (size_t i = 0; i < m_parameters.size(); ++i) {
@@ -130,7 +136,12 @@ Value ScriptFunction::call(Interpreter& interpreter)
         arguments.append({ parameter.name, value });
         interpreter.current_environment()->set(parameter.name, { value, DeclarationKind::Var });
     }
-    return interpreter.run(global_object(), m_body, arguments, ScopeType::Function);
+    if (interpreter.bytecode_enabled() && m_body->is_scope_node()) {
+        auto& body = static_cast<const ScopeNode&>(*m_body);
+        if (auto* executable = body.bytecode_executable())
+            return Bytecode::run(interpreter, global_object(), body, *executable, move(arguments));
+    }
+    return interpreter.run(global_object(), *m_body, arguments, ScopeType::Function);
 }
 
 Value ScriptFunction::construct(Interpreter& interpreter, Function&)
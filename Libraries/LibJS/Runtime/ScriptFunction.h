@@ -35,15 +35,24 @@ class ScriptFunction final : public Function {
     JS_OBJECT(ScriptFunction, Function);
 
 public:
-    static ScriptFunction* create(GlobalObject&, const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, bool is_arrow_function = false);
+    static ScriptFunction* create(GlobalObject&, const FunctionNode&, LexicalEnvironment* parent_environment, bool is_arrow_function = false);
 
-    ScriptFunction(GlobalObject&, const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, Object& prototype, bool is_arrow_function = false);
+    ScriptFunction(GlobalObject&, const FunctionNode&, LexicalEnvironment* parent_environment, Object& prototype, bool is_arrow_function = false);
     virtual void initialize(GlobalObject&) override;
     virtual ~ScriptFunction();
 
-    const Statement& body() const { return m_body; }
+    // Functions whose body was skipped by the parser only have one after they're first called.
+    bool has_body() const { return m_body; }
+    const Statement& body() const
+    {
+        ASSERT(m_body);
+        return *m_body;
+    }
     const Vector<FunctionNode::Parameter>& parameters() const { return m_parameters; };
 
+    size_t source_line() const { return m_source_line; }
+    size_t source_column() const { return m_source_column; }
+
     virtual Value call(Interpreter&) override;
     virtual Value construct(Interpreter&, Function& new_target) override;
 
@@ -52,17 +61,23 @@ public:
 
 private:
     virtual bool is_script_function() const override { return true; }
+    virtual bool has_write_barriers() const override { return true; }
     virtual LexicalEnvironment* create_environment() override;
     virtual void visit_children(Visitor&) override;
 
     JS_DECLARE_NATIVE_GETTER(length_getter);
     JS_DECLARE_NATIVE_GETTER(name_getter);
 
+    bool ensure_body_is_parsed();
+
     FlyString m_name;
-    NonnullRefPtr<Statement> m_body;
+    RefPtr<Statement> m_body;
+    RefPtr<LazyFunctionBody> m_lazy_body;
     const Vector<FunctionNode::Parameter> m_parameters;
     LexicalEnvironment* m_parent_environment { nullptr };
     i32 m_function_length;
+    size_t m_source_line { 0 };
+    size_t m_source_column { 0 };
     bool m_is_arrow_function;
 };
 
@@ -30,6 +30,8 @@
 
 namespace JS {
 
+static u64 s_next_shape_id = 1;
+
 Shape* Shape::create_unique_clone() const
 {
     auto* new_shape = heap().allocate<Shape>(m_global_object, m_global_object);
@@ -48,6 +50,7 @@ Shape* Shape::create_put_transition(const StringOrSymbol& property_name, Propert
         return existing_shape;
     auto* new_shape = heap().allocate<Shape>(m_global_object, *this, property_name, attributes, TransitionType::Put);
     m_forward_transitions.set(key, new_shape);
+    write_barrier(new_shape);
     return new_shape;
 }
 
@@ -58,6 +61,7 @@ Shape* Shape::create_configure_transition(const StringOrSymbol& property_name, P
         return existing_shape;
     auto* new_shape = heap().allocate<Shape>(m_global_object, *this, property_name, attributes, TransitionType::Configure);
     m_forward_transitions.set(key, new_shape);
+    write_barrier(new_shape);
     return new_shape;
 }
 
@@ -69,6 +73,7 @@ Shape* Shape::create_prototype_transition(Object* new_prototype)
 Shape::Shape(GlobalObject& global_object)
     : m_global_object(global_object)
 {
+    m_id = s_next_shape_id++;
 }
 
 Shape::Shape(Shape& previous_shape, const StringOrSymbol& property_name, PropertyAttributes attributes, TransitionType transition_type)
@@ -79,6 +84,7 @@ Shape::Shape(Shape& previous_shape, const StringOrSymbol& property_name, Propert
     , m_prototype(previous_shape.m_prototype)
     , m_transition_type(transition_type)
 {
+    m_id = s_next_shape_id++;
 }
 
 Shape::Shape(Shape& previous_shape, Object* new_prototype)
@@ -87,6 +93,7 @@ Shape::Shape(Shape& previous_shape, Object* new_prototype)
     , m_prototype(new_prototype)
     , m_transition_type(TransitionType::Prototype)
 {
+    m_id = s_next_shape_id++;
 }
 
 Shape::~Shape()
@@ -170,12 +177,28 @@ void Shape::ensure_property_table() const
     }
 }
 
+void Shape::did_change_in_place()
+{
+    ASSERT(is_unique());
+    m_id = s_next_shape_id++;
+}
+
+void Shape::set_prototype_without_transition(Object* new_prototype)
+{
+    m_prototype = new_prototype;
+    write_barrier(new_prototype);
+    m_id = s_next_shape_id++;
+}
+
 void Shape::add_property_to_unique_shape(const StringOrSymbol& property_name, PropertyAttributes attributes)
 {
     ASSERT(is_unique());
     ASSERT(m_property_table);
     ASSERT(!m_property_table->contains(property_name));
     m_property_table->set(property_name, { m_property_table->size(), attributes });
+    if (property_name.is_symbol())
+        write_barrier(const_cast<Symbol*>(property_name.as_symbol()));
+    did_change_in_place();
 }
 
 void Shape::reconfigure_property_in_unique_shape(const StringOrSymbol& property_name, PropertyAttributes attributes)
@@ -184,6 +207,7 @@ void Shape::reconfigure_property_in_unique_shape(const StringOrSymbol& property_
     ASSERT(m_property_table);
     ASSERT(m_property_table->contains(property_name));
     m_property_table->set(property_name, { m_property_table->size(), attributes });
+    did_change_in_place();
 }
 
 void Shape::remove_property_from_unique_shape(const StringOrSymbol& property_name, size_t offset)
@@ -196,6 +220,7 @@ void Shape::remove_property_from_unique_shape(const StringOrSymbol& property_nam
         if (it.value.offset > offset)
             --it.value.offset;
     }
+    did_change_in_place();
 }
 
 }
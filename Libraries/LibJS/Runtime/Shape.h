@@ -71,6 +71,11 @@ public:
     Shape* create_prototype_transition(Object* new_prototype);
 
     bool is_unique() const { return m_unique; }
+
+    // Changes whenever the property table or prototype of this shape does, which only
+    // ever happens to unique shapes. Ids are never reused, so they are safe to cache.
+    u64 id() const { return m_id; }
+
     Shape* create_unique_clone() const;
 
     GlobalObject& global_object() const { return m_global_object; }
@@ -89,7 +94,7 @@ public:
 
     Vector<Property> property_table_ordered() const;
 
-    void set_prototype_without_transition(Object* new_prototype) { m_prototype = new_prototype; }
+    void set_prototype_without_transition(Object* new_prototype);
 
     void remove_property_from_unique_shape(const StringOrSymbol&, size_t offset);
     void add_property_to_unique_shape(const StringOrSymbol&, PropertyAttributes attributes);
@@ -97,12 +102,16 @@ public:
 
 private:
     virtual const char* class_name() const override { return "Shape"; }
+    virtual bool has_write_barriers() const override { return true; }
     virtual void visit_children(Visitor&) override;
 
     void ensure_property_table() const;
+    void did_change_in_place();
 
     GlobalObject& m_global_object;
 
+    u64 m_id { 0 };
+
     mutable OwnPtr<HashMap<StringOrSymbol, PropertyMetadata>> m_property_table;
 
     HashMap<TransitionKey, Shape*> m_forward_transitions;
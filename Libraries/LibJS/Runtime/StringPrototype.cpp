@@ -29,9 +29,12 @@
 #include <AK/StringBuilder.h>
 #include <LibJS/Heap/Heap.h>
 #include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/MarkedValueList.h>
 #include <LibJS/Runtime/PrimitiveString.h>
+#include <LibJS/Runtime/RegExpObject.h>
 #include <LibJS/Runtime/StringObject.h>
 #include <LibJS/Runtime/StringIterator.h>
 #include <LibJS/Runtime/StringPrototype.h>
@@ -89,6 +92,10 @@ void StringPrototype::initialize(GlobalObject& global_object)
     define_native_function("includes", includes, 1, attr);
     define_native_function("slice", slice, 2, attr);
     define_native_function("lastIndexOf", last_index_of, 1, attr);
+    define_native_function("match", match, 1, attr);
+    define_native_function("search", search, 1, attr);
+    define_native_function("replace", replace, 2, attr);
+    define_native_function("split", split, 2, attr);
     define_native_function(global_object.interpreter().well_known_symbol_iterator(), symbol_iterator, 0, attr);
 }
 
@@ -212,7 +219,7 @@ JS_DEFINE_NATIVE_GETTER(StringPrototype::length_getter)
     auto* string_object = typed_this(interpreter, global_object);
     if (!string_object)
         return {};
-    return Value((i32)string_object->primitive_string().string().length());
+    return Value((i32)string_object->primitive_string().length());
 }
 
 JS_DEFINE_NATIVE_FUNCTION(StringPrototype::to_string)
@@ -452,6 +459,309 @@ JS_DEFINE_NATIVE_FUNCTION(StringPrototype::last_index_of)
     return Value(-1);
 }
 
+// The index after the (UTF-8) character at the given one, to get past an empty match.
+static size_t advance_string_index(const String& string, size_t index)
+{
+    ++index;
+    while (index < string.length() && (string[index] & 0xc0) == 0x80)
+        ++index;
+    return index;
+}
+
+static RegExpObject* regexp_object_from(Value value)
+{
+    if (!value.is_object() || !value.as_object().is_regexp_object())
+        return nullptr;
+    auto& regexp_object = static_cast<RegExpObject&>(value.as_object());
+    if (!regexp_object.pattern())
+        return nullptr;
+    return &regexp_object;
+}
+
+// Uses the argument if it's a regular expression, and makes one out of it otherwise.
+static RegExpObject* regexp_object_from(Interpreter& interpreter, GlobalObject& global_object, Value value)
+{
+    if (auto* regexp_object = regexp_object_from(value))
+        return regexp_object;
+    String content = "(?:)";
+    if (!value.is_undefined()) {
+        content = value.to_string(interpreter);
+        if (interpreter.exception())
+            return nullptr;
+    }
+    return RegExpObject::create(global_object, content, "");
+}
+
+// All the matches replace() has to replace, or of the (only) match for a global one.
+static Optional<Vector<Regex::Match>> all_matches(Interpreter& interpreter, RegExpObject& regexp_object, const String& string)
+{
+    Vector<Regex::Match> matches;
+    bool is_global = regexp_object.is_global();
+    if (is_global) {
+        regexp_object.put("lastIndex", Value(0));
+        if (interpreter.exception())
+            return {};
+    }
+    for (;;) {
+        auto match = regexp_object.match(string);
+        if (interpreter.exception())
+            return {};
+        if (!match.has_value())
+            break;
+        bool is_empty = match.value().captures[0].length() == 0;
+        auto end = match.value().end();
+        matches.append(match.release_value());
+        if (!is_global)
+            break;
+        if (is_empty) {
+            regexp_object.put("lastIndex", Value((i32)advance_string_index(string, end)));
+            if (interpreter.exception())
+                return {};
+        }
+    }
+    return matches;
+}
+
+JS_DEFINE_NATIVE_FUNCTION(StringPrototype::match)
+{
+    auto string = ak_string_from(interpreter, global_object);
+    if (string.is_null())
+        return {};
+    auto* regexp_object = regexp_object_from(interpreter, global_object, interpreter.argument(0));
+    if (!regexp_object)
+        return {};
+    if (!regexp_object->is_global())
+        return regexp_object->exec(string);
+
+    auto matches = all_matches(interpreter, *regexp_object, string);
+    if (!matches.has_value())
+        return {};
+    if (matches.value().is_empty())
+        return js_null();
+    auto* array = Array::create(global_object);
+    for (auto& match : matches.value())
+        array->indexed_properties().append(js_string(interpreter, string.substring(match.start(), match.captures[0].length())));
+    return array;
+}
+
+JS_DEFINE_NATIVE_FUNCTION(StringPrototype::search)
+{
+    auto string = ak_string_from(interpreter, global_object);
+    if (string.is_null())
+        return {};
+    auto* regexp_object = regexp_object_from(interpreter, global_object, interpreter.argument(0));
+    if (!regexp_object)
+        return {};
+    // search() doesn't look at or touch lastIndex, so this doesn't go through RegExpObject::match().
+    auto& pattern = *regexp_object->pattern();
+    auto match = regexp_object->is_sticky() ? pattern.match_at(string, 0) : pattern.search(string);
+    if (!match.has_value())
+        return Value(-1);
+    return Value((i32)match.value().start());
+}
+
+static void append_substitution(StringBuilder& builder, const String& replacement, const String& string, const Regex::Match& match)
+{
+    for (size_t i = 0; i < replacement.length(); ++i) {
+        char ch = replacement[i];
+        if (ch != '$' || i + 1 == replacement.length()) {
+            builder.append(ch);
+            continue;
+        }
+
+        char next = replacement[i + 1];
+        if (next == '$') {
+            builder.append('$');
+            ++i;
+        } else if (next == '&') {
+            builder.append(string.substring_view(match.start(), match.captures[0].length()));
+            ++i;
+        } else if (next == '`') {
+            builder.append(string.substring_view(0, match.start()));
+            ++i;
+        } else if (next == '\'') {
+            builder.append(string.substring_view(match.end(), string.length() - match.end()));
+            ++i;
+        } else if (next >= '0' && next <= '9') {
+            // Two digits make a group number if there are that many groups, one digit otherwise.
+            size_t group_count = match.captures.size() - 1;
+            size_t group = next - '0';
+            size_t digits = 1;
+            if (i + 2 < replacement.length() && replacement[i + 2] >= '0' && replacement[i + 2] <= '9') {
+                size_t two_digit_group = group * 10 + (replacement[i + 2] - '0');
+                if (two_digit_group >= 1 && two_digit_group <= group_count) {
+                    group = two_digit_group;
+                    digits = 2;
+                }
+            }
+            if (group < 1 || group > group_count) {
+                builder.append('$');
+                continue;
+            }
+            auto& capture = match.captures[group];
+            if (capture.matched)
+                builder.append(string.substring_view(capture.start, capture.length()));
+            i += digits;
+        } else {
+            builder.append('$');
+        }
+    }
+}
+
+JS_DEFINE_NATIVE_FUNCTION(StringPrototype::replace)
+{
+    auto string = ak_string_from(interpreter, global_object);
+    if (string.is_null())
+        return {};
+    auto search_value = interpreter.argument(0);
+    auto replace_value = interpreter.argument(1);
+
+    Vector<Regex::Match> matches;
+    if (auto* regexp_object = regexp_object_from(search_value)) {
+        auto regexp_matches = all_matches(interpreter, *regexp_object, string);
+        if (!regexp_matches.has_value())
+            return {};
+        matches = regexp_matches.release_value();
+    } else {
+        auto search_string = search_value.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+        if (auto position = string.index_of(search_string); position.has_value()) {
+            Regex::Match match;
+            match.captures.append({ true, position.value(), position.value() + search_string.length() });
+            matches.append(move(match));
+        }
+    }
+
+    String replacement;
+    if (!replace_value.is_function()) {
+        replacement = replace_value.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+
+    StringBuilder builder;
+    size_t end_of_last_match = 0;
+    for (auto& match : matches) {
+        builder.append(string.substring_view(end_of_last_match, match.start() - end_of_last_match));
+        end_of_last_match = match.end();
+
+        if (!replace_value.is_function()) {
+            append_substitution(builder, replacement, string, match);
+            continue;
+        }
+
+        MarkedValueList arguments(interpreter.heap());
+        for (auto& capture : match.captures) {
+            if (capture.matched)
+                arguments.append(js_string(interpreter, string.substring(capture.start, capture.length())));
+            else
+                arguments.append(js_undefined());
+        }
+        arguments.append(Value((i32)match.start()));
+        arguments.append(js_string(interpreter, string));
+        auto result = interpreter.call(replace_value.as_function(), js_undefined(), move(arguments));
+        if (interpreter.exception())
+            return {};
+        auto result_string = result.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+        builder.append(result_string);
+    }
+    builder.append(string.substring_view(end_of_last_match, string.length() - end_of_last_match));
+    return js_string(interpreter, builder.to_string());
+}
+
+JS_DEFINE_NATIVE_FUNCTION(StringPrototype::split)
+{
+    auto string = ak_string_from(interpreter, global_object);
+    if (string.is_null())
+        return {};
+    auto separator = interpreter.argument(0);
+    auto* array = Array::create(global_object);
+
+    size_t limit = NumericLimits<u32>::max();
+    if (!interpreter.argument(1).is_undefined()) {
+        limit = interpreter.argument(1).to_size_t(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+    auto append_part = [&](size_t start, size_t end) {
+        array->indexed_properties().append(js_string(interpreter, string.substring(start, end - start)));
+        return array->indexed_properties().array_like_size() >= limit;
+    };
+
+    auto* regexp_object = regexp_object_from(separator);
+    String separator_string;
+    if (!regexp_object && !separator.is_undefined()) {
+        separator_string = separator.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+    if (limit == 0)
+        return array;
+    if (!regexp_object && separator.is_undefined()) {
+        append_part(0, string.length());
+        return array;
+    }
+
+    if (!regexp_object) {
+        if (separator_string.is_empty()) {
+            for (size_t position = 0; position < string.length();) {
+                auto next_position = advance_string_index(string, position);
+                if (append_part(position, next_position))
+                    break;
+                position = next_position;
+            }
+            return array;
+        }
+        size_t part_start = 0;
+        for (;;) {
+            auto position = string.index_of(separator_string, part_start);
+            if (!position.has_value())
+                break;
+            if (append_part(part_start, position.value()))
+                return array;
+            part_start = position.value() + separator_string.length();
+        }
+        append_part(part_start, string.length());
+        return array;
+    }
+
+    // The separator is tried at each position in turn, and only ever splits off something
+    // non-empty, so an empty match by itself doesn't split the string.
+    auto& pattern = *regexp_object->pattern();
+    if (string.is_empty()) {
+        if (!pattern.match_at(string, 0).has_value())
+            append_part(0, 0);
+        return array;
+    }
+    size_t part_start = 0;
+    size_t position = 0;
+    while (position < string.length()) {
+        auto match = pattern.match_at(string, position);
+        if (!match.has_value() || match.value().end() == part_start) {
+            position = advance_string_index(string, position);
+            continue;
+        }
+        if (append_part(part_start, position))
+            return array;
+        for (size_t i = 1; i < match.value().captures.size(); ++i) {
+            auto& capture = match.value().captures[i];
+            if (capture.matched)
+                array->indexed_properties().append(js_string(interpreter, string.substring(capture.start, capture.length())));
+            else
+                array->indexed_properties().append(js_undefined());
+            if (array->indexed_properties().array_like_size() >= limit)
+                return array;
+        }
+        part_start = match.value().end();
+        position = part_start;
+    }
+    append_part(part_start, string.length());
+    return array;
+}
+
 JS_DEFINE_NATIVE_FUNCTION(StringPrototype::symbol_iterator)
 {
     auto this_object = interpreter.this_value(global_object);
@@ -45,6 +45,7 @@ public:
 
 private:
     virtual const char* class_name() const override { return "Symbol"; }
+    virtual bool has_write_barriers() const override { return true; }
 
     String m_description;
     bool m_is_global;
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/Heap/Heap.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/TypedArray.h>
+
+namespace JS {
+
+TypedArrayBase::TypedArrayBase(ArrayBuffer& buffer, u32 byte_offset, u32 array_length, size_t element_size, Object& prototype)
+    : Object(prototype)
+    , m_viewed_array_buffer(&buffer)
+    , m_byte_offset(byte_offset)
+    , m_array_length(array_length)
+    , m_element_size(element_size)
+{
+    ASSERT(byte_offset + array_length * element_size <= buffer.byte_length());
+}
+
+TypedArrayBase::~TypedArrayBase()
+{
+}
+
+void TypedArrayBase::visit_children(Visitor& visitor)
+{
+    Object::visit_children(visitor);
+    visitor.visit(m_viewed_array_buffer);
+}
+
+template<typename T>
+Value TypedArray<T>::get_by_index(u32 property_index) const
+{
+    if (property_index >= array_length())
+        return {};
+    return element_to_value(data()[property_index]);
+}
+
+template<typename T>
+bool TypedArray<T>::put_by_index(u32 property_index, Value value)
+{
+    auto number = value.to_number(interpreter());
+    if (interpreter().exception())
+        return false;
+    if (property_index < array_length())
+        data()[property_index] = number_to_element(number.as_double());
+    return true;
+}
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, Type)                                                          \
+    template class TypedArray<Type>;                                                                                                         \
+                                                                                                                                             \
+    ClassName* ClassName::create(GlobalObject& global_object, u32 array_length)                                                              \
+    {                                                                                                                                        \
+        auto* buffer = ArrayBuffer::create(global_object, array_length * sizeof(Type));                                                      \
+        return create(global_object, *buffer, 0, array_length);                                                                              \
+    }                                                                                                                                        \
+                                                                                                                                             \
+    ClassName* ClassName::create(GlobalObject& global_object, ArrayBuffer& buffer, u32 byte_offset, u32 array_length)                        \
+    {                                                                                                                                        \
+        return global_object.heap().allocate<ClassName>(global_object, buffer, byte_offset, array_length, *global_object.snake_name##_prototype()); \
+    }                                                                                                                                        \
+                                                                                                                                             \
+    ClassName::ClassName(ArrayBuffer& buffer, u32 byte_offset, u32 array_length, Object& prototype)                                          \
+        : TypedArray(buffer, byte_offset, array_length, prototype)                                                                           \
+    {                                                                                                                                        \
+    }                                                                                                                                        \
+                                                                                                                                             \
+    ClassName::~ClassName() { }                                                                                                              \
+                                                                                                                                             \
+    TypedArrayBase* ClassName::create_with_same_type(GlobalObject& global_object, ArrayBuffer& buffer, u32 byte_offset, u32 array_length) const \
+    {                                                                                                                                        \
+        return create(global_object, buffer, byte_offset, array_length);                                                                     \
+    }
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
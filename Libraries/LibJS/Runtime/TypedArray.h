@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/StdLibExtras.h>
+#include <LibJS/Runtime/ArrayBuffer.h>
+#include <math.h>
+
+namespace JS {
+
+// The element type of Uint8ClampedArray. Values are clamped into its range instead of wrapping around.
+struct ClampedU8 {
+    u8 value;
+};
+
+class TypedArrayBase : public Object {
+    JS_OBJECT(TypedArrayBase, Object);
+
+public:
+    virtual ~TypedArrayBase() override;
+
+    ArrayBuffer& viewed_array_buffer() const { return *m_viewed_array_buffer; }
+    u32 byte_offset() const { return m_byte_offset; }
+    u32 array_length() const { return m_array_length; }
+    u32 byte_length() const { return m_array_length * m_element_size; }
+    size_t element_size() const { return m_element_size; }
+
+    u8* bytes() { return m_viewed_array_buffer->buffer().data() + m_byte_offset; }
+    const u8* bytes() const { return m_viewed_array_buffer->buffer().data() + m_byte_offset; }
+
+    // Reading or writing an index outside of the array does nothing, and elements are never
+    // looked up on the prototype chain.
+    virtual Value get_by_index(u32 property_index) const override = 0;
+    virtual bool put_by_index(u32 property_index, Value) override = 0;
+
+    // Creates a new typed array with the same element type as this one, viewing the given range of a buffer.
+    virtual TypedArrayBase* create_with_same_type(GlobalObject&, ArrayBuffer&, u32 byte_offset, u32 array_length) const = 0;
+
+protected:
+    TypedArrayBase(ArrayBuffer&, u32 byte_offset, u32 array_length, size_t element_size, Object& prototype);
+
+private:
+    virtual bool is_typed_array() const override final { return true; }
+    virtual bool has_write_barriers() const override { return true; }
+    virtual void visit_children(Visitor&) override;
+
+    ArrayBuffer* m_viewed_array_buffer { nullptr };
+    u32 m_byte_offset { 0 };
+    u32 m_array_length { 0 };
+    size_t m_element_size { 0 };
+};
+
+template<typename T>
+class TypedArray : public TypedArrayBase {
+    JS_OBJECT(TypedArray, TypedArrayBase);
+
+public:
+    T* data() { return reinterpret_cast<T*>(bytes()); }
+    const T* data() const { return reinterpret_cast<const T*>(bytes()); }
+
+    virtual Value get_by_index(u32 property_index) const override;
+    virtual bool put_by_index(u32 property_index, Value) override;
+
+    static Value element_to_value(T);
+    static T number_to_element(double);
+
+protected:
+    TypedArray(ArrayBuffer& buffer, u32 byte_offset, u32 array_length, Object& prototype)
+        : TypedArrayBase(buffer, byte_offset, array_length, sizeof(T), prototype)
+    {
+    }
+};
+
+template<typename T>
+inline Value TypedArray<T>::element_to_value(T element)
+{
+    if constexpr (IsSame<T, ClampedU8>::value)
+        return Value(static_cast<i32>(element.value));
+    else if constexpr (IsSame<T, u32>::value)
+        return Value(static_cast<unsigned>(element));
+    else if constexpr (IsSame<T, float>::value || IsSame<T, double>::value)
+        return Value(static_cast<double>(element));
+    else
+        return Value(static_cast<i32>(element));
+}
+
+template<typename T>
+inline T TypedArray<T>::number_to_element(double number)
+{
+    if constexpr (IsSame<T, ClampedU8>::value) {
+        if (__builtin_isnan(number) || number <= 0)
+            return { 0 };
+        if (number >= 255)
+            return { 255 };
+        // Halfway cases are rounded to the nearest even integer.
+        double floored = floor(number);
+        if (number - floored > 0.5 || (number - floored == 0.5 && static_cast<u8>(floored) % 2))
+            return { static_cast<u8>(floored + 1) };
+        return { static_cast<u8>(floored) };
+    } else if constexpr (IsSame<T, float>::value || IsSame<T, double>::value) {
+        return static_cast<T>(number);
+    } else {
+        // Integers wrap around modulo 2^32 like with ToInt32, and are then truncated to the element size.
+        if (!__builtin_isfinite(number))
+            return 0;
+        double modulo = fmod(trunc(number), 4294967296.0);
+        if (modulo < 0)
+            modulo += 4294967296.0;
+        return static_cast<T>(static_cast<u32>(modulo));
+    }
+}
+
+#define JS_DECLARE_TYPED_ARRAY(ClassName, snake_name, PrototypeName, ConstructorName, Type)                            \
+    class ClassName final : public TypedArray<Type> {                                                                  \
+        JS_OBJECT(ClassName, TypedArray);                                                                              \
+                                                                                                                       \
+    public:                                                                                                            \
+        static ClassName* create(GlobalObject&, u32 array_length);                                                    \
+        static ClassName* create(GlobalObject&, ArrayBuffer&, u32 byte_offset, u32 array_length);                     \
+                                                                                                                       \
+        ClassName(ArrayBuffer&, u32 byte_offset, u32 array_length, Object& prototype);                                \
+        virtual ~ClassName() override;                                                                                 \
+                                                                                                                       \
+        virtual TypedArrayBase* create_with_same_type(GlobalObject&, ArrayBuffer&, u32 byte_offset, u32 array_length) const override; \
+    };
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, Type) \
+    JS_DECLARE_TYPED_ARRAY(ClassName, snake_name, PrototypeName, ConstructorName, Type)
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NumericLimits.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/ArrayBuffer.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/TypedArray.h>
+#include <LibJS/Runtime/TypedArrayConstructor.h>
+
+namespace JS {
+
+template<typename ArrayType>
+static ArrayType* create_typed_array_with_length(Interpreter& interpreter, GlobalObject& global_object, size_t length, size_t element_size)
+{
+    if (length > NumericLimits<u32>::max() / element_size) {
+        interpreter.throw_exception<RangeError>(ErrorType::TypedArrayInvalidLength);
+        return nullptr;
+    }
+    return ArrayType::create(global_object, length);
+}
+
+template<typename ArrayType>
+static Value construct_typed_array(Interpreter& interpreter, GlobalObject& global_object, const char* class_name, size_t element_size)
+{
+    auto first_argument = interpreter.argument(0);
+    if (!first_argument.is_object()) {
+        auto length = first_argument.to_index(interpreter);
+        if (interpreter.exception())
+            return {};
+        return create_typed_array_with_length<ArrayType>(interpreter, global_object, length, element_size);
+    }
+
+    auto& object = first_argument.as_object();
+    if (object.is_array_buffer()) {
+        auto& buffer = static_cast<ArrayBuffer&>(object);
+        auto byte_offset = interpreter.argument(1).to_index(interpreter);
+        if (interpreter.exception())
+            return {};
+        if (byte_offset % element_size) {
+            interpreter.throw_exception<RangeError>(ErrorType::TypedArrayMisalignedOffset, class_name, static_cast<int>(element_size));
+            return {};
+        }
+        if (byte_offset > buffer.byte_length()) {
+            interpreter.throw_exception<RangeError>(ErrorType::TypedArrayOutOfBounds);
+            return {};
+        }
+        size_t length;
+        if (interpreter.argument(2).is_undefined()) {
+            if (buffer.byte_length() % element_size) {
+                interpreter.throw_exception<RangeError>(ErrorType::TypedArrayInvalidBufferLength, class_name, static_cast<int>(element_size));
+                return {};
+            }
+            length = (buffer.byte_length() - byte_offset) / element_size;
+        } else {
+            length = interpreter.argument(2).to_index(interpreter);
+            if (interpreter.exception())
+                return {};
+            if (length > (buffer.byte_length() - byte_offset) / element_size) {
+                interpreter.throw_exception<RangeError>(ErrorType::TypedArrayOutOfBounds);
+                return {};
+            }
+        }
+        return ArrayType::create(global_object, buffer, byte_offset, length);
+    }
+
+    // Anything else is copied element by element, converting to the element type as needed.
+    size_t length;
+    if (object.is_typed_array()) {
+        length = static_cast<TypedArrayBase&>(object).array_length();
+    } else {
+        length = object.get("length").value_or(js_undefined()).to_size_t(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+    auto* typed_array = create_typed_array_with_length<ArrayType>(interpreter, global_object, length, element_size);
+    if (!typed_array)
+        return {};
+    for (size_t i = 0; i < length; ++i) {
+        auto value = object.get(static_cast<i32>(i)).value_or(js_undefined());
+        if (interpreter.exception())
+            return {};
+        typed_array->put_by_index(i, value);
+        if (interpreter.exception())
+            return {};
+    }
+    return typed_array;
+}
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, Type)                             \
+    ConstructorName::ConstructorName(GlobalObject& global_object)                                               \
+        : NativeFunction(#ClassName, *global_object.function_prototype())                                       \
+    {                                                                                                           \
+    }                                                                                                           \
+    void ConstructorName::initialize(GlobalObject& global_object)                                               \
+    {                                                                                                           \
+        NativeFunction::initialize(global_object);                                                              \
+        define_property("prototype", global_object.snake_name##_prototype(), 0);                                \
+        define_property("length", Value(3), Attribute::Configurable);                                           \
+        define_property("BYTES_PER_ELEMENT", Value(static_cast<i32>(sizeof(Type))), 0);                         \
+    }                                                                                                           \
+    ConstructorName::~ConstructorName() { }                                                                     \
+    Value ConstructorName::call(Interpreter& interpreter)                                                       \
+    {                                                                                                           \
+        interpreter.throw_exception<TypeError>(ErrorType::ConstructorWithoutNew, #ClassName);                   \
+        return {};                                                                                              \
+    }                                                                                                           \
+    Value ConstructorName::construct(Interpreter& interpreter, Function&)                                       \
+    {                                                                                                           \
+        return construct_typed_array<ClassName>(interpreter, global_object(), #ClassName, sizeof(Type));        \
+    }
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
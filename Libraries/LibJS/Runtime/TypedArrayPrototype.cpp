@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StringBuilder.h>
+#include <AK/Vector.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/TypedArray.h>
+#include <LibJS/Runtime/TypedArrayPrototype.h>
+#include <math.h>
+#include <string.h>
+
+namespace JS {
+
+TypedArrayPrototype::TypedArrayPrototype(GlobalObject& global_object)
+    : Object(*global_object.object_prototype())
+{
+}
+
+void TypedArrayPrototype::initialize(GlobalObject& global_object)
+{
+    Object::initialize(global_object);
+    u8 attr = Attribute::Writable | Attribute::Configurable;
+    define_native_function("fill", fill, 1, attr);
+    define_native_function("indexOf", index_of, 1, attr);
+    define_native_function("join", join, 1, attr);
+    define_native_function("set", set, 1, attr);
+    define_native_function("slice", slice, 2, attr);
+    define_native_function("subarray", subarray, 2, attr);
+
+    define_native_property("buffer", buffer_getter, nullptr, Attribute::Configurable);
+    define_native_property("byteLength", byte_length_getter, nullptr, Attribute::Configurable);
+    define_native_property("byteOffset", byte_offset_getter, nullptr, Attribute::Configurable);
+    define_native_property("length", length_getter, nullptr, Attribute::Configurable);
+}
+
+TypedArrayPrototype::~TypedArrayPrototype()
+{
+}
+
+static TypedArrayBase* typed_array_from(Interpreter& interpreter, GlobalObject& global_object)
+{
+    auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
+    if (!this_object)
+        return nullptr;
+    if (!this_object->is_typed_array()) {
+        interpreter.throw_exception<TypeError>(ErrorType::NotA, "TypedArray");
+        return nullptr;
+    }
+    return static_cast<TypedArrayBase*>(this_object);
+}
+
+static size_t resolve_relative_index(Interpreter& interpreter, Value argument, size_t length, size_t default_index)
+{
+    if (argument.is_undefined())
+        return default_index;
+    auto number = argument.to_number(interpreter);
+    if (interpreter.exception() || number.is_nan())
+        return 0;
+    auto relative_index = trunc(number.as_double());
+    if (relative_index < 0)
+        return max(relative_index + length, 0.0);
+    return min(relative_index, static_cast<double>(length));
+}
+
+static bool have_same_element_type(const TypedArrayBase& a, const TypedArrayBase& b)
+{
+    return StringView(a.class_name()) == b.class_name();
+}
+
+JS_DEFINE_NATIVE_FUNCTION(TypedArrayPrototype::fill)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    auto value = interpreter.argument(0).to_number(interpreter);
+    if (interpreter.exception())
+        return {};
+    auto length = typed_array->array_length();
+    auto start = resolve_relative_index(interpreter, interpreter.argument(1), length, 0);
+    if (interpreter.exception())
+        return {};
+    auto end = resolve_relative_index(interpreter, interpreter.argument(2), length, length);
+    if (interpreter.exception())
+        return {};
+    if (start >= end)
+        return typed_array;
+
+    // Convert the value once, then replicate its bytes over the rest of the range.
+    typed_array->put_by_index(start, value);
+    auto element_size = typed_array->element_size();
+    auto* first_element = typed_array->bytes() + start * element_size;
+    for (size_t i = start + 1; i < end; ++i)
+        memcpy(typed_array->bytes() + i * element_size, first_element, element_size);
+    return typed_array;
+}
+
+JS_DEFINE_NATIVE_FUNCTION(TypedArrayPrototype::index_of)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    auto length = typed_array->array_length();
+    auto from_index = resolve_relative_index(interpreter, interpreter.argument(1), length, 0);
+    if (interpreter.exception())
+        return {};
+    auto search_element = interpreter.argument(0);
+    for (size_t i = from_index; i < length; ++i) {
+        if (strict_eq(interpreter, typed_array->get_by_index(i), search_element))
+            return Value(static_cast<unsigned>(i));
+    }
+    return Value(-1);
+}
+
+JS_DEFINE_NATIVE_FUNCTION(TypedArrayPrototype::join)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    String separator = ",";
+    if (!interpreter.argument(0).is_undefined()) {
+        separator = interpreter.argument(0).to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+    StringBuilder builder;
+    for (size_t i = 0; i < typed_array->array_length(); ++i) {
+        if (i > 0)
+            builder.append(separator);
+        auto string = typed_array->get_by_index(i).to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+        builder.append(string);
+    }
+    return js_string(interpreter, builder.to_string());
+}
+
+JS_DEFINE_NATIVE_FUNCTION(TypedArrayPrototype::set)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    auto* source = interpreter.argument(0).to_object(interpreter, global_object);
+    if (!source)
+        return {};
+    auto offset = interpreter.argument(1).to_index(interpreter);
+    if (interpreter.exception())
+        return {};
+
+    if (source->is_typed_array()) {
+        auto& source_array = static_cast<TypedArrayBase&>(*source);
+        if (offset > typed_array->array_length() || source_array.array_length() > typed_array->array_length() - offset)
+            return interpreter.throw_exception<RangeError>(ErrorType::TypedArrayOutOfBounds);
+        if (have_same_element_type(*typed_array, source_array)) {
+            memmove(typed_array->bytes() + offset * typed_array->element_size(), source_array.bytes(), source_array.byte_length());
+            return js_undefined();
+        }
+        // The arrays may view the same buffer, so read all of the source elements before writing any of them.
+        Vector<Value> values;
+        values.ensure_capacity(source_array.array_length());
+        for (size_t i = 0; i < source_array.array_length(); ++i)
+            values.unchecked_append(source_array.get_by_index(i));
+        for (size_t i = 0; i < values.size(); ++i)
+            typed_array->put_by_index(offset + i, values[i]);
+        return js_undefined();
+    }
+
+    auto length = source->get("length").value_or(js_undefined()).to_size_t(interpreter);
+    if (interpreter.exception())
+        return {};
+    if (offset > typed_array->array_length() || length > typed_array->array_length() - offset)
+        return interpreter.throw_exception<RangeError>(ErrorType::TypedArrayOutOfBounds);
+    for (size_t i = 0; i < length; ++i) {
+        auto value = source->get(static_cast<i32>(i)).value_or(js_undefined());
+        if (interpreter.exception())
+            return {};
+        typed_array->put_by_index(offset + i, value);
+        if (interpreter.exception())
+            return {};
+    }
+    return js_undefined();
+}
+
+JS_DEFINE_NATIVE_FUNCTION(TypedArrayPrototype::slice)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    auto length = typed_array->array_length();
+    auto start = resolve_relative_index(interpreter, interpreter.argument(0), length, 0);
+    if (interpreter.exception())
+        return {};
+    auto end = resolve_relative_index(interpreter, interpreter.argument(1), length, length);
+    if (interpreter.exception())
+        return {};
+    auto new_length = end > start ? end - start : 0;
+    auto element_size = typed_array->element_size();
+    auto* buffer = ArrayBuffer::create(global_object, ByteBuffer::copy(typed_array->bytes() + start * element_size, new_length * element_size));
+    return typed_array->create_with_same_type(global_object, *buffer, 0, new_length);
+}
+
+JS_DEFINE_NATIVE_FUNCTION(TypedArrayPrototype::subarray)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    auto length = typed_array->array_length();
+    auto start = resolve_relative_index(interpreter, interpreter.argument(0), length, 0);
+    if (interpreter.exception())
+        return {};
+    auto end = resolve_relative_index(interpreter, interpreter.argument(1), length, length);
+    if (interpreter.exception())
+        return {};
+    auto new_length = end > start ? end - start : 0;
+    auto byte_offset = typed_array->byte_offset() + start * typed_array->element_size();
+    return typed_array->create_with_same_type(global_object, typed_array->viewed_array_buffer(), byte_offset, new_length);
+}
+
+JS_DEFINE_NATIVE_GETTER(TypedArrayPrototype::buffer_getter)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    return &typed_array->viewed_array_buffer();
+}
+
+JS_DEFINE_NATIVE_GETTER(TypedArrayPrototype::byte_length_getter)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    return Value(typed_array->byte_length());
+}
+
+JS_DEFINE_NATIVE_GETTER(TypedArrayPrototype::byte_offset_getter)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    return Value(typed_array->byte_offset());
+}
+
+JS_DEFINE_NATIVE_GETTER(TypedArrayPrototype::length_getter)
+{
+    auto* typed_array = typed_array_from(interpreter, global_object);
+    if (!typed_array)
+        return {};
+    return Value(typed_array->array_length());
+}
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, Type)      \
+    PrototypeName::PrototypeName(GlobalObject& global_object)                            \
+        : Object(*global_object.typed_array_prototype())                                 \
+    {                                                                                    \
+    }                                                                                    \
+    void PrototypeName::initialize(GlobalObject& global_object)                          \
+    {                                                                                    \
+        Object::initialize(global_object);                                               \
+        define_property("BYTES_PER_ELEMENT", Value(static_cast<i32>(sizeof(Type))), 0); \
+    }                                                                                    \
+    PrototypeName::~PrototypeName() { }
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
@@ -26,6 +26,7 @@
  */
 
 #include <AK/FlyString.h>
+#include <AK/NumericLimits.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 #include <AK/Utf8View.h>
@@ -369,6 +370,24 @@ size_t Value::to_size_t(Interpreter& interpreter) const
     return number.as_size_t();
 }
 
+size_t Value::to_index(Interpreter& interpreter) const
+{
+    if (is_undefined())
+        return 0;
+    auto number = to_number(interpreter);
+    if (interpreter.exception())
+        return 0;
+    if (number.is_nan())
+        return 0;
+    auto integer = trunc(number.as_double());
+    // The spec allows indices up to 2^53 - 1, but nothing we index can be larger than a u32.
+    if (integer < 0 || integer > NumericLimits<u32>::max()) {
+        interpreter.throw_exception<RangeError>(ErrorType::InvalidIndex);
+        return 0;
+    }
+    return static_cast<size_t>(integer);
+}
+
 Value greater_than(Interpreter& interpreter, Value lhs, Value rhs)
 {
     TriState relation = abstract_relation(interpreter, false, lhs, rhs);
@@ -572,16 +591,13 @@ Value add(Interpreter& interpreter, Value lhs, Value rhs)
         return {};
 
     if (lhs_primitive.is_string() || rhs_primitive.is_string()) {
-        auto lhs_string = lhs_primitive.to_string(interpreter);
+        auto* lhs_string = lhs_primitive.to_primitive_string(interpreter);
         if (interpreter.exception())
             return {};
-        auto rhs_string = rhs_primitive.to_string(interpreter);
+        auto* rhs_string = rhs_primitive.to_primitive_string(interpreter);
         if (interpreter.exception())
             return {};
-        StringBuilder builder(lhs_string.length() + rhs_string.length());
-        builder.append(lhs_string);
-        builder.append(rhs_string);
-        return js_string(interpreter, builder.to_string());
+        return js_rope_string(interpreter.heap(), *lhs_string, *rhs_string);
     }
 
     auto lhs_numeric = lhs_primitive.to_numeric(interpreter);
@@ -250,6 +250,7 @@ public:
     double to_double(Interpreter&) const;
     i32 to_i32(Interpreter&) const;
     size_t to_size_t(Interpreter&) const;
+    size_t to_index(Interpreter&) const;
     bool to_boolean() const;
 
     String to_string_without_side_effects() const;
@@ -0,0 +1,88 @@
+test("int32 elements become doubles and then values", () => {
+    const array = [1, 2, 3];
+    array.push(4.5);
+    expect(array).toEqual([1, 2, 3, 4.5]);
+    array[1] = "two";
+    expect(array).toEqual([1, "two", 3, 4.5]);
+    array.unshift(0);
+    expect(array).toEqual([0, 1, "two", 3, 4.5]);
+});
+
+test("negative zero and NaN survive being stored", () => {
+    const array = [0, 1];
+    array[0] = -0;
+    expect(Object.is(array[0], -0)).toBeTrue();
+    array.push(NaN);
+    expect(array[2]).toBeNaN();
+    expect(array.indexOf(NaN)).toBe(-1);
+    expect(array.indexOf(0)).toBe(0);
+    expect([1, 2, 0].indexOf(-0)).toBe(2);
+});
+
+test("holes are not read from the unboxed elements", () => {
+    const array = [1, 2, 3];
+    delete array[1];
+    expect(1 in array).toBeFalse();
+    expect(array[1]).toBeUndefined();
+
+    const grown = [1, 2];
+    grown.length = 4;
+    expect(grown).toHaveLength(4);
+    expect(2 in grown).toBeFalse();
+    grown.length = 1;
+    expect(grown).toEqual([1]);
+
+    const sparse = [1];
+    sparse[3] = 4;
+    expect(sparse).toHaveLength(4);
+    expect(1 in sparse).toBeFalse();
+    expect(sparse[3]).toBe(4);
+});
+
+test("fast paths see changes the callback makes", () => {
+    const array = [1, 2, 3, 4];
+    const seen = [];
+    array.forEach((value, index) => {
+        seen.push(value);
+        if (index === 0) array[2] = "changed";
+        if (index === 1) array.pop();
+    });
+    expect(seen).toEqual([1, 2, "changed"]);
+
+    const mapped = [1, 2, 3].map(value => value * 1.5);
+    expect(mapped).toEqual([1.5, 3, 4.5]);
+    const sparseMapped = [1, , 3].map(value => value + 1);
+    expect(sparseMapped).toHaveLength(3);
+    expect(1 in sparseMapped).toBeFalse();
+    expect(sparseMapped[2]).toBe(4);
+});
+
+test("slice and indexOf on each element kind", () => {
+    const ints = [1, 2, 3, 4, 5];
+    const doubles = [0.5, 1.5, 2.5];
+    const values = ["a", "b", "c", "b"];
+    expect(ints.slice(1, 3)).toEqual([2, 3]);
+    expect(doubles.slice(-2)).toEqual([1.5, 2.5]);
+    expect(values.slice(2)).toEqual(["c", "b"]);
+    expect(ints.slice(3, 1)).toEqual([]);
+    expect(ints.indexOf(4)).toBe(3);
+    expect(ints.indexOf(4.5)).toBe(-1);
+    expect(ints.indexOf("4")).toBe(-1);
+    expect(ints.indexOf(1, 1)).toBe(-1);
+    expect(doubles.indexOf(2.5)).toBe(2);
+    expect(values.indexOf("b", 2)).toBe(3);
+});
+
+test("arrays outgrowing simple storage", () => {
+    const array = [];
+    for (let i = 0; i < 300; ++i) array.push(i);
+    expect(array).toHaveLength(300);
+    expect(array[299]).toBe(299);
+    expect(array.indexOf(250)).toBe(250);
+    expect(array.map(value => value * 2)[299]).toBe(598);
+
+    const grown = [1];
+    grown.length = 500;
+    expect(grown).toHaveLength(500);
+    expect(grown[0]).toBe(1);
+});
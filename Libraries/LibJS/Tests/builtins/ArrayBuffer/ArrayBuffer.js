@@ -0,0 +1,21 @@
+test("basic functionality", () => {
+    expect(ArrayBuffer).toHaveLength(1);
+    expect(new ArrayBuffer().byteLength).toBe(0);
+    expect(new ArrayBuffer(16).byteLength).toBe(16);
+    expect(new ArrayBuffer("8").byteLength).toBe(8);
+    expect(Object.getPrototypeOf(new ArrayBuffer(1))).toBe(ArrayBuffer.prototype);
+});
+
+test("invalid lengths", () => {
+    expect(() => new ArrayBuffer(-1)).toThrowWithMessage(RangeError, "Index must be a non-negative integer");
+    expect(() => ArrayBuffer(1)).toThrowWithMessage(TypeError, "ArrayBuffer constructor must be called with 'new'");
+});
+
+test("isView", () => {
+    const buffer = new ArrayBuffer(8);
+    expect(ArrayBuffer.isView(buffer)).toBeFalse();
+    expect(ArrayBuffer.isView(new Uint8Array(buffer))).toBeTrue();
+    expect(ArrayBuffer.isView(new DataView(buffer))).toBeTrue();
+    expect(ArrayBuffer.isView([])).toBeFalse();
+    expect(ArrayBuffer.isView(1)).toBeFalse();
+});
@@ -0,0 +1,18 @@
+test("basic functionality", () => {
+    const buffer = new ArrayBuffer(8);
+    new Uint8Array(buffer).set([1, 2, 3, 4, 5, 6, 7, 8]);
+
+    expect(new Uint8Array(buffer.slice()).join()).toBe("1,2,3,4,5,6,7,8");
+    expect(new Uint8Array(buffer.slice(2)).join()).toBe("3,4,5,6,7,8");
+    expect(new Uint8Array(buffer.slice(2, 4)).join()).toBe("3,4");
+    expect(new Uint8Array(buffer.slice(-3, -1)).join()).toBe("6,7");
+    expect(buffer.slice(5, 2).byteLength).toBe(0);
+    expect(buffer.slice(0, 100).byteLength).toBe(8);
+});
+
+test("slices are copies", () => {
+    const buffer = new ArrayBuffer(4);
+    const slice = buffer.slice();
+    new Uint8Array(slice)[0] = 42;
+    expect(new Uint8Array(buffer)[0]).toBe(0);
+});
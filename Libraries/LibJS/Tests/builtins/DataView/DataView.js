@@ -0,0 +1,42 @@
+test("basic functionality", () => {
+    const buffer = new ArrayBuffer(16);
+    const view = new DataView(buffer, 4, 8);
+    expect(DataView).toHaveLength(1);
+    expect(view.buffer).toBe(buffer);
+    expect(view.byteOffset).toBe(4);
+    expect(view.byteLength).toBe(8);
+    expect(new DataView(buffer, 4).byteLength).toBe(12);
+});
+
+test("endianness", () => {
+    const view = new DataView(new ArrayBuffer(8));
+    view.setUint16(0, 0x1234);
+    expect(view.getUint8(0)).toBe(0x12);
+    expect(view.getUint8(1)).toBe(0x34);
+    expect(view.getUint16(0, true)).toBe(0x3412);
+
+    view.setUint32(4, 0xdeadbeef, true);
+    expect(view.getUint8(4)).toBe(0xef);
+    expect(view.getUint32(4, true)).toBe(0xdeadbeef);
+    expect(view.getInt32(4, true)).toBe(-559038737);
+});
+
+test("floating point values", () => {
+    const view = new DataView(new ArrayBuffer(8));
+    view.setFloat64(0, Math.PI);
+    expect(view.getFloat64(0)).toBe(Math.PI);
+    view.setFloat32(0, 1.5, true);
+    expect(view.getFloat32(0, true)).toBe(1.5);
+    view.setInt8(0, -1);
+    expect(view.getUint8(0)).toBe(255);
+});
+
+test("errors", () => {
+    const buffer = new ArrayBuffer(4);
+    expect(() => new DataView({})).toThrowWithMessage(TypeError, "Not an ArrayBuffer object");
+    expect(() => new DataView(buffer, 5)).toThrowWithMessage(RangeError, "Offset or length is outside the bounds of the buffer");
+    expect(() => new DataView(buffer, 2, 3)).toThrowWithMessage(RangeError, "Offset or length is outside the bounds of the buffer");
+    expect(() => new DataView(buffer).getUint32(1)).toThrowWithMessage(RangeError, "Offset is outside the bounds of the DataView");
+    expect(() => new DataView(buffer).setFloat64(0, 1)).toThrowWithMessage(RangeError, "Offset is outside the bounds of the DataView");
+    expect(() => DataView.prototype.getInt8.call({}, 0)).toThrowWithMessage(TypeError, "Not a DataView object");
+});
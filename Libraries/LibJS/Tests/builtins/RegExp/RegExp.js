@@ -0,0 +1,37 @@
+test("basic functionality", () => {
+    expect(RegExp).toHaveLength(2);
+    expect(RegExp().toString()).toBe("/(?:)/");
+    expect(new RegExp("a+", "g").toString()).toBe("/a+/g");
+    expect(new RegExp(/b*/i).toString()).toBe("/b*/i");
+    expect(new RegExp(/b*/i, "m").toString()).toBe("/b*/m");
+    expect(typeof /x/).toBe("object");
+});
+
+test("invalid patterns and flags", () => {
+    expect(() => new RegExp("(")).toThrowWithMessage(SyntaxError, "Invalid regular expression /(/: Unterminated group");
+    expect(() => new RegExp("a**")).toThrowWithMessage(SyntaxError, "Nothing to repeat");
+    expect(() => new RegExp("[z-a]")).toThrowWithMessage(SyntaxError, "Range out of order");
+    expect(() => new RegExp("x", "gg")).toThrowWithMessage(SyntaxError, "Invalid regular expression flags 'gg'");
+    expect(() => new RegExp("x", "q")).toThrowWithMessage(SyntaxError, "Invalid regular expression flags 'q'");
+});
+
+test("unsupported features are rejected", () => {
+    expect(() => new RegExp("(a)\\1")).toThrowWithMessage(SyntaxError, "Backreferences are not supported");
+    expect(() => new RegExp("a(?=b)")).toThrowWithMessage(SyntaxError, "Lookaround assertions are not supported");
+});
+
+test("flag getters", () => {
+    const regexp = /a/gimsy;
+    expect(regexp.global).toBeTrue();
+    expect(regexp.ignoreCase).toBeTrue();
+    expect(regexp.multiline).toBeTrue();
+    expect(regexp.dotAll).toBeTrue();
+    expect(regexp.sticky).toBeTrue();
+    expect(regexp.unicode).toBeFalse();
+    expect(regexp.flags).toBe("gimsy");
+    expect(new RegExp("a", "yg").flags).toBe("gy");
+    expect(regexp.source).toBe("a");
+    expect(RegExp.prototype.source).toBe("(?:)");
+    expect(RegExp.prototype.global).toBeUndefined();
+    expect(regexp.lastIndex).toBe(0);
+});
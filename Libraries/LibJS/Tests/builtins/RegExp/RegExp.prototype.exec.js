@@ -0,0 +1,65 @@
+test("basic functionality", () => {
+    expect(RegExp.prototype.exec).toHaveLength(1);
+
+    const result = /(\d+)-(\d+)?/.exec("call 555- now");
+    expect(result).toHaveLength(3);
+    expect(result[0]).toBe("555-");
+    expect(result[1]).toBe("555");
+    expect(result[2]).toBeUndefined();
+    expect(result.index).toBe(5);
+    expect(result.input).toBe("call 555- now");
+
+    expect(/x/.exec("abc")).toBeNull();
+});
+
+test("greedy, lazy and alternation", () => {
+    expect(/a+/.exec("caaat")[0]).toBe("aaa");
+    expect(/a+?/.exec("caaat")[0]).toBe("a");
+    expect(/<.*>/.exec("<a><b>")[0]).toBe("<a><b>");
+    expect(/<.*?>/.exec("<a><b>")[0]).toBe("<a>");
+    expect(/(a|ab)(c|bcd)(d*)/.exec("abcd")).toEqual(["abcd", "a", "bcd", ""]);
+    expect(/a{2,3}/.exec("aaaa")[0]).toBe("aaa");
+    expect(/a{2,}?/.exec("aaaa")[0]).toBe("aa");
+    expect(/x{2}/.exec("x{2}xx").index).toBe(4);
+    expect(/a{/.exec("a{")[0]).toBe("a{");
+});
+
+test("classes, escapes and assertions", () => {
+    expect(/[^a-c]+/.exec("abcdef")[0]).toBe("def");
+    expect(/[\d.]+/.exec("v1.25b")[0]).toBe("1.25");
+    expect(/\w+@\w+\.com/.exec("mail bob@example.com")[0]).toBe("bob@example.com");
+    expect(/\bcat\b/.exec("concat cat").index).toBe(7);
+    expect(/\x41B/.exec("xAB")[0]).toBe("AB");
+    expect(/^b/.exec("a\nb")).toBeNull();
+    expect(/^b/m.exec("a\nb").index).toBe(2);
+    expect(/a$/m.exec("a\nb").index).toBe(0);
+    expect(/a.b/.exec("a\nb")).toBeNull();
+    expect(/a.b/s.exec("a\nb")[0]).toBe("a\nb");
+    expect(/HELLO/i.exec("say hello")[0]).toBe("hello");
+    expect(/[a-z]+/i.exec("ABC")[0]).toBe("ABC");
+});
+
+test("global and sticky expressions use lastIndex", () => {
+    const global = /o/g;
+    expect(global.exec("foo").index).toBe(1);
+    expect(global.lastIndex).toBe(2);
+    expect(global.exec("foo").index).toBe(2);
+    expect(global.exec("foo")).toBeNull();
+    expect(global.lastIndex).toBe(0);
+
+    const sticky = /o/y;
+    expect(sticky.exec("foo")).toBeNull();
+    sticky.lastIndex = 1;
+    expect(sticky.exec("foo").index).toBe(1);
+    expect(sticky.lastIndex).toBe(2);
+});
+
+test("patterns that would make a backtracker explode", () => {
+    const input = "a".repeat(5000);
+    expect(/(a*)*b/.exec(input)).toBeNull();
+    expect(/(a|aa)+$/.exec(input)[0]).toHaveLength(5000);
+});
+
+test("this has to be a regular expression", () => {
+    expect(() => RegExp.prototype.exec.call({}, "a")).toThrowWithMessage(TypeError, "Not a RegExp object");
+});
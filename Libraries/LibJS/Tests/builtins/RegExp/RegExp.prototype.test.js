@@ -0,0 +1,11 @@
+test("basic functionality", () => {
+    expect(RegExp.prototype.test).toHaveLength(1);
+    expect(/ab+c/.test("xabbbcx")).toBeTrue();
+    expect(/ab+c/.test("xacx")).toBeFalse();
+    expect(/^$/.test("")).toBeTrue();
+
+    const global = /a/g;
+    expect(global.test("aa")).toBeTrue();
+    expect(global.test("aa")).toBeTrue();
+    expect(global.test("aa")).toBeFalse();
+});
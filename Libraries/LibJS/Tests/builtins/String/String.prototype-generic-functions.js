@@ -16,6 +16,10 @@ test("basic functionality", () => {
         "substring",
         "includes",
         "slice",
+        "match",
+        "search",
+        "replace",
+        "split",
     ];
 
     genericStringPrototypeFunctions.forEach(name => {
@@ -0,0 +1,13 @@
+test("basic functionality", () => {
+    expect(String.prototype.match).toHaveLength(1);
+
+    const result = "2020-10-14".match(/(\d+)-(\d+)/);
+    expect(result[0]).toBe("2020-10");
+    expect(result[2]).toBe("10");
+    expect(result.index).toBe(0);
+
+    expect("a1b22c333".match(/\d+/g)).toEqual(["1", "22", "333"]);
+    expect("abc".match(/\d/g)).toBeNull();
+    expect("abc".match(/x*/g)).toEqual(["", "", "", ""]);
+    expect("a.c".match(".").index).toBe(0);
+});
@@ -0,0 +1,28 @@
+test("basic functionality", () => {
+    expect(String.prototype.replace).toHaveLength(2);
+
+    expect("aaa".replace("a", "b")).toBe("baa");
+    expect("aaa".replace(/a/, "b")).toBe("baa");
+    expect("aaa".replace(/a/g, "b")).toBe("bbb");
+    expect("abc".replace(/x*/g, "-")).toBe("-a-b-c-");
+    expect("abc".replace("x", "y")).toBe("abc");
+});
+
+test("replacement patterns", () => {
+    expect("John Smith".replace(/(\w+)\s(\w+)/, "$2, $1")).toBe("Smith, John");
+    expect("abc".replace("b", "[$&]")).toBe("a[b]c");
+    expect("abc".replace("b", "[$`|$']")).toBe("a[a|c]c");
+    expect("abc".replace("b", "$$")).toBe("a$c");
+    expect("abc".replace(/(b)/, "$2$1")).toBe("a$2bc");
+    expect("abc".replace(/(b)/, "$10")).toBe("ab0c");
+    expect("abc".replace(/(b)(x)?/, "[$2]")).toBe("a[]c");
+});
+
+test("replacement functions", () => {
+    const result = "a1b22".replace(/(\d)(\d)?/g, (match, first, second, offset, string) => {
+        expect(string).toBe("a1b22");
+        return `<${match}:${first}:${second}:${offset}>`;
+    });
+    expect(result).toBe("a<1:1:undefined:1>b<22:2:2:3>");
+    expect("abc".replace("b", () => 42)).toBe("a42c");
+});
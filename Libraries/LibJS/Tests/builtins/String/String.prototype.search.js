@@ -0,0 +1,11 @@
+test("basic functionality", () => {
+    expect(String.prototype.search).toHaveLength(1);
+    expect("hello friends".search(/fr\w+/)).toBe(6);
+    expect("hello friends".search(/enemies/)).toBe(-1);
+    expect("a+b".search("\\+")).toBe(1);
+
+    const global = /o/g;
+    global.lastIndex = 3;
+    expect("foo".search(global)).toBe(1);
+    expect(global.lastIndex).toBe(3);
+});
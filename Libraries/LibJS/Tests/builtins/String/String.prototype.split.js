@@ -0,0 +1,22 @@
+test("basic functionality", () => {
+    expect(String.prototype.split).toHaveLength(2);
+
+    expect("a,b,c".split(",")).toEqual(["a", "b", "c"]);
+    expect("a,b,c".split(",", 2)).toEqual(["a", "b"]);
+    expect("a,b,c".split()).toEqual(["a,b,c"]);
+    expect("a,b,c".split(",", 0)).toEqual([]);
+    expect("abc".split("")).toEqual(["a", "b", "c"]);
+    expect("".split("")).toEqual([]);
+    expect("".split(",")).toEqual([""]);
+    expect(",a,".split(",")).toEqual(["", "a", ""]);
+});
+
+test("regular expression separators", () => {
+    expect("a1b22c".split(/\d+/)).toEqual(["a", "b", "c"]);
+    expect("a1b2c".split(/(\d)/)).toEqual(["a", "1", "b", "2", "c"]);
+    expect("abc".split(/x*/)).toEqual(["a", "b", "c"]);
+    expect("".split(/x*/)).toEqual([]);
+    expect("".split(/x/)).toEqual([""]);
+    expect("a, b ,c".split(/\s*,\s*/)).toEqual(["a", "b", "c"]);
+    expect("a1b2c".split(/(\d)/, 2)).toEqual(["a", "1"]);
+});
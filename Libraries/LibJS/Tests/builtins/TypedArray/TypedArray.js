@@ -0,0 +1,93 @@
+const TYPED_ARRAYS = [
+    { array: Int8Array, bytes: 1 },
+    { array: Uint8Array, bytes: 1 },
+    { array: Uint8ClampedArray, bytes: 1 },
+    { array: Int16Array, bytes: 2 },
+    { array: Uint16Array, bytes: 2 },
+    { array: Int32Array, bytes: 4 },
+    { array: Uint32Array, bytes: 4 },
+    { array: Float32Array, bytes: 4 },
+    { array: Float64Array, bytes: 8 },
+];
+
+test("basic functionality", () => {
+    TYPED_ARRAYS.forEach(entry => {
+        const array = entry.array;
+        const bytes = entry.bytes;
+        expect(array).toHaveLength(3);
+        expect(array.BYTES_PER_ELEMENT).toBe(bytes);
+        expect(array.prototype.BYTES_PER_ELEMENT).toBe(bytes);
+
+        const typedArray = new array(4);
+        expect(typedArray).toHaveLength(4);
+        expect(typedArray.byteLength).toBe(4 * bytes);
+        expect(typedArray.byteOffset).toBe(0);
+        expect(typedArray.buffer.byteLength).toBe(4 * bytes);
+        expect(typedArray[0]).toBe(0);
+        expect(typedArray[4]).toBeUndefined();
+        expect(Object.getPrototypeOf(typedArray)).toBe(array.prototype);
+        expect(() => array(4)).toThrowWithMessage(TypeError, `${array.name} constructor must be called with 'new'`);
+    });
+});
+
+test("construction from arrays and other typed arrays", () => {
+    TYPED_ARRAYS.forEach(entry => {
+        const array = entry.array;
+        const typedArray = new array([1, 2, 3]);
+        expect(typedArray.join()).toBe("1,2,3");
+        const copy = new array(typedArray);
+        copy[0] = 10;
+        expect(copy.join()).toBe("10,2,3");
+        expect(typedArray[0]).toBe(1);
+    });
+    expect(new Uint8Array({ length: 2, 0: 7, 1: 8 }).join()).toBe("7,8");
+});
+
+test("views on a shared buffer", () => {
+    const buffer = new ArrayBuffer(8);
+    const bytes = new Uint8Array(buffer);
+    const words = new Uint32Array(buffer, 4, 1);
+    words[0] = 0x01020304;
+    expect(bytes.join()).toBe("0,0,0,0,4,3,2,1");
+    expect(words.byteOffset).toBe(4);
+    expect(words.buffer).toBe(buffer);
+    expect(new Uint16Array(buffer, 2)).toHaveLength(3);
+});
+
+test("invalid buffer views", () => {
+    const buffer = new ArrayBuffer(7);
+    expect(() => new Uint16Array(buffer, 1)).toThrowWithMessage(RangeError, "Start offset of Uint16Array must be a multiple of 2");
+    expect(() => new Uint16Array(buffer)).toThrowWithMessage(RangeError, "Length of the buffer of Uint16Array must be a multiple of 2");
+    expect(() => new Uint8Array(buffer, 8)).toThrowWithMessage(RangeError, "Offset or length is outside the bounds of the buffer");
+    expect(() => new Uint8Array(buffer, 4, 4)).toThrowWithMessage(RangeError, "Offset or length is outside the bounds of the buffer");
+    expect(() => new Float64Array(-1)).toThrowWithMessage(RangeError, "Index must be a non-negative integer");
+});
+
+test("element conversion", () => {
+    const int8 = new Int8Array([127, 128, -129, 1.9, -1.9, NaN, Infinity]);
+    expect(int8.join()).toBe("127,-128,127,1,-1,0,0");
+
+    const uint8 = new Uint8Array([256, -1, 300.5, "17"]);
+    expect(uint8.join()).toBe("0,255,44,17");
+
+    const clamped = new Uint8ClampedArray([300, -5, 1.5, 2.5, 0.5, 254.6, NaN]);
+    expect(clamped.join()).toBe("255,0,2,2,0,255,0");
+
+    const uint32 = new Uint32Array([-1, 4294967296]);
+    expect(uint32[0]).toBe(4294967295);
+    expect(uint32[1]).toBe(0);
+
+    const float32 = new Float32Array([0.1]);
+    expect(float32[0]).not.toBe(0.1);
+    expect(Math.abs(float32[0] - 0.1) < 0.000001).toBeTrue();
+});
+
+test("out of range accesses", () => {
+    const typedArray = new Uint8Array(2);
+    typedArray[5] = 1;
+    expect(typedArray[5]).toBeUndefined();
+    expect(typedArray).toHaveLength(2);
+    Uint8Array.prototype[3] = 42;
+    expect(typedArray[3]).toBeUndefined();
+    delete Uint8Array.prototype[3];
+});
@@ -0,0 +1,63 @@
+test("subarray shares the buffer", () => {
+    const typedArray = new Int16Array([1, 2, 3, 4, 5]);
+    const subarray = typedArray.subarray(1, -1);
+    expect(subarray.join()).toBe("2,3,4");
+    expect(subarray.buffer).toBe(typedArray.buffer);
+    expect(subarray.byteOffset).toBe(2);
+    subarray[0] = 20;
+    expect(typedArray[1]).toBe(20);
+    expect(typedArray.subarray(3, 1)).toHaveLength(0);
+});
+
+test("slice copies", () => {
+    const typedArray = new Float64Array([1, 2, 3, 4]);
+    const slice = typedArray.slice(1, 3);
+    expect(slice).toBeInstanceOf(Float64Array);
+    expect(slice.join()).toBe("2,3");
+    slice[0] = 10;
+    expect(typedArray[1]).toBe(2);
+    expect(typedArray.slice(-1).join()).toBe("4");
+});
+
+test("set", () => {
+    const typedArray = new Uint8Array(6);
+    typedArray.set([1, 2, 3]);
+    typedArray.set(new Float32Array([4.5, 5]), 3);
+    expect(typedArray.join()).toBe("1,2,3,4,5,0");
+
+    typedArray.set(typedArray.subarray(0, 3), 2);
+    expect(typedArray.join()).toBe("1,2,1,2,3,0");
+
+    const words = new Uint16Array(typedArray.buffer, 0, 3);
+    new Uint8Array(typedArray.buffer).set(words, 1);
+    expect(typedArray[1]).toBe(words[0] & 0xff);
+
+    expect(() => typedArray.set([1, 2], 5)).toThrowWithMessage(RangeError, "Offset or length is outside the bounds of the buffer");
+    expect(() => typedArray.set([1], -1)).toThrowWithMessage(RangeError, "Index must be a non-negative integer");
+});
+
+test("fill", () => {
+    const typedArray = new Int32Array(5);
+    expect(typedArray.fill(7)).toBe(typedArray);
+    expect(typedArray.join()).toBe("7,7,7,7,7");
+    typedArray.fill(-1, 1, 3);
+    expect(typedArray.join()).toBe("7,-1,-1,7,7");
+    typedArray.fill(0, -2);
+    expect(typedArray.join()).toBe("7,-1,-1,0,0");
+    expect(new Uint8ClampedArray(2).fill(1000).join()).toBe("255,255");
+});
+
+test("indexOf and join", () => {
+    const typedArray = new Uint8Array([5, 6, 7, 6]);
+    expect(typedArray.indexOf(6)).toBe(1);
+    expect(typedArray.indexOf(6, 2)).toBe(3);
+    expect(typedArray.indexOf(8)).toBe(-1);
+    expect(typedArray.indexOf("6")).toBe(-1);
+    expect(typedArray.join(" - ")).toBe("5 - 6 - 7 - 6");
+});
+
+test("methods reject other objects", () => {
+    const join = Object.getPrototypeOf(Uint8Array.prototype).join;
+    expect(() => join.call([1, 2])).toThrowWithMessage(TypeError, "Not a TypedArray object");
+    expect(() => Uint8Array.prototype.length).toThrowWithMessage(TypeError, "Not a TypedArray object");
+});
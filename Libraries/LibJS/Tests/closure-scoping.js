@@ -0,0 +1,71 @@
+test("closures see the bindings of enclosing scopes", () => {
+    let counter = 0;
+    const increment = () => ++counter;
+    increment();
+    increment();
+    expect(counter).toBe(2);
+
+    function makeAdder(a) {
+        return b => {
+            const sum = a + b;
+            return sum;
+        };
+    }
+    expect(makeAdder(1)(2)).toBe(3);
+    expect(makeAdder(10)(-4)).toBe(6);
+});
+
+test("inner bindings shadow outer ones", () => {
+    let x = 1;
+    const f = function (x) {
+        {
+            let x = 3;
+            expect(x).toBe(3);
+            x += 1;
+            expect(x).toBe(4);
+        }
+        return x;
+    };
+    expect(f(2)).toBe(2);
+    expect(x).toBe(1);
+});
+
+test("catch parameters and for loop bindings", () => {
+    let e = "outer";
+    try {
+        throw "inner";
+    } catch (e) {
+        expect(e).toBe("inner");
+        e = "changed";
+        expect(e).toBe("changed");
+    }
+    expect(e).toBe("outer");
+
+    let total = 0;
+    for (let i = 0; i < 5; ++i) {
+        const j = i * 2;
+        total += j;
+    }
+    expect(total).toBe(20);
+});
+
+test("assigning to a const through a closure", () => {
+    {
+        const value = 1;
+        const assign = () => {
+            value = 2;
+        };
+        expect(assign).toThrowWithMessage(TypeError, "Invalid assignment to const variable");
+        expect(value).toBe(1);
+    }
+});
+
+test("class declarations bind in the current environment", () => {
+    let A = 1;
+    const f = () => {
+        class A {}
+        return typeof A;
+    };
+    expect(f()).toBe("function");
+    expect(A).toBe(1);
+});
@@ -0,0 +1,99 @@
+// These have to behave the same whether or not function bodies are parsed lazily (test-js -L).
+
+test("bodies with tricky brackets", () => {
+    function templates(a) {
+        return `{${a + `}${"{"}`}}`;
+    }
+    expect(templates(1)).toBe("{1}{}");
+
+    function regexps() {
+        return [/\{/.test("{"), /[}]/.test("}"), /a{2}/.test("aa")];
+    }
+    expect(regexps()).toEqual([true, true, true]);
+
+    function objects() {
+        const o = { a: { b: [1, { c: "}" }] } };
+        return o.a.b[1].c + "{" + (() => ({}))();
+    }
+    expect(objects()).toBe("}{[object Object]");
+});
+
+test("bindings of enclosing functions and parameters", () => {
+    function outer(a, b = a + 1) {
+        var c = a + b;
+        function inner(d) {
+            return () => a + b + c + d;
+        }
+        return inner;
+    }
+    expect(outer(1)(10)()).toBe(16);
+    expect(outer(1, 5)(0)()).toBe(12);
+
+    let counter = 0;
+    const increment = function () {
+        return ++counter;
+    };
+    increment();
+    expect(increment()).toBe(2);
+    expect(counter).toBe(2);
+});
+
+test("hoisting inside of a function body", () => {
+    function f() {
+        return g() + x;
+        function g() {
+            return "g";
+        }
+        var x = "x";
+    }
+    expect(f()).toBe("gundefined");
+});
+
+test("class declarations and methods", () => {
+    function makeClass() {
+        class A {
+            constructor(value) {
+                this.value = value;
+            }
+            doubled() {
+                return this.value * 2;
+            }
+        }
+        class B extends A {
+            constructor() {
+                super(21);
+            }
+            method() {
+                return super.doubled();
+            }
+        }
+        return B;
+    }
+    expect(new (makeClass())().method()).toBe(42);
+    expect(makeClass()).not.toBe(makeClass());
+});
+
+test("strict mode", () => {
+    function sloppy() {
+        return isStrictMode();
+    }
+    function strict() {
+        "use strict";
+        return (function () {
+            return isStrictMode();
+        })();
+    }
+    expect(sloppy()).toBeFalse();
+    expect(strict()).toBeTrue();
+});
+
+test("function objects of the same function", () => {
+    const makeFunction = value =>
+        function () {
+            return value;
+        };
+    const functions = [makeFunction(0), makeFunction(1), makeFunction(2)];
+    expect(functions[2]()).toBe(2);
+    expect(functions[0]()).toBe(0);
+    expect(functions[1]).toHaveLength(0);
+});
@@ -0,0 +1,44 @@
+test("values stored into old objects survive young collections", () => {
+    const holder = { items: [] };
+    const closure = (() => {
+        let captured = null;
+        return {
+            set: value => (captured = value),
+            get: () => captured,
+        };
+    })();
+    gc();
+
+    for (let i = 0; i < 20000; ++i) {
+        const object = { index: i, name: "item" + i };
+        if (i % 100 === 0) {
+            holder.items.push(object);
+            holder["last"] = object;
+            closure.set([object]);
+        }
+    }
+
+    expect(holder.items).toHaveLength(200);
+    for (let i = 0; i < holder.items.length; ++i) {
+        expect(holder.items[i].index).toBe(i * 100);
+        expect(holder.items[i].name).toBe("item" + i * 100);
+    }
+    expect(holder.last.index).toBe(19900);
+    expect(closure.get()[0].name).toBe("item19900");
+});
+
+test("accessors installed on old objects", () => {
+    const object = {};
+    gc();
+
+    let values = [];
+    for (let i = 0; i < 20000; ++i) values.push({ i });
+    Object.defineProperty(object, "value", {
+        get: () => values[values.length - 1].i,
+        configurable: true,
+    });
+    values = values.slice(-1);
+    for (let i = 0; i < 20000; ++i) ({ i });
+
+    expect(object.value).toBe(19999);
+});
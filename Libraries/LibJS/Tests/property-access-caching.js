@@ -0,0 +1,87 @@
+test("cached lookups see later changes to the object", () => {
+    const get = o => o.foo;
+    const o = { foo: 1 };
+    expect(get(o)).toBe(1);
+    expect(get(o)).toBe(1);
+    o.foo = 2;
+    expect(get(o)).toBe(2);
+    delete o.foo;
+    expect(get(o)).toBeUndefined();
+    Object.defineProperty(o, "foo", { get: () => 3, configurable: true });
+    expect(get(o)).toBe(3);
+});
+
+test("cached lookups see later changes to the prototype chain", () => {
+    const get = o => o.bar;
+    const proto = { bar: "proto" };
+    const o = Object.setPrototypeOf({}, proto);
+    expect(get(o)).toBe("proto");
+    expect(get(o)).toBe("proto");
+    proto.bar = "changed";
+    expect(get(o)).toBe("changed");
+    o.bar = "own";
+    expect(get(o)).toBe("own");
+    delete o.bar;
+    expect(get(o)).toBe("changed");
+    Object.setPrototypeOf(o, { bar: "other" });
+    expect(get(o)).toBe("other");
+});
+
+test("lookups from one site across many shapes", () => {
+    const get = o => o.x;
+    const objects = [];
+    for (let i = 0; i < 10; ++i) {
+        const o = {};
+        o["p" + i] = i;
+        o.x = i;
+        objects.push(o);
+    }
+    for (let round = 0; round < 3; ++round) {
+        for (let i = 0; i < objects.length; ++i) expect(get(objects[i])).toBe(i);
+    }
+});
+
+test("cached stores respect setters and non-writable properties", () => {
+    const set = (o, value) => {
+        o.baz = value;
+    };
+    const o = { baz: 1 };
+    set(o, 2);
+    set(o, 3);
+    expect(o.baz).toBe(3);
+
+    Object.defineProperty(o, "baz", { value: 4, writable: false });
+    set(o, 5);
+    expect(o.baz).toBe(4);
+
+    let setterValue;
+    const p = Object.setPrototypeOf({}, {
+        set qux(value) {
+            setterValue = value;
+        },
+    });
+    const store = value => {
+        p.qux = value;
+    };
+    store(1);
+    store(2);
+    expect(setterValue).toBe(2);
+    expect(p.hasOwnProperty("qux")).toBeFalse();
+});
+
+test("cached method calls", () => {
+    class A {
+        value() {
+            return "A";
+        }
+    }
+    class B extends A {}
+    const call = o => o.value();
+    const b = new B();
+    expect(call(b)).toBe("A");
+    expect(call(b)).toBe("A");
+    B.prototype.value = () => "B";
+    expect(call(b)).toBe("B");
+    b.value = () => "own";
+    expect(call(b)).toBe("own");
+});
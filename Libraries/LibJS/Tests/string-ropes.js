@@ -0,0 +1,48 @@
+test("strings built in a loop", () => {
+    let s = "";
+    for (let i = 0; i < 10000; ++i) s += "ab";
+    expect(s).toHaveLength(20000);
+    expect(s.charAt(19999)).toBe("b");
+    expect(s.substring(0, 4)).toBe("abab");
+    expect(s === "ab".repeat(10000)).toBeTrue();
+});
+
+test("ropes made of ropes", () => {
+    let left = "";
+    let right = "";
+    for (let i = 0; i < 100; ++i) {
+        left = left + i + ",";
+        right = "," + i + right;
+    }
+    const both = left + "|" + right;
+    expect(both.startsWith("0,1,2,")).toBeTrue();
+    expect(both.indexOf("|")).toBe(left.length);
+    expect(both.length).toBe(left.length * 2 + 1);
+    expect(left + "|").toBe(left + "|");
+});
+
+test("ropes as property keys", () => {
+    let key = "";
+    for (let i = 0; i < 20; ++i) key += "key-";
+    const object = {};
+    object[key] = 1;
+    expect(object["key-".repeat(20)]).toBe(1);
+    expect(Object.keys(object)[0]).toBe(key);
+});
+
+test("template literals splice in long strings", () => {
+    let html = "";
+    for (let i = 0; i < 1000; ++i) html = `${html}<li>${i}</li>`;
+    expect(html.startsWith("<li>0</li><li>1</li>")).toBeTrue();
+    expect(html.substring(html.length - 12)).toBe("<li>999</li>");
+    expect(`${html}`).toBe(html);
+});
+
+test("deep ropes survive garbage collection", () => {
+    let s = "";
+    for (let i = 0; i < 50000; ++i) s += "x";
+    gc();
+    expect(s.length).toBe(50000);
+    gc();
+    expect(s.charAt(49999)).toBe("x");
+});
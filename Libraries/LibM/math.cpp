@@ -61,6 +61,9 @@ extern "C" {
 
 double trunc(double x) NOEXCEPT
 {
+    // Doubles this large have no fractional bits, and wouldn't fit into an int64_t anyway.
+    if (!(x > -4503599627370496.0 && x < 4503599627370496.0))
+        return x;
     return (int64_t)x;
 }
 
@@ -79,6 +79,7 @@ double floor(double) NOEXCEPT;
 float floorf(float) NOEXCEPT;
 double round(double) NOEXCEPT;
 float roundf(float) NOEXCEPT;
+double trunc(double) NOEXCEPT;
 double fabs(double) NOEXCEPT;
 float fabsf(float) NOEXCEPT;
 double fmod(double, double) NOEXCEPT;
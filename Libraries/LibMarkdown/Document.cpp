@@ -25,30 +25,37 @@
  */
 
 #include <AK/StringBuilder.h>
-#include <LibMarkdown/CodeBlock.h>
 #include <LibMarkdown/Document.h>
-#include <LibMarkdown/Heading.h>
-#include <LibMarkdown/List.h>
-#include <LibMarkdown/Paragraph.h>
+#include <LibMarkdown/Parser.h>
 
 namespace Markdown {
 
+StringView Document::html_prologue()
+{
+    return "<!DOCTYPE html>\n"
+           "<html>\n"
+           "<head></head>\n"
+           "<body>\n";
+}
+
+StringView Document::html_epilogue()
+{
+    return "</body>\n"
+           "</html>\n";
+}
+
 String Document::render_to_html() const
 {
     StringBuilder builder;
 
-    builder.append("<!DOCTYPE html>\n");
-    builder.append("<html>\n");
-    builder.append("<head></head>\n");
-    builder.append("<body>\n");
+    builder.append(html_prologue());
 
     for (auto& block : m_blocks) {
         auto s = block.render_to_html();
         builder.append(s);
     }
 
-    builder.append("</body>\n");
-    builder.append("</html>\n");
+    builder.append(html_epilogue());
     return builder.build();
 }
 
@@ -64,38 +71,15 @@ String Document::render_for_terminal() const
     return builder.build();
 }
 
-template<typename BlockType>
-static bool helper(Vector<StringView>::ConstIterator& lines, NonnullOwnPtrVector<Block>& blocks)
-{
-    OwnPtr<BlockType> block = BlockType::parse(lines);
-    if (!block)
-        return false;
-    blocks.append(block.release_nonnull());
-    return true;
-}
-
 OwnPtr<Document> Document::parse(const StringView& str)
 {
-    const Vector<StringView> lines_vec = str.lines();
-    auto lines = lines_vec.begin();
     auto document = make<Document>();
-    auto& blocks = document->m_blocks;
-
-    while (true) {
-        if (lines.is_end())
-            break;
-
-        if ((*lines).is_empty()) {
-            ++lines;
-            continue;
-        }
-
-        bool any = helper<List>(lines, blocks) || helper<Paragraph>(lines, blocks) || helper<CodeBlock>(lines, blocks) || helper<Heading>(lines, blocks);
-
-        if (!any)
-            return nullptr;
-    }
-
+    Parser parser;
+    parser.on_block = [&](auto block) {
+        document->m_blocks.append(move(block));
+    };
+    if (!parser.write(str) || !parser.finish())
+        return nullptr;
     return document;
 }
 
@@ -37,6 +37,10 @@ public:
     String render_to_html() const;
     String render_for_terminal() const;
 
+    // What render_to_html() puts around the blocks, for rendering one block at a time as a Parser hands them out.
+    static StringView html_prologue();
+    static StringView html_epilogue();
+
     static OwnPtr<Document> parse(const StringView&);
 
 private:
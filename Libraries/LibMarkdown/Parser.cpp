@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StringBuilder.h>
+#include <LibMarkdown/CodeBlock.h>
+#include <LibMarkdown/Heading.h>
+#include <LibMarkdown/List.h>
+#include <LibMarkdown/Paragraph.h>
+#include <LibMarkdown/Parser.h>
+
+namespace Markdown {
+
+template<typename BlockType>
+static bool helper(Vector<StringView>::ConstIterator& lines, OwnPtr<Block>& block)
+{
+    OwnPtr<BlockType> parsed_block = BlockType::parse(lines);
+    if (!parsed_block)
+        return false;
+    block = parsed_block.release_nonnull();
+    return true;
+}
+
+bool Parser::write(const StringView& input)
+{
+    if (input.is_empty())
+        return true;
+    StringBuilder builder(m_pending.length() + input.length());
+    builder.append(m_pending);
+    builder.append(input);
+    m_pending = builder.build();
+
+    if (m_pending.length() < m_retry_length)
+        return true;
+    return parse_blocks(false);
+}
+
+bool Parser::finish()
+{
+    return parse_blocks(true);
+}
+
+bool Parser::parse_blocks(bool at_end)
+{
+    StringView pending = m_pending;
+    size_t complete_length = pending.length();
+    if (!at_end) {
+        // The last line may not be complete yet.
+        auto last_newline = pending.find_last_of('\n');
+        if (!last_newline.has_value())
+            return true;
+        complete_length = last_newline.value() + 1;
+    }
+
+    auto complete_input = pending.substring_view(0, complete_length);
+    const Vector<StringView> lines_vec = complete_input.lines();
+    auto lines = lines_vec.begin();
+    auto offset_of_next_line = [&] {
+        if (lines.is_end())
+            return complete_length;
+        return (size_t)((*lines).characters_without_null_termination() - complete_input.characters_without_null_termination());
+    };
+
+    size_t consumed = 0;
+    bool holding_block = false;
+    while (!lines.is_end()) {
+        if ((*lines).is_empty()) {
+            ++lines;
+            consumed = offset_of_next_line();
+            continue;
+        }
+
+        OwnPtr<Block> block;
+        bool any = helper<List>(lines, block) || helper<Paragraph>(lines, block) || helper<CodeBlock>(lines, block) || helper<Heading>(lines, block);
+
+        // More input might still complete a block that we couldn't parse, or continue the one we did.
+        if (!at_end && (!any || lines.is_end())) {
+            holding_block = true;
+            break;
+        }
+        if (!any)
+            return false;
+
+        consumed = offset_of_next_line();
+        if (on_block)
+            on_block(block.release_nonnull());
+    }
+
+    if (consumed == pending.length())
+        m_pending = {};
+    else if (consumed)
+        m_pending = pending.substring_view(consumed, pending.length() - consumed);
+    m_retry_length = holding_block ? m_pending.length() * 2 : 0;
+    return true;
+}
+
+}
@@ -47,13 +47,13 @@ bool Client::is_supported_protocol(const String& protocol)
     return send_sync<Messages::ProtocolServer::IsSupportedProtocol>(protocol)->supported();
 }
 
-RefPtr<Download> Client::start_download(const String& url, const HashMap<String, String>& request_headers)
+RefPtr<Download> Client::start_download(const String& url, const HashMap<String, String>& request_headers, bool stream_data)
 {
     IPC::Dictionary header_dictionary;
     for (auto& it : request_headers)
         header_dictionary.add(it.key, it.value);
 
-    i32 download_id = send_sync<Messages::ProtocolServer::StartDownload>(url, header_dictionary)->download_id();
+    i32 download_id = send_sync<Messages::ProtocolServer::StartDownload>(url, header_dictionary, stream_data)->download_id();
     if (download_id < 0)
         return nullptr;
     auto download = Download::create_from_id({}, *this, download_id);
@@ -92,6 +92,22 @@ void Client::handle(const Messages::ProtocolClient::DownloadProgress& message)
     }
 }
 
+void Client::handle(const Messages::ProtocolClient::DownloadHeadersReceived& message)
+{
+    if (auto download = const_cast<Download*>(m_downloads.get(message.download_id()).value_or(nullptr))) {
+        download->did_receive_headers({}, message.status_code(), message.response_headers());
+    }
+}
+
+void Client::handle(const Messages::ProtocolClient::DownloadDataReceived& message)
+{
+    if (auto download = const_cast<Download*>(m_downloads.get(message.download_id()).value_or(nullptr))) {
+        download->did_receive_data({}, message.shbuf_id(), message.offset(), message.size());
+    }
+    // Let the server reuse that part of the buffer.
+    post_message(Messages::ProtocolServer::DownloadDataConsumed(message.download_id(), message.size()));
+}
+
 OwnPtr<Messages::ProtocolClient::CertificateRequestedResponse> Client::handle(const Messages::ProtocolClient::CertificateRequested& message)
 {
     if (auto download = const_cast<Download*>(m_downloads.get(message.download_id()).value_or(nullptr))) {
@@ -51,7 +51,16 @@ void Download::did_finish(Badge<Client>, bool success, Optional<u32> status_code
     if (success && shbuf_id != -1) {
         shared_buffer = SharedBuffer::create_from_shbuf_id(shbuf_id);
         payload = ByteBuffer::wrap(shared_buffer->data(), total_size);
+    } else if (success && !m_streamed_buffers.is_empty()) {
+        payload = ByteBuffer::create_uninitialized(m_streamed_size);
+        u8* payload_ptr = payload.data();
+        for (auto& buffer : m_streamed_buffers) {
+            memcpy(payload_ptr, buffer.data(), buffer.size());
+            payload_ptr += buffer.size();
+        }
     }
+    m_streamed_buffers.clear();
+    m_stream_ring = nullptr;
 
     // FIXME: It's a bit silly that we copy the response headers here just so we can move them into a HashMap with different traits.
     HashMap<String, String, CaseInsensitiveStringTraits> caseless_response_headers;
@@ -68,6 +77,37 @@ void Download::did_progress(Badge<Client>, Optional<u32> total_size, u32 downloa
         on_progress(total_size, downloaded_size);
 }
 
+void Download::did_receive_headers(Badge<Client>, Optional<u32> status_code, const IPC::Dictionary& response_headers)
+{
+    m_status_code = status_code;
+    response_headers.for_each_entry([&](auto& name, auto& value) {
+        m_response_headers.set(name, value);
+    });
+}
+
+void Download::did_receive_data(Badge<Client>, i32 shbuf_id, u32 offset, u32 size)
+{
+    if (!m_stream_ring || m_stream_ring->shbuf_id() != shbuf_id) {
+        m_stream_ring = SharedBuffer::create_from_shbuf_id(shbuf_id);
+        if (!m_stream_ring) {
+            dbg() << "Download: Failed to map the data stream buffer";
+            return;
+        }
+    }
+    if ((size_t)offset + size > (size_t)m_stream_ring->size()) {
+        dbg() << "Download: Received data outside of the data stream buffer";
+        return;
+    }
+
+    ReadonlyBytes data { (const u8*)m_stream_ring->data() + offset, size };
+    if (m_should_buffer_streamed_data) {
+        m_streamed_buffers.append(ByteBuffer::copy(data.data(), data.size()));
+        m_streamed_size += data.size();
+    }
+    if (on_data_received)
+        on_data_received(data);
+}
+
 void Download::did_request_certificates(Badge<Client>)
 {
     if (on_certificate_requested) {
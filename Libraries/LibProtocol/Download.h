@@ -29,8 +29,12 @@
 #include <AK/Badge.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Function.h>
+#include <AK/HashMap.h>
 #include <AK/RefCounted.h>
+#include <AK/SharedBuffer.h>
+#include <AK/Span.h>
 #include <AK/String.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <LibIPC/Forward.h>
 
@@ -57,14 +61,34 @@ public:
     Function<void(Optional<u32> total_size, u32 downloaded_size)> on_progress;
     Function<CertificateAndKey()> on_certificate_requested;
 
+    // This is only called if the download was started with stream_data set, see Client::start_download().
+    // The response headers and status code are known by the time it's called.
+    // The data lives in a buffer shared with ProtocolServer that gets reused once the callback returns,
+    // so anything that's needed later on has to be copied.
+    Function<void(ReadonlyBytes)> on_data_received;
+
+    // Streamed data also makes up the payload that on_finish receives, unless this is turned off.
+    void set_should_buffer_streamed_data(bool should_buffer_streamed_data) { m_should_buffer_streamed_data = should_buffer_streamed_data; }
+
+    const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers() const { return m_response_headers; }
+    Optional<u32> status_code() const { return m_status_code; }
+
     void did_finish(Badge<Client>, bool success, Optional<u32> status_code, u32 total_size, i32 shbuf_id, const IPC::Dictionary& response_headers);
     void did_progress(Badge<Client>, Optional<u32> total_size, u32 downloaded_size);
     void did_request_certificates(Badge<Client>);
+    void did_receive_headers(Badge<Client>, Optional<u32> status_code, const IPC::Dictionary& response_headers);
+    void did_receive_data(Badge<Client>, i32 shbuf_id, u32 offset, u32 size);
 
 private:
     explicit Download(Client&, i32 download_id);
     WeakPtr<Client> m_client;
     int m_download_id { -1 };
+    HashMap<String, String, CaseInsensitiveStringTraits> m_response_headers;
+    Optional<u32> m_status_code;
+    RefPtr<SharedBuffer> m_stream_ring;
+    Vector<ByteBuffer> m_streamed_buffers;
+    size_t m_streamed_size { 0 };
+    bool m_should_buffer_streamed_data { true };
 };
 
 }
@@ -28,12 +28,14 @@
 #include <AK/Atomic.h>
 #include <AK/StdLibExtras.h>
 #include <Kernel/API/Syscall.h>
+#include <errno.h>
 #include <limits.h>
 #include <pthread.h>
 #include <serenity.h>
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/internals.h>
 #include <sys/mman.h>
 #include <time.h>
 #include <unistd.h>
@@ -134,6 +136,7 @@ int pthread_create(pthread_t* thread, pthread_attr_t* attributes, void* (*start_
 
 void pthread_exit(void* value_ptr)
 {
+    __malloc_thread_exit();
     exit_thread(value_ptr);
 }
 
@@ -160,6 +163,7 @@ int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attrib
     mutex->owner = 0;
     mutex->level = 0;
     mutex->type = attributes ? attributes->type : PTHREAD_MUTEX_NORMAL;
+    mutex->protocol = attributes ? attributes->protocol : PTHREAD_PRIO_NONE;
     return 0;
 }
 
@@ -168,37 +172,103 @@ int pthread_mutex_destroy(pthread_mutex_t*)
     return 0;
 }
 
-int pthread_mutex_lock(pthread_mutex_t* mutex)
+// The lock word of a PTHREAD_PRIO_NONE mutex is one of these. Unlocking only
+// has to ask the kernel to wake someone up if it was contended.
+enum MutexState : u32 {
+    Unlocked = 0,
+    Locked = 1,
+    LockedWithWaiters = 2,
+};
+
+static constexpr int mutex_spin_count = 100;
+
+// With PTHREAD_PRIO_INHERIT, the lock word holds the owner's TID instead, which the
+// kernel needs to know whom to lend priority to; see FUTEX_LOCK_PI.
+static int lock_mutex_word(pthread_mutex_t* mutex, bool assume_waiters)
+{
+    auto& lock = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    if (mutex->protocol == PTHREAD_PRIO_INHERIT) {
+        u32 expected = 0;
+        if (lock.compare_exchange_strong(expected, gettid(), AK::memory_order_acquire))
+            return 0;
+        if (futex(reinterpret_cast<int32_t*>(&mutex->lock), FUTEX_LOCK_PI | FUTEX_PRIVATE_FLAG, 0, nullptr, nullptr, 0) < 0)
+            return errno;
+        return 0;
+    }
+
+    // A thread that may have been requeued over from a condition variable has to assume
+    // others were too, and that they need waking up once it unlocks.
+    u32 locked_state = assume_waiters ? MutexState::LockedWithWaiters : MutexState::Locked;
+    u32 expected = MutexState::Unlocked;
+    if (lock.compare_exchange_strong(expected, locked_state, AK::memory_order_acquire))
+        return 0;
+
+    // Critical sections tend to be short, so spin for a little while in the hope that
+    // the owner lets go before it's worth the system call. Once somebody is already
+    // asleep on it, there's no point in trying to jump the queue.
+    for (int i = 0; i < mutex_spin_count; ++i) {
+        u32 value = lock.load(AK::memory_order_relaxed);
+        if (value == MutexState::LockedWithWaiters)
+            break;
+        if (value == MutexState::Unlocked && lock.compare_exchange_strong(value, locked_state, AK::memory_order_acquire))
+            return 0;
+        __builtin_ia32_pause();
+    }
+
+    while (lock.exchange(MutexState::LockedWithWaiters, AK::memory_order_acquire) != MutexState::Unlocked)
+        futex(reinterpret_cast<int32_t*>(&mutex->lock), FUTEX_WAIT | FUTEX_PRIVATE_FLAG, MutexState::LockedWithWaiters, nullptr, nullptr, 0);
+    return 0;
+}
+
+static bool try_lock_mutex_word(pthread_mutex_t* mutex)
+{
+    auto& lock = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    u32 expected = 0;
+    u32 desired = mutex->protocol == PTHREAD_PRIO_INHERIT ? (u32)gettid() : MutexState::Locked;
+    return lock.compare_exchange_strong(expected, desired, AK::memory_order_acquire);
+}
+
+static void unlock_mutex_word(pthread_mutex_t* mutex)
+{
+    auto& lock = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    if (mutex->protocol == PTHREAD_PRIO_INHERIT) {
+        u32 expected = gettid();
+        if (!lock.compare_exchange_strong(expected, 0, AK::memory_order_release))
+            futex(reinterpret_cast<int32_t*>(&mutex->lock), FUTEX_UNLOCK_PI | FUTEX_PRIVATE_FLAG, 0, nullptr, nullptr, 0);
+        return;
+    }
+
+    if (lock.exchange(MutexState::Unlocked, AK::memory_order_release) == MutexState::LockedWithWaiters)
+        futex(reinterpret_cast<int32_t*>(&mutex->lock), FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, nullptr, nullptr, 0);
+}
+
+static int lock_mutex(pthread_mutex_t* mutex, bool assume_waiters)
 {
-    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
     pthread_t this_thread = pthread_self();
-    for (;;) {
-        u32 expected = false;
-        if (!atomic.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
-                mutex->level++;
-                return 0;
-            }
-            sched_yield();
-            continue;
-        }
-        mutex->owner = this_thread;
-        mutex->level = 0;
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
+        mutex->level++;
         return 0;
     }
+    if (int rc = lock_mutex_word(mutex, assume_waiters))
+        return rc;
+    mutex->owner = this_thread;
+    mutex->level = 0;
+    return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    return lock_mutex(mutex, false);
 }
 
 int pthread_mutex_trylock(pthread_mutex_t* mutex)
 {
-    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
-    u32 expected = false;
-    if (!atomic.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-        if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == pthread_self()) {
-            mutex->level++;
-            return 0;
-        }
-        return EBUSY;
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == pthread_self()) {
+        mutex->level++;
+        return 0;
     }
+    if (!try_lock_mutex_word(mutex))
+        return EBUSY;
     mutex->owner = pthread_self();
     mutex->level = 0;
     return 0;
@@ -211,13 +281,14 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex)
         return 0;
     }
     mutex->owner = 0;
-    mutex->lock = 0;
+    unlock_mutex_word(mutex);
     return 0;
 }
 
 int pthread_mutexattr_init(pthread_mutexattr_t* attr)
 {
     attr->type = PTHREAD_MUTEX_NORMAL;
+    attr->protocol = PTHREAD_PRIO_NONE;
     return 0;
 }
 
@@ -236,6 +307,24 @@ int pthread_mutexattr_settype(pthread_mutexattr_t* attr, int type)
     return 0;
 }
 
+int pthread_mutexattr_getprotocol(const pthread_mutexattr_t* attr, int* protocol)
+{
+    if (!attr || !protocol)
+        return EINVAL;
+    *protocol = attr->protocol;
+    return 0;
+}
+
+int pthread_mutexattr_setprotocol(pthread_mutexattr_t* attr, int protocol)
+{
+    if (!attr)
+        return EINVAL;
+    if (protocol != PTHREAD_PRIO_NONE && protocol != PTHREAD_PRIO_INHERIT)
+        return EINVAL;
+    attr->protocol = protocol;
+    return 0;
+}
+
 int pthread_attr_init(pthread_attr_t* attributes)
 {
     auto* impl = new PthreadAttrImpl {};
@@ -476,7 +565,7 @@ int pthread_setschedparam(pthread_t thread, int policy, const struct sched_param
 int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr)
 {
     cond->value = 0;
-    cond->previous = 0;
+    cond->mutex = nullptr;
     cond->clockid = attr ? attr->clockid : CLOCK_MONOTONIC;
     return 0;
 }
@@ -488,11 +577,19 @@ int pthread_cond_destroy(pthread_cond_t*)
 
 static int cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime)
 {
-    i32 value = cond->value;
-    cond->previous = value;
+    // Remember the mutex, so that pthread_cond_broadcast() can move the waiters over to it.
+    reinterpret_cast<Atomic<pthread_mutex_t*>&>(cond->mutex).store(mutex, AK::memory_order_relaxed);
+    i32 value = reinterpret_cast<Atomic<i32>&>(cond->value).load(AK::memory_order_acquire);
     pthread_mutex_unlock(mutex);
-    int rc = futex(&cond->value, FUTEX_WAIT, value, abstime);
-    pthread_mutex_lock(mutex);
+    // FIXME: Timeouts are taken as wall-clock deadlines regardless of cond->clockid.
+    int rc = futex(&cond->value, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME, value, abstime, nullptr, FUTEX_BITSET_MATCH_ANY);
+    if (rc < 0 && errno == EAGAIN) {
+        // We got signalled before we even went to sleep.
+        rc = 0;
+    }
+    int saved_errno = errno;
+    lock_mutex(mutex, true);
+    errno = saved_errno;
     return rc;
 }
 
@@ -527,19 +624,262 @@ int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const s
 
 int pthread_cond_signal(pthread_cond_t* cond)
 {
-    u32 value = cond->previous + 1;
-    cond->value = value;
-    int rc = futex(&cond->value, FUTEX_WAKE, 1, nullptr);
-    ASSERT(rc == 0);
+    reinterpret_cast<Atomic<i32>&>(cond->value).fetch_add(1, AK::memory_order_release);
+    int rc = futex(&cond->value, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, nullptr, nullptr, 0);
+    ASSERT(rc >= 0);
     return 0;
 }
 
 int pthread_cond_broadcast(pthread_cond_t* cond)
 {
-    u32 value = cond->previous + 1;
-    cond->value = value;
-    int rc = futex(&cond->value, FUTEX_WAKE, INT32_MAX, nullptr);
-    ASSERT(rc == 0);
+    auto& value = reinterpret_cast<Atomic<i32>&>(cond->value);
+    i32 new_value = value.fetch_add(1, AK::memory_order_release) + 1;
+    auto* mutex = reinterpret_cast<Atomic<pthread_mutex_t*>&>(cond->mutex).load(AK::memory_order_relaxed);
+
+    // The kernel has to hand PI mutexes over itself, so those waiters all get woken up.
+    if (!mutex || mutex->protocol == PTHREAD_PRIO_INHERIT) {
+        int rc = futex(&cond->value, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT32_MAX, nullptr, nullptr, 0);
+        ASSERT(rc >= 0);
+        return 0;
+    }
+
+    // Wake up one waiter and move the rest over to the mutex, so that they're woken up
+    // one at a time as it gets unlocked, rather than all fighting over it at once.
+    for (;;) {
+        int rc = futex(&cond->value, FUTEX_CMP_REQUEUE | FUTEX_PRIVATE_FLAG, 1, reinterpret_cast<const timespec*>(INT32_MAX), reinterpret_cast<int32_t*>(&mutex->lock), new_value);
+        if (rc >= 0)
+            return 0;
+        ASSERT(errno == EAGAIN);
+        // Someone else signalled in the meantime; they've bumped the value past ours.
+        new_value = value.load(AK::memory_order_acquire);
+    }
+}
+
+int pthread_spin_init(pthread_spinlock_t* lock, int)
+{
+    lock->lock = 0;
+    return 0;
+}
+
+int pthread_spin_destroy(pthread_spinlock_t* lock)
+{
+    if (lock->lock)
+        return EBUSY;
+    return 0;
+}
+
+int pthread_spin_lock(pthread_spinlock_t* lock)
+{
+    auto& word = reinterpret_cast<Atomic<u32>&>(lock->lock);
+    for (;;) {
+        if (!word.exchange(1, AK::memory_order_acquire))
+            return 0;
+        // Wait for it to look free before trying again, so that we're not bouncing
+        // the cache line between processors with every attempt.
+        while (word.load(AK::memory_order_relaxed))
+            __builtin_ia32_pause();
+    }
+}
+
+int pthread_spin_trylock(pthread_spinlock_t* lock)
+{
+    auto& word = reinterpret_cast<Atomic<u32>&>(lock->lock);
+    if (word.exchange(1, AK::memory_order_acquire))
+        return EBUSY;
+    return 0;
+}
+
+int pthread_spin_unlock(pthread_spinlock_t* lock)
+{
+    reinterpret_cast<Atomic<u32>&>(lock->lock).store(0, AK::memory_order_release);
+    return 0;
+}
+
+// The state word of a rwlock holds the number of readers in its low bits, along with
+// whether a writer holds it and whether anyone is asleep waiting for it. Readers and
+// writers sleep on the same word, telling each other apart with their futex bitsets.
+// Waiting writers keep new readers out, so that a steady stream of them can't starve
+// a writer forever.
+enum RWLockState : u32 {
+    WriteLocked = 1u << 31,
+    WritersWaiting = 1u << 30,
+    ReadersWaiting = 1u << 29,
+    ReaderCountMask = ReadersWaiting - 1,
+};
+
+static constexpr u32 rwlock_reader_bitset = 1;
+static constexpr u32 rwlock_writer_bitset = 2;
+
+static int rwlock_wait(pthread_rwlock_t* rwlock, u32 expected_state, u32 bitset, const struct timespec* abstime)
+{
+    int rc = futex(reinterpret_cast<int32_t*>(&rwlock->state), FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME, expected_state, abstime, nullptr, bitset);
+    if (rc < 0 && errno == ETIMEDOUT)
+        return ETIMEDOUT;
+    return 0;
+}
+
+static int rwlock_rdlock(pthread_rwlock_t* rwlock, bool blocking, const struct timespec* abstime)
+{
+    auto& state = reinterpret_cast<Atomic<u32>&>(rwlock->state);
+    u32 value = state.load(AK::memory_order_relaxed);
+    for (;;) {
+        if (!(value & (RWLockState::WriteLocked | RWLockState::WritersWaiting))) {
+            if ((value & RWLockState::ReaderCountMask) == RWLockState::ReaderCountMask)
+                return EAGAIN;
+            if (state.compare_exchange_strong(value, value + 1, AK::memory_order_acquire))
+                return 0;
+            continue;
+        }
+        if (!blocking)
+            return EBUSY;
+        if (!(value & RWLockState::ReadersWaiting)) {
+            if (!state.compare_exchange_strong(value, value | RWLockState::ReadersWaiting, AK::memory_order_relaxed))
+                continue;
+            value |= RWLockState::ReadersWaiting;
+        }
+        if (int rc = rwlock_wait(rwlock, value, rwlock_reader_bitset, abstime))
+            return rc;
+        value = state.load(AK::memory_order_relaxed);
+    }
+}
+
+static int rwlock_wrlock(pthread_rwlock_t* rwlock, bool blocking, const struct timespec* abstime)
+{
+    auto& state = reinterpret_cast<Atomic<u32>&>(rwlock->state);
+    u32 value = state.load(AK::memory_order_relaxed);
+    // Whoever wakes us up clears WritersWaiting, so once we've slept we can't tell whether
+    // other writers are still waiting and have to keep assuming that they are.
+    bool has_slept = false;
+    for (;;) {
+        if (!(value & (RWLockState::WriteLocked | RWLockState::ReaderCountMask))) {
+            u32 desired = value | RWLockState::WriteLocked;
+            if (has_slept)
+                desired |= RWLockState::WritersWaiting;
+            if (state.compare_exchange_strong(value, desired, AK::memory_order_acquire)) {
+                rwlock->writer = pthread_self();
+                return 0;
+            }
+            continue;
+        }
+        if (!blocking)
+            return EBUSY;
+        if (!(value & RWLockState::WritersWaiting)) {
+            if (!state.compare_exchange_strong(value, value | RWLockState::WritersWaiting, AK::memory_order_relaxed))
+                continue;
+            value |= RWLockState::WritersWaiting;
+        }
+        if (int rc = rwlock_wait(rwlock, value, rwlock_writer_bitset, abstime))
+            return rc;
+        has_slept = true;
+        value = state.load(AK::memory_order_relaxed);
+    }
+}
+
+int pthread_rwlock_init(pthread_rwlock_t* rwlock, const pthread_rwlockattr_t*)
+{
+    rwlock->state = 0;
+    rwlock->writer = 0;
+    return 0;
+}
+
+int pthread_rwlock_destroy(pthread_rwlock_t* rwlock)
+{
+    if (rwlock->state & (RWLockState::WriteLocked | RWLockState::ReaderCountMask))
+        return EBUSY;
+    return 0;
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock)
+{
+    return rwlock_rdlock(rwlock, true, nullptr);
+}
+
+int pthread_rwlock_tryrdlock(pthread_rwlock_t* rwlock)
+{
+    return rwlock_rdlock(rwlock, false, nullptr);
+}
+
+int pthread_rwlock_timedrdlock(pthread_rwlock_t* rwlock, const struct timespec* abstime)
+{
+    return rwlock_rdlock(rwlock, true, abstime);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock)
+{
+    if (rwlock->writer == pthread_self() && (rwlock->state & RWLockState::WriteLocked))
+        return EDEADLK;
+    return rwlock_wrlock(rwlock, true, nullptr);
+}
+
+int pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock)
+{
+    return rwlock_wrlock(rwlock, false, nullptr);
+}
+
+int pthread_rwlock_timedwrlock(pthread_rwlock_t* rwlock, const struct timespec* abstime)
+{
+    if (rwlock->writer == pthread_self() && (rwlock->state & RWLockState::WriteLocked))
+        return EDEADLK;
+    return rwlock_wrlock(rwlock, true, abstime);
+}
+
+int pthread_rwlock_unlock(pthread_rwlock_t* rwlock)
+{
+    auto& state = reinterpret_cast<Atomic<u32>&>(rwlock->state);
+    u32 value = state.load(AK::memory_order_relaxed);
+    if (value & RWLockState::WriteLocked) {
+        if (rwlock->writer != pthread_self())
+            return EPERM;
+        rwlock->writer = 0;
+    } else if (!(value & RWLockState::ReaderCountMask)) {
+        return EPERM;
+    }
+
+    // Whoever lets go last hands the lock over: to a writer if there is one,
+    // otherwise to all the readers at once.
+    u32 new_value;
+    bool is_last;
+    for (;;) {
+        new_value = (value & RWLockState::WriteLocked) ? (value & ~RWLockState::WriteLocked) : value - 1;
+        is_last = !(new_value & RWLockState::ReaderCountMask);
+        if (is_last) {
+            if (new_value & RWLockState::WritersWaiting)
+                new_value &= ~RWLockState::WritersWaiting;
+            else
+                new_value &= ~RWLockState::ReadersWaiting;
+        }
+        if (state.compare_exchange_strong(value, new_value, AK::memory_order_release))
+            break;
+    }
+    if (!is_last)
+        return 0;
+
+    if (value & RWLockState::WritersWaiting) {
+        int woken = futex(reinterpret_cast<int32_t*>(&rwlock->state), FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, 1, nullptr, nullptr, rwlock_writer_bitset);
+        if (woken > 0)
+            return 0;
+        // The writers we thought were waiting had already given up (or were never
+        // asleep to begin with), so let the readers in instead.
+        value = state.load(AK::memory_order_relaxed);
+        do {
+            if (!(value & RWLockState::ReadersWaiting))
+                return 0;
+        } while (!state.compare_exchange_strong(value, value & ~RWLockState::ReadersWaiting, AK::memory_order_relaxed));
+    } else if (!(value & RWLockState::ReadersWaiting)) {
+        return 0;
+    }
+    futex(reinterpret_cast<int32_t*>(&rwlock->state), FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, INT32_MAX, nullptr, nullptr, rwlock_reader_bitset);
+    return 0;
+}
+
+int pthread_rwlockattr_init(pthread_rwlockattr_t* attr)
+{
+    *attr = nullptr;
+    return 0;
+}
+
+int pthread_rwlockattr_destroy(pthread_rwlockattr_t*)
+{
     return 0;
 }
 
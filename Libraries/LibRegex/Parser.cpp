@@ -0,0 +1,594 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibRegex/Parser.h>
+
+namespace Regex {
+
+// Counted repetition copies its atom, so this also bounds how big {n,m} can make a program.
+static const size_t max_program_size = 65536;
+
+static bool is_ascii_digit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+static int hex_digit_value(char ch)
+{
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+Parser::Parser(const StringView& pattern, Pattern& compiled_pattern)
+    : m_input(pattern)
+    , m_pattern(compiled_pattern)
+{
+}
+
+void Parser::set_error(const String& error)
+{
+    if (!has_error())
+        m_error = error;
+}
+
+bool Parser::consume_specific(char ch)
+{
+    if (at_end() || peek() != ch)
+        return false;
+    ++m_position;
+    return true;
+}
+
+void Parser::append_fragment(Fragment& fragment, const Fragment& other)
+{
+    fragment.append(other.data(), other.size());
+}
+
+bool Parser::compile()
+{
+    auto body = parse_disjunction();
+    if (!has_error() && !at_end())
+        set_error("Unmatched ')'");
+    if (has_error())
+        return false;
+
+    auto& program = m_pattern.m_program;
+    program.ensure_capacity(body.size() + 3);
+    program.append({ OpCode::Save, 0, 0 });
+    append_fragment(program, body);
+    program.append({ OpCode::Save, 0, 1 });
+    program.append({ OpCode::Match });
+    if (program.size() > max_program_size) {
+        set_error("Regular expression too large");
+        return false;
+    }
+
+    if (!m_pattern.m_options.ignore_case && program[1].op == OpCode::Character)
+        m_pattern.m_first_byte = program[1].character;
+    return true;
+}
+
+Parser::Fragment Parser::parse_disjunction()
+{
+    Vector<Fragment> alternatives;
+    alternatives.append(parse_alternative());
+    while (!has_error() && consume_specific('|'))
+        alternatives.append(parse_alternative());
+    if (has_error())
+        return {};
+    if (alternatives.size() == 1)
+        return alternatives.take_first();
+
+    // Every alternative but the last is tried first by a split, and jumps past the rest once it matched.
+    size_t total_size = 0;
+    for (auto& alternative : alternatives)
+        total_size += alternative.size() + 2;
+    total_size -= 2;
+    if (total_size > max_program_size) {
+        set_error("Regular expression too large");
+        return {};
+    }
+
+    Fragment fragment;
+    fragment.ensure_capacity(total_size);
+    for (size_t i = 0; i < alternatives.size(); ++i) {
+        auto& alternative = alternatives[i];
+        if (i == alternatives.size() - 1) {
+            append_fragment(fragment, alternative);
+            break;
+        }
+        fragment.append({ OpCode::Split, 0, 1, (i32)alternative.size() + 2 });
+        append_fragment(fragment, alternative);
+        fragment.append({ OpCode::Jump, 0, (i32)(total_size - fragment.size()) });
+    }
+    return fragment;
+}
+
+Parser::Fragment Parser::parse_alternative()
+{
+    Fragment fragment;
+    while (!at_end() && peek() != '|' && peek() != ')') {
+        if (!parse_term(fragment))
+            return {};
+    }
+    return fragment;
+}
+
+Optional<u32> Parser::parse_decimal()
+{
+    if (!is_ascii_digit(peek()))
+        return {};
+    u32 value = 0;
+    while (is_ascii_digit(peek())) {
+        // Anything this big can't fit in a program anyway, so there's no need to be precise.
+        value = min<u32>(value * 10 + (consume() - '0'), max_program_size + 1);
+    }
+    return value;
+}
+
+bool Parser::parse_term(Fragment& fragment)
+{
+    bool is_assertion = false;
+    auto atom = parse_atom(is_assertion);
+    if (!atom.has_value())
+        return false;
+
+    bool has_quantifier = true;
+    u32 min = 0;
+    Optional<u32> max;
+    if (consume_specific('*')) {
+        min = 0;
+    } else if (consume_specific('+')) {
+        min = 1;
+    } else if (consume_specific('?')) {
+        min = 0;
+        max = 1;
+    } else if (peek() == '{') {
+        // A brace that doesn't start a well-formed quantifier is just a brace.
+        auto saved_position = m_position;
+        ++m_position;
+        has_quantifier = false;
+        if (auto lower_bound = parse_decimal(); lower_bound.has_value()) {
+            min = lower_bound.value();
+            if (consume_specific('}')) {
+                max = min;
+                has_quantifier = true;
+            } else if (consume_specific(',')) {
+                auto upper_bound = parse_decimal();
+                if (consume_specific('}')) {
+                    max = upper_bound;
+                    has_quantifier = true;
+                }
+            }
+        }
+        if (!has_quantifier)
+            m_position = saved_position;
+    } else {
+        has_quantifier = false;
+    }
+
+    if (has_quantifier) {
+        if (is_assertion) {
+            set_error("Nothing to repeat");
+            return false;
+        }
+        bool greedy = !consume_specific('?');
+        if (max.has_value() && max.value() < min) {
+            set_error("Numbers out of order in {} quantifier");
+            return false;
+        }
+        apply_quantifier(atom.value(), min, max, greedy);
+        if (has_error())
+            return false;
+    }
+
+    append_fragment(fragment, atom.value());
+    if (fragment.size() > max_program_size) {
+        set_error("Regular expression too large");
+        return false;
+    }
+    return true;
+}
+
+void Parser::apply_quantifier(Fragment& atom, u32 min, Optional<u32> max, bool greedy)
+{
+    auto size = atom.size();
+    auto repetitions = max.has_value() ? max.value() : min + 1;
+    if ((u64)repetitions * (size + 2) > max_program_size) {
+        set_error("Regular expression too large");
+        return;
+    }
+
+    Fragment fragment;
+    for (u32 i = 0; i < min; ++i)
+        append_fragment(fragment, atom);
+
+    if (!max.has_value()) {
+        if (min > 0) {
+            // Loop back into the last copy.
+            if (greedy)
+                fragment.append({ OpCode::Split, 0, -(i32)size, 1 });
+            else
+                fragment.append({ OpCode::Split, 0, 1, -(i32)size });
+        } else {
+            if (greedy)
+                fragment.append({ OpCode::Split, 0, 1, (i32)size + 2 });
+            else
+                fragment.append({ OpCode::Split, 0, (i32)size + 2, 1 });
+            append_fragment(fragment, atom);
+            fragment.append({ OpCode::Jump, 0, -(i32)size - 1 });
+        }
+    } else {
+        for (u32 i = min; i < max.value(); ++i) {
+            if (greedy)
+                fragment.append({ OpCode::Split, 0, 1, (i32)size + 1 });
+            else
+                fragment.append({ OpCode::Split, 0, (i32)size + 1, 1 });
+            append_fragment(fragment, atom);
+        }
+    }
+
+    atom = move(fragment);
+}
+
+Optional<Parser::Fragment> Parser::parse_atom(bool& is_assertion)
+{
+    switch (peek()) {
+    case '^':
+        consume();
+        is_assertion = true;
+        return Fragment { { OpCode::AssertStart } };
+    case '$':
+        consume();
+        is_assertion = true;
+        return Fragment { { OpCode::AssertEnd } };
+    case '.':
+        consume();
+        return Fragment { { m_pattern.m_options.dot_all ? OpCode::AnyCharacter : OpCode::AnyCharacterExceptNewline } };
+    case '(':
+        return parse_group();
+    case '[':
+        return parse_character_class();
+    case '\\':
+        consume();
+        return parse_atom_escape(is_assertion);
+    case '*':
+    case '+':
+    case '?':
+        set_error("Nothing to repeat");
+        return {};
+    default:
+        break;
+    }
+
+    // Multi-byte UTF-8 sequences are a single character as far as quantifiers are concerned.
+    Fragment fragment;
+    u8 lead_byte = consume();
+    fragment.append({ OpCode::Character, lead_byte });
+    if (lead_byte >= 0xc0) {
+        while (!at_end() && ((u8)peek() & 0xc0) == 0x80)
+            fragment.append({ OpCode::Character, (u8)consume() });
+    }
+    return fragment;
+}
+
+Optional<Parser::Fragment> Parser::parse_group()
+{
+    consume();
+
+    bool is_capturing = true;
+    if (consume_specific('?')) {
+        if (consume_specific(':')) {
+            is_capturing = false;
+        } else if (peek() == '=' || peek() == '!' || (peek() == '<' && (peek(1) == '=' || peek(1) == '!'))) {
+            set_error("Lookaround assertions are not supported");
+            return {};
+        } else if (consume_specific('<')) {
+            // Named groups are numbered like any other group; the names aren't kept.
+            auto name_start = m_position;
+            while (!at_end() && peek() != '>')
+                consume();
+            if (m_position == name_start || !consume_specific('>')) {
+                set_error("Invalid capture group name");
+                return {};
+            }
+        } else {
+            set_error("Invalid group");
+            return {};
+        }
+    }
+
+    size_t group_index = is_capturing ? ++m_pattern.m_group_count : 0;
+    auto body = parse_disjunction();
+    if (has_error())
+        return {};
+    if (!consume_specific(')')) {
+        set_error("Unterminated group");
+        return {};
+    }
+    if (!is_capturing)
+        return body;
+
+    Fragment fragment;
+    fragment.ensure_capacity(body.size() + 2);
+    fragment.append({ OpCode::Save, 0, (i32)group_index * 2 });
+    append_fragment(fragment, body);
+    fragment.append({ OpCode::Save, 0, (i32)group_index * 2 + 1 });
+    return fragment;
+}
+
+Optional<Parser::Fragment> Parser::parse_atom_escape(bool& is_assertion)
+{
+    if (at_end()) {
+        set_error("\\ at end of pattern");
+        return {};
+    }
+
+    char ch = peek();
+    if (ch == 'b' || ch == 'B') {
+        consume();
+        is_assertion = true;
+        return Fragment { { ch == 'b' ? OpCode::AssertWordBoundary : OpCode::AssertNotWordBoundary } };
+    }
+    if ((ch >= '1' && ch <= '9') || ch == 'k') {
+        set_error("Backreferences are not supported");
+        return {};
+    }
+
+    CharacterClass character_class;
+    if (parse_class_escape(ch, character_class)) {
+        consume();
+        return class_fragment(character_class);
+    }
+
+    u32 code_point;
+    if (!parse_character_escape(code_point))
+        return {};
+    return code_point_fragment(code_point);
+}
+
+bool Parser::parse_class_escape(char ch, CharacterClass& character_class)
+{
+    CharacterClass escape_class;
+    switch (ch) {
+    case 'd':
+    case 'D':
+        escape_class.add_range('0', '9');
+        break;
+    case 'w':
+    case 'W':
+        escape_class.add_range('a', 'z');
+        escape_class.add_range('A', 'Z');
+        escape_class.add_range('0', '9');
+        escape_class.add('_');
+        break;
+    case 's':
+    case 'S':
+        escape_class.add(' ');
+        escape_class.add_range('\t', '\r');
+        break;
+    default:
+        return false;
+    }
+    if (ch == 'D' || ch == 'W' || ch == 'S')
+        escape_class.invert();
+    character_class.add_class(escape_class);
+    return true;
+}
+
+bool Parser::parse_character_escape(u32& code_point)
+{
+    char ch = consume();
+    switch (ch) {
+    case 'n':
+        code_point = '\n';
+        return true;
+    case 'r':
+        code_point = '\r';
+        return true;
+    case 't':
+        code_point = '\t';
+        return true;
+    case 'v':
+        code_point = '\v';
+        return true;
+    case 'f':
+        code_point = '\f';
+        return true;
+    case '0':
+        code_point = 0;
+        return true;
+    case 'c':
+        if ((peek() >= 'a' && peek() <= 'z') || (peek() >= 'A' && peek() <= 'Z')) {
+            code_point = consume() % 32;
+            return true;
+        }
+        set_error("Invalid control escape");
+        return false;
+    case 'x':
+        if (hex_digit_value(peek()) >= 0 && hex_digit_value(peek(1)) >= 0) {
+            code_point = hex_digit_value(consume()) * 16;
+            code_point += hex_digit_value(consume());
+            return true;
+        }
+        code_point = 'x';
+        return true;
+    case 'u': {
+        if (consume_specific('{')) {
+            code_point = 0;
+            size_t digits = 0;
+            while (hex_digit_value(peek()) >= 0 && digits++ < 6)
+                code_point = code_point * 16 + hex_digit_value(consume());
+            if (!digits || code_point > 0x10ffff || !consume_specific('}')) {
+                set_error("Invalid Unicode escape");
+                return false;
+            }
+            return true;
+        }
+        code_point = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            if (hex_digit_value(peek(i)) < 0) {
+                code_point = 'u';
+                return true;
+            }
+        }
+        for (size_t i = 0; i < 4; ++i)
+            code_point = code_point * 16 + hex_digit_value(consume());
+        return true;
+    }
+    default:
+        code_point = (u8)ch;
+        return true;
+    }
+}
+
+Optional<Parser::Fragment> Parser::parse_character_class()
+{
+    consume();
+    bool is_negated = consume_specific('^');
+
+    CharacterClass character_class;
+    for (;;) {
+        if (at_end()) {
+            set_error("Unterminated character class");
+            return {};
+        }
+        if (consume_specific(']'))
+            break;
+
+        Optional<u8> from;
+        if (!parse_class_atom(character_class, from))
+            return {};
+        if (!from.has_value())
+            continue;
+
+        if (peek() != '-' || peek(1) == ']' || m_position + 1 >= m_input.length()) {
+            character_class.add(from.value());
+            continue;
+        }
+
+        consume();
+        Optional<u8> to;
+        if (!parse_class_atom(character_class, to))
+            return {};
+        if (!to.has_value()) {
+            // A range with a class escape at one end, like [a-\d], is just its parts.
+            character_class.add(from.value());
+            character_class.add('-');
+            continue;
+        }
+        if (to.value() < from.value()) {
+            set_error("Range out of order in character class");
+            return {};
+        }
+        character_class.add_range(from.value(), to.value());
+    }
+
+    if (m_pattern.m_options.ignore_case) {
+        for (u8 ch = 'a'; ch <= 'z'; ++ch) {
+            u8 upper = ch - 'a' + 'A';
+            if (character_class.contains(ch) || character_class.contains(upper)) {
+                character_class.add(ch);
+                character_class.add(upper);
+            }
+        }
+    }
+    if (is_negated)
+        character_class.invert();
+    return class_fragment(character_class);
+}
+
+bool Parser::parse_class_atom(CharacterClass& character_class, Optional<u8>& single_character)
+{
+    u8 ch = consume();
+    if (ch == '\\') {
+        if (at_end()) {
+            set_error("\\ at end of pattern");
+            return false;
+        }
+        if (parse_class_escape(peek(), character_class)) {
+            consume();
+            return true;
+        }
+        if (consume_specific('b')) {
+            single_character = '\b';
+            return true;
+        }
+        if (consume_specific('-')) {
+            single_character = '-';
+            return true;
+        }
+        u32 code_point;
+        if (!parse_character_escape(code_point))
+            return false;
+        if (code_point >= 0x80) {
+            set_error("Non-ASCII characters in character classes are not supported");
+            return false;
+        }
+        single_character = code_point;
+        return true;
+    }
+    if (ch >= 0x80) {
+        set_error("Non-ASCII characters in character classes are not supported");
+        return false;
+    }
+    single_character = ch;
+    return true;
+}
+
+Parser::Fragment Parser::class_fragment(const CharacterClass& character_class)
+{
+    m_pattern.m_classes.append(character_class);
+    return { { OpCode::CharacterClass, 0, (i32)m_pattern.m_classes.size() - 1 } };
+}
+
+Parser::Fragment Parser::code_point_fragment(u32 code_point)
+{
+    Fragment fragment;
+    if (code_point < 0x80) {
+        fragment.append({ OpCode::Character, (u8)code_point });
+    } else if (code_point < 0x800) {
+        fragment.append({ OpCode::Character, (u8)(0xc0 | (code_point >> 6)) });
+        fragment.append({ OpCode::Character, (u8)(0x80 | (code_point & 0x3f)) });
+    } else if (code_point < 0x10000) {
+        fragment.append({ OpCode::Character, (u8)(0xe0 | (code_point >> 12)) });
+        fragment.append({ OpCode::Character, (u8)(0x80 | ((code_point >> 6) & 0x3f)) });
+        fragment.append({ OpCode::Character, (u8)(0x80 | (code_point & 0x3f)) });
+    } else {
+        fragment.append({ OpCode::Character, (u8)(0xf0 | (code_point >> 18)) });
+        fragment.append({ OpCode::Character, (u8)(0x80 | ((code_point >> 12) & 0x3f)) });
+        fragment.append({ OpCode::Character, (u8)(0x80 | ((code_point >> 6) & 0x3f)) });
+        fragment.append({ OpCode::Character, (u8)(0x80 | (code_point & 0x3f)) });
+    }
+    return fragment;
+}
+
+}
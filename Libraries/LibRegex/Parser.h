@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <LibRegex/Pattern.h>
+
+namespace Regex {
+
+// Compiles the ECMAScript pattern syntax into a program for Pattern, piece by piece: every
+// parse function returns the instructions for what it parsed.
+class Parser {
+public:
+    Parser(const StringView& pattern, Pattern&);
+
+    bool compile();
+    const String& error() const { return m_error; }
+
+private:
+    using Fragment = Vector<Instruction>;
+
+    Fragment parse_disjunction();
+    Fragment parse_alternative();
+    bool parse_term(Fragment&);
+    Optional<Fragment> parse_atom(bool& is_assertion);
+    Optional<Fragment> parse_atom_escape(bool& is_assertion);
+    Optional<Fragment> parse_character_class();
+    bool parse_class_atom(CharacterClass&, Optional<u8>& single_character);
+    Optional<Fragment> parse_group();
+    bool parse_character_escape(u32& code_point);
+    bool parse_class_escape(char, CharacterClass&);
+    Optional<u32> parse_decimal();
+    void apply_quantifier(Fragment&, u32 min, Optional<u32> max, bool greedy);
+
+    Fragment class_fragment(const CharacterClass&);
+    static Fragment code_point_fragment(u32);
+    static void append_fragment(Fragment&, const Fragment&);
+    void set_error(const String&);
+
+    bool has_error() const { return !m_error.is_null(); }
+
+    bool at_end() const { return m_position >= m_input.length(); }
+    char peek(size_t offset = 0) const { return m_position + offset < m_input.length() ? m_input[m_position + offset] : 0; }
+    char consume() { return m_input[m_position++]; }
+    bool consume_specific(char);
+
+    StringView m_input;
+    size_t m_position { 0 };
+    Pattern& m_pattern;
+    String m_error;
+};
+
+}
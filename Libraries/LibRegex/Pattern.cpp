@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NonnullRefPtr.h>
+#include <LibRegex/Parser.h>
+#include <LibRegex/Pattern.h>
+#include <string.h>
+
+namespace Regex {
+
+void CharacterClass::add_range(u8 from, u8 to)
+{
+    for (unsigned ch = from; ch <= to; ++ch)
+        add(ch);
+}
+
+void CharacterClass::add_class(const CharacterClass& other)
+{
+    for (size_t i = 0; i < 8; ++i)
+        m_bits[i] |= other.m_bits[i];
+}
+
+void CharacterClass::invert()
+{
+    for (auto& bits : m_bits)
+        bits = ~bits;
+}
+
+Result<NonnullRefPtr<Pattern>, String> Pattern::compile(const StringView& source, Options options)
+{
+    auto pattern = adopt(*new Pattern);
+    pattern->m_options = options;
+    Parser parser(source, *pattern);
+    if (!parser.compile())
+        return parser.error();
+    return pattern;
+}
+
+namespace {
+
+// The threads waiting at one position of the input, in order of priority. There's at most one
+// thread per instruction, since two threads there would do the same from now on and only the
+// first of them can win.
+class ThreadList {
+public:
+    ThreadList(size_t program_size, size_t slot_count)
+        : m_slot_count(slot_count)
+    {
+        m_visited_generation.resize(program_size);
+        for (auto& generation : m_visited_generation)
+            generation = 0;
+    }
+
+    void clear()
+    {
+        m_threads.clear_with_capacity();
+        m_captures.clear_with_capacity();
+        ++m_generation;
+    }
+
+    bool is_empty() const { return m_threads.is_empty(); }
+    size_t size() const { return m_threads.size(); }
+    size_t pc(size_t index) const { return m_threads[index].pc; }
+    const int* captures(size_t index) const { return m_captures.data() + m_threads[index].captures_offset; }
+
+    // Returns false if there's been a thread at the instruction already.
+    bool visit(size_t pc)
+    {
+        if (m_visited_generation[pc] == m_generation)
+            return false;
+        m_visited_generation[pc] = m_generation;
+        return true;
+    }
+
+    void append(size_t pc, const int* captures)
+    {
+        m_threads.append({ pc, m_captures.size() });
+        m_captures.append(captures, m_slot_count);
+    }
+
+private:
+    struct Thread {
+        size_t pc;
+        size_t captures_offset;
+    };
+
+    size_t m_slot_count { 0 };
+    u32 m_generation { 1 };
+    Vector<Thread> m_threads;
+    Vector<int> m_captures;
+    Vector<u32> m_visited_generation;
+};
+
+class Matcher {
+public:
+    Matcher(const Vector<Instruction>& program, const Vector<CharacterClass>& classes, const Options& options, const StringView& input)
+        : m_program(program)
+        , m_classes(classes)
+        , m_options(options)
+        , m_input(input)
+    {
+    }
+
+    // Follows all the instructions that don't consume input from the given one, and adds a
+    // thread for every consuming one (or the match) that it reaches.
+    void add_thread(ThreadList&, size_t pc, size_t position, int* captures);
+
+    bool step(u8 ch, size_t pc) const
+    {
+        auto& instruction = m_program[pc];
+        switch (instruction.op) {
+        case OpCode::Character:
+            if (ch == instruction.character)
+                return true;
+            return m_options.ignore_case && to_lower(ch) == to_lower(instruction.character);
+        case OpCode::AnyCharacter:
+            return true;
+        case OpCode::AnyCharacterExceptNewline:
+            return !is_line_terminator(ch);
+        case OpCode::CharacterClass:
+            return m_classes[instruction.operand].contains(ch);
+        default:
+            ASSERT_NOT_REACHED();
+        }
+    }
+
+private:
+    struct Frame {
+        size_t pc;
+        // When set, this frame restores a capture slot instead of exploring an instruction.
+        int slot;
+        int saved_value;
+    };
+
+    static u8 to_lower(u8 ch) { return ch >= 'A' && ch <= 'Z' ? ch + ('a' - 'A') : ch; }
+    static bool is_line_terminator(u8 ch) { return ch == '\n' || ch == '\r'; }
+    static bool is_word_character(u8 ch) { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_'; }
+
+    bool is_word_character_at(size_t position) const { return position < m_input.length() && is_word_character(m_input[position]); }
+    bool assertion_holds(OpCode, size_t position) const;
+
+    const Vector<Instruction>& m_program;
+    const Vector<CharacterClass>& m_classes;
+    const Options& m_options;
+    StringView m_input;
+    Vector<Frame> m_stack;
+};
+
+bool Matcher::assertion_holds(OpCode op, size_t position) const
+{
+    switch (op) {
+    case OpCode::AssertStart:
+        return position == 0 || (m_options.multiline && is_line_terminator(m_input[position - 1]));
+    case OpCode::AssertEnd:
+        return position == m_input.length() || (m_options.multiline && is_line_terminator(m_input[position]));
+    case OpCode::AssertWordBoundary:
+    case OpCode::AssertNotWordBoundary: {
+        bool is_boundary = (position > 0 && is_word_character_at(position - 1)) != is_word_character_at(position);
+        return is_boundary == (op == OpCode::AssertWordBoundary);
+    }
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+void Matcher::add_thread(ThreadList& list, size_t pc, size_t position, int* captures)
+{
+    // This is a depth-first walk, so that threads are added in the order of their priority. Saving
+    // a capture pushes a frame that puts the old value back before the lower priority paths run.
+    m_stack.clear_with_capacity();
+    m_stack.append({ pc, -1, 0 });
+    while (!m_stack.is_empty()) {
+        auto frame = m_stack.take_last();
+        if (frame.slot >= 0) {
+            captures[frame.slot] = frame.saved_value;
+            continue;
+        }
+
+        pc = frame.pc;
+        while (list.visit(pc)) {
+            auto& instruction = m_program[pc];
+            if (instruction.op == OpCode::Jump) {
+                pc += instruction.operand;
+            } else if (instruction.op == OpCode::Split) {
+                m_stack.append({ pc + instruction.alternative, -1, 0 });
+                pc += instruction.operand;
+            } else if (instruction.op == OpCode::Save) {
+                m_stack.append({ 0, instruction.operand, captures[instruction.operand] });
+                captures[instruction.operand] = position;
+                ++pc;
+            } else if (instruction.op >= OpCode::AssertStart && instruction.op <= OpCode::AssertNotWordBoundary) {
+                if (!assertion_holds(instruction.op, position))
+                    break;
+                ++pc;
+            } else {
+                list.append(pc, captures);
+                break;
+            }
+        }
+    }
+}
+
+}
+
+Optional<Match> Pattern::run(const StringView& input, size_t start, bool anchored) const
+{
+    if (start > input.length())
+        return {};
+
+    Matcher matcher(m_program, m_classes, m_options, input);
+    size_t slot_count = (m_group_count + 1) * 2;
+    ThreadList current_threads(m_program.size(), slot_count);
+    ThreadList next_threads(m_program.size(), slot_count);
+    Vector<int> captures;
+    captures.resize(slot_count);
+    Optional<Vector<int>> best_captures;
+
+    for (size_t position = start;; ++position) {
+        if (!best_captures.has_value() && (position == start || !anchored)) {
+            if (current_threads.is_empty() && m_first_byte.has_value() && !anchored) {
+                auto* next = (const char*)memchr(input.characters_without_null_termination() + position, m_first_byte.value(), input.length() - position);
+                if (!next)
+                    break;
+                position = next - input.characters_without_null_termination();
+            }
+            for (auto& capture : captures)
+                capture = -1;
+            matcher.add_thread(current_threads, 0, position, captures.data());
+        }
+        if (current_threads.is_empty()) {
+            if (best_captures.has_value() || anchored || position >= input.length())
+                break;
+            // Forget what the failed attempt visited, so that the next one gets to try again.
+            current_threads.clear();
+            continue;
+        }
+
+        next_threads.clear();
+        for (size_t i = 0; i < current_threads.size(); ++i) {
+            auto pc = current_threads.pc(i);
+            if (m_program[pc].op == OpCode::Match) {
+                // Anything after this thread has lower priority, so it can't win anymore.
+                best_captures = Vector<int>();
+                best_captures.value().append(current_threads.captures(i), slot_count);
+                break;
+            }
+            if (position < input.length() && matcher.step(input[position], pc)) {
+                memcpy(captures.data(), current_threads.captures(i), slot_count * sizeof(int));
+                matcher.add_thread(next_threads, pc + 1, position + 1, captures.data());
+            }
+        }
+
+        swap(current_threads, next_threads);
+        if (position >= input.length())
+            break;
+    }
+
+    if (!best_captures.has_value())
+        return {};
+
+    Match match;
+    match.captures.ensure_capacity(m_group_count + 1);
+    auto& slots = best_captures.value();
+    for (size_t i = 0; i <= m_group_count; ++i) {
+        Capture capture;
+        if (slots[i * 2] >= 0 && slots[i * 2 + 1] >= 0) {
+            capture.matched = true;
+            capture.start = slots[i * 2];
+            capture.end = slots[i * 2 + 1];
+        }
+        match.captures.unchecked_append(capture);
+    }
+    return match;
+}
+
+}
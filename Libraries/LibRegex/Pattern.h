@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
+#include <AK/RefCounted.h>
+#include <AK/Result.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+namespace Regex {
+
+struct Options {
+    bool ignore_case { false };
+    bool multiline { false };
+    bool dot_all { false };
+};
+
+// A span of the input, in bytes. Groups that didn't take part in the match aren't matched.
+struct Capture {
+    bool matched { false };
+    size_t start { 0 };
+    size_t end { 0 };
+
+    size_t length() const { return end - start; }
+};
+
+struct Match {
+    // Capture 0 is the whole match, followed by the groups in the order of their opening parentheses.
+    Vector<Capture> captures;
+
+    size_t start() const { return captures[0].start; }
+    size_t end() const { return captures[0].end; }
+};
+
+enum class OpCode : u8 {
+    Character,
+    AnyCharacter,
+    AnyCharacterExceptNewline,
+    CharacterClass,
+    Split,
+    Jump,
+    Save,
+    AssertStart,
+    AssertEnd,
+    AssertWordBoundary,
+    AssertNotWordBoundary,
+    Match,
+};
+
+// Jumps and splits are relative to their own instruction, so that a piece of a program can be
+// copied around when a quantifier needs it several times.
+struct Instruction {
+    OpCode op;
+    u8 character { 0 };
+    // The preferred jump or split target, the capture slot to save into, or the character class.
+    i32 operand { 0 };
+    // The other split target.
+    i32 alternative { 0 };
+};
+
+class CharacterClass {
+public:
+    bool contains(u8 character) const { return m_bits[character / 32] & (1u << (character % 32)); }
+    void add(u8 character) { m_bits[character / 32] |= 1u << (character % 32); }
+    void add_range(u8 from, u8 to);
+    void add_class(const CharacterClass&);
+    void invert();
+
+private:
+    u32 m_bits[8] {};
+};
+
+// A compiled regular expression. Matching runs every way through the program in lockstep (a Pike
+// VM) instead of backtracking, so it takes time linear in the input whatever the pattern is. That
+// leaves out backreferences and lookaround, which compile() refuses.
+class Pattern : public RefCounted<Pattern> {
+public:
+    static Result<NonnullRefPtr<Pattern>, String> compile(const StringView& pattern, Options = {});
+
+    // The leftmost match starting at or after the given position.
+    Optional<Match> search(const StringView& input, size_t start = 0) const { return run(input, start, false); }
+    // A match starting exactly at the given position.
+    Optional<Match> match_at(const StringView& input, size_t position) const { return run(input, position, true); }
+
+    size_t group_count() const { return m_group_count; }
+    const Options& options() const { return m_options; }
+
+private:
+    friend class Parser;
+
+    Pattern() { }
+
+    Optional<Match> run(const StringView& input, size_t start, bool anchored) const;
+
+    Options m_options;
+    Vector<Instruction> m_program;
+    Vector<CharacterClass> m_classes;
+    size_t m_group_count { 0 };
+    // Set when every match has to start with this byte, which lets the search skip ahead to it.
+    Optional<u8> m_first_byte;
+};
+
+}
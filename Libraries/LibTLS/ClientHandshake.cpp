@@ -25,9 +25,11 @@
  */
 
 #include <AK/Random.h>
+#include <LibCore/DateTime.h>
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
+#include <LibTLS/SessionCache.h>
 #include <LibTLS/TLSv12.h>
 
 namespace TLS {
@@ -42,6 +44,11 @@ ssize_t TLSv12::handle_server_hello_done(const ByteBuffer& buffer)
     if (buffer.size() - 3 < size)
         return (i8)Error::NeedMoreData;
 
+    if (is_ecdhe() && m_context.ecdhe_public_key.is_empty()) {
+        dbg() << "server hello done without a key exchange";
+        return (i8)Error::UnexpectedMessage;
+    }
+
     return size + 3;
 }
 
@@ -85,6 +92,15 @@ ssize_t TLSv12::handle_hello(const ByteBuffer& buffer, WritePacketStage& write_p
         return (i8)Error::NeedMoreData;
     }
 
+    // The server agrees to resume the session we offered by repeating its ID.
+    m_context.is_resuming_session = false;
+    if (m_context.offered_session.has_value()) {
+        auto& session = m_context.offered_session.value();
+        m_context.is_resuming_session = session_length && session_length == session.session_id_size && !memcmp(session.session_id, buffer.offset_pointer(res), session_length);
+        if (!m_context.is_resuming_session)
+            SessionCache::the().remove(m_context.session_cache_key);
+    }
+
     if (session_length && session_length <= 32) {
         memcpy(m_context.session_id, buffer.offset_pointer(res), session_length);
         m_context.session_id_size = session_length;
@@ -108,6 +124,11 @@ ssize_t TLSv12::handle_hello(const ByteBuffer& buffer, WritePacketStage& write_p
         dbg() << "No supported cipher could be agreed upon";
         return (i8)Error::NoCommonCipher;
     }
+    if (m_context.is_resuming_session && cipher != m_context.offered_session.value().cipher) {
+        dbg() << "Server resumed a session with a different cipher";
+        SessionCache::the().remove(m_context.session_cache_key);
+        return (i8)Error::BrokenPacket;
+    }
     m_context.cipher = cipher;
 #ifdef TLS_DEBUG
     dbg() << "Cipher: " << (u16)cipher;
@@ -197,9 +218,91 @@ ssize_t TLSv12::handle_hello(const ByteBuffer& buffer, WritePacketStage& write_p
         }
     }
 
+    if (m_context.is_resuming_session) {
+        // We already share a master secret with the server, so there's no certificate and no key exchange.
+        // It goes straight to ChangeCipherSpec and Finished.
+#ifdef TLS_DEBUG
+        dbg() << "Resuming session";
+#endif
+        m_context.master_key = ByteBuffer::copy(m_context.offered_session.value().master_key.data(), m_context.offered_session.value().master_key.size());
+        if (!expand_key())
+            return (i8)Error::BrokenPacket;
+        m_context.connection_status = ConnectionStatus::KeyExchange;
+    }
+
     return res;
 }
 
+ssize_t TLSv12::handle_new_session_ticket(const ByteBuffer& buffer)
+{
+    // See RFC 5077, section 3.3.
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+    if (size < 6)
+        return (i8)Error::BrokenPacket;
+
+    u32 lifetime_hint = convert_between_host_and_network(*(const u32*)buffer.offset_pointer(3));
+    u16 ticket_length = convert_between_host_and_network(*(const u16*)buffer.offset_pointer(7));
+    if (size < 6u + ticket_length)
+        return (i8)Error::BrokenPacket;
+
+    m_context.session_ticket = ByteBuffer::copy(buffer.offset_pointer(9), ticket_length);
+    m_context.session_ticket_lifetime = lifetime_hint;
+    return size + 3;
+}
+
+void TLSv12::store_session()
+{
+    if (m_context.session_cache_key.is_null())
+        return;
+
+    Session session;
+    if (!m_context.session_ticket.is_empty()) {
+        session.ticket = m_context.session_ticket;
+    } else if (m_context.is_resuming_session) {
+        // Nothing has changed, the offered session stays as it was.
+        return;
+    } else if (m_context.session_id_size) {
+        memcpy(session.session_id, m_context.session_id, m_context.session_id_size);
+        session.session_id_size = m_context.session_id_size;
+    } else {
+        // The server doesn't do resumption.
+        return;
+    }
+
+    static constexpr u32 default_session_lifetime = 10 * 60;
+    static constexpr u32 max_session_lifetime = 24 * 60 * 60;
+    u32 lifetime = default_session_lifetime;
+    if (!m_context.session_ticket.is_empty() && m_context.session_ticket_lifetime)
+        lifetime = min(m_context.session_ticket_lifetime, max_session_lifetime);
+
+    session.cipher = m_context.cipher;
+    session.master_key = ByteBuffer::copy(m_context.master_key.data(), m_context.master_key.size());
+    session.expiration_time = Core::DateTime::now().timestamp() + lifetime;
+    SessionCache::the().set(m_context.session_cache_key, move(session));
+}
+
+void TLSv12::did_complete_handshake()
+{
+    m_context.connection_status = ConnectionStatus::Established;
+
+    if (m_handshake_timeout_timer) {
+        // Disable the handshake timeout timer as handshake has been established.
+        m_handshake_timeout_timer->stop();
+        m_handshake_timeout_timer->remove_from_parent();
+        m_handshake_timeout_timer = nullptr;
+    }
+
+    store_session();
+
+    if (on_tls_ready_to_write)
+        on_tls_ready_to_write(*this);
+}
+
 ssize_t TLSv12::handle_finished(const ByteBuffer& buffer, WritePacketStage& write_packets)
 {
     if (m_context.connection_status < ConnectionStatus::KeyExchange || m_context.connection_status == ConnectionStatus::Established) {
@@ -235,17 +338,14 @@ ssize_t TLSv12::handle_finished(const ByteBuffer& buffer, WritePacketStage& writ
 #ifdef TLS_DEBUG
     dbg() << "FIXME: handle_finished :: Check message validity";
 #endif
-    m_context.connection_status = ConnectionStatus::Established;
 
-    if (m_handshake_timeout_timer) {
-        // Disable the handshake timeout timer as handshake has been established.
-        m_handshake_timeout_timer->stop();
-        m_handshake_timeout_timer->remove_from_parent();
-        m_handshake_timeout_timer = nullptr;
+    if (m_context.is_resuming_session) {
+        // In an abbreviated handshake, the server finishes first, and our Finished is still to come.
+        write_packets = WritePacketStage::Finished;
+        return index + size;
     }
 
-    if (on_tls_ready_to_write)
-        on_tls_ready_to_write(*this);
+    did_complete_handshake();
 
     return index + size;
 }
@@ -299,6 +399,20 @@ void TLSv12::build_random(PacketBuilder& builder)
     builder.append(outbuf);
 }
 
+void TLSv12::build_ecdhe_key_exchange(PacketBuilder& builder)
+{
+    // The shared secret was agreed upon when the server's key exchange came in, all that's left is to send our half.
+    if (!compute_master_secret(48)) {
+        dbg() << "could not derive a master key from the ECDHE secret";
+        return;
+    }
+
+    builder.append_u24(m_context.ecdhe_public_key.size() + 1);
+    builder.append((u8)m_context.ecdhe_public_key.size());
+    builder.append(m_context.ecdhe_public_key);
+    m_context.ecdhe_public_key.clear();
+}
+
 ssize_t TLSv12::handle_payload(const ByteBuffer& vbuffer)
 {
     if (m_context.connection_status == ConnectionStatus::Established) {
@@ -368,6 +482,16 @@ ssize_t TLSv12::handle_payload(const ByteBuffer& vbuffer)
                 payload_res = handle_hello(buffer.slice_view(1, payload_size), write_packets);
             }
             break;
+        case NewSessionTicket:
+#ifdef TLS_DEBUG
+            dbg() << "new session ticket";
+#endif
+            if (m_context.is_server || m_context.connection_status == ConnectionStatus::Established) {
+                payload_res = (i8)Error::UnexpectedMessage;
+                break;
+            }
+            payload_res = handle_new_session_ticket(buffer.slice_view(1, payload_size));
+            break;
         case HelloVerifyRequest:
             dbg() << "unsupported: DTLS";
             payload_res = (i8)Error::UnexpectedMessage;
@@ -645,7 +769,7 @@ ssize_t TLSv12::handle_payload(const ByteBuffer& vbuffer)
                 auto packet = build_finished();
                 write_packet(packet);
             }
-            m_context.connection_status = ConnectionStatus::Established;
+            did_complete_handshake();
             break;
         }
         payload_size++;
@@ -26,6 +26,8 @@
 
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
+#include <LibCrypto/Curves/SECP256r1.h>
+#include <LibCrypto/Curves/X25519.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
 
@@ -85,8 +87,13 @@ bool TLSv12::expand_key()
     memcpy(m_context.crypto.local_iv, client_iv, iv_size);
     memcpy(m_context.crypto.remote_iv, server_iv, iv_size);
 
-    m_aes_local = make<Crypto::Cipher::AESCipher::CBCMode>(ByteBuffer::wrap(client_key, key_size), key_size * 8, Crypto::Cipher::Intent::Encryption, Crypto::Cipher::PaddingMode::RFC5246);
-    m_aes_remote = make<Crypto::Cipher::AESCipher::CBCMode>(ByteBuffer::wrap(server_key, key_size), key_size * 8, Crypto::Cipher::Intent::Decryption, Crypto::Cipher::PaddingMode::RFC5246);
+    if (is_aead()) {
+        m_aes_gcm_local = make<Crypto::Cipher::AESCipher::GCMMode>(ByteBuffer::wrap(client_key, key_size), key_size * 8, Crypto::Cipher::Intent::Encryption);
+        m_aes_gcm_remote = make<Crypto::Cipher::AESCipher::GCMMode>(ByteBuffer::wrap(server_key, key_size), key_size * 8, Crypto::Cipher::Intent::Decryption);
+    } else {
+        m_aes_local = make<Crypto::Cipher::AESCipher::CBCMode>(ByteBuffer::wrap(client_key, key_size), key_size * 8, Crypto::Cipher::Intent::Encryption, Crypto::Cipher::PaddingMode::RFC5246);
+        m_aes_remote = make<Crypto::Cipher::AESCipher::CBCMode>(ByteBuffer::wrap(server_key, key_size), key_size * 8, Crypto::Cipher::Intent::Decryption, Crypto::Cipher::PaddingMode::RFC5246);
+    }
 
     m_context.crypto.created = 1;
 
@@ -239,7 +246,10 @@ ByteBuffer TLSv12::build_client_key_exchange()
 {
     PacketBuilder builder { MessageType::Handshake, m_context.version };
     builder.append((u8)HandshakeType::ClientKeyExchange);
-    build_random(builder);
+    if (is_ecdhe())
+        build_ecdhe_key_exchange(builder);
+    else
+        build_random(builder);
 
     m_context.connection_status = ConnectionStatus::KeyExchange;
 
@@ -250,10 +260,151 @@ ByteBuffer TLSv12::build_client_key_exchange()
     return packet;
 }
 
-ssize_t TLSv12::handle_server_key_exchange(const ByteBuffer&)
+static OwnPtr<Crypto::Curves::EllipticCurve> make_curve(NamedCurve named_curve)
 {
-    dbg() << "FIXME: parse_server_key_exchange";
-    return 0;
+    switch (named_curve) {
+    case NamedCurve::X25519:
+        return make<Crypto::Curves::X25519>();
+    case NamedCurve::SECP256r1:
+        return make<Crypto::Curves::SECP256r1>();
+    default:
+        return nullptr;
+    }
+}
+
+ssize_t TLSv12::handle_server_key_exchange(const ByteBuffer& buffer)
+{
+    // Only the ECDHE suites have the server send a key exchange message, see RFC 4492, section 5.4.
+    if (!is_ecdhe()) {
+        dbg() << "unexpected server key exchange for cipher " << (u16)m_context.cipher;
+        return (i8)Error::UnexpectedMessage;
+    }
+
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+
+    auto message = buffer.bytes().slice(3, size);
+
+    // ECParameters (only named curves) followed by the server's ephemeral point.
+    if (message.size() < 4)
+        return (i8)Error::BrokenPacket;
+    constexpr u8 named_curve_type = 3;
+    if (message[0] != named_curve_type) {
+        dbg() << "server key exchange with unsupported curve type " << message[0];
+        return (i8)Error::NotUnderstood;
+    }
+    auto named_curve = (NamedCurve)convert_between_host_and_network(*(const u16*)(message.data() + 1));
+    size_t point_length = message[3];
+    size_t params_length = 4 + point_length;
+    if (message.size() < params_length + 4)
+        return (i8)Error::BrokenPacket;
+    auto params = message.slice(0, params_length);
+    auto server_public_key = message.slice(4, point_length);
+
+    auto signature_scheme = (SignatureScheme)convert_between_host_and_network(*(const u16*)(message.data() + params_length));
+    size_t signature_length = convert_between_host_and_network(*(const u16*)(message.data() + params_length + 2));
+    if (message.size() < params_length + 4 + signature_length)
+        return (i8)Error::BrokenPacket;
+    auto signature = message.slice(params_length + 4, signature_length);
+
+    if (!verify_server_key_exchange_signature(signature_scheme, params, signature)) {
+        dbg() << "server key exchange signature does not match the certificate";
+        return (i8)Error::NotVerified;
+    }
+
+    auto curve = make_curve(named_curve);
+    if (!curve) {
+        dbg() << "server picked an unsupported curve " << (u16)named_curve;
+        return (i8)Error::NotUnderstood;
+    }
+
+    u8 private_key[curve->key_size()];
+    curve->generate_private_key({ private_key, sizeof(private_key) });
+    m_context.ecdhe_public_key = ByteBuffer::create_uninitialized(curve->public_key_size());
+    m_context.premaster_key = ByteBuffer::create_uninitialized(curve->shared_secret_size());
+    if (!curve->compute_public_key({ private_key, sizeof(private_key) }, m_context.ecdhe_public_key.bytes())
+        || !curve->compute_shared_secret({ private_key, sizeof(private_key) }, server_public_key, m_context.premaster_key.bytes())) {
+        dbg() << "server sent an invalid " << curve->class_name() << " public key";
+        m_context.ecdhe_public_key.clear();
+        m_context.premaster_key.clear();
+        return (i8)Error::BrokenPacket;
+    }
+
+#ifdef TLS_DEBUG
+    dbg() << "ECDHE over " << curve->class_name() << ", premaster secret:";
+    print_buffer(m_context.premaster_key);
+#endif
+
+    return size + 3;
+}
+
+bool TLSv12::verify_server_key_exchange_signature(SignatureScheme scheme, ReadonlyBytes params, ReadonlyBytes signature)
+{
+    // The DigestInfo prefixes from RFC 8017, section 9.2.
+    static constexpr u8 sha1_digest_info[] { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14 };
+    static constexpr u8 sha256_digest_info[] { 0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20 };
+    static constexpr u8 sha512_digest_info[] { 0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00, 0x04, 0x40 };
+
+    Crypto::Hash::HashKind hash_kind;
+    ReadonlyBytes digest_info;
+    switch (scheme) {
+    case SignatureScheme::RSA_PKCS1_SHA1:
+        hash_kind = Crypto::Hash::HashKind::SHA1;
+        digest_info = { sha1_digest_info, sizeof(sha1_digest_info) };
+        break;
+    case SignatureScheme::RSA_PKCS1_SHA256:
+        hash_kind = Crypto::Hash::HashKind::SHA256;
+        digest_info = { sha256_digest_info, sizeof(sha256_digest_info) };
+        break;
+    case SignatureScheme::RSA_PKCS1_SHA512:
+        hash_kind = Crypto::Hash::HashKind::SHA512;
+        digest_info = { sha512_digest_info, sizeof(sha512_digest_info) };
+        break;
+    default:
+        dbg() << "unsupported signature scheme " << (u16)scheme;
+        return false;
+    }
+
+    if (m_context.certificates.is_empty())
+        return false;
+    const auto& certificate = m_context.certificates[0];
+    Crypto::PK::RSA rsa(certificate.public_key.modulus(), 0, certificate.public_key.public_exponent());
+    size_t modulus_length = rsa.output_size();
+    if (signature.size() != modulus_length)
+        return false;
+
+    // The signature covers both randoms and the curve parameters (RFC 4492, section 5.4).
+    Crypto::Hash::Manager hash(hash_kind);
+    hash.update(m_context.local_random, sizeof(m_context.local_random));
+    hash.update(m_context.remote_random, sizeof(m_context.remote_random));
+    hash.update(params.data(), params.size());
+    auto digest = hash.digest();
+    auto digest_size = hash.digest_size();
+    if (modulus_length < digest_info.size() + digest_size + 11)
+        return false;
+
+    // EMSA-PKCS1-v1_5: 0x00 0x01 0xff...0xff 0x00 DigestInfo digest (RFC 8017, section 9.2)
+    u8 expected[modulus_length];
+    size_t digest_offset = modulus_length - digest_size;
+    size_t digest_info_offset = digest_offset - digest_info.size();
+    expected[0] = 0x00;
+    expected[1] = 0x01;
+    memset(expected + 2, 0xff, digest_info_offset - 3);
+    expected[digest_info_offset - 1] = 0x00;
+    memcpy(expected + digest_info_offset, digest_info.data(), digest_info.size());
+    memcpy(expected + digest_offset, digest.immutable_data(), digest_size);
+
+    u8 decoded_data[modulus_length];
+    auto decoded = ByteBuffer::wrap(decoded_data, modulus_length);
+    rsa.verify(ByteBuffer::copy(signature.data(), signature.size()), decoded);
+
+    // The leading zero byte may or may not survive the trip through a big integer.
+    if (decoded.size() != modulus_length && decoded.size() != modulus_length - 1)
+        return false;
+    return !memcmp(decoded.data(), expected + modulus_length - decoded.size(), decoded.size());
 }
 
 ssize_t TLSv12::handle_verify(const ByteBuffer&)
@@ -28,6 +28,7 @@
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
+#include <LibTLS/SessionCache.h>
 #include <LibTLS/TLSv12.h>
 
 namespace TLS {
@@ -51,6 +52,25 @@ ByteBuffer TLSv12::build_hello()
     builder.append(version);
     builder.append(m_context.local_random, sizeof(m_context.local_random));
 
+    // Offer to pick up where the last connection to this server left off.
+    m_context.offered_session.clear();
+    m_context.session_id_size = 0;
+    if (!m_context.session_cache_key.is_null())
+        m_context.offered_session = SessionCache::the().get(m_context.session_cache_key);
+    if (m_context.offered_session.has_value()) {
+        auto& session = m_context.offered_session.value();
+        if (session.ticket.is_empty()) {
+            memcpy(m_context.session_id, session.session_id, session.session_id_size);
+            m_context.session_id_size = session.session_id_size;
+        } else {
+            // A server that accepts the ticket echoes the session ID back, which is how we can tell (RFC 5077, section 3.4).
+            AK::fill_with_random(m_context.session_id, sizeof(m_context.session_id));
+            m_context.session_id_size = sizeof(m_context.session_id);
+        }
+        memcpy(session.session_id, m_context.session_id, m_context.session_id_size);
+        session.session_id_size = m_context.session_id_size;
+    }
+
     builder.append(m_context.session_id_size);
     if (m_context.session_id_size)
         builder.append(m_context.session_id, m_context.session_id_size);
@@ -73,8 +93,13 @@ ByteBuffer TLSv12::build_hello()
             extension_length += alpn_length + 6;
     }
 
-    // Ciphers
-    builder.append((u16)(4 * sizeof(u16)));
+    // Ciphers, the ones with forward secrecy first
+    builder.append((u16)(9 * sizeof(u16)));
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA);
+    builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA);
+    builder.append((u16)CipherSuite::RSA_WITH_AES_128_GCM_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_128_CBC_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_256_CBC_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_128_CBC_SHA);
@@ -92,6 +117,19 @@ ByteBuffer TLSv12::build_hello()
     if (sni_length)
         extension_length += sni_length + 9;
 
+    // The session ticket extension goes out even without a ticket, to let the server know that we'd like one.
+    size_t ticket_length = 0;
+    if (m_context.offered_session.has_value())
+        ticket_length = m_context.offered_session.value().ticket.size();
+    extension_length += ticket_length + 4;
+
+    // The ECDHE suites need us to say which curves we can do and how we'd like the points to look (RFC 4492, section 5.1).
+    static constexpr NamedCurve supported_curves[] { NamedCurve::X25519, NamedCurve::SECP256r1 };
+    static constexpr SignatureScheme supported_signatures[] { SignatureScheme::RSA_PKCS1_SHA256, SignatureScheme::RSA_PKCS1_SHA512, SignatureScheme::RSA_PKCS1_SHA1 };
+    extension_length += 6 + sizeof(supported_curves);
+    extension_length += 6;
+    extension_length += 6 + sizeof(supported_signatures);
+
     builder.append((u16)extension_length);
 
     if (sni_length) {
@@ -108,6 +146,29 @@ ByteBuffer TLSv12::build_hello()
         builder.append((const u8*)m_context.SNI.characters(), sni_length);
     }
 
+    builder.append((u16)HandshakeExtension::SessionTicket);
+    builder.append((u16)ticket_length);
+    if (ticket_length)
+        builder.append(m_context.offered_session.value().ticket);
+
+    builder.append((u16)HandshakeExtension::SupportedGroups);
+    builder.append((u16)(sizeof(supported_curves) + 2));
+    builder.append((u16)sizeof(supported_curves));
+    for (auto curve : supported_curves)
+        builder.append((u16)curve);
+
+    builder.append((u16)HandshakeExtension::ECPointFormats);
+    builder.append((u16)2);
+    builder.append((u8)1);
+    // uncompressed
+    builder.append((u8)0);
+
+    builder.append((u16)HandshakeExtension::SignatureAlgorithms);
+    builder.append((u16)(sizeof(supported_signatures) + 2));
+    builder.append((u16)sizeof(supported_signatures));
+    for (auto signature : supported_signatures)
+        builder.append((u16)signature);
+
     if (alpn_length) {
         // TODO
         ASSERT_NOT_REACHED();
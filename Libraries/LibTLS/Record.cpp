@@ -27,6 +27,7 @@
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
+#include <LibTLS/SessionCache.h>
 #include <LibTLS/TLSv12.h>
 
 namespace TLS {
@@ -65,7 +66,31 @@ void TLSv12::update_packet(ByteBuffer& packet)
                 update_hash(packet.slice_view(header_size, packet.size() - header_size));
             }
         }
-        if (m_context.cipher_spec_set && m_context.crypto.created) {
+        if (m_context.cipher_spec_set && m_context.crypto.created && is_aead()) {
+            // RFC 5288: the record is the explicit part of the nonce, followed by the ciphertext and its tag.
+            // The sequence number is unique for every record, which makes it a fine explicit nonce.
+            size_t length = packet.size() - header_size;
+            u64 sequence_number = convert_between_host_and_network(m_context.local_sequence_number);
+
+            u8 nonce[12];
+            memcpy(nonce, m_context.crypto.local_iv, 4);
+            memcpy(nonce + 4, &sequence_number, 8);
+
+            u8 aad[13];
+            memcpy(aad, &sequence_number, 8);
+            memcpy(aad + 8, packet.data(), 3);
+            *(u16*)(aad + 11) = convert_between_host_and_network((u16)length);
+
+            auto ct = ByteBuffer::create_uninitialized(header_size + aead_explicit_nonce_size + length + aead_tag_size);
+            ct.overwrite(0, packet.data(), header_size - 2);
+            ct.overwrite(header_size, nonce + 4, aead_explicit_nonce_size);
+            auto cipher_text = ct.bytes().slice(header_size + aead_explicit_nonce_size, length);
+            auto tag = ct.bytes().slice(header_size + aead_explicit_nonce_size + length, aead_tag_size);
+            m_aes_gcm_local->encrypt(packet.bytes().slice(header_size, length), cipher_text, { nonce, sizeof(nonce) }, { aad, sizeof(aad) }, tag);
+
+            *(u16*)ct.offset_pointer(header_size - 2) = convert_between_host_and_network((u16)(ct.size() - header_size));
+            packet = ct;
+        } else if (m_context.cipher_spec_set && m_context.crypto.created) {
             size_t length = packet.size() - header_size + mac_length();
             auto block_size = m_aes_local->cipher().block_size();
             // If the length is already a multiple a block_size,
@@ -203,7 +228,42 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
 #endif
     ByteBuffer plain = buffer.slice_view(buffer_position, buffer.size() - buffer_position);
 
-    if (m_context.cipher_spec_set && type != MessageType::ChangeCipher) {
+    if (m_context.cipher_spec_set && type != MessageType::ChangeCipher && is_aead()) {
+#ifdef TLS_DEBUG
+        dbg() << "Encrypted: ";
+        print_buffer(buffer.slice_view(header_size, length));
+#endif
+
+        ASSERT(m_aes_gcm_remote);
+        if (length < aead_explicit_nonce_size + aead_tag_size) {
+            dbg() << "broken packet";
+            auto packet = build_alert(true, (u8)AlertDescription::DecryptError);
+            write_packet(packet);
+            return (i8)Error::BrokenPacket;
+        }
+        length -= aead_explicit_nonce_size + aead_tag_size;
+
+        u8 nonce[12];
+        memcpy(nonce, m_context.crypto.remote_iv, 4);
+        memcpy(nonce + 4, buffer.offset_pointer(header_size), aead_explicit_nonce_size);
+
+        u64 sequence_number = convert_between_host_and_network(m_context.remote_sequence_number);
+        u8 aad[13];
+        memcpy(aad, &sequence_number, 8);
+        memcpy(aad + 8, buffer.offset_pointer(0), 3);
+        *(u16*)(aad + 11) = convert_between_host_and_network((u16)length);
+
+        auto decrypted = ByteBuffer::create_uninitialized(length);
+        auto cipher_text = buffer.bytes().slice(header_size + aead_explicit_nonce_size, length);
+        auto tag = buffer.bytes().slice(header_size + aead_explicit_nonce_size + length, aead_tag_size);
+        if (!m_aes_gcm_remote->decrypt(cipher_text, decrypted.bytes(), { nonce, sizeof(nonce) }, { aad, sizeof(aad) }, tag)) {
+            dbg() << "integrity check failed (AEAD tag mismatch)";
+            auto packet = build_alert(true, (u8)AlertDescription::BadRecordMAC);
+            write_packet(packet);
+            return (i8)Error::IntegrityCheckFailed;
+        }
+        plain = decrypted;
+    } else if (m_context.cipher_spec_set && type != MessageType::ChangeCipher) {
 #ifdef TLS_DEBUG
         dbg() << "Encrypted: ";
         print_buffer(buffer.slice_view(header_size, length));
@@ -303,6 +363,9 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
             if (level == (u8)AlertLevel::Critical) {
                 dbg() << "We were alerted of a critical error: " << code << " (" << alert_name((AlertDescription)code) << ")";
                 m_context.critical_error = code;
+                // Don't try the same session again if the server choked on it.
+                if (m_context.is_resuming_session && m_context.connection_status != ConnectionStatus::Established)
+                    SessionCache::the().remove(m_context.session_cache_key);
                 try_disambiguate_error();
                 res = (i8)Error::UnknownError;
             } else {
@@ -311,7 +374,8 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
             if (code == 0) {
                 // close notify
                 res += 2;
-                alert(AlertLevel::Critical, AlertDescription::CloseNotify);
+                // A close_notify is always a warning, and a fatal one would make the server throw away our session.
+                alert(AlertLevel::Warning, AlertDescription::CloseNotify);
                 m_context.connection_finished = true;
             }
             m_context.error_code = (Error)code;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2020, Sergey Bugaev <bugaevc@serenityos.org>
+ * Copyright (c) 2020, the SerenityOS developers
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -24,51 +24,51 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <LibThread/BackgroundAction.h>
-#include <LibThread/Thread.h>
-#include <LibThread/Lock.h>
-#include <AK/Queue.h>
+#include <LibCore/DateTime.h>
+#include <LibTLS/SessionCache.h>
 
-static LibThread::Lockable<Queue<Function<void()>>>* s_all_actions;
-static LibThread::Thread* s_background_thread;
+namespace TLS {
 
-static int background_thread_func()
+SessionCache& SessionCache::the()
 {
-    while (true) {
-        Function<void()> work_item;
-        {
-            LOCKER(s_all_actions->lock());
+    static SessionCache* s_the;
+    if (!s_the)
+        s_the = new SessionCache;
+    return *s_the;
+}
 
-            if (!s_all_actions->resource().is_empty())
-                work_item = s_all_actions->resource().dequeue();
-        }
-        if (work_item)
-            work_item();
-        else
-            sleep(1);
+Optional<Session> SessionCache::get(const String& key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return {};
+    if (it->value.session.expiration_time <= Core::DateTime::now().timestamp()) {
+        m_entries.remove(it);
+        return {};
     }
-
-    ASSERT_NOT_REACHED();
+    it->value.last_used = ++m_use_counter;
+    return it->value.session;
 }
 
-static void init()
+void SessionCache::set(const String& key, Session session)
 {
-    s_all_actions = new LibThread::Lockable<Queue<Function<void()>>>();
-    s_background_thread = &LibThread::Thread::construct(background_thread_func).leak_ref();
-    s_background_thread->set_name("Background thread");
-    s_background_thread->start();
+    if (!m_entries.contains(key) && m_entries.size() >= max_sessions) {
+        const String* least_recently_used = nullptr;
+        u64 oldest_use = 0;
+        for (auto& it : m_entries) {
+            if (!least_recently_used || it.value.last_used < oldest_use) {
+                least_recently_used = &it.key;
+                oldest_use = it.value.last_used;
+            }
+        }
+        m_entries.remove(String(*least_recently_used));
+    }
+    m_entries.set(key, { move(session), ++m_use_counter });
 }
 
-LibThread::Lockable<Queue<Function<void()>>>& LibThread::BackgroundActionBase::all_actions()
+void SessionCache::remove(const String& key)
 {
-    if (s_all_actions == nullptr)
-        init();
-    return *s_all_actions;
+    m_entries.remove(key);
 }
 
-LibThread::Thread& LibThread::BackgroundActionBase::background_thread()
-{
-    if (s_background_thread == nullptr)
-        init();
-    return *s_background_thread;
 }
@@ -95,6 +95,7 @@ bool TLSv12::write(const ByteBuffer& buffer)
 bool TLSv12::connect(const String& hostname, int port)
 {
     set_sni(hostname);
+    m_context.session_cache_key = String::format("%s:%d", hostname.characters(), port);
     return Core::Socket::connect(hostname, port);
 }
 
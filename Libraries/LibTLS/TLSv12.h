@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/IPv4Address.h>
+#include <AK/Optional.h>
 #include <AK/WeakPtr.h>
 #include <LibCore/Notifier.h>
 #include <LibCore/Socket.h>
@@ -34,6 +35,7 @@
 #include <LibCrypto/Authentication/HMAC.h>
 #include <LibCrypto/BigInt/UnsignedBigInteger.h>
 #include <LibCrypto/Cipher/AES.h>
+#include <LibCrypto/Curves/EllipticCurve.h>
 #include <LibCrypto/Hash/HashManager.h>
 #include <LibCrypto/PK/RSA.h>
 #include <LibTLS/TLSPacketBuilder.h>
@@ -71,6 +73,12 @@ enum class CipherSuite {
     // TODO
     RSA_WITH_AES_128_GCM_SHA256 = 0x009C,
     RSA_WITH_AES_256_GCM_SHA384 = 0x009D,
+
+    // Ephemeral elliptic curve Diffie-Hellman, signed by an RSA certificate (RFC 4492, RFC 5289)
+    ECDHE_RSA_WITH_AES_128_CBC_SHA = 0xC013,
+    ECDHE_RSA_WITH_AES_256_CBC_SHA = 0xC014,
+    ECDHE_RSA_WITH_AES_128_CBC_SHA256 = 0xC027,
+    ECDHE_RSA_WITH_AES_128_GCM_SHA256 = 0xC02F,
 };
 
 #define ENUMERATE_ALERT_DESCRIPTIONS                        \
@@ -155,6 +163,7 @@ enum HandshakeType {
     ClientHello = 0x01,
     ServerHello = 0x02,
     HelloVerifyRequest = 0x03,
+    NewSessionTicket = 0x04,
     CertificateMessage = 0x0b,
     ServerKeyExchange = 0x0c,
     CertificateRequest = 0x0d,
@@ -167,7 +176,22 @@ enum HandshakeType {
 enum class HandshakeExtension : u16 {
     ServerName = 0x00,
     ApplicationLayerProtocolNegotiation = 0x10,
+    SupportedGroups = 0x0a,
+    ECPointFormats = 0x0b,
     SignatureAlgorithms = 0x0d,
+    SessionTicket = 0x23,
+};
+
+enum class NamedCurve : u16 {
+    SECP256r1 = 0x0017,
+    X25519 = 0x001d,
+};
+
+// The (hash, signature) pairs from RFC 5246, section 7.4.1.4.1.
+enum class SignatureScheme : u16 {
+    RSA_PKCS1_SHA1 = 0x0201,
+    RSA_PKCS1_SHA256 = 0x0401,
+    RSA_PKCS1_SHA512 = 0x0601,
 };
 
 enum class WritePacketStage {
@@ -231,6 +255,16 @@ struct Certificate {
     bool is_valid() const;
 };
 
+// What it takes to resume a session with an abbreviated handshake, either by its ID or with a ticket (RFC 5077).
+struct Session {
+    CipherSuite cipher { CipherSuite::Invalid };
+    u8 session_id[32];
+    u8 session_id_size { 0 };
+    ByteBuffer ticket;
+    ByteBuffer master_key;
+    time_t expiration_time { 0 };
+};
+
 struct Context {
     String to_string() const;
     bool verify() const;
@@ -251,6 +285,8 @@ struct Context {
     Vector<Certificate> client_certificates;
     ByteBuffer master_key;
     ByteBuffer premaster_key;
+    // Our half of an ECDHE key exchange, agreed upon when the server sent its own, and sent in the ClientKeyExchange.
+    ByteBuffer ecdhe_public_key;
     u8 cipher_spec_set { 0 };
     struct {
         int created { 0 };
@@ -297,6 +333,13 @@ struct Context {
     size_t send_retries { 0 };
 
     time_t handshake_initiation_timestamp { 0 };
+
+    // Session resumption, see SessionCache.
+    String session_cache_key;
+    Optional<Session> offered_session;
+    bool is_resuming_session { false };
+    ByteBuffer session_ticket;
+    u32 session_ticket_lifetime { 0 };
 };
 
 class TLSv12 : public Core::Socket {
@@ -334,9 +377,23 @@ public:
 
     bool supports_cipher(CipherSuite suite) const
     {
-        return suite == CipherSuite::RSA_WITH_AES_128_CBC_SHA256 || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA256 || suite == CipherSuite::RSA_WITH_AES_128_CBC_SHA || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA;
+        switch (suite) {
+        case CipherSuite::RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
+        case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+            return true;
+        default:
+            return false;
+        }
     }
 
+
     bool supports_version(Version v) const
     {
         return v == Version::V12;
@@ -385,6 +442,7 @@ private:
     ByteBuffer build_change_cipher_spec();
     ByteBuffer build_verify_request();
     void build_random(PacketBuilder&);
+    void build_ecdhe_key_exchange(PacketBuilder&);
 
     bool flush();
     void write_into_socket();
@@ -396,11 +454,16 @@ private:
     ssize_t handle_finished(const ByteBuffer& buffer, WritePacketStage&);
     ssize_t handle_certificate(const ByteBuffer& buffer);
     ssize_t handle_server_key_exchange(const ByteBuffer& buffer);
+    bool verify_server_key_exchange_signature(SignatureScheme, ReadonlyBytes params, ReadonlyBytes signature);
     ssize_t handle_server_hello_done(const ByteBuffer& buffer);
     ssize_t handle_verify(const ByteBuffer& buffer);
     ssize_t handle_payload(const ByteBuffer& buffer);
     ssize_t handle_message(const ByteBuffer& buffer);
     ssize_t handle_random(const ByteBuffer& buffer);
+    ssize_t handle_new_session_ticket(const ByteBuffer& buffer);
+
+    void did_complete_handshake();
+    void store_session();
 
     size_t asn1_length(const ByteBuffer& buffer, size_t* octets);
 
@@ -416,31 +479,68 @@ private:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
         default:
             return 128 / 8;
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
             return 256 / 8;
         }
     }
+    static constexpr size_t aead_explicit_nonce_size = 8;
+    static constexpr size_t aead_tag_size = 16;
+
+    bool is_aead() const
+    {
+        switch (m_context.cipher) {
+        case CipherSuite::AES_128_GCM_SHA256:
+        case CipherSuite::AES_256_GCM_SHA384:
+        case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
+        case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+            return true;
+        default:
+            return false;
+        }
+    }
+    bool is_ecdhe() const
+    {
+        switch (m_context.cipher) {
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+            return true;
+        default:
+            return false;
+        }
+    }
     size_t mac_length() const
     {
         switch (m_context.cipher) {
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
             return Crypto::Hash::SHA1::digest_size();
+        case CipherSuite::AES_128_GCM_SHA256:
         case CipherSuite::AES_256_GCM_SHA384:
+        case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
-            return Crypto::Hash::SHA512::digest_size();
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+            // AEAD records carry their own authentication tag.
+            return 0;
         case CipherSuite::AES_128_CCM_8_SHA256:
         case CipherSuite::AES_128_CCM_SHA256:
-        case CipherSuite::AES_128_GCM_SHA256:
         case CipherSuite::Invalid:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA256:
-        case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
         default:
             return Crypto::Hash::SHA256::digest_size();
         }
@@ -455,13 +555,19 @@ private:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_256_CBC_SHA:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_CBC_SHA256:
         default:
             return 16;
         case CipherSuite::AES_128_GCM_SHA256:
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
-            return 12;
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+            // Only the implicit part of the nonce comes out of the key block, the other
+            // eight bytes are sent along with every record (RFC 5288, section 3).
+            return 4;
         }
     }
 
@@ -479,6 +585,9 @@ private:
     OwnPtr<Crypto::Cipher::AESCipher::CBCMode> m_aes_local;
     OwnPtr<Crypto::Cipher::AESCipher::CBCMode> m_aes_remote;
 
+    OwnPtr<Crypto::Cipher::AESCipher::GCMMode> m_aes_gcm_local;
+    OwnPtr<Crypto::Cipher::AESCipher::GCMMode> m_aes_gcm_remote;
+
     bool m_has_scheduled_write_flush { false };
     i32 m_max_wait_time_for_handshake_in_seconds { 10 };
 
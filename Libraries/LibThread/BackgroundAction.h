@@ -29,32 +29,17 @@
 #include <AK/Function.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/Optional.h>
-#include <AK/Queue.h>
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/Object.h>
-#include <LibThread/Lock.h>
-#include <LibThread/Thread.h>
+#include <LibThread/ThreadPool.h>
 
 namespace LibThread {
 
+// Runs an action on ThreadPool::the() and hands its result to on_complete on the event loop
+// that created it. The action keeps itself alive until then, so callers don't need to hold on to it.
 template<typename Result>
-class BackgroundAction;
-
-class BackgroundActionBase {
-    template<typename Result>
-    friend class BackgroundAction;
-
-private:
-    BackgroundActionBase() {}
-
-    static Lockable<Queue<Function<void()>>>& all_actions();
-    static Thread& background_thread();
-};
-
-template<typename Result>
-class BackgroundAction final : public Core::Object
-    , private BackgroundActionBase {
+class BackgroundAction final : public Core::Object {
     C_OBJECT(BackgroundAction);
 
 public:
@@ -69,28 +54,28 @@ public:
 
 private:
     BackgroundAction(Function<Result()> action, Function<void(Result)> on_complete)
-        : Core::Object(&background_thread())
+        : Core::Object(nullptr)
         , m_action(move(action))
         , m_on_complete(move(on_complete))
+        , m_event_loop(Core::EventLoop::current())
     {
-        LOCKER(all_actions().lock());
-
-        all_actions().resource().enqueue([this] {
+        // Core::Objects must only be destroyed on their own thread, so the reference that keeps us
+        // alive is always dropped back on the event loop, even when there's nothing to call.
+        this->ref();
+        ThreadPool::the().enqueue([this] {
             m_result = m_action();
-            if (m_on_complete) {
-                Core::EventLoop::current().post_event(*this, make<Core::DeferredInvocationEvent>([this](auto&) {
+            m_event_loop.post_event(*this, make<Core::DeferredInvocationEvent>([this](auto&) {
+                if (m_on_complete)
                     m_on_complete(m_result.release_value());
-                    this->remove_from_parent();
-                }));
-                Core::EventLoop::wake();
-            } else {
-                this->remove_from_parent();
-            }
+                this->unref();
+            }));
+            Core::EventLoop::wake();
         });
     }
 
     Function<Result()> m_action;
     Function<void(Result)> m_on_complete;
+    Core::EventLoop& m_event_loop;
     Optional<Result> m_result;
 };
 
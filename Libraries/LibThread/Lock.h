@@ -31,6 +31,7 @@
 #    include <AK/Assertions.h>
 #    include <AK/Atomic.h>
 #    include <AK/Types.h>
+#    include <serenity.h>
 #    include <unistd.h>
 
 namespace LibThread {
@@ -44,6 +45,10 @@ public:
     void unlock();
 
 private:
+    void lock_slow();
+
+    // 0 when free, 1 when held, 2 when held with someone asleep on it.
+    Atomic<u32> m_state { 0 };
     Atomic<pid_t> m_holder { 0 };
     u32 m_level { 0 };
 };
@@ -66,28 +71,40 @@ private:
 ALWAYS_INLINE void Lock::lock()
 {
     pid_t tid = gettid();
-    if (m_holder == tid) {
+    if (m_holder.load(AK::memory_order_relaxed) == tid) {
         ++m_level;
         return;
     }
-    for (;;) {
-        int expected = 0;
-        if (m_holder.compare_exchange_strong(expected, tid, AK::memory_order_acq_rel)) {
-            m_level = 1;
+    u32 expected = 0;
+    if (!m_state.compare_exchange_strong(expected, 1, AK::memory_order_acquire))
+        lock_slow();
+    m_holder.store(tid, AK::memory_order_relaxed);
+    m_level = 1;
+}
+
+inline void Lock::lock_slow()
+{
+    for (int i = 0; i < 100; ++i) {
+        u32 value = m_state.load(AK::memory_order_relaxed);
+        if (value == 2)
+            break;
+        if (value == 0 && m_state.compare_exchange_strong(value, 1, AK::memory_order_acquire))
             return;
-        }
-        donate(expected);
+        __builtin_ia32_pause();
     }
+    while (m_state.exchange(2, AK::memory_order_acquire) != 0)
+        futex(reinterpret_cast<int32_t*>(const_cast<u32*>(m_state.ptr())), FUTEX_WAIT | FUTEX_PRIVATE_FLAG, 2, nullptr, nullptr, 0);
 }
 
 inline void Lock::unlock()
 {
-    ASSERT(m_holder == gettid());
+    ASSERT(m_holder.load(AK::memory_order_relaxed) == gettid());
     ASSERT(m_level);
-    if (m_level == 1)
-        m_holder.store(0, AK::memory_order_release);
-    else
-        --m_level;
+    if (--m_level)
+        return;
+    m_holder.store(0, AK::memory_order_relaxed);
+    if (m_state.exchange(0, AK::memory_order_release) == 2)
+        futex(reinterpret_cast<int32_t*>(const_cast<u32*>(m_state.ptr())), FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, nullptr, nullptr, 0);
 }
 
 #    define LOCKER(lock) LibThread::Locker locker(lock)
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/QuickSort.h>
+#include <AK/Vector.h>
+#include <LibThread/ThreadPool.h>
+
+namespace LibThread {
+
+// Below this many elements, handing work to other threads costs more than it saves.
+static constexpr size_t parallel_sort_threshold = 16384;
+
+namespace Detail {
+
+template<typename T, typename LessThan>
+void merge_runs(T* a, T* a_end, T* b, T* b_end, T* out, LessThan& less_than)
+{
+    while (a != a_end && b != b_end) {
+        if (less_than(*b, *a))
+            *out++ = move(*b++);
+        else
+            *out++ = move(*a++);
+    }
+    while (a != a_end)
+        *out++ = move(*a++);
+    while (b != b_end)
+        *out++ = move(*b++);
+}
+
+// Number of elements in the sorted range [begin, end) that are less than value.
+template<typename T, typename LessThan>
+size_t count_less_than(const T* begin, const T* end, const T& value, LessThan& less_than)
+{
+    size_t low = 0;
+    size_t high = end - begin;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (less_than(begin[middle], value))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+}
+
+// Sorts the vector with a merge sort spread across the threads of a ThreadPool:
+// each thread sorts a slice on its own, then the slices are merged pairwise, with
+// big merges split into independent pieces so that every pass keeps all threads busy.
+// Like quick_sort(), which it falls back to for small inputs, it is not stable.
+// The elements have to be default constructible and movable.
+template<typename T, typename LessThan>
+void parallel_sort(Vector<T>& values, LessThan less_than, ThreadPool& pool = ThreadPool::the())
+{
+    size_t size = values.size();
+    size_t job_count = pool.worker_count() + 1;
+    if (size < parallel_sort_threshold || job_count < 2) {
+        quick_sort(values, move(less_than));
+        return;
+    }
+
+    Vector<size_t> run_starts;
+    for (size_t i = 0; i < job_count; ++i)
+        run_starts.append(size * i / job_count);
+    run_starts.append(size);
+
+    {
+        Vector<Function<void()>> jobs;
+        T* data = values.data();
+        for (size_t i = 0; i < job_count; ++i) {
+            size_t begin = run_starts[i];
+            size_t end = run_starts[i + 1];
+            jobs.append([data, begin, end, &less_than] { quick_sort(data + begin, data + end, less_than); });
+        }
+        pool.run(move(jobs));
+    }
+
+    Vector<T> buffer;
+    buffer.resize(size);
+    T* from = values.data();
+    T* to = buffer.data();
+
+    while (run_starts.size() > 2) {
+        size_t run_count = run_starts.size() - 1;
+        size_t merge_count = run_count / 2;
+        size_t pieces_per_merge = max((size_t)1, job_count / merge_count);
+
+        Vector<Function<void()>> jobs;
+        Vector<size_t> merged_run_starts;
+        for (size_t run = 0; run + 1 < run_count; run += 2) {
+            T* a = from + run_starts[run];
+            T* b = from + run_starts[run + 1];
+            T* b_end = from + run_starts[run + 2];
+            T* out = to + run_starts[run];
+            size_t a_size = b - a;
+            merged_run_starts.append(run_starts[run]);
+
+            // Cut A into equal pieces and B where each of those pieces begins, so that
+            // the pieces can be merged independently straight into their final place.
+            size_t previous_a = 0;
+            size_t previous_b = 0;
+            for (size_t piece = 1; piece <= pieces_per_merge; ++piece) {
+                size_t next_a = a_size * piece / pieces_per_merge;
+                size_t next_b = piece == pieces_per_merge
+                    ? b_end - b
+                    : Detail::count_less_than(b, b_end, a[next_a], less_than);
+                jobs.append([=, &less_than] {
+                    Detail::merge_runs(a + previous_a, a + next_a, b + previous_b, b + next_b, out + previous_a + previous_b, less_than);
+                });
+                previous_a = next_a;
+                previous_b = next_b;
+            }
+        }
+        if (run_count % 2) {
+            size_t begin = run_starts[run_count - 1];
+            merged_run_starts.append(begin);
+            jobs.append([=] {
+                for (size_t i = begin; i < size; ++i)
+                    to[i] = move(from[i]);
+            });
+        }
+        merged_run_starts.append(size);
+        pool.run(move(jobs));
+
+        run_starts = move(merged_run_starts);
+        swap(from, to);
+    }
+
+    if (from != values.data())
+        swap(values, buffer);
+}
+
+}
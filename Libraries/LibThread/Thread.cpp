@@ -45,8 +45,9 @@ LibThread::Thread::~Thread()
 
 void LibThread::Thread::start()
 {
+    pthread_t tid;
     int rc = pthread_create(
-        &m_tid,
+        &tid,
         nullptr,
         [](void* arg) -> void* {
             Thread* self = static_cast<Thread*>(arg);
@@ -57,11 +58,27 @@ void LibThread::Thread::start()
         static_cast<void*>(this));
 
     ASSERT(rc == 0);
+    // The thread clears m_tid itself when it finishes, so keep a separate copy for join().
+    m_tid = tid;
+    m_joinable_tid = tid;
     if (!m_thread_name.is_empty()) {
-        rc = pthread_setname_np(m_tid, m_thread_name.characters());
+        rc = pthread_setname_np(tid, m_thread_name.characters());
         ASSERT(rc == 0);
     }
-    dbg() << "Started a thread, tid = " << m_tid;
+    dbg() << "Started a thread, tid = " << tid;
+}
+
+int LibThread::Thread::join()
+{
+    ASSERT(m_joinable_tid);
+    ASSERT(m_joinable_tid != pthread_self());
+
+    void* exit_code = nullptr;
+    int rc = pthread_join(m_joinable_tid, &exit_code);
+    ASSERT(rc == 0);
+    m_joinable_tid = 0;
+    m_tid = 0;
+    return (int)(size_t)exit_code;
 }
 
 void LibThread::Thread::quit(void *code)
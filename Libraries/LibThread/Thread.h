@@ -43,9 +43,13 @@ public:
     void start();
     void quit(void *code = 0);
 
+    // Waits for the thread to finish and returns what its action returned.
+    int join();
+
 private:
     Function<int()> m_action;
     pthread_t m_tid { 0 };
+    pthread_t m_joinable_tid { 0 };
     String m_thread_name;
 };
 
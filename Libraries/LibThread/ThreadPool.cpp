@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibThread/ThreadPool.h>
+#include <unistd.h>
+
+namespace LibThread {
+
+// Which pool and worker the current thread belongs to, if any.
+static __thread ThreadPool* t_pool;
+static __thread size_t t_worker_index;
+
+ThreadPool& ThreadPool::the()
+{
+    static ThreadPool* s_the;
+    static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+    pthread_once(&s_once, [] {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        s_the = new ThreadPool(cpu_count > 2 ? cpu_count - 1 : 1);
+    });
+    return *s_the;
+}
+
+ThreadPool::Worker::Worker()
+{
+    pthread_mutex_init(&lock, nullptr);
+}
+
+ThreadPool::Worker::~Worker()
+{
+    pthread_mutex_destroy(&lock);
+}
+
+void ThreadPool::Worker::push(Job&& job)
+{
+    pthread_mutex_lock(&lock);
+    jobs.append(move(job));
+    pthread_mutex_unlock(&lock);
+}
+
+Optional<ThreadPool::Job> ThreadPool::Worker::pop_newest()
+{
+    Optional<Job> job;
+    pthread_mutex_lock(&lock);
+    if (oldest_index < jobs.size()) {
+        job = jobs.take_last();
+        if (oldest_index == jobs.size()) {
+            jobs.clear_with_capacity();
+            oldest_index = 0;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return job;
+}
+
+Optional<ThreadPool::Job> ThreadPool::Worker::steal_oldest()
+{
+    Optional<Job> job;
+    pthread_mutex_lock(&lock);
+    if (oldest_index < jobs.size()) {
+        job = move(jobs[oldest_index++]);
+        if (oldest_index == jobs.size()) {
+            jobs.clear_with_capacity();
+            oldest_index = 0;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return job;
+}
+
+ThreadPool::ThreadPool(size_t worker_count)
+{
+    for (size_t i = 0; i < worker_count; ++i)
+        m_workers.append(make<Worker>());
+
+    // Only start the threads once all the deques exist, since they go looking in each other's.
+    for (size_t i = 0; i < worker_count; ++i) {
+        auto thread = Thread::construct([this, i] { return worker_main(i); }, "ThreadPool");
+        thread->start();
+        m_workers[i].thread = move(thread);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_exiting.store(true);
+    pthread_cond_broadcast(&m_work_available);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (auto& worker : m_workers)
+        worker.thread->join();
+}
+
+void ThreadPool::enqueue(Function<void()> job)
+{
+    if (m_workers.is_empty()) {
+        job();
+        return;
+    }
+
+    size_t worker_index;
+    if (t_pool == this)
+        worker_index = t_worker_index;
+    else
+        worker_index = m_next_worker.fetch_add(1, AK::memory_order_relaxed) % m_workers.size();
+
+    // Count the job before it becomes visible, so that taking it can never make the count wrap.
+    // Sleeping workers re-check the count after announcing themselves, so either they see
+    // this job or we see them and wake one up.
+    m_queued_job_count.fetch_add(1);
+    m_workers[worker_index].push(move(job));
+    if (m_sleeping_worker_count.load()) {
+        pthread_mutex_lock(&m_mutex);
+        pthread_cond_signal(&m_work_available);
+        pthread_mutex_unlock(&m_mutex);
+    }
+}
+
+Optional<ThreadPool::Job> ThreadPool::find_job(Optional<size_t> own_worker_index)
+{
+    if (!m_queued_job_count.load(AK::memory_order_relaxed))
+        return {};
+
+    size_t first_victim = 0;
+    if (own_worker_index.has_value()) {
+        if (auto job = m_workers[own_worker_index.value()].pop_newest(); job.has_value())
+            return job;
+        first_victim = own_worker_index.value() + 1;
+    }
+
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        size_t victim = (first_victim + i) % m_workers.size();
+        if (own_worker_index.has_value() && victim == own_worker_index.value())
+            continue;
+        if (auto job = m_workers[victim].steal_oldest(); job.has_value())
+            return job;
+    }
+    return {};
+}
+
+void ThreadPool::run_job(Job& job)
+{
+    m_queued_job_count.fetch_sub(1);
+    job();
+}
+
+bool ThreadPool::run_one_pending_job()
+{
+    Optional<size_t> own_worker_index;
+    if (t_pool == this)
+        own_worker_index = t_worker_index;
+
+    auto job = find_job(own_worker_index);
+    if (!job.has_value())
+        return false;
+    run_job(job.value());
+    return true;
+}
+
+int ThreadPool::worker_main(size_t worker_index)
+{
+    t_pool = this;
+    t_worker_index = worker_index;
+
+    while (!m_exiting.load()) {
+        if (auto job = find_job(worker_index); job.has_value()) {
+            run_job(job.value());
+            continue;
+        }
+
+        pthread_mutex_lock(&m_mutex);
+        m_sleeping_worker_count.fetch_add(1);
+        while (!m_queued_job_count.load() && !m_exiting.load())
+            pthread_cond_wait(&m_work_available, &m_mutex);
+        m_sleeping_worker_count.fetch_sub(1);
+        pthread_mutex_unlock(&m_mutex);
+    }
+    return 0;
+}
+
+void ThreadPool::run(Vector<Function<void()>>&& jobs)
+{
+    if (jobs.is_empty())
+        return;
+
+    Atomic<size_t> remaining { jobs.size() };
+    for (auto& job : jobs) {
+        enqueue([this, &remaining, job = move(job)] {
+            job();
+            if (remaining.fetch_sub(1) == 1) {
+                pthread_mutex_lock(&m_mutex);
+                pthread_cond_broadcast(&m_job_finished);
+                pthread_mutex_unlock(&m_mutex);
+            }
+        });
+    }
+
+    // Help out instead of idling; this may also pick up unrelated jobs, which is fine.
+    while (remaining.load()) {
+        if (run_one_pending_job())
+            continue;
+        pthread_mutex_lock(&m_mutex);
+        while (remaining.load())
+            pthread_cond_wait(&m_job_finished, &m_mutex);
+        pthread_mutex_unlock(&m_mutex);
+    }
+}
+
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/Optional.h>
+#include <AK/RefCounted.h>
+#include <AK/Vector.h>
+#include <LibThread/Thread.h>
+#include <pthread.h>
+
+namespace LibThread {
+
+class ThreadPool;
+
+// The result of a job submitted to a ThreadPool.
+template<typename Result>
+class Future : public RefCounted<Future<Result>> {
+    friend class ThreadPool;
+
+public:
+    ~Future()
+    {
+        pthread_mutex_destroy(&m_mutex);
+        pthread_cond_destroy(&m_ready_condition);
+    }
+
+    bool is_ready() const { return m_ready.load(AK::memory_order_acquire); }
+
+    // Blocks until the job has run, helping out with other queued jobs in the meantime.
+    Result& await();
+
+private:
+    explicit Future(ThreadPool& pool)
+        : m_pool(pool)
+    {
+    }
+
+    void resolve(Result&& result)
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_result = move(result);
+        m_ready.store(true, AK::memory_order_release);
+        pthread_cond_broadcast(&m_ready_condition);
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    ThreadPool& m_pool;
+    Optional<Result> m_result;
+    Atomic<bool> m_ready { false };
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_ready_condition = PTHREAD_COND_INITIALIZER;
+};
+
+// A fixed set of worker threads for spreading CPU-bound work across cores.
+// Every worker has its own deque of jobs: it takes the newest job from its own deque, and when
+// that runs dry, steals the oldest job from another worker's. Jobs queued from outside the pool
+// are dealt out round-robin, so workers rarely contend on the same lock.
+class ThreadPool {
+public:
+    // The shared pool, with one worker per online CPU besides the calling thread (but at least one).
+    static ThreadPool& the();
+
+    explicit ThreadPool(size_t worker_count);
+    ~ThreadPool();
+
+    size_t worker_count() const { return m_workers.size(); }
+
+    // Queues a job to run on one of the workers. A pool without workers runs it right away.
+    void enqueue(Function<void()>);
+
+    template<typename Result>
+    NonnullRefPtr<Future<Result>> submit(Function<Result()> function)
+    {
+        auto future = adopt(*new Future<Result>(*this));
+        // The job keeps a reference of its own, since the caller may let go of the future before it runs.
+        auto* job_future = future.ptr();
+        job_future->ref();
+        enqueue([job_future, function = move(function)] {
+            job_future->resolve(function());
+            job_future->unref();
+        });
+        return future;
+    }
+
+    // Runs all the jobs, using the calling thread as one more worker, and waits for them.
+    void run(Vector<Function<void()>>&& jobs);
+
+    // Runs one queued job on the calling thread, if there is one. Returns whether it did.
+    bool run_one_pending_job();
+
+private:
+    using Job = Function<void()>;
+
+    struct Worker {
+        Worker();
+        ~Worker();
+
+        void push(Job&&);
+        Optional<Job> pop_newest();
+        Optional<Job> steal_oldest();
+
+        pthread_mutex_t lock;
+        Vector<Job> jobs;
+        size_t oldest_index { 0 };
+        RefPtr<Thread> thread;
+    };
+
+    int worker_main(size_t worker_index);
+    Optional<Job> find_job(Optional<size_t> own_worker_index);
+    void run_job(Job&);
+
+    NonnullOwnPtrVector<Worker> m_workers;
+    Atomic<size_t> m_next_worker { 0 };
+
+    // Sleeping and waking up happen under m_mutex; finding and running jobs does not.
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_work_available = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t m_job_finished = PTHREAD_COND_INITIALIZER;
+    Atomic<size_t> m_queued_job_count { 0 };
+    Atomic<size_t> m_sleeping_worker_count { 0 };
+    Atomic<bool> m_exiting { false };
+};
+
+template<typename Result>
+Result& Future<Result>::await()
+{
+    while (!is_ready()) {
+        if (m_pool.run_one_pending_job())
+            continue;
+        pthread_mutex_lock(&m_mutex);
+        while (!is_ready())
+            pthread_cond_wait(&m_ready_condition, &m_mutex);
+        pthread_mutex_unlock(&m_mutex);
+    }
+    return m_result.value();
+}
+
+}
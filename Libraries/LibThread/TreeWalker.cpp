@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Vector.h>
+#include <LibThread/TreeWalker.h>
+#include <dirent.h>
+#include <errno.h>
+#include <unistd.h>
+
+namespace LibThread {
+
+struct TreeWalker::Child {
+    Entry entry;
+    // The listing of this directory, if it is being read ahead.
+    RefPtr<Future<Listing>> listing;
+};
+
+struct TreeWalker::Listing {
+    Vector<Child> children;
+    int error { 0 };
+};
+
+bool TreeWalker::Entry::is_directory() const
+{
+    if (has_stat)
+        return S_ISDIR(stat.st_mode);
+    return type == DT_DIR;
+}
+
+static unsigned char type_from_mode(mode_t mode)
+{
+    if (S_ISDIR(mode))
+        return DT_DIR;
+    if (S_ISREG(mode))
+        return DT_REG;
+    if (S_ISLNK(mode))
+        return DT_LNK;
+    if (S_ISCHR(mode))
+        return DT_CHR;
+    if (S_ISBLK(mode))
+        return DT_BLK;
+    if (S_ISFIFO(mode))
+        return DT_FIFO;
+    if (S_ISSOCK(mode))
+        return DT_SOCK;
+    return DT_UNKNOWN;
+}
+
+TreeWalker::TreeWalker(ThreadPool& pool)
+    : m_pool(pool)
+{
+    // On a single CPU, reading ahead would only take turns with the walk itself.
+    m_max_directories_ahead = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 256 : 0;
+}
+
+void TreeWalker::stat_if_needed(Entry& entry, bool is_root)
+{
+    bool needs_stat = is_root || entry.type == DT_UNKNOWN || (m_follow_symlinks && entry.type == DT_LNK);
+    switch (m_stat_entries) {
+    case StatEntries::WhenNeeded:
+        break;
+    case StatEntries::Directories:
+        needs_stat |= entry.type == DT_DIR;
+        break;
+    case StatEntries::Everything:
+        needs_stat = true;
+        break;
+    }
+    if (!needs_stat)
+        return;
+
+    auto stat_function = m_follow_symlinks ? ::stat : ::lstat;
+    if (stat_function(entry.path.characters(), &entry.stat) < 0)
+        return;
+    entry.has_stat = true;
+    entry.type = type_from_mode(entry.stat.st_mode);
+}
+
+TreeWalker::Listing TreeWalker::list_directory(const String& path, size_t depth)
+{
+    Listing listing;
+    DIR* dir = opendir(path.characters());
+    if (!dir) {
+        listing.error = errno;
+        return listing;
+    }
+
+    for (;;) {
+        errno = 0;
+        auto* dirent = readdir(dir);
+        if (!dirent) {
+            listing.error = errno;
+            break;
+        }
+        StringView name = dirent->d_name;
+        if (name == "." || name == "..")
+            continue;
+
+        Child child;
+        child.entry.path = String::format("%s/%s", path.characters(), dirent->d_name);
+        child.entry.depth = depth + 1;
+        child.entry.type = dirent->d_type;
+        stat_if_needed(child.entry, false);
+        listing.children.append(move(child));
+    }
+    closedir(dir);
+
+    // Start reading the subdirectories only now, so that those of one directory get read in the order they are walked in.
+    for (auto& child : listing.children) {
+        if (!child.entry.is_directory() || child.entry.depth >= m_max_depth)
+            continue;
+        if (m_directories_ahead.fetch_add(1) >= m_max_directories_ahead) {
+            m_directories_ahead.fetch_sub(1);
+            break;
+        }
+        child.listing = m_pool.submit<Listing>([this, path = child.entry.path, depth = child.entry.depth] {
+            return list_directory(path, depth);
+        });
+    }
+    return listing;
+}
+
+void TreeWalker::visit(Entry& entry, RefPtr<Future<Listing>> read_ahead_listing)
+{
+    if (on_entry)
+        on_entry(entry);
+    if (!entry.is_directory())
+        return;
+    if (entry.depth >= m_max_depth) {
+        if (on_leave_directory)
+            on_leave_directory(entry);
+        return;
+    }
+
+    Listing listing;
+    if (read_ahead_listing) {
+        listing = move(read_ahead_listing->await());
+        read_ahead_listing = nullptr;
+        m_directories_ahead.fetch_sub(1);
+    } else {
+        listing = list_directory(entry.path, entry.depth);
+    }
+
+    for (auto& child : listing.children)
+        visit(child.entry, move(child.listing));
+    if (listing.error && on_error)
+        on_error(entry.path, listing.error);
+    if (on_leave_directory)
+        on_leave_directory(entry);
+}
+
+void TreeWalker::walk(const String& root_path)
+{
+    Entry root;
+    root.path = root_path;
+    stat_if_needed(root, true);
+    if (!root.has_stat) {
+        if (on_error)
+            on_error(root_path, errno);
+        return;
+    }
+    visit(root, nullptr);
+}
+
+}
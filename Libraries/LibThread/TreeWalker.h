@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/NumericLimits.h>
+#include <AK/String.h>
+#include <LibThread/ThreadPool.h>
+#include <sys/stat.h>
+
+namespace LibThread {
+
+// Walks directory trees depth-first like a plain recursive walk, and reports the entries in the same
+// order, but reads the directories ahead of that walk on a ThreadPool, many at a time.
+// The callbacks all run on the thread that called walk().
+class TreeWalker {
+public:
+    struct Entry {
+        String path;
+        // 0 for the path the walk started from.
+        size_t depth { 0 };
+        // One of the DT_* constants from <dirent.h>, DT_UNKNOWN if neither the directory nor a stat() said.
+        unsigned char type { 0 };
+        // Unset for entries that weren't asked to be stat()ed, or couldn't be.
+        bool has_stat { false };
+        struct stat stat;
+
+        bool is_directory() const;
+    };
+
+    enum class StatEntries {
+        // Only when the directory listing doesn't say whether an entry is a directory.
+        WhenNeeded,
+        Directories,
+        Everything,
+    };
+
+    TreeWalker(ThreadPool& = ThreadPool::the());
+
+    // Follow symbolic links with stat() rather than looking at the links themselves.
+    void set_follow_symlinks(bool follow_symlinks) { m_follow_symlinks = follow_symlinks; }
+    void set_stat_entries(StatEntries stat_entries) { m_stat_entries = stat_entries; }
+    // Directories at this depth and deeper are reported, but not looked inside of.
+    void set_max_depth(size_t max_depth) { m_max_depth = max_depth; }
+    // How many directories may be read ahead of the walk, which bounds the memory it takes.
+    // With 0, every directory is read when the walk gets to it.
+    void set_max_directories_ahead(size_t max_directories_ahead) { m_max_directories_ahead = max_directories_ahead; }
+
+    // Called for every entry, before the entries in it.
+    Function<void(const Entry&)> on_entry;
+    // Called for every directory, after the entries in it if it was looked inside of.
+    Function<void(const Entry&)> on_leave_directory;
+    // Called with an errno value when the path the walk starts from can't be stat()ed or a directory can't be read.
+    Function<void(const String& path, int error)> on_error;
+
+    void walk(const String& root_path);
+
+private:
+    struct Listing;
+    struct Child;
+
+    Listing list_directory(const String& path, size_t depth);
+    void stat_if_needed(Entry&, bool is_root);
+    void visit(Entry&, RefPtr<Future<Listing>>);
+
+    ThreadPool& m_pool;
+    bool m_follow_symlinks { false };
+    StatEntries m_stat_entries { StatEntries::WhenNeeded };
+    size_t m_max_depth { NumericLimits<size_t>::max() };
+    size_t m_max_directories_ahead;
+    Atomic<size_t> m_directories_ahead { 0 };
+};
+
+}
@@ -52,6 +52,7 @@ void Terminal::clear()
 void Terminal::clear_including_history()
 {
     m_history.clear();
+    m_history_start = 0;
     clear();
 
     m_client.terminal_history_changed();
@@ -493,6 +494,7 @@ void Terminal::escape$L(const ParamVector& params)
     }
 
     m_need_full_flush = true;
+    m_scrolled_lines = 0;
 }
 
 void Terminal::DA(const ParamVector&)
@@ -728,19 +730,43 @@ void Terminal::newline()
     set_cursor(new_row, 0);
 }
 
+OwnPtr<Line> Terminal::add_line_to_history(NonnullOwnPtr<Line>&& line)
+{
+    if (m_history.size() < max_history_size()) {
+        m_history.append(move(line));
+        return nullptr;
+    }
+    OwnPtr<Line> oldest = move(m_history.ptr_at(m_history_start));
+    m_history.ptr_at(m_history_start) = move(line);
+    m_history_start = (m_history_start + 1) % m_history.size();
+    return oldest;
+}
+
 void Terminal::scroll_up()
 {
     // NOTE: We have to invalidate the cursor first.
     invalidate_cursor();
+    OwnPtr<Line> recycled_line;
     if (m_scroll_region_top == 0) {
-        auto line = move(m_lines.ptr_at(m_scroll_region_top));
-        m_history.append(move(line));
-        while (m_history.size() > max_history_size())
-            m_history.take_first();
+        recycled_line = add_line_to_history(move(m_lines.ptr_at(m_scroll_region_top)));
         m_client.terminal_history_changed();
     }
     m_lines.remove(m_scroll_region_top);
-    m_lines.insert(m_scroll_region_bottom, make<Line>(m_columns));
+    if (recycled_line) {
+        recycled_line->set_length(m_columns);
+        recycled_line->set_dirty(true);
+        recycled_line->clear({});
+        m_lines.insert(m_scroll_region_bottom, recycled_line.release_nonnull());
+    } else {
+        m_lines.insert(m_scroll_region_bottom, make<Line>(m_columns));
+    }
+    bool only_scrolled = !m_need_full_flush || m_scrolled_lines;
+    if (only_scrolled && m_scroll_region_top == 0 && m_scroll_region_bottom == (size_t)m_rows - 1) {
+        if (m_scrolled_lines < m_rows)
+            ++m_scrolled_lines;
+    } else {
+        m_scrolled_lines = 0;
+    }
     m_need_full_flush = true;
 }
 
@@ -751,6 +777,7 @@ void Terminal::scroll_down()
     m_lines.remove(m_scroll_region_bottom);
     m_lines.insert(m_scroll_region_top, make<Line>(m_columns));
     m_need_full_flush = true;
+    m_scrolled_lines = 0;
 }
 
 void Terminal::set_cursor(unsigned a_row, unsigned a_column)
@@ -981,6 +1008,37 @@ void Terminal::on_input(u8 ch)
     on_code_point(ch);
 }
 
+void Terminal::on_input(const u8* data, size_t size)
+{
+    auto is_printable = [](u8 ch) { return ch >= 0x20 && ch < 0x7f; };
+
+    size_t i = 0;
+    while (i < size) {
+        // Runs of plain ASCII go straight into the current line, leaving the last column
+        // to on_code_point() since that's where line wrapping happens.
+        size_t room = columns() - 1 - m_cursor_column;
+        if (m_parser_state != Normal || m_stomp || !room || !is_printable(data[i])) {
+            on_input(data[i++]);
+            continue;
+        }
+        size_t run_end = i;
+        while (run_end < size && run_end - i < room && is_printable(data[run_end]))
+            ++run_end;
+
+        auto& line = m_lines[m_cursor_row];
+        u16 column = m_cursor_column;
+        for (size_t j = i; j < run_end; ++j, ++column) {
+            line.set_code_point(column, data[j]);
+            line.attributes()[column] = m_current_attribute;
+            line.attributes()[column].flags |= Attribute::Touched;
+        }
+        line.set_dirty(true);
+        m_last_code_point = data[run_end - 1];
+        set_cursor(m_cursor_row, column);
+        i = run_end;
+    }
+}
+
 void Terminal::on_code_point(u32 code_point)
 {
     auto new_column = m_cursor_column + 1;
@@ -28,6 +28,7 @@
 
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <AK/OwnPtr.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <Kernel/API/KeyCode.h>
@@ -55,8 +56,14 @@ public:
 
     bool m_need_full_flush { false };
 
+    // How many times the whole screen scrolled up since the last flush. As long as nothing
+    // else asked for a full flush, a client may shift its output by this many lines and only
+    // redraw dirty lines, instead of redrawing everything.
+    u16 m_scrolled_lines { 0 };
+
     void invalidate_cursor();
     void on_input(u8);
+    void on_input(const u8*, size_t);
 
     void clear();
     void clear_including_history();
@@ -76,13 +83,13 @@ public:
     Line& line(size_t index)
     {
         if (index < m_history.size())
-            return m_history[index];
+            return m_history[(m_history_start + index) % m_history.size()];
         return m_lines[index - m_history.size()];
     }
     const Line& line(size_t index) const
     {
         if (index < m_history.size())
-            return m_history[index];
+            return m_history[(m_history_start + index) % m_history.size()];
         return m_lines[index - m_history.size()];
     }
 
@@ -96,7 +103,7 @@ public:
     }
 
     size_t max_history_size() const { return 500; }
-    const NonnullOwnPtrVector<Line>& history() const { return m_history; }
+    size_t history_size() const { return m_history.size(); }
 
     void inject_string(const StringView&);
     void handle_key_press(KeyCode, u32, u8 flags);
@@ -108,6 +115,9 @@ private:
 
     void on_code_point(u32);
 
+    // Returns the line that fell off the end of the history, for reuse, if the history is full.
+    OwnPtr<Line> add_line_to_history(NonnullOwnPtr<Line>&&);
+
     void scroll_up();
     void scroll_down();
     void newline();
@@ -154,7 +164,9 @@ private:
 
     TerminalClient& m_client;
 
+    // A ring buffer once it reaches max_history_size(), with the oldest line at m_history_start.
     NonnullOwnPtrVector<Line> m_history;
+    size_t m_history_start { 0 };
     NonnullOwnPtrVector<Line> m_lines;
 
     size_t m_scroll_region_top { 0 };
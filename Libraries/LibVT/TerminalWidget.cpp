@@ -64,7 +64,7 @@ void TerminalWidget::set_pty_master_fd(int fd)
     }
     m_notifier = Core::Notifier::construct(m_ptm_fd, Core::Notifier::Read);
     m_notifier->on_ready_to_read = [this] {
-        u8 buffer[BUFSIZ];
+        u8 buffer[16 * KiB];
         ssize_t nread = read(m_ptm_fd, buffer, sizeof(buffer));
         if (nread < 0) {
             dbgprintf("Terminal read error: %s\n", strerror(errno));
@@ -83,9 +83,8 @@ void TerminalWidget::set_pty_master_fd(int fd)
             set_pty_master_fd(-1);
             return;
         }
-        for (ssize_t i = 0; i < nread; ++i)
-            m_terminal.on_input(buffer[i]);
-        flush_dirty_lines();
+        m_terminal.on_input(buffer, nread);
+        schedule_flush();
     };
 }
 
@@ -98,11 +97,18 @@ TerminalWidget::TerminalWidget(int ptm_fd, bool automatic_size_policy, RefPtr<Co
     set_pty_master_fd(ptm_fd);
     m_cursor_blink_timer = add<Core::Timer>();
     m_visual_beep_timer = add<Core::Timer>();
+    m_flush_timer = add<Core::Timer>();
+    m_flush_timer->set_single_shot(true);
+    m_flush_timer->on_timeout = [this] {
+        flush_dirty_lines();
+    };
 
     m_scrollbar = add<GUI::ScrollBar>(Orientation::Vertical);
     m_scrollbar->set_relative_rect(0, 0, 16, 0);
     m_scrollbar->on_change = [this](int) {
-        force_repaint();
+        // Following the output as the history grows doesn't change what's on screen.
+        if (!m_following_output)
+            force_repaint();
     };
     set_scroll_length(m_config->read_num_entry("Window", "ScrollLength", 4));
 
@@ -178,7 +184,7 @@ void TerminalWidget::set_logical_focus(bool focus)
         m_cursor_blink_timer->start();
     }
     invalidate_cursor();
-    update();
+    force_repaint();
 }
 
 void TerminalWidget::focusin_event(GUI::FocusEvent& event)
@@ -234,7 +240,7 @@ void TerminalWidget::keydown_event(GUI::KeyEvent& event)
 
     if (future_cursor_column <= last_selection_column_on_row(m_terminal.cursor_row()) && m_terminal.cursor_row() >= min_selection_row && m_terminal.cursor_row() <= max_selection_row) {
         m_selection_end = {};
-        update();
+        force_repaint();
     }
 
     m_terminal.handle_key_press(event.key(), event.code_point(), event.modifiers());
@@ -254,6 +260,76 @@ void TerminalWidget::keyup_event(GUI::KeyEvent& event)
     }
 }
 
+void TerminalWidget::paint_row(Gfx::Painter& painter, u16 visual_row, int first_row_from_history, int row_with_cursor, bool visual_beep_active)
+{
+    auto& line = m_terminal.line(first_row_from_history + visual_row);
+    auto row_rect = this->row_rect(visual_row);
+    bool has_only_one_background_color = line.has_only_one_background_color();
+    if (visual_beep_active)
+        painter.clear_rect(row_rect, Color::Red);
+    else if (has_only_one_background_color)
+        painter.clear_rect(row_rect, color_from_rgb(line.attributes()[0].background_color).with_alpha(m_opacity));
+
+    for (size_t column = 0; column < line.length(); ++column) {
+        u32 code_point = line.code_point(column);
+        bool should_reverse_fill_for_cursor_or_selection = m_cursor_blink_state
+            && m_has_logical_focus
+            && visual_row == row_with_cursor
+            && column == m_terminal.cursor_column();
+        should_reverse_fill_for_cursor_or_selection |= selection_contains({ first_row_from_history + visual_row, (int)column });
+        auto attribute = line.attributes()[column];
+        auto text_color = color_from_rgb(should_reverse_fill_for_cursor_or_selection ? attribute.background_color : attribute.foreground_color);
+        auto character_rect = glyph_rect(visual_row, column);
+        auto cell_rect = character_rect.inflated(0, m_line_spacing);
+        if ((!visual_beep_active && !has_only_one_background_color) || should_reverse_fill_for_cursor_or_selection) {
+            painter.clear_rect(cell_rect, color_from_rgb(should_reverse_fill_for_cursor_or_selection ? attribute.foreground_color : attribute.background_color).with_alpha(m_opacity));
+        }
+
+        enum class UnderlineStyle {
+            None,
+            Dotted,
+            Solid,
+        };
+
+        auto underline_style = UnderlineStyle::None;
+
+        if (attribute.flags & VT::Attribute::Underline) {
+            // Content has specified underline
+            underline_style = UnderlineStyle::Solid;
+        } else if (!attribute.href.is_empty()) {
+            // We're hovering a hyperlink
+            if (m_hovered_href_id == attribute.href_id || m_active_href_id == attribute.href_id)
+                underline_style = UnderlineStyle::Solid;
+            else
+                underline_style = UnderlineStyle::Dotted;
+        }
+
+        if (underline_style == UnderlineStyle::Solid) {
+            if (attribute.href_id == m_active_href_id && m_hovered_href_id == m_active_href_id)
+                text_color = palette().active_link();
+            painter.draw_line(cell_rect.bottom_left(), cell_rect.bottom_right(), text_color);
+        } else if (underline_style == UnderlineStyle::Dotted) {
+            auto dotted_line_color = text_color.darkened(0.6f);
+            int x1 = cell_rect.bottom_left().x();
+            int x2 = cell_rect.bottom_right().x();
+            int y = cell_rect.bottom_left().y();
+            for (int x = x1; x <= x2; ++x) {
+                if ((x % 3) == 0)
+                    painter.set_pixel({ x, y }, dotted_line_color);
+            }
+        }
+
+        if (code_point == ' ')
+            continue;
+
+        painter.draw_glyph_or_emoji(
+            character_rect.location(),
+            code_point,
+            attribute.flags & VT::Attribute::Bold ? bold_font() : font(),
+            text_color);
+    }
+}
+
 void TerminalWidget::paint_event(GUI::PaintEvent& event)
 {
     GUI::Frame::paint_event(event);
@@ -274,82 +350,56 @@ void TerminalWidget::paint_event(GUI::PaintEvent& event)
     invalidate_cursor();
 
     int rows_from_history = 0;
-    int first_row_from_history = m_terminal.history().size();
+    int first_row_from_history = m_terminal.history_size();
     int row_with_cursor = m_terminal.cursor_row();
     if (m_scrollbar->value() != m_scrollbar->max()) {
         rows_from_history = min((int)m_terminal.rows(), m_scrollbar->max() - m_scrollbar->value());
-        first_row_from_history = m_terminal.history().size() - (m_scrollbar->max() - m_scrollbar->value());
+        first_row_from_history = m_terminal.history_size() - (m_scrollbar->max() - m_scrollbar->value());
         row_with_cursor = m_terminal.cursor_row() + rows_from_history;
     }
 
-    for (u16 visual_row = 0; visual_row < m_terminal.rows(); ++visual_row) {
-        auto row_rect = this->row_rect(visual_row);
-        if (!event.rect().contains(row_rect))
-            continue;
-        auto& line = m_terminal.line(first_row_from_history + visual_row);
-        bool has_only_one_background_color = line.has_only_one_background_color();
-        if (visual_beep_active)
-            painter.clear_rect(row_rect, Color::Red);
-        else if (has_only_one_background_color)
-            painter.clear_rect(row_rect, color_from_rgb(line.attributes()[0].background_color).with_alpha(m_opacity));
-
-        for (size_t column = 0; column < line.length(); ++column) {
-            u32 code_point = line.code_point(column);
-            bool should_reverse_fill_for_cursor_or_selection = m_cursor_blink_state
-                && m_has_logical_focus
-                && visual_row == row_with_cursor
-                && column == m_terminal.cursor_column();
-            should_reverse_fill_for_cursor_or_selection |= selection_contains({ first_row_from_history + visual_row, (int)column });
-            auto attribute = line.attributes()[column];
-            auto text_color = color_from_rgb(should_reverse_fill_for_cursor_or_selection ? attribute.background_color : attribute.foreground_color);
-            auto character_rect = glyph_rect(visual_row, column);
-            auto cell_rect = character_rect.inflated(0, m_line_spacing);
-            if ((!visual_beep_active && !has_only_one_background_color) || should_reverse_fill_for_cursor_or_selection) {
-                painter.clear_rect(cell_rect, color_from_rgb(should_reverse_fill_for_cursor_or_selection ? attribute.foreground_color : attribute.background_color).with_alpha(m_opacity));
-            }
-
-            enum class UnderlineStyle {
-                None,
-                Dotted,
-                Solid,
-            };
-
-            auto underline_style = UnderlineStyle::None;
-
-            if (attribute.flags & VT::Attribute::Underline) {
-                // Content has specified underline
-                underline_style = UnderlineStyle::Solid;
-            } else if (!attribute.href.is_empty()) {
-                // We're hovering a hyperlink
-                if (m_hovered_href_id == attribute.href_id || m_active_href_id == attribute.href_id)
-                    underline_style = UnderlineStyle::Solid;
-                else
-                    underline_style = UnderlineStyle::Dotted;
-            }
-
-            if (underline_style == UnderlineStyle::Solid) {
-                if (attribute.href_id == m_active_href_id && m_hovered_href_id == m_active_href_id)
-                    text_color = palette().active_link();
-                painter.draw_line(cell_rect.bottom_left(), cell_rect.bottom_right(), text_color);
-            } else if (underline_style == UnderlineStyle::Dotted) {
-                auto dotted_line_color = text_color.darkened(0.6f);
-                int x1 = cell_rect.bottom_left().x();
-                int x2 = cell_rect.bottom_right().x();
-                int y = cell_rect.bottom_left().y();
-                for (int x = x1; x <= x2; ++x) {
-                    if ((x % 3) == 0)
-                        painter.set_pixel({ x, y }, dotted_line_color);
-                }
-            }
+    // Rows are drawn into the cache and copied out from there, so that scrolling only has to
+    // draw the lines that came in. That needs an opaque background, though.
+    bool use_row_cache = !visual_beep_active && m_opacity == 255;
+    if (use_row_cache && (!m_row_cache || m_row_cache->size() != size())) {
+        m_row_cache = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, size());
+        m_clean_rows.clear();
+        m_pending_scroll_rows = 0;
+        use_row_cache = m_row_cache;
+    }
+    if (!use_row_cache) {
+        m_row_cache = nullptr;
+        m_clean_rows.clear();
+        m_pending_scroll_rows = 0;
+        for (u16 visual_row = 0; visual_row < m_terminal.rows(); ++visual_row) {
+            if (event.rect().contains(row_rect(visual_row)))
+                paint_row(painter, visual_row, first_row_from_history, row_with_cursor, visual_beep_active);
+        }
+    } else {
+        m_clean_rows.shrink(min(m_clean_rows.size(), (size_t)m_terminal.rows()));
+        while (m_clean_rows.size() < m_terminal.rows())
+            m_clean_rows.append(false);
+
+        if (m_pending_scroll_rows) {
+            int first_line = row_rect(0).top();
+            int last_line = row_rect(m_terminal.rows() - 1).bottom();
+            int distance = m_pending_scroll_rows * m_line_height;
+            size_t pitch = m_row_cache->pitch();
+            for (int y = first_line; y + distance <= last_line; ++y)
+                memcpy(m_row_cache->scanline(y), m_row_cache->scanline(y + distance), pitch);
+            m_pending_scroll_rows = 0;
+        }
 
-            if (code_point == ' ')
+        Gfx::Painter cache_painter(*m_row_cache);
+        for (u16 visual_row = 0; visual_row < m_terminal.rows(); ++visual_row) {
+            auto row_rect = this->row_rect(visual_row);
+            if (!event.rect().contains(row_rect))
                 continue;
-
-            painter.draw_glyph_or_emoji(
-                character_rect.location(),
-                code_point,
-                attribute.flags & VT::Attribute::Bold ? bold_font() : font(),
-                text_color);
+            if (!m_clean_rows[visual_row]) {
+                paint_row(cache_painter, visual_row, first_row_from_history, row_with_cursor, false);
+                m_clean_rows[visual_row] = true;
+            }
+            painter.blit(row_rect.location(), *m_row_cache, row_rect);
         }
     }
 
@@ -388,25 +438,61 @@ void TerminalWidget::invalidate_cursor()
 
 void TerminalWidget::flush_dirty_lines()
 {
-    // FIXME: Update smarter when scrolled
-    if (m_terminal.m_need_full_flush || m_scrollbar->value() != m_scrollbar->max()) {
-        update();
+    m_last_flush_timer.start();
+    m_flush_timer->stop();
+
+    bool at_bottom = m_scrollbar->value() == m_scrollbar->max();
+    bool scrolled = false;
+    // If nothing but scrolling asked for a full flush, the cached rows can move up instead.
+    if (m_terminal.m_need_full_flush && m_terminal.m_scrolled_lines && at_bottom && m_row_cache) {
+        u16 lines = min(m_terminal.m_scrolled_lines, m_terminal.rows());
+        m_pending_scroll_rows += lines;
+        for (size_t i = 0; i < lines && !m_clean_rows.is_empty(); ++i) {
+            m_clean_rows.remove(0);
+            m_clean_rows.append(false);
+        }
+        m_terminal.m_need_full_flush = false;
+        scrolled = true;
+    }
+    m_terminal.m_scrolled_lines = 0;
+
+    if (m_terminal.m_need_full_flush || !at_bottom) {
         m_terminal.m_need_full_flush = false;
+        force_repaint();
         return;
     }
+
     Gfx::IntRect rect;
     for (int i = 0; i < m_terminal.rows(); ++i) {
         if (m_terminal.visible_line(i).is_dirty()) {
             rect = rect.united(row_rect(i));
             m_terminal.visible_line(i).set_dirty(false);
+            if ((size_t)i < m_clean_rows.size())
+                m_clean_rows[i] = false;
         }
     }
+    // Everything moved, but it's still a single rect to repaint.
+    if (scrolled)
+        rect = row_rect(0).united(row_rect(m_terminal.rows() - 1));
     update(rect);
 }
 
+void TerminalWidget::schedule_flush()
+{
+    // Repaint at most once per frame while output keeps coming in.
+    constexpr int flush_interval_ms = 16;
+    if (!m_last_flush_timer.is_valid() || m_last_flush_timer.elapsed() >= flush_interval_ms) {
+        flush_dirty_lines();
+        return;
+    }
+    if (!m_flush_timer->is_active())
+        m_flush_timer->start(flush_interval_ms - m_last_flush_timer.elapsed());
+}
+
 void TerminalWidget::force_repaint()
 {
     m_needs_background_fill = true;
+    m_clean_rows.clear();
     update();
 }
 
@@ -574,7 +660,7 @@ void TerminalWidget::mouseup_event(GUI::MouseEvent& event)
         if (!m_active_href_id.is_null()) {
             m_active_href = {};
             m_active_href_id = {};
-            update();
+            force_repaint();
         }
     }
 }
@@ -588,7 +674,7 @@ void TerminalWidget::mousedown_event(GUI::MouseEvent& event)
         if (!(event.modifiers() & Mod_Shift) && !attribute.href.is_empty()) {
             m_active_href = attribute.href;
             m_active_href_id = attribute.href_id;
-            update();
+            force_repaint();
             return;
         }
         m_active_href = {};
@@ -610,7 +696,7 @@ void TerminalWidget::mousedown_event(GUI::MouseEvent& event)
         else if (m_rectangle_selection)
             m_rectangle_selection = false;
 
-        update();
+        force_repaint();
     }
 }
 
@@ -632,7 +718,7 @@ void TerminalWidget::mousemove_event(GUI::MouseEvent& event)
             window()->set_override_cursor(GUI::StandardCursor::Hand);
         else
             window()->set_override_cursor(GUI::StandardCursor::None);
-        update();
+        force_repaint();
     }
 
     if (!(event.buttons() & GUI::MouseButton::Left))
@@ -655,14 +741,14 @@ void TerminalWidget::mousemove_event(GUI::MouseEvent& event)
         m_active_href_id = {};
         m_hovered_href = {};
         m_hovered_href_id = {};
-        update();
+        force_repaint();
         return;
     }
 
     auto old_selection_end = m_selection_end;
     m_selection_end = position;
     if (old_selection_end != m_selection_end)
-        update();
+        force_repaint();
 }
 
 void TerminalWidget::leave_event(Core::Event&)
@@ -672,7 +758,7 @@ void TerminalWidget::leave_event(Core::Event&)
     m_hovered_href = {};
     m_hovered_href_id = {};
     if (should_update)
-        update();
+        force_repaint();
 }
 
 void TerminalWidget::mousewheel_event(GUI::MouseEvent& event)
@@ -742,9 +828,11 @@ int TerminalWidget::last_selection_column_on_row(int row) const
 void TerminalWidget::terminal_history_changed()
 {
     bool was_max = m_scrollbar->value() == m_scrollbar->max();
-    m_scrollbar->set_max(m_terminal.history().size());
+    m_following_output = was_max;
+    m_scrollbar->set_max(m_terminal.history_size());
     if (was_max)
         m_scrollbar->set_value(m_scrollbar->max());
+    m_following_output = false;
     m_scrollbar->update();
 }
 
@@ -122,8 +122,11 @@ private:
     Gfx::IntRect glyph_rect(u16 row, u16 column);
     Gfx::IntRect row_rect(u16 row);
 
+    void paint_row(Gfx::Painter&, u16 visual_row, int first_row_from_history, int row_with_cursor, bool visual_beep_active);
+
     void update_cursor();
     void invalidate_cursor();
+    void schedule_flush();
 
     void relayout(const Gfx::IntSize&);
 
@@ -174,6 +177,15 @@ private:
 
     RefPtr<Core::Timer> m_cursor_blink_timer;
     RefPtr<Core::Timer> m_visual_beep_timer;
+    RefPtr<Core::Timer> m_flush_timer;
+    Core::ElapsedTimer m_last_flush_timer;
+
+    // What the rows look like, so that scrolling can move them instead of drawing them again.
+    // A row is clean if the cache is up to date for it.
+    RefPtr<Gfx::Bitmap> m_row_cache;
+    Vector<bool> m_clean_rows;
+    int m_pending_scroll_rows { 0 };
+    bool m_following_output { false };
     RefPtr<Core::ConfigFile> m_config;
 
     RefPtr<GUI::ScrollBar> m_scrollbar;
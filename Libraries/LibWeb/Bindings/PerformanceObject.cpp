@@ -24,60 +24,49 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/Function.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
-#include <LibJS/Runtime/Uint8ClampedArray.h>
+#include <LibWeb/Bindings/PerformanceObject.h>
+#include <time.h>
 
-namespace JS {
+namespace Web {
+namespace Bindings {
 
-Uint8ClampedArray* Uint8ClampedArray::create(GlobalObject& global_object, u32 length)
+static u64 monotonic_time_us()
 {
-    auto& interpreter = global_object.interpreter();
-    return interpreter.heap().allocate<Uint8ClampedArray>(global_object, length, *global_object.array_prototype());
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<u64>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
 }
 
-Uint8ClampedArray::Uint8ClampedArray(u32 length, Object& prototype)
-    : Object(prototype)
-    , m_length(length)
+PerformanceObject::PerformanceObject(JS::GlobalObject& global_object)
+    : Object(*global_object.object_prototype())
+    , m_time_origin_us(monotonic_time_us())
 {
-    define_native_property("length", length_getter, nullptr);
-    m_data = new u8[m_length];
 }
 
-Uint8ClampedArray::~Uint8ClampedArray()
+void PerformanceObject::initialize(JS::GlobalObject& global_object)
 {
-    ASSERT(m_data);
-    delete[] m_data;
-    m_data = nullptr;
+    Object::initialize(global_object);
+    define_native_function("now", now, 0);
 }
 
-JS_DEFINE_NATIVE_GETTER(Uint8ClampedArray::length_getter)
+PerformanceObject::~PerformanceObject()
 {
-    auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
-    if (!this_object)
-        return {};
-    if (StringView(this_object->class_name()) != "Uint8ClampedArray")
-        return interpreter.throw_exception<TypeError>(ErrorType::NotA, "Uint8ClampedArray");
-    return Value(static_cast<const Uint8ClampedArray*>(this_object)->length());
 }
 
-bool Uint8ClampedArray::put_by_index(u32 property_index, Value value)
+JS_DEFINE_NATIVE_FUNCTION(PerformanceObject::now)
 {
-    // FIXME: Use attributes
-    ASSERT(property_index < m_length);
-    auto number = value.to_i32(interpreter());
-    if (interpreter().exception())
+    auto* this_object = interpreter.this_value(global_object).to_object(interpreter, global_object);
+    if (!this_object)
         return {};
-    m_data[property_index] = clamp(number, 0, 255);
-    return true;
+    if (StringView("PerformanceObject") != this_object->class_name())
+        return interpreter.throw_exception<JS::TypeError>(JS::ErrorType::NotA, "Performance");
+    auto time_origin_us = static_cast<PerformanceObject*>(this_object)->m_time_origin_us;
+    // Milliseconds since the window was created, with microsecond resolution.
+    return JS::Value((monotonic_time_us() - time_origin_us) / 1000.0);
 }
 
-Value Uint8ClampedArray::get_by_index(u32 property_index) const
-{
-    ASSERT(property_index < m_length);
-    return Value((i32)m_data[property_index]);
 }
-
 }
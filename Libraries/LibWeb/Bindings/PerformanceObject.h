@@ -27,31 +27,25 @@
 #pragma once
 
 #include <LibJS/Runtime/Object.h>
+#include <LibWeb/Forward.h>
 
-namespace JS {
+namespace Web {
+namespace Bindings {
 
-class Uint8ClampedArray final : public Object {
-    JS_OBJECT(Uint8ClampedArray, Object);
+class PerformanceObject final : public JS::Object {
+    JS_OBJECT(PerformanceObject, JS::Object);
 
 public:
-    static Uint8ClampedArray* create(GlobalObject&, u32 length);
-
-    Uint8ClampedArray(u32 length, Object& prototype);
-    virtual ~Uint8ClampedArray() override;
-
-    i32 length() const { return m_length; }
-
-    virtual bool put_by_index(u32 property_index, Value value) override;
-    virtual Value get_by_index(u32 property_index) const override;
-
-    u8* data() { return m_data; }
-    const u8* data() const { return m_data; }
+    PerformanceObject(JS::GlobalObject&);
+    virtual void initialize(JS::GlobalObject&) override;
+    virtual ~PerformanceObject() override;
 
 private:
-    JS_DECLARE_NATIVE_GETTER(length_getter);
+    JS_DECLARE_NATIVE_FUNCTION(now);
 
-    u8* m_data { nullptr };
-    u32 m_length { 0 };
+    // The time the window was created, in microseconds of the monotonic clock.
+    u64 m_time_origin_us { 0 };
 };
 
 }
+}
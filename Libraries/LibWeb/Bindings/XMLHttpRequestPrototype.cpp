@@ -45,7 +45,9 @@ void XMLHttpRequestPrototype::initialize(JS::GlobalObject& global_object)
     define_native_function("open", open, 2);
     define_native_function("send", send, 0);
     define_native_property("readyState", ready_state_getter, nullptr, JS::Attribute::Enumerable | JS::Attribute::Configurable);
+    define_native_property("response", response_getter, nullptr, JS::Attribute::Enumerable | JS::Attribute::Configurable);
     define_native_property("responseText", response_text_getter, nullptr, JS::Attribute::Enumerable | JS::Attribute::Configurable);
+    define_native_property("responseType", response_type_getter, response_type_setter, JS::Attribute::Enumerable | JS::Attribute::Configurable);
 
     define_property("UNSENT", JS::Value((i32)XMLHttpRequest::ReadyState::Unsent), JS::Attribute::Enumerable);
     define_property("OPENED", JS::Value((i32)XMLHttpRequest::ReadyState::Opened), JS::Attribute::Enumerable);
@@ -102,6 +104,14 @@ JS_DEFINE_NATIVE_GETTER(XMLHttpRequestPrototype::ready_state_getter)
     return JS::Value((i32)impl->ready_state());
 }
 
+JS_DEFINE_NATIVE_GETTER(XMLHttpRequestPrototype::response_getter)
+{
+    auto* impl = impl_from(interpreter, global_object);
+    if (!impl)
+        return {};
+    return impl->response(global_object);
+}
+
 JS_DEFINE_NATIVE_GETTER(XMLHttpRequestPrototype::response_text_getter)
 {
     auto* impl = impl_from(interpreter, global_object);
@@ -110,4 +120,37 @@ JS_DEFINE_NATIVE_GETTER(XMLHttpRequestPrototype::response_text_getter)
     return JS::js_string(interpreter, impl->response_text());
 }
 
+JS_DEFINE_NATIVE_GETTER(XMLHttpRequestPrototype::response_type_getter)
+{
+    auto* impl = impl_from(interpreter, global_object);
+    if (!impl)
+        return {};
+    switch (impl->response_type()) {
+    case XMLHttpRequest::ResponseType::Empty:
+        return JS::js_string(interpreter, "");
+    case XMLHttpRequest::ResponseType::Text:
+        return JS::js_string(interpreter, "text");
+    case XMLHttpRequest::ResponseType::ArrayBuffer:
+        return JS::js_string(interpreter, "arraybuffer");
+    }
+    ASSERT_NOT_REACHED();
+}
+
+JS_DEFINE_NATIVE_SETTER(XMLHttpRequestPrototype::response_type_setter)
+{
+    auto* impl = impl_from(interpreter, global_object);
+    if (!impl)
+        return;
+    auto response_type = value.to_string(interpreter);
+    if (interpreter.exception())
+        return;
+    // Unsupported response types are ignored, like the spec says to do for unknown ones.
+    if (response_type == "")
+        impl->set_response_type(XMLHttpRequest::ResponseType::Empty);
+    else if (response_type == "text")
+        impl->set_response_type(XMLHttpRequest::ResponseType::Text);
+    else if (response_type == "arraybuffer")
+        impl->set_response_type(XMLHttpRequest::ResponseType::ArrayBuffer);
+}
+
 }
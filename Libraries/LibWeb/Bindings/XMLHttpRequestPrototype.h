@@ -43,7 +43,10 @@ private:
     JS_DECLARE_NATIVE_FUNCTION(send);
 
     JS_DECLARE_NATIVE_GETTER(ready_state_getter);
+    JS_DECLARE_NATIVE_GETTER(response_getter);
     JS_DECLARE_NATIVE_GETTER(response_text_getter);
+    JS_DECLARE_NATIVE_GETTER(response_type_getter);
+    JS_DECLARE_NATIVE_SETTER(response_type_setter);
 };
 
 }
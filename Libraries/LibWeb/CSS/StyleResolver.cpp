@@ -32,6 +32,7 @@
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
 #include <LibWeb/Dump.h>
+#include <LibWeb/HTML/AttributeNames.h>
 #include <ctype.h>
 #include <stdio.h>
 
@@ -66,23 +67,88 @@ void StyleResolver::for_each_stylesheet(Callback callback) const
     }
 }
 
+// A Bloom filter of the ids, classes and tag names of an element's ancestors.
+// If it says a name isn't there, no ancestor has it, which lets us reject
+// descendant and child selectors without walking up the tree for each one.
+class AncestorFilter {
+public:
+    explicit AncestorFilter(const DOM::Element& element)
+    {
+        for (auto* ancestor = element.parent(); ancestor; ancestor = ancestor->parent()) {
+            if (!is<DOM::Element>(*ancestor))
+                continue;
+            auto& ancestor_element = downcast<DOM::Element>(*ancestor);
+            add(ancestor_element.local_name().hash());
+            for (auto& class_name : ancestor_element.class_names())
+                add(class_name.hash());
+            auto id = ancestor_element.attribute(HTML::AttributeNames::id);
+            if (!id.is_null())
+                add(FlyString(id).hash());
+        }
+    }
+
+    bool may_contain(u32 hash) const
+    {
+        return has_bit(hash % bit_count) && has_bit((hash >> 16) % bit_count);
+    }
+
+private:
+    static constexpr size_t bit_count = 4096;
+
+    void add(u32 hash)
+    {
+        set_bit(hash % bit_count);
+        set_bit((hash >> 16) % bit_count);
+    }
+
+    bool has_bit(size_t bit) const { return m_bits[bit / 32] & (1u << (bit % 32)); }
+    void set_bit(size_t bit) { m_bits[bit / 32] |= 1u << (bit % 32); }
+
+    u32 m_bits[bit_count / 32] {};
+};
+
 Vector<MatchingRule> StyleResolver::collect_matching_rules(const DOM::Element& element) const
 {
     Vector<MatchingRule> matching_rules;
 
+    // Only built once we have a candidate that needs it.
+    OwnPtr<AncestorFilter> ancestor_filter;
+    auto may_match_ancestors = [&](const StyleSheet::IndexedSelector& candidate) {
+        if (candidate.ancestor_hashes.is_empty())
+            return true;
+        if (!ancestor_filter)
+            ancestor_filter = make<AncestorFilter>(element);
+        for (auto hash : candidate.ancestor_hashes) {
+            if (!ancestor_filter->may_contain(hash))
+                return false;
+        }
+        return true;
+    };
+
+    Vector<const StyleSheet::IndexedSelector*> candidates;
     size_t style_sheet_index = 0;
     for_each_stylesheet([&](auto& sheet) {
-        size_t rule_index = 0;
-        for (auto& rule : sheet.rules()) {
-            size_t selector_index = 0;
-            for (auto& selector : rule.selectors()) {
-                if (SelectorEngine::matches(selector, element)) {
-                    matching_rules.append({ rule, style_sheet_index, rule_index, selector_index });
-                    break;
-                }
-                ++selector_index;
+        candidates.clear_with_capacity();
+        sheet.collect_candidate_selectors(element, candidates);
+
+        // Visit candidates in rule order so that a rule is matched by its first matching selector, and only once.
+        quick_sort(candidates, [](auto* a, auto* b) {
+            if (a->rule_index == b->rule_index)
+                return a->selector_index < b->selector_index;
+            return a->rule_index < b->rule_index;
+        });
+
+        Optional<size_t> last_matched_rule_index;
+        for (auto* candidate : candidates) {
+            if (last_matched_rule_index.has_value() && last_matched_rule_index.value() == candidate->rule_index)
+                continue;
+            if (!may_match_ancestors(*candidate))
+                continue;
+            auto& rule = sheet.rules()[candidate->rule_index];
+            if (SelectorEngine::matches(rule.selectors()[candidate->selector_index], element)) {
+                matching_rules.append({ rule, style_sheet_index, candidate->rule_index, candidate->selector_index });
+                last_matched_rule_index = candidate->rule_index;
             }
-            ++rule_index;
         }
         ++style_sheet_index;
     });
@@ -519,8 +585,62 @@ static void set_property_expanding_shorthands(StyleProperties& style, CSS::Prope
     style.set_property(property_id, value);
 }
 
+bool StyleResolver::has_position_dependent_selectors() const
+{
+    bool has_position_dependent_selectors = false;
+    for_each_stylesheet([&](auto& sheet) {
+        if (sheet.has_position_dependent_selectors())
+            has_position_dependent_selectors = true;
+    });
+    return has_position_dependent_selectors;
+}
+
+static bool is_affected_by_hover(const DOM::Element& element)
+{
+    auto* hovered_node = element.document().hovered_node();
+    return hovered_node && (&element == hovered_node || element.is_ancestor_of(*hovered_node));
+}
+
+static bool have_same_attributes(const DOM::Element& a, const DOM::Element& b)
+{
+    if (a.attribute_count() != b.attribute_count())
+        return false;
+    bool same = true;
+    a.for_each_attribute([&](auto& name, auto& value) {
+        if (same && b.attribute(name) != value)
+            same = false;
+    });
+    return same;
+}
+
+// Siblings with the same tag name, attributes and parent style match the same rules and get the
+// same presentational hints, so we can hand out the style we already resolved for one of them.
+// This is a big win for repetitive content like table cells and list items.
+RefPtr<StyleProperties> StyleResolver::find_shareable_style(const DOM::Element& element, const StyleProperties* parent_style) const
+{
+    static constexpr size_t max_siblings_to_check = 8;
+
+    if (!parent_style || is_affected_by_hover(element) || has_position_dependent_selectors())
+        return nullptr;
+
+    size_t siblings_checked = 0;
+    for (auto* sibling = element.previous_element_sibling(); sibling && siblings_checked < max_siblings_to_check; sibling = sibling->previous_element_sibling(), ++siblings_checked) {
+        if (!sibling->resolved_style() || sibling->resolved_parent_style() != parent_style)
+            continue;
+        if (sibling->local_name() != element.local_name() || !have_same_attributes(*sibling, element))
+            continue;
+        if (is_affected_by_hover(*sibling))
+            continue;
+        return const_cast<StyleProperties*>(sibling->resolved_style());
+    }
+    return nullptr;
+}
+
 NonnullRefPtr<StyleProperties> StyleResolver::resolve_style(const DOM::Element& element, const StyleProperties* parent_style) const
 {
+    if (auto shared_style = find_shareable_style(element, parent_style))
+        return shared_style.release_nonnull();
+
     auto style = StyleProperties::create();
 
     if (parent_style) {
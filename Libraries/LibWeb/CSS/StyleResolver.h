@@ -54,10 +54,15 @@ public:
 
     static bool is_inherited_property(CSS::PropertyID);
 
+    // Whether some style sheet has selectors that depend on where an element is among its siblings.
+    bool has_position_dependent_selectors() const;
+
 private:
     template<typename Callback>
     void for_each_stylesheet(Callback) const;
 
+    RefPtr<StyleProperties> find_shareable_style(const DOM::Element&, const StyleProperties* parent_style) const;
+
     DOM::Document& m_document;
 };
 
@@ -25,16 +25,135 @@
  */
 
 #include <LibWeb/CSS/StyleSheet.h>
+#include <LibWeb/DOM/Element.h>
+#include <LibWeb/HTML/AttributeNames.h>
 
 namespace Web::CSS {
 
 StyleSheet::StyleSheet(NonnullRefPtrVector<StyleRule>&& rules)
     : m_rules(move(rules))
 {
+    build_selector_index();
 }
 
 StyleSheet::~StyleSheet()
 {
 }
 
+void StyleSheet::set_rules(NonnullRefPtrVector<StyleRule>&& rules)
+{
+    m_rules = move(rules);
+    build_selector_index();
+}
+
+static void collect_ancestor_hashes(const Selector& selector, Vector<u32>& hashes)
+{
+    // Walk leftwards for as long as each compound selector has to match an ancestor.
+    // Anything to the left of a sibling combinator may match outside the ancestor chain.
+    auto& complex_selectors = selector.complex_selectors();
+    for (size_t i = complex_selectors.size() - 1; i > 0; --i) {
+        auto relation = complex_selectors[i].relation;
+        if (relation != Selector::ComplexSelector::Relation::Descendant && relation != Selector::ComplexSelector::Relation::ImmediateChild)
+            break;
+        for (auto& simple_selector : complex_selectors[i - 1].compound_selector) {
+            if (simple_selector.type == Selector::SimpleSelector::Type::Id
+                || simple_selector.type == Selector::SimpleSelector::Type::Class
+                || simple_selector.type == Selector::SimpleSelector::Type::TagName)
+                hashes.append(simple_selector.value.hash());
+        }
+    }
+}
+
+static bool is_position_dependent(const Selector& selector)
+{
+    // Only the rightmost compound selector matters here. Everything to the left of a
+    // descendant or child combinator is matched against ancestors, which siblings share.
+    auto& rightmost = selector.complex_selectors().last();
+    if (rightmost.relation == Selector::ComplexSelector::Relation::AdjacentSibling || rightmost.relation == Selector::ComplexSelector::Relation::GeneralSibling)
+        return true;
+    for (auto& simple_selector : rightmost.compound_selector) {
+        switch (simple_selector.pseudo_class) {
+        case Selector::SimpleSelector::PseudoClass::FirstChild:
+        case Selector::SimpleSelector::PseudoClass::LastChild:
+        case Selector::SimpleSelector::PseudoClass::OnlyChild:
+        case Selector::SimpleSelector::PseudoClass::Empty:
+            return true;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+void StyleSheet::build_selector_index()
+{
+    m_selectors_by_id.clear();
+    m_selectors_by_class.clear();
+    m_selectors_by_tag_name.clear();
+    m_universal_selectors.clear();
+    m_has_position_dependent_selectors = false;
+
+    for (size_t rule_index = 0; rule_index < m_rules.size(); ++rule_index) {
+        auto& selectors = m_rules[rule_index].selectors();
+        for (size_t selector_index = 0; selector_index < selectors.size(); ++selector_index) {
+            auto& selector = selectors[selector_index];
+            if (is_position_dependent(selector))
+                m_has_position_dependent_selectors = true;
+
+            IndexedSelector indexed_selector { rule_index, selector_index, {} };
+            collect_ancestor_hashes(selector, indexed_selector.ancestor_hashes);
+
+            // Bucket by the most selective part of the rightmost compound selector, since that is what the element itself must have.
+            const Selector::SimpleSelector* id_selector = nullptr;
+            const Selector::SimpleSelector* class_selector = nullptr;
+            const Selector::SimpleSelector* tag_name_selector = nullptr;
+            for (auto& simple_selector : selector.complex_selectors().last().compound_selector) {
+                if (simple_selector.type == Selector::SimpleSelector::Type::Id)
+                    id_selector = &simple_selector;
+                else if (simple_selector.type == Selector::SimpleSelector::Type::Class)
+                    class_selector = &simple_selector;
+                else if (simple_selector.type == Selector::SimpleSelector::Type::TagName)
+                    tag_name_selector = &simple_selector;
+            }
+
+            if (id_selector)
+                m_selectors_by_id.ensure(id_selector->value).append(move(indexed_selector));
+            else if (class_selector)
+                m_selectors_by_class.ensure(class_selector->value).append(move(indexed_selector));
+            else if (tag_name_selector)
+                m_selectors_by_tag_name.ensure(tag_name_selector->value).append(move(indexed_selector));
+            else
+                m_universal_selectors.append(move(indexed_selector));
+        }
+    }
+}
+
+static void append_candidates(const Vector<StyleSheet::IndexedSelector>& selectors, Vector<const StyleSheet::IndexedSelector*>& candidates)
+{
+    for (auto& selector : selectors)
+        candidates.append(&selector);
+}
+
+void StyleSheet::collect_candidate_selectors(const DOM::Element& element, Vector<const IndexedSelector*>& candidates) const
+{
+    auto id = element.attribute(HTML::AttributeNames::id);
+    if (!id.is_null()) {
+        auto it = m_selectors_by_id.find(id);
+        if (it != m_selectors_by_id.end())
+            append_candidates(it->value, candidates);
+    }
+
+    for (auto& class_name : element.class_names()) {
+        auto it = m_selectors_by_class.find(class_name);
+        if (it != m_selectors_by_class.end())
+            append_candidates(it->value, candidates);
+    }
+
+    auto it = m_selectors_by_tag_name.find(element.local_name());
+    if (it != m_selectors_by_tag_name.end())
+        append_candidates(it->value, candidates);
+
+    append_candidates(m_universal_selectors, candidates);
+}
+
 }
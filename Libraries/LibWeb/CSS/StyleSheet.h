@@ -26,13 +26,25 @@
 
 #pragma once
 
+#include <AK/FlyString.h>
+#include <AK/HashMap.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <LibWeb/CSS/StyleRule.h>
+#include <LibWeb/Forward.h>
 
 namespace Web::CSS {
 
 class StyleSheet : public RefCounted<StyleSheet> {
 public:
+    struct IndexedSelector {
+        size_t rule_index { 0 };
+        size_t selector_index { 0 };
+
+        // Hashes of ids, classes and tag names that some ancestor of the element must have
+        // for the selector to match. Used to reject selectors early with an ancestor filter.
+        Vector<u32> ancestor_hashes;
+    };
+
     static NonnullRefPtr<StyleSheet> create(NonnullRefPtrVector<StyleRule>&& rules)
     {
         return adopt(*new StyleSheet(move(rules)));
@@ -41,12 +53,28 @@ public:
     ~StyleSheet();
 
     const NonnullRefPtrVector<StyleRule>& rules() const { return m_rules; }
-    NonnullRefPtrVector<StyleRule>& rules() { return m_rules; }
+    void set_rules(NonnullRefPtrVector<StyleRule>&&);
+
+    // Appends every selector that could match the element, based on the id, class or tag name
+    // of its rightmost compound selector. The candidates still need to be matched one by one.
+    void collect_candidate_selectors(const DOM::Element&, Vector<const IndexedSelector*>&) const;
+
+    // Whether some selector can match one element and not a sibling of it with the same tag name and attributes.
+    bool has_position_dependent_selectors() const { return m_has_position_dependent_selectors; }
 
 private:
     explicit StyleSheet(NonnullRefPtrVector<StyleRule>&&);
 
+    void build_selector_index();
+
     NonnullRefPtrVector<StyleRule> m_rules;
+
+    HashMap<FlyString, Vector<IndexedSelector>> m_selectors_by_id;
+    HashMap<FlyString, Vector<IndexedSelector>> m_selectors_by_class;
+    HashMap<FlyString, Vector<IndexedSelector>> m_selectors_by_tag_name;
+    Vector<IndexedSelector> m_universal_selectors;
+
+    bool m_has_position_dependent_selectors { false };
 };
 
 }
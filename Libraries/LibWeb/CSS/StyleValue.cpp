@@ -298,10 +298,20 @@ ImageStyleValue::ImageStyleValue(const URL& url, DOM::Document& document)
 }
 
 void ImageStyleValue::resource_did_load()
+{
+    resource()->decode_if_needed();
+    repaint();
+}
+
+void ImageStyleValue::resource_did_decode()
+{
+    repaint();
+}
+
+void ImageStyleValue::repaint()
 {
     if (!m_document)
         return;
-    m_bitmap = resource()->bitmap();
     // FIXME: Do less than a full repaint if possible?
     if (m_document->frame())
         m_document->frame()->set_needs_display({});
@@ -316,7 +316,7 @@ public:
 
     String to_string() const override { return String::format("Image{%s}", m_url.to_string().characters()); }
 
-    const Gfx::Bitmap* bitmap() const { return m_bitmap; }
+    const Gfx::Bitmap* bitmap() const { return resource() ? resource()->bitmap() : nullptr; }
 
 private:
     ImageStyleValue(const URL&, DOM::Document&);
@@ -324,9 +324,15 @@ private:
     // ^ResourceClient
     virtual void resource_did_load() override;
 
+    // ^ImageResourceClient
+    virtual void resource_did_decode() override;
+    // FIXME: We don't know where background images are painted, so never let their bitmaps be purged.
+    virtual bool is_visible_in_viewport() const override { return true; }
+
+    void repaint();
+
     URL m_url;
     WeakPtr<DOM::Document> m_document;
-    RefPtr<Gfx::Bitmap> m_bitmap;
 };
 
 }
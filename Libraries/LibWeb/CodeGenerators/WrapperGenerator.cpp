@@ -441,7 +441,7 @@ void generate_implementation(const IDL::Interface& interface)
     out() << "#include <LibJS/Runtime/GlobalObject.h>";
     out() << "#include <LibJS/Runtime/Error.h>";
     out() << "#include <LibJS/Runtime/Function.h>";
-    out() << "#include <LibJS/Runtime/Uint8ClampedArray.h>";
+    out() << "#include <LibJS/Runtime/TypedArray.h>";
     out() << "#include <LibWeb/Bindings/NodeWrapperFactory.h>";
     out() << "#include <LibWeb/Bindings/" << wrapper_class << ".h>";
     out() << "#include <LibWeb/DOM/Element.h>";
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashMap.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/Timer.h>
 #include <LibGUI/Application.h>
@@ -60,6 +61,9 @@
 
 namespace Web::DOM {
 
+// How long each piece of incremental garbage collection work may take, so that it fits in a frame.
+static constexpr int incremental_gc_budget_ms = 4;
+
 Document::Document(const URL& url)
     : ParentNode(*this, NodeType::DOCUMENT_NODE)
     , m_style_resolver(make<CSS::StyleResolver>(*this))
@@ -70,6 +74,10 @@ Document::Document(const URL& url)
     m_style_update_timer = Core::Timer::create_single_shot(0, [this] {
         update_style();
     });
+    m_incremental_gc_timer = Core::Timer::create_single_shot(0, [this] {
+        if (m_interpreter && m_interpreter->heap().perform_incremental_collection_work(incremental_gc_budget_ms))
+            m_incremental_gc_timer->start();
+    });
 }
 
 Document::~Document()
@@ -269,15 +277,26 @@ void Document::force_layout()
     layout();
 }
 
-void Document::layout()
+void Document::update_layout_tree()
 {
-    if (!frame())
-        return;
+    if (m_layout_root && (needs_layout_tree_update() || child_needs_layout_tree_update())) {
+        LayoutTreeBuilder tree_builder;
+        if (!tree_builder.update_dirty_subtrees(*this))
+            m_layout_root = nullptr;
+    }
 
     if (!m_layout_root) {
         LayoutTreeBuilder tree_builder;
         m_layout_root = static_ptr_cast<LayoutDocument>(tree_builder.build(*this));
     }
+}
+
+void Document::layout()
+{
+    if (!frame())
+        return;
+
+    update_layout_tree();
     m_layout_root->layout();
     m_layout_root->set_needs_display();
 
@@ -285,13 +304,23 @@ void Document::layout()
         frame()->page().client().page_did_layout();
 }
 
-void Document::update_style()
+static void update_style_recursively(Node& node)
 {
-    for_each_in_subtree_of_type<Element>([&](auto& element) {
-        if (element.needs_style_update())
-            element.recompute_style();
-        return IterationDecision::Continue;
+    if (is<Element>(node) && node.needs_style_update())
+        downcast<Element>(node).recompute_style();
+    node.set_needs_style_update(false);
+
+    if (!node.child_needs_style_update())
+        return;
+    node.set_child_needs_style_update(false);
+    node.for_each_child([&](auto& child) {
+        update_style_recursively(child);
     });
+}
+
+void Document::update_style()
+{
+    update_style_recursively(*this);
     update_layout();
 }
 
@@ -355,7 +384,35 @@ void Document::set_hovered_node(Node* node)
     RefPtr<Node> old_hovered_node = move(m_hovered_node);
     m_hovered_node = node;
 
-    invalidate_style();
+    // Only the nodes between each hovered node and their common ancestor change :hover state.
+    // Restyle the branches containing them, or everything under the common ancestor if
+    // sibling-dependent selectors could reach outside of those branches.
+    Node* common_ancestor = nullptr;
+    if (old_hovered_node && node) {
+        for (auto* ancestor = old_hovered_node.ptr(); ancestor; ancestor = ancestor->parent()) {
+            if (ancestor == node || ancestor->is_ancestor_of(*node)) {
+                common_ancestor = ancestor;
+                break;
+            }
+        }
+    }
+
+    if (!common_ancestor) {
+        invalidate_style();
+        return;
+    }
+    if (style_resolver().has_position_dependent_selectors()) {
+        common_ancestor->invalidate_style();
+        return;
+    }
+    for (auto* hovered_node : { old_hovered_node.ptr(), node }) {
+        if (hovered_node == common_ancestor)
+            continue;
+        auto* branch = hovered_node;
+        while (branch->parent() != common_ancestor)
+            branch = branch->parent();
+        branch->invalidate_style();
+    }
 }
 
 Vector<const Element*> Document::get_elements_by_name(const String& name) const
@@ -380,6 +437,148 @@ NonnullRefPtrVector<Element> Document::get_elements_by_tag_name(const FlyString&
     return elements;
 }
 
+static bool is_before_in_tree_order(const Node& a, const Node& b)
+{
+    Vector<const Node*, 32> a_ancestors;
+    for (auto* node = &a; node; node = node->parent())
+        a_ancestors.append(node);
+    Vector<const Node*, 32> b_ancestors;
+    for (auto* node = &b; node; node = node->parent())
+        b_ancestors.append(node);
+
+    size_t a_index = a_ancestors.size();
+    size_t b_index = b_ancestors.size();
+    while (a_index > 0 && b_index > 0 && a_ancestors[a_index - 1] == b_ancestors[b_index - 1]) {
+        --a_index;
+        --b_index;
+    }
+
+    // One of the nodes is an ancestor of the other.
+    if (a_index == 0 || b_index == 0)
+        return a_index == 0 && b_index != 0;
+
+    for (auto* sibling = a_ancestors[a_index - 1]->next_sibling(); sibling; sibling = sibling->next_sibling()) {
+        if (sibling == b_ancestors[b_index - 1])
+            return true;
+    }
+    return false;
+}
+
+const Element* Document::get_element_by_id(const FlyString& id) const
+{
+    auto it = m_elements_by_id.find(id);
+    if (it == m_elements_by_id.end())
+        return nullptr;
+    auto& elements = it->value;
+    ASSERT(!elements.is_empty());
+    const Element* first = elements.first();
+    for (size_t i = 1; i < elements.size(); ++i) {
+        if (is_before_in_tree_order(*elements[i], *first))
+            first = elements[i];
+    }
+    return first;
+}
+
+NonnullRefPtrVector<Element> Document::get_elements_by_class_name(const String& class_names) const
+{
+    auto it = m_elements_by_class_name_cache.find(class_names);
+    if (it != m_elements_by_class_name_cache.end())
+        return it->value;
+
+    Vector<FlyString> wanted_classes;
+    for (auto& class_name : class_names.split_view(' '))
+        wanted_classes.append(class_name);
+
+    // Every match is in the index of each wanted class, so the smallest of those bounds the search.
+    const HashTable<Element*>* candidates = nullptr;
+    for (auto& class_name : wanted_classes) {
+        auto candidates_it = m_elements_by_class_name.find(class_name);
+        if (candidates_it == m_elements_by_class_name.end()) {
+            candidates = nullptr;
+            break;
+        }
+        if (!candidates || candidates_it->value.size() < candidates->size())
+            candidates = &candidates_it->value;
+    }
+
+    NonnullRefPtrVector<Element> elements;
+    if (candidates) {
+        // Walk the tree to produce the elements in tree order, stopping once every candidate has been seen.
+        size_t candidates_seen = 0;
+        for_each_in_subtree_of_type<Element>([&](auto& element) {
+            if (!candidates->contains(const_cast<Element*>(&element)))
+                return IterationDecision::Continue;
+            bool matches = true;
+            for (auto& class_name : wanted_classes) {
+                if (!element.has_class(class_name)) {
+                    matches = false;
+                    break;
+                }
+            }
+            if (matches)
+                elements.append(element);
+            if (++candidates_seen == candidates->size())
+                return IterationDecision::Break;
+            return IterationDecision::Continue;
+        });
+    }
+
+    m_elements_by_class_name_cache.set(class_names, elements);
+    return elements;
+}
+
+void Document::add_subtree_to_element_indexes(Node& root)
+{
+    root.for_each_in_subtree_of_type<Element>([&](auto& element) {
+        add_to_element_indexes(element);
+        return IterationDecision::Continue;
+    });
+}
+
+void Document::remove_subtree_from_element_indexes(Node& root)
+{
+    root.for_each_in_subtree_of_type<Element>([&](auto& element) {
+        remove_from_element_indexes(element);
+        return IterationDecision::Continue;
+    });
+}
+
+void Document::add_to_element_indexes(Element& element)
+{
+    m_elements_by_class_name_cache.clear();
+
+    auto id = element.attribute(HTML::AttributeNames::id);
+    if (!id.is_empty())
+        m_elements_by_id.ensure(id).append(&element);
+
+    for (auto& class_name : element.class_names())
+        m_elements_by_class_name.ensure(class_name).set(&element);
+}
+
+void Document::remove_from_element_indexes(Element& element)
+{
+    m_elements_by_class_name_cache.clear();
+
+    auto id = element.attribute(HTML::AttributeNames::id);
+    if (!id.is_empty()) {
+        auto it = m_elements_by_id.find(id);
+        if (it != m_elements_by_id.end()) {
+            it->value.remove_first_matching([&](auto* entry) { return entry == &element; });
+            if (it->value.is_empty())
+                m_elements_by_id.remove(it);
+        }
+    }
+
+    for (auto& class_name : element.class_names()) {
+        auto it = m_elements_by_class_name.find(class_name);
+        if (it == m_elements_by_class_name.end())
+            continue;
+        it->value.remove(&element);
+        if (it->value.is_empty())
+            m_elements_by_class_name.remove(it);
+    }
+}
+
 Color Document::link_color() const
 {
     if (m_link_color.has_value())
@@ -409,19 +608,51 @@ Color Document::visited_link_color() const
 
 JS::Interpreter& Document::interpreter()
 {
-    if (!m_interpreter)
+    if (!m_interpreter) {
         m_interpreter = JS::Interpreter::create<Bindings::WindowObject>(*m_window);
+        // Full collections are done in small steps whenever the event loop gets to us,
+        // rather than in one long pause in the middle of a script.
+        m_interpreter->heap().set_incremental_collection_callback([this] {
+            if (!m_incremental_gc_timer->is_active())
+                m_incremental_gc_timer->start();
+        });
+    }
     return *m_interpreter;
 }
 
-JS::Value Document::run_javascript(const StringView& source)
+// The same scripts tend to be run over and over (on every page of a site, and again on every reload),
+// so the programs of the most recent ones are kept around for the whole process. Nothing in a program
+// belongs to the interpreter that ran it, and function bodies only parsed once called stay parsed.
+static RefPtr<JS::Program> parse_script(const StringView& source)
 {
+    static constexpr size_t max_cached_programs = 32;
+    static HashMap<String, RefPtr<JS::Program>> s_programs;
+    static Vector<String> s_programs_in_insertion_order;
+
+    String key = source;
+    if (auto it = s_programs.find(key); it != s_programs.end())
+        return it->value;
+
     auto parser = JS::Parser(JS::Lexer(source));
+    parser.set_lazy_function_parsing(true);
     auto program = parser.parse_program();
     if (parser.has_errors()) {
         parser.print_errors();
-        return JS::js_undefined();
+        return nullptr;
     }
+
+    if (s_programs_in_insertion_order.size() == max_cached_programs)
+        s_programs.remove(s_programs_in_insertion_order.take_first());
+    s_programs.set(key, program);
+    s_programs_in_insertion_order.append(move(key));
+    return program;
+}
+
+JS::Value Document::run_javascript(const StringView& source)
+{
+    auto program = parse_script(source);
+    if (!program)
+        return JS::js_undefined();
     auto& interpreter = document().interpreter();
     auto result = interpreter.run(interpreter.global_object(), *program);
     if (interpreter.exception())
@@ -28,6 +28,8 @@
 
 #include <AK/FlyString.h>
 #include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/String.h>
@@ -115,6 +117,9 @@ public:
     void force_layout();
     void invalidate_layout();
 
+    // Builds or updates the layout tree (resolving style along the way) without laying it out.
+    void update_layout_tree();
+
     void update_style();
     void update_layout();
 
@@ -125,8 +130,19 @@ public:
 
     void schedule_style_update();
 
+    const Element* get_element_by_id(const FlyString&) const;
+    Element* get_element_by_id(const FlyString& id) { return const_cast<Element*>(const_cast<const Document*>(this)->get_element_by_id(id)); }
+
     Vector<const Element*> get_elements_by_name(const String&) const;
     NonnullRefPtrVector<Element> get_elements_by_tag_name(const FlyString&) const;
+    NonnullRefPtrVector<Element> get_elements_by_class_name(const String&) const;
+
+    // The id and class indexes are kept up to date as elements are connected to or disconnected
+    // from the document, and when their id or class attribute changes.
+    void add_subtree_to_element_indexes(Node&);
+    void remove_subtree_from_element_indexes(Node&);
+    void add_to_element_indexes(Element&);
+    void remove_from_element_indexes(Element&);
 
     const String& source() const { return m_source; }
     void set_source(const String& source) { m_source = source; }
@@ -193,6 +209,7 @@ private:
     Optional<Color> m_visited_link_color;
 
     RefPtr<Core::Timer> m_style_update_timer;
+    RefPtr<Core::Timer> m_incremental_gc_timer;
 
     String m_source;
 
@@ -209,6 +226,12 @@ private:
 
     bool m_created_for_appropriate_template_contents { false };
     RefPtr<Document> m_associated_inert_template_document;
+
+    HashMap<FlyString, Vector<Element*>> m_elements_by_id;
+    HashMap<FlyString, HashTable<Element*>> m_elements_by_class_name;
+
+    // Results of get_elements_by_class_name(), thrown away whenever the indexes change.
+    mutable HashMap<String, NonnullRefPtrVector<Element>> m_elements_by_class_name_cache;
 };
 
 }
@@ -42,7 +42,6 @@
 #include <LibWeb/Layout/LayoutTableRow.h>
 #include <LibWeb/Layout/LayoutTableRowGroup.h>
 #include <LibWeb/Layout/LayoutText.h>
-#include <LibWeb/Layout/LayoutTreeBuilder.h>
 
 namespace Web::DOM {
 
@@ -81,27 +80,66 @@ String Element::attribute(const FlyString& name) const
     return {};
 }
 
+static bool affects_element_indexes(const FlyString& attribute_name)
+{
+    return attribute_name == HTML::AttributeNames::id || attribute_name == HTML::AttributeNames::class_;
+}
+
 void Element::set_attribute(const FlyString& name, const String& value)
 {
+    bool update_indexes = affects_element_indexes(name) && is_connected();
+    if (update_indexes)
+        document().remove_from_element_indexes(*this);
+
     if (auto* attribute = find_attribute(name))
         attribute->set_value(value);
     else
         m_attributes.empend(name, value);
 
     parse_attribute(name, value);
+
+    if (update_indexes)
+        document().add_to_element_indexes(*this);
+    did_change_attribute();
 }
 
 void Element::remove_attribute(const FlyString& name)
 {
+    bool update_indexes = affects_element_indexes(name) && is_connected();
+    if (update_indexes)
+        document().remove_from_element_indexes(*this);
+
     m_attributes.remove_first_matching([&](auto& attribute) { return attribute.name() == name; });
+    if (name == HTML::AttributeNames::class_)
+        m_classes.clear();
+
+    if (update_indexes)
+        document().add_to_element_indexes(*this);
+    did_change_attribute();
+}
+
+void Element::did_change_attribute()
+{
+    // Attributes set while parsing are picked up when the layout tree is first built.
+    if (!document().layout_node())
+        return;
+    set_needs_style_update(true);
+    document().schedule_style_update();
 }
 
 void Element::set_attributes(Vector<Attribute>&& attributes)
 {
+    bool update_indexes = is_connected();
+    if (update_indexes)
+        document().remove_from_element_indexes(*this);
+
     m_attributes = move(attributes);
 
     for (auto& attribute : m_attributes)
         parse_attribute(attribute.name(), attribute.value());
+
+    if (update_indexes)
+        document().add_to_element_indexes(*this);
 }
 
 bool Element::has_class(const FlyString& class_name) const
@@ -116,7 +154,8 @@ bool Element::has_class(const FlyString& class_name) const
 RefPtr<LayoutNode> Element::create_layout_node(const CSS::StyleProperties* parent_style)
 {
     auto style = document().style_resolver().resolve_style(*this, parent_style);
-    const_cast<Element&>(*this).m_resolved_style = style;
+    set_resolved_style(style, parent_style);
+    set_needs_style_update(false);
     auto display = style->display();
 
     if (display == CSS::Display::None)
@@ -168,6 +207,7 @@ enum class StyleDifference {
     None,
     NeedsRepaint,
     NeedsRelayout,
+    NeedsLayoutTreeUpdate,
 };
 
 static StyleDifference compute_style_difference(const CSS::StyleProperties& old_style, const CSS::StyleProperties& new_style, const Document& document)
@@ -175,22 +215,20 @@ static StyleDifference compute_style_difference(const CSS::StyleProperties& old_
     if (old_style == new_style)
         return StyleDifference::None;
 
-    bool needs_repaint = false;
-    bool needs_relayout = false;
-
+    // A different display type may need a different kind of layout node.
     if (new_style.display() != old_style.display())
-        needs_relayout = true;
+        return StyleDifference::NeedsLayoutTreeUpdate;
+
+    bool needs_repaint = false;
 
     if (new_style.color_or_fallback(CSS::PropertyID::Color, document, Color::Black) != old_style.color_or_fallback(CSS::PropertyID::Color, document, Color::Black))
         needs_repaint = true;
     else if (new_style.color_or_fallback(CSS::PropertyID::BackgroundColor, document, Color::Black) != old_style.color_or_fallback(CSS::PropertyID::BackgroundColor, document, Color::Black))
         needs_repaint = true;
 
-    if (needs_relayout)
-        return StyleDifference::NeedsRelayout;
     if (needs_repaint)
         return StyleDifference::NeedsRepaint;
-    return StyleDifference::None;
+    return StyleDifference::NeedsRelayout;
 }
 
 void Element::recompute_style()
@@ -202,13 +240,12 @@ void Element::recompute_style()
         return;
     ASSERT(parent_layout_node);
     auto style = document().style_resolver().resolve_style(*this, &parent_layout_node->specified_style());
-    m_resolved_style = style;
+    set_resolved_style(style, &parent_layout_node->specified_style());
     if (!layout_node()) {
         if (style->display() == CSS::Display::None)
             return;
         // We need a new layout tree here!
-        LayoutTreeBuilder tree_builder;
-        tree_builder.build(*this);
+        set_needs_layout_tree_update(true);
         return;
     }
 
@@ -219,14 +256,29 @@ void Element::recompute_style()
     auto diff = compute_style_difference(layout_node()->specified_style(), *style, document());
     if (diff == StyleDifference::None)
         return;
-    layout_node()->set_specified_style(*style);
-    if (diff == StyleDifference::NeedsRelayout) {
-        document().force_layout();
+    if (diff == StyleDifference::NeedsLayoutTreeUpdate) {
+        set_needs_layout_tree_update(true);
         return;
     }
-    if (diff == StyleDifference::NeedsRepaint) {
+    layout_node()->set_specified_style(*style);
+    layout_node()->apply_style(*style);
+
+    // Our children may inherit from the style that just changed.
+    set_child_needs_style_update(true);
+    for_each_child([&](auto& child) {
+        if (is<Element>(child))
+            child.set_needs_style_update(true);
+    });
+
+    // Relayout happens in Document::update_layout() once all styles are up to date.
+    if (diff == StyleDifference::NeedsRepaint)
         layout_node()->set_needs_display();
-    }
+}
+
+void Element::set_resolved_style(NonnullRefPtr<CSS::StyleProperties> style, const CSS::StyleProperties* parent_style)
+{
+    m_resolved_style = move(style);
+    m_resolved_parent_style = parent_style;
 }
 
 NonnullRefPtr<CSS::StyleProperties> Element::computed_style()
@@ -265,8 +317,8 @@ void Element::set_inner_html(StringView markup)
     }
 
     set_needs_style_update(true);
+    set_needs_layout_tree_update(true);
     document().schedule_style_update();
-    document().invalidate_layout();
 }
 
 String Element::inner_html() const
@@ -302,8 +354,8 @@ void Element::set_inner_text(StringView text)
     append_child(document().create_text_node(text));
 
     set_needs_style_update(true);
+    set_needs_layout_tree_update(true);
     document().schedule_style_update();
-    document().invalidate_layout();
 }
 
 String Element::inner_text()
@@ -54,6 +54,7 @@ public:
     const FlyString& tag_name() const { return local_name(); }
 
     bool has_attribute(const FlyString& name) const { return !attribute(name).is_null(); }
+    size_t attribute_count() const { return m_attributes.size(); }
     String attribute(const FlyString& name) const;
     String get_attribute(const FlyString& name) const { return attribute(name); }
     void set_attribute(const FlyString& name, const String& value);
@@ -82,6 +83,7 @@ public:
     String name() const { return attribute(HTML::AttributeNames::name); }
 
     const CSS::StyleProperties* resolved_style() const { return m_resolved_style.ptr(); }
+    const CSS::StyleProperties* resolved_parent_style() const { return m_resolved_parent_style.ptr(); }
     NonnullRefPtr<CSS::StyleProperties> computed_style();
 
     String inner_html() const;
@@ -103,8 +105,14 @@ private:
     FlyString m_tag_name;
     Vector<Attribute> m_attributes;
 
+    void set_resolved_style(NonnullRefPtr<CSS::StyleProperties>, const CSS::StyleProperties* parent_style);
+    void did_change_attribute();
+
     RefPtr<CSS::StyleProperties> m_resolved_style;
 
+    // The parent style that m_resolved_style was resolved against, so siblings can tell whether they may share it.
+    RefPtr<const CSS::StyleProperties> m_resolved_parent_style;
+
     Vector<FlyString> m_classes;
 };
 
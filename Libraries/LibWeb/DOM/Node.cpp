@@ -35,6 +35,7 @@
 #include <LibWeb/Bindings/NodeWrapper.h>
 #include <LibWeb/Bindings/NodeWrapperFactory.h>
 #include <LibWeb/CSS/StyleResolver.h>
+#include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
 #include <LibWeb/DOM/Event.h>
 #include <LibWeb/DOM/EventListener.h>
@@ -95,8 +96,8 @@ void Node::set_text_content(const String& content)
     }
 
     set_needs_style_update(true);
+    set_needs_layout_tree_update(true);
     document().schedule_style_update();
-    document().invalidate_layout();
 }
 
 RefPtr<LayoutNode> Node::create_layout_node(const CSS::StyleProperties*)
@@ -104,6 +105,24 @@ RefPtr<LayoutNode> Node::create_layout_node(const CSS::StyleProperties*)
     return nullptr;
 }
 
+void Node::set_needs_style_update(bool value)
+{
+    m_needs_style_update = value;
+    if (!value)
+        return;
+    for (auto* ancestor = parent(); ancestor && !ancestor->m_child_needs_style_update; ancestor = ancestor->parent())
+        ancestor->m_child_needs_style_update = true;
+}
+
+void Node::set_needs_layout_tree_update(bool value)
+{
+    m_needs_layout_tree_update = value;
+    if (!value)
+        return;
+    for (auto* ancestor = parent(); ancestor && !ancestor->m_child_needs_layout_tree_update; ancestor = ancestor->parent())
+        ancestor->m_child_needs_layout_tree_update = true;
+}
+
 void Node::invalidate_style()
 {
     for_each_in_subtree_of_type<Element>([&](auto& element) {
@@ -124,7 +143,8 @@ void Node::dispatch_event(NonnullRefPtr<Event> event)
         if (listener.event_name == event->type()) {
             auto& function = const_cast<EventListener&>(*listener.listener).function();
 #ifdef EVENT_DEBUG
-            static_cast<const JS::ScriptFunction&>(function).body().dump(0);
+            if (static_cast<const JS::ScriptFunction&>(function).has_body())
+                static_cast<const JS::ScriptFunction&>(function).body().dump(0);
 #endif
             auto& global_object = function.global_object();
             auto* this_value = wrap(global_object, *this);
@@ -172,6 +192,18 @@ bool Node::is_connected() const
     return root() && root()->is_document();
 }
 
+void Node::inserted_into(Node&)
+{
+    if (is_connected())
+        const_cast<Document&>(downcast<Document>(*root())).add_subtree_to_element_indexes(*this);
+}
+
+void Node::removed_from(Node& old_parent)
+{
+    if (old_parent.is_connected())
+        const_cast<Document&>(downcast<Document>(*old_parent.root())).remove_subtree_from_element_indexes(*this);
+}
+
 Element* Node::parent_element()
 {
     if (!parent() || !is<Element>(parent()))
@@ -189,6 +221,7 @@ const Element* Node::parent_element() const
 RefPtr<Node> Node::append_child(NonnullRefPtr<Node> node, bool notify)
 {
     TreeNode<Node>::append_child(node, notify);
+    did_change_children();
     return node;
 }
 
@@ -201,14 +234,25 @@ RefPtr<Node> Node::insert_before(NonnullRefPtr<Node> node, RefPtr<Node> child, b
         return nullptr;
     }
     TreeNode<Node>::insert_before(node, child, notify);
+    did_change_children();
     return node;
 }
 
+void Node::did_change_children()
+{
+    // Nothing to update until we have been laid out. The initial layout tree build takes care of new children.
+    if (!layout_node())
+        return;
+    set_needs_layout_tree_update(true);
+    document().schedule_style_update();
+}
+
 void Node::remove_all_children()
 {
     while (RefPtr<Node> child = first_child()) {
         remove_child(*child);
     }
+    did_change_children();
 }
 
 void Node::set_document(Badge<Document>, Document& document)
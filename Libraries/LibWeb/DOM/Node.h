@@ -108,8 +108,8 @@ public:
     Element* parent_element();
     const Element* parent_element() const;
 
-    virtual void inserted_into(Node&) { }
-    virtual void removed_from(Node&) { }
+    virtual void inserted_into(Node&);
+    virtual void removed_from(Node&);
     virtual void children_changed() { }
 
     const LayoutNode* layout_node() const { return m_layout_node; }
@@ -119,8 +119,17 @@ public:
 
     virtual bool is_child_allowed(const Node&) const { return true; }
 
+    // Dirty nodes mark their ancestors with the child_needs_* bits, so updates only have to visit dirty branches.
     bool needs_style_update() const { return m_needs_style_update; }
-    void set_needs_style_update(bool value) { m_needs_style_update = value; }
+    void set_needs_style_update(bool);
+    bool child_needs_style_update() const { return m_child_needs_style_update; }
+    void set_child_needs_style_update(bool value) { m_child_needs_style_update = value; }
+
+    // Set when this node's layout subtree no longer reflects the DOM and has to be rebuilt.
+    bool needs_layout_tree_update() const { return m_needs_layout_tree_update; }
+    void set_needs_layout_tree_update(bool);
+    bool child_needs_layout_tree_update() const { return m_child_needs_layout_tree_update; }
+    void set_child_needs_layout_tree_update(bool value) { m_child_needs_layout_tree_update = value; }
 
     void invalidate_style();
 
@@ -134,10 +143,15 @@ public:
 protected:
     Node(Document&, NodeType);
 
+    void did_change_children();
+
     Document* m_document { nullptr };
     mutable LayoutNode* m_layout_node { nullptr };
     NodeType m_type { NodeType::INVALID };
-    bool m_needs_style_update { true };
+    bool m_needs_style_update { false };
+    bool m_child_needs_style_update { false };
+    bool m_needs_layout_tree_update { false };
+    bool m_child_needs_layout_tree_update { false };
 };
 
 }
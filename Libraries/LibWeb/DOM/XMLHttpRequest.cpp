@@ -25,6 +25,7 @@
  */
 
 #include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/ArrayBuffer.h>
 #include <LibJS/Runtime/Function.h>
 #include <LibWeb/Bindings/EventWrapper.h>
 #include <LibWeb/Bindings/EventWrapperFactory.h>
@@ -60,10 +61,24 @@ String XMLHttpRequest::response_text() const
     return String::copy(m_response);
 }
 
+JS::Value XMLHttpRequest::response(JS::GlobalObject& global_object)
+{
+    if (m_response_type != ResponseType::ArrayBuffer)
+        return JS::js_string(global_object.heap(), response_text());
+    if (m_ready_state != ReadyState::Done || m_response.is_null())
+        return JS::js_null();
+    // The ArrayBuffer shares its bytes with the response rather than copying them.
+    if (m_response_array_buffer.is_null())
+        m_response_array_buffer = JS::make_handle(JS::ArrayBuffer::create(global_object, m_response));
+    return m_response_array_buffer.cell();
+}
+
 void XMLHttpRequest::open(const String& method, const String& url)
 {
     m_method = method;
     m_url = url;
+    m_response = {};
+    m_response_array_buffer = {};
     set_ready_state(ReadyState::Opened);
 }
 
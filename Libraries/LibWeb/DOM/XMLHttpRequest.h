@@ -29,6 +29,7 @@
 #include <AK/ByteBuffer.h>
 #include <AK/RefCounted.h>
 #include <AK/Weakable.h>
+#include <LibJS/Heap/Handle.h>
 #include <LibWeb/Bindings/Wrappable.h>
 #include <LibWeb/DOM/EventTarget.h>
 
@@ -48,6 +49,12 @@ public:
         Done,
     };
 
+    enum class ResponseType {
+        Empty,
+        Text,
+        ArrayBuffer,
+    };
+
     using WrapperType = Bindings::XMLHttpRequestWrapper;
 
     static NonnullRefPtr<XMLHttpRequest> create(DOM::Window& window) { return adopt(*new XMLHttpRequest(window)); }
@@ -59,6 +66,11 @@ public:
 
     ReadyState ready_state() const { return m_ready_state; };
     String response_text() const;
+    JS::Value response(JS::GlobalObject&);
+
+    ResponseType response_type() const { return m_response_type; }
+    void set_response_type(ResponseType response_type) { m_response_type = response_type; }
+
     void open(const String& method, const String& url);
     void send();
 
@@ -78,7 +90,10 @@ private:
     String m_method;
     String m_url;
 
+    ResponseType m_response_type { ResponseType::Empty };
+
     ByteBuffer m_response;
+    JS::Handle<JS::ArrayBuffer> m_response_array_buffer;
 };
 
 }
@@ -73,6 +73,7 @@ class HTMLDialogElement;
 class HTMLDivElement;
 class HTMLDListElement;
 class HTMLDocumentParser;
+class HTMLPreloadScanner;
 class HTMLElement;
 class HTMLEmbedElement;
 class HTMLFieldSetElement;
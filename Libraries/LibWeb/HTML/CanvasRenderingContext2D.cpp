@@ -25,7 +25,10 @@
  */
 
 #include <AK/OwnPtr.h>
+#include <LibCore/Timer.h>
+#include <LibGfx/Bitmap.h>
 #include <LibGfx/Painter.h>
+#include <LibJS/Runtime/TypedArray.h>
 #include <LibWeb/Bindings/CanvasRenderingContext2DWrapper.h>
 #include <LibWeb/HTML/CanvasRenderingContext2D.h>
 #include <LibWeb/HTML/HTMLCanvasElement.h>
@@ -37,6 +40,9 @@ namespace Web::HTML {
 CanvasRenderingContext2D::CanvasRenderingContext2D(HTMLCanvasElement& element)
     : m_element(element.make_weak_ptr())
 {
+    m_repaint_timer = Core::Timer::create_single_shot(0, [this] {
+        flush_pending_repaint();
+    });
 }
 
 CanvasRenderingContext2D::~CanvasRenderingContext2D()
@@ -109,6 +115,7 @@ void CanvasRenderingContext2D::draw_image(const HTMLImageElement& image_element,
     auto rect = m_transform.map(dst_rect);
 
     painter->draw_scaled_bitmap(enclosing_int_rect(rect), *image_element.bitmap(), src_rect);
+    did_draw(rect);
 }
 
 void CanvasRenderingContext2D::scale(float sx, float sy)
@@ -129,9 +136,17 @@ void CanvasRenderingContext2D::rotate(float radians)
     m_transform.rotate_radians(radians);
 }
 
-void CanvasRenderingContext2D::did_draw(const Gfx::FloatRect&)
+void CanvasRenderingContext2D::did_draw(const Gfx::FloatRect& rect)
+{
+    m_pending_repaint_rect = m_pending_repaint_rect.is_empty() ? rect : m_pending_repaint_rect.united(rect);
+    if (!m_repaint_timer->is_active())
+        m_repaint_timer->start();
+}
+
+void CanvasRenderingContext2D::flush_pending_repaint()
 {
     // FIXME: Make use of the rect to reduce the invalidated area when possible.
+    m_pending_repaint_rect = {};
     if (!m_element)
         return;
     if (!m_element->layout_node())
@@ -139,7 +154,7 @@ void CanvasRenderingContext2D::did_draw(const Gfx::FloatRect&)
     m_element->layout_node()->set_needs_display();
 }
 
-OwnPtr<Gfx::Painter> CanvasRenderingContext2D::painter()
+Gfx::Painter* CanvasRenderingContext2D::painter()
 {
     if (!m_element)
         return nullptr;
@@ -149,32 +164,39 @@ OwnPtr<Gfx::Painter> CanvasRenderingContext2D::painter()
             return nullptr;
     }
 
-    return make<Gfx::Painter>(*m_element->bitmap());
+    if (!m_painter || m_painter->target() != m_element->bitmap())
+        m_painter = make<Gfx::Painter>(*m_element->bitmap());
+    return m_painter;
 }
 
 void CanvasRenderingContext2D::begin_path()
 {
     m_path = Gfx::Path();
+    did_change_path();
 }
 
 void CanvasRenderingContext2D::close_path()
 {
     m_path.close();
+    did_change_path();
 }
 
 void CanvasRenderingContext2D::move_to(float x, float y)
 {
     m_path.move_to({ x, y });
+    did_change_path();
 }
 
 void CanvasRenderingContext2D::line_to(float x, float y)
 {
     m_path.line_to({ x, y });
+    did_change_path();
 }
 
 void CanvasRenderingContext2D::quadratic_curve_to(float cx, float cy, float x, float y)
 {
     m_path.quadratic_bezier_curve_to({ cx, cy }, { x, y });
+    did_change_path();
 }
 
 void CanvasRenderingContext2D::stroke()
@@ -184,6 +206,7 @@ void CanvasRenderingContext2D::stroke()
         return;
 
     painter->stroke_path(m_path, m_stroke_style, m_line_width);
+    did_draw(Gfx::FloatRect(painter->target()->rect()));
 }
 
 void CanvasRenderingContext2D::fill(Gfx::Painter::WindingRule winding)
@@ -192,9 +215,12 @@ void CanvasRenderingContext2D::fill(Gfx::Painter::WindingRule winding)
     if (!painter)
         return;
 
-    auto path = m_path;
-    path.close_all_subpaths();
-    painter->fill_path(path, m_fill_style, winding);
+    if (!m_closed_path.has_value()) {
+        m_closed_path = m_path;
+        m_closed_path.value().close_all_subpaths();
+    }
+    m_rasterizer.fill(*painter, m_closed_path.value(), m_fill_style, winding);
+    did_draw(Gfx::FloatRect(painter->target()->rect()));
 }
 
 void CanvasRenderingContext2D::fill(const String& fill_rule)
@@ -213,13 +239,51 @@ RefPtr<ImageData> CanvasRenderingContext2D::create_image_data(int width, int hei
     return ImageData::create_with_size(wrapper()->global_object(), width, height);
 }
 
+RefPtr<ImageData> CanvasRenderingContext2D::get_image_data(int x, int y, int width, int height) const
+{
+    auto image_data = create_image_data(width, height);
+    if (!image_data)
+        return nullptr;
+    if (!m_element || !m_element->bitmap())
+        return image_data;
+
+    // ImageData stores its pixels as R, G, B, A bytes, so we can't just blit into it.
+    auto& bitmap = *m_element->bitmap();
+    auto source_rect = Gfx::IntRect(x, y, width, height).intersected(bitmap.rect());
+    auto* data = reinterpret_cast<u8*>(image_data->data()->data());
+    for (int source_y = source_rect.top(); source_y <= source_rect.bottom(); ++source_y) {
+        auto* source = bitmap.scanline(source_y);
+        auto* destination = data + ((source_y - y) * width + (source_rect.left() - x)) * 4;
+        for (int source_x = source_rect.left(); source_x <= source_rect.right(); ++source_x) {
+            auto color = Color::from_rgba(source[source_x]);
+            *destination++ = color.red();
+            *destination++ = color.green();
+            *destination++ = color.blue();
+            *destination++ = color.alpha();
+        }
+    }
+    return image_data;
+}
+
 void CanvasRenderingContext2D::put_image_data(const ImageData& image_data, float x, float y)
 {
     auto painter = this->painter();
     if (!painter)
         return;
 
-    painter->blit(Gfx::IntPoint(x, y), image_data.bitmap(), image_data.bitmap().rect());
+    // Unlike other drawing operations, putImageData() replaces pixels and ignores the transform.
+    auto& bitmap = *painter->target();
+    Gfx::IntPoint origin(x, y);
+    auto destination_rect = Gfx::IntRect(origin, { (int)image_data.width(), (int)image_data.height() }).intersected(bitmap.rect());
+    auto* data = reinterpret_cast<const u8*>(image_data.data()->data());
+    for (int destination_y = destination_rect.top(); destination_y <= destination_rect.bottom(); ++destination_y) {
+        auto* destination = bitmap.scanline(destination_y);
+        auto* source = data + ((destination_y - origin.y()) * image_data.width() + (destination_rect.left() - origin.x())) * 4;
+        for (int destination_x = destination_rect.left(); destination_x <= destination_rect.right(); ++destination_x) {
+            destination[destination_x] = Color(source[0], source[1], source[2], source[3]).value();
+            source += 4;
+        }
+    }
 
     did_draw(Gfx::FloatRect(x, y, image_data.width(), image_data.height()));
 }
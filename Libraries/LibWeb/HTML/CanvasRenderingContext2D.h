@@ -26,12 +26,15 @@
 
 #pragma once
 
+#include <AK/Optional.h>
 #include <AK/RefCounted.h>
+#include <LibCore/Forward.h>
 #include <LibGfx/AffineTransform.h>
 #include <LibGfx/Color.h>
 #include <LibGfx/Forward.h>
 #include <LibGfx/Painter.h>
 #include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
 #include <LibWeb/Bindings/Wrappable.h>
 
 namespace Web::HTML {
@@ -79,6 +82,7 @@ public:
     void fill(const String& fill_rule);
 
     RefPtr<ImageData> create_image_data(int width, int height) const;
+    RefPtr<ImageData> get_image_data(int x, int y, int width, int height) const;
     void put_image_data(const ImageData&, float x, float y);
 
     HTMLCanvasElement* canvas() { return m_element; }
@@ -87,17 +91,30 @@ private:
     explicit CanvasRenderingContext2D(HTMLCanvasElement&);
 
     void did_draw(const Gfx::FloatRect&);
+    void flush_pending_repaint();
 
-    OwnPtr<Gfx::Painter> painter();
+    Gfx::Painter* painter();
+    void did_change_path() { m_closed_path.clear(); }
 
     WeakPtr<HTMLCanvasElement> m_element;
 
+    // The painter is kept for as long as the canvas keeps its bitmap.
+    OwnPtr<Gfx::Painter> m_painter;
+    Gfx::PathRasterizer m_rasterizer;
+
+    // Draws are coalesced into a single repaint of the canvas per turn of the event loop.
+    Gfx::FloatRect m_pending_repaint_rect;
+    RefPtr<Core::Timer> m_repaint_timer;
+
     Gfx::AffineTransform m_transform;
     Gfx::Color m_fill_style;
     Gfx::Color m_stroke_style;
     float m_line_width { 1 };
 
     Gfx::Path m_path;
+    // m_path with all its subpaths closed, kept so that filling the same path again doesn't
+    // need to split it into lines again.
+    Optional<Gfx::Path> m_closed_path;
 };
 
 }
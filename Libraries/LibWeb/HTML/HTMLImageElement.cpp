@@ -55,6 +55,11 @@ HTMLImageElement::HTMLImageElement(DOM::Document& document, const FlyString& tag
         if (layout_node())
             layout_node()->set_needs_display();
     };
+
+    m_image_loader.on_decode = [this] {
+        if (layout_node())
+            layout_node()->set_needs_display();
+    };
 }
 
 HTMLImageElement::~HTMLImageElement()
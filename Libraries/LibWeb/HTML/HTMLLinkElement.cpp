@@ -70,7 +70,8 @@ void HTMLLinkElement::resource_did_load()
     }
 
     // Transfer the rules from the successfully parsed sheet into the sheet we've already inserted.
-    m_style_sheet->rules() = sheet->rules();
+    auto rules = sheet->rules();
+    m_style_sheet->set_rules(move(rules));
 
     document().update_style();
 }
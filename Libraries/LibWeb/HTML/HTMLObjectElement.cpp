@@ -40,12 +40,14 @@ HTMLObjectElement::HTMLObjectElement(DOM::Document& document, const FlyString& t
 {
     m_image_loader.on_load = [this] {
         m_should_show_fallback_content = false;
-        this->document().force_layout();
+        set_needs_layout_tree_update(true);
+        this->document().layout();
     };
 
     m_image_loader.on_fail = [this] {
         m_should_show_fallback_content = true;
-        this->document().force_layout();
+        set_needs_layout_tree_update(true);
+        this->document().layout();
     };
 }
 
@@ -38,6 +38,7 @@
 #include <LibWeb/HTML/HTMLScriptElement.h>
 #include <LibWeb/HTML/HTMLTemplateElement.h>
 #include <LibWeb/HTML/Parser/HTMLDocumentParser.h>
+#include <LibWeb/HTML/Parser/HTMLPreloadScanner.h>
 #include <LibWeb/HTML/Parser/HTMLToken.h>
 
 namespace Web::HTML {
@@ -124,14 +125,29 @@ HTMLDocumentParser::HTMLDocumentParser(const StringView& input, const String& en
 {
 }
 
+HTMLDocumentParser::HTMLDocumentParser(const String& encoding)
+    : m_tokenizer(encoding)
+    , m_preload_scanner(make<HTMLPreloadScanner>(encoding))
+{
+    m_document = adopt(*new DOM::Document);
+}
+
 HTMLDocumentParser::~HTMLDocumentParser()
 {
 }
 
 void HTMLDocumentParser::run(const URL& url)
 {
+    if (m_finished_parsing)
+        return;
+
     m_document->set_url(url);
-    m_document->set_source(m_tokenizer.source());
+
+    // When we have all of the input up front, the preload scanner gets a copy of it the first time we run.
+    if (!m_preload_scanner && !m_parsing_fragment)
+        m_preload_scanner = make<HTMLPreloadScanner>(m_tokenizer.source(), "utf-8");
+    if (m_preload_scanner)
+        m_preload_scanner->scan(url);
 
     for (;;) {
         auto optional_token = m_tokenizer.next_token();
@@ -139,6 +155,13 @@ void HTMLDocumentParser::run(const URL& url)
             break;
         auto& token = optional_token.value();
 
+        // We may have had to wait for input right after a <pre> or <textarea> start tag, see handle_in_body().
+        if (m_ignore_next_line_feed) {
+            m_ignore_next_line_feed = false;
+            if (token.is_character() && token.code_point() == '\n')
+                continue;
+        }
+
 #ifdef PARSER_DEBUG
         dbg() << "[" << insertion_mode_name() << "] " << token.to_string();
 #endif
@@ -154,6 +177,14 @@ void HTMLDocumentParser::run(const URL& url)
 
     flush_character_insertions();
 
+    // We'll be back with more input later.
+    if (m_tokenizer.is_waiting_for_input() && !m_stop_parsing)
+        return;
+
+    m_finished_parsing = true;
+    m_preload_scanner = nullptr;
+    m_document->set_source(m_tokenizer.source());
+
     // "The end"
 
     auto scripts_to_execute_when_parsing_has_finished = m_document->take_scripts_to_execute_when_parsing_has_finished({});
@@ -169,6 +200,25 @@ void HTMLDocumentParser::run(const URL& url)
     }
 }
 
+void HTMLDocumentParser::insert_input(const StringView& input)
+{
+    m_tokenizer.insert_input_at_end(input);
+
+    // The tree builder may be busy waiting for a script, but that shouldn't stop us from discovering more resources.
+    if (m_preload_scanner) {
+        m_preload_scanner->insert_input(input);
+        if (m_document->url().is_valid())
+            m_preload_scanner->scan(m_document->url());
+    }
+}
+
+void HTMLDocumentParser::finish_input()
+{
+    m_tokenizer.close_input();
+    if (m_preload_scanner)
+        m_preload_scanner->finish_input();
+}
+
 void HTMLDocumentParser::process_using_the_rules_for(InsertionMode mode, HTMLToken& token)
 {
     switch (mode) {
@@ -556,6 +606,9 @@ void HTMLDocumentParser::handle_in_head(HTMLToken& token)
         }
 
         adjusted_insertion_location.parent->insert_before(element, adjusted_insertion_location.insert_before_sibling, false);
+        // The element isn't notified about being inserted, so we have to index it ourselves.
+        if (element->is_connected())
+            element->document().add_to_element_indexes(*element);
         m_stack_of_open_elements.push(element);
         m_tokenizer.switch_to({}, HTMLTokenizer::State::ScriptData);
         m_original_insertion_mode = m_insertion_mode;
@@ -679,22 +732,19 @@ void HTMLDocumentParser::flush_character_insertions()
     m_character_insertion_node->set_data(m_character_insertion_builder.to_string());
     m_character_insertion_node->parent()->children_changed();
     m_character_insertion_builder.clear();
+    m_character_insertion_node = nullptr;
 }
 
 void HTMLDocumentParser::insert_character(u32 data)
 {
     auto node = find_character_insertion_node();
-    if (node == m_character_insertion_node) {
-        m_character_insertion_builder.append(Utf32View { &data, 1 });
-        return;
-    }
-    if (!m_character_insertion_node) {
+    if (node != m_character_insertion_node) {
+        flush_character_insertions();
         m_character_insertion_node = node;
-        m_character_insertion_builder.append(Utf32View { &data, 1 });
-        return;
+        // The node may already have some text in it, e.g if we had to stop and wait for more input halfway through it.
+        if (node)
+            m_character_insertion_builder.append(node->data());
     }
-    flush_character_insertions();
-    m_character_insertion_node = node;
     m_character_insertion_builder.append(Utf32View { &data, 1 });
 }
 
@@ -1201,7 +1251,9 @@ void HTMLDocumentParser::handle_in_body(HTMLToken& token)
         // then ignore that token and move on to the next one.
         // (Newlines at the start of pre blocks are ignored as an authoring convenience.)
         auto next_token = m_tokenizer.next_token();
-        if (next_token.has_value() && next_token.value().is_character() && next_token.value().code_point() == '\n') {
+        if (!next_token.has_value() && m_tokenizer.is_waiting_for_input()) {
+            m_ignore_next_line_feed = true;
+        } else if (next_token.has_value() && next_token.value().is_character() && next_token.value().code_point() == '\n') {
             // Ignore it.
         } else {
             process_using_the_rules_for(m_insertion_mode, next_token.value());
@@ -1542,7 +1594,9 @@ void HTMLDocumentParser::handle_in_body(HTMLToken& token)
         m_frameset_ok = false;
         m_insertion_mode = InsertionMode::Text;
 
-        if (next_token.has_value() && next_token.value().is_character() && next_token.value().code_point() == '\n') {
+        if (!next_token.has_value() && m_tokenizer.is_waiting_for_input()) {
+            m_ignore_next_line_feed = true;
+        } else if (next_token.has_value() && next_token.value().is_character() && next_token.value().code_point() == '\n') {
             // Ignore it.
         } else {
             process_using_the_rules_for(m_insertion_mode, next_token.value());
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
 #include <LibWeb/DOM/Node.h>
 #include <LibWeb/HTML/Parser/HTMLTokenizer.h>
 #include <LibWeb/HTML/Parser/ListOfActiveFormattingElements.h>
@@ -65,10 +66,21 @@ class HTMLDocumentParser {
 public:
     HTMLDocumentParser(const StringView& input, const String& encoding);
     HTMLDocumentParser(const StringView& input, const String& encoding, DOM::Document& existing_document);
+
+    // Creates a parser for a document whose input arrives in pieces. Hand them over with insert_input(),
+    // calling run() after each one, and finish_input() once there's nothing more to come.
+    explicit HTMLDocumentParser(const String& encoding);
+
     ~HTMLDocumentParser();
 
+    // Parses as much of the input as is available. Once all of it has been parsed, "the end" steps run.
     void run(const URL&);
 
+    void insert_input(const StringView&);
+    void finish_input();
+
+    bool has_finished_parsing() const { return m_finished_parsing; }
+
     DOM::Document& document();
 
     static NonnullRefPtrVector<DOM::Node> parse_html_fragment(DOM::Element& context_element, const StringView&);
@@ -174,6 +186,10 @@ private:
     bool m_aborted { false };
     bool m_parser_pause_flag { false };
     bool m_stop_parsing { false };
+    bool m_finished_parsing { false };
+
+    OwnPtr<HTMLPreloadScanner> m_preload_scanner;
+    bool m_ignore_next_line_feed { false };
     size_t m_script_nesting_level { 0 };
 
     RefPtr<DOM::Document> m_document;
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibWeb/DOM/TagNames.h>
+#include <LibWeb/HTML/AttributeNames.h>
+#include <LibWeb/HTML/Parser/HTMLPreloadScanner.h>
+#include <LibWeb/Loader/LoadRequest.h>
+#include <LibWeb/Loader/ResourceLoader.h>
+
+namespace Web::HTML {
+
+HTMLPreloadScanner::HTMLPreloadScanner(const StringView& input, const String& encoding)
+    : m_tokenizer(input, encoding)
+{
+}
+
+HTMLPreloadScanner::HTMLPreloadScanner(const String& encoding)
+    : m_tokenizer(encoding)
+{
+}
+
+void HTMLPreloadScanner::scan(const URL& document_url)
+{
+    for (;;) {
+        auto token = m_tokenizer.next_token();
+        if (!token.has_value() || token.value().is_end_of_file())
+            break;
+        if (token.value().is_start_tag())
+            process_start_tag(token.value(), document_url);
+    }
+}
+
+void HTMLPreloadScanner::process_start_tag(HTMLToken& token, const URL& document_url)
+{
+    auto tag_name = token.tag_name();
+
+    if (tag_name == HTML::TagNames::script) {
+        auto src = token.attribute(HTML::AttributeNames::src);
+        if (!src.is_empty())
+            preload(Resource::Type::Generic, document_url.complete_url(src));
+    } else if (tag_name == HTML::TagNames::link) {
+        auto href = token.attribute(HTML::AttributeNames::href);
+        bool is_stylesheet = false;
+        bool is_alternate = false;
+        for (auto& part : token.attribute(HTML::AttributeNames::rel).split_view(' ')) {
+            if (part == "stylesheet")
+                is_stylesheet = true;
+            else if (part == "alternate")
+                is_alternate = true;
+        }
+        if (is_stylesheet && !is_alternate && !href.is_empty())
+            preload(Resource::Type::Generic, document_url.complete_url(href));
+    } else if (tag_name == HTML::TagNames::img) {
+        auto src = token.attribute(HTML::AttributeNames::src);
+        if (!src.is_empty())
+            preload(Resource::Type::Image, document_url.complete_url(src));
+    }
+
+    // We don't build a tree, so we have to do the tree builder's job of switching the tokenizer
+    // into the right state for elements whose contents aren't markup.
+    if (tag_name == HTML::TagNames::script)
+        m_tokenizer.set_state({}, HTMLTokenizer::State::ScriptData);
+    else if (tag_name.is_one_of(HTML::TagNames::style, HTML::TagNames::iframe, HTML::TagNames::noembed, HTML::TagNames::noframes, HTML::TagNames::noscript))
+        m_tokenizer.set_state({}, HTMLTokenizer::State::RAWTEXT);
+    else if (tag_name.is_one_of(HTML::TagNames::title, HTML::TagNames::textarea))
+        m_tokenizer.set_state({}, HTMLTokenizer::State::RCDATA);
+    else if (tag_name == HTML::TagNames::plaintext)
+        m_tokenizer.set_state({}, HTMLTokenizer::State::PLAINTEXT);
+}
+
+void HTMLPreloadScanner::preload(Resource::Type type, const URL& url)
+{
+    if (!url.is_valid())
+        return;
+    LoadRequest request;
+    request.set_url(url);
+    // NOTE: The resource cache holds on to the resource until the element that needs it asks for it.
+    ResourceLoader::the().load_resource(type, request);
+}
+
+}
@@ -193,6 +193,9 @@ namespace Web::HTML {
     }                     \
     }
 
+// "CounterClockwiseContourIntegral;"
+static constexpr size_t longest_entity_name_length = 32;
+
 static inline bool is_surrogate(u32 code_point)
 {
     return (code_point & 0xfffff800) == 0xd800;
@@ -215,8 +218,11 @@ static inline bool is_control(u32 code_point)
 
 Optional<u32> HTMLTokenizer::next_code_point()
 {
-    if (m_utf8_iterator == m_utf8_view.end())
+    if (m_utf8_iterator == m_utf8_view.end()) {
+        if (!m_input_is_complete)
+            m_starved = true;
         return {};
+    }
     m_prev_utf8_iterator = m_utf8_iterator;
     ++m_utf8_iterator;
 #ifdef TOKENIZER_TRACE
@@ -225,17 +231,39 @@ Optional<u32> HTMLTokenizer::next_code_point()
     return *m_prev_utf8_iterator;
 }
 
-Optional<u32> HTMLTokenizer::peek_code_point(size_t offset) const
+Optional<u32> HTMLTokenizer::peek_code_point(size_t offset)
 {
     auto it = m_utf8_iterator;
     for (size_t i = 0; i < offset && it != m_utf8_view.end(); ++i)
         ++it;
-    if (it == m_utf8_view.end())
+    if (it == m_utf8_view.end()) {
+        if (!m_input_is_complete)
+            m_starved = true;
         return {};
+    }
     return *it;
 }
 
 Optional<HTMLToken> HTMLTokenizer::next_token()
+{
+    if (m_input_is_complete || !m_queued_tokens.is_empty())
+        return consume_next_token();
+
+    // We don't know whether the input we have is enough to produce a token, so we just try.
+    // If we run out of input along the way, everything is rewound to how it was before we started,
+    // and we'll try again once more input has arrived.
+    m_starved = false;
+    save_checkpoint();
+    auto token = consume_next_token();
+    if (m_starved) {
+        restore_checkpoint();
+        return {};
+    }
+    m_checkpoint.clear();
+    return token;
+}
+
+Optional<HTMLToken> HTMLTokenizer::consume_next_token()
 {
 _StartOfFunction:
     if (!m_queued_tokens.is_empty())
@@ -1533,6 +1561,10 @@ _StartOfFunction:
             {
                 size_t byte_offset = m_utf8_view.byte_offset_of(m_prev_utf8_iterator);
 
+                // Don't settle for a shorter entity if the rest of a longer one may still be on its way.
+                if (!m_input_is_complete && m_decoded_input.length() - byte_offset <= longest_entity_name_length)
+                    m_starved = true;
+
                 auto match = HTML::code_points_from_entity(m_decoded_input.substring_view(byte_offset, m_decoded_input.length() - byte_offset - 1));
 
                 if (match.has_value()) {
@@ -2621,6 +2653,117 @@ HTMLTokenizer::HTMLTokenizer(const StringView& input, const String& encoding)
     m_utf8_iterator = m_utf8_view.begin();
 }
 
+HTMLTokenizer::HTMLTokenizer(const String& encoding)
+    : m_decoder(TextCodec::decoder_for(encoding))
+    , m_input_is_streamed(true)
+    , m_input_is_complete(false)
+{
+    ASSERT(m_decoder);
+    m_decoded_input = String::empty();
+    m_utf8_view = Utf8View(m_decoded_input);
+    m_utf8_iterator = m_utf8_view.begin();
+    m_prev_utf8_iterator = m_utf8_iterator;
+}
+
+// Returns the number of bytes at the end of the input that belong to a UTF-8 sequence that isn't complete yet.
+static size_t incomplete_utf8_sequence_length(const ByteBuffer& input)
+{
+    for (size_t i = 1; i <= min(input.size(), (size_t)3); ++i) {
+        u8 byte = input[input.size() - i];
+        if ((byte & 0xc0) == 0x80)
+            continue;
+        size_t sequence_length = 1;
+        if ((byte & 0xe0) == 0xc0)
+            sequence_length = 2;
+        else if ((byte & 0xf0) == 0xe0)
+            sequence_length = 3;
+        else if ((byte & 0xf8) == 0xf0)
+            sequence_length = 4;
+        return sequence_length > i ? i : 0;
+    }
+    return 0;
+}
+
+void HTMLTokenizer::insert_input_at_end(const StringView& input)
+{
+    ASSERT(m_input_is_streamed);
+    ASSERT(!m_input_is_complete);
+    m_undecoded_input.append(input.characters_without_null_termination(), input.length());
+
+    size_t held_back_length = 0;
+    if (m_decoder == TextCodec::decoder_for("utf-8"))
+        held_back_length = incomplete_utf8_sequence_length(m_undecoded_input);
+
+    size_t decodable_length = m_undecoded_input.size() - held_back_length;
+    append_decoded_input(m_decoder->to_utf8(StringView((const char*)m_undecoded_input.data(), decodable_length)));
+    m_undecoded_input = m_undecoded_input.slice(decodable_length, held_back_length);
+}
+
+void HTMLTokenizer::close_input()
+{
+    ASSERT(m_input_is_streamed);
+    if (m_input_is_complete)
+        return;
+    if (!m_undecoded_input.is_empty())
+        append_decoded_input(m_decoder->to_utf8(StringView((const char*)m_undecoded_input.data(), m_undecoded_input.size())));
+    m_undecoded_input.clear();
+    m_input_is_complete = true;
+    m_starved = false;
+}
+
+void HTMLTokenizer::append_decoded_input(const String& input)
+{
+    if (input.is_empty())
+        return;
+    m_source.append(input);
+
+    // Input that has already been tokenized is no longer needed, so we only hold on to what's left of it.
+    size_t byte_offset = m_utf8_view.byte_offset_of(m_utf8_iterator);
+    StringBuilder builder;
+    builder.append(m_decoded_input.substring_view(byte_offset, m_decoded_input.length() - byte_offset));
+    builder.append(input);
+    m_decoded_input = builder.to_string();
+    m_utf8_view = Utf8View(m_decoded_input);
+    m_utf8_iterator = m_utf8_view.begin();
+    m_prev_utf8_iterator = m_utf8_iterator;
+}
+
+void HTMLTokenizer::save_checkpoint()
+{
+    // NOTE: The last emitted start tag is only saved if it changes, see will_emit().
+    m_checkpoint = Checkpoint {
+        m_state,
+        m_return_state,
+        (size_t)m_utf8_view.byte_offset_of(m_utf8_iterator),
+        m_temporary_buffer,
+        m_current_token,
+        {},
+        m_has_emitted_eof,
+        m_character_reference_code,
+    };
+}
+
+void HTMLTokenizer::restore_checkpoint()
+{
+    ASSERT(m_checkpoint.has_value());
+    auto checkpoint = m_checkpoint.release_value();
+    m_state = checkpoint.state;
+    m_return_state = checkpoint.return_state;
+    m_temporary_buffer = move(checkpoint.temporary_buffer);
+    m_current_token = move(checkpoint.current_token);
+    if (checkpoint.last_emitted_start_tag.has_value())
+        m_last_emitted_start_tag = move(checkpoint.last_emitted_start_tag.value());
+    m_has_emitted_eof = checkpoint.has_emitted_eof;
+    m_character_reference_code = checkpoint.character_reference_code;
+    m_queued_tokens.clear();
+
+    // Drop everything before the rewind point, since we're not going to need it anymore.
+    m_decoded_input = m_decoded_input.substring(checkpoint.byte_offset, m_decoded_input.length() - checkpoint.byte_offset);
+    m_utf8_view = Utf8View(m_decoded_input);
+    m_utf8_iterator = m_utf8_view.begin();
+    m_prev_utf8_iterator = m_utf8_iterator;
+}
+
 void HTMLTokenizer::will_switch_to([[maybe_unused]] State new_state)
 {
 #ifdef TOKENIZER_TRACE
@@ -2645,8 +2788,11 @@ void HTMLTokenizer::switch_to(Badge<HTMLDocumentParser>, State new_state)
 
 void HTMLTokenizer::will_emit(HTMLToken& token)
 {
-    if (token.is_start_tag())
-        m_last_emitted_start_tag = token;
+    if (!token.is_start_tag())
+        return;
+    if (m_checkpoint.has_value() && !m_checkpoint.value().last_emitted_start_tag.has_value())
+        m_checkpoint.value().last_emitted_start_tag = move(m_last_emitted_start_tag);
+    m_last_emitted_start_tag = token;
 }
 
 bool HTMLTokenizer::current_end_tag_token_is_appropriate() const
@@ -26,13 +26,19 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/Queue.h>
+#include <AK/StringBuilder.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
 #include <AK/Utf8View.h>
 #include <LibWeb/Forward.h>
 #include <LibWeb/HTML/Parser/HTMLToken.h>
 
+namespace TextCodec {
+class Decoder;
+}
+
 namespace Web::HTML {
 
 #define ENUMERATE_TOKENIZER_STATES                                        \
@@ -121,24 +127,41 @@ class HTMLTokenizer {
 public:
     explicit HTMLTokenizer(const StringView& input, const String& encoding);
 
+    // Creates a tokenizer for input that arrives in pieces (e.g from the network.)
+    // Feed it with insert_input_at_end() and call close_input() once there's nothing more to come.
+    explicit HTMLTokenizer(const String& encoding);
+
     enum class State {
 #define __ENUMERATE_TOKENIZER_STATE(state) state,
         ENUMERATE_TOKENIZER_STATES
 #undef __ENUMERATE_TOKENIZER_STATE
     };
 
+    // Returns an empty Optional once all input has been tokenized, or when more input is needed to produce the next token.
     Optional<HTMLToken> next_token();
 
+    void insert_input_at_end(const StringView&);
+    void close_input();
+
+    bool is_waiting_for_input() const { return m_starved; }
+
     void switch_to(Badge<HTMLDocumentParser>, State new_state);
+    // The preload scanner has no tree builder to switch states for it, so it does that itself.
+    void set_state(Badge<HTMLPreloadScanner>, State new_state) { m_state = new_state; }
 
     void set_blocked(bool b) { m_blocked = b; }
     bool is_blocked() const { return m_blocked; }
 
-    String source() const { return m_decoded_input; }
+    String source() const { return m_input_is_streamed ? m_source.to_string() : m_decoded_input; }
 
 private:
+    Optional<HTMLToken> consume_next_token();
+    void append_decoded_input(const String&);
+    void save_checkpoint();
+    void restore_checkpoint();
+
     Optional<u32> next_code_point();
-    Optional<u32> peek_code_point(size_t offset) const;
+    Optional<u32> peek_code_point(size_t offset);
     bool consume_next_if_match(const StringView&, CaseSensitivity = CaseSensitivity::CaseSensitive);
     void create_new_token(HTMLToken::Type);
     bool current_end_tag_token_is_appropriate() const;
@@ -185,6 +208,26 @@ private:
     u32 m_character_reference_code { 0 };
 
     bool m_blocked { false };
+
+    TextCodec::Decoder* m_decoder { nullptr };
+    bool m_input_is_streamed { false };
+    bool m_input_is_complete { true };
+    bool m_starved { false };
+    ByteBuffer m_undecoded_input;
+    StringBuilder m_source;
+
+    // Where to rewind to if we run out of input halfway through a token.
+    struct Checkpoint {
+        State state;
+        State return_state;
+        size_t byte_offset;
+        Vector<u32> temporary_buffer;
+        HTMLToken current_token;
+        Optional<HTMLToken> last_emitted_start_tag;
+        bool has_emitted_eof;
+        u32 character_reference_code;
+    };
+    Optional<Checkpoint> m_checkpoint;
 };
 
 }
@@ -39,6 +39,9 @@ LayoutTreeBuilder::LayoutTreeBuilder()
 
 static RefPtr<LayoutNode> create_layout_tree(DOM::Node& node, const CSS::StyleProperties* parent_style)
 {
+    node.set_needs_layout_tree_update(false);
+    node.set_child_needs_layout_tree_update(false);
+
     auto layout_node = node.create_layout_node(parent_style);
     if (!layout_node)
         return nullptr;
@@ -86,4 +89,57 @@ RefPtr<LayoutNode> LayoutTreeBuilder::build(DOM::Node& node)
     return create_layout_tree(node, nullptr);
 }
 
+static bool rebuild_layout_subtree(DOM::Node& node)
+{
+    auto* parent_layout_node = node.parent() ? node.parent()->layout_node() : nullptr;
+    RefPtr<LayoutNode> old_layout_node = node.layout_node();
+
+    if (!old_layout_node) {
+        node.set_needs_layout_tree_update(false);
+        node.set_child_needs_layout_tree_update(false);
+        // If our parent isn't rendered, neither are we. Otherwise we don't know where to insert ourselves.
+        return !parent_layout_node;
+    }
+
+    auto* layout_parent = old_layout_node->parent();
+    if (!layout_parent || !parent_layout_node)
+        return false;
+
+    auto new_layout_node = create_layout_tree(node, &parent_layout_node->specified_style());
+    if (!new_layout_node) {
+        layout_parent->remove_child(*old_layout_node);
+        return true;
+    }
+
+    // Switching between inline and block would change how our siblings are wrapped.
+    if (new_layout_node->is_inline() != old_layout_node->is_inline())
+        return false;
+
+    layout_parent->insert_before(*new_layout_node, old_layout_node);
+    layout_parent->remove_child(*old_layout_node);
+    return true;
+}
+
+static bool update_dirty_subtree(DOM::Node& node)
+{
+    if (node.needs_layout_tree_update())
+        return rebuild_layout_subtree(node);
+
+    if (!node.child_needs_layout_tree_update())
+        return true;
+    node.set_child_needs_layout_tree_update(false);
+
+    bool updated_in_place = true;
+    node.for_each_child([&](auto& child) {
+        if (!update_dirty_subtree(child))
+            updated_in_place = false;
+    });
+    return updated_in_place;
+}
+
+bool LayoutTreeBuilder::update_dirty_subtrees(DOM::Document& document)
+{
+    return update_dirty_subtree(document);
+}
+
 }
@@ -36,6 +36,10 @@ public:
     LayoutTreeBuilder();
 
     RefPtr<LayoutNode> build(DOM::Node&);
+
+    // Rebuilds the layout subtrees of nodes that need a layout tree update, in place.
+    // Returns false if some change can't be made in place, and the whole tree needs to be rebuilt.
+    bool update_dirty_subtrees(DOM::Document&);
 };
 
 }
@@ -25,6 +25,7 @@
  */
 
 #include <AK/LexicalPath.h>
+#include <AK/TemporaryChange.h>
 #include <LibGemini/Document.h>
 #include <LibGfx/ImageDecoder.h>
 #include <LibMarkdown/Document.h>
@@ -146,6 +147,8 @@ bool FrameLoader::load(const URL& url, Type type)
         return false;
     }
 
+    abandon_streamed_document();
+
     LoadRequest request;
     request.set_url(url);
     set_resource(ResourceLoader::the().load_resource(Resource::Type::Generic, request));
@@ -200,10 +203,80 @@ void FrameLoader::load_error_page(const URL& failed_url, const String& error)
         });
 }
 
+void FrameLoader::resource_did_receive_data(ReadonlyBytes data)
+{
+    if (m_streamed_document_was_abandoned)
+        return;
+
+    if (!m_document_parser) {
+        // HTML is the only kind of document we can show before all of it has arrived.
+        if (resource()->mime_type() != "text/html")
+            return;
+        m_document_parser = make<HTML::HTMLDocumentParser>(resource()->encoding());
+    }
+
+    m_document_parser->insert_input(StringView(data.data(), data.size()));
+    parse_streamed_input();
+}
+
+void FrameLoader::parse_streamed_input()
+{
+    // A script run by the parser may spin a nested event loop (to load another script, for instance)
+    // during which more data arrives. The parser will get to it once it's back in the tokenizer.
+    if (m_is_parsing_streamed_input)
+        return;
+
+    auto url = resource()->url();
+    {
+        TemporaryChange change(m_is_parsing_streamed_input, true);
+        m_document_parser->run(url);
+    }
+
+    if (m_streamed_document_was_abandoned) {
+        m_streamed_document_was_abandoned = false;
+        m_document_parser = nullptr;
+        return;
+    }
+
+    // Show whatever we have so far. As more of the document gets parsed, it's laid out and painted incrementally.
+    auto& document = m_document_parser->document();
+    frame().set_document(&document);
+
+    if (!m_document_parser->has_finished_parsing())
+        return;
+
+    frame().page().client().page_did_change_title(document.title());
+
+    if (!url.fragment().is_empty())
+        frame().scroll_to_anchor(url.fragment());
+
+    m_document_parser = nullptr;
+}
+
+void FrameLoader::abandon_streamed_document()
+{
+    if (!m_document_parser)
+        return;
+
+    // If one of the parser's scripts started a new load, the parser is still somewhere up the stack,
+    // so it has to stay alive until parse_streamed_input() is back in control.
+    if (m_is_parsing_streamed_input) {
+        m_streamed_document_was_abandoned = true;
+        return;
+    }
+    m_document_parser = nullptr;
+}
+
 void FrameLoader::resource_did_load()
 {
     auto url = resource()->url();
 
+    if (m_document_parser && !m_streamed_document_was_abandoned) {
+        m_document_parser->finish_input();
+        parse_streamed_input();
+        return;
+    }
+
     if (!resource()->has_encoded_data()) {
         load_error_page(url, "No data");
         return;
@@ -233,6 +306,7 @@ void FrameLoader::resource_did_load()
 
 void FrameLoader::resource_did_fail()
 {
+    abandon_streamed_document();
     load_error_page(resource()->url(), resource()->error());
 }
 
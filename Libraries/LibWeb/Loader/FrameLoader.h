@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Forward.h>
+#include <AK/OwnPtr.h>
 #include <LibWeb/Forward.h>
 #include <LibWeb/Loader/Resource.h>
 
@@ -51,13 +52,22 @@ public:
 
 private:
     // ^ResourceClient
+    virtual void resource_did_receive_data(ReadonlyBytes) override;
     virtual void resource_did_load() override;
     virtual void resource_did_fail() override;
 
+    void parse_streamed_input();
+    void abandon_streamed_document();
+
     void load_error_page(const URL& failed_url, const String& error_message);
     RefPtr<DOM::Document> create_document_from_mime_type(const ByteBuffer&, const URL&, const String& mime_type, const String& encoding);
 
     Frame& m_frame;
+
+    // For HTML documents that are parsed while they're still arriving.
+    OwnPtr<HTML::HTMLDocumentParser> m_document_parser;
+    bool m_is_parsing_streamed_input { false };
+    bool m_streamed_document_was_abandoned { false };
 };
 
 }
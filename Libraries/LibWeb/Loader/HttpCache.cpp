@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/QuickSort.h>
+#include <AK/StringBuilder.h>
+#include <LibCore/DirIterator.h>
+#include <LibCore/File.h>
+#include <LibWeb/Loader/HttpCache.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//#define HTTP_CACHE_DEBUG
+
+namespace Web {
+
+static constexpr size_t max_size_in_memory = 32 * MiB;
+static constexpr size_t max_size_on_disk = 128 * MiB;
+static constexpr size_t max_entry_size = 4 * MiB;
+
+// We don't know how old things are without a Last-Modified header, but we also don't want to hang on to them forever.
+static constexpr time_t max_heuristic_freshness_lifetime = 24 * 60 * 60;
+
+HttpCache& HttpCache::the()
+{
+    static HttpCache* s_the;
+    if (!s_the)
+        s_the = new HttpCache;
+    return *s_the;
+}
+
+HttpCache::HttpCache()
+    : m_has_disk_storage(Core::File::is_directory(directory))
+{
+}
+
+// Parses an IMF-fixdate, e.g "Sun, 06 Nov 1994 08:49:37 GMT". The obsolete formats from RFC 7231 aren't supported.
+static Optional<time_t> parse_http_date(const String& string)
+{
+    static const char* month_names[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    auto parts = string.split(' ');
+    if (parts.size() != 6 || parts[5] != "GMT")
+        return {};
+
+    auto time_parts = parts[4].split(':');
+    if (time_parts.size() != 3)
+        return {};
+
+    Optional<int> month;
+    for (int i = 0; i < 12; ++i) {
+        if (parts[2] == month_names[i])
+            month = i;
+    }
+
+    auto day = parts[1].to_uint();
+    auto year = parts[3].to_uint();
+    auto hour = time_parts[0].to_uint();
+    auto minute = time_parts[1].to_uint();
+    auto second = time_parts[2].to_uint();
+    if (!month.has_value() || !day.has_value() || !year.has_value() || !hour.has_value() || !minute.has_value() || !second.has_value())
+        return {};
+
+    struct tm tm {};
+    tm.tm_year = year.value() - 1900;
+    tm.tm_mon = month.value();
+    tm.tm_mday = day.value();
+    tm.tm_hour = hour.value();
+    tm.tm_min = minute.value();
+    tm.tm_sec = second.value();
+    return timegm(&tm);
+}
+
+static Vector<String> cache_control_directives(const HttpCache::Headers& headers)
+{
+    Vector<String> directives;
+    auto cache_control = headers.get("Cache-Control");
+    if (!cache_control.has_value())
+        return directives;
+    for (auto& directive : cache_control.value().split(','))
+        directives.append(directive.trim_whitespace().to_lowercase());
+    return directives;
+}
+
+// https://tools.ietf.org/html/rfc7234#section-4.2.1
+static time_t freshness_lifetime(const HttpCache::Headers& headers, time_t response_time)
+{
+    Optional<time_t> max_age;
+    for (auto& directive : cache_control_directives(headers)) {
+        if (directive == "no-cache")
+            return 0;
+        if (directive.starts_with("max-age=")) {
+            auto value = directive.substring_view(8, directive.length() - 8).to_uint();
+            if (value.has_value())
+                max_age = value.value();
+        }
+    }
+
+    time_t age = 0;
+    if (auto age_header = headers.get("Age"); age_header.has_value())
+        age = age_header.value().to_uint().value_or(0);
+
+    if (max_age.has_value())
+        return max(max_age.value() - age, (time_t)0);
+
+    auto date = response_time;
+    if (auto date_header = headers.get("Date"); date_header.has_value())
+        date = parse_http_date(date_header.value()).value_or(response_time);
+
+    if (auto expires = headers.get("Expires"); expires.has_value()) {
+        // An invalid date (like "0") means that the response has already expired.
+        auto expiry_date = parse_http_date(expires.value());
+        if (!expiry_date.has_value())
+            return 0;
+        return max(expiry_date.value() - date, (time_t)0);
+    }
+
+    // https://tools.ietf.org/html/rfc7234#section-4.2.2
+    if (auto last_modified = headers.get("Last-Modified"); last_modified.has_value()) {
+        auto last_modified_date = parse_http_date(last_modified.value());
+        if (last_modified_date.has_value() && last_modified_date.value() < date)
+            return min((date - last_modified_date.value()) / 10, max_heuristic_freshness_lifetime);
+    }
+
+    return 0;
+}
+
+static bool is_cacheable(const HttpCache::Headers& headers)
+{
+    for (auto& directive : cache_control_directives(headers)) {
+        if (directive == "no-store")
+            return false;
+    }
+
+    // We don't keep track of the request headers a response varies on, so we can't tell whether it's reusable.
+    if (auto vary = headers.get("Vary"); vary.has_value() && !vary.value().trim_whitespace().is_empty())
+        return false;
+
+    return true;
+}
+
+const HttpCache::Entry* HttpCache::lookup(const URL& url)
+{
+    auto key = url.to_string();
+    if (auto it = m_entries.find(key); it != m_entries.end()) {
+        it->value->last_used = ++m_use_counter;
+        return it->value.ptr();
+    }
+
+    // Another process may have stored it.
+    auto entry = read_from_disk(key);
+    if (!entry)
+        return nullptr;
+    auto* entry_ptr = entry.ptr();
+    store_entry(entry.release_nonnull());
+    return entry_ptr;
+}
+
+void HttpCache::add_validators(const Entry& entry, HashMap<String, String>& request_headers)
+{
+    if (auto etag = entry.response_headers.get("ETag"); etag.has_value())
+        request_headers.set("If-None-Match", etag.value());
+    if (auto last_modified = entry.response_headers.get("Last-Modified"); last_modified.has_value())
+        request_headers.set("If-Modified-Since", last_modified.value());
+}
+
+void HttpCache::store(const URL& url, const ByteBuffer& body, const Headers& response_headers)
+{
+    auto key = url.to_string();
+    if (!is_cacheable(response_headers) || body.size() > max_entry_size) {
+        if (auto it = m_entries.find(key); it != m_entries.end()) {
+            m_size_in_memory -= it->value->body.size();
+            m_entries.remove(it);
+        }
+        return;
+    }
+
+    auto entry = make<Entry>();
+    entry->url = key;
+    entry->body = body;
+    entry->response_headers = response_headers;
+    entry->response_time = time(nullptr);
+    entry->fresh_until = entry->response_time + freshness_lifetime(response_headers, entry->response_time);
+
+    // There's no point in keeping something that's stale right away and can't be revalidated.
+    if (!entry->is_fresh() && !entry->can_be_revalidated())
+        return;
+
+#ifdef HTTP_CACHE_DEBUG
+    dbg() << "HttpCache: Storing " << key << ", fresh for " << (entry->fresh_until - entry->response_time) << "s";
+#endif
+
+    write_to_disk(*entry);
+    store_entry(move(entry));
+}
+
+HttpCache::Headers HttpCache::did_revalidate(const URL& url, const ByteBuffer& body, const Headers& cached_headers, const Headers& updated_headers)
+{
+    // https://tools.ietf.org/html/rfc7234#section-4.3.4
+    auto headers = cached_headers;
+    for (auto& it : updated_headers) {
+        if (it.key.equals_ignoring_case("Content-Length"))
+            continue;
+        headers.set(it.key, it.value);
+    }
+    store(url, body, headers);
+    return headers;
+}
+
+void HttpCache::store_entry(NonnullOwnPtr<Entry> entry)
+{
+    entry->last_used = ++m_use_counter;
+    if (auto it = m_entries.find(entry->url); it != m_entries.end())
+        m_size_in_memory -= it->value->body.size();
+    m_size_in_memory += entry->body.size();
+    auto key = entry->url;
+    m_entries.set(key, move(entry));
+    evict_from_memory_if_needed();
+}
+
+void HttpCache::evict_from_memory_if_needed()
+{
+    while (m_size_in_memory > max_size_in_memory) {
+        const Entry* least_recently_used = nullptr;
+        for (auto& it : m_entries) {
+            if (!least_recently_used || it.value->last_used < least_recently_used->last_used)
+                least_recently_used = it.value.ptr();
+        }
+        m_size_in_memory -= least_recently_used->body.size();
+        m_entries.remove(least_recently_used->url);
+    }
+}
+
+String HttpCache::path_for(const String& url) const
+{
+    return String::format("%s/%08x", directory, url.hash());
+}
+
+// The file format is simple: The URL, the response and expiry times, and the response headers, one per line.
+// After those comes an empty line, and the rest of the file is the response body.
+OwnPtr<HttpCache::Entry> HttpCache::read_from_disk(const String& url)
+{
+    if (!m_has_disk_storage)
+        return nullptr;
+
+    auto file_or_error = Core::File::open(path_for(url), Core::IODevice::ReadOnly);
+    if (file_or_error.is_error())
+        return nullptr;
+    auto data = file_or_error.value()->read_all();
+
+    size_t offset = 0;
+    auto read_line = [&]() -> Optional<StringView> {
+        for (size_t i = offset; i < data.size(); ++i) {
+            if (data[i] == '\n') {
+                StringView line((const char*)data.data() + offset, i - offset);
+                offset = i + 1;
+                return line;
+            }
+        }
+        return {};
+    };
+
+    auto url_line = read_line();
+    // Different URLs can end up in the same file, in which case the latest one wins.
+    if (!url_line.has_value() || url_line.value() != url)
+        return nullptr;
+
+    auto times_line = read_line();
+    if (!times_line.has_value())
+        return nullptr;
+    auto times = times_line.value().split_view(' ');
+    if (times.size() != 2)
+        return nullptr;
+
+    auto entry = make<Entry>();
+    entry->url = url;
+    entry->response_time = times[0].to_uint().value_or(0);
+    entry->fresh_until = times[1].to_uint().value_or(0);
+
+    for (;;) {
+        auto line = read_line();
+        if (!line.has_value())
+            return nullptr;
+        if (line.value().is_empty())
+            break;
+        auto colon = line.value().find_first_of(':');
+        if (!colon.has_value() || colon.value() + 2 > line.value().length())
+            return nullptr;
+        entry->response_headers.set(line.value().substring_view(0, colon.value()), line.value().substring_view(colon.value() + 2, line.value().length() - colon.value() - 2));
+    }
+
+    entry->body = ByteBuffer::copy(data.data() + offset, data.size() - offset);
+
+#ifdef HTTP_CACHE_DEBUG
+    dbg() << "HttpCache: Read " << url << " from disk";
+#endif
+    return entry;
+}
+
+void HttpCache::write_to_disk(const Entry& entry)
+{
+    if (!m_has_disk_storage)
+        return;
+
+    StringBuilder builder;
+    builder.append(entry.url);
+    builder.append('\n');
+    builder.appendf("%u %u\n", (unsigned)entry.response_time, (unsigned)entry.fresh_until);
+    for (auto& it : entry.response_headers)
+        builder.appendf("%s: %s\n", it.key.characters(), it.value.characters());
+    builder.append('\n');
+    auto header = builder.to_string();
+
+    // Write to a temporary file first, so that other processes never see a half-written entry.
+    auto path = path_for(entry.url);
+    auto temporary_path = String::format("%s.%d", path.characters(), getpid());
+    {
+        auto file_or_error = Core::File::open(temporary_path, Core::IODevice::WriteOnly, 0600);
+        if (file_or_error.is_error())
+            return;
+        auto& file = *file_or_error.value();
+        if (!file.write(header) || !file.write(entry.body.data(), entry.body.size())) {
+            unlink(temporary_path.characters());
+            return;
+        }
+    }
+    if (rename(temporary_path.characters(), path.characters()) < 0) {
+        unlink(temporary_path.characters());
+        return;
+    }
+
+    evict_from_disk_if_needed();
+}
+
+void HttpCache::evict_from_disk_if_needed()
+{
+    struct CachedFile {
+        String path;
+        size_t size;
+        time_t modification_time;
+    };
+
+    Vector<CachedFile> files;
+    size_t total_size = 0;
+    Core::DirIterator it(directory, Core::DirIterator::SkipDots);
+    while (it.has_next()) {
+        auto path = it.next_full_path();
+        struct stat st;
+        if (stat(path.characters(), &st) < 0)
+            continue;
+        files.append({ path, (size_t)st.st_size, st.st_mtime });
+        total_size += st.st_size;
+    }
+
+    if (total_size <= max_size_on_disk)
+        return;
+
+    // NOTE: Files are only rewritten when an entry is stored or revalidated, so this is only roughly least-recently-used.
+    quick_sort(files, [](auto& a, auto& b) { return a.modification_time < b.modification_time; });
+    for (auto& file : files) {
+        if (total_size <= max_size_on_disk)
+            break;
+        if (unlink(file.path.characters()) == 0)
+            total_size -= file.size;
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/String.h>
+#include <AK/URL.h>
+#include <time.h>
+
+namespace Web {
+
+// A cache for HTTP(S) responses, following the freshness and validation rules of RFC 7234.
+// Entries are kept in memory, and also written to disk so that other processes can use them.
+// Both are capped in size, and the least recently used entries are evicted first.
+class HttpCache {
+public:
+    static constexpr const char* directory = "/tmp/webcache";
+
+    using Headers = HashMap<String, String, CaseInsensitiveStringTraits>;
+
+    struct Entry {
+        String url;
+        ByteBuffer body;
+        Headers response_headers;
+        time_t response_time { 0 };
+        time_t fresh_until { 0 };
+        u64 last_used { 0 };
+
+        bool is_fresh() const { return time(nullptr) < fresh_until; }
+        bool can_be_revalidated() const { return response_headers.contains("ETag") || response_headers.contains("Last-Modified"); }
+    };
+
+    static HttpCache& the();
+
+    const Entry* lookup(const URL&);
+
+    // Adds the validators of a cached entry to the request headers for a conditional request.
+    static void add_validators(const Entry&, HashMap<String, String>& request_headers);
+
+    void store(const URL&, const ByteBuffer& body, const Headers& response_headers);
+
+    // The server has confirmed that our copy is still good (with a 304), and may have sent updated headers along with that.
+    // Returns the headers to use from now on.
+    Headers did_revalidate(const URL&, const ByteBuffer& body, const Headers& cached_headers, const Headers& updated_headers);
+
+private:
+    HttpCache();
+
+    void store_entry(NonnullOwnPtr<Entry>);
+    void evict_from_memory_if_needed();
+
+    OwnPtr<Entry> read_from_disk(const String& url);
+    void write_to_disk(const Entry&);
+    void evict_from_disk_if_needed();
+    String path_for(const String& url) const;
+
+    HashMap<String, NonnullOwnPtr<Entry>> m_entries;
+    size_t m_size_in_memory { 0 };
+    u64 m_use_counter { 0 };
+    bool m_has_disk_storage { false };
+};
+
+}
@@ -69,8 +69,6 @@ void ImageLoader::resource_did_load()
         return;
     }
 
-    m_loading_state = LoadingState::Loaded;
-
 #ifdef IMAGE_LOADER_DEBUG
     if (!resource()->has_encoded_data()) {
         dbg() << "ImageLoader: Resource did load, no encoded data. URL: " << resource()->url();
@@ -88,12 +86,42 @@ void ImageLoader::resource_did_load()
             m_timer->on_timeout = [this] { animate(); };
             m_timer->start();
         }
+    } else if (resource()->has_encoded_data() && !resource()->has_attempted_decode()) {
+        // Wait for the first decode so the image's size is known once we're loaded.
+        resource()->decode_if_needed();
+        return;
+    }
+
+    finish_loading();
+}
+
+void ImageLoader::finish_loading()
+{
+    if (m_loading_state != LoadingState::Loading)
+        return;
+
+    if (!resource()->should_decode_in_process() && resource()->decode_failed()) {
+        m_loading_state = LoadingState::Failed;
+        if (on_fail)
+            on_fail();
+        return;
     }
 
+    m_loading_state = LoadingState::Loaded;
     if (on_load)
         on_load();
 }
 
+void ImageLoader::resource_did_decode()
+{
+    if (m_loading_state == LoadingState::Loading) {
+        finish_loading();
+        return;
+    }
+    if (on_decode)
+        on_decode();
+}
+
 void ImageLoader::animate()
 {
     if (!m_visible_in_viewport)
@@ -133,7 +161,7 @@ bool ImageLoader::has_image() const
         return false;
     if (resource()->should_decode_in_process())
         return const_cast<ImageResource*>(resource())->ensure_decoder().bitmap();
-    return true;
+    return !resource()->decode_failed();
 }
 
 unsigned ImageLoader::width() const
@@ -142,7 +170,7 @@ unsigned ImageLoader::width() const
         return 0;
     if (resource()->should_decode_in_process())
         return const_cast<ImageResource*>(resource())->ensure_decoder().width();
-    return bitmap() ? bitmap()->width() : 0;
+    return resource()->decoded_size().width();
 }
 
 unsigned ImageLoader::height() const
@@ -151,7 +179,7 @@ unsigned ImageLoader::height() const
         return 0;
     if (resource()->should_decode_in_process())
         return const_cast<ImageResource*>(resource())->ensure_decoder().height();
-    return bitmap() ? bitmap()->height() : 0;
+    return resource()->decoded_size().height();
 }
 
 const Gfx::Bitmap* ImageLoader::bitmap() const
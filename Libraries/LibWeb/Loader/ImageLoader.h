@@ -52,14 +52,17 @@ public:
     Function<void()> on_load;
     Function<void()> on_fail;
     Function<void()> on_animate;
+    Function<void()> on_decode;
 
 private:
     // ^ImageResourceClient
     virtual void resource_did_load() override;
     virtual void resource_did_fail() override;
+    virtual void resource_did_decode() override;
     virtual bool is_visible_in_viewport() const override { return m_visible_in_viewport; }
 
     void animate();
+    void finish_loading();
 
     enum class LoadingState {
         None,
@@ -24,7 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Badge.h>
 #include <AK/Function.h>
+#include <AK/HashTable.h>
+#include <AK/Queue.h>
 #include <LibGfx/Bitmap.h>
 #include <LibGfx/ImageDecoder.h>
 #include <LibImageDecoderClient/Client.h>
@@ -32,6 +35,109 @@
 
 namespace Web {
 
+// Keeps track of every out-of-process decoded bitmap. When they take up more than the budget,
+// the least recently used ones that aren't in the viewport are thrown away. They will be decoded
+// again if they're ever needed.
+class DecodedImageCache {
+public:
+    static constexpr size_t budget = 64 * MiB;
+
+    static DecodedImageCache& the()
+    {
+        static DecodedImageCache* s_the;
+        if (!s_the)
+            s_the = new DecodedImageCache;
+        return *s_the;
+    }
+
+    void did_decode(ImageResource& resource, size_t size_in_bytes)
+    {
+        m_resources.set(&resource);
+        m_size_in_bytes += size_in_bytes;
+        evict_if_needed();
+    }
+
+    void did_discard(ImageResource& resource, size_t size_in_bytes)
+    {
+        m_resources.remove(&resource);
+        ASSERT(m_size_in_bytes >= size_in_bytes);
+        m_size_in_bytes -= size_in_bytes;
+    }
+
+    u64 next_use() { return ++m_use_counter; }
+
+private:
+    void evict_if_needed()
+    {
+        while (m_size_in_bytes > budget) {
+            ImageResource* least_recently_used = nullptr;
+            for (auto* resource : m_resources) {
+                if (resource->is_visible_in_viewport())
+                    continue;
+                if (!least_recently_used || resource->last_used() < least_recently_used->last_used())
+                    least_recently_used = resource;
+            }
+            if (!least_recently_used)
+                return;
+            least_recently_used->discard_decoded_image({});
+        }
+    }
+
+    HashTable<ImageResource*> m_resources;
+    size_t m_size_in_bytes { 0 };
+    u64 m_use_counter { 0 };
+};
+
+// Hands out decode jobs to a small pool of ImageDecoder connections. Each connection is served by
+// its own ImageDecoder process, which decodes several images in parallel and remembers the ones it
+// has recently decoded. Identical images are always sent to the same connection, so that decoding
+// one again (e.g. after its bitmap was discarded) can be answered from that cache.
+class ImageDecodeQueue {
+public:
+    static constexpr size_t max_connections = 4;
+
+    static ImageDecodeQueue& the()
+    {
+        static ImageDecodeQueue* s_the;
+        if (!s_the)
+            s_the = new ImageDecodeQueue;
+        return *s_the;
+    }
+
+    void enqueue(ImageResource& resource)
+    {
+        auto& encoded_data = resource.encoded_data();
+        auto& connection = m_connections[string_hash((const char*)encoded_data.data(), encoded_data.size()) % max_connections];
+        connection.pending.enqueue(resource);
+        pump(connection);
+    }
+
+private:
+    struct Connection {
+        RefPtr<ImageDecoderClient::Client> client;
+        Queue<NonnullRefPtr<ImageResource>> pending;
+        size_t requests_in_flight { 0 };
+    };
+
+    void pump(Connection& connection)
+    {
+        while (!connection.pending.is_empty() && connection.requests_in_flight < ImageDecoderClient::Client::max_requests_in_flight) {
+            if (!connection.client)
+                connection.client = ImageDecoderClient::Client::construct();
+
+            auto resource = connection.pending.dequeue();
+            ++connection.requests_in_flight;
+            connection.client->decode_image(resource->encoded_data(), [this, &connection, resource = resource.ptr(), protector = resource](RefPtr<Gfx::Bitmap> bitmap) {
+                --connection.requests_in_flight;
+                resource->did_decode({}, move(bitmap));
+                pump(connection);
+            });
+        }
+    }
+
+    Connection m_connections[max_connections];
+};
+
 ImageResource::ImageResource(const LoadRequest& request)
     : Resource(Type::Image, request)
 {
@@ -39,6 +145,7 @@ ImageResource::ImageResource(const LoadRequest& request)
 
 ImageResource::~ImageResource()
 {
+    discard_decoded_image();
 }
 
 bool ImageResource::should_decode_in_process() const
@@ -65,24 +172,102 @@ const Gfx::Bitmap* ImageResource::bitmap(size_t frame_index) const
             return m_decoder->frame(frame_index).image;
         return m_decoder->bitmap();
     }
-    if (!m_decoded_image && !m_has_attempted_decode) {
-        auto image_decoder_client = ImageDecoderClient::Client::construct();
-        m_decoded_image = image_decoder_client->decode_image(encoded_data());
-        m_has_attempted_decode = true;
+
+    auto& self = const_cast<ImageResource&>(*this);
+    if (m_decoded_image && m_decoded_image->is_volatile()) {
+        if (!self.m_decoded_image->set_nonvolatile())
+            self.discard_decoded_image();
+    }
+    if (!m_decoded_image) {
+        self.decode_if_needed();
+        return nullptr;
     }
+    m_last_used = DecodedImageCache::the().next_use();
     return m_decoded_image;
 }
 
-void ImageResource::update_volatility()
+void ImageResource::decode_if_needed()
 {
-    if (!m_decoder)
+    if (!has_encoded_data() || should_decode_in_process())
+        return;
+    if (m_decoded_image || m_is_decoding || m_decode_failed)
         return;
+    m_is_decoding = true;
+    ImageDecodeQueue::the().enqueue(*this);
+}
 
+// The decoder hands us bitmaps in shared buffers, which the kernel can't purge.
+// Copy them into purgeable memory so they can be made volatile while out of view.
+static RefPtr<Gfx::Bitmap> make_purgeable(RefPtr<Gfx::Bitmap> bitmap)
+{
+    if (!bitmap || bitmap->is_indexed())
+        return bitmap;
+    auto purgeable_bitmap = Gfx::Bitmap::create_purgeable(bitmap->format(), bitmap->size());
+    if (!purgeable_bitmap)
+        return bitmap;
+    for (int y = 0; y < bitmap->height(); ++y)
+        memcpy(purgeable_bitmap->scanline(y), bitmap->scanline(y), bitmap->width() * sizeof(Gfx::RGBA32));
+    return purgeable_bitmap;
+}
+
+void ImageResource::did_decode(Badge<ImageDecodeQueue>, RefPtr<Gfx::Bitmap> bitmap)
+{
+    ASSERT(m_is_decoding);
+    m_is_decoding = false;
+    m_has_attempted_decode = true;
+
+    if (!bitmap) {
+        m_decode_failed = true;
+    } else {
+        m_decoded_image = make_purgeable(move(bitmap));
+        m_decoded_size = m_decoded_image->size();
+        m_last_used = DecodedImageCache::the().next_use();
+        DecodedImageCache::the().did_decode(*this, m_decoded_image->size_in_bytes());
+    }
+
+    for_each_client([](auto& client) {
+        static_cast<ImageResourceClient&>(client).resource_did_decode();
+    });
+}
+
+void ImageResource::discard_decoded_image(Badge<DecodedImageCache>)
+{
+    discard_decoded_image();
+}
+
+void ImageResource::discard_decoded_image()
+{
+    if (!m_decoded_image)
+        return;
+    DecodedImageCache::the().did_discard(*this, m_decoded_image->size_in_bytes());
+    m_decoded_image = nullptr;
+}
+
+bool ImageResource::is_visible_in_viewport() const
+{
     bool visible_in_viewport = false;
-    for_each_client([&](auto& client) {
+    const_cast<ImageResource&>(*this).for_each_client([&](auto& client) {
         if (static_cast<const ImageResourceClient&>(client).is_visible_in_viewport())
             visible_in_viewport = true;
     });
+    return visible_in_viewport;
+}
+
+void ImageResource::update_volatility()
+{
+    bool visible_in_viewport = is_visible_in_viewport();
+
+    if (m_decoded_image && m_decoded_image->is_purgeable()) {
+        if (!visible_in_viewport) {
+            m_decoded_image->set_volatile();
+        } else if (!m_decoded_image->set_nonvolatile()) {
+            discard_decoded_image();
+            decode_if_needed();
+        }
+    }
+
+    if (!m_decoder)
+        return;
 
     if (!visible_in_viewport) {
         m_decoder->set_volatile();
@@ -26,27 +26,55 @@
 
 #pragma once
 
+#include <LibGfx/Size.h>
 #include <LibWeb/Loader/Resource.h>
 
 namespace Web {
 
+class DecodedImageCache;
+class ImageDecodeQueue;
+
 class ImageResource final : public Resource {
     friend class Resource;
 
 public:
     virtual ~ImageResource() override;
     Gfx::ImageDecoder& ensure_decoder();
+
+    // Images that aren't decoded in-process are decoded asynchronously by the ImageDecoder
+    // service. Until that finishes, bitmap() returns null; clients are told about the new
+    // bitmap via resource_did_decode().
     const Gfx::Bitmap* bitmap(size_t frame_index = 0) const;
+    void decode_if_needed();
 
     bool should_decode_in_process() const;
 
+    bool has_attempted_decode() const { return m_has_attempted_decode; }
+    bool decode_failed() const { return m_decode_failed; }
+
+    // The size of the decoded image, which is remembered even if the bitmap gets discarded.
+    const Gfx::IntSize& decoded_size() const { return m_decoded_size; }
+
+    bool is_visible_in_viewport() const;
     void update_volatility();
 
+    void did_decode(Badge<ImageDecodeQueue>, RefPtr<Gfx::Bitmap>);
+    void discard_decoded_image(Badge<DecodedImageCache>);
+
+    u64 last_used() const { return m_last_used; }
+
 private:
     explicit ImageResource(const LoadRequest&);
+
+    void discard_decoded_image();
+
     RefPtr<Gfx::ImageDecoder> m_decoder;
-    mutable RefPtr<Gfx::Bitmap> m_decoded_image;
-    mutable bool m_has_attempted_decode { false };
+    RefPtr<Gfx::Bitmap> m_decoded_image;
+    Gfx::IntSize m_decoded_size;
+    bool m_is_decoding { false };
+    bool m_has_attempted_decode { false };
+    bool m_decode_failed { false };
+    mutable u64 m_last_used { 0 };
 };
 
 class ImageResourceClient : public ResourceClient {
@@ -55,6 +83,10 @@ public:
 
     virtual bool is_visible_in_viewport() const { return false; }
 
+    // Called whenever a new bitmap has been decoded for the resource, including when an image
+    // is decoded again after its bitmap was discarded.
+    virtual void resource_did_decode() { }
+
 protected:
     ImageResource* resource() { return static_cast<ImageResource*>(ResourceClient::resource()); }
     const ImageResource* resource() const { return static_cast<const ImageResource*>(ResourceClient::resource()); }
@@ -84,12 +84,9 @@ static String mime_type_from_content_type(const String& content_type)
     return content_type;
 }
 
-void Resource::did_load(Badge<ResourceLoader>, const ByteBuffer& data, const HashMap<String, String, CaseInsensitiveStringTraits>& headers)
+void Resource::set_response_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& headers)
 {
-    ASSERT(!m_loaded);
-    m_encoded_data = data;
     m_response_headers = headers;
-    m_loaded = true;
 
     auto content_type = headers.get("Content-Type");
     if (content_type.has_value()) {
@@ -111,6 +108,25 @@ void Resource::did_load(Badge<ResourceLoader>, const ByteBuffer& data, const Has
         m_encoding = "utf-8"; // FIXME: This doesn't seem nice.
         m_mime_type = Core::guess_mime_type_based_on_filename(url());
     }
+}
+
+void Resource::did_receive_data(Badge<ResourceLoader>, ReadonlyBytes data, const HashMap<String, String, CaseInsensitiveStringTraits>& headers)
+{
+    ASSERT(!m_loaded);
+    if (m_response_headers.is_empty())
+        set_response_headers(headers);
+
+    for_each_client([&](auto& client) {
+        client.resource_did_receive_data(data);
+    });
+}
+
+void Resource::did_load(Badge<ResourceLoader>, const ByteBuffer& data, const HashMap<String, String, CaseInsensitiveStringTraits>& headers)
+{
+    ASSERT(!m_loaded);
+    m_encoded_data = data;
+    m_loaded = true;
+    set_response_headers(headers);
 
     for_each_client([](auto& client) {
         client.resource_did_load();
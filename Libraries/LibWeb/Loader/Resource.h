@@ -77,6 +77,7 @@ public:
 
     void for_each_client(Function<void(ResourceClient&)>);
 
+    void did_receive_data(Badge<ResourceLoader>, ReadonlyBytes data, const HashMap<String, String, CaseInsensitiveStringTraits>& headers);
     void did_load(Badge<ResourceLoader>, const ByteBuffer& data, const HashMap<String, String, CaseInsensitiveStringTraits>& headers);
     void did_fail(Badge<ResourceLoader>, const String& error);
 
@@ -84,6 +85,8 @@ protected:
     explicit Resource(Type, const LoadRequest&);
 
 private:
+    void set_response_headers(const HashMap<String, String, CaseInsensitiveStringTraits>&);
+
     LoadRequest m_request;
     ByteBuffer m_encoded_data;
     Type m_type { Type::Generic };
@@ -100,6 +103,9 @@ class ResourceClient : public Weakable<ResourceClient> {
 public:
     virtual ~ResourceClient();
 
+    // Called with each piece of the resource's data as it arrives, before resource_did_load().
+    // NOTE: This is not called for reused resources.
+    virtual void resource_did_receive_data(ReadonlyBytes) { }
     virtual void resource_did_load() { }
     virtual void resource_did_fail() { }
 
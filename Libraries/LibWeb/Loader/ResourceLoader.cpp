@@ -31,6 +31,7 @@
 #include <LibCore/File.h>
 #include <LibProtocol/Client.h>
 #include <LibProtocol/Download.h>
+#include <LibWeb/Loader/HttpCache.h>
 #include <LibWeb/Loader/LoadRequest.h>
 #include <LibWeb/Loader/Resource.h>
 #include <LibWeb/Loader/ResourceLoader.h>
@@ -95,6 +96,14 @@ RefPtr<Resource> ResourceLoader::load_resource(Resource::Type type, const LoadRe
 
     s_resource_cache.set(request, resource);
 
+    // Documents, style sheets and scripts can be put to use before they're complete, images can't (yet.)
+    Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>&)> data_callback;
+    if (type == Resource::Type::Generic) {
+        data_callback = [=](auto data, auto& headers) {
+            const_cast<Resource&>(*resource).did_receive_data({}, data, headers);
+        };
+    }
+
     load(
         request.url(),
         [=](auto& data, auto& headers) {
@@ -102,12 +111,58 @@ RefPtr<Resource> ResourceLoader::load_resource(Resource::Type type, const LoadRe
         },
         [=](auto& error) {
             const_cast<Resource&>(*resource).did_fail({}, error);
-        });
+        },
+        move(data_callback));
 
     return resource;
 }
 
-void ResourceLoader::load(const URL& url, Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback)
+class ResourceWaiter final : public ResourceClient {
+public:
+    ResourceWaiter(Resource& resource, Resource::Type type)
+        : m_type(type)
+    {
+        set_resource(&resource);
+    }
+
+    void wait()
+    {
+        if (m_done)
+            return;
+        Core::EventLoop loop;
+        m_loop = &loop;
+        loop.exec();
+        m_loop = nullptr;
+    }
+
+private:
+    virtual Resource::Type client_type() const override { return m_type; }
+    virtual void resource_did_load() override { done(); }
+    virtual void resource_did_fail() override { done(); }
+
+    void done()
+    {
+        m_done = true;
+        if (m_loop)
+            m_loop->quit(0);
+    }
+
+    Resource::Type m_type;
+    Core::EventLoop* m_loop { nullptr };
+    bool m_done { false };
+};
+
+RefPtr<Resource> ResourceLoader::load_resource_sync(Resource::Type type, const LoadRequest& request)
+{
+    auto resource = load_resource(type, request);
+    if (!resource)
+        return nullptr;
+    ResourceWaiter waiter(*resource, type);
+    waiter.wait();
+    return resource;
+}
+
+void ResourceLoader::load(const URL& url, Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback, Function<void(ReadonlyBytes, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> data_callback)
 {
     if (is_port_blocked(url.port())) {
         dbg() << "ResourceLoader::load: Error: blocked port " << url.port() << " for URL: " << url;
@@ -157,13 +212,42 @@ void ResourceLoader::load(const URL& url, Function<void(const ByteBuffer&, const
     if (url.protocol() == "http" || url.protocol() == "https" || url.protocol() == "gemini") {
         HashMap<String, String> headers;
         headers.set("User-Agent", m_user_agent);
-        auto download = protocol_client().start_download(url.to_string(), headers);
+
+        bool is_http = url.protocol() == "http" || url.protocol() == "https";
+        ByteBuffer cached_body;
+        HttpCache::Headers cached_headers;
+        if (is_http) {
+            if (auto* entry = HttpCache::the().lookup(url)) {
+                if (entry->is_fresh()) {
+                    deferred_invoke([data = entry->body, response_headers = entry->response_headers, success_callback = move(success_callback)](auto&) {
+                        success_callback(data, response_headers);
+                    });
+                    return;
+                }
+                if (entry->can_be_revalidated()) {
+                    HttpCache::add_validators(*entry, headers);
+                    cached_body = entry->body;
+                    cached_headers = entry->response_headers;
+                }
+            }
+        }
+
+        auto download = protocol_client().start_download(url.to_string(), headers, static_cast<bool>(data_callback));
         if (!download) {
             if (error_callback)
                 error_callback("Failed to initiate load");
             return;
         }
-        download->on_finish = [this, success_callback = move(success_callback), error_callback = move(error_callback)](bool success, const ByteBuffer& payload, auto, auto& response_headers, auto status_code) {
+        if (data_callback) {
+            download->on_data_received = [download = download.ptr(), data_callback = move(data_callback)](auto data) {
+                // Redirects and error responses are not worth looking at early.
+                auto status_code = download->status_code();
+                if (status_code.has_value() && (status_code.value() < 200 || status_code.value() > 299))
+                    return;
+                data_callback(data, download->response_headers());
+            };
+        }
+        download->on_finish = [this, url, is_http, cached_body, cached_headers, success_callback = move(success_callback), error_callback = move(error_callback)](bool success, const ByteBuffer& payload, auto, auto& response_headers, auto status_code) {
             --m_pending_loads;
             if (on_load_counter_change)
                 on_load_counter_change();
@@ -177,7 +261,14 @@ void ResourceLoader::load(const URL& url, Function<void(const ByteBuffer&, const
                     error_callback(String::format("HTTP error (%u)", status_code.value()));
                 return;
             }
-            success_callback(ByteBuffer::copy(payload.data(), payload.size()), response_headers);
+            if (status_code.has_value() && status_code.value() == 304 && !cached_body.is_null()) {
+                success_callback(cached_body, HttpCache::the().did_revalidate(url, cached_body, cached_headers, response_headers));
+                return;
+            }
+            auto data = ByteBuffer::copy(payload.data(), payload.size());
+            if (is_http && status_code.has_value() && status_code.value() == 200)
+                HttpCache::the().store(url, data, response_headers);
+            success_callback(data, response_headers);
         };
         download->on_certificate_requested = []() -> Protocol::Download::CertificateAndKey {
             return {};
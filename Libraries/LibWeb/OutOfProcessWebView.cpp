@@ -35,7 +35,7 @@
 OutOfProcessWebView::OutOfProcessWebView()
 {
     set_should_hide_unnecessary_scrollbars(true);
-    m_client = WebContentClient::construct(*this);
+    m_client = WebContentClient::create_for_view(*this);
     client().post_message(Messages::WebContentServer::UpdateSystemTheme(Gfx::current_system_theme_buffer_id()));
 }
 
@@ -43,6 +43,11 @@ OutOfProcessWebView::~OutOfProcessWebView()
 {
 }
 
+void OutOfProcessWebView::set_prelaunched_process_count(size_t count)
+{
+    WebContentClient::set_prelaunch_count(count);
+}
+
 void OutOfProcessWebView::load(const URL& url)
 {
     m_url = url;
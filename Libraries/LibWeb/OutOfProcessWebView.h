@@ -44,6 +44,9 @@ public:
     URL url() const { return m_url; }
     void load(const URL&);
 
+    // Keeps this many WebContent processes started ahead of time for views created later on.
+    static void set_prelaunched_process_count(size_t);
+
     void notify_server_did_layout(Badge<WebContentClient>, const Gfx::IntSize& content_size);
     void notify_server_did_paint(Badge<WebContentClient>, i32 shbuf_id);
     void notify_server_did_invalidate_content_rect(Badge<WebContentClient>, const Gfx::IntRect&);
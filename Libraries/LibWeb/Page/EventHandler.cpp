@@ -291,8 +291,8 @@ bool EventHandler::handle_keydown(KeyCode key, unsigned modifiers, u32 code_poin
             builder.append(text_node.data().substring_view(m_frame.cursor_position().offset(), text_node.data().length() - m_frame.cursor_position().offset()));
             text_node.set_data(builder.to_string());
             m_frame.set_cursor_position({ *m_frame.cursor_position().node(), m_frame.cursor_position().offset() - 1 });
-            // FIXME: This should definitely use incremental layout invalidation instead!
-            text_node.document().force_layout();
+            text_node.set_needs_layout_tree_update(true);
+            text_node.document().layout();
             return true;
         }
 
@@ -305,8 +305,8 @@ bool EventHandler::handle_keydown(KeyCode key, unsigned modifiers, u32 code_poin
             text_node.set_data(builder.to_string());
             // FIXME: This will advance the cursor incorrectly when inserting multiple whitespaces (DOM vs layout whitespace collapse difference.)
             m_frame.set_cursor_position({ *m_frame.cursor_position().node(), m_frame.cursor_position().offset() + 1 });
-            // FIXME: This should definitely use incremental layout invalidation instead!
-            text_node.document().force_layout();
+            text_node.set_needs_layout_tree_update(true);
+            text_node.document().layout();
             return true;
         }
     }
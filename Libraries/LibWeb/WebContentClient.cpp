@@ -26,20 +26,70 @@
 
 #include "WebContentClient.h"
 #include "OutOfProcessWebView.h"
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/SharedBuffer.h>
+#include <LibCore/Timer.h>
 
-WebContentClient::WebContentClient(OutOfProcessWebView& view)
+// Starting a process right as a view is created would compete with that view's first load.
+static constexpr int prelaunch_delay_ms = 500;
+
+static size_t s_prelaunch_count = 0;
+static NonnullRefPtrVector<WebContentClient> s_prelaunched_clients;
+static RefPtr<Core::Timer> s_prelaunch_timer;
+
+WebContentClient::WebContentClient()
     : IPC::ServerConnection<WebContentClientEndpoint, WebContentServerEndpoint>(*this, "/tmp/portal/webcontent")
-    , m_view(view)
 {
     handshake();
 }
 
 void WebContentClient::handshake()
 {
-    auto response = send_sync<Messages::WebContentServer::Greet>(getpid());
-    set_my_client_id(response->client_id());
-    set_server_pid(response->server_pid());
+    send_async<Messages::WebContentServer::Greet>([this](auto response) {
+        set_my_client_id(response->client_id());
+        set_server_pid(response->server_pid());
+        enable_shared_ring();
+    },
+        getpid());
+}
+
+NonnullRefPtr<WebContentClient> WebContentClient::create_for_view(OutOfProcessWebView& view)
+{
+    RefPtr<WebContentClient> client;
+    if (!s_prelaunched_clients.is_empty())
+        client = s_prelaunched_clients.take_first();
+    else
+        client = WebContentClient::construct();
+    client->m_view = &view;
+
+    // We can't share buffers with the server until we know its pid, so finish the handshake first.
+    // For a prelaunched process this has usually happened already.
+    client->wait_for_pending_responses();
+
+    schedule_prelaunch();
+    return client.release_nonnull();
+}
+
+void WebContentClient::set_prelaunch_count(size_t count)
+{
+    s_prelaunch_count = count;
+    while (s_prelaunched_clients.size() > s_prelaunch_count)
+        s_prelaunched_clients.take_last();
+    schedule_prelaunch();
+}
+
+void WebContentClient::schedule_prelaunch()
+{
+    if (s_prelaunched_clients.size() >= s_prelaunch_count)
+        return;
+    if (!s_prelaunch_timer) {
+        s_prelaunch_timer = Core::Timer::create_single_shot(prelaunch_delay_ms, [] {
+            while (s_prelaunched_clients.size() < s_prelaunch_count)
+                s_prelaunched_clients.append(WebContentClient::construct());
+        });
+    }
+    if (!s_prelaunch_timer->is_active())
+        s_prelaunch_timer->start();
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidPaint& message)
@@ -47,7 +97,7 @@ void WebContentClient::handle(const Messages::WebContentClient::DidPaint& messag
 #ifdef DEBUG_SPAM
     dbg() << "handle: WebContentClient::DidPaint! content_rect=" << message.content_rect() << ", shbuf_id=" << message.shbuf_id();
 #endif
-    m_view.notify_server_did_paint({}, message.shbuf_id());
+    view().notify_server_did_paint({}, message.shbuf_id());
 }
 
 void WebContentClient::handle([[maybe_unused]] const Messages::WebContentClient::DidFinishLoad& message)
@@ -64,7 +114,7 @@ void WebContentClient::handle(const Messages::WebContentClient::DidInvalidateCon
 #endif
 
     // FIXME: Figure out a way to coalesce these messages to reduce unnecessary painting
-    m_view.notify_server_did_invalidate_content_rect({}, message.content_rect());
+    view().notify_server_did_invalidate_content_rect({}, message.content_rect());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidChangeSelection&)
@@ -72,7 +122,7 @@ void WebContentClient::handle(const Messages::WebContentClient::DidChangeSelecti
 #ifdef DEBUG_SPAM
     dbg() << "handle: WebContentClient::DidChangeSelection!";
 #endif
-    m_view.notify_server_did_change_selection({});
+    view().notify_server_did_change_selection({});
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidLayout& message)
@@ -80,7 +130,7 @@ void WebContentClient::handle(const Messages::WebContentClient::DidLayout& messa
 #ifdef DEBUG_SPAM
     dbg() << "handle: WebContentClient::DidLayout! content_size=" << message.content_size();
 #endif
-    m_view.notify_server_did_layout({}, message.content_size());
+    view().notify_server_did_layout({}, message.content_size());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidChangeTitle& message)
@@ -88,7 +138,7 @@ void WebContentClient::handle(const Messages::WebContentClient::DidChangeTitle&
 #ifdef DEBUG_SPAM
     dbg() << "handle: WebContentClient::DidChangeTitle! title=" << message.title();
 #endif
-    m_view.notify_server_did_change_title({}, message.title());
+    view().notify_server_did_change_title({}, message.title());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidRequestScrollIntoView& message)
@@ -96,7 +146,7 @@ void WebContentClient::handle(const Messages::WebContentClient::DidRequestScroll
 #ifdef DEBUG_SPAM
     dbg() << "handle: WebContentClient::DidRequestScrollIntoView! rect=" << message.rect();
 #endif
-    m_view.notify_server_did_request_scroll_into_view({}, message.rect());
+    view().notify_server_did_request_scroll_into_view({}, message.rect());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidHoverLink& message)
@@ -104,7 +154,7 @@ void WebContentClient::handle(const Messages::WebContentClient::DidHoverLink& me
 #ifdef DEBUG_SPAM
     dbg() << "handle: WebContentClient::DidHoverLink! url=" << message.url();
 #endif
-    m_view.notify_server_did_hover_link({}, message.url());
+    view().notify_server_did_hover_link({}, message.url());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidUnhoverLink&)
@@ -112,30 +162,30 @@ void WebContentClient::handle(const Messages::WebContentClient::DidUnhoverLink&)
 #ifdef DEBUG_SPAM
     dbg() << "handle: WebContentClient::DidUnhoverLink!";
 #endif
-    m_view.notify_server_did_unhover_link({});
+    view().notify_server_did_unhover_link({});
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidClickLink& message)
 {
-    m_view.notify_server_did_click_link({}, message.url(), message.target(), message.modifiers());
+    view().notify_server_did_click_link({}, message.url(), message.target(), message.modifiers());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidMiddleClickLink& message)
 {
-    m_view.notify_server_did_middle_click_link({}, message.url(), message.target(), message.modifiers());
+    view().notify_server_did_middle_click_link({}, message.url(), message.target(), message.modifiers());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidStartLoading& message)
 {
-    m_view.notify_server_did_start_loading({}, message.url());
+    view().notify_server_did_start_loading({}, message.url());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidRequestContextMenu& message)
 {
-    m_view.notify_server_did_request_context_menu({}, message.content_position());
+    view().notify_server_did_request_context_menu({}, message.content_position());
 }
 
 void WebContentClient::handle(const Messages::WebContentClient::DidRequestLinkContextMenu& message)
 {
-    m_view.notify_server_did_request_link_context_menu({}, message.content_position(), message.url(), message.target(), message.modifiers());
+    view().notify_server_did_request_link_context_menu({}, message.content_position(), message.url(), message.target(), message.modifiers());
 }
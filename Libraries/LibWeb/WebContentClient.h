@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
 #include <LibIPC/ServerConnection.h>
 #include <WebContent/WebContentClientEndpoint.h>
 #include <WebContent/WebContentServerEndpoint.h>
@@ -41,8 +42,22 @@ class WebContentClient
 public:
     virtual void handshake() override;
 
+    // Returns a connection for the given view, taking one of the prelaunched processes if there is one.
+    static NonnullRefPtr<WebContentClient> create_for_view(OutOfProcessWebView&);
+
+    // Keeps this many idle WebContent processes around, so new views don't have to wait for one to start.
+    static void set_prelaunch_count(size_t);
+
 private:
-    WebContentClient(OutOfProcessWebView&);
+    WebContentClient();
+
+    static void schedule_prelaunch();
+
+    OutOfProcessWebView& view()
+    {
+        ASSERT(m_view);
+        return *m_view;
+    }
 
     virtual void handle(const Messages::WebContentClient::DidPaint&) override;
     virtual void handle(const Messages::WebContentClient::DidFinishLoad&) override;
@@ -59,5 +74,5 @@ private:
     virtual void handle(const Messages::WebContentClient::DidRequestContextMenu&) override;
     virtual void handle(const Messages::WebContentClient::DidRequestLinkContextMenu&) override;
 
-    OutOfProcessWebView& m_view;
+    OutOfProcessWebView* m_view { nullptr };
 };
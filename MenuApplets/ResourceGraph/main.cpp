@@ -129,9 +129,10 @@ private:
         busy = 0;
         idle = 0;
 
-        auto all_processes = Core::ProcessStatisticsReader::get_all();
+        static Core::ProcessStatisticsReader reader;
+        reader.update();
 
-        for (auto& it : all_processes) {
+        for (auto& it : reader.processes()) {
             for (auto& jt : it.value.threads) {
                 if (it.value.pid == 0)
                     idle += jt.times_scheduled;
@@ -235,6 +236,11 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    if (unveil("/proc/all.bin", "r") < 0) {
+        perror("unveil");
+        return 1;
+    }
+
     if (unveil("/proc/memstat", "r") < 0) {
         perror("unveil");
         return 1;
@@ -109,6 +109,13 @@ mknod mnt/dev/hdd b 4 1
 for hd in a b c d; do
     chmod 600 mnt/dev/hd$hd
 done
+mknod mnt/dev/sda b 8 0
+mknod mnt/dev/sdb b 8 1
+mknod mnt/dev/sdc b 8 2
+mknod mnt/dev/sdd b 8 3
+for sd in a b c d; do
+    chmod 600 mnt/dev/sd$sd
+done
 
 ln -s /proc/self/fd/0 mnt/dev/stdin
 ln -s /proc/self/fd/1 mnt/dev/stdout
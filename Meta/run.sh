@@ -22,6 +22,9 @@ die() {
 
 [ -z "$SERENITY_QEMU_CPU" ] && SERENITY_QEMU_CPU="max"
 
+# e.g. "virtio-net-pci"; multiple queue pairs additionally need a multiqueue tap netdev.
+[ -z "$SERENITY_ETHERNET_DEVICE" ] && SERENITY_ETHERNET_DEVICE="e1000"
+
 [ -z "$SERENITY_DISK_IMAGE" ] && {
     if [ "$1" = qgrub ]; then
         SERENITY_DISK_IMAGE="grub_disk_image"
@@ -87,7 +90,7 @@ elif [ "$1" = "qtap" ]; then
         $SERENITY_KVM_ARG \
         $SERENITY_PACKET_LOGGING_ARG \
         -netdev tap,ifname=tap0,id=br0 \
-        -device e1000,netdev=br0 \
+        -device $SERENITY_ETHERNET_DEVICE,netdev=br0 \
         -kernel Kernel/Kernel \
         -append "${SERENITY_KERNEL_CMDLINE}"
 elif [ "$1" = "qgrub" ]; then
@@ -97,7 +100,7 @@ elif [ "$1" = "qgrub" ]; then
         $SERENITY_KVM_ARG \
         $SERENITY_PACKET_LOGGING_ARG \
         -netdev user,id=breh,hostfwd=tcp:127.0.0.1:8888-10.0.2.15:8888,hostfwd=tcp:127.0.0.1:8823-10.0.2.15:23 \
-        -device e1000,netdev=breh
+        -device $SERENITY_ETHERNET_DEVICE,netdev=breh
 elif [ "$1" = "q35_cmd" ]; then
     # Meta/run.sh q35_cmd: qemu (q35 chipset) with SerenityOS with custom commandline
     shift
@@ -107,7 +110,7 @@ elif [ "$1" = "q35_cmd" ]; then
         $SERENITY_COMMON_QEMU_Q35_ARGS \
         $SERENITY_KVM_ARG \
         -netdev user,id=breh,hostfwd=tcp:127.0.0.1:8888-10.0.2.15:8888,hostfwd=tcp:127.0.0.1:8823-10.0.2.15:23 \
-        -device e1000,netdev=breh \
+        -device $SERENITY_ETHERNET_DEVICE,netdev=breh \
         -kernel Kernel/Kernel \
         -append "${SERENITY_KERNEL_CMDLINE}"
 elif [ "$1" = "qcmd" ]; then
@@ -119,7 +122,7 @@ elif [ "$1" = "qcmd" ]; then
         $SERENITY_COMMON_QEMU_ARGS \
         $SERENITY_KVM_ARG \
         -netdev user,id=breh,hostfwd=tcp:127.0.0.1:8888-10.0.2.15:8888,hostfwd=tcp:127.0.0.1:8823-10.0.2.15:23 \
-        -device e1000,netdev=breh \
+        -device $SERENITY_ETHERNET_DEVICE,netdev=breh \
         -kernel Kernel/Kernel \
         -append "${SERENITY_KERNEL_CMDLINE}"
 else
@@ -129,7 +132,7 @@ else
         $SERENITY_KVM_ARG \
         $SERENITY_PACKET_LOGGING_ARG \
         -netdev user,id=breh,hostfwd=tcp:127.0.0.1:8888-10.0.2.15:8888,hostfwd=tcp:127.0.0.1:8823-10.0.2.15:23,hostfwd=tcp:127.0.0.1:8000-10.0.2.15:8000,hostfwd=tcp:127.0.0.1:2222-10.0.2.15:22 \
-        -device e1000,netdev=breh \
+        -device $SERENITY_ETHERNET_DEVICE,netdev=breh \
         -kernel Kernel/Kernel \
         -append "${SERENITY_KERNEL_CMDLINE}"
 fi
@@ -97,6 +97,16 @@ OwnPtr<Messages::AudioServer::SetMainMixVolumeResponse> ClientConnection::handle
     return make<Messages::AudioServer::SetMainMixVolumeResponse>();
 }
 
+OwnPtr<Messages::AudioServer::GetPeriodSizeResponse> ClientConnection::handle(const Messages::AudioServer::GetPeriodSize&)
+{
+    return make<Messages::AudioServer::GetPeriodSizeResponse>(m_mixer.period_frames());
+}
+
+OwnPtr<Messages::AudioServer::SetPeriodSizeResponse> ClientConnection::handle(const Messages::AudioServer::SetPeriodSize& message)
+{
+    return make<Messages::AudioServer::SetPeriodSizeResponse>(m_mixer.set_period_frames(message.frames()));
+}
+
 OwnPtr<Messages::AudioServer::EnqueueBufferResponse> ClientConnection::handle(const Messages::AudioServer::EnqueueBuffer& message)
 {
     auto shared_buffer = SharedBuffer::create_from_shbuf_id(message.buffer_id());
@@ -156,6 +166,18 @@ OwnPtr<Messages::AudioServer::GetPlayingBufferResponse> ClientConnection::handle
     return make<Messages::AudioServer::GetPlayingBufferResponse>(id);
 }
 
+OwnPtr<Messages::AudioServer::GetPlaybackStatisticsResponse> ClientConnection::handle(const Messages::AudioServer::GetPlaybackStatistics&)
+{
+    // Everything that's still queued up, plus the period the device is working through.
+    int latency = m_mixer.period_frames();
+    u32 underruns = 0;
+    if (m_queue) {
+        latency += m_queue->get_remaining_samples();
+        underruns = m_queue->underrun_count();
+    }
+    return make<Messages::AudioServer::GetPlaybackStatisticsResponse>(latency, underruns);
+}
+
 OwnPtr<Messages::AudioServer::GetMutedResponse> ClientConnection::handle(const Messages::AudioServer::GetMuted&)
 {
     return make<Messages::AudioServer::GetMutedResponse>(m_mixer.is_muted());
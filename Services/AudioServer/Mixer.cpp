@@ -24,11 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/BufferStream.h>
 #include <AK/NumericLimits.h>
 #include <AudioServer/ClientConnection.h>
 #include <AudioServer/Mixer.h>
-#include <pthread.h>
+#include <sched.h>
 
 namespace AudioServer {
 
@@ -46,11 +45,6 @@ Mixer::Mixer()
         return;
     }
 
-    pthread_mutex_init(&m_pending_mutex, nullptr);
-    pthread_cond_init(&m_pending_cond, nullptr);
-
-    m_zero_filled_buffer = (u8*)malloc(4096);
-    bzero(m_zero_filled_buffer, 4096);
     m_sound_thread.start();
 }
 
@@ -61,80 +55,70 @@ Mixer::~Mixer()
 NonnullRefPtr<BufferQueue> Mixer::create_queue(ClientConnection& client)
 {
     auto queue = adopt(*new BufferQueue(client));
-    pthread_mutex_lock(&m_pending_mutex);
-    m_pending_mixing.append(*queue);
-    pthread_cond_signal(&m_pending_cond);
-    pthread_mutex_unlock(&m_pending_mutex);
+    // The mixer takes new queues off this one on every pass, so it's never full for long.
+    while (!m_pending_mixing.try_enqueue(queue))
+        sched_yield();
     return queue;
 }
 
 void Mixer::mix()
 {
-    decltype(m_pending_mixing) active_mix_queues;
+    Vector<NonnullRefPtr<BufferQueue>> active_mix_queues;
 
     for (;;) {
-        if (active_mix_queues.is_empty()) {
-            pthread_mutex_lock(&m_pending_mutex);
-            pthread_cond_wait(&m_pending_cond, &m_pending_mutex);
-            active_mix_queues.append(move(m_pending_mixing));
-            pthread_mutex_unlock(&m_pending_mutex);
+        // Sleep while there's nobody to play for, and pick up new clients as they come.
+        if (active_mix_queues.is_empty())
+            active_mix_queues.append(m_pending_mixing.dequeue());
+        for (;;) {
+            auto queue = m_pending_mixing.try_dequeue();
+            if (!queue.has_value())
+                break;
+            active_mix_queues.append(queue.release_value());
         }
 
         active_mix_queues.remove_all_matching([&](auto& entry) { return !entry->client(); });
 
-        Audio::Sample mixed_buffer[1024];
-        auto mixed_buffer_length = (int)(sizeof(mixed_buffer) / sizeof(Audio::Sample));
+        int period = m_period_frames.load(AK::memory_order_relaxed);
+
+        // Samples are mixed as 16-bit values in 32-bit accumulators, so adding up clients
+        // and applying the volume doesn't need any floating point.
+        i32 mixed_buffer[max_period_frames * 2];
+        __builtin_memset(mixed_buffer, 0, period * 2 * sizeof(i32));
 
-        // Mix the buffers together into the output
         for (auto& queue : active_mix_queues) {
             if (!queue->client()) {
                 queue->clear();
                 continue;
             }
-
-            for (int i = 0; i < mixed_buffer_length; ++i) {
-                auto& mixed_sample = mixed_buffer[i];
-                Audio::Sample sample;
-                if (!queue->get_next_sample(sample))
-                    break;
-                mixed_sample += sample;
-            }
+            queue->mix_into(mixed_buffer, period);
         }
 
-        bool muted = m_muted;
-
-        // output the mixed stuff to the device
-        u8 raw_buffer[4096];
-        auto buffer = ByteBuffer::wrap(muted ? m_zero_filled_buffer : raw_buffer, sizeof(raw_buffer));
-
-        BufferStream stream(buffer);
-        if (!muted) {
-            for (int i = 0; i < mixed_buffer_length; ++i) {
-                auto& mixed_sample = mixed_buffer[i];
-
-                mixed_sample.scale(m_main_volume);
-                mixed_sample.clip();
-
-                i16 out_sample;
-                out_sample = mixed_sample.left * NumericLimits<i16>::max();
-                stream << out_sample;
-
-                ASSERT(!stream.at_end()); // we should have enough space for both channels in one buffer!
-                out_sample = mixed_sample.right * NumericLimits<i16>::max();
-                stream << out_sample;
+        i16 output_buffer[max_period_frames * 2];
+        if (m_muted.load(AK::memory_order_relaxed)) {
+            __builtin_memset(output_buffer, 0, period * 2 * sizeof(i16));
+        } else {
+            // The main volume as a 16.16 fixed-point gain.
+            i64 gain = ((i64)m_main_volume.load(AK::memory_order_relaxed) << 16) / 100;
+            for (int i = 0; i < period * 2; ++i) {
+                i64 scaled = (mixed_buffer[i] * gain) >> 16;
+                output_buffer[i] = max<i64>(-NumericLimits<i16>::max(), min<i64>(scaled, NumericLimits<i16>::max()));
             }
         }
 
-        if (stream.offset() != 0) {
-            buffer.trim(stream.offset());
-        }
-        m_device->write(buffer);
+        m_device->write((const u8*)output_buffer, period * 2 * sizeof(i16));
     }
 }
 
+int Mixer::set_period_frames(int frames)
+{
+    frames = max(min_period_frames, min(frames, max_period_frames));
+    m_period_frames.store(frames, AK::memory_order_relaxed);
+    return frames;
+}
+
 void Mixer::set_main_volume(int volume)
 {
-    m_main_volume = volume;
+    m_main_volume.store(volume, AK::memory_order_relaxed);
     ClientConnection::for_each([volume](ClientConnection& client) {
         client.did_change_main_mix_volume({}, volume);
     });
@@ -142,9 +126,8 @@ void Mixer::set_main_volume(int volume)
 
 void Mixer::set_muted(bool muted)
 {
-    if (m_muted == muted)
+    if (m_muted.exchange(muted, AK::memory_order_relaxed) == muted)
         return;
-    m_muted = muted;
     ClientConnection::for_each([muted](ClientConnection& client) {
         client.did_change_muted_state({}, muted);
     });
@@ -157,7 +140,74 @@ BufferQueue::BufferQueue(ClientConnection& client)
 
 void BufferQueue::enqueue(NonnullRefPtr<Audio::Buffer>&& buffer)
 {
-    m_remaining_samples += buffer->sample_count();
-    m_queue.enqueue(move(buffer));
+    m_remaining_samples.fetch_add(buffer->sample_count(), AK::memory_order_relaxed);
+    // ClientConnection checks is_full() first, and only we ever add to the queue.
+    bool enqueued = m_queue.try_enqueue(move(buffer));
+    ASSERT(enqueued);
+    ++m_enqueued_count;
+}
+
+int BufferQueue::mix_into(i32* mixed_samples, int frame_count)
+{
+    if (m_paused.load(AK::memory_order_relaxed))
+        return 0;
+
+    // Drop whatever was enqueued before the last clear().
+    u32 drop_until = m_drop_buffers_until.load(AK::memory_order_acquire);
+    if (m_current && (i32)(m_current_sequence - drop_until) < 0) {
+        m_current = nullptr;
+        m_position = 0;
+        m_starved = false;
+    }
+
+    int mixed_frames = 0;
+    while (mixed_frames < frame_count) {
+        while (!m_current) {
+            auto buffer = m_queue.try_dequeue();
+            if (!buffer.has_value())
+                break;
+            m_current_sequence = m_dequeued_count++;
+            if ((i32)(m_current_sequence - drop_until) < 0) {
+                m_starved = false;
+                continue;
+            }
+            m_current = buffer.release_value();
+            m_playing_buffer_id.store(m_current->shbuf_id(), AK::memory_order_relaxed);
+        }
+
+        if (!m_current)
+            break;
+
+        int frames = min(frame_count - mixed_frames, m_current->sample_count() - m_position);
+        auto* samples = m_current->samples() + m_position;
+        auto* out = mixed_samples + mixed_frames * 2;
+        for (int i = 0; i < frames; ++i) {
+            out[i * 2] += (i32)(samples[i].left * NumericLimits<i16>::max());
+            out[i * 2 + 1] += (i32)(samples[i].right * NumericLimits<i16>::max());
+        }
+        m_position += frames;
+        mixed_frames += frames;
+
+        if (m_position >= m_current->sample_count()) {
+            m_client->did_finish_playing_buffer({}, m_current->shbuf_id());
+            m_current = nullptr;
+            m_position = 0;
+            m_playing_buffer_id.store(-1, AK::memory_order_relaxed);
+        }
+    }
+
+    if (!mixed_frames)
+        return 0;
+
+    if (m_starved) {
+        m_underrun_count.fetch_add(1, AK::memory_order_relaxed);
+        m_starved = false;
+    }
+    if (mixed_frames < frame_count)
+        m_starved = true;
+
+    m_remaining_samples.fetch_sub(mixed_frames, AK::memory_order_relaxed);
+    m_played_samples.fetch_add(mixed_frames, AK::memory_order_relaxed);
+    return mixed_frames;
 }
 }
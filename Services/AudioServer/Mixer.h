@@ -30,82 +30,79 @@
 #include <AK/Badge.h>
 #include <AK/ByteBuffer.h>
 #include <AK/NonnullRefPtrVector.h>
-#include <AK/Queue.h>
+#include <AK/Atomic.h>
 #include <AK/RefCounted.h>
+#include <AK/SPSCQueue.h>
 #include <AK/WeakPtr.h>
 #include <LibAudio/Buffer.h>
 #include <LibCore/File.h>
-#include <LibThread/Lock.h>
 #include <LibThread/Thread.h>
 
 namespace AudioServer {
 
 class ClientConnection;
 
+// Buffers are enqueued by the client connection on the main thread and played back on the
+// mixer thread. The two sides only meet through the lock-free m_queue and a few atomics,
+// so the mixer never has to wait for the main thread.
 class BufferQueue : public RefCounted<BufferQueue> {
 public:
     explicit BufferQueue(ClientConnection&);
     ~BufferQueue() {}
 
+    // Main thread.
     bool is_full() const { return m_queue.size() >= 3; }
     void enqueue(NonnullRefPtr<Audio::Buffer>&&);
 
-    bool get_next_sample(Audio::Sample& sample)
-    {
-        if (m_paused)
-            return false;
-
-        while (!m_current && !m_queue.is_empty())
-            m_current = m_queue.dequeue();
-
-        if (!m_current)
-            return false;
-
-        sample = m_current->samples()[m_position++];
-        --m_remaining_samples;
-        ++m_played_samples;
-
-        if (m_position >= m_current->sample_count()) {
-            m_client->did_finish_playing_buffer({}, m_current->shbuf_id());
-            m_current = nullptr;
-            m_position = 0;
-        }
-        return true;
-    }
+    // Mixer thread. Adds up to frame_count frames from the queue onto the interleaved
+    // fixed-point samples, and returns how many frames there were to add.
+    int mix_into(i32* mixed_samples, int frame_count);
 
     ClientConnection* client() { return m_client.ptr(); }
 
+    // Main thread. The buffers themselves are dropped by the mixer thread the next time it looks.
     void clear(bool paused = false)
     {
-        m_queue.clear();
-        m_position = 0;
-        m_remaining_samples = 0;
-        m_played_samples = 0;
-        m_current = nullptr;
-        m_paused = paused;
+        m_drop_buffers_until.store(m_enqueued_count, AK::memory_order_release);
+        m_remaining_samples.store(0, AK::memory_order_relaxed);
+        m_played_samples.store(0, AK::memory_order_relaxed);
+        m_playing_buffer_id.store(-1, AK::memory_order_relaxed);
+        m_underrun_count.store(0, AK::memory_order_relaxed);
+        m_paused.store(paused, AK::memory_order_relaxed);
     }
 
     void set_paused(bool paused)
     {
-        m_paused = paused;
+        m_paused.store(paused, AK::memory_order_relaxed);
     }
 
-    int get_remaining_samples() const { return m_remaining_samples; }
-    int get_played_samples() const { return m_played_samples; }
-    int get_playing_buffer() const
-    {
-        if (m_current)
-            return m_current->shbuf_id();
-        return -1;
-    }
+    int get_remaining_samples() const { return m_remaining_samples.load(AK::memory_order_relaxed); }
+    int get_played_samples() const { return m_played_samples.load(AK::memory_order_relaxed); }
+    int get_playing_buffer() const { return m_playing_buffer_id.load(AK::memory_order_relaxed); }
+    u32 underrun_count() const { return m_underrun_count.load(AK::memory_order_relaxed); }
 
 private:
+    SPSCQueue<NonnullRefPtr<Audio::Buffer>, 4> m_queue;
+
+    // Owned by the main thread.
+    u32 m_enqueued_count { 0 };
+
+    // Owned by the mixer thread.
     RefPtr<Audio::Buffer> m_current;
-    Queue<NonnullRefPtr<Audio::Buffer>> m_queue;
-    int m_position{ 0 };
-    int m_remaining_samples{ 0 };
-    int m_played_samples{ 0 };
-    bool m_paused{ false };
+    u32 m_current_sequence { 0 };
+    u32 m_dequeued_count { 0 };
+    int m_position { 0 };
+    // Set when the queue ran dry in the middle of a period. If more audio shows up after
+    // that, the client didn't keep up and there was a gap in playback.
+    bool m_starved { false };
+
+    // Shared between the two.
+    Atomic<u32> m_drop_buffers_until { 0 };
+    Atomic<int> m_remaining_samples { 0 };
+    Atomic<int> m_played_samples { 0 };
+    Atomic<int> m_playing_buffer_id { -1 };
+    Atomic<u32> m_underrun_count { 0 };
+    Atomic<bool> m_paused { false };
     WeakPtr<ClientConnection> m_client;
 };
 
@@ -117,25 +114,34 @@ public:
 
     NonnullRefPtr<BufferQueue> create_queue(ClientConnection&);
 
-    int main_volume() const { return m_main_volume; }
+    int main_volume() const { return m_main_volume.load(AK::memory_order_relaxed); }
     void set_main_volume(int volume);
 
-    bool is_muted() const { return m_muted; }
+    bool is_muted() const { return m_muted.load(AK::memory_order_relaxed); }
     void set_muted(bool);
 
+    // The number of frames mixed ahead of the device at a time. Smaller periods mean lower
+    // latency, but give clients less slack before they underrun.
+    static constexpr int min_period_frames = 128;
+    // The device only buffers this much (one page of 16-bit stereo), so larger periods would just block.
+    static constexpr int max_period_frames = 1024;
+
+    int period_frames() const { return m_period_frames.load(AK::memory_order_relaxed); }
+    // Returns the period that was actually chosen, after clamping.
+    int set_period_frames(int);
+
 private:
-    Vector<NonnullRefPtr<BufferQueue>> m_pending_mixing;
-    pthread_mutex_t m_pending_mutex;
-    pthread_cond_t m_pending_cond;
+    // New queues, handed from the main thread to the mixer thread.
+    SPSCQueue<NonnullRefPtr<BufferQueue>, 16> m_pending_mixing;
 
     RefPtr<Core::File> m_device;
 
     LibThread::Thread m_sound_thread;
 
-    bool m_muted{ false };
-    int m_main_volume{ 100 };
-
-    u8* m_zero_filled_buffer{ nullptr };
+    // Read by the mixer thread on every period.
+    Atomic<bool> m_muted { false };
+    Atomic<int> m_main_volume { 100 };
+    Atomic<int> m_period_frames { max_period_frames };
 
     void mix();
 };
@@ -44,11 +44,11 @@ Storage::~Storage()
 {
 }
 
-void Storage::set_data(NonnullRefPtr<SharedBuffer> data, size_t data_size, const String& mime_type)
+void Storage::set_data(IPC::LargeBuffer data, const String& mime_type)
 {
-    dbg() << "Storage::set_data <- [" << mime_type << "] " << data->data() << " (" << data_size << " bytes)";
-    m_shared_buffer = move(data);
-    m_data_size = data_size;
+    dbg() << "Storage::set_data <- [" << mime_type << "] " << data.data() << " (" << data.size() << " bytes)";
+    m_data = move(data);
+    m_has_data = true;
     m_mime_type = mime_type;
 
     if (on_content_change)
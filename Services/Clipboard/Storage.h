@@ -27,8 +27,8 @@
 #pragma once
 
 #include <AK/Function.h>
-#include <AK/SharedBuffer.h>
 #include <AK/String.h>
+#include <LibIPC/LargeBuffer.h>
 
 namespace Clipboard {
 
@@ -37,25 +37,14 @@ public:
     static Storage& the();
     ~Storage();
 
-    bool has_data() const { return m_shared_buffer; }
+    bool has_data() const { return m_has_data; }
 
     const String& mime_type() const { return m_mime_type; }
 
-    const u8* data() const
-    {
-        if (!has_data())
-            return nullptr;
-        return static_cast<const u8*>(m_shared_buffer->data());
-    }
+    const IPC::LargeBuffer& data() const { return m_data; }
+    size_t data_size() const { return m_data.size(); }
 
-    size_t data_size() const
-    {
-        if (has_data())
-            return m_data_size;
-        return 0;
-    }
-
-    void set_data(NonnullRefPtr<SharedBuffer>, size_t data_size, const String& mime_type);
+    void set_data(IPC::LargeBuffer, const String& mime_type);
 
     Function<void()> on_content_change;
 
@@ -63,8 +52,8 @@ private:
     Storage();
 
     String m_mime_type;
-    RefPtr<SharedBuffer> m_shared_buffer;
-    size_t m_data_size { 0 };
+    IPC::LargeBuffer m_data;
+    bool m_has_data { false };
 };
 
 }
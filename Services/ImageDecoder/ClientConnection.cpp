@@ -25,17 +25,105 @@
  */
 
 #include <AK/Badge.h>
+#include <AK/ByteBuffer.h>
 #include <AK/SharedBuffer.h>
 #include <ImageDecoder/ClientConnection.h>
 #include <ImageDecoder/ImageDecoderClientEndpoint.h>
 #include <LibGfx/Bitmap.h>
 #include <LibGfx/ImageDecoder.h>
 #include <LibGfx/SystemTheme.h>
+#include <LibThread/BackgroundAction.h>
 
 namespace ImageDecoder {
 
 static HashMap<int, RefPtr<ClientConnection>> s_connections;
 
+// Remembers the bitmaps we've recently decoded, by the contents of their encoded data, so that
+// decoding the same image again (e.g. after the client has thrown its copy away) is free.
+// Failed decodes are remembered too, as a null bitmap.
+class DecodedImageCache {
+public:
+    static constexpr size_t budget = 16 * MiB;
+
+    static DecodedImageCache& the()
+    {
+        static DecodedImageCache* s_the;
+        if (!s_the)
+            s_the = new DecodedImageCache;
+        return *s_the;
+    }
+
+    bool get(const u8* data, size_t size, RefPtr<Gfx::Bitmap>& bitmap)
+    {
+        auto hash = string_hash((const char*)data, size);
+        for (auto& entry : m_entries) {
+            if (entry.hash != hash || entry.encoded_data.size() != size || memcmp(entry.encoded_data.data(), data, size))
+                continue;
+            entry.last_used = ++m_use_counter;
+            bitmap = entry.bitmap;
+            return true;
+        }
+        return false;
+    }
+
+    void set(const u8* data, size_t size, RefPtr<Gfx::Bitmap> bitmap)
+    {
+        Entry entry { string_hash((const char*)data, size), ByteBuffer::copy(data, size), move(bitmap), ++m_use_counter };
+        size_t entry_size = size_of(entry);
+        if (entry_size > budget)
+            return;
+        while (m_size_in_bytes + entry_size > budget) {
+            size_t least_recently_used = 0;
+            for (size_t i = 1; i < m_entries.size(); ++i) {
+                if (m_entries[i].last_used < m_entries[least_recently_used].last_used)
+                    least_recently_used = i;
+            }
+            m_size_in_bytes -= size_of(m_entries[least_recently_used]);
+            m_entries.remove(least_recently_used);
+        }
+        m_size_in_bytes += entry_size;
+        m_entries.append(move(entry));
+    }
+
+private:
+    struct Entry {
+        u32 hash { 0 };
+        ByteBuffer encoded_data;
+        RefPtr<Gfx::Bitmap> bitmap;
+        u64 last_used { 0 };
+    };
+
+    static size_t size_of(const Entry& entry)
+    {
+        return entry.encoded_data.size() + (entry.bitmap ? entry.bitmap->size_in_bytes() : 0);
+    }
+
+    Vector<Entry> m_entries;
+    size_t m_size_in_bytes { 0 };
+    u64 m_use_counter { 0 };
+};
+
+// Runs on a worker thread.
+static RefPtr<Gfx::Bitmap> decode(const u8* data, size_t size)
+{
+    auto decoder = Gfx::ImageDecoder::create(data, size);
+    auto bitmap = decoder->bitmap();
+    if (!bitmap) {
+#ifdef IMAGE_DECODER_DEBUG
+        dbg() << "Could not decode image from encoded data";
+#endif
+        return nullptr;
+    }
+
+    // FIXME: We should fix ShareableBitmap so you can send it in responses as well as requests..
+    auto shareable_bitmap = bitmap->to_bitmap_backed_by_shared_buffer();
+    if (!shareable_bitmap)
+        return nullptr;
+    // The same bitmap may be handed out several times, so make sure nobody can scribble on it.
+    shareable_bitmap->shared_buffer()->seal();
+    return shareable_bitmap;
+}
+
 ClientConnection::ClientConnection(NonnullRefPtr<Core::LocalSocket> socket, int client_id)
     : IPC::ClientConnection<ImageDecoderServerEndpoint>(*this, move(socket), client_id)
 {
@@ -60,11 +148,17 @@ OwnPtr<Messages::ImageDecoderServer::GreetResponse> ClientConnection::handle(con
 
 OwnPtr<Messages::ImageDecoderServer::DecodeImageResponse> ClientConnection::handle(const Messages::ImageDecoderServer::DecodeImage& message)
 {
+    auto pending_response = make<PendingResponse>();
+    auto& response = *pending_response;
+    m_pending_responses.enqueue(move(pending_response));
+
     auto encoded_buffer = SharedBuffer::create_from_shbuf_id(message.encoded_shbuf_id());
     if (!encoded_buffer) {
 #ifdef IMAGE_DECODER_DEBUG
         dbg() << "Could not map encoded data buffer";
 #endif
+        response.is_ready = true;
+        post_ready_responses();
         return nullptr;
     }
 
@@ -72,31 +166,65 @@ OwnPtr<Messages::ImageDecoderServer::DecodeImageResponse> ClientConnection::hand
 #ifdef IMAGE_DECODER_DEBUG
         dbg() << "Encoded buffer is smaller than encoded size";
 #endif
+        response.is_ready = true;
+        post_ready_responses();
         return nullptr;
     }
 
+    auto* data = (const u8*)encoded_buffer->data();
+    size_t size = message.encoded_size();
+    if (DecodedImageCache::the().get(data, size, response.bitmap)) {
 #ifdef IMAGE_DECODER_DEBUG
-    dbg() << "Trying to decode " << message.encoded_size() << " bytes of image(?) data in shbuf_id=" << message.encoded_shbuf_id() << " (shbuf size: " << encoded_buffer->size() << ")";
+        dbg() << "Found " << size << " bytes of encoded data in shbuf_id=" << message.encoded_shbuf_id() << " in the cache";
 #endif
+        response.is_ready = true;
+        post_ready_responses();
+        return nullptr;
+    }
 
-    auto decoder = Gfx::ImageDecoder::create((const u8*)encoded_buffer->data(), message.encoded_size());
-    auto bitmap = decoder->bitmap();
-
-    if (!bitmap) {
 #ifdef IMAGE_DECODER_DEBUG
-        dbg() << "Could not decode image from encoded data";
+    dbg() << "Trying to decode " << size << " bytes of image(?) data in shbuf_id=" << message.encoded_shbuf_id() << " (shbuf size: " << encoded_buffer->size() << ")";
 #endif
-        return make<Messages::ImageDecoderServer::DecodeImageResponse>(-1, Gfx::IntSize(), (i32)Gfx::BitmapFormat::Invalid, Vector<u32>());
-    }
 
-    // FIXME: We should fix ShareableBitmap so you can send it in responses as well as requests..
-    m_shareable_bitmap = bitmap->to_bitmap_backed_by_shared_buffer();
-    m_shareable_bitmap->shared_buffer()->share_with(client_pid());
-    Vector<u32> palette;
-    if (m_shareable_bitmap->is_indexed()) {
-        palette = m_shareable_bitmap->palette_to_vector();
+    // The response stays in m_pending_responses (and thus alive) until it's ready.
+    auto weak_this = make_weak_ptr();
+    LibThread::BackgroundAction<RefPtr<Gfx::Bitmap>>::create(
+        [encoded_buffer, data, size] {
+            return decode(data, size);
+        },
+        [this, weak_this, encoded_buffer, data, size, &response](RefPtr<Gfx::Bitmap> bitmap) {
+            if (weak_this.is_null())
+                return;
+            DecodedImageCache::the().set(data, size, bitmap);
+            response.bitmap = move(bitmap);
+            response.is_ready = true;
+            post_ready_responses();
+        });
+
+    // We respond from post_ready_responses() instead.
+    return nullptr;
+}
+
+void ClientConnection::post_ready_responses()
+{
+    while (!m_pending_responses.is_empty() && m_pending_responses.head()->is_ready) {
+        auto response = m_pending_responses.dequeue();
+        if (!response->bitmap) {
+            post_message(Messages::ImageDecoderServer::DecodeImageResponse(-1, Gfx::IntSize(), (i32)Gfx::BitmapFormat::Invalid, Vector<u32>()));
+            continue;
+        }
+
+        auto& bitmap = *response->bitmap;
+        bitmap.shared_buffer()->share_with(client_pid());
+        Vector<u32> palette;
+        if (bitmap.is_indexed())
+            palette = bitmap.palette_to_vector();
+        post_message(Messages::ImageDecoderServer::DecodeImageResponse(bitmap.shbuf_id(), bitmap.size(), (i32)bitmap.format(), palette));
+
+        m_recently_sent_bitmaps.enqueue(bitmap);
+        if (m_recently_sent_bitmaps.size() > max_requests_in_flight)
+            m_recently_sent_bitmaps.dequeue();
     }
-    return make<Messages::ImageDecoderServer::DecodeImageResponse>(m_shareable_bitmap->shbuf_id(), m_shareable_bitmap->size(), (i32)m_shareable_bitmap->format(), palette);
 }
 
 }
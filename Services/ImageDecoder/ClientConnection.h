@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/HashMap.h>
+#include <AK/Queue.h>
 #include <ImageDecoder/Forward.h>
 #include <ImageDecoder/ImageDecoderServerEndpoint.h>
 #include <LibIPC/ClientConnection.h>
@@ -40,6 +41,11 @@ class ClientConnection final
     C_OBJECT(ClientConnection);
 
 public:
+    // Clients may have up to this many decode requests outstanding. We keep the bitmaps of that many
+    // of our most recent responses alive, so that they're still around when the client maps them.
+    // Must match ImageDecoderClient::Client.
+    static constexpr size_t max_requests_in_flight = 4;
+
     explicit ClientConnection(NonnullRefPtr<Core::LocalSocket>, int client_id);
     ~ClientConnection() override;
 
@@ -49,7 +55,17 @@ private:
     virtual OwnPtr<Messages::ImageDecoderServer::GreetResponse> handle(const Messages::ImageDecoderServer::Greet&) override;
     virtual OwnPtr<Messages::ImageDecoderServer::DecodeImageResponse> handle(const Messages::ImageDecoderServer::DecodeImage&) override;
 
-    RefPtr<Gfx::Bitmap> m_shareable_bitmap;
+    struct PendingResponse {
+        bool is_ready { false };
+        RefPtr<Gfx::Bitmap> bitmap;
+    };
+
+    void post_ready_responses();
+
+    // Decoding happens on worker threads and may finish out of order, but the client matches up
+    // responses with its requests by their order, so they're held back until those before are done.
+    Queue<NonnullOwnPtr<PendingResponse>> m_pending_responses;
+    Queue<NonnullRefPtr<Gfx::Bitmap>> m_recently_sent_bitmaps;
 };
 
 }
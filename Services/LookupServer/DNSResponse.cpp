@@ -72,7 +72,8 @@ Optional<DNSResponse> DNSResponse::from_raw_response(const u8* raw_data, size_t
     response.m_id = response_header.id();
     response.m_code = response_header.response_code();
 
-    if (response.code() != DNSResponse::Code::NOERROR)
+    // NXDOMAIN responses are parsed too, since their SOA record says how long they may be cached for.
+    if (response.code() != DNSResponse::Code::NOERROR && response.code() != DNSResponse::Code::NXDOMAIN)
         return response;
 
     size_t offset = sizeof(DNSPacket);
@@ -113,6 +114,28 @@ Optional<DNSResponse> DNSResponse::from_raw_response(const u8* raw_data, size_t
         offset += record.data_length();
     }
 
+    for (u16 i = 0; i < response_header.authority_count(); ++i) {
+        parse_dns_name(raw_data, offset, raw_size);
+        if (offset + sizeof(DNSRecordWithoutName) > raw_size)
+            break;
+        auto& record = *(const DNSRecordWithoutName*)(&raw_data[offset]);
+        offset += sizeof(DNSRecordWithoutName);
+        if (offset + record.data_length() > raw_size)
+            break;
+        if (record.type() == T_SOA) {
+            // The SOA data is two names followed by the serial, refresh, retry, expire and minimum fields.
+            size_t soa_offset = offset;
+            parse_dns_name(raw_data, soa_offset, raw_size);
+            parse_dns_name(raw_data, soa_offset, raw_size);
+            if (soa_offset + 5 * sizeof(u32) <= offset + record.data_length()) {
+                auto& minimum = *(const NetworkOrdered<u32>*)(&raw_data[soa_offset + 4 * sizeof(u32)]);
+                response.m_negative_ttl = min(record.ttl(), (u32)minimum);
+                dbg() << "Authority #" << i << ": SOA, ttl=" << record.ttl() << ", minimum=" << (u32)minimum;
+            }
+        }
+        offset += record.data_length();
+    }
+
     return response;
 }
 
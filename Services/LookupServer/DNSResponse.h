@@ -67,6 +67,9 @@ public:
 
     Code code() const { return (Code)m_code; }
 
+    // How long a negative answer may be cached (RFC 2308.) Only known if the authority section had an SOA record.
+    const Optional<u32>& negative_ttl() const { return m_negative_ttl; }
+
 private:
     DNSResponse() { }
 
@@ -74,4 +77,5 @@ private:
     u8 m_code { 0 };
     Vector<DNSQuestion> m_questions;
     Vector<DNSAnswer> m_answers;
+    Optional<u32> m_negative_ttl;
 };
@@ -43,7 +43,10 @@ LookupServer::LookupServer()
 {
     auto config = Core::ConfigFile::get_for_system("LookupServer");
     dbg() << "Using network config file at " << config->file_name();
-    m_nameserver = config->read_entry("DNS", "Nameserver", "1.1.1.1");
+    // Queries go to the nameservers in turn as they time out.
+    m_nameservers = config->read_entry("DNS", "Nameserver", "1.1.1.1").split(',');
+    for (auto& nameserver : m_nameservers)
+        nameserver = nameserver.trim_whitespace();
 
     load_etc_hosts();
 
@@ -96,6 +99,14 @@ void LookupServer::load_etc_hosts()
     }
 }
 
+static constexpr int query_timeout_ms = 1000;
+static constexpr size_t max_cached_lookups = 1024;
+// RFC 2308 suggests capping negative answers at a few hours, and server failures at five minutes.
+static constexpr u32 max_negative_ttl = 3 * 60 * 60;
+static constexpr u32 server_failure_ttl = 30;
+// Names asked for this often get looked up again in the background shortly before they expire.
+static constexpr u32 prefetch_min_hits = 8;
+
 void LookupServer::service_client(RefPtr<Core::LocalSocket> socket)
 {
     u8 client_buffer[1024];
@@ -113,39 +124,56 @@ void LookupServer::service_client(RefPtr<Core::LocalSocket> socket)
         return;
     }
     auto hostname = String((const char*)client_buffer + 1, nrecv - 1, Chomp);
-    dbg() << "Got request for '" << hostname << "' (using IP " << m_nameserver << ")";
-
-    Vector<String> responses;
+    dbg() << "Got request for '" << hostname << "'";
 
     if (auto known_host = m_etc_hosts.get(hostname); known_host.has_value()) {
-        responses.append(known_host.value());
-    } else if (!hostname.is_empty()) {
-        bool did_timeout;
-        int retries = 3;
-        do {
-            did_timeout = false;
-            if (lookup_type == 'L')
-                responses = lookup(hostname, did_timeout, T_A);
-            else if (lookup_type == 'R')
-                responses = lookup(hostname, did_timeout, T_PTR);
-            if (!did_timeout)
-                break;
-        } while (--retries);
-        if (did_timeout) {
-            fprintf(stderr, "LookupServer: Out of retries :(\n");
-            return;
-        }
+        respond(*socket, { known_host.value() });
+        return;
+    }
+    if (hostname.is_empty()) {
+        respond(*socket, {});
+        return;
+    }
+
+    unsigned short record_type = lookup_type == 'L' ? T_A : T_PTR;
+    auto key = String::format("%c%s", lookup_type, hostname.characters());
+    if (auto cached = lookup_in_cache(key, hostname, record_type); cached.has_value()) {
+        respond(*socket, cached.value());
+        return;
     }
 
+    // If somebody already asked for this, just wait for the same answer.
+    if (auto it = m_pending_lookups.find(key); it != m_pending_lookups.end()) {
+        it->value->clients.append(socket);
+        return;
+    }
+
+    start_lookup(key, hostname, record_type).clients.append(socket);
+}
+
+LookupServer::PendingLookup& LookupServer::start_lookup(const String& key, const String& hostname, unsigned short record_type)
+{
+    auto lookup = make<PendingLookup>();
+    lookup->key = key;
+    lookup->hostname = hostname;
+    lookup->record_type = record_type;
+    auto& lookup_ref = *lookup;
+    m_pending_lookups.set(key, move(lookup));
+    send_query(lookup_ref);
+    return lookup_ref;
+}
+
+void LookupServer::respond(Core::LocalSocket& socket, const Vector<String>& responses)
+{
     if (responses.is_empty()) {
-        int nsent = socket->write("Not found.\n");
+        int nsent = socket.write("Not found.\n");
         if (nsent < 0)
             perror("write");
         return;
     }
     for (auto& response : responses) {
         auto line = String::format("%s\n", response.characters());
-        int nsent = socket->write(line);
+        int nsent = socket.write(line);
         if (nsent < 0) {
             perror("write");
             break;
@@ -153,107 +181,228 @@ void LookupServer::service_client(RefPtr<Core::LocalSocket> socket)
     }
 }
 
-Vector<String> LookupServer::lookup(const String& hostname, bool& did_timeout, unsigned short record_type, ShouldRandomizeCase should_randomize_case)
+Optional<Vector<String>> LookupServer::lookup_in_cache(const String& key, const String& hostname, unsigned short record_type)
 {
-    if (auto it = m_lookup_cache.find(hostname); it != m_lookup_cache.end()) {
-        auto& cached_lookup = it->value;
-        if (cached_lookup.question.record_type() == record_type) {
-            Vector<String> responses;
-            for (auto& cached_answer : cached_lookup.answers) {
-                dbg() << "Cache hit: " << hostname << " -> " << cached_answer.record_data() << ", expired: " << cached_answer.has_expired();
-                if (!cached_answer.has_expired()) {
-                    responses.append(cached_answer.record_data());
-                }
-            }
-            if (!responses.is_empty())
-                return responses;
+    auto it = m_lookup_cache.find(key);
+    if (it == m_lookup_cache.end())
+        return {};
+    auto& cached_lookup = it->value;
+    auto now = time(nullptr);
+
+    if (cached_lookup.answers.is_empty()) {
+        if (now >= cached_lookup.negative_expiration_time) {
+            m_lookup_cache.remove(it);
+            return {};
         }
+        dbg() << "Negative cache hit: " << hostname;
+        cached_lookup.last_used = ++m_cache_use_counter;
+        return Vector<String> {};
+    }
+
+    Vector<String> responses;
+    time_t earliest_expiration_time = 0;
+    for (auto& cached_answer : cached_lookup.answers) {
+        dbg() << "Cache hit: " << hostname << " -> " << cached_answer.record_data() << ", expired: " << cached_answer.has_expired();
+        if (cached_answer.has_expired())
+            continue;
+        responses.append(cached_answer.record_data());
+        if (!earliest_expiration_time || cached_answer.expiration_time() < earliest_expiration_time)
+            earliest_expiration_time = cached_answer.expiration_time();
+    }
+    if (responses.is_empty()) {
         m_lookup_cache.remove(it);
+        return {};
     }
 
-    DNSRequest request;
-    request.add_question(hostname, record_type, should_randomize_case);
+    cached_lookup.last_used = ++m_cache_use_counter;
+    ++cached_lookup.hits;
+
+    // Refresh popular names during the last tenth of their lifetime, so that they never drop out of the cache.
+    auto lifetime = earliest_expiration_time - cached_lookup.stored_time;
+    if (cached_lookup.hits >= prefetch_min_hits && (earliest_expiration_time - now) * 10 <= lifetime && !m_pending_lookups.contains(key)) {
+        dbg() << "Prefetching " << hostname;
+        cached_lookup.hits = 0;
+        start_lookup(key, hostname, record_type);
+    }
+    return responses;
+}
+
+void LookupServer::store_in_cache(const String& key, Vector<DNSAnswer>&& answers, u32 negative_ttl)
+{
+    // A failed prefetch shouldn't throw away answers that are still good.
+    if (answers.is_empty()) {
+        if (auto it = m_lookup_cache.find(key); it != m_lookup_cache.end()) {
+            for (auto& cached_answer : it->value.answers) {
+                if (!cached_answer.has_expired())
+                    return;
+            }
+        }
+    }
+
+    CachedLookup cached_lookup;
+    cached_lookup.answers = move(answers);
+    cached_lookup.stored_time = time(nullptr);
+    cached_lookup.negative_expiration_time = cached_lookup.stored_time + min(negative_ttl, max_negative_ttl);
+    cached_lookup.last_used = ++m_cache_use_counter;
+    m_lookup_cache.set(key, move(cached_lookup));
+
+    while (m_lookup_cache.size() > max_cached_lookups) {
+        const String* least_recently_used = nullptr;
+        u64 least_recently_used_time = 0;
+        for (auto& it : m_lookup_cache) {
+            if (!least_recently_used || it.value.last_used < least_recently_used_time) {
+                least_recently_used = &it.key;
+                least_recently_used_time = it.value.last_used;
+            }
+        }
+        m_lookup_cache.remove(String(*least_recently_used));
+    }
+}
 
-    auto buffer = request.to_byte_buffer();
+void LookupServer::send_query(PendingLookup& lookup)
+{
+    DNSRequest request;
+    request.add_question(lookup.hostname, lookup.record_type, lookup.should_randomize_case);
+    lookup.request_id = request.id();
+    lookup.questions = request.questions();
 
-    auto udp_socket = Core::UDPSocket::construct();
-    udp_socket->set_blocking(true);
+    auto& nameserver = m_nameservers[lookup.attempt % m_nameservers.size()];
+    dbg() << "Asking " << nameserver << " about '" << lookup.hostname << "' (attempt " << lookup.attempt + 1 << ")";
 
-    struct timeval timeout {
-        1, 0
+    // A fresh socket per attempt, so a late answer to an earlier one can't be mistaken for this one.
+    if (auto old_socket = move(lookup.socket)) {
+        old_socket->on_ready_to_read = nullptr;
+        deferred_invoke([old_socket](auto&) { const_cast<Core::UDPSocket&>(*old_socket).remove_from_parent(); });
+    }
+    lookup.socket = Core::UDPSocket::construct(this);
+    lookup.socket->on_ready_to_read = [this, &lookup] {
+        did_receive_response(lookup);
     };
 
-    int rc = setsockopt(udp_socket->fd(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    if (rc < 0) {
-        perror("setsockopt(SOL_SOCKET, SO_RCVTIMEO)");
-        return {};
+    if (!lookup.timeout_timer) {
+        lookup.timeout_timer = Core::Timer::construct(this);
+        lookup.timeout_timer->set_single_shot(true);
+        lookup.timeout_timer->on_timeout = [this, &lookup] {
+            did_time_out(lookup);
+        };
     }
+    lookup.timeout_timer->start(query_timeout_ms);
 
-    if (!udp_socket->connect(m_nameserver, 53))
-        return {};
+    if (!lookup.socket->connect(nameserver, 53) || !lookup.socket->write(request.to_byte_buffer())) {
+        // Give the next nameserver a go right away.
+        lookup.timeout_timer->start(0);
+    }
+}
 
-    if (!udp_socket->write(buffer))
-        return {};
+void LookupServer::did_time_out(PendingLookup& lookup)
+{
+    int max_attempts = max(3, (int)m_nameservers.size());
+    if (++lookup.attempt < max_attempts) {
+        send_query(lookup);
+        return;
+    }
+    fprintf(stderr, "LookupServer: Out of retries :(\n");
+    store_in_cache(lookup.key, {}, server_failure_ttl);
+    // Hanging up without an answer is how clients learn that lookups failed.
+    lookup.clients.clear();
+    finish_lookup(lookup, {});
+}
 
+void LookupServer::did_receive_response(PendingLookup& lookup)
+{
     u8 response_buffer[4096];
-    int nrecv = udp_socket->read(response_buffer, sizeof(response_buffer));
-    if (nrecv == 0)
-        return {};
+    int nrecv = lookup.socket->read(response_buffer, sizeof(response_buffer));
+    if (nrecv <= 0)
+        return;
 
     auto o_response = DNSResponse::from_raw_response(response_buffer, nrecv);
     if (!o_response.has_value())
-        return {};
+        return;
 
     auto& response = o_response.value();
 
-    if (response.id() != request.id()) {
-        dbgprintf("LookupServer: ID mismatch (%u vs %u) :(\n", response.id(), request.id());
-        return {};
+    if (response.id() != lookup.request_id) {
+        // Not ours; keep waiting for the real thing.
+        dbgprintf("LookupServer: ID mismatch (%u vs %u) :(\n", response.id(), lookup.request_id);
+        return;
     }
 
     if (response.code() == DNSResponse::Code::REFUSED) {
-        if (should_randomize_case == ShouldRandomizeCase::Yes) {
+        if (lookup.should_randomize_case == ShouldRandomizeCase::Yes) {
             // Retry with 0x20 case randomization turned off.
-            return lookup(hostname, did_timeout, record_type, ShouldRandomizeCase::No);
+            lookup.should_randomize_case = ShouldRandomizeCase::No;
+            send_query(lookup);
+            return;
         }
-        return {};
+        finish_lookup(lookup, {});
+        return;
     }
 
-    if (response.question_count() != request.question_count()) {
-        dbgprintf("LookupServer: Question count (%u vs %u) :(\n", response.question_count(), request.question_count());
-        return {};
+    if (response.code() == DNSResponse::Code::SERVFAIL) {
+        store_in_cache(lookup.key, {}, server_failure_ttl);
+        finish_lookup(lookup, {});
+        return;
     }
 
-    for (size_t i = 0; i < request.question_count(); ++i) {
-        auto& request_question = request.questions()[i];
+    if (response.question_count() != lookup.questions.size()) {
+        dbgprintf("LookupServer: Question count (%u vs %zu) :(\n", response.question_count(), lookup.questions.size());
+        finish_lookup(lookup, {});
+        return;
+    }
+
+    for (size_t i = 0; i < lookup.questions.size(); ++i) {
+        auto& request_question = lookup.questions[i];
         auto& response_question = response.questions()[i];
         if (request_question != response_question) {
             dbg() << "Request and response questions do not match";
             dbg() << "   Request: {_" << request_question.name() << "_, " << request_question.record_type() << ", " << request_question.class_code() << "}";
             dbg() << "  Response: {_" << response_question.name() << "_, " << response_question.record_type() << ", " << response_question.class_code() << "}";
-            return {};
+            finish_lookup(lookup, {});
+            return;
         }
     }
 
-    if (response.answer_count() < 1) {
-        dbgprintf("LookupServer: Not enough answers (%u) :(\n", response.answer_count());
-        return {};
-    }
-
-    Vector<String, 8> responses;
-    Vector<DNSAnswer, 8> cacheable_answers;
+    Vector<String> responses;
+    Vector<DNSAnswer> cacheable_answers;
     for (auto& answer : response.answers()) {
-        if (answer.type() != T_A)
+        if (answer.type() != lookup.record_type)
             continue;
         responses.append(answer.record_data());
         if (!answer.has_expired())
             cacheable_answers.append(answer);
     }
 
-    if (!cacheable_answers.is_empty()) {
-        if (m_lookup_cache.size() >= 256)
-            m_lookup_cache.remove(m_lookup_cache.begin());
-        m_lookup_cache.set(hostname, { request.questions()[0], move(cacheable_answers) });
+    if (responses.is_empty()) {
+        // NXDOMAIN or no data. Without an SOA record there's no telling how long that holds, so it isn't cached.
+        dbgprintf("LookupServer: No answers (code %u) :(\n", (unsigned)response.code());
+        if (response.negative_ttl().has_value())
+            store_in_cache(lookup.key, {}, response.negative_ttl().value());
+        finish_lookup(lookup, {});
+        return;
     }
-    return responses;
+
+    if (!cacheable_answers.is_empty())
+        store_in_cache(lookup.key, move(cacheable_answers));
+    finish_lookup(lookup, responses);
+}
+
+void LookupServer::finish_lookup(PendingLookup& lookup, const Vector<String>& responses)
+{
+    for (auto& client : lookup.clients)
+        respond(*client, responses);
+    lookup.clients.clear();
+
+    lookup.timeout_timer->stop();
+    lookup.socket->on_ready_to_read = nullptr;
+
+    // We may be inside one of the lookup's own callbacks, so let it go once they've returned.
+    auto key = lookup.key;
+    deferred_invoke([this, key](auto&) {
+        auto it = m_pending_lookups.find(key);
+        if (it == m_pending_lookups.end())
+            return;
+        it->value->socket->remove_from_parent();
+        it->value->timeout_timer->remove_from_parent();
+        m_pending_lookups.remove(it);
+    });
 }
@@ -29,7 +29,11 @@
 #include "DNSRequest.h"
 #include "DNSResponse.h"
 #include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
 #include <LibCore/Object.h>
+#include <LibCore/Timer.h>
+#include <LibCore/UDPSocket.h>
 
 class DNSAnswer;
 
@@ -40,17 +44,46 @@ public:
     LookupServer();
 
 private:
+    // One query on the wire, and everyone waiting for its answer.
+    // Concurrent requests for the same name and type share one of these.
+    struct PendingLookup {
+        String key;
+        String hostname;
+        unsigned short record_type { T_A };
+        ShouldRandomizeCase should_randomize_case { ShouldRandomizeCase::Yes };
+        int attempt { 0 };
+        u16 request_id { 0 };
+        Vector<DNSQuestion> questions;
+        RefPtr<Core::UDPSocket> socket;
+        RefPtr<Core::Timer> timeout_timer;
+        Vector<RefPtr<Core::LocalSocket>> clients;
+    };
+
     void load_etc_hosts();
     void service_client(RefPtr<Core::LocalSocket>);
-    Vector<String> lookup(const String& hostname, bool& did_timeout, unsigned short record_type, ShouldRandomizeCase = ShouldRandomizeCase::Yes);
+    PendingLookup& start_lookup(const String& key, const String& hostname, unsigned short record_type);
+    Optional<Vector<String>> lookup_in_cache(const String& key, const String& hostname, unsigned short record_type);
+    void store_in_cache(const String& key, Vector<DNSAnswer>&&, u32 negative_ttl = 0);
+
+    void send_query(PendingLookup&);
+    void did_receive_response(PendingLookup&);
+    void did_time_out(PendingLookup&);
+    void finish_lookup(PendingLookup&, const Vector<String>& responses);
+    static void respond(Core::LocalSocket&, const Vector<String>& responses);
 
+    // Each answer expires on its own TTL. Negative answers have none, and expire all at once.
     struct CachedLookup {
-        DNSQuestion question;
         Vector<DNSAnswer> answers;
+        time_t negative_expiration_time { 0 };
+        time_t stored_time { 0 };
+        u64 last_used { 0 };
+        u32 hits { 0 };
     };
 
     RefPtr<Core::LocalServer> m_local_server;
-    String m_nameserver;
+    Vector<String> m_nameservers;
     HashMap<String, String> m_etc_hosts;
     HashMap<String, CachedLookup> m_lookup_cache;
+    u64 m_cache_use_counter { 0 };
+    HashMap<String, OwnPtr<PendingLookup>> m_pending_lookups;
 };
@@ -69,6 +69,7 @@ OwnPtr<Messages::ProtocolServer::StartDownloadResponse> ClientConnection::handle
     auto download = protocol->start_download(*this, url, message.request_headers().entries());
     if (!download)
         return make<Messages::ProtocolServer::StartDownloadResponse>(-1);
+    download->set_should_stream_data(message.stream_data());
     auto id = download->id();
     m_downloads.set(id, move(download));
     return make<Messages::ProtocolServer::StartDownloadResponse>(id);
@@ -87,6 +88,18 @@ OwnPtr<Messages::ProtocolServer::StopDownloadResponse> ClientConnection::handle(
 }
 
 void ClientConnection::did_finish_download(Badge<Download>, Download& download, bool success)
+{
+    // The client should see all of the data before it hears that the download is done.
+    // Failed downloads don't need their data anymore, so those end right away.
+    auto* stream = const_cast<DataStream*>(m_data_streams.get(download.id()).value_or(nullptr));
+    if (success && stream && !stream->pending_data.is_empty()) {
+        stream->is_finished = true;
+        return;
+    }
+    post_download_finished(download, success);
+}
+
+void ClientConnection::post_download_finished(Download& download, bool success)
 {
     RefPtr<SharedBuffer> buffer;
     if (success && download.payload().size() > 0 && !download.payload().is_null()) {
@@ -103,6 +116,7 @@ void ClientConnection::did_finish_download(Badge<Download>, Download& download,
         response_headers.add(it.key, it.value);
     post_message(Messages::ProtocolClient::DownloadFinished(download.id(), success, download.status_code(), download.total_size().value(), buffer ? buffer->shbuf_id() : -1, response_headers));
 
+    m_data_streams.remove(download.id());
     m_downloads.remove(download.id());
 }
 
@@ -111,6 +125,76 @@ void ClientConnection::did_progress_download(Badge<Download>, Download& download
     post_message(Messages::ProtocolClient::DownloadProgress(download.id(), download.total_size(), download.downloaded_size()));
 }
 
+void ClientConnection::did_receive_download_headers(Badge<Download>, Download& download)
+{
+    IPC::Dictionary response_headers;
+    for (auto& it : download.response_headers())
+        response_headers.add(it.key, it.value);
+    post_message(Messages::ProtocolClient::DownloadHeadersReceived(download.id(), download.status_code(), response_headers));
+}
+
+void ClientConnection::did_receive_download_data(Badge<Download>, Download& download, ReadonlyBytes data)
+{
+    auto* stream = const_cast<DataStream*>(m_data_streams.get(download.id()).value_or(nullptr));
+    if (!stream) {
+        auto ring = SharedBuffer::create_with_size(data_stream_ring_size);
+        if (!ring || !ring->share_with(client_pid())) {
+            dbg() << "ProtocolServer: Failed to set up a data stream for download " << download.id();
+            return;
+        }
+        auto new_stream = make<DataStream>();
+        new_stream->ring = move(ring);
+        stream = new_stream.ptr();
+        m_data_streams.set(download.id(), move(new_stream));
+    }
+
+    // Keep the data in order, nothing can skip ahead of what's already waiting.
+    size_t written = 0;
+    if (stream->pending_data.is_empty())
+        written = write_to_data_stream(download.id(), *stream, data);
+    if (written < data.size())
+        stream->pending_data.append(ByteBuffer::copy(data.data() + written, data.size() - written));
+}
+
+size_t ClientConnection::write_to_data_stream(i32 download_id, DataStream& stream, ReadonlyBytes data)
+{
+    // The parts of the ring that haven't been consumed yet directly precede the write offset.
+    size_t written = 0;
+    while (written < data.size() && stream.unconsumed_size < data_stream_ring_size) {
+        auto count = min(data.size() - written, min(data_stream_ring_size - stream.unconsumed_size, data_stream_ring_size - stream.write_offset));
+        memcpy((u8*)stream.ring->data() + stream.write_offset, data.data() + written, count);
+        post_message(Messages::ProtocolClient::DownloadDataReceived(download_id, stream.ring->shbuf_id(), stream.write_offset, count));
+        stream.write_offset = (stream.write_offset + count) % data_stream_ring_size;
+        stream.unconsumed_size += count;
+        written += count;
+    }
+    return written;
+}
+
+void ClientConnection::handle(const Messages::ProtocolServer::DownloadDataConsumed& message)
+{
+    auto* stream = const_cast<DataStream*>(m_data_streams.get(message.download_id()).value_or(nullptr));
+    if (!stream)
+        return;
+    stream->unconsumed_size -= min((size_t)message.size(), stream->unconsumed_size);
+
+    while (!stream->pending_data.is_empty()) {
+        auto data = stream->pending_data.first().bytes().slice(stream->pending_offset);
+        auto written = write_to_data_stream(message.download_id(), *stream, data);
+        if (written < data.size()) {
+            stream->pending_offset += written;
+            return;
+        }
+        stream->pending_data.take_first();
+        stream->pending_offset = 0;
+    }
+
+    if (stream->is_finished) {
+        if (auto* download = const_cast<Download*>(m_downloads.get(message.download_id()).value_or(nullptr)))
+            post_download_finished(*download, true);
+    }
+}
+
 void ClientConnection::did_request_certificates(Badge<Download>, Download& download)
 {
     post_message(Messages::ProtocolClient::CertificateRequested(download.id()));
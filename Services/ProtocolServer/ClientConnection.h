@@ -26,7 +26,9 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/HashMap.h>
+#include <AK/Vector.h>
 #include <LibIPC/ClientConnection.h>
 #include <ProtocolServer/Forward.h>
 #include <ProtocolServer/ProtocolServerEndpoint.h>
@@ -46,6 +48,8 @@ public:
 
     void did_finish_download(Badge<Download>, Download&, bool success);
     void did_progress_download(Badge<Download>, Download&);
+    void did_receive_download_headers(Badge<Download>, Download&);
+    void did_receive_download_data(Badge<Download>, Download&, ReadonlyBytes);
     void did_request_certificates(Badge<Download>, Download&);
 
 private:
@@ -55,8 +59,26 @@ private:
     virtual OwnPtr<Messages::ProtocolServer::StopDownloadResponse> handle(const Messages::ProtocolServer::StopDownload&) override;
     virtual OwnPtr<Messages::ProtocolServer::DisownSharedBufferResponse> handle(const Messages::ProtocolServer::DisownSharedBuffer&) override;
     virtual OwnPtr<Messages::ProtocolServer::SetCertificateResponse> handle(const Messages::ProtocolServer::SetCertificate&);
+    virtual void handle(const Messages::ProtocolServer::DownloadDataConsumed&) override;
+
+    // Streamed data goes through a ring buffer that's shared with the client, which says whenever it's done
+    // with a part of it. Whatever doesn't fit in the meantime waits here until there's room again.
+    struct DataStream {
+        RefPtr<AK::SharedBuffer> ring;
+        size_t write_offset { 0 };
+        size_t unconsumed_size { 0 };
+        Vector<ByteBuffer> pending_data;
+        size_t pending_offset { 0 };
+        // Set once the download has finished, but the client hasn't seen all of its data yet.
+        bool is_finished { false };
+    };
+    static constexpr size_t data_stream_ring_size = 256 * KiB;
+
+    size_t write_to_data_stream(i32 download_id, DataStream&, ReadonlyBytes);
+    void post_download_finished(Download&, bool success);
 
     HashMap<i32, OwnPtr<Download>> m_downloads;
+    HashMap<i32, OwnPtr<DataStream>> m_data_streams;
     HashMap<i32, RefPtr<AK::SharedBuffer>> m_shared_buffers;
 };
 
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/URL.h>
+#include <AK/Vector.h>
+#include <LibCore/Socket.h>
+#include <LibCore/Timer.h>
+#include <LibTLS/TLSv12.h>
+#include <time.h>
+
+namespace ProtocolServer {
+
+// Keeps connections open after their job is done, so that the next job for the same origin can skip
+// connecting (and the TLS handshake.) This also limits how many connections are open to one origin at once,
+// the jobs beyond that wait their turn.
+//
+// Jobs go in through start_job(), and have to be handed back with release_job() once they finish or are given up on.
+template<typename JobType, typename SocketType>
+class ConnectionCache {
+public:
+    static constexpr size_t max_connections_per_origin = 6;
+    static constexpr time_t idle_timeout = 10;
+
+    static ConnectionCache& the()
+    {
+        static ConnectionCache* cache;
+        if (!cache)
+            cache = new ConnectionCache;
+        return *cache;
+    }
+
+    void start_job(JobType& job, const URL& url)
+    {
+        auto key = String::format("%s://%s:%u", url.protocol().characters(), url.host().characters(), url.port());
+        auto& origin = ensure_origin(key);
+        m_job_origins.set(&job, key);
+        origin.waiting_jobs.append(job);
+        start_waiting_jobs(origin);
+    }
+
+    void release_job(JobType& job)
+    {
+        auto it = m_job_origins.find(&job);
+        if (it == m_job_origins.end())
+            return;
+        auto& origin = ensure_origin(it->value);
+        m_job_origins.remove(it);
+
+        for (size_t i = 0; i < origin.waiting_jobs.size(); ++i) {
+            if (&origin.waiting_jobs[i] == &job) {
+                origin.waiting_jobs.remove(i);
+                return;
+            }
+        }
+
+        if (auto socket = job.take_socket()) {
+            watch_idle_connection(*socket, origin);
+            origin.idle_connections.append({ socket.release_nonnull(), time(nullptr) });
+            if (!m_idle_timer->is_active())
+                m_idle_timer->start();
+        } else {
+            --origin.connection_count;
+        }
+        start_waiting_jobs(origin);
+    }
+
+private:
+    struct IdleConnection {
+        NonnullRefPtr<SocketType> socket;
+        time_t idle_since { 0 };
+    };
+
+    // Everything is kept per scheme, host and port.
+    struct Origin {
+        Vector<IdleConnection> idle_connections;
+        NonnullRefPtrVector<JobType> waiting_jobs;
+        // Open connections, both idle and in use.
+        size_t connection_count { 0 };
+    };
+
+    ConnectionCache()
+    {
+        m_idle_timer = Core::Timer::construct(1000, [this] { close_expired_connections(); });
+        m_idle_timer->stop();
+    }
+
+    Origin& ensure_origin(const String& key)
+    {
+        auto it = m_origins.find(key);
+        if (it != m_origins.end())
+            return *it->value;
+        auto origin = make<Origin>();
+        auto& origin_ref = *origin;
+        m_origins.set(key, move(origin));
+        return origin_ref;
+    }
+
+    void start_waiting_jobs(Origin& origin)
+    {
+        while (!origin.waiting_jobs.is_empty()) {
+            if (!origin.idle_connections.is_empty()) {
+                // The most recently used connection is the least likely to have been closed by the server.
+                auto connection = origin.idle_connections.take_last();
+                stop_watching_idle_connection(*connection.socket);
+                origin.waiting_jobs.take_first()->start(move(connection.socket));
+                continue;
+            }
+            if (origin.connection_count >= max_connections_per_origin)
+                return;
+            ++origin.connection_count;
+            origin.waiting_jobs.take_first()->start();
+        }
+    }
+
+    void close_idle_connection(Origin& origin, SocketType& socket)
+    {
+        for (size_t i = 0; i < origin.idle_connections.size(); ++i) {
+            if (origin.idle_connections[i].socket.ptr() == &socket) {
+                origin.idle_connections.remove(i);
+                --origin.connection_count;
+                return;
+            }
+        }
+    }
+
+    void close_expired_connections()
+    {
+        auto now = time(nullptr);
+        bool has_idle_connections = false;
+        for (auto& it : m_origins) {
+            auto& connections = it.value->idle_connections;
+            for (size_t i = 0; i < connections.size();) {
+                if (now - connections[i].idle_since < idle_timeout) {
+                    ++i;
+                    continue;
+                }
+                stop_watching_idle_connection(*connections[i].socket);
+                connections.remove(i);
+                --it.value->connection_count;
+            }
+            has_idle_connections |= !connections.is_empty();
+        }
+        if (!has_idle_connections)
+            m_idle_timer->stop();
+    }
+
+    // An idle connection that becomes readable has been closed by the server, or is in a state we can't make sense of.
+    // Either way, it's no good for another request. It's let go of once its own callback has returned.
+    template<typename Callback>
+    static void watch(Core::Socket& socket, Callback callback) { socket.on_ready_to_read = move(callback); }
+    template<typename Callback>
+    static void watch(TLS::TLSv12& socket, Callback callback)
+    {
+        socket.on_tls_ready_to_read = [callback](auto&) { callback(); };
+        socket.on_tls_error = [callback](auto) { callback(); };
+        socket.on_tls_finished = move(callback);
+    }
+
+    static void stop_watching_idle_connection(Core::Socket& socket) { socket.on_ready_to_read = nullptr; }
+    static void stop_watching_idle_connection(TLS::TLSv12& socket)
+    {
+        socket.on_tls_ready_to_read = nullptr;
+        socket.on_tls_finished = nullptr;
+        socket.on_tls_error = nullptr;
+    }
+
+    void watch_idle_connection(SocketType& socket, Origin& origin)
+    {
+        watch(socket, [this, &socket, &origin] {
+            stop_watching_idle_connection(socket);
+            socket.deferred_invoke([this, &origin](auto& object) {
+                close_idle_connection(origin, static_cast<SocketType&>(object));
+                start_waiting_jobs(origin);
+            });
+        });
+    }
+
+    HashMap<String, NonnullOwnPtr<Origin>> m_origins;
+    HashMap<JobType*, String> m_job_origins;
+    RefPtr<Core::Timer> m_idle_timer;
+};
+
+}
@@ -51,7 +51,8 @@ void Download::stop()
 void Download::set_payload(const ByteBuffer& payload)
 {
     m_payload = payload;
-    m_total_size = payload.size();
+    // Jobs don't hold on to the body when it's being streamed, so count what went by instead.
+    m_total_size = m_should_stream_data && payload.is_empty() ? m_streamed_size : payload.size();
 }
 
 void Download::set_response_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)
@@ -75,6 +76,23 @@ void Download::did_progress(Optional<u32> total_size, u32 downloaded_size)
     m_client.did_progress_download({}, *this);
 }
 
+void Download::did_receive_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, Optional<u32> status_code)
+{
+    if (status_code.has_value())
+        set_status_code(status_code.value());
+    set_response_headers(response_headers);
+    if (m_should_stream_data)
+        m_client.did_receive_download_headers({}, *this);
+}
+
+void Download::did_receive_data(ReadonlyBytes data)
+{
+    if (!m_should_stream_data)
+        return;
+    m_streamed_size += data.size();
+    m_client.did_receive_download_data({}, *this, data);
+}
+
 void Download::did_request_certificates()
 {
     m_client.did_request_certificates({}, *this);
@@ -30,6 +30,7 @@
 #include <AK/HashMap.h>
 #include <AK/Optional.h>
 #include <AK/RefCounted.h>
+#include <AK/Span.h>
 #include <AK/URL.h>
 #include <ProtocolServer/Forward.h>
 
@@ -48,6 +49,10 @@ public:
     const ByteBuffer& payload() const { return m_payload; }
     const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers() const { return m_response_headers; }
 
+    // Whether the client wants to see the response body while it's still arriving.
+    bool should_stream_data() const { return m_should_stream_data; }
+    virtual void set_should_stream_data(bool should_stream_data) { m_should_stream_data = should_stream_data; }
+
     void stop();
     virtual void set_certificate(String, String);
 
@@ -56,6 +61,8 @@ protected:
 
     void did_finish(bool success);
     void did_progress(Optional<u32> total_size, u32 downloaded_size);
+    void did_receive_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, Optional<u32> status_code);
+    void did_receive_data(ReadonlyBytes);
     void set_status_code(u32 status_code) { m_status_code = status_code; }
     void did_request_certificates();
     void set_payload(const ByteBuffer&);
@@ -68,8 +75,10 @@ private:
     Optional<u32> m_status_code;
     Optional<u32> m_total_size {};
     size_t m_downloaded_size { 0 };
+    size_t m_streamed_size { 0 };
     ByteBuffer m_payload;
     HashMap<String, String, CaseInsensitiveStringTraits> m_response_headers;
+    bool m_should_stream_data { false };
 };
 
 }
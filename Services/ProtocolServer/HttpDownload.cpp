@@ -26,6 +26,7 @@
 
 #include <LibHTTP/HttpJob.h>
 #include <LibHTTP/HttpResponse.h>
+#include <ProtocolServer/ConnectionCache.h>
 #include <ProtocolServer/HttpDownload.h>
 
 namespace ProtocolServer {
@@ -35,6 +36,9 @@ HttpDownload::HttpDownload(ClientConnection& client, NonnullRefPtr<HTTP::HttpJob
     , m_job(job)
 {
     m_job->on_finish = [this](bool success) {
+        // Let the next download have the connection as soon as possible.
+        ConnectionCache<HTTP::HttpJob, Core::Socket>::the().release_job(m_job);
+
         if (auto* response = m_job->response()) {
             set_status_code(response->code());
             set_payload(response->payload());
@@ -51,12 +55,28 @@ HttpDownload::HttpDownload(ClientConnection& client, NonnullRefPtr<HTTP::HttpJob
     m_job->on_progress = [this](Optional<u32> total, u32 current) {
         did_progress(total, current);
     };
+    m_job->on_headers_received = [this](auto& response_headers, auto status_code) {
+        did_receive_headers(response_headers, status_code);
+    };
+    m_job->on_data_received = [this](auto data) {
+        did_receive_data(data);
+    };
+}
+
+void HttpDownload::set_should_stream_data(bool should_stream_data)
+{
+    Download::set_should_stream_data(should_stream_data);
+    // The client gets to see the body as it arrives, so there's no need to keep a copy of all of it around.
+    m_job->set_should_buffer_payload(!should_stream_data);
 }
 
 HttpDownload::~HttpDownload()
 {
     m_job->on_finish = nullptr;
     m_job->on_progress = nullptr;
+    m_job->on_headers_received = nullptr;
+    m_job->on_data_received = nullptr;
+    ConnectionCache<HTTP::HttpJob, Core::Socket>::the().release_job(m_job);
     m_job->shutdown();
 }
 
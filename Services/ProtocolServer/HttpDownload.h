@@ -41,6 +41,8 @@ public:
 private:
     explicit HttpDownload(ClientConnection&, NonnullRefPtr<HTTP::HttpJob>);
 
+    virtual void set_should_stream_data(bool) override;
+
     NonnullRefPtr<HTTP::HttpJob> m_job;
 };
 
@@ -26,6 +26,7 @@
 
 #include <LibHTTP/HttpJob.h>
 #include <LibHTTP/HttpRequest.h>
+#include <ProtocolServer/ConnectionCache.h>
 #include <ProtocolServer/HttpDownload.h>
 #include <ProtocolServer/HttpProtocol.h>
 
@@ -46,10 +47,11 @@ OwnPtr<Download> HttpProtocol::start_download(ClientConnection& client, const UR
     request.set_method(HTTP::HttpRequest::Method::GET);
     request.set_url(url);
     request.set_headers(headers);
-    auto job = request.schedule();
-    if (!job)
-        return nullptr;
-    return HttpDownload::create_with_job({}, client, (HTTP::HttpJob&)*job);
+    request.set_keep_alive(true);
+    auto job = HTTP::HttpJob::construct(request);
+    auto download = HttpDownload::create_with_job({}, client, (HTTP::HttpJob&)*job);
+    ConnectionCache<HTTP::HttpJob, Core::Socket>::the().start_job(job, url);
+    return download;
 }
 
 }
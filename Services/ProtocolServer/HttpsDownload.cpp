@@ -26,6 +26,7 @@
 
 #include <LibHTTP/HttpResponse.h>
 #include <LibHTTP/HttpsJob.h>
+#include <ProtocolServer/ConnectionCache.h>
 #include <ProtocolServer/HttpsDownload.h>
 
 namespace ProtocolServer {
@@ -35,6 +36,9 @@ HttpsDownload::HttpsDownload(ClientConnection& client, NonnullRefPtr<HTTP::Https
     , m_job(job)
 {
     m_job->on_finish = [this](bool success) {
+        // Let the next download have the connection as soon as possible.
+        ConnectionCache<HTTP::HttpsJob, TLS::TLSv12>::the().release_job(m_job);
+
         if (auto* response = m_job->response()) {
             set_status_code(response->code());
             set_payload(response->payload());
@@ -51,6 +55,12 @@ HttpsDownload::HttpsDownload(ClientConnection& client, NonnullRefPtr<HTTP::Https
     m_job->on_progress = [this](Optional<u32> total, u32 current) {
         did_progress(total, current);
     };
+    m_job->on_headers_received = [this](auto& response_headers, auto status_code) {
+        did_receive_headers(response_headers, status_code);
+    };
+    m_job->on_data_received = [this](auto data) {
+        did_receive_data(data);
+    };
     m_job->on_certificate_requested = [this](auto&) {
         did_request_certificates();
     };
@@ -61,10 +71,20 @@ void HttpsDownload::set_certificate(String certificate, String key)
     m_job->set_certificate(move(certificate), move(key));
 }
 
+void HttpsDownload::set_should_stream_data(bool should_stream_data)
+{
+    Download::set_should_stream_data(should_stream_data);
+    // The client gets to see the body as it arrives, so there's no need to keep a copy of all of it around.
+    m_job->set_should_buffer_payload(!should_stream_data);
+}
+
 HttpsDownload::~HttpsDownload()
 {
     m_job->on_finish = nullptr;
     m_job->on_progress = nullptr;
+    m_job->on_headers_received = nullptr;
+    m_job->on_data_received = nullptr;
+    ConnectionCache<HTTP::HttpsJob, TLS::TLSv12>::the().release_job(m_job);
     m_job->shutdown();
 }
 
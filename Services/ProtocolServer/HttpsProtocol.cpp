@@ -26,6 +26,7 @@
 
 #include <LibHTTP/HttpRequest.h>
 #include <LibHTTP/HttpsJob.h>
+#include <ProtocolServer/ConnectionCache.h>
 #include <ProtocolServer/HttpsDownload.h>
 #include <ProtocolServer/HttpsProtocol.h>
 
@@ -46,9 +47,10 @@ OwnPtr<Download> HttpsProtocol::start_download(ClientConnection& client, const U
     request.set_method(HTTP::HttpRequest::Method::GET);
     request.set_url(url);
     request.set_headers(headers);
+    request.set_keep_alive(true);
     auto job = HTTP::HttpsJob::construct(request);
     auto download = HttpsDownload::create_with_job({}, client, (HTTP::HttpsJob&)*job);
-    job->start();
+    ConnectionCache<HTTP::HttpsJob, TLS::TLSv12>::the().start_job(job, url);
     return download;
 }
 
@@ -29,6 +29,7 @@
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <LibCore/ConfigFile.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibCore/Socket.h>
 #include <grp.h>
 #include <libgen.h>
@@ -84,6 +85,27 @@ Service* Service::find_by_pid(pid_t pid)
     return (*it).value;
 }
 
+Vector<String> Service::dependencies() const
+{
+    Vector<String> dependencies = m_after;
+    for (auto& name : m_requires) {
+        if (!dependencies.contains_slow(name))
+            dependencies.append(name);
+    }
+    return dependencies;
+}
+
+void Service::record_boot_event(int& timestamp, const char* event)
+{
+    // Only the first time counts; restarts and later connections don't say anything about boot.
+    if (timestamp >= 0)
+        return;
+
+    extern Core::ElapsedTimer g_boot_timer;
+    timestamp = g_boot_timer.elapsed();
+    dbg() << "Service " << name() << ": " << event << " at " << timestamp << "ms";
+}
+
 static int ensure_parent_directories(const char* path)
 {
     ASSERT(path[0] == '/');
@@ -152,6 +174,8 @@ void Service::setup_socket()
         perror("listen");
         ASSERT_NOT_REACHED();
     }
+
+    record_boot_event(m_socket_ready_at, "socket ready");
 }
 
 void Service::setup_notifier()
@@ -171,6 +195,8 @@ void Service::handle_socket_connection()
 #ifdef SERVICE_DEBUG
     dbg() << "Ready to read on behalf of " << name();
 #endif
+    record_boot_event(m_first_connection_at, "first connection");
+
     if (m_accept_socket_connections) {
         int accepted_fd = accept(m_socket_fd, nullptr, nullptr);
         if (accepted_fd < 0) {
@@ -190,6 +216,8 @@ void Service::activate()
 {
     ASSERT(m_pid < 0);
 
+    record_boot_event(m_activated_at, "activated");
+
     if (m_lazy)
         setup_notifier();
     else
@@ -281,10 +309,13 @@ void Service::spawn(int socket_fd)
         rc = execv(argv[0], argv);
         perror("exec");
         ASSERT_NOT_REACHED();
-    } else if (!m_multi_instance) {
+    } else {
         // We are the parent.
-        m_pid = pid;
-        s_service_map.set(pid, this);
+        record_boot_event(m_spawned_at, "spawned");
+        if (!m_multi_instance) {
+            m_pid = pid;
+            s_service_map.set(pid, this);
+        }
     }
 }
 
@@ -354,6 +385,8 @@ Service::Service(const Core::ConfigFile& config, const StringView& name)
     m_boot_modes = config.read_entry(name, "BootModes", "graphical").split(',');
     m_multi_instance = config.read_bool_entry(name, "MultiInstance");
     m_accept_socket_connections = config.read_bool_entry(name, "AcceptSocketConnections");
+    m_after = config.read_entry(name, "After").split(',');
+    m_requires = config.read_entry(name, "Requires").split(',');
 
     m_socket_path = config.read_entry(name, "Socket");
 
@@ -416,6 +449,17 @@ void Service::save_to(JsonObject& json)
 
     json.set("restart_attempts", m_restart_attempts);
     json.set("working_directory", m_working_directory);
+
+    auto set_timestamp = [&](const char* key, int timestamp) {
+        if (timestamp >= 0)
+            json.set(key, timestamp);
+        else
+            json.set(key, nullptr);
+    };
+    set_timestamp("socket_ready_at_ms", m_socket_ready_at);
+    set_timestamp("activated_at_ms", m_activated_at);
+    set_timestamp("spawned_at_ms", m_spawned_at);
+    set_timestamp("first_connection_at_ms", m_first_connection_at);
 }
 
 bool Service::is_enabled() const
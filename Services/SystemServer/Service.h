@@ -42,6 +42,10 @@ public:
 
     static Service* find_by_pid(pid_t);
 
+    // Names of the services that have to be activated before this one.
+    Vector<String> dependencies() const;
+    bool requires_service(const String& name) const { return m_requires.contains_slow(name); }
+
     void save_to(AK::JsonObject&) override;
 
 private:
@@ -81,6 +85,10 @@ private:
     bool m_multi_instance { false };
     // Environment variables to pass to the service.
     Vector<String> m_environment;
+    // Services that this service should be activated after, if they are enabled.
+    Vector<String> m_after;
+    // Services without which this service should not be activated at all.
+    Vector<String> m_requires;
 
     // For single-instance services, PID of the running instance of this service.
     pid_t m_pid { -1 };
@@ -94,6 +102,15 @@ private:
     // times where it has exited unsuccessfully and too quickly.
     int m_restart_attempts { 0 };
 
+    // When the service reached each point of its startup, in milliseconds since
+    // SystemServer started, or -1 if it hasn't (yet).
+    int m_socket_ready_at { -1 };
+    int m_activated_at { -1 };
+    int m_spawned_at { -1 };
+    int m_first_connection_at { -1 };
+
+    void record_boot_event(int& timestamp, const char* event);
+
     void resolve_user();
     void setup_socket();
     void setup_notifier();
@@ -27,7 +27,9 @@
 #include "Service.h"
 #include <AK/Assertions.h>
 #include <AK/ByteBuffer.h>
+#include <AK/HashTable.h>
 #include <LibCore/ConfigFile.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/File.h>
@@ -39,6 +41,7 @@
 #include <unistd.h>
 
 String g_boot_mode = "graphical";
+Core::ElapsedTimer g_boot_timer;
 
 static void sigchld_handler(int)
 {
@@ -102,6 +105,68 @@ static void mount_all_filesystems()
     }
 }
 
+static void activate_services(NonnullRefPtrVector<Service>& services)
+{
+    HashTable<String> enabled;
+    for (auto& service : services)
+        enabled.set(service.name());
+
+    // Drop services that require something that won't be started, which in turn
+    // may leave more services without something they require.
+    bool dropped_any = true;
+    while (dropped_any) {
+        dropped_any = false;
+        services.remove_all_matching([&](auto& service) {
+            for (auto& dependency : service->dependencies()) {
+                if (!enabled.contains(dependency) && service->requires_service(dependency)) {
+                    dbg() << "Not activating " << service->name() << ", as it requires " << dependency << " which is not enabled";
+                    enabled.remove(service->name());
+                    dropped_any = true;
+                    return true;
+                }
+            }
+            return false;
+        });
+    }
+
+    // Activate the services in waves: each wave consists of every service whose
+    // dependencies have all been activated in the previous ones.
+    HashTable<String> activated;
+    Vector<Service*> pending;
+    for (auto& service : services)
+        pending.append(&service);
+
+    for (int wave = 0; !pending.is_empty(); ++wave) {
+        Vector<Service*> ready;
+        for (auto* service : pending) {
+            bool dependencies_activated = true;
+            for (auto& dependency : service->dependencies()) {
+                // Ordering against a service that won't be started is meaningless.
+                if (enabled.contains(dependency) && !activated.contains(dependency)) {
+                    dependencies_activated = false;
+                    break;
+                }
+            }
+            if (dependencies_activated)
+                ready.append(service);
+        }
+
+        if (ready.is_empty()) {
+            dbg() << "Found a dependency cycle between " << pending.size() << " services, activating them in order";
+            ready = move(pending);
+        }
+
+        dbg() << "Activating " << ready.size() << " services in wave " << wave << " at " << g_boot_timer.elapsed() << "ms";
+        for (auto* service : ready) {
+            service->activate();
+            activated.set(service->name());
+        }
+        pending.remove_all_matching([&](auto* service) {
+            return activated.contains(service->name());
+        });
+    }
+}
+
 int main(int, char**)
 {
     if (pledge("stdio proc exec tty accept unix rpath wpath cpath chown fattr id sigaction", nullptr) < 0) {
@@ -109,6 +174,8 @@ int main(int, char**)
         return 1;
     }
 
+    g_boot_timer.start();
+
     mount_all_filesystems();
     parse_boot_mode();
 
@@ -133,8 +200,7 @@ int main(int, char**)
 
     // After we've set them all up, activate them!
     dbg() << "Activating " << services.size() << " services...";
-    for (auto& service : services)
-        service.activate();
+    activate_services(services);
 
     return event_loop.exec();
 }
@@ -64,6 +64,7 @@ Gfx::Palette PageHost::palette() const
 void PageHost::set_palette_impl(const Gfx::PaletteImpl& impl)
 {
     m_palette_impl = impl;
+    invalidate_all_tiles();
 }
 
 Web::LayoutDocument* PageHost::layout_root()
@@ -81,16 +82,21 @@ void PageHost::paint(const Gfx::IntRect& content_rect, Gfx::Bitmap& target)
 
     auto* layout_root = this->layout_root();
     if (!layout_root) {
+        m_tiles.clear();
         painter.fill_rect(bitmap_rect, Color::White);
         return;
     }
 
-    painter.fill_rect(bitmap_rect, layout_root->document().background_color(palette()));
-
-    if (auto background_bitmap = layout_root->document().background_image()) {
-        painter.draw_tiled_bitmap(bitmap_rect, *background_bitmap);
+    // The background image is tiled relative to the viewport, so it can't be cached with the content.
+    auto background_bitmap = layout_root->document().background_image();
+    if (!background_bitmap) {
+        paint_tiles(content_rect, target);
+        return;
     }
 
+    painter.fill_rect(bitmap_rect, layout_root->document().background_color(palette()));
+    painter.draw_tiled_bitmap(bitmap_rect, *background_bitmap);
+
     painter.translate(-content_rect.x(), -content_rect.y());
 
     Web::PaintContext context(painter, palette(), Gfx::IntPoint());
@@ -98,6 +104,93 @@ void PageHost::paint(const Gfx::IntRect& content_rect, Gfx::Bitmap& target)
     layout_root->paint_all_phases(context);
 }
 
+static int tile_index(int coordinate, int tile_size)
+{
+    if (coordinate < 0)
+        return -((-coordinate + tile_size - 1) / tile_size);
+    return coordinate / tile_size;
+}
+
+static u64 tile_key(int column, int row)
+{
+    return ((u64)(u32)row << 32) | (u32)column;
+}
+
+template<typename Callback>
+static void for_each_tile_in_rect(const Gfx::IntRect& rect, int tile_size, Callback callback)
+{
+    if (rect.is_empty())
+        return;
+    for (int row = tile_index(rect.top(), tile_size); row <= tile_index(rect.bottom(), tile_size); ++row) {
+        for (int column = tile_index(rect.left(), tile_size); column <= tile_index(rect.right(), tile_size); ++column)
+            callback(tile_key(column, row), Gfx::IntRect { column * tile_size, row * tile_size, tile_size, tile_size });
+    }
+}
+
+void PageHost::paint_tiles(const Gfx::IntRect& content_rect, Gfx::Bitmap& target)
+{
+    Gfx::Painter painter(target);
+
+    for_each_tile_in_rect(content_rect, tile_size, [&](u64 key, const Gfx::IntRect& tile_rect) {
+        auto& tile = m_tiles.ensure(key);
+        if (!tile.bitmap) {
+            tile.bitmap = Gfx::Bitmap::create(target.format(), tile_rect.size());
+            if (!tile.bitmap)
+                return;
+            tile.dirty = true;
+        }
+        if (tile.dirty) {
+            rasterize_tile(tile_rect, *tile.bitmap);
+            tile.dirty = false;
+        }
+        painter.blit(tile_rect.location().translated(-content_rect.x(), -content_rect.y()), *tile.bitmap, tile.bitmap->rect());
+    });
+
+    // Keep a ring of tiles around the viewport for scrolling, and let go of the rest.
+    Vector<u64> keys_to_keep;
+    for_each_tile_in_rect(content_rect.inflated(tile_size * 2, tile_size * 2), tile_size, [&](u64 key, const Gfx::IntRect&) {
+        keys_to_keep.append(key);
+    });
+    if (m_tiles.size() > keys_to_keep.size()) {
+        Vector<u64> keys_to_remove;
+        for (auto& it : m_tiles) {
+            if (!keys_to_keep.contains_slow(it.key))
+                keys_to_remove.append(it.key);
+        }
+        for (auto key : keys_to_remove)
+            m_tiles.remove(key);
+    }
+}
+
+void PageHost::rasterize_tile(const Gfx::IntRect& tile_rect, Gfx::Bitmap& bitmap)
+{
+    auto* layout_root = this->layout_root();
+    ASSERT(layout_root);
+
+    Gfx::Painter painter(bitmap);
+    painter.fill_rect(bitmap.rect(), layout_root->document().background_color(palette()));
+    painter.translate(-tile_rect.x(), -tile_rect.y());
+
+    Web::PaintContext context(painter, palette(), Gfx::IntPoint());
+    context.set_viewport_rect(tile_rect);
+    layout_root->paint_all_phases(context);
+}
+
+void PageHost::invalidate_tiles(const Gfx::IntRect& content_rect)
+{
+    for_each_tile_in_rect(content_rect, tile_size, [&](u64 key, const Gfx::IntRect&) {
+        auto it = m_tiles.find(key);
+        if (it != m_tiles.end())
+            it->value.dirty = true;
+    });
+}
+
+void PageHost::invalidate_all_tiles()
+{
+    for (auto& it : m_tiles)
+        it.value.dirty = true;
+}
+
 void PageHost::set_viewport_rect(const Gfx::IntRect& rect)
 {
     page().main_frame().set_size(rect.size());
@@ -108,6 +201,7 @@ void PageHost::set_viewport_rect(const Gfx::IntRect& rect)
 
 void PageHost::page_did_invalidate(const Gfx::IntRect& content_rect)
 {
+    invalidate_tiles(content_rect);
     m_client.post_message(Messages::WebContentClient::DidInvalidateContentRect(content_rect));
 }
 
@@ -118,6 +212,7 @@ void PageHost::page_did_change_selection()
 
 void PageHost::page_did_layout()
 {
+    invalidate_all_tiles();
     auto* layout_root = this->layout_root();
     ASSERT(layout_root);
     auto content_size = enclosing_int_rect(layout_root->absolute_rect()).size();
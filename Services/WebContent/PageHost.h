@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
+#include <LibGfx/Bitmap.h>
 #include <LibWeb/Page/Page.h>
 
 namespace WebContent {
@@ -69,9 +71,23 @@ private:
     Web::LayoutDocument* layout_root();
     void setup_palette();
 
+    // We keep rasterized tiles of the page content around, so scrolling and small invalidations
+    // (like a blinking cursor) only have to paint the tiles that actually changed.
+    struct Tile {
+        RefPtr<Gfx::Bitmap> bitmap;
+        bool dirty { true };
+    };
+    static constexpr int tile_size = 256;
+
+    void paint_tiles(const Gfx::IntRect& content_rect, Gfx::Bitmap&);
+    void rasterize_tile(const Gfx::IntRect& tile_rect, Gfx::Bitmap&);
+    void invalidate_tiles(const Gfx::IntRect& content_rect);
+    void invalidate_all_tiles();
+
     ClientConnection& m_client;
     NonnullOwnPtr<Web::Page> m_page;
     RefPtr<Gfx::PaletteImpl> m_palette_impl;
+    HashMap<u64, Tile> m_tiles;
 };
 
 }
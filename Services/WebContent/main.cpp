@@ -26,16 +26,31 @@
 
 #include <LibCore/EventLoop.h>
 #include <LibCore/LocalServer.h>
+#include <LibGfx/Font.h>
 #include <LibIPC/ClientConnection.h>
+#include <LibWeb/Loader/HttpCache.h>
 #include <WebContent/ClientConnection.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 int main(int, char**)
 {
     Core::EventLoop event_loop;
-    if (pledge("stdio shared_buffer accept unix rpath", nullptr) < 0) {
+    if (pledge("stdio shared_buffer accept unix rpath wpath cpath", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
+    // The HTTP cache is shared with other WebContent processes through files on disk.
+    if (mkdir(Web::HttpCache::directory, 0700) < 0 && errno != EEXIST) {
+        perror("mkdir");
+        return 1;
+    }
+    if (unveil(Web::HttpCache::directory, "rwc") < 0) {
+        perror("unveil");
+        return 1;
+    }
     if (unveil("/res", "r") < 0) {
         perror("unveil");
         return 1;
@@ -53,6 +68,11 @@ int main(int, char**)
         return 1;
     }
 
+    // We may have been started ahead of time, so get the fonts every page needs loaded while we're idle.
+    Gfx::Font::default_font();
+    Gfx::Font::default_bold_font();
+    Gfx::Font::default_fixed_width_font();
+
     auto socket = Core::LocalSocket::take_over_accepted_socket_from_system_server();
     ASSERT(socket);
     IPC::new_client_connection<WebContent::ClientConnection>(socket.release_nonnull(), 1);
@@ -25,6 +25,7 @@
  */
 
 #include "Client.h"
+#include "FileCache.h"
 #include <AK/Base64.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
@@ -36,12 +37,18 @@
 #include <LibCore/MimeData.h>
 #include <LibHTTP/HttpRequest.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
 namespace WebServer {
 
+// Connections that have been quiet for this long are closed.
+static constexpr int idle_timeout_ms = 15000;
+// Anything longer than this without a complete request header is rejected.
+static constexpr size_t max_request_header_size = 64 * KiB;
+
 Client::Client(NonnullRefPtr<Core::TCPSocket> socket, const String& root, Core::Object* parent)
     : Core::Object(parent)
     , m_socket(socket)
@@ -51,32 +58,121 @@ Client::Client(NonnullRefPtr<Core::TCPSocket> socket, const String& root, Core::
 
 void Client::die()
 {
-    remove_from_parent();
+    if (m_dead)
+        return;
+    m_dead = true;
+    m_socket->on_ready_to_read = nullptr;
+    m_write_notifier->set_enabled(false);
+    m_idle_timer->stop();
+    m_socket->close();
+    // We're usually inside one of our own callbacks here, so go away once it has returned.
+    deferred_invoke([](auto& object) {
+        object.remove_from_parent();
+    });
 }
 
 void Client::start()
 {
-    m_socket->on_ready_to_read = [this] {
-        auto raw_request = m_socket->read_all();
-        if (raw_request.is_null()) {
-            die();
-            return;
-        }
+    m_write_notifier = Core::Notifier::construct(m_socket->fd(), Core::Notifier::Event::Write, this);
+    m_write_notifier->set_enabled(false);
+    m_write_notifier->on_ready_to_write = [this] {
+        flush_output();
+        // The previous response may have been holding up pipelined requests.
+        process_buffered_requests();
+    };
 
-        dbg() << "Got raw request: '" << String::copy(raw_request) << "'";
+    m_idle_timer = Core::Timer::create_single_shot(
+        idle_timeout_ms, [this] {
+            dbg() << "WebServer: Closing idle connection";
+            die();
+        },
+        this);
+    m_idle_timer->start();
 
-        handle_request(move(raw_request));
-        die();
+    m_socket->on_ready_to_read = [this] {
+        did_receive_data();
     };
 }
 
-void Client::handle_request(ByteBuffer raw_request)
+void Client::did_receive_data()
 {
-    auto request_or_error = HTTP::HttpRequest::from_raw_request(raw_request);
-    if (!request_or_error.has_value())
+    auto data = m_socket->read(16 * KiB);
+    if (data.is_null()) {
+        if (m_socket->eof() || m_socket->error() != EAGAIN)
+            die();
         return;
-    auto& request = request_or_error.value();
+    }
+    m_idle_timer->restart();
+    m_input.append(data.data(), data.size());
+    process_buffered_requests();
+}
+
+static Optional<size_t> find_end_of_header(const ByteBuffer& buffer)
+{
+    if (buffer.size() < 4)
+        return {};
+    for (size_t i = 0; i <= buffer.size() - 4; ++i) {
+        if (!memcmp(buffer.data() + i, "\r\n\r\n", 4))
+            return i + 4;
+    }
+    return {};
+}
+
+static String header_value(const HTTP::HttpRequest& request, const StringView& name)
+{
+    for (auto& header : request.headers()) {
+        if (header.name.equals_ignoring_case(name))
+            return header.value;
+    }
+    return {};
+}
+
+void Client::process_buffered_requests()
+{
+    while (!m_dead && !has_pending_output()) {
+        auto header_size = find_end_of_header(m_input);
+        if (!header_size.has_value()) {
+            if (m_input.size() > max_request_header_size)
+                send_bad_request();
+            return;
+        }
 
+        auto request_or_error = HTTP::HttpRequest::from_raw_request(m_input.slice_view(0, header_size.value()));
+        if (!request_or_error.has_value()) {
+            send_bad_request();
+            return;
+        }
+        auto& request = request_or_error.value();
+
+        // We don't look at request bodies, but we have to skip over them to get to the next request.
+        size_t body_size = 0;
+        if (auto content_length = header_value(request, "Content-Length"); !content_length.is_null()) {
+            auto body_size_or_error = content_length.to_uint();
+            if (!body_size_or_error.has_value()) {
+                send_bad_request();
+                return;
+            }
+            body_size = body_size_or_error.value();
+        }
+        if (m_input.size() < header_size.value() + body_size)
+            return;
+        size_t request_size = header_size.value() + body_size;
+        m_input = m_input.slice(request_size, m_input.size() - request_size);
+
+        // HTTP/1.1 connections are persistent unless either side says otherwise, HTTP/1.0 ones only when asked to be.
+        auto connection = header_value(request, "Connection");
+        if (request.protocol() == "HTTP/1.1")
+            m_keep_alive = !connection.equals_ignoring_case("close");
+        else
+            m_keep_alive = connection.equals_ignoring_case("keep-alive");
+
+        handle_request(request);
+        flush_output();
+    }
+}
+
+void Client::handle_request(const HTTP::HttpRequest& request)
+{
     dbg() << "Got HTTP request: " << request.method_name() << " " << request.resource();
     for (auto& header : request.headers()) {
         dbg() << "    " << header.name << " => " << header.value;
@@ -96,7 +192,13 @@ void Client::handle_request(ByteBuffer raw_request)
     path_builder.append(requested_path);
     auto real_path = path_builder.to_string();
 
-    if (Core::File::is_directory(real_path)) {
+    struct stat st;
+    if (stat(real_path.characters(), &st) < 0) {
+        send_error_response(404, "Not found!", request);
+        return;
+    }
+
+    if (S_ISDIR(st.st_mode)) {
 
         if (!request.resource().ends_with("/")) {
             StringBuilder red;
@@ -112,34 +214,139 @@ void Client::handle_request(ByteBuffer raw_request)
         index_html_path_builder.append(real_path);
         index_html_path_builder.append("/index.html");
         auto index_html_path = index_html_path_builder.to_string();
-        if (!Core::File::exists(index_html_path)) {
+        if (stat(index_html_path.characters(), &st) < 0) {
             handle_directory_listing(requested_path, real_path, request);
             return;
         }
         real_path = index_html_path;
     }
 
+    auto entry = FileCache::the().get_file(real_path, st, Core::guess_mime_type_based_on_filename(request.url()));
+    if (!entry) {
+        send_error_response(404, "Not found!", request);
+        return;
+    }
+
+    if (is_not_modified(*entry, request)) {
+        StringBuilder builder;
+        builder.appendf("ETag: %s\r\n", entry->etag.characters());
+        builder.appendf("Last-Modified: %s\r\n", entry->last_modified.characters());
+        send_header(304, "Not Modified", {}, {}, builder.to_string());
+        log_response(304, request);
+        return;
+    }
+
+    if (!entry->body.is_null()) {
+        send_cached_response(*entry, request);
+        return;
+    }
+
     auto file = Core::File::construct(real_path);
     if (!file->open(Core::File::ReadOnly)) {
         send_error_response(404, "Not found!", request);
         return;
     }
 
-    send_response(file->read_all(), request, Core::guess_mime_type_based_on_filename(request.url()));
+    send_file_response(*file, *entry, request);
+}
+
+// If-None-Match wins if both are present. Since clients send back the Last-Modified date they got from us,
+// If-Modified-Since only has to match it exactly, the way nginx does it by default.
+bool Client::is_not_modified(const FileCache::Entry& entry, const HTTP::HttpRequest& request) const
+{
+    auto if_none_match = header_value(request, "If-None-Match");
+    if (!if_none_match.is_null()) {
+        for (auto& etag : if_none_match.split(',')) {
+            auto trimmed_etag = etag.trim_whitespace();
+            if (trimmed_etag == "*" || trimmed_etag == entry.etag || trimmed_etag == gzipped_etag(entry.etag))
+                return true;
+        }
+        return false;
+    }
+    auto if_modified_since = header_value(request, "If-Modified-Since");
+    return !entry.last_modified.is_null() && if_modified_since == entry.last_modified;
+}
+
+bool Client::accepts_gzip(const HTTP::HttpRequest& request)
+{
+    for (auto& coding : header_value(request, "Accept-Encoding").split(',')) {
+        auto parts = coding.split(';');
+        if (parts.is_empty() || !parts[0].trim_whitespace().equals_ignoring_case("gzip"))
+            continue;
+        // "gzip;q=0" means the opposite of what it says on the tin.
+        for (size_t i = 1; i < parts.size(); ++i) {
+            auto parameter = parts[i].trim_whitespace();
+            if (parameter.starts_with("q=") && parameter.substring_view(2, parameter.length() - 2).to_string().trim_whitespace().is_one_of("0", "0.0", "0.00", "0.000"))
+                return false;
+        }
+        return true;
+    }
+    return false;
 }
 
-void Client::send_response(StringView response, const HTTP::HttpRequest& request, const String& content_type)
+String Client::gzipped_etag(const String& etag)
+{
+    if (etag.length() < 2)
+        return etag;
+    return String::format("%s-gz\"", etag.substring(0, etag.length() - 1).characters());
+}
+
+void Client::send_header(unsigned code, const StringView& reason, const String& content_type, Optional<size_t> content_length, const String& extra_headers)
 {
     StringBuilder builder;
-    builder.append("HTTP/1.0 200 OK\r\n");
-    builder.append("Server: WebServer (SerenityOS)\r\n");
-    builder.append("Content-Type: ");
-    builder.append(content_type);
+    builder.appendf("HTTP/1.1 %u ", code);
+    builder.append(reason);
     builder.append("\r\n");
+    builder.append("Server: WebServer (SerenityOS)\r\n");
+    if (!content_type.is_null()) {
+        builder.append("Content-Type: ");
+        builder.append(content_type);
+        builder.append("\r\n");
+    }
+    if (content_length.has_value())
+        builder.appendf("Content-Length: %zu\r\n", content_length.value());
+    builder.append(m_keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+    builder.append(extra_headers);
     builder.append("\r\n");
 
-    m_socket->write(builder.to_string());
-    m_socket->write(response);
+    send_data(builder.to_string());
+}
+
+void Client::send_data(const String& data)
+{
+    m_output.append(ByteBuffer::copy(data.characters(), data.length()));
+}
+
+void Client::send_cached_response(const FileCache::Entry& entry, const HTTP::HttpRequest& request)
+{
+    StringBuilder builder;
+    bool is_gzipped = !entry.gzipped_body.is_null() && accepts_gzip(request);
+    if (!entry.gzipped_body.is_null())
+        builder.append("Vary: Accept-Encoding\r\n");
+    if (is_gzipped)
+        builder.append("Content-Encoding: gzip\r\n");
+    if (!entry.etag.is_null()) {
+        builder.appendf("ETag: %s\r\n", (is_gzipped ? gzipped_etag(entry.etag) : entry.etag).characters());
+        builder.appendf("Last-Modified: %s\r\n", entry.last_modified.characters());
+    }
+
+    // The cached buffers are shared with the queue, not copied.
+    auto& body = is_gzipped ? entry.gzipped_body : entry.body;
+    send_header(200, "OK", entry.content_type, body.size(), builder.to_string());
+    m_output.append(body);
+
+    log_response(200, request);
+}
+
+void Client::send_file_response(Core::File& file, const FileCache::Entry& entry, const HTTP::HttpRequest& request)
+{
+    StringBuilder builder;
+    builder.appendf("ETag: %s\r\n", entry.etag.characters());
+    builder.appendf("Last-Modified: %s\r\n", entry.last_modified.characters());
+    send_header(200, "OK", entry.content_type, entry.size, builder.to_string());
+    // The file itself is sent straight from the page cache as the socket drains, see flush_output().
+    m_file = file;
+    m_file_remaining = entry.size;
 
     log_response(200, request);
 }
@@ -147,17 +354,58 @@ void Client::send_response(StringView response, const HTTP::HttpRequest& request
 void Client::send_redirect(StringView redirect_path, const HTTP::HttpRequest& request)
 {
     StringBuilder builder;
-    builder.append("HTTP/1.0 301 Moved Permanently\r\n");
     builder.append("Location: ");
     builder.append(redirect_path);
     builder.append("\r\n");
-    builder.append("\r\n");
-
-    m_socket->write(builder.to_string());
+    send_header(301, "Moved Permanently", {}, 0, builder.to_string());
 
     log_response(301, request);
 }
 
+void Client::flush_output()
+{
+    while (!m_dead && has_pending_output()) {
+        ssize_t nsent;
+        if (!m_output.is_empty()) {
+            auto& buffer = m_output.first();
+            nsent = ::write(m_socket->fd(), buffer.data() + m_output_offset, buffer.size() - m_output_offset);
+            if (nsent > 0)
+                m_output_offset += nsent;
+            if (m_output_offset == buffer.size()) {
+                m_output.take_first();
+                m_output_offset = 0;
+            }
+        } else {
+            nsent = sendfile(m_socket->fd(), m_file->fd(), nullptr, min(m_file_remaining, 64 * KiB));
+            if (nsent > 0)
+                m_file_remaining -= nsent;
+            // A file that shrank under us leaves the client waiting for bytes that never come, so give up on the connection.
+            if (nsent == 0 && m_file_remaining) {
+                die();
+                return;
+            }
+            if (!m_file_remaining)
+                m_file = nullptr;
+        }
+        if (nsent < 0) {
+            if (errno == EAGAIN) {
+                m_write_notifier->set_enabled(true);
+                return;
+            }
+            perror("write");
+            die();
+            return;
+        }
+        m_idle_timer->restart();
+    }
+    if (m_dead)
+        return;
+
+    m_write_notifier->set_enabled(false);
+    if (!m_keep_alive)
+        die();
+}
+
 static String folder_image_data()
 {
     static String cache;
@@ -179,6 +427,19 @@ static String file_image_data()
 }
 
 void Client::handle_directory_listing(const String& requested_path, const String& real_path, const HTTP::HttpRequest& request)
+{
+    struct stat st;
+    if (stat(real_path.characters(), &st) < 0) {
+        send_error_response(404, "Not found!", request);
+        return;
+    }
+    auto entry = FileCache::the().get_directory_listing(st, [&] {
+        return render_directory_listing(requested_path, real_path);
+    });
+    send_cached_response(*entry, request);
+}
+
+String Client::render_directory_listing(const String& requested_path, const String& real_path)
 {
     StringBuilder builder;
 
@@ -238,24 +499,32 @@ void Client::handle_directory_listing(const String& requested_path, const String
     builder.append("</body>\n");
     builder.append("</html>\n");
 
-    send_response(builder.to_string(), request, "text/html");
+    return builder.to_string();
 }
 
 void Client::send_error_response(unsigned code, const StringView& message, const HTTP::HttpRequest& request)
 {
     StringBuilder builder;
-    builder.appendf("HTTP/1.0 %u ", code);
-    builder.append(message);
-    builder.append("\r\n\r\n");
     builder.append("<!DOCTYPE html><html><body><h1>");
     builder.appendf("%u ", code);
     builder.append(message);
     builder.append("</h1></body></html>");
-    m_socket->write(builder.to_string());
+    auto body = builder.to_string();
+    send_header(code, message, "text/html", body.length());
+    send_data(body);
 
     log_response(code, request);
 }
 
+void Client::send_bad_request()
+{
+    // We can't tell where the next request would start, so this is the last one.
+    m_keep_alive = false;
+    m_input.clear();
+    send_header(400, "Bad Request", {}, 0);
+    flush_output();
+}
+
 void Client::log_response(unsigned code, const HTTP::HttpRequest& request)
 {
     printf("%s :: %03u :: %s %s\n",
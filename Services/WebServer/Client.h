@@ -26,12 +26,23 @@
 
 #pragma once
 
+#include "FileCache.h"
+#include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
+#include <LibCore/File.h>
+#include <LibCore/Forward.h>
+#include <LibCore/Notifier.h>
 #include <LibCore/Object.h>
 #include <LibCore/TCPSocket.h>
+#include <LibCore/Timer.h>
 #include <LibHTTP/Forward.h>
 
 namespace WebServer {
 
+// One HTTP/1.1 connection. Requests are handled in the order they arrive, and the connection
+// stays open between them unless the client asks otherwise. Responses are written without
+// blocking, so the next request waits until everything for the previous one has been sent.
 class Client final : public Core::Object {
     C_OBJECT(Client);
 
@@ -41,16 +52,40 @@ public:
 private:
     Client(NonnullRefPtr<Core::TCPSocket>, const String&, Core::Object* parent);
 
-    void handle_request(ByteBuffer);
-    void send_response(StringView, const HTTP::HttpRequest&, const String& content_type);
+    void did_receive_data();
+    void process_buffered_requests();
+    void handle_request(const HTTP::HttpRequest&);
+    bool is_not_modified(const FileCache::Entry&, const HTTP::HttpRequest&) const;
+    static bool accepts_gzip(const HTTP::HttpRequest&);
+    static String gzipped_etag(const String&);
+    void send_header(unsigned code, const StringView& reason, const String& content_type, Optional<size_t> content_length, const String& extra_headers = {});
+    void send_data(const String&);
+    void send_cached_response(const FileCache::Entry&, const HTTP::HttpRequest&);
+    void send_file_response(Core::File&, const FileCache::Entry&, const HTTP::HttpRequest&);
     void send_redirect(StringView redirect, const HTTP::HttpRequest& request);
     void send_error_response(unsigned code, const StringView& message, const HTTP::HttpRequest&);
+    void send_bad_request();
+    void flush_output();
+    bool has_pending_output() const { return !m_output.is_empty() || m_file; }
     void die();
     void log_response(unsigned code, const HTTP::HttpRequest&);
     void handle_directory_listing(const String& requested_path, const String& real_path, const HTTP::HttpRequest&);
+    static String render_directory_listing(const String& requested_path, const String& real_path);
 
     NonnullRefPtr<Core::TCPSocket> m_socket;
     String m_root_path;
+
+    ByteBuffer m_input;
+    // Headers and bodies waiting to be written, and how much of the first one already has been.
+    Vector<ByteBuffer> m_output;
+    size_t m_output_offset { 0 };
+    RefPtr<Core::File> m_file;
+    size_t m_file_remaining { 0 };
+
+    RefPtr<Core::Notifier> m_write_notifier;
+    RefPtr<Core::Timer> m_idle_timer;
+    bool m_keep_alive { true };
+    bool m_dead { false };
 };
 
 }
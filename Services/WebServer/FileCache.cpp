@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FileCache.h"
+#include <LibCompress/Gzip.h>
+#include <LibCore/File.h>
+#include <stdio.h>
+
+namespace WebServer {
+
+FileCache& FileCache::the()
+{
+    static FileCache* cache;
+    if (!cache)
+        cache = new FileCache;
+    return *cache;
+}
+
+String FileCache::etag_for(const struct stat& st)
+{
+    return String::format("\"%llx-%llx-%llx\"", (u64)st.st_ino, (u64)st.st_mtime, (u64)st.st_size);
+}
+
+String FileCache::http_date(time_t timestamp)
+{
+    struct tm tm;
+    gmtime_r(&timestamp, &tm);
+    char buffer[64];
+    strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buffer;
+}
+
+static String key_for(const struct stat& st)
+{
+    return String::format("%llu:%llu", (u64)st.st_dev, (u64)st.st_ino);
+}
+
+RefPtr<FileCache::Entry> FileCache::find(const String& key, const struct stat& st)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return nullptr;
+    auto& entry = it->value;
+    if (entry->modification_time != st.st_mtime || entry->size != st.st_size) {
+        m_memory_size -= entry->memory_size();
+        m_entries.remove(it);
+        return nullptr;
+    }
+    entry->last_used = ++m_use_counter;
+    return entry;
+}
+
+void FileCache::store(const String& key, NonnullRefPtr<Entry> entry)
+{
+    entry->last_used = ++m_use_counter;
+    if (auto it = m_entries.find(key); it != m_entries.end())
+        m_memory_size -= it->value->memory_size();
+    m_memory_size += entry->memory_size();
+    m_entries.set(key, move(entry));
+    evict_if_needed();
+}
+
+void FileCache::evict_if_needed()
+{
+    while (m_memory_size > max_memory_size) {
+        String least_recently_used;
+        u64 least_recently_used_time = 0;
+        for (auto& it : m_entries) {
+            if (least_recently_used.is_null() || it.value->last_used < least_recently_used_time) {
+                least_recently_used = it.key;
+                least_recently_used_time = it.value->last_used;
+            }
+        }
+        auto it = m_entries.find(least_recently_used);
+        m_memory_size -= (*it).value->memory_size();
+        m_entries.remove(it);
+    }
+}
+
+void FileCache::compress(Entry& entry)
+{
+    if (!entry.content_type.starts_with("text/") || entry.body.size() < 256)
+        return;
+    auto gzipped_body = Compress::Gzip::compress_all(entry.body, Compress::DeflateCompressor::CompressionLevel::Best);
+    // Not worth the client's time unless it saves a good chunk.
+    if (gzipped_body.has_value() && gzipped_body.value().size() < entry.body.size() * 9 / 10)
+        entry.gzipped_body = gzipped_body.release_value();
+}
+
+RefPtr<FileCache::Entry> FileCache::get_file(const String& path, const struct stat& st, const String& content_type)
+{
+    auto key = key_for(st);
+    if (auto entry = find(key, st))
+        return entry;
+
+    auto entry = adopt(*new Entry);
+    entry->device = st.st_dev;
+    entry->inode = st.st_ino;
+    entry->modification_time = st.st_mtime;
+    entry->size = st.st_size;
+    entry->created_time = time(nullptr);
+    entry->content_type = content_type;
+    entry->etag = etag_for(st);
+    entry->last_modified = http_date(st.st_mtime);
+
+    if ((size_t)st.st_size > max_file_size)
+        return entry;
+
+    auto file = Core::File::construct(path);
+    if (!file->open(Core::IODevice::ReadOnly))
+        return nullptr;
+    auto body = file->read_all();
+    // It changed while we were reading it, so don't remember it as the old version.
+    if (body.size() != (size_t)st.st_size)
+        return entry;
+    entry->body = move(body);
+    compress(entry);
+    store(key, entry);
+    return entry;
+}
+
+RefPtr<FileCache::Entry> FileCache::get_directory_listing(const struct stat& st, Function<String()> render)
+{
+    auto key = String::format("listing:%s", key_for(st).characters());
+    if (auto entry = find(key, st); entry && time(nullptr) - entry->created_time < max_directory_listing_age)
+        return entry;
+
+    auto entry = adopt(*new Entry);
+    entry->device = st.st_dev;
+    entry->inode = st.st_ino;
+    entry->modification_time = st.st_mtime;
+    entry->size = st.st_size;
+    entry->created_time = time(nullptr);
+    entry->content_type = "text/html";
+    auto html = render();
+    entry->body = ByteBuffer::copy(html.characters(), html.length());
+    compress(entry);
+    store(key, entry);
+    return entry;
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <AK/String.h>
+#include <sys/stat.h>
+#include <time.h>
+
+namespace WebServer {
+
+// Keeps small files and rendered directory listings in memory, along with their gzipped variants.
+// Entries are identified by device and inode, and thrown out as soon as the size or modification time changes.
+class FileCache {
+public:
+    struct Entry : public RefCounted<Entry> {
+        dev_t device { 0 };
+        ino_t inode { 0 };
+        time_t modification_time { 0 };
+        off_t size { 0 };
+        time_t created_time { 0 };
+        u64 last_used { 0 };
+
+        String content_type;
+        String etag;
+        String last_modified;
+
+        // Null if the file was too large to keep around, or doesn't compress.
+        ByteBuffer body;
+        ByteBuffer gzipped_body;
+
+        size_t memory_size() const { return body.size() + gzipped_body.size(); }
+    };
+
+    static FileCache& the();
+
+    // Always returns an entry with validators, but only small files get their contents cached.
+    RefPtr<Entry> get_file(const String& path, const struct stat&, const String& content_type);
+    RefPtr<Entry> get_directory_listing(const struct stat&, Function<String()> render);
+
+    static String etag_for(const struct stat&);
+    static String http_date(time_t);
+
+private:
+    static constexpr size_t max_file_size = 256 * KiB;
+    static constexpr size_t max_memory_size = 16 * MiB;
+    // Listings also show the sizes and dates of their entries, which don't touch the directory itself.
+    static constexpr time_t max_directory_listing_age = 5;
+
+    FileCache() { }
+
+    RefPtr<Entry> find(const String& key, const struct stat&);
+    void store(const String& key, NonnullRefPtr<Entry>);
+    void evict_if_needed();
+
+    static void compress(Entry&);
+
+    HashMap<String, NonnullRefPtr<Entry>> m_entries;
+    size_t m_memory_size { 0 };
+    u64 m_use_counter { 0 };
+};
+
+}
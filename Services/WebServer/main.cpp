@@ -39,9 +39,11 @@ int main(int argc, char** argv)
     const char* root_path = "/www";
 
     int port = default_port;
+    int worker_count = 1;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(port, "Port to listen on", "port", 'p', "port");
+    args_parser.add_option(worker_count, "Number of worker processes accepting connections", "workers", 'w', "count");
     args_parser.add_positional_argument(root_path, "Path to serve the contents of", "path", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
@@ -57,7 +59,12 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    if (pledge("stdio accept rpath inet unix cpath fattr", nullptr) < 0) {
+    if (worker_count < 1) {
+        printf("Warning: invalid worker count: %d\n", worker_count);
+        worker_count = 1;
+    }
+
+    if (pledge("stdio accept rpath inet unix cpath fattr proc", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
@@ -67,8 +74,10 @@ int main(int argc, char** argv)
     auto server = Core::TCPServer::construct();
 
     server->on_ready_to_accept = [&] {
+        // With several workers waiting on the same socket, another one may have beaten us to it.
         auto client_socket = server->accept();
-        ASSERT(client_socket);
+        if (!client_socket)
+            return;
         auto client = WebServer::Client::construct(client_socket.release_nonnull(), real_root_path, server);
         client->start();
     };
@@ -88,6 +97,17 @@ int main(int argc, char** argv)
 
     unveil(nullptr, nullptr);
 
+    // The workers share the listening socket, and each one serves its connections from its own event loop.
+    for (int i = 1; i < worker_count; ++i) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        if (pid == 0)
+            break;
+    }
+
     if (pledge("stdio accept rpath", nullptr) < 0) {
         perror("pledge");
         return 1;
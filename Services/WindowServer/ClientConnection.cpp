@@ -571,18 +571,7 @@ OwnPtr<Messages::WindowServer::SetWindowBackingStoreResponse> ClientConnection::
         return nullptr;
     }
     auto& window = *(*it).value;
-    if (window.last_backing_store() && window.last_backing_store()->shbuf_id() == message.shbuf_id()) {
-        window.swap_backing_stores();
-    } else {
-        auto shared_buffer = SharedBuffer::create_from_shbuf_id(message.shbuf_id());
-        if (!shared_buffer)
-            return make<Messages::WindowServer::SetWindowBackingStoreResponse>();
-        auto backing_store = Gfx::Bitmap::create_with_shared_buffer(
-            message.has_alpha_channel() ? Gfx::BitmapFormat::RGBA32 : Gfx::BitmapFormat::RGB32,
-            *shared_buffer,
-            message.size());
-        window.set_backing_store(move(backing_store));
-    }
+    set_window_backing_store(window, message.shbuf_id(), message.has_alpha_channel(), message.size());
 
     if (message.flush_immediately())
         window.invalidate(false);
@@ -590,6 +579,52 @@ OwnPtr<Messages::WindowServer::SetWindowBackingStoreResponse> ClientConnection::
     return make<Messages::WindowServer::SetWindowBackingStoreResponse>();
 }
 
+bool ClientConnection::set_window_backing_store(Window& window, int shbuf_id, bool has_alpha_channel, const Gfx::IntSize& size)
+{
+    auto format = has_alpha_channel ? Gfx::BitmapFormat::RGBA32 : Gfx::BitmapFormat::RGB32;
+    auto matches = [&](const Gfx::Bitmap& bitmap) {
+        return bitmap.shbuf_id() == shbuf_id && bitmap.format() == format && bitmap.size() == size;
+    };
+    if (window.backing_store() && matches(*window.backing_store()))
+        return true;
+
+    auto backing_store = window.take_recent_backing_store(shbuf_id);
+    if (!backing_store || !matches(*backing_store)) {
+        auto shared_buffer = SharedBuffer::create_from_shbuf_id(shbuf_id);
+        if (!shared_buffer)
+            return false;
+        backing_store = Gfx::Bitmap::create_with_shared_buffer(format, *shared_buffer, size);
+        if (!backing_store)
+            return false;
+    }
+    window.set_backing_store(move(backing_store));
+    return true;
+}
+
+void ClientConnection::handle(const Messages::WindowServer::PresentBackingStore& message)
+{
+    auto it = m_windows.find(message.window_id());
+    if (it == m_windows.end()) {
+        did_misbehave("PresentBackingStore: Bad window ID");
+        return;
+    }
+    auto& window = *(*it).value;
+    auto old_size = window.backing_store() ? window.backing_store()->size() : Gfx::IntSize();
+    if (set_window_backing_store(window, message.shbuf_id(), message.has_alpha_channel(), message.size())) {
+        // Only what the client says it painted has changed, unless the new backing store doesn't line up with the old one.
+        if (old_size != message.size()) {
+            window.invalidate(false);
+        } else {
+            for (auto& rect : message.rects())
+                window.invalidate(rect);
+        }
+    }
+
+    // Either way, the backing store that was shown before this one is no longer being read from.
+    post_message(Messages::WindowClient::BackingStorePresented(message.window_id(), message.shbuf_id()));
+    WindowSwitcher::the().refresh_if_needed();
+}
+
 OwnPtr<Messages::WindowServer::SetGlobalCursorTrackingResponse> ClientConnection::handle(const Messages::WindowServer::SetGlobalCursorTracking& message)
 {
     int window_id = message.window_id();
@@ -865,6 +900,16 @@ void ClientConnection::handle(const Messages::WindowServer::SetWindowProgress& m
     it->value->set_progress(message.progress());
 }
 
+void ClientConnection::handle(const Messages::WindowServer::SetWindowWantsMouseMoveHistory& message)
+{
+    auto it = m_windows.find(message.window_id());
+    if (it == m_windows.end()) {
+        did_misbehave("SetWindowWantsMouseMoveHistory with bad window ID");
+        return;
+    }
+    it->value->set_wants_mouse_move_history(message.wants_mouse_move_history());
+}
+
 void ClientConnection::handle(const Messages::WindowServer::Pong&)
 {
     m_ping_timer = nullptr;
@@ -90,6 +90,7 @@ private:
     virtual void did_become_responsive() override;
 
     void set_unresponsive(bool);
+    bool set_window_backing_store(Window&, int shbuf_id, bool has_alpha_channel, const Gfx::IntSize&);
     void destroy_window(Window&, Vector<i32>& destroyed_window_ids);
 
     virtual OwnPtr<Messages::WindowServer::GreetResponse> handle(const Messages::WindowServer::Greet&) override;
@@ -112,6 +113,7 @@ private:
     virtual OwnPtr<Messages::WindowServer::GetWindowRectInMenubarResponse> handle(const Messages::WindowServer::GetWindowRectInMenubar&) override;
     virtual void handle(const Messages::WindowServer::InvalidateRect&) override;
     virtual void handle(const Messages::WindowServer::DidFinishPainting&) override;
+    virtual void handle(const Messages::WindowServer::PresentBackingStore&) override;
     virtual OwnPtr<Messages::WindowServer::SetGlobalCursorTrackingResponse> handle(const Messages::WindowServer::SetGlobalCursorTracking&) override;
     virtual OwnPtr<Messages::WindowServer::SetWindowOpacityResponse> handle(const Messages::WindowServer::SetWindowOpacity&) override;
     virtual OwnPtr<Messages::WindowServer::SetWindowBackingStoreResponse> handle(const Messages::WindowServer::SetWindowBackingStore&) override;
@@ -142,6 +144,7 @@ private:
     virtual void handle(const Messages::WindowServer::EnableDisplayLink&) override;
     virtual void handle(const Messages::WindowServer::DisableDisplayLink&) override;
     virtual void handle(const Messages::WindowServer::SetWindowProgress&) override;
+    virtual void handle(const Messages::WindowServer::SetWindowWantsMouseMoveHistory&) override;
     virtual void handle(const Messages::WindowServer::Pong&) override;
 
     Window* window_from_id(i32 window_id);
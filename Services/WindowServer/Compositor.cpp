@@ -33,10 +33,12 @@
 #include "WindowManager.h"
 #include <AK/Memory.h>
 #include <AK/ScopeGuard.h>
+#include <LibCore/Notifier.h>
 #include <LibCore/Timer.h>
 #include <LibGfx/Font.h>
 #include <LibGfx/Painter.h>
 #include <LibThread/BackgroundAction.h>
+#include <unistd.h>
 
 //#define COMPOSE_DEBUG
 //#define OCCLUSIONS_DEBUG
@@ -84,10 +86,40 @@ Compositor::Compositor()
         },
         this);
 
+    // NOTE: The notifier is only enabled while there's something to compose, or display links to notify.
+    m_vblank_notifier = Core::Notifier::construct(Screen::the().framebuffer_fd(), Core::Notifier::Read, this);
+    m_vblank_notifier->on_ready_to_read = [this] {
+        did_vblank();
+    };
+    m_vblank_notifier->set_enabled(false);
+
     m_screen_can_set_buffer = Screen::the().can_set_buffer();
     init_bitmaps();
 }
 
+void Compositor::did_vblank()
+{
+    u64 vblank_count;
+    if (read(m_vblank_notifier->fd(), &vblank_count, sizeof(vblank_count)) != sizeof(vblank_count)) {
+        perror("read(vblank)");
+        dbg() << "Compositor: Framebuffer doesn't report vertical blanking, falling back to timers";
+        m_vblank_notifier->set_enabled(false);
+        m_vblank_notifier = nullptr;
+        if (m_display_link_count)
+            m_display_link_notify_timer->start();
+        if (m_invalidated_any)
+            start_compose_async_timer();
+        return;
+    }
+
+    // Compose first, so that clients woken up by their display links get a whole frame to draw the next one.
+    compose();
+    if (m_display_link_count)
+        notify_display_links();
+    else if (!m_invalidated_any)
+        m_vblank_notifier->set_enabled(false);
+}
+
 void Compositor::init_bitmaps()
 {
     auto& screen = Screen::the();
@@ -138,6 +170,11 @@ void Compositor::compose()
 
     // Mark window regions as dirty that need to be re-rendered
     wm.for_each_visible_window_from_back_to_front([&](Window& window) {
+        // Nothing of an occluded window ends up on screen, so there's no need to track its damage.
+        if (window.is_occluded()) {
+            window.clear_dirty_rects();
+            return IterationDecision::Continue;
+        }
         auto frame_rect = window.frame().rect();
         for (auto& dirty_rect : dirty_screen_rects.rects()) {
             auto invalidate_rect = dirty_rect.intersected(frame_rect);
@@ -254,11 +291,10 @@ void Compositor::compose()
             } else if (m_wallpaper_mode == WallpaperMode::Tile) {
                 painter.draw_tiled_bitmap(rect, *m_wallpaper);
             } else if (m_wallpaper_mode == WallpaperMode::Scaled) {
-                float hscale = (float)m_wallpaper->size().width() / (float)ws.size().width();
-                float vscale = (float)m_wallpaper->size().height() / (float)ws.size().height();
-
-                // TODO: this may look ugly, we should scale to a backing bitmap and then blit
-                painter.blit_scaled(rect, *m_wallpaper, rect, hscale, vscale);
+                if (!m_scaled_wallpaper || m_scaled_wallpaper->size() != ws.size())
+                    m_scaled_wallpaper = m_wallpaper->scaled(ws.size(), Gfx::ScalingMode::BilinearBlend);
+                if (m_scaled_wallpaper)
+                    painter.blit(rect.location(), *m_scaled_wallpaper, rect);
             } else {
                 ASSERT_NOT_REACHED();
             }
@@ -278,7 +314,6 @@ void Compositor::compose()
         auto frame_rect = window.frame().rect();
         if (!frame_rect.intersects(ws.rect()))
             return IterationDecision::Continue;
-        auto frame_rects = frame_rect.shatter(window.rect());
 
 #ifdef COMPOSE_DEBUG
         dbg() << "  window " << window.title() << " frame rect: " << frame_rect;
@@ -286,18 +321,8 @@ void Compositor::compose()
 
         RefPtr<Gfx::Bitmap> backing_store = window.backing_store();
         auto compose_window_rect = [&](Gfx::Painter& painter, const Gfx::IntRect& rect) {
-            if (!window.is_fullscreen()) {
-                rect.for_each_intersected(frame_rects, [&](const Gfx::IntRect& intersected_rect) {
-                    // TODO: Should optimize this to use a backing buffer
-                    Gfx::PainterStateSaver saver(painter);
-                    painter.add_clip_rect(intersected_rect);
-#ifdef COMPOSE_DEBUG
-                    dbg() << "    render frame: " << intersected_rect;
-#endif                    
-                    window.frame().paint(painter);
-                    return IterationDecision::Continue;
-                });
-            }
+            if (!window.is_fullscreen())
+                window.frame().paint(painter, rect);
 
             if (!backing_store) {
                 if (window.is_opaque())
@@ -512,14 +537,22 @@ void Compositor::compose()
         flush(rect);
 }
 
+static void copy_rect(Gfx::Bitmap& to, const Gfx::Bitmap& from, const Gfx::IntRect& rect)
+{
+    Gfx::RGBA32* to_ptr = to.scanline(rect.y()) + rect.x();
+    const Gfx::RGBA32* from_ptr = from.scanline(rect.y()) + rect.x();
+
+    for (int y = 0; y < rect.height(); ++y) {
+        fast_u32_copy(to_ptr, from_ptr, rect.width());
+        from_ptr = (const Gfx::RGBA32*)((const u8*)from_ptr + from.pitch());
+        to_ptr = (Gfx::RGBA32*)((u8*)to_ptr + to.pitch());
+    }
+}
+
 void Compositor::flush(const Gfx::IntRect& a_rect)
 {
     auto rect = Gfx::IntRect::intersection(a_rect, Screen::the().rect());
 
-    Gfx::RGBA32* front_ptr = m_front_bitmap->scanline(rect.y()) + rect.x();
-    Gfx::RGBA32* back_ptr = m_back_bitmap->scanline(rect.y()) + rect.x();
-    size_t pitch = m_back_bitmap->pitch();
-
     // NOTE: The meaning of a flush depends on whether we can flip buffers or not.
     //
     //       If flipping is supported, flushing means that we've flipped, and now we
@@ -529,22 +562,10 @@ void Compositor::flush(const Gfx::IntRect& a_rect)
     //       If flipping is not supported, flushing means that we copy the changed
     //       rects from the backing bitmap to the display framebuffer.
 
-    Gfx::RGBA32* to_ptr;
-    const Gfx::RGBA32* from_ptr;
-
-    if (m_screen_can_set_buffer) {
-        to_ptr = back_ptr;
-        from_ptr = front_ptr;
-    } else {
-        to_ptr = front_ptr;
-        from_ptr = back_ptr;
-    }
-
-    for (int y = 0; y < rect.height(); ++y) {
-        fast_u32_copy(to_ptr, from_ptr, rect.width());
-        from_ptr = (const Gfx::RGBA32*)((const u8*)from_ptr + pitch);
-        to_ptr = (Gfx::RGBA32*)((u8*)to_ptr + pitch);
-    }
+    if (m_screen_can_set_buffer)
+        copy_rect(*m_back_bitmap, *m_front_bitmap, rect);
+    else
+        copy_rect(*m_front_bitmap, *m_back_bitmap, rect);
 }
 
 void Compositor::invalidate_screen()
@@ -576,6 +597,12 @@ void Compositor::invalidate_window()
 
 void Compositor::start_compose_async_timer()
 {
+    if (m_vblank_notifier) {
+        // Compose at the next vertical blank, so that we neither tear nor draw frames that never get shown.
+        m_vblank_notifier->set_enabled(true);
+        return;
+    }
+
     // We delay composition by a timer interval, but to not affect latency too
     // much, if a pending compose is not already scheduled, we also schedule an
     // immediate compose the next spin of the event loop.
@@ -621,6 +648,7 @@ bool Compositor::set_wallpaper(const String& path, Function<void(bool)>&& callba
         [this, path, callback = move(callback)](RefPtr<Gfx::Bitmap> bitmap) {
             m_wallpaper_path = path;
             m_wallpaper = move(bitmap);
+            m_scaled_wallpaper = nullptr;
             invalidate_screen();
             callback(true);
         });
@@ -704,11 +732,37 @@ void Compositor::invalidate_cursor()
     if (m_invalidated_cursor)
         return;
     m_invalidated_cursor = true;
-    m_invalidated_any = true;
 
+    // If nothing else needs to be composed, the cursor can be moved on its own. This is deferred
+    // so that a burst of mouse packets only moves it once.
+    if (!m_invalidated_any && m_cursor_back_bitmap && !WindowManager::the().dnd_client()) {
+        deferred_invoke([this](auto&) {
+            if (m_invalidated_cursor && !m_invalidated_any)
+                update_cursor();
+        });
+        return;
+    }
+
+    m_invalidated_any = true;
     start_compose_async_timer();
 }
 
+void Compositor::update_cursor()
+{
+    m_invalidated_cursor = false;
+
+    auto screen_rect = Screen::the().rect();
+    auto last_cursor_rect = m_last_cursor_rect;
+    auto cursor_rect = current_cursor_rect();
+    restore_cursor_back();
+    draw_cursor(cursor_rect);
+
+    // Both buffers are in sync after every compose, so whatever was drawn into the back buffer
+    // can go straight to the front one, without flipping.
+    copy_rect(*m_front_bitmap, *m_back_bitmap, last_cursor_rect.intersected(screen_rect));
+    copy_rect(*m_front_bitmap, *m_back_bitmap, cursor_rect.intersected(screen_rect));
+}
+
 bool Compositor::draw_geometry_label(Gfx::IntRect& geometry_label_rect)
 {
     auto& wm = WindowManager::the();
@@ -767,7 +821,11 @@ void Compositor::notify_display_links()
 void Compositor::increment_display_link_count(Badge<ClientConnection>)
 {
     ++m_display_link_count;
-    if (m_display_link_count == 1)
+    if (m_display_link_count != 1)
+        return;
+    if (m_vblank_notifier)
+        m_vblank_notifier->set_enabled(true);
+    else
         m_display_link_notify_timer->start();
 }
 
@@ -82,12 +82,17 @@ private:
     void run_animations(Gfx::DisjointRectSet&);
     void notify_display_links();
     void start_compose_async_timer();
+    void did_vblank();
     void recompute_occlusions();
     bool any_opaque_window_above_this_one_contains_rect(const Window&, const Gfx::IntRect&);
     void draw_cursor(const Gfx::IntRect&);
     void restore_cursor_back();
+    void update_cursor();
     bool draw_geometry_label(Gfx::IntRect&);
 
+    // Composing and display links are driven by the screen's vertical blank. The timers are only used
+    // if the framebuffer can't tell us about those.
+    RefPtr<Core::Notifier> m_vblank_notifier;
     RefPtr<Core::Timer> m_compose_timer;
     RefPtr<Core::Timer> m_immediate_compose_timer;
     bool m_flash_flush { false };
@@ -117,6 +122,7 @@ private:
     String m_wallpaper_path;
     WallpaperMode m_wallpaper_mode { WallpaperMode::Unchecked };
     RefPtr<Gfx::Bitmap> m_wallpaper;
+    RefPtr<Gfx::Bitmap> m_scaled_wallpaper;
 
     RefPtr<Core::Timer> m_display_link_notify_timer;
     size_t m_display_link_count { 0 };
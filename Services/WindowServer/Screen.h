@@ -41,6 +41,8 @@ public:
     ~Screen();
 
     bool set_resolution(int width, int height);
+    int framebuffer_fd() const { return m_framebuffer_fd; }
+
     bool can_set_buffer() { return m_can_set_buffer; }
     void set_buffer(int index);
 
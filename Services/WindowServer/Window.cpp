@@ -132,6 +132,25 @@ void Window::destroy()
     set_visible(false);
 }
 
+void Window::set_backing_store(RefPtr<Gfx::Bitmap>&& backing_store)
+{
+    if (m_backing_store && m_backing_store != backing_store) {
+        if (m_recent_backing_stores.size() == max_recent_backing_stores)
+            m_recent_backing_stores.take_last();
+        m_recent_backing_stores.prepend(m_backing_store.release_nonnull());
+    }
+    m_backing_store = move(backing_store);
+}
+
+RefPtr<Gfx::Bitmap> Window::take_recent_backing_store(int shbuf_id)
+{
+    for (size_t i = 0; i < m_recent_backing_stores.size(); ++i) {
+        if (m_recent_backing_stores[i]->shbuf_id() == shbuf_id)
+            return m_recent_backing_stores.take(i);
+    }
+    return nullptr;
+}
+
 void Window::set_title(const String& title)
 {
     if (m_title == title)
@@ -181,9 +200,13 @@ void Window::handle_mouse_event(const MouseEvent& event)
     set_automatic_cursor_tracking_enabled(event.buttons() != 0);
 
     switch (event.type()) {
-    case Event::MouseMove:
-        m_client->post_message(Messages::WindowClient::MouseMove(m_window_id, event.position(), (u32)event.button(), event.buttons(), event.modifiers(), event.wheel_delta(), event.is_drag(), event.drag_data_type()));
+    case Event::MouseMove: {
+        Vector<Gfx::IntPoint> mouse_position_history;
+        if (m_wants_mouse_move_history)
+            mouse_position_history.append(event.position());
+        m_client->post_message(Messages::WindowClient::MouseMove(m_window_id, event.position(), (u32)event.button(), event.buttons(), event.modifiers(), event.wheel_delta(), event.is_drag(), event.drag_data_type(), mouse_position_history));
         break;
+    }
     case Event::MouseDown:
         m_client->post_message(Messages::WindowClient::MouseDown(m_window_id, event.position(), (u32)event.button(), event.buttons(), event.modifiers(), event.wheel_delta()));
         break;
@@ -184,18 +184,9 @@ public:
     const Gfx::Bitmap* backing_store() const { return m_backing_store.ptr(); }
     Gfx::Bitmap* backing_store() { return m_backing_store.ptr(); }
 
-    void set_backing_store(RefPtr<Gfx::Bitmap>&& backing_store)
-    {
-        m_last_backing_store = move(m_backing_store);
-        m_backing_store = move(backing_store);
-    }
-
-    void swap_backing_stores()
-    {
-        swap(m_backing_store, m_last_backing_store);
-    }
-
-    Gfx::Bitmap* last_backing_store() { return m_last_backing_store.ptr(); }
+    void set_backing_store(RefPtr<Gfx::Bitmap>&&);
+    // Clients cycle through a few backing stores, so the ones they used last are kept mapped until they come back.
+    RefPtr<Gfx::Bitmap> take_recent_backing_store(int shbuf_id);
 
     void set_global_cursor_tracking_enabled(bool);
     void set_automatic_cursor_tracking_enabled(bool enabled) { m_automatic_cursor_tracking_enabled = enabled; }
@@ -264,6 +255,9 @@ public:
     int progress() const { return m_progress; }
     void set_progress(int);
 
+    bool wants_mouse_move_history() const { return m_wants_mouse_move_history; }
+    void set_wants_mouse_move_history(bool wants) { m_wants_mouse_move_history = wants; }
+
     bool is_destroyed() const { return m_destroyed; }
     void destroy();
 
@@ -332,8 +326,10 @@ private:
     WindowTileType m_tiled { WindowTileType::None };
     Gfx::IntRect m_untiled_rect;
     bool m_occluded { false };
+    bool m_wants_mouse_move_history { false };
     RefPtr<Gfx::Bitmap> m_backing_store;
-    RefPtr<Gfx::Bitmap> m_last_backing_store;
+    static constexpr size_t max_recent_backing_stores = 2;
+    Vector<NonnullRefPtr<Gfx::Bitmap>, max_recent_backing_stores> m_recent_backing_stores;
     int m_window_id { -1 };
     i32 m_client_id { -1 };
     float m_opacity { 1 };
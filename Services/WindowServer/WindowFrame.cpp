@@ -26,6 +26,7 @@
 
 #include "ClientConnection.h"
 #include <AK/Badge.h>
+#include <LibGfx/Bitmap.h>
 #include <LibGfx/Font.h>
 #include <LibGfx/Painter.h>
 #include <LibGfx/StylePainter.h>
@@ -134,12 +135,14 @@ void WindowFrame::set_button_icons()
         m_maximize_button->set_icon(m_window.is_maximized() ? *s_restore_icon : *s_maximize_icon);
 
     s_last_title_button_icons_path = icons_path;
+    set_dirty();
 }
 
 void WindowFrame::did_set_maximized(Badge<Window>, bool maximized)
 {
     ASSERT(m_maximize_button);
     m_maximize_button->set_icon(maximized ? *s_restore_icon : *s_maximize_icon);
+    set_dirty();
 }
 
 Gfx::IntRect WindowFrame::title_bar_rect() const
@@ -193,14 +196,8 @@ void WindowFrame::paint_normal_frame(Gfx::Painter& painter)
     Gfx::WindowTheme::current().paint_normal_frame(painter, window_state_for_theme(), m_window.rect(), title_text, m_window.icon(), palette, leftmost_button_rect);
 }
 
-void WindowFrame::paint(Gfx::Painter& painter)
+void WindowFrame::render(Gfx::Painter& painter)
 {
-    if (m_window.is_frameless())
-        return;
-
-    Gfx::PainterStateSaver saver(painter);
-    painter.translate(rect().location());
-
     if (m_window.type() == WindowType::Notification)
         paint_notification_frame(painter);
     else if (m_window.type() == WindowType::Normal)
@@ -213,6 +210,82 @@ void WindowFrame::paint(Gfx::Painter& painter)
     }
 }
 
+void WindowFrame::render_to_cache()
+{
+    auto frame_rect = rect();
+    auto window_rect = m_window.rect();
+    auto window_state = window_state_for_theme();
+    bool is_unresponsive = m_window.client() && m_window.client()->is_unresponsive();
+    if (!m_dirty && m_cached_size == frame_rect.size() && m_cached_window_state == window_state && m_cached_unresponsive == is_unresponsive)
+        return;
+    m_dirty = false;
+    m_cached_size = frame_rect.size();
+    m_cached_window_state = window_state;
+    m_cached_unresponsive = is_unresponsive;
+
+    int top = window_rect.top() - frame_rect.top();
+    int bottom = frame_rect.bottom() - window_rect.bottom();
+    int left = window_rect.left() - frame_rect.left();
+    int right = frame_rect.right() - window_rect.right();
+
+    auto ensure_bitmap = [](RefPtr<Gfx::Bitmap>& bitmap, const Gfx::IntSize& size) {
+        if (size.is_empty())
+            bitmap = nullptr;
+        else if (!bitmap || bitmap->size() != size)
+            bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, size);
+    };
+    ensure_bitmap(m_top_bottom, { frame_rect.width(), top + bottom });
+    ensure_bitmap(m_left_right, { left + right, window_rect.height() });
+
+    // Renders the part of the frame at stripe_rect (relative to the frame) into the bitmap at location.
+    auto render_stripe = [&](Gfx::Bitmap& bitmap, const Gfx::IntRect& stripe_rect, const Gfx::IntPoint& location) {
+        if (stripe_rect.is_empty())
+            return;
+        Gfx::Painter painter(bitmap);
+        painter.add_clip_rect({ location, stripe_rect.size() });
+        painter.translate(location - stripe_rect.location());
+        render(painter);
+    };
+
+    if (m_top_bottom) {
+        render_stripe(*m_top_bottom, { 0, 0, frame_rect.width(), top }, { 0, 0 });
+        render_stripe(*m_top_bottom, { 0, frame_rect.height() - bottom, frame_rect.width(), bottom }, { 0, top });
+    }
+    if (m_left_right) {
+        render_stripe(*m_left_right, { 0, top, left, window_rect.height() }, { 0, 0 });
+        render_stripe(*m_left_right, { frame_rect.width() - right, top, right, window_rect.height() }, { left, 0 });
+    }
+}
+
+void WindowFrame::paint(Gfx::Painter& painter, const Gfx::IntRect& dirty_rect)
+{
+    if (m_window.is_frameless())
+        return;
+
+    render_to_cache();
+
+    auto frame_rect = rect();
+    auto window_rect = m_window.rect();
+    int top = window_rect.top() - frame_rect.top();
+    int bottom = frame_rect.bottom() - window_rect.bottom();
+    int left = window_rect.left() - frame_rect.left();
+    int right = frame_rect.right() - window_rect.right();
+
+    auto blit_stripe = [&](const Gfx::Bitmap* bitmap, const Gfx::IntRect& stripe_rect, const Gfx::IntPoint& location) {
+        if (!bitmap)
+            return;
+        auto rect = stripe_rect.intersected(dirty_rect);
+        if (rect.is_empty())
+            return;
+        painter.blit(rect.location(), *bitmap, rect.translated(location - stripe_rect.location()));
+    };
+
+    blit_stripe(m_top_bottom, { frame_rect.x(), frame_rect.y(), frame_rect.width(), top }, { 0, 0 });
+    blit_stripe(m_top_bottom, { frame_rect.x(), window_rect.bottom() + 1, frame_rect.width(), bottom }, { 0, top });
+    blit_stripe(m_left_right, { frame_rect.x(), window_rect.y(), left, window_rect.height() }, { 0, 0 });
+    blit_stripe(m_left_right, { window_rect.right() + 1, window_rect.y(), right, window_rect.height() }, { left, 0 });
+}
+
 static Gfx::IntRect frame_rect_for_window(Window& window, const Gfx::IntRect& rect)
 {
     if (window.is_frameless())
@@ -237,6 +310,7 @@ void WindowFrame::invalidate_title_bar()
 
 void WindowFrame::invalidate(Gfx::IntRect relative_rect)
 {
+    set_dirty();
     auto frame_rect = rect();
     auto window_rect = m_window.rect();
     relative_rect.move_by(frame_rect.x() - window_rect.x(), frame_rect.y() - window_rect.y());
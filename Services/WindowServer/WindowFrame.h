@@ -28,6 +28,7 @@
 
 #include <AK/Forward.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <AK/RefPtr.h>
 #include <LibGfx/Forward.h>
 #include <LibGfx/WindowTheme.h>
 
@@ -43,7 +44,8 @@ public:
     ~WindowFrame();
 
     Gfx::IntRect rect() const;
-    void paint(Gfx::Painter&);
+    // Paints the part of the frame that intersects the given screen rect, from a cached rendering of it.
+    void paint(Gfx::Painter&, const Gfx::IntRect&);
     void on_mouse_event(const MouseEvent&);
     void notify_window_rect_changed(const Gfx::IntRect& old_rect, const Gfx::IntRect& new_rect);
     void invalidate_title_bar();
@@ -58,7 +60,12 @@ public:
     void layout_buttons();
     void set_button_icons();
 
+    // Forces the cached frame to be rendered again the next time it's painted.
+    void set_dirty() { m_dirty = true; }
+
 private:
+    void render(Gfx::Painter&);
+    void render_to_cache();
     void paint_notification_frame(Gfx::Painter&);
     void paint_normal_frame(Gfx::Painter&);
 
@@ -69,6 +76,15 @@ private:
     Button* m_close_button { nullptr };
     Button* m_maximize_button { nullptr };
     Button* m_minimize_button { nullptr };
+
+    // The top and bottom edges of the frame are cached stacked on top of each other,
+    // and the left and right ones next to each other, so the window contents don't take up any space.
+    RefPtr<Gfx::Bitmap> m_top_bottom;
+    RefPtr<Gfx::Bitmap> m_left_right;
+    Gfx::IntSize m_cached_size;
+    Gfx::WindowTheme::WindowState m_cached_window_state { Gfx::WindowTheme::WindowState::Inactive };
+    bool m_cached_unresponsive { false };
+    bool m_dirty { true };
 };
 
 }
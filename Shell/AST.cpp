@@ -882,6 +882,14 @@ RefPtr<Value> Glob::run(RefPtr<Shell>)
     return create<GlobValue>(m_text);
 }
 
+void Glob::for_each_entry(RefPtr<Shell> shell, Function<IterationDecision(RefPtr<Value>)> callback)
+{
+    // Hand out matches as they are found instead of waiting for the whole expansion.
+    Shell::for_each_glob_match(m_text, shell->cwd, [&](String path) {
+        return callback(create<StringValue>(move(path)));
+    });
+}
+
 void Glob::highlight_in_editor(Line::Editor& editor, Shell&, HighlightMetadata metadata)
 {
     Line::Style style { Line::Style::Foreground(Line::Style::XtermColor::Cyan) };
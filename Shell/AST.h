@@ -641,6 +641,7 @@ public:
     Glob(Position, String);
     virtual ~Glob();
     const String& text() const { return m_text; }
+    virtual void for_each_entry(RefPtr<Shell> shell, Function<IterationDecision(RefPtr<Value>)> callback) override;
 
 private:
     virtual void dump(int level) const override;
@@ -26,10 +26,18 @@
 
 #include "Shell.h"
 #include <AK/LexicalPath.h>
+#include <AK/ScopeGuard.h>
+#include <AK/StringBuilder.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/File.h>
+#include <ctype.h>
+#include <errno.h>
 #include <inttypes.h>
 #include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -514,6 +522,268 @@ int Shell::builtin_popd(int argc, const char** argv)
     return 0;
 }
 
+// Appends the character that a backslash escape stands for, and returns how many characters
+// of the escape (not counting the backslash) were used up.
+static size_t append_escape(StringBuilder& builder, const StringView& escape, bool& stop_output)
+{
+    if (escape.is_empty()) {
+        builder.append('\\');
+        return 0;
+    }
+
+    switch (escape[0]) {
+    case 'a':
+        builder.append('\a');
+        return 1;
+    case 'b':
+        builder.append('\b');
+        return 1;
+    case 'c':
+        stop_output = true;
+        return 1;
+    case 'e':
+        builder.append('\033');
+        return 1;
+    case 'f':
+        builder.append('\f');
+        return 1;
+    case 'n':
+        builder.append('\n');
+        return 1;
+    case 'r':
+        builder.append('\r');
+        return 1;
+    case 't':
+        builder.append('\t');
+        return 1;
+    case 'v':
+        builder.append('\v');
+        return 1;
+    case '\\':
+        builder.append('\\');
+        return 1;
+    default:
+        break;
+    }
+
+    if (escape[0] >= '0' && escape[0] <= '7') {
+        // Up to three octal digits, after an optional leading zero.
+        size_t i = escape[0] == '0' ? 1 : 0;
+        size_t end = min(escape.length(), i + 3);
+        u8 value = 0;
+        for (; i < end && escape[i] >= '0' && escape[i] <= '7'; ++i)
+            value = value * 8 + escape[i] - '0';
+        builder.append((char)value);
+        return i;
+    }
+
+    builder.append('\\');
+    return 0;
+}
+
+static void append_padded(StringBuilder& builder, const StringView& text, int width, bool left_align, char padding = ' ')
+{
+    int padding_length = max(width - (int)text.length(), 0);
+    if (left_align) {
+        builder.append(text);
+        for (int i = 0; i < padding_length; ++i)
+            builder.append(' ');
+        return;
+    }
+    // Zeroes go between the sign and the digits.
+    size_t sign_length = padding == '0' && !text.is_empty() && (text[0] == '-' || text[0] == '+') ? 1 : 0;
+    builder.append(text.substring_view(0, sign_length));
+    for (int i = 0; i < padding_length; ++i)
+        builder.append(padding);
+    builder.append(text.substring_view(sign_length, text.length() - sign_length));
+}
+
+int Shell::builtin_printf(int argc, const char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: printf format [arguments...]\n");
+        return 1;
+    }
+
+    StringView format = argv[1];
+    int next_argument = 2;
+    bool failed = false;
+    bool stop_output = false;
+    StringBuilder builder;
+
+    auto take_argument = [&]() -> StringView {
+        if (next_argument < argc)
+            return argv[next_argument++];
+        return "";
+    };
+    auto take_number = [&]() -> i64 {
+        auto argument = take_argument();
+        if (argument.is_empty())
+            return 0;
+        // A leading quote gives the value of the character after it.
+        if (argument[0] == '\'' || argument[0] == '"')
+            return argument.length() > 1 ? (u8)argument[1] : 0;
+        String string = argument;
+        char* end = nullptr;
+        errno = 0;
+        i64 value = strtoll(string.characters(), &end, 0);
+        if (errno || *end) {
+            // Too large to be signed, but it may still fit unsigned.
+            errno = 0;
+            value = strtoull(string.characters(), &end, 0);
+        }
+        if (errno || *end) {
+            fprintf(stderr, "printf: %s: Expected a numeric value\n", string.characters());
+            failed = true;
+        }
+        return value;
+    };
+
+    // The format is reused for as long as there are arguments left for it.
+    do {
+        int arguments_before = next_argument;
+        for (size_t i = 0; i < format.length() && !stop_output; ++i) {
+            char ch = format[i];
+            if (ch == '\\') {
+                i += append_escape(builder, format.substring_view(i + 1, format.length() - i - 1), stop_output);
+                continue;
+            }
+            if (ch != '%') {
+                builder.append(ch);
+                continue;
+            }
+            if (i + 1 < format.length() && format[i + 1] == '%') {
+                builder.append('%');
+                ++i;
+                continue;
+            }
+
+            bool left_align = false;
+            bool always_sign = false;
+            bool space_sign = false;
+            bool alternate_form = false;
+            bool zero_pad = false;
+            for (++i; i < format.length(); ++i) {
+                if (format[i] == '-')
+                    left_align = true;
+                else if (format[i] == '+')
+                    always_sign = true;
+                else if (format[i] == ' ')
+                    space_sign = true;
+                else if (format[i] == '#')
+                    alternate_form = true;
+                else if (format[i] == '0')
+                    zero_pad = true;
+                else
+                    break;
+            }
+
+            auto read_count = [&]() -> int {
+                if (i < format.length() && format[i] == '*') {
+                    ++i;
+                    return take_number();
+                }
+                int count = 0;
+                for (; i < format.length() && isdigit(format[i]); ++i)
+                    count = count * 10 + format[i] - '0';
+                return count;
+            };
+            int width = read_count();
+            if (width < 0) {
+                left_align = true;
+                width = -width;
+            }
+            Optional<int> precision;
+            if (i < format.length() && format[i] == '.') {
+                ++i;
+                precision = max(read_count(), 0);
+            }
+
+            if (i >= format.length()) {
+                fprintf(stderr, "printf: Missing conversion at the end of the format\n");
+                return 1;
+            }
+
+            char conversion = format[i];
+            switch (conversion) {
+            case 's':
+            case 'b': {
+                auto argument = take_argument();
+                String text = argument;
+                if (conversion == 'b') {
+                    StringBuilder escaped;
+                    for (size_t j = 0; j < argument.length() && !stop_output; ++j) {
+                        if (argument[j] == '\\')
+                            j += append_escape(escaped, argument.substring_view(j + 1, argument.length() - j - 1), stop_output);
+                        else
+                            escaped.append(argument[j]);
+                    }
+                    text = escaped.to_string();
+                }
+                if (precision.has_value() && (size_t)precision.value() < text.length())
+                    text = text.substring(0, precision.value());
+                append_padded(builder, text, width, left_align);
+                break;
+            }
+            case 'c': {
+                auto argument = take_argument();
+                append_padded(builder, argument.substring_view(0, min<size_t>(argument.length(), 1)), width, left_align);
+                break;
+            }
+            case 'd':
+            case 'i':
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X': {
+                i64 value = take_number();
+                bool is_signed = conversion == 'd' || conversion == 'i';
+                bool is_negative = is_signed && value < 0;
+                u64 magnitude = is_negative ? -(u64)value : (u64)value;
+                unsigned base = conversion == 'o' ? 8 : (conversion == 'x' || conversion == 'X') ? 16 : 10;
+                const char* digits = conversion == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+
+                char buffer[32];
+                size_t length = 0;
+                do {
+                    buffer[length++] = digits[magnitude % base];
+                    magnitude /= base;
+                } while (magnitude);
+                if (precision.has_value() && precision.value() == 0 && value == 0)
+                    length = 0;
+
+                StringBuilder number;
+                if (is_negative)
+                    number.append('-');
+                else if (is_signed && always_sign)
+                    number.append('+');
+                else if (is_signed && space_sign)
+                    number.append(' ');
+                if (alternate_form && value != 0 && base == 16)
+                    number.append(conversion == 'X' ? "0X" : "0x");
+                else if (alternate_form && base == 8 && (!length || buffer[length - 1] != '0'))
+                    number.append('0');
+                for (int j = length; j < precision.value_or(0); ++j)
+                    number.append('0');
+                while (length)
+                    number.append(buffer[--length]);
+                append_padded(builder, number.to_string(), width, left_align, zero_pad && !precision.has_value() ? '0' : ' ');
+                break;
+            }
+            default:
+                fprintf(stderr, "printf: %%%c: Invalid conversion\n", conversion);
+                return 1;
+            }
+        }
+        // Without conversions to use up the arguments, there's no point in going around again.
+        if (next_argument == arguments_before)
+            break;
+    } while (next_argument < argc && !stop_output);
+
+    fwrite(builder.string_view().characters_without_null_termination(), 1, builder.length(), stdout);
+    return failed ? 1 : 0;
+}
+
 int Shell::builtin_pushd(int argc, const char** argv)
 {
     StringBuilder path_builder;
@@ -751,12 +1021,192 @@ int Shell::builtin_unset(int argc, const char** argv)
             unset_local_variable(value);
         } else {
             unsetenv(value);
+            if (StringView { value } == "PATH")
+                cache_path();
         }
     }
 
     return 0;
 }
 
+// The programs take options through Core::ArgsParser, which finds them anywhere on the command line.
+static bool looks_like_option(const char* argument)
+{
+    return argument[0] == '-' && argument[1];
+}
+
+Optional<int> Shell::builtin_basename(int argc, const char** argv)
+{
+    if (argc != 2 || looks_like_option(argv[1]))
+        return {};
+
+    printf("%s\n", LexicalPath(argv[1]).basename().characters());
+    return 0;
+}
+
+Optional<int> Shell::builtin_bracket(int argc, const char** argv)
+{
+    // Leave complaining about the missing bracket to the program.
+    if (argc < 2 || StringView { argv[argc - 1] } != "]")
+        return {};
+
+    return run_test_builtin(argc - 1, argv);
+}
+
+Optional<int> Shell::builtin_dirname(int argc, const char** argv)
+{
+    if (argc != 2 || looks_like_option(argv[1]))
+        return {};
+
+    printf("%s\n", LexicalPath(argv[1]).dirname().characters());
+    return 0;
+}
+
+Optional<int> Shell::builtin_echo(int argc, const char** argv)
+{
+    bool no_trailing_newline = false;
+    Vector<const char*> values;
+    for (int i = 1; i < argc; ++i) {
+        if (StringView { argv[i] } == "-n")
+            no_trailing_newline = true;
+        else if (looks_like_option(argv[i]))
+            return {};
+        else
+            values.append(argv[i]);
+    }
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        fputs(values[i], stdout);
+        if (i != values.size() - 1)
+            fputc(' ', stdout);
+    }
+    if (!no_trailing_newline)
+        fputc('\n', stdout);
+    return 0;
+}
+
+Optional<int> Shell::builtin_false(int, const char**)
+{
+    return 1;
+}
+
+Optional<int> Shell::builtin_test(int argc, const char** argv)
+{
+    return run_test_builtin(argc, argv);
+}
+
+Optional<int> Shell::builtin_true(int, const char**)
+{
+    return 0;
+}
+
+// Evaluates the simple forms of test(1): a single string, a unary operator and its operand,
+// or two operands and a binary string or integer comparison between them.
+Optional<int> Shell::run_test_builtin(int argc, const char** argv)
+{
+    if (argc == 1)
+        return 1;
+
+    for (int i = 1; i < argc; ++i) {
+        StringView argument = argv[i];
+        if (argument == "(" || argument == ")" || argument == "!")
+            return {};
+    }
+
+    auto is_operator = [](const StringView& argument) {
+        return argument.length() == 2 && argument[0] == '-';
+    };
+
+    if (argc == 2)
+        return StringView { argv[1] }.is_empty() ? 1 : 0;
+
+    if (argc == 3) {
+        StringView op = argv[1];
+        StringView operand = argv[2];
+        if (!is_operator(op) || operand == "-a" || operand == "-o")
+            return {};
+
+        auto check_file_kind = [&](bool follow_symlinks, auto predicate) -> Optional<int> {
+            struct stat st;
+            int rc = follow_symlinks ? stat(argv[2], &st) : lstat(argv[2], &st);
+            if (rc < 0) {
+                if (errno != ENOENT) {
+                    perror(argv[2]);
+                    return 126;
+                }
+                return 1;
+            }
+            return predicate(st.st_mode) ? 0 : 1;
+        };
+        auto check_access = [&](int mode) -> Optional<int> {
+            return access(argv[2], mode) == 0 ? 0 : 1;
+        };
+
+        switch (op[1]) {
+        case 'b':
+            return check_file_kind(true, [](mode_t mode) { return S_ISBLK(mode); });
+        case 'c':
+            return check_file_kind(true, [](mode_t mode) { return S_ISCHR(mode); });
+        case 'd':
+            return check_file_kind(true, [](mode_t mode) { return S_ISDIR(mode); });
+        case 'f':
+            return check_file_kind(true, [](mode_t mode) { return S_ISREG(mode); });
+        case 'h':
+        case 'L':
+            return check_file_kind(false, [](mode_t mode) { return S_ISLNK(mode); });
+        case 'p':
+            return check_file_kind(true, [](mode_t mode) { return S_ISFIFO(mode); });
+        case 'S':
+            return check_file_kind(true, [](mode_t mode) { return S_ISSOCK(mode); });
+        case 'r':
+            return check_access(R_OK);
+        case 'w':
+            return check_access(W_OK);
+        case 'x':
+            return check_access(X_OK);
+        case 'e':
+            return check_access(F_OK);
+        case 'n':
+            return operand.is_empty() ? 1 : 0;
+        case 'z':
+            return operand.is_empty() ? 0 : 1;
+        default:
+            return {};
+        }
+    }
+
+    if (argc == 4 && !is_operator(argv[1])) {
+        StringView lhs = argv[1];
+        StringView op = argv[2];
+        StringView rhs = argv[3];
+        if (op == "=")
+            return lhs == rhs ? 0 : 1;
+        if (op == "!=")
+            return lhs != rhs ? 0 : 1;
+
+        auto lhs_value = String(lhs).trim_whitespace().to_int();
+        auto rhs_value = String(rhs).trim_whitespace().to_int();
+        if (!lhs_value.has_value() || !rhs_value.has_value())
+            return {};
+        int left = lhs_value.value();
+        int right = rhs_value.value();
+        if (op == "-eq")
+            return left == right ? 0 : 1;
+        if (op == "-ne")
+            return left != right ? 0 : 1;
+        if (op == "-ge")
+            return left >= right ? 0 : 1;
+        if (op == "-gt")
+            return left > right ? 0 : 1;
+        if (op == "-le")
+            return left <= right ? 0 : 1;
+        if (op == "-lt")
+            return left < right ? 0 : 1;
+    }
+
+    return {};
+}
+
 bool Shell::run_builtin(const AST::Command& command, const NonnullRefPtrVector<AST::Rewiring>& rewirings, int& retval)
 {
     if (command.argv.is_empty())
@@ -765,15 +1215,25 @@ bool Shell::run_builtin(const AST::Command& command, const NonnullRefPtrVector<A
     if (!has_builtin(command.argv.first()))
         return false;
 
+    StringView name = command.argv.first();
+
+    // The stand-ins for programs would hold up the rest of a pipeline, or whatever is meant to
+    // run while they're in the background, so they only run here when they're being waited for.
+    if ((command.is_pipe_source || !command.should_wait) && is_program_builtin(name))
+        return false;
+
     Vector<const char*> argv;
     for (auto& arg : command.argv)
         argv.append(arg.characters());
 
     argv.append(nullptr);
 
-    StringView name = command.argv.first();
-
     SavedFileDescriptors fds { rewirings };
+    // Whatever the builtin has buffered up must go out before its redirections are undone.
+    ScopeGuard flush_output { [] {
+        fflush(stdout);
+        fflush(stderr);
+    } };
 
     for (auto& rewiring : rewirings) {
         int rc = dup2(rewiring.dest_fd, rewiring.source_fd);
@@ -792,6 +1252,19 @@ bool Shell::run_builtin(const AST::Command& command, const NonnullRefPtrVector<A
     ENUMERATE_SHELL_BUILTINS();
 
 #undef __ENUMERATE_SHELL_BUILTIN
+
+#define __ENUMERATE_SHELL_PROGRAM_BUILTIN(builtin, program)               \
+    if (name == program) {                                                \
+        auto result = builtin_##builtin(argv.size() - 1, argv.data());    \
+        if (!result.has_value())                                          \
+            return false;                                                 \
+        retval = result.value();                                          \
+        return true;                                                      \
+    }
+
+    ENUMERATE_SHELL_PROGRAM_BUILTINS();
+
+#undef __ENUMERATE_SHELL_PROGRAM_BUILTIN
     return false;
 }
 
@@ -805,5 +1278,18 @@ bool Shell::has_builtin(const StringView& name) const
     ENUMERATE_SHELL_BUILTINS();
 
 #undef __ENUMERATE_SHELL_BUILTIN
+    return is_program_builtin(name);
+}
+
+bool Shell::is_program_builtin(const StringView& name) const
+{
+#define __ENUMERATE_SHELL_PROGRAM_BUILTIN(builtin, program) \
+    if (name == program) {                                  \
+        return true;                                        \
+    }
+
+    ENUMERATE_SHELL_PROGRAM_BUILTINS();
+
+#undef __ENUMERATE_SHELL_PROGRAM_BUILTIN
     return false;
 }
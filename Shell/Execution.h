@@ -40,6 +40,8 @@ public:
 
     void collect();
     void add(int fd);
+    // Keeps programs that get started from inheriting the collected descriptors.
+    void set_close_on_exec();
 
 private:
     Vector<int, 32> m_fds;
@@ -28,6 +28,7 @@
 #include "Execution.h"
 #include <AK/Function.h>
 #include <AK/LexicalPath.h>
+#include <AK/QuickSort.h>
 #include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/ArgsParser.h>
@@ -37,11 +38,13 @@
 #include <LibCore/EventLoop.h>
 #include <LibCore/File.h>
 #include <LibLine/Editor.h>
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <pwd.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -194,83 +197,198 @@ Vector<StringView> Shell::split_path(const StringView& path)
     return parts;
 }
 
-Vector<String> Shell::expand_globs(const StringView& path, StringView base)
+namespace {
+
+// Orders names as if each of them was followed by a '/', which is how the paths
+// underneath them compare. This keeps results in the same order as sorting them all.
+static bool directory_name_less_than(const String& a, const String& b)
 {
-    if (path.starts_with('/'))
-        base = "/";
-    auto parts = split_path(path);
-    String base_string = base;
-    struct stat statbuf;
-    if (lstat(base_string.characters(), &statbuf) < 0) {
-        perror("lstat");
-        return {};
+    size_t length = min(a.length(), b.length());
+    int rc = memcmp(a.characters(), b.characters(), length);
+    if (rc != 0)
+        return rc < 0;
+    u8 next_a = length < a.length() ? a[length] : '/';
+    u8 next_b = length < b.length() ? b[length] : '/';
+    return next_a < next_b;
+}
+
+// The state of a single glob expansion. Results are handed to the callback as soon as they
+// are found, in sorted order, so only the listings of the directories on the current path are kept around.
+class GlobExpansion {
+public:
+    GlobExpansion(Vector<StringView> segments, size_t base_length, Function<IterationDecision(String)>& callback)
+        : m_segments(move(segments))
+        , m_base_length(base_length)
+        , m_callback(callback)
+    {
+        // Only a ".." after a glob can bring us back into a directory that was already listed.
+        bool seen_glob = false;
+        for (auto& segment : m_segments) {
+            if (seen_glob && segment == "..")
+                m_should_cache_listings = true;
+            seen_glob |= Shell::is_glob(segment);
+        }
     }
 
-    StringBuilder resolved_base_path_builder;
-    resolved_base_path_builder.append(Core::File::real_path_for(base));
-    if (S_ISDIR(statbuf.st_mode))
-        resolved_base_path_builder.append('/');
+    IterationDecision expand(size_t index, const String& path)
+    {
+        // Literal segments don't need a directory listing, just glue them on.
+        StringBuilder builder;
+        builder.append(path);
+        for (; index < m_segments.size() && !Shell::is_glob(m_segments[index]); ++index) {
+            if (!builder.string_view().ends_with('/'))
+                builder.append('/');
+            builder.append(m_segments[index]);
+        }
 
-    auto resolved_base = resolved_base_path_builder.string_view();
+        if (index == m_segments.size()) {
+            auto result = builder.to_string();
+            if (access(result.characters(), F_OK) < 0)
+                return IterationDecision::Continue;
+            return emit(result);
+        }
 
-    auto results = expand_globs(move(parts), resolved_base);
+        if (!builder.string_view().ends_with('/'))
+            builder.append('/');
+        auto directory = builder.to_string();
+        auto entries = list_directory(directory);
+        if (!entries.has_value())
+            return IterationDecision::Continue;
 
-    for (auto& entry : results) {
-        entry = entry.substring(resolved_base.length(), entry.length() - resolved_base.length());
-        if (entry.is_empty())
-            entry = ".";
-    }
+        auto& segment = m_segments[index];
+        bool is_last = index == m_segments.size() - 1;
+        auto literal_prefix = segment.substring_view(0, literal_prefix_length(segment));
 
-    // Make the output predictable and nice.
-    quick_sort(results);
+        Vector<const DirectoryEntry*> matches;
+        for (auto& entry : entries.value()) {
+            // Dotfiles have to be explicitly requested
+            if (entry.name[0] == '.' && segment[0] != '.')
+                continue;
+            if (!entry.name.starts_with(literal_prefix))
+                continue;
+            if (!entry.name.matches(segment, CaseSensitivity::CaseSensitive))
+                continue;
+            // Only directories can have anything underneath them.
+            if (!is_last && !is_directory(directory, entry))
+                continue;
+            matches.append(&entry);
+        }
 
-    return results;
-}
+        if (is_last)
+            quick_sort(matches, [](auto* a, auto* b) { return a->name < b->name; });
+        else
+            quick_sort(matches, [](auto* a, auto* b) { return directory_name_less_than(a->name, b->name); });
 
-Vector<String> Shell::expand_globs(Vector<StringView> path_segments, const StringView& base)
-{
-    if (path_segments.is_empty()) {
-        String base_str = base;
-        if (access(base_str.characters(), F_OK) == 0)
-            return { move(base_str) };
-        return {};
+        for (auto* entry : matches) {
+            auto entry_path = String::format("%s%s", directory.characters(), entry->name.characters());
+            // Anything we just found in a listing exists, there's no need to ask again.
+            auto decision = is_last ? emit(entry_path) : expand(index + 1, entry_path);
+            if (decision == IterationDecision::Break)
+                return IterationDecision::Break;
+        }
+        return IterationDecision::Continue;
     }
 
-    auto first_segment = path_segments.take_first();
-    if (is_glob(first_segment)) {
-        Vector<String> result;
+private:
+    struct DirectoryEntry {
+        String name;
+        u8 type { DT_UNKNOWN };
+    };
 
-        Core::DirIterator di(base, Core::DirIterator::SkipParentAndBaseDir);
-        if (di.has_error())
-            return {};
+    static size_t literal_prefix_length(const StringView& segment)
+    {
+        for (size_t i = 0; i < segment.length(); ++i) {
+            if (segment[i] == '*' || segment[i] == '?')
+                return i;
+        }
+        return segment.length();
+    }
 
-        while (di.has_next()) {
-            String path = di.next_path();
+    static bool is_directory(const String& directory, const DirectoryEntry& entry)
+    {
+        if (entry.type == DT_DIR)
+            return true;
+        // Symlinks may point to directories, and some file systems don't tell us what the entry is.
+        if (entry.type != DT_LNK && entry.type != DT_UNKNOWN)
+            return false;
+        struct stat st;
+        auto path = String::format("%s%s", directory.characters(), entry.name.characters());
+        return stat(path.characters(), &st) == 0 && S_ISDIR(st.st_mode);
+    }
 
-            // Dotfiles have to be explicitly requested
-            if (path[0] == '.' && first_segment[0] != '.')
-                continue;
+    Optional<Vector<DirectoryEntry>> list_directory(const String& path)
+    {
+        if (m_should_cache_listings) {
+            if (auto it = m_listings.find(path); it != m_listings.end())
+                return it->value;
+        }
 
-            if (path.matches(first_segment, CaseSensitivity::CaseSensitive)) {
-                StringBuilder builder;
-                builder.append(base);
-                if (!base.ends_with('/'))
-                    builder.append('/');
-                builder.append(path);
-                result.append(expand_globs(path_segments, builder.string_view()));
+        Optional<Vector<DirectoryEntry>> listing;
+        if (auto* dir = opendir(path.characters())) {
+            Vector<DirectoryEntry> entries;
+            while (auto* dirent = readdir(dir)) {
+                if (!strcmp(dirent->d_name, ".") || !strcmp(dirent->d_name, ".."))
+                    continue;
+                entries.append({ dirent->d_name, dirent->d_type });
             }
+            closedir(dir);
+            listing = move(entries);
         }
 
-        return result;
-    } else {
-        StringBuilder builder;
-        builder.append(base);
-        if (!base.ends_with('/'))
-            builder.append('/');
-        builder.append(first_segment);
+        if (m_should_cache_listings)
+            m_listings.set(path, listing);
+        return listing;
+    }
 
-        return expand_globs(move(path_segments), builder.string_view());
+    IterationDecision emit(const String& path)
+    {
+        auto result = path.substring(m_base_length, path.length() - m_base_length);
+        if (result.is_empty())
+            result = ".";
+        return m_callback(move(result));
+    }
+
+    Vector<StringView> m_segments;
+    size_t m_base_length { 0 };
+    Function<IterationDecision(String)>& m_callback;
+
+    bool m_should_cache_listings { false };
+    HashMap<String, Optional<Vector<DirectoryEntry>>> m_listings;
+};
+
+}
+
+void Shell::for_each_glob_match(const StringView& path, StringView base, Function<IterationDecision(String)> callback)
+{
+    if (path.starts_with('/'))
+        base = "/";
+    String base_string = base;
+    struct stat statbuf;
+    if (lstat(base_string.characters(), &statbuf) < 0) {
+        perror("lstat");
+        return;
     }
+
+    StringBuilder resolved_base_path_builder;
+    resolved_base_path_builder.append(Core::File::real_path_for(base));
+    if (S_ISDIR(statbuf.st_mode) && !resolved_base_path_builder.string_view().ends_with('/'))
+        resolved_base_path_builder.append('/');
+    auto resolved_base = resolved_base_path_builder.to_string();
+
+    // Absolute globs expand to absolute paths, relative ones to paths relative to the base.
+    size_t base_length = path.starts_with('/') ? 0 : resolved_base.length();
+    GlobExpansion expansion { split_path(path), base_length, callback };
+    expansion.expand(0, resolved_base);
+}
+
+Vector<String> Shell::expand_globs(const StringView& path, StringView base)
+{
+    Vector<String> results;
+    for_each_glob_match(path, base, [&](String result) {
+        results.append(move(result));
+        return IterationDecision::Continue;
+    });
+    return results;
 }
 
 Vector<AST::Command> Shell::expand_aliases(Vector<AST::Command> initial_commands)
@@ -501,8 +619,15 @@ RefPtr<Job> Shell::run_command(const AST::Command& command)
     }
 
     int retval = 0;
-    if (run_builtin(command, rewirings, retval))
-        return nullptr;
+    if (run_builtin(command, rewirings, retval)) {
+        // Builtins have already run to completion, so hand back a job that has exited.
+        StringBuilder cmd;
+        cmd.join(" ", command.argv);
+        auto job = Job::create(-1, -1, cmd.build(), 0);
+        job->deactivate();
+        job->set_has_exit(retval);
+        return *job;
+    }
 
     Vector<const char*> argv;
     Vector<String> copy_argv = command.argv;
@@ -513,83 +638,66 @@ RefPtr<Job> Shell::run_command(const AST::Command& command)
 
     argv.append(nullptr);
 
-    int sync_pipe[2];
-    if (pipe(sync_pipe) < 0) {
-        perror("pipe");
-        return nullptr;
-    }
+    bool is_first = !command.pipeline || (command.pipeline && command.pipeline->pgid == -1);
+    pid_t pgid = is_first ? 0 : command.pipeline->pgid;
+
+    // The child joins its process group and takes over the terminal before it gets to run, so that
+    // it can't trip over the terminal while still being in the background.
+    posix_spawnattr_t spawn_attributes;
+    posix_spawnattr_init(&spawn_attributes);
+    posix_spawnattr_setflags(&spawn_attributes, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&spawn_attributes, pgid);
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    ScopeGuard destroy_spawn_state { [&] {
+        posix_spawn_file_actions_destroy(&file_actions);
+        posix_spawnattr_destroy(&spawn_attributes);
+    } };
 
-    pid_t child = fork();
-    if (child < 0) {
-        perror("fork");
-        return nullptr;
+    if (command.should_wait) {
+        if (isatty(STDIN_FILENO))
+            posix_spawn_file_actions_addtcsetpgrp_np(&file_actions, STDIN_FILENO);
+        else if (isatty(STDOUT_FILENO))
+            posix_spawn_file_actions_addtcsetpgrp_np(&file_actions, STDOUT_FILENO);
     }
 
-    if (child == 0) {
-        close(sync_pipe[1]);
-
-        tcsetattr(0, TCSANOW, &default_termios);
-
-        for (auto& rewiring : rewirings) {
+    for (auto& rewiring : rewirings) {
 #ifdef SH_DEBUG
-            dbgprintf("in %s<%d>, dup2(%d, %d)\n", argv[0], getpid(), rewiring.dest_fd, rewiring.source_fd);
+        dbgprintf("in %s, dup2(%d, %d)\n", argv[0], rewiring.dest_fd, rewiring.source_fd);
 #endif
-            int rc = dup2(rewiring.dest_fd, rewiring.source_fd);
-            if (rc < 0) {
-                perror("dup2(run)");
-                return nullptr;
-            }
-            // dest_fd is closed via the `fds` collector, but rewiring.other_pipe_end->dest_fd
-            // isn't yet in that collector when the first child spawns.
-            if (rewiring.other_pipe_end && close(rewiring.other_pipe_end->dest_fd) < 0)
-                perror("close other pipe end");
-        }
+        posix_spawn_file_actions_adddup2(&file_actions, rewiring.dest_fd, rewiring.source_fd);
+        // dest_fd is closed via the `fds` collector, but rewiring.other_pipe_end->dest_fd
+        // isn't yet in that collector when the first child spawns.
+        if (rewiring.other_pipe_end)
+            fcntl(rewiring.other_pipe_end->dest_fd, F_SETFD, FD_CLOEXEC);
+    }
 
-        fds.collect();
+    // The child mustn't keep any of the descriptors that we're about to close.
+    fds.set_close_on_exec();
 
-        u8 c;
-        while (read(sync_pipe[0], &c, 1) < 0) {
-            if (errno != EINTR) {
-                perror("read");
-                // There's nothing interesting we can do here.
-                break;
-            }
-            dbg() << "Oof";
-        }
+    tcsetattr(0, TCSANOW, &default_termios);
 
-        close(sync_pipe[0]);
-
-        int rc = execvp(argv[0], const_cast<char* const*>(argv.data()));
-        if (rc < 0) {
-            if (errno == ENOENT) {
-                int shebang_fd = open(argv[0], O_RDONLY);
-                auto close_argv = ScopeGuard([shebang_fd]() { if (shebang_fd >= 0)  close(shebang_fd); });
-                char shebang[256] {};
-                ssize_t num_read = -1;
-                if ((shebang_fd >= 0) && ((num_read = read(shebang_fd, shebang, sizeof(shebang))) >= 2) && (StringView(shebang).starts_with("#!"))) {
-                    StringView shebang_path_view(&shebang[2], num_read - 2);
-                    Optional<size_t> newline_pos = shebang_path_view.find_first_of("\n\r");
-                    shebang[newline_pos.has_value() ? (newline_pos.value() + 2) : num_read] = '\0';
-                    fprintf(stderr, "%s: Invalid interpreter \"%s\": %s\n", argv[0], &shebang[2], strerror(ENOENT));
-                } else
-                    fprintf(stderr, "%s: Command not found.\n", argv[0]);
-            } else {
-                int saved_errno = errno;
-                struct stat st;
-                if (stat(argv[0], &st) == 0 && S_ISDIR(st.st_mode)) {
-                    fprintf(stderr, "Shell: %s: Is a directory\n", argv[0]);
-                    _exit(126);
-                }
-                fprintf(stderr, "execvp(%s): %s\n", argv[0], strerror(saved_errno));
-            }
-            _exit(126);
-        }
-        ASSERT_NOT_REACHED();
+    pid_t child = -1;
+    int rc = ENOENT;
+    for (int attempt = 0; attempt < 2 && rc == ENOENT; ++attempt) {
+        auto program_path = find_program(argv[0]);
+        if (program_path.is_null())
+            break;
+        rc = posix_spawn(&child, program_path.characters(), &file_actions, &spawn_attributes, const_cast<char* const*>(argv.data()), environ);
+        // The program may have moved since we last looked for it.
+        if (rc == ENOENT && !StringView(argv[0]).contains('/'))
+            m_program_paths.remove(argv[0]);
     }
 
-    close(sync_pipe[0]);
-
-    bool is_first = !command.pipeline || (command.pipeline && command.pipeline->pgid == -1);
+    if (rc != 0) {
+        restore_ios();
+        report_spawn_error(argv[0], rc);
+        auto job = Job::create(-1, -1, argv[0], 0);
+        job->deactivate();
+        job->set_has_exit(126);
+        return *job;
+    }
 
     if (command.pipeline) {
         if (is_first) {
@@ -597,26 +705,14 @@ RefPtr<Job> Shell::run_command(const AST::Command& command)
         }
     }
 
-    pid_t pgid = is_first ? child : (command.pipeline ? command.pipeline->pgid : child);
-    if (setpgid(child, pgid) < 0)
-        perror("setpgid");
+    if (is_first)
+        pgid = child;
 
     if (command.should_wait) {
         tcsetpgrp(STDOUT_FILENO, pgid);
         tcsetpgrp(STDIN_FILENO, pgid);
     }
 
-    while (write(sync_pipe[1], "x", 1) < 0) {
-        if (errno != EINTR) {
-            perror("write");
-            // There's nothing interesting we can do here.
-            break;
-        }
-        dbg() << "Oof";
-    }
-
-    close(sync_pipe[1]);
-
     StringBuilder cmd;
     cmd.join(" ", command.argv);
 
@@ -636,6 +732,54 @@ RefPtr<Job> Shell::run_command(const AST::Command& command)
     return *job;
 }
 
+String Shell::find_program(const String& name)
+{
+    if (name.contains("/"))
+        return name;
+
+    auto cached_path = m_program_paths.get(name);
+    if (cached_path.has_value())
+        return cached_path.value();
+
+    String path = getenv("PATH");
+    if (path.is_empty())
+        path = "/bin:/usr/bin";
+    for (auto& directory : path.split(':')) {
+        auto program_path = String::format("%s/%s", directory.characters(), name.characters());
+        struct stat st;
+        if (stat(program_path.characters(), &st) == 0 && !S_ISDIR(st.st_mode) && access(program_path.characters(), X_OK) == 0) {
+            m_program_paths.set(name, program_path);
+            return program_path;
+        }
+    }
+    return {};
+}
+
+void Shell::report_spawn_error(const char* program, int error)
+{
+    if (error == ENOENT) {
+        int shebang_fd = open(program, O_RDONLY);
+        auto close_argv = ScopeGuard([shebang_fd]() { if (shebang_fd >= 0)  close(shebang_fd); });
+        char shebang[256] {};
+        ssize_t num_read = -1;
+        if ((shebang_fd >= 0) && ((num_read = read(shebang_fd, shebang, sizeof(shebang))) >= 2) && (StringView(shebang).starts_with("#!"))) {
+            StringView shebang_path_view(&shebang[2], num_read - 2);
+            Optional<size_t> newline_pos = shebang_path_view.find_first_of("\n\r");
+            shebang[newline_pos.has_value() ? (newline_pos.value() + 2) : num_read] = '\0';
+            fprintf(stderr, "%s: Invalid interpreter \"%s\": %s\n", program, &shebang[2], strerror(ENOENT));
+        } else
+            fprintf(stderr, "%s: Command not found.\n", program);
+        return;
+    }
+
+    struct stat st;
+    if (stat(program, &st) == 0 && S_ISDIR(st.st_mode)) {
+        fprintf(stderr, "Shell: %s: Is a directory\n", program);
+        return;
+    }
+    fprintf(stderr, "posix_spawn(%s): %s\n", program, strerror(error));
+}
+
 NonnullRefPtrVector<Job> Shell::run_commands(Vector<AST::Command>& commands)
 {
     NonnullRefPtrVector<Job> jobs_to_wait_for;
@@ -824,6 +968,7 @@ void Shell::cache_path()
 {
     if (!cached_path.is_empty())
         cached_path.clear_with_capacity();
+    m_program_paths.clear();
 
     // Add shell builtins to the cache.
     for (const auto& builtin_name : builtin_names)
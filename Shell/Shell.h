@@ -58,7 +58,20 @@
     __ENUMERATE_SHELL_BUILTIN(jobs)    \
     __ENUMERATE_SHELL_BUILTIN(disown)  \
     __ENUMERATE_SHELL_BUILTIN(fg)      \
-    __ENUMERATE_SHELL_BUILTIN(bg)
+    __ENUMERATE_SHELL_BUILTIN(bg)      \
+    __ENUMERATE_SHELL_BUILTIN(printf)
+
+// These stand in for the programs of the same name, so that scripts don't have to start a process
+// for each of them. They return an empty Optional for anything they can't be sure to handle
+// exactly like the program, which is then run instead.
+#define ENUMERATE_SHELL_PROGRAM_BUILTINS()                   \
+    __ENUMERATE_SHELL_PROGRAM_BUILTIN(basename, "basename") \
+    __ENUMERATE_SHELL_PROGRAM_BUILTIN(bracket, "[")         \
+    __ENUMERATE_SHELL_PROGRAM_BUILTIN(dirname, "dirname")   \
+    __ENUMERATE_SHELL_PROGRAM_BUILTIN(echo, "echo")         \
+    __ENUMERATE_SHELL_PROGRAM_BUILTIN(false, "false")       \
+    __ENUMERATE_SHELL_PROGRAM_BUILTIN(test, "test")         \
+    __ENUMERATE_SHELL_PROGRAM_BUILTIN(true, "true")
 
 #define ENUMERATE_SHELL_OPTIONS()                                                                                    \
     __ENUMERATE_SHELL_OPTION(inline_exec_keep_empty_segments, false, "Keep empty segments in inline execute $(...)") \
@@ -80,12 +93,13 @@ public:
     bool run_file(const String&, bool explicitly_invoked = true);
     bool run_builtin(const AST::Command&, const NonnullRefPtrVector<AST::Rewiring>&, int& retval);
     bool has_builtin(const StringView&) const;
+    bool is_program_builtin(const StringView&) const;
     void block_on_job(RefPtr<Job>);
     String prompt() const;
 
     static String expand_tilde(const String&);
     static Vector<String> expand_globs(const StringView& path, StringView base);
-    static Vector<String> expand_globs(Vector<StringView> path_segments, const StringView& base);
+    static void for_each_glob_match(const StringView& path, StringView base, Function<IterationDecision(String)>);
     Vector<AST::Command> expand_aliases(Vector<AST::Command>);
     String resolve_path(String) const;
     String resolve_alias(const String&) const;
@@ -191,6 +205,9 @@ private:
 
     void cache_path();
     void add_entry_to_cache(const String&);
+    // Returns the path that a program would be run from, or null if it can't be found in PATH.
+    String find_program(const String&);
+    void report_spawn_error(const char* program, int error);
     void stop_all_jobs();
     const Job* m_current_job { nullptr };
     LocalFrame* find_frame_containing_local_variable(const String& name);
@@ -204,11 +221,23 @@ private:
 
 #undef __ENUMERATE_SHELL_BUILTIN
 
+#define __ENUMERATE_SHELL_PROGRAM_BUILTIN(builtin, program) \
+    Optional<int> builtin_##builtin(int argc, const char** argv);
+
+    ENUMERATE_SHELL_PROGRAM_BUILTINS();
+
+#undef __ENUMERATE_SHELL_PROGRAM_BUILTIN
+
+    Optional<int> run_test_builtin(int argc, const char** argv);
+
     constexpr static const char* builtin_names[] = {
 #define __ENUMERATE_SHELL_BUILTIN(builtin) #builtin,
+#define __ENUMERATE_SHELL_PROGRAM_BUILTIN(builtin, program) program,
 
         ENUMERATE_SHELL_BUILTINS()
+        ENUMERATE_SHELL_PROGRAM_BUILTINS()
 
+#undef __ENUMERATE_SHELL_PROGRAM_BUILTIN
 #undef __ENUMERATE_SHELL_BUILTIN
     };
 
@@ -220,6 +249,8 @@ private:
     NonnullRefPtrVector<AST::Redirection> m_global_redirections;
 
     HashMap<String, String> m_aliases;
+    // Where programs have been found in PATH before, so that it isn't searched every time.
+    HashMap<String, String> m_program_paths;
     bool m_is_interactive { true };
 };
 
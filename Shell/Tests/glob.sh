@@ -0,0 +1,22 @@
+#!/bin/sh
+
+rm -rf /tmp/sh-glob-test
+mkdir -p /tmp/sh-glob-test/a/x /tmp/sh-glob-test/a-b/x /tmp/sh-glob-test/.hidden
+cd /tmp/sh-glob-test
+touch a/x/1.cpp a/x/2.h a-b/x/3.cpp top.cpp .dot.cpp
+
+test "$(echo *)" = "a a-b top.cpp" || exit 1
+test "$(echo .*)" = ".dot.cpp .hidden" || exit 1
+test "$(echo */x/*.cpp)" = "a-b/x/3.cpp a/x/1.cpp" || exit 1
+test "$(echo */*/*)" = "a-b/x/3.cpp a/x/1.cpp a/x/2.h" || exit 1
+test "$(echo a*/../*.cpp)" = "a-b/../top.cpp a/../top.cpp" || exit 1
+test "$(echo /tmp/sh-glob-test/*.cpp)" = "/tmp/sh-glob-test/top.cpp" || exit 1
+
+# for loops get the matches in the same order
+for f in */x/* {
+    echo -n "$f " >> /tmp/sh-glob-test/list
+}
+test "$(cat /tmp/sh-glob-test/list)" = "a-b/x/3.cpp a/x/1.cpp a/x/2.h " || exit 1
+
+cd /
+rm -rf /tmp/sh-glob-test
@@ -0,0 +1,34 @@
+#!/bin/sh
+
+# These run inside the shell, and should agree with the programs they stand in for.
+true || exit 1
+false && exit 1
+
+test -d / || exit 1
+test -f / && exit 1
+[ 1 -lt 2 ] || exit 1
+[ yes = no ] && exit 1
+test -z "" || exit 1
+test -n "" && exit 1
+
+test "$(basename /usr/local/bin)" = bin || exit 1
+test "$(dirname /usr/local/bin)" = /usr/local || exit 1
+test "$(echo -n a b)" = "a b" || exit 1
+
+test "$(printf '%s-%03d|%-3x|' foo 7 255)" = "foo-007|ff |" || exit 1
+test "$(printf '%s,' a b c)" = "a,b,c," || exit 1
+
+# Redirected output has to end up in the right place.
+rm -f /tmp/sh-program-builtins
+echo hello > /tmp/sh-program-builtins
+test "$(cat /tmp/sh-program-builtins)" = hello || exit 1
+rm /tmp/sh-program-builtins
+
+# The exit status of a builtin decides conditions.
+if test 1 -eq 1 {
+} else {
+    exit 1
+}
+
+# Pipelines still work when a builtin feeds them.
+test "$(echo piped | cat)" = piped || exit 1
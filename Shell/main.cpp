@@ -30,6 +30,7 @@
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/File.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -56,6 +57,12 @@ void FileDescriptionCollector::add(int fd)
     m_fds.append(fd);
 }
 
+void FileDescriptionCollector::set_close_on_exec()
+{
+    for (auto fd : m_fds)
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
 SavedFileDescriptors::SavedFileDescriptors(const NonnullRefPtrVector<AST::Rewiring>& intended_rewirings)
 {
     for (auto& rewiring : intended_rewirings) {
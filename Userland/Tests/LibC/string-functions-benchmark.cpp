@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Compares the LibC string routines against the plain byte-at-a-time versions
+// they replaced, checking that both agree while timing them.
+
+static void* reference_memcpy(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    void* original_dest = dest_ptr;
+    asm volatile(
+        "rep movsb"
+        : "+D"(dest_ptr), "+S"(src_ptr), "+c"(n)::"memory");
+    return original_dest;
+}
+
+static void* reference_memset(void* dest_ptr, int c, size_t n)
+{
+    void* original_dest = dest_ptr;
+    asm volatile(
+        "rep stosb\n"
+        : "=D"(dest_ptr), "=c"(n)
+        : "0"(dest_ptr), "1"(n), "a"(c)
+        : "memory");
+    return original_dest;
+}
+
+static void* reference_memmove(void* dest, const void* src, size_t n)
+{
+    if (dest < src)
+        return reference_memcpy(dest, src, n);
+    u8* pd = (u8*)dest;
+    const u8* ps = (const u8*)src;
+    for (pd += n, ps += n; n--;)
+        *--pd = *--ps;
+    return dest;
+}
+
+static int reference_memcmp(const void* v1, const void* v2, size_t n)
+{
+    auto* s1 = (const u8*)v1;
+    auto* s2 = (const u8*)v2;
+    while (n-- > 0) {
+        if (*s1++ != *s2++)
+            return s1[-1] < s2[-1] ? -1 : 1;
+    }
+    return 0;
+}
+
+static const void* reference_memchr(const void* ptr, int c, size_t size)
+{
+    auto* cptr = (const char*)ptr;
+    for (size_t i = 0; i < size; ++i) {
+        if (cptr[i] == (char)c)
+            return cptr + i;
+    }
+    return nullptr;
+}
+
+static size_t reference_strlen(const char* str)
+{
+    size_t len = 0;
+    while (*(str++))
+        ++len;
+    return len;
+}
+
+static const char* reference_strchr(const char* str, int c)
+{
+    for (;; ++str) {
+        if (*str == (char)c)
+            return str;
+        if (!*str)
+            return nullptr;
+    }
+}
+
+static constexpr size_t buffer_size = 256 * KiB;
+static u8 g_source[buffer_size + 64];
+static u8 g_dest[buffer_size + 64];
+static u8 g_expected[buffer_size + 64];
+static bool g_failed = false;
+
+static double now_in_microseconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+template<typename Callback>
+static double time_it(size_t iterations, Callback callback)
+{
+    auto start = now_in_microseconds();
+    for (size_t i = 0; i < iterations; ++i) {
+        callback();
+        // Keep the compiler from hoisting the (pure) call out of the loop.
+        asm volatile("" ::
+                         : "memory");
+    }
+    return now_in_microseconds() - start;
+}
+
+static void check(bool condition, const char* name, size_t size, size_t offset)
+{
+    if (condition)
+        return;
+    g_failed = true;
+    fprintf(stderr, "%s FAILED for size %zu at offset %zu\n", name, size, offset);
+}
+
+static void verify()
+{
+    for (size_t i = 0; i < sizeof(g_source); ++i)
+        g_source[i] = 1 + (rand() % 250);
+
+    for (size_t size = 0; size < 300; ++size) {
+        for (size_t offset = 0; offset < 17; ++offset) {
+            memset(g_dest, 0xaa, size + 64);
+            memset(g_expected, 0xaa, size + 64);
+            memcpy(g_dest + offset, g_source + 3, size);
+            reference_memcpy(g_expected + offset, g_source + 3, size);
+            check(!reference_memcmp(g_dest, g_expected, size + 64), "memcpy", size, offset);
+
+            memset(g_dest + offset, 0x5c, size);
+            reference_memset(g_expected + offset, 0x5c, size);
+            check(!reference_memcmp(g_dest, g_expected, size + 64), "memset", size, offset);
+
+            reference_memcpy(g_dest, g_source, size + 64);
+            reference_memcpy(g_expected, g_source, size + 64);
+            memmove(g_dest + offset, g_dest + 8, size);
+            reference_memmove(g_expected + offset, g_expected + 8, size);
+            check(!reference_memcmp(g_dest, g_expected, size + 64), "memmove", size, offset);
+
+            reference_memcpy(g_dest, g_source, size + 64);
+            if (size)
+                g_dest[offset + (rand() % size)] ^= 0x80;
+            int result = memcmp(g_source + offset, g_dest + offset, size);
+            int expected = reference_memcmp(g_source + offset, g_dest + offset, size);
+            check((result < 0) == (expected < 0) && (result > 0) == (expected > 0), "memcmp", size, offset);
+
+            int needle = g_source[offset + size / 2];
+            check(memchr(g_source + offset, needle, size) == reference_memchr(g_source + offset, needle, size), "memchr", size, offset);
+
+            reference_memcpy(g_dest, g_source, size + 64);
+            g_dest[offset + size] = 0;
+            auto* string = (const char*)g_dest + offset;
+            check(strlen(string) == reference_strlen(string), "strlen", size, offset);
+            check(strchr(string, needle) == reference_strchr(string, needle), "strchr", size, offset);
+            check(strchr(string, 0) == reference_strchr(string, 0), "strchr", size, offset);
+        }
+    }
+}
+
+static void report(const char* name, size_t size, double reference_time, double time)
+{
+    printf("%-8s %8zu bytes: %10.1f us -> %10.1f us (%.2fx)\n", name, size, reference_time, time, reference_time / time);
+}
+
+static void benchmark(size_t size)
+{
+    size_t iterations = max((size_t)1, (64 * MiB) / max(size, (size_t)64));
+
+    memset(g_source, 'x', size);
+    g_source[size] = 0;
+
+    report("memcpy", size, time_it(iterations, [&] { reference_memcpy(g_dest, g_source, size); }), time_it(iterations, [&] { memcpy(g_dest, g_source, size); }));
+    report("memmove", size, time_it(iterations, [&] { reference_memmove(g_dest + 1, g_dest, size); }), time_it(iterations, [&] { memmove(g_dest + 1, g_dest, size); }));
+    report("memset", size, time_it(iterations, [&] { reference_memset(g_dest, 0, size); }), time_it(iterations, [&] { memset(g_dest, 0, size); }));
+
+    memset(g_dest, 'x', size);
+    report("memcmp", size, time_it(iterations, [&] { asm volatile("" ::"r"(reference_memcmp(g_dest, g_source, size))); }), time_it(iterations, [&] { asm volatile("" ::"r"(memcmp(g_dest, g_source, size))); }));
+    report("memchr", size, time_it(iterations, [&] { asm volatile("" ::"r"(reference_memchr(g_source, 'y', size))); }), time_it(iterations, [&] { asm volatile("" ::"r"(memchr(g_source, 'y', size))); }));
+    report("strlen", size, time_it(iterations, [&] { asm volatile("" ::"r"(reference_strlen((const char*)g_source))); }), time_it(iterations, [&] { asm volatile("" ::"r"(strlen((const char*)g_source))); }));
+    report("strchr", size, time_it(iterations, [&] { asm volatile("" ::"r"(reference_strchr((const char*)g_source, 'y'))); }), time_it(iterations, [&] { asm volatile("" ::"r"(strchr((const char*)g_source, 'y'))); }));
+}
+
+int main()
+{
+    verify();
+    if (g_failed) {
+        printf("FAIL\n");
+        return 1;
+    }
+
+    static const size_t sizes[] = { 16, 64, 256, 4 * KiB, 64 * KiB, 256 * KiB };
+    for (size_t size : sizes)
+        benchmark(size);
+
+    printf("PASS\n");
+    return 0;
+}
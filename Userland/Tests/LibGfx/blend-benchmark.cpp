@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StdLibExtras.h>
+#include <LibGfx/Blending.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Checks that every blending implementation the CPU can run agrees with the scalar one,
+// then times them against each other.
+
+static constexpr size_t max_row_size = 4096;
+
+static Gfx::RGBA32 g_source[max_row_size];
+static Gfx::RGBA32 g_dest[max_row_size];
+static Gfx::RGBA32 g_expected[max_row_size];
+static bool g_failed;
+
+static Gfx::RGBA32 random_pixel(u8 alpha)
+{
+    return ((u32)alpha << 24) | (rand() & 0xffffff);
+}
+
+static u8 random_alpha()
+{
+    // Fully opaque and fully transparent pixels take shortcuts, so make sure there are plenty of them.
+    switch (rand() % 4) {
+    case 0:
+        return 0;
+    case 1:
+        return 0xff;
+    default:
+        return rand() % 256;
+    }
+}
+
+static void fill_rows(size_t size, bool opaque_dest)
+{
+    for (size_t i = 0; i < size; ++i) {
+        g_source[i] = random_pixel(random_alpha());
+        g_dest[i] = random_pixel(opaque_dest || rand() % 8 ? 0xff : random_alpha());
+        g_expected[i] = g_dest[i];
+    }
+}
+
+static void check(const Gfx::BlendFunctions& functions, const char* name, size_t size)
+{
+    if (!memcmp(g_dest, g_expected, size * sizeof(Gfx::RGBA32)))
+        return;
+    g_failed = true;
+    fprintf(stderr, "%s %s FAILED for size %zu\n", functions.name, name, size);
+}
+
+static void verify(const Gfx::BlendFunctions& functions, const Gfx::BlendFunctions& reference)
+{
+    for (size_t size = 0; size < 100; ++size) {
+        for (int round = 0; round < 20; ++round) {
+            fill_rows(size, round % 2);
+            functions.blend(g_dest, g_source, size);
+            reference.blend(g_expected, g_source, size);
+            check(functions, "blend", size);
+
+            u8 alpha = random_alpha();
+            fill_rows(size, round % 2);
+            functions.blend_opaque_with_alpha(g_dest, g_source, size, alpha);
+            reference.blend_opaque_with_alpha(g_expected, g_source, size, alpha);
+            check(functions, "blend_opaque_with_alpha", size);
+
+            auto color = Gfx::Color::from_rgba(random_pixel(random_alpha()));
+            fill_rows(size, round % 2);
+            functions.blend_color(g_dest, color, size);
+            reference.blend_color(g_expected, color, size);
+            check(functions, "blend_color", size);
+        }
+    }
+}
+
+static double now_in_microseconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+template<typename Callback>
+static double time_it(size_t iterations, Callback callback)
+{
+    auto start = now_in_microseconds();
+    for (size_t i = 0; i < iterations; ++i) {
+        callback();
+        asm volatile("" ::
+                         : "memory");
+    }
+    return now_in_microseconds() - start;
+}
+
+static void benchmark(const Gfx::BlendFunctions& functions, size_t size)
+{
+    size_t iterations = max((size_t)1, (16 * MiB) / size);
+    fill_rows(size, true);
+    // Keep the destination opaque, like a window backing store being composited onto.
+    auto blend_time = time_it(iterations, [&] {
+        memcpy(g_dest, g_expected, size * sizeof(Gfx::RGBA32));
+        functions.blend(g_dest, g_source, size);
+    });
+    auto opacity_time = time_it(iterations, [&] { functions.blend_opaque_with_alpha(g_dest, g_source, size, 0x80); });
+    auto color = Gfx::Color(0x20, 0x40, 0x80, 0x80);
+    auto color_time = time_it(iterations, [&] {
+        memcpy(g_dest, g_expected, size * sizeof(Gfx::RGBA32));
+        functions.blend_color(g_dest, color, size);
+    });
+    printf("%-8s %6zu pixels: blend %9.1f us, opacity %9.1f us, color %9.1f us\n", functions.name, size, blend_time, opacity_time, color_time);
+}
+
+int main()
+{
+    auto implementations = Gfx::available_blend_functions();
+    auto& reference = *implementations.first();
+    for (auto* functions : implementations)
+        verify(*functions, reference);
+    if (g_failed) {
+        printf("FAIL\n");
+        return 1;
+    }
+
+    static const size_t sizes[] = { 16, 256, max_row_size };
+    for (size_t size : sizes) {
+        for (auto* functions : implementations)
+            benchmark(*functions, size);
+    }
+    printf("Using %s\n", Gfx::blend_functions().name);
+    printf("PASS\n");
+    return 0;
+}
@@ -31,6 +31,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <string.h>
 #include <unistd.h>
@@ -71,23 +72,13 @@ int main(int argc, char** argv)
 
     for (auto& fd : fds) {
         for (;;) {
-            char buf[32768];
-            ssize_t nread = read(fd, buf, sizeof(buf));
-            if (nread == 0)
+            ssize_t nsent = sendfile(1, fd, nullptr, 32768);
+            if (nsent == 0)
                 break;
-            if (nread < 0) {
-                perror("read");
+            if (nsent < 0) {
+                perror("sendfile");
                 return 2;
             }
-            size_t already_written = 0;
-            while (already_written < (size_t)nread) {
-                ssize_t nwritten = write(1, buf + already_written, nread - already_written);
-                if (nwritten < 0) {
-                    perror("write");
-                    return 3;
-                }
-                already_written += nwritten;
-            }
         }
         close(fd);
     }
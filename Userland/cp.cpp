@@ -24,24 +24,39 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/LexicalPath.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/DirIterator.h>
+#include <LibThread/ThreadPool.h>
 #include <assert.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+// Both sendfile() and the read() and write() fallback move this much at a time.
+static constexpr size_t copy_chunk_size = 1 * MiB;
+// Blocks of zeroes this big in sparse files are left as holes.
+static constexpr size_t hole_size = 4 * KiB;
+
+// With several jobs, the files found by a recursive copy are copied after all the directories have been made.
+static int s_job_count = 1;
+static Vector<Function<void()>> s_pending_copies;
+static Atomic<bool> s_pending_copy_failed { false };
+
 bool copy_file_or_directory(String, String, bool);
 bool copy_file(String, String, struct stat, int);
 bool copy_directory(String, String);
 
 int main(int argc, char** argv)
 {
-    if (pledge("stdio rpath wpath cpath fattr", nullptr) < 0) {
+    if (pledge("stdio rpath wpath cpath fattr thread", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
@@ -52,6 +67,7 @@ int main(int argc, char** argv)
 
     Core::ArgsParser args_parser;
     args_parser.add_option(recursion_allowed, "Copy directories recursively", "recursive", 'r');
+    args_parser.add_option(s_job_count, "Copy up to N files at once when copying directories", "jobs", 'j', "N");
     args_parser.add_positional_argument(sources, "Source file path", "source");
     args_parser.add_positional_argument(destination, "Destination file path", "destination");
     args_parser.parse(argc, argv);
@@ -61,9 +77,90 @@ int main(int argc, char** argv)
         if (!ok)
             return 1;
     }
+
+    if (!s_pending_copies.is_empty()) {
+        // The calling thread works on the copies too.
+        LibThread::ThreadPool pool(s_job_count - 1);
+        pool.run(move(s_pending_copies));
+        if (s_pending_copy_failed.load())
+            return 1;
+    }
     return 0;
 }
 
+static bool write_all(int fd, const u8* data, size_t size)
+{
+    while (size) {
+        ssize_t nwritten = write(fd, data, size);
+        if (nwritten < 0) {
+            perror("write dst");
+            return false;
+        }
+        assert(nwritten > 0);
+        size -= nwritten;
+        data += nwritten;
+    }
+    return true;
+}
+
+static bool is_all_zeroes(const u8* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Copy the rest of a file with read() and write(). Blocks of zeroes are skipped over in the
+ * destination if skip_zeroes is set, which leaves holes there.
+ */
+static bool copy_with_buffer(int src_fd, int dst_fd, bool skip_zeroes)
+{
+    // One page aligned buffer per thread, since a recursive copy may run a few of these at once.
+    static __thread u8* t_buffer;
+    if (!t_buffer) {
+        void* buffer = mmap(nullptr, copy_chunk_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+        if (buffer == MAP_FAILED) {
+            perror("mmap");
+            return false;
+        }
+        t_buffer = (u8*)buffer;
+    }
+
+    for (;;) {
+        ssize_t nread = read(src_fd, t_buffer, copy_chunk_size);
+        if (nread < 0) {
+            perror("read src");
+            return false;
+        }
+        if (nread == 0)
+            return true;
+        if (!skip_zeroes) {
+            if (!write_all(dst_fd, t_buffer, nread))
+                return false;
+            continue;
+        }
+
+        size_t data_start = 0;
+        for (size_t offset = 0; offset < (size_t)nread; offset += hole_size) {
+            size_t size = min(hole_size, nread - offset);
+            if (!is_all_zeroes(t_buffer + offset, size))
+                continue;
+            if (!write_all(dst_fd, t_buffer + data_start, offset - data_start))
+                return false;
+            if (lseek(dst_fd, size, SEEK_CUR) < 0) {
+                perror("lseek dst");
+                return false;
+            }
+            data_start = offset + size;
+        }
+        if (!write_all(dst_fd, t_buffer + data_start, nread - data_start))
+            return false;
+    }
+}
+
 /**
  * Copy a file or directory to a new location. Returns true if successful, false
  * otherwise. If there is an error, its description is output to stderr.
@@ -121,35 +218,39 @@ bool copy_file(String src_path, String dst_path, struct stat src_stat, int src_f
         }
     }
 
-    if (src_stat.st_size > 0) {
+    // Files with fewer blocks than their size calls for have holes, which we want to keep. Everything else
+    // gets its full size up front, so that the file system can allocate it in one go.
+    bool is_sparse = (off_t)src_stat.st_blocks * 512 < src_stat.st_size;
+    if (src_stat.st_size > 0 && !is_sparse) {
         if (ftruncate(dst_fd, src_stat.st_size) < 0) {
             perror("cp: ftruncate");
             return false;
         }
     }
 
-    for (;;) {
-        char buffer[32768];
-        ssize_t nread = read(src_fd, buffer, sizeof(buffer));
-        if (nread < 0) {
-            perror("read src");
-            return false;
-        }
-        if (nread == 0)
-            break;
-        ssize_t remaining_to_write = nread;
-        char* bufptr = buffer;
-        while (remaining_to_write) {
-            ssize_t nwritten = write(dst_fd, bufptr, remaining_to_write);
-            if (nwritten < 0) {
-                perror("write dst");
+    // sendfile() hands the source's cached pages straight to the destination,
+    // but it can't tell us where the holes are.
+    bool copied = false;
+    while (!is_sparse && !copied) {
+        ssize_t nsent = sendfile(dst_fd, src_fd, nullptr, copy_chunk_size);
+        if (nsent == 0) {
+            copied = true;
+        } else if (nsent < 0) {
+            if (errno != EINVAL && errno != ENOSYS) {
+                perror("sendfile");
                 return false;
             }
-            assert(nwritten > 0);
-            remaining_to_write -= nwritten;
-            bufptr += nwritten;
+            break;
         }
     }
+    if (!copied && !copy_with_buffer(src_fd, dst_fd, is_sparse))
+        return false;
+
+    // A hole at the end of the file would otherwise be cut off.
+    if (is_sparse && ftruncate(dst_fd, src_stat.st_size) < 0) {
+        perror("cp: ftruncate");
+        return false;
+    }
 
     auto my_umask = umask(0);
     umask(my_umask);
@@ -181,10 +282,19 @@ bool copy_directory(String src_path, String dst_path)
     }
     while (di.has_next()) {
         String filename = di.next_path();
-        bool is_copied = copy_file_or_directory(
-            String::format("%s/%s", src_path.characters(), filename.characters()),
-            String::format("%s/%s", dst_path.characters(), filename.characters()),
-            true);
+        auto src_child_path = String::format("%s/%s", src_path.characters(), filename.characters());
+        auto dst_child_path = String::format("%s/%s", dst_path.characters(), filename.characters());
+
+        struct stat src_child_stat;
+        if (s_job_count > 1 && stat(src_child_path.characters(), &src_child_stat) == 0 && !S_ISDIR(src_child_stat.st_mode)) {
+            s_pending_copies.append([src_child_path, dst_child_path] {
+                if (!copy_file_or_directory(src_child_path, dst_child_path, true))
+                    s_pending_copy_failed.store(true);
+            });
+            continue;
+        }
+
+        bool is_copied = copy_file_or_directory(src_child_path, dst_child_path, true);
         if (!is_copied) {
             return false;
         }
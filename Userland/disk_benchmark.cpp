@@ -25,18 +25,28 @@
  */
 
 #include <AK/ByteBuffer.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/QuickSort.h>
 #include <AK/String.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCore/ElapsedTimer.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/IORing.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
+// Random reads and writes, and the writes before an fsync(), are this big.
+static constexpr size_t random_block_size = 4096;
+
 struct Result {
     u64 write_bps;
     u64 read_bps;
@@ -44,7 +54,7 @@ struct Result {
 
 static Result average_result(const Vector<Result>& results)
 {
-    Result average;
+    Result average { 0, 0 };
 
     for (auto& res : results) {
         average.write_bps += res.write_bps;
@@ -57,13 +67,68 @@ static Result average_result(const Vector<Result>& results)
     return average;
 }
 
+static u64 now_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// How long the operations of a benchmark took, in microseconds.
+struct LatencySummary {
+    u64 operations;
+    u64 operations_per_second;
+    u64 p50;
+    u64 p90;
+    u64 p99;
+    u64 max;
+};
+
+static LatencySummary summarize(Vector<u64>& latencies_ns, u64 elapsed_ns)
+{
+    quick_sort(latencies_ns);
+    auto percentile = [&](size_t per_mille) -> u64 {
+        if (latencies_ns.is_empty())
+            return 0;
+        return latencies_ns[min(latencies_ns.size() - 1, latencies_ns.size() * per_mille / 1000)] / 1000;
+    };
+    u64 operations = latencies_ns.size();
+    return { operations, elapsed_ns ? operations * 1000000000 / elapsed_ns : operations, percentile(500), percentile(900), percentile(990), percentile(1000) };
+}
+
+static void report(JsonArray* json_results, JsonObject&& result, const LatencySummary& summary)
+{
+    if (!json_results) {
+        printf("%s", result.get("benchmark").as_string().characters());
+        result.for_each_member([](auto& key, auto& value) {
+            if (key != "benchmark")
+                printf(" %s=%s", key.characters(), value.to_string().characters());
+        });
+        printf(": ops=%llu ops_per_second=%llu p50=%lluus p90=%lluus p99=%lluus max=%lluus\n", summary.operations, summary.operations_per_second, summary.p50, summary.p90, summary.p99, summary.max);
+        return;
+    }
+    result.set("operations", summary.operations);
+    result.set("operations_per_second", summary.operations_per_second);
+    result.set("p50_us", summary.p50);
+    result.set("p90_us", summary.p90);
+    result.set("p99_us", summary.p99);
+    result.set("max_us", summary.max);
+    json_results->append(move(result));
+}
+
 static void exit_with_usage(int rc)
 {
-    fprintf(stderr, "Usage: disk_benchmark [-h] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]\n");
+    fprintf(stderr, "Usage: disk_benchmark [-h] [-c] [-j] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]\n"
+                    "                      [-m benchmark1,benchmark2,...] [-q queue_depth1,queue_depth2,...] [-r read_percentage] [-n file_count]\n"
+                    "Benchmarks: sequential, random-read, random-write, mixed, fsync, metadata\n");
     exit(rc);
 }
 
 static Result benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache);
+static bool random_io_benchmark(int fd, size_t file_size, size_t queue_depth, unsigned read_percentage, int time_ms, Vector<u64>& latencies_ns);
+static bool create_test_file(const String& filename, size_t file_size, bool allow_cache, int& fd);
+static bool fsync_benchmark(const String& filename, int time_ms, Vector<u64>& latencies_ns);
+static bool metadata_benchmark(const String& directory, int file_count, Vector<u64> (&latencies_ns)[3], u64 (&elapsed_ns)[3]);
 
 int main(int argc, char** argv)
 {
@@ -71,10 +136,15 @@ int main(int argc, char** argv)
     int time_per_benchmark = 10;
     Vector<int> file_sizes;
     Vector<int> block_sizes;
+    Vector<int> queue_depths;
+    Vector<String> benchmarks;
+    int read_percentage = 70;
+    int file_count = 1000;
     bool allow_cache = false;
+    bool json = false;
 
     int opt;
-    while ((opt = getopt(argc, argv, "chd:t:f:b:")) != -1) {
+    while ((opt = getopt(argc, argv, "chjd:t:f:b:m:q:r:n:")) != -1) {
         switch (opt) {
         case 'h':
             exit_with_usage(0);
@@ -82,6 +152,9 @@ int main(int argc, char** argv)
         case 'c':
             allow_cache = true;
             break;
+        case 'j':
+            json = true;
+            break;
         case 'd':
             directory = strdup(optarg);
             break;
@@ -96,6 +169,21 @@ int main(int argc, char** argv)
             for (auto size : String(optarg).split(','))
                 block_sizes.append(atoi(size.characters()));
             break;
+        case 'm':
+            benchmarks = String(optarg).split(',');
+            break;
+        case 'q':
+            for (auto depth : String(optarg).split(','))
+                queue_depths.append(max(atoi(depth.characters()), 1));
+            break;
+        case 'r':
+            read_percentage = clamp(atoi(optarg), 0, 100);
+            break;
+        case 'n':
+            file_count = atoi(optarg);
+            break;
+        default:
+            exit_with_usage(1);
         }
     }
 
@@ -105,40 +193,324 @@ int main(int argc, char** argv)
     if (block_sizes.size() == 0) {
         block_sizes = { 8192, 32768, 65536 };
     }
+    if (queue_depths.size() == 0) {
+        queue_depths = { 1, 8, 32 };
+    }
+    if (benchmarks.size() == 0) {
+        benchmarks = { "sequential", "random-read", "random-write", "mixed", "fsync", "metadata" };
+    }
+    auto should_run = [&](const char* name) {
+        return benchmarks.contains_slow(name);
+    };
+
+    // Core::IORing reports completions through the event loop machinery.
+    Core::EventLoop event_loop;
 
     umask(0644);
 
     auto filename = String::format("%s/disk_benchmark.tmp", directory);
+    JsonArray json_results;
+
+    if (should_run("sequential")) {
+        for (auto file_size : file_sizes) {
+            for (auto block_size : block_sizes) {
+                if (block_size > file_size)
+                    continue;
+
+                auto buffer = ByteBuffer::create_uninitialized(block_size);
+
+                Vector<Result> results;
+
+                if (!json)
+                    printf("Running: file_size=%d block_size=%d\n", file_size, block_size);
+                Core::ElapsedTimer timer;
+                timer.start();
+                while (timer.elapsed() < time_per_benchmark * 1000) {
+                    if (!json) {
+                        printf(".");
+                        fflush(stdout);
+                    }
+                    results.append(benchmark(filename, file_size, block_size, buffer, allow_cache));
+                    usleep(100);
+                }
+                auto average = average_result(results);
+                if (json) {
+                    JsonObject result;
+                    result.set("benchmark", "sequential");
+                    result.set("file_size", file_size);
+                    result.set("block_size", block_size);
+                    result.set("runs", results.size());
+                    result.set("write_bps", average.write_bps);
+                    result.set("read_bps", average.read_bps);
+                    json_results.append(move(result));
+                } else {
+                    printf("\nFinished: runs=%zu time=%dms write_bps=%llu read_bps=%llu\n", results.size(), timer.elapsed(), average.write_bps, average.read_bps);
+                }
+
+                sleep(1);
+            }
+        }
+    }
+
+    // The random benchmarks share one file, as large as the largest sequential one.
+    size_t random_file_size = 0;
+    for (auto file_size : file_sizes)
+        random_file_size = max(random_file_size, (size_t)file_size);
+    random_file_size = max(random_file_size, random_block_size);
 
-    for (auto file_size : file_sizes) {
-        for (auto block_size : block_sizes) {
-            if (block_size > file_size)
+    struct RandomBenchmark {
+        const char* name;
+        unsigned read_percentage;
+    };
+    RandomBenchmark random_benchmarks[] = {
+        { "random-read", 100 },
+        { "random-write", 0 },
+        { "mixed", (unsigned)read_percentage },
+    };
+    if (should_run("random-read") || should_run("random-write") || should_run("mixed")) {
+        int fd;
+        if (!create_test_file(filename, random_file_size, allow_cache, fd))
+            return 1;
+        for (auto& random_benchmark : random_benchmarks) {
+            if (!should_run(random_benchmark.name))
                 continue;
+            for (auto queue_depth : queue_depths) {
+                Vector<u64> latencies_ns;
+                u64 start = now_ns();
+                if (!random_io_benchmark(fd, random_file_size, queue_depth, random_benchmark.read_percentage, time_per_benchmark * 1000, latencies_ns)) {
+                    close(fd);
+                    unlink(filename.characters());
+                    return 1;
+                }
+                JsonObject result;
+                result.set("benchmark", random_benchmark.name);
+                result.set("file_size", random_file_size);
+                result.set("queue_depth", queue_depth);
+                if (!strcmp(random_benchmark.name, "mixed"))
+                    result.set("read_percentage", random_benchmark.read_percentage);
+                report(json ? &json_results : nullptr, move(result), summarize(latencies_ns, now_ns() - start));
+            }
+        }
+        close(fd);
+        unlink(filename.characters());
+    }
+
+    if (should_run("fsync")) {
+        Vector<u64> latencies_ns;
+        u64 start = now_ns();
+        if (!fsync_benchmark(filename, time_per_benchmark * 1000, latencies_ns))
+            return 1;
+        JsonObject result;
+        result.set("benchmark", "fsync");
+        result.set("block_size", random_block_size);
+        report(json ? &json_results : nullptr, move(result), summarize(latencies_ns, now_ns() - start));
+    }
+
+    if (should_run("metadata")) {
+        Vector<u64> latencies_ns[3];
+        u64 elapsed_ns[3];
+        if (!metadata_benchmark(String::format("%s/disk_benchmark.meta", directory), file_count, latencies_ns, elapsed_ns))
+            return 1;
+        const char* names[] = { "create", "stat", "unlink" };
+        for (size_t i = 0; i < 3; ++i) {
+            JsonObject result;
+            result.set("benchmark", String::format("metadata-%s", names[i]));
+            result.set("file_count", file_count);
+            report(json ? &json_results : nullptr, move(result), summarize(latencies_ns[i], elapsed_ns[i]));
+        }
+    }
+
+    if (json) {
+        printf("%s\n", json_results.to_string().characters());
+    } else if (isatty(0)) {
+        printf("Press any key to exit...\n");
+        fgetc(stdin);
+    }
+}
+
+bool create_test_file(const String& filename, size_t file_size, bool allow_cache, int& fd)
+{
+    int flags = O_CREAT | O_TRUNC | O_RDWR;
+    if (!allow_cache)
+        flags |= O_DIRECT;
+
+    fd = open(filename.characters(), flags, 0644);
+    if (fd == -1) {
+        perror("open");
+        return false;
+    }
 
-            auto buffer = ByteBuffer::create_uninitialized(block_size);
+    // Fill the file completely, so that random reads don't hit holes and random writes don't grow it.
+    auto buffer = ByteBuffer::create_uninitialized(64 * KiB);
+    arc4random_buf(buffer.data(), buffer.size());
+    for (size_t offset = 0; offset < file_size; offset += buffer.size()) {
+        if (write(fd, buffer.data(), min(buffer.size(), file_size - offset)) < 0) {
+            perror("write");
+            close(fd);
+            unlink(filename.characters());
+            return false;
+        }
+    }
+    if (fsync(fd) < 0) {
+        perror("fsync");
+        close(fd);
+        unlink(filename.characters());
+        return false;
+    }
+    return true;
+}
 
-            Vector<Result> results;
+bool random_io_benchmark(int fd, size_t file_size, size_t queue_depth, unsigned read_percentage, int time_ms, Vector<u64>& latencies_ns)
+{
+    u32 block_count = file_size / random_block_size;
+    Vector<ByteBuffer> buffers;
+    for (size_t i = 0; i < queue_depth; ++i) {
+        buffers.append(ByteBuffer::create_uninitialized(random_block_size));
+        arc4random_buf(buffers.last().data(), random_block_size);
+    }
 
-            printf("Running: file_size=%d block_size=%d\n", file_size, block_size);
-            Core::ElapsedTimer timer;
-            timer.start();
-            while (timer.elapsed() < time_per_benchmark * 1000) {
-                printf(".");
-                fflush(stdout);
-                results.append(benchmark(filename, file_size, block_size, buffer, allow_cache));
-                usleep(100);
+    auto next_is_read = [&] { return arc4random_uniform(100) < read_percentage; };
+    auto next_offset = [&] { return (i64)arc4random_uniform(block_count) * random_block_size; };
+    u64 deadline = now_ns() + (u64)time_ms * 1000000;
+
+    auto ring = Core::IORing::construct(queue_depth);
+    if (!ring->is_valid()) {
+        // Without the ring, there's only ever one operation in flight.
+        while (now_ns() < deadline) {
+            u64 start = now_ns();
+            ssize_t rc = next_is_read() ? pread(fd, buffers[0].data(), random_block_size, next_offset()) : pwrite(fd, buffers[0].data(), random_block_size, next_offset());
+            if (rc < 0) {
+                perror("random I/O");
+                return false;
             }
-            auto average = average_result(results);
-            printf("\nFinished: runs=%zu time=%dms write_bps=%llu read_bps=%llu\n", results.size(), timer.elapsed(), average.write_bps, average.read_bps);
+            latencies_ns.append(now_ns() - start);
+        }
+        return true;
+    }
 
-            sleep(1);
+    Vector<u64> start_times;
+    start_times.resize(queue_depth);
+    size_t in_flight = 0;
+    bool failed = false;
+
+    auto start_operation = [&](size_t slot) {
+        start_times[slot] = now_ns();
+        bool queued = next_is_read()
+            ? ring->enqueue_read(fd, buffers[slot].data(), random_block_size, next_offset(), slot)
+            : ring->enqueue_write(fd, buffers[slot].data(), random_block_size, next_offset(), slot);
+        if (queued)
+            ++in_flight;
+    };
+    ring->on_completion = [&](u64 slot, i32 result) {
+        --in_flight;
+        latencies_ns.append(now_ns() - start_times[slot]);
+        if (result < 0) {
+            fprintf(stderr, "random I/O: %s\n", strerror(-result));
+            failed = true;
         }
+        if (!failed && now_ns() < deadline)
+            start_operation(slot);
+    };
+
+    for (size_t slot = 0; slot < queue_depth; ++slot)
+        start_operation(slot);
+    while (in_flight) {
+        if (ring->submit() < 0 || !ring->wait_for_completions(1))
+            return false;
     }
+    return !failed;
+}
 
-    if (isatty(0)) {
-        printf("Press any key to exit...\n");
-        fgetc(stdin);
+bool fsync_benchmark(const String& filename, int time_ms, Vector<u64>& latencies_ns)
+{
+    int fd = open(filename.characters(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd == -1) {
+        perror("open");
+        return false;
+    }
+
+    auto buffer = ByteBuffer::create_uninitialized(random_block_size);
+    arc4random_buf(buffer.data(), buffer.size());
+    u64 deadline = now_ns() + (u64)time_ms * 1000000;
+    // Keep rewriting the same few blocks, so that the file stays small.
+    for (size_t i = 0; now_ns() < deadline; ++i) {
+        if (pwrite(fd, buffer.data(), buffer.size(), (i % 256) * random_block_size) < 0) {
+            perror("pwrite");
+            break;
+        }
+        u64 start = now_ns();
+        if (fsync(fd) < 0) {
+            perror("fsync");
+            break;
+        }
+        latencies_ns.append(now_ns() - start);
+    }
+
+    bool ok = now_ns() >= deadline;
+    close(fd);
+    unlink(filename.characters());
+    return ok;
+}
+
+bool metadata_benchmark(const String& directory, int file_count, Vector<u64> (&latencies_ns)[3], u64 (&elapsed_ns)[3])
+{
+    if (mkdir(directory.characters(), 0755) < 0) {
+        perror("mkdir");
+        return false;
+    }
+
+    Vector<String> paths;
+    for (int i = 0; i < file_count; ++i)
+        paths.append(String::format("%s/%d", directory.characters(), i));
+    const char data[] = "disk_benchmark";
+
+    bool ok = true;
+    u64 start = now_ns();
+    for (auto& path : paths) {
+        u64 operation_start = now_ns();
+        int fd = open(path.characters(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+        if (fd < 0 || write(fd, data, sizeof(data)) < 0 || close(fd) < 0) {
+            perror("create");
+            ok = false;
+            break;
+        }
+        latencies_ns[0].append(now_ns() - operation_start);
+    }
+    elapsed_ns[0] = now_ns() - start;
+
+    start = now_ns();
+    for (size_t i = 0; ok && i < paths.size(); ++i) {
+        u64 operation_start = now_ns();
+        struct stat st;
+        if (stat(paths[i].characters(), &st) < 0) {
+            perror("stat");
+            ok = false;
+            break;
+        }
+        latencies_ns[1].append(now_ns() - operation_start);
+    }
+    elapsed_ns[1] = now_ns() - start;
+
+    // Clean up even after a failure, but only time a complete run.
+    start = now_ns();
+    for (auto& path : paths) {
+        u64 operation_start = now_ns();
+        if (unlink(path.characters()) < 0) {
+            if (errno != ENOENT && ok) {
+                perror("unlink");
+                ok = false;
+            }
+            continue;
+        }
+        latencies_ns[2].append(now_ns() - operation_start);
+    }
+    elapsed_ns[2] = now_ns() - start;
+
+    if (rmdir(directory.characters()) < 0) {
+        perror("rmdir");
+        ok = false;
     }
+    return ok;
 }
 
 Result benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache)
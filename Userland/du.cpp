@@ -30,9 +30,9 @@
 #include <AK/Vector.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/DateTime.h>
-#include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
 #include <LibCore/Object.h>
+#include <LibThread/TreeWalker.h>
 #include <limits.h>
 #include <math.h>
 #include <stdio.h>
@@ -57,6 +57,7 @@ struct DuOption {
 
 static int parse_args(int argc, char** argv, Vector<String>& files, DuOption& du_option, int& max_depth);
 static int print_space_usage(const String& path, const DuOption& du_option, int max_depth);
+static bool print_entry(const LibThread::TreeWalker::Entry&, const DuOption&);
 
 int main(int argc, char** argv)
 {
@@ -141,33 +142,21 @@ int parse_args(int argc, char** argv, Vector<String>& files, DuOption& du_option
     return 0;
 }
 
-int print_space_usage(const String& path, const DuOption& du_option, int max_depth)
+static bool print_entry(const LibThread::TreeWalker::Entry& entry, const DuOption& du_option)
 {
+    const auto& path = entry.path;
     struct stat path_stat;
-    if (lstat(path.characters(), &path_stat) < 0) {
+    if (entry.has_stat) {
+        path_stat = entry.stat;
+    } else if (lstat(path.characters(), &path_stat) < 0) {
         perror("lstat");
-        return 1;
-    }
-
-    if (--max_depth >= 0 && S_ISDIR(path_stat.st_mode)) {
-        auto di = Core::DirIterator(path, Core::DirIterator::SkipParentAndBaseDir);
-        if (di.has_error()) {
-            fprintf(stderr, "DirIterator: %s\n", di.error_string());
-            return 1;
-        }
-        while (di.has_next()) {
-            const auto child_path = di.next_full_path();
-            if (du_option.all || Core::File::is_directory(child_path)) {
-                if (print_space_usage(child_path, du_option, max_depth))
-                    return 1;
-            }
-        }
+        return false;
     }
 
     const auto basename = LexicalPath(path).basename();
     for (const auto& pattern : du_option.excluded_patterns) {
         if (basename.matches(pattern, CaseSensitivity::CaseSensitive))
-            return 0;
+            return true;
     }
 
     long long size = path_stat.st_size;
@@ -177,7 +166,7 @@ int print_space_usage(const String& path, const DuOption& du_option, int max_dep
     }
 
     if ((du_option.threshold > 0 && size < du_option.threshold) || (du_option.threshold < 0 && size > -du_option.threshold))
-        return 0;
+        return true;
 
     const long long block_size = 1024;
     size = size / block_size + (size % block_size != 0);
@@ -200,5 +189,32 @@ int print_space_usage(const String& path, const DuOption& du_option, int max_dep
         printf("%lld\t%s\t%s\n", size, formatted_time.characters(), path.characters());
     }
 
-    return 0;
+    return true;
+}
+
+int print_space_usage(const String& path, const DuOption& du_option, int max_depth)
+{
+    bool failed = false;
+
+    // Directories are always printed, after everything in them, but other files only with --all.
+    LibThread::TreeWalker walker;
+    walker.set_max_depth(max(max_depth, 0));
+    walker.set_stat_entries(du_option.all ? LibThread::TreeWalker::StatEntries::Everything : LibThread::TreeWalker::StatEntries::Directories);
+    walker.on_entry = [&](auto& entry) {
+        if (entry.is_directory() || (entry.depth > 0 && !du_option.all))
+            return;
+        if (!print_entry(entry, du_option))
+            failed = true;
+    };
+    walker.on_leave_directory = [&](auto& entry) {
+        if (!print_entry(entry, du_option))
+            failed = true;
+    };
+    walker.on_error = [&](auto& error_path, int error) {
+        fprintf(stderr, "%s: %s\n", error_path.characters(), strerror(error));
+        failed = true;
+    };
+    walker.walk(path);
+
+    return failed ? 1 : 0;
 }
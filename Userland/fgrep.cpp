@@ -24,25 +24,89 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <assert.h>
+#include <AK/AhoCorasick.h>
+#include <AK/MemMem.h>
+#include <AK/OwnPtr.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
+static constexpr size_t block_size = 64 * KiB;
+
 int main(int argc, char** argv)
 {
     if (argc < 2) {
         printf("usage: fgrep <str>\n");
         return 0;
     }
+
+    // Like other greps, a newline separates several patterns, any of which can match.
+    auto patterns = StringView(argv[1]).split_view('\n', true);
+    if (patterns.is_empty())
+        patterns.append("");
+    OwnPtr<AhoCorasick> matcher;
+    if (patterns.size() > 1)
+        matcher = make<AhoCorasick>(patterns);
+
+    // Returns the offset of a match in the given bytes, none of which is a newline in any pattern.
+    auto find = [&](const char* text, size_t length) -> Optional<size_t> {
+        if (matcher) {
+            if (auto match = matcher->find(ReadonlyBytes { text, length }); match.has_value())
+                return match.value().offset;
+            return {};
+        }
+        if (auto* position = AK::memmem(text, length, patterns[0].characters_without_null_termination(), patterns[0].length()))
+            return (const char*)position - text;
+        return {};
+    };
+
+    // Searches whole lines in text, printing the ones with a match.
+    auto search_lines = [&](const char* text, size_t length) {
+        size_t position = 0;
+        while (position < length) {
+            auto match = find(text + position, length - position);
+            if (!match.has_value())
+                return;
+            size_t line_start = position + match.value();
+            while (line_start > position && text[line_start - 1] != '\n')
+                --line_start;
+            auto* newline = (const char*)memchr(text + line_start, '\n', length - line_start);
+            size_t line_end = newline ? newline - text + 1 : length;
+            fwrite(text + line_start, 1, line_end - line_start, stdout);
+            if (!newline)
+                putchar('\n');
+            position = line_end;
+        }
+    };
+
+    // Read big blocks and search all complete lines in them at once, carrying the rest over to the next block.
+    Vector<char> buffer;
+    buffer.resize(block_size);
+    size_t used = 0;
     for (;;) {
-        char buf[4096];
-        auto* str = fgets(buf, sizeof(buf), stdin);
-        if (str && strstr(str, argv[1]))
-            write(1, buf, strlen(buf));
-        if (feof(stdin))
-            return 0;
-        ASSERT(str);
+        if (buffer.size() - used < block_size / 2)
+            buffer.resize(buffer.size() * 2);
+        ssize_t nread = read(STDIN_FILENO, buffer.data() + used, buffer.size() - used);
+        if (nread < 0) {
+            perror("read");
+            return 1;
+        }
+        if (nread == 0)
+            break;
+        size_t searched = used;
+        used += nread;
+
+        size_t complete = used;
+        while (complete > searched && buffer[complete - 1] != '\n')
+            --complete;
+        if (complete == searched)
+            continue;
+        search_lines(buffer.data(), complete);
+        memmove(buffer.data(), buffer.data() + complete, used - complete);
+        used -= complete;
     }
+    search_lines(buffer.data(), used);
     return 0;
 }
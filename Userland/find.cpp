@@ -27,11 +27,14 @@
 #include <AK/NonnullOwnPtr.h>
 #include <AK/OwnPtr.h>
 #include <AK/Vector.h>
-#include <LibCore/DirIterator.h>
+#include <LibThread/TreeWalker.h>
+#include <dirent.h>
 #include <getopt.h>
 #include <grp.h>
 #include <pwd.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -39,6 +42,9 @@
 bool g_follow_symlinks = false;
 bool g_there_was_an_error = false;
 bool g_have_seen_action_command = false;
+bool g_needs_stat = false;
+
+using Entry = LibThread::TreeWalker::Entry;
 
 [[noreturn]] static void fatal_error(const char* format, ...)
 {
@@ -56,21 +62,24 @@ bool g_have_seen_action_command = false;
 class Command {
 public:
     virtual ~Command() { }
-    virtual bool evaluate(const char* file_path) const = 0;
+    virtual bool evaluate(const Entry&) const = 0;
 };
 
 class StatCommand : public Command {
 public:
     virtual bool evaluate(const struct stat&) const = 0;
 
-private:
-    virtual bool evaluate(const char* file_path) const override
+protected:
+    virtual bool evaluate(const Entry& entry) const override
     {
+        if (entry.has_stat)
+            return evaluate(entry.stat);
+
         struct stat stat;
         auto stat_func = g_follow_symlinks ? ::stat : ::lstat;
-        int rc = stat_func(file_path, &stat);
+        int rc = stat_func(entry.path.characters(), &stat);
         if (rc < 0) {
-            perror(file_path);
+            perror(entry.path.characters());
             g_there_was_an_error = true;
             return false;
         }
@@ -89,6 +98,31 @@ public:
     }
 
 private:
+    // The directory listing usually says what type an entry is, which saves a stat().
+    virtual bool evaluate(const Entry& entry) const override
+    {
+        if (entry.type == DT_UNKNOWN)
+            return StatCommand::evaluate(entry);
+        switch (m_type) {
+        case 'b':
+            return entry.type == DT_BLK;
+        case 'c':
+            return entry.type == DT_CHR;
+        case 'd':
+            return entry.type == DT_DIR;
+        case 'l':
+            return entry.type == DT_LNK;
+        case 'p':
+            return entry.type == DT_FIFO;
+        case 'f':
+            return entry.type == DT_REG;
+        case 's':
+            return entry.type == DT_SOCK;
+        default:
+            ASSERT_NOT_REACHED();
+        }
+    }
+
     virtual bool evaluate(const struct stat& stat) const override
     {
         auto type = stat.st_mode;
@@ -120,6 +154,7 @@ class LinksCommand final : public StatCommand {
 public:
     LinksCommand(const char* arg)
     {
+        g_needs_stat = true;
         auto number = StringView(arg).to_uint();
         if (!number.has_value())
             fatal_error("Invalid number: \033[1m%s", arg);
@@ -139,6 +174,7 @@ class UserCommand final : public StatCommand {
 public:
     UserCommand(const char* arg)
     {
+        g_needs_stat = true;
         if (struct passwd* passwd = getpwnam(arg)) {
             m_uid = passwd->pw_uid;
         } else {
@@ -163,6 +199,7 @@ class GroupCommand final : public StatCommand {
 public:
     GroupCommand(const char* arg)
     {
+        g_needs_stat = true;
         if (struct group* gr = getgrnam(arg)) {
             m_gid = gr->gr_gid;
         } else {
@@ -187,6 +224,7 @@ class SizeCommand final : public StatCommand {
 public:
     SizeCommand(const char* arg)
     {
+        g_needs_stat = true;
         StringView view = arg;
         if (view.ends_with('c')) {
             m_is_bytes = true;
@@ -220,9 +258,9 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(const Entry& entry) const override
     {
-        printf("%s%c", file_path, m_terminator);
+        printf("%s%c", entry.path.characters(), m_terminator);
         return true;
     }
 
@@ -237,8 +275,17 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(const Entry& entry) const override
     {
+        // Replace any occurrences of "{}" with the path. This happens before forking, since the
+        // directory walk has other threads that might hold the malloc lock at that point.
+        auto argv = m_argv;
+        for (auto& arg : argv) {
+            if (StringView(arg) == "{}")
+                arg = const_cast<char*>(entry.path.characters());
+        }
+        argv.append(nullptr);
+
         pid_t pid = fork();
 
         if (pid < 0) {
@@ -246,18 +293,9 @@ private:
             g_there_was_an_error = true;
             return false;
         } else if (pid == 0) {
-            // Replace any occurrences of "{}" with the path. Since we're in the
-            // child and going to exec real soon, let's just const_cast away the
-            // constness.
-            auto argv = const_cast<Vector<char*>&>(m_argv);
-            for (auto& arg : argv) {
-                if (StringView(arg) == "{}")
-                    arg = const_cast<char*>(file_path);
-            }
-            argv.append(nullptr);
-            execvp(m_argv[0], argv.data());
+            execvp(argv[0], argv.data());
             perror("execvp");
-            exit(1);
+            _exit(1);
         } else {
             int status;
             int rc = waitpid(pid, &status, 0);
@@ -282,9 +320,9 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(const Entry& entry) const override
     {
-        return m_lhs->evaluate(file_path) && m_rhs->evaluate(file_path);
+        return m_lhs->evaluate(entry) && m_rhs->evaluate(entry);
     }
 
     NonnullOwnPtr<Command> m_lhs;
@@ -300,9 +338,9 @@ public:
     }
 
 private:
-    virtual bool evaluate(const char* file_path) const override
+    virtual bool evaluate(const Entry& entry) const override
     {
-        return m_lhs->evaluate(file_path) || m_rhs->evaluate(file_path);
+        return m_lhs->evaluate(entry) || m_rhs->evaluate(entry);
     }
 
     NonnullOwnPtr<Command> m_lhs;
@@ -442,27 +480,23 @@ static const char* parse_options(int argc, char* argv[])
     }
 }
 
-static void walk_tree(const char* root_path, Command& command)
-{
-    command.evaluate(root_path);
-
-    Core::DirIterator dir_iterator(root_path, Core::DirIterator::SkipParentAndBaseDir);
-    if (dir_iterator.has_error() && dir_iterator.error() == ENOTDIR)
-        return;
-
-    while (dir_iterator.has_next())
-        walk_tree(dir_iterator.next_full_path().characters(), command);
-
-    if (dir_iterator.has_error()) {
-        fprintf(stderr, "%s: %s\n", root_path, dir_iterator.error_string());
-        g_there_was_an_error = true;
-    }
-}
-
 int main(int argc, char* argv[])
 {
     auto root_path = parse_options(argc, argv);
     auto command = parse_all_commands(argv);
-    walk_tree(root_path, *command);
+
+    LibThread::TreeWalker walker;
+    walker.set_follow_symlinks(g_follow_symlinks);
+    if (g_needs_stat)
+        walker.set_stat_entries(LibThread::TreeWalker::StatEntries::Everything);
+    walker.on_entry = [&](auto& entry) {
+        command->evaluate(entry);
+    };
+    walker.on_error = [](auto& path, int error) {
+        fprintf(stderr, "%s: %s\n", path.characters(), strerror(error));
+        g_there_was_an_error = true;
+    };
+    walker.walk(root_path);
+
     return g_there_was_an_error ? 1 : 0;
 }
@@ -24,15 +24,17 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
-#include <AK/JsonValue.h>
+#include <AK/JsonStreamReader.h>
 #include <AK/StringBuilder.h>
-#include <LibCore/File.h>
+#include <LibCore/FileStream.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 static bool use_color = false;
-static void print(const String& name, const JsonValue&, Vector<String>& trail);
+static void print_name(const Vector<String>& trail, const String& name);
 
 static const char* color_name = "";
 static const char* color_index = "";
@@ -57,14 +59,18 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    if (argc != 2) {
-        fprintf(stderr, "usage: gron <file>\n");
+    if (argc > 2) {
+        fprintf(stderr, "usage: gron [file]\n");
         return 0;
     }
-    auto file = Core::File::construct(argv[1]);
-    if (!file->open(Core::IODevice::ReadOnly)) {
-        fprintf(stderr, "Couldn't open %s for reading: %s\n", argv[1], file->error_string());
-        return 1;
+
+    int fd = STDIN_FILENO;
+    if (argc == 2) {
+        fd = open(argv[1], O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "Couldn't open %s for reading: %s\n", argv[1], strerror(errno));
+            return 1;
+        }
     }
 
     if (pledge("stdio", nullptr) < 0) {
@@ -72,10 +78,6 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    auto file_contents = file->read_all();
-    auto json = JsonValue::from_string(file_contents);
-    ASSERT(json.has_value());
-
     if (use_color) {
         color_name = "\033[33;1m";
         color_index = "\033[35;1m";
@@ -86,49 +88,84 @@ int main(int argc, char** argv)
         color_off = "\033[0m";
     }
 
+    // Walk the document token by token; only the path to the current value is kept in memory.
+    struct Container {
+        bool is_array { false };
+        int next_index { 0 };
+    };
+    Vector<Container> containers;
     Vector<String> trail;
-    print("json", json.value(), trail);
+    String key;
+
+    auto next_name = [&]() -> String {
+        if (containers.is_empty())
+            return "json";
+        if (!containers.last().is_array)
+            return key;
+        int index = containers.last().next_index++;
+        return String::format("%s%s[%s%s%d%s%s]%s", color_off, color_brace, color_off, color_index, index, color_off, color_brace, color_off);
+    };
+
+    Core::InputFileStream stream(fd);
+    JsonStreamReader reader(stream);
+    while (reader.next()) {
+        switch (reader.token()) {
+        case JsonStreamReader::Token::Key:
+            key = reader.text();
+            break;
+        case JsonStreamReader::Token::StartObject: {
+            auto name = next_name();
+            print_name(trail, name);
+            printf("%s{}%s;\n", color_brace, color_off);
+            trail.append(String::format("%s%s%s.", color_name, name.characters(), color_off));
+            containers.append({ false, 0 });
+            break;
+        }
+        case JsonStreamReader::Token::StartArray: {
+            auto name = next_name();
+            print_name(trail, name);
+            printf("%s[]%s;\n", color_brace, color_off);
+            trail.append(String::format("%s%s%s", color_name, name.characters(), color_off));
+            containers.append({ true, 0 });
+            break;
+        }
+        case JsonStreamReader::Token::EndObject:
+        case JsonStreamReader::Token::EndArray:
+            trail.take_last();
+            containers.take_last();
+            break;
+        case JsonStreamReader::Token::String:
+            print_name(trail, next_name());
+            printf("%s%s%s;\n", color_string, reader.value().serialized<StringBuilder>().characters(), color_off);
+            break;
+        case JsonStreamReader::Token::Number:
+            print_name(trail, next_name());
+            printf("%s%s%s;\n", color_index, reader.text().characters(), color_off);
+            break;
+        case JsonStreamReader::Token::True:
+        case JsonStreamReader::Token::False:
+            print_name(trail, next_name());
+            printf("%s%s%s;\n", color_bool, reader.token() == JsonStreamReader::Token::True ? "true" : "false", color_off);
+            break;
+        case JsonStreamReader::Token::Null:
+            print_name(trail, next_name());
+            printf("%snull%s;\n", color_null, color_off);
+            break;
+        }
+    }
+
+    bool read_failed = stream.handle_error();
+    if (reader.has_error() || read_failed) {
+        fprintf(stderr, "gron: Couldn't parse input as JSON\n");
+        return 1;
+    }
     return 0;
 }
 
-static void print(const String& name, const JsonValue& value, Vector<String>& trail)
+static void print_name(const Vector<String>& trail, const String& name)
 {
     for (size_t i = 0; i < trail.size(); ++i)
         printf("%s", trail[i].characters());
 
     printf("%s%s%s = ", color_name, name.characters(), color_off);
-
-    if (value.is_object()) {
-        printf("%s{}%s;\n", color_brace, color_off);
-        trail.append(String::format("%s%s%s.", color_name, name.characters(), color_off));
-        value.as_object().for_each_member([&](auto& on, auto& ov) { print(on, ov, trail); });
-        trail.take_last();
-        return;
-    }
-    if (value.is_array()) {
-        printf("%s[]%s;\n", color_brace, color_off);
-        trail.append(String::format("%s%s%s", color_name, name.characters(), color_off));
-        for (int i = 0; i < value.as_array().size(); ++i) {
-            auto element_name = String::format("%s%s[%s%s%d%s%s]%s", color_off, color_brace, color_off, color_index, i, color_off, color_brace, color_off);
-            print(element_name, value.as_array()[i], trail);
-        }
-        trail.take_last();
-        return;
-    }
-    switch (value.type()) {
-    case JsonValue::Type::Null:
-        printf("%s", color_null);
-        break;
-    case JsonValue::Type::Bool:
-        printf("%s", color_bool);
-        break;
-    case JsonValue::Type::String:
-        printf("%s", color_string);
-        break;
-    default:
-        printf("%s", color_index);
-        break;
-    }
-
-    printf("%s%s;\n", value.serialized<StringBuilder>().characters(), color_off);
 }
@@ -24,16 +24,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/JsonArray.h>
-#include <AK/JsonObject.h>
-#include <AK/JsonValue.h>
-#include <AK/StringBuilder.h>
+#include <AK/JsonStreamReader.h>
 #include <LibCore/ArgsParser.h>
-#include <LibCore/File.h>
+#include <LibCore/FileStream.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
-static void print(const JsonValue& value, int indent = 0);
 static void print_indent(int indent)
 {
     for (int i = 0; i < indent; ++i)
@@ -50,13 +48,16 @@ int main(int argc, char** argv)
     const char* path = nullptr;
 
     Core::ArgsParser args_parser;
-    args_parser.add_positional_argument(path, "Path to JSON file", "path");
+    args_parser.add_positional_argument(path, "Path to JSON file (standard input if omitted)", "path", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
-    auto file = Core::File::construct(path);
-    if (!file->open(Core::IODevice::ReadOnly)) {
-        fprintf(stderr, "Couldn't open %s for reading: %s\n", path, file->error_string());
-        return 1;
+    int fd = STDIN_FILENO;
+    if (path) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "Couldn't open %s for reading: %s\n", path, strerror(errno));
+            return 1;
+        }
     }
 
     if (pledge("stdio", nullptr) < 0) {
@@ -64,56 +65,74 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    auto file_contents = file->read_all();
-    auto json = JsonValue::from_string(file_contents);
-    if (!json.has_value()) {
-        fprintf(stderr, "Couldn't parse %s as JSON\n", path);
+    // Print tokens as they arrive instead of parsing into a JsonValue first,
+    // so memory use doesn't grow with the size of the document.
+    Core::InputFileStream stream(fd);
+    JsonStreamReader reader(stream);
+
+    int indent = 0;
+    bool after_key = false;
+    auto begin_value = [&] {
+        if (indent > 0 && !after_key)
+            print_indent(indent);
+        after_key = false;
+    };
+    auto end_value = [&] {
+        if (indent > 0)
+            printf(",\n");
+    };
+
+    while (reader.next()) {
+        switch (reader.token()) {
+        case JsonStreamReader::Token::Key:
+            print_indent(indent);
+            printf("\"\033[33;1m%s\033[0m\": ", reader.text().characters());
+            after_key = true;
+            break;
+        case JsonStreamReader::Token::StartObject:
+        case JsonStreamReader::Token::StartArray:
+            begin_value();
+            printf(reader.token() == JsonStreamReader::Token::StartObject ? "{\n" : "[\n");
+            ++indent;
+            break;
+        case JsonStreamReader::Token::EndObject:
+        case JsonStreamReader::Token::EndArray:
+            --indent;
+            print_indent(indent);
+            printf(reader.token() == JsonStreamReader::Token::EndObject ? "}" : "]");
+            end_value();
+            break;
+        case JsonStreamReader::Token::String:
+            begin_value();
+            printf("\033[31;1m\"%s\"\033[0m", reader.text().characters());
+            end_value();
+            break;
+        case JsonStreamReader::Token::Number:
+            begin_value();
+            printf("\033[35;1m%s\033[0m", reader.text().characters());
+            end_value();
+            break;
+        case JsonStreamReader::Token::True:
+        case JsonStreamReader::Token::False:
+            begin_value();
+            printf("\033[32;1m%s\033[0m", reader.token() == JsonStreamReader::Token::True ? "true" : "false");
+            end_value();
+            break;
+        case JsonStreamReader::Token::Null:
+            begin_value();
+            printf("\033[34;1mnull\033[0m");
+            end_value();
+            break;
+        }
+    }
+
+    bool read_failed = stream.handle_error();
+    if (reader.has_error() || read_failed) {
+        printf("\n");
+        fprintf(stderr, "Couldn't parse %s as JSON\n", path ? path : "standard input");
         return 1;
     }
 
-    print(json.value());
     printf("\n");
-
     return 0;
 }
-
-void print(const JsonValue& value, int indent)
-{
-    if (value.is_object()) {
-        printf("{\n");
-        value.as_object().for_each_member([&](auto& member_name, auto& member_value) {
-            print_indent(indent + 1);
-            printf("\"\033[33;1m%s\033[0m\": ", member_name.characters());
-            print(member_value, indent + 1);
-            printf(",\n");
-        });
-        print_indent(indent);
-        printf("}");
-        return;
-    }
-    if (value.is_array()) {
-        printf("[\n");
-        value.as_array().for_each([&](auto& entry_value) {
-            print_indent(indent + 1);
-            print(entry_value, indent + 1);
-            printf(",\n");
-        });
-        print_indent(indent);
-        printf("]");
-        return;
-    }
-    if (value.is_string())
-        printf("\033[31;1m");
-    else if (value.is_number())
-        printf("\033[35;1m");
-    else if (value.is_bool())
-        printf("\033[32;1m");
-    else if (value.is_null())
-        printf("\033[34;1m");
-    if (value.is_string())
-        putchar('"');
-    printf("%s", value.to_string().characters());
-    if (value.is_string())
-        putchar('"');
-    printf("\033[0m");
-}
@@ -66,6 +66,7 @@ private:
 
 static bool s_dump_ast = false;
 static bool s_print_last_result = false;
+static bool s_lazy_function_parsing = false;
 static RefPtr<Line::Editor> s_editor;
 static int s_repl_line_level = 0;
 static bool s_fail_repl = false;
@@ -335,9 +336,25 @@ static bool write_to_file(const StringView& path)
     return true;
 }
 
+static bool write_profile(const JS::Profiler& profiler, const String& path, const String& script_name)
+{
+    auto file = Core::File::construct(path);
+    if (!file->open(Core::IODevice::WriteOnly)) {
+        fprintf(stderr, "Failed to open %s: %s\n", path.characters(), file->error_string());
+        return false;
+    }
+    auto json = profiler.to_json(script_name);
+    if (!file->write(json)) {
+        fprintf(stderr, "Failed to write profile to %s\n", path.characters());
+        return false;
+    }
+    return true;
+}
+
 static bool parse_and_run(JS::Interpreter& interpreter, const StringView& source)
 {
     auto parser = JS::Parser(JS::Lexer(source));
+    parser.set_lazy_function_parsing(s_lazy_function_parsing);
     auto program = parser.parse_program();
 
     if (s_dump_ast)
@@ -534,19 +551,49 @@ public:
         }
         return JS::js_undefined();
     }
+    virtual JS::Value profile() override
+    {
+        auto label = interpreter().argument_count() ? interpreter().argument(0).to_string_without_side_effects() : "default";
+        if (!m_console.profile_start(label)) {
+            printf("\033[33;1m");
+            printf("A profile is already being recorded\n");
+            printf("\033[0m");
+        }
+        return JS::js_undefined();
+    }
+    virtual JS::Value profile_end() override
+    {
+        auto label = interpreter().argument_count() ? interpreter().argument(0).to_string_without_side_effects() : "default";
+        auto profiler = m_console.profile_stop(label);
+        if (!profiler) {
+            printf("\033[33;1m");
+            printf("No profile named \"%s\" is being recorded\n", label.characters());
+            printf("\033[0m");
+            return JS::js_undefined();
+        }
+        auto path = String::format("%s.jsprofile", label.characters());
+        if (write_profile(*profiler, path, label))
+            printf("Profile \"%s\" with %zu samples written to %s\n", label.characters(), profiler->sample_count(), path.characters());
+        return JS::js_undefined();
+    }
 };
 
 int main(int argc, char** argv)
 {
     bool gc_on_every_allocation = false;
+    bool use_bytecode = false;
     bool disable_syntax_highlight = false;
     const char* script_path = nullptr;
+    const char* profile_path = nullptr;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(s_dump_ast, "Dump the AST", "dump-ast", 'A');
     args_parser.add_option(s_print_last_result, "Print last result", "print-last-result", 'l');
     args_parser.add_option(gc_on_every_allocation, "GC on every allocation", "gc-on-every-allocation", 'g');
+    args_parser.add_option(use_bytecode, "Run functions through the bytecode interpreter", "bytecode", 'b');
+    args_parser.add_option(s_lazy_function_parsing, "Parse function bodies when they're first called", "lazy-parse", 'L');
     args_parser.add_option(disable_syntax_highlight, "Disable live syntax highlighting", "no-syntax-highlight", 's');
+    args_parser.add_option(profile_path, "Write a sampling profile of the script to a file", "profile", 'P', "path");
     args_parser.add_positional_argument(script_path, "Path to script file", "script", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
@@ -565,6 +612,7 @@ int main(int argc, char** argv)
         ReplConsoleClient console_client(interpreter->console());
         interpreter->console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->set_bytecode_enabled(use_bytecode);
         interpreter->set_underscore_is_last_value(true);
 
         s_editor = Line::Editor::construct();
@@ -846,6 +894,7 @@ int main(int argc, char** argv)
         ReplConsoleClient console_client(interpreter->console());
         interpreter->console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->set_bytecode_enabled(use_bytecode);
 
         signal(SIGINT, [](int) {
             sigint_handler();
@@ -865,7 +914,14 @@ int main(int argc, char** argv)
             source = file_contents;
         }
 
-        if (!parse_and_run(*interpreter, source))
+        if (profile_path)
+            interpreter->start_profiling();
+        bool success = parse_and_run(*interpreter, source);
+        if (profile_path) {
+            if (auto profiler = interpreter->stop_profiling(); !profiler || !write_profile(*profiler, profile_path, script_path))
+                return 1;
+        }
+        if (!success)
             return 1;
     }
 
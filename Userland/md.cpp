@@ -30,6 +30,7 @@
 #include <LibCore/ArgsParser.h>
 #include <LibCore/File.h>
 #include <LibMarkdown/Document.h>
+#include <LibMarkdown/Parser.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -66,17 +67,36 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    auto buffer = file->read_all();
-    dbg() << "Read size " << buffer.size();
+    // Print every block as soon as it's been read, instead of waiting for the whole file.
+    Markdown::Parser parser;
+    parser.on_block = [&](auto block) {
+        auto rendered = html ? block->render_to_html() : block->render_for_terminal();
+        printf("%s", rendered.characters());
+    };
 
-    auto input = String::copy(buffer);
-    auto document = Markdown::Document::parse(input);
+    if (html)
+        printf("%s", String(Markdown::Document::html_prologue()).characters());
 
-    if (!document) {
+    for (;;) {
+        auto buffer = file->read(BUFSIZ);
+        if (buffer.is_empty())
+            break;
+        if (!parser.write({ (const char*)buffer.data(), buffer.size() })) {
+            fprintf(stderr, "Error parsing\n");
+            return 1;
+        }
+        fflush(stdout);
+    }
+    if (file->error()) {
+        fprintf(stderr, "Error: %s\n", file->error_string());
+        return 1;
+    }
+    if (!parser.finish()) {
         fprintf(stderr, "Error parsing\n");
         return 1;
     }
 
-    String res = html ? document->render_to_html() : document->render_for_terminal();
-    printf("%s", res.characters());
+    if (html)
+        printf("%s", String(Markdown::Document::html_epilogue()).characters());
+    return 0;
 }
@@ -50,7 +50,7 @@ int main(int argc, char** argv)
     Core::EventLoop loop;
     auto protocol_client = Protocol::Client::construct();
 
-    auto download = protocol_client->start_download(url.to_string());
+    auto download = protocol_client->start_download(url.to_string(), {}, true);
     if (!download) {
         fprintf(stderr, "Failed to start download for '%s'\n", url_str);
         return 1;
@@ -79,9 +79,15 @@ int main(int argc, char** argv)
         previous_downloaded_size = downloaded_size;
         prev_time = current_time;
     };
+    // Write the data out as it arrives, instead of holding on to all of it until the end.
+    download->set_should_buffer_streamed_data(false);
+    download->on_data_received = [&](auto data) {
+        write(STDOUT_FILENO, data.data(), data.size());
+    };
     download->on_finish = [&](bool success, auto& payload, auto, auto&, auto) {
         fprintf(stderr, "\033]9;-1;\033\\");
         fprintf(stderr, "\n");
+        // Protocols that can't stream still deliver everything at once.
         if (success)
             write(STDOUT_FILENO, payload.data(), payload.size());
         else
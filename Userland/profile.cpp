@@ -30,6 +30,19 @@
 #include <stdlib.h>
 #include <string.h>
 
+static int counter_from_name(const StringView& name)
+{
+    if (name == "cycles")
+        return PERF_COUNTER_CYCLES;
+    if (name == "instructions")
+        return PERF_COUNTER_INSTRUCTIONS;
+    if (name == "cache-misses")
+        return PERF_COUNTER_CACHE_MISSES;
+    if (name == "branch-misses")
+        return PERF_COUNTER_BRANCH_MISSES;
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
     Core::ArgsParser args_parser;
@@ -38,11 +51,17 @@ int main(int argc, char** argv)
     const char* cmd_argument = nullptr;
     bool enable = false;
     bool disable = false;
+    const char* counter_argument = nullptr;
+    int period = 100000;
+    bool off_cpu = false;
 
     args_parser.add_option(pid_argument, "Target PID", nullptr, 'p', "PID");
     args_parser.add_option(enable, "Enable", nullptr, 'e');
     args_parser.add_option(disable, "Disable", nullptr, 'd');
     args_parser.add_option(cmd_argument, "Command", nullptr, 'c', "command");
+    args_parser.add_option(counter_argument, "Sample a hardware counter instead of the timer (cycles, instructions, cache-misses, branch-misses)", nullptr, 'x', "counter");
+    args_parser.add_option(period, "Events per counter sample", nullptr, 'n', "period");
+    args_parser.add_option(off_cpu, "Also record where threads block, and for how long", nullptr, 'o');
 
     args_parser.parse(argc, argv);
 
@@ -51,6 +70,15 @@ int main(int argc, char** argv)
         return 0;
     }
 
+    int counter = 0;
+    if (counter_argument) {
+        counter = counter_from_name(counter_argument);
+        if (!counter) {
+            fprintf(stderr, "Unknown counter '%s'.\n", counter_argument);
+            return 1;
+        }
+    }
+
     if (pid_argument) {
         if (!(enable ^ disable)) {
             fprintf(stderr, "-p <PID> requires -e xor -d.\n");
@@ -59,6 +87,19 @@ int main(int argc, char** argv)
 
         pid_t pid = atoi(pid_argument);
 
+        if (off_cpu && perf_off_cpu_tracing(pid, enable) < 0) {
+            perror("perf_off_cpu_tracing");
+            return 1;
+        }
+
+        if (counter) {
+            if (perf_counter_sampling(pid, enable ? counter : 0, period) < 0) {
+                perror("perf_counter_sampling");
+                return 1;
+            }
+            return 0;
+        }
+
         if (enable) {
             if (profiling_enable(pid) < 0) {
                 perror("profiling_enable");
@@ -84,7 +125,18 @@ int main(int argc, char** argv)
     cmd_argv.append(nullptr);
 
     dbg() << "Enabling profiling for PID " << getpid();
-    profiling_enable(getpid());
+    if (off_cpu && perf_off_cpu_tracing(getpid(), true) < 0) {
+        perror("perf_off_cpu_tracing");
+        return 1;
+    }
+    if (counter) {
+        if (perf_counter_sampling(getpid(), counter, period) < 0) {
+            perror("perf_counter_sampling");
+            return 1;
+        }
+    } else {
+        profiling_enable(getpid());
+    }
     if (execvp(cmd_argv[0], const_cast<char**>(cmd_argv.data())) < 0) {
         perror("execv");
         return 1;
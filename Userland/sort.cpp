@@ -24,40 +24,397 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/QuickSort.h>
 #include <AK/String.h>
+#include <AK/StringView.h>
 #include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibThread/ParallelSort.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+// Where a sort key starts and ends, as given to -k. Fields and characters count from 1;
+// an end field of 0 means the end of the line, and an end character of 0 the end of its field.
+struct KeySpec {
+    size_t start_field { 1 };
+    size_t start_character { 1 };
+    size_t end_field { 0 };
+    size_t end_character { 0 };
+};
+
+static bool s_has_key = false;
+static KeySpec s_key;
+static char s_separator = 0;
+
+struct Line {
+    StringView text;
+    StringView key;
+};
+
+static bool is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+// Finds field `index' (counting from 0). Without -t, every field takes the blanks in front of it along.
+static void find_field(const StringView& line, size_t index, size_t& start, size_t& end)
+{
+    size_t position = 0;
+    for (size_t field = 0;; ++field) {
+        size_t field_start = position;
+        if (s_separator) {
+            while (position < line.length() && line[position] != s_separator)
+                ++position;
+        } else {
+            while (position < line.length() && is_blank(line[position]))
+                ++position;
+            while (position < line.length() && !is_blank(line[position]))
+                ++position;
+        }
+        if (field == index) {
+            start = field_start;
+            end = position;
+            return;
+        }
+        if (position >= line.length()) {
+            start = end = line.length();
+            return;
+        }
+        if (s_separator)
+            ++position;
+    }
+}
+
+// The key is a slice of the line itself, so nothing gets copied. Like in other sorts, character
+// positions that go past the end of their field carry on into the fields after it.
+static StringView key_of(const StringView& line)
+{
+    size_t field_start, field_end;
+    find_field(line, s_key.start_field - 1, field_start, field_end);
+    size_t key_start = min(field_start + s_key.start_character - 1, line.length());
+
+    size_t key_end = line.length();
+    if (s_key.end_field) {
+        find_field(line, s_key.end_field - 1, field_start, field_end);
+        key_end = s_key.end_character ? min(field_start + s_key.end_character, line.length()) : field_end;
+    }
+    if (key_end <= key_start)
+        return line.substring_view(key_start, 0);
+    return line.substring_view(key_start, key_end - key_start);
+}
+
+static Line make_line(const StringView& text)
+{
+    return { text, s_has_key ? key_of(text) : text };
+}
+
+static int compare(const StringView& a, const StringView& b)
+{
+    size_t length = min(a.length(), b.length());
+    if (length) {
+        int result = memcmp(a.characters_without_null_termination(), b.characters_without_null_termination(), length);
+        if (result)
+            return result;
+    }
+    if (a.length() == b.length())
+        return 0;
+    return a.length() < b.length() ? -1 : 1;
+}
+
+// Lines with equal keys fall back to comparing the whole line.
+static bool less_than(const Line& a, const Line& b)
+{
+    if (s_has_key) {
+        int result = compare(a.key, b.key);
+        if (result)
+            return result < 0;
+    }
+    return compare(a.text, b.text) < 0;
+}
+
+static bool parse_position(const char*& string, size_t& field, size_t& character)
+{
+    char* end;
+    field = strtoul(string, &end, 10);
+    if (end == string)
+        return false;
+    string = end;
+    if (*string == '.') {
+        ++string;
+        character = strtoul(string, &end, 10);
+        if (end == string)
+            return false;
+        string = end;
+    }
+    return true;
+}
+
+// Parses "field[.character][,field[.character]]".
+static bool parse_key(const char* string, KeySpec& key)
+{
+    if (!parse_position(string, key.start_field, key.start_character) || !key.start_field || !key.start_character)
+        return false;
+    if (*string == ',') {
+        ++string;
+        if (!parse_position(string, key.end_field, key.end_character) || !key.end_field)
+            return false;
+    }
+    return !*string;
+}
+
+// Parses a size with an optional K, M or G suffix. Plain numbers are in KiB, like in other sorts.
+static bool parse_size(const char* string, size_t& size)
+{
+    char* end;
+    size = strtoul(string, &end, 10);
+    if (end == string)
+        return false;
+    switch (*end) {
+    case 'b':
+        break;
+    case 'K':
+    case 'k':
+    case '\0':
+        size *= KiB;
+        break;
+    case 'M':
+    case 'm':
+        size *= MiB;
+        break;
+    case 'G':
+    case 'g':
+        size *= GiB;
+        break;
+    default:
+        return false;
+    }
+    return !*end || !end[1];
+}
+
+// A sorted run of lines, along with the storage they point into.
+struct Run {
+    Vector<char> storage;
+    Vector<Line> lines;
+};
+
+// Reads lines until they (and their bookkeeping) take up roughly `budget' bytes.
+// Returns false once the input is exhausted and nothing was read.
+static bool read_run(FILE* input, size_t budget, Run& run, char*& buffer, size_t& capacity)
+{
+    run.storage.clear_with_capacity();
+    run.lines.clear_with_capacity();
+
+    // The lines can't point into the storage until it's done growing, so remember their offsets for now.
+    Vector<size_t> ends;
+    while (run.storage.size() + ends.size() * (sizeof(Line) + sizeof(size_t)) < budget) {
+        ssize_t length = getline(&buffer, &capacity, input);
+        if (length < 0)
+            break;
+        if (length && buffer[length - 1] == '\n')
+            --length;
+        run.storage.append(buffer, length);
+        ends.append(run.storage.size());
+    }
+    if (ends.is_empty())
+        return false;
+
+    run.lines.ensure_capacity(ends.size());
+    size_t start = 0;
+    for (auto end : ends) {
+        run.lines.unchecked_append(make_line({ run.storage.data() + start, end - start }));
+        start = end;
+    }
+    LibThread::parallel_sort(run.lines, less_than);
+    return true;
+}
+
+static void write_lines(FILE* output, const Vector<Line>& lines)
+{
+    for (auto& line : lines) {
+        fwrite(line.text.characters_without_null_termination(), 1, line.text.length(), output);
+        fputc('\n', output);
+    }
+}
+
+// Reads one of the spilled runs back, a line at a time.
+struct RunReader {
+    FILE* file { nullptr };
+    char* buffer { nullptr };
+    size_t capacity { 0 };
+    Line line;
+
+    bool read_next()
+    {
+        ssize_t length = getline(&buffer, &capacity, file);
+        if (length < 0)
+            return false;
+        if (length && buffer[length - 1] == '\n')
+            --length;
+        line = make_line({ buffer, (size_t)length });
+        return true;
+    }
+};
+
+// Merges the runs through a min-heap of the readers, ordered by their current line.
+static void merge_runs(Vector<FILE*>& files, FILE* output)
+{
+    Vector<RunReader> readers;
+    readers.resize(files.size());
+    Vector<size_t> heap;
+    for (size_t i = 0; i < files.size(); ++i) {
+        rewind(files[i]);
+        readers[i].file = files[i];
+        if (readers[i].read_next())
+            heap.append(i);
+    }
+
+    auto heap_less_than = [&](size_t a, size_t b) { return less_than(readers[heap[a]].line, readers[heap[b]].line); };
+    auto sift_down = [&](size_t index) {
+        for (;;) {
+            size_t smallest = index;
+            size_t left = 2 * index + 1;
+            size_t right = left + 1;
+            if (left < heap.size() && heap_less_than(left, smallest))
+                smallest = left;
+            if (right < heap.size() && heap_less_than(right, smallest))
+                smallest = right;
+            if (smallest == index)
+                return;
+            swap(heap[index], heap[smallest]);
+            index = smallest;
+        }
+    };
+
+    for (size_t i = heap.size() / 2; i > 0; --i)
+        sift_down(i - 1);
+
+    while (!heap.is_empty()) {
+        auto& reader = readers[heap[0]];
+        fwrite(reader.line.text.characters_without_null_termination(), 1, reader.line.text.length(), output);
+        fputc('\n', output);
+        if (!reader.read_next()) {
+            heap[0] = heap.last();
+            heap.take_last();
+        }
+        sift_down(0);
+    }
+
+    for (auto& reader : readers) {
+        free(reader.buffer);
+        fclose(reader.file);
+    }
+}
+
+// The most runs merged in one go, which keeps the number of open temporary files in check. Once a level
+// has this many runs, they get merged into a single run on the next level, so each level holds runs that
+// are this many times longer than the ones below it.
+static constexpr size_t max_merge_width = 16;
+
+static FILE* spill(const Vector<Line>& lines)
+{
+    auto* file = tmpfile();
+    if (!file) {
+        perror("tmpfile");
+        exit(1);
+    }
+    write_lines(file, lines);
+    if (ferror(file) || fflush(file) != 0) {
+        perror("sort: Writing a temporary file");
+        exit(1);
+    }
+    return file;
+}
+
+static void add_spilled_run(Vector<Vector<FILE*>>& levels, FILE* file)
+{
+    for (size_t level = 0;; ++level) {
+        if (level == levels.size())
+            levels.append(Vector<FILE*>());
+        levels[level].append(file);
+        if (levels[level].size() < max_merge_width)
+            return;
+
+        file = tmpfile();
+        if (!file) {
+            perror("tmpfile");
+            exit(1);
+        }
+        merge_runs(levels[level], file);
+        if (ferror(file) || fflush(file) != 0) {
+            perror("sort: Writing a temporary file");
+            exit(1);
+        }
+        levels[level].clear();
+    }
+}
 
 int main(int argc, char** argv)
 {
-    if (pledge("stdio", nullptr) > 0) {
+    if (pledge("stdio rpath wpath cpath thread", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
 
-    UNUSED_PARAM(argc);
-    UNUSED_PARAM(argv);
+    if (unveil("/tmp", "rwc") < 0) {
+        perror("unveil");
+        return 1;
+    }
+
+    if (unveil(nullptr, nullptr) < 0) {
+        perror("unveil");
+        return 1;
+    }
+
+    const char* key = nullptr;
+    const char* separator = nullptr;
+    const char* buffer_size = nullptr;
 
-    Vector<String> lines;
+    Core::ArgsParser args_parser;
+    args_parser.add_option(key, "Sort by a key, given as field[.char][,field[.char]]", "key", 'k', "keydef");
+    args_parser.add_option(separator, "Use this character to separate fields, instead of runs of blanks", "field-separator", 't', "char");
+    args_parser.add_option(buffer_size, "Memory to use before spilling sorted runs to temporary files (default: 16M)", "buffer-size", 'S', "size");
+    args_parser.parse(argc, argv);
 
-    for (;;) {
-        char buffer[BUFSIZ];
-        auto* str = fgets(buffer, sizeof(buffer), stdin);
-        if (!str)
-            break;
-        lines.append(buffer);
+    if (key) {
+        if (!parse_key(key, s_key)) {
+            fprintf(stderr, "sort: Invalid key '%s'\n", key);
+            return 1;
+        }
+        s_has_key = true;
     }
 
-    quick_sort(lines, [](auto& a, auto& b) {
-        return strcmp(a.characters(), b.characters()) < 0;
-    });
+    if (separator) {
+        if (strlen(separator) != 1) {
+            fprintf(stderr, "sort: The field separator has to be a single character\n");
+            return 1;
+        }
+        s_separator = separator[0];
+    }
 
-    for (auto& line : lines) {
-        fputs(line.characters(), stdout);
+    size_t budget = 16 * MiB;
+    if (buffer_size && (!parse_size(buffer_size, budget) || !budget)) {
+        fprintf(stderr, "sort: Invalid buffer size '%s'\n", buffer_size);
+        return 1;
+    }
+
+    char* line_buffer = nullptr;
+    size_t line_capacity = 0;
+    Run run;
+    Vector<Vector<FILE*>> levels;
+    while (read_run(stdin, budget, run, line_buffer, line_capacity)) {
+        if (levels.is_empty() && feof(stdin)) {
+            // Everything fit into memory, so there's nothing to merge.
+            write_lines(stdout, run.lines);
+            return 0;
+        }
+        add_spilled_run(levels, spill(run.lines));
     }
+    free(line_buffer);
 
+    Vector<FILE*> spilled_runs;
+    for (auto& level : levels)
+        spilled_runs.append(level.data(), level.size());
+    merge_runs(spilled_runs, stdout);
     return 0;
 }
@@ -25,11 +25,20 @@
  */
 
 #include <AK/Assertions.h>
+#include <AK/HashMap.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
 #include <AK/LogStream.h>
+#include <AK/QuickSort.h>
+#include <AK/StringView.h>
 #include <AK/Types.h>
 #include <Kernel/API/Syscall.h>
 #include <LibC/sys/arch/i386/regs.h>
 #include <LibCore/ArgsParser.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <serenity.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -39,6 +48,7 @@
 #include <unistd.h>
 
 static int g_pid = -1;
+static volatile bool g_interrupted = false;
 
 static void handle_sigint(int)
 {
@@ -50,17 +60,197 @@ static void handle_sigint(int)
     }
 }
 
+static void handle_sigint_while_recording(int)
+{
+    g_interrupted = true;
+}
+
+struct SyscallSummary {
+    u32 function { 0 };
+    u32 calls { 0 };
+    u32 errors { 0 };
+    u64 total_ns { 0 };
+};
+
+static void print_summary(const HashMap<u32, SyscallSummary>& summaries)
+{
+    Vector<SyscallSummary> sorted;
+    u64 total_ns = 0;
+    u32 total_calls = 0;
+    u32 total_errors = 0;
+    for (auto& it : summaries) {
+        sorted.append(it.value);
+        total_ns += it.value.total_ns;
+        total_calls += it.value.calls;
+        total_errors += it.value.errors;
+    }
+    quick_sort(sorted.begin(), sorted.end(), [](auto& a, auto& b) { return a.total_ns > b.total_ns; });
+
+    fprintf(stderr, "%% time     seconds  usecs/call     calls    errors syscall\n");
+    fprintf(stderr, "------ ----------- ----------- --------- --------- ----------------\n");
+    for (auto& summary : sorted) {
+        fprintf(stderr, "%6.2f %11.6f %11llu %9u %9s %s\n",
+            total_ns ? 100.0 * summary.total_ns / total_ns : 0.0,
+            summary.total_ns / 1e9,
+            summary.total_ns / summary.calls / 1000,
+            summary.calls,
+            summary.errors ? String::number(summary.errors).characters() : "",
+            Syscall::to_string((Syscall::Function)summary.function));
+    }
+    fprintf(stderr, "------ ----------- ----------- --------- --------- ----------------\n");
+    fprintf(stderr, "100.00 %11.6f %11s %9u %9u total\n", total_ns / 1e9, "", total_calls, total_errors);
+}
+
+static void handle_syscall_event(const JsonObject& event, bool summarize, HashMap<u32, SyscallSummary>& summaries)
+{
+    if (event.get("type").as_string_or({}) != "syscall")
+        return;
+
+    u32 function = event.get("function").to_u32();
+    i32 return_value = event.get("return_value").to_i32();
+    if (!summarize) {
+        auto arguments = event.get("arguments");
+        fprintf(stderr, "%s(0x%x, 0x%x, 0x%x)\t=%d\n",
+            Syscall::to_string((Syscall::Function)function),
+            arguments.as_array().at(0).to_u32(),
+            arguments.as_array().at(1).to_u32(),
+            arguments.as_array().at(2).to_u32(),
+            return_value);
+        return;
+    }
+
+    auto& summary = summaries.ensure(function);
+    summary.function = function;
+    ++summary.calls;
+    // Pointers (e.g. from mmap) can look negative too, so only the errno range counts as an error.
+    if (return_value < 0 && return_value > -4096)
+        ++summary.errors;
+    summary.total_ns += event.get("duration_ns").to_number<u64>();
+}
+
+// Has the kernel log finished syscalls into the process's perf event buffer and reads them back,
+// without ever stopping the process like ptrace does.
+static int record_syscalls(bool summarize, int start_fd)
+{
+    if (perf_syscall_tracing(g_pid, 1) < 0) {
+        perror("perf_syscall_tracing");
+        return 1;
+    }
+    int fd = perf_event_stream(g_pid);
+    if (fd < 0) {
+        perror("perf_event_stream");
+        return 1;
+    }
+
+    if (start_fd != -1) {
+        // Lets the spawned child go on to exec its program now that it's being recorded.
+        char go = 0;
+        if (write(start_fd, &go, 1) < 0) {
+            perror("write");
+            return 1;
+        }
+        close(start_fd);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(struct sigaction));
+    sa.sa_handler = handle_sigint_while_recording;
+    sigaction(SIGINT, &sa, nullptr);
+
+    HashMap<u32, SyscallSummary> summaries;
+    StringBuilder line;
+    char buffer[BUFSIZ];
+    while (!g_interrupted) {
+        ssize_t nread = read(fd, buffer, sizeof(buffer));
+        if (nread < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            perror("read");
+            return 1;
+        }
+        if (nread == 0)
+            break;
+        for (ssize_t i = 0; i < nread; ++i) {
+            if (buffer[i] != '\n') {
+                line.append(buffer[i]);
+                continue;
+            }
+            auto event = JsonValue::from_string(line.string_view());
+            line.clear();
+            if (event.has_value() && event.value().is_object())
+                handle_syscall_event(event.value().as_object(), summarize, summaries);
+        }
+    }
+
+    // The process may have exited already, in which case there's nothing left to turn off.
+    if (g_interrupted && perf_syscall_tracing(g_pid, 0) < 0)
+        perror("perf_syscall_tracing");
+    close(fd);
+
+    if (summarize)
+        print_summary(summaries);
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
     Vector<const char*> child_argv;
     bool spawned_new_process = false;
+    bool no_stop = false;
+    bool summarize = false;
 
     Core::ArgsParser parser;
     parser.add_option(g_pid, "Trace the given PID", "pid", 'p', "pid");
+    parser.add_option(no_stop, "Record syscalls in the kernel instead of stopping on each one", "no-stop", 'n');
+    parser.add_option(summarize, "Count time, calls and errors of each syscall and print a summary (implies -n)", "summary", 'c');
     parser.add_positional_argument(child_argv, "Arguments to exec", "argument", Core::ArgsParser::Required::No);
 
     parser.parse(argc, argv);
 
+    if (summarize)
+        no_stop = true;
+
+    if (no_stop) {
+        if (g_pid != -1)
+            return record_syscalls(summarize, -1);
+
+        if (child_argv.is_empty()) {
+            fprintf(stderr, "strace: Expected either a pid or some arguments\n");
+            return 1;
+        }
+
+        child_argv.append(nullptr);
+        int start_pipe[2];
+        if (pipe2(start_pipe, O_CLOEXEC) < 0) {
+            perror("pipe2");
+            return 1;
+        }
+        int pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+
+        if (!pid) {
+            close(start_pipe[1]);
+            char go;
+            if (read(start_pipe[0], &go, 1) != 1)
+                exit(1);
+            int rc = execvp(child_argv.first(), const_cast<char**>(child_argv.data()));
+            if (rc < 0) {
+                perror("execvp");
+                exit(1);
+            }
+            ASSERT_NOT_REACHED();
+        }
+
+        close(start_pipe[0]);
+        g_pid = pid;
+        int rc = record_syscalls(summarize, start_pipe[1]);
+        waitpid(pid, nullptr, 0);
+        return rc;
+    }
+
     if (g_pid == -1) {
         if (child_argv.is_empty()) {
             fprintf(stderr, "strace: Expected either a pid or some arguments\n");
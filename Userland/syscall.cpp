@@ -34,7 +34,7 @@
 #include <unistd.h>
 
 #if !defined __ENUMERATE_SYSCALL
-#    define __ENUMERATE_SYSCALL(x) SC_##x,
+#    define __ENUMERATE_SYSCALL(x, needs_lock) SC_##x,
 #endif
 
 #define SC_NARG 4
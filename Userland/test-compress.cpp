@@ -27,7 +27,9 @@
 #include <AK/TestSuite.h>
 
 #include <LibCompress/Deflate.h>
+#include <LibCompress/Gzip.h>
 #include <LibCompress/Zlib.h>
+#include <LibCore/Gzip.h>
 
 bool compare(ReadonlyBytes lhs, ReadonlyBytes rhs)
 {
@@ -53,7 +55,32 @@ TEST_CASE(deflate_decompress_compressed_block)
     const u8 uncompressed[] = "This is a simple text file :)";
 
     const auto decompressed = Compress::DeflateStream::decompress_all({ compressed, sizeof(compressed) });
-    EXPECT(compare({ uncompressed, sizeof(uncompressed) - 1 }, decompressed.span()));
+    EXPECT(compare({ uncompressed, sizeof(uncompressed) - 1 }, decompressed.value().bytes()));
+}
+
+TEST_CASE(deflate_decompress_dynamic_block)
+{
+    const u8 compressed[] = {
+        0x7D, 0xCC, 0xC1, 0x09, 0xC0, 0x20, 0x10, 0x44, 0xD1, 0x56, 0x26, 0xF7,
+        0x90, 0x1E, 0x2C, 0x45, 0x74, 0xC4, 0x05, 0x57, 0xC5, 0x35, 0x24, 0x76,
+        0x1F, 0x2B, 0xC8, 0xF5, 0x3F, 0xF8, 0xAE, 0x82, 0xEF, 0x1C, 0x54, 0x96,
+        0x05, 0x13, 0xED, 0x85, 0x98, 0xBB, 0x20, 0x49, 0xE1, 0x89, 0xD0, 0xB4,
+        0x0F, 0x9A, 0x31, 0xE2, 0x91, 0x99, 0x11, 0x57, 0xF5, 0x2A, 0x01, 0xF9,
+        0x4E, 0x49, 0x7D, 0xDD, 0x1E, 0x69, 0x17, 0xDC, 0xDF, 0xE5, 0xF8, 0x00
+    };
+
+    const u8 uncompressed[] = "An extremely simple text file, compressed with dynamic huffman codes. An extremely simple text file!";
+
+    const auto decompressed = Compress::DeflateStream::decompress_all({ compressed, sizeof(compressed) });
+    EXPECT(compare({ uncompressed, sizeof(uncompressed) - 1 }, decompressed.value().bytes()));
+}
+
+TEST_CASE(deflate_reject_reserved_block_type)
+{
+    const u8 compressed[] = { 0x07, 0x00 };
+
+    const auto decompressed = Compress::DeflateStream::decompress_all({ compressed, sizeof(compressed) });
+    EXPECT(!decompressed.has_value());
 }
 
 TEST_CASE(zlib_simple_decompress)
@@ -68,7 +95,175 @@ TEST_CASE(zlib_simple_decompress)
     const u8 uncompressed[] = "This is a simple text file :)";
 
     const auto decompressed = Compress::Zlib { { compressed, sizeof(compressed) } }.decompress();
-    EXPECT(compare({ uncompressed, sizeof(uncompressed) - 1 }, decompressed.span()));
+    EXPECT(compare({ uncompressed, sizeof(uncompressed) - 1 }, decompressed.value().bytes()));
+}
+
+TEST_CASE(zlib_stream_larger_than_window)
+{
+    // "abc" repeated 30000 times, which is more than the decompressor keeps around at once.
+    const u8 compressed[] = {
+        0x78, 0xDA, 0xED, 0xC2, 0x01, 0x0D, 0x00, 0x00, 0x0C, 0x02, 0xA0, 0xAC,
+        0x6A, 0xFF, 0x0E, 0xEF, 0xF1, 0xC1, 0x48, 0x17, 0x55, 0x55, 0x55, 0x55,
+        0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+        0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+        0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+        0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+        0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+        0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+        0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0xD5, 0x8F,
+        0x0F, 0x9E, 0x2D, 0x9C, 0xFB
+    };
+
+    InputMemoryStream memory_stream { { compressed, sizeof(compressed) } };
+    Compress::ZlibStream zlib_stream { memory_stream };
+
+    size_t total = 0;
+    bool matches = true;
+    u8 buffer[1000];
+    while (auto nread = zlib_stream.read({ buffer, sizeof(buffer) })) {
+        for (size_t i = 0; i < nread; ++i)
+            matches = matches && buffer[i] == "abc"[(total + i) % 3];
+        total += nread;
+    }
+
+    EXPECT(matches);
+    EXPECT_EQ(total, 90000u);
+    EXPECT(zlib_stream.eof());
+    EXPECT(!zlib_stream.handle_error());
+}
+
+// Something resembling text, so that there are both literals and matches to be found.
+static ByteBuffer generate_text(size_t size)
+{
+    static const char* words[] = { "the ", "quick ", "brown ", "fox ", "jumps ", "over ", "a ", "lazy ", "dog", ".\n", ", ", "serenity ", "compress " };
+    auto buffer = ByteBuffer::create_uninitialized(size);
+    u32 seed = 12345;
+    size_t offset = 0;
+    while (offset < size) {
+        seed = seed * 1103515245 + 12345;
+        const char* word = words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))];
+        for (size_t i = 0; word[i] && offset < size; ++i)
+            buffer[offset++] = word[i];
+        if (((seed >> 8) & 0xff) == 0 && offset < size)
+            buffer[offset++] = seed >> 24;
+    }
+    return buffer;
+}
+
+static void expect_deflate_round_trip(ReadonlyBytes uncompressed, Compress::DeflateCompressor::CompressionLevel level)
+{
+    auto compressed = Compress::DeflateCompressor::compress_all(uncompressed, level);
+    EXPECT(compressed.has_value());
+
+    auto decompressed = Compress::DeflateStream::decompress_all(compressed.value());
+    EXPECT(decompressed.has_value());
+    EXPECT(compare(uncompressed, decompressed.value().bytes()));
+}
+
+TEST_CASE(deflate_round_trip_store)
+{
+    expect_deflate_round_trip(generate_text(200000), Compress::DeflateCompressor::CompressionLevel::Store);
+}
+
+TEST_CASE(deflate_round_trip_fastest)
+{
+    expect_deflate_round_trip(generate_text(200000), Compress::DeflateCompressor::CompressionLevel::Fastest);
+}
+
+TEST_CASE(deflate_round_trip_fast)
+{
+    expect_deflate_round_trip(generate_text(200000), Compress::DeflateCompressor::CompressionLevel::Fast);
+}
+
+TEST_CASE(deflate_round_trip_good)
+{
+    expect_deflate_round_trip(generate_text(200000), Compress::DeflateCompressor::CompressionLevel::Good);
+}
+
+TEST_CASE(deflate_round_trip_best)
+{
+    expect_deflate_round_trip(generate_text(200000), Compress::DeflateCompressor::CompressionLevel::Best);
+}
+
+TEST_CASE(deflate_round_trip_incompressible)
+{
+    auto buffer = ByteBuffer::create_uninitialized(100000);
+    u32 seed = 1;
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        buffer[i] = seed >> 24;
+    }
+    expect_deflate_round_trip(buffer, Compress::DeflateCompressor::CompressionLevel::Good);
+}
+
+TEST_CASE(deflate_round_trip_empty)
+{
+    expect_deflate_round_trip({}, Compress::DeflateCompressor::CompressionLevel::Good);
+}
+
+TEST_CASE(deflate_compress_shrinks_text)
+{
+    auto uncompressed = generate_text(100000);
+    auto compressed = Compress::DeflateCompressor::compress_all(uncompressed);
+    EXPECT(compressed.has_value());
+    EXPECT(compressed.value().size() < uncompressed.size() / 3);
+}
+
+TEST_CASE(zlib_round_trip)
+{
+    auto uncompressed = generate_text(50000);
+    auto compressed = Compress::Zlib::compress_all(uncompressed);
+    EXPECT(compressed.has_value());
+
+    Compress::Zlib zlib { compressed.value() };
+    auto decompressed = zlib.decompress();
+    EXPECT(decompressed.has_value());
+    EXPECT(compare(uncompressed, decompressed.value().bytes()));
+    EXPECT_EQ(zlib.checksum(), Crypto::Checksum::Adler32 { uncompressed }.digest());
+}
+
+TEST_CASE(gzip_round_trip)
+{
+    auto uncompressed = generate_text(50000);
+    auto compressed = Compress::Gzip::compress_all(uncompressed);
+    EXPECT(compressed.has_value());
+    EXPECT(Core::Gzip::is_compressed(compressed.value()));
+
+    auto decompressed = Core::Gzip::decompress(compressed.value());
+    EXPECT(decompressed.has_value());
+    EXPECT(compare(uncompressed, decompressed.value().bytes()));
+}
+
+static void benchmark_compress(Compress::DeflateCompressor::CompressionLevel level)
+{
+    auto uncompressed = generate_text(4 * MiB);
+    auto compressed = Compress::DeflateCompressor::compress_all(uncompressed, level);
+    EXPECT(compressed.has_value());
+}
+
+BENCHMARK_CASE(deflate_compress_fastest)
+{
+    benchmark_compress(Compress::DeflateCompressor::CompressionLevel::Fastest);
+}
+
+BENCHMARK_CASE(deflate_compress_good)
+{
+    benchmark_compress(Compress::DeflateCompressor::CompressionLevel::Good);
+}
+
+BENCHMARK_CASE(deflate_compress_best)
+{
+    benchmark_compress(Compress::DeflateCompressor::CompressionLevel::Best);
+}
+
+BENCHMARK_CASE(deflate_decompress)
+{
+    auto compressed = Compress::DeflateCompressor::compress_all(generate_text(4 * MiB));
+    EXPECT(compressed.has_value());
+    for (int i = 0; i < 4; ++i) {
+        auto decompressed = Compress::DeflateStream::decompress_all(compressed.value());
+        EXPECT(decompressed.has_value());
+    }
 }
 
 TEST_MAIN(Compress)
@@ -28,12 +28,17 @@
 #include <LibCore/ArgsParser.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/File.h>
+#include <LibCrypto/Authentication/GHash.h>
 #include <LibCrypto/Authentication/HMAC.h>
+#include <LibCrypto/Authentication/Poly1305.h>
 #include <LibCrypto/BigInt/SignedBigInteger.h>
 #include <LibCrypto/BigInt/UnsignedBigInteger.h>
 #include <LibCrypto/Checksum/Adler32.h>
 #include <LibCrypto/Checksum/CRC32.h>
 #include <LibCrypto/Cipher/AES.h>
+#include <LibCrypto/Cipher/ChaCha20.h>
+#include <LibCrypto/Curves/SECP256r1.h>
+#include <LibCrypto/Curves/X25519.h>
 #include <LibCrypto/Hash/MD5.h>
 #include <LibCrypto/Hash/SHA1.h>
 #include <LibCrypto/Hash/SHA2.h>
@@ -72,6 +77,8 @@ constexpr const char* DEFAULT_SERVER { "www.google.com" };
 // Cipher
 static int aes_cbc_tests();
 static int aes_ctr_tests();
+static int aes_gcm_tests();
+static int chacha20_poly1305_tests();
 
 // Hash
 static int md5_tests();
@@ -87,6 +94,7 @@ static int hmac_sha1_tests();
 
 // Public-Key
 static int rsa_tests();
+static int curve_tests();
 
 // TLS
 static int tls_tests();
@@ -100,6 +108,9 @@ static int crc32_tests();
 
 // stop listing tests
 
+// Benchmarks
+static int run_benchmarks();
+
 static void print_buffer(ReadonlyBytes buffer, int split)
 {
     for (size_t i = 0; i < buffer.size(); ++i) {
@@ -326,6 +337,7 @@ auto main(int argc, char** argv) -> int
         puts("\tencrypt -- Access encryption functions");
         puts("\tdecrypt -- Access decryption functions");
         puts("\ttls -- Connect to a peer over TLS 1.2");
+        puts("\tbench -- Measure the throughput of the ciphers and hashes");
         puts("\tlist -- List all known modes");
         puts("these modes only contain tests");
         puts("\ttest -- Run every test suite");
@@ -408,7 +420,9 @@ auto main(int argc, char** argv) -> int
         return 1;
     }
     if (mode_sv == "pk") {
-        return rsa_tests();
+        rsa_tests();
+        curve_tests();
+        return g_some_test_failed ? 1 : 0;
     }
     if (mode_sv == "bigint") {
         return bigint_tests();
@@ -418,14 +432,21 @@ auto main(int argc, char** argv) -> int
             return tls_tests();
         return run(tls);
     }
+    if (mode_sv == "bench") {
+        return run_benchmarks();
+    }
     if (mode_sv == "test") {
         encrypting = true;
         aes_cbc_tests();
         aes_ctr_tests();
+        aes_gcm_tests();
+        chacha20_poly1305_tests();
 
         encrypting = false;
         aes_cbc_tests();
         aes_ctr_tests();
+        aes_gcm_tests();
+        chacha20_poly1305_tests();
 
         md5_tests();
         sha1_tests();
@@ -438,6 +459,7 @@ auto main(int argc, char** argv) -> int
         hmac_sha1_tests();
 
         rsa_tests();
+        curve_tests();
 
         if (!in_ci) {
             // Do not run these in CI to avoid tests with variables outside our control.
@@ -467,6 +489,10 @@ auto main(int argc, char** argv) -> int
                 return 1;
             }
             return run(aes_cbc);
+        } else if (suite_sv == "AES_GCM" && run_tests) {
+            return aes_gcm_tests();
+        } else if (suite_sv == "ChaCha20_Poly1305" && run_tests) {
+            return chacha20_poly1305_tests();
         } else {
             printf("Unknown cipher suite '%s'\n", suite);
             return 1;
@@ -517,6 +543,13 @@ static void aes_cbc_test_decrypt();
 static void aes_ctr_test_name();
 static void aes_ctr_test_encrypt();
 static void aes_ctr_test_decrypt();
+static void aes_gcm_test_name();
+static void aes_gcm_test_encrypt();
+static void aes_gcm_test_decrypt();
+static void chacha20_test_encrypt();
+static void poly1305_test_process();
+static void chacha20_poly1305_test_encrypt();
+static void chacha20_poly1305_test_decrypt();
 
 static void md5_test_name();
 static void md5_test_hash();
@@ -549,6 +582,11 @@ static void rsa_test_encrypt_decrypt();
 static void rsa_emsa_pss_test_create();
 static void bigint_test_number_theory(); // FIXME: we should really move these num theory stuff out
 
+static void x25519_test_key_exchange();
+static void x25519_test_low_order_point();
+static void secp256r1_test_key_exchange();
+static void secp256r1_test_invalid_point();
+
 static void tls_test_client_hello();
 
 static void bigint_test_fibo500();
@@ -965,6 +1003,406 @@ static void aes_ctr_test_decrypt()
     // If encryption works, then decryption works, too.
 }
 
+static int aes_gcm_tests()
+{
+    aes_gcm_test_name();
+    if (encrypting) {
+        aes_gcm_test_encrypt();
+    } else {
+        aes_gcm_test_decrypt();
+    }
+
+    return g_some_test_failed ? 1 : 0;
+}
+
+static void aes_gcm_test_name()
+{
+    I_TEST((AES GCM class name));
+    Crypto::Cipher::AESCipher::GCMMode cipher("WellHelloFriends"_b, 128, Crypto::Cipher::Intent::Encryption);
+    if (cipher.class_name() != "AES_GCM")
+        FAIL(Invalid class name);
+    else
+        PASS;
+}
+
+static void aes_gcm_test_encrypt()
+{
+    auto test_it = [](const ByteBuffer& key, ReadonlyBytes iv, ReadonlyBytes in, ReadonlyBytes aad, ReadonlyBytes out_expected, ReadonlyBytes tag_expected) {
+        Crypto::Cipher::AESCipher::GCMMode cipher(key, 8 * key.size(), Crypto::Cipher::Intent::Encryption);
+        auto out_actual = ByteBuffer::create_zeroed(in.size());
+        u8 tag[Crypto::Cipher::AESCipher::GCMMode::TagSize];
+        cipher.encrypt(in, out_actual.bytes(), iv, aad, { tag, sizeof(tag) });
+        if (memcmp(out_expected.data(), out_actual.data(), out_expected.size()) != 0) {
+            FAIL(invalid data);
+            print_buffer(out_actual.bytes(), Crypto::Cipher::AESCipher::block_size());
+        } else if (memcmp(tag_expected.data(), tag, sizeof(tag)) != 0) {
+            FAIL(invalid tag);
+            print_buffer({ tag, sizeof(tag) }, -1);
+        } else
+            PASS;
+    };
+    // From the GCM specification (McGrew & Viega), Appendix B
+    {
+        I_TEST((AES GCM 128 bit key, empty message | Encrypt))
+        u8 key[] {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+        };
+        u8 iv[] {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+        };
+        u8 tag[] {
+            0x58, 0xe2, 0xfc, 0xce, 0xfa, 0x7e, 0x30, 0x61, 0x36, 0x7f, 0x1d, 0x57, 0xa4, 0xe7, 0x45, 0x5a
+        };
+        test_it(ByteBuffer::wrap(key, sizeof(key)), { iv, sizeof(iv) }, {}, {}, {}, { tag, sizeof(tag) });
+    }
+    {
+        I_TEST((AES GCM 128 bit key, one block | Encrypt))
+        u8 key[] {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+        };
+        u8 iv[] {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+        };
+        u8 in[] {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+        };
+        u8 out[] {
+            0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92, 0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78
+        };
+        u8 tag[] {
+            0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd, 0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf
+        };
+        test_it(ByteBuffer::wrap(key, sizeof(key)), { iv, sizeof(iv) }, { in, sizeof(in) }, {}, { out, sizeof(out) }, { tag, sizeof(tag) });
+    }
+    {
+        I_TEST((AES GCM 128 bit key, with AAD | Encrypt))
+        u8 key[] {
+            0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+        };
+        u8 iv[] {
+            0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+        };
+        u8 in[] {
+            0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+            0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+            0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+            0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39
+        };
+        u8 aad[] {
+            0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+            0xab, 0xad, 0xda, 0xd2
+        };
+        u8 out[] {
+            0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24, 0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4, 0x9c,
+            0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0, 0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e,
+            0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c, 0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+            0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97, 0x3d, 0x58, 0xe0, 0x91
+        };
+        u8 tag[] {
+            0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb, 0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47
+        };
+        test_it(ByteBuffer::wrap(key, sizeof(key)), { iv, sizeof(iv) }, { in, sizeof(in) }, { aad, sizeof(aad) }, { out, sizeof(out) }, { tag, sizeof(tag) });
+    }
+    {
+        I_TEST((AES GCM 128 bit key, 64 bit IV | Encrypt))
+        u8 key[] {
+            0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+        };
+        u8 iv[] {
+            0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad
+        };
+        u8 in[] {
+            0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+            0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+            0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+            0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39
+        };
+        u8 aad[] {
+            0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+            0xab, 0xad, 0xda, 0xd2
+        };
+        u8 out[] {
+            0x61, 0x35, 0x3b, 0x4c, 0x28, 0x06, 0x93, 0x4a, 0x77, 0x7f, 0xf5, 0x1f, 0xa2, 0x2a, 0x47, 0x55,
+            0x69, 0x9b, 0x2a, 0x71, 0x4f, 0xcd, 0xc6, 0xf8, 0x37, 0x66, 0xe5, 0xf9, 0x7b, 0x6c, 0x74, 0x23,
+            0x73, 0x80, 0x69, 0x00, 0xe4, 0x9f, 0x24, 0xb2, 0x2b, 0x09, 0x75, 0x44, 0xd4, 0x89, 0x6b, 0x42,
+            0x49, 0x89, 0xb5, 0xe1, 0xeb, 0xac, 0x0f, 0x07, 0xc2, 0x3f, 0x45, 0x98
+        };
+        u8 tag[] {
+            0x36, 0x12, 0xd2, 0xe7, 0x9e, 0x3b, 0x07, 0x85, 0x56, 0x1b, 0xe1, 0x4a, 0xac, 0xa2, 0xfc, 0xcb
+        };
+        test_it(ByteBuffer::wrap(key, sizeof(key)), { iv, sizeof(iv) }, { in, sizeof(in) }, { aad, sizeof(aad) }, { out, sizeof(out) }, { tag, sizeof(tag) });
+    }
+    {
+        I_TEST((AES GCM 256 bit key, with AAD | Encrypt))
+        u8 key[] {
+            0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+            0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+        };
+        u8 iv[] {
+            0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+        };
+        u8 in[] {
+            0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+            0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+            0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+            0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39
+        };
+        u8 aad[] {
+            0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+            0xab, 0xad, 0xda, 0xd2
+        };
+        u8 out[] {
+            0x52, 0x2d, 0xc1, 0xf0, 0x99, 0x56, 0x7d, 0x07, 0xf4, 0x7f, 0x37, 0xa3, 0x2a, 0x84, 0x42, 0x7d,
+            0x64, 0x3a, 0x8c, 0xdc, 0xbf, 0xe5, 0xc0, 0xc9, 0x75, 0x98, 0xa2, 0xbd, 0x25, 0x55, 0xd1, 0xaa,
+            0x8c, 0xb0, 0x8e, 0x48, 0x59, 0x0d, 0xbb, 0x3d, 0xa7, 0xb0, 0x8b, 0x10, 0x56, 0x82, 0x88, 0x38,
+            0xc5, 0xf6, 0x1e, 0x63, 0x93, 0xba, 0x7a, 0x0a, 0xbc, 0xc9, 0xf6, 0x62
+        };
+        u8 tag[] {
+            0x76, 0xfc, 0x6e, 0xce, 0x0f, 0x4e, 0x17, 0x68, 0xcd, 0xdf, 0x88, 0x53, 0xbb, 0x2d, 0x55, 0x1b
+        };
+        test_it(ByteBuffer::wrap(key, sizeof(key)), { iv, sizeof(iv) }, { in, sizeof(in) }, { aad, sizeof(aad) }, { out, sizeof(out) }, { tag, sizeof(tag) });
+    }
+}
+
+static void aes_gcm_test_decrypt()
+{
+    auto test_it = [](const ByteBuffer& key, ReadonlyBytes iv, ReadonlyBytes in, ReadonlyBytes aad, ReadonlyBytes out_expected, ReadonlyBytes tag) {
+        Crypto::Cipher::AESCipher::GCMMode cipher(key, 8 * key.size(), Crypto::Cipher::Intent::Decryption);
+        auto out_actual = ByteBuffer::create_zeroed(in.size());
+        if (!cipher.decrypt(in, out_actual.bytes(), iv, aad, tag)) {
+            FAIL(tag not accepted);
+            return;
+        }
+        if (memcmp(out_expected.data(), out_actual.data(), out_expected.size()) != 0) {
+            FAIL(invalid data);
+            print_buffer(out_actual.bytes(), Crypto::Cipher::AESCipher::block_size());
+            return;
+        }
+        auto tampered = ByteBuffer::copy(in.data(), in.size());
+        tampered[0] ^= 1;
+        if (cipher.decrypt(tampered.bytes(), out_actual.bytes(), iv, aad, tag))
+            FAIL(tampered message accepted);
+        else
+            PASS;
+    };
+    // From the GCM specification (McGrew & Viega), Appendix B
+    {
+        I_TEST((AES GCM 128 bit key, with AAD | Decrypt))
+        u8 key[] {
+            0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+        };
+        u8 iv[] {
+            0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+        };
+        u8 in[] {
+            0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24, 0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4, 0x9c,
+            0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0, 0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e,
+            0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c, 0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+            0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97, 0x3d, 0x58, 0xe0, 0x91
+        };
+        u8 aad[] {
+            0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+            0xab, 0xad, 0xda, 0xd2
+        };
+        u8 out[] {
+            0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+            0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+            0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+            0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39
+        };
+        u8 tag[] {
+            0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb, 0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47
+        };
+        test_it(ByteBuffer::wrap(key, sizeof(key)), { iv, sizeof(iv) }, { in, sizeof(in) }, { aad, sizeof(aad) }, { out, sizeof(out) }, { tag, sizeof(tag) });
+    }
+    {
+        I_TEST((AES GCM 256 bit key, with AAD | Decrypt))
+        u8 key[] {
+            0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+            0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+        };
+        u8 iv[] {
+            0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+        };
+        u8 in[] {
+            0x52, 0x2d, 0xc1, 0xf0, 0x99, 0x56, 0x7d, 0x07, 0xf4, 0x7f, 0x37, 0xa3, 0x2a, 0x84, 0x42, 0x7d,
+            0x64, 0x3a, 0x8c, 0xdc, 0xbf, 0xe5, 0xc0, 0xc9, 0x75, 0x98, 0xa2, 0xbd, 0x25, 0x55, 0xd1, 0xaa,
+            0x8c, 0xb0, 0x8e, 0x48, 0x59, 0x0d, 0xbb, 0x3d, 0xa7, 0xb0, 0x8b, 0x10, 0x56, 0x82, 0x88, 0x38,
+            0xc5, 0xf6, 0x1e, 0x63, 0x93, 0xba, 0x7a, 0x0a, 0xbc, 0xc9, 0xf6, 0x62
+        };
+        u8 aad[] {
+            0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+            0xab, 0xad, 0xda, 0xd2
+        };
+        u8 out[] {
+            0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+            0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+            0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+            0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39
+        };
+        u8 tag[] {
+            0x76, 0xfc, 0x6e, 0xce, 0x0f, 0x4e, 0x17, 0x68, 0xcd, 0xdf, 0x88, 0x53, 0xbb, 0x2d, 0x55, 0x1b
+        };
+        test_it(ByteBuffer::wrap(key, sizeof(key)), { iv, sizeof(iv) }, { in, sizeof(in) }, { aad, sizeof(aad) }, { out, sizeof(out) }, { tag, sizeof(tag) });
+    }
+}
+
+static int chacha20_poly1305_tests()
+{
+    chacha20_test_encrypt();
+    poly1305_test_process();
+    if (encrypting) {
+        chacha20_poly1305_test_encrypt();
+    } else {
+        chacha20_poly1305_test_decrypt();
+    }
+
+    return g_some_test_failed ? 1 : 0;
+}
+
+static const char* sunscreen = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+
+static void chacha20_test_encrypt()
+{
+    // From RFC 8439, Section 2.4.2
+    I_TEST((ChaCha20 | Encrypt));
+    u8 key[] {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+        0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+    };
+    u8 nonce[] {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x00
+    };
+    u8 out[] {
+        0x6e, 0x2e, 0x35, 0x9a, 0x25, 0x68, 0xf9, 0x80, 0x41, 0xba, 0x07, 0x28, 0xdd, 0x0d, 0x69, 0x81,
+        0xe9, 0x7e, 0x7a, 0xec, 0x1d, 0x43, 0x60, 0xc2, 0x0a, 0x27, 0xaf, 0xcc, 0xfd, 0x9f, 0xae, 0x0b,
+        0xf9, 0x1b, 0x65, 0xc5, 0x52, 0x47, 0x33, 0xab, 0x8f, 0x59, 0x3d, 0xab, 0xcd, 0x62, 0xb3, 0x57,
+        0x16, 0x39, 0xd6, 0x24, 0xe6, 0x51, 0x52, 0xab, 0x8f, 0x53, 0x0c, 0x35, 0x9f, 0x08, 0x61, 0xd8,
+        0x07, 0xca, 0x0d, 0xbf, 0x50, 0x0d, 0x6a, 0x61, 0x56, 0xa3, 0x8e, 0x08, 0x8a, 0x22, 0xb6, 0x5e,
+        0x52, 0xbc, 0x51, 0x4d, 0x16, 0xcc, 0xf8, 0x06, 0x81, 0x8c, 0xe9, 0x1a, 0xb7, 0x79, 0x37, 0x36,
+        0x5a, 0xf9, 0x0b, 0xbf, 0x74, 0xa3, 0x5b, 0xe6, 0xb4, 0x0b, 0x8e, 0xed, 0xf2, 0x78, 0x5e, 0x42,
+        0x87, 0x4d
+    };
+    Crypto::Cipher::ChaCha20 cipher({ key, sizeof(key) }, { nonce, sizeof(nonce) }, 1);
+    auto out_actual = ByteBuffer::create_zeroed(strlen(sunscreen));
+    // Go through the key stream in uneven pieces.
+    cipher.process({ (const u8*)sunscreen, 7 }, out_actual.bytes());
+    cipher.process({ (const u8*)sunscreen + 7, strlen(sunscreen) - 7 }, out_actual.bytes().slice(7, strlen(sunscreen) - 7));
+    if (out_actual.size() != sizeof(out) || memcmp(out, out_actual.data(), sizeof(out)) != 0) {
+        FAIL(invalid data);
+        print_buffer(out_actual.bytes(), 16);
+    } else
+        PASS;
+}
+
+static void poly1305_test_process()
+{
+    // From RFC 8439, Section 2.5.2
+    I_TEST((Poly1305 | "Cryptographic Forum Research Group"));
+    u8 key[] {
+        0x85, 0xd6, 0xbe, 0x78, 0x57, 0x55, 0x6d, 0x33, 0x7f, 0x44, 0x52, 0xfe, 0x42, 0xd5, 0x06, 0xa8,
+        0x01, 0x03, 0x80, 0x8a, 0xfb, 0x0d, 0xb2, 0xfd, 0x4a, 0xbf, 0xf6, 0xaf, 0x41, 0x49, 0xf5, 0x1b
+    };
+    u8 tag[] {
+        0xa8, 0x06, 0x1d, 0xc1, 0x30, 0x51, 0x36, 0xc6, 0xc2, 0x2b, 0x8b, 0xaf, 0x0c, 0x01, 0x27, 0xa9
+    };
+    Crypto::Authentication::Poly1305 poly1305({ key, sizeof(key) });
+    poly1305.update("Cryptographic"_b);
+    poly1305.update(" Forum Research Group"_b);
+    auto digest = poly1305.digest();
+    if (memcmp(tag, digest.data, sizeof(tag)) != 0) {
+        FAIL(invalid tag);
+        print_buffer({ digest.data, sizeof(digest.data) }, -1);
+    } else
+        PASS;
+}
+
+static void chacha20_poly1305_test_encrypt()
+{
+    // From RFC 8439, Section 2.8.2
+    I_TEST((ChaCha20-Poly1305 | Encrypt));
+    u8 key[] {
+        0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+        0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f
+    };
+    u8 nonce[] {
+        0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47
+    };
+    u8 aad[] {
+        0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7
+    };
+    u8 cipher_text[] {
+        0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2,
+        0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe, 0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6,
+        0x3d, 0xbe, 0xa4, 0x5e, 0x8c, 0xa9, 0x67, 0x12, 0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+        0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29, 0x05, 0xd6, 0xa5, 0xb6, 0x7e, 0xcd, 0x3b, 0x36,
+        0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c, 0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58,
+        0xfa, 0xb3, 0x24, 0xe4, 0xfa, 0xd6, 0x75, 0x94, 0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+        0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d, 0xe5, 0x76, 0xd2, 0x65, 0x86, 0xce, 0xc6, 0x4b,
+        0x61, 0x16
+    };
+    u8 tag[] {
+        0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a, 0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91
+    };
+    Crypto::Cipher::ChaCha20Poly1305 cipher({ key, sizeof(key) });
+    auto out_actual = ByteBuffer::create_zeroed(strlen(sunscreen));
+    u8 tag_actual[Crypto::Cipher::ChaCha20Poly1305::TagSize];
+    cipher.encrypt({ (const u8*)sunscreen, strlen(sunscreen) }, out_actual.bytes(), { nonce, sizeof(nonce) }, { aad, sizeof(aad) }, { tag_actual, sizeof(tag_actual) });
+    if (out_actual.size() != sizeof(cipher_text) || memcmp(cipher_text, out_actual.data(), sizeof(cipher_text)) != 0) {
+        FAIL(invalid data);
+        print_buffer(out_actual.bytes(), 16);
+    } else if (memcmp(tag, tag_actual, sizeof(tag)) != 0) {
+        FAIL(invalid tag);
+        print_buffer({ tag_actual, sizeof(tag_actual) }, -1);
+    } else
+        PASS;
+}
+
+static void chacha20_poly1305_test_decrypt()
+{
+    // From RFC 8439, Section 2.8.2
+    I_TEST((ChaCha20-Poly1305 | Decrypt));
+    u8 key[] {
+        0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+        0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f
+    };
+    u8 nonce[] {
+        0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47
+    };
+    u8 aad[] {
+        0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7
+    };
+    u8 cipher_text[] {
+        0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2,
+        0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe, 0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6,
+        0x3d, 0xbe, 0xa4, 0x5e, 0x8c, 0xa9, 0x67, 0x12, 0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+        0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29, 0x05, 0xd6, 0xa5, 0xb6, 0x7e, 0xcd, 0x3b, 0x36,
+        0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c, 0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58,
+        0xfa, 0xb3, 0x24, 0xe4, 0xfa, 0xd6, 0x75, 0x94, 0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+        0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d, 0xe5, 0x76, 0xd2, 0x65, 0x86, 0xce, 0xc6, 0x4b,
+        0x61, 0x16
+    };
+    u8 tag[] {
+        0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a, 0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91
+    };
+    Crypto::Cipher::ChaCha20Poly1305 cipher({ key, sizeof(key) });
+    auto out_actual = ByteBuffer::create_zeroed(sizeof(cipher_text));
+    if (!cipher.decrypt({ cipher_text, sizeof(cipher_text) }, out_actual.bytes(), { nonce, sizeof(nonce) }, { aad, sizeof(aad) }, { tag, sizeof(tag) })) {
+        FAIL(tag not accepted);
+        return;
+    }
+    if (out_actual.size() != strlen(sunscreen) || memcmp(sunscreen, out_actual.data(), out_actual.size()) != 0) {
+        FAIL(invalid data);
+        print_buffer(out_actual.bytes(), 16);
+        return;
+    }
+    aad[0] ^= 1;
+    if (cipher.decrypt({ cipher_text, sizeof(cipher_text) }, out_actual.bytes(), { nonce, sizeof(nonce) }, { aad, sizeof(aad) }, { tag, sizeof(tag) }))
+        FAIL(tampered aad accepted);
+    else
+        PASS;
+}
+
 static int md5_tests()
 {
     md5_test_name();
@@ -1286,6 +1724,26 @@ static void sha1_test_hash()
         } else
             PASS;
     }
+    {
+        I_TEST((SHA1 Hashing | Updates across block boundaries));
+        u8 result[] {
+            0xc9, 0xc9, 0x60, 0xa0, 0xb9, 0x25, 0x47, 0x4f, 0xab, 0x83, 0x94, 0x2c, 0xc2, 0x7d, 0x50, 0x4f, 0xc2, 0x4a, 0xc3, 0x7b
+        };
+        u8 data[1000];
+        for (size_t i = 0; i < sizeof(data); ++i)
+            data[i] = i % 251;
+        Crypto::Hash::SHA1 hasher;
+        hasher.update(data, 10);
+        hasher.update(data + 10, 200);
+        hasher.update(data + 210, 54);
+        hasher.update(data + 264, 736);
+        auto digest = hasher.digest();
+        if (memcmp(result, digest.data, Crypto::Hash::SHA1::digest_size()) != 0) {
+            FAIL(Invalid hash);
+            print_buffer({ digest.data, Crypto::Hash::SHA1::digest_size() }, -1);
+        } else
+            PASS;
+    }
 }
 
 static int sha256_tests()
@@ -1332,6 +1790,52 @@ static void sha256_test_hash()
         } else
             PASS;
     }
+    u8 result_1000[] {
+        0x4e, 0x4c, 0x29, 0x4b, 0x33, 0x1f, 0x7a, 0x20, 0x99, 0xa3, 0x79, 0xbe, 0xc3, 0x4b, 0x9f, 0x9f, 0xc0, 0x3d, 0xc4, 0x6a, 0xb4, 0x65, 0xd9, 0x98, 0xf4, 0xd6, 0x83, 0xda, 0x53, 0x48, 0x7e, 0x6d
+    };
+    u8 data[1000];
+    for (size_t i = 0; i < sizeof(data); ++i)
+        data[i] = i % 251;
+    {
+        I_TEST((SHA256 Hashing | Updates across block boundaries));
+        Crypto::Hash::SHA256 hasher;
+        hasher.update(data, 10);
+        hasher.update(data + 10, 200);
+        hasher.update(data + 210, 54);
+        hasher.update(data + 264, 736);
+        auto digest = hasher.digest();
+        if (memcmp(result_1000, digest.data, Crypto::Hash::SHA256::digest_size()) != 0) {
+            FAIL(Invalid hash);
+            print_buffer({ digest.data, Crypto::Hash::SHA256::digest_size() }, -1);
+        } else
+            PASS;
+    }
+    {
+        I_TEST((SHA256 Hashing | Multiple messages at once));
+        // Around the padding edge cases, and more of them than there are lanes.
+        size_t lengths[] { 0, 1, 55, 56, 63, 64, 65, 119, 120, 200, 1000 };
+        constexpr size_t count = sizeof(lengths) / sizeof(lengths[0]);
+        ReadonlyBytes messages[count];
+        for (size_t i = 0; i < count; ++i)
+            messages[i] = { data, lengths[i] };
+        Crypto::Hash::SHA256::DigestType digests[count];
+        Crypto::Hash::SHA256::hash_many({ messages, count }, { digests, count });
+
+        bool ok = memcmp(result_1000, digests[count - 1].data, Crypto::Hash::SHA256::digest_size()) == 0;
+        for (size_t i = 0; ok && i < count; ++i) {
+            auto expected = Crypto::Hash::SHA256::hash(data, lengths[i]);
+            if (memcmp(expected.data, digests[i].data, Crypto::Hash::SHA256::digest_size()) != 0) {
+                printf("Message of %zu bytes:\n", lengths[i]);
+                print_buffer({ digests[i].data, Crypto::Hash::SHA256::digest_size() }, -1);
+                ok = false;
+            }
+        }
+        if (ok) {
+            PASS;
+        } else {
+            FAIL(Invalid hash);
+        }
+    }
 }
 
 static void hmac_sha256_test_name()
@@ -1561,6 +2065,8 @@ static void bigint_test_number_theory()
             { "99667739213529524852296932424683448520"_bigint, "123394910770101395416306279070921784207"_bigint, "238026722756504133786938677233768788719"_bigint, "197165477545023317459748215952393063201"_bigint },
             { "49368547511968178788919424448914214709244872098814465088945281575062739912239"_bigint, "25201856190991298572337188495596990852134236115562183449699512394891190792064"_bigint, "45950460777961491021589776911422805972195170308651734432277141467904883064645"_bigint, "39917885806532796066922509794537889114718612292469285403012781055544152450051"_bigint },
             { "48399385336454791246880286907257136254351739111892925951016159217090949616810"_bigint, "5758661760571644379364752528081901787573279669668889744323710906207949658569"_bigint, "32812120644405991429173950312949738783216437173380339653152625840449006970808"_bigint, "7948464125034399875323770213514649646309423451213282653637296324080400293584"_bigint },
+            // 2048-bit odd modulus, which takes the Montgomery path.
+            { "109853157756628224796781349303069831744709865136690645565899946990240264255130447261129648364190155849745669656791420770649086137954889752835066956109368565881724105726835091032622363966086721598226321221025441786990932113288058911519720287271826720491026234793532391545347397885080103689866430565364629844340308070513379641327369361259931613190199335544604992570712112175284912910148634575852479591532031537600054052725742139951693867370327436812792819572659020062952447356186863594242967365201881847917912662775451304953691477020227353106604319131615728692178532792357973398196359434832060118653066693509381100642"_bigint, "22030414774846722158103056423622670368301406214227694892747867282273739403225890966246285616932806023627685787018986180935460056977426911242941231838981947448239040416138386283408001891348696658931709905529271010224372162591150368438891358319995546685541919461386818628135730148145198388882795108803229128174926468203429468500665034086529547410324995629436839067710559430391777032946863708594420362783074149145882143867580872576671523551184978523312909577713769195052585020407946683525730998026776570283876832166990330223358491916884003743998686231708275135246368972259721413563801496399093931900453407006542373454689"_bigint, "27135693933097011361894386404115805554811756651966685418079399911481722739375067498111444780231032640594439531002722550481247504140507479538569330081459397771627179357021378537309565007869108293672168711451415943946214071911298298905420912268158925138228982879748202550023080555149498264494619614563999987472527878639625559532426458062023425051677581302436505065779365614740893692940837294848936169779043559348309619260755328771424701451649360417757335374099495151587547202371758265617128860970519918302151067335725617585344907639949768358678432412524339889640204486860568232381337053922760183807626704365239422613831"_bigint, "7845013464868335542266262135774970009538886641145225159162498662180902843387579354089581125676932165287276009582909490421901207372522295163198015971544575628893848479790450394159995557199418669438211755892073538836969933183573674241862876520553747513421875787250633664088491080354876298633065162639168960160923675210527658276319725586889414055496369805044637688563151024705618752159589162330456727896217256655521381133707547650512940317101174469421247756499614260176083395668957640729652459458402640856218122687670036760379671662359167531921107317164962127288038580122758188381600614648777106804468350187200774874613"_bigint },
         };
 
         for (auto test_case : mod_pow_tests) {
@@ -1713,6 +2219,138 @@ static void rsa_test_encrypt_decrypt()
     }
 }
 
+static int curve_tests()
+{
+    x25519_test_key_exchange();
+    x25519_test_low_order_point();
+    secp256r1_test_key_exchange();
+    secp256r1_test_invalid_point();
+    return g_some_test_failed ? 1 : 0;
+}
+
+static void test_key_exchange(Crypto::Curves::EllipticCurve& curve, ReadonlyBytes alice_private_key, ReadonlyBytes alice_public_key, ReadonlyBytes bob_private_key, ReadonlyBytes bob_public_key, ReadonlyBytes shared_secret)
+{
+    auto public_key = ByteBuffer::create_zeroed(curve.public_key_size());
+    if (!curve.compute_public_key(alice_private_key, public_key.bytes()) || memcmp(public_key.data(), alice_public_key.data(), alice_public_key.size()) != 0) {
+        FAIL(Invalid public key);
+        print_buffer(public_key.bytes(), 16);
+        return;
+    }
+    if (!curve.compute_public_key(bob_private_key, public_key.bytes()) || memcmp(public_key.data(), bob_public_key.data(), bob_public_key.size()) != 0) {
+        FAIL(Invalid public key);
+        print_buffer(public_key.bytes(), 16);
+        return;
+    }
+    auto secret = ByteBuffer::create_zeroed(curve.shared_secret_size());
+    if (!curve.compute_shared_secret(alice_private_key, bob_public_key, secret.bytes()) || memcmp(secret.data(), shared_secret.data(), shared_secret.size()) != 0) {
+        FAIL(Invalid shared secret);
+        print_buffer(secret.bytes(), 16);
+        return;
+    }
+    if (!curve.compute_shared_secret(bob_private_key, alice_public_key, secret.bytes()) || memcmp(secret.data(), shared_secret.data(), shared_secret.size()) != 0) {
+        FAIL(Invalid shared secret);
+        print_buffer(secret.bytes(), 16);
+        return;
+    }
+    PASS;
+}
+
+static void x25519_test_key_exchange()
+{
+    // From RFC 7748, Section 6.1
+    I_TEST((X25519 | Key Exchange));
+    u8 alice_private_key[] {
+        0x77, 0x07, 0x6d, 0x0a, 0x73, 0x18, 0xa5, 0x7d, 0x3c, 0x16, 0xc1, 0x72, 0x51, 0xb2, 0x66, 0x45,
+        0xdf, 0x4c, 0x2f, 0x87, 0xeb, 0xc0, 0x99, 0x2a, 0xb1, 0x77, 0xfb, 0xa5, 0x1d, 0xb9, 0x2c, 0x2a
+    };
+    u8 alice_public_key[] {
+        0x85, 0x20, 0xf0, 0x09, 0x89, 0x30, 0xa7, 0x54, 0x74, 0x8b, 0x7d, 0xdc, 0xb4, 0x3e, 0xf7, 0x5a,
+        0x0d, 0xbf, 0x3a, 0x0d, 0x26, 0x38, 0x1a, 0xf4, 0xeb, 0xa4, 0xa9, 0x8e, 0xaa, 0x9b, 0x4e, 0x6a
+    };
+    u8 bob_private_key[] {
+        0x5d, 0xab, 0x08, 0x7e, 0x62, 0x4a, 0x8a, 0x4b, 0x79, 0xe1, 0x7f, 0x8b, 0x83, 0x80, 0x0e, 0xe6,
+        0x6f, 0x3b, 0xb1, 0x29, 0x26, 0x18, 0xb6, 0xfd, 0x1c, 0x2f, 0x8b, 0x27, 0xff, 0x88, 0xe0, 0xeb
+    };
+    u8 bob_public_key[] {
+        0xde, 0x9e, 0xdb, 0x7d, 0x7b, 0x7d, 0xc1, 0xb4, 0xd3, 0x5b, 0x61, 0xc2, 0xec, 0xe4, 0x35, 0x37,
+        0x3f, 0x83, 0x43, 0xc8, 0x5b, 0x78, 0x67, 0x4d, 0xad, 0xfc, 0x7e, 0x14, 0x6f, 0x88, 0x2b, 0x4f
+    };
+    u8 shared_secret[] {
+        0x4a, 0x5d, 0x9d, 0x5b, 0xa4, 0xce, 0x2d, 0xe1, 0x72, 0x8e, 0x3b, 0xf4, 0x80, 0x35, 0x0f, 0x25,
+        0xe0, 0x7e, 0x21, 0xc9, 0x47, 0xd1, 0x9e, 0x33, 0x76, 0xf0, 0x9b, 0x3c, 0x1e, 0x16, 0x17, 0x42
+    };
+    Crypto::Curves::X25519 curve;
+    test_key_exchange(curve, { alice_private_key, sizeof(alice_private_key) }, { alice_public_key, sizeof(alice_public_key) }, { bob_private_key, sizeof(bob_private_key) }, { bob_public_key, sizeof(bob_public_key) }, { shared_secret, sizeof(shared_secret) });
+}
+
+static void x25519_test_low_order_point()
+{
+    I_TEST((X25519 | Low Order Point));
+    u8 private_key[32];
+    u8 low_order_point[32] {};
+    u8 secret[32];
+    Crypto::Curves::X25519 curve;
+    curve.generate_private_key({ private_key, sizeof(private_key) });
+    if (curve.compute_shared_secret({ private_key, sizeof(private_key) }, { low_order_point, sizeof(low_order_point) }, { secret, sizeof(secret) }))
+        FAIL(all-zero secret accepted);
+    else
+        PASS;
+}
+
+static void secp256r1_test_key_exchange()
+{
+    // From RFC 5903, Section 8.1
+    I_TEST((SECP256r1 | Key Exchange));
+    u8 alice_private_key[] {
+        0xc8, 0x8f, 0x01, 0xf5, 0x10, 0xd9, 0xac, 0x3f, 0x70, 0xa2, 0x92, 0xda, 0xa2, 0x31, 0x6d, 0xe5,
+        0x44, 0xe9, 0xaa, 0xb8, 0xaf, 0xe8, 0x40, 0x49, 0xc6, 0x2a, 0x9c, 0x57, 0x86, 0x2d, 0x14, 0x33
+    };
+    u8 alice_public_key[] {
+        0x04, 0xda, 0xd0, 0xb6, 0x53, 0x94, 0x22, 0x1c, 0xf9, 0xb0, 0x51, 0xe1, 0xfe, 0xca, 0x57, 0x87,
+        0xd0, 0x98, 0xdf, 0xe6, 0x37, 0xfc, 0x90, 0xb9, 0xef, 0x94, 0x5d, 0x0c, 0x37, 0x72, 0x58, 0x11,
+        0x80, 0x52, 0x71, 0xa0, 0x46, 0x1c, 0xdb, 0x82, 0x52, 0xd6, 0x1f, 0x1c, 0x45, 0x6f, 0xa3, 0xe5,
+        0x9a, 0xb1, 0xf4, 0x5b, 0x33, 0xac, 0xcf, 0x5f, 0x58, 0x38, 0x9e, 0x05, 0x77, 0xb8, 0x99, 0x0b,
+        0xb3
+    };
+    u8 bob_private_key[] {
+        0xc6, 0xef, 0x9c, 0x5d, 0x78, 0xae, 0x01, 0x2a, 0x01, 0x11, 0x64, 0xac, 0xb3, 0x97, 0xce, 0x20,
+        0x88, 0x68, 0x5d, 0x8f, 0x06, 0xbf, 0x9b, 0xe0, 0xb2, 0x83, 0xab, 0x46, 0x47, 0x6b, 0xee, 0x53
+    };
+    u8 bob_public_key[] {
+        0x04, 0xd1, 0x2d, 0xfb, 0x52, 0x89, 0xc8, 0xd4, 0xf8, 0x12, 0x08, 0xb7, 0x02, 0x70, 0x39, 0x8c,
+        0x34, 0x22, 0x96, 0x97, 0x0a, 0x0b, 0xcc, 0xb7, 0x4c, 0x73, 0x6f, 0xc7, 0x55, 0x44, 0x94, 0xbf,
+        0x63, 0x56, 0xfb, 0xf3, 0xca, 0x36, 0x6c, 0xc2, 0x3e, 0x81, 0x57, 0x85, 0x4c, 0x13, 0xc5, 0x8d,
+        0x6a, 0xac, 0x23, 0xf0, 0x46, 0xad, 0xa3, 0x0f, 0x83, 0x53, 0xe7, 0x4f, 0x33, 0x03, 0x98, 0x72,
+        0xab
+    };
+    u8 shared_secret[] {
+        0xd6, 0x84, 0x0f, 0x6b, 0x42, 0xf6, 0xed, 0xaf, 0xd1, 0x31, 0x16, 0xe0, 0xe1, 0x25, 0x65, 0x20,
+        0x2f, 0xef, 0x8e, 0x9e, 0xce, 0x7d, 0xce, 0x03, 0x81, 0x24, 0x64, 0xd0, 0x4b, 0x94, 0x42, 0xde
+    };
+    Crypto::Curves::SECP256r1 curve;
+    test_key_exchange(curve, { alice_private_key, sizeof(alice_private_key) }, { alice_public_key, sizeof(alice_public_key) }, { bob_private_key, sizeof(bob_private_key) }, { bob_public_key, sizeof(bob_public_key) }, { shared_secret, sizeof(shared_secret) });
+}
+
+static void secp256r1_test_invalid_point()
+{
+    I_TEST((SECP256r1 | Invalid Point));
+    u8 private_key[Crypto::Curves::SECP256r1::KeySize];
+    u8 public_key[Crypto::Curves::SECP256r1::PointSize];
+    u8 secret[Crypto::Curves::SECP256r1::KeySize];
+    Crypto::Curves::SECP256r1 curve;
+    curve.generate_private_key({ private_key, sizeof(private_key) });
+    if (!curve.compute_public_key({ private_key, sizeof(private_key) }, { public_key, sizeof(public_key) })) {
+        FAIL(could not compute public key);
+        return;
+    }
+    // Nudging y moves the point off the curve.
+    public_key[sizeof(public_key) - 1] ^= 1;
+    if (curve.compute_shared_secret({ private_key, sizeof(private_key) }, { public_key, sizeof(public_key) }, { secret, sizeof(secret) }))
+        FAIL(point off the curve accepted);
+    else
+        PASS;
+}
+
 static int tls_tests()
 {
     tls_test_client_hello();
@@ -1818,6 +2456,24 @@ static int crc32_tests()
     do_test(String("The quick brown fox jumps over the lazy dog").bytes(), 0x414FA339);
     do_test(String("various CRC algorithms input data").bytes(), 0x9BD366AE);
 
+    StringBuilder builder;
+    for (size_t i = 0; i < 10; ++i)
+        builder.append("The quick brown fox jumps over the lazy dog");
+    auto input = builder.to_string();
+    do_test(input.bytes(), 0x8FF719D4);
+
+    {
+        I_TEST((CRC32 | Incremental Update));
+        Crypto::Checksum::CRC32 crc32;
+        for (size_t offset = 0; offset < input.length(); offset += 13)
+            crc32.update(input.bytes().slice(offset, min<size_t>(13, input.length() - offset)));
+        if (crc32.digest() == 0x8FF719D4) {
+            PASS;
+        } else {
+            FAIL(Incorrect Result);
+        }
+    }
+
     return g_some_test_failed ? 1 : 0;
 }
 
@@ -2011,6 +2667,29 @@ static void bigint_multiplication()
             FAIL(Incorrect Result);
         }
     }
+    {
+        // Both of these are long enough to go through Karatsuba.
+        I_TEST((BigInteger | Multiplications with big numbers 3));
+        Crypto::UnsignedBigInteger num1 = "32245375549942755150236203982344007131342961695015857486815621893918167968476350772256743940827875467422698309018386329821262804016352684562942021281834626128924338884197117740767413249205812310725619135450481807253054217985618342543472353263371015761442161142629019637314174187105512921748137444230505732634890930168661088551462463946220879913799254325688499277940125106989154070835844953361708529948640774720557551517777667997038781037349871603159559461971215465237163300433998624407152672395125509756064770689330250450717878500913978639014684435836754062627364503312020188564109664091600445217111766723426925932725"_bigint;
+        Crypto::UnsignedBigInteger num2 = "22866459358277212914770108489795849217467639487356144303128328701669485391111445736102497466620115023619048130770288764175644044669195530772190858896963744243335538920292025244815547808926059262699486873457820967633062809428587589813923039509690237028856411239345147358168012293191952573820348895814579593004302858025024989132257971576990144867891064009932817899915418846966020791800797532572790080984536297748887811126811334032216536296976804535853453671862598153699727133730705645603171978462598678858977776757085844719332242200647052321272233191593217642197265540677449573286641854979014767882628351680203482439179"_bigint;
+        Crypto::UnsignedBigInteger result = num1.multiplied_by(num2);
+        if (result == "737337569505151744413477763618518890641577456340605765549348354439939267378030475247630238877782362949207295339356637188275718907323966718926561176877204538119874738180380990975728833203678773329209739876694186550718043410131944334807346753800301629281506161864603804764930881963005350363597526048009760399372156476371492392405762644253546116019655151318298747199511870928714427449594727243260203631705370263466073264732877316626231538138124727762568230526898754934435283514486566471440451513336453375964625302755523157021144631486120331585412418491174182861864629687817596241141651509869977712303440915210406685228656115777604430663569302630790726850979832880766563393923733618908068680217806895435928085311240145334283288243803164273693789755448695609322687369866115519772499113670505449815155115600646598234363677149409589955592852071434888650116673790917181675157612639915031402696884853127598732074960883646348320299853414628206308704501901395122866961130512614180465173545843930778667735439879556116149677348662787984026931947254981043591125221635218877421786664258515290926383676352948936192898903199151333822179567743516055703593859981508339216930306676860975404224157252479620022195442207012665893527858276298556652658232775"_bigint) {
+            PASS;
+        } else {
+            FAIL(Incorrect Result);
+        }
+    }
+    {
+        I_TEST((BigInteger | Multiplications with big numbers of different lengths));
+        Crypto::UnsignedBigInteger num1 = "730791932879338174733259792262191500995468746531780848652487339209986156722503201641408431341544591632595716126345925224944648636715155218829665103687992326754834547321302175198391886670833465849153645268996302850507637540184715699025223318763467110843149631007842770686960238064278475031825542127225187035724861065817470798606743759996137939159182470111524073688054297027672127773419661514115892781718896748780589987481394528464223339353930940475704072127681903084810654351055844825764138752318654088367546020418087903485028146884205276053990200474205363990036118158892216361919876671137407950442676919386599387517920627404498166343498841226183458871630198851789754910408044075553205445207998975968452365339387568516280339618386285164777797013914674618428811874695070453418523993918109477526115671414159803108256361375934375149607938432320465108688232226723238343909828808928393073985087720868652860668"_bigint;
+        Crypto::UnsignedBigInteger num2 = "89825864308635106284901680562058141202238935798763951912086042618934046054719121058869091014409101664232361731216980732188752022790244320144231091308804661505705780742729164175033468637029623387871708661276449427362865748663058457407762308901903245135486656933095429775534716755214132000788710091458480150218284632159480522748642499895402198596002622785011268962630277228164773468760215560938395711421359394009787723783728427373264914666523828580366790142514295891015606365905281958215308998589623103788449185092521692800016221456954928452812891881639975360923152467926984061327664306113248984608099262"_bigint;
+        Crypto::UnsignedBigInteger result = num1.multiplied_by(num2);
+        if (result == "65644017000664605169961302963576262490145735232947437413720941714390861245825790995741155212450032467569263192866930595210078896280298958243909938522281560554806251643270008934085552000024533853496016199183507445599876078761888834226922100806154898931445129766180666338486159069606906261819306078573385664746291738969218784654178792252471163959446938013335909344624673678582309743602286187903996959790167457148347940183236595988304345525053955772971488466152942929326124736923966896041503552046591412231939769367266482357040028277781266285327754045601065288377094094864748534789451615320848158838305013695613640278942894599358793628698052292671061578986592602976406978935028981398613882946828615047129391414680442667196269752017527993344467971212487403611941230007516441391825574046000781154294212182023254862607530146094566758645071057350838563452579063556977408565226307099440357500997571409905053885300428156951528019365595967951251972421212411916623420900431340285249328732766333278205994830005434993705386343408643539482780011044266241375667513023714349182564857599372254059160797327594267202432536322759332571854839641423930948841073444930991745863978302989471141953630911939513419693128479545833640300395246838978332724457669416651293311664606588249000823257810143678987056600072064188636825427536562988312907764701380305368062063524131125615635185027304198342695593542977786691759282814827782673213848369286541732669790221839473870837550764436284616393599904381981524169188692392834364818399627016"_bigint && num2.multiplied_by(num1) == result) {
+            PASS;
+        } else {
+            FAIL(Incorrect Result);
+        }
+    }
 }
 static void bigint_division()
 {
@@ -2433,3 +3112,130 @@ static void bigint_signed_bitwise()
         }
     }
 }
+
+static constexpr size_t benchmark_buffer_size = 1 * MiB;
+
+// Runs `fn' over a buffer of random data for about a second, and prints the throughput.
+static void benchmark(const char* name, Function<void(ReadonlyBytes, Bytes)> fn)
+{
+    auto in = ByteBuffer::create_uninitialized(benchmark_buffer_size);
+    AK::fill_with_random(in.data(), in.size());
+    // Leave some room for padding.
+    auto out = ByteBuffer::create_uninitialized(benchmark_buffer_size + 64);
+
+    struct timeval end_time;
+    gettimeofday(&start_time, &tz);
+    u64 processed = 0;
+    u64 elapsed_us = 0;
+    do {
+        fn(in.bytes(), out.bytes());
+        processed += in.size();
+        gettimeofday(&end_time, &tz);
+        elapsed_us = (u64)(end_time.tv_sec - start_time.tv_sec) * 1000000 + end_time.tv_usec - start_time.tv_usec;
+    } while (elapsed_us < 1000000);
+
+    auto tenths_of_mib_per_second = processed * 10 * 1000000 / elapsed_us / MiB;
+    printf("%-32s %6llu.%llu MiB/s\n", name, (unsigned long long)(tenths_of_mib_per_second / 10), (unsigned long long)(tenths_of_mib_per_second % 10));
+}
+
+// Like benchmark(), but for operations that are slow enough to count one by one.
+static void benchmark_operation(const char* name, Function<void()> fn)
+{
+    struct timeval end_time;
+    gettimeofday(&start_time, &tz);
+    u64 operations = 0;
+    u64 elapsed_us = 0;
+    do {
+        fn();
+        ++operations;
+        gettimeofday(&end_time, &tz);
+        elapsed_us = (u64)(end_time.tv_sec - start_time.tv_sec) * 1000000 + end_time.tv_usec - start_time.tv_usec;
+    } while (elapsed_us < 1000000);
+
+    auto microseconds_per_operation = elapsed_us / operations;
+    printf("%-32s %6llu.%03llu ms/op\n", name, (unsigned long long)(microseconds_per_operation / 1000), (unsigned long long)(microseconds_per_operation % 1000));
+}
+
+static int run_benchmarks()
+{
+    printf("AES-NI: %s, PCLMULQDQ: %s\n",
+        Crypto::Cipher::AESCipher::is_hardware_accelerated() ? "yes" : "no",
+        Crypto::Authentication::GHash::is_hardware_accelerated() ? "yes" : "no");
+
+    auto key = "WellHelloFriendsWellHelloFriends"_b;
+    u8 iv_storage[16] {};
+    Bytes iv { iv_storage, sizeof(iv_storage) };
+    u8 aad[13] {};
+    u8 tag[16];
+
+    for (auto bits : { 128, 256 }) {
+        auto name = [&](const char* mode) { return String::format("AES-%d-%s", bits, mode); };
+
+        Crypto::Cipher::AESCipher::CBCMode cbc_encryption(key, bits, Crypto::Cipher::Intent::Encryption, Crypto::Cipher::PaddingMode::RFC5246);
+        benchmark(name("CBC encrypt").characters(), [&](auto in, auto out) { cbc_encryption.encrypt(in, out, iv); });
+        Crypto::Cipher::AESCipher::CBCMode cbc_decryption(key, bits, Crypto::Cipher::Intent::Decryption, Crypto::Cipher::PaddingMode::RFC5246);
+        benchmark(name("CBC decrypt").characters(), [&](auto in, auto out) { cbc_decryption.decrypt(in, out, iv); });
+
+        Crypto::Cipher::AESCipher::CTRMode ctr(key, bits, Crypto::Cipher::Intent::Encryption);
+        benchmark(name("CTR").characters(), [&](auto in, auto out) { ctr.encrypt(in, out, iv); });
+
+        Crypto::Cipher::AESCipher::GCMMode gcm(key, bits, Crypto::Cipher::Intent::Encryption);
+        benchmark(name("GCM encrypt").characters(), [&](auto in, auto out) { gcm.encrypt(in, out, { iv_storage, 12 }, { aad, sizeof(aad) }, { tag, sizeof(tag) }); });
+    }
+
+    Crypto::Cipher::ChaCha20Poly1305 chacha20_poly1305(key.bytes());
+    benchmark("ChaCha20-Poly1305 encrypt", [&](auto in, auto out) { chacha20_poly1305.encrypt(in, out, { iv_storage, 12 }, { aad, sizeof(aad) }, { tag, sizeof(tag) }); });
+
+    // For comparison with the MACs that go along with CBC.
+    printf("SHA extensions: %s, SHA256 multi-buffer lanes: %zu\n",
+        Crypto::Hash::SHA256::is_hardware_accelerated() ? "yes" : "no",
+        Crypto::Hash::SHA256::multi_buffer_lanes());
+    benchmark("MD5", [&](auto in, auto) { Crypto::Hash::MD5::hash(in.data(), in.size()); });
+    benchmark("SHA1", [&](auto in, auto) { Crypto::Hash::SHA1::hash(in.data(), in.size()); });
+    benchmark("SHA256", [&](auto in, auto) { Crypto::Hash::SHA256::hash(in.data(), in.size()); });
+    benchmark("SHA512", [&](auto in, auto) { Crypto::Hash::SHA512::hash(in.data(), in.size()); });
+
+    // Lots of small independent messages, one after the other and then all at once.
+    constexpr size_t message_size = 1 * KiB;
+    constexpr size_t message_count = benchmark_buffer_size / message_size;
+    Vector<ReadonlyBytes> messages;
+    Vector<Crypto::Hash::SHA256::DigestType> digests;
+    digests.resize(message_count);
+    benchmark("SHA256 1 KiB messages", [&](auto in, auto) {
+        for (size_t i = 0; i < message_count; ++i)
+            digests[i] = Crypto::Hash::SHA256::hash(in.data() + i * message_size, message_size);
+    });
+    benchmark("SHA256 1 KiB multi-buffer", [&](auto in, auto) {
+        messages.clear_with_capacity();
+        for (size_t i = 0; i < message_count; ++i)
+            messages.append({ in.data() + i * message_size, message_size });
+        Crypto::Hash::SHA256::hash_many(messages.span(), digests.span());
+    });
+
+    Crypto::Authentication::HMAC<Crypto::Hash::SHA1> hmac_sha1(key);
+    benchmark("HMAC-SHA1", [&](auto in, auto) { hmac_sha1.process(in); });
+    Crypto::Authentication::HMAC<Crypto::Hash::SHA256> hmac(key);
+    benchmark("HMAC-SHA256", [&](auto in, auto) { hmac.process(in); });
+    Crypto::Authentication::HMAC<Crypto::Hash::SHA512> hmac_sha512(key);
+    benchmark("HMAC-SHA512", [&](auto in, auto) { hmac_sha512.process(in); });
+
+    Crypto::PK::RSA rsa(
+        "25988985174779135073753888746899492009832206832344854782696797654773742883951954462958574643794555853478782673067307761832135158935559178577480797962717733556693024153539260297864671427754185846234089272563265894792806493097191209651999883694081130093668111296308216116814251374424502478365795068021779621488797636698065690629980026787491502349702098866944070545253622850295692111315158540410574819108552977695763093365695266313266214520801903432172359218505794682558315356414695132874704000097375741087695707314343908731803392543682841223939844597470515874771464561205865828595660297188481645199034538501614966348383"_bigint,
+        "3285254858789046561766850654190592208301492553863633511562195708851077603828371252092410571684941299848100692052216475470319418407947266657386509463694326314149615615606390312917281389798580231672586669797982457320460280331166830589773609357517358473244021972843819772338490707713502155759669030334413129594294295885089446320420673993103755417273521599620587159970496196008432087519054067091293796026039138904929603946559504312271065566696780793364957804980351378391267772247930339446798152016501403242174681381413714611954134951185159012494873227225635870025166748483335873797006250144124949840404285684052675153281"_bigint,
+        "65537"_bigint);
+    auto message = ByteBuffer::create_uninitialized(rsa.output_size());
+    AK::fill_with_random(message.data(), message.size());
+    message[0] = 0;
+    auto signature = ByteBuffer::create_zeroed(rsa.output_size());
+    rsa.sign(message, signature);
+    benchmark_operation("RSA-2048 sign", [&] {
+        auto out = ByteBuffer::create_zeroed(rsa.output_size());
+        rsa.sign(message, out);
+    });
+    benchmark_operation("RSA-2048 verify", [&] {
+        auto out = ByteBuffer::create_zeroed(rsa.output_size());
+        rsa.verify(signature, out);
+    });
+
+    return 0;
+}
@@ -104,9 +104,11 @@ private:
 
 class TestRunner {
 public:
-    TestRunner(String test_root, bool print_times)
+    TestRunner(String test_root, bool print_times, bool use_bytecode, bool lazy_function_parsing)
         : m_test_root(move(test_root))
         , m_print_times(print_times)
+        , m_use_bytecode(use_bytecode)
+        , m_lazy_function_parsing(lazy_function_parsing)
     {
     }
 
@@ -119,6 +121,8 @@ private:
 
     String m_test_root;
     bool m_print_times;
+    bool m_use_bytecode;
+    bool m_lazy_function_parsing;
 
     double m_total_elapsed_time_in_ms { 0 };
     JSTestRunnerCounts m_counts;
@@ -218,7 +222,7 @@ void TestRunner::run()
     print_test_results();
 }
 
-static Result<NonnullRefPtr<JS::Program>, ParserError> parse_file(const String& file_path)
+static Result<NonnullRefPtr<JS::Program>, ParserError> parse_file(const String& file_path, bool lazy_function_parsing)
 {
     auto file = Core::File::construct(file_path);
     auto result = file->open(Core::IODevice::ReadOnly);
@@ -232,6 +236,7 @@ static Result<NonnullRefPtr<JS::Program>, ParserError> parse_file(const String&
     file->close();
 
     auto parser = JS::Parser(JS::Lexer(test_file_string));
+    parser.set_lazy_function_parsing(lazy_function_parsing);
     auto program = parser.parse_program();
 
     if (parser.has_errors()) {
@@ -258,9 +263,10 @@ JSFileResult TestRunner::run_file_test(const String& test_path)
 {
     double start_time = get_time_in_ms();
     auto interpreter = JS::Interpreter::create<TestRunnerGlobalObject>();
+    interpreter->set_bytecode_enabled(m_use_bytecode);
 
     if (!m_test_program) {
-        auto result = parse_file(String::format("%s/test-common.js", m_test_root.characters()));
+        auto result = parse_file(String::format("%s/test-common.js", m_test_root.characters()), m_lazy_function_parsing);
         if (result.is_error()) {
             printf("Unable to parse test-common.js\n");
             printf("%s\n", result.error().error.to_string().characters());
@@ -272,7 +278,7 @@ JSFileResult TestRunner::run_file_test(const String& test_path)
 
     interpreter->run(interpreter->global_object(), *m_test_program);
 
-    auto file_program = parse_file(test_path);
+    auto file_program = parse_file(test_path, m_lazy_function_parsing);
     if (file_program.is_error())
         return { test_path, file_program.error() };
     interpreter->run(interpreter->global_object(), *file_program.value());
@@ -555,6 +561,8 @@ void TestRunner::print_test_results() const
 int main(int argc, char** argv)
 {
     bool print_times = false;
+    bool use_bytecode = false;
+    bool lazy_function_parsing = false;
 
     struct sigaction act;
     memset(&act, 0, sizeof(act));
@@ -568,17 +576,19 @@ int main(int argc, char** argv)
 
     Core::ArgsParser args_parser;
     args_parser.add_option(print_times, "Show duration of each test", "show-time", 't');
+    args_parser.add_option(use_bytecode, "Run functions through the bytecode interpreter", "bytecode", 'b');
+    args_parser.add_option(lazy_function_parsing, "Parse function bodies when they're first called", "lazy-parse", 'L');
     args_parser.parse(argc, argv);
 
 #ifdef __serenity__
-    TestRunner("/home/anon/js-tests", print_times).run();
+    TestRunner("/home/anon/js-tests", print_times, use_bytecode, lazy_function_parsing).run();
 #else
     char* serenity_root = getenv("SERENITY_ROOT");
     if (!serenity_root) {
         printf("test-js requires the SERENITY_ROOT environment variable to be set");
         return 1;
     }
-    TestRunner(String::format("%s/Libraries/LibJS/Tests", serenity_root), print_times).run();
+    TestRunner(String::format("%s/Libraries/LibJS/Tests", serenity_root), print_times, use_bytecode, lazy_function_parsing).run();
 #endif
 
     return 0;
@@ -42,9 +42,17 @@
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/JSONObject.h>
 #include <LibJS/Runtime/MarkedValueList.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Painter.h>
+#include <LibWeb/CSS/StyleResolver.h>
+#include <LibWeb/DOM/Element.h>
 #include <LibWeb/HTML/Parser/HTMLDocumentParser.h>
+#include <LibWeb/Layout/LayoutDocument.h>
 #include <LibWeb/Loader/ResourceLoader.h>
 #include <LibWeb/InProcessWebView.h>
+#include <LibWeb/Page/Frame.h>
+#include <LibWeb/Painting/PaintContext.h>
+#include <math.h>
 #include <signal.h>
 #include <sys/time.h>
 
@@ -654,10 +662,228 @@ void TestRunner::print_test_results() const
     }
 }
 
+// Benchmarks the phases of loading and rendering a corpus of pages. Each page goes through one
+// warm-up run, followed by the requested number of measured runs.
+class BenchmarkRunner {
+public:
+    enum Phase {
+        Parse,
+        Style,
+        LayoutTree,
+        Layout,
+        Paint,
+        PhaseCount,
+    };
+
+    BenchmarkRunner(Vector<String> page_paths, Web::InProcessWebView& page_view, int runs)
+        : m_page_paths(move(page_paths))
+        , m_page_view(page_view)
+        , m_runs(runs)
+    {
+    }
+
+    void run();
+
+private:
+    using Timings = Vector<double>[PhaseCount];
+
+    bool run_once(const String& page_path, const ByteBuffer& data, Timings&);
+    void print_page_result(const String& page_path, const Timings&);
+
+    static const char* phase_name(Phase);
+
+    Vector<String> m_page_paths;
+    RefPtr<Web::InProcessWebView> m_page_view;
+    int m_runs { 0 };
+
+    double m_total_medians[PhaseCount] {};
+};
+
+static const Gfx::IntSize benchmark_viewport_size { 800, 600 };
+
+const char* BenchmarkRunner::phase_name(Phase phase)
+{
+    switch (phase) {
+    case Parse:
+        return "parse";
+    case Style:
+        return "style";
+    case LayoutTree:
+        return "layout tree";
+    case Layout:
+        return "layout";
+    case Paint:
+        return "paint";
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+static void resolve_style_recursively(const Web::CSS::StyleResolver& resolver, const Web::DOM::Node& node, const Web::CSS::StyleProperties* parent_style)
+{
+    RefPtr<Web::CSS::StyleProperties> style;
+    if (is<Web::DOM::Element>(node)) {
+        style = resolver.resolve_style(downcast<Web::DOM::Element>(node), parent_style);
+        parent_style = style.ptr();
+    }
+    node.for_each_child([&](auto& child) {
+        resolve_style_recursively(resolver, child, parent_style);
+    });
+}
+
+bool BenchmarkRunner::run_once(const String& page_path, const ByteBuffer& data, Timings& timings)
+{
+    auto url = URL::create_with_file_protocol(page_path);
+    auto document = adopt(*new Web::DOM::Document(url));
+
+    auto start_time = get_time_in_ms();
+    Web::HTML::HTMLDocumentParser parser(data, "utf-8", document);
+    parser.run(url);
+    timings[Parse].append(get_time_in_ms() - start_time);
+
+    m_page_view->set_document(document);
+    if (!document->frame())
+        return false;
+    document->frame()->set_size(benchmark_viewport_size);
+    document->frame()->set_viewport_rect({ {}, benchmark_viewport_size });
+
+    // Style is resolved again while building the layout tree, so "layout tree" includes it too.
+    start_time = get_time_in_ms();
+    resolve_style_recursively(document->style_resolver(), document, nullptr);
+    timings[Style].append(get_time_in_ms() - start_time);
+
+    document->invalidate_layout();
+    start_time = get_time_in_ms();
+    document->update_layout_tree();
+    timings[LayoutTree].append(get_time_in_ms() - start_time);
+
+    auto* layout_root = document->layout_node();
+    if (!layout_root)
+        return false;
+
+    start_time = get_time_in_ms();
+    layout_root->layout();
+    timings[Layout].append(get_time_in_ms() - start_time);
+
+    auto bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, benchmark_viewport_size);
+    if (!bitmap)
+        return false;
+    Gfx::Painter painter(*bitmap);
+    Web::PaintContext context(painter, static_cast<GUI::Widget&>(*m_page_view).palette(), {});
+    context.set_viewport_rect({ {}, benchmark_viewport_size });
+    start_time = get_time_in_ms();
+    layout_root->paint_all_phases(context);
+    timings[Paint].append(get_time_in_ms() - start_time);
+
+    m_page_view->set_document(nullptr);
+    return true;
+}
+
+struct Statistics {
+    double min { 0 };
+    double median { 0 };
+    double mean { 0 };
+    double max { 0 };
+    double standard_deviation { 0 };
+};
+
+static Statistics compute_statistics(Vector<double> samples)
+{
+    Statistics statistics;
+    if (samples.is_empty())
+        return statistics;
+
+    quick_sort(samples);
+    statistics.min = samples.first();
+    statistics.max = samples.last();
+    auto middle = samples.size() / 2;
+    statistics.median = samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+
+    double sum = 0;
+    for (auto sample : samples)
+        sum += sample;
+    statistics.mean = sum / samples.size();
+
+    double squared_deviations = 0;
+    for (auto sample : samples)
+        squared_deviations += (sample - statistics.mean) * (sample - statistics.mean);
+    statistics.standard_deviation = sqrt(squared_deviations / samples.size());
+    return statistics;
+}
+
+void BenchmarkRunner::print_page_result(const String& page_path, const Timings& timings)
+{
+    printf("%s\n", page_path.characters());
+    for (int phase = 0; phase < PhaseCount; ++phase) {
+        auto statistics = compute_statistics(timings[phase]);
+        m_total_medians[phase] += statistics.median;
+        printf("    %-12s median %8.3fms  mean %8.3fms  min %8.3fms  max %8.3fms  stddev %7.3fms\n",
+            phase_name((Phase)phase), statistics.median, statistics.mean, statistics.min, statistics.max, statistics.standard_deviation);
+    }
+}
+
+void BenchmarkRunner::run()
+{
+    size_t pages_run = 0;
+    for (auto& page_path : m_page_paths) {
+        auto file = Core::File::construct(page_path);
+        if (!file->open(Core::IODevice::ReadOnly)) {
+            printf("Could not open %s: %s\n", page_path.characters(), file->error_string());
+            continue;
+        }
+        auto data = file->read_all();
+
+        Timings warm_up_timings;
+        if (!run_once(page_path, data, warm_up_timings)) {
+            printf("Could not lay out %s, skipping it\n", page_path.characters());
+            continue;
+        }
+
+        Timings timings;
+        for (int i = 0; i < m_runs; ++i)
+            run_once(page_path, data, timings);
+        print_page_result(page_path, timings);
+        ++pages_run;
+    }
+
+    printf("\nBenchmarked %zu pages, %d runs each. Sum of medians:\n", pages_run, m_runs);
+    double total = 0;
+    for (int phase = 0; phase < PhaseCount; ++phase) {
+        printf("    %-12s %8.3fms\n", phase_name((Phase)phase), m_total_medians[phase]);
+        total += m_total_medians[phase];
+    }
+    printf("    %-12s %8.3fms\n", "total", total);
+}
+
+static Vector<String> get_benchmark_paths(const String& corpus_root)
+{
+    Vector<String> paths;
+
+    iterate_directory_recursively(corpus_root, [&](const String& file_path) {
+        if (!file_path.ends_with(".html"))
+            return;
+        // Pages that can pop up dialogs would block the benchmark.
+        auto file = Core::File::construct(file_path);
+        if (!file->open(Core::IODevice::ReadOnly))
+            return;
+        auto contents = String::copy(file->read_all());
+        if (contents.contains("alert(") || contents.contains("confirm(") || contents.contains("prompt("))
+            return;
+        paths.append(file_path);
+    });
+
+    quick_sort(paths);
+
+    return paths;
+}
+
 int main(int argc, char** argv)
 {
     bool print_times = false;
     bool show_window = false;
+    bool benchmark = false;
+    int benchmark_runs = 10;
+    Vector<const char*> benchmark_pages;
 
     struct sigaction act;
     memset(&act, 0, sizeof(act));
@@ -672,6 +898,9 @@ int main(int argc, char** argv)
     Core::ArgsParser args_parser;
     args_parser.add_option(print_times, "Show duration of each test", "show-time", 't');
     args_parser.add_option(show_window, "Show window while running tests", "window", 'w');
+    args_parser.add_option(benchmark, "Time parsing, style, layout and painting of pages instead of running tests", "bench", 'b');
+    args_parser.add_option(benchmark_runs, "Number of measured runs per page when benchmarking", "runs", 'n', "count");
+    args_parser.add_positional_argument(benchmark_pages, "Pages to benchmark (default: the pages in /res/html/misc)", "pages", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
     auto app = GUI::Application::construct(argc, argv);
@@ -690,13 +919,29 @@ int main(int argc, char** argv)
     }
 
 #ifdef __serenity__
-    TestRunner("/home/anon/web-tests", "/home/anon/js-tests", view, print_times).run();
+    String resource_root = "/res";
 #else
     char* serenity_root = getenv("SERENITY_ROOT");
     if (!serenity_root) {
         printf("test-web requires the SERENITY_ROOT environment variable to be set");
         return 1;
     }
+    String resource_root = String::format("%s/Base/res", serenity_root);
+#endif
+
+    if (benchmark) {
+        Vector<String> page_paths;
+        for (auto* page : benchmark_pages)
+            page_paths.append(page);
+        if (page_paths.is_empty())
+            page_paths = get_benchmark_paths(String::format("%s/html/misc", resource_root.characters()));
+        BenchmarkRunner(move(page_paths), view, max(benchmark_runs, 1)).run();
+        return 0;
+    }
+
+#ifdef __serenity__
+    TestRunner("/home/anon/web-tests", "/home/anon/js-tests", view, print_times).run();
+#else
     TestRunner(String::format("%s/Libraries/LibWeb/Tests", serenity_root), String::format("%s/Libraries/LibJS/Tests", serenity_root), view, print_times).run();
 #endif
     return 0;
@@ -130,9 +130,9 @@ private:
         int rc;
 
         if (m_kind == SymbolicLink)
-            rc = stat(m_path.characters(), &statbuf);
-        else
             rc = lstat(m_path.characters(), &statbuf);
+        else
+            rc = stat(m_path.characters(), &statbuf);
 
         if (rc < 0) {
             if (errno != ENOENT) {
@@ -58,6 +58,9 @@ struct ThreadData {
     unsigned inode_faults;
     unsigned zero_faults;
     unsigned cow_faults;
+    unsigned file_read_bytes;
+    unsigned file_write_bytes;
+    unsigned block_io_requests;
     int icon_id;
     unsigned times_scheduled;
 
@@ -65,6 +68,11 @@ struct ThreadData {
     unsigned cpu_percent { 0 };
     unsigned cpu_percent_decimal { 0 };
 
+    // The I/O done since the previous snapshot, which is taken a second earlier.
+    unsigned file_read_bytes_since_prev { 0 };
+    unsigned file_write_bytes_since_prev { 0 };
+    unsigned block_io_requests_since_prev { 0 };
+
     u32 priority;
     String username;
     String state;
@@ -93,11 +101,11 @@ struct Snapshot {
 
 static Snapshot get_snapshot()
 {
-    Snapshot snapshot;
+    static Core::ProcessStatisticsReader reader;
+    reader.update();
 
-    auto all_processes = Core::ProcessStatisticsReader::get_all();
-
-    for (auto& it : all_processes) {
+    Snapshot snapshot;
+    for (auto& it : reader.processes()) {
         auto& stats = it.value;
         for (auto& thread : stats.threads) {
             snapshot.sum_times_scheduled += thread.times_scheduled;
@@ -120,6 +128,9 @@ static Snapshot get_snapshot()
             thread_data.inode_faults = thread.inode_faults;
             thread_data.zero_faults = thread.zero_faults;
             thread_data.cow_faults = thread.cow_faults;
+            thread_data.file_read_bytes = thread.file_read_bytes;
+            thread_data.file_write_bytes = thread.file_write_bytes;
+            thread_data.block_io_requests = thread.block_io_requests;
             thread_data.icon_id = stats.icon_id;
             thread_data.times_scheduled = thread.times_scheduled;
             thread_data.priority = thread.priority;
@@ -148,6 +159,11 @@ int main(int, char**)
         return 1;
     }
 
+    if (unveil("/proc/all.bin", "r") < 0) {
+        perror("unveil");
+        return 1;
+    }
+
     if (unveil("/etc/passwd", "r") < 0) {
         perror("unveil");
         return 1;
@@ -181,7 +197,7 @@ int main(int, char**)
         auto sum_diff = current.sum_times_scheduled - prev.sum_times_scheduled;
 
         printf("\033[3J\033[H\033[2J");
-        printf("\033[47;30m%6s %3s %3s  %-9s  %-10s  %6s  %6s  %4s  %s\033[K\033[0m\n",
+        printf("\033[47;30m%6s %3s %3s  %-9s  %-10s  %6s  %6s  %4s  %6s  %6s  %5s  %s\033[K\033[0m\n",
             "PID",
             "TID",
             "PRI",
@@ -190,6 +206,9 @@ int main(int, char**)
             "VIRT",
             "PHYS",
             "%CPU",
+            "RD K/s",
+            "WR K/s",
+            "BIO/s",
             "NAME");
         for (auto& it : current.map) {
             auto pid_and_tid = it.key;
@@ -204,6 +223,9 @@ int main(int, char**)
             it.value.times_scheduled_since_prev = times_scheduled_diff;
             it.value.cpu_percent = ((times_scheduled_diff * 100) / sum_diff);
             it.value.cpu_percent_decimal = (((times_scheduled_diff * 1000) / sum_diff) % 10);
+            it.value.file_read_bytes_since_prev = it.value.file_read_bytes - (*jt).value.file_read_bytes;
+            it.value.file_write_bytes_since_prev = it.value.file_write_bytes - (*jt).value.file_write_bytes;
+            it.value.block_io_requests_since_prev = it.value.block_io_requests - (*jt).value.block_io_requests;
             threads.append(&it.value);
         }
 
@@ -213,7 +235,7 @@ int main(int, char**)
 
         int row = 0;
         for (auto* thread : threads) {
-            int nprinted = printf("%6d %3d %2u   %-9s  %-10s  %6zu  %6zu  %2u.%1u  ",
+            int nprinted = printf("%6d %3d %2u   %-9s  %-10s  %6zu  %6zu  %2u.%1u  %6u  %6u  %5u  ",
                 thread->pid,
                 thread->tid,
                 thread->priority,
@@ -222,7 +244,10 @@ int main(int, char**)
                 thread->amount_virtual / 1024,
                 thread->amount_resident / 1024,
                 thread->cpu_percent,
-                thread->cpu_percent_decimal);
+                thread->cpu_percent_decimal,
+                thread->file_read_bytes_since_prev / 1024,
+                thread->file_write_bytes_since_prev / 1024,
+                thread->block_io_requests_since_prev);
 
             int remaining = g_window_size.ws_col - nprinted;
             fwrite(thread->name.characters(), 1, max(0, min(remaining, (int)thread->name.length())), stdout);
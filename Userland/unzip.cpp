@@ -24,142 +24,278 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
+#include <AK/ByteBuffer.h>
 #include <AK/MappedFile.h>
 #include <AK/NumberFormat.h>
+#include <AK/Stream.h>
+#include <AK/Vector.h>
+#include <LibCompress/Deflate.h>
 #include <LibCore/ArgsParser.h>
-#include <LibCore/File.h>
+#include <LibCrypto/Checksum/CRC32.h>
+#include <LibThread/ThreadPool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
-static const u8 central_directory_file_header_sig[] = "\x50\x4b\x01\x02";
+// Entries are decompressed, checksummed and written out this much at a time.
+static constexpr size_t extract_block_size = 64 * KiB;
 
-static bool seek_and_read(u8* buffer, const MappedFile& file, off_t seek_to, size_t bytes_to_read)
+static constexpr u32 end_of_central_directory_sig = 0x06054b50;
+static constexpr u32 central_directory_file_header_sig = 0x02014b50;
+static constexpr u32 local_file_header_sig = 0x04034b50;
+
+enum CompressionMethod {
+    None = 0,
+    Shrunk = 1,
+    Factor1 = 2,
+    Factor2 = 3,
+    Factor3 = 4,
+    Factor4 = 5,
+    Implode = 6,
+    Deflate = 8,
+    EnhancedDeflate = 9,
+    PKWareDCLImplode = 10,
+    BZIP2 = 12,
+    LZMA = 14,
+    TERSE = 18,
+    LZ77 = 19,
+};
+
+struct Entry {
+    String name;
+    u16 compression_method { None };
+    u32 crc32 { 0 };
+    u32 compressed_size { 0 };
+    u32 uncompressed_size { 0 };
+    u32 local_file_header_offset { 0 };
+};
+
+static bool read_u16(const MappedFile& file, size_t offset, u16& value)
 {
-    if (!buffer)
+    if (offset + 2 > file.size())
         return false;
+    auto* data = (const u8*)file.data() + offset;
+    value = data[1] << 8 | data[0];
+    return true;
+}
 
-    if ((size_t)seek_to >= file.size())
+static bool read_u32(const MappedFile& file, size_t offset, u32& value)
+{
+    if (offset + 4 > file.size())
         return false;
-
-    memcpy(buffer, (const char*)file.data() + seek_to, bytes_to_read);
-
+    auto* data = (const u8*)file.data() + offset;
+    value = (u32)data[3] << 24 | data[2] << 16 | data[1] << 8 | data[0];
     return true;
 }
 
-static bool find_next_central_directory(off_t file_size, const MappedFile& file, off_t current_index, off_t& return_index)
+static bool find_end_of_central_directory(const MappedFile& file, size_t& return_offset)
 {
-    off_t start_index = current_index == 0 ? current_index : current_index + 1;
-    for (off_t index = start_index; index < file_size - 4; index++) {
-        u8 buffer[4];
-        if (!seek_and_read(buffer, file, index, 4))
-            return false;
+    enum EndOfCentralDirectoryOffsets {
+        EOCDCommentLengthOffset = 20,
+        EOCDSize = 22,
+    };
 
-        if (!memcmp(buffer, central_directory_file_header_sig, 4)) {
-            return_index = index;
+    if (file.size() < EOCDSize)
+        return false;
+    // The record is at the very end, unless the archive has a comment of up to 64 KiB.
+    size_t lowest_offset = file.size() >= EOCDSize + 0xffff ? file.size() - EOCDSize - 0xffff : 0;
+    for (size_t offset = file.size() - EOCDSize + 1; offset-- > lowest_offset;) {
+        u32 signature;
+        u16 comment_length;
+        if (read_u32(file, offset, signature) && signature == end_of_central_directory_sig
+            && read_u16(file, offset + EOCDCommentLengthOffset, comment_length) && offset + EOCDSize + comment_length == file.size()) {
+            return_offset = offset;
             return true;
         }
     }
     return false;
 }
 
-static bool unpack_file_for_central_directory_index(off_t central_directory_index, const MappedFile& file)
+static bool read_central_directory(const MappedFile& file, Vector<Entry>& entries)
 {
+    enum EndOfCentralDirectoryOffsets {
+        EOCDEntryCountOffset = 10,
+        EOCDCentralDirectoryOffsetOffset = 16,
+    };
     enum CentralFileDirectoryHeaderOffsets {
         CFDHCompressionMethodOffset = 10,
+        CFDHCRC32Offset = 16,
+        CFDHCompressedSizeOffset = 20,
+        CFDHUncompressedSizeOffset = 24,
+        CFDHFileNameLengthOffset = 28,
+        CFDHExtraFieldLengthOffset = 30,
+        CFDHFileCommentLengthOffset = 32,
         CFDHLocalFileHeaderIndexOffset = 42,
+        CFDHFileNameBaseOffset = 46,
     };
+
+    size_t end_of_central_directory;
+    if (!find_end_of_central_directory(file, end_of_central_directory))
+        return false;
+
+    u16 entry_count;
+    u32 central_directory_offset;
+    if (!read_u16(file, end_of_central_directory + EOCDEntryCountOffset, entry_count)
+        || !read_u32(file, end_of_central_directory + EOCDCentralDirectoryOffsetOffset, central_directory_offset))
+        return false;
+
+    entries.ensure_capacity(entry_count);
+    size_t offset = central_directory_offset;
+    for (size_t i = 0; i < entry_count; ++i) {
+        u32 signature;
+        if (!read_u32(file, offset, signature) || signature != central_directory_file_header_sig)
+            return false;
+
+        Entry entry;
+        u16 file_name_length;
+        u16 extra_field_length;
+        u16 file_comment_length;
+        if (!read_u16(file, offset + CFDHCompressionMethodOffset, entry.compression_method)
+            || !read_u32(file, offset + CFDHCRC32Offset, entry.crc32)
+            || !read_u32(file, offset + CFDHCompressedSizeOffset, entry.compressed_size)
+            || !read_u32(file, offset + CFDHUncompressedSizeOffset, entry.uncompressed_size)
+            || !read_u16(file, offset + CFDHFileNameLengthOffset, file_name_length)
+            || !read_u16(file, offset + CFDHExtraFieldLengthOffset, extra_field_length)
+            || !read_u16(file, offset + CFDHFileCommentLengthOffset, file_comment_length)
+            || !read_u32(file, offset + CFDHLocalFileHeaderIndexOffset, entry.local_file_header_offset))
+            return false;
+
+        if (!file_name_length || offset + CFDHFileNameBaseOffset + file_name_length > file.size())
+            return false;
+        entry.name = String((const char*)file.data() + offset + CFDHFileNameBaseOffset, file_name_length);
+
+        entries.append(move(entry));
+        offset += CFDHFileNameBaseOffset + file_name_length + extra_field_length + file_comment_length;
+    }
+    return true;
+}
+
+// Finds the entry's data by way of its local file header. Its sizes are taken from the central directory,
+// since the local header doesn't have them if they were written after the data.
+static bool find_entry_data(const MappedFile& file, const Entry& entry, ReadonlyBytes& data)
+{
     enum LocalFileHeaderOffsets {
-        LFHCompressionMethodOffset = 8,
-        LFHCompressedSizeOffset = 18,
         LFHFileNameLengthOffset = 26,
         LFHExtraFieldLengthOffset = 28,
         LFHFileNameBaseOffset = 30,
     };
-    enum CompressionMethod {
-        None = 0,
-        Shrunk = 1,
-        Factor1 = 2,
-        Factor2 = 3,
-        Factor3 = 4,
-        Factor4 = 5,
-        Implode = 6,
-        Deflate = 8,
-        EnhancedDeflate = 9,
-        PKWareDCLImplode = 10,
-        BZIP2 = 12,
-        LZMA = 14,
-        TERSE = 18,
-        LZ77 = 19,
-    };
 
-    u8 buffer[4];
-    if (!seek_and_read(buffer, file, central_directory_index + CFDHLocalFileHeaderIndexOffset, 4))
+    u32 signature;
+    u16 file_name_length;
+    u16 extra_field_length;
+    if (!read_u32(file, entry.local_file_header_offset, signature) || signature != local_file_header_sig
+        || !read_u16(file, entry.local_file_header_offset + LFHFileNameLengthOffset, file_name_length)
+        || !read_u16(file, entry.local_file_header_offset + LFHExtraFieldLengthOffset, extra_field_length))
         return false;
-    off_t local_file_header_index = buffer[3] << 24 | buffer[2] << 16 | buffer[1] << 8 | buffer[0];
 
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHCompressionMethodOffset, 2))
+    size_t data_offset = (size_t)entry.local_file_header_offset + LFHFileNameBaseOffset + file_name_length + extra_field_length;
+    if (data_offset + entry.compressed_size > file.size())
         return false;
-    auto compression_method = buffer[1] << 8 | buffer[0];
-    // FIXME: Remove once any decompression is supported.
-    ASSERT(compression_method == None);
+    data = { (const u8*)file.data() + data_offset, entry.compressed_size };
+    return true;
+}
 
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHCompressedSizeOffset, 4))
+static bool create_directory(const String& path)
+{
+    if (mkdir(path.characters(), 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Can't create directory %s: %s\n", path.characters(), strerror(errno));
         return false;
-    off_t compressed_file_size = buffer[3] << 24 | buffer[2] << 16 | buffer[1] << 8 | buffer[0];
+    }
+    return true;
+}
 
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHFileNameLengthOffset, 2))
-        return false;
-    off_t file_name_length = buffer[1] << 8 | buffer[0];
+// Makes the directories leading up to an entry, as archives don't have to list them on their own.
+static bool create_leading_directories(const String& name)
+{
+    for (size_t i = 1; i < name.length(); ++i) {
+        if (name[i] == '/' && !create_directory(name.substring(0, i)))
+            return false;
+    }
+    return true;
+}
 
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHExtraFieldLengthOffset, 2))
+static bool write_all(int fd, const u8* data, size_t size)
+{
+    while (size) {
+        ssize_t nwritten = write(fd, data, size);
+        if (nwritten <= 0)
+            return false;
+        data += nwritten;
+        size -= nwritten;
+    }
+    return true;
+}
+
+// Streams an entry out to its file, one block at a time, and checks its size and CRC32 along the way.
+static bool extract_entry(const Entry& entry, ReadonlyBytes data)
+{
+    if (entry.compression_method != None && entry.compression_method != Deflate) {
+        fprintf(stderr, "Can't extract %s: Unsupported compression method %u\n", entry.name.characters(), entry.compression_method);
         return false;
-    off_t extra_field_length = buffer[1] << 8 | buffer[0];
+    }
 
-    if (!seek_and_read(buffer, file, local_file_header_index + LFHFileNameBaseOffset, file_name_length))
+    int fd = open(entry.name.characters(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Can't write file %s: %s\n", entry.name.characters(), strerror(errno));
         return false;
-    char file_name[file_name_length + 1];
-    memcpy(file_name, buffer, file_name_length);
-    file_name[file_name_length] = '\0';
+    }
 
-    if (file_name[file_name_length - 1] == '/') {
-        if (mkdir(file_name, 0755) < 0) {
-            perror("mkdir");
-            return false;
+    Crypto::Checksum::CRC32 crc32;
+    size_t uncompressed_size = 0;
+    bool ok = true;
+    auto write_block = [&](ReadonlyBytes block) {
+        crc32.update(block);
+        uncompressed_size += block.size();
+        if (!write_all(fd, block.data(), block.size())) {
+            fprintf(stderr, "Can't write file contents in %s: %s\n", entry.name.characters(), strerror(errno));
+            ok = false;
         }
+    };
+
+    if (entry.compression_method == None) {
+        for (size_t offset = 0; ok && offset < data.size(); offset += extract_block_size)
+            write_block(data.slice(offset, min(extract_block_size, data.size() - offset)));
     } else {
-        auto new_file = Core::File::construct(String { file_name });
-        if (!new_file->open(Core::IODevice::WriteOnly)) {
-            fprintf(stderr, "Can't write file %s: %s\n", file_name, new_file->error_string());
-            return false;
+        InputMemoryStream compressed_stream { data };
+        Compress::DeflateStream deflate_stream { compressed_stream };
+        auto buffer = ByteBuffer::create_uninitialized(extract_block_size);
+        while (ok) {
+            auto nread = deflate_stream.read(buffer.bytes());
+            if (!nread)
+                break;
+            write_block(buffer.bytes().slice(0, nread));
         }
-
-        printf(" extracting: %s\n", file_name);
-        u8 raw_file_contents[compressed_file_size];
-        if (!seek_and_read(raw_file_contents, file, local_file_header_index + LFHFileNameBaseOffset + file_name_length + extra_field_length, compressed_file_size))
-            return false;
-
-        // FIXME: Try to uncompress data here. We're just ignoring it as no decompression methods are implemented yet.
-        if (!new_file->write(raw_file_contents, compressed_file_size)) {
-            fprintf(stderr, "Can't write file contents in %s: %s\n", file_name, new_file->error_string());
-            return false;
+        if (ok && deflate_stream.handle_error()) {
+            fprintf(stderr, "Can't decompress %s: The data is corrupt\n", entry.name.characters());
+            ok = false;
         }
+    }
 
-        if (!new_file->close()) {
-            fprintf(stderr, "Can't close file %s: %s\n", file_name, new_file->error_string());
-            return false;
-        }
+    if (ok && (uncompressed_size != entry.uncompressed_size || crc32.digest() != entry.crc32)) {
+        fprintf(stderr, "Can't extract %s: Bad CRC32 or size\n", entry.name.characters());
+        ok = false;
     }
 
-    return true;
+    if (close(fd) < 0 && ok) {
+        fprintf(stderr, "Can't close file %s: %s\n", entry.name.characters(), strerror(errno));
+        ok = false;
+    }
+    return ok;
 }
 
 int main(int argc, char** argv)
 {
     const char* path;
     int map_size_limit = 32 * MiB;
+    int job_count = max(sysconf(_SC_NPROCESSORS_ONLN), 1l);
 
     Core::ArgsParser args_parser;
     args_parser.add_option(map_size_limit, "Maximum chunk size to map", "map-size-limit", 0, "size");
+    args_parser.add_option(job_count, "Extract up to N files at once, one per CPU by default", "jobs", 'j', "N");
     args_parser.add_positional_argument(path, "File to unzip", "path", Core::ArgsParser::Required::Yes);
     args_parser.parse(argc, argv);
 
@@ -188,14 +324,41 @@ int main(int argc, char** argv)
 
     printf("Archive: %s\n", zip_file_path.characters());
 
-    off_t index = 0;
-    while (find_next_central_directory(st.st_size, mapped_file, index, index)) {
-        bool success = unpack_file_for_central_directory_index(index, mapped_file);
-        if (!success) {
+    Vector<Entry> entries;
+    if (!read_central_directory(mapped_file, entries)) {
+        printf("Could not read the central directory.\n");
+        return 4;
+    }
+
+    // Directories are made up front, in archive order, so that the files can be written in any order.
+    Vector<Function<void()>> extractions;
+    Atomic<bool> extraction_failed { false };
+    for (auto& entry : entries) {
+        if (!create_leading_directories(entry.name))
+            return 1;
+        if (entry.name.ends_with("/")) {
+            if (!create_directory(entry.name))
+                return 1;
+            continue;
+        }
+
+        ReadonlyBytes data;
+        if (!find_entry_data(mapped_file, entry, data)) {
             printf("Could not find local file header for a file.\n");
             return 4;
         }
+
+        printf(" extracting: %s\n", entry.name.characters());
+        extractions.append([&entry, data, &extraction_failed] {
+            if (!extract_entry(entry, data))
+                extraction_failed.store(true);
+        });
     }
+    fflush(stdout);
+
+    // The calling thread extracts files too.
+    LibThread::ThreadPool pool(max(job_count, 1) - 1);
+    pool.run(move(extractions));
 
-    return 0;
+    return extraction_failed.load() ? 1 : 0;
 }
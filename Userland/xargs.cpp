@@ -25,17 +25,52 @@
  */
 
 #include <AK/Function.h>
+#include <AK/HashMap.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/ArgsParser.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/wait.h>
+#include <unistd.h>
 
-bool run_command(Vector<char*>&& child_argv, bool verbose, bool is_stdin, int devnull_fd);
+// Runs commands, up to a given number of them at a time.
+class CommandRunner {
+public:
+    CommandRunner(size_t max_processes, bool verbose, bool group_output, int stdin_fd)
+        : m_max_processes(max_processes)
+        , m_verbose(verbose)
+        , m_group_output(group_output)
+        , m_stdin_fd(stdin_fd)
+    {
+    }
+
+    // Starts a command once there's room for it. Returns false if this or an earlier command failed.
+    bool run(Vector<char*>&& child_argv);
+    // Waits for all commands to finish. Returns false if any of them failed.
+    bool wait_for_all();
+
+private:
+    // With grouped output, every command writes into temporary files of its own, which are
+    // copied out in one piece once it has exited.
+    struct Job {
+        int output_fd { -1 };
+        int error_fd { -1 };
+    };
+
+    void wait_for_one();
+
+    size_t m_max_processes;
+    bool m_verbose;
+    bool m_group_output;
+    int m_stdin_fd;
+    HashMap<pid_t, Job> m_jobs;
+    bool m_failed { false };
+};
 
 enum Decision {
     Unget,
@@ -56,9 +91,15 @@ private:
     Vector<Vector<StringView>> m_all_parts;
 };
 
+// What an argument takes up of ARG_MAX: its characters, the null terminator and the pointer to it.
+static size_t argument_size(const StringView& argument)
+{
+    return argument.length() + 1 + sizeof(char*);
+}
+
 int main(int argc, char** argv)
 {
-    if (pledge("stdio rpath proc exec", nullptr) < 0) {
+    if (pledge("stdio rpath wpath cpath proc exec", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
@@ -70,7 +111,10 @@ int main(int argc, char** argv)
     bool verbose = false;
     const char* file_to_read = "-";
     int max_lines_for_one_command = 0;
+    int max_arguments_for_one_command = 0;
     int max_bytes_for_one_command = ARG_MAX;
+    int max_processes = 1;
+    bool group_output = false;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(placeholder, "Placeholder string to be replaced in arguments", "replace", 'I', "placeholder");
@@ -79,12 +123,25 @@ int main(int argc, char** argv)
     args_parser.add_option(verbose, "Display each command before executing it", "verbose", 'v');
     args_parser.add_option(file_to_read, "Read arguments from the specified file instead of stdin", "arg-file", 'a', "file");
     args_parser.add_option(max_lines_for_one_command, "Use at most max-lines lines to create a command", "line-limit", 'L', "max-lines");
+    args_parser.add_option(max_arguments_for_one_command, "Use at most max-args arguments from the input to create a command", "max-args", 'n', "max-args");
     args_parser.add_option(max_bytes_for_one_command, "Use at most max-chars characters to create a command", "char-limit", 's', "max-chars");
+    args_parser.add_option(max_processes, "Run up to max-procs commands at a time, or one per CPU if 0", "max-procs", 'P', "max-procs");
+    args_parser.add_option(group_output, "Print the output of each command in one piece once it finishes", "group-output", 0);
     args_parser.add_positional_argument(arguments, "Command and any initial arguments for it", "command", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
-    size_t max_bytes = min(ARG_MAX, max_bytes_for_one_command);
+    // The arguments, the pointers to them and the environment all have to fit into ARG_MAX bytes,
+    // and we leave a bit of room besides, like other xargs implementations do.
+    size_t environment_size = 0;
+    for (char** variable = environ; *variable; ++variable)
+        environment_size += argument_size(*variable);
+    size_t max_bytes = min((size_t)max(max_bytes_for_one_command, 0), ARG_MAX - min(environment_size + 2048, (size_t)ARG_MAX / 2));
     size_t max_lines = max(max_lines_for_one_command, 0);
+    if (max_arguments_for_one_command > 0)
+        max_lines = max_lines ? min(max_lines, (size_t)max_arguments_for_one_command) : max_arguments_for_one_command;
+
+    if (max_processes <= 0)
+        max_processes = max(sysconf(_SC_NPROCESSORS_ONLN), 1l);
 
     if (!split_with_nulls && strlen(specified_delimiter) > 1) {
         fprintf(stderr, "xargs: the delimiter must be a single byte\n");
@@ -119,7 +176,7 @@ int main(int argc, char** argv)
     StringBuilder builder;
     Vector<char*> child_argv;
 
-    int devnull_fd = 0;
+    int devnull_fd = -1;
 
     if (is_stdin) {
         devnull_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
@@ -129,6 +186,8 @@ int main(int argc, char** argv)
         }
     }
 
+    CommandRunner runner(max_processes, verbose, group_output, devnull_fd);
+
     size_t total_command_length = 0;
     size_t items_used_for_this_command = 0;
 
@@ -147,24 +206,24 @@ int main(int argc, char** argv)
             child_argv.ensure_capacity(initial_arguments.size());
 
             initial_arguments.for_each_joined_argument(item, [&](const String& string) {
-                total_command_length += string.length();
+                total_command_length += argument_size(string);
                 child_argv.append(strdup(string.characters()));
             });
 
             ++items_used_for_this_command;
         } else {
-            if ((max_lines > 0 && items_used_for_this_command + 1 > max_lines) || total_command_length + item.length() + 1 >= max_bytes) {
+            if ((max_lines > 0 && items_used_for_this_command + 1 > max_lines) || total_command_length + argument_size(item) > max_bytes) {
                 // Note: This `move' does not actually move-construct a new Vector at the callsite, it only allows perfect-forwarding
                 //       and does not invalidate `child_argv' in this scope.
                 //       The same applies for the one below.
-                if (!run_command(move(child_argv), verbose, is_stdin, devnull_fd))
+                if (!runner.run(move(child_argv)))
                     return Stop;
                 items_used_for_this_command = 0;
                 total_command_length = 0;
                 return Unget;
             } else {
                 child_argv.append(strndup(item.characters_without_null_termination(), item.length()));
-                total_command_length += item.length();
+                total_command_length += argument_size(item);
                 ++items_used_for_this_command;
             }
         }
@@ -173,7 +232,9 @@ int main(int argc, char** argv)
     });
 
     if (!fail && !child_argv.is_empty())
-        fail = !run_command(move(child_argv), verbose, is_stdin, devnull_fd);
+        fail = !runner.run(move(child_argv));
+    if (!runner.wait_for_all())
+        fail = true;
 
     if (!is_stdin)
         fclose(fp);
@@ -215,26 +276,57 @@ bool read_items(FILE* fp, char entry_separator, Function<Decision(StringView)> c
     return fail;
 }
 
-bool run_command(Vector<char*>&& child_argv, bool verbose, bool is_stdin, int devnull_fd)
+bool CommandRunner::run(Vector<char*>&& child_argv)
 {
+    while (!m_failed && m_jobs.size() >= m_max_processes)
+        wait_for_one();
+    if (m_failed) {
+        for (auto* ptr : child_argv)
+            free(ptr);
+        child_argv.clear_with_capacity();
+        return false;
+    }
+
     child_argv.append(nullptr);
 
-    if (verbose) {
+    if (m_verbose) {
         StringBuilder builder;
         builder.join(" ", child_argv);
         fprintf(stderr, "xargs: %s\n", builder.to_string().characters());
         fflush(stderr);
     }
 
+    Job job;
+    if (m_group_output) {
+        for (auto* fd : { &job.output_fd, &job.error_fd }) {
+            char path[] = "/tmp/xargs.XXXXXX";
+            *fd = mkstemp(path);
+            if (*fd < 0) {
+                perror("mkstemp");
+                m_failed = true;
+                return false;
+            }
+            unlink(path);
+            // Other commands that get started in the meantime shouldn't hold on to it.
+            fcntl(*fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+    fflush(stdout);
+
     auto pid = fork();
     if (pid < 0) {
         perror("fork");
+        m_failed = true;
         return false;
     }
 
     if (pid == 0) {
-        if (is_stdin)
-            dup2(devnull_fd, STDIN_FILENO);
+        if (m_stdin_fd >= 0)
+            dup2(m_stdin_fd, STDIN_FILENO);
+        if (m_group_output) {
+            dup2(job.output_fd, STDOUT_FILENO);
+            dup2(job.error_fd, STDERR_FILENO);
+        }
 
         execvp(child_argv[0], child_argv.data());
         exit(1);
@@ -245,20 +337,63 @@ bool run_command(Vector<char*>&& child_argv, bool verbose, bool is_stdin, int de
 
     child_argv.clear_with_capacity();
 
+    m_jobs.set(pid, job);
+    return true;
+}
+
+static void copy_and_close(int fd, int output_fd)
+{
+    if (lseek(fd, 0, SEEK_SET) < 0) {
+        perror("lseek");
+        close(fd);
+        return;
+    }
+    char buffer[BUFSIZ];
+    for (;;) {
+        ssize_t nread = read(fd, buffer, sizeof(buffer));
+        if (nread <= 0)
+            break;
+        for (ssize_t offset = 0; offset < nread;) {
+            ssize_t nwritten = write(output_fd, buffer + offset, nread - offset);
+            if (nwritten <= 0)
+                break;
+            offset += nwritten;
+        }
+    }
+    close(fd);
+}
+
+void CommandRunner::wait_for_one()
+{
     int wstatus = 0;
-    if (waitpid(pid, &wstatus, 0) < 0) {
+    pid_t pid = waitpid(-1, &wstatus, 0);
+    if (pid < 0) {
         perror("waitpid");
-        return false;
+        // There's nothing left that we could wait for.
+        m_jobs.clear();
+        m_failed = true;
+        return;
     }
 
-    if (WIFEXITED(wstatus)) {
-        if (WEXITSTATUS(wstatus) != 0)
-            return false;
-    } else {
-        return false;
+    auto job = m_jobs.get(pid);
+    if (!job.has_value())
+        return;
+    m_jobs.remove(pid);
+
+    if (m_group_output) {
+        copy_and_close(job.value().output_fd, STDOUT_FILENO);
+        copy_and_close(job.value().error_fd, STDERR_FILENO);
     }
 
-    return true;
+    if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0)
+        m_failed = true;
+}
+
+bool CommandRunner::wait_for_all()
+{
+    while (!m_jobs.is_empty())
+        wait_for_one();
+    return !m_failed;
 }
 
 ParsedInitialArguments::ParsedInitialArguments(Vector<const char*>& arguments, const StringView& placeholder)